@@ -30,6 +30,14 @@ check_include_file("unistd.h"               HAVE_UNISTD_H)
 
 check_include_file("valgrind/valgrind.h"    HAVE_VALGRIND_H)
 
+if(ENABLE_TRACEPOINTS)
+	if(WIN32)
+		check_include_files("windows.h;TraceLoggingProvider.h" HAVE_TRACELOGGINGPROVIDER_H)
+	else()
+		check_include_file("sys/sdt.h"      HAVE_SYS_SDT_H)
+	endif()
+endif()
+
 # Check that the C compiler works on a trivial program.
 # Do this early on before more specific tests so we can give
 # an appropriate error message.
@@ -135,8 +143,10 @@ endif()
 if(UNIX)
 	cmake_push_check_state()
 	list(APPEND CMAKE_REQUIRED_DEFINITIONS -D_GNU_SOURCE)
+	check_symbol_exists("madvise"       "sys/mman.h" HAVE_MADVISE)
 	check_symbol_exists("memmem"        "string.h"   HAVE_MEMMEM)
 	check_symbol_exists("memrchr"       "string.h"   HAVE_MEMRCHR)
+	check_symbol_exists("posix_fadvise" "fcntl.h"    HAVE_POSIX_FADVISE)
 	check_symbol_exists("strerrorname_np" "string.h" HAVE_STRERRORNAME_NP)
 	check_symbol_exists("strptime"      "time.h"     HAVE_STRPTIME)
 	check_symbol_exists("vasprintf"     "stdio.h"    HAVE_VASPRINTF)
@@ -77,6 +77,7 @@
 #include <wsutil/file_util.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/wslog.h>
+#include <wsutil/json_dumper.h>
 
 #include <gcrypt.h>
 
@@ -104,6 +105,22 @@ static char field_separator           = '\t';  /* Use TAB as field separator by
 static char quote_char                = '\0';  /* Do NOT quote fields by default        */
 static bool machine_readable; /* Display machine-readable numbers      */
 
+/*
+ * JSON report variables
+ */
+
+static bool json_report;      /* Generate a JSON report instead       */
+static json_dumper json_output = {
+    .output_file = NULL,
+    .flags = JSON_DUMPER_FLAGS_PRETTY_PRINT,
+};
+
+/*
+ * Number of files to process concurrently; results are still
+ * reported in the order the files were given.
+ */
+static uint32_t num_jobs = 1;
+
 /*
  * capinfos has the ability to report on a number of
  * various characteristics ("infos") for each input file.
@@ -151,16 +168,6 @@ static bool cap_file_hashes    = true;  /* Calculate file hashes */
 #define HASH_BUF_SIZE (1024 * 1024)
 
 
-static char file_sha256[HASH_STR_SIZE];
-static char file_sha1[HASH_STR_SIZE];
-
-static char  *hash_buf;
-static gcry_md_hd_t hd;
-
-static unsigned int num_ipv4_addresses;
-static unsigned int num_ipv6_addresses;
-static unsigned int num_decryption_secrets;
-
 /*
  * If we have at least two packets with time stamps, and they're not in
  * order - i.e., the later packet has a time stamp older than the earlier
@@ -220,8 +227,36 @@ typedef struct _capture_info {
     GArray               *interface_packet_counts;  /* array of per_packet interface_id counts; one entry per file IDB */
     uint32_t              pkt_interface_id_unknown; /* counts if packet interface_id didn't match a known one */
     GArray               *idb_info_strings;         /* array of IDB info strings */
+
+    char                  file_sha256[HASH_STR_SIZE];
+    char                  file_sha1[HASH_STR_SIZE];
+
+    unsigned int          num_ipv4_addresses;
+    unsigned int          num_ipv6_addresses;
+    unsigned int          num_decryption_secrets;
 } capture_info;
 
+/*
+ * The wiretap callbacks for NRB and DSB entries don't take a user
+ * data pointer; this points to the capture_info for the file being
+ * read on the current thread.
+ */
+static GPrivate current_cf_info = G_PRIVATE_INIT(NULL);
+
+/*
+ * A file being processed by the worker pool when more than one
+ * job was requested.
+ */
+typedef struct _cap_file_job {
+    const char           *filename;
+    capture_info          cf_info;
+    int                   status;
+    bool                  done;
+} cap_file_job;
+
+static GMutex jobs_mutex;
+static GCond  jobs_cond;
+
 static char *decimal_point;
 
 static void
@@ -594,8 +629,8 @@ print_stats(const char *filename, capture_info *cf_info)
         }
     }
     if (cap_file_hashes) {
-        printf     ("SHA256:              %s\n", file_sha256);
-        printf     ("SHA1:                %s\n", file_sha1);
+        printf     ("SHA256:              %s\n", cf_info->file_sha256);
+        printf     ("SHA1:                %s\n", cf_info->file_sha1);
     }
     if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
 
@@ -642,6 +677,7 @@ print_stats(const char *filename, capture_info *cf_info)
         }
         g_free(p->cmt);
       }
+      cf_info->pkt_cmts = NULL;
     }
 
     if (cap_file_idb && cf_info->num_interfaces != 0) {
@@ -660,14 +696,14 @@ print_stats(const char *filename, capture_info *cf_info)
     }
 
     if (cap_file_nrb) {
-        if (num_ipv4_addresses != 0)
-            printf   ("Number of resolved IPv4 addresses in file: %u\n", num_ipv4_addresses);
-        if (num_ipv6_addresses != 0)
-            printf   ("Number of resolved IPv6 addresses in file: %u\n", num_ipv6_addresses);
+        if (cf_info->num_ipv4_addresses != 0)
+            printf   ("Number of resolved IPv4 addresses in file: %u\n", cf_info->num_ipv4_addresses);
+        if (cf_info->num_ipv6_addresses != 0)
+            printf   ("Number of resolved IPv6 addresses in file: %u\n", cf_info->num_ipv6_addresses);
     }
     if (cap_file_dsb) {
-        if (num_decryption_secrets != 0)
-            printf   ("Number of decryption secrets in file: %u\n", num_decryption_secrets);
+        if (cf_info->num_decryption_secrets != 0)
+            printf   ("Number of decryption secrets in file: %u\n", cf_info->num_decryption_secrets);
     }
 }
 
@@ -898,12 +934,12 @@ print_stats_table(const char *filename, capture_info *cf_info)
     if (cap_file_hashes) {
         putsep();
         putquote();
-        printf("%s", file_sha256);
+        printf("%s", cf_info->file_sha256);
         putquote();
 
         putsep();
         putquote();
-        printf("%s", file_sha1);
+        printf("%s", cf_info->file_sha1);
         putquote();
     }
 
@@ -996,17 +1032,257 @@ print_stats_table(const char *filename, capture_info *cf_info)
         g_free(p->cmt);
         putquote();
       }
+      cf_info->pkt_cmts = NULL;
     }
 
     printf("\n");
 }
 
+static void
+json_dumper_member_string(json_dumper *dumper, const char *name, const char *value)
+{
+    json_dumper_set_member_name(dumper, name);
+    if (value != NULL)
+        json_dumper_value_string(dumper, value);
+    else
+        json_dumper_value_anyf(dumper, "null");
+}
+
+static void
+json_dumper_member_double(json_dumper *dumper, const char *name, bool known, double value)
+{
+    json_dumper_set_member_name(dumper, name);
+    if (known)
+        json_dumper_value_double(dumper, value);
+    else
+        json_dumper_value_anyf(dumper, "null");
+}
+
+static void
+json_dumper_member_time(json_dumper *dumper, const char *name, nstime_t *timer,
+                        int tsprecision, capture_info *cf_info)
+{
+    /* See absolute_time_string() for the buffer size. */
+    char time_string_buf[39];
+
+    json_dumper_set_member_name(dumper, name);
+    if (cf_info->times_known && cf_info->packet_count > 0) {
+        if (time_as_secs) {
+            display_epoch_time(time_string_buf, sizeof time_string_buf, timer, tsprecision);
+            json_dumper_value_anyf(dumper, "%s", time_string_buf);
+        } else {
+            /* JSON consumers expect a '.', whatever the locale. */
+            format_nstime_as_iso8601(time_string_buf, sizeof time_string_buf, timer, (char *)".", true, tsprecision);
+            json_dumper_value_string(dumper, time_string_buf);
+        }
+    } else {
+        json_dumper_value_anyf(dumper, "null");
+    }
+}
+
+/*
+ * Emit one JSON object per file, with a member for each requested info.
+ * Values that are unknown are null rather than "n/a", and numbers are
+ * always machine-readable.
+ */
+static void
+print_stats_json(const char *filename, capture_info *cf_info)
+{
+    json_dumper *dumper = &json_output;
+    pkt_cmt     *p;
+    char        *str;
+
+    json_dumper_begin_object(dumper);
+
+    json_dumper_member_string(dumper, "file_name", filename);
+    if (cap_file_type) {
+        json_dumper_member_string(dumper, "file_type", wtap_file_type_subtype_name(cf_info->file_type));
+        json_dumper_member_string(dumper, "file_compression",
+                                  cf_info->compression_type == WS_FILE_UNCOMPRESSED ?
+                                      NULL : ws_compression_type_name(cf_info->compression_type));
+    }
+    if (cap_file_encap) {
+        json_dumper_member_string(dumper, "file_encapsulation", wtap_encap_name(cf_info->file_encap));
+        if (cf_info->file_encap == WTAP_ENCAP_PER_PACKET) {
+            json_dumper_set_member_name(dumper, "encapsulation_counts");
+            json_dumper_begin_object(dumper);
+            for (int i = 0; i < WTAP_NUM_ENCAP_TYPES; i++) {
+                if (cf_info->encap_counts[i] > 0) {
+                    json_dumper_set_member_name(dumper, wtap_encap_name(i));
+                    json_dumper_value_anyf(dumper, "%d", cf_info->encap_counts[i]);
+                }
+            }
+            json_dumper_end_object(dumper);
+        }
+    }
+    if (cap_file_more_info)
+        json_dumper_member_string(dumper, "file_time_precision", wtap_tsprec_string(cf_info->file_tsprec));
+    if (cap_snaplen) {
+        json_dumper_set_member_name(dumper, "packet_size_limit");
+        if (cf_info->snap_set)
+            json_dumper_value_anyf(dumper, "%u", cf_info->snaplen);
+        else
+            json_dumper_value_anyf(dumper, "null");
+        json_dumper_set_member_name(dumper, "packet_size_limit_min_inferred");
+        if (cf_info->snaplen_max_inferred > 0)
+            json_dumper_value_anyf(dumper, "%u", cf_info->snaplen_min_inferred);
+        else
+            json_dumper_value_anyf(dumper, "null");
+        json_dumper_set_member_name(dumper, "packet_size_limit_max_inferred");
+        if (cf_info->snaplen_max_inferred > 0)
+            json_dumper_value_anyf(dumper, "%u", cf_info->snaplen_max_inferred);
+        else
+            json_dumper_value_anyf(dumper, "null");
+    }
+    if (cap_packet_count) {
+        json_dumper_set_member_name(dumper, "packet_count");
+        json_dumper_value_anyf(dumper, "%u", cf_info->packet_count);
+    }
+    if (cap_file_size) {
+        json_dumper_set_member_name(dumper, "file_size");
+        json_dumper_value_int64(dumper, cf_info->filesize);
+    }
+    if (cap_data_size) {
+        json_dumper_set_member_name(dumper, "data_size");
+        json_dumper_value_uint64(dumper, cf_info->packet_bytes);
+    }
+    if (cap_duration) {
+        json_dumper_member_double(dumper, "capture_duration",
+                                  cf_info->times_known && cf_info->packet_count > 0,
+                                  nstime_to_sec(&cf_info->duration));
+    }
+    if (cap_earliest_packet_time)
+        json_dumper_member_time(dumper, "start_time", &cf_info->earliest_packet_time, cf_info->earliest_packet_time_tsprec, cf_info);
+    if (cap_latest_packet_time)
+        json_dumper_member_time(dumper, "end_time", &cf_info->latest_packet_time, cf_info->latest_packet_time_tsprec, cf_info);
+    if (cap_data_rate_byte)
+        json_dumper_member_double(dumper, "data_byte_rate", cf_info->times_known, cf_info->data_rate);
+    if (cap_data_rate_bit)
+        json_dumper_member_double(dumper, "data_bit_rate", cf_info->times_known, cf_info->data_rate*8);
+    if (cap_packet_size)
+        json_dumper_member_double(dumper, "average_packet_size", true, cf_info->packet_size);
+    if (cap_packet_rate)
+        json_dumper_member_double(dumper, "average_packet_rate", cf_info->times_known, cf_info->packet_rate);
+    if (cap_file_hashes) {
+        json_dumper_member_string(dumper, "sha256", cf_info->file_sha256);
+        json_dumper_member_string(dumper, "sha1", cf_info->file_sha1);
+    }
+    if (cap_order) {
+        json_dumper_set_member_name(dumper, "strict_time_order");
+        switch (cf_info->order) {
+            case IN_ORDER:
+                json_dumper_value_anyf(dumper, "true");
+                break;
+            case NOT_IN_ORDER:
+                json_dumper_value_anyf(dumper, "false");
+                break;
+            default:
+                json_dumper_value_anyf(dumper, "null");
+                break;
+        }
+    }
+
+    if (cap_file_more_info || cap_comment) {
+        json_dumper_set_member_name(dumper, "sections");
+        json_dumper_begin_array(dumper);
+        for (unsigned section_number = 0;
+                section_number < wtap_file_get_num_shbs(cf_info->wth);
+                section_number++) {
+            wtap_block_t shb = wtap_file_get_shb(cf_info->wth, section_number);
+
+            json_dumper_begin_object(dumper);
+            if (cap_file_more_info) {
+                json_dumper_member_string(dumper, "capture_hardware",
+                    wtap_block_get_string_option_value(shb, OPT_SHB_HARDWARE, &str) == WTAP_OPTTYPE_SUCCESS ? str : NULL);
+                json_dumper_member_string(dumper, "capture_oper_sys",
+                    wtap_block_get_string_option_value(shb, OPT_SHB_OS, &str) == WTAP_OPTTYPE_SUCCESS ? str : NULL);
+                json_dumper_member_string(dumper, "capture_application",
+                    wtap_block_get_string_option_value(shb, OPT_SHB_USERAPPL, &str) == WTAP_OPTTYPE_SUCCESS ? str : NULL);
+            }
+            if (cap_comment) {
+                json_dumper_set_member_name(dumper, "capture_comments");
+                json_dumper_begin_array(dumper);
+                for (unsigned i = 0; wtap_block_get_nth_string_option_value(shb, OPT_COMMENT, i, &str) == WTAP_OPTTYPE_SUCCESS; i++) {
+                    json_dumper_value_string(dumper, str);
+                }
+                json_dumper_end_array(dumper);
+            }
+            json_dumper_end_object(dumper);
+        }
+        json_dumper_end_array(dumper);
+    }
+
+    if (pkt_comments) {
+        json_dumper_set_member_name(dumper, "packet_comments");
+        json_dumper_begin_array(dumper);
+        for (p = cf_info->pkt_cmts; p != NULL; p = p->next) {
+            json_dumper_begin_object(dumper);
+            json_dumper_set_member_name(dumper, "packet");
+            json_dumper_value_anyf(dumper, "%u", p->recno);
+            json_dumper_member_string(dumper, "comment", p->cmt);
+            json_dumper_end_object(dumper);
+        }
+        json_dumper_end_array(dumper);
+    }
+
+    if (cap_file_idb) {
+        wtapng_iface_descriptions_t *idb_info = wtap_file_get_idb_info(cf_info->wth);
+
+        json_dumper_set_member_name(dumper, "interfaces");
+        json_dumper_begin_array(dumper);
+        for (unsigned i = 0; i < idb_info->interface_data->len; i++) {
+            wtap_block_t idb = g_array_index(idb_info->interface_data, wtap_block_t, i);
+            wtapng_if_descr_mandatory_t *if_descr_mand = (wtapng_if_descr_mandatory_t*)wtap_block_get_mandatory_data(idb);
+            uint32_t packet_count = 0;
+
+            if (i < cf_info->interface_packet_counts->len)
+                packet_count = g_array_index(cf_info->interface_packet_counts, uint32_t, i);
+
+            json_dumper_begin_object(dumper);
+            json_dumper_member_string(dumper, "name",
+                wtap_block_get_string_option_value(idb, OPT_IDB_NAME, &str) == WTAP_OPTTYPE_SUCCESS ? str : NULL);
+            json_dumper_member_string(dumper, "description",
+                wtap_block_get_string_option_value(idb, OPT_IDB_DESCRIPTION, &str) == WTAP_OPTTYPE_SUCCESS ? str : NULL);
+            json_dumper_member_string(dumper, "encapsulation", wtap_encap_name(if_descr_mand->wtap_encap));
+            json_dumper_set_member_name(dumper, "snaplen");
+            json_dumper_value_anyf(dumper, "%u", if_descr_mand->snap_len);
+            json_dumper_set_member_name(dumper, "packet_count");
+            json_dumper_value_anyf(dumper, "%u", packet_count);
+            json_dumper_end_object(dumper);
+        }
+        json_dumper_end_array(dumper);
+
+        g_free(idb_info);
+    }
+
+    if (cap_file_nrb) {
+        json_dumper_set_member_name(dumper, "resolved_ipv4_addresses");
+        json_dumper_value_anyf(dumper, "%u", cf_info->num_ipv4_addresses);
+        json_dumper_set_member_name(dumper, "resolved_ipv6_addresses");
+        json_dumper_value_anyf(dumper, "%u", cf_info->num_ipv6_addresses);
+    }
+    if (cap_file_dsb) {
+        json_dumper_set_member_name(dumper, "decryption_secrets");
+        json_dumper_value_anyf(dumper, "%u", cf_info->num_decryption_secrets);
+    }
+
+    json_dumper_end_object(dumper);
+}
+
 static void
 cleanup_capture_info(capture_info *cf_info)
 {
     unsigned int i;
+    pkt_cmt *p, *next;
     ws_assert(cf_info != NULL);
 
+    for (p = cf_info->pkt_cmts; p != NULL; p = next) {
+        next = p->next;
+        g_free(p->cmt);
+        g_free(p);
+    }
+    cf_info->pkt_cmts = NULL;
+
     g_free(cf_info->encap_counts);
     cf_info->encap_counts = NULL;
 
@@ -1026,21 +1302,27 @@ cleanup_capture_info(capture_info *cf_info)
 static void
 count_ipv4_address(const unsigned int addr _U_, const char *name _U_, const bool static_entry _U_)
 {
-    num_ipv4_addresses++;
+    capture_info *cf_info = (capture_info *)g_private_get(&current_cf_info);
+
+    cf_info->num_ipv4_addresses++;
 }
 
 static void
 count_ipv6_address(const ws_in6_addr *addrp _U_, const char *name _U_, const bool static_entry _U_)
 {
-    num_ipv6_addresses++;
+    capture_info *cf_info = (capture_info *)g_private_get(&current_cf_info);
+
+    cf_info->num_ipv6_addresses++;
 }
 
 static void
 count_decryption_secret(uint32_t secrets_type _U_, const void *secrets _U_, unsigned int size _U_)
 {
+    capture_info *cf_info = (capture_info *)g_private_get(&current_cf_info);
+
     /* XXX - count them based on the secrets type (which is an opaque code,
        not a small integer)? */
-    num_decryption_secrets++;
+    cf_info->num_decryption_secrets++;
 }
 
 static void
@@ -1054,31 +1336,46 @@ hash_to_str(const unsigned char *hash, size_t length, char *str)
 }
 
 static void
-calculate_hashes(const char *filename)
+calculate_hashes(const char *filename, capture_info *cf_info)
 {
     FILE  *fh;
     size_t hash_bytes;
+    gcry_md_hd_t hd = NULL;
+    char  *hash_buf;
 
-    (void) g_strlcpy(file_sha256, "<unknown>", HASH_STR_SIZE);
-    (void) g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
+    (void) g_strlcpy(cf_info->file_sha256, "<unknown>", HASH_STR_SIZE);
+    (void) g_strlcpy(cf_info->file_sha1, "<unknown>", HASH_STR_SIZE);
 
     if (cap_file_hashes) {
+        /* Each file gets its own context, as files may be hashed concurrently. */
+        gcry_md_open(&hd, GCRY_MD_SHA256, 0);
+        if (hd)
+            gcry_md_enable(hd, GCRY_MD_SHA1);
+
         fh = ws_fopen(filename, "rb");
         if (fh && hd) {
+            hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
             while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
                 gcry_md_write(hd, hash_buf, hash_bytes);
             }
+            g_free(hash_buf);
             gcry_md_final(hd);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, file_sha256);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
+            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, cf_info->file_sha256);
+            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, cf_info->file_sha1);
         }
         if (fh) fclose(fh);
-        if (hd) gcry_md_reset(hd);
+        gcry_md_close(hd);
     }
 }
 
+/*
+ * Read a capture file and fill in *cf_info->  This may run on a worker
+ * thread, so it doesn't write anything to the standard output; on
+ * success (a return value other than 2) the file is left open for
+ * print_cap_file_info().
+ */
 static int
-process_cap_file(const char *filename, bool need_separator)
+gather_cap_file_info(const char *filename, capture_info *cf_info)
 {
     int                   status = 0;
     int                   err;
@@ -1091,7 +1388,6 @@ process_cap_file(const char *filename, bool need_separator)
     uint32_t              snaplen_min_inferred = 0xffffffff;
     uint32_t              snaplen_max_inferred =          0;
     wtap_rec              rec;
-    capture_info          cf_info;
     bool                  have_times = true;
     nstime_t              earliest_packet_time;
     int                   earliest_packet_time_tsprec;
@@ -1106,22 +1402,24 @@ process_cap_file(const char *filename, bool need_separator)
 
     pkt_cmt *pc = NULL, *prev = NULL;
 
-    cf_info.wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, false, application_configuration_environment_prefix());
-    if (!cf_info.wth) {
+    cf_info->wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, false, application_configuration_environment_prefix());
+    if (!cf_info->wth) {
         report_cfile_open_failure(filename, err, err_info);
         return 2;
     }
 
+    /*
+     * Nothing we report depends on the contents of the packets, so
+     * let file types that can skip over the packet data do so.
+     */
+    wtap_set_skip_packet_data(cf_info->wth, true);
+
     /*
      * Calculate the checksums. Do this after wtap_open_offline, so we don't
      * bother calculating them for files that are not known capture types
      * where we wouldn't print them anyway.
      */
-    calculate_hashes(filename);
-
-    if (need_separator && long_report) {
-        printf("\n");
-    }
+    calculate_hashes(filename, cf_info);
 
     nstime_set_zero(&earliest_packet_time);
     earliest_packet_time_tsprec = WTAP_TSPREC_UNKNOWN;
@@ -1130,35 +1428,36 @@ process_cap_file(const char *filename, bool need_separator)
     nstime_set_zero(&cur_time);
     nstime_set_zero(&prev_time);
 
-    cf_info.encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
+    cf_info->encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
 
-    idb_info = wtap_file_get_idb_info(cf_info.wth);
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
     ws_assert(idb_info->interface_data != NULL);
 
-    cf_info.pkt_cmts = NULL;
-    cf_info.num_interfaces = idb_info->interface_data->len;
-    cf_info.interface_packet_counts  = g_array_sized_new(false, true, sizeof(uint32_t), cf_info.num_interfaces);
-    g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
-    cf_info.pkt_interface_id_unknown = 0;
+    cf_info->pkt_cmts = NULL;
+    cf_info->num_interfaces = idb_info->interface_data->len;
+    cf_info->interface_packet_counts  = g_array_sized_new(false, true, sizeof(uint32_t), cf_info->num_interfaces);
+    g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
+    cf_info->pkt_interface_id_unknown = 0;
 
     g_free(idb_info);
     idb_info = NULL;
 
     /* Zero out the counters for the callbacks. */
-    num_ipv4_addresses = 0;
-    num_ipv6_addresses = 0;
-    num_decryption_secrets = 0;
+    cf_info->num_ipv4_addresses = 0;
+    cf_info->num_ipv6_addresses = 0;
+    cf_info->num_decryption_secrets = 0;
+    g_private_set(&current_cf_info, cf_info);
 
     /* Register callbacks for new name<->address maps from the file and
        decryption secrets from the file. */
-    wtap_set_cb_new_ipv4(cf_info.wth, count_ipv4_address);
-    wtap_set_cb_new_ipv6(cf_info.wth, count_ipv6_address);
-    wtap_set_cb_new_secrets(cf_info.wth, count_decryption_secret);
+    wtap_set_cb_new_ipv4(cf_info->wth, count_ipv4_address);
+    wtap_set_cb_new_ipv6(cf_info->wth, count_ipv6_address);
+    wtap_set_cb_new_secrets(cf_info->wth, count_decryption_secret);
 
     /* Tally up data that we need to parse through the file to find */
     wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
-    while (wtap_read(cf_info.wth, &rec, &err, &err_info, &data_offset))  {
+    while (wtap_read(cf_info->wth, &rec, &err, &err_info, &data_offset))  {
         if (rec.presence_flags & WTAP_HAS_TS) {
             prev_time = cur_time;
             cur_time = rec.ts;
@@ -1200,7 +1499,7 @@ process_cap_file(const char *filename, bool need_separator)
                 pc->next = NULL;
 
                 if (prev == NULL)
-                  cf_info.pkt_cmts = pc;
+                  cf_info->pkt_cmts = pc;
                 else
                   prev->next = pc;
 
@@ -1221,7 +1520,7 @@ process_cap_file(const char *filename, bool need_separator)
 
             if ((rec.rec_header.packet_header.pkt_encap > 0) &&
                     (rec.rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-                cf_info.encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
+                cf_info->encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
             } else {
                 fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
                         rec.rec_header.packet_header.pkt_encap, packet, filename);
@@ -1229,37 +1528,37 @@ process_cap_file(const char *filename, bool need_separator)
 
             /* Packet interface_id info */
             if (rec.presence_flags & WTAP_HAS_INTERFACE_ID) {
-                /* cf_info.num_interfaces is size, not index, so it's one more than max index */
-                if (rec.rec_header.packet_header.interface_id >= cf_info.num_interfaces) {
+                /* cf_info->num_interfaces is size, not index, so it's one more than max index */
+                if (rec.rec_header.packet_header.interface_id >= cf_info->num_interfaces) {
                     /*
                      * OK, re-fetch the number of interfaces, as there might have
                      * been an interface that was in the middle of packets, and
                      * grow the array to be big enough for the new number of
                      * interfaces.
                      */
-                    idb_info = wtap_file_get_idb_info(cf_info.wth);
+                    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-                    cf_info.num_interfaces = idb_info->interface_data->len;
-                    g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
+                    cf_info->num_interfaces = idb_info->interface_data->len;
+                    g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
 
                     g_free(idb_info);
                     idb_info = NULL;
                 }
-                if (rec.rec_header.packet_header.interface_id < cf_info.num_interfaces) {
-                    g_array_index(cf_info.interface_packet_counts, uint32_t,
+                if (rec.rec_header.packet_header.interface_id < cf_info->num_interfaces) {
+                    g_array_index(cf_info->interface_packet_counts, uint32_t,
                             rec.rec_header.packet_header.interface_id) += 1;
                 }
                 else {
-                    cf_info.pkt_interface_id_unknown += 1;
+                    cf_info->pkt_interface_id_unknown += 1;
                 }
             }
             else {
                 /* it's for interface_id 0 */
-                if (cf_info.num_interfaces != 0) {
-                    g_array_index(cf_info.interface_packet_counts, uint32_t, 0) += 1;
+                if (cf_info->num_interfaces != 0) {
+                    g_array_index(cf_info->interface_packet_counts, uint32_t, 0) += 1;
                 }
                 else {
-                    cf_info.pkt_interface_id_unknown += 1;
+                    cf_info->pkt_interface_id_unknown += 1;
                 }
             }
         }
@@ -1275,14 +1574,14 @@ process_cap_file(const char *filename, bool need_separator)
      * we get, for example, a count of the number of statistics entries
      * for each interface as of the *end* of the file.
      */
-    idb_info = wtap_file_get_idb_info(cf_info.wth);
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-    cf_info.idb_info_strings = g_array_sized_new(false, false, sizeof(char*), cf_info.num_interfaces);
-    cf_info.num_interfaces = idb_info->interface_data->len;
-    for (i = 0; i < cf_info.num_interfaces; i++) {
+    cf_info->idb_info_strings = g_array_sized_new(false, false, sizeof(char*), cf_info->num_interfaces);
+    cf_info->num_interfaces = idb_info->interface_data->len;
+    for (i = 0; i < cf_info->num_interfaces; i++) {
         const wtap_block_t if_descr = g_array_index(idb_info->interface_data, wtap_block_t, i);
         char *s = wtap_get_debug_if_descr(if_descr, 21, "\n");
-        g_array_append_val(cf_info.idb_info_strings, s);
+        g_array_append_val(cf_info->idb_info_strings, s);
     }
 
     g_free(idb_info);
@@ -1299,94 +1598,198 @@ process_cap_file(const char *filename, bool need_separator)
             fprintf(stderr,
                     "  (will continue anyway, checksums might be incorrect)\n");
         } else {
-            cleanup_capture_info(&cf_info);
-            wtap_close(cf_info.wth);
+            cleanup_capture_info(cf_info);
+            wtap_close(cf_info->wth);
             return 2;
         }
     }
 
     /* File size */
-    size = wtap_file_size(cf_info.wth, &err);
+    size = wtap_file_size(cf_info->wth, &err);
     if (size == -1) {
         fprintf(stderr,
                 "capinfos: Can't get size of \"%s\": %s.\n",
                 filename, g_strerror(err));
-        cleanup_capture_info(&cf_info);
-        wtap_close(cf_info.wth);
+        cleanup_capture_info(cf_info);
+        wtap_close(cf_info->wth);
         return 2;
     }
 
-    cf_info.filesize = size;
+    cf_info->filesize = size;
 
     /* File Type */
-    cf_info.file_type = wtap_file_type_subtype(cf_info.wth);
-    cf_info.compression_type = wtap_get_compression_type(cf_info.wth);
+    cf_info->file_type = wtap_file_type_subtype(cf_info->wth);
+    cf_info->compression_type = wtap_get_compression_type(cf_info->wth);
 
     /* File Encapsulation */
-    cf_info.file_encap = wtap_file_encap(cf_info.wth);
+    cf_info->file_encap = wtap_file_encap(cf_info->wth);
 
-    cf_info.file_tsprec = wtap_file_tsprec(cf_info.wth);
+    cf_info->file_tsprec = wtap_file_tsprec(cf_info->wth);
 
     /* Packet size limit (snaplen) */
-    cf_info.snaplen = wtap_snapshot_length(cf_info.wth);
-    if (cf_info.snaplen > 0)
-        cf_info.snap_set = true;
+    cf_info->snaplen = wtap_snapshot_length(cf_info->wth);
+    if (cf_info->snaplen > 0)
+        cf_info->snap_set = true;
     else
-        cf_info.snap_set = false;
+        cf_info->snap_set = false;
 
-    cf_info.snaplen_min_inferred = snaplen_min_inferred;
-    cf_info.snaplen_max_inferred = snaplen_max_inferred;
+    cf_info->snaplen_min_inferred = snaplen_min_inferred;
+    cf_info->snaplen_max_inferred = snaplen_max_inferred;
 
     /* # of packets */
-    cf_info.packet_count = packet;
+    cf_info->packet_count = packet;
 
     /* File Times */
-    cf_info.times_known = have_times;
-    cf_info.earliest_packet_time = earliest_packet_time;
-    cf_info.earliest_packet_time_tsprec = earliest_packet_time_tsprec;
-    cf_info.latest_packet_time = latest_packet_time;
-    cf_info.latest_packet_time_tsprec = latest_packet_time_tsprec;
-    nstime_delta(&cf_info.duration, &latest_packet_time, &earliest_packet_time);
+    cf_info->times_known = have_times;
+    cf_info->earliest_packet_time = earliest_packet_time;
+    cf_info->earliest_packet_time_tsprec = earliest_packet_time_tsprec;
+    cf_info->latest_packet_time = latest_packet_time;
+    cf_info->latest_packet_time_tsprec = latest_packet_time_tsprec;
+    nstime_delta(&cf_info->duration, &latest_packet_time, &earliest_packet_time);
     /* Duration precision is the higher of the earliest and latest packet timestamp precisions. */
-    if (cf_info.latest_packet_time_tsprec > cf_info.earliest_packet_time_tsprec)
-        cf_info.duration_tsprec = cf_info.latest_packet_time_tsprec;
+    if (cf_info->latest_packet_time_tsprec > cf_info->earliest_packet_time_tsprec)
+        cf_info->duration_tsprec = cf_info->latest_packet_time_tsprec;
     else
-        cf_info.duration_tsprec = cf_info.earliest_packet_time_tsprec;
-    cf_info.know_order = know_order;
-    cf_info.order = order;
+        cf_info->duration_tsprec = cf_info->earliest_packet_time_tsprec;
+    cf_info->know_order = know_order;
+    cf_info->order = order;
 
     /* Number of packet bytes */
-    cf_info.packet_bytes = bytes;
+    cf_info->packet_bytes = bytes;
 
-    cf_info.data_rate   = 0.0;
-    cf_info.packet_rate = 0.0;
-    cf_info.packet_size = 0.0;
+    cf_info->data_rate   = 0.0;
+    cf_info->packet_rate = 0.0;
+    cf_info->packet_size = 0.0;
 
     if (packet > 0) {
         double delta_time = nstime_to_sec(&latest_packet_time) - nstime_to_sec(&earliest_packet_time);
         if (delta_time > 0.0) {
-            cf_info.data_rate   = (double)bytes  / delta_time; /* Data rate per second */
-            cf_info.packet_rate = (double)packet / delta_time; /* packet rate per second */
+            cf_info->data_rate   = (double)bytes  / delta_time; /* Data rate per second */
+            cf_info->packet_rate = (double)packet / delta_time; /* packet rate per second */
         }
-        cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
+        cf_info->packet_size = (double)bytes / packet;                  /* Avg packet size      */
     }
 
-    if (!long_report && table_report_header) {
-      print_stats_table_header(&cf_info);
-    }
+    return status;
+}
 
-    if (long_report) {
-        print_stats(filename, &cf_info);
+static void
+close_cap_file_info(capture_info *cf_info)
+{
+    cleanup_capture_info(cf_info);
+    wtap_close(cf_info->wth);
+}
+
+/*
+ * Report the information gathered by gather_cap_file_info(), and close
+ * the file.
+ */
+static void
+print_cap_file_info(const char *filename, capture_info *cf_info, bool need_separator)
+{
+    if (json_report) {
+        print_stats_json(filename, cf_info);
+    } else if (long_report) {
+        if (need_separator) {
+            printf("\n");
+        }
+        print_stats(filename, cf_info);
     } else {
-        print_stats_table(filename, &cf_info);
+        if (table_report_header) {
+            print_stats_table_header(cf_info);
+        }
+        print_stats_table(filename, cf_info);
     }
 
-    cleanup_capture_info(&cf_info);
-    wtap_close(cf_info.wth);
+    close_cap_file_info(cf_info);
+}
+
+static int
+process_cap_file(const char *filename, bool need_separator)
+{
+    capture_info cf_info;
+    int          status;
 
+    status = gather_cap_file_info(filename, &cf_info);
+    if (status != 2) {
+        print_cap_file_info(filename, &cf_info, need_separator);
+    }
     return status;
 }
 
+static void
+process_cap_file_job(void *data, void *user_data _U_)
+{
+    cap_file_job *job = (cap_file_job *)data;
+
+    job->status = gather_cap_file_info(job->filename, &job->cf_info);
+
+    g_mutex_lock(&jobs_mutex);
+    job->done = true;
+    g_cond_broadcast(&jobs_cond);
+    g_mutex_unlock(&jobs_mutex);
+}
+
+/*
+ * Process the files on a pool of num_jobs worker threads, each with its
+ * own wtap handle, and report the results in the order the files were
+ * given.  At most two files per worker are read ahead of the one being
+ * reported, so that the number of open files stays bounded.
+ */
+static int
+process_cap_files_parallel(int num_files, char **filenames)
+{
+    GThreadPool  *pool;
+    cap_file_job *jobs;
+    int           next_job = 0;
+    int           window = (int)MIN(num_jobs * 2, (uint32_t)INT_MAX);
+    int           i;
+    int           status;
+    int           overall_error_status = 0;
+    bool          need_separator = false;
+
+    jobs = g_new0(cap_file_job, num_files);
+    pool = g_thread_pool_new(process_cap_file_job, NULL, (int)MIN(num_jobs, (uint32_t)INT_MAX), true, NULL);
+
+    for (i = 0; i < num_files; i++) {
+        while (next_job < num_files && next_job - i < window) {
+            jobs[next_job].filename = filenames[next_job];
+            g_thread_pool_push(pool, &jobs[next_job], NULL);
+            next_job++;
+        }
+
+        g_mutex_lock(&jobs_mutex);
+        while (!jobs[i].done)
+            g_cond_wait(&jobs_cond, &jobs_mutex);
+        g_mutex_unlock(&jobs_mutex);
+
+        status = jobs[i].status;
+        if (status != 2) {
+            print_cap_file_info(jobs[i].filename, &jobs[i].cf_info, need_separator);
+            /* See the comment in main(). */
+            need_separator = true;
+        }
+        if (status) {
+            overall_error_status = status;
+            if (stop_after_failure)
+                break;
+        }
+    }
+
+    /*
+     * Drop any files that haven't been started, wait for the ones that
+     * have, and discard what they found.
+     */
+    g_thread_pool_free(pool, true, true);
+    for (i++; i < next_job; i++) {
+        if (jobs[i].done && jobs[i].status != 2)
+            close_cap_file_info(&jobs[i].cf_info);
+    }
+    g_free(jobs);
+
+    return overall_error_status;
+}
+
 static void
 print_usage(FILE *output)
 {
@@ -1428,6 +1831,7 @@ print_usage(FILE *output)
     fprintf(output, "Output format:\n");
     fprintf(output, "  -L generate long report (default)\n");
     fprintf(output, "  -T generate table report\n");
+    fprintf(output, "  -J generate JSON report\n");
     fprintf(output, "  -M display machine-readable values in long reports\n");
     fprintf(output, "\n");
     fprintf(output, "Table report options:\n");
@@ -1446,6 +1850,7 @@ print_usage(FILE *output)
     fprintf(output, "  -h, --help               display this help and exit\n");
     fprintf(output, "  -v, --version            display version info and exit\n");
     fprintf(output, "  -C cancel processing if file open fails (default is to continue)\n");
+    fprintf(output, "  -j <jobs> process up to <jobs> files concurrently (default 1)\n");
     fprintf(output, "  -A generate all infos (default)\n");
     fprintf(output, "  -K disable displaying the capture comment\n");
     fprintf(output, "  -P disable displaying individual packet comments\n");
@@ -1473,7 +1878,7 @@ main(int argc, char *argv[])
     const struct file_extension_info* file_extensions;
     unsigned num_extensions;
 
-#define OPTSTRING "abcdehiklmnopqrstuvxyzABCDEFHIKLMNPQRST"
+#define OPTSTRING "abcdehij:klmnopqrstuvxyzABCDEFHIJKLMNPQRST"
     static const char optstring[] = OPTSTRING;
 
     int status = 0;
@@ -1659,16 +2064,30 @@ main(int argc, char *argv[])
                 stop_after_failure = true;
                 break;
 
+            case 'j':
+                if (!get_nonzero_uint32(ws_optarg, "number of jobs", &num_jobs)) {
+                    overall_error_status = WS_EXIT_INVALID_OPTION;
+                    goto exit;
+                }
+                break;
+
             case 'A':
                 enable_all_infos();
                 break;
 
             case 'L':
                 long_report = true;
+                json_report = false;
                 break;
 
             case 'T':
                 long_report = false;
+                json_report = false;
+                break;
+
+            case 'J':
+                long_report = false;
+                json_report = true;
                 break;
 
             case 'M':
@@ -1734,37 +2153,44 @@ main(int argc, char *argv[])
 
     if (cap_file_hashes) {
         gcry_check_version(NULL);
-        gcry_md_open(&hd, GCRY_MD_SHA256, 0);
-        if (hd)
-            gcry_md_enable(hd, GCRY_MD_SHA1);
-
-        hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
     }
 
     overall_error_status = 0;
 
-    for (opt = ws_optind; opt < argc; opt++) {
+    if (json_report) {
+        json_output.output_file = stdout;
+        json_dumper_begin_array(&json_output);
+    }
 
-        status = process_cap_file(argv[opt], need_separator);
-        if (status) {
-            /* Something failed.  It's been reported; remember that processing
-               one file failed and, if -C was specified, stop. */
-            overall_error_status = status;
-            if (stop_after_failure)
-                goto exit;
-        }
-        if (status != 2) {
-            /* Either it succeeded or it got a "short read" but printed
-               information anyway.  Note that we need a blank line before
-               the next file's information, to separate it from the
-               previous file. */
-            need_separator = true;
+    if (num_jobs > 1 && argc - ws_optind > 1) {
+        overall_error_status = process_cap_files_parallel(argc - ws_optind, argv + ws_optind);
+    } else {
+        for (opt = ws_optind; opt < argc; opt++) {
+
+            status = process_cap_file(argv[opt], need_separator);
+            if (status) {
+                /* Something failed.  It's been reported; remember that processing
+                   one file failed and, if -C was specified, stop. */
+                overall_error_status = status;
+                if (stop_after_failure)
+                    break;
+            }
+            if (status != 2) {
+                /* Either it succeeded or it got a "short read" but printed
+                   information anyway.  Note that we need a blank line before
+                   the next file's information, to separate it from the
+                   previous file. */
+                need_separator = true;
+            }
         }
     }
 
+    if (json_report) {
+        json_dumper_end_array(&json_output);
+        json_dumper_finish(&json_output);
+    }
+
 exit:
-    g_free(hash_buf);
-    gcry_md_close(hd);
     wtap_cleanup();
     free_progdirs();
     return overall_error_status;
@@ -64,10 +64,20 @@ struct packet_provider_data {
     GTree       *frames_modified_blocks; /* BST with modified blocks for frames (key = frame_data) */
 };
 
+/* Running totals over a set of frames, for the capture file summary. */
+typedef struct _frame_tally {
+    uint32_t    count;          /* Number of frames */
+    uint32_t    count_ts;       /* Number of those with a time stamp */
+    uint64_t    bytes;          /* Sum of their packet lengths */
+    double      start;          /* Earliest time stamp, if count_ts > 0 */
+    double      stop;           /* Latest time stamp, if count_ts > 0 */
+} frame_tally;
+
 typedef struct _capture_file {
     epan_t                     *epan;
     file_state                  state;                /* Current state of capture file */
     char                       *filename;             /* Name of capture file */
+    char                      **set_filenames;        /* Files read as one capture, if more than one, or NULL */
     char                       *source;               /* Temp file source, e.g. "Pipe from elsewhere" */
     bool                        is_tempfile;          /* Is capture file a temporary file? */
     bool                        unsaved_changes;      /* Does the capture file have changes that have not been saved? */
@@ -85,6 +95,10 @@ typedef struct _capture_file {
     uint32_t                    marked_count;         /* Number of marked frames */
     uint32_t                    ignored_count;        /* Number of ignored frames */
     uint32_t                    ref_time_count;       /* Number of time referenced frames */
+    frame_tally                 tally_all;            /* All frames */
+    frame_tally                 tally_displayed;      /* Frames that passed the display filter */
+    frame_tally                 tally_marked;         /* Marked frames */
+    bool                        tally_valid;          /* true if the tallies above are up to date */
     bool                        drops_known;          /* true if we know how many packets were dropped */
     uint32_t                    drops;                /* Dropped packets */
     nstime_t                    elapsed_time;         /* Elapsed time */
@@ -95,6 +109,8 @@ typedef struct _capture_file {
     bool                        redissecting;         /* true if currently redissecting (cf_redissect_packets) */
     bool                        read_lock;            /* true if currently processing a file (cf_read) */
     rescan_type                 redissection_queued;  /* Queued redissection type. */
+    bool                        passed_dfilter_superset; /* true if every frame dfcode can match has passed_dfilter set */
+    bool                        dfilter_narrowed;     /* true if the next rescan only has to test frames that passed */
     /* search */
     char                       *sfilter;              /* Filter, hex value, or string being searched */
     /* XXX: Some of these booleans should be enums; they're exclusive cases */
@@ -115,6 +131,13 @@ typedef struct _capture_file {
     /* frames */
     uint32_t                    first_displayed;      /* Frame number of first frame displayed */
     uint32_t                    last_displayed;       /* Frame number of last frame displayed */
+    GPtrArray                  *frame_protos;         /* Per-frame sets of protocols seen in the frame's layers */
+    GHashTable                 *proto_sets;           /* Interned protocol sets pointed to by frame_protos */
+    struct _syscall_columns    *syscall_columns;      /* Per-frame system call event header fields */
+    struct _ph_frame_stacks    *ph_stacks;            /* Per-frame protocol stacks kept by ph_stats_new() */
+    struct _frame_index        *frame_index;          /* Frame index from an earlier read of this file, if any */
+    struct _frame_ngram_index  *ngram_index;          /* Trigram filters of the frames' bytes, for Find Packet */
+    GSList                     *export_jobs;          /* Background dissection exports (cf_export_job_t) reading the file */
     /* Data for currently selected frame */
     column_info                 cinfo;                /* Column formatting information */
     frame_data                 *current_frame;        /* Frame data */
@@ -22,6 +22,7 @@
 #include <ws_exit_codes.h>
 
 #include <epan/epan.h>
+#include <epan/epan_dissect.h>
 #include <epan/timestamp.h>
 #include <epan/prefs.h>
 #include <epan/dfilter/dfilter.h>
@@ -37,10 +38,12 @@
 #include <wsutil/wslog.h>
 #include <wsutil/ws_getopt.h>
 #include <wsutil/utf8_entities.h>
+#include <wsutil/time_util.h>
 #include <app/application_flavor.h>
 
 #include <wiretap/wtap.h>
 
+#include "cfile.h"
 #include "ui/util.h"
 #include "ui/failure_message.h"
 #include "wsutil/cmdarg_err.h"
@@ -59,6 +62,7 @@ static int opt_optimize = 1;
 static int opt_show_types;
 static int opt_dump_refs;
 static int opt_dump_macros;
+static const char *opt_capture;
 
 static int64_t elapsed_expand;
 static int64_t elapsed_compile;
@@ -120,6 +124,7 @@ print_usage(void)
      * print empty reference vectors. */
     fprintf(fp, "      --refs          dump some runtime data structures\n");
     fprintf(fp, "      --file <path>   read filters line-by-line from a file (use '-' for stdin)\n");
+    fprintf(fp, "      --capture <path> run the filter over a capture file and profile it\n");
     fprintf(fp, "  -h, --help          display this help and exit\n");
     fprintf(fp, "  -v, --version       print version\n");
     fprintf(fp, "\n");
@@ -255,6 +260,110 @@ optarg_to_digit(const char *arg, int* digit)
     return true;
 }
 
+static epan_t *
+dftest_epan_new(capture_file *cf)
+{
+    static const struct packet_provider_funcs funcs = {
+        cap_file_provider_get_frame_ts,
+        cap_file_provider_get_start_ts,
+        cap_file_provider_get_end_ts,
+        cap_file_provider_get_interface_name,
+        cap_file_provider_get_interface_description,
+        NULL,
+        cap_file_provider_get_process_id,
+        cap_file_provider_get_process_name,
+        cap_file_provider_get_process_uuid,
+    };
+
+    return epan_new(&cf->provider, &funcs);
+}
+
+/*
+ * Dissects every packet in the capture file and runs the filter over
+ * it, timing the two separately, then shows the instructions with how
+ * often each ran and what it cost.
+ */
+static int
+profile_filter(dfilter_t *df, uint16_t dump_flags)
+{
+    capture_file    cf;
+    epan_dissect_t  edt;
+    wtap_rec        rec;
+    frame_data      fdlocal, ref_frame, prev_dis_frame;
+    int             err;
+    char           *err_info = NULL;
+    int64_t         data_offset;
+    uint32_t        cum_bytes = 0;
+    uint64_t        start, dissect_ns = 0, filter_ns = 0;
+    int             exit_status = EXIT_SUCCESS;
+
+    cap_file_init(&cf);
+    cf.provider.wth = wtap_open_offline(opt_capture, WTAP_TYPE_AUTO, &err, &err_info,
+                                        false, application_configuration_environment_prefix());
+    if (cf.provider.wth == NULL) {
+        report_cfile_open_failure(opt_capture, err, err_info);
+        return WS_EXIT_INVALID_FILE;
+    }
+    cf.cd_t = wtap_file_type_subtype(cf.provider.wth);
+    cf.epan = dftest_epan_new(&cf);
+
+    if (dfilter_requires_columns(df)) {
+        printf("\nWarning: Columns are not filled in, so column fields are never present.\n");
+    }
+
+    dfilter_set_profiling(df, true);
+    epan_dissect_init(&edt, cf.epan, true, false);
+    wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
+
+    while (wtap_read(cf.provider.wth, &rec, &err, &err_info, &data_offset)) {
+        frame_data_init(&fdlocal, cf.count + 1, &rec, data_offset, cum_bytes);
+
+        epan_dissect_prime_with_dfilter(&edt, df);
+        frame_data_set_before_dissect(&fdlocal, &cf.elapsed_time,
+                &cf.provider.ref, cf.provider.prev_dis);
+        if (cf.provider.ref == &fdlocal) {
+            ref_frame = fdlocal;
+            cf.provider.ref = &ref_frame;
+        }
+
+        start = ws_monotonic_ns();
+        epan_dissect_run(&edt, cf.cd_t, &rec, &fdlocal, NULL);
+        dissect_ns += ws_monotonic_ns() - start;
+
+        start = ws_monotonic_ns();
+        dfilter_apply_edt(df, &edt);
+        filter_ns += ws_monotonic_ns() - start;
+
+        frame_data_set_after_dissect(&fdlocal, &cum_bytes);
+        prev_dis_frame = fdlocal;
+        cf.provider.prev_dis = &prev_dis_frame;
+        cf.count++;
+
+        epan_dissect_reset(&edt);
+        frame_data_destroy(&fdlocal);
+        wtap_rec_reset(&rec);
+    }
+    if (err != 0) {
+        report_cfile_read_failure(opt_capture, err, err_info);
+        exit_status = WS_EXIT_INVALID_FILE;
+    }
+
+    epan_dissect_cleanup(&edt);
+    wtap_rec_cleanup(&rec);
+    wtap_close(cf.provider.wth);
+    epan_free(cf.epan);
+
+    printf("\nCapture: %s\n", opt_capture);
+    printf("Packets: %u\n", cf.count);
+    printf("Dissection: %.3f ms\n", dissect_ns / 1e6);
+    printf("Filtering: %.3f ms (%.0f ns per packet, including the profiling)\n\n",
+            filter_ns / 1e6, cf.count ? (double)filter_ns / cf.count : 0.0);
+    dfilter_dump(stdout, df, dump_flags | DF_DUMP_PROFILE);
+    dfilter_set_profiling(df, false);
+
+    return exit_status;
+}
+
 static int
 test_filter(const char *text)
 {
@@ -303,6 +412,14 @@ test_filter(const char *text)
     if (opt_timer)
         print_elapsed();
 
+    if (opt_capture) {
+        int exit_status = profile_filter(df, dump_flags);
+
+        g_free(expanded_text);
+        dfilter_free(df);
+        return exit_status;
+    }
+
     g_free(expanded_text);
     dfilter_free(df);
 
@@ -338,6 +455,7 @@ main(int argc, char **argv)
         { "types",    ws_no_argument,   0, 2000 },
         { "refs",     ws_no_argument,   0, 3000 },
         { "file",     ws_required_argument, 0, 4000 },
+        { "capture",  ws_required_argument, 0, 5000 },
         LONGOPT_WSLOG
         { NULL,       0,                0,  0   }
     };
@@ -459,6 +577,9 @@ main(int argc, char **argv)
             case 4000:
                 path = ws_optarg;
                 break;
+            case 5000:
+                opt_capture = ws_optarg;
+                break;
             case 'v':
                 show_version();
                 return EXIT_SUCCESS;
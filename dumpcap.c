@@ -24,6 +24,12 @@
 #include <netinet/in.h>
 #endif
 
+#ifdef __linux__
+#include <sys/socket.h>
+#include <linux/if_packet.h>    /* PACKET_FANOUT */
+#include <fcntl.h>              /* F_SETPIPE_SZ */
+#endif
+
 #include <wsutil/ws_getopt.h>
 
 #include <signal.h>
@@ -321,6 +327,9 @@ typedef struct _capture_src {
     size_t                       cap_pipe_bytes_to_read; /**< Used by cap_pipe_dispatch */
     size_t                       cap_pipe_bytes_read;    /**< Used by cap_pipe_dispatch */
 #endif
+    uint8_t*                     cap_pipe_rbuf;          /**< Read-ahead buffer for pipes and sockets we select() on */
+    size_t                       cap_pipe_rbuf_pos;      /**< Offset of the first unconsumed byte in cap_pipe_rbuf */
+    size_t                       cap_pipe_rbuf_len;      /**< Number of bytes in cap_pipe_rbuf */
     int (*cap_pipe_dispatch)(struct _loop_data *, struct _capture_src *, char *, size_t);
     cap_pipe_state_t cap_pipe_state;
     cap_pipe_err_t cap_pipe_err;
@@ -406,8 +415,34 @@ static loop_data   global_ld;
 #define PIPE_READ_TIMEOUT   250000
 #endif
 
+/*
+ * Pipes and sockets are read this much at a time, if that much is
+ * available, and records are parsed out of the buffer. read() on a pipe
+ * returns whatever is there, so this doesn't add latency; it means a
+ * busy extcap gets two system calls for many records instead of four
+ * for each one.
+ */
+#define CAP_PIPE_RBUF_SIZE  (256 * 1024)
+
 #define WRITER_THREAD_TIMEOUT 100000 /* usecs */
 
+/*
+ * Maximum number of queued packets the writer takes off the queue at
+ * once. Taking them in batches means one lock round trip, and one pass
+ * through the main loop's bookkeeping, per batch rather than per packet.
+ */
+#define WRITER_BATCH_SIZE 256
+
+/*
+ * Number of packets written but not yet reported to the parent after
+ * which we report them without waiting for the update interval to end.
+ * At low packet rates the update interval still governs how often the
+ * parent hears from us; on fast links this bounds both how long a
+ * packet waits before the parent can show it and how much the parent
+ * has to read and dissect in one go.
+ */
+#define SYNC_PIPE_PACKET_BATCH 10000
+
 static void
 dumpcap_log_writer(const char *domain, enum ws_log_level level,
                                    const char *file, long line, const char *func,
@@ -421,6 +456,11 @@ static GPtrArray *capture_comments;
 static bool quiet;
 static bool really_quiet;
 static bool use_threads;
+
+#ifdef PACKET_FANOUT
+/* PACKET_FANOUT group id of the first interface, or 0 for no fanout */
+static uint32_t fanout_group_base;
+#endif
 static uint64_t start_time;
 
 static void capture_loop_write_packet_cb(uint8_t *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -539,6 +579,10 @@ print_usage(FILE *output)
     fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
     fprintf(output, "                           within dumpcap\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
+#ifdef PACKET_FANOUT
+    fprintf(output, "  --fanout <group id>      share the packets of an interface given more than\n");
+    fprintf(output, "                           once among its capture threads (Linux only)\n");
+#endif
     fprintf(output, "  -q                       don't report packet capture counts\n");
     fprintf(output, "  -Q                       suppress all non-error status messages to stderr\n");
     fprintf(output, "  --application-flavor <flavor>\n");
@@ -1654,6 +1698,86 @@ cap_pipe_select(int pipe_fd)
     return select(pipe_fd+1, &rfds, NULL, NULL, &timeout);
 }
 
+/* Like cap_pipe_select(), but data left in the read-ahead buffer counts
+ * as readable.
+ */
+static int
+cap_pipe_src_select(capture_src *pcap_src)
+{
+    if (pcap_src->cap_pipe_rbuf_pos < pcap_src->cap_pipe_rbuf_len) {
+        return 1;
+    }
+    return cap_pipe_select(pcap_src->cap_pipe_fd);
+}
+
+/* Read up to sz bytes from the source's pipe or socket through its
+ * read-ahead buffer. Like read(2), this returns what's available, and
+ * only blocks if nothing is.
+ */
+static ssize_t
+cap_pipe_buffered_read(capture_src *pcap_src, uint8_t *buf, size_t sz)
+{
+    size_t avail;
+
+    if (pcap_src->cap_pipe_rbuf_pos == pcap_src->cap_pipe_rbuf_len) {
+        ssize_t b;
+
+        if (sz >= CAP_PIPE_RBUF_SIZE) {
+            /* No point in copying a read that fills the buffer. */
+            return cap_pipe_read(pcap_src->cap_pipe_fd, buf, sz, pcap_src->from_cap_socket);
+        }
+        if (pcap_src->cap_pipe_rbuf == NULL) {
+            pcap_src->cap_pipe_rbuf = (uint8_t*)g_malloc(CAP_PIPE_RBUF_SIZE);
+        }
+        b = cap_pipe_read(pcap_src->cap_pipe_fd, pcap_src->cap_pipe_rbuf,
+                          CAP_PIPE_RBUF_SIZE, pcap_src->from_cap_socket);
+        if (b <= 0) {
+            return b;
+        }
+        pcap_src->cap_pipe_rbuf_pos = 0;
+        pcap_src->cap_pipe_rbuf_len = b;
+    }
+
+    avail = pcap_src->cap_pipe_rbuf_len - pcap_src->cap_pipe_rbuf_pos;
+    if (sz > avail) {
+        sz = avail;
+    }
+    memcpy(buf, pcap_src->cap_pipe_rbuf + pcap_src->cap_pipe_rbuf_pos, sz);
+    pcap_src->cap_pipe_rbuf_pos += sz;
+    return (ssize_t) sz;
+}
+
+/* Ask for a pipe buffer of buffer_size MiB, or as close to it as the
+ * system allows, so that a fast writer such as an extcap has more room
+ * before it blocks. Linux pipes default to 64 KiB, and unprivileged
+ * processes are limited to /proc/sys/fs/pipe-max-size (1 MiB by default).
+ */
+static void
+cap_pipe_set_buffer_size(int fd, int buffer_size)
+{
+#if defined(__linux__) && defined(F_SETPIPE_SZ)
+    int cur_size = fcntl(fd, F_GETPIPE_SZ);
+    int want_size;
+
+    if (cur_size < 0 || buffer_size <= 0 || buffer_size > INT_MAX / (1024 * 1024)) {
+        return;
+    }
+    for (want_size = buffer_size * 1024 * 1024; want_size > cur_size; want_size /= 2) {
+        if (fcntl(fd, F_SETPIPE_SZ, want_size) >= 0) {
+            ws_debug("pipe buffer size set to %d bytes", want_size);
+            return;
+        }
+        if (errno != EPERM) {
+            break;
+        }
+    }
+    ws_debug("pipe buffer size left at %d bytes", cur_size);
+#else
+    (void) fd;
+    (void) buffer_size;
+#endif
+}
+
 #define DEF_TCP_PORT 19000
 
 static int
@@ -1754,15 +1878,15 @@ cap_pipe_read_data_bytes(capture_src *pcap_src, char *errmsg, size_t errmsgl)
             return -1;
         }
 
-        sel_ret = cap_pipe_select(fd);
+        sel_ret = cap_pipe_src_select(pcap_src);
         if (sel_ret < 0) {
             snprintf(errmsg, errmsgl,
                        "Unexpected error from select: %s.", g_strerror(errno));
             pcap_src->cap_pipe_err = PIPERR;
             return -1;
         } else if (sel_ret > 0) {
-            b = cap_pipe_read(fd, pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read+bytes_read,
-                              sz-bytes_read, pcap_src->from_cap_socket);
+            b = cap_pipe_buffered_read(pcap_src, pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read+bytes_read,
+                                       sz-bytes_read);
             if (b <= 0) {
                 if (b == 0) {
                     snprintf(errmsg, errmsgl,
@@ -2654,8 +2778,8 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd, ((uint8_t*)&pcap_info->rechdr)+pcap_src->cap_pipe_bytes_read,
-                 pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read, pcap_src->from_cap_socket);
+            b = cap_pipe_buffered_read(pcap_src, ((uint8_t*)&pcap_info->rechdr)+pcap_src->cap_pipe_bytes_read,
+                 pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read);
             if (b <= 0) {
                 if (b == 0)
                     result = PD_PIPE_EOF;
@@ -2713,10 +2837,9 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd,
+            b = cap_pipe_buffered_read(pcap_src,
                               pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read,
-                              pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read,
-                              pcap_src->from_cap_socket);
+                              pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read);
             if (b <= 0) {
                 if (b == 0)
                     result = PD_PIPE_EOF;
@@ -3119,6 +3242,45 @@ pcapng_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t
 /** Open the capture input sources; each one is either a pcap device,
  *  a capture pipe, or a capture socket.
  *  Returns true if it succeeds, false otherwise. */
+#ifdef PACKET_FANOUT
+/*
+ * Add a live Linux capture handle to a PACKET_FANOUT group, so that the
+ * kernel spreads the interface's packets by flow hash over all the
+ * handles, and hence capture threads, opened on it. All the handles of
+ * one interface use the group fanout_group_base + the index of the
+ * interface's first -i; the kernel refuses to mix devices in a group.
+ * Each handle gets its own IDB and its own drop counts in the ISBs.
+ */
+static bool
+capture_loop_join_fanout(capture_options *capture_opts, unsigned iface_index,
+                         capture_src *pcap_src, char *errmsg, size_t errmsg_len)
+{
+    interface_options *interface_opts = &g_array_index(capture_opts->ifaces, interface_options, iface_index);
+    unsigned           first;
+    uint32_t           group;
+    int                fanout_arg;
+
+    for (first = 0; first < iface_index; first++) {
+        if (strcmp(g_array_index(capture_opts->ifaces, interface_options, first).name,
+                   interface_opts->name) == 0) {
+            break;
+        }
+    }
+    group = (fanout_group_base + first) & 0xffff;
+    fanout_arg = (int)(group | ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16));
+    if (setsockopt(pcap_fileno(pcap_src->pcap_h), SOL_PACKET, PACKET_FANOUT,
+                   &fanout_arg, sizeof(fanout_arg)) == -1) {
+        snprintf(errmsg, errmsg_len,
+                 "Couldn't add interface %s to fanout group %u: %s.",
+                 interface_opts->display_name, group, g_strerror(errno));
+        return false;
+    }
+    ws_info("Interface %u (%s) joined fanout group %u.", iface_index,
+            interface_opts->display_name, group);
+    return true;
+}
+#endif
+
 static bool
 capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
                         char *errmsg, size_t errmsg_len,
@@ -3225,6 +3387,13 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
                 return false;
             }
             pcap_src->linktype = dlt_to_linktype(get_pcap_datalink(pcap_src->pcap_h, interface_opts->name));
+
+#ifdef PACKET_FANOUT
+            if (fanout_group_base != 0 &&
+                !capture_loop_join_fanout(capture_opts, i, pcap_src, errmsg, errmsg_len)) {
+                return false;
+            }
+#endif
         } else {
             /* We couldn't open "iface" as a network device. */
             /* Try to open it as a pipe */
@@ -3275,6 +3444,9 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
                  * so we tried to open it as a pipe, and that succeeded.
                  */
                 open_status = CAP_DEVICE_OPEN_NO_ERR;
+                if (pcap_src->cap_pipe_fd >= 0 && !pcap_src->from_cap_socket) {
+                    cap_pipe_set_buffer_size(pcap_src->cap_pipe_fd, interface_opts->buffer_size);
+                }
             }
         }
 
@@ -3379,6 +3551,10 @@ static void capture_loop_close_input(loop_data *ld)
                 g_free(pcap_src->cap_pipe_databuf);
                 pcap_src->cap_pipe_databuf = NULL;
             }
+            g_free(pcap_src->cap_pipe_rbuf);
+            pcap_src->cap_pipe_rbuf = NULL;
+            pcap_src->cap_pipe_rbuf_pos = 0;
+            pcap_src->cap_pipe_rbuf_len = 0;
             if (pcap_src->from_pcapng) {
                 g_array_free(pcap_src->cap_pipe_info.pcapng.src_iface_to_global, TRUE);
                 pcap_src->cap_pipe_info.pcapng.src_iface_to_global = NULL;
@@ -3680,7 +3856,7 @@ capture_loop_dispatch(loop_data *ld,
 #ifdef _WIN32
         if (pcap_src->from_cap_socket) {
 #endif
-            sel_ret = cap_pipe_select(pcap_src->cap_pipe_fd);
+            sel_ret = cap_pipe_src_select(pcap_src);
             if (sel_ret <= 0) {
                 if (sel_ret < 0 && errno != EINTR) {
                     snprintf(errmsg, errmsg_len,
@@ -4152,23 +4328,80 @@ pcap_read_handler(void* arg)
     return (NULL);
 }
 
-/* Try to pop an item off the packet queue and if it exists, write it */
-static bool
-capture_loop_dequeue_packet(void) {
+/* Timestamp of a queued packet, in nanoseconds. */
+static inline int64_t
+queue_element_ts(const pcap_queue_element *queue_element)
+{
+    return (int64_t)queue_element->u.phdr.ts.tv_sec * 1000000000 +
+           (int64_t)queue_element->u.phdr.ts.tv_usec * (queue_element->pcap_src->ts_nsec ? 1 : 1000);
+}
+
+/*
+ * Each capture thread queues its interface's packets in the order it
+ * captured them, but packets from different interfaces end up in the
+ * order in which the threads got to the queue, so a busy interface can
+ * push another interface's earlier packets back. Put a batch in
+ * timestamp order, as merging per-interface captures would, without
+ * changing the order of any one interface's packets. Pcapng blocks
+ * from pipes stay where they are, and packets aren't moved past them.
+ */
+static void
+capture_loop_order_batch(pcap_queue_element **batch, unsigned count)
+{
+    for (unsigned i = 1; i < count; i++) {
+        pcap_queue_element *queue_element = batch[i];
+        int64_t             ts;
+        unsigned            j;
+
+        if (queue_element->pcap_src->from_pcapng) {
+            continue;
+        }
+        ts = queue_element_ts(queue_element);
+        for (j = i; j > 0; j--) {
+            const pcap_queue_element *prev = batch[j - 1];
+            if (prev->pcap_src->from_pcapng || prev->pcap_src == queue_element->pcap_src ||
+                queue_element_ts(prev) <= ts) {
+                break;
+            }
+            batch[j] = batch[j - 1];
+        }
+        batch[j] = queue_element;
+    }
+}
+
+/* Pop a batch of items off the packet queue, if there are any, and write
+ * them. Returns the number of items dequeued. */
+static unsigned
+capture_loop_dequeue_packets(void) {
+    pcap_queue_element *batch[WRITER_BATCH_SIZE];
     pcap_queue_element *queue_element;
+    unsigned            count = 0;
 
     g_async_queue_lock(pcap_queue);
     queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
+    while (queue_element) {
         if (queue_element->pcap_src->from_pcapng) {
             pcap_queue_bytes -= queue_element->u.bh.block_total_length;
         } else {
             pcap_queue_bytes -= queue_element->u.phdr.caplen;
         }
         pcap_queue_packets -= 1;
+        batch[count++] = queue_element;
+        if (count == WRITER_BATCH_SIZE) {
+            break;
+        }
+        queue_element = (pcap_queue_element *)g_async_queue_try_pop_unlocked(pcap_queue);
     }
     g_async_queue_unlock(pcap_queue);
-    if (queue_element) {
+
+    if (global_ld.pcaps->len > 1) {
+        capture_loop_order_batch(batch, count);
+    }
+
+    /* The write callbacks discard packets once capturing has stopped,
+     * as they do for the rest of a pcap_dispatch() batch. */
+    for (unsigned i = 0; i < count; i++) {
+        queue_element = batch[i];
         if (queue_element->pcap_src->from_pcapng) {
             ws_info("Dequeued a block of type 0x%08x of length %d captured on interface %d.",
                   queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
@@ -4187,9 +4420,8 @@ capture_loop_dequeue_packet(void) {
         }
         g_free(queue_element->pd);
         g_free(queue_element);
-        return true;
     }
-    return false;
+    return count;
 }
 
 /*
@@ -4386,13 +4618,7 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
     while (global_ld.go) {
         /* dispatch incoming packets */
         if (use_threads) {
-            bool dequeued = capture_loop_dequeue_packet();
-
-            if (dequeued) {
-                inpkts = 1;
-            } else {
-                inpkts = 0;
-            }
+            inpkts = capture_loop_dequeue_packets();
         } else {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, 0);
             inpkts = capture_loop_dispatch(&global_ld, errmsg,
@@ -4437,16 +4663,19 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
         /* Only update after an interval so as not to overload slow displays.
          * This also prevents too much context-switching between the dumpcap
          * and wireshark processes.
-         * XXX: Should we send updates sooner if there have been lots of
-         * packets we haven't notified the parent about, such as on fast links?
+         * On fast links, update as soon as there's a full batch of packets
+         * the parent hasn't been told about, so that it doesn't fall a whole
+         * interval's worth of packets behind.
          */
 #ifdef _WIN32
         cur_time = GetTickCount64();
-        if ((cur_time - upd_time) > capture_opts->update_interval)
+        if ((cur_time - upd_time) > capture_opts->update_interval ||
+            global_ld.inpkts_to_sync_pipe >= SYNC_PIPE_PACKET_BATCH)
 #else
         gettimeofday(&cur_time, NULL);
         if (((uint64_t)cur_time.tv_sec * 1000000 + cur_time.tv_usec) >
-            ((uint64_t)upd_time.tv_sec * 1000000 + upd_time.tv_usec + capture_opts->update_interval*1000))
+            ((uint64_t)upd_time.tv_sec * 1000000 + upd_time.tv_usec + capture_opts->update_interval*1000) ||
+            global_ld.inpkts_to_sync_pipe >= SYNC_PIPE_PACKET_BATCH)
 #endif
         {
 
@@ -4503,8 +4732,8 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
             ws_info("Thread of interface %u terminated.", pcap_src->interface_id);
         }
         while (1) {
-            bool dequeued = capture_loop_dequeue_packet();
-            if (!dequeued) {
+            unsigned dequeued = capture_loop_dequeue_packets();
+            if (dequeued == 0) {
                 break;
             }
             if (capture_opts->output_to_pipe) {
@@ -4900,7 +5129,11 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
                                        bh->block_total_length,
                                        &global_ld.bytes_written, &err);
 
-        ws_cwstream_flush(global_ld.pdh, NULL);
+        /* Data blocks are flushed by the main loop, once per batch or
+         * update interval; get everything else out right away. */
+        if (!is_data_block(bh->block_type)) {
+            ws_cwstream_flush(global_ld.pdh, NULL);
+        }
         if (!successful) {
             global_ld.go = false;
             global_ld.err = err;
@@ -5177,6 +5410,9 @@ gather_dumpcap_runtime_info(feature_list l)
 #ifdef _WIN32
 #define LONGOPT_SIGNAL_PIPE         LONGOPT_BASE_APPLICATION+5
 #endif
+#ifdef PACKET_FANOUT
+#define LONGOPT_FANOUT              LONGOPT_BASE_APPLICATION+6
+#endif
 
 /* And now our feature presentation... [ fade to music ] */
 int
@@ -5195,6 +5431,9 @@ main(int argc, char *argv[])
         {"application-flavor", ws_required_argument, NULL, LONGOPT_APPLICATION_FLAVOR},
 #ifdef _WIN32
         {"signal-pipe", ws_required_argument, NULL, LONGOPT_SIGNAL_PIPE},
+#endif
+#ifdef PACKET_FANOUT
+        {"fanout", ws_required_argument, NULL, LONGOPT_FANOUT},
 #endif
         {0, 0, 0, 0 }
     };
@@ -5587,6 +5826,13 @@ main(int argc, char *argv[])
                 return WS_EXIT_INVALID_OPTION;
             }
             break;
+#ifdef PACKET_FANOUT
+        case LONGOPT_FANOUT:           /* spread interfaces over PACKET_FANOUT groups */
+            if (!get_nonzero_uint32(ws_optarg, "fanout group id", &fanout_group_base))
+                arg_error = true;
+            use_threads = true;
+            break;
+#endif
         case LONGOPT_CAPTURE_COMMENT:  /* capture comment */
             if (capture_comments == NULL) {
                 capture_comments = g_ptr_array_new_with_free_func(g_free);
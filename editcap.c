@@ -65,6 +65,8 @@
 #include <wsutil/wslog.h>
 #include <wsutil/report_message.h>
 #include <wiretap/wtap_opttypes.h>
+#include <wiretap/pcapng_module.h>
+#include <wsutil/ws_roundup.h>
 
 #include "ui/failure_message.h"
 
@@ -93,6 +95,7 @@ typedef struct _fd_hash_t {
     uint8_t    digest[16];
     uint32_t   len;
     nstime_t   frame_time;
+    bool       used;
 } fd_hash_t;
 
 #define DEFAULT_DUP_DEPTH       5   /* Used with -d */
@@ -102,6 +105,19 @@ static fd_hash_t fd_hash[MAX_DUP_DEPTH];
 static unsigned  dup_window    = DEFAULT_DUP_DEPTH;
 static unsigned  cur_dup_entry;
 
+/*
+ * Index of the digests in the fd_hash[] window, so that looking for
+ * a duplicate takes the same time whatever the size of the window.
+ */
+typedef struct _fd_hash_count_t {
+    uint8_t    digest[16];
+    uint32_t   len;
+    unsigned   count;           /* entries in fd_hash[] with this digest and length */
+    unsigned   newest_entry;    /* the most recently added of those entries */
+} fd_hash_count_t;
+
+static GHashTable *fd_hash_index;
+
 static uint32_t  ignored_bytes;  /* Used with -I */
 
 #define ONE_BILLION 1000000000
@@ -667,6 +683,79 @@ set_unused_info(wtap_rec *rec) {
     }
 }
 
+static unsigned
+fd_hash_count_hash(const void *key)
+{
+    const fd_hash_count_t *hash_count = (const fd_hash_count_t *)key;
+    uint32_t h;
+
+    /* The digest is already well mixed. */
+    memcpy(&h, hash_count->digest, sizeof h);
+    return h ^ hash_count->len;
+}
+
+static gboolean
+fd_hash_count_equal(const void *a, const void *b)
+{
+    const fd_hash_count_t *hash_count_a = (const fd_hash_count_t *)a;
+    const fd_hash_count_t *hash_count_b = (const fd_hash_count_t *)b;
+
+    return hash_count_a->len == hash_count_b->len &&
+        memcmp(hash_count_a->digest, hash_count_b->digest, 16) == 0;
+}
+
+/* Remove an fd_hash[] entry, which is about to be reused, from the index. */
+static void
+fd_hash_index_remove(unsigned entry)
+{
+    fd_hash_count_t key;
+    fd_hash_count_t *hash_count;
+
+    if (!fd_hash[entry].used)
+        return;
+    fd_hash[entry].used = false;
+
+    memcpy(key.digest, fd_hash[entry].digest, 16);
+    key.len = fd_hash[entry].len;
+    hash_count = (fd_hash_count_t *)g_hash_table_lookup(fd_hash_index, &key);
+    if (hash_count != NULL && --hash_count->count == 0) {
+        g_hash_table_remove(fd_hash_index, hash_count);
+    }
+}
+
+/*
+ * Add the fd_hash[] entry that was just filled in to the index.
+ * Returns true, with the most recent such entry in *prev_entry, if
+ * another entry in the window has the same digest and length.
+ */
+static bool
+fd_hash_index_add(unsigned entry, unsigned *prev_entry)
+{
+    fd_hash_count_t key;
+    fd_hash_count_t *hash_count;
+    bool found;
+
+    memcpy(key.digest, fd_hash[entry].digest, 16);
+    key.len = fd_hash[entry].len;
+    hash_count = (fd_hash_count_t *)g_hash_table_lookup(fd_hash_index, &key);
+    if (hash_count == NULL) {
+        hash_count = g_new(fd_hash_count_t, 1);
+        memcpy(hash_count->digest, key.digest, 16);
+        hash_count->len = key.len;
+        hash_count->count = 0;
+        g_hash_table_add(fd_hash_index, hash_count);
+    }
+
+    found = hash_count->count > 0;
+    if (found)
+        *prev_entry = hash_count->newest_entry;
+    hash_count->count++;
+    hash_count->newest_entry = entry;
+    fd_hash[entry].used = true;
+
+    return found;
+}
+
 static bool
 is_duplicate(wtap_rec *rec) {
     uint8_t* fd = ws_buffer_start_ptr(&rec->data);
@@ -693,9 +782,12 @@ is_duplicate(wtap_rec *rec) {
     new_fd  = &fd[offset];
     new_len = len - (offset);
 
+    unsigned prev_entry;
+
     cur_dup_entry++;
     if (cur_dup_entry >= dup_window)
         cur_dup_entry = 0;
+    fd_hash_index_remove(cur_dup_entry);
 
     /* Calculate our digest */
     gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
@@ -703,24 +795,15 @@ is_duplicate(wtap_rec *rec) {
     fd_hash[cur_dup_entry].len = len;
 
     /* Look for duplicates */
-    for (unsigned i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
-
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return true;
-        }
-    }
-
-    return false;
+    return fd_hash_index_add(cur_dup_entry, &prev_entry);
 }
 
 static bool
 is_duplicate_rel_time(wtap_rec *rec, const nstime_t *current) {
     uint8_t* fd = ws_buffer_start_ptr(&rec->data);
     uint32_t len = rec->rec_header.packet_header.caplen;
-    int i;
+    unsigned prev_entry;
+    nstime_t delta;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     uint32_t offset = ignored_bytes;
@@ -737,6 +820,7 @@ is_duplicate_rel_time(wtap_rec *rec, const nstime_t *current) {
     cur_dup_entry++;
     if (cur_dup_entry >= dup_window)
         cur_dup_entry = 0;
+    fd_hash_index_remove(cur_dup_entry);
 
     /* Calculate our digest */
     gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
@@ -747,88 +831,25 @@ is_duplicate_rel_time(wtap_rec *rec, const nstime_t *current) {
 
     /*
      * Look for relative time related duplicates.
-     * This is hopefully a reasonably efficient mechanism for
-     * finding duplicates by rel time in the fd_hash[] cache.
-     * We check starting from the most recently added hash
-     * entries and work backwards towards older packets.
-     * This approach allows the dup test to be terminated
-     * when the relative time of a cached entry is found to
-     * be beyond the dup time window.
+     * The index gives us the most recently cached packet with the
+     * same digest, if any; it's a duplicate if its time stamp is
+     * within the dup time window before the current packet.
      *
      * Of course this assumes that the input trace file is
      * "well-formed" in the sense that the packet timestamps are
      * in strict chronologically increasing order (which is NOT
-     * always the case!!).
-     *
-     * The fd_hash[] table was deliberately created large (1,000,000).
-     * Looking for time related duplicates in large trace files with
-     * non-fractional dup time window values can potentially take
-     * a long time to complete.
+     * always the case!!).  A cached packet with a later time
+     * stamp than the current one, which is NOT a normal situation,
+     * isn't treated as a duplicate.
      */
+    if (!fd_hash_index_add(cur_dup_entry, &prev_entry))
+        return false;
 
-    for (i = cur_dup_entry - 1;; i--) {
-        nstime_t delta;
-        int cmp;
-
-        if (i < 0)
-            i = dup_window - 1;
-
-        if (i == (int)cur_dup_entry) {
-            /*
-             * We've decremented back to where we started.
-             * Check no more!
-             */
-            break;
-        }
-
-        if (nstime_is_unset(&(fd_hash[i].frame_time))) {
-            /*
-             * We've decremented to an unused fd_hash[] entry.
-             * Check no more!
-             */
-            break;
-        }
-
-        nstime_delta(&delta, current, &fd_hash[i].frame_time);
-
-        if (delta.secs < 0 || delta.nsecs < 0) {
-            /*
-             * A negative delta implies that the current packet
-             * has an absolute timestamp less than the cached packet
-             * that it is being compared to.  This is NOT a normal
-             * situation since trace files usually have packets in
-             * chronological order (oldest to newest).
-             *
-             * There are several possible ways to deal with this:
-             * 1. 'continue' dup checking with the next cached frame.
-             * 2. 'break' from looking for a duplicate of the current frame.
-             * 3. Take the absolute value of the delta and see if that
-             * falls within the specified dup time window.
-             *
-             * Currently this code does option 1.  But it would pretty
-             * easy to add yet-another-editcap-option to select one of
-             * the other behaviors for dealing with out-of-sequence
-             * packets.
-             */
-            continue;
-        }
-
-        cmp = nstime_cmp(&delta, &relative_time_window);
-
-        if (cmp > 0) {
-            /*
-             * The delta time indicates that we are now looking at
-             * cached packets beyond the specified dup time window.
-             * Check no more!
-             */
-            break;
-        } else if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-                   && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return true;
-        }
-    }
+    nstime_delta(&delta, current, &fd_hash[prev_entry].frame_time);
+    if (delta.secs < 0 || delta.nsecs < 0)
+        return false;
 
-    return false;
+    return nstime_cmp(&delta, &relative_time_window) <= 0;
 }
 
 static void
@@ -1382,6 +1403,478 @@ extract_secrets(wtap *wth, char* filename, int *err, char **err_info)
     return EXIT_SUCCESS;
 }
 
+/*
+ * Fast path for splitting a pcapng file into uncompressed pcapng files
+ * with -c or -i when nothing else about the records is being changed.
+ *
+ * Rather than have libwiretap parse every record and the pcapng writer
+ * serialize it again, blocks are copied verbatim, through large stdio
+ * buffers.  Each output file starts with the Section Header Block of
+ * the current section, with our application name added if the block
+ * doesn't have one and the section length made unknown, followed by the
+ * section's Interface Description and Decryption Secrets Blocks seen so
+ * far, exactly as they were read.  Blocks of other types that come
+ * before the first packet go into the first file only; after that, every
+ * block goes into the file being written at the time.
+ */
+#define FAST_SPLIT_BUFFER_SIZE  (4 * 1024 * 1024)
+#define FAST_SPLIT_MAX_BLOCK    (128 * 1024 * 1024)
+#define FAST_SPLIT_BOM          0x1A2B3C4D
+
+typedef struct {
+    uint64_t  units_per_sec;    /* from if_tsresol */
+    int64_t   tsoffset;         /* from if_tsoffset */
+} fast_split_if_t;
+
+typedef struct {
+    const char *in_filename;
+    FILE     *in;
+    bool      big_endian;       /* byte order of the current section */
+    GArray   *interfaces;       /* fast_split_if_t, for the current section */
+    Buffer    headers;          /* blocks that start each output file */
+    Buffer    pending;          /* other blocks before the first packet */
+    Buffer    block;            /* the block just read */
+    char     *filename;
+    FILE     *out;
+    uint64_t  read_count;       /* packets */
+} fast_split_t;
+
+static uint16_t
+fast_split_get16(const fast_split_t *fs, const uint8_t *p)
+{
+    return fs->big_endian ? pntohu16(p) : pletohu16(p);
+}
+
+static uint32_t
+fast_split_get32(const fast_split_t *fs, const uint8_t *p)
+{
+    return fs->big_endian ? pntohu32(p) : pletohu32(p);
+}
+
+static void
+fast_split_put16(const fast_split_t *fs, uint8_t *p, uint16_t v)
+{
+    if (fs->big_endian)
+        phtonu16(p, v);
+    else
+        phtoleu16(p, v);
+}
+
+static void
+fast_split_put32(const fast_split_t *fs, uint8_t *p, uint32_t v)
+{
+    if (fs->big_endian)
+        phtonu32(p, v);
+    else
+        phtoleu32(p, v);
+}
+
+static int
+fast_split_read_err(FILE *fp)
+{
+    return ferror(fp) ? errno : WTAP_ERR_SHORT_READ;
+}
+
+/*
+ * Read the next block into fs->block.  Returns false with *err set to 0
+ * at the end of the file.
+ */
+static bool
+fast_split_read_block(fast_split_t *fs, uint32_t *typep, int *err, char **err_info)
+{
+    uint8_t  hdr[12];
+    size_t   hdr_len = 8;
+    size_t   nread;
+    uint32_t type, total_len, magic;
+    uint8_t *p;
+
+    nread = fread(hdr, 1, 8, fs->in);
+    if (nread == 0 && !ferror(fs->in)) {
+        *err = 0;
+        return false;
+    }
+    if (nread != 8) {
+        *err = fast_split_read_err(fs->in);
+        return false;
+    }
+
+    /*
+     * The SHB block type reads the same in either byte order; the
+     * byte-order magic after the length tells us the order of the
+     * section it starts.
+     */
+    if (pletohu32(hdr) == BLOCK_TYPE_SHB) {
+        if (fread(hdr + 8, 1, 4, fs->in) != 4) {
+            *err = fast_split_read_err(fs->in);
+            return false;
+        }
+        hdr_len = 12;
+        magic = pletohu32(hdr + 8);
+        if (magic == FAST_SPLIT_BOM) {
+            fs->big_endian = false;
+        } else if (magic == GUINT32_SWAP_LE_BE(FAST_SPLIT_BOM)) {
+            fs->big_endian = true;
+        } else {
+            *err = WTAP_ERR_BAD_FILE;
+            *err_info = ws_strdup_printf("pcapng: unknown byte-order magic number 0x%08x", magic);
+            return false;
+        }
+    }
+    type = fast_split_get32(fs, hdr);
+    total_len = fast_split_get32(fs, hdr + 4);
+    if (total_len < (type == BLOCK_TYPE_SHB ? 28 : 12) || (total_len % 4) != 0 ||
+        total_len > FAST_SPLIT_MAX_BLOCK) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("pcapng: block of type 0x%08x has an invalid length %u",
+                                     type, total_len);
+        return false;
+    }
+
+    ws_buffer_clean(&fs->block);
+    ws_buffer_assure_space(&fs->block, total_len);
+    p = ws_buffer_start_ptr(&fs->block);
+    memcpy(p, hdr, hdr_len);
+    if (fread(p + hdr_len, 1, total_len - hdr_len, fs->in) != total_len - hdr_len) {
+        *err = fast_split_read_err(fs->in);
+        return false;
+    }
+    ws_buffer_increase_length(&fs->block, total_len);
+    if (fast_split_get32(fs, p + total_len - 4) != total_len) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("pcapng: block of type 0x%08x has mismatched lengths",
+                                     type);
+        return false;
+    }
+    *typep = type;
+    return true;
+}
+
+/*
+ * Start a new section: the headers for new files become a copy of its
+ * Section Header Block, with an unknown section length, since we're
+ * splitting the section, and with our application name added if no
+ * application is named.
+ */
+static void
+fast_split_start_section(fast_split_t *fs)
+{
+    const uint8_t *p = ws_buffer_start_ptr(&fs->block);
+    uint32_t total_len = (uint32_t)ws_buffer_length(&fs->block);
+    uint32_t off = 24, end = 24;
+    uint16_t code, len;
+    bool     have_userappl = false;
+    uint8_t  opt_hdr[4];
+    uint8_t *shb;
+
+    while (off + 4 <= total_len - 4) {
+        code = fast_split_get16(fs, p + off);
+        len = fast_split_get16(fs, p + off + 2);
+        if (code == OPT_EOFOPT || off + 4 + WS_ROUNDUP_4(len) > total_len - 4)
+            break;
+        if (code == OPT_SHB_USERAPPL)
+            have_userappl = true;
+        off += 4 + WS_ROUNDUP_4(len);
+        end = off;
+    }
+
+    ws_buffer_clean(&fs->headers);
+    ws_buffer_append(&fs->headers, p, end);
+    if (!have_userappl) {
+        const char *appl = get_appname_and_version();
+        size_t appl_len = MIN(strlen(appl), UINT16_MAX);
+        static const uint8_t zeroes[4];
+
+        fast_split_put16(fs, opt_hdr, OPT_SHB_USERAPPL);
+        fast_split_put16(fs, opt_hdr + 2, (uint16_t)appl_len);
+        ws_buffer_append(&fs->headers, opt_hdr, 4);
+        ws_buffer_append(&fs->headers, (const uint8_t *)appl, appl_len);
+        ws_buffer_append(&fs->headers, zeroes, WS_ROUNDUP_4(appl_len) - appl_len);
+    }
+    /* opt_endofopt, then the trailing length */
+    memset(opt_hdr, 0, 4);
+    ws_buffer_append(&fs->headers, opt_hdr, 4);
+    ws_buffer_append(&fs->headers, opt_hdr, 4);
+
+    shb = ws_buffer_start_ptr(&fs->headers);
+    total_len = (uint32_t)ws_buffer_length(&fs->headers);
+    fast_split_put32(fs, shb + 4, total_len);
+    memset(shb + 16, 0xFF, 8);          /* section length: unknown */
+    fast_split_put32(fs, shb + total_len - 4, total_len);
+
+    g_array_set_size(fs->interfaces, 0);
+}
+
+/* Note the time stamp resolution and offset of an interface. */
+static bool
+fast_split_add_interface(fast_split_t *fs, int *err, char **err_info)
+{
+    const uint8_t *p = ws_buffer_start_ptr(&fs->block);
+    uint32_t total_len = (uint32_t)ws_buffer_length(&fs->block);
+    fast_split_if_t iface = { 1000000, 0 };
+    uint32_t off = 16;
+    uint16_t code, len;
+    uint8_t  tsresol;
+
+    while (off + 4 <= total_len - 4) {
+        code = fast_split_get16(fs, p + off);
+        len = fast_split_get16(fs, p + off + 2);
+        if (code == OPT_EOFOPT || off + 4 + WS_ROUNDUP_4(len) > total_len - 4)
+            break;
+        if (code == OPT_IDB_TSRESOL && len == 1) {
+            tsresol = p[off + 4];
+            if (tsresol & 0x80) {
+                if ((tsresol & 0x7F) > 63)
+                    goto bad_tsresol;
+                iface.units_per_sec = UINT64_C(1) << (tsresol & 0x7F);
+            } else {
+                if (tsresol > 19)
+                    goto bad_tsresol;
+                iface.units_per_sec = 1;
+                for (unsigned i = 0; i < tsresol; i++)
+                    iface.units_per_sec *= 10;
+            }
+        } else if (code == OPT_IDB_TSOFFSET && len == 8) {
+            iface.tsoffset = (int64_t)(fs->big_endian ? pntohu64(p + off + 4) : pletohu64(p + off + 4));
+        }
+        off += 4 + WS_ROUNDUP_4(len);
+    }
+    g_array_append_val(fs->interfaces, iface);
+    return true;
+
+bad_tsresol:
+    *err = WTAP_ERR_UNSUPPORTED;
+    *err_info = ws_strdup_printf("pcapng: IDB power-of-%u time stamp resolution %u is too high",
+                                 (tsresol & 0x80) ? 2 : 10, tsresol & 0x7F);
+    return false;
+}
+
+/* Get the time stamp of a packet block, if it has one. */
+static bool
+fast_split_packet_ts(fast_split_t *fs, uint32_t type, nstime_t *ts, bool *has_ts,
+                     int *err, char **err_info)
+{
+    const uint8_t *p = ws_buffer_start_ptr(&fs->block);
+    const fast_split_if_t *iface;
+    uint32_t interface_id;
+    uint64_t units, rem;
+
+    *has_ts = false;
+    if (type == BLOCK_TYPE_SPB)
+        return true;
+    if (ws_buffer_length(&fs->block) < 32) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("pcapng: packet block of type 0x%08x is too short", type);
+        return false;
+    }
+    if (type == BLOCK_TYPE_EPB)
+        interface_id = fast_split_get32(fs, p + 8);
+    else
+        interface_id = fast_split_get16(fs, p + 8);
+    if (interface_id >= fs->interfaces->len) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("pcapng: interface index %u is not less than section interface count %u",
+                                     interface_id, fs->interfaces->len);
+        return false;
+    }
+    iface = &g_array_index(fs->interfaces, fast_split_if_t, interface_id);
+    units = ((uint64_t)fast_split_get32(fs, p + 12) << 32) | fast_split_get32(fs, p + 16);
+    rem = units % iface->units_per_sec;
+    ts->secs = (time_t)(units / iface->units_per_sec) + (time_t)iface->tsoffset;
+    if (iface->units_per_sec <= UINT64_MAX / NANOSECS_PER_SEC)
+        ts->nsecs = (int)(rem * NANOSECS_PER_SEC / iface->units_per_sec);
+    else
+        ts->nsecs = (int)((double)rem * NANOSECS_PER_SEC / (double)iface->units_per_sec);
+    *has_ts = true;
+    return true;
+}
+
+static bool
+fast_split_write(fast_split_t *fs, Buffer *buf)
+{
+    size_t len = ws_buffer_length(buf);
+
+    if (len != 0 && fwrite(ws_buffer_start_ptr(buf), 1, len, fs->out) != len) {
+        report_cfile_write_failure(fs->in_filename, fs->filename, errno, NULL,
+                                   fs->read_count, wtap_pcapng_file_type_subtype());
+        return false;
+    }
+    return true;
+}
+
+static bool
+fast_split_close(fast_split_t *fs)
+{
+    FILE *out = fs->out;
+
+    fs->out = NULL;
+    if (fclose(out) != 0) {
+        report_cfile_close_failure(fs->filename, errno, NULL);
+        return false;
+    }
+    return true;
+}
+
+/* Start writing the next file, which takes ownership of filename. */
+static int
+fast_split_open(fast_split_t *fs, char *filename)
+{
+    g_free(fs->filename);
+    fs->filename = filename;
+    fs->out = ws_fopen(filename, "wb");
+    if (fs->out == NULL) {
+        report_cfile_dump_open_failure(filename, errno, NULL,
+                                       wtap_pcapng_file_type_subtype());
+        return WS_EXIT_INVALID_FILE;
+    }
+    setvbuf(fs->out, NULL, _IOFBF, FAST_SPLIT_BUFFER_SIZE);
+    if (!fast_split_write(fs, &fs->headers) || !fast_split_write(fs, &fs->pending))
+        return WRITE_ERROR;
+    ws_buffer_clean(&fs->pending);
+    return EXIT_SUCCESS;
+}
+
+/* Close the current file, if any, and start the next one. */
+static int
+fast_split_next(fast_split_t *fs, char *filename)
+{
+    if (fs->out != NULL) {
+        if (!fast_split_close(fs)) {
+            g_free(filename);
+            return WRITE_ERROR;
+        }
+        if (verbose)
+            fprintf(stderr, "Continuing writing in file %s\n", filename);
+    }
+    return fast_split_open(fs, filename);
+}
+
+static int
+fast_split(const char *in_filename, const char *out_filename,
+           char *fprefix, char *fsuffix,
+           uint64_t split_packet_count, const nstime_t *secs_per_block)
+{
+    fast_split_t fs;
+    int          ret = EXIT_SUCCESS;
+    int          err = 0;
+    char        *err_info = NULL;
+    uint32_t     type;
+    nstime_t     ts;
+    bool         has_ts;
+    nstime_t     block_next = NSTIME_INIT_UNSET;
+    unsigned     block_cnt = 0;
+    uint64_t     written_count = 0;
+
+    memset(&fs, 0, sizeof fs);
+    fs.in_filename = in_filename;
+    fs.in = ws_fopen(in_filename, "rb");
+    if (fs.in == NULL) {
+        report_cfile_open_failure(in_filename, errno, NULL);
+        return WS_EXIT_INVALID_FILE;
+    }
+    setvbuf(fs.in, NULL, _IOFBF, FAST_SPLIT_BUFFER_SIZE);
+    fs.interfaces = g_array_new(FALSE, FALSE, sizeof(fast_split_if_t));
+    ws_buffer_init(&fs.headers, 0);
+    ws_buffer_init(&fs.pending, 0);
+    ws_buffer_init(&fs.block, DEFAULT_INIT_BUFFER_SIZE_2048);
+
+    while (ret == EXIT_SUCCESS && fast_split_read_block(&fs, &type, &err, &err_info)) {
+        if (type != BLOCK_TYPE_SHB && ws_buffer_length(&fs.headers) == 0) {
+            err = WTAP_ERR_BAD_FILE;
+            err_info = ws_strdup_printf("pcapng: block of type 0x%08x before the first section header",
+                                        type);
+            break;
+        }
+        switch (type) {
+
+        case BLOCK_TYPE_SHB:
+            fast_split_start_section(&fs);
+            if (fs.out != NULL && !fast_split_write(&fs, &fs.headers))
+                ret = WRITE_ERROR;
+            break;
+
+        case BLOCK_TYPE_IDB:
+            if (!fast_split_add_interface(&fs, &err, &err_info))
+                goto read_error;
+            /* FALLTHROUGH */
+        case BLOCK_TYPE_DSB:
+            ws_buffer_append_buffer(&fs.headers, &fs.block);
+            if (fs.out != NULL && !fast_split_write(&fs, &fs.block))
+                ret = WRITE_ERROR;
+            break;
+
+        case BLOCK_TYPE_EPB:
+        case BLOCK_TYPE_PB:
+        case BLOCK_TYPE_SPB:
+            if (!fast_split_packet_ts(&fs, type, &ts, &has_ts, &err, &err_info))
+                goto read_error;
+            fs.read_count++;
+
+            /* The same decisions as the main loop makes for each packet. */
+            if (fs.out == NULL) {
+                ret = fast_split_open(&fs, fileset_get_filename_by_pattern(block_cnt++,
+                                                                           has_ts ? &ts : NULL,
+                                                                           fprefix, fsuffix));
+                if (ret != EXIT_SUCCESS)
+                    break;
+            }
+            if (has_ts && !nstime_is_unset(secs_per_block)) {
+                if (nstime_is_unset(&block_next)) {
+                    block_next = ts;
+                    nstime_add(&block_next, secs_per_block);
+                }
+                while (ret == EXIT_SUCCESS && nstime_cmp(&ts, &block_next) > 0) {
+                    /* Use the interval start time for the filename. */
+                    ret = fast_split_next(&fs, fileset_get_filename_by_pattern(block_cnt++, &block_next,
+                                                                               fprefix, fsuffix));
+                    nstime_add(&block_next, secs_per_block);
+                }
+            }
+            if (ret == EXIT_SUCCESS && split_packet_count != 0 &&
+                written_count > 0 && (written_count % split_packet_count) == 0) {
+                ret = fast_split_next(&fs, fileset_get_filename_by_pattern(block_cnt++,
+                                                                           has_ts ? &ts : NULL,
+                                                                           fprefix, fsuffix));
+            }
+            if (ret == EXIT_SUCCESS && !fast_split_write(&fs, &fs.block))
+                ret = WRITE_ERROR;
+            written_count++;
+            break;
+
+        default:
+            if (fs.out != NULL) {
+                if (!fast_split_write(&fs, &fs.block))
+                    ret = WRITE_ERROR;
+            } else {
+                ws_buffer_append_buffer(&fs.pending, &fs.block);
+            }
+            break;
+        }
+    }
+
+read_error:
+    if (err != 0) {
+        report_cfile_read_failure(in_filename, err, err_info);
+    }
+
+    if (ret == EXIT_SUCCESS) {
+        if (verbose)
+            fprintf(stderr, "Total selected: %" PRIu64 "\n", written_count);
+        /* No packets, so write a file with just the headers, as the main loop does. */
+        if (fs.out == NULL)
+            ret = fast_split_open(&fs, g_strdup(out_filename));
+    }
+    if (fs.out != NULL && !fast_split_close(&fs) && ret == EXIT_SUCCESS)
+        ret = WRITE_ERROR;
+
+    fclose(fs.in);
+    g_free(fs.filename);
+    ws_buffer_free(&fs.block);
+    ws_buffer_free(&fs.pending);
+    ws_buffer_free(&fs.headers);
+    g_array_free(fs.interfaces, TRUE);
+    return ret;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -1456,6 +1949,7 @@ main(int argc, char *argv[])
     bool                         valid_seed = false;
     unsigned int                 seed = 0;
     bool                         edit_option_specified = false;
+    bool                         record_option_specified = false;
     ws_compression_type compression_type   = WS_FILE_UNKNOWN_COMPRESSION;
     const struct file_extension_info* file_extensions;
     unsigned num_extensions;
@@ -1508,6 +2002,10 @@ main(int argc, char *argv[])
         if (opt != LONGOPT_EXTRACT_SECRETS && opt != 'V') {
             edit_option_specified = true;
         }
+        if (opt != 'c' && opt != 'i' && opt != 'F' && opt != 'V' &&
+            opt != LONGOPT_COMPRESS) {
+            record_option_specified = true;
+        }
         switch (opt) {
         case LONGOPT_NO_VLAN:
         {
@@ -2095,6 +2593,23 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    /*
+     * If all we're doing is splitting a pcapng file into uncompressed
+     * pcapng files, copy the blocks rather than reading and rewriting
+     * every record.
+     */
+    if ((split_packet_count != 0 || !nstime_is_unset(&secs_per_block)) &&
+        !record_option_specified && argc == ws_optind + 2 &&
+        strcmp(argv[ws_optind], "-") != 0 &&
+        wtap_file_type_subtype(wth) == wtap_pcapng_file_type_subtype() &&
+        wtap_get_compression_type(wth) == WS_FILE_UNCOMPRESSED &&
+        out_file_type_subtype == wtap_pcapng_file_type_subtype() &&
+        compression_type == WS_FILE_UNCOMPRESSED) {
+        ret = fast_split(argv[ws_optind], argv[ws_optind+1], fprefix, fsuffix,
+                         split_packet_count, &secs_per_block);
+        goto clean_exit;
+    }
+
     wtap_dump_params_init_no_idbs(&params, wth);
 
     /*
@@ -2208,7 +2723,9 @@ main(int argc, char *argv[])
             memset(&fd_hash[u].digest, 0, 16);
             fd_hash[u].len = 0;
             nstime_set_unset(&fd_hash[u].frame_time);
+            fd_hash[u].used = false;
         }
+        fd_hash_index = g_hash_table_new_full(fd_hash_count_hash, fd_hash_count_equal, g_free, NULL);
     }
 
     /* Set up an array of all IDBs seen */
@@ -2736,6 +3253,9 @@ clean_exit:
         }
         g_array_free(idbs_seen, TRUE);
     }
+    if (fd_hash_index != NULL) {
+        g_hash_table_destroy(fd_hash_index);
+    }
     g_free(params.idb_inf);
     wtap_dump_params_cleanup(&params);
     if (wth != NULL)
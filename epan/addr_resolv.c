@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include <wsutil/strtoi.h>
 #include <wsutil/ws_assert.h>
@@ -106,6 +107,7 @@
 #define ENAME_VLANS     "vlans"
 #define ENAME_SS7PCS    "ss7pcs"
 #define ENAME_ENTERPRISES "enterprises"
+#define ENAME_DNS_CACHE "dns_cache"
 #define ENAME_TACS      "tacs"
 
 #define HASHETHSIZE      2048
@@ -325,6 +327,7 @@ e_addr_resolve gbl_resolv_flags = {
  */
 static unsigned name_resolve_concurrency = 500;
 static bool resolve_synchronously;
+static bool use_dns_cache;
 
 /*
  *  Global variables (can be changed in GUI sections)
@@ -372,6 +375,9 @@ typedef struct _async_hostent {
 static void
 c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he);
 
+static void dns_cache_add_ipv4(const uint32_t addr, const char *name);
+static void dns_cache_add_ipv6(const ws_in6_addr *addrp, const char *name);
+
 /*
  * Submitted synchronous queries trigger a callback (c_ares_ghba_sync_cb()).
  * The callback processes the response, sets completed to true if
@@ -395,6 +401,32 @@ static  unsigned    async_dns_in_flight;
 static  wmem_list_t *async_dns_queue_head;
 static  GMutex      async_dns_queue_mtx;
 
+/*
+ * Upper bound on the number of select()/ares_process() rounds done by a
+ * single host_name_lookup_process() call, so that a steady stream of
+ * replies cannot keep the caller's main loop from running.
+ */
+#define ASYNC_DNS_MAX_ROUNDS 32
+
+/*
+ * Names obtained from DNS replies can be saved in the personal "dns_cache"
+ * file, and are then used instead of a new query in later sessions. The
+ * file uses the hosts file format followed by the time of the reply;
+ * entries older than DNS_CACHE_MAX_AGE seconds are queried again.
+ */
+#define DNS_CACHE_MAX_AGE (7 * 24 * 60 * 60)
+
+typedef struct _dns_cache_entry
+{
+    time_t       time;
+    char        *name;
+} dns_cache_entry_t;
+
+static  char        *dns_cache_path;
+static  wmem_map_t  *dns_cache_ipv4;    /* uint32_t -> dns_cache_entry_t */
+static  wmem_map_t  *dns_cache_ipv6;    /* ws_in6_addr* -> dns_cache_entry_t */
+static  bool        dns_cache_dirty;
+
 //UAT for providing a list of DNS servers to C-ARES for name resolution
 bool use_custom_dns_server_list;
 struct dns_server_data {
@@ -476,9 +508,11 @@ c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he)
             switch(sdd->family) {
                 case AF_INET:
                     add_ipv4_name(sdd->addr.ip4, he->h_name, false);
+                    dns_cache_add_ipv4(sdd->addr.ip4, he->h_name);
                     break;
                 case AF_INET6:
                     add_ipv6_name(&sdd->addr.ip6, he->h_name, false);
+                    dns_cache_add_ipv6(&sdd->addr.ip6, he->h_name);
                     break;
                 default:
                     /* Throw an exception? */
@@ -559,7 +593,7 @@ process_async_dns_queue(void)
 
     head = wmem_list_head(async_dns_queue_head);
 
-    while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
+    while (head != NULL && async_dns_in_flight < name_resolve_concurrency) {
         caqm = (async_dns_queue_msg_t *)wmem_list_frame_data(head);
         wmem_list_remove_frame(async_dns_queue_head, head);
         if (caqm->family == AF_INET) {
@@ -781,6 +815,192 @@ fgetline(char *buf, int size, FILE *fp)
 } /* fgetline */
 
 
+/*
+ * Read the DNS cache file, if that hasn't been done yet.
+ */
+static void
+dns_cache_load(void)
+{
+    FILE *cf;
+    char line[MAX_LINELEN];
+    char *cp, *name;
+    union {
+        uint32_t ip4_addr;
+        ws_in6_addr ip6_addr;
+    } host_addr;
+    bool is_ipv6;
+    int64_t reply_time;
+    time_t oldest;
+    dns_cache_entry_t *entry;
+
+    if (dns_cache_ipv4 != NULL)
+        return;
+
+    dns_cache_ipv4 = wmem_map_new(addr_resolv_scope, g_direct_hash, g_direct_equal);
+    dns_cache_ipv6 = wmem_map_new(addr_resolv_scope, ws_ipv6_hash, ipv6_equal);
+
+    if (dns_cache_path == NULL || (cf = ws_fopen(dns_cache_path, "r")) == NULL)
+        return;
+
+    oldest = time(NULL) - DNS_CACHE_MAX_AGE;
+    while (fgetline(line, sizeof(line), cf) >= 0) {
+        if ((cp = strchr(line, '#')))
+            *cp = '\0';
+
+        if ((cp = strtok(line, " \t")) == NULL)
+            continue; /* no tokens in the line */
+
+        if (ws_inet_pton6(cp, &host_addr.ip6_addr)) {
+            is_ipv6 = true;
+        } else if (ws_inet_pton4(cp, &host_addr.ip4_addr)) {
+            is_ipv6 = false;
+        } else {
+            continue;
+        }
+
+        if ((name = strtok(NULL, " \t")) == NULL)
+            continue; /* no host name */
+
+        if ((cp = strtok(NULL, " \t")) == NULL || !ws_strtoi64(cp, NULL, &reply_time))
+            continue; /* no time of the reply */
+
+        if (reply_time < oldest)
+            continue; /* stale, query it again */
+
+        entry = wmem_new(addr_resolv_scope, dns_cache_entry_t);
+        entry->time = (time_t)reply_time;
+        entry->name = wmem_strdup(addr_resolv_scope, name);
+        if (is_ipv6) {
+            ws_in6_addr *addr_key = wmem_new(addr_resolv_scope, ws_in6_addr);
+            memcpy(addr_key, &host_addr.ip6_addr, sizeof(ws_in6_addr));
+            wmem_map_insert(dns_cache_ipv6, addr_key, entry);
+        } else {
+            wmem_map_insert(dns_cache_ipv4, GUINT_TO_POINTER(host_addr.ip4_addr), entry);
+        }
+    }
+
+    fclose(cf);
+}
+
+static const char *
+dns_cache_lookup_ipv4(const uint32_t addr)
+{
+    dns_cache_entry_t *entry;
+
+    if (!use_dns_cache)
+        return NULL;
+
+    dns_cache_load();
+    entry = (dns_cache_entry_t *)wmem_map_lookup(dns_cache_ipv4, GUINT_TO_POINTER(addr));
+    return entry ? entry->name : NULL;
+}
+
+static const char *
+dns_cache_lookup_ipv6(const ws_in6_addr *addrp)
+{
+    dns_cache_entry_t *entry;
+
+    if (!use_dns_cache)
+        return NULL;
+
+    dns_cache_load();
+    entry = (dns_cache_entry_t *)wmem_map_lookup(dns_cache_ipv6, addrp);
+    return entry ? entry->name : NULL;
+}
+
+static dns_cache_entry_t *
+dns_cache_entry_update(dns_cache_entry_t *entry, const char *name)
+{
+    if (entry == NULL) {
+        entry = wmem_new0(addr_resolv_scope, dns_cache_entry_t);
+    }
+    wmem_free(addr_resolv_scope, entry->name);
+    entry->name = wmem_strdup(addr_resolv_scope, name);
+    entry->time = time(NULL);
+    dns_cache_dirty = true;
+    return entry;
+}
+
+static void
+dns_cache_add_ipv4(const uint32_t addr, const char *name)
+{
+    dns_cache_entry_t *entry;
+
+    if (!use_dns_cache || !name || name[0] == '\0')
+        return;
+
+    dns_cache_load();
+    entry = (dns_cache_entry_t *)wmem_map_lookup(dns_cache_ipv4, GUINT_TO_POINTER(addr));
+    if (entry == NULL) {
+        wmem_map_insert(dns_cache_ipv4, GUINT_TO_POINTER(addr), dns_cache_entry_update(NULL, name));
+    } else {
+        dns_cache_entry_update(entry, name);
+    }
+}
+
+static void
+dns_cache_add_ipv6(const ws_in6_addr *addrp, const char *name)
+{
+    dns_cache_entry_t *entry;
+
+    if (!use_dns_cache || !name || name[0] == '\0')
+        return;
+
+    dns_cache_load();
+    entry = (dns_cache_entry_t *)wmem_map_lookup(dns_cache_ipv6, addrp);
+    if (entry == NULL) {
+        ws_in6_addr *addr_key = wmem_new(addr_resolv_scope, ws_in6_addr);
+        memcpy(addr_key, addrp, sizeof(ws_in6_addr));
+        wmem_map_insert(dns_cache_ipv6, addr_key, dns_cache_entry_update(NULL, name));
+    } else {
+        dns_cache_entry_update(entry, name);
+    }
+}
+
+static void
+dns_cache_write_ipv4(void *key, void *value, void *user_data)
+{
+    uint32_t addr = GPOINTER_TO_UINT(key);
+    dns_cache_entry_t *entry = (dns_cache_entry_t *)value;
+    char buf[WS_INET_ADDRSTRLEN];
+
+    ip_addr_to_str_buf(&addr, buf, sizeof(buf));
+    fprintf((FILE *)user_data, "%s\t%s\t%" PRId64 "\n", buf, entry->name, (int64_t)entry->time);
+}
+
+static void
+dns_cache_write_ipv6(void *key, void *value, void *user_data)
+{
+    dns_cache_entry_t *entry = (dns_cache_entry_t *)value;
+    char buf[WS_INET6_ADDRSTRLEN];
+
+    ip6_to_str_buf((const ws_in6_addr *)key, buf, sizeof(buf));
+    fprintf((FILE *)user_data, "%s\t%s\t%" PRId64 "\n", buf, entry->name, (int64_t)entry->time);
+}
+
+/*
+ * Save the DNS cache, if anything was added to it.
+ */
+static void
+dns_cache_write(void)
+{
+    FILE *cf;
+
+    if (!dns_cache_dirty || dns_cache_path == NULL)
+        return;
+
+    if ((cf = ws_fopen(dns_cache_path, "w")) == NULL)
+        return;
+
+    fputs("# Host names from DNS replies, saved by the name resolution\n"
+          "# \"use_dns_cache\" preference. Format: address name time\n", cf);
+    wmem_map_foreach(dns_cache_ipv4, dns_cache_write_ipv4, cf);
+    wmem_map_foreach(dns_cache_ipv6, dns_cache_write_ipv6, cf);
+    fclose(cf);
+    dns_cache_dirty = false;
+}
+
+
 /*
  *  Local function definitions
  */
@@ -1250,9 +1470,11 @@ c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
             switch(caqm->family) {
                 case AF_INET:
                     add_ipv4_name(caqm->addr.ip4, he->h_name, false);
+                    dns_cache_add_ipv4(caqm->addr.ip4, he->h_name);
                     break;
                 case AF_INET6:
                     add_ipv6_name(&caqm->addr.ip6, he->h_name, false);
+                    dns_cache_add_ipv6(&caqm->addr.ip6, he->h_name);
                     break;
                 default:
                     /* Throw an exception? */
@@ -1302,9 +1524,14 @@ host_lookup(const unsigned addr)
         return tp;
 
     if (gbl_resolv_flags.use_external_net_name_resolver) {
+        const char *cached_name;
+
         tp->flags |= TRIED_RESOLVE_ADDRESS;
 
-        if (async_dns_initialized) {
+        if ((cached_name = dns_cache_lookup_ipv4(addr)) != NULL) {
+            /* A recent reply is in the DNS cache; don't ask again. */
+            add_ipv4_name(addr, cached_name, false);
+        } else if (async_dns_initialized) {
             /* c-ares is initialized, so we can use it */
             if (resolve_synchronously || name_resolve_concurrency == 0) {
                 /*
@@ -1377,9 +1604,14 @@ host_lookup6(const ws_in6_addr *addr)
         return tp;
 
     if (gbl_resolv_flags.use_external_net_name_resolver) {
+        const char *cached_name;
+
         tp->flags |= TRIED_RESOLVE_ADDRESS;
 
-        if (async_dns_initialized) {
+        if ((cached_name = dns_cache_lookup_ipv6(addr)) != NULL) {
+            /* A recent reply is in the DNS cache; don't ask again. */
+            add_ipv6_name(addr, cached_name, false);
+        } else if (async_dns_initialized) {
             /* c-ares is initialized, so we can use it */
             if (resolve_synchronously || name_resolve_concurrency == 0) {
                 /*
@@ -3489,6 +3721,14 @@ addr_resolve_pref_init(module_t *nameres)
             10,
             &name_resolve_concurrency);
 
+    prefs_register_bool_preference(nameres, "use_dns_cache",
+            "Save DNS results between sessions",
+            "Save the host names received in DNS replies in the \"dns_cache\""
+            " file in the personal configuration directory, and use them"
+            " instead of sending new queries in later sessions. Names are"
+            " queried again after a week.",
+            &use_dns_cache);
+
     prefs_register_obsolete_preference(nameres, "hosts_file_handling");
 
     prefs_register_bool_preference(nameres, "vlan_name",
@@ -3537,33 +3777,54 @@ disable_name_resolution(void) {
 bool
 host_name_lookup_process(void) {
     struct timeval tv = { 0, 0 };
-    int nfds;
+    int nfds, nready;
+    unsigned round;
     fd_set rfds, wfds;
-    bool nro = new_resolved_objects;
+    bool nro;
 
-    new_resolved_objects = false;
-    nro |= maxmind_db_lookup_process();
+    nro = maxmind_db_lookup_process();
 
-    if (!async_dns_initialized)
+    if (!async_dns_initialized) {
         /* c-ares not initialized. Bail out and cancel timers. */
+        nro |= new_resolved_objects;
+        new_resolved_objects = false;
         return nro;
+    }
 
-    process_async_dns_queue();
+    /*
+     * Handle all the replies that have already arrived, and keep the
+     * query window full while doing so: each round of replies frees up
+     * slots for queued requests. Waiting for the next call to refill the
+     * window would limit us to one window of replies per main loop
+     * iteration, which is far too slow for captures with many hosts.
+     */
+    for (round = 0; round < ASYNC_DNS_MAX_ROUNDS; round++) {
+        process_async_dns_queue();
 
-    FD_ZERO(&rfds);
-    FD_ZERO(&wfds);
-    nfds = ares_fds(ghba_chan, &rfds, &wfds);
-    if (nfds > 0) {
-        if (select(nfds, &rfds, &wfds, NULL, &tv) == -1) { /* call to select() failed */
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        nfds = ares_fds(ghba_chan, &rfds, &wfds);
+        if (nfds == 0)
+            break;
+
+        tv.tv_sec = 0;
+        tv.tv_usec = 0;
+        nready = select(nfds, &rfds, &wfds, NULL, &tv);
+        if (nready == -1) { /* call to select() failed */
             /* If it's interrupted by a signal, no need to put out a message */
             if (errno != EINTR)
                 fprintf(stderr, "Warning: call to select() failed, error is %s\n", g_strerror(errno));
-            return nro;
+            break;
         }
+        /* Called even if nothing is ready, to handle timeouts. */
         ares_process(ghba_chan, &rfds, &wfds);
+        if (nready == 0)
+            break;
     }
 
-    /* Any new entries? */
+    /* Any new entries, including the replies handled above? */
+    nro |= new_resolved_objects;
+    new_resolved_objects = false;
     return nro;
 }
 
@@ -3754,6 +4015,10 @@ host_name_lookup_init(const char* app_env_var_prefix)
     ws_assert(async_dns_queue_head == NULL);
     async_dns_queue_head = wmem_list_new(addr_resolv_scope);
 
+    /* The DNS cache is read when it's first needed. */
+    ws_assert(dns_cache_path == NULL);
+    dns_cache_path = get_persconffile_path(ENAME_DNS_CACHE, false, app_env_var_prefix);
+
     /*
      * The manually resolved lists are the only address resolution maps
      * that are not reset by addr_resolv_cleanup(), because they are
@@ -3816,6 +4081,13 @@ host_name_lookup_cleanup(void)
 
     _host_name_lookup_cleanup();
 
+    dns_cache_write();
+    g_free(dns_cache_path);
+    dns_cache_path = NULL;
+    dns_cache_ipv4 = NULL;
+    dns_cache_ipv6 = NULL;
+    dns_cache_dirty = false;
+
     ipxnet_hash_table = NULL;
     ipv4_hash_table = NULL;
     ipv6_hash_table = NULL;
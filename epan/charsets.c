@@ -83,28 +83,22 @@ uint8_t *
 get_ascii_string(wmem_allocator_t *scope, const uint8_t *ptr, size_t length)
 {
     wmem_strbuf_t *str;
-    const uint8_t *prev = ptr;
-    size_t valid_bytes = 0;
 
     str = wmem_strbuf_new_sized(scope, length+1);
 
     while (length > 0) {
-        uint8_t ch = *ptr++;
+        size_t valid_bytes = ws_ascii_prefix_len(ptr, length);
 
-        if (ch < 0x80) {
-            valid_bytes++;
-        } else {
-            if (valid_bytes) {
-                wmem_strbuf_append_len(str, (const char*)prev, valid_bytes);
-                valid_bytes = 0;
-            }
-            prev = ptr;
+        if (valid_bytes) {
+            wmem_strbuf_append_len(str, (const char*)ptr, valid_bytes);
+            ptr += valid_bytes;
+            length -= valid_bytes;
+        }
+        if (length > 0) {
             wmem_strbuf_append_unichar_repl(str);
+            ptr++;
+            length--;
         }
-        length--;
-    }
-    if (valid_bytes) {
-        wmem_strbuf_append_len(str, (const char*)prev, valid_bytes);
     }
 
     return (uint8_t *) wmem_strbuf_finalize(str);
@@ -182,21 +176,24 @@ get_8859_1_string(wmem_allocator_t *scope, const uint8_t *ptr, size_t length)
     str = wmem_strbuf_new_sized(scope, length+1);
 
     while (length > 0) {
-        uint8_t ch = *ptr;
+        size_t ascii_len = ws_ascii_prefix_len(ptr, length);
 
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else {
+        if (ascii_len) {
+            wmem_strbuf_append_len(str, (const char*)ptr, ascii_len);
+            ptr += ascii_len;
+            length -= ascii_len;
+        }
+        if (length > 0) {
             /*
              * Note: we assume here that the code points
              * 0x80-0x9F are used for C1 control characters,
              * and thus have the same value as the corresponding
              * Unicode code points.
              */
-            wmem_strbuf_append_unichar(str, ch);
+            wmem_strbuf_append_unichar(str, *ptr);
+            ptr++;
+            length--;
         }
-        ptr++;
-        length--;
     }
 
     return (uint8_t *) wmem_strbuf_finalize(str);
@@ -695,6 +692,66 @@ get_unichar2_string(wmem_allocator_t *scope, const uint8_t *ptr, size_t length,
     return (uint8_t *) wmem_strbuf_finalize(str);
 }
 
+/*
+ * Append the run of UTF-16 (or UCS-2) code units below 0x80 at the start
+ * of a buffer, which are copied to UTF-8 as is, to a string buffer. Four
+ * code units are checked at a time, and the characters are gathered in a
+ * local buffer so that the string buffer is appended to once per run
+ * rather than once per character.
+ *
+ * Returns the number of bytes of input used, which is even.
+ */
+static size_t
+append_utf_16_ascii(wmem_strbuf_t *strbuf, const uint8_t *ptr, size_t length, unsigned encoding)
+{
+    /* Four code units, loaded as a little-endian word; the character is
+     * the low byte of each unit for little-endian, the high byte for
+     * big-endian, and the other byte has to be zero. */
+    const uint64_t mask  = (encoding == ENC_BIG_ENDIAN) ? UINT64_C(0x80FF80FF80FF80FF) : UINT64_C(0xFF80FF80FF80FF80);
+    const unsigned shift = (encoding == ENC_BIG_ENDIAN) ? 8 : 0;
+    char    buf[64];
+    size_t  buf_len = 0;
+    size_t  i = 0;
+
+    for (;;) {
+        if (i + 8 <= length) {
+            uint64_t units = pletohu64(ptr + i);
+
+            if ((units & mask) == 0) {
+                units >>= shift;
+                if (buf_len + 4 > sizeof buf) {
+                    wmem_strbuf_append_len(strbuf, buf, buf_len);
+                    buf_len = 0;
+                }
+                buf[buf_len++] = (char)(units & 0x7F);
+                buf[buf_len++] = (char)((units >> 16) & 0x7F);
+                buf[buf_len++] = (char)((units >> 32) & 0x7F);
+                buf[buf_len++] = (char)((units >> 48) & 0x7F);
+                i += 8;
+                continue;
+            }
+        }
+        if (i + 1 < length) {
+            gunichar2 uchar = (encoding == ENC_BIG_ENDIAN) ? pntohu16(ptr + i) : pletohu16(ptr + i);
+
+            if (uchar < 0x80) {
+                if (buf_len == sizeof buf) {
+                    wmem_strbuf_append_len(strbuf, buf, buf_len);
+                    buf_len = 0;
+                }
+                buf[buf_len++] = (char)uchar;
+                i += 2;
+                continue;
+            }
+        }
+        break;
+    }
+    if (buf_len) {
+        wmem_strbuf_append_len(strbuf, buf, buf_len);
+    }
+    return i;
+}
+
 /*
  * Given a wmem scope, a pointer, and a length, treat the string of bytes
  * referred to by the pointer and length as a UCS-2 encoded string
@@ -729,6 +786,9 @@ get_ucs_2_string(wmem_allocator_t *scope, const uint8_t *ptr, size_t length, uns
     encoding = encoding & ENC_LITTLE_ENDIAN;
 
     for(; i + 1 < length; i += 2) {
+        i += append_utf_16_ascii(strbuf, ptr + i, length - i, encoding);
+        if (i + 1 >= length)
+            break;
         if (encoding == ENC_BIG_ENDIAN) {
             uchar = pntohu16(ptr + i);
         } else {
@@ -782,6 +842,9 @@ get_utf_16_string(wmem_allocator_t *scope, const uint8_t *ptr, size_t length, un
     encoding = encoding & ENC_LITTLE_ENDIAN;
 
     for(; i + 1 < length; i += 2) {
+        i += append_utf_16_ascii(strbuf, ptr + i, length - i, encoding);
+        if (i + 1 >= length)
+            break;
         if (encoding == ENC_BIG_ENDIAN)
             uchar2 = pntohu16(ptr + i);
         else
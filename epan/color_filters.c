@@ -435,7 +435,7 @@ color_filter_compile_cb(void *filter_arg, void *err)
     /* If the filter is disabled it doesn't matter if it compiles or not. */
     if (colorf->disabled) return;
 
-    if (!dfilter_compile(colorf->filter_text, &colorf->c_colorfilter, &df_err)) {
+    if (!dfilter_compile_cached(colorf->filter_text, &colorf->c_colorfilter, &df_err)) {
         *err_msg = ws_strdup_printf("Could not compile color filter name: \"%s\" text: \"%s\".\n%s",
                       colorf->filter_name, colorf->filter_text, df_err->msg);
         df_error_free(&df_err);
@@ -457,7 +457,7 @@ color_filter_validate_cb(void *filter_arg, void *err)
     /* If the filter is disabled it doesn't matter if it compiles or not. */
     if (colorf->disabled) return;
 
-    if (!dfilter_compile(colorf->filter_text, &colorf->c_colorfilter, &df_err)) {
+    if (!dfilter_compile_cached(colorf->filter_text, &colorf->c_colorfilter, &df_err)) {
         *err_msg = ws_strdup_printf("Disabling color filter name: \"%s\" filter: \"%s\".\n%s",
                       colorf->filter_name, colorf->filter_text, df_err->msg);
         df_error_free(&df_err);
@@ -586,21 +586,85 @@ color_filters_use_proto(int proto_id)
     return (item != NULL);
 }
 
+/*
+ * The protocols in a packet's layers, gathered once so that each color
+ * filter can be checked against them without walking the list again.
+ * Most coloring rules only match packets containing some protocol
+ * (see dfilter_required_protocols()), and a typical packet has only a
+ * handful of layers, so most rules can be rejected this way without
+ * running their filter at all.
+ */
+#define COLOR_LAYERS_MAX 32
+
+typedef struct {
+    int  protos[COLOR_LAYERS_MAX];
+    int  count;
+    bool valid;             /* false if the layers weren't (all) gathered */
+} color_layers_t;
+
+static void
+color_layers_init(color_layers_t *layers, const epan_dissect_t *edt)
+{
+    wmem_list_frame_t *layer;
+
+    layers->count = 0;
+    layers->valid = false;
+    if (edt->pi.layers == NULL) {
+        return;
+    }
+    for (layer = wmem_list_head(edt->pi.layers); layer != NULL; layer = wmem_list_frame_next(layer)) {
+        if (layers->count == COLOR_LAYERS_MAX) {
+            return;
+        }
+        layers->protos[layers->count++] = GPOINTER_TO_INT(wmem_list_frame_data(layer));
+    }
+    layers->valid = true;
+}
+
+/* Returns true if we know the filter can't match the packet, because
+ * the packet lacks one of the protocols the filter requires. */
+static bool
+color_layers_exclude(const color_layers_t *layers, const dfilter_t *df)
+{
+    const int *required_protos;
+    int        num_required_protos;
+
+    if (!layers->valid) {
+        return false;
+    }
+    required_protos = dfilter_required_protocols(df, &num_required_protos);
+    for (int i = 0; i < num_required_protos; i++) {
+        int j;
+        for (j = 0; j < layers->count; j++) {
+            if (layers->protos[j] == required_protos[i]) {
+                break;
+            }
+        }
+        if (j == layers->count) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /* * Return the color_t for later use */
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
 {
     GSList         *curr;
     color_filter_t *colorf;
+    color_layers_t  layers;
 
     /* If we have color filters, "search" for the matching one. */
     if ((edt->tree != NULL) && (color_filters_used())) {
         curr = color_filter_list;
+        color_layers_init(&layers, edt);
 
         while(curr != NULL) {
             colorf = (color_filter_t *)curr->data;
             if ( (!colorf->disabled) &&
                  (colorf->c_colorfilter != NULL) &&
+                 !color_layers_exclude(&layers, colorf->c_colorfilter) &&
                  dfilter_apply_edt(colorf->c_colorfilter, edt) &&
                  !color_filter_is_session_disabled(colorf->filter_name)) {
                 return colorf;
@@ -618,6 +682,7 @@ color_filters_colorize_packet_all(epan_dissect_t *edt, GSList **matches)
     GSList         *curr;
     color_filter_t *colorf;
     const color_filter_t *first_match = NULL;
+    color_layers_t  layers;
 
     if (matches) {
         *matches = NULL;
@@ -626,11 +691,13 @@ color_filters_colorize_packet_all(epan_dissect_t *edt, GSList **matches)
     /* If we have color filters, collect ALL matching ones. */
     if ((edt->tree != NULL) && (color_filters_used())) {
         curr = color_filter_list;
+        color_layers_init(&layers, edt);
 
         while(curr != NULL) {
             colorf = (color_filter_t *)curr->data;
             if ( (!colorf->disabled) &&
                  (colorf->c_colorfilter != NULL) &&
+                 !color_layers_exclude(&layers, colorf->c_colorfilter) &&
                  dfilter_apply_edt(colorf->c_colorfilter, edt)) {
 
                 bool is_session_disabled = color_filter_is_session_disabled(colorf->filter_name);
@@ -42,6 +42,16 @@ typedef struct {
   int                  field_id;       /**< ID for a single field expression, or 0 */
 } col_custom_t;
 
+/** The fields to prime the tree with for all custom columns at once.
+ * Built by col_custom_prime_edt() and rebuilt if the display format of a
+ * column changes.
+ */
+typedef struct {
+  GArray             *hfids;                /**< Fields to prime */
+  GArray             *hfids_print;          /**< Fields to prime for printing (COLUMN_DISPLAY_DETAILS) */
+  char               *display;              /**< Display format of each column when built */
+} col_custom_plan_t;
+
 /** Individual column info */
 typedef struct {
   int                 col_fmt;              /**< Format of column */
@@ -51,6 +61,7 @@ typedef struct {
   int                 col_custom_occurrence;/**< Custom column field occurrence */
   GSList             *col_custom_fields_ids;/**< Custom column fields id */
   struct epan_dfilter *col_custom_dfilter;  /**< Compiled custom column field */
+  int                 col_custom_same_as;   /**< Earlier custom column with the same fields and occurrence, or -1 */
   const char         *col_data;             /**< Column data */
   char               *col_buf;              /**< Buffer into which to copy data for column */
   int                 col_fence;            /**< Stuff in column buffer before this index is immutable */
@@ -68,6 +79,7 @@ struct epan_column_info {
   col_expr_t          col_expr;             /**< Column expressions and values */
   bool                writable;             /**< writable or not @todo Are we still writing to the columns? */
   GRegex             *prime_regex;          /**< Used to prime custom columns */
+  col_custom_plan_t  *custom_plan;          /**< Fields of all custom columns, or NULL */
 };
 
 /** Allocate all the data structures for constructing column data, given
@@ -80,6 +92,11 @@ WS_DLL_PUBLIC void col_setup(column_info *cinfo, const int num_cols);
  */
 WS_DLL_PUBLIC void col_cleanup(column_info *cinfo);
 
+/** Free the combined list of custom column fields, so that it's built
+ * again the next time it's needed.
+ */
+extern void col_custom_plan_free(column_info *cinfo);
+
 /** Initialize the data structures for constructing column data.
  */
 extern void col_init(column_info *cinfo, const struct epan_session *epan);
@@ -30,6 +30,7 @@
 
 #include <epan/strutil.h>
 #include <epan/epan.h>
+#include <epan/epan_dissect.h>
 #include <epan/dfilter/dfilter.h>
 
 #include <wsutil/value_string.h>
@@ -80,6 +81,7 @@ col_setup(column_info *cinfo, const int num_cols)
   cinfo->prime_regex = g_regex_new(COL_CUSTOM_PRIME_REGEX,
     (GRegexCompileFlags) (G_REGEX_RAW),
     0, NULL);
+  cinfo->custom_plan = NULL;
 }
 
 static void
@@ -100,6 +102,20 @@ col_custom_fields_ids_free(GSList** custom_fields_id)
   *custom_fields_id = NULL;
 }
 
+void
+col_custom_plan_free(column_info *cinfo)
+{
+  col_custom_plan_t *plan = cinfo->custom_plan;
+
+  if (plan == NULL)
+    return;
+  g_array_free(plan->hfids, true);
+  g_array_free(plan->hfids_print, true);
+  g_free(plan->display);
+  g_free(plan);
+  cinfo->custom_plan = NULL;
+}
+
 /* Cleanup all the data structures for constructing column data; undoes
    the allocations that col_setup() does. */
 void
@@ -137,6 +153,7 @@ col_cleanup(column_info *cinfo)
   g_free(cinfo->col_expr.col_expr_val);
   if (cinfo->prime_regex)
     g_regex_unref(cinfo->prime_regex);
+  col_custom_plan_free(cinfo);
 }
 
 /* Initialize the data structures for constructing column data. */
@@ -368,7 +385,16 @@ void col_custom_set_edt(epan_dissect_t *edt, column_info *cinfo)
     if (col_item->fmt_matx[COL_CUSTOM] &&
         col_item->col_custom_fields &&
         col_item->col_custom_fields_ids) {
+        int same_as = col_item->col_custom_same_as;
+
         col_item->col_data = col_item->col_buf;
+        if (same_as >= 0 && get_column_display_format(same_as) == get_column_display_format(i)) {
+            /* The earlier column has just been filled in with the same thing. */
+            (void) g_strlcpy(col_item->col_buf, cinfo->columns[same_as].col_buf, COL_MAX_LEN);
+            (void) g_strlcpy(cinfo->col_expr.col_expr_val[i], cinfo->col_expr.col_expr_val[same_as], COL_MAX_LEN);
+            cinfo->col_expr.col_expr[i] = cinfo->col_expr.col_expr[same_as];
+            continue;
+        }
         cinfo->col_expr.col_expr[i] = epan_custom_set(edt, col_item->col_custom_fields_ids,
                                      col_item->col_custom_occurrence,
                                      get_column_display_format(i) == COLUMN_DISPLAY_DETAILS,
@@ -408,27 +434,88 @@ col_custom_set(proto_tree *tree, column_info *cinfo)
 }
 #endif
 
+/* Does the plan still match the columns' display formats? */
+static bool
+col_custom_plan_current(column_info *cinfo)
+{
+  int i;
+
+  for (i = cinfo->col_first[COL_CUSTOM];
+       i <= cinfo->col_last[COL_CUSTOM]; i++) {
+    if (cinfo->custom_plan->display[i] != get_column_display_format(i))
+      return false;
+  }
+  return true;
+}
+
+/*
+ * Gather the fields of all the custom columns, without duplicates, so
+ * that col_custom_prime_edt() can prime the tree with each of them once
+ * instead of once per column that uses it. Priming a field for printing
+ * covers priming it directly, so a field that any "details" column uses
+ * is only primed for printing.
+ */
+static void
+col_custom_plan_build(column_info *cinfo)
+{
+  col_custom_plan_t *plan;
+  GHashTable *fields;
+  GHashTableIter iter;
+  void *key, *value;
+  int i;
+
+  col_custom_plan_free(cinfo);
+  plan = g_new(col_custom_plan_t, 1);
+  plan->hfids = g_array_new(false, false, sizeof(int));
+  plan->hfids_print = g_array_new(false, false, sizeof(int));
+  plan->display = g_new0(char, cinfo->num_cols);
+
+  fields = g_hash_table_new(g_direct_hash, g_direct_equal);
+  for (i = cinfo->col_first[COL_CUSTOM];
+       i <= cinfo->col_last[COL_CUSTOM]; i++) {
+    col_item_t *col_item = &cinfo->columns[i];
+    const int *hfids;
+    int num_hfids;
+    bool print;
+
+    plan->display[i] = get_column_display_format(i);
+    if (!col_item->fmt_matx[COL_CUSTOM] || !col_item->col_custom_dfilter)
+      continue;
+
+    print = plan->display[i] == COLUMN_DISPLAY_DETAILS;
+    hfids = dfilter_interesting_fields(col_item->col_custom_dfilter, &num_hfids);
+    for (int j = 0; j < num_hfids; j++) {
+      if (print || !g_hash_table_contains(fields, GINT_TO_POINTER(hfids[j])))
+        g_hash_table_insert(fields, GINT_TO_POINTER(hfids[j]), GINT_TO_POINTER(print));
+    }
+  }
+
+  g_hash_table_iter_init(&iter, fields);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    int hfid = GPOINTER_TO_INT(key);
+
+    g_array_append_val(GPOINTER_TO_INT(value) ? plan->hfids_print : plan->hfids, hfid);
+  }
+  g_hash_table_destroy(fields);
+
+  cinfo->custom_plan = plan;
+}
+
 void
 col_custom_prime_edt(epan_dissect_t *edt, column_info *cinfo)
 {
-  int i;
-  col_item_t* col_item;
+  col_custom_plan_t *plan;
 
   if (!HAVE_CUSTOM_COLS(cinfo))
     return;
 
-  for (i = cinfo->col_first[COL_CUSTOM];
-       i <= cinfo->col_last[COL_CUSTOM]; i++) {
-    col_item = &cinfo->columns[i];
+  if (cinfo->custom_plan == NULL || !col_custom_plan_current(cinfo))
+    col_custom_plan_build(cinfo);
+  plan = cinfo->custom_plan;
 
-    if (col_item->fmt_matx[COL_CUSTOM] &&
-        col_item->col_custom_dfilter) {
-      if (get_column_display_format(i) == COLUMN_DISPLAY_DETAILS) {
-        epan_dissect_prime_with_dfilter_print(edt, col_item->col_custom_dfilter);
-      } else {
-        epan_dissect_prime_with_dfilter(edt, col_item->col_custom_dfilter);
-      }
-    }
+  epan_dissect_prime_with_hfid_array(edt, plan->hfids);
+  for (unsigned i = 0; i < plan->hfids_print->len; i++) {
+    proto_tree_prime_with_hfid_print(edt->tree, g_array_index(plan->hfids_print, int, i));
   }
 }
 
@@ -542,6 +629,76 @@ col_append_frame_number(packet_info *pinfo, const int col, const char *fmt_str,
   }
 }
 
+/*
+ * vsnprintf() for column text.
+ *
+ * Nearly all column formats are made up of literal text and plain "%s",
+ * "%u" and "%d" conversions; those are handled here without going
+ * through the C library's format parser, which is measurable when
+ * every packet's Info column is built. Anything else (flags, widths,
+ * precisions, length modifiers, other conversions) is left to
+ * vsnprintf(). Like vsnprintf(), this returns the length the result
+ * would have had without truncation.
+ */
+static int
+col_vsnprintf(char *buf, size_t buf_size, const char *format, va_list ap)
+{
+  va_list     ap2;
+  const char *p;
+  const char *str;
+  char        num_buf[12];  /* "-2147483648" */
+  size_t      len = 0;
+  size_t      str_len;
+
+  va_copy(ap2, ap);
+  for (p = format; *p != '\0'; p++) {
+    if (*p != '%') {
+      str = p;
+      while (p[1] != '\0' && p[1] != '%')
+        p++;
+      str_len = p - str + 1;
+    } else {
+      switch (p[1]) {
+
+      case 's':
+        str = va_arg(ap2, const char *);
+        if (str == NULL)
+          str = "(null)";
+        str_len = strlen(str);
+        break;
+
+      case 'u':
+        str = uint_to_str_back(num_buf + sizeof(num_buf), va_arg(ap2, unsigned));
+        str_len = num_buf + sizeof(num_buf) - str;
+        break;
+
+      case 'd':
+        str = int_to_str_back(num_buf + sizeof(num_buf), va_arg(ap2, int));
+        str_len = num_buf + sizeof(num_buf) - str;
+        break;
+
+      case '%':
+        str = "%";
+        str_len = 1;
+        break;
+
+      default:
+        va_end(ap2);
+        return vsnprintf(buf, buf_size, format, ap);
+      }
+      p++;
+    }
+    if (len + 1 < buf_size)
+      memcpy(buf + len, str, MIN(str_len, buf_size - 1 - len));
+    len += str_len;
+  }
+  va_end(ap2);
+
+  if (buf_size != 0)
+    buf[MIN(len, buf_size - 1)] = '\0';
+  return (int)len;
+}
+
 static void
 col_do_append_fstr(column_info *cinfo, const int el, const char *separator, const char *format, va_list ap)
 {
@@ -549,6 +706,7 @@ col_do_append_fstr(column_info *cinfo, const int el, const char *separator, cons
   int    i;
   col_item_t* col_item;
   char tmp[COL_BUF_MAX_LEN];
+  bool formatted = false;
 
   sep_len = (separator) ? strlen(separator) : 0;
 
@@ -576,15 +734,15 @@ col_do_append_fstr(column_info *cinfo, const int el, const char *separator, cons
       }
 
       if (len < max_len) {
-        va_list ap2;
-
-        va_copy(ap2, ap);
-        pos = vsnprintf(tmp, sizeof(tmp), format, ap2);
-        va_end(ap2);
-        if (pos >= max_len) {
-          ws_utf8_truncate(tmp, max_len - 1);
+        /* Every column gets the same text, so only format it once. */
+        if (!formatted) {
+          pos = col_vsnprintf(tmp, sizeof(tmp), format, ap);
+          if (pos >= max_len) {
+            ws_utf8_truncate(tmp, max_len - 1);
+          }
+          WS_UTF_8_CHECK(tmp, -1);
+          formatted = true;
         }
-        WS_UTF_8_CHECK(tmp, -1);
         ws_label_strcpy(col_item->col_buf, max_len, len, (const uint8_t*)tmp, 0);
       }
     }
@@ -636,6 +794,7 @@ col_prepend_fstr(column_info *cinfo, const int el, const char *format, ...)
   size_t      max_len, pos;
   col_item_t* col_item;
   char tmp[COL_BUF_MAX_LEN];
+  bool formatted = false;
 
   if (!CHECK_COL(cinfo, el))
     return;
@@ -655,13 +814,16 @@ col_prepend_fstr(column_info *cinfo, const int el, const char *format, ...)
         (void) g_strlcpy(orig_buf, col_item->col_buf, max_len);
         orig = orig_buf;
       }
-      va_start(ap, format);
-      pos = vsnprintf(tmp, sizeof(tmp), format, ap);
-      va_end(ap);
-      if (pos >= max_len) {
-        ws_utf8_truncate(tmp, max_len - 1);
+      if (!formatted) {
+        va_start(ap, format);
+        pos = col_vsnprintf(tmp, sizeof(tmp), format, ap);
+        va_end(ap);
+        if (pos >= max_len) {
+          ws_utf8_truncate(tmp, max_len - 1);
+        }
+        WS_UTF_8_CHECK(tmp, -1);
+        formatted = true;
       }
-      WS_UTF_8_CHECK(tmp, -1);
       pos = ws_label_strcpy(col_item->col_buf, max_len, 0, (const uint8_t*)tmp, 0);
 
       /*
@@ -693,6 +855,7 @@ col_prepend_fence_fstr(column_info *cinfo, const int el, const char *format, ...
   size_t      max_len, pos;
   col_item_t* col_item;
   char tmp[COL_BUF_MAX_LEN];
+  bool formatted = false;
 
   if (!CHECK_COL(cinfo, el))
     return;
@@ -712,13 +875,16 @@ col_prepend_fence_fstr(column_info *cinfo, const int el, const char *format, ...
         (void) g_strlcpy(orig_buf, col_item->col_buf, max_len);
         orig = orig_buf;
       }
-      va_start(ap, format);
-      pos = vsnprintf(tmp, sizeof(tmp), format, ap);
-      va_end(ap);
-      if (pos >= max_len) {
-        ws_utf8_truncate(tmp, max_len - 1);
+      if (!formatted) {
+        va_start(ap, format);
+        pos = col_vsnprintf(tmp, sizeof(tmp), format, ap);
+        va_end(ap);
+        if (pos >= max_len) {
+          ws_utf8_truncate(tmp, max_len - 1);
+        }
+        WS_UTF_8_CHECK(tmp, -1);
+        formatted = true;
       }
-      WS_UTF_8_CHECK(tmp, -1);
       pos = ws_label_strcpy(col_item->col_buf, max_len, 0, (const uint8_t*)tmp, 0);
 
       /*
@@ -877,6 +1043,7 @@ col_add_fstr(column_info *cinfo, const int el, const char *format, ...)
   int     max_len;
   col_item_t* col_item;
   char tmp[COL_BUF_MAX_LEN];
+  bool formatted = false;
 
   if (!CHECK_COL(cinfo, el))
     return;
@@ -901,13 +1068,16 @@ col_add_fstr(column_info *cinfo, const int el, const char *format, ...)
          */
         col_item->col_data = col_item->col_buf;
       }
-      va_start(ap, format);
-      pos = vsnprintf(tmp, sizeof(tmp), format, ap);
-      va_end(ap);
-      if (pos >= max_len) {
-        ws_utf8_truncate(tmp, max_len - 1);
+      if (!formatted) {
+        va_start(ap, format);
+        pos = col_vsnprintf(tmp, sizeof(tmp), format, ap);
+        va_end(ap);
+        if (pos >= max_len) {
+          ws_utf8_truncate(tmp, max_len - 1);
+        }
+        WS_UTF_8_CHECK(tmp, -1);
+        formatted = true;
       }
-      WS_UTF_8_CHECK(tmp, -1);
       ws_label_strcpy(col_item->col_buf, max_len, col_item->col_fence, (const uint8_t*)tmp, 0);
     }
   }
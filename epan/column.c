@@ -1159,8 +1159,12 @@ col_finalize(column_info *cinfo)
   col_item_t* col_item;
   dfilter_t *dfilter;
 
+  /* The custom columns' fields may be different now. */
+  col_custom_plan_free(cinfo);
+
   for (i = 0; i < cinfo->num_cols; i++) {
     col_item = &cinfo->columns[i];
+    col_item->col_custom_same_as = -1;
 
     if (col_item->col_fmt == COL_CUSTOM) {
       if(!dfilter_compile(col_item->col_custom_fields, &col_item->col_custom_dfilter, NULL)) {
@@ -1190,6 +1194,18 @@ col_finalize(column_info *cinfo)
           }
         }
         g_strfreev(fields);
+
+        /* A column that shows the same thing as an earlier one can just
+         * copy it. */
+        for (unsigned j = 0; j < i; j++) {
+          if (cinfo->columns[j].col_fmt == COL_CUSTOM &&
+              cinfo->columns[j].col_custom_fields != NULL &&
+              cinfo->columns[j].col_custom_occurrence == col_item->col_custom_occurrence &&
+              strcmp(cinfo->columns[j].col_custom_fields, col_item->col_custom_fields) == 0) {
+            col_item->col_custom_same_as = (int)j;
+            break;
+          }
+        }
       }
     } else {
       col_item->col_custom_fields = NULL;
@@ -422,11 +422,58 @@ conversation_create_from_template(conversation_t *conversation, const address *a
 /*
  * Compute the hash value for two given element lists if the match
  * is to be exact.
+ *
+ * Each element is hashed on its own and the element hashes are then
+ * combined, so that the hash of a key can also be assembled from element
+ * hashes computed earlier. find_conversation() relies on that to hash
+ * each of its addresses only once however many tables it searches.
  */
-/* https://web.archive.org/web/20070615045827/http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
- * (formerly at http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing)
- * One-at-a-Time hash
- */
+static inline unsigned
+conversation_hash_bytes(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    unsigned hash_val = (unsigned)len;
+    uint32_t word;
+
+    /* Four bytes at a time; addresses are mostly 4 or 16 bytes long. */
+    for (; len >= 4; p += 4, len -= 4) {
+        memcpy(&word, p, 4);
+        hash_val ^= word;
+        hash_val *= 0x9E3779B1U;
+        hash_val ^= hash_val >> 15;
+    }
+    for (; len > 0; p++, len--) {
+        hash_val ^= *p;
+        hash_val *= 0x9E3779B1U;
+    }
+    return hash_val;
+}
+
+static inline unsigned
+conversation_hash_address(const address *addr)
+{
+    return conversation_hash_bytes(addr->data, (size_t)addr->len);
+}
+
+static inline unsigned
+conversation_hash_combine(unsigned hash_val, unsigned element_hash)
+{
+    hash_val ^= element_hash;
+    hash_val *= 0x01000193U;
+    hash_val ^= hash_val >> 13;
+    return hash_val;
+}
+
+static inline unsigned
+conversation_hash_finish(unsigned hash_val)
+{
+    hash_val += ( hash_val << 3 );
+    hash_val ^= ( hash_val >> 11 );
+    hash_val += ( hash_val << 15 );
+
+    return hash_val;
+}
+
 static unsigned
 conversation_hash_element_list(const void *v)
 {
@@ -434,51 +481,37 @@ conversation_hash_element_list(const void *v)
     unsigned hash_val = 0;
 
     for (;;) {
-        // XXX We could use a hash_arbitrary_bytes routine. Abuse add_address_to_hash in the mean time.
-        address tmp_addr;
         switch (element->type) {
         case CE_ADDRESS:
-            hash_val = add_address_to_hash(hash_val, &element->addr_val);
+            hash_val = conversation_hash_combine(hash_val, conversation_hash_address(&element->addr_val));
             break;
         case CE_PORT:
-            tmp_addr.len = (int) sizeof(element->port_val);
-            tmp_addr.data = &element->port_val;
-            hash_val = add_address_to_hash(hash_val, &tmp_addr);
+            hash_val = conversation_hash_combine(hash_val, element->port_val);
             break;
         case CE_STRING:
-            tmp_addr.len = (int) strlen(element->str_val);
-            tmp_addr.data = element->str_val;
-            hash_val = add_address_to_hash(hash_val, &tmp_addr);
+            hash_val = conversation_hash_combine(hash_val,
+                    conversation_hash_bytes(element->str_val, strlen(element->str_val)));
             break;
         case CE_UINT:
-            tmp_addr.len = (int) sizeof(element->uint_val);
-            tmp_addr.data = &element->uint_val;
-            hash_val = add_address_to_hash(hash_val, &tmp_addr);
+            hash_val = conversation_hash_combine(hash_val, element->uint_val);
             break;
         case CE_UINT64:
-            tmp_addr.len = (int) sizeof(element->uint64_val);
-            tmp_addr.data = &element->uint64_val;
-            hash_val = add_address_to_hash(hash_val, &tmp_addr);
+            hash_val = conversation_hash_combine(hash_val,
+                    (unsigned)(element->uint64_val ^ (element->uint64_val >> 32)));
             break;
         case CE_INT:
-            tmp_addr.len = (int) sizeof(element->int_val);
-            tmp_addr.data = &element->int_val;
-            hash_val = add_address_to_hash(hash_val, &tmp_addr);
+            hash_val = conversation_hash_combine(hash_val, (unsigned)element->int_val);
             break;
         case CE_INT64:
-            tmp_addr.len = (int) sizeof(element->int64_val);
-            tmp_addr.data = &element->int64_val;
-            hash_val = add_address_to_hash(hash_val, &tmp_addr);
+            hash_val = conversation_hash_combine(hash_val,
+                    (unsigned)((uint64_t)element->int64_val ^ ((uint64_t)element->int64_val >> 32)));
             break;
         case CE_BLOB:
-            tmp_addr.len = (int) element->blob.len;
-            tmp_addr.data = element->blob.val;
-            hash_val = add_address_to_hash(hash_val, &tmp_addr);
+            hash_val = conversation_hash_combine(hash_val,
+                    conversation_hash_bytes(element->blob.val, element->blob.len));
             break;
         case CE_CONVERSATION_TYPE:
-            tmp_addr.len = (int) sizeof(element->conversation_type_val);
-            tmp_addr.data = &element->conversation_type_val;
-            hash_val = add_address_to_hash(hash_val, &tmp_addr);
+            hash_val = conversation_hash_combine(hash_val, (unsigned)element->conversation_type_val);
             goto done;
             break;
         }
@@ -486,11 +519,7 @@ conversation_hash_element_list(const void *v)
     }
 
 done:
-    hash_val += ( hash_val << 3 );
-    hash_val ^= ( hash_val >> 11 );
-    hash_val += ( hash_val << 15 );
-
-    return hash_val;
+    return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -589,7 +618,9 @@ conversation_init(void)
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
     char *exact_map_key = conversation_element_list_name(wmem_epan_scope(), exact_elements);
-    conversation_hashtable_exact_addr_port = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+    /* The address and port tables are searched for nearly every packet, so
+     * use flat maps for them; see find_conversation(). */
+    conversation_hashtable_exact_addr_port = wmem_map_new_flat_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
     wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), exact_map_key),
@@ -601,7 +632,7 @@ conversation_init(void)
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
     char *addrs_map_key = conversation_element_list_name(wmem_epan_scope(), addrs_elements);
-    conversation_hashtable_exact_addr = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+    conversation_hashtable_exact_addr = wmem_map_new_flat_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
     wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), addrs_map_key),
@@ -614,7 +645,7 @@ conversation_init(void)
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
     char *no_addr2_map_key = conversation_element_list_name(wmem_epan_scope(), no_addr2_elements);
-    conversation_hashtable_no_addr2 = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+    conversation_hashtable_no_addr2 = wmem_map_new_flat_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                        conversation_hash_element_list,
                                                        conversation_match_element_list);
     wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), no_addr2_map_key),
@@ -627,7 +658,7 @@ conversation_init(void)
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
     char *no_port2_map_key = conversation_element_list_name(wmem_epan_scope(), no_port2_elements);
-    conversation_hashtable_no_port2 = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+    conversation_hashtable_no_port2 = wmem_map_new_flat_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                        conversation_hash_element_list,
                                                        conversation_match_element_list);
     wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), no_port2_map_key),
@@ -639,7 +670,7 @@ conversation_init(void)
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
     char *no_addr2_or_port2_map_key = conversation_element_list_name(wmem_epan_scope(), no_addr2_or_port2_elements);
-    conversation_hashtable_no_addr2_or_port2 = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+    conversation_hashtable_no_addr2_or_port2 = wmem_map_new_flat_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
     wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), no_addr2_or_port2_map_key),
@@ -789,6 +820,95 @@ conversation_epan_reset(void)
     new_index = 0;
 }
 
+static GSList *conversation_retire_callbacks;
+
+void
+conversation_register_retire_callback(conversation_retire_cb callback)
+{
+    conversation_retire_callbacks = g_slist_append(conversation_retire_callbacks, (void *)callback);
+}
+
+typedef struct {
+    uint32_t before_frame;
+    GPtrArray *idle;
+} conversation_retire_t;
+
+static void
+conversation_collect_idle(void *key _U_, void *value, void *user_data)
+{
+    conversation_retire_t *retire = (conversation_retire_t *)user_data;
+    conversation_t *conv;
+
+    for (conv = (conversation_t *)value; conv != NULL; conv = conv->next) {
+        if (conv->setup_frame < retire->before_frame &&
+                conv->last_frame < retire->before_frame &&
+                conv->last_lookup_frame < retire->before_frame) {
+            g_ptr_array_add(retire->idle, conv);
+        }
+    }
+}
+
+static void
+conversation_free(conversation_t *conv)
+{
+    GSList *cb;
+
+    for (cb = conversation_retire_callbacks; cb != NULL; cb = cb->next) {
+        ((conversation_retire_cb)cb->data)(conv);
+    }
+
+    if (conv->data_list) {
+        wmem_tree_destroy(conv->data_list, false, false);
+    }
+    /* The dissector tree is shared with any conversations created from
+     * this one as a template, so it's left to the file scope. */
+
+    for (conversation_element_t *el = conv->key_ptr; ; el++) {
+        if (el->type == CE_ADDRESS) {
+            free_address_wmem(wmem_file_scope(), &el->addr_val);
+        } else if (el->type == CE_STRING) {
+            wmem_free(wmem_file_scope(), (void *)el->str_val);
+        } else if (el->type == CE_BLOB) {
+            wmem_free(wmem_file_scope(), (void *)el->blob.val);
+        } else if (el->type == CE_CONVERSATION_TYPE) {
+            break;
+        }
+    }
+    wmem_free(wmem_file_scope(), conv->key_ptr);
+    wmem_free(wmem_file_scope(), conv);
+}
+
+static void
+conversation_retire_table(void *key _U_, void *value, void *user_data)
+{
+    wmem_map_t *hashtable = (wmem_map_t *)value;
+    conversation_retire_t *retire = (conversation_retire_t *)user_data;
+    unsigned start = retire->idle->len;
+
+    /* The table can't be changed while we're walking it. */
+    wmem_map_foreach(hashtable, conversation_collect_idle, retire);
+    for (unsigned i = start; i < retire->idle->len; i++) {
+        conversation_remove_from_hashtable(hashtable, (conversation_t *)g_ptr_array_index(retire->idle, i));
+    }
+}
+
+unsigned
+conversation_retire_idle(const uint32_t before_frame)
+{
+    conversation_retire_t retire;
+    unsigned count;
+
+    retire.before_frame = before_frame;
+    retire.idle = g_ptr_array_new();
+    wmem_map_foreach(conversation_hashtable_element_list, conversation_retire_table, &retire);
+    for (unsigned i = 0; i < retire.idle->len; i++) {
+        conversation_free((conversation_t *)g_ptr_array_index(retire.idle, i));
+    }
+    count = retire.idle->len;
+    g_ptr_array_free(retire.idle, true);
+    return count;
+}
+
 /*
  * Does the right thing when inserting into one of the conversation hash tables,
  * taking into account ordering and hash chains and all that good stuff.
@@ -878,6 +998,9 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
             else
                 chain_head->latest_found = conv->latest_found;
 
+            /* Steal first, so that the table's key is the new head's
+             * rather than ours. */
+            wmem_map_steal(hashtable, conv->key_ptr);
             wmem_map_insert(hashtable, chain_head->key_ptr, chain_head);
         }
     }
@@ -1561,12 +1684,10 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
     DENDENT();
 }
 
-static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_hashtable, const uint32_t frame_num, conversation_element_t *conv_key)
+static conversation_t *conversation_lookup_chain(conversation_t *chain_head, const uint32_t frame_num)
 {
     conversation_t* convo = NULL;
     conversation_t* match = NULL;
-    conversation_t* chain_head = NULL;
-    chain_head = (conversation_t *)wmem_map_lookup(conversation_hashtable, conv_key);
 
     if (chain_head && (chain_head->setup_frame <= frame_num)) {
         match = chain_head;
@@ -1586,11 +1707,31 @@ static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_ha
 
     if (match) {
         chain_head->latest_found = match;
+        if (frame_num > match->last_lookup_frame) {
+            match->last_lookup_frame = frame_num;
+        }
     }
 
     return match;
 }
 
+static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_hashtable, const uint32_t frame_num, conversation_element_t *conv_key)
+{
+    return conversation_lookup_chain((conversation_t *)wmem_map_lookup(conversation_hashtable, conv_key), frame_num);
+}
+
+/*
+ * As conversation_lookup_hashtable(), for a key whose hash has already been
+ * assembled from element hashes (see conversation_hash_element_list()).
+ */
+static conversation_t *conversation_lookup_hashtable_hash(wmem_map_t *conversation_hashtable, const uint32_t frame_num,
+                                                          conversation_element_t *conv_key, unsigned hash_val)
+{
+    return conversation_lookup_chain((conversation_t *)wmem_map_lookup_hash(conversation_hashtable, conv_key,
+                                                                            conversation_hash_finish(hash_val)),
+                                     frame_num);
+}
+
 conversation_t *find_conversation_full(const uint32_t frame_num, conversation_element_t *elements)
 {
     char *el_list_map_key = conversation_element_list_name(NULL, elements);
@@ -1608,8 +1749,8 @@ conversation_t *find_conversation_full(const uint32_t frame_num, conversation_el
  * {addr1, port1, addr2, port2} and set up before frame_num.
  */
 static conversation_t *
-conversation_lookup_exact(const uint32_t frame_num, const address *addr1, const uint32_t port1,
-                          const address *addr2, const uint32_t port2, const conversation_type ctype)
+conversation_lookup_exact(const uint32_t frame_num, const address *addr1, const unsigned addr1_hash, const uint32_t port1,
+                          const address *addr2, const unsigned addr2_hash, const uint32_t port2, const conversation_type ctype)
 {
     conversation_element_t key[EXACT_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = *addr1 },
@@ -1618,7 +1759,12 @@ conversation_lookup_exact(const uint32_t frame_num, const address *addr1, const
         { CE_PORT, .port_val = port2 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = ctype },
     };
-    return conversation_lookup_hashtable(conversation_hashtable_exact_addr_port, frame_num, key);
+    unsigned hash_val = conversation_hash_combine(0, addr1_hash);
+    hash_val = conversation_hash_combine(hash_val, port1);
+    hash_val = conversation_hash_combine(hash_val, addr2_hash);
+    hash_val = conversation_hash_combine(hash_val, port2);
+    hash_val = conversation_hash_combine(hash_val, (unsigned)ctype);
+    return conversation_lookup_hashtable_hash(conversation_hashtable_exact_addr_port, frame_num, key, hash_val);
 }
 
 /*
@@ -1626,7 +1772,7 @@ conversation_lookup_exact(const uint32_t frame_num, const address *addr1, const
  * {addr1, port1, port2} and set up before frame_num.
  */
 static conversation_t *
-conversation_lookup_no_addr2(const uint32_t frame_num, const address *addr1, const uint32_t port1,
+conversation_lookup_no_addr2(const uint32_t frame_num, const address *addr1, const unsigned addr1_hash, const uint32_t port1,
                           const uint32_t port2, const conversation_type ctype)
 {
     conversation_element_t key[NO_ADDR2_IDX_COUNT] = {
@@ -1635,7 +1781,11 @@ conversation_lookup_no_addr2(const uint32_t frame_num, const address *addr1, con
         { CE_PORT, .port_val = port2 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = ctype },
     };
-    return conversation_lookup_hashtable(conversation_hashtable_no_addr2, frame_num, key);
+    unsigned hash_val = conversation_hash_combine(0, addr1_hash);
+    hash_val = conversation_hash_combine(hash_val, port1);
+    hash_val = conversation_hash_combine(hash_val, port2);
+    hash_val = conversation_hash_combine(hash_val, (unsigned)ctype);
+    return conversation_lookup_hashtable_hash(conversation_hashtable_no_addr2, frame_num, key, hash_val);
 }
 
 /*
@@ -1643,8 +1793,8 @@ conversation_lookup_no_addr2(const uint32_t frame_num, const address *addr1, con
  * {addr1, port1, addr2} and set up before frame_num.
  */
 static conversation_t *
-conversation_lookup_no_port2(const uint32_t frame_num, const address *addr1, const uint32_t port1,
-                          const address *addr2, const conversation_type ctype)
+conversation_lookup_no_port2(const uint32_t frame_num, const address *addr1, const unsigned addr1_hash, const uint32_t port1,
+                          const address *addr2, const unsigned addr2_hash, const conversation_type ctype)
 {
     conversation_element_t key[NO_PORT2_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = *addr1 },
@@ -1652,7 +1802,11 @@ conversation_lookup_no_port2(const uint32_t frame_num, const address *addr1, con
         { CE_ADDRESS, .addr_val = *addr2 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = ctype },
     };
-    return conversation_lookup_hashtable(conversation_hashtable_no_port2, frame_num, key);
+    unsigned hash_val = conversation_hash_combine(0, addr1_hash);
+    hash_val = conversation_hash_combine(hash_val, port1);
+    hash_val = conversation_hash_combine(hash_val, addr2_hash);
+    hash_val = conversation_hash_combine(hash_val, (unsigned)ctype);
+    return conversation_lookup_hashtable_hash(conversation_hashtable_no_port2, frame_num, key, hash_val);
 }
 
 /*
@@ -1660,7 +1814,7 @@ conversation_lookup_no_port2(const uint32_t frame_num, const address *addr1, con
  * {addr1, port1, addr2} and set up before frame_num.
  */
 static conversation_t *
-conversation_lookup_no_addr2_or_port2(const uint32_t frame_num, const address *addr1, const uint32_t port1,
+conversation_lookup_no_addr2_or_port2(const uint32_t frame_num, const address *addr1, const unsigned addr1_hash, const uint32_t port1,
                           const conversation_type ctype)
 {
     conversation_element_t key[NO_ADDR2_PORT2_IDX_COUNT] = {
@@ -1668,7 +1822,10 @@ conversation_lookup_no_addr2_or_port2(const uint32_t frame_num, const address *a
         { CE_PORT, .port_val = port1 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = ctype },
     };
-    return conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2, frame_num, key);
+    unsigned hash_val = conversation_hash_combine(0, addr1_hash);
+    hash_val = conversation_hash_combine(hash_val, port1);
+    hash_val = conversation_hash_combine(hash_val, (unsigned)ctype);
+    return conversation_lookup_hashtable_hash(conversation_hashtable_no_addr2_or_port2, frame_num, key, hash_val);
 }
 
 /*
@@ -1676,15 +1833,18 @@ conversation_lookup_no_addr2_or_port2(const uint32_t frame_num, const address *a
  * {addr1, addr2} and set up before frame_num.
  */
 static conversation_t *
-conversation_lookup_no_ports(const uint32_t frame_num, const address *addr1,
-                          const address *addr2, const conversation_type ctype)
+conversation_lookup_no_ports(const uint32_t frame_num, const address *addr1, const unsigned addr1_hash,
+                          const address *addr2, const unsigned addr2_hash, const conversation_type ctype)
 {
     conversation_element_t key[ADDRS_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = *addr1 },
         { CE_ADDRESS, .addr_val = *addr2 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = ctype },
     };
-    return conversation_lookup_hashtable(conversation_hashtable_exact_addr, frame_num, key);
+    unsigned hash_val = conversation_hash_combine(0, addr1_hash);
+    hash_val = conversation_hash_combine(hash_val, addr2_hash);
+    hash_val = conversation_hash_combine(hash_val, (unsigned)ctype);
+    return conversation_lookup_hashtable_hash(conversation_hashtable_exact_addr, frame_num, key, hash_val);
 }
 
 /*
@@ -1850,6 +2010,10 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
         addr_b = &null_address_;
     }
 
+    /* Every table searched below is keyed by these addresses. */
+    unsigned hash_a = conversation_hash_address(addr_a);
+    unsigned hash_b = conversation_hash_address(addr_b);
+
     DINSTR(char *addr_a_str = address_to_str(NULL, addr_a));
     DINSTR(char *addr_b_str = address_to_str(NULL, addr_b));
     /*
@@ -1866,7 +2030,7 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
          */
         DPRINT(("trying exact match: %s:%d -> %s:%d",
                     addr_a_str, port_a, addr_b_str, port_b));
-        conversation = conversation_lookup_exact(frame_num, addr_a, port_a, addr_b, port_b, ctype);
+        conversation = conversation_lookup_exact(frame_num, addr_a, hash_a, port_a, addr_b, hash_b, port_b, ctype);
         /*
          * Look for an alternate conversation in the opposite direction, which
          * might fit better. Note that using the helper functions such as
@@ -1878,7 +2042,7 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
 
         DPRINT(("trying exact match: %s:%d -> %s:%d",
                     addr_b_str, port_b, addr_a_str, port_a));
-        other_conv = conversation_lookup_exact(frame_num, addr_b, port_b, addr_a, port_a, ctype);
+        other_conv = conversation_lookup_exact(frame_num, addr_b, hash_b, port_b, addr_a, hash_a, port_a, ctype);
         if (other_conv != NULL) {
             if (conversation != NULL) {
                 if(other_conv->conv_index > conversation->conv_index) {
@@ -1895,7 +2059,7 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
              */
             DPRINT(("trying exact match: %s:%d -> %s:%d",
                         addr_b_str, port_a, addr_a_str, port_b));
-            conversation = conversation_lookup_exact(frame_num, addr_b, port_a, addr_a, port_b, ctype);
+            conversation = conversation_lookup_exact(frame_num, addr_b, hash_b, port_a, addr_a, hash_a, port_b, ctype);
         }
         DPRINT(("exact match %sfound",conversation?"":"not "));
         if (conversation != NULL)
@@ -1920,14 +2084,14 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
          */
         DPRINT(("trying wildcarded match: %s:%d -> *:%d",
                     addr_a_str, port_a, port_b));
-        conversation = conversation_lookup_no_addr2(frame_num, addr_a, port_a, port_b, ctype);
+        conversation = conversation_lookup_no_addr2(frame_num, addr_a, hash_a, port_a, port_b, ctype);
         if ((conversation == NULL) && (addr_a->type == AT_FC)) {
             /* In Fibre channel, OXID & RXID are never swapped as
              * TCP/UDP ports are in TCP/IP.
              */
             DPRINT(("trying wildcarded match: %s:%d -> *:%d",
                         addr_b_str, port_a, port_b));
-            conversation = conversation_lookup_no_addr2(frame_num, addr_b, port_a, port_b, ctype);
+            conversation = conversation_lookup_no_addr2(frame_num, addr_b, hash_b, port_a, port_b, ctype);
         }
         if (conversation != NULL) {
             /*
@@ -1970,7 +2134,7 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
         if (!(options & NO_ADDR_B)) {
             DPRINT(("trying wildcarded match: %s:%d -> *:%d",
                         addr_b_str, port_b, port_a));
-            conversation = conversation_lookup_no_addr2(frame_num, addr_b, port_b, port_a, ctype);
+            conversation = conversation_lookup_no_addr2(frame_num, addr_b, hash_b, port_b, port_a, ctype);
             if (conversation != NULL) {
                 /*
                  * If this is for a connection-oriented
@@ -2013,13 +2177,13 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
          */
         DPRINT(("trying wildcarded match: %s:%d -> %s:*",
                     addr_a_str, port_a, addr_b_str));
-        conversation = conversation_lookup_no_port2(frame_num, addr_a, port_a, addr_b, ctype);
+        conversation = conversation_lookup_no_port2(frame_num, addr_a, hash_a, port_a, addr_b, hash_b, ctype);
         if ((conversation == NULL) && (addr_a->type == AT_FC)) {
             /* In Fibre channel, OXID & RXID are never swapped as
              * TCP/UDP ports are in TCP/IP
              */
             DPRINT(("trying wildcarded match: %s:%d -> %s:*", addr_b_str, port_a, addr_a_str));
-            conversation = conversation_lookup_no_port2(frame_num, addr_b, port_a, addr_a, ctype);
+            conversation = conversation_lookup_no_port2(frame_num, addr_b, hash_b, port_a, addr_a, hash_a, ctype);
         }
         if (conversation != NULL) {
             /*
@@ -2062,7 +2226,7 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
         if (!(options & NO_PORT_B)) {
             DPRINT(("trying wildcarded match: %s:%d -> %s:*",
                         addr_b_str, port_b, addr_a_str));
-            conversation = conversation_lookup_no_port2(frame_num, addr_b, port_b, addr_a, ctype);
+            conversation = conversation_lookup_no_port2(frame_num, addr_b, hash_b, port_b, addr_a, hash_a, ctype);
             if (conversation != NULL) {
                 /*
                  * If this is for a connection-oriented
@@ -2103,7 +2267,7 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
      */
     if (!(options & NO_PORT_X)) {
         DPRINT(("trying wildcarded match: %s:%d -> *:*", addr_a_str, port_a));
-        conversation = conversation_lookup_no_addr2_or_port2(frame_num, addr_a, port_a, ctype);
+        conversation = conversation_lookup_no_addr2_or_port2(frame_num, addr_a, hash_a, port_a, ctype);
         if (conversation != NULL) {
             /*
              * If this is for a connection-oriented protocol:
@@ -2156,11 +2320,11 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
             if (addr_a->type == AT_FC) {
                 DPRINT(("trying wildcarded match: %s:%d -> *:*",
                             addr_b_str, port_a));
-                conversation = conversation_lookup_no_addr2_or_port2(frame_num, addr_b, port_a, ctype);
+                conversation = conversation_lookup_no_addr2_or_port2(frame_num, addr_b, hash_b, port_a, ctype);
             } else {
                 DPRINT(("trying wildcarded match: %s:%d -> *:*",
                             addr_b_str, port_b));
-                conversation = conversation_lookup_no_addr2_or_port2(frame_num, addr_b, port_b, ctype);
+                conversation = conversation_lookup_no_addr2_or_port2(frame_num, addr_b, hash_b, port_b, ctype);
             }
             if (conversation != NULL) {
                 /*
@@ -2205,7 +2369,7 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
          */
         DPRINT(("trying exact match: %s -> %s",
                     addr_a_str, addr_b_str));
-        conversation = conversation_lookup_no_ports(frame_num, addr_a, addr_b, ctype);
+        conversation = conversation_lookup_no_ports(frame_num, addr_a, hash_a, addr_b, hash_b, ctype);
 
         if (conversation != NULL) {
             DPRINT(("match found"));
@@ -2217,7 +2381,7 @@ find_conversation(const uint32_t frame_num, const address *addr_a, const address
         else {
             DPRINT(("trying exact match: %s -> %s",
                         addr_b_str, addr_a_str));
-            conversation = conversation_lookup_no_ports(frame_num, addr_b, addr_a, ctype);
+            conversation = conversation_lookup_no_ports(frame_num, addr_b, hash_b, addr_a, hash_a, ctype);
             if (conversation != NULL) {
                 DPRINT(("match found"));
                 goto end;
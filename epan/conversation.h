@@ -239,6 +239,7 @@ typedef struct conversation {
     wmem_tree_t *dissector_tree;	/** tree containing protocol dissector client associated with conversation */
     unsigned	options;		/** wildcard flags */
     conversation_element_t *key_ptr;	/** Keys are conversation element arrays terminated with a CE_CONVERSATION_TYPE */
+    uint32_t last_lookup_frame;		/** highest frame number in which the conversation was looked up */
 } conversation_t;
 
 /*
@@ -293,6 +294,35 @@ extern void conversation_init(void);
  */
 extern void conversation_epan_reset(void);
 
+/**
+ * Called for each conversation that is about to be retired by
+ * conversation_retire_idle(), so that whoever attached data to it can
+ * free that data.
+ */
+typedef void (*conversation_retire_cb)(conversation_t *conv);
+
+/**
+ * Register a function to be called for retired conversations.
+ *
+ * @param callback The function to call.
+ */
+WS_DLL_PUBLIC void conversation_register_retire_callback(conversation_retire_cb callback);
+
+/**
+ * Retire the conversations that haven't been created, found or looked up
+ * since before the given frame. They are removed from the conversation
+ * tables, the retire callbacks are called for them, and the conversations
+ * themselves are freed; the data attached with conversation_add_proto_data()
+ * is left to the callbacks.
+ *
+ * This is only safe when no frame before before_frame will be dissected
+ * again, such as in a single pass over a live capture.
+ *
+ * @param before_frame The first frame whose conversations are kept.
+ * @return The number of conversations retired.
+ */
+WS_DLL_PUBLIC unsigned conversation_retire_idle(const uint32_t before_frame);
+
 /**
  * Create a new conversation identified by a list of elements.
  * @param setup_frame The first frame in the conversation.
@@ -338,6 +338,119 @@ void reset_hostlist_table_data(conv_hash_t *ch)
     reset_endpoint_table_data(ch);
 }
 
+void *
+conversation_table_shard_new(void *tapdata)
+{
+    const conv_hash_t *ch = (const conv_hash_t *)tapdata;
+    conv_hash_t *shard = g_new0(conv_hash_t, 1);
+
+    shard->user_data = ch->user_data;
+    shard->flags = ch->flags;
+    return shard;
+}
+
+void
+conversation_table_shard_merge(void *tapdata, void *shard)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    const conv_hash_t *shard_ch = (const conv_hash_t *)shard;
+    unsigned i;
+
+    if (shard_ch->conv_array == NULL) {
+        return;
+    }
+
+    if (ch->conv_array == NULL) {
+        ch->conv_array = g_array_sized_new(false, false, sizeof(conv_item_t), shard_ch->conv_array->len);
+        ch->hashtable = g_hash_table_new_full(conversation_hash,
+                                              conversation_equal, /* key_equal_func */
+                                              g_free,             /* key_destroy_func */
+                                              NULL);              /* value_destroy_func */
+    }
+
+    for (i = 0; i < shard_ch->conv_array->len; i++) {
+        const conv_item_t *shard_item = &g_array_index(shard_ch->conv_array, conv_item_t, i);
+        conv_item_t *conv_item;
+        conv_key_t existing_key;
+        void *conversation_idx_hash_val;
+
+        /* conversation_equal() matches either direction */
+        existing_key.addr1 = shard_item->src_address;
+        existing_key.addr2 = shard_item->dst_address;
+        existing_key.port1 = shard_item->src_port;
+        existing_key.port2 = shard_item->dst_port;
+        existing_key.conv_id = shard_item->conv_id;
+
+        if (!g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
+            conv_key_t *new_key;
+            conv_item_t new_conv_item = *shard_item;
+            unsigned int conversation_idx;
+
+            copy_address(&new_conv_item.src_address, &shard_item->src_address);
+            copy_address(&new_conv_item.dst_address, &shard_item->dst_address);
+            g_array_append_val(ch->conv_array, new_conv_item);
+            conversation_idx = ch->conv_array->len - 1;
+            conv_item = &g_array_index(ch->conv_array, conv_item_t, conversation_idx);
+
+            new_key = g_new(conv_key_t, 1);
+            set_address(&new_key->addr1, conv_item->src_address.type, conv_item->src_address.len, conv_item->src_address.data);
+            set_address(&new_key->addr2, conv_item->dst_address.type, conv_item->dst_address.len, conv_item->dst_address.data);
+            new_key->port1 = conv_item->src_port;
+            new_key->port2 = conv_item->dst_port;
+            new_key->conv_id = conv_item->conv_id;
+            g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
+            continue;
+        }
+
+        conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
+        if (conv_item->src_port == shard_item->src_port &&
+            addresses_equal(&conv_item->src_address, &shard_item->src_address)) {
+            conv_item->tx_frames += shard_item->tx_frames;
+            conv_item->tx_bytes += shard_item->tx_bytes;
+            conv_item->rx_frames += shard_item->rx_frames;
+            conv_item->rx_bytes += shard_item->rx_bytes;
+            conv_item->tx_frames_total += shard_item->tx_frames_total;
+            conv_item->tx_bytes_total += shard_item->tx_bytes_total;
+            conv_item->rx_frames_total += shard_item->rx_frames_total;
+            conv_item->rx_bytes_total += shard_item->rx_bytes_total;
+        } else {
+            /* the shard saw this conversation the other way around */
+            conv_item->tx_frames += shard_item->rx_frames;
+            conv_item->tx_bytes += shard_item->rx_bytes;
+            conv_item->rx_frames += shard_item->tx_frames;
+            conv_item->rx_bytes += shard_item->tx_bytes;
+            conv_item->tx_frames_total += shard_item->rx_frames_total;
+            conv_item->tx_bytes_total += shard_item->rx_bytes_total;
+            conv_item->rx_frames_total += shard_item->tx_frames_total;
+            conv_item->rx_bytes_total += shard_item->tx_bytes_total;
+        }
+        conv_item->filtered = conv_item->filtered && shard_item->filtered;
+
+        if (!nstime_is_unset(&shard_item->start_time)) {
+            if (nstime_is_unset(&conv_item->start_time) ||
+                    nstime_cmp(&shard_item->start_time, &conv_item->start_time) < 0) {
+                conv_item->start_time = shard_item->start_time;
+                conv_item->start_abs_time = shard_item->start_abs_time;
+            }
+            if (nstime_is_unset(&conv_item->stop_time) ||
+                    nstime_cmp(&shard_item->stop_time, &conv_item->stop_time) > 0) {
+                conv_item->stop_time = shard_item->stop_time;
+            }
+        }
+
+        if (shard_item->ext_tcp.flows > conv_item->ext_tcp.flows) {
+            conv_item->ext_tcp = shard_item->ext_tcp;
+        }
+    }
+}
+
+void
+conversation_table_shard_free(void *shard)
+{
+    reset_conversation_table_data((conv_hash_t *)shard);
+    g_free(shard);
+}
+
 char *get_conversation_address(wmem_allocator_t *allocator, address *addr, bool resolve_names)
 {
     if (resolve_names) {
@@ -1081,6 +1194,79 @@ add_hostlist_table_data(conv_hash_t *ch, const address *addr, uint32_t port, boo
     add_endpoint_table_data(ch, addr, port, sender, num_frames, num_bytes, et_info, etype);
 }
 
+void *
+endpoint_table_shard_new(void *tapdata)
+{
+    return conversation_table_shard_new(tapdata);
+}
+
+void
+endpoint_table_shard_merge(void *tapdata, void *shard)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    const conv_hash_t *shard_ch = (const conv_hash_t *)shard;
+    unsigned i;
+
+    if (shard_ch->conv_array == NULL) {
+        return;
+    }
+
+    if (ch->conv_array == NULL) {
+        ch->conv_array = g_array_sized_new(false, false, sizeof(endpoint_item_t), shard_ch->conv_array->len);
+        ch->hashtable = g_hash_table_new_full(endpoint_hash,
+                                              endpoint_match, /* key_equal_func */
+                                              g_free,     /* key_destroy_func */
+                                              NULL);      /* value_destroy_func */
+    }
+
+    for (i = 0; i < shard_ch->conv_array->len; i++) {
+        const endpoint_item_t *shard_item = &g_array_index(shard_ch->conv_array, endpoint_item_t, i);
+        endpoint_item_t *endpoint_item;
+        endpoint_key_t existing_key;
+        void *endpoint_idx_hash_val;
+
+        copy_address_shallow(&existing_key.myaddress, &shard_item->myaddress);
+        existing_key.port = shard_item->port;
+
+        if (!g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &endpoint_idx_hash_val)) {
+            endpoint_key_t *new_key;
+            endpoint_item_t new_endpoint_item = *shard_item;
+            unsigned int endpoint_idx;
+
+            copy_address(&new_endpoint_item.myaddress, &shard_item->myaddress);
+            new_endpoint_item.modified = true;
+            g_array_append_val(ch->conv_array, new_endpoint_item);
+            endpoint_idx = ch->conv_array->len - 1;
+            endpoint_item = &g_array_index(ch->conv_array, endpoint_item_t, endpoint_idx);
+
+            new_key = g_new(endpoint_key_t, 1);
+            set_address(&new_key->myaddress, endpoint_item->myaddress.type, endpoint_item->myaddress.len, endpoint_item->myaddress.data);
+            new_key->port = endpoint_item->port;
+            g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(endpoint_idx));
+            continue;
+        }
+
+        endpoint_item = &g_array_index(ch->conv_array, endpoint_item_t, GPOINTER_TO_UINT(endpoint_idx_hash_val));
+        endpoint_item->tx_frames += shard_item->tx_frames;
+        endpoint_item->tx_bytes += shard_item->tx_bytes;
+        endpoint_item->rx_frames += shard_item->rx_frames;
+        endpoint_item->rx_bytes += shard_item->rx_bytes;
+        endpoint_item->tx_frames_total += shard_item->tx_frames_total;
+        endpoint_item->tx_bytes_total += shard_item->tx_bytes_total;
+        endpoint_item->rx_frames_total += shard_item->rx_frames_total;
+        endpoint_item->rx_bytes_total += shard_item->rx_bytes_total;
+        endpoint_item->filtered = endpoint_item->filtered && shard_item->filtered;
+        endpoint_item->modified = true;
+    }
+}
+
+void
+endpoint_table_shard_free(void *shard)
+{
+    reset_endpoint_table_data((conv_hash_t *)shard);
+    g_free(shard);
+}
+
 /*
  * Editor modelines
  *
@@ -293,6 +293,25 @@ WS_DLL_PUBLIC void reset_endpoint_table_data(conv_hash_t *ch);
 G_DEPRECATED_FOR(reset_endpoint_table_data)
 WS_DLL_PUBLIC void reset_hostlist_table_data(conv_hash_t *ch);
 
+/** Shard callbacks for set_tap_mergeable(), for conversation listeners
+ *  whose tapdata is a conv_hash_t.
+ *
+ *  A shard starts out as an empty table with the same flags. Merging adds
+ *  its counters to the matching conversations in the parent, in either
+ *  direction, and appends the conversations the parent hasn't seen yet in
+ *  the order the shard saw them.
+ */
+WS_DLL_PUBLIC void *conversation_table_shard_new(void *tapdata);
+WS_DLL_PUBLIC void conversation_table_shard_merge(void *tapdata, void *shard);
+WS_DLL_PUBLIC void conversation_table_shard_free(void *shard);
+
+/** Shard callbacks for set_tap_mergeable(), for endpoint listeners
+ *  whose tapdata is a conv_hash_t.
+ */
+WS_DLL_PUBLIC void *endpoint_table_shard_new(void *tapdata);
+WS_DLL_PUBLIC void endpoint_table_shard_merge(void *tapdata, void *shard);
+WS_DLL_PUBLIC void endpoint_table_shard_free(void *shard);
+
 /** Initialize dissector conversation for stats and (possibly) GUI.
  *
  * @param opt_arg filter string to compare with dissector
@@ -2852,21 +2852,73 @@ Dot11DecryptFtDerivePtk(
 
 #define MAX_SSID_LENGTH 32 /* maximum SSID length */
 
+/*
+ * Deriving a PSK takes 4096 rounds of PBKDF2-SHA1, and the same
+ * passphrase/SSID pairs are derived again each time the keys are set
+ * (on every preference change and file reload) and for every handshake
+ * tried against a wildcard SSID key. Remember the results for the life
+ * of the process; they are only ever kept in memory.
+ */
+#define PSK_CACHE_MAX_ENTRIES 4096
+
+static GHashTable *psk_cache;
+
+static GBytes *
+Dot11DecryptPskCacheKey(
+    const struct DOT11DECRYPT_KEY_ITEMDATA_PWD *userPwd)
+{
+    uint8_t key[1 + DOT11DECRYPT_WPA_PASSPHRASE_MAX_LEN + MAX_SSID_LENGTH];
+
+    /* The passphrase length separates the passphrase from the SSID. */
+    key[0] = (uint8_t)userPwd->PassphraseLen;
+    memcpy(key + 1, userPwd->Passphrase, userPwd->PassphraseLen);
+    memcpy(key + 1 + userPwd->PassphraseLen, userPwd->Ssid, userPwd->SsidLen);
+
+    return g_bytes_new(key, 1 + userPwd->PassphraseLen + userPwd->SsidLen);
+}
+
 static int
 Dot11DecryptRsnaPwd2Psk(
     const struct DOT11DECRYPT_KEY_ITEMDATA_PWD *userPwd,
     unsigned char *output)
 {
+    GBytes *cache_key;
+    const unsigned char *cached;
+
     if (userPwd->SsidLen> MAX_SSID_LENGTH) {
         /* This "should not happen" */
         return DOT11DECRYPT_RET_UNSUCCESS;
     }
+    if (userPwd->PassphraseLen > DOT11DECRYPT_WPA_PASSPHRASE_MAX_LEN) {
+        return DOT11DECRYPT_RET_UNSUCCESS;
+    }
+
+    if (psk_cache == NULL) {
+        psk_cache = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+                                          (GDestroyNotify)g_bytes_unref, g_free);
+    }
+
+    cache_key = Dot11DecryptPskCacheKey(userPwd);
+    cached = (const unsigned char *)g_hash_table_lookup(psk_cache, cache_key);
+    if (cached != NULL) {
+        g_bytes_unref(cache_key);
+        memcpy(output, cached, DOT11DECRYPT_WPA_PWD_PSK_LEN);
+        return DOT11DECRYPT_RET_SUCCESS;
+    }
+
     if (gcry_kdf_derive(userPwd->Passphrase, userPwd->PassphraseLen, GCRY_KDF_PBKDF2,
                         GCRY_MD_SHA1, userPwd->Ssid, userPwd->SsidLen, 4096,
                         DOT11DECRYPT_WPA_PWD_PSK_LEN, output)) {
+        g_bytes_unref(cache_key);
         return DOT11DECRYPT_RET_UNSUCCESS;
     }
 
+    /* Start over rather than grow without bound when fed many SSIDs. */
+    if (g_hash_table_size(psk_cache) >= PSK_CACHE_MAX_ENTRIES) {
+        g_hash_table_remove_all(psk_cache);
+    }
+    g_hash_table_insert(psk_cache, cache_key, g_memdup2(output, DOT11DECRYPT_WPA_PWD_PSK_LEN));
+
     return DOT11DECRYPT_RET_SUCCESS;
 }
 
@@ -31,13 +31,29 @@ typedef struct {
 	unsigned idx;
 } df_cell_iter_t;
 
+/* Execution counters for one instruction, kept while profiling. */
+typedef struct {
+	uint64_t	executed;
+	uint64_t	elapsed_ns;
+	uint64_t	values;		/* Field values loaded, for reads */
+} df_insn_profile_t;
+
 /* Passed back to user */
 struct epan_dfilter {
+	/* Dropped by dfilter_free(); more than 1 when shared by the cache. */
+	int		refcount;
 	GPtrArray	*insns;
 	unsigned	num_registers;
 	df_cell_t	*registers;
 	int		*interesting_fields;
 	int		num_interesting_fields;
+	int		*required_protos;
+	int		num_required_protos;
+	dfilter_frame_bounds_t frame_bounds;
+	bool		has_frame_bounds;
+	GHashTable	*field_values;	/* field ID -> GArray of uint32_t, or NULL */
+	GPtrArray	*conjuncts;
+	GPtrArray	*disjuncts;
 	GPtrArray	*deprecated;
 	GSList		*warnings;
 	char		*expanded_text;
@@ -48,6 +64,10 @@ struct epan_dfilter {
 	GSList		*function_stack;
 	GSList		*set_stack;
 	ftenum_t	 ret_type;
+	/* NULL unless profiling; one entry per instruction. */
+	df_insn_profile_t *profile;
+	uint64_t	profile_runs;
+	uint64_t	profile_matched;
 };
 
 typedef struct {
@@ -543,6 +543,8 @@ void dfilter_macro_reload(const char* app_env_var_prefix) {
 	 * for every reload because the configuration profile might have changed. */
 	convert_old_uat_file(app_env_var_prefix);
 
+	dfilter_lock();
+	dfilter_cache_flush();
 	g_hash_table_remove_all(macros_table);
 
 	filter_list_t *list = ws_filter_list_read(DMACROS_LIST, app_env_var_prefix);
@@ -560,6 +562,7 @@ void dfilter_macro_reload(const char* app_env_var_prefix) {
 		}
 	}
 
+	dfilter_unlock();
 	ws_filter_list_free(list);
 }
 
@@ -26,6 +26,7 @@
 #include "scanner_lex.h"
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/ws_trace.h>
 #include "grammar.h"
 
 
@@ -34,6 +35,24 @@
 /* Holds the singular instance of our Lemon parser object */
 static void*	ParserObj;
 
+/*
+ * Compiling uses ParserObj, the macro table and the field registry, so
+ * only one thread compiles at a time, and code that changes the macros
+ * or the registry after startup holds the same lock; see dfilter_lock().
+ * It's recursive because registering a field can happen in the middle
+ * of a compile, when a prefix initializer runs.
+ */
+static GRecMutex dfilter_mutex;
+
+/*
+ * Filters compiled with dfilter_compile_shared(), keyed by the flags
+ * and the text, holding one reference each. Empty when anything that
+ * could change their meaning changes; when full, the oldest goes.
+ */
+#define DFILTER_CACHE_MAX	256
+static GHashTable *dfilter_cache;
+static GQueue dfilter_cache_order = G_QUEUE_INIT;
+
 df_loc_t loc_empty = {-1, 0};
 
 void
@@ -124,6 +143,12 @@ dfilter_init(const char* app_env_var_prefix)
 void
 dfilter_cleanup(void)
 {
+	dfilter_cache_flush();
+	if (dfilter_cache) {
+		g_hash_table_destroy(dfilter_cache);
+		dfilter_cache = NULL;
+	}
+
 	dfilter_plugins_cleanup();
 	dfilter_macro_cleanup();
 	df_func_cleanup();
@@ -143,6 +168,7 @@ dfilter_new(GPtrArray *deprecated)
 	dfilter_t	*df;
 
 	df = g_new0(dfilter_t, 1);
+	df->refcount = 1;
 	df->insns = NULL;
 	df->function_stack = NULL;
 	df->set_stack = NULL;
@@ -173,11 +199,21 @@ dfilter_free(dfilter_t *df)
 	if (!df)
 		return;
 
+	if (!g_atomic_int_dec_and_test(&df->refcount))
+		return;
+
 	if (df->insns) {
 		free_insns(df->insns);
 	}
 
 	g_free(df->interesting_fields);
+	g_free(df->required_protos);
+	if (df->field_values)
+		g_hash_table_destroy(df->field_values);
+	if (df->conjuncts)
+		g_ptr_array_unref(df->conjuncts);
+	if (df->disjuncts)
+		g_ptr_array_unref(df->disjuncts);
 
 	g_hash_table_destroy(df->references);
 	g_hash_table_destroy(df->raw_references);
@@ -201,6 +237,7 @@ dfilter_free(dfilter_t *df)
 	g_free(df->registers);
 	g_free(df->expanded_text);
 	g_free(df->syntax_tree_str);
+	g_free(df->profile);
 	g_free(df);
 }
 
@@ -473,6 +510,9 @@ dfwork_build(dfwork_t *dfw)
 {
 	dfilter_t	*dfilter;
 	char		*tree_str;
+	dfilter_frame_bounds_t frame_bounds;
+	bool		has_frame_bounds;
+	GHashTable	*field_values;
 
 	log_syntax_tree(LOG_LEVEL_NOISY, dfw->st_root, "Syntax tree before semantic check", NULL);
 
@@ -488,6 +528,11 @@ dfwork_build(dfwork_t *dfw)
 		tree_str = dump_syntax_tree_str(dfw->st_root);
 	}
 
+	/* Code generation takes the constants out of the tree, so look at
+	 * them first. */
+	has_frame_bounds = dfw_frame_bounds(dfw, &frame_bounds);
+	field_values = dfw_field_values(dfw);
+
 	/* Create bytecode */
 	dfw_gencode(dfw);
 
@@ -497,6 +542,13 @@ dfwork_build(dfwork_t *dfw)
 	dfw->insns = NULL;
 	dfilter->interesting_fields = dfw_interesting_fields(dfw,
 		&dfilter->num_interesting_fields);
+	dfilter->required_protos = dfw_required_protocols(dfw,
+		&dfilter->num_required_protos);
+	dfilter->frame_bounds = frame_bounds;
+	dfilter->has_frame_bounds = has_frame_bounds;
+	dfilter->field_values = field_values;
+	dfilter->conjuncts = dfw_terms(dfw, STNODE_OP_AND);
+	dfilter->disjuncts = dfw_terms(dfw, STNODE_OP_OR);
 	dfilter->expanded_text = dfw->expanded_text;
 	dfw->expanded_text = NULL;
 	dfilter->references = dfw->references;
@@ -626,9 +678,11 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 
 	ws_debug("Called from %s() with filter: %s", caller, text);
 
+	dfilter_lock();
 	if (flags & DF_EXPAND_MACROS) {
 		expanded_text = dfilter_macro_apply(text, &error);
 		if (expanded_text == NULL) {
+			dfilter_unlock();
 			return compile_failure(error, err_ptr);
 		}
 		ws_noisy("Expanded text: %s", expanded_text);
@@ -639,6 +693,7 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 	}
 
 	dfcode = compile_filter(expanded_text, flags, &error);
+	dfilter_unlock();
 	g_free(expanded_text);
 	expanded_text = NULL;
 
@@ -651,6 +706,82 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 	return true;
 }
 
+static bool
+has_references(const dfilter_t *df);
+
+bool
+dfilter_compile_shared(const char *text, dfilter_t **dfp,
+			df_error_t **err_ptr, unsigned flags,
+			const char *caller)
+{
+	dfilter_t *dfcode;
+	char *key;
+	bool ok;
+
+	ws_assert(dfp);
+	if (text == NULL || (flags & (DF_DEBUG_FLEX|DF_DEBUG_LEMON))) {
+		return dfilter_compile_full(text, dfp, err_ptr, flags, caller);
+	}
+
+	key = ws_strdup_printf("%x:%s", flags, text);
+
+	dfilter_lock();
+	if (dfilter_cache != NULL &&
+			(dfcode = g_hash_table_lookup(dfilter_cache, key)) != NULL) {
+		g_atomic_int_inc(&dfcode->refcount);
+		dfilter_unlock();
+		g_free(key);
+		ws_debug("Called from %s() with cached filter: %s", caller, text);
+		*dfp = dfcode;
+		return true;
+	}
+
+	ok = dfilter_compile_full(text, dfp, err_ptr, flags, caller);
+
+	/* Field references are loaded into the filter itself before each
+	 * use, so a filter that has any can't be shared. */
+	if (ok && *dfp != NULL && !has_references(*dfp)) {
+		if (dfilter_cache == NULL) {
+			dfilter_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+						g_free, (GDestroyNotify)dfilter_free);
+		}
+		if (g_queue_get_length(&dfilter_cache_order) >= DFILTER_CACHE_MAX) {
+			g_hash_table_remove(dfilter_cache, g_queue_pop_head(&dfilter_cache_order));
+		}
+		g_atomic_int_inc(&(*dfp)->refcount);
+		g_hash_table_insert(dfilter_cache, key, *dfp);
+		g_queue_push_tail(&dfilter_cache_order, key);
+		key = NULL;
+	}
+	dfilter_unlock();
+
+	g_free(key);
+	return ok;
+}
+
+void
+dfilter_cache_flush(void)
+{
+	dfilter_lock();
+	g_queue_clear(&dfilter_cache_order);
+	if (dfilter_cache != NULL) {
+		g_hash_table_remove_all(dfilter_cache);
+	}
+	dfilter_unlock();
+}
+
+void
+dfilter_lock(void)
+{
+	g_rec_mutex_lock(&dfilter_mutex);
+}
+
+void
+dfilter_unlock(void)
+{
+	g_rec_mutex_unlock(&dfilter_mutex);
+}
+
 struct stnode *dfilter_get_syntax_tree(const char *text)
 {
 	dfsyntax_t *dfs = NULL;
@@ -658,14 +789,17 @@ struct stnode *dfilter_get_syntax_tree(const char *text)
 
 	dfs = dfsyntax_new(DF_EXPAND_MACROS);
 
+	dfilter_lock();
 	char *expanded_text = dfilter_macro_apply(text, NULL);
 	if (!expanded_text) {
+		dfilter_unlock();
 		dfsyntax_free(dfs);
 		return NULL;
 	}
 
 	bool ok = dfwork_parse(expanded_text, dfs);
 	if (!ok || !dfs->st_root) {
+		dfilter_unlock();
 		g_free(expanded_text);
 		dfsyntax_free(dfs);
 		return NULL;
@@ -678,9 +812,11 @@ struct stnode *dfilter_get_syntax_tree(const char *text)
 	dfsyntax_free(dfs);
 
 	if (!dfw_semcheck(dfw)) {
+		dfilter_unlock();
 		dfwork_free(dfw);
 		return NULL;
 	}
+	dfilter_unlock();
 
 	stnode_t *st_root = dfw->st_root;
 	dfw->st_root = NULL;
@@ -698,7 +834,12 @@ dfilter_apply(dfilter_t *df, proto_tree *tree)
 bool
 dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 {
-	return dfvm_apply(df, edt->tree);
+	bool passed;
+
+	WS_TRACE1(filter__start, edt->pi.num);
+	passed = dfvm_apply(df, edt->tree);
+	WS_TRACE2(filter__done, edt->pi.num, passed);
+	return passed;
 }
 
 bool
@@ -707,6 +848,18 @@ dfilter_apply_full(dfilter_t *df, proto_tree *tree, GPtrArray **fvals)
 	return dfvm_apply_full(df, tree, fvals);
 }
 
+void
+dfilter_set_profiling(dfilter_t *df, bool enable)
+{
+	g_free(df->profile);
+	df->profile = NULL;
+	df->profile_runs = 0;
+	df->profile_matched = 0;
+	if (enable) {
+		df->profile = g_new0(df_insn_profile_t, df->insns->len);
+	}
+}
+
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree)
 {
@@ -768,6 +921,97 @@ dfilter_interested_in_proto(const dfilter_t *df, int proto_id)
 	return false;
 }
 
+const int *
+dfilter_interesting_fields(const dfilter_t *df, int *num_fields)
+{
+	*num_fields = df->num_interesting_fields;
+	return df->interesting_fields;
+}
+
+const int *
+dfilter_required_protocols(const dfilter_t *df, int *num_protos)
+{
+	if (df == NULL) {
+		*num_protos = 0;
+		return NULL;
+	}
+	*num_protos = df->num_required_protos;
+	return df->required_protos;
+}
+
+bool
+dfilter_frame_bounds(const dfilter_t *df, dfilter_frame_bounds_t *bounds)
+{
+	if (df == NULL || !df->has_frame_bounds) {
+		return false;
+	}
+	*bounds = df->frame_bounds;
+	return true;
+}
+
+bool
+dfilter_field_values(const dfilter_t *df, int hfid, const uint32_t **values,
+			unsigned *num_values)
+{
+	GArray *field_values;
+
+	if (df == NULL || df->field_values == NULL) {
+		return false;
+	}
+	field_values = (GArray *)g_hash_table_lookup(df->field_values, GINT_TO_POINTER(hfid));
+	if (field_values == NULL) {
+		return false;
+	}
+	*values = (const uint32_t *)field_values->data;
+	*num_values = field_values->len;
+	return true;
+}
+
+/* Is every term in "terms" also in "of"? */
+static bool
+terms_subset(const GPtrArray *terms, const GPtrArray *of)
+{
+	for (unsigned i = 0; i < terms->len; i++) {
+		bool found = false;
+		for (unsigned j = 0; j < of->len && !found; j++) {
+			found = strcmp(g_ptr_array_index(terms, i), g_ptr_array_index(of, j)) == 0;
+		}
+		if (!found)
+			return false;
+	}
+	return true;
+}
+
+static bool
+has_references(const dfilter_t *df)
+{
+	return g_hash_table_size(df->references) > 0 ||
+		g_hash_table_size(df->raw_references) > 0;
+}
+
+bool
+dfilter_implies(const dfilter_t *df, const dfilter_t *other)
+{
+	if (other == NULL) {
+		/* The empty filter matches everything. */
+		return true;
+	}
+	if (df == NULL) {
+		return false;
+	}
+
+	/* Field references take their values from whatever frame is selected
+	 * when the filter is applied, so the same text needn't match the same
+	 * frames twice. */
+	if (has_references(df) || has_references(other)) {
+		return false;
+	}
+
+	/* "A and B" implies "A", and "A" implies "A or B". */
+	return terms_subset(other->conjuncts, df->conjuncts) ||
+		terms_subset(df->disjuncts, other->disjuncts);
+}
+
 bool
 dfilter_requires_columns(const dfilter_t *df)
 {
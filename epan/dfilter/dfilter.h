@@ -18,6 +18,21 @@
 /* Passed back to user */
 typedef struct epan_dfilter dfilter_t;
 
+/* Limits a dfilter puts on the frame metadata of the frames it matches;
+ * see dfilter_frame_bounds(). The limits are inclusive. */
+typedef struct {
+	uint32_t	num_min;	/* frame.number */
+	uint32_t	num_max;
+	uint32_t	len_min;	/* frame.len */
+	uint32_t	len_max;
+	uint32_t	cap_len_min;	/* frame.cap_len */
+	uint32_t	cap_len_max;
+	nstime_t	time_min;	/* frame.time etc., unset if no limit */
+	nstime_t	time_max;
+	int		marked;		/* frame.marked, 0 or 1, or -1 if either */
+	int		ignored;	/* frame.ignored, 0 or 1, or -1 if either */
+} dfilter_frame_bounds_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -102,6 +117,47 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 				DF_EXPAND_MACROS|DF_OPTIMIZE, \
 				__func__)
 
+/* Like dfilter_compile_full(), but shares the compiled filter with
+ * everyone else who compiles the same text with the same flags, so that
+ * a filter that has been syntax checked, applied or used as a coloring
+ * rule once isn't compiled again. The filter is released with
+ * dfilter_free() as usual.
+ *
+ * A shared filter must not be modified, e.g. with dfilter_set_profiling(),
+ * nor applied on two threads at once. Filters with field references
+ * aren't shared, since the references are loaded into the filter.
+ */
+WS_DLL_PUBLIC
+bool
+dfilter_compile_shared(const char *text, dfilter_t **dfp,
+			df_error_t **errpp, unsigned flags,
+			const char *caller);
+
+#define dfilter_compile_cached(text, dfp, errp) \
+	dfilter_compile_shared(text, dfp, errp, \
+				DF_EXPAND_MACROS|DF_OPTIMIZE, \
+				__func__)
+
+/* Forget the filters shared by dfilter_compile_shared(). Called when
+ * the macros, the preferences or the registered fields change, since
+ * any of those can change what a filter's text means. */
+WS_DLL_PUBLIC
+void
+dfilter_cache_flush(void);
+
+/* Filters may be compiled on any thread, one at a time. Code that
+ * changes the macros or the field registry after startup holds this
+ * lock while it does so, and code that looks things up in the registry
+ * on a thread other than the main one holds it as well. It may be
+ * taken recursively. */
+WS_DLL_PUBLIC
+void
+dfilter_lock(void);
+
+WS_DLL_PUBLIC
+void
+dfilter_unlock(void);
+
 struct stnode;
 
 /** Build a syntax tree for a filter
@@ -172,6 +228,78 @@ dfilter_interested_in_field(const dfilter_t *df, int hfid);
 bool
 dfilter_interested_in_proto(const dfilter_t *df, int proto_id);
 
+/* Get the fields and protocols a dfilter looks at
+ *
+ * @param df The dfilter
+ * @param num_fields Set to the number of IDs returned
+ * @return An array of header field info IDs, owned by the dfilter
+ */
+WS_DLL_PUBLIC
+const int *
+dfilter_interesting_fields(const dfilter_t *df, int *num_fields);
+
+/* Get the protocols a frame must contain for the dfilter to match it
+ *
+ * @param df The dfilter
+ * @param num_protos Set to the number of protocol IDs returned
+ * @return An array of protocol IDs, any of which being absent from a
+ * frame's layers means the dfilter cannot match that frame, or NULL
+ * if no such protocol is known. Owned by the dfilter.
+ */
+WS_DLL_PUBLIC
+const int *
+dfilter_required_protocols(const dfilter_t *df, int *num_protos);
+
+/* Get the limits a dfilter puts on frame metadata
+ *
+ * The limits come from comparisons of frame.number, frame.len,
+ * frame.cap_len, frame.time, frame.time_utc, frame.time_epoch,
+ * frame.marked and frame.ignored with constants, and are combined through
+ * "and" and "or". A frame whose metadata is outside them can't match the
+ * dfilter, so there's no need to dissect it to find out; one inside them
+ * might still not match.
+ *
+ * @param df The dfilter
+ * @param bounds Set to the limits, if there are any
+ * @return true if the dfilter limits any frame metadata
+ */
+WS_DLL_PUBLIC
+bool
+dfilter_frame_bounds(const dfilter_t *df, dfilter_frame_bounds_t *bounds);
+
+/* Get the values a dfilter requires an unsigned integer field to have
+ *
+ * The values come from "==" and "in" comparisons of the field with
+ * constants, combined through "and" and "or". A frame in which the field
+ * has none of them, or doesn't appear, can't match the dfilter.
+ *
+ * @param df The dfilter
+ * @param hfid The field
+ * @param values Set to the values, sorted; owned by the dfilter
+ * @param num_values Set to the number of values, which may be 0 if
+ * nothing can match
+ * @return true if the dfilter limits the field's values
+ */
+WS_DLL_PUBLIC
+bool
+dfilter_field_values(const dfilter_t *df, int hfid, const uint32_t **values,
+			unsigned *num_values);
+
+/* Check whether every frame one dfilter matches is matched by another
+ *
+ * This is decided from the syntax trees alone: it's true when df is
+ * other with more terms and'ed on, or other is df with more terms or'ed
+ * on. A false result means "not known", not that df matches frames
+ * that other doesn't.
+ *
+ * @param df The dfilter, or NULL for the empty filter
+ * @param other The dfilter to compare with, or NULL for the empty filter
+ * @return true if df can only match frames that other matches
+ */
+WS_DLL_PUBLIC
+bool
+dfilter_implies(const dfilter_t *df, const dfilter_t *other);
+
 WS_DLL_PUBLIC
 bool
 dfilter_requires_columns(const dfilter_t *df);
@@ -186,6 +314,16 @@ dfilter_get_warnings(dfilter_t *df);
 
 #define DF_DUMP_REFERENCES	(1U << 0)
 #define DF_DUMP_SHOW_FTYPE	(1U << 1)
+/* Show the counters gathered since dfilter_set_profiling() */
+#define DF_DUMP_PROFILE		(1U << 2)
+
+/* Start or stop counting how often each instruction of the filter runs,
+ * the time it takes and the field values it loads. Starting discards
+ * the counters gathered so far. Profiling adds a clock read per
+ * instruction; it's meant for dftest, not for normal filtering. */
+WS_DLL_PUBLIC
+void
+dfilter_set_profiling(dfilter_t *df, bool enable);
 
 /* Print bytecode of dfilter to fp */
 WS_DLL_PUBLIC
@@ -11,9 +11,12 @@
 
 #include "dfvm.h"
 
+#include <stdlib.h>
+
 #include <tfs.h>
 #include <ftypes/ftypes.h>
 #include <wsutil/array.h>
+#include <wsutil/time_util.h>
 #include <wsutil/ws_assert.h>
 
 static void
@@ -58,6 +61,8 @@ dfvm_opcode_tostr(dfvm_opcode_t code)
 		case DFVM_SET_ADD:		return "SET_ADD";
 		case DFVM_SET_ADD_RANGE:	return "SET_ADD_RANGE";
 		case DFVM_SET_CLEAR:		return "SET_CLEAR";
+		case DFVM_ALL_IN_CONST:		return "ALL_IN_CONST";
+		case DFVM_ANY_IN_CONST:		return "ANY_IN_CONST";
 		case DFVM_SLICE:		return "SLICE";
 		case DFVM_LENGTH:		return "LENGTH";
 		case DFVM_BITWISE_AND:		return "BITWISE_AND";
@@ -89,6 +94,14 @@ dfvm_value_free(dfvm_value_t *v)
 		case PCRE:
 			ws_regex_free(v->value.pcre);
 			break;
+		case CONST_SET:
+			if (v->value.const_set->hashed)
+				g_hash_table_destroy(v->value.const_set->hashed);
+			g_ptr_array_unref(v->value.const_set->fvalues);
+			g_free(v->value.const_set->lows);
+			g_free(v->value.const_set->highs);
+			g_free(v->value.const_set);
+			break;
 		case EMPTY:
 		case HFINFO:
 		case RAW_HFINFO:
@@ -243,6 +256,176 @@ dfvm_value_new_uint(unsigned num)
 	return v;
 }
 
+/* Types whose values compare equal only if they're identical, so they
+ * can be hashed. */
+static bool
+const_set_hashable(ftenum_t ftype)
+{
+	switch (ftype) {
+		case FT_STRING:
+		case FT_STRINGZ:
+		case FT_STRINGZPAD:
+		case FT_STRINGZTRUNC:
+		case FT_UINT_STRING:
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+		case FT_ETHER:
+		case FT_EUI64:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static bool
+const_set_keyed(ftenum_t ftype)
+{
+	return FT_IS_INTEGER(ftype) || ftype == FT_IPv4;
+}
+
+/* Get the interval of keys a value matches. Signed integers are biased
+ * so that the keys sort in the same order as the values. */
+static bool
+const_set_key(const fvalue_t *fv, uint64_t *low, uint64_t *high)
+{
+	ftenum_t ftype = fvalue_type_ftenum(fv);
+	const ipv4_addr_and_mask *ipv4;
+	int64_t	val;
+
+	if (FT_IS_INT(ftype)) {
+		if (fvalue_to_sinteger64(fv, &val) != FT_OK)
+			return false;
+		*low = *high = (uint64_t)val ^ (UINT64_C(1) << 63);
+		return true;
+	}
+	if (FT_IS_UINT(ftype)) {
+		if (fvalue_to_uinteger64(fv, low) != FT_OK)
+			return false;
+		*high = *low;
+		return true;
+	}
+	if (ftype == FT_IPv4) {
+		/* A CIDR block matches all the addresses in it. */
+		ipv4 = fvalue_get_ipv4((fvalue_t *)fv);
+		*low = ipv4->addr & ipv4->nmask;
+		*high = *low | (~ipv4->nmask & UINT32_MAX);
+		return true;
+	}
+	return false;
+}
+
+bool
+dfvm_const_set_supports(ftenum_t ftype, bool ranges)
+{
+	if (const_set_keyed(ftype))
+		return true;
+	return !ranges && const_set_hashable(ftype);
+}
+
+static unsigned
+const_set_hash(const void *key)
+{
+	return fvalue_hash(key);
+}
+
+static gboolean
+const_set_equal(const void *a, const void *b)
+{
+	return fvalue_equal(a, b);
+}
+
+typedef struct {
+	uint64_t low;
+	uint64_t high;
+} const_set_interval_t;
+
+static int
+compare_const_set_intervals(const void *a, const void *b)
+{
+	const const_set_interval_t *ia = a;
+	const const_set_interval_t *ib = b;
+
+	return (ia->low > ib->low) - (ia->low < ib->low);
+}
+
+dfvm_value_t*
+dfvm_value_new_const_set(ftenum_t ftype, GPtrArray *fvalues)
+{
+	dfvm_value_t *v = dfvm_value_new(CONST_SET);
+	dfvm_const_set_t *set = g_new0(dfvm_const_set_t, 1);
+	const_set_interval_t *intervals;
+	uint64_t low, high, unused;
+	unsigned n = 0;
+
+	ws_assert(fvalues->len % 2 == 0);
+	set->ftype = ftype;
+	set->fvalues = fvalues;
+	v->value.const_set = set;
+
+	if (!const_set_keyed(ftype)) {
+		set->hashed = g_hash_table_new(const_set_hash, const_set_equal);
+		for (unsigned i = 0; i < fvalues->len; i += 2) {
+			ws_assert(fvalues->pdata[i + 1] == NULL);
+			g_hash_table_add(set->hashed, fvalues->pdata[i]);
+		}
+		return v;
+	}
+
+	intervals = g_new(const_set_interval_t, fvalues->len / 2);
+	for (unsigned i = 0; i < fvalues->len; i += 2) {
+		if (!const_set_key(fvalues->pdata[i], &low, &high))
+			continue;
+		if (fvalues->pdata[i + 1] != NULL &&
+				!const_set_key(fvalues->pdata[i + 1], &unused, &high))
+			continue;
+		if (low > high)
+			continue;
+		intervals[n].low = low;
+		intervals[n].high = high;
+		n++;
+	}
+
+	/* Sort and merge overlapping intervals, so that at most one can
+	 * contain any key. */
+	qsort(intervals, n, sizeof(const_set_interval_t), compare_const_set_intervals);
+	set->lows = g_new(uint64_t, n);
+	set->highs = g_new(uint64_t, n);
+	for (unsigned i = 0; i < n; i++) {
+		if (set->len > 0 && intervals[i].low <= set->highs[set->len - 1]) {
+			if (intervals[i].high > set->highs[set->len - 1])
+				set->highs[set->len - 1] = intervals[i].high;
+			continue;
+		}
+		set->lows[set->len] = intervals[i].low;
+		set->highs[set->len] = intervals[i].high;
+		set->len++;
+	}
+	g_free(intervals);
+	return v;
+}
+
+static char *
+const_set_tostr(const dfvm_const_set_t *set)
+{
+	wmem_strbuf_t *buf = wmem_strbuf_new(NULL, "{");
+	char *s;
+
+	for (unsigned i = 0; i < set->fvalues->len; i += 2) {
+		if (i != 0)
+			wmem_strbuf_append_c(buf, ' ');
+		s = fvalue_to_debug_repr(NULL, set->fvalues->pdata[i]);
+		wmem_strbuf_append(buf, s);
+		g_free(s);
+		if (set->fvalues->pdata[i + 1] != NULL) {
+			s = fvalue_to_debug_repr(NULL, set->fvalues->pdata[i + 1]);
+			wmem_strbuf_append_printf(buf, "..%s", s);
+			g_free(s);
+		}
+	}
+	wmem_strbuf_append_c(buf, '}');
+	return wmem_strbuf_finalize(buf);
+}
+
 static char *
 dfvm_value_tostr(dfvm_value_t *v)
 {
@@ -270,6 +453,9 @@ dfvm_value_tostr(dfvm_value_t *v)
 		case PCRE:
 			s = ws_strdup(ws_regex_pattern(v->value.pcre));
 			break;
+		case CONST_SET:
+			s = const_set_tostr(v->value.const_set);
+			break;
 		case REGISTER:
 			s = ws_strdup_printf("R%"PRIu32, v->value.numeric);
 			break;
@@ -310,6 +496,9 @@ value_type_tostr(dfvm_value_t *v, bool show_ftype)
 		case FVALUE:
 			s = fvalue_type_name(dfvm_value_get_fvalue(v));
 			break;
+		case CONST_SET:
+			s = ftype_name(v->value.const_set->ftype);
+			break;
 		case FUNCTION_DEF:
 			if (v->value.funcdef->return_ftype != FT_NONE)
 				s = ftype_name(v->value.funcdef->return_ftype);
@@ -560,6 +749,12 @@ append_op_args(wmem_strbuf_t *buf, dfvm_insn_t *insn, GSList **stack_print,
 			wmem_strbuf_append_printf(buf, "%s%s", arg1_str, arg1_str_type);
 			break;
 
+		case DFVM_ALL_IN_CONST:
+		case DFVM_ANY_IN_CONST:
+			wmem_strbuf_append_printf(buf, "%s%s in %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
 		case DFVM_SET_ADD_RANGE:
 			wmem_strbuf_append_printf(buf, "%s%s .. %s%s",
 						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
@@ -704,6 +899,19 @@ dfvm_dump_str(wmem_allocator_t *alloc, dfilter_t *df, uint16_t flags)
 		wmem_strbuf_append_c(buf, '\n');
 	}
 
+	if ((flags & DF_DUMP_PROFILE) && df->profile) {
+		uint64_t total_ns = 0;
+
+		for (id = 0; id < (int)df->insns->len; id++) {
+			total_ns += df->profile[id].elapsed_ns;
+		}
+		wmem_strbuf_append_printf(buf,
+				"Profile: %"PRIu64" runs, %"PRIu64" matched, %.3f ms\n"
+				"(each instruction is followed by its executions, microseconds "
+				"and, for reads, field values loaded)\n\n",
+				df->profile_runs, df->profile_matched, total_ns / 1e6);
+	}
+
 	wmem_strbuf_append(buf, "Instructions:");
 
 	length = df->insns->len;
@@ -723,6 +931,24 @@ dfvm_dump_str(wmem_allocator_t *alloc, dfilter_t *df, uint16_t flags)
 				append_op_args(buf, insn, &stack_print, flags);
 				break;
 		}
+
+		if ((flags & DF_DUMP_PROFILE) && df->profile) {
+			df_insn_profile_t *prof = &df->profile[id];
+
+			indent(buf, 64, col_start);
+			wmem_strbuf_append_printf(buf, " | %10"PRIu64" %12.3f",
+					prof->executed, prof->elapsed_ns / 1e3);
+			switch (insn->op) {
+				case DFVM_READ_TREE:
+				case DFVM_READ_TREE_R:
+				case DFVM_READ_REFERENCE:
+				case DFVM_READ_REFERENCE_R:
+					wmem_strbuf_append_printf(buf, " %10"PRIu64, prof->values);
+					break;
+				default:
+					break;
+			}
+		}
 	}
 
 	if (flags & DF_DUMP_SHOW_FTYPE) {
@@ -1052,6 +1278,22 @@ cmp_test_internal(enum match_how how, DFVMCompareFunc match_func,
 	bool want_any = (how == MATCH_ANY);
 	ft_bool_t have_match;
 
+	if (fv2->len == 1) {
+		/* The usual case of comparing against a single constant. */
+		const fvalue_t *val2 = fv2->pdata[0];
+
+		for (size_t idx1 = 0; idx1 < fv1->len; idx1++) {
+			have_match = match_func(fv1->pdata[idx1], val2);
+			if (want_all && have_match == FT_FALSE) {
+				return false;
+			}
+			else if (want_any && have_match == FT_TRUE) {
+				return true;
+			}
+		}
+		return want_all;
+	}
+
 	for (size_t idx1 = 0; idx1 < fv1->len; idx1++) {
 		for (size_t idx2 = 0; idx2 < fv2->len; idx2++) {
 			have_match = match_func(fv1->pdata[idx1], fv2->pdata[idx2]);
@@ -1257,6 +1499,67 @@ all_in(dfilter_t *df, dfvm_value_t *arg1)
 	return true;
 }
 
+static bool
+const_set_contains(const dfvm_const_set_t *set, const fvalue_t *fv)
+{
+	const fvalue_t *low, *high;
+	uint64_t key, key_high;
+	unsigned lo, hi, mid;
+
+	if (fvalue_type_ftenum(fv) == set->ftype) {
+		if (set->hashed) {
+			return g_hash_table_contains(set->hashed, fv);
+		}
+		if (const_set_key(fv, &key, &key_high) && key == key_high) {
+			/* Find the last interval starting at or below the key. */
+			lo = 0;
+			hi = set->len;
+			while (lo < hi) {
+				mid = lo + (hi - lo) / 2;
+				if (set->lows[mid] <= key)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			return lo > 0 && key <= set->highs[lo - 1];
+		}
+	}
+
+	/* Fields sharing a name can differ in type, and a field's IPv4
+	 * address may itself have a netmask; compare those one by one. */
+	for (unsigned i = 0; i < set->fvalues->len; i += 2) {
+		low = set->fvalues->pdata[i];
+		high = set->fvalues->pdata[i + 1];
+		if (high == NULL) {
+			if (fvalue_eq(fv, low) == FT_TRUE)
+				return true;
+		}
+		else if (fvalue_ge(fv, low) == FT_TRUE && fvalue_le(fv, high) == FT_TRUE) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Is any (or every) value in the register in the set of constants? */
+static bool
+in_const(dfilter_t *df, bool want_all, dfvm_value_t *arg1, dfvm_value_t *arg2)
+{
+	df_cell_t *rp = &df->registers[arg1->value.numeric];
+	const dfvm_const_set_t *set = arg2->value.const_set;
+	GPtrArray *value;
+
+	/* If the read failed we jump over the membership test. */
+	ws_assert(!df_cell_is_empty(rp));
+	value = df_cell_ptr(rp);
+
+	for (size_t i = 0; i < value->len; i++) {
+		if (const_set_contains(set, value->pdata[i]) != want_all)
+			return !want_all;
+	}
+	return want_all;
+}
+
 /* Clear registers that were populated during evaluation.
  * If we created the values, then these will be freed as well. */
 static void
@@ -1587,6 +1890,20 @@ check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
 	return false;
 }
 
+/* Charges the time since the previous instruction started to it, and
+ * counts the next one, if any. Returns the time now. */
+static uint64_t
+profile_step(dfilter_t *df, int prev_id, uint64_t prev_start, int id)
+{
+	uint64_t now = ws_monotonic_ns();
+
+	if (prev_id >= 0)
+		df->profile[prev_id].elapsed_ns += now - prev_start;
+	if (id >= 0)
+		df->profile[id].executed++;
+	return now;
+}
+
 bool
 dfvm_apply_full(dfilter_t *df, proto_tree *tree, GPtrArray **fvals)
 {
@@ -1596,6 +1913,8 @@ dfvm_apply_full(dfilter_t *df, proto_tree *tree, GPtrArray **fvals)
 	dfvm_value_t	*arg1;
 	dfvm_value_t	*arg2;
 	dfvm_value_t	*arg3 = NULL;
+	int		prof_id = -1;
+	uint64_t	prof_start = 0;
 
 	ws_assert(tree);
 
@@ -1604,6 +1923,10 @@ dfvm_apply_full(dfilter_t *df, proto_tree *tree, GPtrArray **fvals)
 	for (id = 0; id < length; id++) {
 
 	  AGAIN:
+		if (df->profile) {
+			prof_start = profile_step(df, prof_id, prof_start, id);
+			prof_id = id;
+		}
 		insn = g_ptr_array_index(df->insns, id);
 		arg1 = insn->arg1;
 		arg2 = insn->arg2;
@@ -1620,18 +1943,26 @@ dfvm_apply_full(dfilter_t *df, proto_tree *tree, GPtrArray **fvals)
 
 			case DFVM_READ_TREE:
 				accum = read_tree(df, tree, arg1, arg2, NULL);
+				if (df->profile)
+					df->profile[id].values += df_cell_size(&df->registers[arg2->value.numeric]);
 				break;
 
 			case DFVM_READ_TREE_R:
 				accum = read_tree(df, tree, arg1, arg2, arg3);
+				if (df->profile)
+					df->profile[id].values += df_cell_size(&df->registers[arg2->value.numeric]);
 				break;
 
 			case DFVM_READ_REFERENCE:
 				accum = read_reference(df, arg1, arg2, NULL);
+				if (df->profile)
+					df->profile[id].values += df_cell_size(&df->registers[arg2->value.numeric]);
 				break;
 
 			case DFVM_READ_REFERENCE_R:
 				accum = read_reference(df, arg1, arg2, arg3);
+				if (df->profile)
+					df->profile[id].values += df_cell_size(&df->registers[arg2->value.numeric]);
 				break;
 
 			case DFVM_PUT_FVALUE:
@@ -1778,6 +2109,14 @@ dfvm_apply_full(dfilter_t *df, proto_tree *tree, GPtrArray **fvals)
 				set_clear(df);
 				break;
 
+			case DFVM_ALL_IN_CONST:
+				accum = in_const(df, true, arg1, arg2);
+				break;
+
+			case DFVM_ANY_IN_CONST:
+				accum = in_const(df, false, arg1, arg2);
+				break;
+
 			case DFVM_UNARY_MINUS:
 				mk_minus(df, arg1, arg2);
 				break;
@@ -1794,6 +2133,12 @@ dfvm_apply_full(dfilter_t *df, proto_tree *tree, GPtrArray **fvals)
 					}
 				}
 				free_register_overhead(df);
+				if (df->profile) {
+					profile_step(df, prof_id, prof_start, -1);
+					df->profile_runs++;
+					if (accum)
+						df->profile_matched++;
+				}
 				return accum;
 
 			case DFVM_NO_OP:
@@ -31,8 +31,27 @@ typedef enum {
 	DRANGE,
 	FUNCTION_DEF,
 	PCRE,
+	CONST_SET,
 } dfvm_value_type_t;
 
+/**
+ * @brief A set of constants, for testing membership without comparing
+ * against each constant in turn.
+ *
+ * Integers and IPv4 addresses are kept as sorted, disjoint intervals of
+ * keys (a CIDR block being an interval of addresses) and looked up by
+ * binary search. Other types that compare for exact equality are kept
+ * in a hash table.
+ */
+typedef struct {
+	ftenum_t ftype;        /**< Type of the constants. */
+	unsigned len;          /**< Number of intervals. */
+	uint64_t *lows;        /**< Lower bound of each interval. */
+	uint64_t *highs;       /**< Upper bound of each interval. */
+	GHashTable *hashed;    /**< The constants, if not kept as intervals. */
+	GPtrArray *fvalues;    /**< The elements as written, in pairs of lower bound and upper bound or NULL. */
+} dfvm_const_set_t;
+
 /**
  * @brief Represents a typed value used in display filter virtual machine (DFVM) operations.
  *
@@ -50,6 +69,7 @@ typedef struct {
 		header_field_info *hfinfo;     /**< Pointer to header field metadata. */
 		df_func_def_t *funcdef;        /**< Pointer to a display filter function definition. */
 		ws_regex_t *pcre;              /**< Pointer to a compiled regular expression. */
+		dfvm_const_set_t *const_set;   /**< Pointer to a set of constants. */
 	} value;
 
 	int ref_count; /**< Reference count for memory management. */
@@ -93,6 +113,8 @@ typedef enum {
 	DFVM_SET_ADD,
 	DFVM_SET_ADD_RANGE,
 	DFVM_SET_CLEAR,
+	DFVM_ALL_IN_CONST,
+	DFVM_ANY_IN_CONST,
 	DFVM_SLICE,
 	DFVM_LENGTH,
 	DFVM_BITWISE_AND,
@@ -159,6 +181,16 @@ dfvm_value_new_pcre(ws_regex_t *re);
 dfvm_value_t*
 dfvm_value_new_uint(unsigned num);
 
+/* Can constants of type ftype (and ranges of them, if ranges is true) be
+ * put in a constant set? */
+bool
+dfvm_const_set_supports(ftenum_t ftype, bool ranges);
+
+/* Takes ownership of the array of fvalues, which holds pairs of a lower
+ * bound and an upper bound or NULL, all of type ftype. */
+dfvm_value_t*
+dfvm_value_new_const_set(ftenum_t ftype, GPtrArray *fvalues);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df, uint16_t flags);
 
@@ -444,8 +444,72 @@ fixup_jumps(void *data, void *user_data)
 	}
 }
 
+static void
+gen_const_set(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg, GPtrArray *fvalues)
+{
+	GSList		*jumps = NULL;
+	dfvm_value_t	*val1, *val2;
+
+	val1 = gen_entity(dfw, st_arg, &jumps);
+	val2 = dfvm_value_new_const_set(fvalue_type_ftenum(fvalues->pdata[0]), fvalues);
+	switch (op) {
+		case DFVM_SET_ALL_IN:
+		case DFVM_SET_ALL_NOT_IN:
+			gen_relation_insn(dfw, DFVM_ALL_IN_CONST, val1, val2, NULL);
+			break;
+		default:
+			gen_relation_insn(dfw, DFVM_ANY_IN_CONST, val1, val2, NULL);
+			break;
+	}
+	if (op == DFVM_SET_ALL_NOT_IN || op == DFVM_SET_ANY_NOT_IN)
+		dfw_append_insn(dfw, dfvm_insn_new(DFVM_NOT));
+
+	/* Jump here if the field was not present */
+	g_slist_foreach(jumps, fixup_jumps, dfw);
+	g_slist_free(jumps);
+}
+
+/* If every element of the set is a constant that can go in a constant
+ * set, return the elements as pairs of lower bound and upper bound or
+ * NULL, taking them from the set. */
+static GPtrArray *
+const_set_elements(GSList *nodelist)
+{
+	GPtrArray	*fvalues;
+	GSList		*l;
+	stnode_t	*node;
+	ftenum_t	ftype = FT_NONE;
+	bool		ranges = false;
+	bool		upper = false;
+
+	for (l = nodelist; l != NULL; l = g_slist_next(l), upper = !upper) {
+		node = l->data;
+		if (node == NULL)
+			continue;
+		if (stnode_type_id(node) != STTYPE_FVALUE)
+			return NULL;
+		if (ftype == FT_NONE)
+			ftype = fvalue_type_ftenum(stnode_data(node));
+		else if (fvalue_type_ftenum(stnode_data(node)) != ftype)
+			return NULL;
+		if (upper)
+			ranges = true;
+	}
+	if (ftype == FT_NONE || !dfvm_const_set_supports(ftype, ranges))
+		return NULL;
+
+	fvalues = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
+	for (l = nodelist; l != NULL; l = g_slist_next(l)) {
+		node = l->data;
+		g_ptr_array_add(fvalues, node ? stnode_steal_data(node) : NULL);
+	}
+	return fvalues;
+}
+
 /* Generate the code for the in operator. Pushes set values into a stack
- * and then evaluates membership in a single instruction. */
+ * and then evaluates membership in a single instruction. If the set only
+ * holds constants, they're put in a constant set instead, so the
+ * membership test doesn't have to compare with each in turn. */
 static void
 gen_relation_in(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
 				stnode_t *st_arg1, stnode_t *st_arg2)
@@ -457,11 +521,20 @@ gen_relation_in(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
 	stnode_t	*node1, *node2;
 	GSList		*nodelist_head, *nodelist;
 
+	nodelist_head = nodelist = stnode_steal_data(st_arg2);
+	if (dfw->flags & DF_OPTIMIZE) {
+		GPtrArray *fvalues = const_set_elements(nodelist_head);
+		if (fvalues != NULL) {
+			set_nodelist_free(nodelist_head);
+			gen_const_set(dfw, select_opcode(op, how), st_arg1, fvalues);
+			return;
+		}
+	}
+
 	/* Create code for the LHS of the relation */
 	val1 = gen_entity(dfw, st_arg1, &jumps);
 
 	/* Create code to populate the set stack */
-	nodelist_head = nodelist = stnode_steal_data(st_arg2);
 	while (nodelist) {
 		node1 = nodelist->data;
 		nodelist = g_slist_next(nodelist);
@@ -705,6 +778,182 @@ gen_notzero_slice(dfwork_t *dfw, stnode_t *st_node)
 	return val1;
 }
 
+/* An operand of a chain of "and" or "or" tests. */
+typedef struct {
+	stnode_t	*node;
+	/* If the operand compares a field with a constant, the field and
+	 * the constants (together with those of any later operands
+	 * comparing the same field) to test it against, as set elements. */
+	stnode_t	*field;
+	GPtrArray	*fvalues;
+} chain_operand_t;
+
+/* Collect the operands of the chain of "op" tests rooted at st_node. */
+static void
+// NOLINTNEXTLINE(misc-no-recursion)
+chain_operands(stnode_t *st_node, stnode_op_t op, GPtrArray *operands)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) == STTYPE_TEST) {
+		sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+		if (st_op == op) {
+			chain_operands(st_arg1, op, operands);
+			chain_operands(st_arg2, op, operands);
+			return;
+		}
+	}
+	g_ptr_array_add(operands, st_node);
+}
+
+/* If st_node is "field == constant", and the constant can go in a
+ * constant set, return the field and the constant. */
+static stnode_t *
+const_set_candidate(stnode_t *st_node, fvalue_t **fv_ptr)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return NULL;
+	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+	if (st_op != STNODE_OP_ANY_EQ || sttype_test_get_match(st_node) == STNODE_MATCH_ALL)
+		return NULL;
+	if (stnode_type_id(st_arg1) != STTYPE_FIELD || stnode_type_id(st_arg2) != STTYPE_FVALUE)
+		return NULL;
+	if (!dfvm_const_set_supports(fvalue_type_ftenum(stnode_data(st_arg2)), false))
+		return NULL;
+	*fv_ptr = stnode_data(st_arg2);
+	return st_arg1;
+}
+
+/*
+ * Find the operands of a chain of "and" or "or" tests, dropping any that
+ * repeat an earlier one (as expanded macros often do). In an "or" chain,
+ * comparisons of the same field with constants are merged into one
+ * membership test against the set of constants:
+ *
+ *   tcp.port == 80 || udp.port == 53 || tcp.port == 443
+ *
+ * is evaluated as
+ *
+ *   tcp.port in {80 443} || udp.port == 53
+ *
+ * Neither changes the result; display filter tests have no side effects,
+ * so their order doesn't matter.
+ */
+static GArray *
+optimize_chain(GPtrArray *nodes, stnode_op_t op)
+{
+	GArray		*operands;
+	GHashTable	*seen, *fields;
+	chain_operand_t	operand, *group;
+	unsigned	group_idx;
+	stnode_t	*field;
+	fvalue_t	*fv;
+	char		*str;
+
+	operands = g_array_sized_new(false, false, sizeof(chain_operand_t), nodes->len);
+	seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	fields = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	for (unsigned i = 0; i < nodes->len; i++) {
+		operand.node = nodes->pdata[i];
+		operand.field = NULL;
+		operand.fvalues = NULL;
+
+		str = dump_syntax_tree_str(operand.node);
+		if (g_hash_table_contains(seen, str)) {
+			g_free(str);
+			continue;
+		}
+		g_hash_table_add(seen, str);
+
+		field = op == STNODE_OP_OR ? const_set_candidate(operand.node, &fv) : NULL;
+		if (field != NULL) {
+			str = dump_syntax_tree_str(field);
+			/* Stored as index + 1, the array may grow. */
+			group_idx = GPOINTER_TO_UINT(g_hash_table_lookup(fields, str));
+			group = group_idx ? &g_array_index(operands, chain_operand_t, group_idx - 1) : NULL;
+			if (group != NULL && fvalue_type_ftenum(group->fvalues->pdata[0]) == fvalue_type_ftenum(fv)) {
+				g_ptr_array_add(group->fvalues, fvalue_dup(fv));
+				g_ptr_array_add(group->fvalues, NULL);
+				g_free(str);
+				continue;
+			}
+			operand.field = field;
+			operand.fvalues = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
+			g_ptr_array_add(operand.fvalues, fvalue_dup(fv));
+			g_ptr_array_add(operand.fvalues, NULL);
+			if (group == NULL) {
+				g_hash_table_insert(fields, str, GUINT_TO_POINTER(operands->len + 1));
+			}
+			else {
+				g_free(str);
+			}
+		}
+		g_array_append_val(operands, operand);
+	}
+
+	g_hash_table_destroy(fields);
+	g_hash_table_destroy(seen);
+	return operands;
+}
+
+static void
+gen_chain(dfwork_t *dfw, stnode_t *st_node, stnode_op_t op)
+{
+	GPtrArray	*nodes, *exits;
+	GArray		*operands;
+	chain_operand_t	*operand;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*jmp;
+
+	nodes = g_ptr_array_new();
+	chain_operands(st_node, op, nodes);
+	if (dfw->flags & DF_OPTIMIZE) {
+		operands = optimize_chain(nodes, op);
+	}
+	else {
+		operands = g_array_sized_new(false, true, sizeof(chain_operand_t), nodes->len);
+		for (unsigned i = 0; i < nodes->len; i++) {
+			chain_operand_t plain = { nodes->pdata[i], NULL, NULL };
+			g_array_append_val(operands, plain);
+		}
+	}
+	g_ptr_array_free(nodes, true);
+
+	/* Each operand but the last exits the chain once its result is
+	 * known to be the chain's. */
+	exits = g_ptr_array_new();
+	for (unsigned i = 0; i < operands->len; i++) {
+		operand = &g_array_index(operands, chain_operand_t, i);
+		if (operand->fvalues != NULL && operand->fvalues->len > 2) {
+			gen_const_set(dfw, DFVM_SET_ANY_IN, operand->field, operand->fvalues);
+		}
+		else {
+			if (operand->fvalues != NULL)
+				g_ptr_array_unref(operand->fvalues);
+			gencode(dfw, operand->node);
+		}
+
+		if (i + 1 < operands->len) {
+			insn = dfvm_insn_new(op == STNODE_OP_AND ? DFVM_IF_FALSE_GOTO : DFVM_IF_TRUE_GOTO);
+			jmp = dfvm_value_new(INSN_NUMBER);
+			insn->arg1 = dfvm_value_ref(jmp);
+			dfw_append_insn(dfw, insn);
+			g_ptr_array_add(exits, jmp);
+		}
+	}
+	for (unsigned i = 0; i < exits->len; i++) {
+		jmp = exits->pdata[i];
+		jmp->value.numeric = dfw->next_insn_id;
+	}
+	g_ptr_array_free(exits, true);
+	g_array_free(operands, true);
+}
+
 static void
 gen_test(dfwork_t *dfw, stnode_t *st_node)
 {
@@ -712,7 +961,6 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 	stmatch_t	st_how;
 	stnode_t	*st_arg1, *st_arg2;
 	dfvm_insn_t	*insn;
-	dfvm_value_t	*jmp;
 
 
 	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
@@ -726,27 +974,8 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case STNODE_OP_AND:
-			gencode(dfw, st_arg1);
-
-			insn = dfvm_insn_new(DFVM_IF_FALSE_GOTO);
-			jmp = dfvm_value_new(INSN_NUMBER);
-			insn->arg1 = dfvm_value_ref(jmp);
-			dfw_append_insn(dfw, insn);
-
-			gencode(dfw, st_arg2);
-			jmp->value.numeric = dfw->next_insn_id;
-			break;
-
 		case STNODE_OP_OR:
-			gencode(dfw, st_arg1);
-
-			insn = dfvm_insn_new(DFVM_IF_TRUE_GOTO);
-			jmp = dfvm_value_new(INSN_NUMBER);
-			insn->arg1 = dfvm_value_ref(jmp);
-			dfw_append_insn(dfw, insn);
-
-			gencode(dfw, st_arg2);
-			jmp->value.numeric = dfw->next_insn_id;
+			gen_chain(dfw, st_node, st_op);
 			break;
 
 		case STNODE_OP_ALL_EQ:
@@ -897,6 +1126,55 @@ optimize(dfwork_t *dfw)
 	}
 }
 
+/* Remove the no-op instructions left behind by optimize(), so that the
+ * interpreter doesn't have to dispatch them on every run, and renumber
+ * the jump targets to match. */
+static void
+remove_no_ops(dfwork_t *dfw)
+{
+	unsigned	id, new_id;
+	unsigned	*new_ids;
+	dfvm_insn_t	*insn;
+	GHashTable	*fixed;
+
+	new_ids = g_new(unsigned, dfw->insns->len + 1);
+	for (id = 0, new_id = 0; id < dfw->insns->len; id++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+		/* A jump to a no-op goes to the next real instruction. */
+		new_ids[id] = new_id;
+		if (insn->op != DFVM_NO_OP)
+			new_id++;
+	}
+	new_ids[id] = new_id;
+	if (new_id == dfw->insns->len) {
+		g_free(new_ids);
+		return;
+	}
+
+	/* Jump targets could in principle share a value; only fix each once. */
+	fixed = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (id = 0, new_id = 0; id < dfw->insns->len; id++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+		if (insn->op == DFVM_NO_OP) {
+			dfvm_insn_free(insn);
+			continue;
+		}
+		if ((insn->op == DFVM_IF_TRUE_GOTO || insn->op == DFVM_IF_FALSE_GOTO) &&
+				!g_hash_table_contains(fixed, insn->arg1)) {
+			insn->arg1->value.numeric = new_ids[insn->arg1->value.numeric];
+			g_hash_table_add(fixed, insn->arg1);
+		}
+		insn->id = new_id;
+		g_ptr_array_index(dfw->insns, new_id) = insn;
+		new_id++;
+	}
+	g_ptr_array_set_size(dfw->insns, new_id);
+	dfw->next_insn_id = (int)new_id;
+
+	g_hash_table_destroy(fixed);
+	g_free(new_ids);
+}
+
 void
 dfw_gencode(dfwork_t *dfw)
 {
@@ -910,6 +1188,7 @@ dfw_gencode(dfwork_t *dfw)
 	dfw_append_insn(dfw, insn);
 	if (dfw->flags & DF_OPTIMIZE) {
 		optimize(dfw);
+		remove_no_ops(dfw);
 	}
 }
 
@@ -949,6 +1228,715 @@ dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields)
 	return hki.fields;
 }
 
+/* Returns the protocol a field must come from for the field to be present,
+ * or -1 if we can't say. Internal pseudo-protocols and protocols in name
+ * only never show up in the frame's layers, so they tell us nothing. */
+static int
+field_required_proto(const header_field_info *hfinfo)
+{
+	int proto_id;
+	protocol_t *protocol;
+
+	if (hfinfo == NULL)
+		return -1;
+	proto_id = (hfinfo->parent == -1) ? hfinfo->id : hfinfo->parent;
+	protocol = find_protocol_by_id(proto_id);
+	if (protocol == NULL || proto_is_pino(protocol))
+		return -1;
+	if (g_str_has_prefix(proto_get_protocol_filter_name(proto_id), "_ws."))
+		return -1;
+	return proto_id;
+}
+
+static GHashTable *
+entity_required_protos(stnode_t *st_arg)
+{
+	GHashTable *protos;
+	int proto_id;
+
+	switch (stnode_type_id(st_arg)) {
+		case STTYPE_FIELD:
+			proto_id = field_required_proto(sttype_field_hfinfo(st_arg));
+			break;
+		case STTYPE_SLICE:
+			return entity_required_protos(sttype_slice_entity(st_arg));
+		default:
+			/* Functions, literals, references etc. can match
+			 * without any field being present. */
+			return NULL;
+	}
+	if (proto_id < 0)
+		return NULL;
+	protos = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_hash_table_add(protos, GINT_TO_POINTER(proto_id));
+	return protos;
+}
+
+static GHashTable *
+protos_union(GHashTable *a, GHashTable *b)
+{
+	GHashTableIter iter;
+	void *key;
+
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	g_hash_table_iter_init(&iter, b);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		g_hash_table_add(a, key);
+	g_hash_table_destroy(b);
+	return a;
+}
+
+static GHashTable *
+protos_intersection(GHashTable *a, GHashTable *b)
+{
+	GHashTableIter iter;
+	void *key;
+
+	if (a == NULL || b == NULL) {
+		if (a)
+			g_hash_table_destroy(a);
+		if (b)
+			g_hash_table_destroy(b);
+		return NULL;
+	}
+	g_hash_table_iter_init(&iter, a);
+	while (g_hash_table_iter_next(&iter, &key, NULL)) {
+		if (!g_hash_table_contains(b, key))
+			g_hash_table_iter_remove(&iter);
+	}
+	g_hash_table_destroy(b);
+	if (g_hash_table_size(a) == 0) {
+		g_hash_table_destroy(a);
+		return NULL;
+	}
+	return a;
+}
+
+/* Every protocol in the returned set must be present in a frame for
+ * the expression to be true; NULL means no such protocol is known. */
+static GHashTable *
+node_required_protos(stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (st_node == NULL)
+		return NULL;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return entity_required_protos(st_node);
+
+	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+	switch (st_op) {
+		case STNODE_OP_AND:
+			return protos_union(node_required_protos(st_arg1),
+						node_required_protos(st_arg2));
+		case STNODE_OP_OR:
+			return protos_intersection(node_required_protos(st_arg1),
+						node_required_protos(st_arg2));
+		case STNODE_OP_ALL_EQ:
+		case STNODE_OP_ANY_EQ:
+		case STNODE_OP_ALL_NE:
+		case STNODE_OP_ANY_NE:
+		case STNODE_OP_GT:
+		case STNODE_OP_GE:
+		case STNODE_OP_LT:
+		case STNODE_OP_LE:
+		case STNODE_OP_CONTAINS:
+		case STNODE_OP_MATCHES:
+		case STNODE_OP_IN:
+		case STNODE_OP_NOT_IN:
+			/* A relation is false if a field operand is missing. */
+			return protos_union(entity_required_protos(st_arg1),
+					st_arg2 ? entity_required_protos(st_arg2) : NULL);
+		default:
+			/* "not" can be true when nothing is present. */
+			return NULL;
+	}
+}
+
+int*
+dfw_required_protocols(dfwork_t *dfw, int *caller_num_protos)
+{
+	GHashTable *protos;
+	GHashTableIter iter;
+	void *key;
+	int *proto_ids;
+	int i = 0;
+
+	*caller_num_protos = 0;
+	protos = node_required_protos(dfw->st_root);
+	if (protos == NULL)
+		return NULL;
+
+	proto_ids = g_new(int, g_hash_table_size(protos));
+	g_hash_table_iter_init(&iter, protos);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		proto_ids[i++] = GPOINTER_TO_INT(key);
+	g_hash_table_destroy(protos);
+
+	*caller_num_protos = i;
+	return proto_ids;
+}
+
+/* The frame metadata a field shows, for dfw_frame_bounds(). */
+typedef enum {
+	FRAME_FIELD_NONE,
+	FRAME_FIELD_NUMBER,
+	FRAME_FIELD_LEN,
+	FRAME_FIELD_CAP_LEN,
+	FRAME_FIELD_TIME,
+	FRAME_FIELD_MARKED,
+	FRAME_FIELD_IGNORED
+} frame_field_t;
+
+static frame_field_t
+frame_field(stnode_t *st_arg)
+{
+	header_field_info *hfinfo;
+
+	if (stnode_type_id(st_arg) != STTYPE_FIELD)
+		return FRAME_FIELD_NONE;
+	hfinfo = sttype_field_hfinfo(st_arg);
+	/* Another field with the same name could hold other values. */
+	if (hfinfo->same_name_prev_id != -1 || hfinfo->same_name_next != NULL)
+		return FRAME_FIELD_NONE;
+	if (sttype_field_drange(st_arg) != NULL || sttype_field_raw(st_arg) ||
+			sttype_field_value_string(st_arg))
+		return FRAME_FIELD_NONE;
+
+	if (strcmp(hfinfo->abbrev, "frame.number") == 0)
+		return FRAME_FIELD_NUMBER;
+	if (strcmp(hfinfo->abbrev, "frame.len") == 0)
+		return FRAME_FIELD_LEN;
+	if (strcmp(hfinfo->abbrev, "frame.cap_len") == 0)
+		return FRAME_FIELD_CAP_LEN;
+	if (strcmp(hfinfo->abbrev, "frame.time") == 0 ||
+			strcmp(hfinfo->abbrev, "frame.time_utc") == 0 ||
+			strcmp(hfinfo->abbrev, "frame.time_epoch") == 0)
+		return FRAME_FIELD_TIME;
+	if (strcmp(hfinfo->abbrev, "frame.marked") == 0)
+		return FRAME_FIELD_MARKED;
+	if (strcmp(hfinfo->abbrev, "frame.ignored") == 0)
+		return FRAME_FIELD_IGNORED;
+	return FRAME_FIELD_NONE;
+}
+
+static void
+frame_bounds_init(dfilter_frame_bounds_t *bounds)
+{
+	bounds->num_min = 0;
+	bounds->num_max = UINT32_MAX;
+	bounds->len_min = 0;
+	bounds->len_max = UINT32_MAX;
+	bounds->cap_len_min = 0;
+	bounds->cap_len_max = UINT32_MAX;
+	nstime_set_unset(&bounds->time_min);
+	nstime_set_unset(&bounds->time_max);
+	bounds->marked = -1;
+	bounds->ignored = -1;
+}
+
+/* Keep the later of two lower time limits (or the earlier of two upper
+ * ones if "later" is false), where unset means no limit. */
+static void
+time_limit_narrow(nstime_t *limit, const nstime_t *other, bool later)
+{
+	if (nstime_is_unset(other))
+		return;
+	if (nstime_is_unset(limit) ||
+			(later ? nstime_cmp(other, limit) > 0 : nstime_cmp(other, limit) < 0))
+		*limit = *other;
+}
+
+static void
+time_limit_widen(nstime_t *limit, const nstime_t *other, bool earlier)
+{
+	if (nstime_is_unset(limit))
+		return;
+	if (nstime_is_unset(other))
+		nstime_set_unset(limit);
+	else if (earlier ? nstime_cmp(other, limit) < 0 : nstime_cmp(other, limit) > 0)
+		*limit = *other;
+}
+
+/* A frame that matches both a and b is within both of their bounds. */
+static void
+frame_bounds_intersect(dfilter_frame_bounds_t *a, const dfilter_frame_bounds_t *b)
+{
+	a->num_min = MAX(a->num_min, b->num_min);
+	a->num_max = MIN(a->num_max, b->num_max);
+	a->len_min = MAX(a->len_min, b->len_min);
+	a->len_max = MIN(a->len_max, b->len_max);
+	a->cap_len_min = MAX(a->cap_len_min, b->cap_len_min);
+	a->cap_len_max = MIN(a->cap_len_max, b->cap_len_max);
+	time_limit_narrow(&a->time_min, &b->time_min, true);
+	time_limit_narrow(&a->time_max, &b->time_max, false);
+	if ((a->marked >= 0 && b->marked >= 0 && a->marked != b->marked) ||
+			(a->ignored >= 0 && b->ignored >= 0 && a->ignored != b->ignored)) {
+		/* Nothing matches. */
+		a->num_min = UINT32_MAX;
+		a->num_max = 0;
+	}
+	if (a->marked < 0)
+		a->marked = b->marked;
+	if (a->ignored < 0)
+		a->ignored = b->ignored;
+}
+
+/* A frame that matches a or b is within the span of their bounds. */
+static void
+frame_bounds_union(dfilter_frame_bounds_t *a, const dfilter_frame_bounds_t *b)
+{
+	a->num_min = MIN(a->num_min, b->num_min);
+	a->num_max = MAX(a->num_max, b->num_max);
+	a->len_min = MIN(a->len_min, b->len_min);
+	a->len_max = MAX(a->len_max, b->len_max);
+	a->cap_len_min = MIN(a->cap_len_min, b->cap_len_min);
+	a->cap_len_max = MAX(a->cap_len_max, b->cap_len_max);
+	time_limit_widen(&a->time_min, &b->time_min, true);
+	time_limit_widen(&a->time_max, &b->time_max, false);
+	if (a->marked != b->marked)
+		a->marked = -1;
+	if (a->ignored != b->ignored)
+		a->ignored = -1;
+}
+
+/* Narrow [*min, *max] to the values "op value" allows. Strict comparisons
+ * are treated as if they weren't; the bounds only have to hold for every
+ * frame that matches. */
+static void
+uint_bounds_apply(uint32_t *min, uint32_t *max, stnode_op_t op, uint32_t value)
+{
+	if (op != STNODE_OP_LT && op != STNODE_OP_LE)
+		*min = MAX(*min, value);
+	if (op != STNODE_OP_GT && op != STNODE_OP_GE)
+		*max = MIN(*max, value);
+}
+
+static void
+time_bounds_apply(nstime_t *min, nstime_t *max, stnode_op_t op, const nstime_t *value)
+{
+	if (op != STNODE_OP_LT && op != STNODE_OP_LE)
+		time_limit_narrow(min, value, true);
+	if (op != STNODE_OP_GT && op != STNODE_OP_GE)
+		time_limit_narrow(max, value, false);
+}
+
+/* Apply "field op value", where op is an equality or an ordering and
+ * value is a constant. */
+static bool
+frame_bounds_apply(dfilter_frame_bounds_t *bounds, frame_field_t field,
+			stnode_op_t op, fvalue_t *value)
+{
+	ftenum_t	ftype = fvalue_type_ftenum(value);
+
+	switch (field) {
+		case FRAME_FIELD_NUMBER:
+			if (ftype != FT_UINT32)
+				return false;
+			uint_bounds_apply(&bounds->num_min, &bounds->num_max, op, fvalue_get_uinteger(value));
+			return true;
+		case FRAME_FIELD_LEN:
+			if (ftype != FT_UINT32)
+				return false;
+			uint_bounds_apply(&bounds->len_min, &bounds->len_max, op, fvalue_get_uinteger(value));
+			return true;
+		case FRAME_FIELD_CAP_LEN:
+			if (ftype != FT_UINT32)
+				return false;
+			uint_bounds_apply(&bounds->cap_len_min, &bounds->cap_len_max, op, fvalue_get_uinteger(value));
+			return true;
+		case FRAME_FIELD_TIME:
+			if (ftype != FT_ABSOLUTE_TIME)
+				return false;
+			time_bounds_apply(&bounds->time_min, &bounds->time_max, op, fvalue_get_time(value));
+			return true;
+		case FRAME_FIELD_MARKED:
+		case FRAME_FIELD_IGNORED:
+			if (ftype != FT_BOOLEAN ||
+					(op != STNODE_OP_ALL_EQ && op != STNODE_OP_ANY_EQ))
+				return false;
+			if (field == FRAME_FIELD_MARKED)
+				bounds->marked = fvalue_get_uinteger64(value) ? 1 : 0;
+			else
+				bounds->ignored = fvalue_get_uinteger64(value) ? 1 : 0;
+			return true;
+		default:
+			return false;
+	}
+}
+
+/* "field in {...}" limits the field to the span of the set. */
+static bool
+frame_bounds_apply_set(dfilter_frame_bounds_t *bounds, frame_field_t field, GSList *nodelist)
+{
+	dfilter_frame_bounds_t set_bounds, elem_bounds;
+	stnode_t	*lower, *upper;
+	bool		first = true;
+
+	if (field == FRAME_FIELD_NONE)
+		return false;
+
+	while (nodelist) {
+		lower = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+		upper = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+
+		if (stnode_type_id(lower) != STTYPE_FVALUE ||
+				(upper && stnode_type_id(upper) != STTYPE_FVALUE))
+			return false;
+		frame_bounds_init(&elem_bounds);
+		if (upper) {
+			if (!frame_bounds_apply(&elem_bounds, field, STNODE_OP_GE, stnode_data(lower)) ||
+					!frame_bounds_apply(&elem_bounds, field, STNODE_OP_LE, stnode_data(upper)))
+				return false;
+		} else {
+			if (!frame_bounds_apply(&elem_bounds, field, STNODE_OP_ANY_EQ, stnode_data(lower)))
+				return false;
+		}
+		if (first)
+			set_bounds = elem_bounds;
+		else
+			frame_bounds_union(&set_bounds, &elem_bounds);
+		first = false;
+	}
+	if (first)
+		return false;
+	frame_bounds_intersect(bounds, &set_bounds);
+	return true;
+}
+
+/* Narrow the bounds to those of the frames the expression can be true for;
+ * returns false if it says nothing about frame metadata. */
+static bool
+// NOLINTNEXTLINE(misc-no-recursion)
+node_frame_bounds(stnode_t *st_node, dfilter_frame_bounds_t *bounds)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	dfilter_frame_bounds_t bounds1, bounds2;
+	bool		known1, known2;
+
+	if (st_node == NULL || stnode_type_id(st_node) != STTYPE_TEST)
+		return false;
+
+	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+	switch (st_op) {
+		case STNODE_OP_AND:
+			known1 = node_frame_bounds(st_arg1, bounds);
+			known2 = node_frame_bounds(st_arg2, bounds);
+			return known1 || known2;
+		case STNODE_OP_OR:
+			frame_bounds_init(&bounds1);
+			frame_bounds_init(&bounds2);
+			if (!node_frame_bounds(st_arg1, &bounds1) ||
+					!node_frame_bounds(st_arg2, &bounds2))
+				return false;
+			frame_bounds_union(&bounds1, &bounds2);
+			frame_bounds_intersect(bounds, &bounds1);
+			return true;
+		case STNODE_OP_IN:
+			if (stnode_type_id(st_arg2) != STTYPE_SET)
+				return false;
+			return frame_bounds_apply_set(bounds, frame_field(st_arg1), stnode_data(st_arg2));
+		case STNODE_OP_ALL_EQ:
+		case STNODE_OP_ANY_EQ:
+		case STNODE_OP_GT:
+		case STNODE_OP_GE:
+		case STNODE_OP_LT:
+		case STNODE_OP_LE:
+			if (stnode_type_id(st_arg2) == STTYPE_FVALUE)
+				return frame_bounds_apply(bounds, frame_field(st_arg1),
+							st_op, stnode_data(st_arg2));
+			if (stnode_type_id(st_arg1) == STTYPE_FVALUE) {
+				/* "constant op field" */
+				if (st_op == STNODE_OP_GT)
+					st_op = STNODE_OP_LT;
+				else if (st_op == STNODE_OP_GE)
+					st_op = STNODE_OP_LE;
+				else if (st_op == STNODE_OP_LT)
+					st_op = STNODE_OP_GT;
+				else if (st_op == STNODE_OP_LE)
+					st_op = STNODE_OP_GE;
+				return frame_bounds_apply(bounds, frame_field(st_arg2),
+							st_op, stnode_data(st_arg1));
+			}
+			return false;
+		default:
+			return false;
+	}
+}
+
+bool
+dfw_frame_bounds(dfwork_t *dfw, dfilter_frame_bounds_t *bounds)
+{
+	frame_bounds_init(bounds);
+	return node_frame_bounds(dfw->st_root, bounds);
+}
+
+/* An unsigned integer field whose values an equality or set test
+ * constrains, for dfw_field_values(), or NULL. */
+static header_field_info *
+value_field(stnode_t *st_arg)
+{
+	header_field_info *hfinfo;
+
+	if (stnode_type_id(st_arg) != STTYPE_FIELD)
+		return NULL;
+	hfinfo = sttype_field_hfinfo(st_arg);
+	if (hfinfo->same_name_prev_id != -1 || hfinfo->same_name_next != NULL)
+		return NULL;
+	if (sttype_field_drange(st_arg) != NULL || sttype_field_raw(st_arg) ||
+			sttype_field_value_string(st_arg))
+		return NULL;
+
+	switch (hfinfo->type) {
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+			return hfinfo;
+		default:
+			return NULL;
+	}
+}
+
+static bool
+value_get(stnode_t *st_value, uint32_t *value)
+{
+	fvalue_t	*fv;
+
+	if (st_value == NULL || stnode_type_id(st_value) != STTYPE_FVALUE)
+		return false;
+	fv = stnode_data(st_value);
+	switch (fvalue_type_ftenum(fv)) {
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+			*value = fvalue_get_uinteger(fv);
+			return true;
+		default:
+			return false;
+	}
+}
+
+static int
+value_compare(const void *a, const void *b)
+{
+	uint32_t value_a = *(const uint32_t *)a;
+	uint32_t value_b = *(const uint32_t *)b;
+
+	return value_a < value_b ? -1 : value_a > value_b;
+}
+
+/* Sort the values and drop duplicates. */
+static void
+values_normalize(GArray *values)
+{
+	unsigned	len = 0;
+
+	g_array_sort(values, value_compare);
+	for (unsigned i = 0; i < values->len; i++) {
+		if (len == 0 || g_array_index(values, uint32_t, i) != g_array_index(values, uint32_t, len - 1))
+			g_array_index(values, uint32_t, len++) = g_array_index(values, uint32_t, i);
+	}
+	g_array_set_size(values, len);
+}
+
+static void
+values_free(void *data)
+{
+	g_array_free((GArray *)data, true);
+}
+
+static GHashTable *
+field_values_new(int hfid, GArray *values)
+{
+	GHashTable	*field_values;
+
+	field_values = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, values_free);
+	values_normalize(values);
+	g_hash_table_insert(field_values, GINT_TO_POINTER(hfid), values);
+	return field_values;
+}
+
+/* Keep the values in "values" that are also in "other"; both are sorted. */
+static void
+values_intersect(GArray *values, const GArray *other)
+{
+	unsigned	len = 0, j = 0;
+
+	for (unsigned i = 0; i < values->len; i++) {
+		uint32_t value = g_array_index(values, uint32_t, i);
+
+		while (j < other->len && g_array_index(other, uint32_t, j) < value)
+			j++;
+		if (j < other->len && g_array_index(other, uint32_t, j) == value)
+			g_array_index(values, uint32_t, len++) = value;
+	}
+	g_array_set_size(values, len);
+}
+
+/* The values a set test allows, or NULL if they aren't all constants.
+ * Ranges are left out; they could allow any number of values. */
+static GArray *
+set_values(GSList *nodelist)
+{
+	GArray		*values = g_array_new(false, false, sizeof(uint32_t));
+	stnode_t	*lower, *upper;
+	uint32_t	value;
+
+	while (nodelist) {
+		lower = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+		upper = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+
+		if (upper != NULL || !value_get(lower, &value)) {
+			g_array_free(values, true);
+			return NULL;
+		}
+		g_array_append_val(values, value);
+	}
+	return values;
+}
+
+/* Get the values the expression requires fields to have, as a table
+ * of sorted arrays by field ID, or NULL if it doesn't require any. */
+static GHashTable *
+// NOLINTNEXTLINE(misc-no-recursion)
+node_field_values(stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	header_field_info *hfinfo;
+	GHashTable	*values1, *values2;
+	GHashTableIter	iter;
+	void		*key, *value;
+	GArray		*values;
+	uint32_t	constant;
+
+	if (st_node == NULL || stnode_type_id(st_node) != STTYPE_TEST)
+		return NULL;
+
+	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+	switch (st_op) {
+		case STNODE_OP_AND:
+			/* Both sets of requirements hold. */
+			values1 = node_field_values(st_arg1);
+			values2 = node_field_values(st_arg2);
+			if (values1 == NULL)
+				return values2;
+			if (values2 == NULL)
+				return values1;
+			g_hash_table_iter_init(&iter, values2);
+			while (g_hash_table_iter_next(&iter, &key, &value)) {
+				values = g_hash_table_lookup(values1, key);
+				if (values != NULL) {
+					values_intersect(values, value);
+				} else {
+					g_hash_table_iter_steal(&iter);
+					g_hash_table_insert(values1, key, value);
+				}
+			}
+			g_hash_table_destroy(values2);
+			return values1;
+		case STNODE_OP_OR:
+			/* Only fields both sides require something of are
+			 * required to have one of their values. */
+			values1 = node_field_values(st_arg1);
+			values2 = node_field_values(st_arg2);
+			if (values1 == NULL || values2 == NULL) {
+				if (values1 != NULL)
+					g_hash_table_destroy(values1);
+				if (values2 != NULL)
+					g_hash_table_destroy(values2);
+				return NULL;
+			}
+			g_hash_table_iter_init(&iter, values1);
+			while (g_hash_table_iter_next(&iter, &key, &value)) {
+				GArray *other = g_hash_table_lookup(values2, key);
+
+				if (other == NULL) {
+					g_hash_table_iter_remove(&iter);
+					continue;
+				}
+				g_array_append_vals(value, other->data, other->len);
+				values_normalize(value);
+			}
+			g_hash_table_destroy(values2);
+			if (g_hash_table_size(values1) == 0) {
+				g_hash_table_destroy(values1);
+				return NULL;
+			}
+			return values1;
+		case STNODE_OP_IN:
+			if (stnode_type_id(st_arg2) != STTYPE_SET ||
+					(hfinfo = value_field(st_arg1)) == NULL)
+				return NULL;
+			values = set_values(stnode_data(st_arg2));
+			if (values == NULL)
+				return NULL;
+			return field_values_new(hfinfo->id, values);
+		case STNODE_OP_ALL_EQ:
+		case STNODE_OP_ANY_EQ:
+			hfinfo = value_field(st_arg1);
+			if (hfinfo == NULL || !value_get(st_arg2, &constant)) {
+				/* "constant == field" */
+				hfinfo = value_field(st_arg2);
+				if (hfinfo == NULL || !value_get(st_arg1, &constant))
+					return NULL;
+			}
+			values = g_array_new(false, false, sizeof(uint32_t));
+			g_array_append_val(values, constant);
+			return field_values_new(hfinfo->id, values);
+		default:
+			return NULL;
+	}
+}
+
+GHashTable*
+dfw_field_values(dfwork_t *dfw)
+{
+	return node_field_values(dfw->st_root);
+}
+
+/* Split the expression into the operands of its outermost chain of "op",
+ * each described so that identical operands compare equal as strings. */
+static void
+// NOLINTNEXTLINE(misc-no-recursion)
+node_terms(stnode_t *st_node, stnode_op_t op, GPtrArray *terms)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) == STTYPE_TEST) {
+		sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+		if (st_op == op) {
+			node_terms(st_arg1, op, terms);
+			node_terms(st_arg2, op, terms);
+			return;
+		}
+	}
+	g_ptr_array_add(terms, dump_syntax_tree_str(st_node));
+}
+
+GPtrArray*
+dfw_terms(dfwork_t *dfw, stnode_op_t op)
+{
+	GPtrArray *terms = g_ptr_array_new_with_free_func(g_free);
+
+	if (dfw->st_root != NULL)
+		node_terms(dfw->st_root, op, terms);
+	return terms;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
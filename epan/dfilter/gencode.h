@@ -18,4 +18,16 @@ dfw_gencode(dfwork_t *dfw);
 int*
 dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields);
 
+int*
+dfw_required_protocols(dfwork_t *dfw, int *caller_num_protos);
+
+bool
+dfw_frame_bounds(dfwork_t *dfw, dfilter_frame_bounds_t *bounds);
+
+GHashTable*
+dfw_field_values(dfwork_t *dfw);
+
+GPtrArray*
+dfw_terms(dfwork_t *dfw, stnode_op_t op);
+
 #endif
@@ -134,8 +134,14 @@ struct _diam_avp_t {
 #define VND_AVP_VS(v)      ((value_string *)(void *)(wmem_array_get_raw((v)->vs_avps)))
 #define VND_AVP_VS_LEN(v)  (wmem_array_get_count((v)->vs_avps))
 
+/* The key of dictionary.avps */
+typedef struct _diam_avp_key_t {
+	uint32_t code;
+	uint32_t vendorid;
+} diam_avp_key_t;
+
 typedef struct _diam_dictionary_t {
-	wmem_tree_t *avps;
+	wmem_map_t *avps;
 	wmem_tree_t *vnds;
 	value_string_ext *applications;
 } diam_dictionary_t;
@@ -369,6 +375,24 @@ export_diameter_pdu(packet_info *pinfo, tvbuff_t *tvb)
 
 }
 
+static unsigned
+diam_avp_key_hash(const void *k)
+{
+	const diam_avp_key_t *key = (const diam_avp_key_t *)k;
+
+	/* Most AVPs of a vendor have codes close together, spread the vendors apart. */
+	return key->code ^ (key->vendorid * 2654435761U);
+}
+
+static gboolean
+diam_avp_key_equal(const void *a, const void *b)
+{
+	const diam_avp_key_t *key_a = (const diam_avp_key_t *)a;
+	const diam_avp_key_t *key_b = (const diam_avp_key_t *)b;
+
+	return key_a->code == key_b->code && key_a->vendorid == key_b->vendorid;
+}
+
 static int
 compare_avps(const void *a, const void *b)
 {
@@ -933,7 +957,7 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	uint32_t vendor_flag    = len & 0x80000000;
 	uint32_t flags_bits     = (len & 0xFF000000) >> 24;
 	uint32_t vendorid       = vendor_flag ? tvb_get_ntohl(tvb,offset+8) : 0 ;
-	wmem_tree_key_t k[3];
+	diam_avp_key_t k = { code, vendorid };
 	diam_avp_t *a;
 	proto_item *pi, *avp_item;
 	proto_tree *avp_tree, *save_tree;
@@ -943,16 +967,7 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	const char *avp_str = NULL;
 	uint8_t pad_len;
 
-	k[0].length = 1;
-	k[0].key = &code;
-
-	k[1].length = 1;
-	k[1].key = &vendorid;
-
-	k[2].length = 0;
-	k[2].key = NULL;
-
-	a = (diam_avp_t *)wmem_tree_lookup32_array(dictionary.avps,k);
+	a = (diam_avp_t *)wmem_map_lookup(dictionary.avps, &k);
 
 	len &= 0x00ffffff;
 	pad_len = WS_PADDING_TO_4(len);
@@ -2542,7 +2557,7 @@ typedef struct populate_avp_data
 	GHashTable* vendors;
 	GHashTable* types;
 	GHashTable* build_avps;
-	wmem_tree_t* dict_avps;
+	wmem_map_t* dict_avps;
 	GSList* xmlpis;
 	wmem_array_t* hf_array;
 	GPtrArray* ett_array;
@@ -2625,16 +2640,12 @@ ddictionary_populate_avp(void* data, void* user_data)
 	if (avp != NULL) {
 		g_hash_table_insert(pop_data->build_avps, avp_name, avp);
 
-		wmem_tree_key_t k[3];
+		diam_avp_key_t* k = wmem_new(wmem_epan_scope(), diam_avp_key_t);
 
-		k[0].length = 1;
-		k[0].key = &(a->code);
-		k[1].length = 1;
-		k[1].key = &(vnd->code);
-		k[2].length = 0;
-		k[2].key = NULL;
+		k->code = a->code;
+		k->vendorid = vnd->code;
 
-		wmem_tree_insert32_array(pop_data->dict_avps, k, avp);
+		wmem_map_insert(pop_data->dict_avps, k, avp);
 	}
 }
 
@@ -2979,7 +2990,7 @@ ddictionary_load(wmem_array_t* hf_array, GPtrArray* ett_array)
 	ddict_t all_data = { NULL, NULL, NULL, NULL, NULL, NULL};
 
 	dictionary.vnds = wmem_tree_new(wmem_epan_scope());
-	dictionary.avps = wmem_tree_new(wmem_epan_scope());
+	dictionary.avps = wmem_map_new(wmem_epan_scope(), diam_avp_key_hash, diam_avp_key_equal);
 
 	unknown_vendor.vs_avps = wmem_array_new(wmem_epan_scope(), sizeof(value_string));
 	wmem_array_set_null_terminator(unknown_vendor.vs_avps);
@@ -65,6 +65,7 @@
 #include "packet-ip.h"
 #include <epan/prefs.h>
 #include <epan/prefs-int.h>
+#include <epan/req_resp_table.h>
 #include <epan/strutil.h>
 #include <epan/expert.h>
 #include <epan/tap.h>
@@ -238,6 +239,7 @@ static const char* st_str_service_unsolicited = "no. of unsolicited responses";
 static const char* st_str_service_retransmission = "no. of retransmissions";
 static const char* st_str_service_rrt = "request-response time (msec)";
 
+static int st_node_packets = -1;
 static int st_node_packet_qr = -1;
 static int st_node_packet_qtypes = -1;
 static int st_node_packet_qnames = -1;
@@ -696,17 +698,12 @@ enum DnsTransport {
 
 /* Structure containing transaction specific information */
 typedef struct _dns_transaction_t {
-  uint32_t req_frame;
-  uint32_t rep_frame;
-  nstime_t req_time;
-  unsigned id;
+  req_resp_trans_t trans;   /* keyed by transaction ID, or DoH stream */
   bool multiple_responds;
 } dns_transaction_t;
 
-/* Structure containing conversation specific information */
-typedef struct _dns_conv_info_t {
-  wmem_tree_t *pdus;
-} dns_conv_info_t;
+/* Queries and responses, by conversation */
+static req_resp_table_t *dns_transactions;
 
 /* DNS structs and definitions */
 
@@ -4563,9 +4560,7 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   int                cur_off;
   bool               isupdate;
   conversation_t    *conversation;
-  dns_conv_info_t   *dns_info;
   dns_transaction_t *dns_trans = NULL;
-  wmem_tree_key_t    key[3];
   struct DnsTap     *dns_stats;
   wmem_list_t       *rr_types;
   uint16_t           qtype = 0;
@@ -4663,84 +4658,59 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     reqresp_id = id;
   }
 
-  /*
-   * Do we already have a state structure for this conv
-   */
-  dns_info = (dns_conv_info_t *)conversation_get_proto_data(conversation, proto_dns);
-  if (!dns_info) {
-    /* No.  Attach that information to the conversation, and add
-     * it to the list of information structures.
-     */
-    dns_info = wmem_new(wmem_file_scope(), dns_conv_info_t);
-    dns_info->pdus=wmem_tree_new(wmem_file_scope());
-    conversation_add_proto_data(conversation, proto_dns, dns_info);
-  }
-
-  key[0].length = 1;
-  key[0].key = &reqresp_id;
-  key[1].length = 1;
-  key[1].key = &pinfo->num;
-  key[2].length = 0;
-  key[2].key = NULL;
-
   if (!pinfo->flags.in_error_pkt) {
     if (!pinfo->fd->visited) {
+      dns_trans = (dns_transaction_t *)req_resp_lookup(dns_transactions, pinfo,
+                                                       conversation->conv_index, reqresp_id);
       if (!(flags&F_RESPONSE)) {
         /* This is a request */
         bool new_transaction = false;
 
         /* Check if we've seen this transaction before */
-        dns_trans=(dns_transaction_t *)wmem_tree_lookup32_array_le(dns_info->pdus, key);
-        if ((dns_trans == NULL) || (dns_trans->id != reqresp_id) || (dns_trans->rep_frame > 0)) {
+        if ((dns_trans == NULL) || (dns_trans->trans.rep_frame > 0)) {
           new_transaction = true;
         } else {
           nstime_t request_delta;
 
           /* Has not enough time elapsed that we consider this request a retransmission? */
-          nstime_delta(&request_delta, &pinfo->abs_ts, &dns_trans->req_time);
+          nstime_delta(&request_delta, &pinfo->abs_ts, &dns_trans->trans.req_time);
           if (nstime_to_sec(&request_delta) < (double)retransmission_timer) {
             retransmission = true;
+            req_resp_attach(dns_transactions, pinfo, &dns_trans->trans);
           } else {
             new_transaction = true;
           }
         }
 
         if (new_transaction) {
-          dns_trans=wmem_new(wmem_file_scope(), dns_transaction_t);
-          dns_trans->req_frame=pinfo->num;
-          dns_trans->rep_frame=0;
-          dns_trans->req_time=pinfo->abs_ts;
-          dns_trans->id = reqresp_id;
-          dns_trans->multiple_responds=false;
-          wmem_tree_insert32_array(dns_info->pdus, key, (void *)dns_trans);
+          dns_trans = (dns_transaction_t *)req_resp_add_request(dns_transactions, pinfo,
+                                                                conversation->conv_index, reqresp_id,
+                                                                sizeof(dns_transaction_t));
         }
-      } else {
-        dns_trans=(dns_transaction_t *)wmem_tree_lookup32_array_le(dns_info->pdus, key);
-        if (dns_trans) {
-          if (dns_trans->id != reqresp_id) {
-            dns_trans = NULL;
-          } else if (dns_trans->rep_frame == 0) {
-            dns_trans->rep_frame=pinfo->num;
-          } else if (!dns_trans->multiple_responds) {
+      } else if (dns_trans) {
+        if (dns_trans->trans.rep_frame == 0) {
+          req_resp_add_response(dns_transactions, pinfo, &dns_trans->trans);
+        } else {
+          if (!dns_trans->multiple_responds) {
             retransmission = true;
           }
+          req_resp_attach(dns_transactions, pinfo, &dns_trans->trans);
         }
       }
     } else {
-      dns_trans=(dns_transaction_t *)wmem_tree_lookup32_array_le(dns_info->pdus, key);
+      dns_trans = (dns_transaction_t *)req_resp_find(dns_transactions, pinfo,
+                                                     conversation->conv_index, reqresp_id);
       if (dns_trans) {
-        if (dns_trans->id != reqresp_id) {
-          dns_trans = NULL;
-        } else if ((!(flags & F_RESPONSE)) && (dns_trans->req_frame != pinfo->num)) {
+        if ((!(flags & F_RESPONSE)) && (dns_trans->trans.req_frame != pinfo->num)) {
           /* This is a request retransmission, create a "fake" dns_trans structure*/
-          dns_transaction_t *retrans_dns = wmem_new(pinfo->pool, dns_transaction_t);
-          retrans_dns->req_frame=dns_trans->req_frame;
-          retrans_dns->rep_frame=0;
-          retrans_dns->req_time=pinfo->abs_ts;
+          dns_transaction_t *retrans_dns = wmem_new0(pinfo->pool, dns_transaction_t);
+          retrans_dns->trans.req_frame=dns_trans->trans.req_frame;
+          retrans_dns->trans.rep_frame=0;
+          retrans_dns->trans.req_time=pinfo->abs_ts;
           dns_trans = retrans_dns;
 
           retransmission = true;
-        } else if ((flags & F_RESPONSE) && (dns_trans->rep_frame != pinfo->num) && (!dns_trans->multiple_responds)) {
+        } else if ((flags & F_RESPONSE) && (dns_trans->trans.rep_frame != pinfo->num) && (!dns_trans->multiple_responds)) {
           retransmission = true;
         }
       }
@@ -4748,10 +4718,10 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   }
   if (!dns_trans) {
     /* create a "fake" dns_trans structure */
-    dns_trans=wmem_new(pinfo->pool, dns_transaction_t);
-    dns_trans->req_frame=0;
-    dns_trans->rep_frame=0;
-    dns_trans->req_time=pinfo->abs_ts;
+    dns_trans=wmem_new0(pinfo->pool, dns_transaction_t);
+    dns_trans->trans.req_frame=0;
+    dns_trans->trans.rep_frame=0;
+    dns_trans->trans.req_time=pinfo->abs_ts;
   }
 
   if (transport == DNS_TRANSPORT_TCP) {
@@ -4904,17 +4874,17 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   if (!(flags&F_RESPONSE)) {
     proto_item *it;
     /* This is a request */
-    if ((retransmission) && (dns_trans->req_frame) && (!pinfo->flags.in_error_pkt)) {
-      expert_add_info_format(pinfo, transaction_item, &ei_dns_retransmit_request, "DNS query retransmission. Original request in frame %d", dns_trans->req_frame);
+    if ((retransmission) && (dns_trans->trans.req_frame) && (!pinfo->flags.in_error_pkt)) {
+      expert_add_info_format(pinfo, transaction_item, &ei_dns_retransmit_request, "DNS query retransmission. Original request in frame %d", dns_trans->trans.req_frame);
 
-      it=proto_tree_add_uint(dns_tree, hf_dns_retransmit_request_in, tvb, 0, 0, dns_trans->req_frame);
+      it=proto_tree_add_uint(dns_tree, hf_dns_retransmit_request_in, tvb, 0, 0, dns_trans->trans.req_frame);
       proto_item_set_generated(it);
 
       it=proto_tree_add_boolean(dns_tree, hf_dns_retransmission, tvb, 0, 0, true);
       proto_item_set_generated(it);
-    } else if (dns_trans->rep_frame) {
+    } else if (dns_trans->trans.rep_frame) {
 
-      it=proto_tree_add_uint(dns_tree, hf_dns_response_in, tvb, 0, 0, dns_trans->rep_frame);
+      it=proto_tree_add_uint(dns_tree, hf_dns_response_in, tvb, 0, 0, dns_trans->trans.rep_frame);
       proto_item_set_generated(it);
     } else if PINFO_FD_VISITED(pinfo) {
       expert_add_info(pinfo, transaction_item, &ei_dns_response_missing);
@@ -4922,20 +4892,20 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   } else {
     /* This is a reply */
     proto_item *it;
-    if (dns_trans->req_frame) {
-      if ((retransmission) && (dns_trans->rep_frame) && (!pinfo->flags.in_error_pkt)) {
-        expert_add_info_format(pinfo, transaction_item, &ei_dns_retransmit_response, "DNS response retransmission. Original response in frame %d", dns_trans->rep_frame);
+    if (dns_trans->trans.req_frame) {
+      if ((retransmission) && (dns_trans->trans.rep_frame) && (!pinfo->flags.in_error_pkt)) {
+        expert_add_info_format(pinfo, transaction_item, &ei_dns_retransmit_response, "DNS response retransmission. Original response in frame %d", dns_trans->trans.rep_frame);
 
-        it=proto_tree_add_uint(dns_tree, hf_dns_retransmit_response_in, tvb, 0, 0, dns_trans->rep_frame);
+        it=proto_tree_add_uint(dns_tree, hf_dns_retransmit_response_in, tvb, 0, 0, dns_trans->trans.rep_frame);
         proto_item_set_generated(it);
 
         it=proto_tree_add_boolean(dns_tree, hf_dns_retransmission, tvb, 0, 0, true);
         proto_item_set_generated(it);
       } else {
-        it=proto_tree_add_uint(dns_tree, hf_dns_response_to, tvb, 0, 0, dns_trans->req_frame);
+        it=proto_tree_add_uint(dns_tree, hf_dns_response_to, tvb, 0, 0, dns_trans->trans.req_frame);
         proto_item_set_generated(it);
 
-        nstime_delta(&delta, &pinfo->abs_ts, &dns_trans->req_time);
+        nstime_delta(&delta, &pinfo->abs_ts, &dns_trans->trans.req_time);
         it=proto_tree_add_time(dns_tree, hf_dns_time, tvb, 0, 0, &delta);
         proto_item_set_generated(it);
       }
@@ -5000,7 +4970,7 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
       }
     }
     if (flags & F_RESPONSE) {
-      if (dns_trans->req_frame == 0) {
+      if (dns_trans->trans.req_frame == 0) {
         /* we don't have a request. This is an unsolicited response */
         dns_stats->unsolicited = true;
       } else {
@@ -5192,7 +5162,7 @@ dissect_dns_heur(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data
 
 static void dns_stats_tree_init(stats_tree* st)
 {
-  stats_tree_create_node(st, st_str_packets, 0, STAT_DT_INT, true);
+  st_node_packets = stats_tree_create_node(st, st_str_packets, 0, STAT_DT_INT, true);
   stat_node_set_flags(st, st_str_packets, 0, false, ST_FLG_SORT_TOP);
   st_node_packet_qr = stats_tree_create_pivot(st, st_str_packet_qr, 0);
   st_node_packet_qtypes = stats_tree_create_pivot(st, st_str_packet_qtypes, 0);
@@ -5224,70 +5194,78 @@ static void dns_stats_tree_init(stats_tree* st)
   st_node_service_rrt = stats_tree_create_node(st, st_str_service_rrt, st_node_service_stats, STAT_DT_FLOAT, false);
 }
 
+/* Ticks the child of a pivot node for a numeric value (type, class, rcode,
+ * ...). The child is found by the value itself, so its name is only
+ * formatted the first time the value is seen. */
+static void G_GNUC_PRINTF(5, 0)
+dns_stats_tree_tick_pivot(stats_tree *st, int pivot_id, uint32_t value, const value_string *vals, const char *unknown_fmt)
+{
+  char *name = NULL;
+
+  if (stats_tree_node_id_by_key(st, pivot_id, value) < 0) {
+    name = val_to_str(NULL, value, vals, unknown_fmt);
+  }
+  stats_tree_tick_pivot_by_key(st, pivot_id, value, name);
+  wmem_free(NULL, name);
+}
+
 static tap_packet_status dns_stats_tree_packet(stats_tree* st, packet_info* pinfo _U_, epan_dissect_t* edt _U_, const void* p, tap_flags_t flags _U_)
 {
   const struct DnsTap *pi = (const struct DnsTap *)p;
-  tick_stat_node(st, st_str_packets, 0, false);
-  stats_tree_tick_pivot(st, st_node_packet_qr,
-          val_to_str(pinfo->pool, pi->packet_qr, dns_qr_vals, "Unknown qr (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_qtypes,
-          val_to_str(pinfo->pool, pi->packet_qtype, dns_types_vals, "Unknown packet type (%d)"));
+  tick_stat_node_by_id(st, st_node_packets);
+  dns_stats_tree_tick_pivot(st, st_node_packet_qr, pi->packet_qr, dns_qr_vals, "Unknown qr (%d)");
+  dns_stats_tree_tick_pivot(st, st_node_packet_qtypes, pi->packet_qtype, dns_types_vals, "Unknown packet type (%d)");
   if (dns_qname_stats && pi->qname_len > 0) {
         stats_tree_tick_pivot(st, st_node_packet_qnames, pi->qname);
   }
-  stats_tree_tick_pivot(st, st_node_packet_qclasses,
-          val_to_str(pinfo->pool, pi->packet_qclass, dns_classes, "Unknown class (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_rcodes,
-          val_to_str(pinfo->pool, pi->packet_rcode, rcode_vals, "Unknown rcode (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_opcodes,
-          val_to_str(pinfo->pool, pi->packet_opcode, opcode_vals, "Unknown opcode (%d)"));
-  avg_stat_node_add_value_int(st, st_str_packets_avg_size, 0, false,
-          pi->payload_size);
+  dns_stats_tree_tick_pivot(st, st_node_packet_qclasses, pi->packet_qclass, dns_classes, "Unknown class (%d)");
+  dns_stats_tree_tick_pivot(st, st_node_packet_rcodes, pi->packet_rcode, rcode_vals, "Unknown rcode (%d)");
+  dns_stats_tree_tick_pivot(st, st_node_packet_opcodes, pi->packet_opcode, opcode_vals, "Unknown opcode (%d)");
+  avg_stat_node_add_value_int_by_id(st, st_node_packets_avg_size, pi->payload_size);
 
   /* split up stats for queries and responses */
   if (pi->packet_qr == 0) {
-    avg_stat_node_add_value_int(st, st_str_query_qname_len, 0, false, pi->qname_len);
+    avg_stat_node_add_value_int_by_id(st, st_node_query_qname_len, pi->qname_len);
     switch(pi->qname_labels) {
       case 1:
-        tick_stat_node(st, st_str_query_domains_l1, 0, false);
+        tick_stat_node_by_id(st, st_node_query_domains_l1);
         break;
       case 2:
-        tick_stat_node(st, st_str_query_domains_l2, 0, false);
+        tick_stat_node_by_id(st, st_node_query_domains_l2);
         break;
       case 3:
-        tick_stat_node(st, st_str_query_domains_l3, 0, false);
+        tick_stat_node_by_id(st, st_node_query_domains_l3);
         break;
       default:
-        tick_stat_node(st, st_str_query_domains_lmore, 0, false);
+        tick_stat_node_by_id(st, st_node_query_domains_lmore);
         break;
     }
   } else {
-    avg_stat_node_add_value_int(st, st_str_response_nquestions, 0, false, pi->nquestions);
-    avg_stat_node_add_value_int(st, st_str_response_nanswers, 0, false, pi->nanswers);
-    avg_stat_node_add_value_int(st, st_str_response_nauthorities, 0, false, pi->nauthorities);
-    avg_stat_node_add_value_int(st, st_str_response_nadditionals, 0, false, pi->nadditionals);
+    avg_stat_node_add_value_int_by_id(st, st_node_response_nquestions, pi->nquestions);
+    avg_stat_node_add_value_int_by_id(st, st_node_response_nanswers, pi->nanswers);
+    avg_stat_node_add_value_int_by_id(st, st_node_response_nauthorities, pi->nauthorities);
+    avg_stat_node_add_value_int_by_id(st, st_node_response_nadditionals, pi->nadditionals);
 
     /* add answer types to stats */
     for (wmem_list_frame_t *type_entry = wmem_list_head(pi->rr_types); type_entry != NULL; type_entry = wmem_list_frame_next(type_entry)) {
       int qtype_val = GPOINTER_TO_INT(wmem_list_frame_data(type_entry));
-      stats_tree_tick_pivot(st, st_node_rr_types,
-                            val_to_str(pinfo->pool, qtype_val, dns_types_vals, "Unknown packet type (%d)"));
+      dns_stats_tree_tick_pivot(st, st_node_rr_types, qtype_val, dns_types_vals, "Unknown packet type (%d)");
     }
 
     if (pi->unsolicited) {
-      tick_stat_node(st, st_str_service_unsolicited, 0, false);
+      tick_stat_node_by_id(st, st_node_service_unsolicited);
     } else {
-        avg_stat_node_add_value_int(st, st_str_response_nquestions, 0, false, pi->nquestions);
-        avg_stat_node_add_value_int(st, st_str_response_nanswers, 0, false, pi->nanswers);
-        avg_stat_node_add_value_int(st, st_str_response_nauthorities, 0, false, pi->nauthorities);
-        avg_stat_node_add_value_int(st, st_str_response_nadditionals, 0, false, pi->nadditionals);
+        avg_stat_node_add_value_int_by_id(st, st_node_response_nquestions, pi->nquestions);
+        avg_stat_node_add_value_int_by_id(st, st_node_response_nanswers, pi->nanswers);
+        avg_stat_node_add_value_int_by_id(st, st_node_response_nauthorities, pi->nauthorities);
+        avg_stat_node_add_value_int_by_id(st, st_node_response_nadditionals, pi->nadditionals);
         if (pi->unsolicited) {
-          tick_stat_node(st, st_str_service_unsolicited, 0, false);
+          tick_stat_node_by_id(st, st_node_service_unsolicited);
         } else {
           if (pi->retransmission)
-            tick_stat_node(st, st_str_service_retransmission, 0, false);
+            tick_stat_node_by_id(st, st_node_service_retransmission);
           else
-            avg_stat_node_add_value_float(st, st_str_service_rrt, 0, false, (float)(pi->rrt.secs*1000. + pi->rrt.nsecs/1000000.0));
+            avg_stat_node_add_value_float_by_id(st, st_node_service_rrt, (float)(pi->rrt.secs*1000. + pi->rrt.nsecs/1000000.0));
         }
     }
   }
@@ -8012,6 +7990,8 @@ proto_register_dns(void)
   expert_dns = expert_register_protocol(proto_dns);
   expert_register_field_array(expert_dns, ei, array_length(ei));
 
+  dns_transactions = req_resp_table_register("DNS", NULL);
+
   dns_module = prefs_register_protocol(proto_dns, NULL);
 
   // preferences for dns_qr_statistics
@@ -239,7 +239,7 @@ ftp_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
         }
         if (!g_hash_table_contains(command_packet_to_eo_row, GUINT_TO_POINTER(eo_info->command_frame))) {
             /* Command packet not previously seen. Create the new entry in the hashtable. */
-            export_object_entry_t *entry = g_new(export_object_entry_t, 1);
+            export_object_entry_t *entry = g_new0(export_object_entry_t, 1);
             entry->pkt_num = pinfo->num;
             /* If the command is STOR, the transfer is from the client to the server
                If the command is RETR, the transfer is from the server to the client
@@ -1891,6 +1891,8 @@ proto_register_ftp(void)
                              10,
                              &pref_export_maxsize);
     ftp_eo_tap = register_export_object(proto_ftp_data, ftp_eo_packet, ftp_eo_cleanup);
+    /* Files are assembled from several packets into an existing entry */
+    set_eo_updates_entries(proto_ftp_data);
 }
 
 void
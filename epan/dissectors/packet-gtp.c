@@ -2581,6 +2581,17 @@ wmem_map_t* session_imsi;
 wmem_map_t* frame_map;
 wmem_map_t* frame_map_deint;
 
+/* Indexes kept alongside the maps above so that lookups and removals
+ * touch only the entries concerned, rather than the whole map, which
+ * grows with every TEID seen in the capture:
+ * frame -> list of the <teid,ip> keys it added to frame_map,
+ * session -> list of the frames belonging to it, and
+ * <teid,ip> -> frame for frame_map_deint regardless of the conversation.
+ */
+static wmem_map_t* frame_keys;
+static wmem_map_t* session_frames;
+static wmem_map_t* frame_map_deint_any;
+
 typedef struct {
     uint32_t teid;
     address addr;
@@ -2662,63 +2673,58 @@ get_gtp_session_frame(address ip, uint32_t teid, uint32_t convid, uint32_t *fram
 
     /*
      * Otherwise, look for an element matching only properties : <teid,addr>,
-     * as the get_frame() would do with its own Map.
-     * For this, parse the Map until any element looks good.
+     * as the get_frame() would do with its own Map. fill_map() keeps
+     * frame_map_deint_any for this, holding the last frame that added
+     * <teid,addr> for any conversation.
      */
     else {
-        wmem_list_t *frame_map_keys = wmem_map_get_keys(NULL, frame_map_deint);
-        for (wmem_list_frame_t *cur_frame = wmem_list_head(frame_map_keys); cur_frame; cur_frame = wmem_list_frame_next(cur_frame)) {
-            gtp_info_deint_t *comp_info = (gtp_info_deint_t *)wmem_list_frame_data(cur_frame);
-            if(comp_info) {
-
-                /* teid and addr are matching */
-                if( (info.teid == comp_info->teid) && (cmp_address(&info.addr, &comp_info->addr) == 0) ) {
-
-                    gtp_info_deint_t ginfod;
-                    ginfod.teid = teid;
-                    ginfod.convid = comp_info->convid;
-                    copy_address_shallow(&ginfod.addr, &ip);
-
-                    value = wmem_map_lookup(frame_map_deint, &ginfod);
-                    if (value != NULL) {
-                        *frame = GPOINTER_TO_UINT(value);
-                        return 1;
-                    }
+        gtp_info_t ginfo;
+        ginfo.teid = teid;
+        copy_address_shallow(&ginfo.addr, &ip);
 
-                    /* very unlikely, but keep it safe */
-                    wmem_destroy_list(frame_map_keys);
-                    return 0;
-                }
-            }
+        value = wmem_map_lookup(frame_map_deint_any, &ginfo);
+        if (value != NULL) {
+            *frame = GPOINTER_TO_UINT(value);
+            return 1;
         }
-        wmem_destroy_list(frame_map_keys);
     }
 
     return 0;
 }
 
-static gboolean
-frame_equal(void *key _U_, void *value, void *data){
-    uint32_t frame = GPOINTER_TO_UINT(data);
-
-    return (GPOINTER_TO_UINT(value) == frame);
-}
-
 void
 remove_frame_info(uint32_t f) {
-    /* XXX: This iterates through the entire map and it is slow if done
-     * often. For large files with lots of removals, there are better
-     * alternatives, e.g. marking sessions as expired and then periodically
-     * removing all expired sessions from the map, or using a bijective
-     * map to coordinate removals.
-     */
-    wmem_map_foreach_remove(frame_map, frame_equal, GUINT_TO_POINTER(f));
+    wmem_list_t *keys;
+    wmem_list_frame_t *elem;
+    gtp_info_t *gtp_info;
+
+    /* Only the keys this frame added can map to it. A later frame may
+     * have taken one of them over, in which case it is left alone. */
+    keys = (wmem_list_t *)wmem_map_remove(frame_keys, GUINT_TO_POINTER(f));
+    if (keys == NULL) {
+        return;
+    }
+    for (elem = wmem_list_head(keys); elem; elem = wmem_list_frame_next(elem)) {
+        gtp_info = (gtp_info_t *)wmem_list_frame_data(elem);
+        if (GPOINTER_TO_UINT(wmem_map_lookup(frame_map, gtp_info)) == f) {
+            wmem_map_remove(frame_map, gtp_info);
+        }
+    }
+    wmem_destroy_list(keys);
 }
 
 void
 add_gtp_session(uint32_t frame, uint32_t session) {
+    wmem_list_t *frames;
 
     wmem_map_insert(session_table, GUINT_TO_POINTER(frame), GUINT_TO_POINTER(session));
+
+    frames = (wmem_list_t *)wmem_map_lookup(session_frames, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        frames = wmem_list_new(wmem_file_scope());
+        wmem_map_insert(session_frames, GUINT_TO_POINTER(session), frames);
+    }
+    wmem_list_append(frames, GUINT_TO_POINTER(frame));
 }
 
 bool
@@ -2752,16 +2758,23 @@ ip_exists(address ip, wmem_list_t *ip_list) {
 }
 
 
-/* wmem_map_foreach() callback used in fill_map() */
+/* Used in fill_map() to remove the frame information of every frame of a session */
 static void
-remove_session_from_table(void *key, void *val, void *userdata) {
-    unsigned fr = GPOINTER_TO_UINT(key);
-    unsigned session = GPOINTER_TO_UINT(val);
-    unsigned remove_session = GPOINTER_TO_UINT(userdata);
+remove_session_from_table(uint32_t remove_session) {
+    wmem_list_t *frames;
+    wmem_list_frame_t *elem;
+    uint32_t fr;
 
-    /* If it's the session we are looking for, we remove all the frame information */
-    if (session == remove_session) {
-        remove_frame_info(fr);
+    frames = (wmem_list_t *)wmem_map_lookup(session_frames, GUINT_TO_POINTER(remove_session));
+    if (frames == NULL) {
+        return;
+    }
+    for (elem = wmem_list_head(frames); elem; elem = wmem_list_frame_next(elem)) {
+        fr = GPOINTER_TO_UINT(wmem_list_frame_data(elem));
+        /* If it's still in the session we are looking for, we remove all the frame information */
+        if (GPOINTER_TO_UINT(wmem_map_lookup(session_table, GUINT_TO_POINTER(fr))) == remove_session) {
+            remove_frame_info(fr);
+        }
     }
 }
 
@@ -2770,6 +2783,7 @@ fill_map(wmem_list_t *teid_list, wmem_list_t *ip_list, uint32_t frame, uint32_t
     wmem_list_frame_t *elem_ip, *elem_teid;
     gtp_info_t *gtp_info;
     gtp_info_deint_t *gtp_infod;
+    wmem_list_t *keys;
     uint32_t teid, session;
     address *ip;
 
@@ -2801,11 +2815,16 @@ fill_map(wmem_list_t *teid_list, wmem_list_t *ip_list, uint32_t frame, uint32_t
                     session = GPOINTER_TO_UINT(wmem_map_lookup(session_table, GUINT_TO_POINTER(frame)));
                     if (session) {
                         /* If the msg has the same session ID and it's not the upd req we have to remove its info */
-                        wmem_map_foreach(session_table, remove_session_from_table, GUINT_TO_POINTER(session));
+                        remove_session_from_table(session);
                     }
                 }
                 wmem_map_insert(frame_map_deint, gtp_infod, GUINT_TO_POINTER(frame));
 
+                gtp_info = wmem_new0(wmem_file_scope(), gtp_info_t);
+                gtp_info->teid = teid;
+                copy_address_shallow(&gtp_info->addr, &gtp_infod->addr);
+                wmem_map_insert(frame_map_deint_any, gtp_info, GUINT_TO_POINTER(frame));
+
             }
             else {
                 gtp_info = wmem_new0(wmem_file_scope(), gtp_info_t);
@@ -2818,10 +2837,19 @@ fill_map(wmem_list_t *teid_list, wmem_list_t *ip_list, uint32_t frame, uint32_t
                     session = GPOINTER_TO_UINT(wmem_map_lookup(session_table, GUINT_TO_POINTER(frame)));
                     if (session) {
                         /* If the msg has the same session ID and it's not the upd req we have to remove its info */
-                        wmem_map_foreach(session_table, remove_session_from_table, GUINT_TO_POINTER(session));
+                        remove_session_from_table(session);
                     }
                 }
                 wmem_map_insert(frame_map, gtp_info, GUINT_TO_POINTER(frame));
+
+                /* Not kept across iterations, as removing the session
+                 * above may have dropped this frame's list. */
+                keys = (wmem_list_t *)wmem_map_lookup(frame_keys, GUINT_TO_POINTER(frame));
+                if (keys == NULL) {
+                    keys = wmem_list_new(wmem_file_scope());
+                    wmem_map_insert(frame_keys, GUINT_TO_POINTER(frame), keys);
+                }
+                wmem_list_append(keys, gtp_info);
             }
 
             elem_teid = wmem_list_frame_next(elem_teid);
@@ -13413,6 +13441,9 @@ proto_register_gtp(void)
     frame_map = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), gtp_info_hash, gtp_info_equal);
     frame_map_deint = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), gtp_info_hash, gtp_info_deint_equal);
     teid_imsi = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
+    frame_keys = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
+    session_frames = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
+    frame_map_deint_any = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), gtp_info_hash, gtp_info_equal);
     register_init_routine(gtp_init);
     gtp_tap = register_tap("gtp");
     gtpv1_tap = register_tap("gtpv1");
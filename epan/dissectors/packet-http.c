@@ -271,6 +271,11 @@ static bool http_dechunk_body = true;
  */
 static bool http_decompress_body = true;
 
+/*
+ * Only uncompress bodies in passes that use them.
+ */
+static bool http_decompress_body_on_demand = false;
+
 /*
  * Extra checks for valid ASCII data in HTTP headers.
  */
@@ -418,7 +423,7 @@ http_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 	if(eo_info) { /* We have data waiting for us */
 		/* These values will be freed when the Export Object window
 		 * is closed. */
-		entry = g_new(export_object_entry_t, 1);
+		entry = g_new0(export_object_entry_t, 1);
 
 		entry->pkt_num = pinfo->num;
 		/* XXX: Should this remove the port, if any? It's only
@@ -723,43 +728,42 @@ http_stats_tree_packet(stats_tree* st, packet_info* pinfo, epan_dissect_t* edt _
 	const http_info_value_t* v = (const http_info_value_t*)p;
 	unsigned i = v->response_code;
 	int resp_grp;
-	const char *resp_str;
+	int resp_node;
 	char* str;
 
-	tick_stat_node(st, st_str_packets, 0, false);
+	tick_stat_node_by_id(st, st_node_packets);
 
 	if (i) {
-		tick_stat_node(st, st_str_responses, st_node_packets, false);
+		tick_stat_node_by_id(st, st_node_responses);
 
 		if ( (i<100)||(i>=600) ) {
 			resp_grp = st_node_resp_broken;
-			resp_str = st_str_resp_broken;
 		} else if (i<200) {
 			resp_grp = st_node_resp_100;
-			resp_str = st_str_resp_100;
 		} else if (i<300) {
 			resp_grp = st_node_resp_200;
-			resp_str = st_str_resp_200;
 		} else if (i<400) {
 			resp_grp = st_node_resp_300;
-			resp_str = st_str_resp_300;
 		} else if (i<500) {
 			resp_grp = st_node_resp_400;
-			resp_str = st_str_resp_400;
 		} else {
 			resp_grp = st_node_resp_500;
-			resp_str = st_str_resp_500;
 		}
 
-		tick_stat_node(st, resp_str, st_node_responses, false);
+		tick_stat_node_by_id(st, resp_grp);
 
-		str = wmem_strdup_printf(pinfo->pool, "%u %s", i,
-			   val_to_str(pinfo->pool, i, vals_http_status_code, "Unknown (%d)"));
-		tick_stat_node(st, str, resp_grp, false);
+		/* Only build the name the first time a status code is seen */
+		resp_node = stats_tree_node_id_by_key(st, resp_grp, i);
+		if (resp_node < 0) {
+			str = wmem_strdup_printf(pinfo->pool, "%u %s", i,
+				   val_to_str(pinfo->pool, i, vals_http_status_code, "Unknown (%d)"));
+			resp_node = stats_tree_create_node_by_key(st, str, resp_grp, i, STAT_DT_INT, false);
+		}
+		tick_stat_node_by_id(st, resp_node);
 	} else if (v->request_method) {
 		stats_tree_tick_pivot(st,st_node_requests,v->request_method);
 	} else {
-		tick_stat_node(st, st_str_other, st_node_packets, false);
+		tick_stat_node_by_id(st, st_node_other);
 	}
 
 	return TAP_PACKET_REDRAW;
@@ -2252,9 +2256,25 @@ dissecting_body:
 			tvbuff_t *uncomp_tvb = NULL;
 			proto_item *e_ti = NULL;
 			proto_tree *e_tree = NULL;
+			bool decompress_body = http_decompress_body;
+
+			/*
+			 * Uncompressing a large body is the most expensive
+			 * part of dissecting it. If nobody is going to see
+			 * the result in this pass, leave it until a pass
+			 * that builds a tree, such as when the frame is
+			 * selected, or one for Export Objects or Follow
+			 * Stream.
+			 */
+			if (decompress_body && http_decompress_body_on_demand &&
+			    tree == NULL &&
+			    !have_tap_listener(http_eo_tap) &&
+			    !have_tap_listener(http_follow_tap)) {
+				decompress_body = false;
+			}
 
 #if defined(HAVE_ZLIB) || defined(HAVE_ZLIBNG)
-			if (http_decompress_body &&
+			if (decompress_body &&
 			    (g_ascii_strcasecmp(headers->content_encoding, "gzip") == 0 ||
 			     g_ascii_strcasecmp(headers->content_encoding, "deflate") == 0 ||
 			     g_ascii_strcasecmp(headers->content_encoding, "x-gzip") == 0 ||
@@ -2266,7 +2286,7 @@ dissecting_body:
 #endif
 
 #ifdef HAVE_BROTLI
-			if (http_decompress_body &&
+			if (decompress_body &&
 			    g_ascii_strcasecmp(headers->content_encoding, "br") == 0)
 			{
 				uncomp_tvb = tvb_child_uncompress_brotli(tvb, next_tvb, 0,
@@ -2275,7 +2295,7 @@ dissecting_body:
 #endif
 
 #ifdef HAVE_SNAPPY
-			if (http_decompress_body &&
+			if (decompress_body &&
 			    g_ascii_strcasecmp(headers->content_encoding, "snappy") == 0)
 			{
 				uncomp_tvb = tvb_child_uncompress_snappy(tvb, next_tvb, 0,
@@ -2284,7 +2304,7 @@ dissecting_body:
 #endif
 
 #ifdef HAVE_ZSTD
-			if (http_decompress_body &&
+			if (decompress_body &&
 			    g_ascii_strcasecmp(headers->content_encoding, "zstd") == 0)
 			{
 				uncomp_tvb = tvb_child_uncompress_zstd(tvb, next_tvb, 0,
@@ -2292,7 +2312,7 @@ dissecting_body:
 			}
 #endif
 
-			if (http_decompress_body &&
+			if (decompress_body &&
 			    g_ascii_strcasecmp(headers->content_encoding, "xpress") == 0)
 			{
 				/*
@@ -2370,7 +2390,7 @@ dissecting_body:
 				add_new_data_source(pinfo, next_tvb,
 				    "Uncompressed entity body");
 			} else {
-				if (http_decompress_body) {
+				if (decompress_body) {
 					/* XXX - We should distinguish between "failed", "unsupported
 					 * only because support wasn't compiled in", and "unsupported
 					 * by Wireshark", to indicate whether the problem is with
@@ -2378,7 +2398,7 @@ dissecting_body:
 					 */
 					expert_add_info(pinfo, e_ti, &ei_http_decompression_failed);
 				}
-				else {
+				else if (!http_decompress_body) {
 					expert_add_info(pinfo, e_ti, &ei_http_decompression_disabled);
 				}
 				/* XXX: Should this be sent to the follow tap? */
@@ -5013,6 +5033,13 @@ proto_register_http(void)
 	    "Whether to uncompress entity bodies that are compressed "
 	    "using \"Content-Encoding: \"",
 	    &http_decompress_body);
+	prefs_register_bool_preference(http_module, "decompress_body_on_demand",
+	    "Uncompress entity bodies only when needed",
+	    "Whether to skip uncompressing entity bodies when no protocol tree "
+	    "is being built and neither Export Objects nor Follow Stream is "
+	    "active. Protocols carried in a compressed body are then only "
+	    "dissected when its frame is dissected with a tree.",
+	    &http_decompress_body_on_demand);
 	prefs_register_bool_preference(http_module, "check_ascii_headers",
 	    "Reject non-ASCII headers as invalid HTTP",
 	    "Whether to treat non-ASCII in headers as non-HTTP data "
@@ -580,6 +580,12 @@ static const fragment_items http2_body_fragment_items = {
 static wmem_map_t *http2_hdrcache_map;
 /* Header name_length + name + value_length + value */
 static char *http2_header_pstr;
+/* Decompressed header blocks (wmem_array_t of http2_header_t) are
+   kept for every HEADERS frame.  Since the header fields themselves
+   are shared through http2_hdrcache_map, repeated blocks (common with
+   gRPC) have identical contents and are shared as a whole through
+   this map as well. */
+static wmem_map_t *http2_hdrblock_map;
 #endif
 
 #ifdef HAVE_NGHTTP2
@@ -1401,6 +1407,7 @@ hd_inflate_del_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_, vo
     nghttp2_hd_inflate_del((nghttp2_hd_inflater*)user_data);
     http2_hdrcache_map = NULL;
     http2_header_pstr = NULL;
+    http2_hdrblock_map = NULL;
 
     return false;
 }
@@ -1932,15 +1939,14 @@ process_http2_header_repr_info(wmem_array_t *headers,
 
         if(header_repr_info->complete) {
             if(header_repr_info->type == HTTP2_HD_HEADER_TABLE_SIZE_UPDATE) {
-                http2_header_t *out;
+                /* Zeroed, header blocks are compared bytewise. */
+                http2_header_t out = { 0 };
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                out.type = header_repr_info->type;
+                out.length = i - start;
+                out.table.header_table_size = header_repr_info->integer;
 
-                out->type = header_repr_info->type;
-                out->length = i - start;
-                out->table.header_table_size = header_repr_info->integer;
-
-                wmem_array_append(headers, out, 1);
+                wmem_array_append(headers, &out, 1);
 
                 reset_http2_header_repr_info(header_repr_info);
                 /* continue to decode header table size update or
@@ -1982,6 +1988,24 @@ static gboolean http2_hdrcache_equal(const void *lhs, const void *rhs)
     return alen == blen && memcmp(a, b, alen) == 0;
 }
 
+static unsigned http2_hdrblock_hash(const void *key)
+{
+    wmem_array_t *headers = (wmem_array_t *)key;
+
+    return wmem_strong_hash((const uint8_t *)wmem_array_get_raw(headers),
+                            wmem_array_get_count(headers) * sizeof(http2_header_t));
+}
+
+static gboolean http2_hdrblock_equal(const void *lhs, const void *rhs)
+{
+    wmem_array_t *a = (wmem_array_t *)lhs;
+    wmem_array_t *b = (wmem_array_t *)rhs;
+    unsigned count = wmem_array_get_count(a);
+
+    return count == wmem_array_get_count(b) &&
+           memcmp(wmem_array_get_raw(a), wmem_array_get_raw(b), count * sizeof(http2_header_t)) == 0;
+}
+
 /* If we are in a HEADERS or PUSH_PROMISE context, return the stream id
  * the headers describe. (For PUSH_PROMISE or CONTIUATIONs thereof, this
  * is the promised stream id.) Otherwise return 0.
@@ -2438,6 +2462,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, unsigned offset, p
     http2_header_repr_info_t *header_repr_info;
     wmem_list_t *header_list;
     wmem_array_t *headers;
+    wmem_array_t *cached_headers;
     unsigned i;
     const char *method_header_value = NULL;
     const char *path_header_value = NULL;
@@ -2447,6 +2472,9 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, unsigned offset, p
     if (!http2_hdrcache_map) {
         http2_hdrcache_map = wmem_map_new(wmem_file_scope(), http2_hdrcache_hash, http2_hdrcache_equal);
     }
+    if (!http2_hdrblock_map) {
+        http2_hdrblock_map = wmem_map_new(wmem_file_scope(), http2_hdrblock_hash, http2_hdrblock_equal);
+    }
 
     header_data = (http2_header_data_t*)p_get_proto_data(wmem_file_scope(), pinfo, proto_http2, PROTO_DATA_KEY_HEADER);
     header_list = header_data->header_list;
@@ -2473,7 +2501,9 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, unsigned offset, p
 
         final = flags & HTTP2_FLAGS_END_HEADERS;
 
-        headers = wmem_array_sized_new(wmem_file_scope(), sizeof(http2_header_t), 16);
+        /* Collect the block in packet scope first, only its final
+           (possibly shared) copy is kept for the file. */
+        headers = wmem_array_sized_new(pinfo->pool, sizeof(http2_header_t), 16);
 
         for(;;) {
             nghttp2_nv nv;
@@ -2500,7 +2530,8 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, unsigned offset, p
                 char *cached_pstr;
                 uint32_t len;
                 unsigned datalen = (unsigned)(4 + nv.namelen + 4 + nv.valuelen);
-                http2_header_t *out;
+                /* Zeroed, header blocks are compared bytewise. */
+                http2_header_t out = { 0 };
 
                 if (decompressed_bytes + datalen >= MAX_HTTP2_HEADER_SIZE) {
                     header_data->header_size_reached = decompressed_bytes;
@@ -2508,13 +2539,11 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, unsigned offset, p
                     break;
                 }
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                out.type = header_repr_info->type;
+                out.length = rv;
+                out.table.data.idx = header_repr_info->integer;
 
-                out->type = header_repr_info->type;
-                out->length = rv;
-                out->table.data.idx = header_repr_info->integer;
-
-                out->table.data.datalen = datalen;
+                out.table.data.datalen = datalen;
                 decompressed_bytes += datalen;
 
                 /* Prepare buffer... with the following format
@@ -2523,7 +2552,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, unsigned offset, p
                    value length (uint32)
                    value (string)
                 */
-                http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, out->table.data.datalen);
+                http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, out.table.data.datalen);
 
                 /* nv.namelen and nv.valuelen are of size_t.  In order
                    to get length in 4 bytes, we have to copy it to
@@ -2538,14 +2567,14 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, unsigned offset, p
 
                 cached_pstr = (char *)wmem_map_lookup(http2_hdrcache_map, http2_header_pstr);
                 if (cached_pstr) {
-                    out->table.data.data = cached_pstr;
+                    out.table.data.data = cached_pstr;
                 } else {
                     wmem_map_insert(http2_hdrcache_map, http2_header_pstr, http2_header_pstr);
-                    out->table.data.data = http2_header_pstr;
+                    out.table.data.data = http2_header_pstr;
                     http2_header_pstr = NULL;
                 }
 
-                wmem_array_append(headers, out, 1);
+                wmem_array_append(headers, &out, 1);
 
                 reset_http2_header_repr_info(header_repr_info);
             }
@@ -2559,6 +2588,15 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, unsigned offset, p
             }
         }
 
+        cached_headers = (wmem_array_t *)wmem_map_lookup(http2_hdrblock_map, headers);
+        if (!cached_headers) {
+            cached_headers = wmem_array_sized_new(wmem_file_scope(), sizeof(http2_header_t),
+                                                  wmem_array_get_count(headers));
+            wmem_array_append(cached_headers, wmem_array_get_raw(headers), wmem_array_get_count(headers));
+            wmem_map_insert(http2_hdrblock_map, cached_headers, cached_headers);
+        }
+        headers = cached_headers;
+
         wmem_list_append(header_list, headers);
 
         if(!header_data->current) {
@@ -1121,27 +1121,25 @@ dissect_http3_headers(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, unsig
              * Check whether the decoder has emitted header data.
              */
             if (flags & NGHTTP3_QPACK_DECODE_FLAG_EMIT) {
-                http3_header_field_t  *out;
+                http3_header_field_t  out = { 0 };
 
                 ws_noisy("Emit nread=%d flags=%" PRIu8 "", nread, flags);
 
-                /* Create an output field and add it to the headers array */
-                out = wmem_new0(wmem_file_scope(), http3_header_field_t);
-
                 /* Populate the `encoded' portion. */
-                out->encoded.len    = nread;
-                out->encoded.offset = header_data->encoded.pos;
+                out.encoded.len    = nread;
+                out.encoded.offset = header_data->encoded.pos;
 
                 /* Populate the `decoded' portion. */
-                get_header_field_pstr(pinfo->pool, &nv, &out->decoded.bytes, &out->decoded.len);
+                get_header_field_pstr(pinfo->pool, &nv, &out.decoded.bytes, &out.decoded.len);
 
-                /* Add the decoded header field to the header data. */
+                /* Add the decoded header field to the header data, the
+                 * array keeps its own copy of the field. */
                 if (header_data->header_fields == NULL) {
                     header_data->header_fields = wmem_array_new(wmem_file_scope(), sizeof(http3_header_field_t));
                 }
-                wmem_array_append(header_data->header_fields, out, 1);
+                wmem_array_append(header_data->header_fields, &out, 1);
 
-                header_len += out->decoded.len;
+                header_len += out.decoded.len;
 
             } else {
                 proto_tree_add_expert_format(tree, pinfo, &ei_http3_header_decoding_no_output, tvb, tvb_offset, 0,
@@ -162,7 +162,7 @@ imf_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
   if(eo_info) { /* We have data waiting for us */
     /* These values will be freed when the Export Object window
      * is closed. */
-    entry = g_new(export_object_entry_t, 1);
+    entry = g_new0(export_object_entry_t, 1);
 
     char *start = g_strrstr_len(eo_info->sender_data, -1, "<");
     char *stop = g_strrstr_len(eo_info->sender_data, -1,  ">");
@@ -305,6 +305,15 @@ static extra_esp_sa_records_t extra_esp_sa_records;
 static uat_t * esp_uat;
 static unsigned num_sa_uat;
 
+/* Index of the UAT SAs, built when first needed after the UAT changes:
+   the SAs with a plain SPI by SPI value, and those whose SPI has
+   wildcards in a list. Both hold indexes into uat_esp_sa_records in
+   table order, so that the first matching SA still wins. */
+static GHashTable *esp_sa_spi_index;      /* SPI -> GArray of unsigned */
+static GArray *esp_sa_wildcard_records;   /* of unsigned */
+static bool esp_sa_index_valid;
+static unsigned esp_sa_index_count;       /* num_sa_uat when built */
+
 /*
    Name : static int compute_ascii_key(char **ascii_key, char *key)
    Description : Allocate memory for the key and transform the key if it is hexadecimal
@@ -493,6 +502,102 @@ static void uat_esp_sa_record_free_cb(void*r) {
   }
 }
 
+static void esp_sa_index_free_array(void *data)
+{
+  g_array_free((GArray *)data, true);
+}
+
+static void uat_esp_sa_post_update_cb(void)
+{
+  esp_sa_index_valid = false;
+}
+
+static void esp_sa_index_build(void)
+{
+  unsigned i;
+
+  if (esp_sa_spi_index == NULL) {
+    esp_sa_spi_index = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, esp_sa_index_free_array);
+    esp_sa_wildcard_records = g_array_new(false, false, sizeof(unsigned));
+  }
+  g_hash_table_remove_all(esp_sa_spi_index);
+  g_array_set_size(esp_sa_wildcard_records, 0);
+
+  for (i = 0; i < num_sa_uat; i++) {
+    const char *filter = uat_esp_sa_records[i].spi;
+    unsigned long spi;
+    GArray *records;
+
+    if (filter == NULL) {
+      continue;
+    }
+    if (strchr(filter, IPSEC_SA_WILDCARDS_ANY) != NULL) {
+      g_array_append_val(esp_sa_wildcard_records, i);
+      continue;
+    }
+    spi = strtoul(filter, NULL, 0);
+    if (spi > UINT32_MAX) {
+      /* filter_spi_match() would never match it */
+      continue;
+    }
+    records = (GArray *)g_hash_table_lookup(esp_sa_spi_index, GUINT_TO_POINTER(spi));
+    if (records == NULL) {
+      records = g_array_new(false, false, sizeof(unsigned));
+      g_hash_table_insert(esp_sa_spi_index, GUINT_TO_POINTER(spi), records);
+    }
+    g_array_append_val(records, i);
+  }
+  esp_sa_index_valid = true;
+  esp_sa_index_count = num_sa_uat;
+}
+
+/* The SAs that may match a SPI, in the order they are to be tried:
+   the ones added by dissectors, then those from the UAT. */
+typedef struct {
+  unsigned extra;
+  GArray *exact;
+  unsigned exact_pos;
+  unsigned wildcard_pos;
+} esp_sa_iter_t;
+
+static void esp_sa_iter_init(esp_sa_iter_t *iter, unsigned spi)
+{
+  if (!esp_sa_index_valid || esp_sa_index_count != num_sa_uat) {
+    esp_sa_index_build();
+  }
+  iter->extra = 0;
+  iter->exact = (GArray *)g_hash_table_lookup(esp_sa_spi_index, GUINT_TO_POINTER(spi));
+  iter->exact_pos = 0;
+  iter->wildcard_pos = 0;
+}
+
+static uat_esp_sa_record_t *esp_sa_iter_next(esp_sa_iter_t *iter)
+{
+  unsigned exact_idx = UINT_MAX;
+  unsigned wildcard_idx = UINT_MAX;
+
+  if (iter->extra < extra_esp_sa_records.num_records) {
+    return &extra_esp_sa_records.records[iter->extra++];
+  }
+
+  if (iter->exact != NULL && iter->exact_pos < iter->exact->len) {
+    exact_idx = g_array_index(iter->exact, unsigned, iter->exact_pos);
+  }
+  if (iter->wildcard_pos < esp_sa_wildcard_records->len) {
+    wildcard_idx = g_array_index(esp_sa_wildcard_records, unsigned, iter->wildcard_pos);
+  }
+
+  if (exact_idx < wildcard_idx) {
+    iter->exact_pos++;
+    return &uat_esp_sa_records[exact_idx];
+  }
+  if (wildcard_idx != UINT_MAX) {
+    iter->wildcard_pos++;
+    return &uat_esp_sa_records[wildcard_idx];
+  }
+  return NULL;
+}
+
 UAT_VS_DEF(uat_esp_sa_records, protocol, uat_esp_sa_record_t, uint8_t, IPSEC_SA_IPV4, "IPv4")
 UAT_CSTRING_CB_DEF(uat_esp_sa_records, srcIP, uat_esp_sa_record_t)
 UAT_CSTRING_CB_DEF(uat_esp_sa_records, dstIP, uat_esp_sa_record_t)
@@ -1182,25 +1287,16 @@ get_esp_sa(wmem_allocator_t* scope,
   )
 {
   bool found = false;
-  unsigned i, j;
+  esp_sa_iter_t iter;
+  uat_esp_sa_record_t *record;
 
   *cipher_hd = NULL;
   *cipher_hd_created = NULL;
 
-  /* Check each known SA in turn */
-  for (i = 0, j=0; (found == false) && ((i < num_sa_uat) || (j < extra_esp_sa_records.num_records)); )
+  /* Check each SA that may have this SPI in turn */
+  esp_sa_iter_init(&iter, spi);
+  while ((found == false) && ((record = esp_sa_iter_next(&iter)) != NULL))
   {
-    /* Get the next record to try */
-    uat_esp_sa_record_t *record;
-    if (j < extra_esp_sa_records.num_records) {
-      /* Extra ones checked first */
-      record = &extra_esp_sa_records.records[j++];
-    }
-    else {
-      /* Then UAT ones */
-      record = &uat_esp_sa_records[i++];
-    }
-
     if((protocol_typ == record->protocol || record->protocol == IPSEC_SA_ANY)
        && (filter_address_match(scope, src, record->srcIP, protocol_typ) || record->protocol == IPSEC_SA_ANY)
        && (filter_address_match(scope, dst, record->dstIP, protocol_typ) || record->protocol == IPSEC_SA_ANY)
@@ -2899,8 +2995,8 @@ proto_register_ipsec(void)
             uat_esp_sa_record_copy_cb,      /* copy callback */
             uat_esp_sa_record_update_cb,    /* update callback */
             uat_esp_sa_record_free_cb,      /* free callback */
-            NULL,                           /* post update callback */
-            NULL,                           /* reset callback */
+            uat_esp_sa_post_update_cb,      /* post update callback */
+            uat_esp_sa_post_update_cb,      /* reset callback */
             esp_uat_flds);                  /* UAT field definitions */
 
   static const char *esp_uat_defaults_[] = {
@@ -1778,8 +1778,50 @@ struct decrypt_krb5_with_cb_state {
 	void *decrypt_cb_data;
 	unsigned count;
 	enc_key_t *ek;
+	bool ek_derived;
 };
 
+/*
+ * With a large keytab most keys are of the same type, so trying every
+ * key of the right type means thousands of trial decryptions of each
+ * blob. Usually a handful of keys, such as the krbtgt key and those
+ * of the busiest services, decrypt almost everything, so the keys
+ * that worked most recently are tried first, and the key that
+ * decrypted a blob is remembered so it is tried first on revisits.
+ * Either way a key is only used once it has decrypted the blob.
+ */
+#define KERBEROS_RECENT_KEYS_MAX 32
+
+typedef struct {
+	uint32_t frame;
+	int usage;
+	unsigned offset;
+	unsigned length;
+} kerberos_blob_key_t;
+
+/* blob -> enc_key_t that decrypted it */
+static wmem_map_t *kerberos_blob_keys;
+/* key map -> wmem_list_t of the keys from it that worked most recently */
+static wmem_map_t *kerberos_recent_keys;
+
+static unsigned
+kerberos_blob_key_hash(const void *k)
+{
+	const kerberos_blob_key_t *key = (const kerberos_blob_key_t *)k;
+
+	return wmem_strong_hash((const uint8_t *)key, sizeof(*key));
+}
+
+static gboolean
+kerberos_blob_key_equal(const void *k1, const void *k2)
+{
+	const kerberos_blob_key_t *key1 = (const kerberos_blob_key_t *)k1;
+	const kerberos_blob_key_t *key2 = (const kerberos_blob_key_t *)k2;
+
+	return key1->frame == key2->frame && key1->usage == key2->usage &&
+	       key1->offset == key2->offset && key1->length == key2->length;
+}
+
 static void
 decrypt_krb5_with_cb_try_key(void *__key _U_, void *value, void *userdata)
 {
@@ -1905,6 +1947,7 @@ decrypt_krb5_with_cb_try_key(void *__key _U_, void *value, void *userdata)
 			 * remember the key and stop traversing
 			 */
 			state->ek = state->private_data->last_added_key;
+			state->ek_derived = true;
 			return;
 		}
 		krb5_free_keyblock(keytab_krb5_ctx, k);
@@ -1960,6 +2003,7 @@ decrypt_krb5_with_cb_try_key(void *__key _U_, void *value, void *userdata)
 			 * remember the key and stop traversing
 			 */
 			state->ek = state->private_data->last_added_key;
+			state->ek_derived = true;
 			return;
 		}
 		krb5_free_keyblock(keytab_krb5_ctx, k);
@@ -2016,6 +2060,10 @@ decrypt_krb5_with_cb(proto_tree *tree,
 {
 	const char *key_map_name = NULL;
 	wmem_map_t *key_map = NULL;
+	wmem_list_t *recent_keys;
+	wmem_list_frame_t *frame;
+	kerberos_blob_key_t blob_key = { 0, };
+	enc_key_t *blob_ek;
 	struct decrypt_krb5_with_cb_state state = {
 		.tree = tree,
 		.pinfo = pinfo,
@@ -2042,7 +2090,63 @@ decrypt_krb5_with_cb(proto_tree *tree,
 		break;
 	}
 
-	wmem_map_foreach(key_map, decrypt_krb5_with_cb_try_key, &state);
+	if (kerberos_blob_keys == NULL) {
+		kerberos_blob_keys = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+							    kerberos_blob_key_hash,
+							    kerberos_blob_key_equal);
+		kerberos_recent_keys = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+							      g_direct_hash, g_direct_equal);
+	}
+
+	recent_keys = (wmem_list_t *)wmem_map_lookup(kerberos_recent_keys, key_map);
+	if (recent_keys == NULL) {
+		recent_keys = wmem_list_new(wmem_file_scope());
+		wmem_map_insert(kerberos_recent_keys, key_map, recent_keys);
+	}
+
+	if (cryptotvb != NULL) {
+		blob_key.frame = pinfo->num;
+		blob_key.usage = usage;
+		blob_key.offset = tvb_raw_offset(cryptotvb);
+		blob_key.length = tvb_reported_length(cryptotvb);
+		blob_ek = (enc_key_t *)wmem_map_lookup(kerberos_blob_keys, &blob_key);
+		if (blob_ek != NULL) {
+			decrypt_krb5_with_cb_try_key(NULL, blob_ek, &state);
+		}
+	}
+
+	for (frame = wmem_list_head(recent_keys);
+	     state.ek == NULL && frame != NULL;
+	     frame = wmem_list_frame_next(frame)) {
+		decrypt_krb5_with_cb_try_key(NULL, wmem_list_frame_data(frame), &state);
+	}
+
+	if (state.ek == NULL) {
+		wmem_map_foreach(key_map, decrypt_krb5_with_cb_try_key, &state);
+	}
+
+	if (state.ek != NULL && !state.ek_derived) {
+		/*
+		 * Keys derived with the FAST armor or strengthen key are
+		 * added by add_encryption_key() on every pass, so they
+		 * have to be derived again rather than remembered.
+		 */
+		if (cryptotvb != NULL &&
+		    wmem_map_lookup(kerberos_blob_keys, &blob_key) == NULL) {
+			wmem_map_insert(kerberos_blob_keys,
+					wmem_memdup(wmem_file_scope(), &blob_key, sizeof(blob_key)),
+					state.ek);
+		}
+		if (wmem_list_head(recent_keys) == NULL ||
+		    wmem_list_frame_data(wmem_list_head(recent_keys)) != state.ek) {
+			wmem_list_remove(recent_keys, state.ek);
+			wmem_list_prepend(recent_keys, state.ek);
+			if (wmem_list_count(recent_keys) > KERBEROS_RECENT_KEYS_MAX) {
+				wmem_list_remove_frame(recent_keys, wmem_list_tail(recent_keys));
+			}
+		}
+	}
+
 	if (state.ek != NULL) {
 		used_encryption_key(tree, pinfo, private_data,
 				    state.ek, usage, cryptotvb,
@@ -296,6 +296,30 @@ typedef struct _v9_v10_tmplt_entry {
     const char *pen_str;
 } v9_v10_tmplt_entry_t;
 
+/*
+ * A template's fields as its data records are decoded: without the
+ * zero-length fields, and with what the template alone determines
+ * worked out when the template is stored, rather than for every field
+ * of every record.
+ */
+typedef struct _v9_v10_plan_entry {
+    uint64_t     pen_type;
+    uint32_t     pen;
+    const char  *pen_str;
+    uint16_t     type;
+    uint16_t     masked_type;
+    uint16_t     length;          /* VARIABLE_LENGTH for a variable length field */
+    int          rev;             /* 1 if a reverse (RFC 5103) field */
+} v9_v10_plan_entry_t;
+
+typedef struct _v9_v10_tmplt_plan {
+    unsigned     vspec;           /* the version the plan was made for */
+    unsigned     count;
+    v9_v10_plan_entry_t *entries;
+    uint32_t     pies;            /* bit n: a field belongs to v10_pie_items[n] */
+    bool         tree_only;       /* fixed length fields that only add to the tree */
+} v9_v10_tmplt_plan_t;
+
 typedef enum {
     TF_SCOPES=0,
     TF_ENTRIES,
@@ -327,6 +351,7 @@ typedef struct _v9_v10_tmplt {
     unsigned length;
     uint16_t field_count[TF_NUM];                /* 0:scopes; 1:entries  */
     v9_v10_tmplt_entry_t *fields_p[TF_NUM_EXT];  /* 0:scopes; 1:entries; n:vendor_entries  */
+    v9_v10_tmplt_plan_t *plan[TF_NUM];           /* 0:scopes; 1:entries  */
 } v9_v10_tmplt_t;
 
 
@@ -4280,6 +4305,9 @@ static unsigned dissect_v9_pdu_scope(tvbuff_t *tvb, packet_info *pinfo, proto_tr
 static unsigned dissect_v9_v10_pdu_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree,
                                         int offset, v9_v10_tmplt_t *tmplt_p, hdrinfo_t *hdrinfo_p,
                                         v9_v10_tmplt_fields_type_t fields_type);
+static v9_v10_tmplt_plan_t *v9_v10_tmplt_get_plan(v9_v10_tmplt_t *tmplt_p, v9_v10_tmplt_fields_type_t fields_type,
+                                                  unsigned vspec);
+static bool     v9_v10_tmplt_tree_only(v9_v10_tmplt_t *tmplt_p, unsigned vspec);
 static int      dissect_v9_v10_options_template(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree,
                                                 int offset, int len, hdrinfo_t *hdrinfo_p, uint16_t flowset_id);
 static int      dissect_v9_v10_data_template(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree,
@@ -5133,6 +5161,15 @@ dissect_v9_v10_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree, int
         }
         proto_item_set_generated(ti);
 
+        if (pdutree == NULL && v9_v10_tmplt_tree_only(tmplt_p, hdrinfo_p->vspec)) {
+            /* The records would only add to the tree, so just count them. */
+            unsigned records = length / tmplt_p->length;
+
+            tvb_ensure_bytes_exist(tvb, offset, records * tmplt_p->length);
+            *flows_seen += records;
+            return 0;
+        }
+
         /* Note: If the flow contains variable length fields then          */
         /*       tmplt_p->length will be less then actual length of the flow. */
         while (length >= tmplt_p->length) {
@@ -5330,6 +5367,144 @@ dissect_v10_pdu_subtemplate_list(tvbuff_t* tvb, packet_info* pinfo, proto_item*
     }
 }
 
+/* Known PIEs, with a hidden item to filter on any of their fields. */
+static const struct {
+    uint32_t  pen;
+    int      *hf;
+} v10_pie_items[] = {
+    { VENDOR_CACE,             &hf_pie_cace },
+    { VENDOR_PLIXER,           &hf_pie_plixer },
+    { VENDOR_NTOP,             &hf_pie_ntop },
+    { VENDOR_IXIA,             &hf_pie_ixia },
+    { VENDOR_NETSCALER,        &hf_pie_netscaler },
+    { VENDOR_BARRACUDA,        &hf_pie_barracuda },
+    { VENDOR_GIGAMON,          &hf_pie_gigamon },
+    { VENDOR_CISCO,            &hf_pie_cisco },
+    { VENDOR_NIAGARA_NETWORKS, &hf_pie_niagara_networks },
+    { VENDOR_JUNIPER,          &hf_pie_juniper },
+};
+
+/* Whether a field does anything but add to the tree, such as calling another dissector. */
+static bool
+v9_v10_field_tree_only(uint64_t pen_type)
+{
+    if (pen_type >= 0x8000) {
+        /* Enterprise and v9 vendor fields; some of these do more. */
+        return false;
+    }
+
+    switch (pen_type) {
+    case 291: /* basicList */
+    case 292: /* subTemplateList */
+    case 293: /* subTemplateMultiList */
+    case 315: /* dataLinkFrameSection */
+        return false;
+    default:
+        return true;
+    }
+}
+
+/* Make the plan for decoding a template's scope fields or its entries. */
+static v9_v10_tmplt_plan_t *
+v9_v10_tmplt_make_plan(const v9_v10_tmplt_t *tmplt_p, v9_v10_tmplt_fields_type_t fields_type, unsigned vspec)
+{
+    const v9_v10_tmplt_entry_t *entries_p = tmplt_p->fields_p[fields_type];
+    v9_v10_tmplt_plan_t        *plan;
+    unsigned                    i, n;
+
+    plan = wmem_new0(wmem_file_scope(), v9_v10_tmplt_plan_t);
+    plan->vspec = vspec;
+    plan->tree_only = true;
+    plan->entries = wmem_alloc_array(wmem_file_scope(), v9_v10_plan_entry_t, tmplt_p->field_count[fields_type]);
+
+    for (i = 0; i < tmplt_p->field_count[fields_type]; i++) {
+        v9_v10_plan_entry_t *entry;
+
+        if (entries_p[i].length == 0) {
+            /* XXX: Zero length fields probably shouldn't be included in the cached template */
+            /* YYY: Maybe.  If you don't cache the zero length fields can you still compare that you actually */
+            /* have the same template with the same ID. */
+            /* XXX: One capture has been seen wherein the "length" field in the template is 0 even though
+                    the field is actually present in the dataflow.
+                    See: https://gitlab.com/wireshark/wireshark/-/issues/10432#c1
+            */
+            continue;
+        }
+
+        entry = &plan->entries[plan->count++];
+        entry->type    = entries_p[i].type;
+        entry->length  = entries_p[i].length;
+        entry->pen     = entries_p[i].pen;
+        entry->pen_str = entries_p[i].pen_str;
+
+        /*  v9 types
+         *    0x 0000 0000 0000 to
+         *    0x 0000 0000 ffff
+         *  v10 global types (presumably consistent with v9 types 0x0000 - 0x7fff)
+         *    0x 0000 0000 0000 to
+         *    0x 0000 0000 7fff
+         *  V10 Enterprise types
+         *    0x 0000 0001 0000 to
+         *    0x ffff ffff 7fff
+         */
+        entry->pen_type = entry->masked_type = entry->type;
+        entry->rev      = 0;
+
+        if ((vspec == 10) && (entry->type & 0x8000)) {
+            entry->pen_type = entry->masked_type = entry->type & 0x7fff;
+            if (entry->pen == REVPEN) { /* reverse PEN */
+                entry->rev = 1;
+            } else if (entry->pen == 0) {
+                entry->pen_type = (UINT64_C(0xffff) << 16) | entry->pen_type;  /* hack to force "unknown" */
+            } else {
+                entry->pen_type = (((uint64_t)entry->pen) << 16) | entry->pen_type;
+            }
+        }
+
+        for (n = 0; n < array_length(v10_pie_items); n++) {
+            if (entry->pen == v10_pie_items[n].pen) {
+                plan->pies |= 1U << n;
+            }
+        }
+
+        if (entry->length == VARIABLE_LENGTH || !v9_v10_field_tree_only(entry->pen_type)) {
+            plan->tree_only = false;
+        }
+    }
+
+    return plan;
+}
+
+static v9_v10_tmplt_plan_t *
+v9_v10_tmplt_get_plan(v9_v10_tmplt_t *tmplt_p, v9_v10_tmplt_fields_type_t fields_type, unsigned vspec)
+{
+    if (tmplt_p->fields_p[fields_type] == NULL) {
+        return NULL;
+    }
+    if (tmplt_p->plan[fields_type] == NULL || tmplt_p->plan[fields_type]->vspec != vspec) {
+        tmplt_p->plan[fields_type] = v9_v10_tmplt_make_plan(tmplt_p, fields_type, vspec);
+    }
+    return tmplt_p->plan[fields_type];
+}
+
+/* Whether the template's records would only add to the tree, each taking tmplt_p->length bytes. */
+static bool
+v9_v10_tmplt_tree_only(v9_v10_tmplt_t *tmplt_p, unsigned vspec)
+{
+    v9_v10_tmplt_plan_t *plan;
+
+    if (tmplt_p->field_count[TF_SCOPES] > 0) {
+        plan = v9_v10_tmplt_get_plan(tmplt_p, TF_SCOPES, vspec);
+        /* v9 scope fields are always shown as their fixed length. */
+        if (plan != NULL && vspec == 10 && !plan->tree_only) {
+            return false;
+        }
+    }
+
+    plan = v9_v10_tmplt_get_plan(tmplt_p, TF_ENTRIES, vspec);
+    return plan != NULL && plan->tree_only;
+}
+
 static unsigned
 // NOLINTNEXTLINE(misc-no-recursion)
 dissect_v9_v10_pdu_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree, int offset,
@@ -5369,27 +5544,15 @@ dissect_v9_v10_pdu_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree,
 
     proto_item           *ti;
     proto_item           *cti;
-    uint16_t              count;
-    v9_v10_tmplt_entry_t *entries_p;
+    unsigned              count;
+    v9_v10_tmplt_plan_t  *plan;
     proto_tree           *fwdstattree;
 
-    bool                 cace_pie_seen = false,
-                         plixer_pie_seen = false,
-                         ntop_pie_seen = false,
-                         ixia_pie_seen = false,
-                         netscaler_pie_seen = false,
-                         barracuda_pie_seen = false,
-                         gigamon_pie_seen = false,
-                         cisco_pie_seen = false,
-                         niagara_networks_pie_seen = false,
-                         juniper_networks_pie_seen = false;
-
-
     uint8_t      ip_protocol = 0;
     uint16_t     port_number;
 
-    entries_p = tmplt_p->fields_p[fields_type];
-    if (entries_p == NULL) {
+    plan = v9_v10_tmplt_get_plan(tmplt_p, fields_type, hdrinfo_p->vspec);
+    if (plan == NULL) {
         /* I don't think we can actually hit this condition.
            If we can, what would cause it?  Does this need a
            warn?  If so, what?
@@ -5397,14 +5560,23 @@ dissect_v9_v10_pdu_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree,
         return 0;
     }
     orig_offset   = offset;
-    count         = tmplt_p->field_count[fields_type];
+    count         = plan->count;
+
+    /* Provide a convenient (hidden) filter for any items belonging to a known PIE. */
+    for (i = 0; i < (int)array_length(v10_pie_items); i++) {
+        if (plan->pies & (1U << i)) {
+            proto_item *pie_ti = proto_tree_add_item(pdutree, *v10_pie_items[i].hf, tvb, 0, 0, ENC_NA);
+            proto_item_set_hidden(pie_ti);
+        }
+    }
 
     for (i=0; i < (int)duration_type_max; i++) {
         offset_s[0][i]   = offset_s[1][i] = offset_e[0][i] = offset_e[1][i] = 0;
         msec_start[0][i] = msec_start[1][i] = msec_end[0][i] = msec_end[1][i] = 0;
     }
 
-    for (i = 0; i < count; i++) {
+    for (i = 0; i < (int)count; i++) {
+        const v9_v10_plan_entry_t *entry = &plan->entries[i];
         uint64_t     pen_type;
         uint16_t     type;
         uint16_t     masked_type;
@@ -5413,20 +5585,11 @@ dissect_v9_v10_pdu_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree,
         const char *pen_str;
         int          vstr_len;
 
-        type    = entries_p[i].type;
-        length  = entries_p[i].length;
-        pen     = entries_p[i].pen;
-        pen_str = entries_p[i].pen_str;
+        type    = entry->type;
+        length  = entry->length;
+        pen     = entry->pen;
+        pen_str = entry->pen_str;
 
-        if (length == 0) { /* XXX: Zero length fields probably shouldn't be included in the cached template */
-            /* YYY: Maybe.  If you don't cache the zero length fields can you still compare that you actually */
-            /* have the same template with the same ID. */
-            /* XXX: One capture has been seen wherein the "length" field in the template is 0 even though
-                    the field is actually present in the dataflow.
-                    See: https://gitlab.com/wireshark/wireshark/-/issues/10432#c1
-            */
-            continue;
-        }
         /* See if variable length field */
         vstr_len = 0;
         if (length == VARIABLE_LENGTH) {
@@ -5443,107 +5606,9 @@ dissect_v9_v10_pdu_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree,
             gen_str_offset = offset;
         }
 
-        /*  v9 types
-         *    0x 0000 0000 0000 to
-         *    0x 0000 0000 ffff
-         *  v10 global types (presumably consistent with v9 types 0x0000 - 0x7fff)
-         *    0x 0000 0000 0000 to
-         *    0x 0000 0000 7fff
-         *  V10 Enterprise types
-         *    0x 0000 0001 0000 to
-         *    0x ffff ffff 7fff
-         */
-        pen_type = masked_type = type;
-        rev      = 0;
-
-        if ((hdrinfo_p->vspec == 10) && (type & 0x8000)) {
-            pen_type = masked_type = type & 0x7fff;
-            if (pen == REVPEN) { /* reverse PEN */
-                rev = 1;
-            } else if (pen == 0) {
-                pen_type = (UINT64_C(0xffff) << 16) | pen_type;  /* hack to force "unknown" */
-            } else {
-                pen_type = (((uint64_t)pen) << 16) | pen_type;
-            }
-        }
-
-        /* Provide a convenient (hidden) filter for any items belonging to a known PIE,
-           but take care not to add > once. */
-        switch (pen) {
-            case VENDOR_CACE:
-                if (!cace_pie_seen) {
-                    proto_item *pie_cace_ti = proto_tree_add_item(pdutree, hf_pie_cace, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_cace_ti);
-                    cace_pie_seen = true;
-                }
-                break;
-            case VENDOR_PLIXER:
-                if (!plixer_pie_seen) {
-                    proto_item *pie_plixer_ti = proto_tree_add_item(pdutree, hf_pie_plixer, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_plixer_ti);
-                    plixer_pie_seen = true;
-                }
-                break;
-            case VENDOR_NTOP:
-                if (!ntop_pie_seen) {
-                    proto_item *pie_ntop_ti = proto_tree_add_item(pdutree, hf_pie_ntop, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_ntop_ti);
-                    ntop_pie_seen = true;
-                }
-                break;
-            case VENDOR_IXIA:
-                if (!ixia_pie_seen) {
-                    proto_item *pie_ixia_ti = proto_tree_add_item(pdutree, hf_pie_ixia, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_ixia_ti);
-                    ixia_pie_seen = true;
-                }
-                break;
-            case VENDOR_NETSCALER:
-                if (!netscaler_pie_seen) {
-                    proto_item *pie_netscaler_ti = proto_tree_add_item(pdutree, hf_pie_netscaler, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_netscaler_ti);
-                    netscaler_pie_seen = true;
-                }
-                break;
-            case VENDOR_BARRACUDA:
-                if (!barracuda_pie_seen) {
-                    proto_item *pie_barracuda_ti = proto_tree_add_item(pdutree, hf_pie_barracuda, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_barracuda_ti);
-                    barracuda_pie_seen = true;
-                }
-                break;
-            case VENDOR_GIGAMON:
-                if (!gigamon_pie_seen) {
-                    proto_item *pie_gigamon_ti = proto_tree_add_item(pdutree, hf_pie_gigamon, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_gigamon_ti);
-                    gigamon_pie_seen = true;
-                }
-                break;
-            case VENDOR_CISCO:
-                if (!cisco_pie_seen) {
-                    proto_item *pie_cisco_ti = proto_tree_add_item(pdutree, hf_pie_cisco, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_cisco_ti);
-                    cisco_pie_seen = true;
-                }
-                break;
-            case VENDOR_NIAGARA_NETWORKS:
-                if (!niagara_networks_pie_seen) {
-                    proto_item *pie_niagara_networks_ti = proto_tree_add_item(pdutree, hf_pie_niagara_networks, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_niagara_networks_ti);
-                    niagara_networks_pie_seen = true;
-                }
-                break;
-            case VENDOR_JUNIPER:
-                if(!juniper_networks_pie_seen) {
-                    proto_item *pie_juniper_ti = proto_tree_add_item(pdutree, hf_pie_juniper, tvb, 0, 0, ENC_NA);
-                    proto_item_set_hidden(pie_juniper_ti);
-                    juniper_networks_pie_seen = true;
-                }
-                break;
-
-            default:
-                break;
-        }
+        pen_type    = entry->pen_type;
+        masked_type = entry->masked_type;
+        rev         = entry->rev;
 
         ti = NULL;
         switch (pen_type) {
@@ -13331,6 +13396,8 @@ dissect_v9_v10_options_template(tvbuff_t *tvb, packet_info *pinfo, proto_tree *p
             tmplt_p->template_frame_number = pinfo->num;
             /* Add completed entry into table */
             wmem_map_insert(v9_v10_tmplt_table, tmplt_p, tmplt_p);
+            v9_v10_tmplt_get_plan(tmplt_p, TF_SCOPES, hdrinfo_p->vspec);
+            v9_v10_tmplt_get_plan(tmplt_p, TF_ENTRIES, hdrinfo_p->vspec);
         }
 
         remaining -= offset - orig_offset;
@@ -13438,6 +13505,7 @@ dissect_v9_v10_data_template(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdut
             /* Remember when we saw this template */
             tmplt_p->template_frame_number = pinfo->num;
             wmem_map_insert(v9_v10_tmplt_table, tmplt_p, tmplt_p);
+            v9_v10_tmplt_get_plan(tmplt_p, TF_ENTRIES, hdrinfo_p->vspec);
 
             /* Create if necessary observation domain entry (for use with sequence analysis) */
             domain_state = (netflow_domain_state_t *)wmem_map_lookup(netflow_sequence_analysis_domain_hash,
@@ -130,6 +130,31 @@ add_per_encoded_label(tvbuff_t* tvb, packet_info* pinfo _U_, proto_tree* tree)
 
 #define SEQ_MAX_COMPONENTS 128
 
+/* The optional/default and extension presence bits of a SEQUENCE are
+   internal PER fields, hidden unless display_internal_per_fields is set.
+   Unless the tree is visible or a filter refers to them, read them in
+   one go instead of adding (and labelling) an item for every bit. */
+static bool
+per_skip_presence_items(proto_tree *tree, int hf_index)
+{
+	return !display_internal_per_fields && !proto_field_is_referenced(tree, hf_index);
+}
+
+/* Read num_bits presence bits into mask, first bit in the MSB of mask[0]. */
+static uint32_t
+per_read_presence_bits(tvbuff_t *tvb, uint32_t offset, uint32_t num_bits, uint32_t *mask)
+{
+	uint32_t i, n, bits;
+
+	for(i=0;i<num_bits;i+=n){
+		n=MIN(num_bits-i, 32);
+		bits=tvb_get_bits32(tvb, offset, n, ENC_BIG_ENDIAN);
+		mask[i>>5]=(n==32)?bits:bits<<(32-n);
+		offset+=n;
+	}
+	return offset;
+}
+
 static void per_check_value(uint32_t value, uint32_t min_len, uint32_t max_len, asn1_ctx_t *actx, proto_item *item, bool is_signed)
 {
 	if ((is_signed == false) && (value > max_len)) {
@@ -648,6 +673,7 @@ dissect_per_restricted_character_string_sorted(tvbuff_t *tvb, uint32_t offset, a
 	unsigned char_pos;
 	int bits_per_char;
 	uint32_t old_offset;
+	tvb_bit_reader_t br;
 
 DEBUG_ENTRY("dissect_per_restricted_character_string");
 
@@ -762,16 +788,13 @@ DEBUG_ENTRY("dissect_per_restricted_character_string");
 
 	buf = wmem_strbuf_new_len(actx->pinfo->pool, NULL, length);
 	old_offset=offset;
+	if (length) {
+		tvb_bit_reader_init(&br, tvb, offset);
+	}
 	for(char_pos=0;char_pos<length;char_pos++){
 		unsigned char val;
-		int i;
-		bool bit;
 
-		val=0;
-		for(i=0;i<bits_per_char;i++){
-			offset=dissect_per_boolean(tvb, offset, actx, tree, -1, &bit);
-			val=(val<<1)|bit;
-		}
+		val=(unsigned char)tvb_bit_reader_get(&br, bits_per_char);
 		if(use_canonical_order == false){
 			if (val > ub || val < lb) {
 				wmem_strbuf_append_unichar_repl(buf);
@@ -786,6 +809,9 @@ DEBUG_ENTRY("dissect_per_restricted_character_string");
 			}
 		}
 	}
+	if (length) {
+		offset = tvb_bit_reader_offset(&br);
+	}
 	str_len = (int)wmem_strbuf_get_len(buf);
 	str = wmem_strbuf_finalize(buf);
 	/* Note that str can contain embedded nulls. Length claims any bytes partially used.  */
@@ -1971,15 +1997,19 @@ DEBUG_ENTRY("dissect_per_sequence");
 	}
 
 	memset(optional_mask, 0, sizeof(optional_mask));
-	for(i=0;i<num_opts;i++){
-		offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_optional_field_bit, &optional_field_flag);
-		if (tree) {
-			proto_item_append_text(actx->created_item, " (%s %s present)",
-				index_get_optional_name(sequence, i), optional_field_flag?"is":"is NOT");
-		}
-		if (!display_internal_per_fields) proto_item_set_hidden(actx->created_item);
-		if(optional_field_flag){
-			optional_mask[i>>5]|=0x80000000>>(i&0x1f);
+	if (per_skip_presence_items(tree, hf_per_optional_field_bit)) {
+		offset=per_read_presence_bits(tvb, offset, num_opts, optional_mask);
+	} else {
+		for(i=0;i<num_opts;i++){
+			offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_optional_field_bit, &optional_field_flag);
+			if (tree) {
+				proto_item_append_text(actx->created_item, " (%s %s present)",
+					index_get_optional_name(sequence, i), optional_field_flag?"is":"is NOT");
+			}
+			if (!display_internal_per_fields) proto_item_set_hidden(actx->created_item);
+			if(optional_field_flag){
+				optional_mask[i>>5]|=0x80000000>>(i&0x1f);
+			}
 		}
 	}
 
@@ -2038,15 +2068,20 @@ DEBUG_ENTRY("dissect_per_sequence");
 		}
 
 		extension_mask=0;
-		for(i=0;i<num_extensions;i++){
-			offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_extension_present_bit, &extension_bit);
-			if (tree) {
-				proto_item_append_text(actx->created_item, " (%s %s present)",
-					index_get_extension_name(sequence, i), extension_bit?"is":"is NOT");
-			}
-			if (!display_internal_per_fields) proto_item_set_hidden(actx->created_item);
+		if (per_skip_presence_items(tree, hf_per_extension_present_bit)) {
+			extension_mask=tvb_get_bits32(tvb, offset, num_extensions, ENC_BIG_ENDIAN);
+			offset+=num_extensions;
+		} else {
+			for(i=0;i<num_extensions;i++){
+				offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_extension_present_bit, &extension_bit);
+				if (tree) {
+					proto_item_append_text(actx->created_item, " (%s %s present)",
+						index_get_extension_name(sequence, i), extension_bit?"is":"is NOT");
+				}
+				if (!display_internal_per_fields) proto_item_set_hidden(actx->created_item);
 
-			extension_mask=(extension_mask<<1)|extension_bit;
+				extension_mask=(extension_mask<<1)|extension_bit;
+			}
 		}
 
 		/* find how many extensions we know about */
@@ -2136,15 +2171,19 @@ DEBUG_ENTRY("dissect_per_sequence_eag");
 	}
 
 	memset(optional_mask, 0, sizeof(optional_mask));
-	for(i=0;i<num_opts;i++){
-		offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_optional_field_bit, &optional_field_flag);
-		if (tree) {
-			proto_item_append_text(actx->created_item, " (%s %s present)",
-				index_get_optional_name(sequence, i), optional_field_flag?"is":"is NOT");
-		}
-		if (!display_internal_per_fields) proto_item_set_hidden(actx->created_item);
-		if(optional_field_flag){
-			optional_mask[i>>5]|=0x80000000>>(i&0x1f);
+	if (per_skip_presence_items(tree, hf_per_optional_field_bit)) {
+		offset=per_read_presence_bits(tvb, offset, num_opts, optional_mask);
+	} else {
+		for(i=0;i<num_opts;i++){
+			offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_optional_field_bit, &optional_field_flag);
+			if (tree) {
+				proto_item_append_text(actx->created_item, " (%s %s present)",
+					index_get_optional_name(sequence, i), optional_field_flag?"is":"is NOT");
+			}
+			if (!display_internal_per_fields) proto_item_set_hidden(actx->created_item);
+			if(optional_field_flag){
+				optional_mask[i>>5]|=0x80000000>>(i&0x1f);
+			}
 		}
 	}
 
@@ -110,6 +110,7 @@ void proto_reg_handoff_protobuf(void);
 #define PREFS_UPDATE_ALL   (PREFS_UPDATE_PROTOBUF_SEARCH_PATHS | PREFS_UPDATE_PROTOBUF_UDP_MESSAGE_TYPES | PREFS_UPDATE_PROTOBUF_URI_MESSAGE_TYPES)
 
 static void protobuf_reinit(int target);
+static void flush_and_report_error(void);
 
 static int proto_protobuf;
 static int proto_protobuf_json_mapping;
@@ -167,6 +168,8 @@ static bool old_dissect_bytes_as_string;
 static bool show_details;
 static bool pbf_as_hf; /* dissect protobuf fields as header fields of wireshark */
 static bool preload_protos;
+static bool load_on_demand;
+static bool pool_loaded_on_demand; /* whether the .proto files in pbw_pool are parsed on demand */
 /* Show protobuf as JSON similar to https://developers.google.com/protocol-buffers/docs/proto3#json */
 static bool display_json_mapping;
 static bool use_utc_fmt;
@@ -1835,6 +1838,9 @@ dissect_protobuf(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data
                                  NULL);  // retval
     }
 
+    /* report the errors of .proto files that have been loaded on demand */
+    flush_and_report_error();
+
     return tvb_captured_length(tvb);
 }
 
@@ -1861,7 +1867,7 @@ load_all_files_in_dir(PbwDescriptorPool* pool, const char* dir_path, unsigned de
                 dot = strrchr(name, '.');
                 if (dot && g_ascii_strcasecmp(dot + 1, "proto") == 0) {
                     /* Note: pbw_load_proto_file support absolute or relative (to one of search paths) path */
-                    if (pbw_load_proto_file(pool, path) != 0) {
+                    if ((pool_loaded_on_demand ? pbw_add_proto_file_on_demand(pool, path) : pbw_load_proto_file(pool, path)) != 0) {
                         g_free(path);
                         ws_dir_close(dir);
                         return false;
@@ -2187,6 +2193,9 @@ protobuf_reinit(int target)
         /* init DescriptorPool of protobuf */
         pbw_reinit_DescriptorPool(&pbw_pool, (const char **)source_paths, buffer_error);
 
+        /* Wireshark fields are registered for all messages up front, so they need all the files parsed */
+        pool_loaded_on_demand = load_on_demand && !pbf_as_hf;
+
         /* load all .proto files in the marked search paths, we can invoke FindMethodByName etc later. */
         for (i = 0; i < num_proto_paths; ++i) {
             if ((i < 2) || protobuf_search_paths[i - 2].load_all) {
@@ -2407,6 +2416,15 @@ proto_register_protobuf(void)
         " when the Protobuf dissector is called for the first time.",
         &preload_protos);
 
+    prefs_register_bool_preference(protobuf_module, "load_on_demand",
+        "Parse .proto files on demand.",
+        "Only read the package names of the .proto files in the search paths whose files are all loaded,"
+        " and parse the files of a package the first time a message, enum or service of that package is"
+        " needed. This makes loading a large number of .proto files faster. It does not apply while"
+        " Protobuf fields are dissected as Wireshark fields, as those fields are registered for all messages"
+        " when the files are loaded.",
+        &load_on_demand);
+
     protobuf_search_paths_uat = uat_new("Protobuf Search Paths",
         sizeof(protobuf_search_path_t),
         "protobuf_search_paths",
@@ -2556,7 +2574,10 @@ proto_register_protobuf(void)
 void
 proto_reg_handoff_protobuf(void)
 {
-    if (protobuf_dissector_called) {
+    if (protobuf_dissector_called && pool_loaded_on_demand != (load_on_demand && !pbf_as_hf)) {
+        /* reload the .proto files, all or on demand */
+        protobuf_reinit(PREFS_UPDATE_PROTOBUF_SEARCH_PATHS);
+    } else if (protobuf_dissector_called) {
         update_header_fields( /* if bytes_as_string preferences changed, we force reload header fields */
             (old_dissect_bytes_as_string && !dissect_bytes_as_string) || (!old_dissect_bytes_as_string && dissect_bytes_as_string)
         );
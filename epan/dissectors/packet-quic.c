@@ -64,12 +64,14 @@
 #include <epan/tap.h>
 #include <epan/follow.h>
 #include <epan/addr_resolv.h>
+#include <epan/stream_frames.h>
 
 /* Prototypes */
 void proto_reg_handoff_quic(void);
 void proto_register_quic(void);
 
 static int quic_follow_tap;
+static stream_frames_table_t *quic_connection_frames;
 
 /* Initialize the protocol and registered fields */
 static int proto_quic;
@@ -4420,6 +4422,7 @@ quic_add_connection_info(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, qu
     conversation_set_elements_by_id(pinfo, CONVERSATION_QUIC, conn->number);
     pi = proto_tree_add_uint(ctree, hf_quic_connection_number, tvb, 0, 0, conn->number);
     proto_item_set_generated(pi);
+    stream_frames_add(quic_connection_frames, pinfo, conn->number);
 #if 0
     proto_tree_add_debug_text(ctree, "Client CID: %s", cid_to_string(pinfo->pool, &conn->client_cids.data));
     proto_tree_add_debug_text(ctree, "Server CID: %s", cid_to_string(pinfo->pool, &conn->server_cids.data));
@@ -6387,6 +6390,7 @@ proto_register_quic(void)
     register_follow_stream(proto_quic, "quic_follow", quic_follow_conv_filter, quic_follow_index_filter, udp_follow_address_filter,
                            udp_port_to_display, follow_quic_tap_listener, get_quic_connections_count,
                            quic_get_sub_stream_id);
+    quic_connection_frames = stream_frames_register("quic.connection.number");
 
     reassembly_table_register(&quic_reassembly_table,
                               &quic_reassembly_table_functions);
@@ -1320,7 +1320,7 @@ smb_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 
 	if (active_row == -1) { /* This is a new-tracked file */
 		/* Construct the entry in the list of active files */
-		entry = g_new(export_object_entry_t, 1);
+		entry = g_new0(export_object_entry_t, 1);
 		entry->payload_data = NULL;
 		entry->payload_len = 0;
 		new_file = g_new(active_file, 1);
@@ -22604,6 +22604,8 @@ proto_register_smb(void)
 	register_srt_table(proto_smb, NULL, 3, smbstat_packet, smbstat_init, NULL);
 	/* Register the tap for the "Export Object" function */
 	smb_eo_tap = register_export_object(proto_smb, smb_eo_packet, smb_eo_cleanup);
+	/* Files are assembled from several packets into an existing entry */
+	set_eo_updates_entries(proto_smb);
 }
 
 void
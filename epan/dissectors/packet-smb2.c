@@ -32,6 +32,7 @@
 #include <epan/strutil.h>
 #include <epan/asn1.h>
 #include <epan/reassemble.h>
+#include <epan/req_resp_table.h>
 #include <epan/uat.h>
 #include <epan/tfs.h>
 #include <epan/read_keytab_file.h>
@@ -1388,11 +1389,11 @@ smb2stat_packet(void *pss, packet_info *pinfo, epan_dissect_t *edt _U_, const vo
 	 * retransmissions triggered by the expiry of the rexmit timer (RTOs). Only calculating SRT
 	 * for the last received response accomplishes this goal without requiring the TCP pref
 	 * "Do not call subdissectors for error packets" to be set. */
-	if (si->saved->frame_res != pinfo->num)
+	if (si->saved->trans.rep_frame != pinfo->num)
 		return TAP_PACKET_DONT_REDRAW;
 
 	smb2_srt_table = g_array_index(data->srt_array, srt_stat_table*, i);
-	add_srt_table_data(smb2_srt_table, si->opcode, &si->saved->req_time, pinfo);
+	add_srt_table_data(smb2_srt_table, si->opcode, &si->saved->trans.req_time, pinfo);
 	return TAP_PACKET_REDRAW;
 }
 
@@ -1551,47 +1552,8 @@ static bool seskey_find_sid_key(uint64_t sesid, uint8_t *out_seskey,
 /* ExportObject preferences variable */
 bool eosmb2_take_name_as_fid = false ;
 
-/* unmatched smb_saved_info structures.
-   For unmatched smb_saved_info structures we store the smb_saved_info
-   structure using the msg_id field.
-*/
-static int
-smb2_saved_info_equal_unmatched(const void *k1, const void *k2)
-{
-	const smb2_saved_info_t *key1 = (const smb2_saved_info_t *)k1;
-	const smb2_saved_info_t *key2 = (const smb2_saved_info_t *)k2;
-	return key1->msg_id == key2->msg_id;
-}
-static unsigned
-smb2_saved_info_hash_unmatched(const void *k)
-{
-	const smb2_saved_info_t *key = (const smb2_saved_info_t *)k;
-	uint32_t hash;
-
-	hash = (uint32_t) (key->msg_id&0xffffffff);
-	return hash;
-}
-
-/* matched smb_saved_info structures.
-   For matched smb_saved_info structures we store the smb_saved_info
-   structure using the msg_id field.
-*/
-static int
-smb2_saved_info_equal_matched(const void *k1, const void *k2)
-{
-	const smb2_saved_info_t *key1 = (const smb2_saved_info_t *)k1;
-	const smb2_saved_info_t *key2 = (const smb2_saved_info_t *)k2;
-	return key1->msg_id == key2->msg_id;
-}
-static unsigned
-smb2_saved_info_hash_matched(const void *k)
-{
-	const smb2_saved_info_t *key = (const smb2_saved_info_t *)k;
-	uint32_t hash;
-
-	hash = (uint32_t) (key->msg_id&0xffffffff);
-	return hash;
-}
+/* smb2_saved_info_t structures, by conversation and msg_id. */
+static req_resp_table_t *smb2_transactions;
 
 /* For Tids of a specific conversation.
    This keeps track of tid->sharename mappings and other information about the
@@ -1698,22 +1660,6 @@ smb2_fid_info_hash(const void *k)
 	return hash;
 }
 
-/* Callback for destroying the glib hash tables associated with a conversation
- * struct. */
-static bool
-smb2_conv_destroy(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
-	          void *user_data)
-{
-	smb2_conv_info_t *conv = (smb2_conv_info_t *)user_data;
-
-	g_hash_table_destroy(conv->matched);
-	g_hash_table_destroy(conv->unmatched);
-
-	/* This conversation is gone, return false to indicate we don't
-	 * want to be called again for this conversation. */
-	return false;
-}
-
 static smb2_sesid_info_t *
 smb2_get_session(smb2_conv_info_t *conv _U_, uint64_t id, packet_info *pinfo, smb2_info_t *si)
 {
@@ -12881,7 +12827,7 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, bool fi
 	int         chain_offset	  = 0;
 	const char *label		  = smb_header_label;
 	conversation_t    *conversation;
-	smb2_saved_info_t *ssi          = NULL, ssi_key;
+	smb2_saved_info_t *ssi          = NULL;
 	smb2_info_t       *si;
 	smb2_transform_info_t *sti;
 	smb2_comp_transform_info_t *scti;
@@ -12929,20 +12875,8 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, bool fi
 		 * create it.
 		 */
 		si->conv = wmem_new0(wmem_file_scope(), smb2_conv_info_t);
-		/* qqq this leaks memory for now since we never free
-		   the hashtables */
-		si->conv->matched = g_hash_table_new(smb2_saved_info_hash_matched,
-			smb2_saved_info_equal_matched);
-		si->conv->unmatched = g_hash_table_new(smb2_saved_info_hash_unmatched,
-			smb2_saved_info_equal_unmatched);
 		si->conv->preauth_hash_current = si->conv->preauth_hash_con;
 
-		/* Bit of a hack to avoid leaking the hash tables - register a
-		 * callback to free them. Ideally wmem would implement a simple
-		 * hash table so we wouldn't have to do this. */
-		wmem_register_callback(wmem_file_scope(), smb2_conv_destroy,
-				si->conv);
-
 		conversation_add_proto_data(conversation, proto_smb2, si->conv);
 	}
 
@@ -13039,7 +12973,6 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, bool fi
 
 		/* Message ID */
 		si->msg_id = tvb_get_letoh64(tvb, offset);
-		ssi_key.msg_id = si->msg_id;
 		proto_tree_add_item(header_tree, hf_smb2_msg_id, tvb, offset, 8, ENC_LITTLE_ENDIAN);
 		proto_item_append_text(item,  ", MessageId %" PRIu64, (uint64_t)si->msg_id);
 		offset += 8;
@@ -13071,53 +13004,35 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, bool fi
 
 
 		if (!pinfo->fd->visited) {
-			/* see if we can find this msg_id in the unmatched table */
-			ssi = (smb2_saved_info_t *)g_hash_table_lookup(si->conv->unmatched, &ssi_key);
-
 			if (!(si->flags & SMB2_FLAGS_RESPONSE)) {
-				/* This is a request */
-				if (ssi) {
-					/* this is a request and we already found
-					* an older ssi so just delete the previous
-					* one
-					*/
-					g_hash_table_remove(si->conv->unmatched, ssi);
+				/* This is a request; it replaces any older
+				* one with the same msg_id
+				*/
+				ssi = (smb2_saved_info_t *)req_resp_add_request(smb2_transactions, pinfo,
+						conversation->conv_index, si->msg_id, sizeof(smb2_saved_info_t));
+				ssi->extra_info_type = SMB2_EI_NONE;
+			} else {
+				/* This is a response; see if its request is
+				* still waiting for one
+				*/
+				ssi = (smb2_saved_info_t *)req_resp_lookup(smb2_transactions, pinfo,
+						conversation->conv_index, si->msg_id);
+				if (ssi && ssi->trans.rep_frame != 0) {
 					ssi = NULL;
 				}
-
-				if (!ssi) {
-					/* no we couldn't find it, so just add it then
-					* if was a request we are decoding
-					*/
-					ssi                  = wmem_new0(wmem_file_scope(), smb2_saved_info_t);
-					ssi->msg_id          = ssi_key.msg_id;
-					ssi->frame_req       = pinfo->num;
-					ssi->frame_res       = UINT32_MAX;
-					ssi->req_time        = pinfo->abs_ts;
-					ssi->extra_info_type = SMB2_EI_NONE;
-					g_hash_table_insert(si->conv->unmatched, ssi, ssi);
-				}
-			} else {
-				/* This is a response */
-				if (!((si->flags & SMB2_FLAGS_ASYNC_CMD)
-					&& si->status == NT_STATUS_PENDING)
-					&& ssi) {
-					/* just  set the response frame and move it to the matched table */
-					ssi->frame_res = pinfo->num;
-					ssi->resp_time = pinfo->abs_ts;
-					g_hash_table_remove(si->conv->unmatched, ssi);
-					g_hash_table_insert(si->conv->matched, ssi, ssi);
+				if (ssi) {
+					if ((si->flags & SMB2_FLAGS_ASYNC_CMD)
+						&& si->status == NT_STATUS_PENDING) {
+						/* the real response is still to come */
+						req_resp_attach(smb2_transactions, pinfo, &ssi->trans);
+					} else {
+						req_resp_add_response(smb2_transactions, pinfo, &ssi->trans);
+					}
 				}
 			}
 		} else {
-			/* see if we can find this msg_id in the matched table */
-			ssi = (smb2_saved_info_t *)g_hash_table_lookup(si->conv->matched, &ssi_key);
-			/* if we couldn't find it in the matched table, it might still
-			* be in the unmatched table
-			*/
-			if (!ssi) {
-				ssi = (smb2_saved_info_t *)g_hash_table_lookup(si->conv->unmatched, &ssi_key);
-			}
+			ssi = (smb2_saved_info_t *)req_resp_find(smb2_transactions, pinfo,
+					conversation->conv_index, si->msg_id);
 		}
 
 		if (ssi) {
@@ -13141,29 +13056,29 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, bool fi
 			}
 
 			if (!(si->flags & SMB2_FLAGS_RESPONSE)) {
-				if (ssi->frame_res != UINT32_MAX) {
+				if (ssi->trans.rep_frame != 0) {
 					proto_item *tmp_item;
 					nstime_t    deltat;
 
 					tmp_item = proto_tree_add_uint(header_tree, hf_smb2_response_in, tvb, 0, 0,
-						ssi->frame_res);
+						ssi->trans.rep_frame);
 					proto_item_set_generated(tmp_item);
 
-					nstime_delta(&deltat, &ssi->resp_time, &pinfo->abs_ts);
+					nstime_delta(&deltat, &ssi->trans.rep_time, &pinfo->abs_ts);
 					tmp_item = proto_tree_add_time(header_tree, hf_smb2_time_req, tvb,
 								       0, 0, &deltat);
 					proto_item_set_generated(tmp_item);
 				}
 			} else {
-				if (ssi->frame_req != UINT32_MAX) {
+				if (ssi->trans.req_frame != 0) {
 					proto_item *tmp_item;
 					nstime_t    t, deltat;
 
 					tmp_item = proto_tree_add_uint(header_tree, hf_smb2_response_to, tvb, 0, 0,
-						ssi->frame_req);
+						ssi->trans.req_frame);
 					proto_item_set_generated(tmp_item);
 					t = pinfo->abs_ts;
-					nstime_delta(&deltat, &t, &ssi->req_time);
+					nstime_delta(&deltat, &t, &ssi->trans.req_time);
 					tmp_item = proto_tree_add_time(header_tree, hf_smb2_time_resp, tvb,
 					0, 0, &deltat);
 					proto_item_set_generated(tmp_item);
@@ -16427,6 +16342,8 @@ proto_register_smb2(void)
 	expert_smb2 = expert_register_protocol(proto_smb2);
 	expert_register_field_array(expert_smb2, ei, array_length(ei));
 
+	smb2_transactions = req_resp_table_register("SMB2", NULL);
+
 	smb2_module = prefs_register_protocol(proto_smb2, NULL);
 	prefs_register_bool_preference(smb2_module, "eosmb2_take_name_as_fid",
 				       "Use the full file name as File ID when exporting an SMB2 object",
@@ -12,6 +12,8 @@
 #define __PACKET_SMB2_H__
 
 #include "packet-dcerpc.h"
+#include <epan/req_resp_table.h>
+
 #include "packet-smb.h"
 #include "packet-ntlmssp.h"
 
@@ -63,12 +65,9 @@ typedef enum {
 	SMB2_EI_FINDPATTERN	/* find tracking  char * */
 } smb2_extra_info_t;
 typedef struct _smb2_saved_info_t {
+	req_resp_trans_t trans;	/* keyed by msg_id */
 	uint8_t   smb2_class;
 	uint8_t   infolevel;
-	uint64_t  msg_id;
-	uint32_t  frame_req, frame_res;
-	nstime_t  req_time;
-	nstime_t  resp_time;
 	uint8_t  *preauth_hash_req, *preauth_hash_res;
 	smb2_fid_info_t *file;
 	e_ctx_hnd policy_hnd; 	/* for eo_smb tracking */
@@ -125,9 +124,6 @@ typedef struct _smb2_sesid_info_t {
  * There is one such structure for each conversation.
  */
 typedef struct _smb2_conv_info_t {
-	/* these two tables are used to match requests with responses */
-	GHashTable *unmatched;
-	GHashTable *matched;
 	uint16_t dialect;
 	uint16_t sign_alg;
 	uint16_t enc_alg;
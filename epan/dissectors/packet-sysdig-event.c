@@ -2925,6 +2925,50 @@ dissect_event_params(tvbuff_t *tvb, packet_info *pinfo, const char **event_name,
     return param_offset;
 }
 
+/*
+ * Add the fields that come from the event header, which wiretap has
+ * already decoded, and return the event type item.
+ */
+static proto_item *
+add_header_fields(proto_tree *se_tree, tvbuff_t *tvb, const wtap_syscall_header *syscall_header)
+{
+    proto_tree_add_uint(se_tree, hf_se_cpu_id, tvb, 0, 0, syscall_header->cpu_id);
+    proto_tree_add_uint64(se_tree, hf_se_thread_id, tvb, 0, 0, syscall_header->thread_id);
+    proto_tree_add_uint(se_tree, hf_se_event_length, tvb, 0, 0, syscall_header->event_len);
+    proto_tree_add_uint(se_tree, hf_se_event_data_length, tvb, 0, 0, syscall_header->event_data_len);
+    if (syscall_header->nparams != 0) {
+        proto_tree_add_uint(se_tree, hf_se_nparams, tvb, 0, 0, syscall_header->nparams);
+    }
+    return proto_tree_add_uint(se_tree, hf_se_event_type, tvb, 0, 0, syscall_header->event_type);
+}
+
+bool
+sysdig_event_is_header_field(int hfid)
+{
+    return hfid == proto_sysdig_event ||
+        hfid == hf_se_cpu_id ||
+        hfid == hf_se_thread_id ||
+        hfid == hf_se_event_length ||
+        hfid == hf_se_event_data_length ||
+        hfid == hf_se_nparams ||
+        hfid == hf_se_event_type;
+}
+
+bool
+sysdig_event_add_header_tree(proto_tree *tree, const wtap_syscall_header *syscall_header)
+{
+    proto_item *ti;
+
+    /* Plugin events are handed to the Falco bridge as they are. */
+    if (syscall_header->event_type == EVT_PLUGINEVENT_E && falco_events_handle) {
+        return false;
+    }
+
+    ti = proto_tree_add_protocol_format(tree, proto_sysdig_event, NULL, 0, 0, "Sysdig Event");
+    add_header_fields(proto_item_add_subtree(ti, ett_sysdig_event), NULL, syscall_header);
+    return true;
+}
+
 static int
 dissect_sysdig_event(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
         void *data _U_)
@@ -2996,14 +3040,7 @@ dissect_sysdig_event(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 
     se_tree = proto_item_add_subtree(ti, ett_sysdig_event);
 
-    proto_tree_add_uint(se_tree, hf_se_cpu_id, tvb, 0, 0, pinfo->rec->rec_header.syscall_header.cpu_id);
-    proto_tree_add_uint64(se_tree, hf_se_thread_id, tvb, 0, 0, pinfo->rec->rec_header.syscall_header.thread_id);
-    proto_tree_add_uint(se_tree, hf_se_event_length, tvb, 0, 0, pinfo->rec->rec_header.syscall_header.event_len);
-    proto_tree_add_uint(se_tree, hf_se_event_data_length, tvb, 0, 0, pinfo->rec->rec_header.syscall_header.event_data_len);
-    if (pinfo->rec->rec_header.syscall_header.nparams != 0) {
-        proto_tree_add_uint(se_tree, hf_se_nparams, tvb, 0, 0, pinfo->rec->rec_header.syscall_header.nparams);
-    }
-    ti = proto_tree_add_uint(se_tree, hf_se_event_type, tvb, 0, 0, event_type);
+    ti = add_header_fields(se_tree, tvb, &pinfo->rec->rec_header.syscall_header);
 
     syscall_tree = proto_item_add_subtree(ti, ett_sysdig_syscall);
 
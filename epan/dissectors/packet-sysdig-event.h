@@ -10,6 +10,10 @@
 
 #include <stdint.h>
 
+#include <epan/proto.h>
+#include <wiretap/wtap.h>
+#include "ws_symbol_export.h"
+
 #pragma once
 
 typedef struct _sysdig_event_param_data {
@@ -17,3 +21,17 @@ typedef struct _sysdig_event_param_data {
     int data_bytes_offset;
     uint32_t data_bytes_length;
 } sysdig_event_param_data;
+
+/*
+ * Is hfid the Sysdig Event protocol or one of the fields taken from the
+ * event header? A display filter that only uses those can be evaluated
+ * against sysdig_event_add_header_tree() instead of a full dissection.
+ */
+WS_DLL_PUBLIC bool sysdig_event_is_header_field(int hfid);
+
+/*
+ * Add the Sysdig Event protocol and its header fields for an event to a
+ * tree, as dissecting the event would. Returns false, adding nothing, for
+ * events whose dissection doesn't include the header fields.
+ */
+WS_DLL_PUBLIC bool sysdig_event_add_header_tree(proto_tree *tree, const wtap_syscall_header *syscall_header);
@@ -30,6 +30,7 @@
 #include <epan/tfs.h>
 #include <epan/unit_strings.h>
 #include <epan/iana-info.h>
+#include <epan/stream_frames.h>
 
 #include <wsutil/array.h>
 #include <wsutil/utf8_entities.h>
@@ -1011,6 +1012,7 @@ static dissector_handle_t tcp_opt_unknown_handle;
 static capture_dissector_handle_t tcp_cap_handle;
 
 static uint32_t tcp_stream_count;
+static stream_frames_table_t *tcp_stream_frames;
 static uint32_t mptcp_stream_count;
 
 
@@ -2050,11 +2052,11 @@ init_tcp_conversation_data(packet_info *pinfo, int direction)
     tcpd=wmem_new0(wmem_file_scope(), struct tcp_analysis);
     tcpd->flow1.win_scale = (direction >= 0) ? pinfo->src_win_scale : pinfo->dst_win_scale;
     tcpd->flow1.window = UINT32_MAX;
-    tcpd->flow1.multisegment_pdus=wmem_tree_new(wmem_file_scope());
+    tcpd->flow1.multisegment_pdus=wmem_tree_new_btree(wmem_file_scope());
 
     tcpd->flow2.window = UINT32_MAX;
     tcpd->flow2.win_scale = (direction >= 0) ? pinfo->dst_win_scale : pinfo->src_win_scale;
-    tcpd->flow2.multisegment_pdus=wmem_tree_new(wmem_file_scope());
+    tcpd->flow2.multisegment_pdus=wmem_tree_new_btree(wmem_file_scope());
 
     if (tcp_reassemble_out_of_order) {
         tcpd->flow1.ooo_segments=wmem_list_new(wmem_file_scope());
@@ -2078,7 +2080,7 @@ init_tcp_conversation_data(packet_info *pinfo, int direction)
         tcpd->flow2.process_info = wmem_new0(wmem_file_scope(), struct tcp_process_info_t);
     }
 
-    tcpd->acked_table=wmem_tree_new(wmem_file_scope());
+    tcpd->acked_table=wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
     tcpd->ts_first.secs=pinfo->abs_ts.secs;
     tcpd->ts_first.nsecs=pinfo->abs_ts.nsecs;
     nstime_set_zero(&tcpd->ts_mru_syn);
@@ -2464,29 +2466,30 @@ mptcp_select_subflow_from_meta(const struct tcp_analysis *tcpd, const mptcp_meta
 static void
 tcp_analyze_get_acked_struct(uint32_t frame, uint32_t seq, uint32_t ack, bool createflag, struct tcp_analysis *tcpd)
 {
-
-    wmem_tree_key_t key[4];
-
-    key[0].length = 1;
-    key[0].key = &frame;
-
-    key[1].length = 1;
-    key[1].key = &seq;
-
-    key[2].length = 1;
-    key[2].key = &ack;
-
-    key[3].length = 0;
-    key[3].key = NULL;
+    struct tcp_acked *first, *ta;
 
     if (!tcpd) {
         return;
     }
 
-    tcpd->ta = (struct tcp_acked *)wmem_tree_lookup32_array(tcpd->acked_table, key);
+    /*
+     * Almost every frame has at most one entry, so a single map entry
+     * per frame with a short chain is far smaller than a tree keyed by
+     * (frame, seq, ack), which allocates a node at each of the three
+     * levels.
+     */
+    first = (struct tcp_acked *)wmem_map_lookup(tcpd->acked_table, GUINT_TO_POINTER(frame));
+    for (ta = first; ta != NULL; ta = ta->next) {
+        if (ta->seq == seq && ta->ack == ack)
+            break;
+    }
+    tcpd->ta = ta;
     if((!tcpd->ta) && createflag) {
         tcpd->ta = wmem_new0(wmem_file_scope(), struct tcp_acked);
-        wmem_tree_insert32_array(tcpd->acked_table, key, (void *)tcpd->ta);
+        tcpd->ta->seq = seq;
+        tcpd->ta->ack = ack;
+        tcpd->ta->next = first;
+        wmem_map_insert(tcpd->acked_table, GUINT_TO_POINTER(frame), (void *)tcpd->ta);
     }
 }
 
@@ -8814,6 +8817,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     if (tcpd) {
         item = proto_tree_add_uint(tcp_tree, hf_tcp_stream, tvb, offset, 0, tcpd->stream);
         proto_item_set_generated(item);
+        stream_frames_add(tcp_stream_frames, pinfo, tcpd->stream);
         tcpinfo.stream = tcpd->stream;
 
         if (tcp_calculate_ts) {
@@ -11156,6 +11160,7 @@ proto_register_tcp(void)
     register_conversation_table(proto_mptcp, false, mptcpip_conversation_packet, tcpip_endpoint_packet);
     register_follow_stream(proto_tcp, "tcp_follow", tcp_follow_conv_filter, tcp_follow_index_filter, tcp_follow_address_filter,
                             tcp_port_to_display, follow_tcp_tap_listener, get_tcp_stream_count, NULL);
+    tcp_stream_frames = stream_frames_register("tcp.stream");
 
     tcp_tap = register_tap("tcp");
     tcp_follow_tap = register_tap("tcp_follow");
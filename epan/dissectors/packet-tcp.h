@@ -166,6 +166,11 @@ typedef struct _tcp_unacked_t {
 } tcp_unacked_t;
 
 struct tcp_acked {
+	struct tcp_acked *next;	/* Next entry for the same frame, if the
+				   frame has more than one (seq, ack) */
+	uint32_t seq;		/* seq and ack this entry was created for */
+	uint32_t ack;
+
 	uint32_t frame_acked;
 	uint32_t rto_frame;
 	nstime_t ts;
@@ -453,10 +458,11 @@ struct tcp_analysis {
 	 */
 	struct tcp_acked *ta;
 
-	/* This structure contains a tree containing all the various ta's
-	 * keyed by frame number.
+	/* This structure contains a map containing all the various ta's
+	 * keyed by frame number; the entries for one frame are chained
+	 * through their next pointers, and told apart by seq and ack.
 	 */
-	wmem_tree_t	*acked_table;
+	wmem_map_t	*acked_table;
 
 	/* Remember the timestamp of the first frame seen in this tcp
 	 * conversation to be able to calculate a relative time compared
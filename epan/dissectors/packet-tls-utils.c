@@ -5549,7 +5549,7 @@ dtls_check_mac(SslDecryptSession *ssl, SslDecoder*decoder, int ct, uint8_t* data
 
 
 static bool
-tls_decrypt_aead_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, SslDecoder *decoder,
+tls_decrypt_aead_record(SslDecryptSession *ssl, SslDecoder *decoder,
         uint8_t ct, uint16_t record_version,
         bool ignore_mac_failed,
         const unsigned char *in, uint16_t inl,
@@ -5573,6 +5573,8 @@ tls_decrypt_aead_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, Ssl
     const uint8_t   draft_version = ssl->session.tls13_draft_version;
     const unsigned char   *auth_tag_wire;
     unsigned char   auth_tag_calc[16];
+    /* Large enough for the longest (D)TLS 1.2 AAD, which has a connection ID. */
+    unsigned char   aad_buf[23 + UINT8_MAX];
     unsigned char  *aad = NULL;
     unsigned        aad_len = 0;
 
@@ -5649,7 +5651,7 @@ tls_decrypt_aead_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, Ssl
     if (is_cid) { /* if connection ID */
         if (ssl->session.deprecated_cid) {
             aad_len = 14 + cidl;
-            aad = wmem_alloc(allocator, aad_len);
+            aad = aad_buf;
             phtonu64(aad, decoder->seq);         /* record sequence number */
             phtonu16(aad, decoder->epoch);       /* DTLS 1.2 includes epoch. */
             aad[8] = ct;                        /* TLSCompressed.type */
@@ -5659,7 +5661,7 @@ tls_decrypt_aead_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, Ssl
             phtonu16(aad + 12 + cidl, ciphertext_len);  /* TLSCompressed.length */
         } else {
             aad_len = 23 + cidl;
-            aad = wmem_alloc(allocator, aad_len);
+            aad = aad_buf;
             memset(aad, 0xFF, 8);               /* seq_num_placeholder */
             aad[8] = ct;                        /* TLSCompressed.type */
             aad[9] = cidl;                      /* cid_length */
@@ -5672,7 +5674,7 @@ tls_decrypt_aead_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, Ssl
         }
     } else if (is_v12) {
         aad_len = 13;
-        aad = wmem_alloc(allocator, aad_len);
+        aad = aad_buf;
         phtonu64(aad, decoder->seq);         /* record sequence number */
         if (version == DTLSV1DOT2_VERSION) {
             phtonu16(aad, decoder->epoch);   /* DTLS 1.2 includes epoch. */
@@ -5685,7 +5687,7 @@ tls_decrypt_aead_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, Ssl
         aad = decoder->dtls13_aad.data;
     } else if (draft_version >= 25 || draft_version == 0) {
         aad_len = 5;
-        aad = wmem_alloc(allocator, aad_len);
+        aad = aad_buf;
         aad[0] = ct;                        /* TLSCiphertext.opaque_type (23) */
         phtonu16(aad + 1, record_version);   /* TLSCiphertext.legacy_record_version (0x0303) */
         phtonu16(aad + 3, inl);              /* TLSCiphertext.length */
@@ -5751,7 +5753,7 @@ tls_decrypt_aead_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, Ssl
 /* Assume that we are called only for a non-NULL decoder which also means that
  * we have a non-NULL decoder->cipher_suite. */
 int
-ssl_decrypt_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, SslDecoder *decoder, uint8_t ct, uint16_t record_version,
+ssl_decrypt_record(wmem_allocator_t* allocator _U_, SslDecryptSession *ssl, SslDecoder *decoder, uint8_t ct, uint16_t record_version,
         bool ignore_mac_failed,
         const unsigned char *in, uint16_t inl, const unsigned char *cid, uint8_t cidl,
         StringInfo *comp_str, StringInfo *out_str, unsigned *outl)
@@ -5785,7 +5787,7 @@ ssl_decrypt_record(wmem_allocator_t* allocator, SslDecryptSession *ssl, SslDecod
         ssl->session.version == TLSV1DOT3_VERSION ||
         ssl->session.version == DTLSV1DOT3_VERSION) {
 
-        if (!tls_decrypt_aead_record(allocator, ssl, decoder, ct, record_version, ignore_mac_failed, in, inl, cid, cidl, out_str, &worklen)) {
+        if (!tls_decrypt_aead_record(ssl, decoder, ct, record_version, ignore_mac_failed, in, inl, cid, cidl, out_str, &worklen)) {
             /* decryption failed */
             return -1;
         }
@@ -6382,6 +6384,163 @@ tls_add_packet_info(int proto, packet_info *pinfo, uint8_t curr_layer_num_ssl)
     return pi;
 }
 
+/*
+ * Decrypted record cache. By default the plaintext of every decrypted record
+ * is kept for the lifetime of the capture file. When a limit is configured,
+ * the plaintext of TLS records which can be decrypted again (AEAD ciphers
+ * without compression) is kept in an LRU list and the least recently used
+ * plaintext is released once the limit is exceeded. It is decrypted again
+ * from the record in the frame when the frame is dissected next time.
+ */
+typedef struct _TlsRecordRecompute {
+    SslRecordInfo *rec;
+    SslDecryptSession *ssl;
+    SslDecoder *decoder;
+    uint32_t last_frame;            /**< Frame which used the plaintext last. */
+    uint16_t record_version;        /**< Record layer version (for the AAD). */
+    uint16_t record_length;         /**< Length of the encrypted fragment. */
+    uint8_t ct;                     /**< Record layer content type (for the AAD). */
+    struct _TlsRecordRecompute *prev, *next;   /**< LRU list, most recent first. */
+} TlsRecordRecompute;
+
+static size_t tls_record_cache_limit;
+static size_t tls_record_cache_size;
+static TlsRecordRecompute *tls_record_cache_head, *tls_record_cache_tail;
+
+void
+tls_record_cache_init(size_t limit)
+{
+    /* The entries themselves are in file scope and are gone already. */
+    tls_record_cache_limit = limit;
+    tls_record_cache_size = 0;
+    tls_record_cache_head = tls_record_cache_tail = NULL;
+}
+
+static void
+tls_record_cache_unlink(TlsRecordRecompute *rc)
+{
+    if (rc->prev) {
+        rc->prev->next = rc->next;
+    } else {
+        tls_record_cache_head = rc->next;
+    }
+    if (rc->next) {
+        rc->next->prev = rc->prev;
+    } else {
+        tls_record_cache_tail = rc->prev;
+    }
+    rc->prev = rc->next = NULL;
+}
+
+static void
+tls_record_cache_push(TlsRecordRecompute *rc)
+{
+    rc->prev = NULL;
+    rc->next = tls_record_cache_head;
+    if (tls_record_cache_head) {
+        tls_record_cache_head->prev = rc;
+    } else {
+        tls_record_cache_tail = rc;
+    }
+    tls_record_cache_head = rc;
+}
+
+/* Release the least recently used plaintext until the cache fits in its
+ * limit. Records of the frame being dissected are never released since
+ * the dissector (and taps) may still refer to their plaintext. */
+static void
+tls_record_cache_evict(uint32_t current_frame)
+{
+    while (tls_record_cache_size > tls_record_cache_limit && tls_record_cache_tail &&
+            tls_record_cache_tail->last_frame != current_frame) {
+        TlsRecordRecompute *rc = tls_record_cache_tail;
+
+        tls_record_cache_unlink(rc);
+        tls_record_cache_size -= rc->rec->plain_data_len;
+        wmem_free(wmem_file_scope(), rc->rec->plain_data);
+        rc->rec->plain_data = NULL;
+    }
+}
+
+void
+tls_record_info_set_recompute(SslRecordInfo *rec, packet_info *pinfo, SslDecryptSession *ssl,
+                              SslDecoder *decoder, uint8_t ct, uint16_t record_version,
+                              uint16_t record_length)
+{
+    TlsRecordRecompute *rc;
+
+    if (tls_record_cache_limit == 0 || decoder->compression > 0) {
+        return;
+    }
+    switch (decoder->cipher_suite->mode) {
+    case MODE_GCM:
+    case MODE_CCM:
+    case MODE_CCM_8:
+    case MODE_POLY1305:
+        break;
+    default:
+        /* Stream and CBC ciphers carry state between records. */
+        return;
+    }
+    if (ssl->session.version != TLSV1DOT2_VERSION && ssl->session.version != TLSV1DOT3_VERSION) {
+        return;
+    }
+
+    rc = wmem_new0(wmem_file_scope(), TlsRecordRecompute);
+    rc->rec = rec;
+    rc->ssl = ssl;
+    rc->decoder = decoder;
+    rc->last_frame = pinfo->num;
+    rc->record_version = record_version;
+    rc->record_length = record_length;
+    rc->ct = ct;
+    rec->recompute = rc;
+
+    tls_record_cache_push(rc);
+    tls_record_cache_size += rec->plain_data_len;
+    tls_record_cache_evict(pinfo->num);
+}
+
+/* Decrypt a record again whose plaintext was evicted from the cache. */
+static bool
+tls_record_recompute(tvbuff_t *parent_tvb, packet_info *pinfo, int record_id, SslRecordInfo *rec)
+{
+    TlsRecordRecompute *rc = rec->recompute;
+    SslDecoder *decoder = rc->decoder;
+    int offset = record_id - tvb_raw_offset(parent_tvb);
+    StringInfo out_str;
+    unsigned outl = 0;
+    uint64_t saved_seq;
+    bool ok;
+
+    if (offset < 0 || !tvb_bytes_exist(parent_tvb, offset, rc->record_length)) {
+        return false;
+    }
+
+    /* The decoder may be in use for later records, restore its sequence
+     * number afterwards. The cipher state is reset for every AEAD record. */
+    if (ssl_data_alloc(&out_str, rc->record_length) < 0) {
+        return false;
+    }
+    saved_seq = decoder->seq;
+    decoder->seq = rec->record_seq;
+    /* The record authenticated (or was accepted anyway) the first time. */
+    ok = tls_decrypt_aead_record(rc->ssl, decoder, rc->ct, rc->record_version, true,
+                                 tvb_get_ptr(parent_tvb, offset, rc->record_length),
+                                 rc->record_length, NULL, 0, &out_str, &outl);
+    decoder->seq = saved_seq;
+
+    if (ok && outl == rec->plain_data_len) {
+        rec->plain_data = (unsigned char *)wmem_memdup(wmem_file_scope(), out_str.data, outl);
+        tls_record_cache_size += outl;
+    } else {
+        ssl_debug_printf("%s failed to decrypt record %d in frame %u again\n", G_STRFUNC, record_id, pinfo->num);
+        ok = false;
+    }
+    g_free(out_str.data);
+    return ok;
+}
+
 /**
  * Remembers the decrypted TLS record fragment (TLSInnerPlaintext in TLS 1.3) to
  * avoid the need for a decoder in the second pass. Additionally, it remembers
@@ -6396,8 +6555,9 @@ tls_add_packet_info(int proto, packet_info *pinfo, uint8_t curr_layer_num_ssl)
  * @param flow Information about sequence numbers, etc.
  * @param type TLS Content Type (such as handshake or application_data).
  * @param curr_layer_num_ssl The layer identifier for this TLS session.
+ * @return The stored record.
  */
-void
+SslRecordInfo *
 ssl_add_record_info(int proto, packet_info *pinfo,
                     const unsigned char *plain_data, int plain_data_len, int content_len,
                     int record_id, SslFlow *flow, ContentType type, uint8_t curr_layer_num_ssl,
@@ -6416,6 +6576,7 @@ ssl_add_record_info(int proto, packet_info *pinfo,
     rec->type = type;
     rec->next = NULL;
     rec->record_seq = record_seq;
+    rec->recompute = NULL;
 
     if (flow && type == SSL_ID_APP_DATA) {
         rec->seq = flow->byte_seq;
@@ -6429,6 +6590,8 @@ ssl_add_record_info(int proto, packet_info *pinfo,
     prec = &pi->records;
     while (*prec) prec = &(*prec)->next;
     *prec = rec;
+
+    return rec;
 }
 
 /* search in packet data for the specified id; return a newly created tvb for the associated data */
@@ -6444,9 +6607,25 @@ ssl_get_record_info(tvbuff_t *parent_tvb, int proto, packet_info *pinfo, int rec
 
     for (rec = pi->records; rec; rec = rec->next)
         if (rec->id == record_id) {
+            const unsigned char *plain_data = rec->plain_data;
+
+            if (rec->recompute) {
+                TlsRecordRecompute *rc = rec->recompute;
+
+                if (!rec->plain_data && !tls_record_recompute(parent_tvb, pinfo, record_id, rec)) {
+                    return NULL;
+                }
+                rc->last_frame = pinfo->num;
+                tls_record_cache_unlink(rc);
+                tls_record_cache_push(rc);
+                tls_record_cache_evict(pinfo->num);
+                /* The cached plaintext may be released while the tree of
+                 * this frame is still shown, give the tvb its own copy. */
+                plain_data = (const unsigned char *)wmem_memdup(pinfo->pool, rec->plain_data, rec->plain_data_len);
+            }
             *matched_record = rec;
             /* link new real_data_tvb with a parent tvb so it is freed when frame dissection is complete */
-            return tvb_new_child_real_data(parent_tvb, rec->plain_data, rec->plain_data_len, rec->plain_data_len);
+            return tvb_new_child_real_data(parent_tvb, plain_data, rec->plain_data_len, rec->plain_data_len);
         }
 
     return NULL;
@@ -443,6 +443,10 @@ typedef struct _SslRecordInfo {
                                  Can be NULL if this record type may not be fragmented. */
     uint64_t record_seq;    /**< Implicit (TLS) or explicit (DTLS) record sequence number. */
     uint32_t seq;            /**< Data offset within the flow. */
+    struct _TlsRecordRecompute *recompute; /**< State to decrypt the record again
+                                                after its plain_data was evicted from
+                                                the decrypted record cache, or NULL
+                                                if plain_data is always kept. */
     struct _SslRecordInfo* next;
 } SslRecordInfo;
 
@@ -788,12 +792,22 @@ SslPacketInfo *
 tls_add_packet_info(int proto, packet_info *pinfo, uint8_t curr_layer_num_ssl);
 
 /* add to packet data a copy of the specified real data */
-extern void
+extern SslRecordInfo *
 ssl_add_record_info(int proto, packet_info *pinfo,
                     const unsigned char *plain_data, int plain_data_len, int content_len,
                     int record_id, SslFlow *flow, ContentType type, uint8_t curr_layer_num_ssl,
                     uint64_t record_seq);
 
+/* allow the plaintext of a TLS record to be evicted and decrypted again on demand */
+extern void
+tls_record_info_set_recompute(SslRecordInfo *rec, packet_info *pinfo, SslDecryptSession *ssl,
+                              SslDecoder *decoder, uint8_t ct, uint16_t record_version,
+                              uint16_t record_length);
+
+/* reset the decrypted record cache and set its size limit in bytes (0 for unlimited) */
+extern void
+tls_record_cache_init(size_t limit);
+
 /* search in packet data for the specified id; return a newly created tvb for the associated data */
 extern tvbuff_t*
 ssl_get_record_info(tvbuff_t *parent_tvb, int proto, packet_info *pinfo, int record_id, uint8_t curr_layer_num_ssl, SslRecordInfo **matched_record);
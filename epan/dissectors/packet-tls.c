@@ -86,6 +86,7 @@ static unsigned ntlsdecrypt;
 static bool tls_desegment          = true;
 static bool tls_desegment_app_data = true;
 static bool tls_ignore_mac_failed;
+static unsigned tls_decrypted_cache_size; /* in MiB, 0 for unlimited */
 
 #define PORT_HEUR_DEFAULT "443"
 /* Try heuristic dissectors before dissectors assigned to a port.
@@ -355,6 +356,7 @@ ssl_init(void)
 {
     ssl_common_init(&ssl_master_key_map,
                     &ssl_decrypted_data, &ssl_compressed_data);
+    tls_record_cache_init((size_t)tls_decrypted_cache_size * 1024 * 1024);
     ssl_debug_flush();
 
     /* Reset the identifier for a group of handshake fragments. */
@@ -1355,10 +1357,13 @@ dissect_ssl_heur(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data
 
 static void
 tls_save_decrypted_record(packet_info *pinfo, int record_id, SslDecryptSession *ssl, uint8_t content_type,
+                          uint16_t record_version, uint16_t record_length,
                           SslDecoder *decoder, bool allow_fragments, uint8_t curr_layer_num_ssl)
 {
     const unsigned char *data = ssl_decrypted_data.data;
     unsigned content_len = ssl_decrypted_data_avail;
+    const uint8_t record_ct = content_type;
+    SslRecordInfo *rec;
 
     if (content_len == 0) {
         return;
@@ -1390,9 +1395,10 @@ tls_save_decrypted_record(packet_info *pinfo, int record_id, SslDecryptSession *
     /* In TLS 1.3 only Handshake and Application Data can be fragmented.
      * Alert messages MUST NOT be fragmented across records, so do not
      * bother maintaining a flow for those. */
-    ssl_add_record_info(proto_tls, pinfo, data, ssl_decrypted_data_avail, content_len, record_id,
+    rec = ssl_add_record_info(proto_tls, pinfo, data, ssl_decrypted_data_avail, content_len, record_id,
             allow_fragments ? decoder->flow : NULL, (ContentType)content_type,
             curr_layer_num_ssl, decoder->seq - 1); // decoder->seq has already been incremented
+    tls_record_info_set_recompute(rec, pinfo, ssl, decoder, record_ct, record_version, record_length);
 }
 
 /**
@@ -1456,7 +1462,8 @@ decrypt_ssl3_record(tvbuff_t *tvb, packet_info *pinfo, uint32_t offset, SslDecry
         ssl_data_set(data_for_iv, (const unsigned char*)tvb_get_ptr(tvb, offset + record_length - data_for_iv_len, data_for_iv_len), data_for_iv_len);
     }
     if (success) {
-        tls_save_decrypted_record(pinfo, tvb_raw_offset(tvb)+offset, ssl, content_type, decoder, allow_fragments, curr_layer_num_ssl);
+        tls_save_decrypted_record(pinfo, tvb_raw_offset(tvb)+offset, ssl, content_type, record_version, record_length,
+                                  decoder, allow_fragments, curr_layer_num_ssl);
     }
     return success;
 }
@@ -1487,7 +1494,8 @@ decrypt_tls13_early_data(tvbuff_t *tvb, packet_info *pinfo, uint32_t offset,
                                      tvb_get_ptr(tvb, offset, record_length), record_length, NULL, 0,
                                      &ssl_compressed_data, &ssl_decrypted_data, &ssl_decrypted_data_avail) == 0;
         if (success) {
-            tls_save_decrypted_record(pinfo, tvb_raw_offset(tvb)+offset, ssl, SSL_ID_APP_DATA, ssl->client, true, curr_layer_num_ssl);
+            tls_save_decrypted_record(pinfo, tvb_raw_offset(tvb)+offset, ssl, SSL_ID_APP_DATA, 0x303, record_length,
+                                      ssl->client, true, curr_layer_num_ssl);
         } else {
             ssl_debug_printf("early data decryption failed, end of early data?\n");
         }
@@ -1527,7 +1535,8 @@ decrypt_tls13_early_data(tvbuff_t *tvb, packet_info *pinfo, uint32_t offset,
                                      &ssl_compressed_data, &ssl_decrypted_data, &ssl_decrypted_data_avail) == 0;
         if (success) {
             ssl_debug_printf("Early data decryption succeeded, cipher = %#x\n", cipher);
-            tls_save_decrypted_record(pinfo, tvb_raw_offset(tvb)+offset, ssl, SSL_ID_APP_DATA, ssl->client, true, curr_layer_num_ssl);
+            tls_save_decrypted_record(pinfo, tvb_raw_offset(tvb)+offset, ssl, SSL_ID_APP_DATA, 0x303, record_length,
+                                      ssl->client, true, curr_layer_num_ssl);
             break;
         }
     }
@@ -5147,6 +5156,12 @@ proto_register_tls(void)
              "Message Authentication Code (MAC), ignore \"mac failed\"",
              "For troubleshooting ignore the mac check result and decrypt also if the Message Authentication Code (MAC) fails.",
              &tls_ignore_mac_failed);
+        prefs_register_uint_preference(ssl_module,
+             "decrypted_cache_size",
+             "Decrypted record cache size (MiB)",
+             "Upper bound for the memory used to keep decrypted TLS records. Records using AEAD ciphers "
+             "are decrypted again when needed after they were released. 0 means no limit.",
+             10, &tls_decrypted_cache_size);
 
         /* Port 443 is too overloaded... */
         range_convert_str(wmem_epan_scope(), &tls_try_heuristic_first, PORT_HEUR_DEFAULT, 65535);
@@ -34,6 +34,7 @@
 #include <epan/exported_pdu.h>
 #include <epan/decode_as.h>
 #include <epan/iana-info.h>
+#include <epan/stream_frames.h>
 
 void proto_register_udp(void);
 void proto_reg_handoff_udp(void);
@@ -109,6 +110,7 @@ static bool udplite_check_checksum;
 static dissector_table_t udp_dissector_table;
 static heur_dissector_list_t heur_subdissector_list;
 static uint32_t udp_stream_count;
+static stream_frames_table_t *udp_stream_frames;
 
 /* Determine if there is a sub-dissector and call it.  This has been */
 /* separated into a stand alone routine so other protocol dissectors */
@@ -1245,6 +1247,7 @@ dissect(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, uint32_t ip_proto)
     if (udpd) {
         item = proto_tree_add_uint(udp_tree, hf_udp_stream, tvb, offset, 0, udpd->stream);
         proto_item_set_generated(item);
+        stream_frames_add(udp_stream_frames, pinfo, udpd->stream);
 
         /* Copy the stream index into the header as well to make it available
         * to tap listeners.
@@ -1567,6 +1570,7 @@ proto_register_udp(void)
     register_conversation_filter("udp", "UDP", udp_filter_valid, udp_build_filter_by_id, NULL);
     register_follow_stream(proto_udp, "udp_follow", udp_follow_conv_filter, udp_follow_index_filter, udp_follow_address_filter,
                         udp_port_to_display, follow_tvb_tap_listener, get_udp_stream_count, NULL);
+    udp_stream_frames = stream_frames_register("udp.stream");
 
     register_init_routine(udp_init);
 
@@ -35,6 +35,7 @@
 #include <wsutil/nstime.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/ws_trace.h>
 #include <wsutil/version_info.h>
 
 #include "conversation.h"
@@ -59,6 +60,8 @@
 #include "conversation_filter.h"
 #include "conversation_table.h"
 #include "reassemble.h"
+#include "req_resp_table.h"
+#include "stream_frames.h"
 #include "rtd_table.h"
 #include "srt_table.h"
 #include "stats_tree.h"
@@ -121,6 +124,7 @@ static char* epan_env_prefix_cache;
  */
 bool wireshark_abort_on_dissector_bug;
 bool wireshark_abort_on_too_many_items;
+bool wireshark_skip_field_checks;
 
 void
 ws_dissector_bug(const char *format, ...)
@@ -284,6 +288,16 @@ epan_init(register_cb cb, void *client_data, bool load_plugins, epan_app_data_t*
 		wireshark_abort_on_too_many_items = false;
 	}
 
+	/* Checking every field as it's registered takes a noticeable part
+	 * of startup; if the set of dissectors is known to be good, e.g.
+	 * when running TShark many times with the same build, the checks
+	 * can be skipped. */
+	if (getenv("WIRESHARK_SKIP_FIELD_CHECKS") != NULL) {
+		wireshark_skip_field_checks = true;
+	} else {
+		wireshark_skip_field_checks = false;
+	}
+
 	/* initialize memory allocation subsystem */
 	wmem_init_scopes();
 
@@ -353,6 +367,8 @@ epan_init(register_cb cb, void *client_data, bool load_plugins, epan_app_data_t*
 		keytab_file_data_init();
 		capture_dissector_init();
 		reassembly_tables_init();
+		req_resp_tables_init();
+		stream_frames_init();
 		conversation_filters_init();
 		conversation_table_init();
 		export_object_init();
@@ -462,6 +478,8 @@ epan_cleanup(void)
 	secrets_cleanup();
 	conversation_filters_cleanup();
 	reassembly_table_cleanup();
+	req_resp_tables_cleanup();
+	stream_frames_cleanup();
 	tap_cleanup();
 	expert_cleanup();
 	capture_dissector_cleanup();
@@ -502,6 +520,13 @@ epan_cleanup(void)
 struct epan_session {
 	struct packet_provider_data *prov;	/* packet provider data for this session */
 	struct packet_provider_funcs funcs;	/* functions using that data */
+	bool frozen;				/* true once the first pass is done */
+};
+
+struct epan_view {
+	epan_t *session;
+	epan_dissect_t edt;
+	bool used;				/* true once edt holds a dissection */
 };
 
 epan_t *
@@ -624,6 +649,73 @@ epan_free(epan_t *session)
 	}
 }
 
+void
+epan_freeze(epan_t *session)
+{
+	session->frozen = true;
+}
+
+bool
+epan_is_frozen(const epan_t *session)
+{
+	return session->frozen;
+}
+
+epan_view_t *
+epan_view_new(epan_t *session, const bool create_proto_tree, const bool proto_tree_visible)
+{
+	epan_view_t *view;
+
+	if (!session->frozen)
+		return NULL;
+
+	view = g_new0(epan_view_t, 1);
+	view->session = session;
+	epan_dissect_init(&view->edt, session, create_proto_tree, proto_tree_visible);
+	packet_revisit_views_add(1);
+
+	return view;
+}
+
+epan_dissect_t *
+epan_view_prepare(epan_view_t *view)
+{
+	if (view->used)
+		epan_dissect_reset(&view->edt);
+	view->used = false;
+
+	return &view->edt;
+}
+
+epan_dissect_t *
+epan_view_dissect(epan_view_t *view, int file_type_subtype,
+	wtap_rec *rec, frame_data *fd, column_info *cinfo)
+{
+	/* A first look at a frame builds state; that isn't a revisit. */
+	if (!fd->visited)
+		return NULL;
+
+	epan_view_prepare(view);
+	view->used = true;
+
+	dissect_record(&view->edt, file_type_subtype, rec, fd, cinfo);
+
+	wtap_block_unref(rec->block);
+	rec->block = NULL;
+
+	return &view->edt;
+}
+
+void
+epan_view_free(epan_view_t *view)
+{
+	if (view) {
+		packet_revisit_views_add(-1);
+		epan_dissect_cleanup(&view->edt);
+		g_free(view);
+	}
+}
+
 void
 epan_conversation_init(void)
 {
@@ -684,8 +776,6 @@ epan_dissect_reset(epan_dissect_t *edt)
 
 	wtap_block_unref(edt->pi.rec->block);
 
-	g_slist_free(edt->pi.proto_data);
-
 	/* Free the data sources list. */
 	free_data_sources(&edt->pi);
 
@@ -723,6 +813,31 @@ epan_dissect_fake_protocols(epan_dissect_t *edt, const bool fake_protocols)
 		proto_tree_set_fake_protocols(edt->tree, fake_protocols);
 }
 
+void
+epan_dissect_demand_only(epan_dissect_t *edt, const bool demand_only)
+{
+	if (edt)
+		proto_tree_set_demand_only(edt->tree, demand_only);
+}
+
+bool
+epan_dissect_field_is_demanded(epan_dissect_t *edt, int hfid)
+{
+	return proto_field_is_referenced(edt->tree, hfid);
+}
+
+unsigned
+epan_retire_before(const uint32_t before_frame)
+{
+	unsigned retired;
+
+	retired = conversation_retire_idle(before_frame);
+	reassembly_tables_retire(before_frame);
+	req_resp_tables_retire(before_frame);
+	retire_tap_listeners(before_frame);
+	return retired;
+}
+
 void
 epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, frame_data *fd, column_info *cinfo)
@@ -733,7 +848,9 @@ epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 	 * registered to a fake tap. */
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
+	WS_TRACE2(dissect__start, fd->num, fd->pkt_len);
 	dissect_record(edt, file_type_subtype, rec, fd, cinfo);
+	WS_TRACE1(dissect__done, fd->num);
 
 	/* free all memory allocated */
 	wtap_block_unref(rec->block);
@@ -745,7 +862,9 @@ epan_dissect_run_with_taps(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, frame_data *fd, column_info *cinfo)
 {
 	tap_queue_init(edt);
+	WS_TRACE2(dissect__start, fd->num, fd->pkt_len);
 	dissect_record(edt, file_type_subtype, rec, fd, cinfo);
+	WS_TRACE1(dissect__done, fd->num);
 	tap_push_tapped_queue(edt);
 
 	/* free all memory allocated */
@@ -787,8 +906,6 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 
 	g_slist_foreach(epan_plugins, epan_plugin_dissect_cleanup, edt);
 
-	g_slist_free(edt->pi.proto_data);
-
 	/* Free the data sources list. */
 	free_data_sources(&edt->pi);
 
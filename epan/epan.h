@@ -39,6 +39,16 @@ extern bool wireshark_abort_on_dissector_bug;
  */
 extern bool wireshark_abort_on_too_many_items;
 
+/**
+ * @brief Controls whether fields are checked for mistakes as they are registered.
+ *
+ * This global variable reflects the value of the corresponding environment variable,
+ * allowing Wireshark to avoid repeatedly querying the environment.
+ * If set to true, fields are registered without checking their names, types,
+ * display bases and value strings for mistakes.
+ */
+extern bool wireshark_skip_field_checks;
+
 /**
  * @brief Report a dissector bug (and optionally abort).
  *
@@ -596,6 +606,52 @@ WS_DLL_PUBLIC
 void
 epan_dissect_fake_protocols(epan_dissect_t *edt, const bool fake_protocols);
 
+/**
+ * @brief Indicate whether only the demanded fields need to be dissected.
+ *
+ * The demand set is the union of everything primed with
+ * epan_dissect_prime_with_dfilter(), epan_dissect_prime_with_hfid() and
+ * friends, i.e. the display and read filters, custom columns, taps and
+ * "-e" fields. When set and the tree isn't visible, subtrees holding no
+ * demanded field are not allocated at all. Don't set this if anything
+ * walks the whole tree, e.g. a tap with TL_REQUIRES_PROTO_TREE.
+ *
+ * @param edt          The dissection context.
+ * @param demand_only  If true, skip subtrees with no demanded fields.
+ */
+WS_DLL_PUBLIC
+void
+epan_dissect_demand_only(epan_dissect_t *edt, const bool demand_only);
+
+/**
+ * @brief Check whether a field or protocol is in the demand set.
+ *
+ * Every field is demanded when the tree is visible.
+ *
+ * @param edt   The dissection context.
+ * @param hfid  The field or protocol ID.
+ * @return true if the field will be added to the tree when present.
+ */
+WS_DLL_PUBLIC
+bool
+epan_dissect_field_is_demanded(epan_dissect_t *edt, int hfid);
+
+/**
+ * Drop the state that only concerns frames before before_frame, for
+ * running indefinitely on a live capture in bounded memory: idle
+ * conversations are retired, stale reassemblies and request/response
+ * transactions are dropped and the tap listeners' retire callbacks are
+ * called.
+ *
+ * Only frames from before_frame on may be dissected afterwards.
+ *
+ * @param before_frame The first frame whose state is kept.
+ * @return The number of conversations retired.
+ */
+WS_DLL_PUBLIC
+unsigned
+epan_retire_before(const uint32_t before_frame);
+
 /**
  * @brief Run a single packet dissection.
  *
@@ -614,6 +670,86 @@ void
 epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
         wtap_rec *rec, frame_data *fd, struct epan_column_info *cinfo);
 
+/**
+ * @brief Mark the end of the first pass over a session's frames.
+ *
+ * Once every frame has been dissected (and so has its visited flag set),
+ * the state the dissectors built up is complete and later dissections
+ * only read it. Freezing the session records that, so that views of it
+ * can be created.
+ *
+ * @param session The epan session.
+ */
+WS_DLL_PUBLIC void epan_freeze(epan_t *session);
+
+/**
+ * @brief Check whether epan_freeze() has been called for a session.
+ *
+ * @param session The epan session.
+ * @return true if the session is frozen.
+ */
+WS_DLL_PUBLIC bool epan_is_frozen(const epan_t *session);
+
+/**
+ * @brief A read-only view of a frozen session for redissecting frames.
+ *
+ * Each view has a dissection context of its own, so views can be handed
+ * to worker threads to redissect frames concurrently. Calls to dissectors
+ * of protocols that haven't been declared safe to run concurrently with
+ * proto_set_revisit_safe() are serialized while any view exists.
+ *
+ * Views are created and freed by the thread that owns the session, and
+ * not while another thread is dissecting with a view. Views don't run
+ * taps or prime Lua field extractors, and dissector profiling isn't
+ * thread safe, so it shouldn't be turned on while views exist.
+ */
+typedef struct epan_view epan_view_t;
+
+/**
+ * @brief Create a view of a frozen session.
+ *
+ * @param session            The frozen epan session.
+ * @param create_proto_tree  true to build protocol trees.
+ * @param proto_tree_visible true if the trees are to be shown.
+ * @return The new view, or NULL if the session isn't frozen.
+ */
+WS_DLL_PUBLIC epan_view_t *epan_view_new(epan_t *session,
+        const bool create_proto_tree, const bool proto_tree_visible);
+
+/**
+ * @brief Get a view's dissection ready for the next frame.
+ *
+ * epan_view_dissect() does this itself; it's called first by callers
+ * that prime the dissection, e.g. with col_custom_prime_edt(), since
+ * resetting it clears that.
+ *
+ * @param view The view.
+ * @return The view's dissection, cleared of any previous frame.
+ */
+WS_DLL_PUBLIC epan_dissect_t *epan_view_prepare(epan_view_t *view);
+
+/**
+ * @brief Redissect a frame with a view.
+ *
+ * @param view              The view to use.
+ * @param file_type_subtype The subtype of the capture file format.
+ * @param rec               The frame's record, as read again from the file.
+ * @param fd                The frame data, which must have been visited.
+ * @param cinfo             Column info to fill in, or NULL.
+ * @return The dissection, valid until the view is next used or freed, or
+ *         NULL if the frame hasn't been dissected before.
+ */
+WS_DLL_PUBLIC epan_dissect_t *epan_view_dissect(epan_view_t *view,
+        int file_type_subtype, wtap_rec *rec, frame_data *fd,
+        struct epan_column_info *cinfo);
+
+/**
+ * @brief Free a view.
+ *
+ * @param view The view, or NULL.
+ */
+WS_DLL_PUBLIC void epan_view_free(epan_view_t *view);
+
 /**
  * @brief Run a single packet dissection and invoke tap listeners.
  *
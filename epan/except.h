@@ -48,6 +48,20 @@ extern "C" {
 
 enum { except_no_call, except_call };
 
+/*
+ * Every TRY saves a context to return to. Where they exist, _setjmp() and
+ * _longjmp() are used for that: on BSD-derived systems, macOS included,
+ * setjmp() also saves the signal mask, which takes a system call each
+ * time, and nothing that throws depends on the mask being restored.
+ */
+#ifdef _WIN32
+#define except_setjmp(env)      setjmp(env)
+#define except_longjmp(env, v)  longjmp(env, v)
+#else
+#define except_setjmp(env)      _setjmp(env)
+#define except_longjmp(env, v)  _longjmp(env, v)
+#endif
+
 typedef struct {
     unsigned long except_group;
     unsigned long except_code;
@@ -181,7 +195,7 @@ WS_DLL_PUBLIC void except_free(void *);
         struct except_stacknode except_sn;                      \
         struct except_catch except_ch;                          \
         except_setup_try(&except_sn, &except_ch, ID, NUM);      \
-        if (setjmp(except_ch.except_jmp))                       \
+        if (except_setjmp(except_ch.except_jmp))                \
             *(PPE) = &except_ch.except_obj;                     \
         else                                                    \
             *(PPE) = 0
@@ -9,6 +9,7 @@
 #include <config.h>
 
 #include <stdio.h>
+#include <string.h>
 #include <glib.h>
 #include "exceptions.h"
 
@@ -206,10 +207,74 @@ run_tests(void)
         printf("success\n");
 }
 
-int main(void)
+/* Time the cost of saving a context, with and without the signal mask,
+ * and of a TRY block with and without an exception. */
+static void
+run_bench(unsigned iterations)
+{
+    jmp_buf env;
+    volatile unsigned int count = 0;
+    int64_t start;
+
+    start = g_get_monotonic_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        if (setjmp(env) == 0)
+            count++;
+    }
+    printf("setjmp():           %8.2f ns\n",
+           (g_get_monotonic_time() - start) * 1000.0 / iterations);
+
+    start = g_get_monotonic_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        if (except_setjmp(env) == 0)
+            count++;
+    }
+    printf("except_setjmp():    %8.2f ns\n",
+           (g_get_monotonic_time() - start) * 1000.0 / iterations);
+
+    start = g_get_monotonic_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        TRY {
+            count++;
+        }
+        CATCH_ALL {
+            failed = true;
+        }
+        ENDTRY;
+    }
+    printf("TRY, no exception:  %8.2f ns\n",
+           (g_get_monotonic_time() - start) * 1000.0 / iterations);
+
+    start = g_get_monotonic_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        TRY {
+            THROW(BoundsError);
+        }
+        CATCH(BoundsError) {
+            count++;
+        }
+        ENDTRY;
+    }
+    printf("TRY, exception:     %8.2f ns\n",
+           (g_get_monotonic_time() - start) * 1000.0 / iterations);
+
+    if (count != iterations * 4) {
+        printf("bench: %u iterations counted (not %u)\n", count, iterations * 4);
+        failed = true;
+    }
+}
+
+int main(int argc, char **argv)
 {
     except_init();
-    run_tests();
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        /* exntest bench [iterations] */
+        unsigned iterations = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 10000000;
+
+        run_bench(iterations > 0 ? iterations : 1);
+    } else {
+        run_tests();
+    }
     except_deinit();
     return failed ? EXIT_FAILURE:EXIT_SUCCESS;
 }
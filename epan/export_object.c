@@ -12,6 +12,9 @@
 
 #include <string.h>
 
+#include <wsutil/file_util.h>
+#include <wsutil/tempfile.h>
+
 #include "proto.h"
 #include "packet_info.h"
 #include "export_object.h"
@@ -21,6 +24,7 @@ struct register_eo {
     const char* tap_listen_str;          /* string used in register_tap_listener (NULL to use protocol name) */
     tap_packet_cb eo_func;               /* function to be called for new incoming packets for SRT */
     export_object_gui_reset_cb reset_cb; /* function to parse parameters of optional arguments of tap string */
+    bool updates_entries;                /* entries are extended after they are added */
 };
 
 static wmem_tree_t *registered_eo_tables;
@@ -42,11 +46,25 @@ register_export_object(const int proto_id, tap_packet_cb export_packet_func, exp
     table->tap_listen_str = wmem_strdup_printf(wmem_epan_scope(), "%s_eo", proto_get_protocol_filter_name(proto_id));
     table->eo_func = export_packet_func;
     table->reset_cb = reset_cb;
+    table->updates_entries = false;
 
     wmem_tree_insert_string(registered_eo_tables, proto_get_protocol_filter_name(proto_id), table, 0);
     return register_tap(table->tap_listen_str);
 }
 
+void set_eo_updates_entries(const int proto_id)
+{
+    register_eo_t *eo = get_eo_by_name(proto_get_protocol_filter_name(proto_id));
+
+    DISSECTOR_ASSERT(eo);
+    eo->updates_entries = true;
+}
+
+bool get_eo_updates_entries(register_eo_t* eo)
+{
+    return eo->updates_entries;
+}
+
 int get_eo_proto_id(register_eo_t* eo)
 {
     if (!eo) {
@@ -148,12 +166,58 @@ eo_ct2ext(const char *content_type)
     return content_type;
 }
 
+bool
+eo_spill_entry(export_object_entry_t *entry, const char *tmp_dir)
+{
+    char *path = NULL;
+    int fd;
+    const uint8_t *ptr;
+    size_t remaining;
+    ws_file_ssize_t bytes_written;
+
+    if (entry->payload_path != NULL)
+        return true;
+
+    fd = create_tempfile(tmp_dir, &path, "wireshark_eo_", NULL, NULL);
+    if (fd < 0)
+        return false;
+
+    /* Write in chunks that fit in the count argument of ws_write() */
+    ptr = entry->payload_data;
+    remaining = entry->payload_len;
+    while (remaining > 0) {
+        bytes_written = ws_write(fd, ptr, (unsigned int)MIN(remaining, G_MAXINT));
+        if (bytes_written <= 0) {
+            ws_close(fd);
+            ws_unlink(path);
+            g_free(path);
+            return false;
+        }
+        ptr += bytes_written;
+        remaining -= bytes_written;
+    }
+    if (ws_close(fd) < 0) {
+        ws_unlink(path);
+        g_free(path);
+        return false;
+    }
+
+    g_free(entry->payload_data);
+    entry->payload_data = NULL;
+    entry->payload_path = path;
+    return true;
+}
+
 void eo_free_entry(export_object_entry_t *entry)
 {
     g_free(entry->hostname);
     g_free(entry->content_type);
     g_free(entry->filename);
     g_free(entry->payload_data);
+    if (entry->payload_path) {
+        ws_unlink(entry->payload_path);
+        g_free(entry->payload_path);
+    }
 
     g_free(entry);
 }
@@ -25,6 +25,7 @@ typedef struct _export_object_entry_t {
     char *filename;
     size_t payload_len;
     uint8_t *payload_data;
+    char *payload_path;     /* If not NULL, the payload was moved to this file, see eo_spill_entry() */
 } export_object_entry_t;
 
 /** Maximum file name size for the file to which we save an object.
@@ -66,6 +67,22 @@ extern void export_object_init(void);
  */
 WS_DLL_PUBLIC int register_export_object(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb);
 
+/** Declare that the tap of an Export Object keeps extending entries after
+ * passing them to add_entry, looking them up with get_entry. The payload
+ * of such entries must stay in memory until tapping is done.
+ *
+ * @param proto_id is the protocol passed to register_export_object()
+ */
+WS_DLL_PUBLIC void set_eo_updates_entries(const int proto_id);
+
+/** Check whether the tap of an Export Object extends entries after adding
+ * them, see set_eo_updates_entries()
+ *
+ * @param eo Registered Export Object
+ * @return true if entries can change until tapping is done
+ */
+WS_DLL_PUBLIC bool get_eo_updates_entries(register_eo_t* eo);
+
 /** Get protocol ID from Export Object
  *
  * @param eo Registered Export Object
@@ -124,6 +141,18 @@ WS_DLL_PUBLIC GString *eo_massage_str(const char *in_str, size_t maxlen, int dup
  */
 WS_DLL_PUBLIC const char *eo_ct2ext(const char *content_type);
 
+/** Move the payload of an entry from memory to a new file in a directory,
+ * so that only its metadata stays in memory. The file is removed by
+ * eo_free_entry().
+ *
+ * @param entry export_object_entry_t structure whose payload to move
+ * @param tmp_dir directory in which to create the file, or NULL for the
+ *  system temporary directory
+ * @return true on success (or if the payload is already in a file); on
+ *  failure the payload stays in memory
+ */
+WS_DLL_PUBLIC bool eo_spill_entry(export_object_entry_t *entry, const char *tmp_dir);
+
 /** Free the contents of export_object_entry_t structure
  *
  * @param entry export_object_entry_t structure to be freed
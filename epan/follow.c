@@ -245,6 +245,127 @@ follow_tvb_tap_listener(void *tapdata, packet_info *pinfo,
     return TAP_PACKET_DONT_REDRAW;
 }
 
+struct follow_multi {
+    register_follow_t *follower;
+    GTree *streams;                     /* stream index -> follow_info_t */
+    follow_multi_record_func record_cb;
+    void *user_data;
+};
+
+static int
+follow_multi_stream_cmp(const void *a, const void *b, void *user_data _U_)
+{
+    unsigned stream_a = GPOINTER_TO_UINT(a);
+    unsigned stream_b = GPOINTER_TO_UINT(b);
+
+    return stream_a < stream_b ? -1 : stream_a > stream_b;
+}
+
+follow_multi_t *
+follow_multi_new(register_follow_t *follower, follow_multi_record_func record_cb, void *user_data)
+{
+    follow_multi_t *multi;
+
+    /* The sub-stream to follow is selected by the tap handlers from
+     * follow_info_t->substream_id, so they can't be demultiplexed here. */
+    if (follower->sub_stream_id != NULL)
+        return NULL;
+
+    multi = g_new0(follow_multi_t, 1);
+    multi->follower = follower;
+    multi->streams = g_tree_new_full(follow_multi_stream_cmp, NULL, NULL, (GDestroyNotify)follow_info_free);
+    multi->record_cb = record_cb;
+    multi->user_data = user_data;
+    return multi;
+}
+
+tap_packet_status
+follow_multi_tap_listener(void *tapdata, packet_info *pinfo,
+                          epan_dissect_t *edt, const void *data, tap_flags_t flags)
+{
+    follow_multi_t *multi = (follow_multi_t *)tapdata;
+    follow_info_t *follow_info;
+    follow_record_t *follow_record;
+    unsigned stream = 0, sub_stream = 0;
+    char *filter;
+    GList *cur;
+    tap_packet_status status;
+
+    filter = multi->follower->conv_filter(edt, pinfo, &stream, &sub_stream);
+    if (filter == NULL)
+        return TAP_PACKET_DONT_REDRAW;
+    g_free(filter);
+
+    follow_info = (follow_info_t *)g_tree_lookup(multi->streams, GUINT_TO_POINTER(stream));
+    if (follow_info == NULL) {
+        follow_info = g_new0(follow_info_t, 1);
+        follow_info->show_stream = BOTH_HOSTS;
+        follow_info->substream_id = SUBSTREAM_UNUSED;
+        follow_info->filter_out_filter = multi->follower->index_filter(stream, 0);
+        g_tree_insert(multi->streams, GUINT_TO_POINTER(stream), follow_info);
+    }
+
+    status = multi->follower->tap_handler(follow_info, pinfo, edt, data, flags);
+
+    if (multi->record_cb == NULL || follow_info->payload == NULL)
+        return status;
+
+    /* Hand the new records over oldest first and drop them, so memory
+     * use is bounded by the records held back for reassembly. */
+    follow_info->payload = g_list_reverse(follow_info->payload);
+    for (cur = follow_info->payload; cur; cur = g_list_next(cur)) {
+        follow_record = (follow_record_t *)cur->data;
+        multi->record_cb(follow_info, stream, follow_record, multi->user_data);
+        if (follow_record->data)
+            g_byte_array_free(follow_record->data, true);
+        g_free(follow_record);
+    }
+    g_list_free(follow_info->payload);
+    follow_info->payload = NULL;
+
+    return status;
+}
+
+void
+follow_multi_reset(void *tapdata)
+{
+    follow_multi_t *multi = (follow_multi_t *)tapdata;
+
+    g_tree_destroy(multi->streams);
+    multi->streams = g_tree_new_full(follow_multi_stream_cmp, NULL, NULL, (GDestroyNotify)follow_info_free);
+}
+
+typedef struct {
+    follow_multi_stream_func func;
+    void *user_data;
+} follow_multi_foreach_t;
+
+static gboolean
+follow_multi_foreach_cb(void *key, void *value, void *data)
+{
+    follow_multi_foreach_t *foreach = (follow_multi_foreach_t *)data;
+
+    return foreach->func((follow_info_t *)value, GPOINTER_TO_UINT(key), foreach->user_data);
+}
+
+void
+follow_multi_foreach_stream(follow_multi_t *multi, follow_multi_stream_func func, void *user_data)
+{
+    follow_multi_foreach_t foreach = { func, user_data };
+
+    g_tree_foreach(multi->streams, follow_multi_foreach_cb, &foreach);
+}
+
+void
+follow_multi_free(follow_multi_t *multi)
+{
+    if (multi == NULL)
+        return;
+
+    g_tree_destroy(multi->streams);
+    g_free(multi);
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -216,6 +216,75 @@ WS_DLL_PUBLIC void follow_reset_stream(follow_info_t* info);
  */
 WS_DLL_PUBLIC void follow_info_free(follow_info_t* follow_info);
 
+/* Following several streams at once */
+
+/** Multi-stream follow state, see follow_multi_new()
+ */
+typedef struct follow_multi follow_multi_t;
+
+/** Called by follow_multi_tap_listener() for each record the follower's
+ * tap handler produces, oldest first. The record is freed when the
+ * callback returns.
+ *
+ * @param info [in] Per-stream follower info (addresses, ports, counters)
+ * @param stream [in] Stream index
+ * @param record [in] New payload record
+ * @param user_data [in] Data passed to follow_multi_new()
+ */
+typedef void (*follow_multi_record_func)(follow_info_t *info, unsigned stream, follow_record_t *record, void *user_data);
+
+/** Called by follow_multi_foreach_stream() for each stream seen so far,
+ * in ascending stream index order.
+ *
+ * @return true to stop the traversal
+ */
+typedef bool (*follow_multi_stream_func)(follow_info_t *info, unsigned stream, void *user_data);
+
+/** Create the state for following every stream of a follower in a single
+ * pass. Register it as tap data together with follow_multi_tap_listener()
+ * and follow_multi_reset(), using the follower's tap string and an optional
+ * filter that selects the streams of interest.
+ *
+ * Each packet is assigned to its stream with the follower's conversation
+ * filter function, and then passed to the follower's own tap handler with
+ * a follow_info_t of that stream.
+ *
+ * Followers with sub-streams (HTTP/2, QUIC, MP2T) are not supported.
+ *
+ * @param follower [in] Registered follower
+ * @param record_cb [in] Called with every new record. If NULL, records are
+ * kept in the payload of each stream's follow_info_t instead.
+ * @param user_data [in] Passed to record_cb
+ * @return The new state, or NULL if the follower is not supported
+ */
+WS_DLL_PUBLIC follow_multi_t *follow_multi_new(register_follow_t *follower, follow_multi_record_func record_cb, void *user_data);
+
+/** Tap listener for follow_multi_t tap data
+ */
+WS_DLL_PUBLIC tap_packet_status
+follow_multi_tap_listener(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data, tap_flags_t flags);
+
+/** Forget all streams for retapping
+ *
+ * @param tapdata [in] follow_multi_t state
+ */
+WS_DLL_PUBLIC void follow_multi_reset(void *tapdata);
+
+/** Call func for each stream seen so far, in ascending stream order
+ *
+ * @param multi [in] follow_multi_t state
+ * @param func [in] Function to call
+ * @param user_data [in] Passed to func
+ */
+WS_DLL_PUBLIC void follow_multi_foreach_stream(follow_multi_t *multi, follow_multi_stream_func func, void *user_data);
+
+/** Free follow_multi_t state and the follow_info_t of every stream
+ * (except their GUI elements)
+ *
+ * @param multi [in] follow_multi_t state
+ */
+WS_DLL_PUBLIC void follow_multi_free(follow_multi_t *multi);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
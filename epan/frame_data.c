@@ -11,6 +11,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/epan.h>
@@ -20,6 +22,34 @@
 #include <wiretap/wtap.h>
 #include <wsutil/ws_assert.h>
 
+/* The rarely set fields of a frame_data, allocated only when one of them
+   is set. */
+typedef struct _frame_data_cold {
+  nstime_t     shift_offset; /**< How much the abs_ts of the frame is shifted */
+  GArray      *aggregation_ids;  /**< Interned ids of the aggregation_keys used for rendering the aggregation view. */
+  unsigned     aggregation_group; /**< Interned id of aggregation_ids as a whole, 0 if not yet known. */
+} frame_data_cold;
+
+static frame_data_cold *
+frame_data_cold_get(frame_data *fdata)
+{
+  if (fdata->cold == NULL) {
+    fdata->cold = g_new0(frame_data_cold, 1);
+  }
+  return fdata->cold;
+}
+
+/* Free the cold fields if none of them are set any more. */
+static void
+frame_data_cold_release(frame_data *fdata)
+{
+  if (fdata->cold && fdata->cold->aggregation_ids == NULL &&
+      nstime_is_zero(&fdata->cold->shift_offset)) {
+    g_free(fdata->cold);
+    fdata->cold = NULL;
+  }
+}
+
 #define COMPARE_FRAME_NUM()     ((fdata1->num < fdata2->num) ? -1 : \
                                  (fdata1->num > fdata2->num) ? 1 : \
                                  0)
@@ -232,20 +262,86 @@ frame_compare_delta_times_prev_displayed(const struct epan_session *epan, const
                                    fdata2, have_del_dis_ts2, &del_dis_ts2);
 }
 
-static int
-frame_data_aggregation_values_compare(GSList* list1, GSList* list2) {
-  GHashTable* set = g_hash_table_new(g_str_hash, g_str_equal);
-  for (GSList* node = list1; node; node = node->next)
-    g_hash_table_add(set, node->data);
-
-  for (GSList* node = list2; node; node = node->next) {
-    if (g_hash_table_contains(set, node->data)) {
-      g_hash_table_destroy(set);
-      return 0;
+/*
+ * Aggregation keys are interned: each distinct field and set of values
+ * is stored once and given an id, starting at 1, and each frame keeps
+ * only an array of the ids of its keys. That array is interned in turn
+ * into a group id, so that the aggregation view can group frames with a
+ * hash table instead of comparing every frame with every group. Both
+ * tables outlive rescans, which free and retap the keys of each frame.
+ */
+static GHashTable *aggregation_key_ids;   /* aggregation_key * -> id */
+static GPtrArray  *aggregation_key_table; /* id - 1 -> aggregation_key * */
+static GHashTable *aggregation_group_ids; /* GBytes of key ids -> id */
+
+static unsigned
+aggregation_key_hash(const void *data)
+{
+  const aggregation_key *key = (const aggregation_key *)data;
+  unsigned hash = g_str_hash(key->field);
+
+  for (GSList *node = key->values; node; node = node->next)
+    hash = hash * 31 + g_str_hash(node->data);
+  return hash;
+}
+
+static gboolean
+aggregation_key_equal(const void *data1, const void *data2)
+{
+  const aggregation_key *key1 = (const aggregation_key *)data1;
+  const aggregation_key *key2 = (const aggregation_key *)data2;
+  GSList *node1, *node2;
+
+  if (key1->values_num != key2->values_num || strcmp(key1->field, key2->field) != 0)
+    return FALSE;
+  for (node1 = key1->values, node2 = key2->values; node1 && node2;
+       node1 = node1->next, node2 = node2->next) {
+    if (strcmp((const char *)node1->data, (const char *)node2->data) != 0)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* Sort the values of a key and drop duplicates, so that keys with the
+   same set of values are equal. */
+static void
+aggregation_key_canonicalize(aggregation_key *key)
+{
+  GSList *node;
+
+  key->values = g_slist_sort(key->values, (GCompareFunc)g_strcmp0);
+  node = key->values;
+  while (node && node->next) {
+    if (strcmp((const char *)node->data, (const char *)node->next->data) == 0) {
+      GSList *dup = node->next;
+      g_free(dup->data);
+      node->next = dup->next;
+      g_slist_free_1(dup);
+      key->values_num--;
+    } else {
+      node = node->next;
     }
   }
-  g_hash_table_destroy(set);
-  return 1;
+}
+
+/* Takes ownership of key. */
+static unsigned
+aggregation_key_intern(aggregation_key *key)
+{
+  void *id;
+
+  aggregation_key_canonicalize(key);
+  if (aggregation_key_ids == NULL) {
+    aggregation_key_ids = g_hash_table_new(aggregation_key_hash, aggregation_key_equal);
+    aggregation_key_table = g_ptr_array_new_with_free_func(free_aggregation_key);
+  }
+  if (g_hash_table_lookup_extended(aggregation_key_ids, key, NULL, &id)) {
+    free_aggregation_key(key);
+    return GPOINTER_TO_UINT(id);
+  }
+  g_ptr_array_add(aggregation_key_table, key);
+  g_hash_table_insert(aggregation_key_ids, key, GUINT_TO_POINTER(aggregation_key_table->len));
+  return aggregation_key_table->len;
 }
 
 void
@@ -331,26 +427,177 @@ frame_data_compare(const struct epan_session *epan, const frame_data *fdata1, co
   g_return_val_if_reached(0);
 }
 
+enum {
+  FRAME_SORT_NO_TS,     /* Sorts before everything else */
+  FRAME_SORT_REF_TIME,  /* Sorts before other time stamps */
+  FRAME_SORT_VALUE
+};
+
+void
+frame_data_get_sort_key(const struct epan_session *epan, const frame_data *fdata, int field, frame_data_sort_key_t *key)
+{
+  nstime_t ts;
+  bool have_ts;
+
+  key->order = FRAME_SORT_VALUE;
+  key->value = 0;
+  key->nsecs = 0;
+
+  switch (field) {
+  case COL_NUMBER:
+    /* The frame number itself breaks the tie. */
+    return;
+
+  case COL_NUMBER_DIS:
+    key->value = fdata->dis_num;
+    return;
+
+  case COL_PACKET_LENGTH:
+    key->value = fdata->pkt_len;
+    return;
+
+  case COL_CUMULATIVE_BYTES:
+    key->value = fdata->cum_bytes;
+    return;
+
+  case COL_CLS_TIME:
+    switch (timestamp_get_type()) {
+    case TS_ABSOLUTE:
+    case TS_ABSOLUTE_WITH_YMD:
+    case TS_ABSOLUTE_WITH_YDOY:
+    case TS_UTC:
+    case TS_UTC_WITH_YMD:
+    case TS_UTC_WITH_YDOY:
+    case TS_EPOCH:
+      ts = fdata->abs_ts;
+      have_ts = true;
+      break;
+
+    case TS_RELATIVE:
+      have_ts = frame_rel_time(epan, fdata, &ts);
+      break;
+
+    case TS_RELATIVE_CAP:
+      have_ts = frame_rel_start_time(epan, fdata, &ts);
+      break;
+
+    case TS_DELTA:
+      have_ts = frame_delta_time_prev_captured(epan, fdata, &ts);
+      break;
+
+    case TS_DELTA_DIS:
+      have_ts = frame_delta_time_prev_displayed(epan, fdata, &ts);
+      break;
+
+    default:
+      /* All frames compare equal. */
+      return;
+    }
+    break;
+
+  case COL_ABS_TIME:
+  case COL_ABS_YMD_TIME:
+  case COL_ABS_YDOY_TIME:
+  case COL_UTC_TIME:
+  case COL_UTC_YMD_TIME:
+  case COL_UTC_YDOY_TIME:
+    ts = fdata->abs_ts;
+    have_ts = true;
+    break;
+
+  case COL_REL_TIME:
+    have_ts = frame_rel_time(epan, fdata, &ts);
+    break;
+
+  case COL_DELTA_TIME:
+    have_ts = frame_delta_time_prev_captured(epan, fdata, &ts);
+    break;
+
+  case COL_DELTA_TIME_DIS:
+    have_ts = frame_delta_time_prev_displayed(epan, fdata, &ts);
+    break;
+
+  default:
+    g_return_if_reached();
+  }
+
+  /* As in frame_compare_time_deltas() and COMPARE_TS_REAL(). */
+  if (!have_ts) {
+    key->order = FRAME_SORT_NO_TS;
+    return;
+  }
+  key->order = fdata->ref_time ? FRAME_SORT_REF_TIME : FRAME_SORT_VALUE;
+  key->value = ts.secs;
+  key->nsecs = ts.nsecs;
+}
+
+int
+frame_data_compare_sort_keys(const frame_data_sort_key_t *key1, const frame_data_sort_key_t *key2)
+{
+  if (key1->order != key2->order)
+    return key1->order < key2->order ? -1 : 1;
+  if (key1->value != key2->value)
+    return key1->value < key2->value ? -1 : 1;
+  if (key1->nsecs != key2->nsecs)
+    return key1->nsecs < key2->nsecs ? -1 : 1;
+  return 0;
+}
+
 int
 frame_data_aggregation_compare(const frame_data* fdata1, const frame_data* fdata2)
 {
-  unsigned length = g_slist_length(fdata1->aggregation_keys);
-  if (length != g_slist_length(fdata2->aggregation_keys)) {
+  unsigned num1, num2;
+  const unsigned *ids1 = frame_data_get_aggregation_key_ids(fdata1, &num1);
+  const unsigned *ids2 = frame_data_get_aggregation_key_ids(fdata2, &num2);
+
+  if (num1 != num2 || (num1 > 0 && memcmp(ids1, ids2, num1 * sizeof(unsigned)) != 0)) {
     return 1;
   }
-  unsigned i = 0;
-  while (i < length) {
-    const aggregation_key* key1 = (aggregation_key*)g_slist_nth_data(fdata1->aggregation_keys, i);
-    const aggregation_key* key2 = (aggregation_key*)g_slist_nth_data(fdata2->aggregation_keys, i);
-    if (g_strcmp0(key1->field, key2->field) != 0 ||
-      frame_data_aggregation_values_compare(key1->values, key2->values) == 1) {
-      return 1;
-    }
-    i++;
-  }
   return 0;
 }
 
+unsigned
+frame_data_get_aggregation_group(frame_data *fdata)
+{
+  frame_data_cold *cold = fdata->cold;
+  GBytes *ids;
+  void *id;
+
+  if (cold == NULL || cold->aggregation_ids == NULL)
+    return 0;
+  if (cold->aggregation_group != 0)
+    return cold->aggregation_group;
+
+  if (aggregation_group_ids == NULL)
+    aggregation_group_ids = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+                                                  (GDestroyNotify)g_bytes_unref, NULL);
+  ids = g_bytes_new(cold->aggregation_ids->data,
+                    cold->aggregation_ids->len * sizeof(unsigned));
+  if (g_hash_table_lookup_extended(aggregation_group_ids, ids, NULL, &id)) {
+    g_bytes_unref(ids);
+  } else {
+    id = GUINT_TO_POINTER(g_hash_table_size(aggregation_group_ids) + 1);
+    g_hash_table_insert(aggregation_group_ids, ids, id);
+  }
+  cold->aggregation_group = GPOINTER_TO_UINT(id);
+  return cold->aggregation_group;
+}
+
+void
+frame_data_aggregation_keys_clear(void)
+{
+  if (aggregation_key_ids) {
+    g_hash_table_destroy(aggregation_key_ids);
+    aggregation_key_ids = NULL;
+    g_ptr_array_free(aggregation_key_table, TRUE);
+    aggregation_key_table = NULL;
+  }
+  if (aggregation_group_ids) {
+    g_hash_table_destroy(aggregation_group_ids);
+    aggregation_group_ids = NULL;
+  }
+}
+
 void
 frame_data_init(frame_data *fdata, uint32_t num, const wtap_rec *rec,
                 int64_t offset, uint32_t cum_bytes)
@@ -423,11 +670,9 @@ frame_data_init(frame_data *fdata, uint32_t num, const wtap_rec *rec,
   fdata->has_modified_block = 0;
   fdata->need_colorize = 0;
   fdata->color_filter = NULL;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
   fdata->frame_ref_num = 0;
   fdata->prev_dis_num = 0;
-  fdata->aggregation_keys = NULL;
+  fdata->cold = NULL;
 }
 
 void
@@ -506,10 +751,8 @@ frame_data_reset(frame_data *fdata)
 void
 frame_data_destroy(frame_data *fdata)
 {
-  if (fdata->pfd) {
-    g_slist_free(fdata->pfd);
-    fdata->pfd = NULL;
-  }
+  /* The proto data is in file scope, which goes away on its own. */
+  fdata->pfd = NULL;
 
   if (fdata->dependent_frames) {
     g_hash_table_destroy(fdata->dependent_frames);
@@ -521,10 +764,74 @@ frame_data_destroy(frame_data *fdata)
 
 void frame_data_aggregation_free(frame_data* fdata)
 {
-  if (fdata->aggregation_keys) {
-    g_slist_free_full(fdata->aggregation_keys, free_aggregation_key);
-    fdata->aggregation_keys = NULL;
+  if (fdata->cold && fdata->cold->aggregation_ids) {
+    g_array_free(fdata->cold->aggregation_ids, TRUE);
+    fdata->cold->aggregation_ids = NULL;
+    fdata->cold->aggregation_group = 0;
+    frame_data_cold_release(fdata);
+  }
+}
+
+void
+frame_data_free_persistent(frame_data *fdata)
+{
+  frame_data_destroy(fdata);
+
+  g_free(fdata->cold);
+  fdata->cold = NULL;
+}
+
+const nstime_t *
+frame_data_get_shift_offset(const frame_data *fdata)
+{
+  static const nstime_t no_shift = NSTIME_INIT_ZERO;
+
+  return fdata->cold ? &fdata->cold->shift_offset : &no_shift;
+}
+
+void
+frame_data_set_shift_offset(frame_data *fdata, const nstime_t *offset)
+{
+  if (nstime_is_zero(offset)) {
+    if (fdata->cold) {
+      nstime_set_zero(&fdata->cold->shift_offset);
+      frame_data_cold_release(fdata);
+    }
+    return;
+  }
+
+  frame_data_cold_get(fdata)->shift_offset = *offset;
+}
+
+const unsigned *
+frame_data_get_aggregation_key_ids(const frame_data *fdata, unsigned *num)
+{
+  if (fdata->cold == NULL || fdata->cold->aggregation_ids == NULL) {
+    *num = 0;
+    return NULL;
   }
+  *num = fdata->cold->aggregation_ids->len;
+  return (const unsigned *)(void *)fdata->cold->aggregation_ids->data;
+}
+
+const aggregation_key *
+frame_data_get_aggregation_key(unsigned id)
+{
+  if (aggregation_key_table == NULL || id == 0 || id > aggregation_key_table->len)
+    return NULL;
+  return (const aggregation_key *)g_ptr_array_index(aggregation_key_table, id - 1);
+}
+
+void
+frame_data_append_aggregation_key(frame_data *fdata, aggregation_key *key)
+{
+  frame_data_cold *cold = frame_data_cold_get(fdata);
+  unsigned id = aggregation_key_intern(key);
+
+  if (cold->aggregation_ids == NULL)
+    cold->aggregation_ids = g_array_new(FALSE, FALSE, sizeof(unsigned));
+  g_array_append_val(cold->aggregation_ids, id);
+  cold->aggregation_group = 0;
 }
 
 /*
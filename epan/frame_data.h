@@ -21,6 +21,8 @@ extern "C" {
 
 typedef struct wtap_rec wtap_rec;
 struct _packet_info;
+/** Protocol data of a frame or packet; see proto_data.h */
+typedef struct _proto_data_vec proto_data_vec_t;
 struct epan_session;
 
 #define PINFO_FD_VISITED(pinfo)   ((pinfo)->fd->visited)
@@ -61,25 +63,21 @@ typedef struct _aggregation_key {
    Try to keep it close to, and less than or equal to, a power of 2.
    "Smaller than a power of 2" is OK for ILP32 platforms.
 
-   XXX - shuffle the fields to try to keep the most commonly-accessed
-   fields within the first 16 or 32 bytes, so they all fit in a cache
-   line? */
+   The fields that are looked at for every frame when filtering, sorting
+   or rescanning come first, so that they fit in the first 40 bytes and
+   thus in a single cache line.  Fields that are set for only a few frames
+   (the time shift offset and the aggregation view keys) are kept in a
+   separately allocated structure, only allocated when they are set, which
+   is reached with the frame_data_get_/set_ helpers below.  On LP64
+   platforms this brings the structure from 104 down to 88 bytes, saving
+   about 16 MB per million frames. */
 struct _color_filter; /* Forward */
+struct _frame_data_cold; /* Forward */
 DIAG_OFF_PEDANTIC
 typedef struct _frame_data {
   uint32_t     num;          /**< Frame number */
-  uint32_t     dis_num;      /**< Displayed frame number */
   uint32_t     pkt_len;      /**< Packet length */
   uint32_t     cap_len;      /**< Amount actually captured */
-  int64_t      file_off;     /**< File offset */
-  /* These two are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
-     LLP64 (64-bit Windows) platforms.  Put them here, one after the
-     other, so they don't require padding between them. */
-  GSList      *pfd;          /**< Per frame proto data */
-  GHashTable  *dependent_frames;     /**< A hash table of frames which this one depends on */
-  const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
-  uint32_t     cum_bytes;    /**< Cumulative bytes into the capture */
-  /* XXX - cum_bytes presumably ought to be 64-bit as well now */
   uint8_t      tcp_snd_manual_analysis;   /**< TCP SEQ Analysis Overriding, 0 = none, 1 = OOO, 2 = RET , 3 = Fast RET, 4 = Spurious RET  */
   /* Keep the bitfields below to 24 bits, so this plus the previous field
      are 32 bits. (XXX - The previous field could be a bitfield too.) */
@@ -95,23 +93,66 @@ typedef struct _frame_data {
   unsigned int has_modified_block : 1; /** 1 = block for this packet has been modified */
   unsigned int need_colorize    : 1; /**< 1 = need to (re-)calculate packet color */
   unsigned int tsprec           : 4; /**< Time stamp precision -2^tsprec gives up to femtoseconds */
+  int64_t      file_off;     /**< File offset */
   nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
+  uint32_t     dis_num;      /**< Displayed frame number */
+  uint32_t     cum_bytes;    /**< Cumulative bytes into the capture */
+  /* XXX - cum_bytes presumably ought to be 64-bit as well now */
   uint32_t     frame_ref_num; /**< Reference frame for relative timestamps (can be this frame) */
   /* frame_ref_num == num if ref_time == true, but also if this is the first
    * record that has_ts (or if somehow a record without a TS is a reference
    * time frame, the first frame after that with has_ts == true.) */
   uint32_t     prev_dis_num; /**< Previous displayed frame (0 if first one) */
-  GSList*      aggregation_keys; /**< Holds the aggregation_key values used for rendering the aggregation view. */
+  /* These are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
+     LLP64 (64-bit Windows) platforms.  Put them here, one after the
+     other, so they don't require padding between them. */
+  proto_data_vec_t *pfd;     /**< Per frame proto data */
+  GHashTable  *dependent_frames;     /**< A hash table of frames which this one depends on */
+  const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
+  struct _frame_data_cold *cold; /**< Rarely set fields, NULL if none are set */
 } frame_data;
 DIAG_ON_PEDANTIC
 
 /** compare two frame_datas */
 WS_DLL_PUBLIC int frame_data_compare(const struct epan_session *epan, const frame_data *fdata1, const frame_data *fdata2, int field);
 
+/**
+ * A frame's value for a field, as compared by frame_data_compare().
+ * Sorting many frames by keys worked out once per frame avoids looking
+ * up the previous or reference frame in every comparison.
+ */
+typedef struct {
+  uint8_t  order;   /**< Compared first: no time stamp, time reference, other */
+  int64_t  value;   /**< The number, or the seconds of a time */
+  int32_t  nsecs;   /**< The nanoseconds of a time */
+} frame_data_sort_key_t;
+
+/** Get the sort key for a field of a frame_data; see frame_data_compare(). */
+WS_DLL_PUBLIC void frame_data_get_sort_key(const struct epan_session *epan, const frame_data *fdata, int field, frame_data_sort_key_t *key);
+
+/**
+ * Compare two sort keys. This gives the same order as frame_data_compare()
+ * for the frames the keys were taken from, except that keys that compare
+ * equal still have to be ordered by frame number.
+ */
+WS_DLL_PUBLIC int frame_data_compare_sort_keys(const frame_data_sort_key_t *key1, const frame_data_sort_key_t *key2);
+
 /** compare two frame_aggregation_field_datas */
 WS_DLL_PUBLIC int frame_data_aggregation_compare(const frame_data* fdata1, const frame_data* fdata2);
 
+/**
+ * The id of the frame's aggregation keys taken together. Frames for which
+ * frame_data_aggregation_compare() returns 0 have the same id, so it can
+ * be used to group frames with a hash table. 0 if the frame has no keys.
+ */
+WS_DLL_PUBLIC unsigned frame_data_get_aggregation_group(frame_data *fdata);
+
+/**
+ * Free the interned aggregation keys. The aggregation keys of every
+ * frame must have been freed, or must be freed before they are used.
+ */
+WS_DLL_PUBLIC void frame_data_aggregation_keys_clear(void);
+
 WS_DLL_PUBLIC void frame_data_reset(frame_data *fdata);
 
 WS_DLL_PUBLIC void frame_data_destroy(frame_data *fdata);
@@ -120,6 +161,33 @@ WS_DLL_PUBLIC void free_aggregation_key(void *key);
 
 WS_DLL_PUBLIC void frame_data_aggregation_free(frame_data *fdata);
 
+/**
+ * Free everything freed by frame_data_destroy() as well as the state
+ * that persists across frame_data_reset(), such as the time shift offset.
+ */
+WS_DLL_PUBLIC void frame_data_free_persistent(frame_data *fdata);
+
+/** How much the abs_ts of the frame is shifted. Never NULL. */
+WS_DLL_PUBLIC const nstime_t *frame_data_get_shift_offset(const frame_data *fdata);
+
+WS_DLL_PUBLIC void frame_data_set_shift_offset(frame_data *fdata, const nstime_t *offset);
+
+/**
+ * The ids of the aggregation_keys used for rendering the aggregation
+ * view, in the order they were appended; *num is set to their number.
+ */
+WS_DLL_PUBLIC const unsigned *frame_data_get_aggregation_key_ids(const frame_data *fdata, unsigned *num);
+
+/** The aggregation_key with the given id, or NULL. */
+WS_DLL_PUBLIC const aggregation_key *frame_data_get_aggregation_key(unsigned id);
+
+/**
+ * Add a key to the frame, taking ownership of it. Its values are sorted
+ * and stripped of duplicates, and it is interned with the keys of other
+ * frames.
+ */
+WS_DLL_PUBLIC void frame_data_append_aggregation_key(frame_data *fdata, aggregation_key *key);
+
 WS_DLL_PUBLIC void frame_data_init(frame_data *fdata, uint32_t num,
                 const wtap_rec *rec, int64_t offset,
                 uint32_t cum_bytes);
@@ -10,42 +10,61 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+
 #include <glib.h>
 
+#ifdef HAVE_MADVISE
+#include <sys/mman.h>
+#endif
+
 #include <epan/packet.h>
 
 #include "frame_data_sequence.h"
 
 /*
- * We store the frame_data structures in a radix tree, with 1024
- * elements per level.  The leaf nodes are arrays of 1024 frame_data
- * structures; the nodes above them are arrays of 1024 pointers to
- * the nodes below them.  The capture_file structure has a pointer
- * to the root node.
+ * We store the frame_data structures in chunks of FRAME_CHUNK_SIZE
+ * bytes, found through an array of pointers to the chunks.  Finding a
+ * frame is a division by a constant and two loads, however many frames
+ * there are, and as chunks never move, neither do the frame_data
+ * structures in them; growing the sequence only ever reallocates the
+ * array of pointers, which for 100 million frames is about 40 KB.
  *
- * As frame numbers are 32 bits, and as 1024 is 2^10, that gives us
- * up to 4 levels of tree.
+ * A chunk is the size of an x86-64 or AArch64 huge page.  Where we can,
+ * we align chunks to that size and ask for them to be backed by huge
+ * pages, as going through the frames of a large capture (filtering,
+ * sorting, rescanning) otherwise spends much of its time on TLB misses.
  */
-#define LOG2_NODES_PER_LEVEL    10
-#define NODES_PER_LEVEL         (1<<LOG2_NODES_PER_LEVEL)
+#define FRAME_CHUNK_SIZE        (2 * 1024 * 1024)
+#define FRAMES_PER_CHUNK        ((uint32_t)(FRAME_CHUNK_SIZE / sizeof(frame_data)))
 
 struct _frame_data_sequence {
   uint32_t     count;           /* Total number of frames */
-  void        *ptree_root;      /* Pointer to the root node */
+  frame_data **chunks;          /* Array of pointers to the chunks */
+  uint32_t     chunks_allocated; /* Number of entries in the chunks array */
 };
 
-/*
- * For a given frame number, calculate the indices into a level 3
- * node, a level 2 node, a level 1 node, and a leaf node.
- */
-#define LEVEL_3_INDEX(framenum) \
-        ((framenum) >> (3*LOG2_NODES_PER_LEVEL))
-#define LEVEL_2_INDEX(framenum) \
-        (((framenum) >> (2*LOG2_NODES_PER_LEVEL)) & (NODES_PER_LEVEL - 1))
-#define LEVEL_1_INDEX(framenum) \
-        (((framenum) >> (1*LOG2_NODES_PER_LEVEL)) & (NODES_PER_LEVEL - 1))
-#define LEAF_INDEX(framenum) \
-        (((framenum) >> (0*LOG2_NODES_PER_LEVEL)) & (NODES_PER_LEVEL - 1))
+static frame_data *
+frame_chunk_alloc(void)
+{
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+  void *chunk;
+
+  if (posix_memalign(&chunk, FRAME_CHUNK_SIZE, FRAME_CHUNK_SIZE) == 0) {
+    /* This is only advice; it doesn't matter if it's not taken. */
+    (void)madvise(chunk, FRAME_CHUNK_SIZE, MADV_HUGEPAGE);
+    return (frame_data *)chunk;
+  }
+#endif
+  return (frame_data *)g_malloc(FRAME_CHUNK_SIZE);
+}
+
+static void
+frame_chunk_free(frame_data *chunk)
+{
+  /* g_free() is free(), so this works for posix_memalign()ed chunks too. */
+  g_free(chunk);
+}
 
 frame_data_sequence *
 new_frame_data_sequence(void)
@@ -54,22 +73,14 @@ new_frame_data_sequence(void)
 
   fds = (frame_data_sequence *)g_malloc(sizeof *fds);
   fds->count = 0;
-  fds->ptree_root = NULL;
+  fds->chunks = NULL;
+  fds->chunks_allocated = 0;
   return fds;
 }
 
-/*
- * Add a new frame_data structure to a frame_data_sequence.
- */
 frame_data *
 frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
 {
-  frame_data *leaf;
-  frame_data **level1;
-  frame_data ***level2;
-  frame_data ****level3;
-  frame_data *node;
-
   /*
    * The current value of fds->count is the index value for the new frame,
    * because the index value for a frame is the frame number - 1, and
@@ -77,112 +88,27 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
    * the last frame in the collection is fds->count, so its index value
    * is fds->count - 1.
    */
-  if (fds->count == 0) {
-    /* The tree is empty; allocate the first leaf node, which will be
-       the root node. */
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-    node = &leaf[0];
-    fds->ptree_root = leaf;
-  } else if (fds->count < NODES_PER_LEVEL) {
-    /* It's a 1-level tree, and is going to stay that way for now. */
-    leaf = (frame_data *)fds->ptree_root;
-    node = &leaf[fds->count];
-  } else if (fds->count == NODES_PER_LEVEL) {
-    /* It's a 1-level tree that will turn into a 2-level tree. */
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-    level1[0] = (frame_data *)fds->ptree_root;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-    level1[1] = leaf;
-    node = &leaf[0];
-    fds->ptree_root = level1;
-  } else if (fds->count < NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 2-level tree, and is going to stay that way for now. */
-    level1 = (frame_data **)fds->ptree_root;
-    leaf = level1[fds->count >> LOG2_NODES_PER_LEVEL];
-    if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-      level1[fds->count >> LOG2_NODES_PER_LEVEL] = leaf;
-    }
-    node = &leaf[LEAF_INDEX(fds->count)];
-  } else if (fds->count == NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 2-level tree that will turn into a 3-level tree */
-    level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
-    level2[0] = (frame_data **)fds->ptree_root;
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-    level2[1] = level1;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-    level1[0] = leaf;
-    node = &leaf[0];
-    fds->ptree_root = level2;
-  } else if (fds->count < NODES_PER_LEVEL*NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 3-level tree, and is going to stay that way for now. */
-    level2 = (frame_data ***)fds->ptree_root;
-    level1 = level2[fds->count >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)];
-    if (level1 == NULL) {
-      level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-      level2[fds->count >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)] = level1;
-    }
-    leaf = level1[LEVEL_1_INDEX(fds->count)];
-    if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-      level1[LEVEL_1_INDEX(fds->count)] = leaf;
-    }
-    node = &leaf[LEAF_INDEX(fds->count)];
-  } else if (fds->count == NODES_PER_LEVEL*NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 3-level tree that will turn into a 4-level tree */
-    level3 = (frame_data ****)g_malloc0((sizeof *level3)*NODES_PER_LEVEL);
-    level3[0] = (frame_data ***)fds->ptree_root;
-    level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
-    level3[1] = level2;
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-    level2[0] = level1;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-    level1[0] = leaf;
-    node = &leaf[0];
-    fds->ptree_root = level3;
-  } else {
-    /* fds->count is 2^32-1 at most, and NODES_PER_LEVEL^4
-       2^(LOG2_NODES_PER_LEVEL*4), and LOG2_NODES_PER_LEVEL is 10,
-       so fds->count is always less < NODES_PER_LEVEL^4.
+  uint32_t    chunk_index = fds->count / FRAMES_PER_CHUNK;
+  frame_data *node;
 
-       XXX - we should fail if fds->count is 2^31-1, or should
-       make the frame numbers 64-bit and just let users run
-       themselves out of address space or swap space. :-) */
-    /* It's a 4-level tree, and is going to stay that way forever. */
-    level3 = (frame_data ****)fds->ptree_root;
-    level2 = level3[LEVEL_3_INDEX(fds->count)];
-    if (level2 == NULL) {
-      level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
-      level3[LEVEL_3_INDEX(fds->count)] = level2;
-    }
-    level1 = level2[LEVEL_2_INDEX(fds->count)];
-    if (level1 == NULL) {
-      level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-      level2[LEVEL_2_INDEX(fds->count)] = level1;
-    }
-    leaf = level1[LEVEL_1_INDEX(fds->count)];
-    if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-      level1[LEVEL_1_INDEX(fds->count)] = leaf;
+  if (fds->count % FRAMES_PER_CHUNK == 0) {
+    /* The last chunk, if any, is full; start a new one. */
+    if (chunk_index == fds->chunks_allocated) {
+      fds->chunks_allocated = fds->chunks_allocated ? fds->chunks_allocated * 2 : 16;
+      fds->chunks = (frame_data **)g_realloc(fds->chunks,
+          sizeof *fds->chunks * fds->chunks_allocated);
     }
-    node = &leaf[LEAF_INDEX(fds->count)];
+    fds->chunks[chunk_index] = frame_chunk_alloc();
   }
+  node = &fds->chunks[chunk_index][fds->count % FRAMES_PER_CHUNK];
   *node = *fdata;
   fds->count++;
   return node;
 }
 
-/*
- * Find the frame_data for the specified frame number.
- */
 frame_data *
 frame_data_sequence_find(frame_data_sequence *fds, uint32_t num)
 {
-  frame_data *leaf;
-  frame_data **level1;
-  frame_data ***level2;
-  frame_data ****level3;
-
   if (num == 0 || fds == NULL) {
     /* There is no frame number 0 */
     return NULL;
@@ -195,85 +121,23 @@ frame_data_sequence_find(frame_data_sequence *fds, uint32_t num)
     return NULL;
   }
 
-  if (fds->count <= NODES_PER_LEVEL) {
-    /* It's a 1-level tree. */
-    leaf = (frame_data *)fds->ptree_root;
-    return &leaf[num];
-  }
-  if (fds->count <= NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 2-level tree. */
-    level1 = (frame_data **)fds->ptree_root;
-    leaf = level1[num >> LOG2_NODES_PER_LEVEL];
-    return &leaf[LEAF_INDEX(num)];
-  }
-  if (fds->count <= NODES_PER_LEVEL*NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 3-level tree. */
-    level2 = (frame_data ***)fds->ptree_root;
-    level1 = level2[num >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)];
-    leaf = level1[(num >> LOG2_NODES_PER_LEVEL) & (NODES_PER_LEVEL - 1)];
-    return &leaf[LEAF_INDEX(num)];
-  }
-  /* fds->count is 2^32-1 at most, and NODES_PER_LEVEL^4
-     2^(LOG2_NODES_PER_LEVEL*4), and LOG2_NODES_PER_LEVEL is 10,
-     so fds->count is always less < NODES_PER_LEVEL^4. */
-  /* It's a 4-level tree, and is going to stay that way forever. */
-  level3 = (frame_data ****)fds->ptree_root;
-  level2 = level3[num >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)];
-  level1 = level2[(num >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)) & (NODES_PER_LEVEL - 1)];
-  leaf = level1[(num >> LOG2_NODES_PER_LEVEL) & (NODES_PER_LEVEL - 1)];
-  return &leaf[LEAF_INDEX(num)];
+  return &fds->chunks[num / FRAMES_PER_CHUNK][num % FRAMES_PER_CHUNK];
 }
 
-/* recursively frees a frame_data radix level */
-static void
-// NOLINTNEXTLINE(misc-no-recursion)
-free_frame_data_array(void *array, unsigned count, unsigned level, bool last)
+frame_data *
+frame_data_sequence_find_run(frame_data_sequence *fds, uint32_t num,
+    uint32_t *run_len)
 {
-  unsigned i, level_count;
-
-  if (last) {
-    /* if we are the last in our given parent's row, we may not have
-     * exactly a full row, so do the bit twiddling to figure out exactly
-     * how many fields we have */
-    level_count = (count >> ((level - 1) * LOG2_NODES_PER_LEVEL)) &
-                  (NODES_PER_LEVEL - 1);
-    /* the above calculation rounds down, so make sure we count correctly
-     * if count is not an even multiple of NODES_PER_LEVEL */
-    if (count & ((1 << ((level - 1) * LOG2_NODES_PER_LEVEL)) - 1)) {
-      level_count++;
-    }
-  }
-  else {
-    /* if we're not the last in our parent, then we're guaranteed to have
-     * a full array */
-    level_count = NODES_PER_LEVEL;
-  }
-
-
-  if (level > 1) {
-    /* recurse on every sub-array, passing on our own 'last' value
-     * specially to our last child */
-    frame_data **real_array = (frame_data **) array;
+  frame_data *fdata = frame_data_sequence_find(fds, num);
 
-    for (i=0; i < level_count-1; i++) {
-      // We recurse here, but we're limited to four levels.
-      free_frame_data_array(real_array[i], count, level-1, false);
-    }
-
-    // We recurse here, but we're limited to four levels.
-    free_frame_data_array(real_array[level_count-1], count, level-1, last);
-  }
-  else if (level == 1) {
-    /* bottom level, so just clean up all the frame data */
-    frame_data *real_array = (frame_data *) array;
-
-    for (i=0; i < level_count; i++) {
-      frame_data_destroy(&real_array[i]);
-    }
+  if (fdata == NULL) {
+    *run_len = 0;
+    return NULL;
   }
 
-  /* free the array itself */
-  g_free(array);
+  num--;
+  *run_len = MIN(FRAMES_PER_CHUNK - num % FRAMES_PER_CHUNK, fds->count - num);
+  return fdata;
 }
 
 /*
@@ -282,33 +146,15 @@ free_frame_data_array(void *array, unsigned count, unsigned level, bool last)
 void
 free_frame_data_sequence(frame_data_sequence *fds)
 {
-  unsigned   levels;
+  uint32_t i;
 
-  /* calculate how many levels we have */
-  if (fds->count == 0) {
-    /* The tree is empty; there are no levels. */
-    levels = 0;
-  } else if (fds->count <= NODES_PER_LEVEL) {
-    /* It's a 1-level tree. */
-    levels = 1;
-  } else if (fds->count <= NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 2-level tree. */
-    levels = 2;
-  } else if (fds->count <= NODES_PER_LEVEL*NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 3-level tree. */
-    levels = 3;
-  } else {
-    /* fds->count is 2^32-1 at most, and NODES_PER_LEVEL^4
-       2^(LOG2_NODES_PER_LEVEL*4), and LOG2_NODES_PER_LEVEL is 10,
-       so fds->count is always less < NODES_PER_LEVEL^4. */
-    /* It's a 4-level tree. */
-    levels = 4;
+  for (i = 0; i < fds->count; i++) {
+    frame_data_free_persistent(&fds->chunks[i / FRAMES_PER_CHUNK][i % FRAMES_PER_CHUNK]);
   }
-
-  /* call the recursive free function */
-  if (levels > 0) {
-    free_frame_data_array(fds->ptree_root, fds->count, levels, true);
+  for (i = 0; i * FRAMES_PER_CHUNK < fds->count; i++) {
+    frame_chunk_free(fds->chunks[i]);
   }
+  g_free(fds->chunks);
 
   /* free the header struct */
   g_free(fds);
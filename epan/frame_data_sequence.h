@@ -30,6 +30,15 @@ WS_DLL_PUBLIC frame_data *frame_data_sequence_add(frame_data_sequence *fds,
 WS_DLL_PUBLIC frame_data *frame_data_sequence_find(frame_data_sequence *fds,
     uint32_t num);
 
+/*
+ * Find the frame_data for the specified frame number, and how many
+ * frames, starting with that one, are stored one after the other, so
+ * that a loop over many frames can step through them with a pointer
+ * rather than looking each of them up.
+ */
+WS_DLL_PUBLIC frame_data *frame_data_sequence_find_run(frame_data_sequence *fds,
+    uint32_t num, uint32_t *run_len);
+
 /*
  * Free a frame_data_sequence and all the frame_data structures in it.
  */
@@ -18,6 +18,8 @@
 #include <epan/tvbuff.h>
 #include <epan/in_cksum.h>
 
+#include <wsutil/ws_cksum.h>
+
 /*
  * Checksum routine for Internet Protocol family headers (Portable Version).
  *
@@ -28,6 +30,13 @@
 #define ADDCARRY(x)  {if ((x) > 65535) (x) -= 65535;}
 #define REDUCE {l_util.l = sum; sum = l_util.s[0] + l_util.s[1]; ADDCARRY(sum);}
 
+/*
+ * Runs of at least this many bytes are handed to ws_cksum_sum16(), which
+ * adds them up with SIMD instructions where it can; below this the call
+ * isn't worth it.
+ */
+#define IN_CKSUM_BULK_MIN 64
+
 /*
  * Linux and Windows, at least, when performing Local Checksum Offload
  * store the one's complement sum (not inverted to its bitwise complement)
@@ -94,6 +103,13 @@ in_cksum_ret_partial(const vec_t *vec, int veclen, uint16_t *partial)
 			mlen--;
 			byte_swapped = 1;
 		}
+		if (mlen >= IN_CKSUM_BULK_MIN) {
+			int bulk = mlen & ~1;
+
+			sum += ws_cksum_sum16(w, bulk);
+			w += bulk / 2;
+			mlen -= bulk;
+		}
 		/*
 		 * Unroll the loop to make overhead from
 		 * branches &c small.
@@ -23,26 +23,43 @@ typedef struct {
     uint8_t kind;
 } manuf_registry_t;
 
+/*
+ * The names are stored in a few string pools (each small enough for
+ * compilers that limit the size of string literals) and referenced by
+ * pool number and offset instead of by pointer. This keeps the tables
+ * free of relocations, so they stay in read-only memory that is shared
+ * between processes instead of being copied into every process at startup.
+ */
+typedef uint32_t manuf_str_t;
+
+#define MANUF_STR(pool, offset) ((manuf_str_t)(((pool) << 16) | (offset)))
+
 typedef struct {
     uint8_t oui24[3];
-    const char *short_name;
-    const char *long_name;
+    manuf_str_t short_name;
+    manuf_str_t long_name;
 } manuf_oui24_t;
 
 typedef struct {
     uint8_t oui28[4];
-    const char *short_name;
-    const char *long_name;
+    manuf_str_t short_name;
+    manuf_str_t long_name;
 } manuf_oui28_t;
 
 typedef struct {
     uint8_t oui36[5];
-    const char *short_name;
-    const char *long_name;
+    manuf_str_t short_name;
+    manuf_str_t long_name;
 } manuf_oui36_t;
 
 #include "manuf-data.c"
 
+static inline const char *
+manuf_str(manuf_str_t str)
+{
+    return manuf_string_pools[str >> 16] + (str & 0xFFFF);
+}
+
 static int
 compare_oui24_registry(const void *key, const void *element)
 {
@@ -137,8 +154,8 @@ ws_manuf_lookup(const uint8_t addr[6], const char **long_name_ptr, unsigned *mas
         {
             const manuf_oui24_t *ptr = manuf_oui24_lookup(addr_copy);
             if (ptr) {
-                short_name = ptr->short_name;
-                long_name = ptr->long_name;
+                short_name = manuf_str(ptr->short_name);
+                long_name = manuf_str(ptr->long_name);
                 mask = 24;
             }
             break;
@@ -147,8 +164,8 @@ ws_manuf_lookup(const uint8_t addr[6], const char **long_name_ptr, unsigned *mas
         {
             const manuf_oui28_t *ptr = manuf_oui28_lookup(addr_copy);
             if (ptr) {
-                short_name = ptr->short_name;
-                long_name = ptr->long_name;
+                short_name = manuf_str(ptr->short_name);
+                long_name = manuf_str(ptr->long_name);
                 mask = 28;
             }
             break;
@@ -157,8 +174,8 @@ ws_manuf_lookup(const uint8_t addr[6], const char **long_name_ptr, unsigned *mas
         {
             const manuf_oui36_t *ptr = manuf_oui36_lookup(addr_copy);
             if (ptr) {
-                short_name = ptr->short_name;
-                long_name = ptr->long_name;
+                short_name = manuf_str(ptr->short_name);
+                long_name = manuf_str(ptr->long_name);
                 mask = 36;
             }
             break;
@@ -197,8 +214,8 @@ ws_manuf_lookup_oui24(const uint8_t oui[3], const char **long_name_ptr)
         {
             const manuf_oui24_t *ptr = manuf_oui24_lookup(addr_copy);
             if (ptr) {
-                short_name = ptr->short_name;
-                long_name = ptr->long_name;
+                short_name = manuf_str(ptr->short_name);
+                long_name = manuf_str(ptr->long_name);
             }
             break;
         }
@@ -228,8 +245,8 @@ copy_oui24(struct ws_manuf *dst, const manuf_oui24_t *src)
     dst->block[3] = 0;
     dst->block[4] = 0;
     dst->mask = 24;
-    dst->short_name = src->short_name;
-    dst->long_name = src->long_name;
+    dst->short_name = manuf_str(src->short_name);
+    dst->long_name = manuf_str(src->long_name);
     return dst;
 }
 
@@ -239,8 +256,8 @@ copy_oui28(struct ws_manuf *dst, const manuf_oui28_t *src)
     memcpy(dst->block, src->oui28, sizeof(src->oui28));
     dst->block[4] = 0;
     dst->mask = 28;
-    dst->short_name = src->short_name;
-    dst->long_name = src->long_name;
+    dst->short_name = manuf_str(src->short_name);
+    dst->long_name = manuf_str(src->long_name);
     return dst;
 }
 
@@ -249,8 +266,8 @@ copy_oui36(struct ws_manuf *dst, const manuf_oui36_t *src)
 {
     memcpy(dst->block, src->oui36, sizeof(src->oui36));
     dst->mask = 36;
-    dst->short_name = src->short_name;
-    dst->long_name = src->long_name;
+    dst->short_name = manuf_str(src->short_name);
+    dst->long_name = manuf_str(src->long_name);
     return dst;
 }
 
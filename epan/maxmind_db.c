@@ -69,11 +69,19 @@ typedef struct _mmdbr_response_t {
     bool is_ipv4;
     ws_in4_addr ipv4_addr;
     ws_in6_addr ipv6_addr;
+    uint32_t prefix_len; // Network the result applies to, 0 = just this address
     mmdb_lookup_t mmdb_val;
 } mmdb_response_t;
 
 static wmem_map_t *mmdb_ipv4_map;
 static wmem_map_t *mmdb_ipv6_map;
+
+// Results that apply to a whole network, indexed by prefix length and then
+// by the masked network address. Consulted before sending an address to
+// mmdbresolve so that neighbors of a resolved address don't need a round
+// trip of their own.
+static wmem_map_t *mmdb_ipv4_prefix_maps[32 + 1];
+static wmem_map_t *mmdb_ipv6_prefix_maps[128 + 1];
 static GAsyncQueue *mmdbr_response_q; // g_allocated mmdbr_response_t *
 static GThread *read_mmdbr_stdout_thread;
 
@@ -123,6 +131,7 @@ static void mmdb_resolve_stop(void);
 #define RES_LOCATION_LATITUDE   "location.latitude"
 #define RES_LOCATION_LONGITUDE  "location.longitude"
 #define RES_LOCATION_ACCURACY   "location.accuracy_radius"
+#define RES_PREFIX_LEN          "mmdbresolve.prefix_len"
 #define RES_END                 "# End "
 
 // Interned strings and v6 addresses, similar to GLib's string chunks.
@@ -153,6 +162,45 @@ static void init_lookup(mmdb_lookup_t *lookup) {
     *lookup = empty_lookup;
 }
 
+static ws_in4_addr ipv4_network(ws_in4_addr addr, unsigned prefix_len) {
+    return addr & g_htonl(~UINT32_C(0) << (32 - prefix_len));
+}
+
+static void ipv6_network(const ws_in6_addr *addr, unsigned prefix_len, ws_in6_addr *network) {
+    *network = *addr;
+    for (unsigned bit = prefix_len; bit < 128; bit++) {
+        network->bytes[bit / 8] &= ~(0x80 >> (bit % 8));
+    }
+}
+
+static mmdb_lookup_t *lookup_ipv4_prefix(ws_in4_addr addr) {
+    for (unsigned prefix_len = 32; prefix_len > 0; prefix_len--) {
+        if (mmdb_ipv4_prefix_maps[prefix_len]) {
+            mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_prefix_maps[prefix_len],
+                    GUINT_TO_POINTER(ipv4_network(addr, prefix_len)));
+            if (result) {
+                return result;
+            }
+        }
+    }
+    return NULL;
+}
+
+static mmdb_lookup_t *lookup_ipv6_prefix(const ws_in6_addr *addr) {
+    ws_in6_addr network;
+
+    for (unsigned prefix_len = 128; prefix_len > 0; prefix_len--) {
+        if (mmdb_ipv6_prefix_maps[prefix_len]) {
+            ipv6_network(addr, prefix_len, &network);
+            mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_prefix_maps[prefix_len], network.bytes);
+            if (result) {
+                return result;
+            }
+        }
+    }
+    return NULL;
+}
+
 static bool mmdbr_pipe_valid(void) {
     g_rw_lock_reader_lock(&mmdbr_pipe_mtx);
     bool pipe_valid = ws_pipe_valid(&mmdbr_pipe);
@@ -160,6 +208,8 @@ static bool mmdbr_pipe_valid(void) {
     return pipe_valid;
 }
 
+#define MMDBR_MAX_WRITE_LEN 65536
+
 // Writing to mmdbr_pipe.stdin_fd can block. Do so in a separate thread.
 static void *
 write_mmdbr_stdin_worker(void *data _U_) {
@@ -184,19 +234,37 @@ write_mmdbr_stdin_worker(void *data _U_) {
             return NULL;
         }
 
-        ws_noisy("write %s ql %d", request, g_async_queue_length(mmdbr_request_q));
-        status = g_io_channel_write_chars(mmdbr_pipe.stdin_io, request, strlen(request), &bytes_written, &err);
+        // Send whatever else is already queued along with this request,
+        // so that a burst of lookups costs a few writes instead of one
+        // per address.
+        GString *batch = g_string_new(request);
+        bool stop = false;
+        g_free(request);
+        while (batch->len < MMDBR_MAX_WRITE_LEN && (request = (char *) g_async_queue_try_pop(mmdbr_request_q)) != NULL) {
+            if (strcmp(request, mmdbr_stop_sentinel) == 0) {
+                g_free(request);
+                stop = true;
+                break;
+            }
+            g_string_append(batch, request);
+            g_free(request);
+        }
+
+        ws_noisy("write %zu bytes ql %d", batch->len, g_async_queue_length(mmdbr_request_q));
+        status = g_io_channel_write_chars(mmdbr_pipe.stdin_io, batch->str, batch->len, &bytes_written, &err);
+        g_string_free(batch, TRUE);
         if (status != G_IO_STATUS_NORMAL) {
             ws_debug("write error %s. exiting thread.", err->message);
             g_clear_error(&err);
-            g_free(request);
             mmdb_response_t *response = g_new0(mmdb_response_t, 1);
             response->fatal_err = true;
             g_async_queue_push(mmdbr_response_q, response); // Will be freed by maxmind_db_pop_response.
             return NULL;
         }
         g_clear_error(&err);
-        g_free(request);
+        if (stop) {
+            return NULL;
+        }
     }
     return NULL;
 }
@@ -284,6 +352,7 @@ read_mmdbr_stdout_worker(void *data _U_) {
             }
             // Reset state.
             init_lookup(&response->mmdb_val);
+            response->prefix_len = 0;
             g_string_truncate(country_iso, 0);
             g_string_truncate(country, 0);
             g_string_truncate(city, 0);
@@ -323,6 +392,12 @@ read_mmdbr_stdout_worker(void *data _U_) {
             } else {
                 ws_debug("Invalid accuracy radius: %s", val_start);
             }
+        } else if (val_start && g_str_has_prefix(line, RES_PREFIX_LEN)) {
+            if (!ws_strtou32(val_start, NULL, &response->prefix_len) ||
+                    response->prefix_len > (response->is_ipv4 ? 32U : 128U)) {
+                ws_debug("Invalid prefix length: %s", val_start);
+                response->prefix_len = 0;
+            }
         } else if (g_str_has_prefix(line, RES_END)) {
             if (response->mmdb_val.found && cur_addr[0]) {
                 if (country_iso->len) {
@@ -734,8 +809,25 @@ static void maxmind_db_pop_response(mmdb_response_t *response)
 
         if (response->is_ipv4) {
             wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(response->ipv4_addr), mmdb_val);
+            if (response->prefix_len > 0 && response->prefix_len < 32) {
+                unsigned prefix_len = response->prefix_len;
+                if (!mmdb_ipv4_prefix_maps[prefix_len]) {
+                    mmdb_ipv4_prefix_maps[prefix_len] = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
+                }
+                wmem_map_insert(mmdb_ipv4_prefix_maps[prefix_len],
+                        GUINT_TO_POINTER(ipv4_network(response->ipv4_addr, prefix_len)), mmdb_val);
+            }
         } else {
             wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(&response->ipv6_addr), mmdb_val);
+            if (response->prefix_len > 0 && response->prefix_len < 128) {
+                unsigned prefix_len = response->prefix_len;
+                ws_in6_addr network;
+                if (!mmdb_ipv6_prefix_maps[prefix_len]) {
+                    mmdb_ipv6_prefix_maps[prefix_len] = wmem_map_new(wmem_epan_scope(), ipv6_oat_hash, ipv6_equal);
+                }
+                ipv6_network(&response->ipv6_addr, prefix_len, &network);
+                wmem_map_insert(mmdb_ipv6_prefix_maps[prefix_len], chunkify_v6_addr(&network), mmdb_val);
+            }
         }
     }
     g_free(response);
@@ -778,6 +870,10 @@ maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
 
     mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
 
+    if (!result && (result = lookup_ipv4_prefix(*addr)) != NULL) {
+        wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
+    }
+
     if (!result) {
         result = &mmdb_not_found;
         wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
@@ -805,6 +901,10 @@ maxmind_db_lookup_ipv6(const ws_in6_addr *addr) {
 
     mmdb_lookup_t * result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
 
+    if (!result && (result = lookup_ipv6_prefix(addr)) != NULL) {
+        wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
+    }
+
     if (!result) {
         result = &mmdb_not_found;
         wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
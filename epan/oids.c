@@ -35,7 +35,10 @@
 static bool smi_init_done;
 static bool oids_init_done;
 static bool load_smi_modules;
+static bool load_smi_modules_on_demand;
 static bool suppress_smi_errors;
+/* Set by oids_init() while loading is deferred to the first lookup. */
+static char *mibs_pending_prefix;
 #endif
 
 #include "oids.h"
@@ -757,6 +760,19 @@ static void register_mibs(const char* app_env_var_prefix) {
 
 	oids_init_done = true;
 }
+
+/*
+ * Loads the modules if oids_init() deferred that. Reading and walking a
+ * large set of MIBs is most of the cost of starting up with OID
+ * resolution enabled, and many sessions never look at an OID.
+ */
+static void load_pending_mibs(void) {
+	char *app_env_var_prefix = mibs_pending_prefix;
+
+	mibs_pending_prefix = NULL;
+	register_mibs(app_env_var_prefix);
+	g_free(app_env_var_prefix);
+}
 #endif
 
 void oid_pref_init(module_t *nameres)
@@ -778,6 +794,15 @@ void oid_pref_init(module_t *nameres)
                                   " You must restart Wireshark for this change to take effect",
                                   &load_smi_modules);
 
+    prefs_register_bool_preference(nameres, "load_smi_modules_on_demand",
+                                  "Load SMI modules on first use",
+                                  "Wait until an Object ID is first resolved before loading"
+                                  " the MIB and PIB modules, instead of loading them at startup."
+                                  " Fields from the modules cannot be used in filters"
+                                  " until then."
+                                  " You must restart Wireshark for this change to take effect",
+                                  &load_smi_modules_on_demand);
+
     prefs_register_bool_preference(nameres, "suppress_smi_errors",
                                   "Suppress SMI errors",
                                   "While loading MIB or PIB modules errors may be detected,"
@@ -848,6 +873,10 @@ void oid_pref_init(module_t *nameres)
                             "Enable OID resolution: N/A",
                             "Support for OID resolution was not compiled into this version of Wireshark");
 
+    prefs_register_static_text_preference(nameres, "load_smi_modules_on_demand_static",
+                            "Load SMI modules on first use: N/A",
+                            "Support for OID resolution was not compiled into this version of Wireshark");
+
     prefs_register_static_text_preference(nameres, "suppress_smi_errors_static",
                             "Suppress SMI errors: N/A",
                             "Support for OID resolution was not compiled into this version of Wireshark");
@@ -861,6 +890,11 @@ void oid_pref_init(module_t *nameres)
 void oids_init(const char* app_env_var_prefix _U_) {
 	prepopulate_oids();
 #ifdef HAVE_LIBSMI
+	if (load_smi_modules && load_smi_modules_on_demand && !oids_init_done) {
+		g_free(mibs_pending_prefix);
+		mibs_pending_prefix = g_strdup(app_env_var_prefix);
+		return;
+	}
 	register_mibs(app_env_var_prefix);
 #else
 	ws_info("libsmi disabled oid resolution not enabled");
@@ -869,6 +903,8 @@ void oids_init(const char* app_env_var_prefix _U_) {
 
 void oids_cleanup(void) {
 #ifdef HAVE_LIBSMI
+	g_free(mibs_pending_prefix);
+	mibs_pending_prefix = NULL;
 	unregister_mibs();
 #else
 	ws_info("libsmi disabled oid resolution not enabled");
@@ -1053,6 +1089,11 @@ oid_info_t* oid_get(unsigned len, uint32_t* subids, unsigned* matched, unsigned*
 	oid_info_t* curr_oid = &oid_root;
 	unsigned i;
 
+#ifdef HAVE_LIBSMI
+	if (G_UNLIKELY(mibs_pending_prefix != NULL))
+		load_pending_mibs();
+#endif
+
 	if(!(subids && *subids <= 2)) {
 		*matched = 0;
 		*left = len;
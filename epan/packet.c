@@ -28,11 +28,13 @@
 
 #include "addr_resolv.h"
 #include "tvbuff.h"
+#include "tvbuff-int.h"
 #include "epan_dissect.h"
 
 #include <epan/wmem_scopes.h>
 
 #include <epan/column-info.h>
+#include <epan/conversation.h>
 #include <epan/exceptions.h>
 #include <epan/reassemble.h>
 #include <epan/stream.h>
@@ -41,6 +43,7 @@
 #include <epan/range.h>
 
 #include <wsutil/str_util.h>
+#include <wsutil/time_util.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 
@@ -93,9 +96,20 @@ struct data_source {
  *
  * "protocol" is the protocol associated with the dissector table. Used
  * for determining dependencies.
+ *
+ * "dense_pages" shadows the hash table entries of FT_UINT8 and FT_UINT16
+ * tables in pages of DTBL_DENSE_PAGE_SIZE slots indexed by value, so
+ * that looking up a port or type number is two loads instead of a hash
+ * lookup. Pages are allocated when a value in them is first added; the
+ * hash table stays authoritative for iteration and Decode As.
  */
+#define DTBL_DENSE_PAGE_SHIFT	8
+#define DTBL_DENSE_PAGE_SIZE	(1U << DTBL_DENSE_PAGE_SHIFT)
+
 struct dissector_table {
 	GHashTable	*hash_table;
+	dtbl_entry_t	***dense_pages;
+	uint32_t	dense_max;
 	GSList		*dissector_handles;
 	GHashTable	*da_descriptions;
 	const char	*ui_name;
@@ -184,15 +198,35 @@ destroy_depend_dissector_list(void *data)
 
 /*
  * A heuristics dissector list.
+ *
+ * The dissectors of a heuristic list are kept sorted by their "hits"
+ * count, most frequently accepted first, so that common protocols are
+ * found after few failed probes. Counts are halved once the leader
+ * reaches HEUR_HITS_MAX so the order follows changes in the traffic mix.
  */
 struct heur_dissector_list {
 	const char	*ui_name;
 	protocol_t	*protocol;
 	GSList		*dissectors;
+	unsigned	num_dissectors;
 };
 
+#define HEUR_HITS_MAX	(1U << 16)
+
 static GHashTable *heur_dissector_lists;
 
+/*
+ * The heuristic dissector that last accepted a packet of a conversation,
+ * per heuristic list, so that further packets of the conversation try it
+ * before searching the list. Lives in file scope, like the conversations.
+ */
+typedef struct {
+	const conversation_t *conv;
+	heur_dissector_list_t list;
+} heur_conv_key_t;
+
+static wmem_map_t *heur_conv_cache;
+
 /* Name hashtables for fast detection of duplicate names */
 static GHashTable* heuristic_short_names;
 
@@ -221,6 +255,11 @@ destroy_dissector_table(void *data)
 	struct dissector_table *table = (struct dissector_table *)data;
 
 	g_hash_table_destroy(table->hash_table);
+	if (table->dense_pages) {
+		for (uint32_t i = 0; i <= (table->dense_max >> DTBL_DENSE_PAGE_SHIFT); i++)
+			g_free(table->dense_pages[i]);
+		g_free(table->dense_pages);
+	}
 	g_slist_free(table->dissector_handles);
 	if (table->da_descriptions)
 		g_hash_table_destroy(table->da_descriptions);
@@ -320,6 +359,10 @@ packet_cleanup(void)
 	g_hash_table_destroy(depend_dissector_lists);
 	g_hash_table_destroy(heur_dissector_lists);
 	g_hash_table_destroy(heuristic_short_names);
+	if (dissector_perf_stats) {
+		g_hash_table_destroy(dissector_perf_stats);
+		dissector_perf_stats = NULL;
+	}
 	g_slist_foreach(shutdown_routines, &call_routine, NULL);
 	g_slist_free(shutdown_routines);
 	if (postdissectors) {
@@ -369,6 +412,44 @@ register_shutdown_routine(void (*func)(void))
 	shutdown_routines = g_slist_prepend(shutdown_routines, (void *)func);
 }
 
+static unsigned
+heur_conv_key_hash(const void *k)
+{
+	const heur_conv_key_t *key = (const heur_conv_key_t *)k;
+
+	return g_direct_hash(key->conv) ^ g_direct_hash(key->list);
+}
+
+static gboolean
+heur_conv_key_equal(const void *a, const void *b)
+{
+	const heur_conv_key_t *key_a = (const heur_conv_key_t *)a;
+	const heur_conv_key_t *key_b = (const heur_conv_key_t *)b;
+
+	return key_a->conv == key_b->conv && key_a->list == key_b->list;
+}
+
+static void
+heur_conv_cache_init(void)
+{
+	heur_conv_cache = wmem_map_new(wmem_file_scope(), heur_conv_key_hash, heur_conv_key_equal);
+}
+
+/*
+ * The protocols that have been added to a packet's layers since the
+ * dissection state was last initialized, i.e. those that frame.protocols
+ * has listed for some packet of the file.
+ */
+static wmem_map_t *protocols_dissected;
+
+bool
+protocol_was_dissected(const int proto_id)
+{
+	if (protocols_dissected == NULL)
+		return false;
+	return wmem_map_contains(protocols_dissected, GINT_TO_POINTER(proto_id));
+}
+
 /* Initialize all data structures used for dissection. */
 void
 init_dissection(const char* app_env_var_prefix)
@@ -384,6 +465,8 @@ init_dissection(const char* app_env_var_prefix)
 
 	/* Initialize the table of conversations. */
 	epan_conversation_init();
+	heur_conv_cache_init();
+	protocols_dissected = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
 
 	/* Initialize protocol-specific variables. */
 	g_slist_foreach(init_routines, &call_routine, NULL);
@@ -407,8 +490,15 @@ cleanup_dissection(void)
 	/* Cleanup the expert infos */
 	expert_packet_cleanup();
 
+	heur_conv_cache = NULL;
+	protocols_dissected = NULL;
 	wmem_leave_file_scope();
 
+	/* Release the uncompressed data cached for this file's frames,
+	 * and the tvbuffs kept for reuse. */
+	tvb_uncompress_cache_clear();
+	tvb_cache_clear();
+
 	/*
 	 * Keep the name resolution info around until we start the next
 	 * dissection. Lua scripts may potentially do name resolution at
@@ -870,6 +960,9 @@ add_layer(packet_info *pinfo, int proto_id)
 	pinfo->curr_layer_num++;
 	wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
 
+	if (protocols_dissected != NULL)
+		wmem_map_insert(protocols_dissected, GINT_TO_POINTER(proto_id), GINT_TO_POINTER(1));
+
 	/* Increment layer number for this proto id. */
 	if (pinfo->proto_layers == NULL) {
 		pinfo->proto_layers = wmem_map_new(pinfo->pool, g_direct_hash, g_direct_equal);
@@ -914,6 +1007,279 @@ remove_last_layer(packet_info *pinfo, bool reduce_count)
 }
 
 
+/*
+ * Per-protocol dissector profiling.
+ *
+ * When enabled, each call made through a dissector handle or to a
+ * heuristic dissector is timed, and the bytes it requests from the packet
+ * and file scopes are counted, against the dissector's protocol. Time and
+ * bytes spent in subdissectors are accumulated in dissector_perf_child_* while
+ * a call is in progress, so that the caller can be charged its "self"
+ * share as well as the inclusive total.
+ */
+static bool dissector_perf_on;
+static GHashTable *dissector_perf_stats;	/* proto_id -> dissector_perf_t */
+static uint64_t dissector_perf_child_ns;
+static uint64_t dissector_perf_child_bytes;
+static uint64_t dissector_perf_child_file_bytes;
+
+typedef struct {
+	uint64_t start_ns;
+	uint64_t start_bytes;
+	uint64_t start_file_bytes;
+	uint64_t saved_child_ns;
+	uint64_t saved_child_bytes;
+	uint64_t saved_child_file_bytes;
+} dissector_perf_call_t;
+
+void
+dissector_perf_enable(bool enable)
+{
+	if (enable && dissector_perf_stats == NULL) {
+		dissector_perf_stats = g_hash_table_new_full(g_direct_hash,
+		    g_direct_equal, NULL, g_free);
+	}
+	dissector_perf_on = enable;
+}
+
+bool
+dissector_perf_enabled(void)
+{
+	return dissector_perf_on;
+}
+
+void
+dissector_perf_reset(void)
+{
+	if (dissector_perf_stats != NULL) {
+		g_hash_table_remove_all(dissector_perf_stats);
+	}
+}
+
+static int
+dissector_perf_compare(const void *a, const void *b)
+{
+	const dissector_perf_t *perf_a = *(const dissector_perf_t **)a;
+	const dissector_perf_t *perf_b = *(const dissector_perf_t **)b;
+
+	if (perf_a->self_ns != perf_b->self_ns)
+		return perf_a->self_ns < perf_b->self_ns ? 1 : -1;
+	return perf_a->proto_id - perf_b->proto_id;
+}
+
+GPtrArray *
+dissector_perf_get_stats(void)
+{
+	GPtrArray *stats = g_ptr_array_new_with_free_func(g_free);
+	GHashTableIter iter;
+	void *value;
+
+	if (dissector_perf_stats == NULL) {
+		return stats;
+	}
+
+	g_hash_table_iter_init(&iter, dissector_perf_stats);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		g_ptr_array_add(stats, g_memdup2(value, sizeof(dissector_perf_t)));
+	}
+	g_ptr_array_sort(stats, dissector_perf_compare);
+
+	return stats;
+}
+
+static void
+dissector_perf_enter(dissector_perf_call_t *call, packet_info *pinfo)
+{
+	call->saved_child_ns = dissector_perf_child_ns;
+	call->saved_child_bytes = dissector_perf_child_bytes;
+	call->saved_child_file_bytes = dissector_perf_child_file_bytes;
+	dissector_perf_child_ns = 0;
+	dissector_perf_child_bytes = 0;
+	dissector_perf_child_file_bytes = 0;
+	call->start_bytes = wmem_allocated_bytes(pinfo->pool);
+	call->start_file_bytes = wmem_allocated_bytes(wmem_file_scope());
+	call->start_ns = ws_monotonic_ns();
+}
+
+static void
+dissector_perf_leave(const dissector_perf_call_t *call, packet_info *pinfo,
+		     protocol_t *protocol, bool accepted)
+{
+	uint64_t ns = ws_monotonic_ns() - call->start_ns;
+	uint64_t bytes = wmem_allocated_bytes(pinfo->pool) - call->start_bytes;
+	uint64_t file_bytes = wmem_allocated_bytes(wmem_file_scope()) - call->start_file_bytes;
+	int proto_id = proto_get_id(protocol);
+	dissector_perf_t *perf;
+
+	perf = (dissector_perf_t *)g_hash_table_lookup(dissector_perf_stats, GINT_TO_POINTER(proto_id));
+	if (perf == NULL) {
+		perf = g_new0(dissector_perf_t, 1);
+		perf->proto_id = proto_id;
+		g_hash_table_insert(dissector_perf_stats, GINT_TO_POINTER(proto_id), perf);
+	}
+	perf->calls++;
+	if (accepted)
+		perf->accepted++;
+	perf->total_ns += ns;
+	perf->self_ns += ns - MIN(ns, dissector_perf_child_ns);
+	perf->total_bytes += bytes;
+	perf->self_bytes += bytes - MIN(bytes, dissector_perf_child_bytes);
+	perf->total_file_bytes += file_bytes;
+	perf->self_file_bytes += file_bytes - MIN(file_bytes, dissector_perf_child_file_bytes);
+
+	/* Our caller sees all of this call as time spent in a subdissector. */
+	dissector_perf_child_ns = call->saved_child_ns + ns;
+	dissector_perf_child_bytes = call->saved_child_bytes + bytes;
+	dissector_perf_child_file_bytes = call->saved_child_file_bytes + file_bytes;
+}
+
+static int
+call_dissector_func(dissector_handle_t handle, tvbuff_t *tvb,
+		    packet_info *pinfo, proto_tree *tree, void *data)
+{
+	switch (handle->dissector_type) {
+
+	case DISSECTOR_TYPE_SIMPLE:
+		return (handle->dissector_func.dissector_type_simple)(tvb, pinfo, tree, data);
+
+	case DISSECTOR_TYPE_CALLBACK:
+		return (handle->dissector_func.dissector_type_callback)(tvb, pinfo, tree, data, handle->dissector_data);
+
+	default:
+		ws_assert_not_reached();
+	}
+}
+
+/*
+ * Concurrent revisits.
+ *
+ * While epan views exist, frames that have already been dissected may be
+ * redissected from several threads at once. Only the dissectors of
+ * protocols declared with proto_set_revisit_safe() may run concurrently;
+ * calls to all others, including handles without a protocol, take a
+ * single recursive lock for their duration, so a run of unsafe
+ * dissectors within a frame takes it once per thread and never waits on
+ * itself.
+ */
+static int revisit_view_count;
+static GRecMutex revisit_mutex;
+
+void
+packet_revisit_views_add(int delta)
+{
+	g_atomic_int_add(&revisit_view_count, delta);
+}
+
+static inline bool
+revisit_needs_lock(const protocol_t *protocol)
+{
+	return G_UNLIKELY(g_atomic_int_get(&revisit_view_count) > 0) &&
+	    (protocol == NULL || !proto_is_revisit_safe(protocol));
+}
+
+static int
+call_dissector_func_profiled(dissector_handle_t handle, tvbuff_t *tvb,
+			     packet_info *pinfo, proto_tree *tree, void *data)
+{
+	dissector_perf_call_t call;
+	volatile int len = 0;
+
+	dissector_perf_enter(&call, pinfo);
+	TRY {
+		len = call_dissector_func(handle, tvb, pinfo, tree, data);
+	}
+	CATCH_ALL {
+		/* Count the call even when it throws; malformed packets are
+		 * often where the time goes. */
+		dissector_perf_leave(&call, pinfo, handle->protocol, false);
+		RETHROW;
+	}
+	ENDTRY;
+	dissector_perf_leave(&call, pinfo, handle->protocol, len != 0);
+
+	return len;
+}
+
+static int
+call_dissector_func_maybe_profiled(dissector_handle_t handle, tvbuff_t *tvb,
+				   packet_info *pinfo, proto_tree *tree, void *data)
+{
+	if (dissector_perf_on && handle->protocol != NULL) {
+		return call_dissector_func_profiled(handle, tvb, pinfo, tree, data);
+	}
+	return call_dissector_func(handle, tvb, pinfo, tree, data);
+}
+
+static int
+call_dissector_func_locked(dissector_handle_t handle, tvbuff_t *tvb,
+			   packet_info *pinfo, proto_tree *tree, void *data)
+{
+	volatile int len = 0;
+
+	g_rec_mutex_lock(&revisit_mutex);
+	TRY {
+		len = call_dissector_func_maybe_profiled(handle, tvb, pinfo, tree, data);
+	}
+	CATCH_ALL {
+		g_rec_mutex_unlock(&revisit_mutex);
+		RETHROW;
+	}
+	ENDTRY;
+	g_rec_mutex_unlock(&revisit_mutex);
+
+	return len;
+}
+
+static bool
+call_heur_func_unlocked(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			packet_info *pinfo, proto_tree *tree, void *data)
+{
+	dissector_perf_call_t call;
+	volatile bool accepted = false;
+
+	if (!dissector_perf_on || hdtbl_entry->protocol == NULL) {
+		return (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	}
+
+	dissector_perf_enter(&call, pinfo);
+	TRY {
+		accepted = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	}
+	CATCH_ALL {
+		dissector_perf_leave(&call, pinfo, hdtbl_entry->protocol, false);
+		RETHROW;
+	}
+	ENDTRY;
+	dissector_perf_leave(&call, pinfo, hdtbl_entry->protocol, accepted);
+
+	return accepted;
+}
+
+static bool
+call_heur_func(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+	       packet_info *pinfo, proto_tree *tree, void *data)
+{
+	volatile bool accepted = false;
+
+	if (!revisit_needs_lock(hdtbl_entry->protocol)) {
+		return call_heur_func_unlocked(hdtbl_entry, tvb, pinfo, tree, data);
+	}
+
+	g_rec_mutex_lock(&revisit_mutex);
+	TRY {
+		accepted = call_heur_func_unlocked(hdtbl_entry, tvb, pinfo, tree, data);
+	}
+	CATCH_ALL {
+		g_rec_mutex_unlock(&revisit_mutex);
+		RETHROW;
+	}
+	ENDTRY;
+	g_rec_mutex_unlock(&revisit_mutex);
+
+	return accepted;
+}
+
+
 /* This function will return
  *   >0  this protocol was successfully dissected and this was this protocol.
  *   0   this packet did not match this protocol.
@@ -939,18 +1305,10 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			proto_get_protocol_short_name(handle->protocol);
 	}
 
-	switch (handle->dissector_type) {
-
-	case DISSECTOR_TYPE_SIMPLE:
-		len = (handle->dissector_func.dissector_type_simple)(tvb, pinfo, tree, data);
-		break;
-
-	case DISSECTOR_TYPE_CALLBACK:
-		len = (handle->dissector_func.dissector_type_callback)(tvb, pinfo, tree, data, handle->dissector_data);
-		break;
-
-	default:
-		ws_assert_not_reached();
+	if (revisit_needs_lock(handle->protocol)) {
+		len = call_dissector_func_locked(handle, tvb, pinfo, tree, data);
+	} else {
+		len = call_dissector_func_maybe_profiled(handle, tvb, pinfo, tree, data);
 	}
 	pinfo->current_proto = saved_proto;
 	pinfo->curr_proto_layer_num = saved_proto_layer_num;
@@ -1245,10 +1603,70 @@ find_uint_dtbl_entry(dissector_table_t sub_dissectors, const uint32_t pattern)
 	/*
 	 * Find the entry.
 	 */
+	if (sub_dissectors->dense_pages != NULL && pattern <= sub_dissectors->dense_max) {
+		dtbl_entry_t **page = sub_dissectors->dense_pages[pattern >> DTBL_DENSE_PAGE_SHIFT];
+
+		return page ? page[pattern & (DTBL_DENSE_PAGE_SIZE - 1)] : NULL;
+	}
 	return (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table,
 				   GUINT_TO_POINTER(pattern));
 }
 
+/* Point the dense slot for a value, if the table has one, at an entry. */
+static void
+dense_dtbl_set(dissector_table_t sub_dissectors, const uint32_t pattern, dtbl_entry_t *dtbl_entry)
+{
+	dtbl_entry_t **page;
+
+	if (sub_dissectors->dense_pages == NULL || pattern > sub_dissectors->dense_max)
+		return;
+
+	page = sub_dissectors->dense_pages[pattern >> DTBL_DENSE_PAGE_SHIFT];
+	if (page == NULL) {
+		if (dtbl_entry == NULL)
+			return;
+		page = g_new0(dtbl_entry_t *, DTBL_DENSE_PAGE_SIZE);
+		sub_dissectors->dense_pages[pattern >> DTBL_DENSE_PAGE_SHIFT] = page;
+	}
+	page[pattern & (DTBL_DENSE_PAGE_SIZE - 1)] = dtbl_entry;
+}
+
+/* Refill the dense slots from the hash table after bulk removals. */
+static void
+dense_dtbl_rebuild(dissector_table_t sub_dissectors)
+{
+	GHashTableIter iter;
+	void *key, *value;
+
+	if (sub_dissectors->dense_pages == NULL)
+		return;
+
+	for (uint32_t i = 0; i <= (sub_dissectors->dense_max >> DTBL_DENSE_PAGE_SHIFT); i++) {
+		if (sub_dissectors->dense_pages[i])
+			memset(sub_dissectors->dense_pages[i], 0, DTBL_DENSE_PAGE_SIZE * sizeof(dtbl_entry_t *));
+	}
+	g_hash_table_iter_init(&iter, sub_dissectors->hash_table);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		dense_dtbl_set(sub_dissectors, GPOINTER_TO_UINT(key), (dtbl_entry_t *)value);
+	}
+}
+
+static void
+insert_uint_dtbl_entry(dissector_table_t sub_dissectors, const uint32_t pattern, dtbl_entry_t *dtbl_entry)
+{
+	g_hash_table_insert(sub_dissectors->hash_table,
+			     GUINT_TO_POINTER(pattern), (void *)dtbl_entry);
+	dense_dtbl_set(sub_dissectors, pattern, dtbl_entry);
+}
+
+static void
+remove_uint_dtbl_entry(dissector_table_t sub_dissectors, const uint32_t pattern)
+{
+	dense_dtbl_set(sub_dissectors, pattern, NULL);
+	g_hash_table_remove(sub_dissectors->hash_table,
+			    GUINT_TO_POINTER(pattern));
+}
+
 #if 0
 static void
 dissector_add_uint_sanity_check(const char *name, uint32_t pattern, dissector_handle_t handle, dissector_table_t sub_dissectors)
@@ -1327,8 +1745,7 @@ dissector_add_uint_real(const char *name _U_, const uint32_t pattern, dissector_
 	dtbl_entry->initial = dtbl_entry->current;
 
 	/* do the table insertion */
-	g_hash_table_insert(sub_dissectors->hash_table,
-			     GUINT_TO_POINTER(pattern), (void *)dtbl_entry);
+	insert_uint_dtbl_entry(sub_dissectors, pattern, dtbl_entry);
 }
 
 /* Add an entry to a uint dissector table. */
@@ -1534,8 +1951,7 @@ dissector_delete_uint(const char *name, const uint32_t pattern,
 		/*
 		 * Found - remove it.
 		 */
-		g_hash_table_remove(sub_dissectors->hash_table,
-				    GUINT_TO_POINTER(pattern));
+		remove_uint_dtbl_entry(sub_dissectors, pattern);
 	}
 }
 
@@ -1607,6 +2023,7 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	ws_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	dense_dtbl_rebuild(sub_dissectors);
 }
 
 static void
@@ -1618,6 +2035,7 @@ dissector_delete_from_table(void *key _U_, void *value, void *user_data)
 	dissector_handle_t handle = (dissector_handle_t) user_data;
 
 	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	dense_dtbl_rebuild(sub_dissectors);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 	if (sub_dissectors->da_descriptions)
 		g_hash_table_remove(sub_dissectors->da_descriptions, handle->description);
@@ -1651,8 +2069,7 @@ dissector_change_uint(const char *name, const uint32_t pattern, dissector_handle
 		 * to decode it, just remove the entry to save memory.
 		 */
 		if (handle == NULL && dtbl_entry->initial == NULL) {
-			g_hash_table_remove(sub_dissectors->hash_table,
-					    GUINT_TO_POINTER(pattern));
+			remove_uint_dtbl_entry(sub_dissectors, pattern);
 			return;
 		}
 		dtbl_entry->current = handle;
@@ -1672,8 +2089,7 @@ dissector_change_uint(const char *name, const uint32_t pattern, dissector_handle
 	dtbl_entry->current = handle;
 
 	/* do the table insertion */
-	g_hash_table_insert(sub_dissectors->hash_table,
-			     GUINT_TO_POINTER(pattern), (void *)dtbl_entry);
+	insert_uint_dtbl_entry(sub_dissectors, pattern, dtbl_entry);
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1700,8 +2116,7 @@ dissector_reset_uint(const char *name, const uint32_t pattern)
 	if (dtbl_entry->initial != NULL) {
 		dtbl_entry->current = dtbl_entry->initial;
 	} else {
-		g_hash_table_remove(sub_dissectors->hash_table,
-				    GUINT_TO_POINTER(pattern));
+		remove_uint_dtbl_entry(sub_dissectors, pattern);
 	}
 }
 
@@ -2771,10 +3186,16 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
 	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors->dense_pages = NULL;
+	sub_dissectors->dense_max = 0;
 	switch (type) {
 
 	case FT_UINT8:
 	case FT_UINT16:
+		sub_dissectors->dense_max = (type == FT_UINT8) ? 0xFF : 0xFFFF;
+		sub_dissectors->dense_pages = g_new0(dtbl_entry_t **,
+		    (sub_dissectors->dense_max >> DTBL_DENSE_PAGE_SHIFT) + 1);
+		/* FALL THROUGH */
 	case FT_UINT24:
 	case FT_UINT32:
 		/*
@@ -2843,6 +3264,8 @@ dissector_table_t register_custom_dissector_table(const char *name,
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
 	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors->dense_pages = NULL;
+	sub_dissectors->dense_max = 0;
 	sub_dissectors->hash_func = hash_func;
 	sub_dissectors->hash_table = g_hash_table_new_full(hash_func,
 							       key_equal_func,
@@ -3007,6 +3430,7 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
 	hdtbl_entry->enabled_by_default = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->hits = 0;
 
 	/* do the table insertion */
 	/* Ensure short_name is unique */
@@ -3017,6 +3441,7 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 
 	sub_dissectors->dissectors = g_slist_prepend(sub_dissectors->dissectors,
 	    (void *)hdtbl_entry);
+	sub_dissectors->num_dissectors++;
 
 	/* XXX - could be optimized to pass hdtbl_entry directly */
 	proto_add_heuristic_dissector(hdtbl_entry->protocol, hdtbl_entry->short_name);
@@ -3062,7 +3487,108 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 		proto_add_deregistered_slice(sizeof(heur_dtbl_entry_t), found_hdtbl_entry);
 		sub_dissectors->dissectors = g_slist_delete_link(sub_dissectors->dissectors,
 		    found_entry);
+		sub_dissectors->num_dissectors--;
+		/* Don't leave the conversations pointing at the removed entry. */
+		if (heur_conv_cache) {
+			heur_conv_cache_init();
+		}
+	}
+}
+
+/*
+ * Try one heuristic dissector of a list; returns what the dissector
+ * returned. The protocol layer added for it is removed again if it
+ * rejected the packet or put nothing in the tree.
+ */
+static bool
+try_heuristic_entry(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+		    packet_info *pinfo, proto_tree *tree, void *data,
+		    unsigned saved_layers_len, unsigned saved_tree_count)
+{
+	int                proto_id;
+	int                len;
+	bool               consumed_none;
+	unsigned           saved_desegment_len;
+
+	if (hdtbl_entry->protocol != NULL) {
+		proto_id = proto_get_id(hdtbl_entry->protocol);
+		/* do NOT change this behavior - wslua uses the protocol short name set here in order
+		   to determine which Lua-based heuristic dissector to call */
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		add_layer(pinfo, proto_id);
+	}
+
+	pinfo->heur_list_name = hdtbl_entry->list_name;
+
+	saved_desegment_len = pinfo->desegment_len;
+	len = call_heur_func(hdtbl_entry, tvb, pinfo, tree, data);
+	consumed_none = len == 0 || (pinfo->desegment_len != saved_desegment_len && pinfo->desegment_offset == 0);
+	if (hdtbl_entry->protocol != NULL &&
+		(consumed_none || (tree && saved_tree_count == tree->tree_data->count))) {
+		/*
+		 * We added a protocol layer above. The dissector
+		 * didn't consume any data or it didn't add any
+		 * items to the tree so remove it from the list.
+		 */
+		while (wmem_list_count(pinfo->layers) > saved_layers_len) {
+			/*
+			 * Only reduce the layer number if the dissector
+			 * didn't consume data. Since tree can be NULL on
+			 * the first pass, we cannot check it or it will
+			 * break dissectors that rely on a stable value.
+			 */
+			remove_last_layer(pinfo, consumed_none);
+		}
 	}
+	if (len && ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_DEBUG)) {
+		ws_debug("Frame: %d | Layers: %s | Dissector: %s\n", pinfo->num, proto_list_layers(pinfo), hdtbl_entry->short_name);
+	}
+
+	return len != 0;
+}
+
+static bool
+heur_entry_is_enabled(const heur_dtbl_entry_t *hdtbl_entry)
+{
+	return hdtbl_entry->protocol == NULL ||
+		(proto_is_protocol_enabled(hdtbl_entry->protocol) && hdtbl_entry->enabled);
+}
+
+/*
+ * Count a search hit for "entry" (whose predecessor in the list is
+ * "prev_entry") and move it ahead of the entries with fewer hits.
+ */
+static void
+heur_dissector_list_hit(heur_dissector_list_t sub_dissectors, GSList *entry, GSList *prev_entry)
+{
+	heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+	GSList            *pos, *prev_pos = NULL;
+
+	if (++hdtbl_entry->hits >= HEUR_HITS_MAX) {
+		for (pos = sub_dissectors->dissectors; pos != NULL; pos = pos->next) {
+			((heur_dtbl_entry_t *)pos->data)->hits /= 2;
+		}
+	}
+
+	for (pos = sub_dissectors->dissectors; pos != entry; prev_pos = pos, pos = pos->next) {
+		if (((heur_dtbl_entry_t *)pos->data)->hits < hdtbl_entry->hits)
+			break;
+	}
+	if (pos == entry)
+		return;
+
+	prev_entry->next = entry->next;
+	entry->next = pos;
+	if (prev_pos != NULL)
+		prev_pos->next = entry;
+	else
+		sub_dissectors->dissectors = entry;
 }
 
 bool
@@ -3074,14 +3600,12 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	int                saved_proto_layer_num;
 	const char        *saved_heur_list_name;
 	GSList            *entry;
-	GSList            *prev_entry = NULL;
+	GSList            *prev_entry;
 	uint16_t           saved_can_desegment;
 	unsigned           saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
-	int                proto_id;
-	int                len;
-	bool               consumed_none;
-	unsigned           saved_desegment_len;
+	heur_dtbl_entry_t *conv_entry = NULL;
+	heur_conv_key_t    conv_key;
 	unsigned           saved_tree_count = tree ? tree->tree_data->count : 0;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
@@ -3107,72 +3631,63 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 	DISSECTOR_ASSERT(saved_layers_len < prefs.gui_max_tree_depth);
 
-	for (entry = sub_dissectors->dissectors; entry != NULL;
-	    entry = g_slist_next(entry)) {
+	/*
+	 * If this conversation was claimed by one of the list's dissectors
+	 * before, try that one first. Looking the conversation up is only
+	 * worth it when there is a search to save. (Error packets that
+	 * carry another conversation are left alone; finding that one is
+	 * slow.)
+	 */
+	conv_key.conv = NULL;
+	conv_key.list = sub_dissectors;
+	if (heur_conv_cache != NULL && sub_dissectors->num_dissectors > 1 &&
+	    pinfo->track_ctype == 0) {
+		conv_key.conv = find_conversation_pinfo_ro(pinfo, 0);
+	}
+	if (conv_key.conv != NULL) {
+		conv_entry = (heur_dtbl_entry_t *)wmem_map_lookup(heur_conv_cache, &conv_key);
+		if (conv_entry != NULL && heur_entry_is_enabled(conv_entry) &&
+		    try_heuristic_entry(conv_entry, tvb, pinfo, tree, data,
+					saved_layers_len, saved_tree_count)) {
+			*heur_dtbl_entry = conv_entry;
+			status = true;
+		}
+	}
+
+	for (prev_entry = NULL, entry = sub_dissectors->dissectors;
+	    !status && entry != NULL;
+	    prev_entry = entry, entry = g_slist_next(entry)) {
 		/* XXX - why set this now and above? */
 		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
 
-		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==false))) {
+		if (hdtbl_entry == conv_entry || !heur_entry_is_enabled(hdtbl_entry)) {
 			/*
-			 * No - don't try this dissector.
+			 * No - don't try this dissector (again).
 			 */
 			continue;
 		}
 
-		if (hdtbl_entry->protocol != NULL) {
-			proto_id = proto_get_id(hdtbl_entry->protocol);
-			/* do NOT change this behavior - wslua uses the protocol short name set here in order
-			   to determine which Lua-based heuristic dissector to call */
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
-
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			add_layer(pinfo, proto_id);
-		}
-
-		pinfo->heur_list_name = hdtbl_entry->list_name;
+		if (try_heuristic_entry(hdtbl_entry, tvb, pinfo, tree, data,
+					saved_layers_len, saved_tree_count)) {
+			*heur_dtbl_entry = hdtbl_entry;
 
-		saved_desegment_len = pinfo->desegment_len;
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
-		consumed_none = len == 0 || (pinfo->desegment_len != saved_desegment_len && pinfo->desegment_offset == 0);
-		if (hdtbl_entry->protocol != NULL &&
-			(consumed_none || (tree && saved_tree_count == tree->tree_data->count))) {
 			/*
-			 * We added a protocol layer above. The dissector
-			 * didn't consume any data or it didn't add any
-			 * items to the tree so remove it from the list.
+			 * Only searches count towards the list order, so
+			 * it reflects the packets that still get here.
 			 */
-			while (wmem_list_count(pinfo->layers) > saved_layers_len) {
-				/*
-				 * Only reduce the layer number if the dissector
-				 * didn't consume data. Since tree can be NULL on
-				 * the first pass, we cannot check it or it will
-				 * break dissectors that rely on a stable value.
-				 */
-				remove_last_layer(pinfo, consumed_none);
-			}
-		}
-		if (len) {
-			if (ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_DEBUG)) {
-				ws_debug("Frame: %d | Layers: %s | Dissector: %s\n", pinfo->num, proto_list_layers(pinfo), hdtbl_entry->short_name);
-			}
-
-			*heur_dtbl_entry = hdtbl_entry;
-
-			/* Bubble the matched entry to the top for faster search next time. */
-			if (prev_entry != NULL) {
-				sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
-				sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
+			heur_dissector_list_hit(sub_dissectors, entry, prev_entry);
+
+			if (conv_entry != NULL) {
+				/* Replacing a value keeps the stored key. */
+				wmem_map_insert(heur_conv_cache, &conv_key, hdtbl_entry);
+			} else if (conv_key.conv != NULL) {
+				heur_conv_key_t *new_key = wmem_new(wmem_file_scope(), heur_conv_key_t);
+				*new_key = conv_key;
+				wmem_map_insert(heur_conv_cache, new_key, hdtbl_entry);
 			}
 			status = true;
-			break;
 		}
-		prev_entry = entry;
 	}
 
 	pinfo->current_proto = saved_curr_proto;
@@ -3330,6 +3845,7 @@ register_heur_dissector_list_with_description(const char *name, const char *ui_n
 	sub_dissectors->protocol  = (proto == -1) ? NULL : find_protocol_by_id(proto);
 	sub_dissectors->ui_name = ui_name;
 	sub_dissectors->dissectors = NULL;	/* initially empty */
+	sub_dissectors->num_dissectors = 0;
 	/* Make sure the registration is unique */
 	if (!g_hash_table_insert(heur_dissector_lists, (void *)name,
 			    (void *) sub_dissectors)) {
@@ -3773,7 +4289,7 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 	pinfo->heur_list_name = heur_dtbl_entry->list_name;
 
 	/* call the dissector, in case of failure call data handle (might happen with exported PDUs) */
-	if (!(*heur_dtbl_entry->dissector)(tvb, pinfo, tree, data)) {
+	if (!call_heur_func(heur_dtbl_entry, tvb, pinfo, tree, data)) {
 		/*
 		 * We added a protocol layer above. The dissector
 		 * didn't accept the packet or it didn't add any
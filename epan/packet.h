@@ -491,6 +491,7 @@ typedef struct heur_dtbl_entry {
 	char *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	bool enabled;
 	bool enabled_by_default;
+	unsigned hits;     /* recent number of packets this entry accepted when its list was searched */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
@@ -809,6 +810,13 @@ void init_dissection(const char* app_env_var_prefix);
 /* Free data structures allocated for dissection. */
 void cleanup_dissection(void);
 
+/*
+ * Returns true if the protocol has been one of the layers of any packet
+ * dissected since the dissection state was last initialized, i.e. since
+ * the current file was opened or last redissected.
+ */
+WS_DLL_PUBLIC bool protocol_was_dissected(const int proto_id);
+
 /* Allow protocols to register a "cleanup" routine to be
  * run after the initial sequential run through the packets.
  * Note that the file can still be open after this; this is not
@@ -1049,6 +1057,15 @@ WS_DLL_PUBLIC bool postdissectors_want_hfids(void);
 extern void
 prime_epan_dissect_with_postdissector_wanted_hfids(epan_dissect_t *edt);
 
+/** Count epan views in and out.
+ * While any view exists, calls to dissectors of protocols that haven't
+ * been declared revisit-safe are serialized.
+ * INTERNAL USE ONLY!!!
+ * @param delta 1 when a view is created, -1 when it is freed.
+ */
+extern void
+packet_revisit_views_add(int delta);
+
 /** Increment the dissection depth.
  * This should be used to limit recursion outside the tree depth checks in
  * call_dissector and dissector_try_heuristic.
@@ -1063,6 +1080,44 @@ WS_DLL_PUBLIC void increment_dissection_depth(packet_info *pinfo);
 
 WS_DLL_PUBLIC void decrement_dissection_depth(packet_info *pinfo);
 
+/** Per-protocol dissector profiling counters. */
+typedef struct {
+	int proto_id;          /**< Protocol the dissectors belong to */
+	uint64_t calls;        /**< Calls to the protocol's dissectors, including heuristic tries */
+	uint64_t accepted;     /**< Calls that accepted the packet */
+	uint64_t total_ns;     /**< Time spent, including subdissectors */
+	uint64_t self_ns;      /**< Time spent, excluding subdissectors */
+	uint64_t total_bytes;  /**< Packet scope bytes allocated, including subdissectors */
+	uint64_t self_bytes;   /**< Packet scope bytes allocated, excluding subdissectors */
+	uint64_t total_file_bytes; /**< File scope bytes allocated, including subdissectors */
+	uint64_t self_file_bytes;  /**< File scope bytes allocated, excluding subdissectors */
+} dissector_perf_t;
+
+/** Turn dissector profiling on or off.
+ * While profiling is on, every call through a dissector handle or to a
+ * heuristic dissector that belongs to a protocol is timed and its packet
+ * and file scope allocations are counted. File scope memory lives until
+ * the capture file is closed, so the file scope counts show which
+ * protocols the memory held for a file belongs to. Profiling is off by default; turning it
+ * off keeps the counters gathered so far.
+ * @param enable true to start profiling, false to stop.
+ */
+WS_DLL_PUBLIC void dissector_perf_enable(bool enable);
+
+/** Check whether dissector profiling is on.
+ * @return true if dissector calls are being profiled.
+ */
+WS_DLL_PUBLIC bool dissector_perf_enabled(void);
+
+/** Discard the dissector profiling counters gathered so far. */
+WS_DLL_PUBLIC void dissector_perf_reset(void);
+
+/** Get a snapshot of the dissector profiling counters.
+ * @return A GPtrArray of dissector_perf_t copies, sorted by self time,
+ * largest first. Free it with g_ptr_array_unref().
+ */
+WS_DLL_PUBLIC GPtrArray *dissector_perf_get_stats(void);
+
 /** @} */
 
 #ifdef __cplusplus
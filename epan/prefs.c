@@ -33,6 +33,7 @@
 #include <epan/strutil.h>
 #include <epan/column.h>
 #include <epan/decode_as.h>
+#include <epan/dfilter/dfilter.h>
 #include <ui/capture_opts.h>
 #include <wsutil/file_util.h>
 #include <wsutil/report_message.h>
@@ -961,6 +962,9 @@ void
 prefs_apply_all(void)
 {
     wmem_tree_foreach(prefs_modules, call_apply_cb, NULL);
+    /* What a filter means can depend on preferences, e.g. on name
+     * resolution, and on the fields they register. */
+    dfilter_cache_flush();
 }
 
 /*
@@ -972,8 +976,10 @@ prefs_apply_all(void)
 void
 prefs_apply(module_t *module)
 {
-    if (module && module->prefs_changed_flags)
+    if (module && module->prefs_changed_flags) {
         call_apply_cb(NULL, module, NULL);
+        dfilter_cache_flush();
+    }
 }
 
 static module_t *
@@ -3517,6 +3523,23 @@ prefs_register_modules(void)
                                    "Wrap to beginning/end of file during search?",
                                    &prefs.gui_find_wrap);
 
+    prefs_register_bool_preference(gui_module, "frame_index",
+                                   "Keep an index of frames next to capture files",
+                                   "After a capture file has been read in full, write an index "
+                                   "of its frames to a file next to it (with \".wsidx\" appended "
+                                   "to the name), and use it to report progress when the file "
+                                   "is opened again.",
+                                   &prefs.gui_frame_index);
+
+    prefs_register_bool_preference(gui_module, "find_index",
+                                   "Index packet bytes to speed up finding packets",
+                                   "While a capture file is read, record which byte sequences "
+                                   "each frame contains, so that finding packets by hex value "
+                                   "or string can skip frames that can't match. The index is "
+                                   "saved next to the capture file (with \".wsngram\" appended "
+                                   "to the name) and used when the file is opened again.",
+                                   &prefs.gui_find_index);
+
     prefs_register_obsolete_preference(gui_module, "use_pref_save");
 
     prefs_register_bool_preference(gui_module, "geometry.save.position",
@@ -3794,7 +3817,7 @@ prefs_register_modules(void)
 
     prefs_register_uint_preference(gui_module, "packet_list_cached_rows_max",
                                    "Maximum cached rows",
-                                   "Maximum number of rows that can be sorted by columns that require dissection. Increasing this increases memory consumption by caching column text",
+                                   "Maximum number of rows for which column text is cached. Increasing this speeds up scrolling and sorting by columns that require dissection, but increases memory consumption",
                                    10,
                                    &prefs.gui_packet_list_cached_rows_max);
 
@@ -3848,6 +3871,12 @@ prefs_register_modules(void)
         "Enables auto scroll of Plot",
         &prefs.gui_plot_enable_auto_scroll);
 
+    prefs_register_bool_preference(gui_module, "plot_opengl",
+        "Draw graphs with OpenGL",
+        "Draw the I/O, TCP stream, RTP player and other graphs with OpenGL "
+        "if it is available. Graphs are drawn in software if it isn't.",
+        &prefs.gui_plot_opengl);
+
     prefs_register_bool_preference(gui_module, "show_byteview_in_dialog",
         "Show the byte view in the packet details dialog",
         "Show the byte view in the packet details dialog",
@@ -4145,6 +4174,19 @@ prefs_register_modules(void)
             "of cache entries to maintain. A 0 means no limit.",
             10, &prefs.ignore_dup_frames_cache_entries);
 
+    prefs_register_uint_preference(protocols_module, "uncompress_cache_size",
+            "Uncompressed data cache size (MB)",
+            "The maximum amount of memory used to keep the results of uncompressing "
+            "large payloads, so that revisiting their frames does not uncompress them "
+            "again. A 0 disables the cache.",
+            10, &prefs.uncompress_cache_size);
+
+    prefs_register_uint_preference(protocols_module, "request_retention",
+            "Unanswered request retention (seconds)",
+            "How long dissectors that match requests to responses with a shared "
+            "request/response table wait for a response; a later one is not matched. "
+            "A 0 means forever.",
+            10, &prefs.request_retention);
 
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
@@ -4467,6 +4509,8 @@ prefs_set_global_defaults(wmem_allocator_t* pref_scope, const char** col_fmt, in
     prefs.gui_ask_unsaved            = true;
     prefs.gui_autocomplete_filter    = true;
     prefs.gui_find_wrap              = true;
+    prefs.gui_frame_index            = false;
+    prefs.gui_find_index             = false;
     prefs.gui_update_enabled         = true;
     prefs.gui_update_channel         = UPDATE_CHANNEL_STABLE;
     prefs.gui_update_interval        = 60*60*24; /* Seconds */
@@ -4563,6 +4607,8 @@ prefs_set_global_defaults(wmem_allocator_t* pref_scope, const char** col_fmt, in
     prefs.display_abs_time_ascii = ABS_TIME_ASCII_TREE;
     prefs.ignore_dup_frames = false;
     prefs.ignore_dup_frames_cache_entries = 10000;
+    prefs.uncompress_cache_size = 64;
+    prefs.request_retention = 0;
 
     /* set the default values for the io graph dialog */
     prefs.gui_io_graph_automatic_update = true;
@@ -4572,6 +4618,7 @@ prefs_set_global_defaults(wmem_allocator_t* pref_scope, const char** col_fmt, in
     prefs.gui_plot_automatic_update = true;
     prefs.gui_plot_enable_legend = true;
     prefs.gui_plot_enable_auto_scroll = false;
+    prefs.gui_plot_opengl = false;
 
     /* set the default values for the packet dialog */
     prefs.gui_packet_dialog_layout   = layout_vertical;
@@ -4690,9 +4737,10 @@ prefs_reset(const char* app_env_var_prefix, const char** col_fmt, int num_cols)
     prefs.saved_at_version = NULL;
 
     /*
-     * Unload all UAT preferences.
+     * Unload the UAT preferences, keeping those that would be read
+     * again from the same unmodified file.
      */
-    uat_unload_all();
+    uat_unload_changed(app_env_var_prefix);
 
     /*
      * Unload any loaded MIBs.
@@ -224,6 +224,8 @@ typedef struct _e_prefs {
   bool         gui_ask_unsaved;
   bool         gui_autocomplete_filter;
   bool         gui_find_wrap;
+  bool         gui_frame_index;
+  bool         gui_find_index;
   char        *gui_window_title;
   char        *gui_prepend_window_title;
   char        *gui_start_title;
@@ -245,6 +247,7 @@ typedef struct _e_prefs {
   bool         gui_plot_automatic_update;
   bool         gui_plot_enable_legend;
   bool         gui_plot_enable_auto_scroll;
+  bool         gui_plot_opengl;
   bool         gui_packet_details_show_byteview;
   char        *capture_device;
   char        *capture_devices_linktypes;
@@ -277,6 +280,8 @@ typedef struct _e_prefs {
   int          conversation_deinterlacing_key;
   bool         ignore_dup_frames;
   unsigned     ignore_dup_frames_cache_entries;
+  unsigned     uncompress_cache_size;
+  unsigned     request_retention;
   bool         filter_expressions_old;  /* true if old filter expressions preferences were loaded. */
   bool         cols_hide_new; /* true if the new (index-based) gui.column.hide preference was loaded. */
   bool         gui_update_enabled;
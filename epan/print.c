@@ -78,6 +78,8 @@ struct _output_fields {
     GPtrArray    *fields;
     GPtrArray    *field_dfilters;
     GHashTable   *field_indicies;
+    unsigned     *field_index_by_id;
+    unsigned      field_index_by_id_len;
     GPtrArray   **field_values;
     wmem_map_t   *protocolfilter;
     char          quote;
@@ -906,9 +908,18 @@ write_json_proto_node(GSList *node_values_head,
     // Retrieve json key from first value.
     proto_node *first_value = (proto_node *) node_values_head->data;
     const char *json_key = proto_node_to_json_key(first_value);
-    char* json_key_suffix = ws_strdup_printf("%s%s", json_key, suffix);
-    json_dumper_set_member_name(pdata->dumper, json_key_suffix);
-    g_free(json_key_suffix);
+    if (suffix[0] == '\0') {
+        json_dumper_set_member_name(pdata->dumper, json_key);
+    } else {
+        char key_buf[256];
+        wmem_strbuf_t json_key_suffix;
+
+        wmem_strbuf_init_buffer(&json_key_suffix, NULL, key_buf, sizeof(key_buf));
+        wmem_strbuf_append(&json_key_suffix, json_key);
+        wmem_strbuf_append(&json_key_suffix, suffix);
+        json_dumper_set_member_name(pdata->dumper, wmem_strbuf_get_str(&json_key_suffix));
+        wmem_strbuf_destroy(&json_key_suffix);
+    }
     write_json_proto_node_value_list(node_values_head, value_writer, pdata);
 }
 
@@ -968,13 +979,13 @@ write_json_proto_node_hex_dump(proto_node *node, write_json_data *pdata)
     /* Dump raw hex-encoded dissected information including position, length,
      * bitmask, type, and data source index. */
     /* These were added for use by json2pcap, but might be useful for others. */
-    json_dumper_value_anyf(pdata->dumper, "%" PRId32, fi->start);
-    json_dumper_value_anyf(pdata->dumper, "%" PRId32, fi->length);
-    json_dumper_value_anyf(pdata->dumper, "%" PRIu64, fi->hfinfo->bitmask);
-    json_dumper_value_anyf(pdata->dumper, "%" PRId32, (int32_t)fvalue_type_ftenum(fi->value));
+    json_dumper_value_int64(pdata->dumper, fi->start);
+    json_dumper_value_int64(pdata->dumper, fi->length);
+    json_dumper_value_uint64(pdata->dumper, fi->hfinfo->bitmask);
+    json_dumper_value_int64(pdata->dumper, (int32_t)fvalue_type_ftenum(fi->value));
 
     if (get_field_data_source(pdata->src_list, fi, &src_idx)) {
-        json_dumper_value_anyf(pdata->dumper, "%" PRIu32, src_idx);
+        json_dumper_value_uint64(pdata->dumper, src_idx);
     } else {
         json_dumper_value_anyf(pdata->dumper, "null");
     }
@@ -1197,9 +1208,12 @@ ek_fill_attr(proto_node *node, GHashTable *attr_table, write_json_data *pdata)
         ws_assert(fi);
 
         attr_instances = (GSList *) g_hash_table_lookup(attr_table, fi->hfinfo->abbrev);
-        attr_instances = g_slist_append(attr_instances, current_node);
-        // Update instance list for this attr in hash table
-        g_hash_table_insert(attr_table, g_strdup(fi->hfinfo->abbrev), attr_instances);
+        // Prepend rather than walk the list to append; the lists are
+        // put back in tree order before they are written.
+        attr_instances = g_slist_prepend(attr_instances, current_node);
+        // Update instance list for this attr in hash table. The abbrev
+        // outlives the table, so it doesn't need to be copied.
+        g_hash_table_insert(attr_table, (void *) fi->hfinfo->abbrev, attr_instances);
 
         /* Field, recurse through children*/
         if (fi->hfinfo->type != FT_PROTOCOL && current_node->first_child != NULL) {
@@ -1238,18 +1252,21 @@ ek_fill_attr(proto_node *node, GHashTable *attr_table, write_json_data *pdata)
 static void
 ek_write_name(proto_node *pnode, char* suffix, write_json_data* pdata)
 {
-    field_info *fi = PNODE_FINFO(pnode);
-    char       *str;
+    field_info   *fi = PNODE_FINFO(pnode);
+    char          name_buf[256];
+    wmem_strbuf_t name;
 
+    /* This is done for every field, so build the name on the stack. */
+    wmem_strbuf_init_buffer(&name, NULL, name_buf, sizeof(name_buf));
     if (fi->hfinfo->parent != -1) {
         header_field_info* parent = proto_registrar_get_nth(fi->hfinfo->parent);
-        str = ws_strdup_printf("%s_%s%s", parent->abbrev, fi->hfinfo->abbrev, suffix ? suffix : "");
-        json_dumper_set_member_name(pdata->dumper, str);
-    } else {
-        str = ws_strdup_printf("%s%s", fi->hfinfo->abbrev, suffix ? suffix : "");
-        json_dumper_set_member_name(pdata->dumper, str);
+        wmem_strbuf_append(&name, parent->abbrev);
+        wmem_strbuf_append_c(&name, '_');
     }
-    g_free(str);
+    wmem_strbuf_append(&name, fi->hfinfo->abbrev);
+    wmem_strbuf_append(&name, suffix);
+    json_dumper_set_member_name(pdata->dumper, wmem_strbuf_get_str(&name));
+    wmem_strbuf_destroy(&name);
 }
 
 static void
@@ -1312,7 +1329,7 @@ ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
     // Raw name
     ek_write_name(pnode, "_raw", pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_begin_array(pdata->dumper);
     }
 
@@ -1326,7 +1343,7 @@ ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
         current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_end_array(pdata->dumper);
     }
 }
@@ -1348,7 +1365,7 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
     // Print attr name
     ek_write_name(pnode, NULL, pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_begin_array(pdata->dumper);
     }
 
@@ -1403,7 +1420,7 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
         current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_end_array(pdata->dumper);
     }
 }
@@ -1420,7 +1437,7 @@ static void
 // NOLINTNEXTLINE(misc-no-recursion)
 proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
 {
-    GHashTable *attr_table  = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GHashTable *attr_table  = g_hash_table_new(g_str_hash, g_str_equal);
     GHashTableIter iter;
     void *key, *value;
     ek_fill_attr(node, attr_table, pdata);
@@ -1428,17 +1445,17 @@ proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
     // Print attributes
     g_hash_table_iter_init(&iter, attr_table);
     while (g_hash_table_iter_next (&iter, &key, &value)) {
-        process_ek_attrs(key, value, pdata);
+        GSList *attr_instances = g_slist_reverse((GSList *) value);
+
+        process_ek_attrs(key, attr_instances, pdata);
         g_hash_table_iter_remove(&iter);
-        /* We lookup a list in the table, append to it, and re-insert it; as
-         * g_slist_append() can change the start pointer of the list we can't
-         * just append to the list without replacing the old value. In turn,
-         * that means we can't set the value_destroy_func when creating
-         * the hash table, because on re-insertion that would destroy the
-         * nodes of the old list, which are still being used by the new list.
-         * So free it here.
+        /* We lookup a list in the table, prepend to it, and re-insert it; as
+         * g_slist_prepend() changes the start pointer of the list we can't
+         * set the value_destroy_func when creating the hash table, because
+         * on re-insertion that would destroy the nodes of the old list,
+         * which are still being used by the new list. So free it here.
          */
-        g_slist_free((GSList*)value);
+        g_slist_free(attr_instances);
     }
     g_hash_table_destroy(attr_table);
 }
@@ -2015,6 +2032,8 @@ void output_fields_free(output_fields_t* fields)
             g_hash_table_destroy(fields->field_indicies);
         }
 
+        g_free(fields->field_index_by_id);
+
         if (NULL != fields->field_dfilters) {
             g_ptr_array_unref(fields->field_dfilters);
         }
@@ -2416,6 +2435,39 @@ static void format_field_values(output_fields_t* fields, void *field_index, char
     g_ptr_array_add(fv_p, (void *)value);
 }
 
+/* Marks hf IDs in field_index_by_id that aren't output fields. */
+#define FIELD_INDEX_NONE UINT_MAX
+
+/*
+ * Look up the output field index (plus one) of a field, or NULL if it
+ * isn't an output field. This is done for every node of every tree, so
+ * rather than hash the abbreviation each time, remember the answer for
+ * each hf ID.
+ */
+static void *
+get_field_index(output_fields_t *fields, const header_field_info *hfinfo)
+{
+    unsigned id = (unsigned) hfinfo->id;
+    unsigned index;
+
+    if (id >= fields->field_index_by_id_len) {
+        unsigned new_len = MAX(id + 1, fields->field_index_by_id_len * 2);
+
+        fields->field_index_by_id = g_renew(unsigned, fields->field_index_by_id, new_len);
+        memset(fields->field_index_by_id + fields->field_index_by_id_len, 0,
+               (new_len - fields->field_index_by_id_len) * sizeof(unsigned));
+        fields->field_index_by_id_len = new_len;
+    }
+
+    index = fields->field_index_by_id[id];
+    if (index == 0) {
+        index = GPOINTER_TO_UINT(g_hash_table_lookup(fields->field_indicies, hfinfo->abbrev));
+        fields->field_index_by_id[id] = (index != 0) ? index : FIELD_INDEX_NONE;
+    }
+
+    return (index != FIELD_INDEX_NONE) ? GUINT_TO_POINTER(index) : NULL;
+}
+
 static void proto_tree_get_node_field_values(proto_node *node, void *data)
 {
     write_field_data_t *call_data;
@@ -2427,7 +2479,7 @@ static void proto_tree_get_node_field_values(proto_node *node, void *data)
 
     /* check for a faked item with an invisible tree */
     if (fi) {
-        field_index = g_hash_table_lookup(call_data->fields->field_indicies, fi->hfinfo->abbrev);
+        field_index = get_field_index(call_data->fields, fi->hfinfo);
         if (NULL != field_index) {
             format_field_values(call_data->fields, field_index,
                                 get_node_field_value(fi, call_data->edt) /* g_ alloc'd string */
@@ -2530,14 +2582,20 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
                 fv_p = fields->field_values[i];
 
                 /* Output the array of (partial) field values */
-                if (g_ptr_array_len(fv_p) != 0) {
-                    wmem_strbuf_t *buf = wmem_strbuf_new(NULL, g_ptr_array_index(fv_p, 0));
+                if (g_ptr_array_len(fv_p) == 1) {
+                    print_escaped_csv(fh, (char *)g_ptr_array_index(fv_p, 0), fields->separator, fields->quote, fields->escape);
+                } else if (g_ptr_array_len(fv_p) != 0) {
+                    char values_buf[256];
+                    wmem_strbuf_t buf;
+
+                    wmem_strbuf_init_buffer(&buf, NULL, values_buf, sizeof(values_buf));
+                    wmem_strbuf_append(&buf, (char *)g_ptr_array_index(fv_p, 0));
                     for (j = 1; j < g_ptr_array_len(fv_p); j++ ) {
-                        wmem_strbuf_append_c(buf, fields->aggregator);
-                        wmem_strbuf_append(buf, (char *)g_ptr_array_index(fv_p, j));
+                        wmem_strbuf_append_c(&buf, fields->aggregator);
+                        wmem_strbuf_append(&buf, (char *)g_ptr_array_index(fv_p, j));
                     }
-                    print_escaped_csv(fh, wmem_strbuf_get_str(buf), fields->separator, fields->quote, fields->escape);
-                    wmem_strbuf_destroy(buf);
+                    print_escaped_csv(fh, wmem_strbuf_get_str(&buf), fields->separator, fields->quote, fields->escape);
+                    wmem_strbuf_destroy(&buf);
                 }
                 g_ptr_array_free(fv_p, true);  /* get ready for the next packet */
                 fields->field_values[i] = NULL;
@@ -2770,6 +2828,8 @@ output_fields_t* output_fields_new(void)
     fields->fields              = NULL; /*Do lazy initialisation */
     fields->field_dfilters      = NULL;
     fields->field_indicies      = NULL;
+    fields->field_index_by_id   = NULL;
+    fields->field_index_by_id_len = 0;
     fields->field_values        = NULL;
     fields->protocolfilter      = NULL;
     fields->quote               ='\0';
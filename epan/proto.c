@@ -169,34 +169,32 @@ struct ptvcursor {
 
 /** See inlined comments.
  @param pi the created protocol item we're about to return */
+/* If the tree (GUI) or item isn't visible it's pointless for us to
+ * generate the protocol item's string representation. Protocol items
+ * stay visible in such trees (taps want their lengths) but their labels
+ * are only wanted if their field is referenced for printing. */
+#define PROTO_ITEM_REPR_IS_FAKE(pi) \
+	(!(PTREE_DATA(pi)->visible) && \
+	 (PROTO_ITEM_IS_HIDDEN(pi) || \
+	  (PITEM_FINFO(pi)->hfinfo->type == FT_PROTOCOL && \
+	   PITEM_FINFO(pi)->hfinfo->ref_type != HF_REF_TYPE_PRINT)))
+
 #define TRY_TO_FAKE_THIS_REPR(pi)	\
 	ws_assert(pi);			\
 	if (!PITEM_FINFO(pi))		\
 		return pi;		\
-	if (!(PTREE_DATA(pi)->visible) && \
-	      PROTO_ITEM_IS_HIDDEN(pi)) { \
-		/* If the tree (GUI) or item isn't visible it's pointless for \
-		 * us to generate the protocol item's string representation */ \
-		return pi; \
-	}
+	if (PROTO_ITEM_REPR_IS_FAKE(pi)) \
+		return pi;
 /* Same as above but returning void */
 #define TRY_TO_FAKE_THIS_REPR_VOID(pi)	\
 	if (!pi || !PITEM_FINFO(pi))	\
 		return;			\
-	if (!(PTREE_DATA(pi)->visible) && \
-	      PROTO_ITEM_IS_HIDDEN(pi)) { \
-		/* If the tree (GUI) or item isn't visible it's pointless for \
-		 * us to generate the protocol item's string representation */ \
-		return; \
-	}
+	if (PROTO_ITEM_REPR_IS_FAKE(pi)) \
+		return;
 /* Similar to above, but allows a NULL tree */
 #define TRY_TO_FAKE_THIS_REPR_NESTED(pi)	\
-	if ((pi == NULL) || (PITEM_FINFO(pi) == NULL) || (!(PTREE_DATA(pi)->visible) && \
-		PROTO_ITEM_IS_HIDDEN(pi))) { \
-		/* If the tree (GUI) or item isn't visible it's pointless for \
-		 * us to generate the protocol item's string representation */ \
-		return pi; \
-	}
+	if ((pi == NULL) || (PITEM_FINFO(pi) == NULL) || PROTO_ITEM_REPR_IS_FAKE(pi)) \
+		return pi;
 
 #ifdef ENABLE_CHECK_FILTER
 #define CHECK_HF_VALUE(type, spec, start_values) \
@@ -390,6 +388,7 @@ static expert_field ei_string_trailing_characters;
 static void register_string_errors(void);
 
 static int proto_register_field_init(header_field_info *hfinfo, const int parent);
+static void tmp_fld_check_assert(header_field_info *hfinfo);
 
 /* special-case header field used within proto.c */
 static header_field_info hfi_text_only =
@@ -406,6 +405,8 @@ struct _protocol {
 	bool        is_enabled;         /* true if protocol is enabled */
 	bool        enabled_by_default; /* true if protocol is enabled by default */
 	bool        can_toggle;         /* true if is_enabled can be changed */
+	bool        revisit_safe;       /* true if already dissected frames can be
+	                                   redissected concurrently */
 	int         parent_proto_id;    /* Used to identify "pino"s (Protocol In Name Only).
 	                                   For dissectors that need a protocol name so they
 	                                   can be added to a dissector table, but use the
@@ -430,27 +431,81 @@ static GPtrArray *deregistered_slice;
 /* indexed by prefix, contains initializers */
 static GHashTable* prefixes;
 
+/*
+ * The proto_nodes, field_infos and item labels of a tree come from slabs
+ * of fixed-size items that belong to the tree and are rewound, not freed,
+ * by proto_tree_reset(), so that dissecting the next frame with the same
+ * tree reuses the memory (and cache lines) of the previous one. Like the
+ * packet scope they replace, individual items are never freed.
+ */
+#define PROTO_SLAB_ITEMS 256
+
+typedef struct {
+	GPtrArray *blocks;	/* each holding PROTO_SLAB_ITEMS items */
+	unsigned   cur_block;
+	unsigned   cur_item;
+	unsigned   allocated;	/* since the last reset */
+} proto_slab_t;
+
+struct _proto_tree_slabs {
+	proto_slab_t nodes;
+	proto_slab_t field_infos;
+	proto_slab_t labels;
+};
+
+static void
+proto_slab_init(proto_slab_t *slab)
+{
+	slab->blocks = g_ptr_array_new_with_free_func(g_free);
+	slab->cur_block = 0;
+	slab->cur_item = 0;
+	slab->allocated = 0;
+}
+
+static inline void *
+proto_slab_alloc(proto_slab_t *slab, size_t item_size)
+{
+	if (slab->cur_item == PROTO_SLAB_ITEMS) {
+		slab->cur_block++;
+		slab->cur_item = 0;
+	}
+	if (slab->cur_block == slab->blocks->len) {
+		g_ptr_array_add(slab->blocks, g_malloc(item_size * PROTO_SLAB_ITEMS));
+	}
+	slab->allocated++;
+	return (uint8_t *)g_ptr_array_index(slab->blocks, slab->cur_block) + item_size * slab->cur_item++;
+}
+
+static void
+proto_slab_rewind(proto_slab_t *slab)
+{
+	slab->cur_block = 0;
+	slab->cur_item = 0;
+	slab->allocated = 0;
+}
+
 /* Contains information about a field when a dissector calls
  * proto_tree_add_item.  */
-#define FIELD_INFO_NEW(pool, fi)  fi = wmem_new(pool, field_info)
-#define FIELD_INFO_FREE(pool, fi) wmem_free(pool, fi)
+#define FIELD_INFO_NEW(tree, fi)  \
+	fi = (field_info *)proto_slab_alloc(&PTREE_DATA(tree)->slabs->field_infos, sizeof(field_info))
 
 /* Contains the space for proto_nodes. */
+#define PROTO_NODE_NEW(tree, node) \
+	node = (proto_node *)proto_slab_alloc(&PTREE_DATA(tree)->slabs->nodes, sizeof(proto_node))
+
 #define PROTO_NODE_INIT(node)			\
 	node->first_child = NULL;		\
 	node->last_child = NULL;		\
 	node->next = NULL;
 
-#define PROTO_NODE_FREE(pool, node)			\
-	wmem_free(pool, node)
-
 /* String space for protocol and field items for the GUI */
-#define ITEM_LABEL_NEW(pool, il)			\
-	il = wmem_new(pool, item_label_t);		\
+#define ITEM_LABEL_NEW(node, il)			\
+	il = (item_label_t *)proto_slab_alloc(&PTREE_DATA(node)->slabs->labels, sizeof(item_label_t)); \
 	il->value_pos = 0;				\
 	il->value_len = 0;
-#define ITEM_LABEL_FREE(pool, il)			\
-	wmem_free(pool, il);
+/* Labels are recycled along with the tree. (Not all labels come from the
+ * slab; some dissectors allocate their own out of the packet scope.) */
+#define ITEM_LABEL_FREE(node, il)
 
 #define PROTO_REGISTRAR_GET_NTH(hfindex, hfinfo)						\
 	if((hfindex == 0 || (unsigned)hfindex > gpa_hfinfo.len) && wireshark_abort_on_dissector_bug)	\
@@ -470,6 +525,121 @@ typedef struct _gpa_hfinfo_t {
 
 static gpa_hfinfo_t gpa_hfinfo;
 
+/*
+ * The field_infos of the fields a filter is interested in, collected as
+ * the tree is built. slot[hfid] is 0 for a field not seen in the tree
+ * yet, otherwise one more than the index of its array in "arrays"; only
+ * the first "used" arrays hold anything. proto_tree_reset() clears just
+ * the slots in use and empties the arrays without freeing them, so once
+ * a few frames have been dissected with a tree, collecting their fields
+ * allocates nothing.
+ */
+struct _proto_tree_interesting {
+	uint32_t	*slot;		/* indexed by hfid */
+	unsigned	num_slots;
+	GPtrArray	*arrays;	/* of GPtrArray * */
+	GArray		*hfids;		/* hfid of each array in use */
+};
+
+static inline GPtrArray *
+interesting_lookup(const struct _proto_tree_interesting *interesting, int hfid)
+{
+	uint32_t slot;
+
+	if (interesting == NULL || (unsigned)hfid >= interesting->num_slots)
+		return NULL;
+	slot = interesting->slot[hfid];
+	return slot ? (GPtrArray *)g_ptr_array_index(interesting->arrays, slot - 1) : NULL;
+}
+
+static void
+interesting_add(tree_data_t *tree_data, field_info *fi)
+{
+	struct _proto_tree_interesting *interesting = tree_data->interesting;
+	int hfid = fi->hfinfo->id;
+	GPtrArray *ptrs;
+	unsigned used;
+
+	if (interesting == NULL) {
+		/* Set up the slots now that we know they're needed. */
+		interesting = g_new(struct _proto_tree_interesting, 1);
+		interesting->num_slots = gpa_hfinfo.len;
+		interesting->slot = g_new0(uint32_t, interesting->num_slots);
+		interesting->arrays = g_ptr_array_new();
+		interesting->hfids = g_array_new(false, false, sizeof(int));
+		tree_data->interesting = interesting;
+	}
+	if ((unsigned)hfid >= interesting->num_slots) {
+		/* A field registered since, e.g. by a plugin or a UAT. */
+		unsigned num_slots = gpa_hfinfo.len;
+
+		interesting->slot = g_renew(uint32_t, interesting->slot, num_slots);
+		memset(interesting->slot + interesting->num_slots, 0,
+		    (num_slots - interesting->num_slots) * sizeof(uint32_t));
+		interesting->num_slots = num_slots;
+	}
+
+	if (interesting->slot[hfid] == 0) {
+		/* First element of this field in the tree. */
+		used = interesting->hfids->len;
+		if (used == interesting->arrays->len)
+			g_ptr_array_add(interesting->arrays, g_ptr_array_new());
+		g_array_append_val(interesting->hfids, hfid);
+		interesting->slot[hfid] = used + 1;
+	}
+	ptrs = (GPtrArray *)g_ptr_array_index(interesting->arrays, interesting->slot[hfid] - 1);
+	g_ptr_array_add(ptrs, fi);
+}
+
+/* Forget the fields collected, and the filter references to them. */
+static void
+interesting_reset(struct _proto_tree_interesting *interesting)
+{
+	for (unsigned i = 0; i < interesting->hfids->len; i++) {
+		int hfid = g_array_index(interesting->hfids, int, i);
+		header_field_info *hfinfo;
+
+		PROTO_REGISTRAR_GET_NTH(hfid, hfinfo);
+		if (hfinfo->ref_type != HF_REF_TYPE_NONE) {
+			/* when a field is referenced by a filter this also
+			   affects the refcount for the parent protocol so we need
+			   to adjust the refcount for the parent as well
+			*/
+			if (hfinfo->parent != -1) {
+				header_field_info *parent_hfinfo;
+				PROTO_REGISTRAR_GET_NTH(hfinfo->parent, parent_hfinfo);
+				parent_hfinfo->ref_type = HF_REF_TYPE_NONE;
+			}
+			hfinfo->ref_type = HF_REF_TYPE_NONE;
+		}
+
+		interesting->slot[hfid] = 0;
+		g_ptr_array_set_size((GPtrArray *)g_ptr_array_index(interesting->arrays, i), 0);
+	}
+	g_array_set_size(interesting->hfids, 0);
+}
+
+static void
+interesting_free(struct _proto_tree_interesting *interesting)
+{
+	interesting_reset(interesting);
+	for (unsigned i = 0; i < interesting->arrays->len; i++)
+		g_ptr_array_free((GPtrArray *)g_ptr_array_index(interesting->arrays, i), true);
+	g_ptr_array_free(interesting->arrays, true);
+	g_array_free(interesting->hfids, true);
+	g_free(interesting->slot);
+	g_free(interesting);
+}
+
+/* While the built-in dissectors and plugins register at startup, the
+ * field checks are done afterwards, in parallel, for the fields from
+ * fld_checks_first_id on. */
+static bool fld_checks_deferred;
+static uint32_t fld_checks_first_id;
+
+#define FLD_CHECK_MAX_THREADS	16
+#define FLD_CHECK_MIN_FIELDS	8192	/* per thread */
+
 /* Hash table of abbreviations and IDs */
 static wmem_map_t *gpa_name_map;
 static header_field_info *same_name_hfinfo;
@@ -484,6 +654,15 @@ static GHashTable *gpa_protocol_aliases;
 static char *last_field_name;
 static header_field_info *last_hfinfo;
 
+/*
+ * The registered protocols and fields, one per abbreviation, sorted
+ * case-insensitively by abbreviation so that all those starting with
+ * a prefix can be found by binary search. Built on first use, and
+ * thrown away when a field is registered or deregistered.
+ */
+static GPtrArray *sorted_hfinfo;
+static void sorted_hfinfo_invalidate(void);
+
 /* Points to the first element of an array of bits, indexed by
    a subtree item type; that array element is true if subtrees of
    an item of that type are to be expanded. */
@@ -601,6 +780,84 @@ void proto_pre_init(void)
 	deregistered_slice = g_ptr_array_new();
 }
 
+typedef struct {
+	uint32_t first;
+	uint32_t last;
+} fld_check_range_t;
+
+static void *
+check_fields_worker(void *arg)
+{
+	fld_check_range_t *range = (fld_check_range_t *)arg;
+	void *volatile error_message = NULL;
+
+	TRY {
+		for (uint32_t i = range->first; i < range->last; i++) {
+			if (gpa_hfinfo.hfi[i] != NULL)
+				tmp_fld_check_assert(gpa_hfinfo.hfi[i]);
+		}
+	}
+	CATCH(DissectorError) {
+		/* The message gets freed by ENDTRY, so we must make a copy. */
+		error_message = g_strdup(GET_MESSAGE);
+	}
+	ENDTRY;
+
+	return (void *) error_message;
+}
+
+/*
+ * Run the checks that proto_register_field_init() skipped while
+ * fld_checks_deferred was set. The checks only read the fields, so
+ * each thread takes a contiguous range of IDs; if several fields are
+ * bad, the one registered first is reported, as it would have been
+ * had the checks been done during registration.
+ */
+static void
+check_deferred_fields(void)
+{
+	fld_check_range_t ranges[FLD_CHECK_MAX_THREADS];
+	GThread *threads[FLD_CHECK_MAX_THREADS];
+	uint32_t first = fld_checks_first_id;
+	uint32_t count;
+	unsigned num_threads;
+	char *error_message = NULL;
+
+	if (!fld_checks_deferred)
+		return;
+	fld_checks_deferred = false;
+
+	count = gpa_hfinfo.len - first;
+	num_threads = MIN(g_get_num_processors(), FLD_CHECK_MAX_THREADS);
+	num_threads = MIN(num_threads, count / FLD_CHECK_MIN_FIELDS);
+
+	if (num_threads < 2) {
+		for (uint32_t i = first; i < gpa_hfinfo.len; i++) {
+			if (gpa_hfinfo.hfi[i] != NULL)
+				tmp_fld_check_assert(gpa_hfinfo.hfi[i]);
+		}
+		return;
+	}
+
+	for (unsigned t = 0; t < num_threads; t++) {
+		ranges[t].first = first + (uint32_t)((uint64_t)count * t / num_threads);
+		ranges[t].last = first + (uint32_t)((uint64_t)count * (t + 1) / num_threads);
+		threads[t] = g_thread_new("check_fields_worker", check_fields_worker, &ranges[t]);
+	}
+	for (unsigned t = 0; t < num_threads; t++) {
+		char *thread_error = (char *)g_thread_join(threads[t]);
+
+		if (error_message == NULL)
+			error_message = thread_error;
+		else
+			g_free(thread_error);
+	}
+
+	/* XXX - The message is leaked, as in register_all_protocols(). */
+	if (error_message != NULL)
+		THROW_MESSAGE(DissectorError, error_message);
+}
+
 /* initialize data structures and register protocols and fields */
 void
 proto_init(GSList *register_all_plugin_protocols_list,
@@ -633,6 +890,8 @@ proto_init(GSList *register_all_plugin_protocols_list,
 	   dissector tables, and dissectors to be called through a
 	   handle, and do whatever one-time initialization it needs to
 	   do. */
+	fld_checks_deferred = !wireshark_skip_field_checks;
+	fld_checks_first_id = gpa_hfinfo.len;
 	if (register_func != NULL)
 		register_func(cb, client_data);
 
@@ -646,6 +905,9 @@ proto_init(GSList *register_all_plugin_protocols_list,
 		(*cb)(RA_PLUGIN_REGISTER, NULL, client_data);
 	g_slist_foreach(dissector_plugins, call_plugin_register_protoinfo, NULL);
 
+	/* Check the fields registered above before any handoff uses them. */
+	check_deferred_fields();
+
 	/* Now call the "handoff registration" routines of all built-in
 	   dissectors; those routines register the dissector in other
 	   dissectors' handoff tables, and fetch any dissector handles
@@ -695,6 +957,7 @@ proto_cleanup_base(void)
 	}
 	g_free(last_field_name);
 	last_field_name = NULL;
+	sorted_hfinfo_invalidate();
 
 	while (protocols) {
 		protocol = (protocol_t *)protocols->data;
@@ -873,30 +1136,6 @@ proto_tree_children_foreach(proto_tree *tree, proto_tree_foreach_func func,
 	}
 }
 
-static void
-free_GPtrArray_value(void *key, void *value, void *user_data _U_)
-{
-	GPtrArray         *ptrs = (GPtrArray *)value;
-	int                hfid = GPOINTER_TO_UINT(key);
-	header_field_info *hfinfo;
-
-	PROTO_REGISTRAR_GET_NTH(hfid, hfinfo);
-	if (hfinfo->ref_type != HF_REF_TYPE_NONE) {
-		/* when a field is referenced by a filter this also
-		   affects the refcount for the parent protocol so we need
-		   to adjust the refcount for the parent as well
-		*/
-		if (hfinfo->parent != -1) {
-			header_field_info *parent_hfinfo;
-			PROTO_REGISTRAR_GET_NTH(hfinfo->parent, parent_hfinfo);
-			parent_hfinfo->ref_type = HF_REF_TYPE_NONE;
-		}
-		hfinfo->ref_type = HF_REF_TYPE_NONE;
-	}
-
-	g_ptr_array_free(ptrs, true);
-}
-
 static void
 proto_tree_free_node(proto_node *node, void *data _U_)
 {
@@ -918,13 +1157,8 @@ proto_tree_reset(proto_tree *tree)
 	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
 
 	/* free tree data */
-	if (tree_data->interesting_hfids) {
-		/* Free all the GPtrArray's in the interesting_hfids hash. */
-		g_hash_table_foreach(tree_data->interesting_hfids,
-			free_GPtrArray_value, NULL);
-
-		/* And then remove all values. */
-		g_hash_table_remove_all(tree_data->interesting_hfids);
+	if (tree_data->interesting) {
+		interesting_reset(tree_data->interesting);
 	}
 
 	/* Reset track of the number of children */
@@ -935,6 +1169,11 @@ proto_tree_reset(proto_tree *tree)
 	tree_data->max_start = 0;
 	tree_data->start_idle_count = 0;
 
+	/* Recycle the nodes for the next frame */
+	proto_slab_rewind(&tree_data->slabs->nodes);
+	proto_slab_rewind(&tree_data->slabs->field_infos);
+	proto_slab_rewind(&tree_data->slabs->labels);
+
 	PROTO_NODE_INIT(tree);
 }
 
@@ -947,15 +1186,15 @@ proto_tree_free(proto_tree *tree)
 	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
 
 	/* free tree data */
-	if (tree_data->interesting_hfids) {
-		/* Free all the GPtrArray's in the interesting_hfids hash. */
-		g_hash_table_foreach(tree_data->interesting_hfids,
-			free_GPtrArray_value, NULL);
-
-		/* And then destroy the hash. */
-		g_hash_table_destroy(tree_data->interesting_hfids);
+	if (tree_data->interesting) {
+		interesting_free(tree_data->interesting);
 	}
 
+	g_ptr_array_free(tree_data->slabs->nodes.blocks, true);
+	g_ptr_array_free(tree_data->slabs->field_infos.blocks, true);
+	g_ptr_array_free(tree_data->slabs->labels.blocks, true);
+	g_free(tree_data->slabs);
+
 	g_slice_free(tree_data_t, tree_data);
 
 	g_slice_free(proto_tree, tree);
@@ -982,6 +1221,13 @@ proto_tree_set_fake_protocols(proto_tree *tree, bool fake_protocols)
 		PTREE_DATA(tree)->fake_protocols = fake_protocols;
 }
 
+void
+proto_tree_set_demand_only(proto_tree *tree, bool demand_only)
+{
+	if (tree)
+		PTREE_DATA(tree)->demand_only = demand_only;
+}
+
 /* Assume dissector set only its protocol fields.
    This function is called by dissectors and allows the speeding up of filtering
    in wireshark; if this function returns false it is safe to reset tree to NULL
@@ -1172,6 +1418,100 @@ proto_registrar_get_byalias(const char *alias_name)
 	return hfinfo;
 }
 
+static void
+sorted_hfinfo_invalidate(void)
+{
+	if (sorted_hfinfo) {
+		g_ptr_array_free(sorted_hfinfo, true);
+		sorted_hfinfo = NULL;
+	}
+}
+
+static header_field_info *hfinfo_same_name_get_prev(const header_field_info *hfinfo);
+
+static void
+sorted_hfinfo_add(void *key _U_, void *value, void *user_data)
+{
+	header_field_info *hfinfo = (header_field_info *)value;
+	header_field_info *prev;
+
+	if (hfinfo->id == hf_text_only)
+		return;
+
+	/* Use the first field registered with this name, as
+	 * proto_get_first_protocol_field() callers do. */
+	while ((prev = hfinfo_same_name_get_prev(hfinfo)) != NULL)
+		hfinfo = prev;
+
+	g_ptr_array_add((GPtrArray *)user_data, hfinfo);
+}
+
+static int
+sorted_hfinfo_compare(const void *a, const void *b)
+{
+	const header_field_info *hfa = *(const header_field_info * const *)a;
+	const header_field_info *hfb = *(const header_field_info * const *)b;
+
+	return g_ascii_strcasecmp(hfa->abbrev, hfb->abbrev);
+}
+
+static GPtrArray *
+sorted_hfinfo_get(void)
+{
+	if (sorted_hfinfo == NULL) {
+		sorted_hfinfo = g_ptr_array_sized_new(wmem_map_size(gpa_name_map));
+		wmem_map_foreach(gpa_name_map, sorted_hfinfo_add, sorted_hfinfo);
+		g_ptr_array_sort(sorted_hfinfo, sorted_hfinfo_compare);
+	}
+	return sorted_hfinfo;
+}
+
+header_field_info *
+proto_registrar_get_first_byprefix(const char *prefix, void **cookie)
+{
+	GPtrArray *sorted = sorted_hfinfo_get();
+	size_t prefix_len = strlen(prefix);
+	unsigned low = 0, high = sorted->len;
+
+	/* Find the first abbreviation not less than the prefix. */
+	while (low < high) {
+		unsigned mid = low + (high - low) / 2;
+		header_field_info *hfinfo = (header_field_info *)g_ptr_array_index(sorted, mid);
+
+		if (g_ascii_strncasecmp(hfinfo->abbrev, prefix, prefix_len) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	*cookie = GUINT_TO_POINTER(low);
+	if (low >= sorted->len)
+		return NULL;
+
+	header_field_info *hfinfo = (header_field_info *)g_ptr_array_index(sorted, low);
+	if (g_ascii_strncasecmp(hfinfo->abbrev, prefix, prefix_len) != 0)
+		return NULL;
+
+	return hfinfo;
+}
+
+header_field_info *
+proto_registrar_get_next_byprefix(const char *prefix, void **cookie)
+{
+	GPtrArray *sorted = sorted_hfinfo_get();
+	unsigned i = GPOINTER_TO_UINT(*cookie) + 1;
+
+	*cookie = GUINT_TO_POINTER(i);
+	if (i >= sorted->len)
+		return NULL;
+
+	header_field_info *hfinfo = (header_field_info *)g_ptr_array_index(sorted, i);
+	if (g_ascii_strncasecmp(hfinfo->abbrev, prefix, strlen(prefix)) != 0)
+		return NULL;
+
+	return hfinfo;
+}
+
 int
 proto_registrar_get_id_byname(const char *field_name)
 {
@@ -2724,25 +3064,7 @@ tree_data_add_maybe_interesting_field(tree_data_t *tree_data, field_info *fi)
 	const header_field_info *hfinfo = fi->hfinfo;
 
 	if (hfinfo->ref_type == HF_REF_TYPE_DIRECT || hfinfo->ref_type == HF_REF_TYPE_PRINT) {
-		GPtrArray *ptrs = NULL;
-
-		if (tree_data->interesting_hfids == NULL) {
-			/* Initialize the hash because we now know that it is needed */
-			tree_data->interesting_hfids =
-				g_hash_table_new(g_direct_hash, NULL /* g_direct_equal */);
-		} else if (g_hash_table_size(tree_data->interesting_hfids)) {
-			ptrs = (GPtrArray *)g_hash_table_lookup(tree_data->interesting_hfids,
-					   GINT_TO_POINTER(hfinfo->id));
-		}
-
-		if (!ptrs) {
-			/* First element triggers the creation of pointer array */
-			ptrs = g_ptr_array_new();
-			g_hash_table_insert(tree_data->interesting_hfids,
-					    GINT_TO_POINTER(hfinfo->id), ptrs);
-		}
-
-		g_ptr_array_add(ptrs, fi);
+		interesting_add(tree_data, fi);
 	}
 }
 
@@ -6484,6 +6806,15 @@ proto_tree_add_fake_node(proto_tree *tree, const header_field_info *hfinfo)
 
 	ws_assert(tree);
 
+	/*
+	 * If "tree" is itself a fake node and the caller only wants the
+	 * primed fields, nothing can tell this item apart from its parent,
+	 * so hand back the parent and skip the allocation.
+	 */
+	if (PTREE_DATA(tree)->demand_only && PNODE_FINFO(tree) == NULL &&
+	    tree->parent != NULL)
+		return tree;
+
 	/*
 	 * Restrict our depth. proto_tree_traverse_pre_order and
 	 * proto_tree_traverse_post_order (and possibly others) are recursive
@@ -6518,7 +6849,7 @@ proto_tree_add_fake_node(proto_tree *tree, const header_field_info *hfinfo)
 		/* XXX - is it safe to continue here? */
 	}
 
-	pnode = wmem_new(PNODE_POOL(tree), proto_node);
+	PROTO_NODE_NEW(tree, pnode);
 	PROTO_NODE_INIT(pnode);
 	pnode->parent = tnode;
 	PNODE_HFINFO(pnode) = hfinfo;
@@ -6594,7 +6925,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		/* XXX - is it safe to continue here? */
 	}
 
-	pnode = wmem_new(PNODE_POOL(tree), proto_node);
+	PROTO_NODE_NEW(tree, pnode);
 	PROTO_NODE_INIT(pnode);
 	pnode->parent = tnode;
 	PNODE_HFINFO(pnode) = fi->hfinfo;
@@ -6971,7 +7302,7 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 {
 	field_info *fi;
 
-	FIELD_INFO_NEW(PNODE_POOL(tree), fi);
+	FIELD_INFO_NEW(tree, fi);
 
 	fi->hfinfo     = hfinfo;
 	fi->start      = start;
@@ -7074,7 +7405,7 @@ proto_tree_set_representation_value(proto_item *pi, const char *format, va_list
 
 		hf = fi->hfinfo;
 
-		ITEM_LABEL_NEW(PNODE_POOL(pi), fi->rep);
+		ITEM_LABEL_NEW(pi, fi->rep);
 		if (hf->bitmask && (hf->type == FT_BOOLEAN || FT_IS_UINT(hf->type))) {
 			uint64_t val;
 			char *p;
@@ -7122,7 +7453,7 @@ proto_tree_set_representation(proto_item *pi, const char *format, va_list ap)
 	DISSECTOR_ASSERT(fi);
 
 	if (!proto_item_is_hidden(pi)) {
-		ITEM_LABEL_NEW(PNODE_POOL(pi), fi->rep);
+		ITEM_LABEL_NEW(pi, fi->rep);
 
 		str = wmem_strdup_vprintf(PNODE_POOL(pi), format, ap);
 		WS_UTF_8_CHECK(str, -1);
@@ -7167,6 +7498,7 @@ hfinfo_remove_from_gpa_name_map(const header_field_info *hfinfo)
 {
 	g_free(last_field_name);
 	last_field_name = NULL;
+	sorted_hfinfo_invalidate();
 
 	if (!hfinfo->same_name_next && hfinfo->same_name_prev_id == -1) {
 		/* No hfinfo with the same name */
@@ -7886,7 +8218,7 @@ proto_item_set_text(proto_item *pi, const char *format, ...)
 		return;
 
 	if (fi->rep) {
-		ITEM_LABEL_FREE(PNODE_POOL(pi), fi->rep);
+		ITEM_LABEL_FREE(pi, fi->rep);
 		fi->rep = NULL;
 	}
 
@@ -7917,7 +8249,7 @@ proto_item_append_text(proto_item *pi, const char *format, ...)
 		 * generate the default representation.
 		 */
 		if (fi->rep == NULL) {
-			ITEM_LABEL_NEW(PNODE_POOL(pi), fi->rep);
+			ITEM_LABEL_NEW(pi, fi->rep);
 			proto_item_fill_label(fi, fi->rep->representation, &fi->rep->value_pos);
 			/* Check for special case append value to FT_NONE or FT_PROTOCOL */
 			if ((fi->hfinfo->type == FT_NONE || fi->hfinfo->type == FT_PROTOCOL) &&
@@ -7976,7 +8308,7 @@ proto_item_prepend_text(proto_item *pi, const char *format, ...)
 		 * generate the default representation.
 		 */
 		if (fi->rep == NULL) {
-			ITEM_LABEL_NEW(PNODE_POOL(pi), fi->rep);
+			ITEM_LABEL_NEW(pi, fi->rep);
 			proto_item_fill_label(fi, representation, &fi->rep->value_pos);
 		} else
 			(void) g_strlcpy(representation, fi->rep->representation, ITEM_LABEL_LENGTH);
@@ -8127,7 +8459,7 @@ proto_tree_create_root(packet_info *pinfo)
 	pnode->tree_data->pinfo = pinfo;
 
 	/* Don't initialize the tree_data_t. Wait until we know we need it */
-	pnode->tree_data->interesting_hfids = NULL;
+	pnode->tree_data->interesting = NULL;
 
 	/* Set the default to false so it's easier to
 	 * find errors; if we expect to see the protocol tree
@@ -8138,6 +8470,9 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Make sure that we fake protocols (if possible) */
 	pnode->tree_data->fake_protocols = true;
 
+	/* Build fake nodes for every unreferenced item unless told otherwise */
+	pnode->tree_data->demand_only = false;
+
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
@@ -8146,9 +8481,28 @@ proto_tree_create_root(packet_info *pinfo)
 	pnode->tree_data->max_start = 0;
 	pnode->tree_data->start_idle_count = 0;
 
+	pnode->tree_data->slabs = g_new(struct _proto_tree_slabs, 1);
+	proto_slab_init(&pnode->tree_data->slabs->nodes);
+	proto_slab_init(&pnode->tree_data->slabs->field_infos);
+	proto_slab_init(&pnode->tree_data->slabs->labels);
+
 	return (proto_tree *)pnode;
 }
 
+void
+proto_tree_get_alloc_stats(const proto_tree *tree, struct proto_tree_alloc_stats *stats)
+{
+	const struct _proto_tree_slabs *slabs = PTREE_DATA(tree)->slabs;
+
+	stats->node_count = slabs->nodes.allocated;
+	stats->field_info_count = slabs->field_infos.allocated;
+	stats->label_count = slabs->labels.allocated;
+	stats->reserved_bytes =
+		slabs->nodes.blocks->len * PROTO_SLAB_ITEMS * sizeof(proto_node) +
+		slabs->field_infos.blocks->len * PROTO_SLAB_ITEMS * sizeof(field_info) +
+		slabs->labels.blocks->len * PROTO_SLAB_ITEMS * sizeof(item_label_t);
+}
+
 
 /* "prime" a proto_tree with a single hfid that a dfilter
  * is interested in. */
@@ -8411,6 +8765,8 @@ proto_register_protocol(const char *name, const char *short_name,
 
 	check_protocol_filter_name_or_fail(filter_name);
 
+	dfilter_lock();
+
 	/*
 	 * Add this protocol to the list of known protocols;
 	 * the list is sorted by protocol short name.
@@ -8423,6 +8779,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->is_enabled = true; /* protocol is enabled by default */
 	protocol->enabled_by_default = true; /* see previous comment */
 	protocol->can_toggle = true;
+	protocol->revisit_safe = false;
 	protocol->parent_proto_id = -1;
 	protocol->heur_list = NULL;
 
@@ -8462,6 +8819,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	hfinfo->parent = -1; /* This field differentiates protos and fields */
 
 	protocol->proto_id = proto_register_field_init(hfinfo, hfinfo->parent);
+	dfilter_unlock();
 	return protocol->proto_id;
 }
 
@@ -8486,6 +8844,8 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 
 	check_protocol_filter_name_or_fail(filter_name);
 
+	dfilter_lock();
+
 	/* Add this protocol to the list of helper protocols (just so it can be properly freed) */
 	protocol = g_new(protocol_t, 1);
 	protocol->name = name;
@@ -8498,6 +8858,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 	protocol->is_enabled = true;
 	protocol->enabled_by_default = true;
 	protocol->can_toggle = true;
+	protocol->revisit_safe = false;
 
 	protocol->parent_proto_id = parent_proto;
 	protocol->heur_list = NULL;
@@ -8521,6 +8882,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 	hfinfo->parent = -1; /* This field differentiates protos and fields */
 
 	protocol->proto_id = proto_register_field_init(hfinfo, hfinfo->parent);
+	dfilter_unlock();
 	return protocol->proto_id;
 }
 
@@ -8537,6 +8899,7 @@ proto_deregister_protocol(const char *short_name)
 	if (protocol == NULL)
 		return false;
 
+	dfilter_lock();
 	g_hash_table_remove(proto_names, protocol->name);
 	g_hash_table_remove(proto_short_names, (void *)short_name);
 	g_hash_table_remove(proto_filter_names, (void *)protocol->filter_name);
@@ -8562,6 +8925,8 @@ proto_deregister_protocol(const char *short_name)
 
 	g_free(last_field_name);
 	last_field_name = NULL;
+	sorted_hfinfo_invalidate();
+	dfilter_unlock();
 
 	return true;
 }
@@ -8834,24 +9199,26 @@ proto_is_frame_protocol(const wmem_list_t *layers, const char* proto_name)
 char *
 proto_list_layers(const packet_info *pinfo)
 {
-	wmem_strbuf_t *buf;
+	char layers_buf[256];
+	wmem_strbuf_t buf;
 	wmem_list_frame_t *layers = wmem_list_head(pinfo->layers);
 
-	buf = wmem_strbuf_new_sized(pinfo->pool, 128);
+	/* Build the string on the stack, so that only the result is allocated. */
+	wmem_strbuf_init_buffer(&buf, pinfo->pool, layers_buf, sizeof(layers_buf));
 
 	/* Walk the list of layers in the packet and
 	   return a string of all entries. */
 	while (layers != NULL)
 	{
-		wmem_strbuf_append(buf, proto_get_protocol_filter_name(GPOINTER_TO_UINT(wmem_list_frame_data(layers))));
+		wmem_strbuf_append(&buf, proto_get_protocol_filter_name(GPOINTER_TO_UINT(wmem_list_frame_data(layers))));
 
 		layers = wmem_list_frame_next(layers);
 		if (layers != NULL) {
-			wmem_strbuf_append_c(buf, ':');
+			wmem_strbuf_append_c(&buf, ':');
 		}
 	}
 
-	return wmem_strbuf_finalize(buf);
+	return wmem_strbuf_steal(&buf);
 }
 
 uint8_t
@@ -8992,6 +9359,21 @@ proto_set_cant_toggle(const int proto_id)
 	protocol->can_toggle = false;
 }
 
+void
+proto_set_revisit_safe(const int proto_id)
+{
+	protocol_t *protocol;
+
+	protocol = find_protocol_by_id(proto_id);
+	protocol->revisit_safe = true;
+}
+
+bool
+proto_is_revisit_safe(const protocol_t *protocol)
+{
+	return protocol->revisit_safe;
+}
+
 static int
 proto_register_field_common(protocol_t *proto, header_field_info *hfi, const int parent)
 {
@@ -9013,6 +9395,7 @@ proto_register_field_array(const int parent, hf_register_info *hf, const int num
 
 	/* if (proto == NULL) - error or return? */
 
+	dfilter_lock();
 	if (proto->fields == NULL) {
 		/* Ironically, the NEW_PROTO_TREE_API was removed shortly before
 		 * GLib introduced g_ptr_array_new_from_array, which might have
@@ -9036,11 +9419,12 @@ proto_register_field_array(const int parent, hf_register_info *hf, const int num
 			REPORT_DISSECTOR_BUG(
 				"Duplicate field detected in call to proto_register_field_array: %s is already registered",
 				ptr->hfinfo.abbrev);
-			return;
+			break;
 		}
 
 		*ptr->p_id = proto_register_field_common(proto, &ptr->hfinfo, parent);
 	}
+	dfilter_unlock();
 }
 
 /* deregister already registered fields */
@@ -9053,6 +9437,7 @@ proto_deregister_field (const int parent, int hf_id)
 
 	g_free(last_field_name);
 	last_field_name = NULL;
+	sorted_hfinfo_invalidate();
 
 	if (hf_id == -1 || hf_id == 0)
 		return;
@@ -9062,6 +9447,7 @@ proto_deregister_field (const int parent, int hf_id)
 		return;
 	}
 
+	dfilter_lock();
 	for (i = 0; i < proto->fields->len; i++) {
 		hfi = (header_field_info *)g_ptr_array_index(proto->fields, i);
 		if (hfi->id == hf_id) {
@@ -9069,9 +9455,10 @@ proto_deregister_field (const int parent, int hf_id)
 			wmem_map_remove(gpa_name_map, hfi->abbrev);
 			g_ptr_array_remove_index_fast(proto->fields, i);
 			g_ptr_array_add(deregistered_fields, gpa_hfinfo.hfi[hf_id]);
-			return;
+			break;
 		}
 	}
+	dfilter_unlock();
 }
 
 /* Deregister all registered fields starting with a prefix. Use for dynamic registered fields only! */
@@ -9083,7 +9470,9 @@ proto_deregister_all_fields_with_prefix(const int parent, const char *prefix)
 
 	g_free(last_field_name);
 	last_field_name = NULL;
+	sorted_hfinfo_invalidate();
 
+	dfilter_lock();
 	proto = find_protocol_by_id(parent);
 	if (proto && proto->fields && proto->fields->len > 0) {
 		unsigned i = proto->fields->len;
@@ -9099,6 +9488,7 @@ proto_deregister_all_fields_with_prefix(const int parent, const char *prefix)
 			}
 		} while (i > 0);
 	}
+	dfilter_unlock();
 }
 
 void
@@ -9266,6 +9656,9 @@ free_deregistered_slice (void *data, void *user_data _U_)
 void
 proto_free_deregistered_fields (void)
 {
+	/* Cached display filters may point to the fields. */
+	dfilter_cache_flush();
+
 	expert_free_deregistered_expertinfos();
 
 	g_ptr_array_foreach(deregistered_fields, free_deregistered_field, NULL);
@@ -9357,10 +9750,11 @@ tmp_fld_check_assert(header_field_info *hfinfo)
 	if (!hfinfo->abbrev || !hfinfo->abbrev[0])
 		REPORT_DISSECTOR_BUG("Field '%s' does not have an abbreviation", hfinfo->name);
 
-	/* TODO: This check is a significant percentage of startup time (~10%),
+	/* This check is a significant percentage of startup time (~10%),
 	   although not nearly as slow as what's enabled by ENABLE_CHECK_FILTER.
-	   It might be nice to have a way to disable this check when, e.g.,
-	   running TShark many times with the same configuration. */
+	   Setting WIRESHARK_SKIP_FIELD_CHECKS disables it along with the
+	   rest of this function, e.g. when running TShark many times with
+	   the same configuration. */
 	/* Check that the filter name (abbreviation) is legal;
 	 * it must contain only alphanumerics, '-', "_", and ".". */
 	unsigned char c;
@@ -9973,7 +10367,15 @@ static int
 proto_register_field_init(header_field_info *hfinfo, const int parent)
 {
 
-	tmp_fld_check_assert(hfinfo);
+	/* A field without a name or abbreviation can't go in the name
+	 * map below, so that part of the checks is never put off. */
+	if (wireshark_skip_field_checks) {
+		/* Nothing to check. */
+	} else if (!fld_checks_deferred ||
+		   !hfinfo->name || !hfinfo->name[0] ||
+		   !hfinfo->abbrev || !hfinfo->abbrev[0]) {
+		tmp_fld_check_assert(hfinfo);
+	}
 
 	hfinfo->parent         = parent;
 	hfinfo->same_name_next = NULL;
@@ -10016,6 +10418,7 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 		/* wmem_map_insert - if key is already present the previous
 		 * hfinfo with the same key/name is returned, otherwise NULL */
 		same_name_hfinfo = wmem_map_insert(gpa_name_map, (void *) (hfinfo->abbrev), hfinfo);
+		sorted_hfinfo_invalidate();
 		if (same_name_hfinfo) {
 			/* There's already a field with this name.
 			 * Put the current field *before* that field
@@ -11624,24 +12027,20 @@ proto_get_finfo_ptr_array(const proto_tree *tree, const int id)
 	if (!tree)
 		return NULL;
 
-	if (PTREE_DATA(tree)->interesting_hfids != NULL)
-		return (GPtrArray *)g_hash_table_lookup(PTREE_DATA(tree)->interesting_hfids,
-					   GINT_TO_POINTER(id));
-	else
-		return NULL;
+	return interesting_lookup(PTREE_DATA(tree)->interesting, id);
 }
 
 bool
 proto_tracking_interesting_fields(const proto_tree *tree)
 {
-	GHashTable *interesting_hfids;
+	const struct _proto_tree_interesting *interesting;
 
 	if (!tree)
 		return false;
 
-	interesting_hfids = PTREE_DATA(tree)->interesting_hfids;
+	interesting = PTREE_DATA(tree)->interesting;
 
-	return (interesting_hfids != NULL) && g_hash_table_size(interesting_hfids);
+	return (interesting != NULL) && interesting->hfids->len > 0;
 }
 
 /* Helper struct for proto_find_info() and	proto_all_finfos() */
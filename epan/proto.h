@@ -893,14 +893,16 @@ typedef struct
 /** One of these exists for the entire protocol tree. Each proto_node
  * in the protocol tree points to the same copy. */
 typedef struct {
-    GHashTable          *interesting_hfids;
+    struct _proto_tree_interesting *interesting;
     bool                 visible;
     bool                 fake_protocols;
+    bool                 demand_only;
     unsigned             count;
     struct _packet_info *pinfo;
     tvbuff_t            *idle_count_ds_tvb;
     unsigned             max_start;
     unsigned             start_idle_count;
+    struct _proto_tree_slabs *slabs;
 } tree_data_t;
 
 /** Each proto_tree, proto_item is one of these. */
@@ -1248,6 +1250,19 @@ void proto_tree_reset(proto_tree *tree);
  @param tree the tree to free */
 WS_DLL_PUBLIC void proto_tree_free(proto_tree *tree);
 
+struct proto_tree_alloc_stats {
+    unsigned node_count;        /**< proto_nodes allocated since the last reset */
+    unsigned field_info_count;  /**< field_infos allocated since the last reset */
+    unsigned label_count;       /**< item labels allocated since the last reset */
+    size_t   reserved_bytes;    /**< memory held for recycling between frames */
+};
+
+/** Get the proto_node, field_info and label allocation counts of the frame
+ * being dissected into a tree.
+ @param tree the tree root
+ @param stats structure to fill in */
+WS_DLL_PUBLIC void proto_tree_get_alloc_stats(const proto_tree *tree, struct proto_tree_alloc_stats *stats);
+
 /** Set the tree visible or invisible.
  Is the parsing being done for a visible proto_tree or an invisible one?
  By setting this correctly, the proto_tree creation is sped up by not
@@ -1264,6 +1279,16 @@ proto_tree_set_visible(proto_tree *tree, bool visible);
 extern void
 proto_tree_set_fake_protocols(proto_tree *tree, bool fake_protocols);
 
+/** Indicate whether only the primed fields are demanded (default = false).
+ * When set and the tree isn't visible, an unreferenced item added below
+ * an already faked item reuses that fake node rather than getting one of
+ * its own, so whole unreferenced subtrees cost no allocations. Only set
+ * this when nothing walks the faked parts of the tree.
+ @param tree the tree to be set
+ @param demand_only true if only the primed fields are needed */
+extern void
+proto_tree_set_demand_only(proto_tree *tree, bool demand_only);
+
 /** Mark a field/protocol ID as "interesting".
  * That means that we don't fake the item (because we are filtering on it),
  * and we mark its parent protocol (if any) as being indirectly referenced
@@ -2776,6 +2801,21 @@ WS_DLL_PUBLIC header_field_info* proto_registrar_get_byname(const char *field_na
  @return the registered item */
 WS_DLL_PUBLIC header_field_info* proto_registrar_get_byalias(const char *alias_name);
 
+/** Get the first protocol or field whose abbreviation starts with a
+ prefix, compared case-insensitively. Matches come in sorted order,
+ once per abbreviation; registering or deregistering fields ends an
+ iteration in progress.
+ @param prefix the abbreviation prefix to search for
+ @param[out] cookie state to pass to proto_registrar_get_next_byprefix()
+ @return the first matching item, or NULL if there is none */
+WS_DLL_PUBLIC header_field_info* proto_registrar_get_first_byprefix(const char *prefix, void **cookie);
+
+/** Get the next protocol or field whose abbreviation starts with a prefix.
+ @param prefix the prefix passed to proto_registrar_get_first_byprefix()
+ @param[in,out] cookie state from the previous call
+ @return the next matching item, or NULL if there are no more */
+WS_DLL_PUBLIC header_field_info* proto_registrar_get_next_byprefix(const char *prefix, void **cookie);
+
 /** Get the header_field id based upon a field name.
  @param field_name the field name to search for
  @return the field id for the registered item */
@@ -2956,6 +2996,19 @@ WS_DLL_PUBLIC void proto_reenable_all(void);
  @param proto_id protocol id (0-indexed) */
 WS_DLL_PUBLIC void proto_set_cant_toggle(const int proto_id);
 
+/** Declare that a protocol's dissectors can redissect frames concurrently.
+ * Such dissectors, when called for a frame that has already been
+ * dissected, only read the state built up on earlier passes, allocate
+ * nothing in file scope and keep no static state of their own, so that
+ * epan views (see epan_view_new()) can run them from several threads at
+ * once. The dissectors of other protocols are run one at a time.
+ * @param proto_id protocol id (0-indexed) */
+WS_DLL_PUBLIC void proto_set_revisit_safe(const int proto_id);
+
+/** Can the protocol's dissectors redissect frames concurrently?
+ @return true if proto_set_revisit_safe() was called for it */
+WS_DLL_PUBLIC bool proto_is_revisit_safe(const protocol_t *protocol);
+
 /** Checks for existence any protocol or field within a tree.
  @param tree "Protocols" are assumed to be a child of the [empty] root node.
  @param id hfindex of protocol or field
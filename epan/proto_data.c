@@ -10,6 +10,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/wmem_scopes.h>
@@ -26,18 +28,27 @@ typedef struct _proto_data {
   void *proto_data;
 } proto_data_t;
 
+/* The protocol data of a frame or packet, kept in one block sorted by
+   protocol index and key, so that a lookup is a binary search over
+   contiguous memory rather than a walk over a list node per entry.
+   Entries with the same protocol index and key are ordered newest first. */
+struct _proto_data_vec {
+  unsigned count;
+  unsigned capacity;
+  proto_data_t entries[];
+};
+
+#define PROTO_DATA_VEC_INITIAL_CAPACITY 4
+
 static int
-p_compare(const void *a, const void *b)
+p_compare(const proto_data_t *ap, int proto, uint32_t key)
 {
-  const proto_data_t *ap = (const proto_data_t *)a;
-  const proto_data_t *bp = (const proto_data_t *)b;
-
-  if (ap -> proto > bp -> proto) {
+  if (ap->proto > proto) {
     return 1;
-  } else if (ap -> proto == bp -> proto) {
-    if (ap->key > bp->key){
+  } else if (ap->proto == proto) {
+    if (ap->key > key) {
       return 1;
-    } else if (ap -> key == bp -> key) {
+    } else if (ap->key == key) {
       return 0;
     }
     return -1;
@@ -46,53 +57,112 @@ p_compare(const void *a, const void *b)
   }
 }
 
+static proto_data_vec_t **
+p_get_vec(wmem_allocator_t *scope, struct _packet_info* pinfo)
+{
+  if (scope == pinfo->pool) {
+    return &pinfo->proto_data;
+  } else if (scope == wmem_file_scope()) {
+    return &pinfo->fd->pfd;
+  }
+  DISSECTOR_ASSERT(!"invalid wmem scope");
+  return NULL;
+}
+
+/* Index of the first entry that doesn't sort before proto and key,
+   i.e. of the newest matching entry if there is one. */
+static unsigned
+p_lower_bound(const proto_data_vec_t *vec, int proto, uint32_t key)
+{
+  unsigned low = 0;
+  unsigned high = vec ? vec->count : 0;
+
+  while (low < high) {
+    unsigned mid = low + (high - low) / 2;
+    if (p_compare(&vec->entries[mid], proto, key) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+static proto_data_t *
+p_find(const proto_data_vec_t *vec, int proto, uint32_t key)
+{
+  unsigned idx = p_lower_bound(vec, proto, key);
+
+  if (vec && idx < vec->count && p_compare(&vec->entries[idx], proto, key) == 0) {
+    return (proto_data_t *)&vec->entries[idx];
+  }
+  return NULL;
+}
+
 void
 p_add_proto_data(wmem_allocator_t *tmp_scope, struct _packet_info* pinfo, int proto, uint32_t key, void *proto_data)
 {
-  proto_data_t     *p1;
-  GSList          **proto_list;
-  wmem_allocator_t *scope;
+  proto_data_vec_t **vecp;
+  proto_data_vec_t  *vec;
+  proto_data_t      *p1;
+  wmem_allocator_t  *scope;
+  unsigned           idx;
 
   if (tmp_scope == pinfo->pool) {
     scope = tmp_scope;
-    proto_list = &pinfo->proto_data;
   } else if (tmp_scope == wmem_file_scope()) {
     scope = wmem_file_scope();
-    proto_list = &pinfo->fd->pfd;
   } else {
     DISSECTOR_ASSERT(!"invalid wmem scope");
   }
+  vecp = p_get_vec(scope, pinfo);
+  vec = *vecp;
+
+  if (vec == NULL || vec->count == vec->capacity) {
+    unsigned capacity = vec ? vec->capacity * 2 : PROTO_DATA_VEC_INITIAL_CAPACITY;
+    proto_data_vec_t *new_vec;
+
+    if (scope == pinfo->pool) {
+      /* Some dissectors save and restore a copy of the whole packet_info
+         around calls to subdissectors, so leave the old block alone for
+         the copy to point at; the pool is freed with the packet anyway. */
+      new_vec = (proto_data_vec_t *)wmem_alloc(scope,
+          sizeof(proto_data_vec_t) + capacity * sizeof(proto_data_t));
+      new_vec->count = 0;
+      if (vec) {
+        memcpy(new_vec->entries, vec->entries, vec->count * sizeof(proto_data_t));
+        new_vec->count = vec->count;
+      }
+    } else {
+      new_vec = (proto_data_vec_t *)wmem_realloc(scope, vec,
+          sizeof(proto_data_vec_t) + capacity * sizeof(proto_data_t));
+      if (vec == NULL) {
+        new_vec->count = 0;
+      }
+    }
+    new_vec->capacity = capacity;
+    vec = new_vec;
+    *vecp = vec;
+  }
 
-  p1 = wmem_new(scope, proto_data_t);
-
+  /* Most lookups are for data that a dissector added earlier the same
+     way, so inserting before any older entries with the same protocol
+     index and key makes the newest one the one that's found. */
+  idx = p_lower_bound(vec, proto, key);
+  memmove(&vec->entries[idx + 1], &vec->entries[idx], (vec->count - idx) * sizeof(proto_data_t));
+  p1 = &vec->entries[idx];
   p1->proto = proto;
   p1->key = key;
   p1->proto_data = proto_data;
-
-  /* Add it to the GSLIST */
-  *proto_list = g_slist_prepend(*proto_list, p1);
+  vec->count++;
 }
 
 void
 p_set_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, uint32_t key, void *proto_data)
 {
-  proto_data_t  temp;
-  GSList       *item;
-
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
-
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  proto_data_t *pd = p_find(*p_get_vec(scope, pinfo), proto, key);
 
-  if (item) {
-    proto_data_t *pd = (proto_data_t *)item->data;
+  if (pd) {
     pd->proto_data = proto_data;
     return;
   }
@@ -103,23 +173,9 @@ p_set_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto,
 void *
 p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, uint32_t key)
 {
-  proto_data_t  temp, *p1;
-  GSList       *item;
-
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
+  proto_data_t *p1 = p_find(*p_get_vec(scope, pinfo), proto, key);
 
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
-
-  if (item) {
-    p1 = (proto_data_t *)item->data;
+  if (p1) {
     return p1->proto_data;
   }
 
@@ -129,40 +185,31 @@ p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto,
 void
 p_remove_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, uint32_t key)
 {
-  proto_data_t  temp;
-  GSList       *item;
-  GSList      **proto_list;
-
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
-
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-    proto_list = &pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-    proto_list = &pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  proto_data_vec_t *vec = *p_get_vec(scope, pinfo);
+  proto_data_t     *item = p_find(vec, proto, key);
 
   if (item) {
-    *proto_list = g_slist_remove(*proto_list, item->data);
+    unsigned idx = (unsigned)(item - vec->entries);
+    memmove(item, item + 1, (vec->count - idx - 1) * sizeof(proto_data_t));
+    vec->count--;
   }
 }
 
+unsigned
+p_get_proto_data_count(wmem_allocator_t *scope, struct _packet_info* pinfo)
+{
+  proto_data_vec_t *vec = *p_get_vec(scope, pinfo);
+
+  return vec ? vec->count : 0;
+}
+
 char *
 p_get_proto_name_and_key(wmem_allocator_t *scope, struct _packet_info* pinfo, unsigned pfd_index){
-  proto_data_t  *temp;
+  proto_data_vec_t *vec = *p_get_vec(scope, pinfo);
+  proto_data_t     *temp;
 
-  if (scope == pinfo->pool) {
-    temp = (proto_data_t *)g_slist_nth_data(pinfo->proto_data, pfd_index);
-  } else if (scope == wmem_file_scope()) {
-    temp = (proto_data_t *)g_slist_nth_data(pinfo->fd->pfd, pfd_index);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  DISSECTOR_ASSERT(vec && pfd_index < vec->count);
+  temp = &vec->entries[pfd_index];
 
   return wmem_strdup_printf(pinfo->pool, "[%s, key %u]",proto_get_protocol_name(temp->proto), temp->key);
 }
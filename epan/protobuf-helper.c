@@ -45,6 +45,12 @@ pbw_load_proto_file(PbwDescriptorPool* pool, const char* filename) {
     }
 }
 
+/* add a proto file to be loaded when a name in its package is first looked up, return 0 if succeeds */
+int
+pbw_add_proto_file_on_demand(PbwDescriptorPool* pool, const char* filename) {
+    return pbl_add_proto_file_on_demand((pbl_descriptor_pool_t*) pool, filename) ? 0 : 2;
+}
+
 /* like DescriptorPool::FindMethodByName */
 const PbwMethodDescriptor*
 pbw_DescriptorPool_FindMethodByName(const PbwDescriptorPool* pool, const char* name) {
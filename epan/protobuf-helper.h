@@ -85,6 +85,10 @@ pbw_reinit_DescriptorPool(PbwDescriptorPool** pool, const char** directories, pb
 int
 pbw_load_proto_file(PbwDescriptorPool* pool, const char* filename);
 
+/* add a proto file to be loaded when a name in its package is first looked up, return 0 if success */
+int
+pbw_add_proto_file_on_demand(PbwDescriptorPool* pool, const char* filename);
+
 /* like DescriptorPool::FindMethodByName */
 const PbwMethodDescriptor*
 pbw_DescriptorPool_FindMethodByName(const PbwDescriptorPool* pool, const char* name);
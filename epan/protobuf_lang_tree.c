@@ -120,6 +120,7 @@ pbl_reinit_descriptor_pool(pbl_descriptor_pool_t** ppool, const char** directori
     p->packages = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, pbl_free_node);
     p->proto_files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
     p->proto_files_to_be_parsed = g_queue_new();
+    p->files_by_package = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
 
     *ppool = p;
 }
@@ -134,6 +135,7 @@ pbl_free_pool(pbl_descriptor_pool_t* pool)
     g_hash_table_destroy(pool->packages);
     g_queue_free(pool->proto_files_to_be_parsed); /* elements will be removed in p->proto_files */
     g_hash_table_destroy(pool->proto_files);
+    g_hash_table_destroy(pool->files_by_package);
 
     g_free(pool);
 }
@@ -180,9 +182,11 @@ pbl_canonicalize_absolute_filepath(const char* path)
     }
 }
 
-/* Add a file into to do list */
-bool
-pbl_add_proto_file_to_be_parsed(pbl_descriptor_pool_t* pool, const char* filepath)
+/* Get the canonical absolute path of a file given as absolute or relative to one of the source directories.
+ * Return a newly-allocated path, NULL if the file is not found.
+ */
+static char*
+pbl_resolve_proto_file_path(const pbl_descriptor_pool_t* pool, const char* filepath)
 {
     char* path = NULL;
     GList* it = NULL;
@@ -203,6 +207,15 @@ pbl_add_proto_file_to_be_parsed(pbl_descriptor_pool_t* pool, const char* filepat
         }
     }
 
+    return path;
+}
+
+/* Add a file into to do list */
+bool
+pbl_add_proto_file_to_be_parsed(pbl_descriptor_pool_t* pool, const char* filepath)
+{
+    char* path = pbl_resolve_proto_file_path(pool, filepath);
+
     if (path == NULL) {
         if (pool->parser_state) {
             /* only happened during parsing an 'import' line of a .proto file */
@@ -233,6 +246,128 @@ pbl_add_proto_file_to_be_parsed(pbl_descriptor_pool_t* pool, const char* filepat
     return true;
 }
 
+static bool
+pbl_is_ident_char(char c)
+{
+    return g_ascii_isalnum(c) || c == '_';
+}
+
+/* Find the name in the top level 'package' statement of the proto file contents, without parsing the file.
+ * Return a newly-allocated name, the default package name if there isn't one.
+ */
+static char*
+pbl_scan_package_name(const char* p)
+{
+    int depth = 0;
+    bool statement_start = true;
+    const char* name;
+
+    while (*p) {
+        if (g_ascii_isspace(*p)) {
+            p++;
+        } else if (p[0] == '/' && p[1] == '/') {
+            while (*p && *p != '\n') p++;
+        } else if (p[0] == '/' && p[1] == '*') {
+            p = strstr(p + 2, "*/");
+            if (p == NULL) break;
+            p += 2;
+        } else if (*p == '"' || *p == '\'') {
+            char quote = *p++;
+            while (*p && *p != quote) {
+                if (*p == '\\' && p[1]) p++;
+                p++;
+            }
+            if (*p) p++;
+            statement_start = false;
+        } else if (*p == ';' || *p == '{' || *p == '}') {
+            if (*p == '{') depth++;
+            else if (*p == '}' && depth > 0) depth--;
+            p++;
+            statement_start = true;
+        } else if (pbl_is_ident_char(*p)) {
+            name = p;
+            while (pbl_is_ident_char(*p)) p++;
+            if (statement_start && depth == 0 && p - name == 7 && strncmp(name, "package", 7) == 0) {
+                while (g_ascii_isspace(*p)) p++;
+                name = p;
+                while (pbl_is_ident_char(*p) || *p == '.') p++;
+                return g_strndup(name, p - name);
+            }
+            statement_start = false;
+        } else {
+            p++;
+            statement_start = false;
+        }
+    }
+
+    return g_strdup(PBL_DEFAULT_PACKAGE_NAME);
+}
+
+/* Add a file to be parsed when its package is looked up */
+bool
+pbl_add_proto_file_on_demand(pbl_descriptor_pool_t* pool, const char* filepath)
+{
+    char* path = pbl_resolve_proto_file_path(pool, filepath);
+    char* contents;
+    char* package_name;
+    GPtrArray* files;
+
+    if (path == NULL) {
+        pool->error_cb("Protobuf: file [%s] does not exist!\n", filepath);
+        return false;
+    }
+
+    if (g_hash_table_lookup(pool->proto_files, path)) {
+        /* The file is already in the proto_files */
+        g_free(path);
+        return true;
+    }
+
+    if (!g_file_get_contents(path, &contents, NULL, NULL)) {
+        pool->error_cb("Protobuf: file [%s] can not be read!\n", path);
+        g_free(path);
+        return false;
+    }
+    package_name = pbl_scan_package_name(contents);
+    g_free(contents);
+
+    files = (GPtrArray*) g_hash_table_lookup(pool->files_by_package, package_name);
+    if (files) {
+        g_free(package_name);
+    } else {
+        files = g_ptr_array_new_with_free_func(g_free);
+        g_hash_table_insert(pool->files_by_package, package_name, files);
+    }
+    g_ptr_array_add(files, path);
+    return true;
+}
+
+/* Parse the files waiting for the package to be looked up */
+static void
+pbl_load_package_on_demand(pbl_descriptor_pool_t* pool, const char* package_name)
+{
+    void* key;
+    void* value;
+    GPtrArray* files;
+    unsigned i;
+
+    if (!g_hash_table_steal_extended(pool->files_by_package, package_name, &key, &value)) {
+        return;
+    }
+
+    files = (GPtrArray*) value;
+    for (i = 0; i < files->len; i++) {
+        pbl_add_proto_file_to_be_parsed(pool, (const char*) g_ptr_array_index(files, i));
+    }
+    g_free(key);
+    g_ptr_array_unref(files);
+
+    /* If this lookup happens while parsing, the files will be parsed after the current one. */
+    if (pool->parser_state == NULL) {
+        run_pbl_parser(pool);
+    }
+}
+
 /* find node according to full_name */
 static pbl_node_t*
 pbl_find_node_in_pool(const pbl_descriptor_pool_t* pool, const char* full_name, pbl_node_type_t nodetype)
@@ -260,12 +395,15 @@ pbl_find_node_in_pool(const pbl_descriptor_pool_t* pool, const char* full_name,
             if (i == 0) {
                 /* no dot any more, we search in default package */
                 names = g_slist_prepend(names, full_name_buf);
+                /* the pool is only changed by adding the definitions of files not parsed yet */
+                pbl_load_package_on_demand((pbl_descriptor_pool_t*) pool, PBL_DEFAULT_PACKAGE_NAME);
                 package = (pbl_node_t*) g_hash_table_lookup(pool->packages, PBL_DEFAULT_PACKAGE_NAME);
             } else { /* replace middle dot with '\0' */
                 /* push name at top of names */
                 names = g_slist_prepend(names, full_name_buf + i + 1);
                 full_name_buf[i] = 0;
                 /* take 0~i of full_name_buf as package name */
+                pbl_load_package_on_demand((pbl_descriptor_pool_t*) pool, full_name_buf);
                 package = (pbl_node_t*) g_hash_table_lookup(pool->packages, full_name_buf);
             }
             if (package) {
@@ -49,6 +49,7 @@ typedef struct {
     GHashTable* packages; /* all packages parsed from proto files */
     GHashTable* proto_files; /* all proto files that are parsed or to be parsed */
     GQueue* proto_files_to_be_parsed; /* files is to be parsed */
+    GHashTable* files_by_package; /* package name -> GPtrArray of files to be parsed when the package is looked up */
     struct _protobuf_lang_state_t *parser_state; /* current parser state */
 } pbl_descriptor_pool_t;
 
@@ -209,6 +210,11 @@ pbl_free_pool(pbl_descriptor_pool_t* pool);
 bool
 pbl_add_proto_file_to_be_parsed(pbl_descriptor_pool_t* pool, const char* filepath);
 
+/* add a proto file to pool without parsing it. Only its package name is read. The file will be parsed the
+   first time a name in that package is looked up. */
+bool
+pbl_add_proto_file_on_demand(pbl_descriptor_pool_t* pool, const char* filepath);
+
 /* run C protocol buffers language parser, return 0 if success */
 int run_pbl_parser(pbl_descriptor_pool_t* pool);
 
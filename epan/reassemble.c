@@ -17,8 +17,11 @@
 #include <epan/reassemble.h>
 #include <epan/tvbuff-int.h>
 
+#include <wsutil/file_util.h>
 #include <wsutil/str_util.h>
+#include <wsutil/tempfile.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/ws_trace.h>
 
 /*
  * Functions for reassembly tables where the endpoint addresses, and a
@@ -316,6 +319,311 @@ reassembled_key_free(void *ptr)
 	g_slice_free(reassembled_key, (reassembled_key *)ptr);
 }
 
+/*
+ * Once linking a fragment has to walk this many others, index the list
+ * by offset.
+ */
+#define FRAG_INDEX_MIN_WALK 32
+
+/*
+ * Drops the offset index of the fragments, if any. Call it whenever
+ * fragments are removed from or moved within the list.
+ */
+static void
+fragment_index_drop(fragment_head *fd_head)
+{
+	if (fd_head->frag_index) {
+		wmem_tree_destroy(fd_head->frag_index, false, false);
+		fd_head->frag_index = NULL;
+	}
+}
+
+/*
+ * Indexes the fragments by offset. Of the fragments with the same offset,
+ * the index keeps the last one in the list, which is where the next
+ * fragment with that offset is linked.
+ */
+static void
+fragment_index_build(fragment_head *fd_head)
+{
+	fragment_item *fd_i;
+
+	fd_head->frag_index = wmem_tree_new(NULL);
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		wmem_tree_insert32(fd_head->frag_index, fd_i->offset, fd_i);
+	}
+}
+
+/*
+ * Memory budget for the data of completed reassemblies.
+ *
+ * Reassemblies that have data in memory are kept on a list, least
+ * recently used first. Once the table is over its budget, reassemblies
+ * at the front of the list have their data written to a spill file and
+ * freed. The data never changes once reassembled, so it's only written
+ * the first time; the space is reclaimed when the table is reinitialized.
+ */
+typedef struct _reassembly_spill_entry {
+	struct _reassembly_spill_entry *prev;	/* LRU list, only while resident */
+	struct _reassembly_spill_entry *next;
+	struct _reassembly_spill *spill;
+	fragment_head *fd_head;
+	int64_t file_offset;			/* -1 until written to the spill file */
+	uint32_t len;
+	uint32_t frame;				/* last frame that looked it up */
+	bool resident;
+} reassembly_spill_entry_t;
+
+typedef struct _reassembly_spill {
+	size_t budget;
+	size_t resident;			/* bytes of reassembled data in memory */
+	reassembly_spill_entry_t *lru_head;
+	reassembly_spill_entry_t *lru_tail;
+	int fd;					/* -1 until something is spilled */
+	char *path;
+	int64_t file_len;
+	bool failed;				/* writing failed; keep everything resident */
+} reassembly_spill_t;
+
+static void
+spill_lru_unlink(reassembly_spill_t *spill, reassembly_spill_entry_t *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		spill->lru_head = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		spill->lru_tail = entry->prev;
+	entry->prev = entry->next = NULL;
+}
+
+static void
+spill_lru_append(reassembly_spill_t *spill, reassembly_spill_entry_t *entry)
+{
+	entry->prev = spill->lru_tail;
+	entry->next = NULL;
+	if (spill->lru_tail)
+		spill->lru_tail->next = entry;
+	else
+		spill->lru_head = entry;
+	spill->lru_tail = entry;
+}
+
+/*
+ * The data can only be freed if nothing else points into it; fragments
+ * are made subsets of it when a completed reassembly is extended.
+ */
+static bool
+spill_evictable(const fragment_head *fd_head)
+{
+	const fragment_item *fd_i;
+
+	if (fd_head->tvb_data == NULL ||
+	    (fd_head->flags & (FD_SUBSET_TVB|FD_PARTIAL_REASSEMBLY)))
+		return false;
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (fd_i->flags & FD_SUBSET_TVB)
+			return false;
+	}
+	return true;
+}
+
+static bool
+spill_write(reassembly_spill_t *spill, reassembly_spill_entry_t *entry)
+{
+	const uint8_t *ptr;
+	size_t done = 0;
+	ws_file_ssize_t ret;
+
+	if (spill->fd == -1) {
+		spill->fd = create_tempfile(NULL, &spill->path, "wireshark_reassembly", NULL, NULL);
+		if (spill->fd == -1)
+			return false;
+		spill->file_len = 0;
+	}
+
+	ptr = tvb_get_ptr(entry->fd_head->tvb_data, 0, entry->len);
+	if (ws_lseek64(spill->fd, spill->file_len, SEEK_SET) == -1)
+		return false;
+	while (done < entry->len) {
+		ret = ws_write(spill->fd, ptr + done, (unsigned)(entry->len - done));
+		if (ret <= 0)
+			return false;
+		done += (size_t)ret;
+	}
+	entry->file_offset = spill->file_len;
+	spill->file_len += entry->len;
+	return true;
+}
+
+static bool
+spill_read(reassembly_spill_t *spill, reassembly_spill_entry_t *entry, uint8_t *buf)
+{
+	size_t done = 0;
+	ws_file_ssize_t ret;
+
+	if (ws_lseek64(spill->fd, entry->file_offset, SEEK_SET) == -1)
+		return false;
+	while (done < entry->len) {
+		ret = ws_read(spill->fd, buf + done, (unsigned)(entry->len - done));
+		if (ret <= 0)
+			return false;
+		done += (size_t)ret;
+	}
+	return true;
+}
+
+/*
+ * Spills least recently used reassemblies until the table is within its
+ * budget. Ones looked up in the current frame are left alone, as the
+ * dissectors may still be using their data.
+ */
+static void
+spill_evict(reassembly_spill_t *spill, const uint32_t frame)
+{
+	reassembly_spill_entry_t *entry, *next;
+
+	if (spill->budget == 0 || spill->failed)
+		return;
+
+	for (entry = spill->lru_head; entry && spill->resident > spill->budget; entry = next) {
+		next = entry->next;
+		if (entry->frame == frame || !spill_evictable(entry->fd_head))
+			continue;
+		if (entry->file_offset == -1 && !spill_write(spill, entry)) {
+			spill->failed = true;
+			return;
+		}
+		tvb_free(entry->fd_head->tvb_data);
+		entry->fd_head->tvb_data = NULL;
+		entry->resident = false;
+		spill->resident -= entry->len;
+		spill_lru_unlink(spill, entry);
+	}
+}
+
+/*
+ * Reads the data of a spilled reassembly back in.
+ */
+static void
+spill_load(fragment_head *fd_head)
+{
+	reassembly_spill_entry_t *entry = fd_head->spill;
+	uint8_t *buf;
+
+	if (entry == NULL || entry->resident)
+		return;
+
+	buf = (uint8_t *)g_malloc(entry->len);
+	if (!spill_read(entry->spill, entry, buf)) {
+		g_free(buf);
+		fd_head->error = "reassembled data could not be read back from disk";
+		return;
+	}
+	fd_head->tvb_data = tvb_new_real_data(buf, entry->len, entry->len);
+	tvb_set_free_cb(fd_head->tvb_data, g_free);
+	entry->resident = true;
+	entry->spill->resident += entry->len;
+	spill_lru_append(entry->spill, entry);
+}
+
+/*
+ * Starts accounting for the data of a just completed reassembly.
+ */
+static void
+spill_track(reassembly_table *table, fragment_head *fd_head, const uint32_t frame)
+{
+	reassembly_spill_entry_t *entry;
+	uint32_t len;
+
+	if (table->memory_budget == 0 || fd_head->spill != NULL ||
+	    fd_head->tvb_data == NULL || (fd_head->flags & FD_SUBSET_TVB))
+		return;
+	len = tvb_captured_length(fd_head->tvb_data);
+	if (len == 0)
+		return;
+
+	if (table->spill == NULL) {
+		table->spill = g_new0(reassembly_spill_t, 1);
+		table->spill->fd = -1;
+	}
+	table->spill->budget = table->memory_budget;
+
+	entry = g_slice_new0(reassembly_spill_entry_t);
+	entry->spill = table->spill;
+	entry->fd_head = fd_head;
+	entry->file_offset = -1;
+	entry->len = len;
+	entry->frame = frame;
+	entry->resident = true;
+	fd_head->spill = entry;
+	table->spill->resident += len;
+	spill_lru_append(table->spill, entry);
+
+	spill_evict(table->spill, frame);
+}
+
+/*
+ * Marks a reassembly as used by the given frame, reading its data back
+ * in if it was spilled.
+ */
+static void
+spill_touch(fragment_head *fd_head, const uint32_t frame)
+{
+	reassembly_spill_entry_t *entry = fd_head->spill;
+
+	if (entry == NULL)
+		return;
+
+	entry->frame = frame;
+	if (entry->resident) {
+		spill_lru_unlink(entry->spill, entry);
+		spill_lru_append(entry->spill, entry);
+	} else {
+		spill_load(fd_head);
+	}
+	spill_evict(entry->spill, frame);
+}
+
+/*
+ * Stops accounting for a reassembly; call it before the fragment_head
+ * is freed or its data is handed over to something else.
+ */
+static void
+spill_untrack(fragment_head *fd_head)
+{
+	reassembly_spill_entry_t *entry = fd_head->spill;
+
+	if (entry == NULL)
+		return;
+
+	if (entry->resident) {
+		entry->spill->resident -= entry->len;
+		spill_lru_unlink(entry->spill, entry);
+	}
+	g_slice_free(reassembly_spill_entry_t, entry);
+	fd_head->spill = NULL;
+}
+
+static void
+spill_close(reassembly_table *table)
+{
+	reassembly_spill_t *spill = table->spill;
+
+	if (spill == NULL)
+		return;
+
+	if (spill->fd != -1) {
+		ws_close(spill->fd);
+		ws_unlink(spill->path);
+	}
+	g_free(spill->path);
+	g_free(spill);
+	table->spill = NULL;
+}
+
 /*
  * For a fragment hash table entry, free the associated fragments.
  * The entry value (fd_chain) is freed herein and the entry is freed
@@ -336,6 +644,8 @@ free_all_fragments(void *key_arg _U_, void *value, void *user_data _U_)
 		fd_i = fd_head->next;
 		if(fd_head->tvb_data && !(fd_head->flags&FD_SUBSET_TVB))
 			tvb_free(fd_head->tvb_data);
+		fragment_index_drop(fd_head);
+		spill_untrack(fd_head);
 		g_slice_free(fragment_head, fd_head);
 	}
 
@@ -386,6 +696,8 @@ free_fd_head(fragment_head *fd_head)
 		}
 		g_slice_free(fragment_item, fd_i);
 	}
+	fragment_index_drop(fd_head);
+	spill_untrack(fd_head);
 	g_slice_free(fragment_head, fd_head);
 }
 
@@ -407,6 +719,7 @@ reassembled_table_insert(GHashTable *reassembled_table, reassembled_key *key, fr
 	fd_head->ref_count++;
 	if ((old_fd_head = g_hash_table_lookup(reassembled_table, key)) != NULL) {
 		if (old_fd_head->ref_count == 1) {
+			spill_untrack(old_fd_head);
 			/* We're replacing the last entry in the reassembled
 			 * table for an old reassembly. Does it have a tvb?
 			 * We might still be using that tvb's memory for an
@@ -501,6 +814,9 @@ reassembly_table_init(reassembly_table *table,
 		table->reassembled_table = g_hash_table_new_full(reassembled_hash,
 		    reassembled_equal, reassembled_key_free, unref_fd_head);
 	}
+
+	/* Nothing refers to the spilled data any more. */
+	spill_close(table);
 }
 
 /*
@@ -550,6 +866,34 @@ reassembly_table_destroy(reassembly_table *table)
 		g_hash_table_destroy(table->reassembled_table);
 		table->reassembled_table = NULL;
 	}
+	spill_close(table);
+}
+
+void
+reassembly_table_set_memory_budget(reassembly_table *table, size_t budget)
+{
+	table->memory_budget = budget;
+	if (table->spill != NULL) {
+		table->spill->budget = budget;
+		spill_evict(table->spill, 0);
+	}
+}
+
+
+/*
+ * Look up an fd_head in the reassembled table, reading its data back in
+ * if it was spilled to disk.
+ */
+static fragment_head *
+lookup_reassembled(reassembly_table *table, const packet_info *pinfo,
+		   const reassembled_key *key)
+{
+	fragment_head *fd_head;
+
+	fd_head = (fragment_head *)g_hash_table_lookup(table->reassembled_table, key);
+	if (fd_head != NULL)
+		spill_touch(fd_head, pinfo->num);
+	return fd_head;
 }
 
 /*
@@ -623,6 +967,9 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 		return NULL;
 	}
 
+	/* The caller gets the data, so it has to be in memory. */
+	spill_load(fd_head);
+	spill_untrack(fd_head);
 	fd_tvb_data=fd_head->tvb_data;
 	/* loop over all partial fragments and free any tvbuffs */
 	for(fd=fd_head->next;fd;){
@@ -634,6 +981,7 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 		g_slice_free(fragment_item, fd);
 		fd=tmp_fd;
 	}
+	fragment_index_drop(fd_head);
 	g_slice_free(fragment_head, fd_head);
 	g_hash_table_remove(table->fragment_table, key);
 
@@ -660,7 +1008,7 @@ fragment_get_reassembled_id(reassembly_table *table, const packet_info *pinfo,
 	/* create key to search hash with */
 	key.frame = pinfo->num;
 	key.id = id;
-	fd_head = (fragment_head *)g_hash_table_lookup(table->reassembled_table, &key);
+	fd_head = lookup_reassembled(table, pinfo, &key);
 
 	return fd_head;
 }
@@ -746,6 +1094,7 @@ static void fragment_reset_first_gap(fragment_head *fd_head)
  */
 static void fragment_items_removed(fragment_head *fd_head, fragment_item *modified)
 {
+	fragment_index_drop(fd_head);
 	if ((fd_head->first_gap == modified) ||
 	    ((modified != NULL) && (modified->offset > fd_head->contiguous_len))) {
 		/* Removed elements were after first gap */
@@ -1053,6 +1402,7 @@ fragment_reassembled(reassembly_table *table, fragment_head *fd_head,
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in = pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+	spill_track(table, fd_head, pinfo->num);
 }
 
 /*
@@ -1091,18 +1441,26 @@ fragment_reassembled_single(reassembly_table *table, fragment_head *fd_head,
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in = pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+	spill_track(table, fd_head, pinfo->num);
 }
 
 static void
 LINK_FRAG(fragment_head *fd_head,fragment_item *fd)
 {
 	fragment_item *fd_i;
+	unsigned walked = 0;
 
 	/* add fragment to list, keep list sorted */
 	if (fd_head->next == NULL || fd->offset < fd_head->next->offset) {
 		/* New first fragment */
 		fd->next = fd_head->next;
 		fd_head->next = fd;
+	} else if (fd_head->frag_index) {
+		/* The last fragment at or before this offset; there is one,
+		 * as this offset isn't before the first fragment. */
+		fd_i = (fragment_item *)wmem_tree_lookup32_le(fd_head->frag_index, fd->offset);
+		fd->next = fd_i->next;
+		fd_i->next = fd;
 	} else {
 		fd_i = fd_head->next;
 		if (fd_head->first_gap != NULL) {
@@ -1114,11 +1472,20 @@ LINK_FRAG(fragment_head *fd_head,fragment_item *fd)
 		for(; fd_i->next; fd_i=fd_i->next) {
 			if (fd->offset < fd_i->next->offset )
 				break;
+			walked++;
 		}
 		fd->next = fd_i->next;
 		fd_i->next = fd;
 	}
 
+	/* A lossy stream can leave many fragments held after the first
+	 * gap, each (re)transmission walking all of them. */
+	if (fd_head->frag_index) {
+		wmem_tree_insert32(fd_head->frag_index, fd->offset, fd);
+	} else if (walked >= FRAG_INDEX_MIN_WALK) {
+		fragment_index_build(fd_head);
+	}
+
 	update_first_gap(fd_head, fd, false);
 }
 
@@ -1131,6 +1498,7 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 	if (fd == NULL) return;
 
 	multi_insert = (fd->next != NULL);
+	fragment_index_drop(fd_head);
 
 	if (fd_head->next == NULL) {
 		fd_head->next = fd;
@@ -1508,6 +1876,8 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	/* mark this packet as defragmented.
 	   allows us to skip any trailing fragments */
 	fd_head->flags |= FD_DEFRAGMENTED;
+	/* Nothing is held waiting any more, so free the index. */
+	fragment_index_drop(fd_head);
 	fd_head->reassembled_in=pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
 
@@ -1531,6 +1901,7 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	fragment_item *fd_item;
 	bool already_added;
 
+	WS_TRACE3(fragment__add, pinfo->num, frag_offset, frag_data_len);
 
 	/*
 	 * Dissector shouldn't give us garbage tvb info.
@@ -1776,7 +2147,7 @@ fragment_add_check_with_fallback(reassembly_table *table, tvbuff_t *tvb, const i
 	if (pinfo->fd->visited) {
 		reass_key.frame = pinfo->num;
 		reass_key.id = id;
-		return (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		return lookup_reassembled(table, pinfo, &reass_key);
 	}
 
 	/* Looks up a key in the GHashTable, returning the original key and the associated value
@@ -1788,7 +2159,7 @@ fragment_add_check_with_fallback(reassembly_table *table, tvbuff_t *tvb, const i
 		/* Check if there is completed reassembly reachable from fallback frame */
 		reass_key.frame = fallback_frame;
 		reass_key.id = id;
-		fd_head = (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		fd_head = lookup_reassembled(table, pinfo, &reass_key);
 		if (fd_head != NULL) {
 			/* Found completely reassembled packet, hash it with current frame number */
 			reassembled_key *new_key = g_slice_new(reassembled_key);
@@ -1920,6 +2291,8 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 	 * allows us to skip any trailing fragments.
 	 */
 	fd_head->flags |= FD_DEFRAGMENTED;
+	/* Nothing is held waiting any more, so free the index. */
+	fragment_index_drop(fd_head);
 	fd_head->reassembled_in=pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
 }
@@ -2194,6 +2567,8 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 	fragment_head *fd_head;
 	void *orig_key;
 
+	WS_TRACE3(fragment__add__seq, pinfo->num, frag_number, frag_data_len);
+
 	fd_head = lookup_fd_head(table, pinfo, id, data, &orig_key);
 
 	/* have we already seen this frame ?*/
@@ -2348,7 +2723,7 @@ fragment_add_seq_check_work(reassembly_table *table, tvbuff_t *tvb,
 	if (pinfo->fd->visited) {
 		reass_key.frame = pinfo->num;
 		reass_key.id = id;
-		return (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		return lookup_reassembled(table, pinfo, &reass_key);
 	}
 
 	fd_head = fragment_add_seq_common(table, tvb, offset, pinfo, id, data,
@@ -2455,6 +2830,7 @@ fragment_add_seq_single_move(reassembly_table *table, const packet_info *pinfo,
 		if (fd && fd->offset != 0) {
 			fragment_item *inserted = fd;
 			bool multi_insert = (inserted->next != NULL);
+			fragment_index_drop(fh);
 			if (prev_fd) {
 				prev_fd->next = fd;
 			} else {
@@ -2504,7 +2880,7 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 	if (pinfo->fd->visited) {
 		reass_key.frame = pinfo->num;
 		reass_key.id = id;
-		fh = (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		fh = lookup_reassembled(table, pinfo, &reass_key);
 		return fh;
 	}
 	/* First let's figure out where we want to add our new fragment */
@@ -2765,6 +3141,7 @@ fragment_start_seq_check(reassembly_table *table, const packet_info *pinfo,
 		fd_head = g_slice_new(fragment_head);
 		fd_head->next = NULL;
 		fd_head->first_gap = NULL;
+		fd_head->frag_index = NULL;
 		fd_head->contiguous_len = 0;
 		fd_head->frame = 0;
 		fd_head->len = 0;
@@ -2798,7 +3175,7 @@ fragment_end_seq_next(reassembly_table *table, const packet_info *pinfo,
 	if (pinfo->fd->visited) {
 		reass_key.frame = pinfo->num;
 		reass_key.id = id;
-		return (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		return lookup_reassembled(table, pinfo, &reass_key);
 	}
 
 	fd_head = lookup_fd_head(table, pinfo, id, data, &orig_key);
@@ -3171,6 +3548,57 @@ reassembly_table_cleanup_reg_tables(void)
 	g_list_foreach(reassembly_table_list, reassembly_table_cleanup_reg_table, NULL);
 }
 
+static void
+reassembly_table_set_reg_budget(void *p, void *user_data)
+{
+	register_reassembly_table_t* reg_table = (register_reassembly_table_t*)p;
+	reassembly_table_set_memory_budget(reg_table->table, *(size_t *)user_data);
+}
+
+void
+reassembly_tables_set_memory_budget(size_t budget)
+{
+	g_list_foreach(reassembly_table_list, reassembly_table_set_reg_budget, &budget);
+}
+
+static gboolean
+fragment_is_idle(void *key, void *value, void *user_data)
+{
+	fragment_head *fd_head = (fragment_head *)value;
+
+	if (fd_head->frame >= *(uint32_t *)user_data)
+		return FALSE;
+	return free_all_fragments(key, value, NULL);
+}
+
+static gboolean
+reassembled_is_idle(void *key, void *value _U_, void *user_data)
+{
+	return ((reassembled_key *)key)->frame < *(uint32_t *)user_data;
+}
+
+static void
+reassembly_table_retire_reg_table(void *p, void *user_data)
+{
+	register_reassembly_table_t* reg_table = (register_reassembly_table_t*)p;
+	reassembly_table *table = reg_table->table;
+
+	if (table->fragment_table != NULL)
+		g_hash_table_foreach_remove(table->fragment_table,
+					    fragment_is_idle, user_data);
+	if (table->reassembled_table != NULL)
+		g_hash_table_foreach_remove(table->reassembled_table,
+					    reassembled_is_idle, user_data);
+}
+
+void
+reassembly_tables_retire(const uint32_t before_frame)
+{
+	uint32_t frame = before_frame;
+
+	g_list_foreach(reassembly_table_list, reassembly_table_retire_reg_table, &frame);
+}
+
 void reassembly_tables_init(void)
 {
 	register_init_routine(&reassembly_table_init_reg_tables);
@@ -103,6 +103,19 @@ typedef struct _fragment_head {
 	 * an error, in which case it's the string for the error.
 	 */
 	const char *error;
+	/**
+	 * Index of the fragments by offset, so that out-of-order fragments
+	 * can be linked in O(log n). Only built once the list gets long,
+	 * and dropped whenever fragments are removed; NULL otherwise.
+	 */
+	struct _wmem_tree_t *frag_index;
+	/**
+	 * Bookkeeping for the memory budget of the reassembly table, if
+	 * it has one; NULL otherwise. While the reassembled data is spilled
+	 * to disk, tvb_data is NULL; it is read back in when the reassembly
+	 * is looked up again.
+	 */
+	struct _reassembly_spill_entry *spill;
 } fragment_head;
 
 /*
@@ -149,6 +162,8 @@ typedef struct {
 	fragment_temporary_key temporary_key_func;
 	fragment_persistent_key persistent_key_func;
 	GDestroyNotify free_temporary_key_func;		/* temporary key destruction function */
+	size_t memory_budget;				/* bytes of reassembled data to keep in memory, 0 for no limit */
+	struct _reassembly_spill *spill;		/* spill file and LRU list of reassembled data */
 } reassembly_table;
 
 /*
@@ -194,6 +209,38 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/*
+ * Limit the memory used by the data of completed reassemblies in a table.
+ *
+ * Once more than "budget" bytes of reassembled data are in memory, the
+ * least recently used reassemblies have their data written to a temporary
+ * file and freed; the data is read back in when the reassembly is looked
+ * up again, e.g. when the GUI revisits a frame. Reassemblies used in the
+ * frame being dissected are never spilled. A budget of 0, the default,
+ * means no limit. The budget survives reassembly_table_init().
+ */
+WS_DLL_PUBLIC void
+reassembly_table_set_memory_budget(reassembly_table *table, size_t budget);
+
+/*
+ * Set the memory budget of all the reassembly tables registered with
+ * reassembly_table_register(), as with reassembly_table_set_memory_budget().
+ */
+WS_DLL_PUBLIC void
+reassembly_tables_set_memory_budget(size_t budget);
+
+/*
+ * Drop the state of the registered reassembly tables that only concerns
+ * frames before before_frame: reassemblies still in progress that haven't
+ * had a fragment added since then, and the entries for those frames in
+ * the table of completed reassemblies.
+ *
+ * This is only safe when no frame before before_frame will be dissected
+ * again, such as in a single pass over a live capture.
+ */
+WS_DLL_PUBLIC void
+reassembly_tables_retire(const uint32_t before_frame);
+
 /*
  * This function adds a new fragment to the reassembly table
  * If this is the first fragment seen for this datagram, a new entry
@@ -3203,6 +3203,237 @@ test_fragment_add_check_duplicate_conflict(void)
         print_fragment_table();
     }
 }
+/**********************************************************************************
+ *
+ * large out-of-order datagrams
+ *
+ *********************************************************************************/
+
+#define LARGE_FRAGS    10000
+#define LARGE_FRAG_LEN 10
+
+/* Where fragment n of a large datagram comes from, and thus what its data is */
+#define LARGE_FRAG_TVB_OFFSET(n) (int)(((n) * 7) % (DATA_LEN - LARGE_FRAG_LEN))
+
+/* Fills order[] with a permutation of 1..LARGE_FRAGS-1, so that the first
+ * fragment comes last and every other fragment is held waiting for it. */
+static void
+large_frag_order(uint32_t *order)
+{
+    uint32_t rnd = 12345;
+
+    for (uint32_t n = 0; n < LARGE_FRAGS - 1; n++) {
+        order[n] = n + 1;
+    }
+    for (uint32_t n = LARGE_FRAGS - 2; n > 0; n--) {
+        uint32_t k, tmp;
+
+        rnd = rnd * 1103515245 + 12345;
+        k = (rnd >> 8) % (n + 1);
+        tmp = order[n];
+        order[n] = order[k];
+        order[k] = tmp;
+    }
+}
+
+/* Adds a datagram of LARGE_FRAGS fragments in random order, with every
+ * tenth one retransmitted, and the first fragment last. */
+static void
+test_fragment_add_large_out_of_order(void)
+{
+    fragment_head *fd_head = NULL;
+    fragment_item *fd;
+    uint32_t *order;
+    uint32_t n, count, prev_offset;
+    int64_t start;
+
+    printf("Starting test test_fragment_add_large_out_of_order\n");
+
+    order = g_new(uint32_t, LARGE_FRAGS - 1);
+    large_frag_order(order);
+
+    start = g_get_monotonic_time();
+    pinfo.num = 1;
+    for (n = 0; n < LARGE_FRAGS - 1; n++) {
+        uint32_t frag = order[n];
+
+        fd_head=fragment_add(&test_reassembly_table, tvb, LARGE_FRAG_TVB_OFFSET(frag), &pinfo, 12, NULL,
+                             frag * LARGE_FRAG_LEN, LARGE_FRAG_LEN, frag != LARGE_FRAGS - 1);
+        ASSERT_EQ_POINTER(NULL,fd_head);
+        pinfo.num++;
+        if (frag % 10 == 0) {
+            fd_head=fragment_add(&test_reassembly_table, tvb, LARGE_FRAG_TVB_OFFSET(frag), &pinfo, 12, NULL,
+                                 frag * LARGE_FRAG_LEN, LARGE_FRAG_LEN, frag != LARGE_FRAGS - 1);
+            ASSERT_EQ_POINTER(NULL,fd_head);
+            pinfo.num++;
+        }
+    }
+    fd_head=fragment_add(&test_reassembly_table, tvb, LARGE_FRAG_TVB_OFFSET(0), &pinfo, 12, NULL,
+                         0, LARGE_FRAG_LEN, true);
+    printf("    %u fragments took %.3f ms\n", pinfo.num,
+           (double)(g_get_monotonic_time() - start) / 1000);
+
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(LARGE_FRAGS * LARGE_FRAG_LEN,fd_head->datalen);
+    ASSERT_EQ(pinfo.num,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET|FD_OVERLAP,fd_head->flags);
+
+    /* the list is still sorted by offset, retransmissions after the original */
+    count = 0;
+    prev_offset = 0;
+    for (fd = fd_head->next; fd != NULL; fd = fd->next) {
+        ASSERT(fd->offset >= prev_offset);
+        ASSERT_EQ(LARGE_FRAG_LEN,fd->len);
+        ASSERT_EQ_POINTER(NULL,fd->tvb_data);
+        if (fd->offset == prev_offset && count != 0) {
+            ASSERT_EQ(FD_OVERLAP,fd->flags);
+        } else {
+            ASSERT_EQ(0,fd->flags);
+        }
+        prev_offset = fd->offset;
+        count++;
+    }
+    ASSERT_EQ(LARGE_FRAGS + (LARGE_FRAGS - 1) / 10,count);
+
+    for (n = 0; n < LARGE_FRAGS; n++) {
+        ASSERT(!tvb_memeql(fd_head->tvb_data, n * LARGE_FRAG_LEN,
+                           data + LARGE_FRAG_TVB_OFFSET(n), LARGE_FRAG_LEN));
+    }
+
+    g_free(order);
+}
+
+/* As above, but with block numbers rather than offsets. */
+static void
+test_fragment_add_seq_large_out_of_order(void)
+{
+    fragment_head *fd_head = NULL;
+    fragment_item *fd;
+    uint32_t *order;
+    uint32_t n, count;
+    int64_t start;
+
+    printf("Starting test test_fragment_add_seq_large_out_of_order\n");
+
+    order = g_new(uint32_t, LARGE_FRAGS - 1);
+    large_frag_order(order);
+
+    start = g_get_monotonic_time();
+    pinfo.num = 1;
+    for (n = 0; n < LARGE_FRAGS - 1; n++) {
+        uint32_t frag = order[n];
+
+        fd_head=fragment_add_seq(&test_reassembly_table, tvb, LARGE_FRAG_TVB_OFFSET(frag), &pinfo, 12, NULL,
+                                 frag, LARGE_FRAG_LEN, frag != LARGE_FRAGS - 1, 0);
+        ASSERT_EQ_POINTER(NULL,fd_head);
+        pinfo.num++;
+    }
+    fd_head=fragment_add_seq(&test_reassembly_table, tvb, LARGE_FRAG_TVB_OFFSET(0), &pinfo, 12, NULL,
+                             0, LARGE_FRAG_LEN, true, 0);
+    printf("    %u fragments took %.3f ms\n", pinfo.num,
+           (double)(g_get_monotonic_time() - start) / 1000);
+
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(LARGE_FRAGS - 1,fd_head->datalen); /* index of last fragment */
+    ASSERT_EQ(LARGE_FRAGS * LARGE_FRAG_LEN,fd_head->len);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_BLOCKSEQUENCE|FD_DATALEN_SET,fd_head->flags);
+
+    count = 0;
+    for (fd = fd_head->next; fd != NULL; fd = fd->next) {
+        ASSERT_EQ(count,fd->offset);
+        count++;
+    }
+    ASSERT_EQ(LARGE_FRAGS,count);
+
+    for (n = 0; n < LARGE_FRAGS; n++) {
+        ASSERT(!tvb_memeql(fd_head->tvb_data, n * LARGE_FRAG_LEN,
+                           data + LARGE_FRAG_TVB_OFFSET(n), LARGE_FRAG_LEN));
+    }
+
+    g_free(order);
+}
+
+/**********************************************************************************
+ *
+ * memory budget
+ *
+ *********************************************************************************/
+
+#define BUDGET_DATAGRAMS 10
+#define BUDGET_FRAG_LEN  50
+
+static void
+count_spilled(void *k _U_, void *v, void *ud)
+{
+    fragment_head *fd_head = (fragment_head *)v;
+
+    if (fd_head->tvb_data == NULL) {
+        (*(unsigned *)ud)++;
+    }
+}
+
+/* Reassembles BUDGET_DATAGRAMS datagrams of two fragments each into a table
+ * that only has room for two of them, then revisits them all and checks that
+ * the spilled data is read back in intact. */
+static void
+test_fragment_add_check_memory_budget(void)
+{
+    fragment_head *fd_head;
+    unsigned spilled = 0;
+    uint32_t i;
+
+    printf("Starting test test_fragment_add_check_memory_budget\n");
+
+    reassembly_table_set_memory_budget(&test_reassembly_table,
+                                       2 * 2 * BUDGET_FRAG_LEN);
+
+    for (i = 0; i < BUDGET_DATAGRAMS; i++) {
+        pinfo.num = 2 * i + 1;
+        fd_head = fragment_add_check(&test_reassembly_table, tvb, i, &pinfo,
+                                     100 + i, NULL, 0, BUDGET_FRAG_LEN, true);
+        ASSERT_EQ_POINTER(NULL, fd_head);
+
+        pinfo.num = 2 * i + 2;
+        fd_head = fragment_add_check(&test_reassembly_table, tvb,
+                                     i + BUDGET_FRAG_LEN, &pinfo, 100 + i, NULL,
+                                     BUDGET_FRAG_LEN, BUDGET_FRAG_LEN, false);
+        ASSERT_NE_POINTER(NULL, fd_head);
+        /* the reassembly just completed is never spilled */
+        ASSERT_NE_POINTER(NULL, fd_head->tvb_data);
+    }
+
+    ASSERT_EQ(0, g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(2 * BUDGET_DATAGRAMS,
+              g_hash_table_size(test_reassembly_table.reassembled_table));
+
+    /* two frames refer to each reassembly, and all but two are on disk */
+    g_hash_table_foreach(test_reassembly_table.reassembled_table,
+                         count_spilled, &spilled);
+    ASSERT_EQ(2 * (BUDGET_DATAGRAMS - 2), spilled);
+
+    /* revisit them in reverse, so that every one has to be read back in */
+    pinfo.fd->visited = 1;
+    for (i = BUDGET_DATAGRAMS; i-- > 0; ) {
+        pinfo.num = 2 * i + 1;
+        fd_head = fragment_add_check(&test_reassembly_table, tvb, i, &pinfo,
+                                     100 + i, NULL, 0, BUDGET_FRAG_LEN, true);
+        ASSERT_NE_POINTER(NULL, fd_head);
+        ASSERT_NE_POINTER(NULL, fd_head->tvb_data);
+        ASSERT_EQ_POINTER(NULL, fd_head->error);
+        ASSERT_EQ(2 * BUDGET_FRAG_LEN, tvb_captured_length(fd_head->tvb_data));
+        ASSERT(!tvb_memeql(fd_head->tvb_data, 0, data + i, BUDGET_FRAG_LEN));
+        ASSERT(!tvb_memeql(fd_head->tvb_data, BUDGET_FRAG_LEN,
+                           data + i + BUDGET_FRAG_LEN, BUDGET_FRAG_LEN));
+    }
+
+    spilled = 0;
+    g_hash_table_foreach(test_reassembly_table.reassembled_table,
+                         count_spilled, &spilled);
+    ASSERT_EQ(2 * (BUDGET_DATAGRAMS - 2), spilled);
+
+    reassembly_table_set_memory_budget(&test_reassembly_table, 0);
+}
+
 /**********************************************************************************
  *
  * main
@@ -3251,6 +3482,9 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_check_duplicate_last,
 #endif
         test_fragment_add_check_duplicate_conflict,
+        test_fragment_add_large_out_of_order,
+        test_fragment_add_seq_large_out_of_order,
+        test_fragment_add_check_memory_budget,
     };
 
     /* a tvbuff for testing with */
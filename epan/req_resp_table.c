@@ -0,0 +1,332 @@
+/* req_resp_table.c
+ * Routines for matching requests to responses.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/prefs.h>
+#include <wsutil/app_mem_usage.h>
+
+#include <epan/req_resp_table.h>
+
+/* A frame that a transaction was recorded for. */
+typedef struct _req_resp_frame_t {
+	uint64_t key;
+	uint32_t conv_index;
+	uint32_t frame;
+	struct _req_resp_frame_t *next;	/* the transaction's other frames */
+} req_resp_frame_t;
+
+struct _req_resp_table_t {
+	const char *name;
+	const unsigned *retention;
+	wmem_map_t *outstanding;	/* conversation and key -> latest transaction */
+	wmem_map_t *by_frame;		/* req_resp_frame_t -> transaction */
+	GQueue transactions;		/* in the order their requests were added */
+	size_t bytes;
+};
+
+static GSList *req_resp_tables;
+
+static unsigned
+req_resp_hash_key(const uint32_t conv_index, const uint64_t key)
+{
+	uint64_t hash = (key ^ ((uint64_t)conv_index << 32)) * UINT64_C(0x9e3779b97f4a7c15);
+
+	return (unsigned)(hash >> 32);
+}
+
+static unsigned
+req_resp_trans_hash(const void *k)
+{
+	const req_resp_trans_t *trans = (const req_resp_trans_t *)k;
+
+	return req_resp_hash_key(trans->conv_index, trans->key);
+}
+
+static gboolean
+req_resp_trans_equal(const void *a, const void *b)
+{
+	const req_resp_trans_t *trans_a = (const req_resp_trans_t *)a;
+	const req_resp_trans_t *trans_b = (const req_resp_trans_t *)b;
+
+	return trans_a->key == trans_b->key && trans_a->conv_index == trans_b->conv_index;
+}
+
+static unsigned
+req_resp_frame_hash(const void *k)
+{
+	const req_resp_frame_t *frame = (const req_resp_frame_t *)k;
+
+	return req_resp_hash_key(frame->conv_index, frame->key) ^ (frame->frame * 0x9e3779b1U);
+}
+
+static gboolean
+req_resp_frame_equal(const void *a, const void *b)
+{
+	const req_resp_frame_t *frame_a = (const req_resp_frame_t *)a;
+	const req_resp_frame_t *frame_b = (const req_resp_frame_t *)b;
+
+	return frame_a->frame == frame_b->frame && frame_a->key == frame_b->key &&
+	    frame_a->conv_index == frame_b->conv_index;
+}
+
+req_resp_table_t *
+req_resp_table_register(const char *name, const unsigned *retention)
+{
+	req_resp_table_t *table = g_new0(req_resp_table_t, 1);
+
+	table->name = name;
+	table->retention = retention;
+	g_queue_init(&table->transactions);
+	req_resp_tables = g_slist_prepend(req_resp_tables, table);
+	return table;
+}
+
+req_resp_trans_t *
+req_resp_lookup(req_resp_table_t *table, const packet_info *pinfo,
+    const uint32_t conv_index, const uint64_t key)
+{
+	req_resp_trans_t lookup_key, *trans;
+	unsigned retention = table->retention ? *table->retention : prefs.request_retention;
+
+	lookup_key.conv_index = conv_index;
+	lookup_key.key = key;
+	trans = (req_resp_trans_t *)wmem_map_lookup(table->outstanding, &lookup_key);
+	if (trans != NULL && retention > 0) {
+		nstime_t delta;
+
+		nstime_delta(&delta, &pinfo->abs_ts, &trans->req_time);
+		if (nstime_to_sec(&delta) > (double)retention) {
+			/* Kept for req_resp_find(), but no longer matched. */
+			wmem_map_remove(table->outstanding, trans);
+			return NULL;
+		}
+	}
+	return trans;
+}
+
+req_resp_trans_t *
+req_resp_add_request(req_resp_table_t *table, const packet_info *pinfo,
+    const uint32_t conv_index, const uint64_t key, const size_t size)
+{
+	req_resp_trans_t *trans;
+
+	DISSECTOR_ASSERT(size >= sizeof(req_resp_trans_t) && size <= UINT32_MAX);
+
+	trans = (req_resp_trans_t *)wmem_alloc0(wmem_file_scope(), size);
+	trans->key = key;
+	trans->conv_index = conv_index;
+	trans->req_frame = pinfo->num;
+	trans->req_time = pinfo->abs_ts;
+	trans->size = (uint32_t)size;
+	trans->link.data = trans;
+	g_queue_push_tail_link(&table->transactions, &trans->link);
+	table->bytes += size;
+
+	/*
+	 * Inserting over an equal key would keep the old transaction as the
+	 * key, and it might be retired before the new one.
+	 */
+	wmem_map_remove(table->outstanding, trans);
+	wmem_map_insert(table->outstanding, trans, trans);
+
+	req_resp_attach(table, pinfo, trans);
+	return trans;
+}
+
+void
+req_resp_add_response(req_resp_table_t *table, const packet_info *pinfo,
+    req_resp_trans_t *trans)
+{
+	trans->rep_frame = pinfo->num;
+	trans->rep_time = pinfo->abs_ts;
+	req_resp_attach(table, pinfo, trans);
+}
+
+void
+req_resp_attach(req_resp_table_t *table, const packet_info *pinfo,
+    req_resp_trans_t *trans)
+{
+	req_resp_frame_t lookup_key, *frame;
+	req_resp_trans_t *existing;
+
+	lookup_key.key = trans->key;
+	lookup_key.conv_index = trans->conv_index;
+	lookup_key.frame = pinfo->num;
+	existing = (req_resp_trans_t *)wmem_map_lookup(table->by_frame, &lookup_key);
+	if (existing == trans)
+		return;
+	if (existing != NULL)
+		wmem_map_remove(table->by_frame, &lookup_key);
+
+	frame = wmem_new(wmem_file_scope(), req_resp_frame_t);
+	*frame = lookup_key;
+	frame->next = trans->frames;
+	trans->frames = frame;
+	if (pinfo->num > trans->last_frame)
+		trans->last_frame = pinfo->num;
+	wmem_map_insert(table->by_frame, frame, trans);
+	table->bytes += sizeof(req_resp_frame_t);
+}
+
+req_resp_trans_t *
+req_resp_find(req_resp_table_t *table, const packet_info *pinfo,
+    const uint32_t conv_index, const uint64_t key)
+{
+	req_resp_frame_t lookup_key;
+
+	lookup_key.key = key;
+	lookup_key.conv_index = conv_index;
+	lookup_key.frame = pinfo->num;
+	return (req_resp_trans_t *)wmem_map_lookup(table->by_frame, &lookup_key);
+}
+
+bool
+req_resp_response_time(const req_resp_trans_t *trans, nstime_t *delta)
+{
+	if (trans->req_frame == 0 || trans->rep_frame == 0)
+		return false;
+
+	nstime_delta(delta, &trans->rep_time, &trans->req_time);
+	return true;
+}
+
+static void
+req_resp_trans_free(req_resp_table_t *table, req_resp_trans_t *trans)
+{
+	req_resp_frame_t *frame, *next;
+
+	if (wmem_map_lookup(table->outstanding, trans) == trans)
+		wmem_map_remove(table->outstanding, trans);
+
+	for (frame = trans->frames; frame != NULL; frame = next) {
+		next = frame->next;
+		/* A later transaction may have taken over the frame's key. */
+		if (wmem_map_lookup(table->by_frame, frame) == trans)
+			wmem_map_remove(table->by_frame, frame);
+		wmem_free(wmem_file_scope(), frame);
+		table->bytes -= sizeof(req_resp_frame_t);
+	}
+
+	table->bytes -= trans->size;
+	wmem_free(wmem_file_scope(), trans);
+}
+
+static void
+req_resp_table_retire(void *data, void *user_data)
+{
+	req_resp_table_t *table = (req_resp_table_t *)data;
+	uint32_t before_frame = *(const uint32_t *)user_data;
+	GList *link, *next;
+
+	for (link = table->transactions.head; link != NULL; link = next) {
+		req_resp_trans_t *trans = (req_resp_trans_t *)link->data;
+
+		next = link->next;
+		if (trans->last_frame < before_frame) {
+			g_queue_unlink(&table->transactions, link);
+			req_resp_trans_free(table, trans);
+		}
+	}
+}
+
+void
+req_resp_tables_retire(const uint32_t before_frame)
+{
+	uint32_t frame = before_frame;
+
+	g_slist_foreach(req_resp_tables, req_resp_table_retire, &frame);
+}
+
+size_t
+req_resp_tables_in_use(void)
+{
+	size_t bytes = 0;
+
+	for (GSList *entry = req_resp_tables; entry != NULL; entry = entry->next)
+		bytes += ((req_resp_table_t *)entry->data)->bytes;
+	return bytes;
+}
+
+static const ws_mem_usage_t req_resp_tables_usage = { "Request/response tables", req_resp_tables_in_use, NULL };
+
+/* Called at the start of each file, in the file scope. */
+static void
+req_resp_table_init(void *data, void *user_data _U_)
+{
+	req_resp_table_t *table = (req_resp_table_t *)data;
+
+	table->outstanding = wmem_map_new(wmem_file_scope(), req_resp_trans_hash, req_resp_trans_equal);
+	table->by_frame = wmem_map_new_flat(wmem_file_scope(), req_resp_frame_hash, req_resp_frame_equal);
+	g_queue_init(&table->transactions);
+	table->bytes = 0;
+}
+
+static void
+req_resp_tables_init_routine(void)
+{
+	g_slist_foreach(req_resp_tables, req_resp_table_init, NULL);
+}
+
+/* The transactions and maps go with the file scope. */
+static void
+req_resp_table_reset(void *data, void *user_data _U_)
+{
+	req_resp_table_t *table = (req_resp_table_t *)data;
+
+	table->outstanding = NULL;
+	table->by_frame = NULL;
+	g_queue_init(&table->transactions);
+	table->bytes = 0;
+}
+
+static void
+req_resp_tables_cleanup_routine(void)
+{
+	g_slist_foreach(req_resp_tables, req_resp_table_reset, NULL);
+}
+
+void
+req_resp_tables_init(void)
+{
+	static bool usage_registered;
+
+	register_init_routine(&req_resp_tables_init_routine);
+	register_cleanup_routine(&req_resp_tables_cleanup_routine);
+
+	/* epan can be initialized again, but the component is kept forever. */
+	if (!usage_registered) {
+		memory_usage_component_register(&req_resp_tables_usage);
+		usage_registered = true;
+	}
+}
+
+void
+req_resp_tables_cleanup(void)
+{
+	g_slist_free_full(req_resp_tables, g_free);
+	req_resp_tables = NULL;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,167 @@
+/** @file
+ * Declarations of routines for matching requests to responses.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __REQ_RESP_TABLE_H__
+#define __REQ_RESP_TABLE_H__
+
+#include "ws_symbol_export.h"
+#include <epan/packet_info.h>
+#include <wsutil/nstime.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A request/response table matches the requests of a protocol to their
+ * responses by a key of the dissector's choosing (a transaction or
+ * message ID), within a conversation.
+ *
+ * On the first pass the dissector looks up the request that is waiting
+ * for a key with req_resp_lookup(), and adds requests and responses with
+ * req_resp_add_request() and req_resp_add_response(). Each of those, and
+ * req_resp_attach(), records the transaction for the frame, and on later
+ * passes req_resp_find() returns it. Both lookups are hash lookups, so
+ * they don't slow down as the capture grows.
+ *
+ * Requests that go unanswered for longer than the table's retention are
+ * forgotten, so that a response much later doesn't get matched to them.
+ * The transactions themselves last as long as the file, unless
+ * epan_retire_before() retires them.
+ */
+
+/*
+ * A transaction. Dissectors that keep more about a transaction make this
+ * the first member of their own structure, and pass the size of that to
+ * req_resp_add_request().
+ */
+typedef struct _req_resp_trans_t {
+	uint64_t key;
+	uint32_t conv_index;
+	uint32_t req_frame;	/* 0 if the request wasn't seen */
+	uint32_t rep_frame;	/* 0 if no response has been matched yet */
+	nstime_t req_time;
+	nstime_t rep_time;
+
+	/* Private to the table. */
+	uint32_t last_frame;
+	uint32_t size;
+	struct _req_resp_frame_t *frames;
+	GList link;
+} req_resp_trans_t;
+
+typedef struct _req_resp_table_t req_resp_table_t;
+
+/**
+ * Register a table. Its transactions are freed with the file scope.
+ *
+ * @param name  The name of the table, used for reporting its memory.
+ * @param retention  The number of seconds to wait for a response before
+ * forgetting a request, usually a preference; 0 means forever. If NULL,
+ * the "protocols.request_retention" preference is used.
+ * @return The table.
+ */
+WS_DLL_PUBLIC req_resp_table_t *
+req_resp_table_register(const char *name, const unsigned *retention);
+
+/**
+ * Find the latest request for a key that is still waiting for its
+ * response, or that was answered but not replaced by a newer request.
+ * Only valid on the first pass.
+ *
+ * @return The transaction, or NULL if there is none or it has expired.
+ */
+WS_DLL_PUBLIC req_resp_trans_t *
+req_resp_lookup(req_resp_table_t *table, const packet_info *pinfo,
+    const uint32_t conv_index, const uint64_t key);
+
+/**
+ * Add a request for the current frame, replacing any earlier request with
+ * the same key.
+ *
+ * @param size  The size of the structure to allocate, which begins with a
+ * req_resp_trans_t. It is zeroed apart from the transaction fields.
+ * @return The new transaction.
+ */
+WS_DLL_PUBLIC req_resp_trans_t *
+req_resp_add_request(req_resp_table_t *table, const packet_info *pinfo,
+    const uint32_t conv_index, const uint64_t key, const size_t size);
+
+/**
+ * Match the current frame to a transaction as its response.
+ */
+WS_DLL_PUBLIC void
+req_resp_add_response(req_resp_table_t *table, const packet_info *pinfo,
+    req_resp_trans_t *trans);
+
+/**
+ * Record a transaction for the current frame without changing it, e.g.
+ * for a retransmission, so that req_resp_find() returns it later.
+ */
+WS_DLL_PUBLIC void
+req_resp_attach(req_resp_table_t *table, const packet_info *pinfo,
+    req_resp_trans_t *trans);
+
+/**
+ * Find the transaction recorded for a key in the current frame on an
+ * earlier pass.
+ *
+ * @return The transaction, or NULL if there was none.
+ */
+WS_DLL_PUBLIC req_resp_trans_t *
+req_resp_find(req_resp_table_t *table, const packet_info *pinfo,
+    const uint32_t conv_index, const uint64_t key);
+
+/**
+ * Get the time between a transaction's request and its response, as
+ * shown in "Time" fields and added to service response time tables.
+ *
+ * @return false if either hasn't been seen.
+ */
+WS_DLL_PUBLIC bool
+req_resp_response_time(const req_resp_trans_t *trans, nstime_t *delta);
+
+/**
+ * Free the transactions whose frames all come before before_frame.
+ * Called by epan_retire_before().
+ */
+extern void
+req_resp_tables_retire(const uint32_t before_frame);
+
+/**
+ * Get the number of bytes used by the transactions of every table.
+ */
+WS_DLL_PUBLIC size_t
+req_resp_tables_in_use(void);
+
+extern void
+req_resp_tables_init(void);
+
+extern void
+req_resp_tables_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __REQ_RESP_TABLE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -105,6 +105,55 @@ void reset_rtd_table(rtd_stat_table* table)
         memset(table->time_stats[i].rtd, 0, sizeof(timestat_t)*table->time_stats[i].num_timestat);
 }
 
+void *rtd_table_shard_new(void *tapdata)
+{
+    const rtd_data_t *data = (const rtd_data_t *)tapdata;
+    rtd_data_t *shard = g_new0(rtd_data_t, 1);
+    unsigned i;
+
+    shard->user_data = data->user_data;
+    shard->stat_table.filter = data->stat_table.filter;
+    shard->stat_table.num_rtds = data->stat_table.num_rtds;
+    shard->stat_table.time_stats = g_new0(rtd_timestat, data->stat_table.num_rtds);
+
+    for (i = 0; i < data->stat_table.num_rtds; i++)
+    {
+        shard->stat_table.time_stats[i].num_timestat = data->stat_table.time_stats[i].num_timestat;
+        shard->stat_table.time_stats[i].rtd = g_new0(timestat_t, data->stat_table.time_stats[i].num_timestat);
+    }
+
+    return shard;
+}
+
+void rtd_table_shard_merge(void *tapdata, void *shard)
+{
+    rtd_data_t *data = (rtd_data_t *)tapdata;
+    const rtd_data_t *shard_data = (const rtd_data_t *)shard;
+    unsigned i, j;
+
+    for (i = 0; i < data->stat_table.num_rtds && i < shard_data->stat_table.num_rtds; i++)
+    {
+        rtd_timestat *ts = &data->stat_table.time_stats[i];
+        const rtd_timestat *shard_ts = &shard_data->stat_table.time_stats[i];
+
+        for (j = 0; j < ts->num_timestat && j < shard_ts->num_timestat; j++)
+            time_stat_merge(&ts->rtd[j], &shard_ts->rtd[j]);
+
+        ts->open_req_num += shard_ts->open_req_num;
+        ts->disc_rsp_num += shard_ts->disc_rsp_num;
+        ts->req_dup_num += shard_ts->req_dup_num;
+        ts->rsp_dup_num += shard_ts->rsp_dup_num;
+    }
+}
+
+void rtd_table_shard_free(void *shard)
+{
+    rtd_data_t *shard_data = (rtd_data_t *)shard;
+
+    free_rtd_table(&shard_data->stat_table);
+    g_free(shard_data);
+}
+
 register_rtd_t* get_rtd_table_by_name(const char* name)
 {
     return (register_rtd_t*)wmem_tree_lookup_string(registered_rtd_tables, name, 0);
@@ -122,6 +122,17 @@ WS_DLL_PUBLIC void free_rtd_table(rtd_stat_table* table);
  */
 WS_DLL_PUBLIC void reset_rtd_table(rtd_stat_table* table);
 
+/** Shard callbacks for set_tap_mergeable(), for listeners whose tapdata
+ * is an rtd_data_t.
+ *
+ * rtd_table_shard_new() returns an rtd_data_t with a table of the same
+ * size as tapdata's, without any samples; rtd_table_shard_merge() adds its
+ * samples and counters to tapdata.
+ */
+WS_DLL_PUBLIC void *rtd_table_shard_new(void *tapdata);
+WS_DLL_PUBLIC void rtd_table_shard_merge(void *tapdata, void *shard);
+WS_DLL_PUBLIC void rtd_table_shard_free(void *shard);
+
 /** Iterator to walk RTD tables and execute func
  * Used for initialization
  *
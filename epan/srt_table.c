@@ -268,6 +268,77 @@ add_srt_table_data(srt_stat_table *rst, int indx, const nstime_t *req_time, pack
     time_stat_update(&rp->stats, &delta, pinfo);
 }
 
+void *
+srt_table_shard_new(void *tapdata)
+{
+    const srt_data_t *data = (const srt_data_t *)tapdata;
+    srt_data_t *shard = g_new(srt_data_t, 1);
+    unsigned i;
+    int j;
+
+    shard->srt_array = g_array_new(false, true, sizeof(srt_stat_table*));
+    shard->user_data = data->user_data;
+
+    for (i = 0; i < data->srt_array->len; i++)
+    {
+        const srt_stat_table *rst = g_array_index(data->srt_array, srt_stat_table*, i);
+        srt_stat_table *shard_rst;
+
+        shard_rst = init_srt_table(rst->name, rst->short_name, shard->srt_array, rst->num_procs,
+                                   rst->proc_column_name, rst->filter_string, rst->table_specific_data);
+        for (j = 0; j < rst->num_procs; j++)
+        {
+            shard_rst->procedures[j].proc_index = rst->procedures[j].proc_index;
+            shard_rst->procedures[j].procedure = g_strdup(rst->procedures[j].procedure);
+        }
+    }
+
+    return shard;
+}
+
+void
+srt_table_shard_merge(void *tapdata, void *shard)
+{
+    srt_data_t *data = (srt_data_t *)tapdata;
+    const srt_data_t *shard_data = (const srt_data_t *)shard;
+    unsigned i;
+    int j;
+
+    for (i = 0; i < data->srt_array->len && i < shard_data->srt_array->len; i++)
+    {
+        srt_stat_table *rst = g_array_index(data->srt_array, srt_stat_table*, i);
+        const srt_stat_table *shard_rst = g_array_index(shard_data->srt_array, srt_stat_table*, i);
+
+        for (j = 0; j < shard_rst->num_procs; j++)
+        {
+            const srt_procedure_t *rp = &shard_rst->procedures[j];
+
+            if (j >= rst->num_procs || (rst->procedures[j].procedure == NULL && rp->procedure != NULL))
+            {
+                init_srt_table_row(rst, j, rp->procedure);
+            }
+            time_stat_merge(&rst->procedures[j].stats, &rp->stats);
+        }
+    }
+}
+
+void
+srt_table_shard_free(void *shard)
+{
+    srt_data_t *shard_data = (srt_data_t *)shard;
+    unsigned i;
+
+    for (i = 0; i < shard_data->srt_array->len; i++)
+    {
+        srt_stat_table *rst = g_array_index(shard_data->srt_array, srt_stat_table*, i);
+
+        free_srt_table_data(rst);
+        g_free(rst);
+    }
+    g_array_free(shard_data->srt_array, true);
+    g_free(shard_data);
+}
+
 /*
  * Editor modelines
  *
@@ -209,6 +209,17 @@ WS_DLL_PUBLIC void init_srt_table_row(srt_stat_table *rst, int proc_index, const
  */
 WS_DLL_PUBLIC void add_srt_table_data(srt_stat_table *rst, int proc_index, const nstime_t *req_time, packet_info *pinfo);
 
+/** Shard callbacks for set_tap_mergeable(), for listeners whose tapdata
+ * is an srt_data_t.
+ *
+ * srt_table_shard_new() returns an srt_data_t with the same tables and
+ * rows as tapdata, without any responses; srt_table_shard_merge() adds its
+ * responses to tapdata, with any rows it discovered.
+ */
+WS_DLL_PUBLIC void *srt_table_shard_new(void *tapdata);
+WS_DLL_PUBLIC void srt_table_shard_merge(void *tapdata, void *shard);
+WS_DLL_PUBLIC void srt_table_shard_free(void *shard);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
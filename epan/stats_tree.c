@@ -111,6 +111,7 @@ free_stat_node(stat_node *node)
     }
 
     if (node->hash) g_hash_table_destroy(node->hash);
+    if (node->key_hash) g_hash_table_destroy(node->key_hash);
 
     while (node->bh) {
         bucket = node->bh;
@@ -148,6 +149,7 @@ stats_tree_free(stats_tree *st)
     }
     g_free(st->root.name);
     g_free(st->root.bh);
+    if (st->root.key_hash) g_hash_table_destroy(st->root.key_hash);
 
     if (st->cfg->free_tree_pr)
         st->cfg->free_tree_pr(st);
@@ -228,6 +230,10 @@ stats_tree_reinit(void *p)
     }
 
     st->root.children = NULL;
+    st->root.last_child = NULL;
+    if (st->root.key_hash) {
+        g_hash_table_remove_all(st->root.key_hash);
+    }
     st->root.counter = 0;
     switch (st->root.datatype)
     {
@@ -496,7 +502,6 @@ new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatyp
 {
 
     stat_node *node = g_new0(stat_node, 1);
-    stat_node *last_chld = NULL;
 
     node->datatype = datatype;
     switch (datatype)
@@ -541,17 +546,12 @@ new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatyp
 
     if (node->parent->children) {
         /* insert as last child */
-
-        for (last_chld = node->parent->children;
-             last_chld->next;
-             last_chld = last_chld->next ) ;
-
-        last_chld->next = node;
-
+        node->parent->last_child->next = node;
     } else {
         /* insert as first child */
         node->parent->children = node;
     }
+    node->parent->last_child = node;
 
     if(node->parent->hash) {
         g_hash_table_replace(node->parent->hash,node->name,node);
@@ -673,32 +673,10 @@ update_burst_calc(stat_node *node, int value)
     }
 }
 
-/*
- * Increases by delta the counter of the node whose name is given
- * if the node does not exist yet it's created (with counter=1)
- * using parent_name as parent node.
- * with_hash=true to indicate that the created node will have a parent
- */
-int
-stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
-              int parent_id, bool with_hash, int value)
+/* Applies the manip_node_mode operation to an integer node */
+static void
+manip_node_int(stat_node *node, manip_node_mode mode, int value)
 {
-    stat_node *node = NULL;
-    stat_node *parent = NULL;
-
-    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
-
-    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
-
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
-
-    if ( node == NULL )
-        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
-
     switch (mode) {
         case MN_INCREASE:
             node->counter += value;
@@ -728,11 +706,63 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
             node->st_flags &= ~value;
             break;
     }
+}
 
-    if (node)
-        return node->id;
-    else
-        return -1;
+/* Applies the manip_node_mode operation to a floating point node */
+static void
+manip_node_float(stat_node *node, manip_node_mode mode, float value)
+{
+    switch (mode) {
+    case MN_AVERAGE:
+        node->counter++;
+        update_burst_calc(node, 1);
+        /* fall through */ /*to average code */
+    case MN_AVERAGE_NOTICK:
+        node->total.float_total += value;
+        if (node->minvalue.float_min > value) {
+            node->minvalue.float_min = value;
+        }
+        if (node->maxvalue.float_max < value) {
+            node->maxvalue.float_max = value;
+        }
+        node->st_flags |= ST_FLG_AVERAGE;
+        break;
+    default:
+        //only average is currently supported
+        ws_assert_not_reached();
+        break;
+    }
+}
+
+/*
+ * Increases by delta the counter of the node whose name is given
+ * if the node does not exist yet it's created (with counter=1)
+ * using parent_name as parent node.
+ * with_hash=true to indicate that the created node will have a parent
+ */
+int
+stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
+              int parent_id, bool with_hash, int value)
+{
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+
+    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    if( parent->hash ) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if ( node == NULL )
+        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
+
+    manip_node_int(node, mode, value);
+
+    return node->id;
 }
 
 /*
@@ -762,31 +792,81 @@ stats_tree_manip_node_float(manip_node_mode mode, stats_tree *st, const char *na
     if (node == NULL)
         node = new_stat_node(st, name, parent_id, STAT_DT_FLOAT, with_hash, with_hash);
 
-    switch (mode) {
-    case MN_AVERAGE:
-        node->counter++;
-        update_burst_calc(node, 1);
-        /* fall through */ /*to average code */
-    case MN_AVERAGE_NOTICK:
-        node->total.float_total += value;
-        if (node->minvalue.float_min > value) {
-            node->minvalue.float_min = value;
-        }
-        if (node->maxvalue.float_max < value) {
-            node->maxvalue.float_max = value;
-        }
-        node->st_flags |= ST_FLG_AVERAGE;
-        break;
-    default:
-        //only average is currently supported
-        ws_assert_not_reached();
-        break;
-    }
+    manip_node_float(node, mode, value);
 
-    if (node)
-        return node->id;
-    else
+    return node->id;
+}
+
+/*
+ * Same as stats_tree_manip_node_int(), but for a node whose id was
+ * obtained beforehand, so no name has to be built or hashed.
+ */
+int
+stats_tree_manip_node_int_by_id(manip_node_mode mode, stats_tree *st, int node_id, int value)
+{
+    stat_node *node;
+
+    ws_assert( node_id >= 0 && node_id < (int) st->parents->len );
+
+    node = (stat_node *)g_ptr_array_index(st->parents,node_id);
+    manip_node_int(node, mode, value);
+
+    return node_id;
+}
+
+int
+stats_tree_manip_node_float_by_id(manip_node_mode mode, stats_tree *st, int node_id, float value)
+{
+    stat_node *node;
+
+    ws_assert( node_id >= 0 && node_id < (int) st->parents->len );
+
+    node = (stat_node *)g_ptr_array_index(st->parents,node_id);
+    manip_node_float(node, mode, value);
+
+    return node_id;
+}
+
+int
+stats_tree_node_id_by_key(stats_tree *st, int parent_id, unsigned key)
+{
+    stat_node *parent;
+    stat_node *node;
+
+    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+    if (!parent->key_hash) {
         return -1;
+    }
+
+    node = (stat_node *)g_hash_table_lookup(parent->key_hash, GUINT_TO_POINTER(key));
+    return node ? node->id : -1;
+}
+
+int
+stats_tree_create_node_by_key(stats_tree *st, const char *name, int parent_id,
+              unsigned key, stat_node_datatype datatype, bool with_hash)
+{
+    stat_node *parent;
+    stat_node *node;
+
+    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    /* Give the node an id, so that it can be updated without a lookup,
+     * but keep it out of the tree-wide names table like any other child. */
+    node = new_stat_node(st,name,parent_id,datatype,with_hash,false);
+    g_ptr_array_add(st->parents,node);
+    node->id = st->parents->len - 1;
+
+    if (!parent->key_hash) {
+        parent->key_hash = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    g_hash_table_insert(parent->key_hash, GUINT_TO_POINTER(key), node);
+
+    return node->id;
 }
 
 char*
@@ -1037,6 +1117,24 @@ stats_tree_tick_pivot(stats_tree *st, int pivot_id, const char *pivot_value)
     return pivot_id;
 }
 
+int
+stats_tree_tick_pivot_by_key(stats_tree *st, int pivot_id, unsigned key, const char *pivot_value)
+{
+    stat_node *parent = (stat_node *)g_ptr_array_index(st->parents,pivot_id);
+    int node_id;
+
+    parent->counter++;
+    update_burst_calc(parent, 1);
+
+    node_id = stats_tree_node_id_by_key(st, pivot_id, key);
+    if (node_id < 0) {
+        node_id = stats_tree_create_node_by_key(st, pivot_value, pivot_id, key, STAT_DT_INT, false);
+    }
+    stats_tree_manip_node_int_by_id(MN_INCREASE, st, node_id, 1);
+
+    return pivot_id;
+}
+
 char*
 stats_tree_get_displayname (const char* fullname)
 {
@@ -196,6 +196,30 @@ WS_DLL_PUBLIC int stats_tree_tick_pivot(stats_tree *st,
                                         int pivot_id,
                                         const char *pivot_value);
 
+/* Like stats_tree_tick_pivot(), but the pivot's children are identified
+ * by a numeric key (e.g. a protocol or response code). pivot_value is
+ * only used as the name of the child the first time the key is seen, so
+ * it may be NULL if stats_tree_node_id_by_key() says the child exists. */
+WS_DLL_PUBLIC int stats_tree_tick_pivot_by_key(stats_tree *st,
+                                        int pivot_id,
+                                        unsigned key,
+                                        const char *pivot_value);
+
+/* Returns the id of the child of parent_id created with
+ * stats_tree_create_node_by_key() for key, or -1 if there is none yet. */
+WS_DLL_PUBLIC int stats_tree_node_id_by_key(stats_tree *st,
+                                        int parent_id,
+                                        unsigned key);
+
+/* Creates a child of parent_id that is found by a numeric key instead of
+ * its name, and returns its id for use with the *_by_id functions. */
+WS_DLL_PUBLIC int stats_tree_create_node_by_key(stats_tree *st,
+                                        const char *name,
+                                        int parent_id,
+                                        unsigned key,
+                                        stat_node_datatype datatype,
+                                        bool with_hash);
+
 extern void stats_tree_cleanup(void);
 
 
@@ -227,6 +251,23 @@ WS_DLL_PUBLIC int stats_tree_manip_node_float(manip_node_mode mode,
                                         bool with_children,
                                         float value);
 
+/*
+ * manipulates the value of a node by the id returned when it was created
+ * (stats_tree_create_node(), stats_tree_create_pivot(),
+ * stats_tree_create_node_by_key(), ...). Unlike the name based functions
+ * this does no string building or hashing, so it's preferable for nodes
+ * that are updated for every packet. The node must exist.
+ */
+WS_DLL_PUBLIC int stats_tree_manip_node_int_by_id(manip_node_mode mode,
+                                        stats_tree *st,
+                                        int node_id,
+                                        int value);
+
+WS_DLL_PUBLIC int stats_tree_manip_node_float_by_id(manip_node_mode mode,
+                                        stats_tree *st,
+                                        int node_id,
+                                        float value);
+
 #define increase_stat_node(st,name,parent_id,with_children,value)       \
     (stats_tree_manip_node_int(MN_INCREASE,(st),(name),(parent_id),(with_children),(value)))
 
@@ -264,6 +305,18 @@ WS_DLL_PUBLIC int stats_tree_manip_node_float(manip_node_mode mode,
 #define stat_node_clear_flags(st,name,parent_id,with_children,flags)    \
     (stats_tree_manip_node_int(MN_CLEAR_FLAGS,(st),(name),(parent_id),(with_children),flags))
 
+#define increase_stat_node_by_id(st,node_id,value)                      \
+    (stats_tree_manip_node_int_by_id(MN_INCREASE,(st),(node_id),(value)))
+
+#define tick_stat_node_by_id(st,node_id)                                \
+    (stats_tree_manip_node_int_by_id(MN_INCREASE,(st),(node_id),1))
+
+#define avg_stat_node_add_value_int_by_id(st,node_id,value)             \
+    (stats_tree_manip_node_int_by_id(MN_AVERAGE,(st),(node_id),(value)))
+
+#define avg_stat_node_add_value_float_by_id(st,node_id,value)           \
+    (stats_tree_manip_node_float_by_id(MN_AVERAGE,(st),(node_id),(value)))
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
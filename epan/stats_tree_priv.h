@@ -95,12 +95,14 @@ struct _stat_node {
 	double burst_time;              /**< Time span of the burst. */
 
 	GHashTable *hash;               /**< Child nodes indexed by name. */
+	GHashTable *key_hash;           /**< Child nodes indexed by numeric key, created on demand. */
 
 	stats_tree *st;                 /**< Pointer to the owning statistics tree. */
 
 	/** Tree relationships. */
 	stat_node *parent;              /**< Pointer to parent node. */
 	stat_node *children;            /**< Pointer to first child node. */
+	stat_node *last_child;          /**< Pointer to last child node, for appending. */
 	stat_node *next;                /**< Pointer to next sibling node. */
 
 	range_pair_t *rng;              /**< Optional range constraint for value filtering. */
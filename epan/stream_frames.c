@@ -0,0 +1,283 @@
+/* stream_frames.c
+ * Routines for indexing the frames of streams.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/dfilter/dfilter.h>
+#include <wsutil/app_mem_usage.h>
+
+#include <epan/stream_frames.h>
+
+/* The frames of a stream. */
+typedef struct {
+	uint8_t *deltas;	/* each frame number less the one before, LEB128 */
+	uint32_t len;
+	uint32_t size;
+	uint32_t last_frame;	/* 0 if there are none */
+	uint32_t count;
+} stream_frame_list_t;
+
+struct _stream_frames_table_t {
+	const char *field;
+	wmem_array_t *streams;	/* stream_frame_list_t, by stream index */
+	size_t bytes;
+};
+
+/*
+ * Where a cursor is in a stream's list. The list is looked up each time,
+ * as frames can be added (and the list moved) while a cursor is in use.
+ */
+typedef struct {
+	uint32_t stream;
+	uint32_t offset;
+	uint32_t frame;		/* the last frame read, 0 before the first */
+} stream_frames_iter_t;
+
+struct _stream_frames_cursor_t {
+	const stream_frames_table_t *table;
+	GArray *iters;		/* stream_frames_iter_t */
+	uint32_t last_frame;
+};
+
+static GSList *stream_frames_tables;
+
+stream_frames_table_t *
+stream_frames_register(const char *field)
+{
+	stream_frames_table_t *table = g_new0(stream_frames_table_t, 1);
+
+	table->field = field;
+	stream_frames_tables = g_slist_prepend(stream_frames_tables, table);
+	return table;
+}
+
+void
+stream_frames_add(stream_frames_table_t *table, const packet_info *pinfo,
+    const uint32_t stream)
+{
+	stream_frame_list_t *list;
+	uint32_t delta;
+
+	if (PINFO_FD_VISITED(pinfo) || table->streams == NULL)
+		return;
+
+	/* Stream indexes are handed out in order, so this is rarely more than one. */
+	while (wmem_array_get_count(table->streams) <= stream) {
+		stream_frame_list_t empty = { 0 };
+
+		wmem_array_append_one(table->streams, empty);
+		table->bytes += sizeof(stream_frame_list_t);
+	}
+
+	list = (stream_frame_list_t *)wmem_array_index(table->streams, stream);
+	/* Already recorded, e.g. for another segment in the same frame. */
+	if (pinfo->num <= list->last_frame)
+		return;
+
+	if (list->len + 5 > list->size) {
+		uint32_t size = MAX(16, list->size * 2);
+
+		list->deltas = (uint8_t *)wmem_realloc(wmem_file_scope(), list->deltas, size);
+		table->bytes += size - list->size;
+		list->size = size;
+	}
+	delta = pinfo->num - list->last_frame;
+	while (delta >= 0x80) {
+		list->deltas[list->len++] = (uint8_t)(delta | 0x80);
+		delta >>= 7;
+	}
+	list->deltas[list->len++] = (uint8_t)delta;
+	list->last_frame = pinfo->num;
+	list->count++;
+}
+
+static const stream_frame_list_t *
+stream_frames_list(const stream_frames_table_t *table, const uint32_t stream)
+{
+	if (table->streams == NULL || stream >= wmem_array_get_count(table->streams))
+		return NULL;
+	return (const stream_frame_list_t *)wmem_array_index(table->streams, stream);
+}
+
+uint32_t
+stream_frames_count(const stream_frames_table_t *table, const uint32_t stream)
+{
+	const stream_frame_list_t *list = stream_frames_list(table, stream);
+
+	return list ? list->count : 0;
+}
+
+stream_frames_cursor_t *
+stream_frames_cursor_new(const dfilter_t *df, const uint32_t last_frame)
+{
+	const stream_frames_table_t *best = NULL;
+	const uint32_t *best_values = NULL;
+	unsigned best_num_values = 0;
+	uint64_t best_count = 0;
+	stream_frames_cursor_t *cursor;
+
+	for (GSList *entry = stream_frames_tables; entry != NULL; entry = entry->next) {
+		const stream_frames_table_t *table = (const stream_frames_table_t *)entry->data;
+		const uint32_t *values;
+		unsigned num_values;
+		uint64_t count = 0;
+		int hfid;
+
+		if (table->streams == NULL)
+			continue;
+		hfid = proto_registrar_get_id_byname(table->field);
+		if (hfid < 0 || !dfilter_field_values(df, hfid, &values, &num_values))
+			continue;
+
+		for (unsigned i = 0; i < num_values; i++)
+			count += stream_frames_count(table, values[i]);
+		if (best == NULL || count < best_count) {
+			best = table;
+			best_values = values;
+			best_num_values = num_values;
+			best_count = count;
+		}
+	}
+	if (best == NULL)
+		return NULL;
+
+	cursor = g_new(stream_frames_cursor_t, 1);
+	cursor->table = best;
+	cursor->iters = g_array_sized_new(false, false, sizeof(stream_frames_iter_t), best_num_values);
+	cursor->last_frame = last_frame;
+	for (unsigned i = 0; i < best_num_values; i++) {
+		stream_frames_iter_t iter = { best_values[i], 0, 0 };
+
+		if (stream_frames_count(best, iter.stream) > 0)
+			g_array_append_val(cursor->iters, iter);
+	}
+	return cursor;
+}
+
+bool
+stream_frames_cursor_has(stream_frames_cursor_t *cursor, const uint32_t frame)
+{
+	if (frame > cursor->last_frame)
+		return true;
+
+	for (unsigned i = 0; i < cursor->iters->len; i++) {
+		stream_frames_iter_t *iter = &g_array_index(cursor->iters, stream_frames_iter_t, i);
+		const stream_frame_list_t *list = stream_frames_list(cursor->table, iter->stream);
+
+		if (list == NULL)
+			continue;
+		while (iter->frame < frame && iter->offset < list->len) {
+			uint32_t delta = 0;
+			unsigned shift = 0;
+			uint8_t byte;
+
+			do {
+				byte = list->deltas[iter->offset++];
+				delta |= (uint32_t)(byte & 0x7f) << shift;
+				shift += 7;
+			} while (byte & 0x80);
+			iter->frame += delta;
+		}
+		if (iter->frame == frame)
+			return true;
+	}
+	return false;
+}
+
+void
+stream_frames_cursor_free(stream_frames_cursor_t *cursor)
+{
+	if (cursor) {
+		g_array_free(cursor->iters, true);
+		g_free(cursor);
+	}
+}
+
+size_t
+stream_frames_in_use(void)
+{
+	size_t bytes = 0;
+
+	for (GSList *entry = stream_frames_tables; entry != NULL; entry = entry->next)
+		bytes += ((stream_frames_table_t *)entry->data)->bytes;
+	return bytes;
+}
+
+static const ws_mem_usage_t stream_frames_usage = { "Stream frame indexes", stream_frames_in_use, NULL };
+
+/* Called at the start of each file, in the file scope. */
+static void
+stream_frames_table_init(void *data, void *user_data _U_)
+{
+	stream_frames_table_t *table = (stream_frames_table_t *)data;
+
+	table->streams = wmem_array_new(wmem_file_scope(), sizeof(stream_frame_list_t));
+	table->bytes = 0;
+}
+
+static void
+stream_frames_init_routine(void)
+{
+	g_slist_foreach(stream_frames_tables, stream_frames_table_init, NULL);
+}
+
+/* The lists go with the file scope. */
+static void
+stream_frames_table_reset(void *data, void *user_data _U_)
+{
+	stream_frames_table_t *table = (stream_frames_table_t *)data;
+
+	table->streams = NULL;
+	table->bytes = 0;
+}
+
+static void
+stream_frames_cleanup_routine(void)
+{
+	g_slist_foreach(stream_frames_tables, stream_frames_table_reset, NULL);
+}
+
+void
+stream_frames_init(void)
+{
+	static bool usage_registered;
+
+	register_init_routine(&stream_frames_init_routine);
+	register_cleanup_routine(&stream_frames_cleanup_routine);
+
+	/* epan can be initialized again, but the component is kept forever. */
+	if (!usage_registered) {
+		memory_usage_component_register(&stream_frames_usage);
+		usage_registered = true;
+	}
+}
+
+void
+stream_frames_cleanup(void)
+{
+	g_slist_free_full(stream_frames_tables, g_free);
+	stream_frames_tables = NULL;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
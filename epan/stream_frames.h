@@ -0,0 +1,120 @@
+/** @file
+ * Declarations of routines for indexing the frames of streams.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __STREAM_FRAMES_H__
+#define __STREAM_FRAMES_H__
+
+#include "ws_symbol_export.h"
+#include <epan/packet_info.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A stream frame index lists the frames in which each stream of a
+ * protocol appears, by the stream index field the protocol's dissector
+ * assigns on the first pass ("tcp.stream", "udp.stream" and so on). The
+ * dissector adds each frame with stream_frames_add() wherever it adds the
+ * field, and the lists are kept delta-encoded, so they take a byte or two
+ * per frame.
+ *
+ * A display filter that requires the field to have certain values (e.g.
+ * "tcp.stream eq 5", as used by Follow Stream) can then only match the
+ * frames in those streams' lists; a stream_frames_cursor_t tells which
+ * those are, so a rescan doesn't have to dissect the others.
+ */
+
+typedef struct _stream_frames_table_t stream_frames_table_t;
+
+/**
+ * Register an index. Its lists are freed with the file scope.
+ *
+ * @param field  The abbreviation of the stream index field, which must
+ * be an unsigned integer field added wherever stream_frames_add() is
+ * called, and nowhere else.
+ * @return The index.
+ */
+WS_DLL_PUBLIC stream_frames_table_t *
+stream_frames_register(const char *field);
+
+/**
+ * Record that the current frame is in a stream. Only does anything on
+ * the first pass.
+ */
+WS_DLL_PUBLIC void
+stream_frames_add(stream_frames_table_t *table, const packet_info *pinfo,
+    const uint32_t stream);
+
+/**
+ * Get the number of frames recorded for a stream.
+ */
+WS_DLL_PUBLIC uint32_t
+stream_frames_count(const stream_frames_table_t *table, const uint32_t stream);
+
+/* The frames a display filter can match, going by the stream indexes. */
+typedef struct _stream_frames_cursor_t stream_frames_cursor_t;
+
+/**
+ * Create a cursor over the frames of the streams a display filter
+ * requires (see dfilter_field_values()). If the filter limits the fields
+ * of more than one index, the one with the fewest frames is used.
+ *
+ * @param df  The display filter.
+ * @param last_frame  The last frame the first pass has dissected; later
+ * frames aren't in the lists yet, and might match.
+ * @return The cursor, or NULL if the filter doesn't limit any indexed
+ * field.
+ */
+WS_DLL_PUBLIC stream_frames_cursor_t *
+stream_frames_cursor_new(const struct epan_dfilter *df, const uint32_t last_frame);
+
+/**
+ * Check whether a frame is in one of the cursor's streams. Frames must be
+ * checked in increasing order.
+ *
+ * @return false if the display filter can't match the frame.
+ */
+WS_DLL_PUBLIC bool
+stream_frames_cursor_has(stream_frames_cursor_t *cursor, const uint32_t frame);
+
+WS_DLL_PUBLIC void
+stream_frames_cursor_free(stream_frames_cursor_t *cursor);
+
+/**
+ * Get the number of bytes used by the lists of every index.
+ */
+WS_DLL_PUBLIC size_t
+stream_frames_in_use(void);
+
+extern void
+stream_frames_init(void);
+
+extern void
+stream_frames_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __STREAM_FRAMES_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -27,6 +27,7 @@
 #include <epan/dfilter/dfilter.h>
 #include <epan/tap.h>
 #include <wsutil/wslog.h>
+#include <wsutil/ws_trace.h>
 
 static bool tapping_is_active=false;
 static dfilter_t *main_filter;
@@ -87,15 +88,44 @@ typedef struct _tap_listener_t {
 	unsigned flags;
 	char *fstring;
 	dfilter_t *code;
+	struct _tap_listener_t *filter_owner;	/* earlier listener with the same filter, if any */
+	unsigned filter_serial;	/* tap_push_serial when filter_passed was set */
+	bool filter_passed;
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
 	tap_draw_cb draw;
 	tap_finish_cb finish;
+	tap_retire_cb retire;
+	tap_shard_new_cb shard_new;
+	tap_shard_merge_cb shard_merge;
+	tap_shard_free_cb shard_free;
+	void *shard;		/* from the active shard set, if any */
 } tap_listener_t;
 
+typedef struct _tap_shard_t {
+	void *tapdata;
+	void *shard;
+	tap_shard_merge_cb shard_merge;
+	tap_shard_free_cb shard_free;
+} tap_shard_t;
+
+struct _tap_shard_set_t {
+	GArray *shards;		/* of tap_shard_t */
+};
+
 static tap_listener_t *tap_listener_queue;
 
+/*
+ * Filter results only depend on the packet, so each distinct filter is
+ * applied at most once per tap_push_tapped_queue() call however many
+ * records are queued and however many listeners use it. The serial
+ * number tells the cached results of one push from the next.
+ */
+static unsigned tap_push_serial;
+static unsigned main_filter_serial;
+static bool main_filter_passed;
+
 static GSList *tap_plugins;
 
 #ifdef HAVE_PLUGINS
@@ -315,6 +345,28 @@ tap_queue_init(epan_dissect_t *edt)
 	tap_build_interesting (edt);
 }
 
+static bool
+tap_main_filter_passes(epan_dissect_t *edt)
+{
+	if(main_filter_serial!=tap_push_serial){
+		main_filter_passed=dfilter_apply_edt(main_filter, edt);
+		main_filter_serial=tap_push_serial;
+	}
+	return main_filter_passed;
+}
+
+static bool
+tap_listener_filter_passes(tap_listener_t *tl, epan_dissect_t *edt)
+{
+	tap_listener_t *owner = tl->filter_owner ? tl->filter_owner : tl;
+
+	if(owner->filter_serial!=tap_push_serial){
+		owner->filter_passed=dfilter_apply_edt(owner->code, edt);
+		owner->filter_serial=tap_push_serial;
+	}
+	return owner->filter_passed;
+}
+
 /* this function is called after a packet has been fully dissected to push the tapped
    data to all extensions that has callbacks registered.
 */
@@ -337,6 +389,9 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	tap_push_serial++;
+	WS_TRACE2(tap__push__start, edt->pi.num, tap_packet_index);
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
@@ -369,7 +424,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					unsigned flags = tl->flags;
 					if((tl->flags & TL_LIMIT_TO_DISPLAY_FILTER) && main_filter) {
 
-						if (!dfilter_apply_edt(main_filter, edt)){
+						if (!tap_main_filter_passes(edt)){
 							/* The packet didn't
 							 * pass the filter. */
 							if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
@@ -379,7 +434,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 						}
 					}
 					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+						if (!tap_listener_filter_passes(tl, edt)){
 							/* The packet didn't
 							 * pass the filter. */
 							if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
@@ -392,7 +447,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					/* So call the per-packet routine. */
 					tap_packet_status status;
 
-					status = tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
+					status = tl->packet(tl->shard ? tl->shard : tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
 
 					switch (status) {
 
@@ -411,6 +466,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 			}
 		}
 	}
+	WS_TRACE1(tap__push__done, edt->pi.num);
 }
 
 
@@ -538,6 +594,27 @@ find_tap_id(const char *name)
 	return 0;
 }
 
+/* Point each listener at the first listener with an identical filter, so
+ * that they share its per-packet result. Call after any filter change. */
+static void
+tap_listeners_share_filters(void)
+{
+	tap_listener_t *tl, *other;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		tl->filter_owner=NULL;
+		if(!tl->code){
+			continue;
+		}
+		for(other=tap_listener_queue;other!=tl;other=other->next){
+			if(other->code && !other->filter_owner && !strcmp(other->fstring, tl->fstring)){
+				tl->filter_owner=other;
+				break;
+			}
+		}
+	}
+}
+
 static void
 free_tap_listener(tap_listener_t *tl)
 {
@@ -606,6 +683,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->next=tap_listener_queue;
 
 	tap_listener_queue=tl;
+	tap_listeners_share_filters();
 
 	return NULL;
 }
@@ -646,6 +724,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 		if(fstring){
 			if(!dfilter_compile(fstring, &code, &df_err)){
 				tl->fstring=NULL;
+				tap_listeners_share_filters();
 				error_string = g_string_new("");
 				g_string_printf(error_string,
 						 "Filter \"%s\" is invalid - %s",
@@ -656,6 +735,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 		}
 		tl->fstring=g_strdup(fstring);
 		tl->code=code;
+		tap_listeners_share_filters();
 	}
 
 	return NULL;
@@ -696,6 +776,152 @@ set_tap_flags(void *tapdata, unsigned flags)
 	return NULL;
 }
 
+void
+set_tap_retire(void *tapdata, tap_retire_cb retire)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			tl->retire=retire;
+			break;
+		}
+	}
+}
+
+/* This function is called when state about old frames is dropped, for
+   example by tshark running on a live capture for a long time.
+*/
+void
+retire_tap_listeners(uint32_t before_frame)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->retire){
+			tl->retire(tl->tapdata, before_frame);
+			tl->needs_redraw=true;
+		}
+	}
+}
+
+static tap_listener_t *
+find_tap_listener(void *tapdata)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			return tl;
+		}
+	}
+	return NULL;
+}
+
+void
+set_tap_mergeable(void *tapdata, tap_shard_new_cb shard_new,
+		  tap_shard_merge_cb shard_merge, tap_shard_free_cb shard_free)
+{
+	tap_listener_t *tl=find_tap_listener(tapdata);
+
+	if(tl){
+		tl->shard_new=shard_new;
+		tl->shard_merge=shard_merge;
+		tl->shard_free=shard_free;
+	}
+}
+
+bool
+tap_listeners_mergeable(void)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->packet && !tl->shard_new){
+			return false;
+		}
+	}
+	return true;
+}
+
+tap_shard_set_t *
+tap_shard_set_new(void)
+{
+	tap_shard_set_t *set;
+	tap_listener_t *tl;
+
+	set=g_new(tap_shard_set_t, 1);
+	set->shards=g_array_new(false, false, sizeof(tap_shard_t));
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->shard_new){
+			tap_shard_t shard;
+
+			shard.tapdata=tl->tapdata;
+			shard.shard=tl->shard_new(tl->tapdata);
+			shard.shard_merge=tl->shard_merge;
+			shard.shard_free=tl->shard_free;
+			g_array_append_val(set->shards, shard);
+		}
+	}
+	return set;
+}
+
+void
+tap_shard_set_activate(tap_shard_set_t *set)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		tl->shard=NULL;
+	}
+	if(!set){
+		return;
+	}
+	for(unsigned i=0;i<set->shards->len;i++){
+		tap_shard_t *shard=&g_array_index(set->shards, tap_shard_t, i);
+
+		/* The listener may have been removed since. */
+		tl=find_tap_listener(shard->tapdata);
+		if(tl){
+			tl->shard=shard->shard;
+		}
+	}
+}
+
+static void
+tap_shard_set_release(tap_shard_set_t *set, bool merge)
+{
+	for(unsigned i=0;i<set->shards->len;i++){
+		tap_shard_t *shard=&g_array_index(set->shards, tap_shard_t, i);
+		tap_listener_t *tl=find_tap_listener(shard->tapdata);
+
+		if(tl && tl->shard==shard->shard){
+			tl->shard=NULL;
+		}
+		if(tl && merge){
+			shard->shard_merge(tl->tapdata, shard->shard);
+			tl->needs_redraw=true;
+		}
+		if(shard->shard_free){
+			shard->shard_free(shard->shard);
+		}
+	}
+	g_array_free(set->shards, true);
+	g_free(set);
+}
+
+void
+tap_shard_set_merge(tap_shard_set_t *set)
+{
+	tap_shard_set_release(set, true);
+}
+
+void
+tap_shard_set_free(tap_shard_set_t *set)
+{
+	tap_shard_set_release(set, false);
+}
+
 /* this function recompiles dfilter for all registered tap listeners
  */
 void
@@ -719,6 +945,7 @@ tap_listeners_dfilter_recompile(void)
 		}
 		tl->code=code;
 	}
+	tap_listeners_share_filters();
 }
 
 /* this function removes a tap listener
@@ -749,6 +976,7 @@ remove_tap_listener(void *tapdata)
 			return;
 		}
 	}
+	tap_listeners_share_filters();
 	free_tap_listener(tl);
 }
 
@@ -772,6 +1000,22 @@ tap_listeners_require_dissection(void)
 
 }
 
+bool
+tap_listeners_limited_to(const dfilter_t *df)
+{
+	tap_listener_t *tap_queue = tap_listener_queue;
+
+	while(tap_queue) {
+		if(!(tap_queue->flags & TL_IS_DISSECTOR_HELPER) &&
+		    (tap_queue->code == NULL || !dfilter_implies(tap_queue->code, df)))
+			return false;
+
+		tap_queue = tap_queue->next;
+	}
+
+	return true;
+}
+
 /*
  * Return true if we have one or more tap listeners that require the columns,
  * false otherwise.
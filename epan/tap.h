@@ -34,6 +34,10 @@ typedef void (*tap_reset_cb)(void *tapdata);
 typedef tap_packet_status (*tap_packet_cb)(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data, tap_flags_t flags);
 typedef void (*tap_draw_cb)(void *tapdata);
 typedef void (*tap_finish_cb)(void *tapdata);
+typedef void (*tap_retire_cb)(void *tapdata, uint32_t before_frame);
+typedef void *(*tap_shard_new_cb)(void *tapdata);
+typedef void (*tap_shard_merge_cb)(void *tapdata, void *shard);
+typedef void (*tap_shard_free_cb)(void *shard);
 
 /**
  * Flags to indicate what a tap listener's packet routine requires.
@@ -260,12 +264,77 @@ WS_DLL_PUBLIC void remove_tap_listener(void *tapdata);
 /** This function sets new flags to a tap listener */
 WS_DLL_PUBLIC GString *set_tap_flags(void *tapdata, unsigned flags);
 
+/** This function sets the retire callback of a tap listener.
+ *
+ * @param tapdata The tapdata the listener was registered with.
+ * @param tap_retire void (*retire)(void *tapdata, uint32_t before_frame)
+ *                   Called by retire_tap_listeners() when state about frames
+ *                   before before_frame, and about conversations idle since
+ *                   then, is being dropped; the listener should drop
+ *                   what it keeps about them too, as they won't be seen again.
+ */
+WS_DLL_PUBLIC void set_tap_retire(void *tapdata, tap_retire_cb tap_retire);
+
+/** This function calls the retire callback of all tap listeners that have
+ *  one. It's used when running indefinitely on a live capture, to bound
+ *  the memory used by the listeners.
+ */
+WS_DLL_PUBLIC void retire_tap_listeners(uint32_t before_frame);
+
+/** This function declares a tap listener mergeable: its results for a set
+ *  of packets can be computed in parts, each part from a separate "shard"
+ *  of state, and the shards merged into the listener's own state after.
+ *
+ * @param tapdata The tapdata the listener was registered with.
+ * @param shard_new void *(*shard_new)(void *tapdata)
+ *                  Returns new, empty state, configured like tapdata.
+ *                  The listener's packet callback must accept it in
+ *                  place of tapdata.
+ * @param shard_merge void (*shard_merge)(void *tapdata, void *shard)
+ *                  Adds the results in shard to tapdata. Shards are merged
+ *                  in the order of the packets they saw.
+ * @param shard_free void (*shard_free)(void *shard)
+ *                  Frees a shard, merged or not.
+ */
+WS_DLL_PUBLIC void set_tap_mergeable(void *tapdata, tap_shard_new_cb shard_new,
+    tap_shard_merge_cb shard_merge, tap_shard_free_cb shard_free);
+
+/** Returns true if all tap listeners which have a packet callback are
+ *  mergeable.
+ */
+WS_DLL_PUBLIC bool tap_listeners_mergeable(void);
+
+typedef struct _tap_shard_set_t tap_shard_set_t;
+
+/** Creates a shard for each mergeable tap listener. */
+WS_DLL_PUBLIC tap_shard_set_t *tap_shard_set_new(void);
+
+/** Makes the packets tapped from now on go to the shards in the set, for
+ *  the mergeable listeners; the others still get them directly. NULL makes
+ *  all listeners get them directly again.
+ */
+WS_DLL_PUBLIC void tap_shard_set_activate(tap_shard_set_t *set);
+
+/** Merges the shards in the set into their listeners and frees the set. */
+WS_DLL_PUBLIC void tap_shard_set_merge(tap_shard_set_t *set);
+
+/** Frees the set without merging its shards. */
+WS_DLL_PUBLIC void tap_shard_set_free(tap_shard_set_t *set);
+
 /**
  * Return true if we have one or more tap listeners that require dissection,
  * false otherwise.
  */
 WS_DLL_PUBLIC bool tap_listeners_require_dissection(void);
 
+/**
+ * Return true if every tap listener that requires dissection has a filter
+ * that can only match frames the given filter matches (see
+ * dfilter_implies()), so that frames it can't match needn't be dissected
+ * for the listeners either.
+ */
+WS_DLL_PUBLIC bool tap_listeners_limited_to(const struct epan_dfilter *df);
+
 /**
  * Return true if we have one or more tap listeners that require the columns,
  * false otherwise.
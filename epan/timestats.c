@@ -56,6 +56,29 @@ time_stat_update(timestat_t *stats, const nstime_t *delta, packet_info *pinfo)
 	stats->num++;
 }
 
+/* Add the samples summarized in another timestat_t struct */
+void
+time_stat_merge(timestat_t *stats, const timestat_t *other)
+{
+	if(other->num==0){
+		return;
+	}
+
+	if(stats->num==0 || nstime_cmp(&other->min, &stats->min) < 0){
+		stats->min=other->min;
+		stats->min_num=other->min_num;
+	}
+
+	if(stats->num==0 || nstime_cmp(&other->max, &stats->max) > 0){
+		stats->max=other->max;
+		stats->max_num=other->max_num;
+	}
+
+	nstime_add(&stats->tot, &other->tot);
+
+	stats->num+=other->num;
+}
+
 /*
  * get_average - function
  *
@@ -70,6 +70,59 @@
 
 #define TVBPARSE_MAX_RECURSION_DEPTH 100 // Arbitrary. Matches DAAP and PNIO.
 
+/*
+ * Most rules can only start matching at a few byte values, which are
+ * worked out when the rule is built. one_of uses them to pass over
+ * alternatives without calling them, and until and tvbparse_find() use
+ * them to search for the next place worth trying with ws_mempbrk, which
+ * is vectorized, instead of trying the rule at every offset.
+ */
+#define TVBPARSE_SKIP_MAX_BYTES 16
+
+static void set_first(tvbparse_wanted_t* w, const uint8_t* first) {
+    char needles[TVBPARSE_SKIP_MAX_BYTES + 1];
+    unsigned n = 0;
+    ws_mempbrk_pattern* skip;
+
+    w->first = first;
+    w->skip = NULL;
+
+    if (!first || first[0])
+        return;
+
+    for (unsigned i = 1; i < 256; i++) {
+        if (first[i]) {
+            if (n == TVBPARSE_SKIP_MAX_BYTES)
+                return;
+            needles[n++] = (char)i;
+        }
+    }
+    needles[n] = '\0';
+
+    skip = wmem_new(wmem_epan_scope(), ws_mempbrk_pattern);
+    ws_mempbrk_compile(skip, needles);
+    w->skip = skip;
+}
+
+static void set_first_from(tvbparse_wanted_t* w, const tvbparse_wanted_t* from) {
+    w->first = from->first;
+    w->skip = from->skip;
+}
+
+/*
+ * The first offset from offset, and before end, at which wanted can match,
+ * or the offset after the last one looked at if there is none.
+ */
+static int skip_to_first(tvbparse_t* tt, int offset, int end, const tvbparse_wanted_t* wanted) {
+    unsigned found;
+
+    if (offset >= end || tvb_captured_length_remaining(tt->tvb, offset) <= 0)
+        return offset;
+
+    tvb_ws_mempbrk_uint8_length(tt->tvb, offset, end - offset, wanted->skip, &found, NULL);
+    return (int)found;
+}
+
 static tvbparse_elem_t* new_tok(tvbparse_t* tt,
                                 int id,
                                 int offset,
@@ -157,6 +210,11 @@ tvbparse_wanted_t* tvbparse_char(const int id,
                                  tvbparse_action_t before_cb,
                                  tvbparse_action_t after_cb) {
     tvbparse_wanted_t* w = wmem_new0(wmem_epan_scope(), tvbparse_wanted_t);
+    uint8_t* first = (uint8_t *)wmem_alloc0(wmem_epan_scope(), 256);
+    size_t i;
+
+    for (i = 0; chr[i]; i++)
+        first[(uint8_t)chr[i]] = 1;
 
     w->condition = cond_char;
     w->id = id;
@@ -165,6 +223,7 @@ tvbparse_wanted_t* tvbparse_char(const int id,
     w->data = data;
     w->before = before_cb;
     w->after = after_cb;
+    set_first(w, first);
 
     return w;
 }
@@ -173,6 +232,8 @@ static int cond_chars_common(tvbparse_t* tt, int offset, const tvbparse_wanted_t
     unsigned length = 0;
     int start = offset;
     int left = tt->end_offset - offset;
+    int avail;
+    const uint8_t* ptr;
 
 #ifdef TVBPARSE_DEBUG
     if (TVBPARSE_DEBUG & TVBPARSE_DEBUG_CHARS) ws_warning("cond_chars_common: control='%s'",wanted->control.str);
@@ -183,15 +244,18 @@ static int cond_chars_common(tvbparse_t* tt, int offset, const tvbparse_wanted_t
 
     left = left < (int) wanted->max ? left :  (int) wanted->max;
 
-    while( left > 0 ) {
-        uint8_t t = tvb_get_uint8(tt->tvb,offset++);
-
-        if (!wanted->control.str[t])
-            break;
-
-        length++;
-        left--;
-    };
+    /* Scan what is in the buffer directly. If the run goes on past it,
+       let tvb_get_uint8() throw the exception it always did. */
+    avail = tvb_captured_length_remaining(tt->tvb, offset);
+    avail = avail < left ? avail : left;
+    avail = avail > 0 ? avail : 0;
+    if (avail > 0) {
+        ptr = tvb_get_ptr(tt->tvb, offset, avail);
+        while (length < (unsigned)avail && wanted->control.str[ptr[length]])
+            length++;
+    }
+    if (length == (unsigned)avail && length < (unsigned)left)
+        tvb_get_uint8(tt->tvb, offset + length);
 
     if (length < wanted->min) {
         return  -1;
@@ -229,6 +293,7 @@ tvbparse_wanted_t* tvbparse_chars(const int id,
     w->data = data;
     w->before = before_cb;
     w->after = after_cb;
+    set_first(w, (const uint8_t *)accept_str);
 
     return w;
 }
@@ -272,6 +337,12 @@ tvbparse_wanted_t* tvbparse_not_char(const int id,
                                      tvbparse_action_t before_cb,
                                      tvbparse_action_t after_cb) {
     tvbparse_wanted_t* w = wmem_new0(wmem_epan_scope(), tvbparse_wanted_t);
+    uint8_t* first = (uint8_t *)wmem_alloc(wmem_epan_scope(), 256);
+    size_t i;
+
+    memset(first, 1, 256);
+    for (i = 0; chr[i]; i++)
+        first[(uint8_t)chr[i]] = 0;
 
     w->condition = cond_not_char;
     w->id = id;
@@ -279,6 +350,7 @@ tvbparse_wanted_t* tvbparse_not_char(const int id,
     w->data = data;
     w->before = before_cb;
     w->after = after_cb;
+    set_first(w, first);
 
     return w;
 }
@@ -310,6 +382,7 @@ tvbparse_wanted_t* tvbparse_not_chars(const int id,
     w->data = data;
     w->before = before_cb;
     w->after = after_cb;
+    set_first(w, (const uint8_t *)accept_str);
 
     return w;
 }
@@ -350,6 +423,12 @@ tvbparse_wanted_t* tvbparse_string(const int id,
     w->before = before_cb;
     w->after = after_cb;
 
+    if (w->len > 0) {
+        uint8_t* first = (uint8_t *)wmem_alloc0(wmem_epan_scope(), 256);
+        first[(uint8_t)str[0]] = 1;
+        set_first(w, first);
+    }
+
     return w;
 }
 
@@ -389,11 +468,19 @@ tvbparse_wanted_t* tvbparse_casestring(const int id,
     w->before = before_cb;
     w->after = after_cb;
 
+    if (w->len > 0) {
+        uint8_t* first = (uint8_t *)wmem_alloc0(wmem_epan_scope(), 256);
+        first[(uint8_t)g_ascii_tolower(str[0])] = 1;
+        first[(uint8_t)g_ascii_toupper(str[0])] = 1;
+        set_first(w, first);
+    }
+
     return w;
 }
 
 static int cond_one_of(tvbparse_t* tt, const int offset, const tvbparse_wanted_t * wanted, tvbparse_elem_t** tok) {
     unsigned i;
+    int t = -1;
 #ifdef TVBPARSE_DEBUG
     if (TVBPARSE_DEBUG & TVBPARSE_DEBUG_ONEOF) ws_warning("cond_one_of: START");
 #endif
@@ -404,6 +491,9 @@ static int cond_one_of(tvbparse_t* tt, const int offset, const tvbparse_wanted_t
     if (++tt->recursion_depth > TVBPARSE_MAX_RECURSION_DEPTH)
         return -1;
 
+    if ( offset < tt->end_offset && tvb_offset_exists(tt->tvb, offset) )
+        t = tvb_get_uint8(tt->tvb, offset);
+
     for(i=0; i < wanted->control.elems->len; i++) {
         tvbparse_wanted_t* w = (tvbparse_wanted_t *)g_ptr_array_index(wanted->control.elems,i);
         tvbparse_elem_t* new_elem = NULL;
@@ -412,6 +502,9 @@ static int cond_one_of(tvbparse_t* tt, const int offset, const tvbparse_wanted_t
         if ( offset + w->len > tt->end_offset )
             continue;
 
+        if ( w->first && t >= 0 && !w->first[t] )
+            continue;
+
         curr_len = w->condition(tt, offset, w,  &new_elem);
 
         if (curr_len >= 0) {
@@ -446,6 +539,8 @@ tvbparse_wanted_t* tvbparse_set_oneof(const int id,
     tvbparse_t* el;
     va_list ap;
 
+    uint8_t* first = (uint8_t *)wmem_alloc0(wmem_epan_scope(), 256);
+
     w->condition = cond_one_of;
     w->id = id;
     w->data = data;
@@ -457,11 +552,22 @@ tvbparse_wanted_t* tvbparse_set_oneof(const int id,
     va_start(ap,after_cb);
 
     while(( el = va_arg(ap,tvbparse_t*) )) {
+        const tvbparse_wanted_t* alt = (const tvbparse_wanted_t *)el;
+
         g_ptr_array_add(w->control.elems,el);
+
+        if (first && alt->first) {
+            for (unsigned i = 0; i < 256; i++)
+                first[i] |= alt->first[i] ? 1 : 0;
+        } else {
+            first = NULL;
+        }
     };
 
     va_end(ap);
 
+    set_first(w, first);
+
     return w;
 }
 
@@ -546,6 +652,7 @@ tvbparse_wanted_t* tvbparse_hashed(const int id,
     w->control.hash.table = wmem_map_new(wmem_epan_scope(), g_str_hash,g_str_equal);
     w->control.hash.key = key;
     w->control.hash.other = other;
+    set_first_from(w, key);
 
     va_start(ap,other);
 
@@ -657,6 +764,10 @@ tvbparse_wanted_t* tvbparse_set_seq(const int id,
     };
 
     va_end(ap);
+
+    if (w->control.elems->len > 0)
+        set_first_from(w, (const tvbparse_wanted_t *)g_ptr_array_index(w->control.elems, 0));
+
     return w;
 }
 
@@ -749,6 +860,8 @@ tvbparse_wanted_t* tvbparse_some(const int id,
     w->before = before_cb;
     w->after = after_cb;
     w->control.subelem = el;
+    if (from > 0)
+        set_first_from(w, el);
 
     return w;
 }
@@ -756,8 +869,11 @@ tvbparse_wanted_t* tvbparse_some(const int id,
 
 static int cond_until(tvbparse_t* tt, const int offset, const tvbparse_wanted_t * wanted, tvbparse_elem_t** tok) {
     tvbparse_elem_t* new_elem = NULL;
+    const tvbparse_wanted_t* subelem = wanted->control.until.subelem;
     int len = 0;
     int target_offset = offset;
+    /* The subelement is tried at offset, then up to end_offset - 2. */
+    int limit = MAX(tt->end_offset - 1, offset + 1);
 #ifdef TVBPARSE_DEBUG
     if (TVBPARSE_DEBUG & TVBPARSE_DEBUG_UNTIL) ws_warning("cond_until: START");
 #endif
@@ -769,7 +885,14 @@ static int cond_until(tvbparse_t* tt, const int offset, const tvbparse_wanted_t
         return -1;
 
     do {
-        len = wanted->control.until.subelem->condition(tt, target_offset++, wanted->control.until.subelem,  &new_elem);
+        if (subelem->skip) {
+            target_offset = skip_to_first(tt, target_offset, limit, subelem);
+            if (target_offset >= limit) {
+                len = -1;
+                break;
+            }
+        }
+        len = subelem->condition(tt, target_offset++, subelem,  &new_elem);
     } while(len < 0  && target_offset+1 < tt->end_offset);
 
     tt->recursion_depth--;
@@ -1026,6 +1149,8 @@ tvbparse_elem_t* tvbparse_find(tvbparse_t* tt, const tvbparse_wanted_t* wanted)
 #endif
 
     do {
+        if (wanted->skip)
+            target_offset = skip_to_first(tt, target_offset+1, tt->end_offset, wanted) - 1;
         len = wanted->condition(tt, target_offset+1, wanted,  &tok);
     } while(len < 0  && ++target_offset < tt->end_offset);
 
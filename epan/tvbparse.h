@@ -139,6 +139,13 @@ struct _tvbparse_wanted_t {
 
     tvbparse_action_t before; /**< Action to perform before parsing this element. */
     tvbparse_action_t after;  /**< Action to perform after parsing this element. */
+
+    /**
+     * 256 entries, non-zero for the bytes a match can start with, or NULL
+     * if that is not known. A rule with a set never matches zero bytes.
+     */
+    const uint8_t* first;
+    const ws_mempbrk_pattern* skip; /**< The bytes in first, when there are few enough to search for. */
 };
 
 /**
@@ -811,6 +811,317 @@ zstd_tests (void) {
 	printf ("Skipping ZSTD test. ZSTD is not available.\n");
 #endif
 }
+#define SEARCH_BENCH_SIZE	(1024 * 1024)
+#define SEARCH_BENCH_ROUNDS	16
+
+static double
+search_bench_rate(int64_t start)
+{
+	int64_t elapsed = g_get_monotonic_time() - start;
+
+	if (elapsed <= 0)
+		elapsed = 1;
+	/* bytes per microsecond == MB/s */
+	return (double)SEARCH_BENCH_SIZE * SEARCH_BENCH_ROUNDS / elapsed;
+}
+
+/* Checks the line and byte set searches of tvb, which holds data, and
+ * prints how fast they run. */
+static bool
+search_check(tvbuff_t *tvb, const char *name, const uint8_t *data,
+	     GArray *line_lens, unsigned expected_seps, const ws_mempbrk_pattern *pbrk_sep)
+{
+	unsigned	offset, next_offset, linelen, found_offset, n_lines, n_seps;
+	unsigned char	found_needle;
+	uint8_t		*copy;
+	int64_t		start;
+
+	offset = 0;
+	n_lines = 0;
+	while (tvb_find_line_end_remaining(tvb, offset, &linelen, &next_offset)) {
+		if (n_lines >= line_lens->len ||
+		    linelen != g_array_index(line_lens, unsigned, n_lines)) {
+			printf("Failed TVB=%s line search: line %u at offset %u has length %u\n",
+				name, n_lines, offset, linelen);
+			return false;
+		}
+		n_lines++;
+		offset = next_offset;
+	}
+	if (n_lines != line_lens->len || next_offset != SEARCH_BENCH_SIZE) {
+		printf("Failed TVB=%s line search: found %u lines, expected %u\n",
+			name, n_lines, line_lens->len);
+		return false;
+	}
+
+	offset = 0;
+	n_seps = 0;
+	while (tvb_ws_mempbrk_uint8_remaining(tvb, offset, pbrk_sep, &found_offset, &found_needle)) {
+		if (found_needle != data[found_offset] ||
+		    (found_needle != ';' && found_needle != '=')) {
+			printf("Failed TVB=%s byte set search at offset %u\n", name, found_offset);
+			return false;
+		}
+		n_seps++;
+		offset = found_offset + 1;
+	}
+	if (n_seps != expected_seps) {
+		printf("Failed TVB=%s byte set search: found %u, expected %u\n",
+			name, n_seps, expected_seps);
+		return false;
+	}
+
+	copy = (uint8_t *)tvb_memdup(NULL, tvb, 0, SEARCH_BENCH_SIZE);
+	if (memcmp(copy, data, SEARCH_BENCH_SIZE) != 0) {
+		printf("Failed TVB=%s memdup\n", name);
+		wmem_free(NULL, copy);
+		return false;
+	}
+	wmem_free(NULL, copy);
+	printf("Passed TVB=%s search tests\n", name);
+
+	start = g_get_monotonic_time();
+	for (unsigned round = 0; round < SEARCH_BENCH_ROUNDS; round++) {
+		offset = 0;
+		while (tvb_find_line_end_remaining(tvb, offset, &linelen, &next_offset))
+			offset = next_offset;
+	}
+	printf("Benchmark: TVB=%s tvb_find_line_end_remaining %.1f MB/s\n", name, search_bench_rate(start));
+
+	start = g_get_monotonic_time();
+	for (unsigned round = 0; round < SEARCH_BENCH_ROUNDS; round++) {
+		offset = 0;
+		while (tvb_find_uint8_remaining(tvb, offset, '\n', &found_offset))
+			offset = found_offset + 1;
+	}
+	printf("Benchmark: TVB=%s tvb_find_uint8_remaining %.1f MB/s\n", name, search_bench_rate(start));
+
+	start = g_get_monotonic_time();
+	for (unsigned round = 0; round < SEARCH_BENCH_ROUNDS; round++) {
+		offset = 0;
+		while (tvb_ws_mempbrk_uint8_remaining(tvb, offset, pbrk_sep, &found_offset, &found_needle))
+			offset = found_offset + 1;
+	}
+	printf("Benchmark: TVB=%s tvb_ws_mempbrk_uint8_remaining %.1f MB/s\n", name, search_bench_rate(start));
+
+	return true;
+}
+
+/* Runs search_check() over a text protocol-like buffer long enough to
+ * exercise the vectorized scanners, both as one real tvb and as a
+ * composite of many segments, the way TCP reassembly builds them. */
+static void
+search_tests(void)
+{
+	static const char filler[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ/:.-0123456789";
+	uint8_t		*data;
+	GArray		*line_lens;
+	tvbuff_t	*tvb, *tvb_comp;
+	ws_mempbrk_pattern pbrk_sep;
+	unsigned	offset;
+	unsigned	expected_seps = 0;
+
+	/* Lines of 0 to 299 bytes, mostly ending in CR-LF, with the odd
+	 * ';' and '=' thrown in for the byte set search. */
+	data = (uint8_t *)g_malloc(SEARCH_BENCH_SIZE);
+	line_lens = g_array_new(false, false, sizeof(unsigned));
+	srand(1);
+	offset = 0;
+	while (offset < SEARCH_BENCH_SIZE - 302) {
+		unsigned len = (unsigned)(rand() % 300);
+
+		for (unsigned i = 0; i < len; i++) {
+			int r = rand() % 64;
+
+			if (r == 0)
+				data[offset + i] = ';';
+			else if (r == 1)
+				data[offset + i] = '=';
+			else
+				data[offset + i] = filler[rand() % (sizeof(filler) - 1)];
+			if (r <= 1)
+				expected_seps++;
+		}
+		g_array_append_val(line_lens, len);
+		offset += len;
+		if (rand() % 8 != 0)
+			data[offset++] = '\r';
+		data[offset++] = '\n';
+	}
+	/* Run the last line to the end of the buffer, without an EOL */
+	memset(data + offset, 'x', SEARCH_BENCH_SIZE - offset);
+
+	ws_mempbrk_compile(&pbrk_sep, ";=");
+
+	tvb = tvb_new_real_data(data, SEARCH_BENCH_SIZE, SEARCH_BENCH_SIZE);
+	if (!search_check(tvb, "Real", data, line_lens, expected_seps, &pbrk_sep))
+		failed = true;
+
+	/* Segments of 1 to 1460 bytes, so lines and CR-LF pairs
+	 * straddle member boundaries. */
+	tvb_comp = tvb_new_composite();
+	offset = 0;
+	while (offset < SEARCH_BENCH_SIZE) {
+		unsigned len = MIN((unsigned)(rand() % 1460) + 1, SEARCH_BENCH_SIZE - offset);
+
+		tvb_composite_append(tvb_comp, tvb_new_subset_length(tvb, offset, len));
+		offset += len;
+	}
+	tvb_composite_finalize(tvb_comp);
+	if (!search_check(tvb_comp, "Composite", data, line_lens, expected_seps, &pbrk_sep))
+		failed = true;
+
+	tvb_free_chain(tvb);
+	g_array_free(line_lens, true);
+	g_free(data);
+}
+
+#define BITS_BENCH_SIZE		(64 * 1024)
+#define BITS_BENCH_ROUNDS	16
+
+/* Checks that the bit reader returns the same fields as tvb_get_bits64()
+ * for a tvb starting at a bit offset, then times both. */
+static bool
+bit_reader_check(tvbuff_t *tvb, const char *name, const uint8_t *widths, unsigned n_widths)
+{
+	tvb_bit_reader_t br;
+	unsigned	bit_offset, i, n_fields;
+	uint64_t	expected, got, sum;
+	volatile unsigned long got_ex, expected_ex;
+	int64_t		start;
+	unsigned	total_bits = tvb_captured_length(tvb) * 8;
+
+	/* Fields of 0 to 64 bits, with the odd peek, skip and align. */
+	tvb_bit_reader_init(&br, tvb, 3);
+	bit_offset = 3;
+	for (i = 0; i < n_widths && bit_offset + widths[i] + 8 <= total_bits; i++) {
+		unsigned width = widths[i];
+
+		if (tvb_bit_reader_offset(&br) != bit_offset) {
+			printf("Failed TVB=%s bit reader field %u: offset %u, expected %u\n",
+				name, i, tvb_bit_reader_offset(&br), bit_offset);
+			return false;
+		}
+		expected = width ? tvb_get_bits64(tvb, bit_offset, width, ENC_BIG_ENDIAN) : 0;
+		switch (i % 8) {
+		case 5:
+			got = width <= 32 ? tvb_bit_reader_peek(&br, width) : expected;
+			tvb_bit_reader_skip(&br, width);
+			break;
+		case 7:
+			tvb_bit_reader_align(&br);
+			bit_offset = (bit_offset + 7) & ~7U;
+			expected = width ? tvb_get_bits64(tvb, bit_offset, width, ENC_BIG_ENDIAN) : 0;
+			/* FALLTHROUGH */
+		default:
+			got = tvb_bit_reader_get64(&br, width);
+			break;
+		}
+		if (got != expected) {
+			printf("Failed TVB=%s bit reader field %u (%u bits at %u): 0x%" PRIx64 ", expected 0x%" PRIx64 "\n",
+				name, i, width, bit_offset, got, expected);
+			return false;
+		}
+		bit_offset += width;
+	}
+
+	/* Large skips, up to the last bit. */
+	tvb_bit_reader_init(&br, tvb, 5);
+	tvb_bit_reader_skip(&br, total_bits - 5 - 9);
+	expected = tvb_get_bits64(tvb, total_bits - 9, 9, ENC_BIG_ENDIAN);
+	got = tvb_bit_reader_get(&br, 9);
+	if (got != expected || tvb_bit_reader_bits_left(&br) != 0) {
+		printf("Failed TVB=%s bit reader skip to the end\n", name);
+		return false;
+	}
+
+	/* One bit too many must throw like tvb_get_bits64(). */
+	expected_ex = 0;
+	TRY {
+		tvb_get_bits64(tvb, total_bits, 1, ENC_BIG_ENDIAN);
+	}
+	CATCH_ALL {
+		expected_ex = exc->except_id.except_code;
+	}
+	ENDTRY;
+	got_ex = 0;
+	TRY {
+		tvb_bit_reader_get(&br, 1);
+	}
+	CATCH_ALL {
+		got_ex = exc->except_id.except_code;
+	}
+	ENDTRY;
+	if (got_ex == 0 || got_ex != expected_ex) {
+		printf("Failed TVB=%s bit reader overrun: exception %lu, expected %lu\n",
+			name, got_ex, expected_ex);
+		return false;
+	}
+	printf("Passed TVB=%s bit reader tests\n", name);
+
+	/* Rates in million fields per second, for fields of 1 to 8 bits as
+	 * in PER and CSN.1. */
+	n_fields = 0;
+	sum = 0;
+	start = g_get_monotonic_time();
+	for (unsigned round = 0; round < BITS_BENCH_ROUNDS; round++) {
+		bit_offset = 0;
+		for (i = 0; bit_offset + 8 <= total_bits; i++) {
+			unsigned width = (widths[i % n_widths] & 7) + 1;
+
+			sum += tvb_get_bits8(tvb, bit_offset, width);
+			bit_offset += width;
+			n_fields++;
+		}
+	}
+	printf("Benchmark: TVB=%s tvb_get_bits8 %.1f Mfields/s (%" PRIu64 ")\n",
+		name, (double)n_fields / MAX(g_get_monotonic_time() - start, 1), sum);
+
+	n_fields = 0;
+	sum = 0;
+	start = g_get_monotonic_time();
+	for (unsigned round = 0; round < BITS_BENCH_ROUNDS; round++) {
+		tvb_bit_reader_init(&br, tvb, 0);
+		for (i = 0; tvb_bit_reader_bits_left(&br) >= 8; i++) {
+			unsigned width = (widths[i % n_widths] & 7) + 1;
+
+			sum += tvb_bit_reader_get(&br, width);
+			n_fields++;
+		}
+	}
+	printf("Benchmark: TVB=%s tvb_bit_reader_get %.1f Mfields/s (%" PRIu64 ")\n",
+		name, (double)n_fields / MAX(g_get_monotonic_time() - start, 1), sum);
+
+	return true;
+}
+
+static void
+bit_reader_tests(void)
+{
+	uint8_t		*data;
+	uint8_t		widths[4096];
+	tvbuff_t	*tvb, *tvb_sub;
+
+	data = (uint8_t *)g_malloc(BITS_BENCH_SIZE);
+	srand(2);
+	for (unsigned i = 0; i < BITS_BENCH_SIZE; i++)
+		data[i] = (uint8_t)rand();
+	for (unsigned i = 0; i < array_length(widths); i++)
+		widths[i] = (uint8_t)(rand() % 65);
+
+	tvb = tvb_new_real_data(data, BITS_BENCH_SIZE, BITS_BENCH_SIZE);
+	if (!bit_reader_check(tvb, "Real", widths, array_length(widths)))
+		failed = true;
+
+	/* A subset whose captured data ends before the reported length. */
+	tvb_sub = tvb_new_subset_length_caplen(tvb, 7, BITS_BENCH_SIZE - 107, BITS_BENCH_SIZE - 7);
+	if (!bit_reader_check(tvb_sub, "Subset", widths, array_length(widths)))
+		failed = true;
+
+	tvb_free_chain(tvb);
+	g_free(data);
+}
+
 /* Note: valgrind can be used to check for tvbuff memory leaks */
 int
 main(void)
@@ -823,6 +1134,8 @@ main(void)
 	run_tests();
 	varint_tests();
 	zstd_tests ();
+	search_tests();
+	bit_reader_tests();
 	except_deinit();
 	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -100,4 +100,31 @@ void tvb_validate_offset_length(const tvbuff_t *tvb, const unsigned offset, cons
 void tvb_validate_offset_and_remaining(const tvbuff_t *tvb, const unsigned offset, unsigned *rem_len);
 
 void tvb_check_offset_length(const tvbuff_t *tvb, const int offset, int const length_val, unsigned *offset_ptr, unsigned *length_ptr);
+
+/* Algorithms whose results are kept by tvb_uncompress_cached(). */
+typedef enum {
+	TVB_UNCOMPRESS_ZLIB,
+	TVB_UNCOMPRESS_BROTLI,
+	TVB_UNCOMPRESS_ZSTD,
+	TVB_UNCOMPRESS_SNAPPY,
+	TVB_UNCOMPRESS_LZ77,
+	TVB_UNCOMPRESS_LZ77HUFF,
+	TVB_UNCOMPRESS_LZNT1
+} tvb_uncompress_algo_e;
+
+typedef tvbuff_t *(*tvb_uncompress_func_t)(tvbuff_t *tvb, const unsigned offset, unsigned comprlen);
+
+/* Returns the result of uncompress(tvb, offset, comprlen), taken from or
+ * added to the cache of uncompressed data when that is enabled. */
+tvbuff_t *tvb_uncompress_cached(tvbuff_t *tvb, const unsigned offset, unsigned comprlen,
+    tvb_uncompress_algo_e algo, tvb_uncompress_func_t uncompress);
+
+/* Empties the cache of uncompressed data; called at the end of each file. */
+void tvb_uncompress_cache_clear(void);
+
+/* tvbuffs of up to this size (that is, a subset) are recycled by tvb_new(). */
+#define TVB_CACHE_ITEM_SIZE	(sizeof(struct tvbuff) + sizeof(void *) + 2 * sizeof(unsigned))
+
+/* Frees the calling thread's recycled tvbuffs. */
+void tvb_cache_clear(void);
 #endif
@@ -66,6 +66,31 @@ ensure_contiguous_unsigned(tvbuff_t *tvb, const unsigned offset, const unsigned
 static inline uint8_t *
 tvb_get_raw_string(wmem_allocator_t *scope, tvbuff_t *tvb, const unsigned offset, const unsigned length);
 
+/*
+ * Several subset tvbuffs are created and freed for each layer of every
+ * packet, so freed tvbuffs of up to TVB_CACHE_ITEM_SIZE bytes, which
+ * covers subsets and real data tvbuffs, go on a per-thread free list and
+ * are handed out again by tvb_new() instead of going back to the
+ * allocator. The list is capped so that freeing a long chain after a
+ * big packet doesn't hold on to all of it.
+ */
+#define TVB_CACHE_MAX	1024
+
+static WS_THREAD_LOCAL tvbuff_t *tvb_cache;
+static WS_THREAD_LOCAL unsigned tvb_cache_len;
+
+void
+tvb_cache_clear(void)
+{
+	tvbuff_t *tvb;
+
+	while ((tvb = tvb_cache) != NULL) {
+		tvb_cache = tvb->next;
+		g_free(tvb);
+	}
+	tvb_cache_len = 0;
+}
+
 tvbuff_t *
 tvb_new(const struct tvb_ops *ops)
 {
@@ -74,7 +99,15 @@ tvb_new(const struct tvb_ops *ops)
 
 	ws_assert(size >= sizeof(*tvb));
 
-	tvb = (tvbuff_t *) g_slice_alloc(size);
+	if (size > TVB_CACHE_ITEM_SIZE) {
+		tvb = (tvbuff_t *) g_slice_alloc(size);
+	} else if (tvb_cache != NULL) {
+		tvb = tvb_cache;
+		tvb_cache = tvb->next;
+		tvb_cache_len--;
+	} else {
+		tvb = (tvbuff_t *) g_malloc(TVB_CACHE_ITEM_SIZE);
+	}
 
 	tvb->next		 = NULL;
 	tvb->ops		 = ops;
@@ -102,7 +135,15 @@ tvb_free_internal(tvbuff_t *tvb)
 
 	size = tvb->ops->tvb_size;
 
-	g_slice_free1(size, tvb);
+	if (size > TVB_CACHE_ITEM_SIZE) {
+		g_slice_free1(size, tvb);
+	} else if (tvb_cache_len < TVB_CACHE_MAX) {
+		tvb->next = tvb_cache;
+		tvb_cache = tvb;
+		tvb_cache_len++;
+	} else {
+		g_free(tvb);
+	}
 }
 
 /* XXX: just call tvb_free_chain();
@@ -2546,6 +2587,35 @@ _tvb_get_bits64_le(tvbuff_t *tvb, unsigned bit_offset, const unsigned total_no_o
 	return value;
 }
 
+void
+tvb_bit_reader_init(tvb_bit_reader_t *br, tvbuff_t *tvb, unsigned bit_offset)
+{
+	unsigned offset = bit_offset >> 3;
+
+	DISSECTOR_ASSERT(tvb && tvb->initialized);
+
+	br->tvb = tvb;
+	br->start = offset << 3;
+	br->byte_len = tvb_captured_length_remaining(tvb, offset);
+	br->data = br->byte_len ? ensure_contiguous_unsigned(tvb, offset, br->byte_len) : NULL;
+	br->next_byte = 0;
+	br->cache = 0;
+	br->cache_bits = 0;
+	tvb_bit_reader_skip(br, bit_offset & 7);
+}
+
+void
+tvb_bit_reader_overrun(const tvb_bit_reader_t *br, unsigned no_of_bits)
+{
+	unsigned bit_offset = tvb_bit_reader_offset(br);
+	unsigned octet_offset = bit_offset >> 3;
+
+	/* Let the tvb pick the exception, as for any other access. */
+	tvb_ensure_bytes_exist(br->tvb, octet_offset,
+	    (((bit_offset & 7) + no_of_bits + 7) >> 3));
+	THROW(ReportedBoundsError);
+}
+
 /* Get 1 - 32 bits (should be deprecated as same as tvb_get_bits32??) */
 uint32_t
 tvb_get_bits(tvbuff_t *tvb, const unsigned bit_offset, const unsigned no_of_bits, const unsigned encoding)
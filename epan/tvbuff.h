@@ -2109,6 +2109,153 @@ WS_DEPRECATED_X("Use tvb_get_bits32() instead")
 uint32_t tvb_get_bits(tvbuff_t *tvb, const unsigned bit_offset,
     const unsigned no_of_bits, const unsigned encoding);
 
+/**
+ * @brief Cursor for reading consecutive bit fields from a tvbuff.
+ *
+ * Decoders such as PER and CSN.1 read long runs of small, MSB-first bit
+ * fields. tvb_get_bits8() and friends validate the offset and resolve the
+ * backing data again for every field; the bit reader does that once, when
+ * it is initialized, and then serves reads from a 64-bit cache register
+ * refilled from a contiguous pointer.
+ *
+ * Bits within an octet are numbered from the MSB, as with ENC_BIG_ENDIAN.
+ * Reading past the captured data throws the same exception as the other
+ * accessors would.
+ *
+ * The members are private; use the tvb_bit_reader_* functions.
+ */
+typedef struct {
+    tvbuff_t       *tvb;
+    const uint8_t  *data;       /**< Captured data from the first byte read. */
+    unsigned        start;      /**< Bit offset of data[0] within tvb. */
+    unsigned        byte_len;   /**< Number of bytes available in data. */
+    unsigned        next_byte;  /**< Next byte of data to load into cache. */
+    unsigned        cache_bits; /**< Number of unread bits in cache. */
+    uint64_t        cache;      /**< Unread bits, the next one in the MSB. */
+} tvb_bit_reader_t;
+
+/**
+ * @brief Start reading bits at bit_offset.
+ *
+ * The reader covers the captured data from bit_offset to the end of the tvb.
+ *
+ * @param br          The reader to initialize.
+ * @param tvb         The tvbuff_t to read from.
+ * @param bit_offset  The bit offset within the buffer of the first bit to read.
+ */
+WS_DLL_PUBLIC void tvb_bit_reader_init(tvb_bit_reader_t *br, tvbuff_t *tvb,
+    unsigned bit_offset);
+
+/**
+ * @brief Throw the exception for reading no_of_bits past the end of the reader.
+ *
+ * Used by the inline accessors, not meant to be called directly.
+ */
+WS_DLL_PUBLIC WS_NORETURN void tvb_bit_reader_overrun(const tvb_bit_reader_t *br,
+    unsigned no_of_bits);
+
+/**
+ * @brief Return the current position of the reader as a bit offset within its tvbuff.
+ */
+static inline unsigned tvb_bit_reader_offset(const tvb_bit_reader_t *br) {
+    return br->start + br->next_byte * 8 - br->cache_bits;
+}
+
+/**
+ * @brief Return the number of captured bits left to read.
+ */
+static inline unsigned tvb_bit_reader_bits_left(const tvb_bit_reader_t *br) {
+    return br->cache_bits + (br->byte_len - br->next_byte) * 8;
+}
+
+/* Load whole bytes into the cache until it holds more than 56 bits. */
+static inline void tvb_bit_reader_refill(tvb_bit_reader_t *br) {
+    while (br->cache_bits <= 56 && br->next_byte < br->byte_len) {
+        br->cache |= (uint64_t)br->data[br->next_byte++] << (56 - br->cache_bits);
+        br->cache_bits += 8;
+    }
+}
+
+/**
+ * @brief Return the next 0–32 bits without consuming them.
+ *
+ * @param br          The reader.
+ * @param no_of_bits  The number of bits to return (must be between 0 and 32).
+ *
+ * @return The bits, the first one as the most significant bit of the value.
+ */
+static inline uint32_t tvb_bit_reader_peek(tvb_bit_reader_t *br, unsigned no_of_bits) {
+    if (no_of_bits == 0)
+        return 0;
+    if (br->cache_bits < no_of_bits) {
+        tvb_bit_reader_refill(br);
+        if (br->cache_bits < no_of_bits)
+            tvb_bit_reader_overrun(br, no_of_bits);
+    }
+    return (uint32_t)(br->cache >> (64 - no_of_bits));
+}
+
+/**
+ * @brief Consume 0–64 bits.
+ *
+ * Larger skips, for example over octet strings, are supported as well.
+ */
+static inline void tvb_bit_reader_skip(tvb_bit_reader_t *br, unsigned no_of_bits) {
+    if (no_of_bits > tvb_bit_reader_bits_left(br))
+        tvb_bit_reader_overrun(br, no_of_bits);
+    if (no_of_bits > br->cache_bits) {
+        /* Drop the cache and skip whole bytes in the data. */
+        no_of_bits -= br->cache_bits;
+        br->next_byte += no_of_bits >> 3;
+        br->cache = 0;
+        br->cache_bits = 0;
+        no_of_bits &= 7;
+        tvb_bit_reader_refill(br);
+    }
+    br->cache = no_of_bits < 64 ? br->cache << no_of_bits : 0;
+    br->cache_bits -= no_of_bits;
+}
+
+/**
+ * @brief Read the next 0–32 bits.
+ *
+ * @param br          The reader.
+ * @param no_of_bits  The number of bits to read (must be between 0 and 32).
+ *
+ * @return The bits, the first one as the most significant bit of the value.
+ */
+static inline uint32_t tvb_bit_reader_get(tvb_bit_reader_t *br, unsigned no_of_bits) {
+    uint32_t value = tvb_bit_reader_peek(br, no_of_bits);
+
+    br->cache <<= no_of_bits;
+    br->cache_bits -= no_of_bits;
+    return value;
+}
+
+/**
+ * @brief Read the next 0–64 bits.
+ *
+ * @param br          The reader.
+ * @param no_of_bits  The number of bits to read (must be between 0 and 64).
+ *
+ * @return The bits, the first one as the most significant bit of the value.
+ */
+static inline uint64_t tvb_bit_reader_get64(tvb_bit_reader_t *br, unsigned no_of_bits) {
+    if (no_of_bits <= 32)
+        return tvb_bit_reader_get(br, no_of_bits);
+    if (no_of_bits > tvb_bit_reader_bits_left(br))
+        tvb_bit_reader_overrun(br, no_of_bits);
+    uint64_t value = (uint64_t)tvb_bit_reader_get(br, no_of_bits - 32) << 32;
+    return value | tvb_bit_reader_get(br, 32);
+}
+
+/**
+ * @brief Advance to the next octet boundary, as for aligned PER.
+ */
+static inline void tvb_bit_reader_align(tvb_bit_reader_t *br) {
+    tvb_bit_reader_skip(br, br->cache_bits & 7);
+}
+
 /**
  * @brief Copy a range of bytes from a tvbuff into a pre-allocated target buffer.
  *
@@ -18,6 +18,7 @@
 #endif
 
 #include "tvbuff.h"
+#include "tvbuff-int.h"
 
 #ifdef HAVE_BROTLI
 
@@ -45,8 +46,8 @@ brotli_g_free_wrapper(void *opaque _U_, void *address)
  * succeeded or NULL if uncompression failed.
  */
 
-tvbuff_t *
-tvb_uncompress_brotli(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+static tvbuff_t *
+uncompress_brotli(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 {
     uint8_t             *compr;
     uint8_t             *uncompr        = NULL;
@@ -162,13 +163,19 @@ cleanup:
     return NULL;
 }
 #else
-tvbuff_t *
-tvb_uncompress_brotli(tvbuff_t *tvb _U_, const unsigned offset _U_, unsigned comprlen _U_)
+static tvbuff_t *
+uncompress_brotli(tvbuff_t *tvb _U_, const unsigned offset _U_, unsigned comprlen _U_)
 {
     return NULL;
 }
 #endif
 
+tvbuff_t *
+tvb_uncompress_brotli(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+{
+    return tvb_uncompress_cached(tvb, offset, comprlen, TVB_UNCOMPRESS_BROTLI, uncompress_brotli);
+}
+
 tvbuff_t *
 tvb_child_uncompress_brotli(tvbuff_t *parent, tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 {
@@ -24,42 +24,14 @@ typedef struct {
 	unsigned end_offset;
 } tvb_comp_member_t;
 
-static int
-tvb_comp_off_compare(const void *a, const void *b, void *user_data)
-{
-	tvb_comp_member_t* off_a = (tvb_comp_member_t*)a;
-	tvb_comp_member_t* off_b = (tvb_comp_member_t*)b;
-	tvb_comp_member_t* key = (tvb_comp_member_t*)user_data;
-
-	if (off_a->end_offset < off_b->end_offset)
-		return -1;
-	else if (off_a->end_offset > off_b->end_offset)
-		return 1;
-
-	/* This is a hack to ensure that in cases of ties, key is always
-	 * sorted first. This ensures that g_sequence_search returns an
-	 * iterator pointing to the tvb in the sequence with a matching
-	 * offset instead of the node after it. (It would be simpler but
-	 * somewhat slower to have the natural comparison function and
-	 * call g_sequence_lookup followed by g_sequence_search in case
-	 * of failure.)
-	 *
-	 * If we allowed zero length TVBs to be part of the composite,
-	 * we might have to search through all the TVBs with the same
-	 * end_offset to find the right one. (Or maybe we could just
-	 * no-op and not add the zero length TVBs?)
-	 */
-	if (off_a == key) {
-		return -1;
-	} else if (off_b == key) {
-		return 1;
-	}
-	return 0;
-}
-
 typedef struct {
+	/* Members as they are appended or prepended. */
 	GSequence	*tvbs;
 
+	/* Once finalized, the members in order. end_offset increases
+	 * strictly, so a member can be found by binary search. */
+	tvb_comp_member_t *members;
+	unsigned	num_members;
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -74,7 +46,9 @@ composite_free(tvbuff_t *tvb)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	g_sequence_free(composite->tvbs);
+	if (composite->tvbs)
+		g_sequence_free(composite->tvbs);
+	g_free(composite->members);
 
 	g_free((void *)tvb->real_data);
 }
@@ -85,6 +59,25 @@ composite_offset(const tvbuff_t *tvb _U_, const unsigned counter)
 	return counter;
 }
 
+/* Returns the index of the member holding abs_offset, or num_members
+ * if abs_offset is the end of the composite. */
+static unsigned
+composite_find_member(const tvb_comp_t *composite, unsigned abs_offset)
+{
+	unsigned low = 0;
+	unsigned high = composite->num_members;
+
+	while (low < high) {
+		unsigned mid = low + (high - low) / 2;
+
+		if (composite->members[mid].end_offset < abs_offset)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
 static const uint8_t*
 composite_get_ptr(tvbuff_t *tvb, unsigned abs_offset, unsigned abs_length)
 {
@@ -93,6 +86,7 @@ composite_get_ptr(tvbuff_t *tvb, unsigned abs_offset, unsigned abs_length)
 	tvb_comp_member_t *member = NULL;
 	tvbuff_t   *member_tvb = NULL;
 	unsigned	member_offset;
+	unsigned	i;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
@@ -100,16 +94,15 @@ composite_get_ptr(tvbuff_t *tvb, unsigned abs_offset, unsigned abs_length)
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
 
-	tvb_comp_member_t key = { .end_offset = abs_offset };
-	GSequenceIter *iter = g_sequence_search(composite->tvbs, &key, tvb_comp_off_compare, &key);
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (g_sequence_iter_is_end(iter)) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return (const uint8_t*)"";
 	}
 
-	member = (tvb_comp_member_t *)g_sequence_get(iter);
+	member = &composite->members[i];
 	member_tvb = member->tvb;
 	member_offset = abs_offset - member->start_offset;
 
@@ -121,6 +114,9 @@ composite_get_ptr(tvbuff_t *tvb, unsigned abs_offset, unsigned abs_length)
 		return tvb_get_ptr(member_tvb, member_offset, abs_length);
 	}
 	else {
+		/* The caller wants contiguous memory across members, which
+		 * is the one time we flatten the composite. Searches and
+		 * copies work member by member and never get here. */
 		/* Use a temporary variable as tvb_memcpy is also checking tvb->real_data pointer */
 		void *real_data = g_malloc(tvb->length);
 		tvb_memcpy(tvb, real_data, 0, tvb->length);
@@ -141,6 +137,7 @@ composite_memcpy(tvbuff_t *tvb, void* _target, unsigned abs_offset, unsigned abs
 	tvb_comp_member_t *member = NULL;
 	tvbuff_t   *member_tvb = NULL;
 	unsigned	    member_offset, member_length;
+	unsigned	i;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
@@ -148,16 +145,15 @@ composite_memcpy(tvbuff_t *tvb, void* _target, unsigned abs_offset, unsigned abs
 	 * is contiguous inside one of the member tvbuffs */
 	composite   = &composite_tvb->composite;
 
-	tvb_comp_member_t key = { .end_offset = abs_offset };
-	GSequenceIter *iter = g_sequence_search(composite->tvbs, &key, tvb_comp_off_compare, &key);
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (g_sequence_iter_is_end(iter)) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
-	member = (tvb_comp_member_t *)g_sequence_get(iter);
+	member = &composite->members[i];
 	member_tvb = member->tvb;
 	member_offset = abs_offset - member->start_offset;
 
@@ -189,12 +185,12 @@ composite_memcpy(tvbuff_t *tvb, void* _target, unsigned abs_offset, unsigned abs
 
 			if (!abs_length)
 				break;
-			iter = g_sequence_iter_next(iter);
 			/* tvb_memcpy calls check_offset_length and so there
 			 * should be enough captured length to copy. */
-			DISSECTOR_ASSERT(!g_sequence_iter_is_end(iter));
+			i++;
+			DISSECTOR_ASSERT(i < composite->num_members);
 
-			member = (tvb_comp_member_t *)g_sequence_get(iter);
+			member = &composite->members[i];
 			member_tvb = member->tvb;
 			member_offset = 0;
 		}
@@ -205,6 +201,66 @@ composite_memcpy(tvbuff_t *tvb, void* _target, unsigned abs_offset, unsigned abs
 	DISSECTOR_ASSERT_NOT_REACHED();
 }
 
+static bool
+composite_find_uint8(tvbuff_t *tvb, unsigned abs_offset, unsigned limit, uint8_t needle, unsigned *found_offset)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	tvb_comp_member_t *member;
+	unsigned	member_offset, member_length, member_found;
+	unsigned	i;
+
+	if (found_offset)
+		*found_offset = abs_offset + limit;
+
+	/* Search each member in place rather than flattening the
+	 * composite for the generic search. */
+	for (i = composite_find_member(composite, abs_offset);
+	     limit && i < composite->num_members; i++) {
+		member = &composite->members[i];
+		member_offset = abs_offset - member->start_offset;
+		member_length = MIN(member->end_offset - abs_offset + 1, limit);
+
+		if (tvb_find_uint8_length(member->tvb, member_offset, member_length, needle, &member_found)) {
+			if (found_offset)
+				*found_offset = member->start_offset + member_found;
+			return true;
+		}
+		abs_offset += member_length;
+		limit -= member_length;
+	}
+	return false;
+}
+
+static bool
+composite_pbrk_uint8(tvbuff_t *tvb, unsigned abs_offset, unsigned limit, const ws_mempbrk_pattern* pattern, unsigned *found_offset, unsigned char *found_needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	tvb_comp_member_t *member;
+	unsigned	member_offset, member_length, member_found;
+	unsigned	i;
+
+	if (found_offset)
+		*found_offset = abs_offset + limit;
+
+	for (i = composite_find_member(composite, abs_offset);
+	     limit && i < composite->num_members; i++) {
+		member = &composite->members[i];
+		member_offset = abs_offset - member->start_offset;
+		member_length = MIN(member->end_offset - abs_offset + 1, limit);
+
+		if (tvb_ws_mempbrk_uint8_length(member->tvb, member_offset, member_length, pattern, &member_found, found_needle)) {
+			if (found_offset)
+				*found_offset = member->start_offset + member_found;
+			return true;
+		}
+		abs_offset += member_length;
+		limit -= member_length;
+	}
+	return false;
+}
+
 static const struct tvb_ops tvb_composite_ops = {
 	sizeof(struct tvb_composite), /* size */
 
@@ -212,10 +268,8 @@ static const struct tvb_ops tvb_composite_ops = {
 	composite_offset,     /* offset */
 	composite_get_ptr,    /* get_ptr */
 	composite_memcpy,     /* memcpy */
-	/* XXX - The generic find routines work, but specialized ones
-	 * might be able to avoid some memcpys */
-	NULL,                 /* find_uint8 XXX */
-	NULL,                 /* pbrk_uint8 XXX */
+	composite_find_uint8, /* find_uint8 */
+	composite_pbrk_uint8, /* pbrk_uint8 */
 	NULL,                 /* clone */
 };
 
@@ -239,6 +293,8 @@ tvb_new_composite(void)
 	tvb_comp_t *composite = &composite_tvb->composite;
 
 	composite->tvbs		 = g_sequence_new(g_free);
+	composite->members	 = NULL;
+	composite->num_members	 = 0;
 
 	return tvb;
 }
@@ -328,10 +384,14 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	/* Record the offsets - we have to do that now because it's possible
 	 * to prepend TVBs. Note that the GSequence is already sorted according
 	 * to these offsets, we're just noting them, so we don't need to sort.
+	 * The members move to a flat array, which is cheaper to search.
 	 */
+	composite->members = g_new(tvb_comp_member_t, num_members);
+	composite->num_members = num_members;
 	GSequenceIter *iter = g_sequence_get_begin_iter(composite->tvbs);
 	for (i=0; i < num_members; i++, iter=g_sequence_iter_next(iter)) {
-		member = (tvb_comp_member_t *)g_sequence_get(iter);
+		member = &composite->members[i];
+		*member = *(tvb_comp_member_t *)g_sequence_get(iter);
 		member_tvb = member->tvb;
 		member->start_offset = tvb->length;
 		tvb->length += member_tvb->length;
@@ -342,6 +402,8 @@ tvb_composite_finalize(tvbuff_t *tvb)
 		tvb->contained_length += member_tvb->contained_length;
 		member->end_offset = tvb->length - 1;
 	}
+	g_sequence_free(composite->tvbs);
+	composite->tvbs = NULL;
 
 	tvb->initialized = true;
 	tvb->ds_tvb = tvb;
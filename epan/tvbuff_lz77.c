@@ -12,6 +12,7 @@
 #include <glib.h>
 #include <epan/exceptions.h>
 #include <epan/tvbuff.h>
+#include <epan/tvbuff-int.h>
 #include <epan/wmem_scopes.h>
 
 #define MAX_INPUT_SIZE (16*1024*1024) /* 16MB */
@@ -93,8 +94,8 @@ static bool do_uncompress(tvbuff_t *tvb, int offset, int in_size,
 	return true;
 }
 
-tvbuff_t *
-tvb_uncompress_lz77(tvbuff_t *tvb, const unsigned offset, unsigned in_size)
+static tvbuff_t *
+uncompress_lz77(tvbuff_t *tvb, const unsigned offset, unsigned in_size)
 {
 	volatile bool ok = false;
 	wmem_allocator_t *pool;
@@ -132,6 +133,12 @@ tvb_uncompress_lz77(tvbuff_t *tvb, const unsigned offset, unsigned in_size)
 	return out;
 }
 
+tvbuff_t *
+tvb_uncompress_lz77(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+{
+	return tvb_uncompress_cached(tvb, offset, comprlen, TVB_UNCOMPRESS_LZ77, uncompress_lz77);
+}
+
 tvbuff_t *
 tvb_child_uncompress_lz77(tvbuff_t *parent, tvbuff_t *tvb, const unsigned offset, unsigned in_size)
 {
@@ -21,6 +21,7 @@
 #include <stdlib.h> /* qsort */
 #include <epan/exceptions.h>
 #include <epan/tvbuff.h>
+#include <epan/tvbuff-int.h>
 #include <epan/wmem_scopes.h>
 
 #define MAX_INPUT_SIZE (16*1024*1024) /* 16MB */
@@ -356,8 +357,8 @@ static bool do_uncompress(struct input *input,
 	return true;
 }
 
-tvbuff_t *
-tvb_uncompress_lz77huff(tvbuff_t *tvb,
+static tvbuff_t *
+uncompress_lz77huff(tvbuff_t *tvb,
 			const unsigned offset,
 			unsigned input_size)
 {
@@ -402,6 +403,12 @@ tvb_uncompress_lz77huff(tvbuff_t *tvb,
 	return out;
 }
 
+tvbuff_t *
+tvb_uncompress_lz77huff(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+{
+	return tvb_uncompress_cached(tvb, offset, comprlen, TVB_UNCOMPRESS_LZ77HUFF, uncompress_lz77huff);
+}
+
 tvbuff_t *
 tvb_child_uncompress_lz77huff(tvbuff_t *parent, tvbuff_t *tvb, const unsigned offset, unsigned in_size)
 {
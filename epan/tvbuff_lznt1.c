@@ -16,6 +16,7 @@
 #include <glib.h>
 #include <epan/exceptions.h>
 #include <epan/tvbuff.h>
+#include <epan/tvbuff-int.h>
 #include <epan/wmem_scopes.h>
 
 #define MAX_INPUT_SIZE (16*1024*1024) /* 16MB */
@@ -114,8 +115,8 @@ do_uncompress(tvbuff_t *tvb, int offset, int in_size, wmem_array_t *obuf)
 	return true;
 }
 
-tvbuff_t *
-tvb_uncompress_lznt1(tvbuff_t *tvb, const unsigned offset, unsigned in_size)
+static tvbuff_t *
+uncompress_lznt1(tvbuff_t *tvb, const unsigned offset, unsigned in_size)
 {
 	volatile bool ok = false;
 	wmem_allocator_t *pool;
@@ -153,6 +154,12 @@ tvb_uncompress_lznt1(tvbuff_t *tvb, const unsigned offset, unsigned in_size)
 	return out;
 }
 
+tvbuff_t *
+tvb_uncompress_lznt1(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+{
+	return tvb_uncompress_cached(tvb, offset, comprlen, TVB_UNCOMPRESS_LZNT1, uncompress_lznt1);
+}
+
 tvbuff_t *
 tvb_child_uncompress_lznt1(tvbuff_t *parent, tvbuff_t *tvb, const unsigned offset, unsigned in_size)
 {
@@ -23,6 +23,8 @@ struct tvb_real {
 	tvbuff_free_cb_t	free_cb;
 };
 
+G_STATIC_ASSERT(sizeof(struct tvb_real) <= TVB_CACHE_ITEM_SIZE);
+
 static void
 real_free(tvbuff_t *tvb)
 {
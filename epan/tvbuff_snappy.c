@@ -14,6 +14,7 @@
 #endif
 
 #include "tvbuff.h"
+#include "tvbuff-int.h"
 
 #ifdef HAVE_SNAPPY
 
@@ -23,8 +24,8 @@
  * succeeded or NULL if uncompression failed.
  */
 
-tvbuff_t *
-tvb_uncompress_snappy(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+static tvbuff_t *
+uncompress_snappy(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 {
     tvbuff_t *uncompr_tvb = NULL;
     unsigned char *decompressed_buffer = NULL;
@@ -55,13 +56,19 @@ tvb_uncompress_snappy(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
     return uncompr_tvb;
 }
 #else
-tvbuff_t *
-tvb_uncompress_snappy(tvbuff_t *tvb _U_, const unsigned offset _U_, unsigned comprlen _U_)
+static tvbuff_t *
+uncompress_snappy(tvbuff_t *tvb _U_, const unsigned offset _U_, unsigned comprlen _U_)
 {
     return NULL;
 }
 #endif
 
+tvbuff_t *
+tvb_uncompress_snappy(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+{
+    return tvb_uncompress_cached(tvb, offset, comprlen, TVB_UNCOMPRESS_SNAPPY, uncompress_snappy);
+}
+
 tvbuff_t *
 tvb_child_uncompress_snappy(tvbuff_t *parent, tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 {
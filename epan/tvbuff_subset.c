@@ -33,6 +33,9 @@ struct tvb_subset {
 	tvb_backing_t	subset;
 };
 
+/* Subsets are the most common tvbuffs, and are recycled by tvb_new(). */
+G_STATIC_ASSERT(sizeof(struct tvb_subset) <= TVB_CACHE_ITEM_SIZE);
+
 static unsigned
 subset_offset(const tvbuff_t *tvb, const unsigned counter)
 {
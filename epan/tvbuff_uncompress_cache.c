@@ -0,0 +1,247 @@
+/* tvbuff_uncompress_cache.c
+ * Cache of the results of the tvb_uncompress_* functions
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Dissectors uncompress a payload each time its frame is dissected, so
+ * going back and forth over a frame with a large compressed body redoes
+ * the work every time. The tvbuff layer does not know which frame it is
+ * working for, so results are looked up by algorithm and by the
+ * compressed bytes themselves; a hit is always verified against a copy
+ * of those bytes, and identical payloads in different frames share an
+ * entry.
+ *
+ * Entries are kept on an LRU list within the "protocols.uncompress_cache_size"
+ * budget. A tvbuff handed out for an entry holds a reference to it, so an
+ * entry evicted while a tree still refers to it is freed once that tvbuff
+ * is.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "tvbuff.h"
+#include "tvbuff-int.h"
+#include "prefs.h"
+
+/* Smaller results are cheaper to recompute than to look up and keep. */
+#define UNCOMPRESS_CACHE_MIN_LEN	4096
+
+/* Bytes hashed at each end of the compressed data. */
+#define UNCOMPRESS_CACHE_HASH_LEN	512
+
+typedef struct uncompress_cache_entry {
+	GList		link;		/* in uncompress_lru, most recent first */
+	uint32_t	hash;
+	tvb_uncompress_algo_e algo;
+	unsigned	comprlen;
+	unsigned	uncomprlen;
+	unsigned	refcount;	/* the cache's, plus one per tvbuff */
+	const uint8_t	*compr;
+	/* Followed by the uncompressed data, then the compressed data. */
+} uncompress_cache_entry_t;
+
+#define ENTRY_DATA(entry)	((uint8_t *)((entry) + 1))
+
+static GHashTable *uncompress_cache;
+static GQueue uncompress_lru = G_QUEUE_INIT;
+static size_t uncompress_cache_bytes;
+static GMutex uncompress_cache_mutex;
+
+static uint32_t
+uncompress_cache_hash_bytes(tvb_uncompress_algo_e algo, const uint8_t *compr, unsigned comprlen)
+{
+	uint32_t hash = 2166136261U ^ (uint32_t)algo;
+	unsigned head = MIN(comprlen, UNCOMPRESS_CACHE_HASH_LEN);
+	unsigned tail;
+
+	hash = (hash ^ comprlen) * 16777619U;
+	for (unsigned i = 0; i < head; i++)
+		hash = (hash ^ compr[i]) * 16777619U;
+	if (comprlen > 2 * UNCOMPRESS_CACHE_HASH_LEN)
+		tail = comprlen - UNCOMPRESS_CACHE_HASH_LEN;
+	else
+		tail = head;
+	for (unsigned i = tail; i < comprlen; i++)
+		hash = (hash ^ compr[i]) * 16777619U;
+
+	return hash;
+}
+
+static unsigned
+uncompress_cache_hash(const void *key)
+{
+	return ((const uncompress_cache_entry_t *)key)->hash;
+}
+
+static gboolean
+uncompress_cache_equal(const void *a, const void *b)
+{
+	const uncompress_cache_entry_t *entry_a = (const uncompress_cache_entry_t *)a;
+	const uncompress_cache_entry_t *entry_b = (const uncompress_cache_entry_t *)b;
+
+	return entry_a->hash == entry_b->hash &&
+	    entry_a->algo == entry_b->algo &&
+	    entry_a->comprlen == entry_b->comprlen &&
+	    memcmp(entry_a->compr, entry_b->compr, entry_a->comprlen) == 0;
+}
+
+static size_t
+uncompress_cache_entry_size(const uncompress_cache_entry_t *entry)
+{
+	return sizeof(*entry) + entry->uncomprlen + entry->comprlen;
+}
+
+/* Called with the mutex held. */
+static void
+uncompress_cache_entry_unref(uncompress_cache_entry_t *entry)
+{
+	if (--entry->refcount == 0)
+		g_free(entry);
+}
+
+/* Called with the mutex held. */
+static void
+uncompress_cache_evict(uncompress_cache_entry_t *entry)
+{
+	g_hash_table_remove(uncompress_cache, entry);
+	g_queue_unlink(&uncompress_lru, &entry->link);
+	uncompress_cache_bytes -= uncompress_cache_entry_size(entry);
+	uncompress_cache_entry_unref(entry);
+}
+
+static void
+uncompress_cache_release(void *data)
+{
+	uncompress_cache_entry_t *entry = ((uncompress_cache_entry_t *)data) - 1;
+
+	g_mutex_lock(&uncompress_cache_mutex);
+	uncompress_cache_entry_unref(entry);
+	g_mutex_unlock(&uncompress_cache_mutex);
+}
+
+/* Called with the mutex held. */
+static tvbuff_t *
+uncompress_cache_new_tvb(uncompress_cache_entry_t *entry)
+{
+	tvbuff_t *tvb;
+
+	entry->refcount++;
+	tvb = tvb_new_real_data(ENTRY_DATA(entry), entry->uncomprlen, entry->uncomprlen);
+	tvb_set_free_cb(tvb, uncompress_cache_release);
+	return tvb;
+}
+
+static size_t
+uncompress_cache_budget(void)
+{
+	return (size_t)prefs.uncompress_cache_size * 1024 * 1024;
+}
+
+tvbuff_t *
+tvb_uncompress_cached(tvbuff_t *tvb, const unsigned offset, unsigned comprlen,
+    tvb_uncompress_algo_e algo, tvb_uncompress_func_t uncompress)
+{
+	uncompress_cache_entry_t key, *entry, *existing;
+	tvbuff_t *uncompr_tvb;
+	unsigned uncomprlen;
+	size_t budget = uncompress_cache_budget();
+
+	if (budget == 0 || tvb == NULL || comprlen == 0 ||
+	    !tvb_bytes_exist(tvb, offset, comprlen))
+		return uncompress(tvb, offset, comprlen);
+
+	key.compr = tvb_get_ptr(tvb, offset, comprlen);
+	key.algo = algo;
+	key.comprlen = comprlen;
+	key.hash = uncompress_cache_hash_bytes(algo, key.compr, comprlen);
+
+	g_mutex_lock(&uncompress_cache_mutex);
+	if (uncompress_cache != NULL &&
+	    (entry = (uncompress_cache_entry_t *)g_hash_table_lookup(uncompress_cache, &key)) != NULL) {
+		g_queue_unlink(&uncompress_lru, &entry->link);
+		g_queue_push_head_link(&uncompress_lru, &entry->link);
+		uncompr_tvb = uncompress_cache_new_tvb(entry);
+		g_mutex_unlock(&uncompress_cache_mutex);
+		return uncompr_tvb;
+	}
+	g_mutex_unlock(&uncompress_cache_mutex);
+
+	uncompr_tvb = uncompress(tvb, offset, comprlen);
+	if (uncompr_tvb == NULL)
+		return NULL;
+
+	uncomprlen = tvb_captured_length(uncompr_tvb);
+	if (uncomprlen < UNCOMPRESS_CACHE_MIN_LEN ||
+	    uncomprlen != tvb_reported_length(uncompr_tvb) ||
+	    sizeof(*entry) + uncomprlen + comprlen > budget)
+		return uncompr_tvb;
+
+	entry = (uncompress_cache_entry_t *)g_malloc(sizeof(*entry) + uncomprlen + comprlen);
+	memset(&entry->link, 0, sizeof(entry->link));
+	entry->link.data = entry;
+	entry->hash = key.hash;
+	entry->algo = algo;
+	entry->comprlen = comprlen;
+	entry->uncomprlen = uncomprlen;
+	entry->refcount = 1;
+	tvb_memcpy(uncompr_tvb, ENTRY_DATA(entry), 0, uncomprlen);
+	memcpy(ENTRY_DATA(entry) + uncomprlen, key.compr, comprlen);
+	entry->compr = ENTRY_DATA(entry) + uncomprlen;
+	tvb_free(uncompr_tvb);
+
+	g_mutex_lock(&uncompress_cache_mutex);
+	if (uncompress_cache == NULL)
+		uncompress_cache = g_hash_table_new(uncompress_cache_hash, uncompress_cache_equal);
+	while (uncompress_cache_bytes + uncompress_cache_entry_size(entry) > budget)
+		uncompress_cache_evict((uncompress_cache_entry_t *)g_queue_peek_tail(&uncompress_lru));
+	/*
+	 * Another thread may have added the same data meanwhile; replacing
+	 * its entry only costs the copy made above.
+	 */
+	existing = (uncompress_cache_entry_t *)g_hash_table_lookup(uncompress_cache, entry);
+	if (existing != NULL)
+		uncompress_cache_evict(existing);
+	g_hash_table_add(uncompress_cache, entry);
+	g_queue_push_head_link(&uncompress_lru, &entry->link);
+	uncompress_cache_bytes += uncompress_cache_entry_size(entry);
+	uncompr_tvb = uncompress_cache_new_tvb(entry);
+	g_mutex_unlock(&uncompress_cache_mutex);
+
+	return uncompr_tvb;
+}
+
+void
+tvb_uncompress_cache_clear(void)
+{
+	g_mutex_lock(&uncompress_cache_mutex);
+	while (!g_queue_is_empty(&uncompress_lru))
+		uncompress_cache_evict((uncompress_cache_entry_t *)g_queue_peek_tail(&uncompress_lru));
+	if (uncompress_cache != NULL) {
+		g_hash_table_destroy(uncompress_cache);
+		uncompress_cache = NULL;
+	}
+	g_mutex_unlock(&uncompress_cache_mutex);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -19,6 +19,7 @@
 #include <wsutil/zlib_compat.h>
 
 #include "tvbuff.h"
+#include "tvbuff-int.h"
 #include <wsutil/wslog.h>
 
 #ifdef USE_ZLIB_OR_ZLIBNG
@@ -30,8 +31,8 @@
 #define TVB_Z_MIN_BUFSIZ 32768
 #define TVB_Z_MAX_BUFSIZ 1048576 * 10
 
-tvbuff_t *
-tvb_uncompress_zlib(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+static tvbuff_t *
+uncompress_zlib(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 {
 	int        err;
 	/* bytes_out is an unsigned because tvb_new_real_data does not accept
@@ -323,13 +324,19 @@ tvb_uncompress_zlib(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 	return uncompr_tvb;
 }
 #else /* USE_ZLIB_OR_ZLIBNG */
-tvbuff_t *
-tvb_uncompress_zlib(tvbuff_t *tvb _U_, const unsigned offset _U_, unsigned comprlen _U_)
+static tvbuff_t *
+uncompress_zlib(tvbuff_t *tvb _U_, const unsigned offset _U_, unsigned comprlen _U_)
 {
 	return NULL;
 }
 #endif /* USE_ZLIB_OR_ZLIBNG */
 
+tvbuff_t *
+tvb_uncompress_zlib(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+{
+	return tvb_uncompress_cached(tvb, offset, comprlen, TVB_UNCOMPRESS_ZLIB, uncompress_zlib);
+}
+
 tvbuff_t *
 tvb_child_uncompress_zlib(tvbuff_t *parent, tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 {
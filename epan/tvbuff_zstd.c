@@ -21,11 +21,11 @@
 #include "proto.h" // DISSECTOR_ASSERT_HINT
 #include "tvbuff.h"
 
-#include "tvbuff-int.h" // tvb_add_to_chain
+#include "tvbuff-int.h" // tvb_add_to_chain, tvb_uncompress_cached
 
 #define MAX_LOOP_ITERATIONS 100
 
-tvbuff_t *tvb_uncompress_zstd(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+static tvbuff_t *uncompress_zstd(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 {
 #ifndef HAVE_ZSTD
     // Cast to void to silence unused warnings.
@@ -98,6 +98,11 @@ end:
 #endif /* HAVE_ZSTD */
 }
 
+tvbuff_t *tvb_uncompress_zstd(tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
+{
+    return tvb_uncompress_cached(tvb, offset, comprlen, TVB_UNCOMPRESS_ZSTD, uncompress_zstd);
+}
+
 tvbuff_t *tvb_child_uncompress_zstd(tvbuff_t *parent, tvbuff_t *tvb, const unsigned offset, unsigned comprlen)
 {
     tvbuff_t *uncompressed = tvb_uncompress_zstd(tvb, offset, comprlen);
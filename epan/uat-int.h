@@ -16,6 +16,8 @@
 #ifndef __UAT_INT_H__
 #define __UAT_INT_H__
 
+#include <time.h>
+
 #include <glib.h>
 
 #include "uat.h"
@@ -62,6 +64,9 @@ struct epan_uat {
     uat_rep_t* rep;
     uat_rep_free_cb_t free_rep;
     bool loaded;
+    char* loaded_from;  /**< The file the records were read from by uat_load_all(), if they still match it. */
+    time_t loaded_mtime;
+    int64_t loaded_size;
 };
 
 WS_DLL_PUBLIC
@@ -549,6 +549,9 @@ void uat_clear(uat_t* uat) {
     g_array_set_size(uat->user_data,0);
     g_array_set_size(uat->valid_data,0);
 
+    g_free(uat->loaded_from);
+    uat->loaded_from = NULL;
+
     *((uat)->user_ptr) = NULL;
     *((uat)->nrows_p) = 0;
 
@@ -570,6 +573,38 @@ void uat_unload_all(void) {
     }
 }
 
+/* Would loading the table again read exactly what it holds now? */
+static bool uat_is_unchanged(uat_t* uat, const char* app_env_var_prefix) {
+    char* fname;
+    ws_statb64 st;
+    bool unchanged;
+
+    if (!uat->loaded || uat->changed || !uat->loaded_from)
+        return false;
+
+    fname = uat_get_actual_filename(uat, false, app_env_var_prefix);
+    unchanged = fname && strcmp(fname, uat->loaded_from) == 0 &&
+                ws_stat64(fname, &st) == 0 &&
+                st.st_mtime == uat->loaded_mtime &&
+                (int64_t)st.st_size == uat->loaded_size;
+    g_free(fname);
+
+    return unchanged;
+}
+
+void uat_unload_changed(const char* app_env_var_prefix) {
+    unsigned i;
+
+    for (i=0; i < all_uats->len; i++) {
+        uat_t* u = (uat_t *)g_ptr_array_index(all_uats,i);
+        /* Do not unload if not in profile */
+        if (u->from_profile && !uat_is_unchanged(u, app_env_var_prefix)) {
+            uat_clear(u);
+            u->loaded = false;
+        }
+    }
+}
+
 static void free_uat(uat_t *uat)
 {
     unsigned j;
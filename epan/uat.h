@@ -406,6 +406,11 @@ WS_DLL_PUBLIC
 void uat_foreach_table(uat_cb_t cb,void* user_data);
 void uat_unload_all(void);
 
+/** Unload the tables that uat_load_all() would not load from the same
+ * unmodified file again, so that a following uat_load_all() only reads
+ * the tables that have changed. Used when switching profiles. */
+void uat_unload_changed(const char* app_env_var_prefix);
+
 /* Converts an ASCII string using C-style escapes (e.g., for unprintable
  * characters) into a "stringlike" array of bytes that may include internal
  * NUL bytes and other unprintable characters. This is the PT_TEXTMOD_STRING
@@ -13,6 +13,7 @@
 
 #include "wmem_scopes.h"
 
+#include <wsutil/app_mem_usage.h>
 #include <wsutil/ws_assert.h>
 
 /* One of the supposed benefits of wmem over the old emem was going to be that
@@ -80,11 +81,30 @@ wmem_epan_scope(void)
     return epan_scope;
 }
 
+/* Memory Usage Reporting */
+
+static size_t
+wmem_file_scope_in_use(void)
+{
+    return file_scope ? (size_t)wmem_in_use_bytes(file_scope) : 0;
+}
+
+static size_t
+wmem_epan_scope_in_use(void)
+{
+    return epan_scope ? (size_t)wmem_in_use_bytes(epan_scope) : 0;
+}
+
+static const ws_mem_usage_t file_scope_usage = { "wmem file scope", wmem_file_scope_in_use, NULL };
+static const ws_mem_usage_t epan_scope_usage = { "wmem epan scope", wmem_epan_scope_in_use, NULL };
+
 /* Scope Management */
 
 void
 wmem_init_scopes(void)
 {
+    static bool usage_registered;
+
     ws_assert(file_scope   == NULL);
     ws_assert(epan_scope   == NULL);
 
@@ -95,6 +115,13 @@ wmem_init_scopes(void)
 
     /* Scopes are initialized to true by default on creation */
     wmem_leave_scope(file_scope);
+
+    /* The scopes can be recreated, but the components are kept forever. */
+    if (!usage_registered) {
+        memory_usage_component_register(&file_scope_usage);
+        memory_usage_component_register(&epan_scope_usage);
+        usage_registered = true;
+    }
 }
 
 void
@@ -111,3 +111,39 @@ void wscbor_enc_array_head(GByteArray *buf, size_t len) {
 void wscbor_enc_map_head(GByteArray *buf, size_t len) {
     wscbor_enc_head(buf, CBOR_TYPE_MAP, len);
 }
+
+void wscbor_enc_double(GByteArray *buf, double value) {
+    uint64_t bits;
+    uint8_t tmp[9];
+
+    memcpy(&bits, &value, sizeof(bits));
+    tmp[0] = (CBOR_TYPE_FLOAT_CTRL << 5) | 27;
+    for (int ix = 8; ix > 0; --ix) {
+        tmp[ix] = (uint8_t)(bits & 0xFF);
+        bits >>= 8;
+    }
+    g_byte_array_append(buf, tmp, sizeof(tmp));
+}
+
+/** Encode the head of an indefinite length item of a major type.
+ */
+static void wscbor_enc_head_indef(GByteArray *buf, uint8_t type_major) {
+    const uint8_t tmp[1] = { (type_major << 5) | 31 };
+    g_byte_array_append(buf, tmp, sizeof(tmp));
+}
+
+void wscbor_enc_bstr_head_indef(GByteArray *buf) {
+    wscbor_enc_head_indef(buf, CBOR_TYPE_BYTESTRING);
+}
+
+void wscbor_enc_array_head_indef(GByteArray *buf) {
+    wscbor_enc_head_indef(buf, CBOR_TYPE_ARRAY);
+}
+
+void wscbor_enc_map_head_indef(GByteArray *buf) {
+    wscbor_enc_head_indef(buf, CBOR_TYPE_MAP);
+}
+
+void wscbor_enc_break(GByteArray *buf) {
+    wscbor_enc_head_indef(buf, CBOR_TYPE_FLOAT_CTRL);
+}
@@ -101,6 +101,41 @@ void wscbor_enc_array_head(GByteArray *buf, size_t len);
 WS_DLL_PUBLIC
 void wscbor_enc_map_head(GByteArray *buf, size_t len);
 
+/** Add an item containing a double-precision float.
+ * @param[in,out] buf The buffer to append to.
+ * @param value The value to write.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_double(GByteArray *buf, double value);
+
+/** Add a byte string header with an indefinite length.
+ * @note The definite length byte strings which follow this header are its
+ * chunks, up to a wscbor_enc_break().
+ * @param[in,out] buf The buffer to append to.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_bstr_head_indef(GByteArray *buf);
+
+/** Add an array header with an indefinite length.
+ * @note The items which follow this header must end with a wscbor_enc_break().
+ * @param[in,out] buf The buffer to append to.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_array_head_indef(GByteArray *buf);
+
+/** Add a map header with an indefinite length.
+ * @note The pairs which follow this header must end with a wscbor_enc_break().
+ * @param[in,out] buf The buffer to append to.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_map_head_indef(GByteArray *buf);
+
+/** Add the "break" stop code, ending an indefinite length item.
+ * @param[in,out] buf The buffer to append to.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_break(GByteArray *buf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -282,6 +282,49 @@ wscbor_enc_test_map(void)
     g_bytes_unref(data);
 }
 
+static void
+wscbor_enc_test_double(void)
+{
+    GByteArray *buf = g_byte_array_new();
+    g_assert_nonnull(buf);
+
+    wscbor_enc_double(buf, 1.1);
+    wscbor_enc_double(buf, -4.0);
+
+    GBytes *data = g_byte_array_free_to_bytes(buf);
+    g_assert_nonnull(data);
+    g_assert_cmpmem(g_bytes_get_data(data, NULL), (int)g_bytes_get_size(data),
+                    "\xFB\x3F\xF1\x99\x99\x99\x99\x99\x9A"
+                    "\xFB\xC0\x10\x00\x00\x00\x00\x00\x00", (int)18);
+
+    g_bytes_unref(data);
+}
+
+static void
+wscbor_enc_test_indef(void)
+{
+    GByteArray *buf = g_byte_array_new();
+    g_assert_nonnull(buf);
+
+    wscbor_enc_map_head_indef(buf);
+    wscbor_enc_tstr(buf, "a");
+    wscbor_enc_array_head_indef(buf);
+    wscbor_enc_int64(buf, 1);
+    wscbor_enc_break(buf);
+    wscbor_enc_tstr(buf, "b");
+    wscbor_enc_bstr_head_indef(buf);
+    wscbor_enc_bstr(buf, (const uint8_t *)"\x01\x02", 2);
+    wscbor_enc_break(buf);
+    wscbor_enc_break(buf);
+
+    GBytes *data = g_byte_array_free_to_bytes(buf);
+    g_assert_nonnull(data);
+    g_assert_cmpmem(g_bytes_get_data(data, NULL), (int)g_bytes_get_size(data),
+                    "\xBF\x61\x61\x9F\x01\xFF\x61\x62\x5F\x42\x01\x02\xFF\xFF", (int)14);
+
+    g_bytes_unref(data);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -298,6 +341,8 @@ main(int argc, char **argv)
     g_test_add_func("/wscbor_enc/tstr", wscbor_enc_test_tstr);
     g_test_add_func("/wscbor_enc/array", wscbor_enc_test_array);
     g_test_add_func("/wscbor_enc/map", wscbor_enc_test_map);
+    g_test_add_func("/wscbor_enc/double", wscbor_enc_test_double);
+    g_test_add_func("/wscbor_enc/indef", wscbor_enc_test_indef);
 
     result = g_test_run();
 
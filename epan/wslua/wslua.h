@@ -272,6 +272,11 @@ struct _wslua_field_info {
     bool expired;
 };
 
+// A group of field extractors resolved together by FieldSet.
+struct _wslua_field_set {
+    GPtrArray *fields; /* Field */
+};
+
 /*
  * _func_saver stores function refs so that Lua won't garbage collect them prematurely.
  * It is only used by tcp_dissect_pdus right now.
@@ -384,6 +389,7 @@ typedef int64_t Int64;
 typedef uint64_t UInt64;
 typedef struct _wslua_header_field_info* Field;
 typedef struct _wslua_field_info* FieldInfo;
+typedef struct _wslua_field_set* FieldSet;
 typedef struct _wslua_tap* Listener;
 typedef struct _wslua_tw* TextWindow;
 typedef struct _wslua_progdlg* ProgDlg;
@@ -729,6 +735,41 @@ extern int wslua_reg_attributes(lua_State *L, const wslua_attribute_table *t, bo
     } \
 }
 
+/* Free list for the structures behind per-packet userdata, which scripts
+ * otherwise allocate and free again for every field, range and tree item
+ * they touch. Up to WSLUA_POOL_MAX released structures are kept and
+ * handed out again by alloc_##C(). */
+#define WSLUA_POOL_MAX 1024
+
+#define WSLUA_POOL(C, size) \
+static GPtrArray* pool_##C; \
+static C alloc_##C(void) { \
+    if (pool_##C && pool_##C->len) \
+        return (C)g_ptr_array_remove_index_fast(pool_##C, pool_##C->len - 1); \
+    return (C)g_malloc(size); \
+} \
+static void release_##C(C p) { \
+    if (!pool_##C) \
+        pool_##C = g_ptr_array_new(); \
+    if (pool_##C->len < WSLUA_POOL_MAX) \
+        g_ptr_array_add(pool_##C, p); \
+    else \
+        g_free(p); \
+}
+
+/* Same as CLEAR_OUTSTANDING, for classes allocated from a WSLUA_POOL */
+#define CLEAR_OUTSTANDING_POOLED(C, marker, marker_val) void clear_outstanding_##C(void) { \
+    while (outstanding_##C->len) { \
+        C p = (C)g_ptr_array_remove_index_fast(outstanding_##C,0); \
+        if (p) { \
+            if (p->marker != marker_val) \
+                p->marker = marker_val; \
+            else \
+                release_##C(p); \
+        } \
+    } \
+}
+
 #define WSLUA_CLASS_DECLARE(C) \
 extern C to##C(lua_State* L, int idx); \
 extern C check##C(lua_State* L, int idx); \
@@ -33,15 +33,17 @@ WSLUA_CLASS_DEFINE(FieldInfo,FAIL_ON_NULL_OR_EXPIRED("FieldInfo"));
 
 static GPtrArray* outstanding_FieldInfo;
 
+WSLUA_POOL(FieldInfo, sizeof(struct _wslua_field_info))
+
 FieldInfo* push_FieldInfo(lua_State* L, field_info* f) {
-    FieldInfo fi = (FieldInfo) g_malloc(sizeof(struct _wslua_field_info));
+    FieldInfo fi = alloc_FieldInfo();
     fi->ws_fi = f;
     fi->expired = false;
     g_ptr_array_add(outstanding_FieldInfo,fi);
     return pushFieldInfo(L,fi);
 }
 
-CLEAR_OUTSTANDING(FieldInfo,expired,true)
+CLEAR_OUTSTANDING_POOLED(FieldInfo,expired,true)
 
 /* WSLUA_ATTRIBUTE FieldInfo_len RO The length of this field. */
 WSLUA_METAMETHOD FieldInfo__len(lua_State* L) {
@@ -417,7 +419,7 @@ static int FieldInfo__gc(lua_State* L) {
         fi->expired = true;
     else
         /* do NOT free fi->ws_fi */
-        g_free(fi);
+        release_FieldInfo(fi);
 
     return 0;
 }
@@ -998,6 +1000,311 @@ int Field_register(lua_State* L) {
     return 0;
 }
 
+WSLUA_CLASS_DEFINE(FieldSet,FAIL_ON_NULL("FieldSet"));
+/*
+   A group of Field extractors that are looked up together and return plain Lua values.
+   Like a `Field`, a `FieldSet` can only be created *outside* of the callback functions of
+   dissectors, post-dissectors, heuristic-dissectors, and taps.
+
+   Calling a `FieldSet` inside a callback resolves all of its fields in a single call and
+   returns numbers, strings and booleans directly, without creating a `FieldInfo` for every
+   occurrence. This is considerably cheaper for post-dissectors and taps that read many
+   fields from every packet.
+
+   @since 4.7.0
+ */
+
+/*
+ * Push the value of a field as a plain Lua value. Unlike FieldInfo__call(),
+ * no userdata is created: addresses and other types without a natural Lua
+ * representation are returned as their display string, times as a number of
+ * seconds and byte fields as a Lua string holding the raw bytes.
+ */
+static void push_field_value_plain(lua_State* L, field_info* fi) {
+    char* repr;
+
+    switch(fi->hfinfo->type) {
+        case FT_BOOLEAN:
+                lua_pushboolean(L,(int)fvalue_get_uinteger64(fi->value));
+                return;
+        case FT_CHAR:
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_FRAMENUM:
+                lua_pushinteger(L,(lua_Integer)(fvalue_get_uinteger(fi->value)));
+                return;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+                lua_pushinteger(L,(lua_Integer)(fvalue_get_sinteger(fi->value)));
+                return;
+        case FT_FLOAT:
+        case FT_DOUBLE:
+                lua_pushnumber(L,(lua_Number)(fvalue_get_floating(fi->value)));
+                return;
+#if LUA_VERSION_NUM >= 503
+        /* lua_Integer is 64 bits wide; UINT64 values above INT64_MAX wrap. */
+        case FT_INT64:
+                lua_pushinteger(L,(lua_Integer)(fvalue_get_sinteger64(fi->value)));
+                return;
+        case FT_UINT64:
+                lua_pushinteger(L,(lua_Integer)(fvalue_get_uinteger64(fi->value)));
+                return;
+#else
+        case FT_INT64:
+                pushInt64(L,(Int64)(fvalue_get_sinteger64(fi->value)));
+                return;
+        case FT_UINT64:
+                pushUInt64(L,fvalue_get_uinteger64(fi->value));
+                return;
+#endif
+        case FT_ABSOLUTE_TIME:
+        case FT_RELATIVE_TIME:
+                lua_pushnumber(L,(lua_Number)nstime_to_sec(fvalue_get_time(fi->value)));
+                return;
+        case FT_NONE:
+                /* There is no value, but the field is present. */
+                if (fi->length > 0 && fi->rep) {
+                    lua_pushstring(L, fi->rep->representation);
+                } else {
+                    lua_pushboolean(L,1);
+                }
+                return;
+        case FT_BYTES:
+        case FT_UINT_BYTES:
+        case FT_REL_OID:
+        case FT_SYSTEM_ID:
+        case FT_OID:
+                lua_pushlstring(L, (const char*)fvalue_get_bytes_data(fi->value),
+                                (size_t)fvalue_length2(fi->value));
+                return;
+        case FT_PROTOCOL: {
+                tvbuff_t* tvb = fvalue_get_protocol(fi->value);
+                unsigned len = tvb ? tvb_captured_length(tvb) : 0;
+                lua_pushlstring(L, len ? (const char*)tvb_get_ptr(tvb, 0, len) : "", len);
+                return;
+            }
+        default:
+                repr = fvalue_to_string_repr(NULL, fi->value, FTREPR_DISPLAY, BASE_NONE);
+                if (repr) {
+                    lua_pushstring(L, repr);
+                    wmem_free(NULL, repr);
+                } else {
+                    lua_pushnil(L);
+                }
+                return;
+    }
+}
+
+/*
+ * Push the values of a field, following fields that share its name, onto
+ * the Lua stack. Stops after the first one if first_only is set.
+ * Returns the number of values pushed.
+ */
+static int push_field_values_plain(lua_State* L, Field f, bool first_only) {
+    header_field_info* in = f->hfi;
+    int items_found = 0;
+
+    while (in) {
+        GPtrArray* found = proto_get_finfo_ptr_array(lua_tree->tree, in->id);
+        unsigned i;
+        if (found) {
+            for (i=0; i<found->len; i++) {
+                luaL_checkstack(L, 1, "too many field values");
+                push_field_value_plain(L, (field_info *) g_ptr_array_index(found,i));
+                items_found++;
+                if (first_only) {
+                    return items_found;
+                }
+            }
+        }
+        in = (in->same_name_prev_id != -1) ? proto_registrar_get_nth(in->same_name_prev_id) : NULL;
+    }
+
+    return items_found;
+}
+
+WSLUA_CONSTRUCTOR FieldSet_new(lua_State *L) {
+    /*
+       Create a FieldSet from a list of field names.
+
+       @code
+       local fields = FieldSet.new({"ip.src", "ip.dst", "tcp.srcport", "tcp.dstport"})
+
+       local tap = Listener.new("tcp")
+
+       function tap.packet(pinfo, tvb)
+           local src, dst, sport, dport = fields()
+       end
+       @endcode
+       */
+#define WSLUA_ARG_FieldSet_new_FIELDNAMES 1 /* A Lua array table of filter names (e.g. `{"ip.src", "ip.dst"}`). */
+    FieldSet fs;
+    lua_Integer n, i;
+
+    luaL_checktype(L, WSLUA_ARG_FieldSet_new_FIELDNAMES, LUA_TTABLE);
+
+    if (!wanted_fields) {
+        WSLUA_ERROR(FieldSet_new,"A FieldSet must be defined before Taps or Dissectors get called");
+        return 0;
+    }
+
+    n = (lua_Integer)lua_rawlen(L, WSLUA_ARG_FieldSet_new_FIELDNAMES);
+    if (n == 0) {
+        WSLUA_ARG_ERROR(FieldSet_new,FIELDNAMES,"must contain at least one field name");
+        return 0;
+    }
+
+    /* Check every name before registering any of them */
+    for (i = 1; i <= n; i++) {
+        const char* name;
+        lua_rawgeti(L, WSLUA_ARG_FieldSet_new_FIELDNAMES, i);
+        name = lua_tostring(L, -1);
+        if (!name || (!proto_registrar_get_byname(name) && !wslua_is_field_available(L, name))) {
+            WSLUA_ARG_ERROR(FieldSet_new,FIELDNAMES,"each entry must be the name of an existing field");
+            return 0;
+        }
+        lua_pop(L, 1);
+    }
+
+    fs = g_new(struct _wslua_field_set, 1);
+    fs->fields = g_ptr_array_sized_new((unsigned)n);
+
+    for (i = 1; i <= n; i++) {
+        Field f = (Field)g_new0(struct _wslua_header_field_info, 1);
+        lua_rawgeti(L, WSLUA_ARG_FieldSet_new_FIELDNAMES, i);
+        f->name = g_strdup(lua_tostring(L, -1));
+        lua_pop(L, 1);
+
+        g_ptr_array_add(fs->fields, f);
+        g_ptr_array_add(wanted_fields, f);
+    }
+
+    pushFieldSet(L,fs);
+    WSLUA_RETURN(1); /* The new FieldSet. */
+}
+
+static void check_FieldSet_usable(lua_State* L, FieldSet fs) {
+    unsigned i;
+
+    if (! lua_pinfo ) {
+        luaL_error(L,"FieldSets cannot be used outside dissectors or taps");
+    }
+
+    for (i = 0; i < fs->fields->len; i++) {
+        Field f = (Field)g_ptr_array_index(fs->fields, i);
+        if (!f->hfi) {
+            luaL_error(L,"invalid field %s", f->name);
+        }
+    }
+}
+
+WSLUA_METAMETHOD FieldSet__call(lua_State* L) {
+    /*
+       Obtain the value of the first occurrence of each field, in the order the fields
+       were given to `FieldSet.new()`. A field that is not present in the packet gives `nil`.
+
+       Integers, floating point numbers and booleans are returned as Lua numbers and booleans,
+       absolute and relative times as a number of seconds, byte fields as a Lua string of the
+       raw bytes, and all other types (such as addresses) as their display string.
+       With Lua 5.3 and later 64-bit integer fields are returned as Lua integers; with older
+       versions they are returned as `Int64` or `UInt64`.
+       */
+    FieldSet fs = checkFieldSet(L,1);
+    unsigned i;
+
+    check_FieldSet_usable(L, fs);
+    luaL_checkstack(L, (int)fs->fields->len, "too many fields in FieldSet");
+
+    for (i = 0; i < fs->fields->len; i++) {
+        Field f = (Field)g_ptr_array_index(fs->fields, i);
+
+        if (push_field_values_plain(L, f, true) == 0) {
+            lua_pushnil(L);
+        }
+    }
+
+    WSLUA_RETURN((int)fs->fields->len); /* The value of each field, or nil. */
+}
+
+WSLUA_METHOD FieldSet_all(lua_State* L) {
+    /*
+       Obtain the values of all occurrences of each field, as one Lua array table per field
+       in the order the fields were given to `FieldSet.new()`. A field that is not present
+       in the packet gives an empty table. Values are converted as for calling the `FieldSet`.
+       */
+    FieldSet fs = checkFieldSet(L,1);
+    unsigned i;
+
+    check_FieldSet_usable(L, fs);
+    luaL_checkstack(L, (int)fs->fields->len + 2, "too many fields in FieldSet");
+
+    for (i = 0; i < fs->fields->len; i++) {
+        Field f = (Field)g_ptr_array_index(fs->fields, i);
+        int n, j;
+
+        lua_newtable(L);
+        n = push_field_values_plain(L, f, false);
+        /* The values sit above the table; store them last to first. */
+        for (j = n; j > 0; j--) {
+            lua_rawseti(L, -1 - j, j);
+        }
+    }
+
+    WSLUA_RETURN((int)fs->fields->len); /* A table of values for each field. */
+}
+
+WSLUA_METAMETHOD FieldSet__len(lua_State* L) {
+    /* The number of fields in this FieldSet. */
+    FieldSet fs = checkFieldSet(L,1);
+
+    lua_pushinteger(L, (lua_Integer)fs->fields->len);
+    return 1;
+}
+
+static int FieldSet__gc(lua_State* L) {
+    FieldSet fs = toFieldSet(L,1);
+    unsigned i;
+
+    if (!fs) return 0;
+
+    for (i = 0; i < fs->fields->len; i++) {
+        Field f = (Field)g_ptr_array_index(fs->fields, i);
+
+        // See Field__gc: drop it from wanted_fields if not primed yet.
+        if (wanted_fields) {
+            g_ptr_array_remove_fast(wanted_fields, f);
+        }
+
+        g_free(f->name);
+        g_free(f);
+    }
+
+    g_ptr_array_free(fs->fields, true);
+    g_free(fs);
+    return 0;
+}
+
+WSLUA_METHODS FieldSet_methods[] = {
+    WSLUA_CLASS_FNREG(FieldSet,new),
+    WSLUA_CLASS_FNREG(FieldSet,all),
+    { NULL, NULL }
+};
+
+WSLUA_META FieldSet_meta[] = {
+    WSLUA_CLASS_MTREG(FieldSet,call),
+    WSLUA_CLASS_MTREG(FieldSet,len),
+    { NULL, NULL }
+};
+
+int FieldSet_register(lua_State* L) {
+    WSLUA_REGISTER_CLASS(FieldSet);
+    return 0;
+}
+
 int wslua_deregister_fields(lua_State* L _U_) {
     if (wslua_dfilter) {
         dfilter_free(wslua_dfilter);
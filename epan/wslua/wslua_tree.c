@@ -25,10 +25,12 @@ static int wslua_ett = -1;
 
 static GPtrArray* outstanding_TreeItem;
 
+WSLUA_POOL(TreeItem, sizeof(struct _wslua_treeitem))
+
 
 /* pushing a TreeItem with a NULL item or subtree is completely valid for this function */
 TreeItem push_TreeItem(lua_State *L, proto_tree *tree, proto_item *item) {
-    TreeItem ti = g_new(struct _wslua_treeitem, 1);
+    TreeItem ti = alloc_TreeItem();
 
     ti->tree = tree;
     ti->item = item;
@@ -50,7 +52,7 @@ TreeItem create_TreeItem(proto_tree* tree, proto_item* item)
     return tree_item;
 }
 
-CLEAR_OUTSTANDING(TreeItem, expired, true)
+CLEAR_OUTSTANDING_POOLED(TreeItem, expired, true)
 
 WSLUA_CLASS_DEFINE(TreeItem,FAIL_ON_NULL_OR_EXPIRED("TreeItem"));
 /* <<lua_class_TreeItem,`TreeItem`>>s represent information in the https://www.wireshark.org/docs/wsug_html_chunked/ChUsePacketDetailsPaneSection.html[packet details] pane of Wireshark, and the packet details view of TShark.
@@ -1709,7 +1711,7 @@ static int TreeItem__gc(lua_State* L) {
     if (!ti->expired)
         ti->expired = true;
     else
-        g_free(ti);
+        release_TreeItem(ti);
     return 0;
 }
 
@@ -82,6 +82,14 @@ int push_wsluaTvb(lua_State* L, Tvb t) {
 
 #define PUSH_TVBRANGE(L,t) {g_ptr_array_add(outstanding_TvbRange,t);pushTvbRange(L,t);}
 
+/* A TvbRange pushed by push_TvbRange() and its Tvb are allocated as one block */
+typedef struct {
+    struct _wslua_tvbrange range;
+    struct _wslua_tvb tvb;
+} tvbrange_block_t;
+
+WSLUA_POOL(TvbRange, sizeof(tvbrange_block_t))
+
 
 static void free_Tvb(Tvb tvb) {
     if (!tvb) return;
@@ -352,8 +360,8 @@ static void free_TvbRange(TvbRange tvbr) {
     if (!tvbr->tvb->expired) {
         tvbr->tvb->expired = true;
     } else {
-        free_Tvb(tvbr->tvb);
-        g_free(tvbr);
+        /* The Tvb is part of the same block and never needs freeing. */
+        release_TvbRange(tvbr);
     }
 }
 
@@ -393,8 +401,8 @@ bool push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
         return false;
     }
 
-    tvbr = (TvbRange)g_malloc(sizeof(struct _wslua_tvbrange));
-    tvbr->tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    tvbr = alloc_TvbRange();
+    tvbr->tvb = &((tvbrange_block_t *)tvbr)->tvb;
     tvbr->tvb->ws_tvb = ws_tvb;
     tvbr->tvb->expired = false;
     tvbr->tvb->need_free = false;
@@ -23,6 +23,7 @@
 #include <wsutil/filesystem.h>
 #include <app/application_flavor.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/tempfile.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/report_message.h>
@@ -44,6 +45,8 @@
 #include <epan/addr_resolv.h>
 #include <epan/color_filters.h>
 #include <epan/secrets.h>
+#include <epan/stream_frames.h>
+#include <epan/dissectors/packet-sysdig-event.h>
 
 #include "cfile.h"
 #include "file.h"
@@ -55,6 +58,9 @@
 #include "ui/urls.h"
 #include "ui/ws_ui_util.h"
 #include "ui/packet_list_utils.h"
+#include "ui/frame_index.h"
+#include "ui/frame_ngram_index.h"
+#include "ui/proto_hier_stats.h"
 
 /* Needed for addrinfo */
 #include <sys/types.h>
@@ -80,6 +86,9 @@ static void add_new_record_to_record_list(capture_file *cf, wtap_rec *rec,
                                           GChecksum *frame_cksum);
 
 static void rescan_packets(capture_file *cf, const char *action, const char *action_item, bool redissect);
+static void cf_free_frame_protos(capture_file *cf);
+static void cf_free_syscall_columns(capture_file *cf);
+static void cf_export_jobs_stop(capture_file *cf);
 
 typedef enum {
     MR_NOTMATCHED,
@@ -247,13 +256,15 @@ ws_epan_new(capture_file *cf)
     return epan_new(&cf->provider, &funcs);
 }
 
-cf_status_t
-cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile, int *err)
+static cf_status_t
+cf_open_files(capture_file *cf, const char *const *fnames, unsigned num_files,
+        unsigned int type, bool is_tempfile, int *err)
 {
+    const char *fname = fnames[0];
     wtap  *wth;
     char *err_info;
 
-    wth = wtap_open_offline(fname, type, err, &err_info, true, application_configuration_environment_prefix());
+    wth = wtap_open_offline_multi(fnames, num_files, type, err, &err_info, true, application_configuration_environment_prefix());
     if (wth == NULL)
         goto fail;
 
@@ -274,6 +285,8 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile
      * old file's read lock was held, but it doesn't hurt to clear it. */
     cf->read_lock = false;
     cf->redissection_queued = RESCAN_NONE;
+    cf->passed_dfilter_superset = false;
+    cf->dfilter_narrowed = false;
 
     cf->provider.wth = wth;
     cf->f_datalen = 0;
@@ -283,9 +296,32 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile
        in any case. */
     cf->filename = g_strdup(fname);
 
+    /* If it's a set of files read as one, the first file names it, but
+       we need them all to reload it. */
+    if (num_files > 1) {
+        cf->set_filenames = g_new(char *, num_files + 1);
+        for (unsigned i = 0; i < num_files; i++)
+            cf->set_filenames[i] = g_strdup(fnames[i]);
+        cf->set_filenames[num_files] = NULL;
+    }
+
     /* Indicate whether it's a permanent or temporary file. */
     cf->is_tempfile = is_tempfile;
 
+    /* Use the frame index left by an earlier read, if it's still current.
+       The index is kept beside a single file, so sets don't have one. */
+    if (prefs.gui_frame_index && !is_tempfile && num_files == 1)
+        cf->frame_index = frame_index_open(fname);
+
+    /* Likewise for the trigram filters used to speed up Find Packet,
+       otherwise build them as the file is read. */
+    if (prefs.gui_find_index) {
+        if (!is_tempfile && num_files == 1)
+            cf->ngram_index = frame_ngram_index_open(fname);
+        if (cf->ngram_index == NULL)
+            cf->ngram_index = frame_ngram_index_new();
+    }
+
     /* No user changes yet. */
     cf->unsaved_changes = false;
 
@@ -303,6 +339,10 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile
     cf->marked_count = 0;
     cf->ignored_count = 0;
     cf->ref_time_count = 0;
+    memset(&cf->tally_all, 0, sizeof(cf->tally_all));
+    memset(&cf->tally_displayed, 0, sizeof(cf->tally_displayed));
+    memset(&cf->tally_marked, 0, sizeof(cf->tally_marked));
+    cf->tally_valid = true;
     cf->drops_known = false;
     cf->drops     = 0;
     cf->snap      = wtap_snapshot_length(cf->provider.wth);
@@ -335,6 +375,18 @@ fail:
     return CF_ERROR;
 }
 
+cf_status_t
+cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile, int *err)
+{
+    return cf_open_files(cf, &fname, 1, type, is_tempfile, err);
+}
+
+cf_status_t
+cf_open_set(capture_file *cf, const char *const *fnames, unsigned num_files, unsigned int type, int *err)
+{
+    return cf_open_files(cf, fnames, num_files, type, false, err);
+}
+
 /*
  * Add an encapsulation type to cf->linktypes.
  */
@@ -365,6 +417,8 @@ cf_close(capture_file *cf)
 
     cf_callback_invoke(cf_cb_file_closing, cf);
 
+    cf_export_jobs_stop(cf);
+
     /* close things, if not already closed before */
     color_filters_cleanup();
 
@@ -380,6 +434,8 @@ cf_close(capture_file *cf)
         g_free(cf->filename);
         cf->filename = NULL;
     }
+    g_strfreev(cf->set_filenames);
+    cf->set_filenames = NULL;
     /* ...which means we have no changes to that file to save. */
     cf->unsaved_changes = false;
 
@@ -400,6 +456,15 @@ cf_close(capture_file *cf)
         free_frame_data_sequence(cf->provider.frames);
         cf->provider.frames = NULL;
     }
+    frame_data_aggregation_keys_clear();
+    cf_free_frame_protos(cf);
+    cf_free_syscall_columns(cf);
+    ph_frame_stacks_free(cf->ph_stacks);
+    cf->ph_stacks = NULL;
+    frame_index_free(cf->frame_index);
+    cf->frame_index = NULL;
+    frame_ngram_index_free(cf->ngram_index);
+    cf->ngram_index = NULL;
     if (cf->provider.frames_modified_blocks) {
         g_tree_destroy(cf->provider.frames_modified_blocks);
         cf->provider.frames_modified_blocks = NULL;
@@ -410,6 +475,7 @@ cf_close(capture_file *cf)
 
     /* No frames, no frame selected, no field in that frame selected. */
     cf->count = 0;
+    cf->tally_valid = false;
     cf->current_frame = NULL;
     cf->finfo_selected = NULL;
 
@@ -459,6 +525,18 @@ calc_progbar_val(capture_file *cf, int64_t size, int64_t file_pos, char *status_
 {
     float progbar_val;
 
+    if (cf->frame_index != NULL && frame_index_count(cf->frame_index) > 0) {
+        /* We know how many frames there are; that's a better measure
+         * than the file position, e.g. for compressed files. */
+        uint32_t frames = frame_index_count(cf->frame_index);
+
+        progbar_val = (float) cf->count / (float) frames;
+        if (progbar_val > 1.0f)
+            progbar_val = 1.0f;
+        snprintf(status_str, status_size, "%u of %u frames", cf->count, frames);
+        return progbar_val;
+    }
+
     progbar_val = (float) file_pos / (float) size;
     if (progbar_val > 1.0f) {
 
@@ -518,6 +596,7 @@ cf_read(capture_file *cf, bool reloading)
     }
     /* This is a full dissection, so clear any pending request for one. */
     cf->redissection_queued = RESCAN_NONE;
+    cf->passed_dfilter_superset = false;
     cf->read_lock = true;
 
     /* Compile the current display filter.
@@ -533,7 +612,7 @@ cf_read(capture_file *cf, bool reloading)
      * once, reducing the chances of that)... (#19612)
      */
     if (cf->dfilter) {
-        compiled = dfilter_compile(cf->dfilter, &dfcode, NULL);
+        compiled = dfilter_compile_cached(cf->dfilter, &dfcode, NULL);
         ws_assert(compiled && dfcode);
     }
 
@@ -704,6 +783,10 @@ cf_read(capture_file *cf, bool reloading)
     /* We're done reading sequentially through the file. */
     cf->state = FILE_READ_DONE;
 
+    /* Every frame has been tested against the display filter, unless
+     * the filter was changed while we were reading. */
+    cf->passed_dfilter_superset = !cf->stop_flag && cf->redissection_queued == RESCAN_NONE;
+
     /* Destroy the progress bar if it was created. */
     if (progbar != NULL)
         destroy_progress_dlg(progbar);
@@ -795,13 +878,43 @@ cf_read(capture_file *cf, bool reloading)
                 "The file contains more records than the maximum "
                 "supported number of records, %u.", max_records);
         return CF_READ_ERROR;
-    } else
-        return CF_READ_OK;
+    }
+
+    if (prefs.gui_frame_index && !cf->is_tempfile && cf->count > 0) {
+        /* Write an index for the next time the file is opened unless the
+         * one we have describes the same frames. */
+        if (cf->frame_index == NULL ||
+                frame_index_count(cf->frame_index) != cf->count ||
+                !frame_index_matches(cf->frame_index,
+                    frame_data_sequence_find(cf->provider.frames, cf->count))) {
+            frame_index_free(cf->frame_index);
+            cf->frame_index = NULL;
+            if (frame_index_write(cf->filename, cf->provider.frames, cf->count))
+                cf->frame_index = frame_index_open(cf->filename);
+        }
+    }
+    if (cf->ngram_index != NULL && frame_ngram_index_is_new(cf->ngram_index) &&
+            !cf->is_tempfile && cf->rfcode == NULL &&
+            frame_ngram_index_count(cf->ngram_index) == cf->count) {
+        /* Save the filters we built so that searching is fast right away
+         * the next time the file is opened. Keep using the ones in memory;
+         * they're the same. */
+        frame_ngram_index_write(cf->ngram_index, cf->filename);
+    }
+    return CF_READ_OK;
 }
 
 #ifdef HAVE_LIBPCAP
+/*
+ * Longest time, in microseconds, that cf_continue_tail() spends reading
+ * packets in one call. dumpcap reports new packets at least every 100 ms
+ * by default, so this leaves the UI at least half of that to redraw and
+ * handle input when we can't keep up with the capture.
+ */
+#define TAIL_READ_TIME_LIMIT (50 * 1000)
+
 cf_read_status_t
-cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
+cf_continue_tail(capture_file *cf, int *to_read, wtap_rec *rec,
         int *err, fifo_string_cache_t *frame_dup_cache, GChecksum *frame_cksum)
 {
     char             *err_info;
@@ -865,6 +978,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
 
     TRY {
         int64_t data_offset = 0;
+        int64_t start_time = g_get_monotonic_time();
         column_info *cinfo;
 
         /* If the display filter or any tap listeners require the columns,
@@ -872,10 +986,18 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
         cinfo = (tap_listeners_require_columns() ||
             dfilter_requires_columns(cf->dfcode)) ? &cf->cinfo : NULL;
 
-        while (to_read != 0) {
+        while (*to_read != 0) {
+            if (g_get_monotonic_time() - start_time > TAIL_READ_TIME_LIMIT) {
+                /* We're falling behind; let the UI catch its breath and
+                   leave the rest of the packets for later. */
+                break;
+            }
             wtap_cleareof(cf->provider.wth);
             if (!wtap_read(cf->provider.wth, rec, err, &err_info,
                         &data_offset)) {
+                /* Whatever isn't there yet will be read along with the
+                   packets the child tells us about next. */
+                *to_read = 0;
                 break;
             }
             if (cf->state == FILE_READ_ABORTED) {
@@ -887,7 +1009,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
             add_new_record_to_record_list(cf, rec, cf->dfcode, &edt, cinfo,
                                           data_offset, frame_dup_cache,
                                           frame_cksum);
-            to_read--;
+            (*to_read)--;
         }
         wtap_rec_reset(rec);
     }
@@ -1201,6 +1323,354 @@ void
 cf_set_rfcode(capture_file *cf, dfilter_t *rfcode)
 {
     cf->rfcode = rfcode;
+
+    /* A saved n-gram index numbers all of the file's frames, which won't
+       be the frame numbers we end up with. */
+    if (rfcode != NULL && cf->ngram_index != NULL &&
+            !frame_ngram_index_is_new(cf->ngram_index)) {
+        frame_ngram_index_free(cf->ngram_index);
+        cf->ngram_index = frame_ngram_index_new();
+    }
+}
+
+/*
+ * Protocol sets for the display filter prefilter.
+ *
+ * When a frame is dissected we remember which protocols appear in its
+ * layers. A later rescan with a display filter that can only match
+ * frames containing certain protocols (see dfilter_required_protocols())
+ * can then reject frames lacking one of them without reading or
+ * dissecting them. Most frames in a capture share a handful of protocol
+ * stacks, so the sets are interned; each is an array of protocol IDs
+ * sorted in ascending order, preceded by its length.
+ */
+static unsigned
+proto_set_hash(const void *key)
+{
+    const int *set = (const int *)key;
+    unsigned hash = 5381;
+
+    for (int i = 0; i <= set[0]; i++) {
+        hash = hash * 33 + (unsigned)set[i];
+    }
+    return hash;
+}
+
+static gboolean
+proto_set_equal(const void *a, const void *b)
+{
+    const int *set_a = (const int *)a;
+    const int *set_b = (const int *)b;
+
+    return set_a[0] == set_b[0] &&
+        memcmp(set_a + 1, set_b + 1, set_a[0] * sizeof(int)) == 0;
+}
+
+static int
+proto_id_compare(const void *a, const void *b)
+{
+    int id_a = *(const int *)a;
+    int id_b = *(const int *)b;
+
+    return (id_a > id_b) - (id_a < id_b);
+}
+
+static void
+cf_free_frame_protos(capture_file *cf)
+{
+    if (cf->frame_protos != NULL) {
+        g_ptr_array_free(cf->frame_protos, true);
+        cf->frame_protos = NULL;
+    }
+    if (cf->proto_sets != NULL) {
+        g_hash_table_destroy(cf->proto_sets);
+        cf->proto_sets = NULL;
+    }
+}
+
+static void
+cf_record_frame_protos(capture_file *cf, const frame_data *fdata, packet_info *pinfo)
+{
+    wmem_list_frame_t *layer;
+    int  *set, *interned;
+    int   count, n = 0;
+
+    if (pinfo->layers == NULL) {
+        return;
+    }
+    if (cf->frame_protos == NULL) {
+        cf->frame_protos = g_ptr_array_new();
+        cf->proto_sets = g_hash_table_new_full(proto_set_hash, proto_set_equal, g_free, NULL);
+    }
+
+    count = (int)wmem_list_count(pinfo->layers);
+    set = g_new(int, count + 1);
+    for (layer = wmem_list_head(pinfo->layers); layer != NULL; layer = wmem_list_frame_next(layer)) {
+        int proto_id = GPOINTER_TO_INT(wmem_list_frame_data(layer));
+        set[++n] = proto_id;
+    }
+    qsort(set + 1, n, sizeof(int), proto_id_compare);
+    /* Drop duplicates, e.g. for tunnels. */
+    count = 0;
+    for (int i = 1; i <= n; i++) {
+        if (count == 0 || set[count] != set[i]) {
+            set[++count] = set[i];
+        }
+    }
+    set[0] = count;
+
+    interned = (int *)g_hash_table_lookup(cf->proto_sets, set);
+    if (interned == NULL) {
+        g_hash_table_add(cf->proto_sets, set);
+        interned = set;
+    } else {
+        g_free(set);
+    }
+
+    if (cf->frame_protos->len < fdata->num) {
+        g_ptr_array_set_size(cf->frame_protos, fdata->num);
+    }
+    g_ptr_array_index(cf->frame_protos, fdata->num - 1) = interned;
+}
+
+/*
+ * Returns true if we know the frame lacks one of the protocols required
+ * to match the display filter, so it can be rejected without dissection.
+ */
+static bool
+cf_frame_lacks_protos(capture_file *cf, const frame_data *fdata,
+        const int *required_protos, int num_required_protos)
+{
+    const int *set;
+
+    if (cf->frame_protos == NULL || fdata->num > cf->frame_protos->len) {
+        return false;
+    }
+    set = (const int *)g_ptr_array_index(cf->frame_protos, fdata->num - 1);
+    if (set == NULL) {
+        return false;
+    }
+    for (int i = 0; i < num_required_protos; i++) {
+        if (bsearch(&required_protos[i], set + 1, set[0], sizeof(int), proto_id_compare) == NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Returns true if the frame's metadata is outside the limits the display
+ * filter puts on it (see dfilter_frame_bounds()), so it can be rejected
+ * without reading or dissecting it.
+ */
+static bool
+cf_frame_outside_bounds(const frame_data *fdata, const dfilter_frame_bounds_t *bounds)
+{
+    if (fdata->num < bounds->num_min || fdata->num > bounds->num_max) {
+        return true;
+    }
+    if (fdata->pkt_len < bounds->len_min || fdata->pkt_len > bounds->len_max) {
+        return true;
+    }
+    if (fdata->cap_len < bounds->cap_len_min || fdata->cap_len > bounds->cap_len_max) {
+        return true;
+    }
+    if (fdata->has_ts) {
+        if (!nstime_is_unset(&bounds->time_min) && nstime_cmp(&fdata->abs_ts, &bounds->time_min) < 0) {
+            return true;
+        }
+        if (!nstime_is_unset(&bounds->time_max) && nstime_cmp(&fdata->abs_ts, &bounds->time_max) > 0) {
+            return true;
+        }
+    }
+    if (bounds->marked >= 0 && fdata->marked != (unsigned)bounds->marked) {
+        return true;
+    }
+    if (bounds->ignored >= 0 && fdata->ignored != (unsigned)bounds->ignored) {
+        return true;
+    }
+    return false;
+}
+
+/*
+ * System call event header columns.
+ *
+ * Wiretap decodes the header of each sysdig/Falco event, so when a frame
+ * is first dissected we copy the header fields the Sysdig Event dissector
+ * shows into one array per field. A later rescan with a display filter
+ * that only looks at those fields can evaluate it against a tree built
+ * from the arrays and reject frames it doesn't match without reading
+ * them or running the Falco plugins on them again. Frames it does match
+ * are still dissected, since a dissector might hide them.
+ */
+typedef struct _syscall_columns {
+    GArray *present;                /* uint8_t, nonzero if the frame's header was recorded */
+    GArray *cpu_id;                 /* uint16_t */
+    GArray *event_type;             /* uint16_t */
+    GArray *thread_id;              /* uint64_t */
+    GArray *event_len;              /* uint32_t */
+    GArray *event_data_len;         /* uint32_t */
+    GArray *nparams;                /* uint32_t */
+} syscall_columns_t;
+
+static void
+cf_free_syscall_columns(capture_file *cf)
+{
+    syscall_columns_t *cols = cf->syscall_columns;
+
+    if (cols == NULL) {
+        return;
+    }
+    g_array_free(cols->present, true);
+    g_array_free(cols->cpu_id, true);
+    g_array_free(cols->event_type, true);
+    g_array_free(cols->thread_id, true);
+    g_array_free(cols->event_len, true);
+    g_array_free(cols->event_data_len, true);
+    g_array_free(cols->nparams, true);
+    g_free(cols);
+    cf->syscall_columns = NULL;
+}
+
+static void
+cf_record_syscall_columns(capture_file *cf, const frame_data *fdata,
+        const wtap_syscall_header *syscall_header)
+{
+    syscall_columns_t *cols = cf->syscall_columns;
+    unsigned idx = fdata->num - 1;
+
+    if (cols == NULL) {
+        cols = g_new(syscall_columns_t, 1);
+        cols->present = g_array_new(false, true, sizeof(uint8_t));
+        cols->cpu_id = g_array_new(false, true, sizeof(uint16_t));
+        cols->event_type = g_array_new(false, true, sizeof(uint16_t));
+        cols->thread_id = g_array_new(false, true, sizeof(uint64_t));
+        cols->event_len = g_array_new(false, true, sizeof(uint32_t));
+        cols->event_data_len = g_array_new(false, true, sizeof(uint32_t));
+        cols->nparams = g_array_new(false, true, sizeof(uint32_t));
+        cf->syscall_columns = cols;
+    }
+
+    if (cols->present->len <= idx) {
+        /* Grow geometrically; set_size() would add one frame at a time. */
+        unsigned len = MAX(idx + 1, cols->present->len * 2);
+
+        g_array_set_size(cols->present, len);
+        g_array_set_size(cols->cpu_id, len);
+        g_array_set_size(cols->event_type, len);
+        g_array_set_size(cols->thread_id, len);
+        g_array_set_size(cols->event_len, len);
+        g_array_set_size(cols->event_data_len, len);
+        g_array_set_size(cols->nparams, len);
+    }
+
+    g_array_index(cols->present, uint8_t, idx) = 1;
+    g_array_index(cols->cpu_id, uint16_t, idx) = syscall_header->cpu_id;
+    g_array_index(cols->event_type, uint16_t, idx) = syscall_header->event_type;
+    g_array_index(cols->thread_id, uint64_t, idx) = syscall_header->thread_id;
+    g_array_index(cols->event_len, uint32_t, idx) = syscall_header->event_len;
+    g_array_index(cols->event_data_len, uint32_t, idx) = syscall_header->event_data_len;
+    g_array_index(cols->nparams, uint32_t, idx) = syscall_header->nparams;
+}
+
+/*
+ * Returns true if the display filter only looks at system call event
+ * header fields, so that cf_frame_fails_syscall_columns() can be used.
+ */
+static bool
+cf_dfilter_uses_syscall_columns(capture_file *cf, const dfilter_t *dfcode)
+{
+    const int *fields;
+    int num_fields;
+
+    if (cf->syscall_columns == NULL) {
+        return false;
+    }
+    fields = dfilter_interesting_fields(dfcode, &num_fields);
+    if (num_fields == 0) {
+        return false;
+    }
+    for (int i = 0; i < num_fields; i++) {
+        if (!sysdig_event_is_header_field(fields[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Returns true if we know from its recorded event header that the frame
+ * doesn't match the display filter. edt supplies an empty tree to build
+ * the header fields in.
+ */
+static bool
+cf_frame_fails_syscall_columns(capture_file *cf, const frame_data *fdata,
+        dfilter_t *dfcode, epan_dissect_t *edt)
+{
+    syscall_columns_t *cols = cf->syscall_columns;
+    wtap_syscall_header syscall_header = {0};
+    unsigned idx = fdata->num - 1;
+    bool failed = false;
+
+    if (idx >= cols->present->len || !g_array_index(cols->present, uint8_t, idx)) {
+        return false;
+    }
+    syscall_header.cpu_id = g_array_index(cols->cpu_id, uint16_t, idx);
+    syscall_header.event_type = g_array_index(cols->event_type, uint16_t, idx);
+    syscall_header.thread_id = g_array_index(cols->thread_id, uint64_t, idx);
+    syscall_header.event_len = g_array_index(cols->event_len, uint32_t, idx);
+    syscall_header.event_data_len = g_array_index(cols->event_data_len, uint32_t, idx);
+    syscall_header.nparams = g_array_index(cols->nparams, uint32_t, idx);
+
+    epan_dissect_prime_with_dfilter(edt, dfcode);
+    if (sysdig_event_add_header_tree(edt->tree, &syscall_header)) {
+        failed = !dfilter_apply_edt(dfcode, edt);
+    }
+    /* Nothing was dissected, so there's no record or data sources for
+     * epan_dissect_reset() to free. */
+    proto_tree_reset(edt->tree);
+    wmem_free_all(edt->pi.pool);
+    return failed;
+}
+
+/*
+ * The summary tallies are kept up to date as frames are added, filtered
+ * and marked, so that the capture file properties don't have to go
+ * through every frame. Taking a frame out of a tally can leave its time
+ * span too wide, in which case summary_fill_in() recomputes them all.
+ */
+static void
+frame_tally_add(frame_tally *tally, const frame_data *fdata)
+{
+    tally->count++;
+    tally->bytes += fdata->pkt_len;
+    if (fdata->has_ts) {
+        double cur_time = nstime_to_sec(&fdata->abs_ts);
+
+        if (tally->count_ts == 0 || cur_time < tally->start)
+            tally->start = cur_time;
+        if (tally->count_ts == 0 || cur_time > tally->stop)
+            tally->stop = cur_time;
+        tally->count_ts++;
+    }
+}
+
+static void
+frame_tally_remove(capture_file *cf, frame_tally *tally, const frame_data *fdata)
+{
+    if (tally->count == 0) {
+        cf->tally_valid = false;
+        return;
+    }
+    tally->count--;
+    tally->bytes -= fdata->pkt_len;
+    if (fdata->has_ts && tally->count_ts > 0) {
+        double cur_time = nstime_to_sec(&fdata->abs_ts);
+
+        tally->count_ts--;
+        if (tally->count_ts > 0 && (cur_time <= tally->start || cur_time >= tally->stop))
+            cf->tally_valid = false;
+    }
 }
 
 static void
@@ -1231,6 +1701,10 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
 
     /* Dissect the frame. */
     epan_dissect_run_with_taps(edt, cf->cd_t, rec, fdata, cinfo);
+    cf_record_frame_protos(cf, fdata, &edt->pi);
+    if (rec->rec_type == REC_TYPE_SYSCALL) {
+        cf_record_syscall_columns(cf, fdata, &rec->rec_header.syscall_header);
+    }
 
     if (fdata->passed_dfilter && dfcode != NULL) {
         fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
@@ -1248,6 +1722,8 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
         cf->displayed_count++;
         fdata->dis_num = cf->displayed_count;
     }
+    if (fdata->passed_dfilter)
+        frame_tally_add(&cf->tally_displayed, fdata);
 
     if (add_to_packet_list) {
         /* We fill the needed columns from new_packet_list */
@@ -1329,6 +1805,7 @@ add_new_record_to_record_list(capture_file *cf, wtap_rec *rec,
         fdata = frame_data_sequence_add(cf->provider.frames, &fdlocal);
 
         cf->count++;
+        frame_tally_add(&cf->tally_all, fdata);
         if (rec->block != NULL) {
             uint64_t dropcount = 0;
 
@@ -1340,6 +1817,11 @@ add_new_record_to_record_list(capture_file *cf, wtap_rec *rec,
         }
         cf->f_datalen = offset + fdlocal.cap_len;
 
+        if (cf->ngram_index != NULL) {
+            frame_ngram_index_add(cf->ngram_index, fdata->num,
+                    ws_buffer_start_ptr(&rec->data), fdata->cap_len);
+        }
+
         // Should we check if the frame data is a duplicate, and thus, ignore
         // this frame?
         if (frame_cksum != NULL && rec->rec_type == REC_TYPE_PACKET) {
@@ -1524,7 +2006,7 @@ cf_filter_packets(capture_file *cf, char *dftext, bool force)
          * and try to compile it.
          */
         dftext = g_strdup(dftext);
-        if (!dfilter_compile(dftext, &dfcode, &df_err)) {
+        if (!dfilter_compile_cached(dftext, &dfcode, &df_err)) {
             /* The attempt failed; report an error. */
             simple_message_box(ESD_TYPE_ERROR, NULL,
                     "See the help for a description of the display filter syntax.",
@@ -1543,6 +2025,13 @@ cf_filter_packets(capture_file *cf, char *dftext, bool force)
         }
     }
 
+    /* A filter that implies the current one can't match a frame the
+     * current one rejected, so the rescan only has to test the frames
+     * that are displayed now. That holds only if each frame's
+     * passed_dfilter still reflects the current filter (or a wider one). */
+    cf->dfilter_narrowed = cf->passed_dfilter_superset && dfcode != NULL &&
+        dfilter_implies(dfcode, cf->dfcode);
+
     /* We have a valid filter.  Replace the current filter. */
     g_free(cf->dfilter);
     cf->dfilter = dftext;
@@ -1672,6 +2161,14 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, bo
     bool        compiled _U_;
     uint32_t    frames_count;
     rescan_type queued_rescan_type = RESCAN_NONE;
+    const int  *required_protos = NULL;
+    int         num_required_protos = 0;
+    dfilter_frame_bounds_t frame_bounds;
+    bool        have_frame_bounds = false;
+    epan_dissect_t *syscall_edt = NULL;
+    stream_frames_cursor_t *stream_cursor = NULL;
+    bool        taps_limited;
+    bool        narrowing;
 
     if (cf->state == FILE_CLOSED || cf->state == FILE_READ_PENDING) {
         return;
@@ -1697,7 +2194,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, bo
      * once, reducing the chances of that)... (#19612)
      */
     if (cf->dfilter) {
-        compiled = dfilter_compile(cf->dfilter, &dfcode, NULL);
+        compiled = dfilter_compile_cached(cf->dfilter, &dfcode, NULL);
         ws_assert(compiled && dfcode);
     }
 
@@ -1726,6 +2223,48 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, bo
                         cf->dfcode, "Rescanning packets with display filter");
     }
 
+    /* Tap listeners that only look at frames the display filter matches
+     * (e.g. Follow Stream's, which uses the same filter) don't need to
+     * see the others. */
+    taps_limited = !tap_listeners_require_dissection() ||
+        (cf->dfcode != NULL && tap_listeners_limited_to(cf->dfcode));
+
+    /* If the display filter can only match frames containing certain
+     * protocols, frames we've already seen without them can be rejected
+     * without dissecting them again. That isn't possible if we're
+     * redissecting (the protocols seen might change) or if a tap
+     * listener needs to see every frame. */
+    if (!redissect && cf->dfcode != NULL && taps_limited) {
+        required_protos = dfilter_required_protocols(cf->dfcode, &num_required_protos);
+
+        /* Limits on frame metadata such as the frame number or time can
+         * be checked against the frame_data itself. */
+        have_frame_bounds = dfilter_frame_bounds(cf->dfcode, &frame_bounds);
+
+        /* Likewise, a filter that only looks at system call event header
+         * fields can be checked against the header fields we recorded. */
+        if (cf_dfilter_uses_syscall_columns(cf, cf->dfcode)) {
+            syscall_edt = epan_dissect_new(cf->epan, true, false);
+        }
+
+        /* And a filter on a stream index, such as "tcp.stream eq 5", can
+         * only match the frames the first pass put in that stream. */
+        stream_cursor = stream_frames_cursor_new(cf->dfcode, cf->count);
+    }
+
+    /* If the display filter was narrowed (e.g. something was and'ed onto
+     * it), frames that didn't pass the old filter can't pass the new one
+     * and needn't be dissected again. The same conditions apply as for
+     * the required protocols. */
+    narrowing = cf->dfilter_narrowed && !redissect && cf->dfcode != NULL &&
+        taps_limited;
+    cf->dfilter_narrowed = false;
+
+    /* Frames we don't get to, if we're stopped, keep their old
+     * passed_dfilter; that's only a superset of what the new filter
+     * matches if the new filter narrows the old one. */
+    cf->passed_dfilter_superset = narrowing;
+
     /* Get the union of the flags for all tap listeners. */
     tap_flags = union_of_tap_listener_flags();
 
@@ -1776,7 +2315,13 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, bo
            want to dissect those before their time. */
         cf->redissecting = true;
 
+        /* The protocols found in each frame will be recorded again. */
+        cf_free_frame_protos(cf);
+        ph_frame_stacks_free(cf->ph_stacks);
+        cf->ph_stacks = NULL;
+
         /* 'reset' dissection session */
+        cf_export_jobs_stop(cf);
         epan_free(cf->epan);
         if (cf->edt && cf->edt->pi.fd) {
             /* All pointers in "per frame proto data" for the currently selected
@@ -1808,6 +2353,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, bo
 
     /* We currently don't display any packets */
     cf->displayed_count = 0;
+    memset(&cf->tally_displayed, 0, sizeof(cf->tally_displayed));
 
     /* Iterate through the list of frames.  Call a routine for each frame
        to check whether it should be displayed and, if so, add it to
@@ -1858,6 +2404,21 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, bo
         wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
     }
 
+    /*
+     * XXX - When we aren't redissecting, every frame has been visited
+     * and the filter result depends only on the frame, so in principle
+     * the frames could be split into chunks and filtered in parallel,
+     * each chunk with its own epan_dissect_t, merging passed_dfilter and
+     * dependent_of_displayed afterwards. That isn't safe yet: the packet
+     * scope allocator, the proto tree's field info cache, the random
+     * access wtap handle and cf_read_record()'s buffer are shared, and
+     * many dissectors still update conversation, reassembly or expert
+     * state on revisits without any way to say so. Until those are per
+     * dissection (or dissectors can declare that they're revisit-safe),
+     * we stay serial and instead avoid dissecting frames the filter
+     * can't match (see required_protos, frame_bounds, stream_cursor and
+     * narrowing above).
+     */
     for (framenum = 1; framenum <= frames_count; framenum++) {
         fdata = frame_data_sequence_find(cf->provider.frames, framenum);
 
@@ -1932,6 +2493,33 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, bo
         /* Frame dependencies from the previous dissection/filtering are no longer valid. */
         fdata->dependent_of_displayed = 0;
 
+        if (!fdata->ref_time && ((narrowing && !fdata->passed_dfilter) ||
+                (stream_cursor != NULL && !stream_frames_cursor_has(stream_cursor, fdata->num)) ||
+                (have_frame_bounds && cf_frame_outside_bounds(fdata, &frame_bounds)) ||
+                (num_required_protos > 0 &&
+                 cf_frame_lacks_protos(cf, fdata, required_protos, num_required_protos)) ||
+                (syscall_edt != NULL &&
+                 cf_frame_fails_syscall_columns(cf, fdata, cf->dfcode, syscall_edt)))) {
+            /* The display filter can't match this frame; do only the
+             * bookkeeping add_packet_to_packet_list() would do for a
+             * frame that didn't pass it. */
+            frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                    &cf->provider.ref, cf->provider.prev_dis);
+            cf->provider.prev_cap = fdata;
+            fdata->passed_dfilter = 0;
+
+            if (prev_frame_num != -1 && !selected_frame_seen && prev_frame->passed_dfilter) {
+                preceding_frame_num = prev_frame_num;
+                preceding_frame = prev_frame;
+            }
+            if (fdata == selected_frame) {
+                selected_frame_seen = true;
+            }
+            prev_frame_num = fdata->num;
+            prev_frame = fdata;
+            continue;
+        }
+
         if (!cf_read_record(cf, fdata, &rec))
             break; /* error reading the frame */
 
@@ -1968,8 +2556,20 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, bo
     }
 
     epan_dissect_cleanup(&edt);
+    stream_frames_cursor_free(stream_cursor);
+    if (syscall_edt != NULL) {
+        epan_dissect_free(syscall_edt);
+    }
     wtap_rec_cleanup(&rec);
 
+    if (framenum > frames_count) {
+        /* Every frame has been tested against the new filter. */
+        cf->passed_dfilter_superset = true;
+    } else {
+        /* The frames after this still have their old passed_dfilter. */
+        cf->tally_valid = false;
+    }
+
     /* We are done redissecting the packet list. */
     cf->redissecting = false;
 
@@ -2181,11 +2781,25 @@ typedef enum {
     PSP_FAILED
 } psp_return_t;
 
+/* What a copy callback did with a record. */
+typedef enum {
+    PSP_RECORD_READ,     /* nothing; read it and pass it to the callback */
+    PSP_RECORD_COPIED,   /* dealt with it without it being read */
+    PSP_RECORD_FAILED    /* failed, and reported the error */
+} psp_record_t;
+
+/*
+ * As process_specified_records(), but each record is first offered to
+ * copy_callback, which can deal with it without it being read. Once
+ * every record has been processed, copy_callback is called once more
+ * with a NULL frame_data, to finish off.
+ */
 static psp_return_t
-process_specified_records(capture_file *cf, packet_range_t *range,
+process_specified_records_with_copy(capture_file *cf, packet_range_t *range,
         const char *string1, const char *string2, bool terminate_is_stop,
         bool (*callback)(capture_file *, frame_data *,
             wtap_rec *, void *),
+        psp_record_t (*copy_callback)(capture_file *, frame_data *, void *),
         void *callback_args,
         bool show_progress_bar)
 {
@@ -2286,6 +2900,17 @@ process_specified_records(capture_file *cf, packet_range_t *range,
             }
         }
 
+        if (copy_callback != NULL) {
+            psp_record_t copied = copy_callback(cf, fdata, callback_args);
+
+            if (copied == PSP_RECORD_FAILED) {
+                ret = PSP_FAILED;
+                break;
+            }
+            if (copied == PSP_RECORD_COPIED)
+                continue;
+        }
+
         /* Get the packet */
         if (!cf_read_record(cf, fdata, &rec)) {
             /* Attempt to get the packet failed. */
@@ -2301,6 +2926,10 @@ process_specified_records(capture_file *cf, packet_range_t *range,
         wtap_rec_reset(&rec);
     }
 
+    if (ret == PSP_FINISHED && copy_callback != NULL &&
+            copy_callback(cf, NULL, callback_args) == PSP_RECORD_FAILED)
+        ret = PSP_FAILED;
+
     /* We're done printing the packets; destroy the progress bar if
        it was created. */
     if (progbar != NULL)
@@ -2315,6 +2944,18 @@ process_specified_records(capture_file *cf, packet_range_t *range,
     return ret;
 }
 
+static psp_return_t
+process_specified_records(capture_file *cf, packet_range_t *range,
+        const char *string1, const char *string2, bool terminate_is_stop,
+        bool (*callback)(capture_file *, frame_data *,
+            wtap_rec *, void *),
+        void *callback_args,
+        bool show_progress_bar)
+{
+    return process_specified_records_with_copy(cf, range, string1, string2,
+            terminate_is_stop, callback, NULL, callback_args, show_progress_bar);
+}
+
 typedef struct {
     epan_dissect_t edt;
     column_info *cinfo;
@@ -3188,6 +3829,597 @@ cf_write_json_packets(capture_file *cf, print_args_t *print_args)
     return CF_PRINT_OK;
 }
 
+/*
+ * Background dissection exports.
+ *
+ * A job redissects the selected frames with views of the frozen session,
+ * one per worker thread, and reads their records again through a wtap
+ * of its own, so that it doesn't share the provider's wtap with the GUI.
+ * Workers take frames in order; each formats its frame into a slot of a
+ * window of slots, and a writer thread writes the slots out in order,
+ * so the output is the same as cf_write_*_packets() would write. The
+ * window bounds how far the workers can get ahead of the writer.
+ *
+ * XXX - the frames' modified blocks (edited comments) are looked up in
+ * the provider while the GUI may be changing them.
+ */
+
+#define EXPORT_JOB_MAX_THREADS      8
+#define EXPORT_JOB_SLOTS_PER_THREAD 4
+
+typedef struct {
+    cf_export_job_t *job;
+    GThread     *thread;
+    epan_view_t *view;
+    column_info  cinfo;
+    wtap_rec     rec;
+    FILE        *scratch;       /* holds one formatted frame, for the print routines that write to a FILE */
+    char        *scratch_name;
+    json_dumper  jdumper;
+} export_worker_t;
+
+struct _cf_export_job {
+    capture_file       *cf;
+    cf_export_format_e  format;
+    char               *capture_filename;
+    char               *output_filename;
+    print_dissections_e print_dissections;
+    bool                print_hex;
+    bool                no_duplicate_keys;
+    int                 file_type_subtype;
+    GPtrArray          *frames;         /* frame_data * of the selected frames, in order */
+    wtap               *wth;
+    FILE               *fh;
+    json_dumper         jdumper;
+
+    unsigned            num_workers;
+    export_worker_t    *workers;
+    GThread            *writer;
+    bool                joined;
+
+    /* Protected by mutex. */
+    GMutex              mutex;
+    GCond               cond;
+    unsigned            window;
+    GByteArray        **slots;          /* frame i is in slots[i % window] until written */
+    unsigned            next;           /* the next frame for a worker to take */
+    unsigned            written;        /* the number of frames written */
+    bool                stop;
+    bool                finished;       /* true once the writer is done */
+    int                 read_err;
+    char               *read_err_info;
+    int                 write_err;
+};
+
+bool
+cf_can_export_in_background(capture_file *cf)
+{
+    return cf->state == FILE_READ_DONE && cf->filename != NULL &&
+        cf->epan != NULL && !cf->redissecting &&
+        cf->redissection_queued == RESCAN_NONE;
+}
+
+/* Called with the mutex held, so that frames are read in order. */
+static bool
+export_job_read(cf_export_job_t *job, const frame_data *fdata, wtap_rec *rec)
+{
+    int64_t offset;
+
+    /*
+     * Read on to the frame, skipping the frames that weren't selected
+     * (and any records the read filter dropped). Reading sequentially
+     * also leaves the wtap knowing the interfaces and other blocks that
+     * come before the record, which seeking to it might not.
+     */
+    do {
+        wtap_rec_reset(rec);
+        if (!wtap_read(job->wth, rec, &job->read_err, &job->read_err_info, &offset)) {
+            if (job->read_err == 0) {
+                /* The file is shorter than it was when we read it. */
+                job->read_err = WTAP_ERR_SHORT_READ;
+            }
+            return false;
+        }
+    } while (offset < fdata->file_off);
+
+    if (offset != fdata->file_off) {
+        job->read_err = WTAP_ERR_SHORT_READ;
+        return false;
+    }
+    return true;
+}
+
+/* Format a frame into out; on failure, *err is an errno value. */
+static bool
+export_worker_format(export_worker_t *worker, frame_data *fdata,
+        GByteArray *out, int *err)
+{
+    cf_export_job_t *job = worker->job;
+    epan_dissect_t *edt;
+    column_info *cinfo = NULL;
+    long len;
+
+    edt = epan_view_prepare(worker->view);
+    if (job->format == CF_EXPORT_PSML || job->format == CF_EXPORT_CSV) {
+        cinfo = &worker->cinfo;
+        col_custom_prime_edt(edt, cinfo);
+    }
+    edt = epan_view_dissect(worker->view, job->file_type_subtype,
+            &worker->rec, fdata, cinfo);
+    if (edt == NULL) {
+        /* Not dissected yet, so not shown either; there's nothing to write. */
+        return true;
+    }
+    if (cinfo != NULL)
+        epan_dissect_fill_in_columns(edt, false, true);
+
+    if (job->format == CF_EXPORT_JSON) {
+        GString *json = worker->jdumper.output_string;
+        const char *start;
+
+        g_string_truncate(json, 0);
+        write_json_proto_tree(NULL, job->print_dissections, job->print_hex,
+                edt, &worker->cinfo,
+                job->no_duplicate_keys ?
+                    proto_node_group_children_by_json_key :
+                    proto_node_group_children_by_unique,
+                &worker->jdumper);
+
+        /* Leave out the separator; the writer's dumper adds its own. */
+        start = strchr(json->str, '{');
+        if (start != NULL)
+            g_byte_array_append(out, (const uint8_t *)start,
+                    (unsigned)(json->len - (start - json->str)) + 1);
+        return true;
+    }
+
+    rewind(worker->scratch);
+    switch (job->format) {
+
+        case CF_EXPORT_PDML:
+            write_pdml_proto_tree(NULL, edt, &worker->cinfo, worker->scratch, false);
+            break;
+
+        case CF_EXPORT_PSML:
+            write_psml_columns(edt, worker->scratch, false);
+            break;
+
+        case CF_EXPORT_CSV:
+            write_csv_columns(edt, worker->scratch);
+            break;
+
+        case CF_EXPORT_CARRAYS:
+            write_carrays_hex_data(fdata->num, worker->scratch, edt);
+            break;
+
+        default:
+            ws_assert_not_reached();
+    }
+
+    len = ftell(worker->scratch);
+    if (ferror(worker->scratch) || len < 0) {
+        *err = errno;
+        return false;
+    }
+    rewind(worker->scratch);
+    g_byte_array_set_size(out, (unsigned)len);
+    if (fread(out->data, 1, (size_t)len, worker->scratch) != (size_t)len) {
+        *err = ferror(worker->scratch) ? errno : EIO;
+        return false;
+    }
+    return true;
+}
+
+static void *
+export_worker_thread(void *data)
+{
+    export_worker_t *worker = (export_worker_t *)data;
+    cf_export_job_t *job = worker->job;
+
+    for (;;) {
+        frame_data *fdata;
+        GByteArray *out;
+        unsigned    idx;
+        bool        ok;
+        int         err = 0;
+
+        g_mutex_lock(&job->mutex);
+        while (!job->stop && job->next < job->frames->len &&
+                job->next >= job->written + job->window)
+            g_cond_wait(&job->cond, &job->mutex);
+        if (job->stop || job->next >= job->frames->len) {
+            g_mutex_unlock(&job->mutex);
+            break;
+        }
+        idx = job->next++;
+        fdata = (frame_data *)g_ptr_array_index(job->frames, idx);
+        if (!export_job_read(job, fdata, &worker->rec)) {
+            job->stop = true;
+            g_cond_broadcast(&job->cond);
+            g_mutex_unlock(&job->mutex);
+            break;
+        }
+        g_mutex_unlock(&job->mutex);
+
+        out = g_byte_array_new();
+        ok = export_worker_format(worker, fdata, out, &err);
+
+        g_mutex_lock(&job->mutex);
+        if (ok) {
+            job->slots[idx % job->window] = out;
+        } else {
+            g_byte_array_unref(out);
+            if (job->write_err == 0)
+                job->write_err = err;
+            job->stop = true;
+        }
+        g_cond_broadcast(&job->cond);
+        g_mutex_unlock(&job->mutex);
+        if (!ok)
+            break;
+    }
+
+    return NULL;
+}
+
+static void *
+export_writer_thread(void *data)
+{
+    cf_export_job_t *job = (cf_export_job_t *)data;
+    bool failed;
+    int err = 0;
+
+    g_mutex_lock(&job->mutex);
+    while (!job->stop && job->written < job->frames->len) {
+        unsigned slot = job->written % job->window;
+        GByteArray *out = job->slots[slot];
+
+        if (out == NULL) {
+            g_cond_wait(&job->cond, &job->mutex);
+            continue;
+        }
+        job->slots[slot] = NULL;
+        g_mutex_unlock(&job->mutex);
+
+        if (out->len > 0) {
+            if (job->format == CF_EXPORT_JSON)
+                json_dumper_value_anyf(&job->jdumper, "%s", (const char *)out->data);
+            else
+                fwrite(out->data, 1, out->len, job->fh);
+        }
+        g_byte_array_unref(out);
+        if (ferror(job->fh))
+            err = errno;
+
+        g_mutex_lock(&job->mutex);
+        if (err != 0) {
+            job->write_err = err;
+            job->stop = true;
+        } else {
+            job->written++;
+        }
+        g_cond_broadcast(&job->cond);
+    }
+    failed = job->write_err != 0;
+    g_mutex_unlock(&job->mutex);
+
+    /* Like the synchronous exports, a stopped export is still finished off. */
+    if (!failed) {
+        switch (job->format) {
+
+            case CF_EXPORT_PDML:
+                write_pdml_finale(job->fh);
+                break;
+
+            case CF_EXPORT_PSML:
+                write_psml_finale(job->fh);
+                break;
+
+            case CF_EXPORT_JSON:
+                write_json_finale(&job->jdumper);
+                break;
+
+            default:
+                break;
+        }
+        if (ferror(job->fh))
+            err = errno;
+    }
+    if (fclose(job->fh) == EOF && err == 0 && !failed)
+        err = errno;
+    job->fh = NULL;
+
+    g_mutex_lock(&job->mutex);
+    if (err != 0 && job->write_err == 0)
+        job->write_err = err;
+    job->finished = true;
+    g_cond_broadcast(&job->cond);
+    g_mutex_unlock(&job->mutex);
+
+    return NULL;
+}
+
+static void
+export_job_free_workers(cf_export_job_t *job)
+{
+    for (unsigned i = 0; i < job->num_workers; i++) {
+        export_worker_t *worker = &job->workers[i];
+
+        epan_view_free(worker->view);
+        col_cleanup(&worker->cinfo);
+        wtap_rec_cleanup(&worker->rec);
+        if (worker->scratch != NULL)
+            fclose(worker->scratch);
+        if (worker->scratch_name != NULL) {
+            ws_unlink(worker->scratch_name);
+            g_free(worker->scratch_name);
+        }
+        if (worker->jdumper.output_string != NULL)
+            g_string_free(worker->jdumper.output_string, TRUE);
+    }
+    g_free(job->workers);
+    job->workers = NULL;
+    job->num_workers = 0;
+}
+
+/* Stop the job if it's still running and wait for its threads. */
+static void
+export_job_join(cf_export_job_t *job)
+{
+    if (job->joined)
+        return;
+
+    g_mutex_lock(&job->mutex);
+    if (!job->finished)
+        job->stop = true;
+    g_cond_broadcast(&job->cond);
+    g_mutex_unlock(&job->mutex);
+
+    for (unsigned i = 0; i < job->num_workers; i++) {
+        if (job->workers[i].thread != NULL)
+            g_thread_join(job->workers[i].thread);
+    }
+    if (job->writer != NULL)
+        g_thread_join(job->writer);
+
+    /* Views are freed by the thread that owns the session. */
+    export_job_free_workers(job);
+    wtap_close(job->wth);
+    job->wth = NULL;
+    for (unsigned i = 0; i < job->window; i++) {
+        if (job->slots[i] != NULL)
+            g_byte_array_unref(job->slots[i]);
+    }
+
+    job->cf->export_jobs = g_slist_remove(job->cf->export_jobs, job);
+    job->joined = true;
+}
+
+/*
+ * Called before anything frees the session or the frames, or closes,
+ * moves or replaces the file, that the jobs are using.
+ */
+static void
+cf_export_jobs_stop(capture_file *cf)
+{
+    while (cf->export_jobs != NULL)
+        export_job_join((cf_export_job_t *)cf->export_jobs->data);
+}
+
+cf_export_job_t *
+cf_export_job_start(capture_file *cf, cf_export_format_e format,
+        print_args_t *print_args, cf_print_status_t *status)
+{
+    cf_export_job_t *job;
+    const char *single_file[1];
+    const char *const *fnames;
+    unsigned     num_files;
+    unsigned     num_workers;
+    wtap        *wth;
+    int          err;
+    char        *err_info;
+    GPtrArray   *frames;
+    FILE        *fh;
+    bool         proto_tree_needed;
+
+    *status = CF_PRINT_OK;
+
+    if (!cf_can_export_in_background(cf))
+        return NULL;
+
+    if (cf->set_filenames != NULL) {
+        fnames = (const char *const *)cf->set_filenames;
+        num_files = g_strv_length(cf->set_filenames);
+    } else {
+        single_file[0] = cf->filename;
+        fnames = single_file;
+        num_files = 1;
+    }
+    wth = wtap_open_offline_multi(fnames, num_files, cf->open_type, &err, &err_info, false, application_configuration_environment_prefix());
+    if (wth == NULL) {
+        /* Let the caller export it the usual way, which reports any problem. */
+        g_free(err_info);
+        return NULL;
+    }
+
+    frames = g_ptr_array_new();
+    packet_range_process_init(&print_args->range);
+    for (uint32_t framenum = 1; framenum <= cf->count; framenum++) {
+        frame_data *fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+        range_process_e process_this = packet_range_process_packet(&print_args->range, fdata);
+
+        if (process_this == range_process_next)
+            continue;
+        if (process_this == range_processing_finished)
+            break;
+        g_ptr_array_add(frames, fdata);
+    }
+
+    fh = ws_fopen(print_args->file, "w");
+    if (fh == NULL) {
+        g_ptr_array_free(frames, TRUE);
+        wtap_close(wth);
+        *status = CF_PRINT_OPEN_ERROR;
+        return NULL;
+    }
+
+    job = g_new0(cf_export_job_t, 1);
+    job->cf = cf;
+    job->format = format;
+    job->capture_filename = g_strdup(cf->filename);
+    job->output_filename = g_strdup(print_args->file);
+    job->print_dissections = print_args->print_dissections;
+    job->print_hex = print_args->print_hex;
+    job->no_duplicate_keys = print_args->no_duplicate_keys;
+    job->file_type_subtype = cf->cd_t;
+    job->frames = frames;
+    job->wth = wth;
+    job->fh = fh;
+    g_mutex_init(&job->mutex);
+    g_cond_init(&job->cond);
+
+    switch (format) {
+
+        case CF_EXPORT_PDML:
+            write_pdml_preamble(fh, cf->filename, get_doc_dir(application_configuration_environment_prefix()));
+            break;
+
+        case CF_EXPORT_PSML:
+            write_psml_preamble(&cf->cinfo, fh);
+            break;
+
+        case CF_EXPORT_CSV:
+            write_csv_column_titles(&cf->cinfo, fh);
+            break;
+
+        case CF_EXPORT_JSON:
+            job->jdumper = write_json_preamble(fh);
+            break;
+
+        case CF_EXPORT_CARRAYS:
+            break;
+    }
+
+    /* Views of the session are only possible once it's frozen. */
+    epan_freeze(cf->epan);
+
+    if (format == CF_EXPORT_PSML || format == CF_EXPORT_CSV)
+        proto_tree_needed = have_custom_cols(&cf->cinfo) || have_field_extractors();
+    else
+        proto_tree_needed = true;
+
+    num_workers = MIN((unsigned)g_get_num_processors(), EXPORT_JOB_MAX_THREADS);
+    num_workers = MAX(num_workers, 1);
+    job->workers = g_new0(export_worker_t, num_workers);
+    for (unsigned i = 0; i < num_workers; i++) {
+        export_worker_t *worker = &job->workers[i];
+
+        if (format == CF_EXPORT_JSON) {
+            worker->jdumper.output_string = g_string_new(NULL);
+            worker->jdumper.flags = JSON_DUMPER_FLAGS_PRETTY_PRINT;
+            /* Nest the frames as deep as in the output, so they're indented the same. */
+            json_dumper_begin_array(&worker->jdumper);
+        } else {
+            int fd = create_tempfile(NULL, &worker->scratch_name, "wireshark_export", NULL, NULL);
+
+            if (fd == -1)
+                break;
+            worker->scratch = ws_fdopen(fd, "w+b");
+            if (worker->scratch == NULL) {
+                ws_close(fd);
+                ws_unlink(worker->scratch_name);
+                g_free(worker->scratch_name);
+                worker->scratch_name = NULL;
+                break;
+            }
+        }
+        worker->job = job;
+        worker->view = epan_view_new(cf->epan, proto_tree_needed, proto_tree_needed);
+        build_column_format_array(&worker->cinfo, prefs.num_cols, false);
+        worker->cinfo.epan = cf->epan;
+        wtap_rec_init(&worker->rec, DEFAULT_INIT_BUFFER_SIZE_2048);
+        job->num_workers++;
+    }
+
+    if (ferror(fh) || job->num_workers < num_workers) {
+        /* The preamble couldn't be written, or there's nowhere to format the frames. */
+        job->joined = true;
+        export_job_free_workers(job);
+        fclose(fh);
+        wtap_close(wth);
+        g_ptr_array_free(frames, TRUE);
+        g_free(job->capture_filename);
+        g_free(job->output_filename);
+        g_mutex_clear(&job->mutex);
+        g_cond_clear(&job->cond);
+        g_free(job);
+        *status = CF_PRINT_WRITE_ERROR;
+        return NULL;
+    }
+
+    job->window = num_workers * EXPORT_JOB_SLOTS_PER_THREAD;
+    job->slots = g_new0(GByteArray *, job->window);
+    cf->export_jobs = g_slist_prepend(cf->export_jobs, job);
+
+    for (unsigned i = 0; i < num_workers; i++)
+        job->workers[i].thread = g_thread_new("Export worker", export_worker_thread, &job->workers[i]);
+    job->writer = g_thread_new("Export writer", export_writer_thread, job);
+
+    return job;
+}
+
+bool
+cf_export_job_poll(cf_export_job_t *job, unsigned *done, unsigned *total)
+{
+    bool running;
+
+    g_mutex_lock(&job->mutex);
+    running = !job->finished;
+    if (done != NULL)
+        *done = job->written;
+    if (total != NULL)
+        *total = job->frames->len;
+    g_mutex_unlock(&job->mutex);
+
+    return running;
+}
+
+void
+cf_export_job_cancel(cf_export_job_t *job)
+{
+    g_mutex_lock(&job->mutex);
+    job->stop = true;
+    g_cond_broadcast(&job->cond);
+    g_mutex_unlock(&job->mutex);
+}
+
+cf_print_status_t
+cf_export_job_finish(cf_export_job_t *job)
+{
+    cf_print_status_t status = CF_PRINT_OK;
+
+    export_job_join(job);
+
+    if (job->read_err != 0) {
+        report_cfile_read_failure(job->capture_filename, job->read_err, job->read_err_info);
+        job->read_err_info = NULL;
+        status = CF_PRINT_WRITE_ERROR;
+    } else if (job->write_err != 0) {
+        report_write_failure(job->output_filename, job->write_err);
+        status = CF_PRINT_WRITE_ERROR;
+    }
+
+    g_ptr_array_free(job->frames, TRUE);
+    g_free(job->slots);
+    g_free(job->capture_filename);
+    g_free(job->output_filename);
+    g_mutex_clear(&job->mutex);
+    g_cond_clear(&job->cond);
+    g_free(job);
+
+    return status;
+}
+
 bool
 cf_find_packet_protocol_tree(capture_file *cf, const char *string,
         search_direction dir, bool multiple)
@@ -3533,8 +4765,33 @@ typedef struct {
     const uint8_t *data;
     size_t        data_len;
     ws_mempbrk_pattern *pattern;
+    /* For ruling out frames with the n-gram index before matching */
+    ws_match_function match_function;
+    bool          try_narrow;
+    uint8_t      *wide_data;    /* data with a NUL after each byte but the last */
+    size_t        wide_len;
 } cbs_t;    /* "Counted byte string" */
 
+/*
+ * Skip reading and matching frames that the n-gram index says can't
+ * contain the narrow or wide form of the search data. The index folds
+ * ASCII case, so this works for case insensitive searches too.
+ */
+static match_result
+match_indexed(capture_file *cf, frame_data *fdata,
+        wtap_rec *rec, void *criterion)
+{
+    cbs_t *info = (cbs_t *)criterion;
+
+    if ((!info->try_narrow ||
+                !frame_ngram_index_may_contain(cf->ngram_index, fdata->num, info->data, info->data_len)) &&
+            (info->wide_data == NULL ||
+                !frame_ngram_index_may_contain(cf->ngram_index, fdata->num, info->wide_data, info->wide_len))) {
+        return MR_NOTMATCHED;
+    }
+    return info->match_function(cf, fdata, rec, criterion);
+}
+
 
 /*
  * The current match_* routines only support ASCII case insensitivity and don't
@@ -3559,9 +4816,13 @@ cf_find_packet_data(capture_file *cf, const uint8_t *string, size_t string_size,
     char needles[3];
     ws_mempbrk_pattern pattern = {0};
     ws_match_function match_function;
+    bool   result;
 
     info.data = string;
     info.data_len = string_size;
+    info.try_narrow = true;
+    info.wide_data = NULL;
+    info.wide_len = 0;
 
     /* Regex, String or hex search? */
     if (cf->regex) {
@@ -3620,6 +4881,19 @@ cf_find_packet_data(capture_file *cf, const uint8_t *string, size_t string_size,
         match_function = (dir == SD_FORWARD) ? match_binary : match_binary_reverse;
     }
 
+    if (cf->ngram_index != NULL && !cf->regex && string_size >= 3) {
+        if (cf->string && cf->scs_type != SCS_NARROW) {
+            info.try_narrow = cf->scs_type == SCS_NARROW_AND_WIDE;
+            info.wide_len = string_size * 2 - 1;
+            info.wide_data = (uint8_t *)g_malloc0(info.wide_len);
+            for (size_t i = 0; i < string_size; i++) {
+                info.wide_data[i * 2] = string[i];
+            }
+        }
+        info.match_function = match_function;
+        match_function = match_indexed;
+    }
+
     if (multiple && cf->current_frame && (cf->search_pos || cf->search_len)) {
         /* Use the current frame (this will perform the equivalent of
          * cf_read_current_record() in match_function).
@@ -3637,12 +4911,15 @@ cf_find_packet_data(capture_file *cf, const uint8_t *string, size_t string_size,
                 packet_list_select_row_from_data(cf->current_frame);
             }
             cf->search_in_progress = false;
+            g_free(info.wide_data);
             return true;
         }
     }
     cf->search_pos = 0; /* Reset the position */
     cf->search_len = 0; /* Reset length */
-    return find_packet(cf, match_function, &info, dir, true);
+    result = find_packet(cf, match_function, &info, dir, true);
+    g_free(info.wide_data);
+    return result;
 }
 
 static match_result
@@ -3659,6 +4936,12 @@ match_narrow_and_wide(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -3734,6 +5017,12 @@ match_narrow_and_wide_reverse(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -3741,10 +5030,6 @@ match_narrow_and_wide_reverse(capture_file *cf, frame_data *fdata,
     }
 
     result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
     buf_len = fdata->cap_len;
     buf_start = ws_buffer_start_ptr(&rec->data);
     buf_end = buf_start + buf_len;
@@ -3815,6 +5100,12 @@ match_narrow_and_wide_case(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -3893,6 +5184,12 @@ match_narrow_and_wide_case_reverse(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -3902,10 +5199,6 @@ match_narrow_and_wide_case_reverse(capture_file *cf, frame_data *fdata,
     ws_assert(pattern != NULL);
 
     result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
     buf_len = fdata->cap_len;
     buf_start = ws_buffer_start_ptr(&rec->data);
     buf_end = buf_start + buf_len;
@@ -3976,6 +5269,12 @@ match_narrow_case(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -4033,6 +5332,12 @@ match_narrow_case_reverse(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -4042,10 +5347,6 @@ match_narrow_case_reverse(capture_file *cf, frame_data *fdata,
     ws_assert(pattern != NULL);
 
     result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
     buf_len = fdata->cap_len;
     buf_start = ws_buffer_start_ptr(&rec->data);
     buf_end = buf_start + buf_len;
@@ -4093,6 +5394,12 @@ match_wide(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -4149,6 +5456,12 @@ match_wide_reverse(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -4156,10 +5469,6 @@ match_wide_reverse(capture_file *cf, frame_data *fdata,
     }
 
     result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
     buf_len = fdata->cap_len;
     buf_start = ws_buffer_start_ptr(&rec->data);
     buf_end = buf_start + buf_len;
@@ -4211,6 +5520,12 @@ match_wide_case(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -4271,6 +5586,12 @@ match_wide_case_reverse(capture_file *cf, frame_data *fdata,
     uint8_t       c_char;
     size_t        c_match    = 0;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (textlen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -4280,10 +5601,6 @@ match_wide_case_reverse(capture_file *cf, frame_data *fdata,
     ws_assert(pattern != NULL);
 
     result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
     buf_len = fdata->cap_len;
     buf_start = ws_buffer_start_ptr(&rec->data);
     buf_end = buf_start + buf_len;
@@ -4328,6 +5645,12 @@ match_binary(capture_file *cf, frame_data *fdata,
     match_result  result;
     const uint8_t *pd = NULL, *buf_start;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (datalen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -4363,6 +5686,12 @@ match_binary_reverse(capture_file *cf, frame_data *fdata,
     match_result  result;
     const uint8_t *pd = NULL, *buf_start;
 
+    /* Has to be room to hold the sought data; if not, don't bother
+       reading the frame. */
+    if (datalen > fdata->cap_len) {
+        return MR_NOTMATCHED;
+    }
+
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec)) {
         /* Attempt to get the packet failed. */
@@ -4371,10 +5700,6 @@ match_binary_reverse(capture_file *cf, frame_data *fdata,
 
     result = MR_NOTMATCHED;
     buf_start = ws_buffer_start_ptr(&rec->data);
-    /* Has to be room to hold the sought data. */
-    if (datalen > fdata->cap_len) {
-        return result;
-    }
     pd = buf_start + fdata->cap_len - datalen;
     if (cf->search_len || cf->search_pos) {
         /* we want to start searching one byte before the previous match start */
@@ -4444,26 +5769,45 @@ match_regex_reverse(capture_file *cf, frame_data *fdata,
         return MR_ERROR;
     }
 
-    size_t offset = fdata->cap_len - 1;
-    if (cf->search_pos) {
-        /* we want to start searching one byte before the previous match */
-        offset = cf->search_pos - 1;
+    if (fdata->cap_len == 0) {
+        return result;
     }
-    for (; offset > 0; offset--) {
-        if (ws_regex_matches_pos(cf->regex,
+    size_t limit = fdata->cap_len - 1;
+    if (cf->search_len || cf->search_pos) {
+        /* we want a match starting before the previous match */
+        if (cf->search_pos == 0) {
+            return result;
+        }
+        limit = cf->search_pos - 1;
+    }
+
+    /* PCRE2 only searches forward. Rather than retrying at every offset
+     * from the end of the frame backwards, which rescans the rest of the
+     * frame each time, step through the matches from the start of the
+     * frame and keep the last one that starts early enough. */
+    size_t match_pos[2];
+    size_t offset = 0;
+    while (offset <= limit &&
+            ws_regex_matches_pos(cf->regex,
                                     (const char *)ws_buffer_start_ptr(&rec->data),
                                     fdata->cap_len, offset,
-                                    result_pos)) {
-            //TODO: A chosen regex can match the empty string (zero length)
-            // which doesn't make a lot of sense for searching the packet bytes.
-            // Should we search with the PCRE2_NOTEMPTY option?
-            //TODO: Fix cast.
-            /* Save position and length for highlighting the field. */
-            cf->search_pos = (uint32_t)(result_pos[0]);
-            cf->search_len = (uint32_t)(result_pos[1] - result_pos[0]);
-            result = MR_MATCHED;
+                                    match_pos)) {
+        if (match_pos[0] > limit) {
             break;
         }
+        result_pos[0] = match_pos[0];
+        result_pos[1] = match_pos[1];
+        result = MR_MATCHED;
+        offset = match_pos[0] + 1;
+    }
+    if (result == MR_MATCHED) {
+        //TODO: A chosen regex can match the empty string (zero length)
+        // which doesn't make a lot of sense for searching the packet bytes.
+        // Should we search with the PCRE2_NOTEMPTY option?
+        //TODO: Fix cast.
+        /* Save position and length for highlighting the field. */
+        cf->search_pos = (uint32_t)(result_pos[0]);
+        cf->search_len = (uint32_t)(result_pos[1] - result_pos[0]);
     }
     return result;
 }
@@ -4936,6 +6280,7 @@ cf_mark_frame(capture_file *cf, frame_data *frame)
         frame->marked = true;
         if (cf->count > cf->marked_count)
             cf->marked_count++;
+        frame_tally_add(&cf->tally_marked, frame);
     }
 }
 
@@ -4949,6 +6294,7 @@ cf_unmark_frame(capture_file *cf, frame_data *frame)
         frame->marked = false;
         if (cf->marked_count > 0)
             cf->marked_count--;
+        frame_tally_remove(cf, &cf->tally_marked, frame);
     }
 }
 
@@ -5187,8 +6533,84 @@ typedef struct {
     const char  *fname;
     int          file_type;
     bool         export;
+    bool         copy_raw;  /* unchanged records can be copied as they are */
+    uint32_t     raw_num;   /* last frame of the run waiting to be copied, or 0 */
+    int64_t      raw_start; /* offset of the first record of the run */
+    int64_t      raw_last;  /* offset of the last record of the run */
 } save_callback_args_t;
 
+static void
+save_callback_args_init_raw(save_callback_args_t *args, capture_file *cf)
+{
+    args->copy_raw = wtap_dump_can_copy_raw(args->pdh, cf->provider.wth);
+    args->raw_num = 0;
+    args->raw_start = 0;
+    args->raw_last = 0;
+}
+
+/*
+ * Write out the run of records waiting to be copied.
+ */
+static bool
+save_raw_flush(capture_file *cf, save_callback_args_t *args)
+{
+    unsigned last_len;
+    bool     write_failed;
+    int      err;
+    char    *err_info;
+
+    if (args->raw_num == 0)
+        return true;
+
+    if (!wtap_raw_record_len(cf->provider.wth, args->raw_last, &last_len,
+                &err, &err_info)) {
+        report_cfile_read_failure(cf->filename, err, err_info);
+        return false;
+    }
+    if (!wtap_dump_copy_raw(args->pdh, cf->provider.wth, args->raw_start,
+                args->raw_last + last_len - args->raw_start, &write_failed,
+                &err, &err_info)) {
+        if (write_failed)
+            report_cfile_write_failure(NULL, args->fname, err, err_info,
+                    args->raw_num, args->file_type);
+        else
+            report_cfile_read_failure(cf->filename, err, err_info);
+        return false;
+    }
+    args->raw_num = 0;
+    return true;
+}
+
+/*
+ * Copy a record as it is in the file, if the output format allows and
+ * nothing about the record has been changed, rather than reading it and
+ * writing it out again. The records of consecutive frames are next to
+ * each other in the file, so runs of them are copied at once.
+ */
+static psp_record_t
+save_record_raw(capture_file *cf, frame_data *fdata, void *argsp)
+{
+    save_callback_args_t *args = (save_callback_args_t *)argsp;
+
+    if (fdata == NULL)
+        return save_raw_flush(cf, args) ? PSP_RECORD_COPIED : PSP_RECORD_FAILED;
+
+    if (!args->copy_raw || fdata->has_modified_block ||
+            !nstime_is_zero(frame_data_get_shift_offset(fdata))) {
+        /* It has to be written out with wtap_dump(), after the run. */
+        return save_raw_flush(cf, args) ? PSP_RECORD_READ : PSP_RECORD_FAILED;
+    }
+
+    if (args->raw_num == 0 || fdata->num != args->raw_num + 1) {
+        if (!save_raw_flush(cf, args))
+            return PSP_RECORD_FAILED;
+        args->raw_start = fdata->file_off;
+    }
+    args->raw_num = fdata->num;
+    args->raw_last = fdata->file_off;
+    return PSP_RECORD_COPIED;
+}
+
 /*
  * Save a capture to a file, in a particular format, saving either
  * all packets, all currently-displayed packets, or all marked packets.
@@ -5226,9 +6648,9 @@ save_record(capture_file *cf, frame_data *fdata, wtap_rec *rec, void *argsp)
      * and set the presence flag, so that time stamps aren't lost.
      */
 
-    if (!nstime_is_zero(&fdata->shift_offset)) {
+    if (!nstime_is_zero(frame_data_get_shift_offset(fdata))) {
         if (new_rec.presence_flags & WTAP_HAS_TS) {
-            nstime_add(&new_rec.ts, &fdata->shift_offset);
+            nstime_add(&new_rec.ts, frame_data_get_shift_offset(fdata));
         }
     }
 
@@ -5251,7 +6673,8 @@ save_record(capture_file *cf, frame_data *fdata, wtap_rec *rec, void *argsp)
      * If we're exporting to a different file, then don't do that.
      */
     if (!args->export && new_rec.presence_flags & WTAP_HAS_TS) {
-        nstime_set_zero(&fdata->shift_offset);
+        nstime_t no_shift = NSTIME_INIT_ZERO;
+        frame_data_set_shift_offset(fdata, &no_shift);
     }
 
     return true;
@@ -5562,16 +6985,20 @@ cf_save_records(capture_file *cf, const char *fname, unsigned save_format,
 
     cf_callback_invoke(cf_cb_file_save_started, (void *)fname);
 
+    /* The file may be moved, replaced or reopened. */
+    cf_export_jobs_stop(cf);
+
     addr_lists = get_addrinfo_list();
 
     if (save_format == cf->cd_t && compression_type == cf->compression_type
-            && !discard_comments && !cf->unsaved_changes
+            && !discard_comments && !cf->unsaved_changes && cf->set_filenames == NULL
             && (wtap_addrinfo_list_empty(addr_lists) || wtap_file_type_subtype_supports_block(save_format, WTAP_BLOCK_NAME_RESOLUTION) == BLOCK_NOT_SUPPORTED)) {
         /* We're saving in the format it's already in, and we're not discarding
            comments, and there are no changes we have in memory that aren't saved
            to the file, and we have no name resolution information to write or
            the file format we're saving in doesn't support writing name
-           resolution information, so we can just move or copy the raw data. */
+           resolution information, and it's a single file rather than a set
+           read as one, so we can just move or copy the raw data. */
 
         if (cf->is_tempfile) {
             /* The file being saved is a temporary file from a live
@@ -5693,8 +7120,9 @@ cf_save_records(capture_file *cf, const char *fname, unsigned save_format,
         callback_args.pdh = pdh;
         callback_args.fname = fname;
         callback_args.file_type = save_format;
-        switch (process_specified_records(cf, NULL, "Saving", "packets",
-                    true, save_record, &callback_args, true)) {
+        save_callback_args_init_raw(&callback_args, cf);
+        switch (process_specified_records_with_copy(cf, NULL, "Saving", "packets",
+                    true, save_record, save_record_raw, &callback_args, true)) {
 
             case PSP_FINISHED:
                 /* Completed successfully. */
@@ -5955,8 +7383,9 @@ cf_export_specified_packets(capture_file *cf, const char *fname,
     callback_args.pdh = pdh;
     callback_args.fname = fname;
     callback_args.file_type = save_format;
-    switch (process_specified_records(cf, range, "Writing", "specified records",
-                true, save_record, &callback_args, true)) {
+    save_callback_args_init_raw(&callback_args, cf);
+    switch (process_specified_records_with_copy(cf, range, "Writing", "specified records",
+                true, save_record, save_record_raw, &callback_args, true)) {
 
         case PSP_FINISHED:
             /* Completed successfully. */
@@ -6027,6 +7456,7 @@ cf_status_t
 cf_reload(capture_file *cf)
 {
     char     *filename;
+    char    **set_filenames;
     bool      is_tempfile;
     cf_status_t cf_status = CF_OK;
     int       err;
@@ -6047,9 +7477,12 @@ cf_reload(capture_file *cf)
        Also, "cf_close()" will free "cf->filename", so we must make
        a copy of it first. */
     filename = g_strdup(cf->filename);
+    set_filenames = g_strdupv(cf->set_filenames);
     is_tempfile = cf->is_tempfile;
     cf->is_tempfile = false;
-    if (cf_open(cf, filename, cf->open_type, is_tempfile, &err) == CF_OK) {
+    if ((set_filenames != NULL ?
+            cf_open_set(cf, (const char *const *)set_filenames, g_strv_length(set_filenames), cf->open_type, &err) :
+            cf_open(cf, filename, cf->open_type, is_tempfile, &err)) == CF_OK) {
         switch (cf_read(cf, /*reloading=*/true)) {
 
             case CF_READ_OK:
@@ -6077,5 +7510,6 @@ cf_reload(capture_file *cf)
     /* "cf_open()" made a copy of the file name we handed it, so
        we should free up our copy. */
     g_free(filename);
+    g_strfreev(set_filenames);
     return cf_status;
 }
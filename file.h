@@ -126,6 +126,19 @@ cf_callback_remove(cf_callback_t func, void *user_data);
  */
 cf_status_t cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile, int *err);
 
+/**
+ * Open a set of consecutive capture files, such as a ring buffer, as one
+ * capture, without merging them into a temporary file first.
+ *
+ * @param cf the capture file to be opened
+ * @param fnames the filenames to be opened, in time order
+ * @param num_files the number of filenames
+ * @param type WTAP_TYPE_AUTO for automatic or index to direct open routine
+ * @param err error code
+ * @return one of cf_status_t
+ */
+cf_status_t cf_open_set(capture_file *cf, const char *const *fnames, unsigned num_files, unsigned int type, int *err);
+
 /**
  * Close a capture file.
  *
@@ -181,13 +194,18 @@ bool cf_read_current_record(capture_file *cf);
 /**
  * Read packets from the "end" of a capture file.
  *
+ * So as not to hold up the UI when packets arrive faster than they can
+ * be dissected, this stops after a while even if there are more packets
+ * to read; the caller should read the rest later.
+ *
  * @param cf the capture file to be read from
- * @param to_read the number of packets to read
+ * @param to_read the number of packets to read; on return, the number
+ * of packets that were left for later
  * @param rec pointer to wtap_rec to use when reading
  * @param err the error code, if an error had occurred
  * @return one of cf_read_status_t
  */
-cf_read_status_t cf_continue_tail(capture_file *cf, volatile int to_read,
+cf_read_status_t cf_continue_tail(capture_file *cf, int *to_read,
                                   wtap_rec *rec, int *err,
                                   fifo_string_cache_t *frame_dup_cache, GChecksum *frame_cksum);
 
@@ -517,6 +535,75 @@ cf_print_status_t cf_write_carrays_packets(capture_file *cf, print_args_t *print
  */
 cf_print_status_t cf_write_json_packets(capture_file *cf, print_args_t *print_args);
 
+/** The formats that can be exported in the background. */
+typedef enum {
+    CF_EXPORT_PDML,
+    CF_EXPORT_PSML,
+    CF_EXPORT_CSV,
+    CF_EXPORT_CARRAYS,
+    CF_EXPORT_JSON
+} cf_export_format_e;
+
+/** A background export of packet dissections. */
+typedef struct _cf_export_job cf_export_job_t;
+
+/**
+ * Check whether the capture file can be exported in the background, i.e.
+ * it has been read completely and isn't about to be redissected.
+ *
+ * @param cf the capture file
+ * @return true if cf_export_job_start() can be used
+ */
+bool cf_can_export_in_background(capture_file *cf);
+
+/**
+ * Start exporting the capture file in the background, with the same
+ * output as the matching cf_write_*_packets() call. The frames are
+ * redissected on worker threads and written in order by another thread.
+ *
+ * Jobs are stopped, keeping what has been written so far, when the file
+ * is closed, saved or redissected.
+ *
+ * @param cf the capture file
+ * @param format the export format
+ * @param print_args the arguments what and how to export; the range is
+ * only used before this returns
+ * @param status [out] CF_PRINT_OPEN_ERROR if the output file couldn't be
+ * opened (errno is set), CF_PRINT_WRITE_ERROR if it couldn't be written,
+ * otherwise CF_PRINT_OK
+ * @return the job, or NULL if it couldn't be started; if status is
+ * CF_PRINT_OK, the caller can export the file with cf_write_*_packets()
+ */
+cf_export_job_t *cf_export_job_start(capture_file *cf, cf_export_format_e format,
+                                     print_args_t *print_args, cf_print_status_t *status);
+
+/**
+ * Check on a background export.
+ *
+ * @param job the job
+ * @param done [out] the number of frames written so far, or NULL
+ * @param total [out] the number of frames to write, or NULL
+ * @return true if it's still running
+ */
+bool cf_export_job_poll(cf_export_job_t *job, unsigned *done, unsigned *total);
+
+/**
+ * Ask a background export to stop; cf_export_job_poll() returns false
+ * once it has.
+ *
+ * @param job the job
+ */
+void cf_export_job_cancel(cf_export_job_t *job);
+
+/**
+ * Wait for a background export to end, report any error, and free it.
+ * Must be called from the thread that owns the capture file.
+ *
+ * @param job the job
+ * @return one of cf_print_status_t
+ */
+cf_print_status_t cf_export_job_finish(cf_export_job_t *job);
+
 /**
  * Find packet with a protocol tree item that contains a specified text string.
  *
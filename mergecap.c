@@ -48,6 +48,7 @@
 
 #define LONGOPT_COMPRESS                LONGOPT_BASE_APPLICATION+1
 #define LONGOPT_NO_MERGING_COMMENT      LONGOPT_BASE_APPLICATION+2
+#define LONGOPT_MAX_OPEN_FILES          LONGOPT_BASE_APPLICATION+3
 
 /*
  * Show the usage
@@ -71,6 +72,8 @@ print_usage(FILE *output)
     fprintf(output, "  --compress <type> compress the output file using the type compression format.\n");
     fprintf(output, "  --no-merging-comment\n");
     fprintf(output, "                    do not add \"File created by merging:\" comment.\n");
+    fprintf(output, "  --max-open-files <count>\n");
+    fprintf(output, "                    merge at most <count> files at once, through temporary files.\n");
     fprintf(output, "\n");
     fprintf(output, "Miscellaneous:\n");
     fprintf(output, "  -h, --help        display this help and exit.\n");
@@ -192,6 +195,7 @@ main(int argc, char *argv[])
         {"version", ws_no_argument, NULL, 'v'},
         {"compress", ws_required_argument, NULL, LONGOPT_COMPRESS},
         {"no-merging-comment", ws_no_argument, NULL, LONGOPT_NO_MERGING_COMMENT},
+        {"max-open-files", ws_required_argument, NULL, LONGOPT_MAX_OPEN_FILES},
         LONGOPT_WSLOG
         {0, 0, 0, 0 }
     };
@@ -323,6 +327,23 @@ main(int argc, char *argv[])
                 add_merging_comment = false;
                 break;
 
+            case LONGOPT_MAX_OPEN_FILES:
+            {
+                uint32_t max_open_files;
+
+                if (!get_nonzero_uint32(ws_optarg, "maximum number of open files", &max_open_files)) {
+                    status = false;
+                    goto clean_exit;
+                }
+                if (max_open_files < 2) {
+                    cmdarg_err("The maximum number of open files must be at least 2");
+                    status = false;
+                    goto clean_exit;
+                }
+                merge_set_max_open_files(max_open_files);
+                break;
+            }
+
             case '?':              /* Bad options if GNU getopt */
             default:
                 /* wslog arguments are okay */
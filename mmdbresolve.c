@@ -11,6 +11,7 @@
  *
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -161,6 +162,13 @@ main(int argc, char *argv[])
 
         fprintf(stdout, "[%s]\n", addr_str);
 
+        // The most specific network any database returned its answer for.
+        // Every address in that network gets the same combined result, which
+        // lets the caller answer lookups for its neighbors from its cache.
+        bool is_ipv4 = strchr(addr_str, ':') == NULL;
+        unsigned prefix_len = 0;
+        bool prefix_valid = true;
+
 #ifdef MMDB_DEBUG_SLOW
 #ifdef _WIN32
         Sleep(1000);
@@ -171,6 +179,19 @@ main(int argc, char *argv[])
             fprintf(stdout, "# %s\n", mmdbs[mmdb_idx].metadata.database_type);
             MMDB_lookup_result_s result = MMDB_lookup_string(&mmdbs[mmdb_idx], addr_str, &gai_err, &mmdb_err);
 
+            if (gai_err == 0 && mmdb_err == MMDB_SUCCESS) {
+                unsigned netmask = result.netmask;
+                // IPv4 addresses in an IPv6 database are in ::/96.
+                if (is_ipv4 && mmdbs[mmdb_idx].metadata.ip_version == 6) {
+                    netmask = netmask > 96 ? netmask - 96 : 0;
+                }
+                if (netmask > prefix_len) {
+                    prefix_len = netmask;
+                }
+            } else {
+                prefix_valid = false;
+            }
+
             if (result.found_entry && gai_err == 0 && mmdb_err == MMDB_SUCCESS) {
                 for (size_t key_idx = 0; lookup_keys[key_idx][0]; key_idx++) {
                     MMDB_entry_data_s entry_data;
@@ -216,6 +237,9 @@ main(int argc, char *argv[])
                 // dump error info.
             }
         }
+        if (prefix_valid && prefix_len > 0) {
+            fprintf(stdout, "mmdbresolve.prefix_len: %u\n", prefix_len);
+        }
         fprintf(stdout, "# End %s\n", addr_str);
         fflush(stdout);
     }
@@ -0,0 +1,693 @@
+/* perfshark.c
+ * Dissection benchmark: reads a capture file into memory once and times
+ * repeated dissection passes over it.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#define WS_LOG_DOMAIN  LOG_DOMAIN_MAIN
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <locale.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <ws_exit_codes.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/column.h>
+#include <epan/conversation_table.h>
+#include <epan/packet.h>
+#include <epan/prefs.h>
+#include <epan/proto.h>
+#include <epan/rtd_table.h>
+#include <epan/srt_table.h>
+#include <epan/stat_tap_ui.h>
+#include <epan/tap.h>
+#include <epan/timestamp.h>
+#include <epan/dfilter/dfilter.h>
+
+#ifdef HAVE_PLUGINS
+#include <wsutil/plugins.h>
+#endif
+#include <wsutil/filesystem.h>
+#include <wsutil/privileges.h>
+#include <wsutil/clopts_common.h>
+#include <wsutil/cmdarg_err.h>
+#include <wsutil/json_dumper.h>
+#include <wsutil/report_message.h>
+#include <wsutil/time_util.h>
+#include <wsutil/version_info.h>
+#include <wsutil/wslog.h>
+#include <wsutil/ws_getopt.h>
+#include <app/application_flavor.h>
+
+#include <wiretap/wtap.h>
+
+#include "cfile.h"
+#include "ui/util.h"
+#include "ui/failure_message.h"
+#include "ui/taps.h"
+#include "ui/cli/tshark-tap.h"
+#include "cli_main.h"
+
+#define DEFAULT_PASSES  5
+
+/* The tap listeners in ui/cli refer to this. */
+capture_file cfile;
+
+/* A record, kept in memory for the whole run. */
+typedef struct {
+    wtap_rec      rec;
+    wtap_block_t  block;        /* epan_dissect_run() consumes rec.block */
+    frame_data   *fdata;
+} perf_packet_t;
+
+/* What one dissection pass took. */
+typedef struct {
+    int64_t   elapsed;          /* microseconds */
+    double    user_time;        /* seconds */
+    double    sys_time;         /* seconds */
+    uint32_t  passed;           /* frames that matched the display filter */
+} perf_pass_t;
+
+static int opt_passes = DEFAULT_PASSES;
+static bool opt_tree;
+static bool opt_visible;
+static bool opt_columns;
+static bool opt_revisit;
+static bool opt_per_protocol;
+
+static void
+print_usage(FILE *fp)
+{
+    fprintf(fp, "\n");
+    fprintf(fp, "Usage: perfshark [OPTIONS] -r <infile>\n");
+    fprintf(fp, "\n");
+    fprintf(fp, "Reads a capture file into memory, dissects it repeatedly and\n");
+    fprintf(fp, "writes the timings to the standard output as JSON.\n");
+    fprintf(fp, "\n");
+    fprintf(fp, "Options:\n");
+    fprintf(fp, "  -r <infile>              set the filename to read from\n");
+    fprintf(fp, "  -n <passes>              number of dissection passes (default: %d)\n", DEFAULT_PASSES);
+    fprintf(fp, "  -t, --tree               build a protocol tree\n");
+    fprintf(fp, "  -V, --visible            build a visible protocol tree, with labels\n");
+    fprintf(fp, "  -c, --columns            fill in the packet list columns\n");
+    fprintf(fp, "  -Y <display filter>      apply a display filter to each packet\n");
+    fprintf(fp, "  -z <statistics>          run a statistics tap; see tshark -z help\n");
+    fprintf(fp, "                           (the statistics aren't printed)\n");
+    fprintf(fp, "  -p, --per-protocol       time each protocol's dissectors and count\n");
+    fprintf(fp, "                           their packet scope allocations\n");
+    fprintf(fp, "      --revisit            keep the dissection state between passes,\n");
+    fprintf(fp, "                           so later passes revisit dissected frames\n");
+    fprintf(fp, "  -o <name>:<value>        override preference setting\n");
+    fprintf(fp, "  -C <config profile>      run with specified configuration profile\n");
+    fprintf(fp, "  -h, --help               display this help and exit\n");
+    fprintf(fp, "  -v, --version            print version\n");
+    fprintf(fp, "\n");
+    ws_log_print_usage(fp);
+}
+
+static epan_t *
+perfshark_epan_new(capture_file *cf)
+{
+    static const struct packet_provider_funcs funcs = {
+        cap_file_provider_get_frame_ts,
+        cap_file_provider_get_start_ts,
+        cap_file_provider_get_end_ts,
+        cap_file_provider_get_interface_name,
+        cap_file_provider_get_interface_description,
+        NULL,
+        cap_file_provider_get_process_id,
+        cap_file_provider_get_process_name,
+        cap_file_provider_get_process_uuid,
+    };
+
+    return epan_new(&cf->provider, &funcs);
+}
+
+/*
+ * Read every record in the file into memory, so that the passes measure
+ * dissection and not I/O.
+ */
+static bool
+load_cap_file(capture_file *cf, const char *fname, GArray *packets)
+{
+    wtap          *wth;
+    int            err;
+    char          *err_info = NULL;
+    int64_t        data_offset;
+    uint32_t       cum_bytes = 0;
+    perf_packet_t  pkt;
+    frame_data     fdlocal;
+
+    wth = wtap_open_offline(fname, WTAP_TYPE_AUTO, &err, &err_info, false,
+                            application_configuration_environment_prefix());
+    if (wth == NULL) {
+        report_cfile_open_failure(fname, err, err_info);
+        return false;
+    }
+
+    cf->provider.wth = wth;
+    cf->filename = g_strdup(fname);
+    cf->cd_t = wtap_file_type_subtype(wth);
+    cf->open_type = WTAP_TYPE_AUTO;
+    cf->snap = wtap_snapshot_length(wth);
+    cf->provider.frames = new_frame_data_sequence();
+
+    for (;;) {
+        wtap_rec_init(&pkt.rec, DEFAULT_INIT_BUFFER_SIZE_2048);
+        if (!wtap_read(wth, &pkt.rec, &err, &err_info, &data_offset)) {
+            wtap_rec_cleanup(&pkt.rec);
+            break;
+        }
+        pkt.block = pkt.rec.block;
+        pkt.rec.block = NULL;
+
+        frame_data_init(&fdlocal, cf->count + 1, &pkt.rec, data_offset, cum_bytes);
+        frame_data_set_after_dissect(&fdlocal, &cum_bytes);
+        pkt.fdata = frame_data_sequence_add(cf->provider.frames, &fdlocal);
+        cf->count++;
+        cf->f_datalen += ws_buffer_length(&pkt.rec.data);
+
+        g_array_append_val(packets, pkt);
+    }
+
+    /* Everything else is read from memory. */
+    wtap_sequential_close(wth);
+
+    if (err != 0) {
+        report_cfile_read_failure(fname, err, err_info);
+        return false;
+    }
+    return true;
+}
+
+static void
+run_pass(capture_file *cf, GArray *packets, dfilter_t *dfcode,
+         bool create_proto_tree, column_info *cinfo, perf_pass_t *pass)
+{
+    epan_dissect_t  edt;
+    uint32_t        cum_bytes = 0;
+    int64_t         start;
+    double          user_start, sys_start;
+
+    if (!opt_revisit || cf->epan == NULL) {
+        /* Start from scratch, as when the GUI redissects. */
+        epan_free(cf->epan);
+        cf->epan = perfshark_epan_new(cf);
+        cf->cinfo.epan = cf->epan;
+        for (unsigned i = 0; i < packets->len; i++) {
+            frame_data_reset(g_array_index(packets, perf_packet_t, i).fdata);
+        }
+    }
+    nstime_set_zero(&cf->elapsed_time);
+    cf->provider.ref = NULL;
+    cf->provider.prev_dis = NULL;
+    cf->provider.prev_cap = NULL;
+    reset_tap_listeners();
+
+    memset(pass, 0, sizeof(*pass));
+    get_resource_usage(&user_start, &sys_start);
+    start = g_get_monotonic_time();
+
+    epan_dissect_init(&edt, cf->epan, create_proto_tree, opt_visible);
+    for (unsigned i = 0; i < packets->len; i++) {
+        perf_packet_t *pkt = &g_array_index(packets, perf_packet_t, i);
+        frame_data    *fdata = pkt->fdata;
+
+        if (dfcode)
+            epan_dissect_prime_with_dfilter(&edt, dfcode);
+        if (cinfo)
+            col_custom_prime_edt(&edt, cinfo);
+
+        frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                &cf->provider.ref, cf->provider.prev_dis);
+
+        pkt->rec.block = wtap_block_ref(pkt->block);
+        epan_dissect_run_with_taps(&edt, cf->cd_t, &pkt->rec, fdata, cinfo);
+
+        fdata->passed_dfilter = dfcode ? dfilter_apply_edt(dfcode, &edt) : 1;
+        if (fdata->passed_dfilter)
+            pass->passed++;
+        if (cinfo)
+            epan_dissect_fill_in_columns(&edt, false, true);
+
+        frame_data_set_after_dissect(fdata, &cum_bytes);
+        cf->provider.prev_dis = cf->provider.prev_cap = fdata;
+
+        epan_dissect_reset(&edt);
+    }
+    epan_dissect_cleanup(&edt);
+
+    pass->elapsed = g_get_monotonic_time() - start;
+    get_resource_usage(&pass->user_time, &pass->sys_time);
+    pass->user_time -= user_start;
+    pass->sys_time -= sys_start;
+}
+
+static void
+dump_rate(json_dumper *dumper, const char *name, uint64_t count, int64_t elapsed)
+{
+    json_dumper_set_member_name(dumper, name);
+    json_dumper_value_double(dumper, elapsed > 0 ? (double)count * 1000000.0 / (double)elapsed : 0.0);
+}
+
+static void
+print_results_json(capture_file *cf, const char *dfilter, GPtrArray *taps,
+                   int64_t load_elapsed, perf_pass_t *passes)
+{
+    json_dumper dumper = {
+        .output_file = stdout,
+        .flags = JSON_DUMPER_FLAGS_PRETTY_PRINT,
+    };
+    int64_t best = 0;
+
+#define DUMP(name, val) \
+        json_dumper_set_member_name(&dumper, name); \
+        json_dumper_value_anyf(&dumper, "%"PRId64, (int64_t)(val))
+
+    json_dumper_begin_object(&dumper);
+    json_dumper_set_member_name(&dumper, "version");
+    json_dumper_value_string(&dumper, application_get_vcs_version_info_short());
+    json_dumper_set_member_name(&dumper, "path");
+    json_dumper_value_string(&dumper, cf->filename);
+    DUMP("packets", cf->count);
+    DUMP("bytes", cf->f_datalen);
+    json_dumper_set_member_name(&dumper, "tree");
+    json_dumper_value_anyf(&dumper, "%s", opt_tree ? "true" : "false");
+    json_dumper_set_member_name(&dumper, "visible");
+    json_dumper_value_anyf(&dumper, "%s", opt_visible ? "true" : "false");
+    json_dumper_set_member_name(&dumper, "columns");
+    json_dumper_value_anyf(&dumper, "%s", opt_columns ? "true" : "false");
+    json_dumper_set_member_name(&dumper, "revisit");
+    json_dumper_value_anyf(&dumper, "%s", opt_revisit ? "true" : "false");
+    if (dfilter) {
+        json_dumper_set_member_name(&dumper, "filter");
+        json_dumper_value_string(&dumper, dfilter);
+    }
+    json_dumper_set_member_name(&dumper, "taps");
+    json_dumper_begin_array(&dumper);
+    for (unsigned i = 0; i < taps->len; i++) {
+        json_dumper_value_string(&dumper, (const char *)g_ptr_array_index(taps, i));
+    }
+    json_dumper_end_array(&dumper);
+    json_dumper_set_member_name(&dumper, "time_unit");
+    json_dumper_value_string(&dumper, "microseconds");
+    DUMP("load", load_elapsed);
+
+    json_dumper_set_member_name(&dumper, "passes");
+    json_dumper_begin_array(&dumper);
+    for (int i = 0; i < opt_passes; i++) {
+        json_dumper_begin_object(&dumper);
+        DUMP("elapsed", passes[i].elapsed);
+        json_dumper_set_member_name(&dumper, "user_time");
+        json_dumper_value_double(&dumper, passes[i].user_time);
+        json_dumper_set_member_name(&dumper, "sys_time");
+        json_dumper_value_double(&dumper, passes[i].sys_time);
+        dump_rate(&dumper, "packets_per_sec", cf->count, passes[i].elapsed);
+        dump_rate(&dumper, "bytes_per_sec", cf->f_datalen, passes[i].elapsed);
+        DUMP("passed", passes[i].passed);
+        json_dumper_end_object(&dumper);
+        if (best == 0 || passes[i].elapsed < best)
+            best = passes[i].elapsed;
+    }
+    json_dumper_end_array(&dumper);
+
+    /* The fastest pass is the least disturbed by everything else. */
+    DUMP("best", best);
+    dump_rate(&dumper, "packets_per_sec", cf->count, best);
+    dump_rate(&dumper, "bytes_per_sec", cf->f_datalen, best);
+
+    if (opt_per_protocol) {
+        GPtrArray *stats = dissector_perf_get_stats();
+
+        /* Totals over all the passes; divide by "passes" for one. */
+        json_dumper_set_member_name(&dumper, "protocols");
+        json_dumper_begin_array(&dumper);
+        for (unsigned i = 0; i < stats->len; i++) {
+            const dissector_perf_t *perf = (const dissector_perf_t *)g_ptr_array_index(stats, i);
+
+            json_dumper_begin_object(&dumper);
+            json_dumper_set_member_name(&dumper, "name");
+            json_dumper_value_string(&dumper, proto_get_protocol_filter_name(perf->proto_id));
+            DUMP("calls", perf->calls);
+            DUMP("accepted", perf->accepted);
+            DUMP("total", perf->total_ns / 1000);
+            DUMP("self", perf->self_ns / 1000);
+            DUMP("total_bytes", perf->total_bytes);
+            DUMP("self_bytes", perf->self_bytes);
+            json_dumper_end_object(&dumper);
+        }
+        json_dumper_end_array(&dumper);
+        g_ptr_array_unref(stats);
+    }
+    json_dumper_end_object(&dumper);
+    json_dumper_finish(&dumper);
+
+#undef DUMP
+}
+
+int
+main(int argc, char **argv)
+{
+    char        *configuration_init_error;
+    char        *cf_name = NULL;
+    char        *dfilter = NULL;
+    dfilter_t   *dfcode = NULL;
+    df_error_t  *df_err = NULL;
+    GPtrArray   *prefs_args = g_ptr_array_new();
+    GPtrArray   *taps = g_ptr_array_new();
+    GArray      *packets = NULL;
+    perf_pass_t *passes = NULL;
+    int64_t      load_start, load_elapsed;
+    bool         create_proto_tree;
+    column_info *cinfo;
+    unsigned     tap_flags;
+    int          exit_status = EXIT_FAILURE;
+
+    const char* optstring = "hvC:n:o:pr:tVcY:z:";
+    static const struct ws_option long_options[] = {
+        { "help",         ws_no_argument,   0,  'h' },
+        { "version",      ws_no_argument,   0,  'v' },
+        { "tree",         ws_no_argument,   0,  't' },
+        { "visible",      ws_no_argument,   0,  'V' },
+        { "columns",      ws_no_argument,   0,  'c' },
+        { "per-protocol", ws_no_argument,   0,  'p' },
+        { "revisit",      ws_no_argument,   0, 1000 },
+        LONGOPT_WSLOG
+        { NULL,           0,                0,  0   }
+    };
+    int opt;
+    const struct file_extension_info* file_extensions;
+    unsigned num_extensions;
+    epan_app_data_t app_data;
+
+    /* Future proof by zeroing out all data */
+    memset(&app_data, 0, sizeof(app_data));
+
+    /* Set the program name. */
+    g_set_prgname("perfshark");
+
+    /*
+     * Set the C-language locale to the native environment and set the
+     * code page to UTF-8 on Windows.
+     */
+#ifdef _WIN32
+    setlocale(LC_ALL, ".UTF-8");
+#else
+    setlocale(LC_ALL, "");
+#endif
+
+    cmdarg_err_init(stderr_cmdarg_err, stderr_cmdarg_err_cont);
+
+    /* Initialize log handler early for startup. */
+    ws_log_init(vcmdarg_err, "Perfshark Debug Console");
+
+    /* Early logging command-line initialization. */
+    ws_log_parse_args(&argc, argv, optstring, long_options, vcmdarg_err, WS_EXIT_INVALID_OPTION);
+
+    ws_noisy("Finished log init and parsing command line log arguments");
+
+    /*
+     * Get credential information for later use.
+     */
+    init_process_policies();
+
+    /*
+     * Attempt to get the pathname of the directory containing the
+     * executable file.
+     */
+    configuration_init_error = configuration_init(argv[0], "wireshark");
+    if (configuration_init_error != NULL) {
+        fprintf(stderr, "Error: Can't get pathname of directory containing "
+                        "the perfshark program: %s.\n",
+            configuration_init_error);
+        g_free(configuration_init_error);
+    }
+
+    initialize_funnel_ops();
+
+    ws_init_version_info("Perfshark", NULL, application_get_vcs_version_info, NULL, NULL);
+
+    for (;;) {
+        opt = ws_getopt_long(argc, argv, optstring, long_options, NULL);
+        if (opt == -1)
+            break;
+
+        switch (opt) {
+            case 'C':   /* Configuration Profile */
+                if (profile_exists (application_configuration_environment_prefix(), ws_optarg, false)) {
+                    set_profile_name (ws_optarg);
+                } else {
+                    cmdarg_err("Configuration Profile \"%s\" does not exist", ws_optarg);
+                    print_usage(stderr);
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto out;
+                }
+                break;
+            case 'n':
+                if (!get_positive_int(ws_optarg, "number of passes", &opt_passes)) {
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto out;
+                }
+                break;
+            case 'o':
+                /* Applied once the preferences have been read. */
+                g_ptr_array_add(prefs_args, ws_optarg);
+                break;
+            case 'p':
+                opt_per_protocol = true;
+                break;
+            case 'r':
+                cf_name = ws_optarg;
+                break;
+            case 't':
+                opt_tree = true;
+                break;
+            case 'V':
+                opt_tree = true;
+                opt_visible = true;
+                break;
+            case 'c':
+                opt_columns = true;
+                break;
+            case 'Y':
+                dfilter = ws_optarg;
+                break;
+            case 'z':
+                /* Started once the dissectors have been registered. */
+                g_ptr_array_add(taps, ws_optarg);
+                break;
+            case 1000:
+                opt_revisit = true;
+                break;
+            case 'v':
+                show_version();
+                exit_status = EXIT_SUCCESS;
+                goto out;
+            case 'h':
+                show_help_header(NULL);
+                print_usage(stdout);
+                exit_status = EXIT_SUCCESS;
+                goto out;
+            case '?':
+                print_usage(stderr);
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto out;
+            default:
+                /* wslog arguments are okay */
+                if (ws_log_is_wslog_arg(opt))
+                    break;
+
+                ws_assert_not_reached();
+                break;
+        }
+    }
+
+    if (cf_name == NULL) {
+        cmdarg_err("A capture file must be given with -r.");
+        print_usage(stderr);
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto out;
+    }
+    if (argc > ws_optind) {
+        cmdarg_err("Unexpected argument \"%s\".", argv[ws_optind]);
+        print_usage(stderr);
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto out;
+    }
+
+    init_report_failure_message("perfshark");
+
+    timestamp_set_type(TS_RELATIVE);
+    timestamp_set_precision(TS_PREC_AUTO);
+    timestamp_set_seconds_type(TS_SECONDS_DEFAULT);
+
+    /*
+     * Libwiretap must be initialized before libwireshark is, so that
+     * dissection-time handlers for file-type-dependent blocks can
+     * register using the file type/subtype value for the file type.
+     */
+    application_file_extensions(&file_extensions, &num_extensions);
+    wtap_init(true, application_configuration_environment_prefix(), file_extensions, num_extensions);
+
+    /* Register all dissectors and tap listeners. */
+    app_data.env_var_prefix = application_configuration_environment_prefix();
+    app_data.col_fmt = application_columns();
+    app_data.num_cols = application_num_columns();
+    app_data.register_func = register_all_protocols;
+    app_data.handoff_func = register_all_protocol_handoffs;
+    app_data.tap_reg_listeners = tap_reg_listener;
+    if (!epan_init(NULL, NULL, true, &app_data)) {
+        exit_status = WS_EXIT_INIT_FAILED;
+        goto out;
+    }
+
+    conversation_table_set_gui_info(init_iousers);
+    endpoint_table_set_gui_info(init_endpoints);
+    srt_table_iterate_tables(register_srt_tables, NULL);
+    rtd_table_iterate_tables(register_rtd_tables, NULL);
+    stat_tap_iterate_tables(register_simple_stat_tables, NULL);
+
+    /* Load libwireshark settings from the current profile. */
+    epan_load_settings();
+
+    for (unsigned i = 0; i < prefs_args->len; i++) {
+        const char *pref = (const char *)g_ptr_array_index(prefs_args, i);
+        char *errmsg = NULL;
+
+        switch (prefs_set_pref(pref, &errmsg)) {
+
+            case PREFS_SET_OK:
+                break;
+
+            case PREFS_SET_SYNTAX_ERR:
+                cmdarg_err("Invalid -o flag \"%s\"%s%s", pref,
+                        errmsg ? ": " : "", errmsg ? errmsg : "");
+                g_free(errmsg);
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+
+            case PREFS_SET_NO_SUCH_PREF:
+                cmdarg_err("-o flag \"%s\" specifies unknown preference", pref);
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+
+            case PREFS_SET_OBSOLETE:
+                cmdarg_err("-o flag \"%s\" specifies obsolete preference", pref);
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+        }
+    }
+
+    /* notify all registered modules that have had any of their preferences
+       changed either from one of the preferences file or from the command
+       line that its preferences have changed. */
+    prefs_apply_all();
+
+    cap_file_init(&cfile);
+    build_column_format_array(&cfile.cinfo, prefs.num_cols, true);
+
+    if (dfilter) {
+        if (!dfilter_compile(dfilter, &dfcode, &df_err)) {
+            cmdarg_err("%s", df_err->msg);
+            df_error_free(&df_err);
+            exit_status = WS_EXIT_INVALID_FILTER;
+            goto clean_exit;
+        }
+    }
+
+    packets = g_array_new(false, false, sizeof(perf_packet_t));
+    load_start = g_get_monotonic_time();
+    if (!load_cap_file(&cfile, cf_name, packets)) {
+        exit_status = WS_EXIT_INVALID_FILE;
+        goto clean_exit;
+    }
+    load_elapsed = g_get_monotonic_time() - load_start;
+
+    for (unsigned i = 0; i < taps->len; i++) {
+        if (!process_stat_cmd_arg((const char *)g_ptr_array_index(taps, i))) {
+            cmdarg_err("Invalid -z argument \"%s\"; it must be one of:",
+                    (const char *)g_ptr_array_index(taps, i));
+            list_stat_cmd_args();
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+    }
+    if (!start_requested_stats()) {
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+
+    /* Build what the filter, the taps and the postdissectors need. */
+    tap_flags = union_of_tap_listener_flags();
+    create_proto_tree = opt_tree || dfcode != NULL ||
+            have_filtering_tap_listeners() ||
+            (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids();
+    cinfo = (opt_columns || (tap_flags & TL_REQUIRES_COLUMNS)) ? &cfile.cinfo : NULL;
+
+    passes = g_new0(perf_pass_t, opt_passes);
+    dissector_perf_enable(opt_per_protocol);
+    dissector_perf_reset();
+    for (int i = 0; i < opt_passes; i++) {
+        run_pass(&cfile, packets, dfcode, create_proto_tree, cinfo, &passes[i]);
+    }
+    dissector_perf_enable(false);
+
+    print_results_json(&cfile, dfilter, taps, load_elapsed, passes);
+    exit_status = EXIT_SUCCESS;
+
+clean_exit:
+    reset_tap_listeners();
+    if (packets) {
+        for (unsigned i = 0; i < packets->len; i++) {
+            perf_packet_t *pkt = &g_array_index(packets, perf_packet_t, i);
+
+            wtap_block_unref(pkt->block);
+            wtap_rec_cleanup(&pkt->rec);
+        }
+        g_array_free(packets, true);
+    }
+    g_free(passes);
+    dfilter_free(dfcode);
+    if (cfile.provider.frames != NULL) {
+        free_frame_data_sequence(cfile.provider.frames);
+        cfile.provider.frames = NULL;
+    }
+    if (cfile.provider.wth != NULL) {
+        wtap_close(cfile.provider.wth);
+        cfile.provider.wth = NULL;
+    }
+    g_free(cfile.filename);
+    col_cleanup(&cfile.cinfo);
+    epan_free(cfile.epan);
+    epan_cleanup();
+    wtap_cleanup();
+
+out:
+    g_ptr_array_free(prefs_args, true);
+    g_ptr_array_free(taps, true);
+    return exit_status;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -79,14 +79,22 @@ codec_l16_decode(codec_context_t *ctx _U_,
         return inputBytesSize/channels;
     }
 
-    /* Downmix to mono. No worries about overflow because tmp is 32 bit. */
-    for (i=0; i<inputBytesSize/(2 * channels); i++)
-    {
-        int32_t tmp = 0;
-        for (unsigned j=0; j < channels; j++) {
-            tmp += (int16_t)g_ntohs(dataIn[channels*i + j]);
+    if (channels == 1) {
+        /* Just a byte swap, which the compiler can do a vector at a time. */
+        for (i=0; i<inputBytesSize/2; i++)
+        {
+            dataOut[i] = g_ntohs(dataIn[i]);
+        }
+    } else {
+        /* Downmix to mono. No worries about overflow because tmp is 32 bit. */
+        for (i=0; i<inputBytesSize/(2 * channels); i++)
+        {
+            int32_t tmp = 0;
+            for (unsigned j=0; j < channels; j++) {
+                tmp += (int16_t)g_ntohs(dataIn[channels*i + j]);
+            }
+            dataOut[i] = (int16_t)(tmp / channels);
         }
-        dataOut[i] = (int16_t)(tmp / channels);
     }
 
     *outputSamplesSize = inputBytesSize/channels;
@@ -284,7 +284,8 @@ struct _mate_gop {
 	uint32_t id;
 	const mate_cfg_gop* cfg;
 
-	char* gop_key;
+	AVPL* key; /* the key avps, also the gop_index key */
+	char* gop_key; /* the key as a string, for display */
 	AVPL* avpl; /* the attributes of the pdu/gop/gog */
 	unsigned last_n;
 
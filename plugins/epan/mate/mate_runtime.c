@@ -32,7 +32,7 @@ typedef struct _tmp_pdu_data {
 
 
 typedef struct _gogkey {
-	char* key;
+	AVPL* key;
 	const mate_cfg_gop* cfg;
 } gogkey;
 
@@ -56,6 +56,7 @@ static void free_mate_pdu(mate_pdu *pdu)
 static void free_mate_gop(mate_gop *gop)
 {
 	g_free(gop->gop_key);
+	if (gop->key) delete_avpl(gop->key,true);
 	if (gop->avpl) delete_avpl(gop->avpl,true);
 	g_slice_free(mate_max_size, (mate_max_size *)gop);
 }
@@ -82,8 +83,9 @@ static gopcfg_runtime_data* get_gopcfg_rd(const mate_cfg_gop* cfg)
 	gopcfg_runtime_data* gop_rd = g_hash_table_lookup(rd->gopcfg_rd, cfg);
 	if (!gop_rd) {
 		gop_rd = g_new0(gopcfg_runtime_data, 1);
-		gop_rd->gop_index = g_hash_table_new(g_str_hash, g_str_equal);
-		gop_rd->gog_index = g_hash_table_new(g_str_hash, g_str_equal);
+		/* keyed by AVPL, compared by the (subscribed) names and values */
+		gop_rd->gop_index = g_hash_table_new(avpl_hash, avpl_equal);
+		gop_rd->gog_index = g_hash_table_new(avpl_hash, avpl_equal);
 		g_hash_table_insert(rd->gopcfg_rd, (void*)cfg, gop_rd);
 	}
 	return gop_rd;
@@ -132,16 +134,19 @@ void initialize_mate_runtime(mate_config* mc) {
 }
 
 
-static mate_gop* new_gop(const mate_cfg_gop* cfg, mate_pdu* pdu, char* key) {
+/* takes ownership of key, which must have its own copies of the avps */
+static mate_gop* new_gop(const mate_cfg_gop* cfg, mate_pdu* pdu, AVPL* key) {
 	mate_gop* gop = (mate_gop*)g_slice_new(mate_max_size);
 
 	gopcfg_runtime_data* gop_rd = get_gopcfg_rd(cfg);
 	gop->id = ++(gop_rd->last_id);
 	gop->cfg = cfg;
 
-	dbg_print(dbg_gop, 1, dbg_facility, "new_gop: %s: ``%s:%d''", key, gop->cfg->name, gop->id);
+	gop->key = key;
+	gop->gop_key = avpl_to_str(key);
+
+	dbg_print(dbg_gop, 1, dbg_facility, "new_gop: %s: ``%s:%d''", gop->gop_key, gop->cfg->name, gop->id);
 
-	gop->gop_key = key;
 	gop->avpl = new_avpl(cfg->name);
 	gop->last_n = 0;
 
@@ -170,7 +175,7 @@ static mate_gop* new_gop(const mate_cfg_gop* cfg, mate_pdu* pdu, char* key) {
 	pdu->time_in_gop = 0.0f;
 
 	g_hash_table_add(rd->gops, gop);
-	g_hash_table_insert(gop_rd->gop_index,gop->gop_key,gop);
+	g_hash_table_insert(gop_rd->gop_index,gop->key,gop);
 	return gop;
 }
 
@@ -263,7 +268,7 @@ static void gog_remove_keys(mate_gog* gog) {
 			g_hash_table_remove(gop_rd->gog_index,gog_key->key);
 		}
 
-		g_free(gog_key->key);
+		delete_avpl(gog_key->key,true);
 		g_free(gog_key);
 	}
 
@@ -301,18 +306,16 @@ static void reanalyze_gop(mate_config* mc, mate_gop* gop) {
 		while (( curr_gogkey = get_next_avpl(gog_keys,&cookie) )) {
 			gop_cfg = (const mate_cfg_gop *)g_hash_table_lookup(mc->gopcfgs,curr_gogkey->name);
 
-			if (( gogkey_match = new_avpl_pairs_match(gop_cfg->name, gog->avpl, curr_gogkey, true, false) )) {
+			if (( gogkey_match = new_avpl_pairs_match(gop_cfg->name, gog->avpl, curr_gogkey, true, true) )) {
 
 				gog_key = g_new(gogkey, 1);
 
-				gog_key->key = avpl_to_str(gogkey_match);
-				delete_avpl(gogkey_match,false);
-
+				gog_key->key = gogkey_match;
 				gog_key->cfg = gop_cfg;
 
 				gopcfg_runtime_data* gop_rd = get_gopcfg_rd(gop_cfg);
 				if (g_hash_table_lookup(gop_rd->gog_index,gog_key->key)) {
-					g_free(gog_key->key);
+					delete_avpl(gog_key->key,true);
 					g_free(gog_key);
 					gog_key = NULL;
 				}
@@ -322,7 +325,7 @@ static void reanalyze_gop(mate_config* mc, mate_gop* gop) {
 							we should try to merge (non released) gogs
 					        that happen to have equal keys */
 				} else {
-					dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: new key for gog=%s:%d : %s",gog->cfg->name,gog->id,gog_key->key);
+					dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: new key for gog=%s:%d",gog->cfg->name,gog->id);
 					g_ptr_array_add(gog->gog_keys,gog_key);
 					g_hash_table_insert(gop_rd->gog_index,gog_key->key,gog);
 				}
@@ -348,7 +351,6 @@ static void analyze_gop(mate_config* mc, mate_gop* gop) {
 	void* cookie = NULL;
 	AVPL* gogkey_match = NULL;
 	mate_gog* gog = NULL;
-	char* key = NULL;
 	gopcfg_runtime_data* gop_rd = get_gopcfg_rd(gop->cfg);
 
 	if ( ! gop->gog  ) {
@@ -369,11 +371,9 @@ static void analyze_gop(mate_config* mc, mate_gop* gop) {
 		while (( curr_gogkey = get_next_avpl(gog_keys,&cookie) )) {
 			if (( gogkey_match = new_avpl_pairs_match(gop->cfg->name, gop->avpl, curr_gogkey, true, true) )) {
 
-				key = avpl_to_str(gogkey_match);
+				dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: got gogkey_match: %s",curr_gogkey->name);
 
-				dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: got gogkey_match: %s",key);
-
-				if (( gog = (mate_gog *)g_hash_table_lookup(gop_rd->gog_index,key) )) {
+				if (( gog = (mate_gog *)g_hash_table_lookup(gop_rd->gog_index,gogkey_match) )) {
 					dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: got already a matching gog: %s:%d",gog->cfg->name,gog->id);
 
 					if (gog->num_of_counting_gops == gog->num_of_released_gops && gog->expiration < rd->now) {
@@ -416,9 +416,6 @@ static void analyze_gop(mate_config* mc, mate_gop* gop) {
 			}
 		} /* while */
 
-		g_free(key);
-		key = NULL;
-
 		if (gogkey_match) delete_avpl(gogkey_match,true);
 
 		reanalyze_gop(mc, gop);
@@ -434,8 +431,7 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 	*/
 	const mate_cfg_gop* cfg = NULL;
 	mate_gop* gop = NULL;
-	char* gop_key;
-	char* orig_gop_key = NULL;
+	AVPL* gop_key = NULL;
 	AVPL* candidate_start = NULL;
 	AVPL* candidate_stop = NULL;
 	AVPL* is_start = NULL;
@@ -445,7 +441,6 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 	AVPL* curr_gogkey = NULL;
 	void* cookie = NULL;
 	AVPL* gogkey_match = NULL;
-	char* gogkey_str = NULL;
 
 	dbg_print (dbg_gop,1,dbg_facility,"analyze_pdu: %s",pdu->cfg->name);
 
@@ -455,15 +450,16 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 	gopcfg_runtime_data* gop_rd = get_gopcfg_rd(cfg);
 
 	if ((gopkey_match = new_avpl_pairs_match("gop_key_match", pdu->avpl, cfg->key, true, true))) {
-		gop_key = avpl_to_str(gopkey_match);
-
-		if (g_hash_table_lookup_extended(gop_rd->gop_index,(const void *)gop_key,(void * *)&orig_gop_key,(void * *)&gop)) {
-			g_free(gop_key);
+		/*
+		 * Look the gop up by the key avps themselves rather than by
+		 * a string made from them; this is done for every pdu.
+		 */
+		if (( gop = (mate_gop *)g_hash_table_lookup(gop_rd->gop_index,gopkey_match) )) {
 
 			/* is the gop dead ? */
 			if ( ! gop->released &&
-				 ( ( gop->cfg->lifetime > 0.0 && gop->time_to_die >= rd->now) ||
-				   ( gop->cfg->idle_timeout > 0.0 && gop->time_to_timeout >= rd->now) ) ) {
+				 ( ( gop->cfg->lifetime > 0.0 && gop->time_to_die < rd->now) ||
+				   ( gop->cfg->idle_timeout > 0.0 && gop->time_to_timeout < rd->now) ) ) {
 				dbg_print (dbg_gop,4,dbg_facility,"analyze_pdu: expiring released gop");
 				gop->released = true;
 
@@ -472,9 +468,7 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 
 			/* TODO: is the gop expired? */
 
-			gop_key = orig_gop_key;
-
-			dbg_print (dbg_gop,2,dbg_facility,"analyze_pdu: got gop: %s",gop_key);
+			dbg_print (dbg_gop,2,dbg_facility,"analyze_pdu: got gop: %s",gop->gop_key);
 
 			if (( candidate_start = cfg->start )) {
 
@@ -485,10 +479,8 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 					if ( gop->released ) {
 						dbg_print (dbg_gop,3,dbg_facility,"analyze_pdu: start on released gop, let's create a new gop");
 
-						g_hash_table_remove(gop_rd->gop_index,gop_key);
-						gop->gop_key = NULL;
-						gop = new_gop(cfg,pdu,gop_key);
-						g_hash_table_insert(gop_rd->gop_index,gop_key,gop);
+						g_hash_table_remove(gop_rd->gop_index,gop->key);
+						gop = new_gop(cfg,pdu,new_avpl_from_avpl(cfg->name,gop->key,true));
 					} else {
 						dbg_print (dbg_gop,1,dbg_facility,"analyze_pdu: duplicate start on gop");
 					}
@@ -512,6 +504,9 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 				/* there is no GopStart, we'll check for matching GogKeys
 				if we have one we'll create the Gop */
 
+				/* the key is what matched, before any extras */
+				gop_key = new_avpl_from_avpl(cfg->name,gopkey_match,true);
+
 				apply_extras(pdu->avpl,gopkey_match,cfg->extra);
 
 				gog_keys = (LoAL *)g_hash_table_lookup(mc->gogs_by_gopname,cfg->name);
@@ -520,29 +515,24 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 
 					while (( curr_gogkey = get_next_avpl(gog_keys,&cookie) )) {
 						if (( gogkey_match = new_avpl_pairs_match(cfg->name, gopkey_match, curr_gogkey, true, false) )) {
-							gogkey_str = avpl_to_str(gogkey_match);
-
-							if (g_hash_table_lookup(gop_rd->gog_index,gogkey_str)) {
+							if (g_hash_table_lookup(gop_rd->gog_index,gogkey_match)) {
 								gop = new_gop(cfg,pdu,gop_key);
-								g_hash_table_insert(gop_rd->gop_index,gop_key,gop);
 								delete_avpl(gogkey_match,false);
-								g_free(gogkey_str);
 								break;
 							} else {
 								delete_avpl(gogkey_match,false);
-								g_free(gogkey_str);
 							}
 						}
 					}
 
 					if ( ! gop ) {
-						g_free(gop_key);
+						delete_avpl(gop_key,true);
 						delete_avpl(gopkey_match,true);
 						return;
 					}
 
 				} else {
-					g_free(gop_key);
+					delete_avpl(gop_key,true);
 					delete_avpl(gopkey_match,true);
 					return;
 				}
@@ -552,9 +542,8 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 
 				if (( is_start = new_avpl_pairs_match("", pdu->avpl, candidate_start, true, false) )) {
 					delete_avpl(is_start,false);
-					gop = new_gop(cfg,pdu,gop_key);
+					gop = new_gop(cfg,pdu,new_avpl_from_avpl(cfg->name,gopkey_match,true));
 				} else {
-					g_free(gop_key);
 					delete_avpl(gopkey_match, true);
 					return;
 				}
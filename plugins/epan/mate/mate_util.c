@@ -775,6 +775,57 @@ extern char* avpl_to_dotstr(AVPL* avpl) {
 	return r;
 }
 
+/**
+ * avpl_hash:
+ * @param v the avpl to hash.
+ *
+ * Hashes the names and values of an avpl, for use as a GHashTable key.
+ * Names and values are subscribed to avp_strings, so equal strings are
+ * the same pointer and the pointers can be hashed instead of the text.
+ *
+ * Return value: the hash.
+ *
+ **/
+extern unsigned avpl_hash(const void *v) {
+	const AVPL* avpl = (const AVPL*)v;
+	const AVPN* c;
+	unsigned h = avpl->len;
+
+	for(c=avpl->null.next; c->avp; c = c->next) {
+		h = (h * 31) + g_direct_hash(c->avp->n);
+		h = (h * 31) + g_direct_hash(c->avp->v);
+	}
+
+	return h;
+}
+
+/**
+ * avpl_equal:
+ * @param a an avpl.
+ * @param b another avpl.
+ *
+ * Compares the names and values of two avpls, AVP by AVP, as
+ * avpl_to_str() of each would compare, without making the strings.
+ *
+ * Return value: whether they are equal.
+ *
+ **/
+extern gboolean avpl_equal(const void *a, const void *b) {
+	const AVPL* avpl_a = (const AVPL*)a;
+	const AVPL* avpl_b = (const AVPL*)b;
+	const AVPN* ca;
+	const AVPN* cb;
+
+	if (avpl_a->len != avpl_b->len) return FALSE;
+
+	for(ca=avpl_a->null.next, cb=avpl_b->null.next; ca->avp && cb->avp; ca = ca->next, cb = cb->next) {
+		if (ca->avp->n != cb->avp->n || ca->avp->o != cb->avp->o || ca->avp->v != cb->avp->v)
+			return FALSE;
+	}
+
+	return ca->avp == cb->avp;
+}
+
 /**
 * merge_avpl:
  * @param dst the avpl in which to merge the avps.
@@ -998,7 +1049,8 @@ extern AVPL* new_avpl_loose_match(const char* name,
 	cs = src->null.next;
 	co = op->null.next;
 	while (cs->avp && co->avp) {
-		int name_diff = strcmp(co->avp->n, cs->avp->n);
+		/* names are subscribed, so equal names are the same pointer */
+		int name_diff = co->avp->n == cs->avp->n ? 0 : strcmp(co->avp->n, cs->avp->n);
 
 		if (name_diff < 0) {
 			// op < source, op is not matching
@@ -1059,7 +1111,7 @@ extern AVPL* new_avpl_pairs_match(const char* name, AVPL* src, AVPL* op, bool st
 	cs = src->null.next;
 	co = op->null.next;
 	while (cs->avp && co->avp) {
-		int name_diff = g_strcmp0(co->avp->n, cs->avp->n);
+		int name_diff = co->avp->n == cs->avp->n ? 0 : g_strcmp0(co->avp->n, cs->avp->n);
 		const char *failed_match = NULL;
 
 		if (name_diff < 0) {
@@ -206,6 +206,10 @@ extern AVP* extract_avp_by_name(AVPL* avpl, char* name);
 extern char* avpl_to_str(AVPL* avpl);
 extern char* avpl_to_dotstr(AVPL*);
 
+/* hash and compare avp lists by their names and values, for GHashTable keys */
+extern unsigned avpl_hash(const void *v);
+extern gboolean avpl_equal(const void *a, const void *b);
+
 /* deletes an avp list  and eventually its contents */
 extern void delete_avpl(AVPL* avpl, bool avps_too);
 
@@ -198,12 +198,12 @@ static void ipv6_ptype_stats_tree_init(stats_tree *st) {
 }
 
 static tap_packet_status ipv4_ptype_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_, tap_flags_t flags _U_) {
-	stats_tree_tick_pivot(st, st_node_ipv4_ptype, port_type_to_str(pinfo->ptype));
+	stats_tree_tick_pivot_by_key(st, st_node_ipv4_ptype, pinfo->ptype, port_type_to_str(pinfo->ptype));
 	return TAP_PACKET_REDRAW;
 }
 
 static tap_packet_status ipv6_ptype_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_, tap_flags_t flags _U_) {
-	stats_tree_tick_pivot(st, st_node_ipv6_ptype, port_type_to_str(pinfo->ptype));
+	stats_tree_tick_pivot_by_key(st, st_node_ipv6_ptype, pinfo->ptype, port_type_to_str(pinfo->ptype));
 	return TAP_PACKET_REDRAW;
 }
 
@@ -103,12 +103,24 @@ in a message header
 static wmem_map_t *dcerpc_context_zero;
 
 /*
-    The rrpd_list holds information about all of the APDU Request-Response Pairs seen in the trace.
+    The RRPDs that can still be matched are indexed by stream, one hash for TCP and one for UDP, each indexed by
+    stream number.  Only entries that a later packet could still match are kept on a stream's list: once a GTCP or
+    GUDP RRPD has been followed by another one on the same stream nothing can find it again, and it is dropped
+    from the list.  The RRPDs themselves stay reachable through output_rrpd for the second scan.
  */
-static wmem_list_t *rrpd_list;
+typedef struct _RRPD_STREAM
+{
+    wmem_list_t *rrpds;             /* DCE-RPC, SMB2, SYN and the latest GTCP or GUDP RRPD, oldest first */
+    wmem_list_frame_t *generic;     /* the entry on rrpds holding the latest GTCP or GUDP RRPD */
+    wmem_map_t *dns_rrpds;          /* the latest DNS RRPD for each message ID */
+    RRPD *temp_rsp;                 /* this stream's temp_rsp_rrpd_list entry, see below */
+} RRPD_STREAM;
+
+static wmem_map_t *tcp_rrpd_streams;
+static wmem_map_t *udp_rrpd_streams;
 
 /*
-    output_rrpd is a hash of pointers to RRPDs on the rrpd_list.  The index is the frame number.  This hash is
+    output_rrpd is a hash of pointers to RRPDs.  The index is the frame number.  This hash is
     used during Wireshark's second scan.  As each packet is processed, TRANSUM uses the packet's frame number to index into
     this hash to determine if we have RTE data for this particular packet, and if so the write_rte function is called.
  */
@@ -118,10 +130,9 @@ static wmem_map_t *output_rrpd;
     The temp_rsp_rrpd_list holds RRPDs for APDUs where we have not yet seen the header information and so we can't
     fully qualify the identification of the RRPD (the identification being ip_proto:stream_no:session_id:msg_id).
     This only occurs when a) we are using one of the decode_based calculations (such as SMB2), and b) when we have
-    TCP Reassembly enabled.  Once we receive a header packet for an APDU we migrate the entry from this array to the
-    main rrpd_list.
+    TCP Reassembly enabled.  Once we receive a header packet for an APDU we migrate the entry to the stream's RRPDs.
+    A stream never has more than one of these at a time, so rather than a list each stream keeps its own as temp_rsp.
  */
-static wmem_list_t *temp_rsp_rrpd_list;  /* Reuse these for speed and efficient memory use - issue a warning if we run out */
 
 /* Optimisation data - the following is used for various optimisation measures */
 static int highest_tcp_stream_no;
@@ -224,14 +235,76 @@ static void update_output_rrpd(RRPD *in_rrpd)
         wmem_map_insert(output_rrpd, GUINT_TO_POINTER(in_rrpd->rsp_last_frame), in_rrpd);
 }
 
+/* Return the index entry for the RRPD's stream, creating it if asked to. */
+static RRPD_STREAM *find_rrpd_stream(RRPD *in_rrpd, bool create)
+{
+    wmem_map_t *streams;
+    RRPD_STREAM *stream;
+
+    if (in_rrpd->ip_proto == IP_PROTO_TCP)
+        streams = tcp_rrpd_streams;
+    else if (in_rrpd->ip_proto == IP_PROTO_UDP)
+        streams = udp_rrpd_streams;
+    else
+        return NULL;
+
+    stream = (RRPD_STREAM*)wmem_map_lookup(streams, GUINT_TO_POINTER(in_rrpd->stream_no));
+    if (stream == NULL && create)
+    {
+        stream = wmem_new0(wmem_file_scope(), RRPD_STREAM);
+        stream->rrpds = wmem_list_new(wmem_file_scope());
+        wmem_map_insert(streams, GUINT_TO_POINTER(in_rrpd->stream_no), stream);
+    }
+
+    return stream;
+}
+
+/* Return the tail of the list of RRPDs that could match the input RRPD */
+static wmem_list_frame_t *rrpd_stream_tail(RRPD *in_rrpd)
+{
+    RRPD_STREAM *stream = find_rrpd_stream(in_rrpd, false);
+
+    return stream != NULL ? wmem_list_tail(stream->rrpds) : NULL;
+}
+
 /* Return the index of the RRPD that has been appended */
 static RRPD* append_to_rrpd_list(RRPD *in_rrpd)
 {
     RRPD *next_rrpd = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+    RRPD_STREAM *stream;
 
     update_output_rrpd(next_rrpd);
 
-    wmem_list_append(rrpd_list, next_rrpd);
+    stream = find_rrpd_stream(next_rrpd, true);
+    if (stream == NULL)
+        return next_rrpd;
+
+    switch (next_rrpd->calculation)
+    {
+    case RTE_CALC_DNS:
+        /* DNS RRPDs are only ever matched by message ID */
+        if (stream->dns_rrpds == NULL)
+            stream->dns_rrpds = wmem_map_new(wmem_file_scope(), g_int64_hash, g_int64_equal);
+        wmem_map_insert(stream->dns_rrpds, &next_rrpd->msg_id, next_rrpd);
+        return next_rrpd;
+
+    case RTE_CALC_GTCP:
+    case RTE_CALC_GUDP:
+    case RTE_CALC_SYN:
+        /* The GTCP and GUDP searches stop at the first GTCP, GUDP or SYN entry and no other calculation
+           looks at GTCP or GUDP entries, so the previous one can never be matched again. */
+        if (stream->generic != NULL)
+        {
+            wmem_list_remove_frame(stream->rrpds, stream->generic);
+            stream->generic = NULL;
+        }
+        break;
+    }
+
+    wmem_list_append(stream->rrpds, next_rrpd);
+
+    if (next_rrpd->calculation == RTE_CALC_GTCP || next_rrpd->calculation == RTE_CALC_GUDP)
+        stream->generic = wmem_list_tail(stream->rrpds);
 
     return next_rrpd;
 }
@@ -241,67 +314,63 @@ static RRPD *find_latest_rrpd_dcerpc(RRPD *in_rrpd)
     RRPD *rrpd;
     wmem_list_frame_t* i;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    for (i = rrpd_stream_tail(in_rrpd); i != NULL; i = wmem_list_frame_prev(i))
     {
         rrpd = (RRPD*)wmem_list_frame_data(i);
 
         if (rrpd->calculation != RTE_CALC_DCERPC && rrpd->calculation != RTE_CALC_SYN)
             continue;
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
+        /* if we can match on session_id and msg_id must be a retransmission of the last request packet or the response */
+        /* this logic works whether or not we are using reassembly */
+        if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
+            return rrpd;
+
+        /* If this is a retransmission, we assume it relates to this rrpd_list entry.
+           This is a bit of a kludge and not ideal but a compromise.*/
+        /* ToDo: look at using TCP sequence number to allocate a retransmission to the correct APDU */
+        if (in_rrpd->is_retrans)
+            return rrpd;
+
+        if (preferences.reassembly)
         {
-            /* if we can match on session_id and msg_id must be a retransmission of the last request packet or the response */
-            /* this logic works whether or not we are using reassembly */
-            if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
-                return rrpd;
-
-            /* If this is a retransmission, we assume it relates to this rrpd_list entry.
-               This is a bit of a kludge and not ideal but a compromise.*/
-            /* ToDo: look at using TCP sequence number to allocate a retransmission to the correct APDU */
-            if (in_rrpd->is_retrans)
-                return rrpd;
-
-            if (preferences.reassembly)
+            if (in_rrpd->c2s)
             {
-                if (in_rrpd->c2s)
-                {
-                    /* if the input rrpd is for c2s and the one we have found already has response information, then the
-                    in_rrpd represents a new RR Pair. */
-                    if (rrpd->rsp_first_frame)
-                        return NULL;
-
-                    /* If the current rrpd_list entry doesn't have a msg_id then we assume we are mid Request APDU and so we have a match. */
-                    if (!rrpd->msg_id)
-                        return rrpd;
-                }
-                else  /* The in_rrpd relates to a packet going s2c */
-                {
-                    /* When reassembly is enabled, multi-packet response information is actually migrated from the temp_rsp_rrpd_list
-                    to the rrpd_list and so we won't come through here. */
-                    ;
-                }
+                /* if the input rrpd is for c2s and the one we have found already has response information, then the
+                in_rrpd represents a new RR Pair. */
+                if (rrpd->rsp_first_frame)
+                    return NULL;
+
+                /* If the current rrpd_list entry doesn't have a msg_id then we assume we are mid Request APDU and so we have a match. */
+                if (!rrpd->msg_id)
+                    return rrpd;
             }
-            else /* we are not using reassembly */
+            else  /* The in_rrpd relates to a packet going s2c */
             {
-                if (in_rrpd->c2s)
-                {
-                    if (in_rrpd->msg_id)
-                        /* if we have a message id this is a new Request APDU */
-                        return NULL;
-                    else  /* No msg_id */
-                    {
-                        return rrpd;  /* add this packet to the matching stream */
-                    }
-                }
-                else  /* this packet is going s2c */
+                /* When reassembly is enabled, multi-packet response information is actually migrated from the temp_rsp_rrpd_list
+                to the rrpd_list and so we won't come through here. */
+                ;
+            }
+        }
+        else /* we are not using reassembly */
+        {
+            if (in_rrpd->c2s)
+            {
+                if (in_rrpd->msg_id)
+                    /* if we have a message id this is a new Request APDU */
+                    return NULL;
+                else  /* No msg_id */
                 {
-                    if (!in_rrpd->msg_id && rrpd->rsp_first_frame)
-                        /* we need to add this frame to the response APDU of the most recent rrpd_list entry that has already had response packets */
-                        return rrpd;
+                    return rrpd;  /* add this packet to the matching stream */
                 }
             }
-        }  /* this is the end of the 5-tuple check */
+            else  /* this packet is going s2c */
+            {
+                if (!in_rrpd->msg_id && rrpd->rsp_first_frame)
+                    /* we need to add this frame to the response APDU of the most recent rrpd_list entry that has already had response packets */
+                    return rrpd;
+            }
+        }
 
         if (in_rrpd->c2s)
             in_rrpd->req_search_total++;
@@ -314,35 +383,21 @@ static RRPD *find_latest_rrpd_dcerpc(RRPD *in_rrpd)
 
 static RRPD *find_latest_rrpd_dns(RRPD *in_rrpd)
 {
+    RRPD_STREAM *stream;
     RRPD *rrpd;
-    wmem_list_frame_t* i;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
-    {
-        rrpd = (RRPD*)wmem_list_frame_data(i);
-
-        if (rrpd->calculation != RTE_CALC_DNS)
-            continue;
+    stream = find_rrpd_stream(in_rrpd, false);
+    if (stream == NULL || stream->dns_rrpds == NULL)
+        return NULL;
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
-            if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
-            {
-                if (in_rrpd->c2s && rrpd->rsp_first_frame)
-                    return NULL;  /* this is new */
-                else
-                    return rrpd;
-            }
-        }  /* this is the end of the 5-tuple check */
+    rrpd = (RRPD*)wmem_map_lookup(stream->dns_rrpds, &in_rrpd->msg_id);
+    if (rrpd == NULL || rrpd->session_id != in_rrpd->session_id)
+        return NULL;
 
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
-        else
-            in_rrpd->rsp_search_total++;
-    } /* this is the end of the for loop */
+    if (in_rrpd->c2s && rrpd->rsp_first_frame)
+        return NULL;  /* this is new */
 
-    return NULL;
+    return rrpd;
 }
 
 static RRPD *find_latest_rrpd_gtcp(RRPD *in_rrpd)
@@ -350,27 +405,18 @@ static RRPD *find_latest_rrpd_gtcp(RRPD *in_rrpd)
     RRPD *rrpd;
     wmem_list_frame_t* i;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    for (i = rrpd_stream_tail(in_rrpd); i != NULL; i = wmem_list_frame_prev(i))
     {
         rrpd = (RRPD*)wmem_list_frame_data(i);
 
         if (rrpd->calculation != RTE_CALC_GTCP && rrpd->calculation != RTE_CALC_SYN)
             continue;
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
-            if (in_rrpd->c2s && rrpd->rsp_first_frame)
-                return NULL;  /* this is new */
-            else
-                return rrpd;
-        }  /* this is the end of the 5-tuple check */
-
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
+        if (in_rrpd->c2s && rrpd->rsp_first_frame)
+            return NULL;  /* this is new */
         else
-            in_rrpd->rsp_search_total++;
-    } /* this is the end of the for loop */
+            return rrpd;
+    }
 
     return NULL;
 }
@@ -380,27 +426,18 @@ static RRPD *find_latest_rrpd_gudp(RRPD *in_rrpd)
     RRPD *rrpd;
     wmem_list_frame_t* i;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    for (i = rrpd_stream_tail(in_rrpd); i != NULL; i = wmem_list_frame_prev(i))
     {
         rrpd = (RRPD*)wmem_list_frame_data(i);
 
         if (rrpd->calculation != RTE_CALC_GUDP)
             continue;
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
-            if (in_rrpd->c2s && rrpd->rsp_first_frame)
-                return NULL;  /* this is new */
-            else
-                return rrpd;
-        }  /* this is the end of the 5-tuple check */
-
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
+        if (in_rrpd->c2s && rrpd->rsp_first_frame)
+            return NULL;  /* this is new */
         else
-            in_rrpd->rsp_search_total++;
-    } /* this is the end of the for loop */
+            return rrpd;
+    }
 
     return NULL;
 }
@@ -410,67 +447,63 @@ static RRPD *find_latest_rrpd_smb2(RRPD *in_rrpd)
     RRPD *rrpd;
     wmem_list_frame_t* i;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    for (i = rrpd_stream_tail(in_rrpd); i != NULL; i = wmem_list_frame_prev(i))
     {
         rrpd = (RRPD*)wmem_list_frame_data(i);
 
         if (rrpd->calculation != RTE_CALC_SMB2 && rrpd->calculation != RTE_CALC_SYN)
             continue;
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
+        /* if we can match on session_id and msg_id must be a retransmission of the last request packet or the response */
+        /* this logic works whether or not we are using reassembly */
+        if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
+            return rrpd;
+
+        /* If this is a retransmission, we assume it relates to this rrpd_list entry.
+        This is a bit of a kludge and not ideal but a compromise.*/
+        /* ToDo: look at using TCP sequence number to allocate a retransmission to the correct APDU */
+        if (in_rrpd->is_retrans)
+            return rrpd;
+
+        if (preferences.reassembly)
         {
-            /* if we can match on session_id and msg_id must be a retransmission of the last request packet or the response */
-            /* this logic works whether or not we are using reassembly */
-            if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
-                return rrpd;
-
-            /* If this is a retransmission, we assume it relates to this rrpd_list entry.
-            This is a bit of a kludge and not ideal but a compromise.*/
-            /* ToDo: look at using TCP sequence number to allocate a retransmission to the correct APDU */
-            if (in_rrpd->is_retrans)
-                return rrpd;
-
-            if (preferences.reassembly)
+            if (in_rrpd->c2s)
             {
-                if (in_rrpd->c2s)
-                {
-                    /* if the input rrpd is for c2s and the one we have found already has response information, then the
-                    in_rrpd represents a new RR Pair. */
-                    if (rrpd->rsp_first_frame)
-                        return NULL;
-
-                    /* If the current rrpd_list entry doesn't have a msg_id then we assume we are mid Request APDU and so we have a match. */
-                    if (!rrpd->msg_id)
-                        return rrpd;
-                }
-                else  /* The in_rrpd relates to a packet going s2c */
-                {
-                    /* When reassembly is enabled, multi-packet response information is actually migrated from the temp_rsp_rrpd_list
-                    to the rrpd_list and so we won't come through here. */
-                    ;
-                }
+                /* if the input rrpd is for c2s and the one we have found already has response information, then the
+                in_rrpd represents a new RR Pair. */
+                if (rrpd->rsp_first_frame)
+                    return NULL;
+
+                /* If the current rrpd_list entry doesn't have a msg_id then we assume we are mid Request APDU and so we have a match. */
+                if (!rrpd->msg_id)
+                    return rrpd;
             }
-            else /* we are not using reassembly */
+            else  /* The in_rrpd relates to a packet going s2c */
             {
-                if (in_rrpd->c2s)
-                {
-                    if (in_rrpd->msg_id)
-                        /* if we have a message id this is a new Request APDU */
-                        return NULL;
-                    else  /* No msg_id */
-                    {
-                        return rrpd;  /* add this packet to the matching stream */
-                    }
-                }
-                else  /* this packet is going s2c */
+                /* When reassembly is enabled, multi-packet response information is actually migrated from the temp_rsp_rrpd_list
+                to the rrpd_list and so we won't come through here. */
+                ;
+            }
+        }
+        else /* we are not using reassembly */
+        {
+            if (in_rrpd->c2s)
+            {
+                if (in_rrpd->msg_id)
+                    /* if we have a message id this is a new Request APDU */
+                    return NULL;
+                else  /* No msg_id */
                 {
-                    if (!in_rrpd->msg_id && rrpd->rsp_first_frame)
-                        /* we need to add this frame to the response APDU of the most recent rrpd_list entry that has already had response packets */
-                        return rrpd;
+                    return rrpd;  /* add this packet to the matching stream */
                 }
             }
-        }  /* this is the end of the 5-tuple check */
+            else  /* this packet is going s2c */
+            {
+                if (!in_rrpd->msg_id && rrpd->rsp_first_frame)
+                    /* we need to add this frame to the response APDU of the most recent rrpd_list entry that has already had response packets */
+                    return rrpd;
+            }
+        }
 
         if (in_rrpd->c2s)
             in_rrpd->req_search_total++;
@@ -486,24 +519,13 @@ static RRPD *find_latest_rrpd_syn(RRPD *in_rrpd)
     RRPD *rrpd;
     wmem_list_frame_t* i;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    for (i = rrpd_stream_tail(in_rrpd); i != NULL; i = wmem_list_frame_prev(i))
     {
         rrpd = (RRPD*)wmem_list_frame_data(i);
 
-        if (rrpd->calculation != RTE_CALC_SYN)
-            continue;
-
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
+        if (rrpd->calculation == RTE_CALC_SYN)
             return rrpd;
-        }  /* this is the end of the 5-tuple check */
-
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
-        else
-            in_rrpd->rsp_search_total++;
-    } /* this is the end of the for loop */
+    }
 
     return NULL;
 }
@@ -603,25 +625,21 @@ static void update_rrpd_list_entry_req(RRPD *in_rrpd)
 static RRPD* insert_into_temp_rsp_rrpd_list(RRPD *in_rrpd)
 {
     RRPD *rrpd = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+    RRPD_STREAM *stream = find_rrpd_stream(rrpd, true);
+
+    if (stream == NULL)
+        return NULL;
 
-    wmem_list_append(temp_rsp_rrpd_list, rrpd);
+    stream->temp_rsp = rrpd;
 
     return rrpd;
 }
 
 static RRPD* find_temp_rsp_rrpd(RRPD *in_rrpd)
 {
-    wmem_list_frame_t *i;
-    RRPD* rrpd;
+    RRPD_STREAM *stream = find_rrpd_stream(in_rrpd, false);
 
-    for (i = wmem_list_head(temp_rsp_rrpd_list); i; i = wmem_list_frame_next(i))
-    {
-        rrpd = (RRPD*)wmem_list_frame_data(i);
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-            return rrpd;
-    }
-
-    return NULL;
+    return stream != NULL ? stream->temp_rsp : NULL;
 }
 
 static void update_temp_rsp_rrpd(RRPD *temp_list, RRPD *in_rrpd)
@@ -630,12 +648,14 @@ static void update_temp_rsp_rrpd(RRPD *temp_list, RRPD *in_rrpd)
     temp_list->rsp_last_rtime = in_rrpd->rsp_last_rtime;
 }
 
-/* This function migrates an entry from the temp_rsp_rrpd_list to the main rrpd_list. */
+/* This function migrates an entry from the temp_rsp_rrpd_list to the stream's RRPDs. */
 static void migrate_temp_rsp_rrpd(RRPD *main_list, RRPD *temp_list)
 {
+    RRPD_STREAM *stream = find_rrpd_stream(temp_list, false);
+
     update_rrpd_list_entry(main_list, temp_list);
 
-    wmem_list_remove(temp_rsp_rrpd_list, temp_list);
+    stream->temp_rsp = NULL;
 }
 
 static void update_rrpd_list_entry_rsp(RRPD *in_rrpd)
@@ -757,8 +777,8 @@ static void init_globals(void)
     /* Create and initialise some dynamic memory areas */
     tcp_stream_exceptions = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
     detected_tcp_svc = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
-    rrpd_list = wmem_list_new(wmem_file_scope());
-    temp_rsp_rrpd_list = wmem_list_new(wmem_file_scope());
+    tcp_rrpd_streams = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    udp_rrpd_streams = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
 
     /* Indicate what fields we're interested in. */
     GArray *wanted_fields = g_array_sized_new(false, false, (unsigned)sizeof(int), HF_INTEREST_END_OF_LIST);
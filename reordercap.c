@@ -43,6 +43,9 @@
 /* Additional exit codes */
 #define OUTPUT_FILE_ERROR 1
 
+/* Number of records read at a time in the first pass */
+#define READ_BATCH_SIZE 64
+
 /* Show command-line usage */
 static void
 print_usage(FILE *output)
@@ -52,6 +55,8 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Options:\n");
     fprintf(output, "  -n                don't write to output file if the input file is ordered.\n");
+    fprintf(output, "  -w <frames>       sort in a single pass, holding at most <frames> frames;\n");
+    fprintf(output, "                    for files that are only slightly out of order.\n");
     fprintf(output, "  -h, --help        display this help and exit.\n");
     fprintf(output, "  -v, --version     print version information and exit.\n");
 }
@@ -65,6 +70,15 @@ typedef struct FrameRecord_t {
 } FrameRecord_t;
 
 
+/* A frame held in the reorder window, along with its record */
+typedef struct WindowFrame_t {
+    unsigned     num;
+
+    nstime_t     frame_time;
+    wtap_rec     rec;
+} WindowFrame_t;
+
+
 /**************************************************/
 /* Debugging only                                 */
 
@@ -126,8 +140,8 @@ frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
 static int
 frames_compare(const void *a, const void *b)
 {
-    const FrameRecord_t *frame1 = *(const FrameRecord_t *const *) a;
-    const FrameRecord_t *frame2 = *(const FrameRecord_t *const *) b;
+    const FrameRecord_t *frame1 = (const FrameRecord_t *) a;
+    const FrameRecord_t *frame2 = (const FrameRecord_t *) b;
 
     const nstime_t *time1 = &frame1->frame_time;
     const nstime_t *time2 = &frame2->frame_time;
@@ -135,6 +149,223 @@ frames_compare(const void *a, const void *b)
     return nstime_cmp(time1, time2);
 }
 
+/* Frames in the reorder window are kept in a binary min-heap, ordered
+   by time stamp, with frames that have the same time stamp kept in
+   their input order. */
+static bool
+window_frame_is_before(const WindowFrame_t *frame1, const WindowFrame_t *frame2)
+{
+    int cmp = nstime_cmp(&frame1->frame_time, &frame2->frame_time);
+
+    return cmp < 0 || (cmp == 0 && frame1->num < frame2->num);
+}
+
+static void
+window_heap_push(WindowFrame_t **heap, unsigned *count, WindowFrame_t *frame)
+{
+    unsigned i = (*count)++;
+
+    while (i > 0) {
+        unsigned parent = (i - 1) / 2;
+
+        if (!window_frame_is_before(frame, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = frame;
+}
+
+static WindowFrame_t *
+window_heap_pop(WindowFrame_t **heap, unsigned *count)
+{
+    WindowFrame_t *top = heap[0];
+    WindowFrame_t *last = heap[--(*count)];
+    unsigned i = 0;
+
+    for (;;) {
+        unsigned child = 2 * i + 1;
+
+        if (child >= *count)
+            break;
+        if (child + 1 < *count && window_frame_is_before(heap[child + 1], heap[child]))
+            child++;
+        if (!window_frame_is_before(heap[child], last))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+/* Add any interfaces that have been read since the last call to the output */
+static bool
+window_add_new_idbs(wtap *wth, wtap_dumper *pdh, int *err, char **err_info)
+{
+    wtap_block_t if_data;
+
+    while ((if_data = wtap_get_next_interface_description(wth)) != NULL) {
+        /* Only output file types that use IDBs need them. */
+        if (wtap_file_type_subtype_supports_block(wtap_dump_file_type_subtype(pdh),
+                                                  WTAP_BLOCK_IF_ID_AND_INFO) != BLOCK_NOT_SUPPORTED) {
+            /* wtap_dump_add_idb() makes its own copy. */
+            if (!wtap_dump_add_idb(pdh, if_data, err, err_info))
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Sort in a single streaming pass: frames are read into a window of at
+   most window_size frames, and the earliest frame in the window is
+   written out whenever it is full.  This needs memory for window_size
+   frames rather than for metadata about every frame, and reads the input
+   sequentially, but only sorts correctly if no frame is more than
+   window_size frames away from its place in time order. */
+static int
+reorder_window(wtap *wth, const char *infile, const char *outfile,
+               unsigned window_size)
+{
+    wtap_dumper *pdh;
+    wtap_dump_params params;
+    int err;
+    char *err_info;
+    int64_t data_offset;
+    WindowFrame_t *frames;
+    WindowFrame_t **heap;
+    WindowFrame_t **free_frames;
+    unsigned heap_count = 0;
+    unsigned free_count = 0;
+    unsigned frames_used = 0;
+    unsigned frame_count = 0;
+    unsigned wrong_order_count = 0;
+    unsigned late_count = 0;
+    nstime_t prev_read_time;
+    nstime_t prev_written_time;
+    bool read_ok = true;
+    int ret = EXIT_SUCCESS;
+
+    /* Interfaces are added to the output as they are read. */
+    wtap_dump_params_init_no_idbs(&params, wth);
+    if (strcmp(outfile, "-") == 0) {
+        pdh = wtap_dump_open_stdout(wtap_file_type_subtype(wth),
+                                    WS_FILE_UNCOMPRESSED, &params, &err, &err_info);
+    } else {
+        pdh = wtap_dump_open(outfile, wtap_file_type_subtype(wth),
+                             WS_FILE_UNCOMPRESSED, &params, &err, &err_info);
+    }
+    if (pdh == NULL) {
+        report_cfile_dump_open_failure(outfile, err, err_info,
+                                       wtap_file_type_subtype(wth));
+        wtap_dump_params_cleanup(&params);
+        return OUTPUT_FILE_ERROR;
+    }
+
+    if (!window_add_new_idbs(wth, pdh, &err, &err_info)) {
+        report_cfile_write_failure(infile, outfile, err, err_info, 0,
+                                   wtap_file_type_subtype(wth));
+        wtap_dump_close(pdh, NULL, &err, &err_info);
+        g_free(err_info);
+        wtap_dump_params_cleanup(&params);
+        return OUTPUT_FILE_ERROR;
+    }
+
+    /* One more than the window, for the frame being read. */
+    frames = g_new(WindowFrame_t, (size_t)window_size + 1);
+    heap = g_new(WindowFrame_t *, (size_t)window_size + 1);
+    free_frames = g_new(WindowFrame_t *, (size_t)window_size + 1);
+    nstime_set_unset(&prev_read_time);
+    nstime_set_unset(&prev_written_time);
+
+    while (read_ok || heap_count > 0) {
+        WindowFrame_t *frame;
+
+        if (read_ok) {
+            /* Read the next frame into a free slot, initializing the
+               slots only as they're first needed. */
+            if (free_count > 0) {
+                frame = free_frames[--free_count];
+            } else {
+                frame = &frames[frames_used++];
+                wtap_rec_init(&frame->rec, DEFAULT_INIT_BUFFER_SIZE_2048);
+            }
+
+            if (!wtap_read(wth, &frame->rec, &err, &err_info, &data_offset)) {
+                if (err != 0) {
+                    /* Print a message noting that the read failed somewhere along the line. */
+                    report_cfile_read_failure(infile, err, err_info);
+                }
+                free_frames[free_count++] = frame;
+                read_ok = false;
+                continue;
+            }
+            if (!window_add_new_idbs(wth, pdh, &err, &err_info)) {
+                report_cfile_write_failure(infile, outfile, err, err_info, frame_count + 1,
+                                           wtap_file_type_subtype(wth));
+                ret = OUTPUT_FILE_ERROR;
+                break;
+            }
+
+            frame->num = ++frame_count;
+            if (frame->rec.presence_flags & WTAP_HAS_TS) {
+                frame->frame_time = frame->rec.ts;
+            } else {
+                nstime_set_unset(&frame->frame_time);
+            }
+            if (frame_count > 1 && nstime_cmp(&frame->frame_time, &prev_read_time) < 0) {
+                wrong_order_count++;
+            }
+            prev_read_time = frame->frame_time;
+
+            window_heap_push(heap, &heap_count, frame);
+            if (heap_count <= window_size)
+                continue;
+        }
+
+        /* Write out the earliest frame in the window. */
+        frame = window_heap_pop(heap, &heap_count);
+        if (nstime_cmp(&frame->frame_time, &prev_written_time) < 0) {
+            late_count++;
+        }
+        prev_written_time = frame->frame_time;
+
+        DEBUG_PRINT("\nDumping frame %u\n", frame->num);
+        if (!wtap_dump(pdh, &frame->rec, &err, &err_info)) {
+            report_cfile_write_failure(infile, outfile, err, err_info, frame->num,
+                                       wtap_file_type_subtype(wth));
+            ret = OUTPUT_FILE_ERROR;
+            break;
+        }
+        wtap_rec_reset(&frame->rec);
+        free_frames[free_count++] = frame;
+    }
+
+    printf("%u frames, %u out of order\n", frame_count, wrong_order_count);
+    if (ret == EXIT_SUCCESS && late_count > 0) {
+        fprintf(stderr,
+                "reordercap: %u frames were further out of order than the window of %u frames,\n"
+                "and the output file is not completely in order; use a larger window.\n",
+                late_count, window_size);
+    }
+
+    for (unsigned i = 0; i < frames_used; i++) {
+        wtap_rec_cleanup(&frames[i].rec);
+    }
+    g_free(free_frames);
+    g_free(heap);
+    g_free(frames);
+
+    /* Close outfile */
+    if (!wtap_dump_close(pdh, NULL, &err, &err_info)) {
+        report_cfile_close_failure(outfile, err, err_info);
+        ret = OUTPUT_FILE_ERROR;
+    }
+    wtap_dump_params_cleanup(&params);
+
+    return ret;
+}
+
 /********************************************************************/
 /* Main function.                                                   */
 /********************************************************************/
@@ -145,17 +376,19 @@ main(int argc, char *argv[])
     wtap *wth = NULL;
     wtap_dumper *pdh = NULL;
     wtap_rec rec;
+    wtap_rec batch_recs[READ_BATCH_SIZE];
+    int64_t batch_offsets[READ_BATCH_SIZE];
+    unsigned batch_count;
     int err;
     char *err_info;
-    int64_t data_offset;
     unsigned wrong_order_count = 0;
     bool write_output_regardless = true;
+    uint32_t window_size = 0;
     unsigned i;
     wtap_dump_params params;
     int                          ret = EXIT_SUCCESS;
 
-    GPtrArray *frames;
-    FrameRecord_t *prevFrame = NULL;
+    GArray *frames;
 
     int opt;
     static const struct ws_option long_options[] = {
@@ -164,7 +397,7 @@ main(int argc, char *argv[])
         LONGOPT_WSLOG
         {0, 0, 0, 0 }
     };
-#define OPTSTRING "hnv"
+#define OPTSTRING "hnvw:"
     static const char optstring[] = OPTSTRING;
     int file_count;
     char *infile;
@@ -216,6 +449,12 @@ main(int argc, char *argv[])
             case 'n':
                 write_output_regardless = false;
                 break;
+            case 'w':
+                if (!get_nonzero_uint32(ws_optarg, "reorder window size", &window_size)) {
+                    ret = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
             case 'h':
                 show_help_header("Reorder timestamps of input file frames into output file.");
                 print_usage(stdout);
@@ -235,6 +474,12 @@ main(int argc, char *argv[])
         }
     }
 
+    if (window_size > 0 && !write_output_regardless) {
+        cmdarg_err("-n can't be used with -w, as the output is written while the input is read");
+        ret = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+
     /* Remaining args are file names */
     file_count = argc - ws_optind;
     if (file_count == 2) {
@@ -258,32 +503,49 @@ main(int argc, char *argv[])
     }
     DEBUG_PRINT("file_type_subtype is %d\n", wtap_file_type_subtype(wth));
 
-    /* Allocate the array of frame pointers. */
-    frames = g_ptr_array_new();
-
-    /* Read each frame from infile */
-    wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
-    while (wtap_read(wth, &rec, &err, &err_info, &data_offset)) {
-        FrameRecord_t *newFrameRecord;
+    if (window_size > 0) {
+        ret = reorder_window(wth, infile, outfile, window_size);
+        wtap_close(wth);
+        goto clean_exit;
+    }
 
-        newFrameRecord = g_slice_new(FrameRecord_t);
-        newFrameRecord->num = frames->len + 1;
-        newFrameRecord->offset = data_offset;
-        if (rec.presence_flags & WTAP_HAS_TS) {
-            newFrameRecord->frame_time = rec.ts;
-        } else {
-            nstime_set_unset(&newFrameRecord->frame_time);
-        }
+    /* Allocate the array of frames; they're kept inline, rather than
+       allocated one by one, as there may be a great many of them. */
+    frames = g_array_new(false, false, sizeof(FrameRecord_t));
 
-        if (prevFrame && frames_compare(&newFrameRecord, &prevFrame) < 0) {
-           wrong_order_count++;
+    /*
+     * Read each frame from infile.  Only the time stamps and offsets
+     * are needed here, as the frames are reread when they're written,
+     * so let the reader skip the packet data.
+     */
+    wtap_set_skip_packet_data(wth, true);
+    for (i = 0; i < READ_BATCH_SIZE; i++)
+        wtap_rec_init(&batch_recs[i], DEFAULT_INIT_BUFFER_SIZE_2048);
+    do {
+        batch_count = wtap_read_batch(wth, batch_recs, batch_offsets,
+                                      READ_BATCH_SIZE, &err, &err_info);
+        for (i = 0; i < batch_count; i++) {
+            FrameRecord_t newFrameRecord;
+
+            newFrameRecord.num = frames->len + 1;
+            newFrameRecord.offset = batch_offsets[i];
+            if (batch_recs[i].presence_flags & WTAP_HAS_TS) {
+                newFrameRecord.frame_time = batch_recs[i].ts;
+            } else {
+                nstime_set_unset(&newFrameRecord.frame_time);
+            }
+
+            if (frames->len > 0 &&
+                frames_compare(&newFrameRecord, &g_array_index(frames, FrameRecord_t, frames->len - 1)) < 0) {
+               wrong_order_count++;
+            }
+
+            g_array_append_val(frames, newFrameRecord);
+            wtap_rec_reset(&batch_recs[i]);
         }
-
-        g_ptr_array_add(frames, newFrameRecord);
-        prevFrame = newFrameRecord;
-        wtap_rec_reset(&rec);
-    }
-    wtap_rec_cleanup(&rec);
+    } while (batch_count == READ_BATCH_SIZE);
+    for (i = 0; i < READ_BATCH_SIZE; i++)
+        wtap_rec_cleanup(&batch_recs[i]);
     if (err != 0) {
       /* Print a message noting that the read failed somewhere along the line. */
       report_cfile_read_failure(infile, err, err_info);
@@ -296,7 +558,7 @@ main(int argc, char *argv[])
     /* Sort the frames */
     /* XXX - Does this handle multiple SHBs correctly? */
     if (wrong_order_count > 0) {
-        g_ptr_array_sort(frames, frames_compare);
+        g_array_sort(frames, frames_compare);
     }
 
 
@@ -325,12 +587,10 @@ main(int argc, char *argv[])
         /* Write out each sorted frame in turn */
         wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
         for (i = 0; i < frames->len; i++) {
-            FrameRecord_t *frame = (FrameRecord_t *)frames->pdata[i];
+            FrameRecord_t *frame = &g_array_index(frames, FrameRecord_t, i);
 
             if (!frame_write(frame, wth, pdh, &rec, infile, outfile))
                 return EXIT_FAILURE;
-
-            g_slice_free(FrameRecord_t, frame);
         }
 
         wtap_rec_cleanup(&rec);
@@ -346,18 +606,11 @@ main(int argc, char *argv[])
         }
     } else {
         printf("Not writing output file because input file is already in order.\n");
-
-        /* Free frame memory */
-        for (i = 0; i < frames->len; i++) {
-            FrameRecord_t *frame = (FrameRecord_t *)frames->pdata[i];
-
-            g_slice_free(FrameRecord_t, frame);
-        }
     }
 
 
     /* Free the whole array */
-    g_ptr_array_free(frames, TRUE);
+    g_array_free(frames, TRUE);
 
     wtap_dump_params_cleanup(&params);
 
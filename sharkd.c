@@ -28,7 +28,9 @@
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
 #include <wsutil/privileges.h>
+#include <wsutil/app_mem_usage.h>
 #include <wsutil/wslog.h>
+#include <wsutil/ws_trace.h>
 #include <wsutil/version_info.h>
 #include <wsutil/report_message.h>
 #include <app/application_flavor.h>
@@ -72,6 +74,16 @@ capture_file cfile;
 
 static uint32_t cum_bytes;
 static frame_data ref_frame;
+static bool tailing;        /* the first pass is left open for more records */
+
+/* The frame_data of every frame loaded, not counting what it points to. */
+static size_t
+sharkd_frame_data_size(void)
+{
+    return (size_t)cfile.count * sizeof(frame_data);
+}
+
+static const ws_mem_usage_t frame_data_usage = { "Frame data", sharkd_frame_data_size, NULL };
 
 /*
  * The leading + ensures that getopt_long() does not permute the argv[]
@@ -96,6 +108,7 @@ static frame_data ref_frame;
 static const struct ws_option long_options[] = {
     {"api", ws_required_argument, NULL, 'a'},
     {"foreground", ws_no_argument, NULL, LONGOPT_FOREGROUND},
+    {"preload", ws_required_argument, NULL, LONGOPT_PRELOAD},
     {"help", ws_no_argument, NULL, 'h'},
     {"version", ws_no_argument, NULL, 'v'},
     {"config-profile", ws_required_argument, NULL, 'C'},
@@ -157,6 +170,7 @@ main(int argc, char *argv[])
 
     /* Initialize log handler early so we can have proper logging during startup. */
     ws_log_init(vcmdarg_err, "SharkD Debug Console");
+    ws_trace_register();
 
     /* Early logging command-line initialization. */
     ws_log_parse_args(&argc, argv, sharkd_optstring(), sharkd_long_options(), vcmdarg_err, SHARKD_INIT_FAILED);
@@ -232,6 +246,7 @@ main(int argc, char *argv[])
     }
 
     cap_file_init(&cfile);
+    memory_usage_component_register(&frame_data_usage);
 
     /* Notify all registered modules that have had any of their preferences
        changed either from one of the preferences file or from the command
@@ -351,75 +366,102 @@ process_packet(capture_file *cf, epan_dissect_t *edt, int64_t offset,
 }
 
 
+/* Reads records up to the end of the file, or the limits, on the first pass. */
 static int
-load_cap_file(capture_file *cf, int max_packet_count, int64_t max_byte_count)
+read_cap_file_records(capture_file *cf, int max_packet_count, int64_t max_byte_count,
+                      char **err_info)
 {
     int          err;
-    char        *err_info = NULL;
     int64_t      data_offset;
     wtap_rec     rec;
     epan_dissect_t *edt = NULL;
 
     {
-        /* Allocate a frame_data_sequence for all the frames. */
-        cf->provider.frames = new_frame_data_sequence();
-
-        {
-            bool create_proto_tree;
-
-            /*
-             * Determine whether we need to create a protocol tree.
-             * We do if:
-             *
-             *    we're going to apply a read filter;
-             *
-             *    we're going to apply a display filter;
-             *
-             *    a postdissector wants field values or protocols
-             *    on the first pass.
-             */
-            create_proto_tree =
-                (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids());
+        bool create_proto_tree;
+
+        /*
+         * Determine whether we need to create a protocol tree.
+         * We do if:
+         *
+         *    we're going to apply a read filter;
+         *
+         *    we're going to apply a display filter;
+         *
+         *    a postdissector wants field values or protocols
+         *    on the first pass.
+         */
+        create_proto_tree =
+            (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids());
 
-            /* We're not going to display the protocol tree on this pass,
-               so it's not going to be "visible". */
-            edt = epan_dissect_new(cf->epan, create_proto_tree, false);
-        }
+        /* We're not going to display the protocol tree on this pass,
+           so it's not going to be "visible". */
+        edt = epan_dissect_new(cf->epan, create_proto_tree, false);
+    }
 
-        wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
+    wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
 
-        while (wtap_read(cf->provider.wth, &rec, &err, &err_info, &data_offset)) {
-            if (process_packet(cf, edt, data_offset, &rec)) {
-                wtap_rec_reset(&rec);
-                /* Stop reading if we have the maximum number of packets;
-                 * When the -c option has not been used, max_packet_count
-                 * starts at 0, which practically means, never stop reading.
-                 * (unless we roll over max_packet_count ?)
-                 */
-                if ( (--max_packet_count == 0) || (max_byte_count != 0 && data_offset >= max_byte_count)) {
-                    err = 0; /* This is not an error */
-                    break;
-                }
+    while (wtap_read(cf->provider.wth, &rec, &err, err_info, &data_offset)) {
+        if (process_packet(cf, edt, data_offset, &rec)) {
+            wtap_rec_reset(&rec);
+            /* Stop reading if we have the maximum number of packets;
+             * When the -c option has not been used, max_packet_count
+             * starts at 0, which practically means, never stop reading.
+             * (unless we roll over max_packet_count ?)
+             */
+            if ( (--max_packet_count == 0) || (max_byte_count != 0 && data_offset >= max_byte_count)) {
+                err = 0; /* This is not an error */
+                break;
             }
         }
+    }
 
-        if (edt) {
-            epan_dissect_free(edt);
-            edt = NULL;
-        }
+    if (edt) {
+        epan_dissect_free(edt);
+        edt = NULL;
+    }
 
-        wtap_rec_cleanup(&rec);
+    wtap_rec_cleanup(&rec);
+
+    return err;
+}
+
+/* Ends the first pass; no more records are read after this. */
+static void
+finish_cap_file(capture_file *cf)
+{
+    tailing = false;
 
-        /* Close the sequential I/O side, to free up memory it requires. */
-        wtap_sequential_close(cf->provider.wth);
+    /* Close the sequential I/O side, to free up memory it requires. */
+    wtap_sequential_close(cf->provider.wth);
 
-        /* Allow the protocol dissectors to free up memory that they
-         * don't need after the sequential run-through of the packets. */
-        postseq_cleanup_all_protocols();
+    /* Allow the protocol dissectors to free up memory that they
+     * don't need after the sequential run-through of the packets. */
+    postseq_cleanup_all_protocols();
 
-        cf->provider.prev_dis = NULL;
-        cf->provider.prev_cap = NULL;
-    }
+    /* Every frame has been seen once; later requests only revisit them. */
+    epan_freeze(cf->epan);
+
+    cf->provider.prev_dis = NULL;
+    cf->provider.prev_cap = NULL;
+}
+
+static int
+load_cap_file(capture_file *cf, int max_packet_count, int64_t max_byte_count, bool tail)
+{
+    int          err;
+    char        *err_info = NULL;
+
+    tailing = false;
+
+    /* Allocate a frame_data_sequence for all the frames. */
+    cf->provider.frames = new_frame_data_sequence();
+
+    err = read_cap_file_records(cf, max_packet_count, max_byte_count, &err_info);
+
+    if (tail && err == 0)
+        tailing = true;
+    else
+        finish_cap_file(cf);
 
     if (err != 0) {
         report_cfile_read_failure(cf->filename, err, err_info);
@@ -491,13 +533,118 @@ sharkd_cf_open(const char *fname, unsigned int type, bool is_tempfile, int *err)
 int
 sharkd_load_cap_file(void)
 {
-    return load_cap_file(&cfile, 0, 0);
+    return load_cap_file(&cfile, 0, 0, false);
 }
 
 int
 sharkd_load_cap_file_with_limits(int max_packet_count, int64_t max_byte_count)
 {
-    return load_cap_file(&cfile, max_packet_count, max_byte_count);
+    return load_cap_file(&cfile, max_packet_count, max_byte_count, false);
+}
+
+/*
+ * Like sharkd_load_cap_file(), but for a file that's still being
+ * written: the end of the file isn't taken to be the end of the
+ * capture, and sharkd_continue_tail() reads what's been added since.
+ */
+int
+sharkd_load_cap_file_tail(void)
+{
+    return load_cap_file(&cfile, 0, 0, true);
+}
+
+bool
+sharkd_is_tailing(void)
+{
+    return tailing;
+}
+
+/*
+ * Reads the records added to the file since the last call, continuing
+ * the first pass where it stopped, and sets added to the number of new
+ * frames. On an error, stops following the file.
+ */
+int
+sharkd_continue_tail(uint32_t *added)
+{
+    uint32_t count = cfile.count;
+    char *err_info = NULL;
+    int err;
+
+    *added = 0;
+    if (!tailing)
+        return 0;
+
+    wtap_cleareof(cfile.provider.wth);
+    err = read_cap_file_records(&cfile, 0, 0, &err_info);
+    *added = cfile.count - count;
+
+    /* Update the file encapsulation; it might have changed based on the
+       packets we've read. */
+    cfile.lnk_t = wtap_file_encap(cfile.provider.wth);
+
+    if (err != 0) {
+        report_cfile_read_failure(cfile.filename, err, err_info);
+        finish_cap_file(&cfile);
+    }
+
+    return err;
+}
+
+void
+sharkd_finish_tail(void)
+{
+    if (tailing)
+        finish_cap_file(&cfile);
+}
+
+/*
+ * The capture file the daemon loaded before forking the session
+ * processes, if any. The sessions share its frames copy-on-write.
+ */
+static char *preloaded_fname;
+
+int
+sharkd_preload_cap_file(const char *fname)
+{
+    int err = 0;
+
+    if (sharkd_cf_open(fname, WTAP_TYPE_AUTO, false, &err) != CF_OK)
+        return err != 0 ? err : -1;
+
+    err = sharkd_load_cap_file();
+    if (err == 0)
+        preloaded_fname = g_strdup(fname);
+    return err;
+}
+
+bool
+sharkd_cf_is_preloaded(const char *fname)
+{
+    /* Not if the session has opened another file since. */
+    return preloaded_fname != NULL && cfile.filename != NULL &&
+        strcmp(cfile.filename, preloaded_fname) == 0 &&
+        strcmp(fname, preloaded_fname) == 0;
+}
+
+bool
+sharkd_reopen_preloaded(void)
+{
+    int err;
+
+    if (preloaded_fname == NULL || cfile.provider.wth == NULL)
+        return true;
+
+    /*
+     * A forked session inherits the daemon's file descriptor, and with
+     * it the file offset, which all the sessions would then be fighting
+     * over when seeking to frames; give it one of its own.
+     */
+    if (!wtap_fdreopen(cfile.provider.wth, cfile.filename, &err)) {
+        report_cfile_open_failure(cfile.filename, err, NULL);
+        return false;
+    }
+    return true;
 }
 
 frame_data *
@@ -565,6 +712,21 @@ sharkd_dissect_request(uint32_t framenum, uint32_t frame_ref_num,
 
 int
 sharkd_retap(void)
+{
+    sharkd_retap_frames(NULL, NULL);
+
+    draw_tap_listeners(true);
+
+    return 0;
+}
+
+/*
+ * Runs the frames through the tap listeners, without drawing them. If
+ * cb stops it, returns false and the listeners have seen only part of
+ * the capture.
+ */
+bool
+sharkd_retap_frames(sharkd_retap_func_t cb, void *data)
 {
     uint32_t         framenum;
     frame_data      *fdata;
@@ -576,6 +738,7 @@ sharkd_retap(void)
     bool          create_proto_tree;
     epan_dissect_t edt;
     column_info   *cinfo;
+    bool          completed = true;
 
     /* Get the union of the flags for all tap listeners. */
     tap_flags = union_of_tap_listener_flags();
@@ -600,6 +763,11 @@ sharkd_retap(void)
     reset_tap_listeners();
 
     for (framenum = 1; framenum <= cfile.count; framenum++) {
+        if (cb && !cb(framenum, data)) {
+            completed = false;
+            break;
+        }
+
         fdata = sharkd_get_frame(framenum);
 
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &err, &err_info))
@@ -616,13 +784,21 @@ sharkd_retap(void)
     wtap_rec_cleanup(&rec);
     epan_dissect_cleanup(&edt);
 
-    draw_tap_listeners(true);
-
-    return 0;
+    return completed;
 }
 
 int
 sharkd_filter(const char *dftext, uint8_t **result)
+{
+    return sharkd_filter_candidates(dftext, NULL, result);
+}
+
+/*
+ * Like sharkd_filter(), but only frames set in the candidates bitmap, if
+ * there is one, are dissected; the others are taken not to match.
+ */
+int
+sharkd_filter_candidates(const char *dftext, const uint8_t *candidates, uint8_t **result)
 {
     dfilter_t  *dfcode = NULL;
 
@@ -637,18 +813,18 @@ sharkd_filter(const char *dftext, uint8_t **result)
 
     epan_dissect_t edt;
 
-    if (!dfilter_compile(dftext, &dfcode, NULL)) {
+    if (!dfilter_compile_cached(dftext, &dfcode, NULL)) {
         return -1;
     }
 
+    frames_count = cfile.count;
+
     /* if dfilter_compile() success, but (dfcode == NULL) all frames are matching */
     if (dfcode == NULL) {
-        *result = NULL;
+        *result = candidates ? (uint8_t *) g_memdup2(candidates, 2 + (frames_count / 8)) : NULL;
         return 0;
     }
 
-    frames_count = cfile.count;
-
     wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
     epan_dissect_init(&edt, cfile.epan, true, false);
 
@@ -663,6 +839,9 @@ sharkd_filter(const char *dftext, uint8_t **result)
             passed_bits = 0;
         }
 
+        if (candidates && !(candidates[framenum / 8] & (1 << (framenum % 8))))
+            continue;
+
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &err, &err_info))
             break;
 
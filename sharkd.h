@@ -27,15 +27,27 @@
 #define SHARKD_MODE_GOLD_DAEMON        4
 
 typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, struct epan_column_info *cinfo, const GSList *data_src, void *data);
+/* Called before each frame of a retap; returns false to stop there. */
+typedef bool (*sharkd_retap_func_t)(uint32_t framenum, void *data);
 
 #define LONGOPT_FOREGROUND 4000
+#define LONGOPT_PRELOAD    4001
 
 /* sharkd.c */
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, bool is_tempfile, int *err);
 int sharkd_load_cap_file(void);
 int sharkd_load_cap_file_with_limits(int max_packet_count, int64_t max_byte_count);
+int sharkd_load_cap_file_tail(void);
+bool sharkd_is_tailing(void);
+int sharkd_continue_tail(uint32_t *added);
+void sharkd_finish_tail(void);
+int sharkd_preload_cap_file(const char *fname);
+bool sharkd_cf_is_preloaded(const char *fname);
+bool sharkd_reopen_preloaded(void);
 int sharkd_retap(void);
+bool sharkd_retap_frames(sharkd_retap_func_t cb, void *data);
 int sharkd_filter(const char *dftext, uint8_t **result);
+int sharkd_filter_candidates(const char *dftext, const uint8_t *candidates, uint8_t **result);
 frame_data *sharkd_get_frame(uint32_t framenum);
 enum dissect_request_status {
   DISSECT_REQUEST_SUCCESS,
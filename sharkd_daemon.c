@@ -60,6 +60,7 @@
 
 static int mode;
 static socket_handle_t _server_fd = INVALID_SOCKET;
+static char *preload_file;
 
 static socket_handle_t
 socket_init(char *path)
@@ -199,6 +200,8 @@ print_usage(FILE* output)
     fprintf(output, "  -a <socket>, --api <socket>\n");
     fprintf(output, "                           listen on this socket instead of the console\n");
     fprintf(output, "  --foreground             do not detach from console\n");
+    fprintf(output, "  --preload <infile>       load this capture file once, at startup, and share it\n");
+    fprintf(output, "                           with the sessions that load it\n");
     fprintf(output, "  -h, --help               show this help information\n");
     fprintf(output, "  -v, --version            show version information\n");
     fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
@@ -355,6 +358,17 @@ sharkd_init(int argc, char **argv)
                     foreground = true;
                     break;
 
+                case LONGOPT_PRELOAD:
+#ifndef _WIN32
+                    g_free(preload_file);
+                    preload_file = g_strdup(ws_optarg);
+#else
+                    /* The sessions are separate processes, not forks,
+                     * so there's nothing to share them with. */
+                    fprintf(stderr, "--preload is not supported on Windows; ignoring it\n");
+#endif
+                    break;
+
                 default:
                     /* wslog arguments are okay */
                     if (ws_log_is_wslog_arg(opt))
@@ -395,6 +409,22 @@ sharkd_loop(int argc _U_, char* argv[] _U_)
 sharkd_loop(int argc _U_, char* argv[])
 #endif
 {
+    if (preload_file)
+    {
+        /*
+         * Load and dissect the file once, here, so that the forked session
+         * processes share the frames and the dissection state copy-on-write
+         * instead of each reading the whole file again. Those of a session
+         * that it changes - display filters, comments - become its own.
+         */
+        fprintf(stderr, "preload: filename=%s\n", preload_file);
+        if (sharkd_preload_cap_file(preload_file) != 0)
+        {
+            fprintf(stderr, "cannot preload %s\n", preload_file);
+            return -1;
+        }
+    }
+
     if (mode == SHARKD_MODE_CLASSIC_CONSOLE || mode == SHARKD_MODE_GOLD_CONSOLE)
     {
         return sharkd_session_main(mode);
@@ -445,6 +475,9 @@ sharkd_loop(int argc _U_, char* argv[])
             dup2(fd, 1);
             close(fd);
 
+            if (!sharkd_reopen_preloaded())
+                exit(EXIT_FAILURE);
+
             exit(sharkd_session_main(mode));
         }
 
@@ -18,8 +18,13 @@
 #include <errno.h>
 #include <inttypes.h>
 
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
 #include <glib.h>
 
+#include <wsutil/app_mem_usage.h>
 #include <wsutil/wsjson.h>
 #include <wsutil/json_dumper.h>
 #include <wsutil/ws_assert.h>
@@ -49,6 +54,7 @@
 #include <epan/srt_table.h>
 #include <epan/to_str.h>
 #include <epan/secrets.h>
+#include <epan/wscbor_enc.h>
 
 #include <epan/dissectors/packet-h225.h>
 #include <ui/voip_calls.h>
@@ -69,6 +75,7 @@
 
 #include <epan/maxmind_db.h>
 
+#include <wsutil/bits_ctz.h>
 #include <wsutil/pint.h>
 #include <wsutil/strnatcmp.h>
 #include <wsutil/strtoi.h>
@@ -77,12 +84,42 @@
 
 #include "sharkd.h"
 
+/*
+ * Filter results are kept compressed, in the style of roaring bitmaps:
+ * the frames are split into chunks by the upper bits of their number,
+ * and each chunk with any matching frame holds either a sorted array of
+ * the lower bits, while there are few of them, or a plain bitset.
+ */
+#define FILTER_CHUNK_SHIFT    16
+#define FILTER_CHUNK_FRAMES   (1U << FILTER_CHUNK_SHIFT)
+#define FILTER_ARRAY_MAX      (FILTER_CHUNK_FRAMES / 16)  /* beyond this, the bitset is smaller */
+
+/* The least recently used results are dropped beyond this. */
+#define FILTER_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+struct sharkd_filter_chunk
+{
+    uint32_t key;        /* framenum >> FILTER_CHUNK_SHIFT */
+    uint32_t count;      /* matching frames in the chunk */
+    uint16_t *array;     /* if count <= FILTER_ARRAY_MAX */
+    uint64_t *bits;      /* otherwise */
+};
+
 struct sharkd_filter_item
 {
-    uint8_t *filtered; /* can be NULL if all frames are matching for given filter. */
+    bool all;            /* all frames are matching for given filter, there are no chunks */
+    struct sharkd_filter_chunk *chunks;
+    unsigned num_chunks;
+    size_t size;
+    const char *filter;  /* the key in filter_table */
+    GList *lru_link;     /* in filter_lru */
 };
 
 static GHashTable *filter_table;
+static GHashTable *frames_cursors;
+static uint32_t frames_cursor_last_id;
+static GQueue filter_lru = G_QUEUE_INIT;  /* most recently used first */
+static size_t filter_cache_size;
 
 static int mode;
 static uint32_t rpcid;
@@ -107,21 +144,128 @@ json_find_attr(const char *buf, const jsmntok_t *tokens, int count, const char *
     return NULL;
 }
 
+/*
+ * Responses are JSON text, one per line, unless the client asked for
+ * CBOR with "encoding": then they're the same objects and arrays as CBOR
+ * items, each preceded by its length as 4 bytes in network byte order,
+ * with byte strings for the data which would be base64 in JSON.
+ */
+static GByteArray *cbor_buf;
+
+static void
+sharkd_cbor_member_name(const char *key)
+{
+    if (key)
+        wscbor_enc_tstr(cbor_buf, key);
+}
+
+/*
+ * Values are formatted as JSON text by the callers; turn this back into
+ * the item it stands for.
+ */
+static void
+sharkd_cbor_value_text(char *text)
+{
+    uint64_t u64;
+    int64_t i64;
+    double d;
+    char *end;
+    size_t len = strlen(text);
+
+    if (!strcmp(text, "true"))
+        wscbor_enc_boolean(cbor_buf, true);
+    else if (!strcmp(text, "false"))
+        wscbor_enc_boolean(cbor_buf, false);
+    else if (!strcmp(text, "null"))
+        wscbor_enc_null(cbor_buf);
+    else if (ws_strtou64(text, NULL, &u64))
+        wscbor_enc_uint64(cbor_buf, u64);
+    else if (ws_strtoi64(text, NULL, &i64))
+        wscbor_enc_int64(cbor_buf, i64);
+    else if (len >= 2 && text[0] == '[' && text[len - 1] == ']')
+    {
+        /* Only ever an array of numbers. */
+        char **elems;
+
+        text[len - 1] = '\0';
+        elems = g_strsplit(text + 1, ",", -1);
+        wscbor_enc_array_head_indef(cbor_buf);
+        for (char **elem = elems; *elem && **elem; elem++)
+            sharkd_cbor_value_text(*elem);
+        wscbor_enc_break(cbor_buf);
+        g_strfreev(elems);
+    }
+    else
+    {
+        d = g_ascii_strtod(text, &end);
+        if (end != text && *end == '\0')
+            wscbor_enc_double(cbor_buf, d);
+        else
+            wscbor_enc_tstr(cbor_buf, text);
+    }
+}
+
 static void
-json_print_base64(const uint8_t *data, size_t len)
+sharkd_json_bytes_begin(const char *key)
 {
+    if (cbor_buf)
+    {
+        sharkd_cbor_member_name(key);
+        wscbor_enc_bstr_head_indef(cbor_buf);
+        return;
+    }
+
+    if (key)
+        json_dumper_set_member_name(&dumper, key);
     json_dumper_begin_base64(&dumper);
+}
+
+static void
+sharkd_json_bytes_write(const uint8_t *data, size_t len)
+{
+    if (cbor_buf)
+    {
+        if (len)
+            wscbor_enc_bstr(cbor_buf, data, len);
+        return;
+    }
+
     json_dumper_write_base64(&dumper, data, len);
+}
+
+static void
+sharkd_json_bytes_end(void)
+{
+    if (cbor_buf)
+    {
+        wscbor_enc_break(cbor_buf);
+        return;
+    }
+
     json_dumper_end_base64(&dumper);
 }
 
 static void G_GNUC_PRINTF(2, 3)
 sharkd_json_value_anyf(const char *key, const char *format, ...)
 {
+    va_list ap;
+
+    if (cbor_buf)
+    {
+        char *text;
+
+        sharkd_cbor_member_name(key);
+        va_start(ap, format);
+        text = ws_strdup_vprintf(format, ap);
+        va_end(ap);
+        sharkd_cbor_value_text(text);
+        g_free(text);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
 
-    va_list ap;
     va_start(ap, format);
     json_dumper_value_va_list(&dumper, format, ap);
     va_end(ap);
@@ -130,6 +274,16 @@ sharkd_json_value_anyf(const char *key, const char *format, ...)
 static void
 sharkd_json_value_string(const char *key, const char *str)
 {
+    if (cbor_buf)
+    {
+        sharkd_cbor_member_name(key);
+        if (str)
+            wscbor_enc_tstr(cbor_buf, str);
+        else
+            wscbor_enc_null(cbor_buf);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
     json_dumper_value_string(&dumper, str);
@@ -138,18 +292,32 @@ sharkd_json_value_string(const char *key, const char *str)
 static void
 sharkd_json_value_base64(const char *key, const uint8_t *data, size_t len)
 {
-    if (key)
-        json_dumper_set_member_name(&dumper, key);
-    json_print_base64(data, len);
+    sharkd_json_bytes_begin(key);
+    sharkd_json_bytes_write(data, len);
+    sharkd_json_bytes_end();
 }
 
 static void G_GNUC_PRINTF(2, 3)
 sharkd_json_value_stringf(const char *key, const char *format, ...)
 {
+    va_list ap;
+
+    if (cbor_buf)
+    {
+        char *text;
+
+        sharkd_cbor_member_name(key);
+        va_start(ap, format);
+        text = ws_strdup_vprintf(format, ap);
+        va_end(ap);
+        wscbor_enc_tstr(cbor_buf, text);
+        g_free(text);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
 
-    va_list ap;
     va_start(ap, format);
     char* sformat = ws_strdup_printf("\"%s\"", format);
     json_dumper_value_va_list(&dumper, sformat, ap);
@@ -160,6 +328,13 @@ sharkd_json_value_stringf(const char *key, const char *format, ...)
 static void
 sharkd_json_array_open(const char *key)
 {
+    if (cbor_buf)
+    {
+        sharkd_cbor_member_name(key);
+        wscbor_enc_array_head_indef(cbor_buf);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
     json_dumper_begin_array(&dumper);
@@ -168,12 +343,25 @@ sharkd_json_array_open(const char *key)
 static void
 sharkd_json_array_close(void)
 {
+    if (cbor_buf)
+    {
+        wscbor_enc_break(cbor_buf);
+        return;
+    }
+
     json_dumper_end_array(&dumper);
 }
 
 static void
 sharkd_json_object_open(const char *key)
 {
+    if (cbor_buf)
+    {
+        sharkd_cbor_member_name(key);
+        wscbor_enc_map_head_indef(cbor_buf);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
     json_dumper_begin_object(&dumper);
@@ -182,23 +370,47 @@ sharkd_json_object_open(const char *key)
 static void
 sharkd_json_object_close(void)
 {
+    if (cbor_buf)
+    {
+        wscbor_enc_break(cbor_buf);
+        return;
+    }
+
     json_dumper_end_object(&dumper);
 }
 
 static void
 sharkd_json_response_open(uint32_t id)
 {
-    json_dumper_begin_object(&dumper);  // start the message
+    sharkd_json_object_open(NULL);  // start the message
     sharkd_json_value_string("jsonrpc", "2.0");
     sharkd_json_value_anyf("id", "%d", id);
 }
 
+static void
+sharkd_json_notification_open(const char *method)
+{
+    sharkd_json_object_open(NULL);  // start the message, without an id
+    sharkd_json_value_string("jsonrpc", "2.0");
+    sharkd_json_value_string("method", method);
+}
+
 static void
 sharkd_json_response_close(void)
 {
-    json_dumper_end_object(&dumper);  // end the message
+    sharkd_json_object_close();  // end the message
+
+    if (cbor_buf)
+    {
+        uint8_t len[4];
 
-    json_dumper_finish(&dumper);
+        phtonu32(len, cbor_buf->len);
+        fwrite(len, sizeof(len), 1, stdout);
+        fwrite(cbor_buf->data, 1, cbor_buf->len, stdout);
+        g_byte_array_set_size(cbor_buf, 0);
+    }
+    else
+        json_dumper_finish(&dumper);
 
     /*
      * We do an explicit fflush after every line, because
@@ -227,7 +439,7 @@ sharkd_json_result_prologue(uint32_t id)
 static void
 sharkd_json_result_epilogue(void)
 {
-    json_dumper_end_object(&dumper);  // end the result object
+    sharkd_json_object_close();  // end the result object
     sharkd_json_response_close();
 }
 
@@ -372,15 +584,20 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         // Valid methods
         {"method",     "analyse",        1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "bye",            1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "cancel",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "check",          1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "complete",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "download",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "dumpconf",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "follow",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "encoding",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "field",          1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "fields",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "frame",          1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "frames",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "frames_close",   1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "frames_next",    1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "frames_open",    1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "info",           1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "intervals",      1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "iograph",        1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
@@ -388,6 +605,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"method",     "setcomment",     1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "setconf",        1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "status",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "tail",           1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "tap",            1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
 
         // Parameters and their method context
@@ -397,6 +615,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"complete",   "pref",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"download",   "token",          2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"dumpconf",   "pref",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"encoding",   "format",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"follow",     "follow",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"follow",     "filter",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"follow",     "sub_stream",     2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
@@ -414,6 +633,14 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"frames",     "skip",           2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frames",     "limit",          2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frames",     "refs",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"frames_close", "cursor",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
+        {"frames_next", "cursor",        2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
+        {"frames_next", "limit",         2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
+        {"frames_next", "batch",         2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
+        {"frames_next", "interruptible", 2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
+        {"frames_open", "column*",       2, JSMN_UNDEFINED,    SHARKD_JSON_ANY,      SHARKD_OPTIONAL},
+        {"frames_open", "filter",        2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"frames_open", "refs",          2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"intervals",  "interval",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"intervals",  "filter",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"iograph",    "interval",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
@@ -452,10 +679,13 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"load",       "file",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"load",       "max_packets",    2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"load",       "max_bytes",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
+        {"load",       "memory",         2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
+        {"load",       "tail",           2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"setcomment", "frame",          2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
         {"setcomment", "comment",        2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"setconf",    "name",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"setconf",    "value",          2, JSMN_UNDEFINED,    SHARKD_JSON_ANY,      SHARKD_MANDATORY},
+        {"tail",       "stop",           2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"tap",        "tap0",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"tap",        "tap1",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"tap",        "tap2",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
@@ -473,6 +703,8 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"tap",        "tap14",          2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"tap",        "tap15",          2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"tap",        "filter",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"tap",        "progress",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
+        {"tap",        "interruptible",  2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
 
         // End of the name_array
         {NULL,         NULL,             0, JSMN_STRING,       SHARKD_ARRAY_END,   SHARKD_OPTIONAL},
@@ -739,140 +971,518 @@ sharkd_session_filter_free(void *data)
 {
     struct sharkd_filter_item *l = (struct sharkd_filter_item *) data;
 
-    g_free(l->filtered);
+    for (unsigned i = 0; i < l->num_chunks; i++)
+    {
+        g_free(l->chunks[i].array);
+        g_free(l->chunks[i].bits);
+    }
+    g_free(l->chunks);
     g_free(l);
 }
 
-static const struct sharkd_filter_item *
-sharkd_session_filter_data(const char *filter)
+static void
+sharkd_session_filter_clear(void)
 {
-    struct sharkd_filter_item *l;
+    g_hash_table_remove_all(filter_table);
+    g_queue_clear(&filter_lru);
+    filter_cache_size = 0;
+}
 
-    l = (struct sharkd_filter_item *) g_hash_table_lookup(filter_table, filter);
-    if (!l)
+static bool
+sharkd_filter_bit(const uint8_t *bits, uint32_t framenum)
+{
+    return (bits[framenum / 8] & (1 << (framenum % 8))) != 0;
+}
+
+/*
+ * Compresses a bitmap as returned by sharkd_filter(), or NULL if all
+ * frames match.
+ */
+static struct sharkd_filter_item *
+sharkd_filter_item_new(const uint8_t *bits, uint32_t frames_count)
+{
+    struct sharkd_filter_item *l = g_new0(struct sharkd_filter_item, 1);
+    GArray *chunks;
+
+    if (bits == NULL)
     {
-        uint8_t *filtered = NULL;
+        l->all = true;
+        return l;
+    }
 
-        int ret = sharkd_filter(filter, &filtered);
+    chunks = g_array_new(false, false, sizeof(struct sharkd_filter_chunk));
+    for (uint32_t key = 0; key <= (frames_count >> FILTER_CHUNK_SHIFT); key++)
+    {
+        uint32_t first = key << FILTER_CHUNK_SHIFT;
+        uint32_t last = MIN(frames_count, first + (FILTER_CHUNK_FRAMES - 1));
+        struct sharkd_filter_chunk chunk = { key, 0, NULL, NULL };
 
-        if (ret == -1)
-            return NULL;
+        for (uint32_t framenum = MAX(first, 1); framenum <= last; framenum++)
+        {
+            if (sharkd_filter_bit(bits, framenum))
+                chunk.count++;
+        }
+        if (chunk.count == 0)
+            continue;
 
-        l = g_new(struct sharkd_filter_item, 1);
-        l->filtered = filtered;
+        if (chunk.count <= FILTER_ARRAY_MAX)
+        {
+            unsigned n = 0;
 
-        g_hash_table_insert(filter_table, g_strdup(filter), l);
+            chunk.array = g_new(uint16_t, chunk.count);
+            for (uint32_t framenum = MAX(first, 1); framenum <= last; framenum++)
+            {
+                if (sharkd_filter_bit(bits, framenum))
+                    chunk.array[n++] = (uint16_t) (framenum - first);
+            }
+            l->size += chunk.count * sizeof(uint16_t);
+        }
+        else
+        {
+            chunk.bits = g_new0(uint64_t, FILTER_CHUNK_FRAMES / 64);
+            for (uint32_t framenum = MAX(first, 1); framenum <= last; framenum++)
+            {
+                if (sharkd_filter_bit(bits, framenum))
+                    chunk.bits[(framenum - first) / 64] |= UINT64_C(1) << ((framenum - first) % 64);
+            }
+            l->size += FILTER_CHUNK_FRAMES / 8;
+        }
+        g_array_append_val(chunks, chunk);
     }
 
+    l->num_chunks = chunks->len;
+    l->chunks = (struct sharkd_filter_chunk *) g_array_free(chunks, false);
+    l->size += l->num_chunks * sizeof(struct sharkd_filter_chunk);
     return l;
 }
 
+/* Returns whether the frame matches the filter. */
 static bool
-sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
+sharkd_filter_item_passed(const struct sharkd_filter_item *l, uint32_t framenum)
 {
-    bool ret = false;
-    char **arr;
-    uint32_t tmp_addr_src, tmp_addr_dst;
-    address tmp_src_addr, tmp_dst_addr;
+    uint32_t key = framenum >> FILTER_CHUNK_SHIFT;
+    uint16_t low = (uint16_t) (framenum & (FILTER_CHUNK_FRAMES - 1));
+    unsigned lo = 0, hi = l->num_chunks;
 
-    memset(id, 0, sizeof(*id));
+    if (l->all)
+        return true;
 
-    arr = g_strsplit(init_str, "_", 7); /* pass larger value, so we'll catch incorrect input :) */
-    if (g_strv_length(arr) != 5)
-        goto fail;
+    while (lo < hi)
+    {
+        unsigned mid = lo + (hi - lo) / 2;
+        const struct sharkd_filter_chunk *chunk = &l->chunks[mid];
 
-    /* TODO, for now only IPv4 */
-    if (!get_host_ipaddr(arr[0], &tmp_addr_src))
-        goto fail;
+        if (chunk->key < key)
+            lo = mid + 1;
+        else if (chunk->key > key)
+            hi = mid;
+        else if (chunk->bits)
+            return (chunk->bits[low / 64] >> (low % 64)) & 1;
+        else
+        {
+            unsigned alo = 0, ahi = chunk->count;
 
-    if (!ws_strtou16(arr[1], NULL, &id->src_port))
-        goto fail;
+            while (alo < ahi)
+            {
+                unsigned amid = alo + (ahi - alo) / 2;
+
+                if (chunk->array[amid] < low)
+                    alo = amid + 1;
+                else if (chunk->array[amid] > low)
+                    ahi = amid;
+                else
+                    return true;
+            }
+            return false;
+        }
+    }
+    return false;
+}
 
-    if (!get_host_ipaddr(arr[2], &tmp_addr_dst))
-        goto fail;
+/* Expands the result back to a bitmap as used by sharkd_filter(). */
+static uint8_t *
+sharkd_filter_item_expand(const struct sharkd_filter_item *l, uint32_t frames_count)
+{
+    size_t len = 2 + (frames_count / 8);
+    uint8_t *bits = (uint8_t *) g_malloc0(len);
 
-    if (!ws_strtou16(arr[3], NULL, &id->dst_port))
-        goto fail;
+    if (l->all)
+    {
+        memset(bits, 0xff, len);
+        return bits;
+    }
 
-    if (!ws_hexstrtou32(arr[4], NULL, &id->ssrc))
-        goto fail;
+    for (unsigned i = 0; i < l->num_chunks; i++)
+    {
+        const struct sharkd_filter_chunk *chunk = &l->chunks[i];
+        uint32_t first = chunk->key << FILTER_CHUNK_SHIFT;
 
-    set_address(&tmp_src_addr, AT_IPv4, 4, &tmp_addr_src);
-    copy_address(&id->src_addr, &tmp_src_addr);
-    set_address(&tmp_dst_addr, AT_IPv4, 4, &tmp_addr_dst);
-    copy_address(&id->dst_addr, &tmp_dst_addr);
+        if (chunk->array)
+        {
+            for (uint32_t n = 0; n < chunk->count; n++)
+            {
+                uint32_t framenum = first + chunk->array[n];
 
-    ret = true;
+                bits[framenum / 8] |= 1 << (framenum % 8);
+            }
+        }
+        else
+        {
+            for (uint32_t w = 0; w < FILTER_CHUNK_FRAMES / 64; w++)
+            {
+                uint64_t word = chunk->bits[w];
 
-fail:
-    g_strfreev(arr);
-    return ret;
+                while (word)
+                {
+                    uint32_t framenum = first + w * 64 + ws_ctz(word);
+
+                    bits[framenum / 8] |= 1 << (framenum % 8);
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+    return bits;
 }
 
-static bool
-sharkd_session_process_info_nstat_cb(const void *key, void *value, void *userdata _U_)
+/*
+ * Splits a filter at its top-level "&&"/"and" or "||"/"or" operators,
+ * so that cached results for the operands can be combined. Returns NULL
+ * if there's no such operator, or if both kinds are used; precedence
+ * isn't worth getting into.
+ */
+static char **
+sharkd_filter_split(const char *filter, bool *is_and)
 {
-    stat_tap_table_ui *stat_tap = (stat_tap_table_ui *) value;
+    GPtrArray *operands = g_ptr_array_new();
+    const char *start = filter;
+    int depth = 0;
+    int kind = 0;  /* 1 for and, 2 for or */
 
-    json_dumper_begin_object(&dumper);
-    sharkd_json_value_string("name", stat_tap->title);
-    sharkd_json_value_stringf("tap", "nstat:%s", (const char *) key);
-    json_dumper_end_object(&dumper);
+    for (const char *p = filter; *p; p++)
+    {
+        size_t op_len = 0;
+        int op_kind = 0;
 
-    return false;
-}
+        if (*p == '"')
+        {
+            /* Skip the string, with its escapes. */
+            for (p++; *p && *p != '"'; p++)
+            {
+                if (*p == '\\' && p[1])
+                    p++;
+            }
+            if (!*p)
+                break;
+            continue;
+        }
+        if (*p == '(' || *p == '[' || *p == '{')
+            depth++;
+        else if (*p == ')' || *p == ']' || *p == '}')
+            depth--;
+        if (depth != 0)
+            continue;
 
-static bool
-sharkd_session_process_info_conv_cb(const void* key, void* value, void* userdata _U_)
-{
-    struct register_ct *table = (struct register_ct *) value;
+        if (!strncmp(p, "&&", 2))
+            op_kind = 1, op_len = 2;
+        else if (!strncmp(p, "||", 2))
+            op_kind = 2, op_len = 2;
+        else if (p > filter && g_ascii_isspace(p[-1]))
+        {
+            if (!g_ascii_strncasecmp(p, "and", 3) && (g_ascii_isspace(p[3]) || p[3] == '('))
+                op_kind = 1, op_len = 3;
+            else if (!g_ascii_strncasecmp(p, "or", 2) && (g_ascii_isspace(p[2]) || p[2] == '('))
+                op_kind = 2, op_len = 2;
+        }
+        if (!op_kind)
+            continue;
 
-    const char *label = (const char *) key;
+        if (kind && kind != op_kind)
+        {
+            kind = -1;
+            break;
+        }
+        kind = op_kind;
+        g_ptr_array_add(operands, g_strndup(start, p - start));
+        p += op_len - 1;
+        start = p + 1;
+    }
 
-    if (get_conversation_packet_func(table))
+    if (kind <= 0 || depth != 0)
     {
-        json_dumper_begin_object(&dumper);
-        sharkd_json_value_stringf("name", "Conversation List/%s", label);
-        sharkd_json_value_stringf("tap", "conv:%s", label);
-        json_dumper_end_object(&dumper);
+        g_ptr_array_set_free_func(operands, g_free);
+        g_ptr_array_free(operands, true);
+        return NULL;
     }
+    g_ptr_array_add(operands, g_strdup(start));
+    g_ptr_array_add(operands, NULL);
 
-    if (get_endpoint_packet_func(table))
+    for (char **op = (char **) operands->pdata; *op; op++)
     {
-        json_dumper_begin_object(&dumper);
-        sharkd_json_value_stringf("name", "Endpoint/%s", label);
-        sharkd_json_value_stringf("tap", "endpt:%s", label);
-        json_dumper_end_object(&dumper);
-    }
-    return false;
-}
+        size_t len;
 
-static bool
-sharkd_session_seq_analysis_cb(const void *key, void *value, void *userdata _U_)
-{
-    register_analysis_t *analysis = (register_analysis_t *) value;
+        g_strstrip(*op);
+        /* "(a)" is cached as "a", if it was used on its own before. */
+        len = strlen(*op);
+        if (len >= 2 && (*op)[0] == '(' && (*op)[len - 1] == ')')
+        {
+            int d = 0;
+            size_t i;
 
-    json_dumper_begin_object(&dumper);
-    sharkd_json_value_string("name", sequence_analysis_get_ui_name(analysis));
-    sharkd_json_value_stringf("tap", "seqa:%s", (const char *) key);
-    json_dumper_end_object(&dumper);
+            for (i = 0; i < len - 1; i++)
+            {
+                if ((*op)[i] == '(')
+                    d++;
+                else if ((*op)[i] == ')')
+                    d--;
+                if (d == 0)
+                    break;
+            }
+            if (i == len - 1)
+            {
+                memmove(*op, *op + 1, len - 2);
+                (*op)[len - 2] = '\0';
+                g_strstrip(*op);
+            }
+        }
+    }
 
-    return false;
+    *is_and = (kind == 1);
+    return (char **) g_ptr_array_free(operands, false);
 }
 
-static bool
-sharkd_export_object_visit_cb(const void *key _U_, void *value, void *user_data _U_)
+/*
+ * Runs the filter, using the cached results of its operands, if it's a
+ * conjunction or disjunction of filters used before: only the frames
+ * matching all of them are dissected for "a && b", and only those
+ * matching none of them for "a || b".
+ */
+static int
+sharkd_session_filter_run(const char *filter, uint8_t **filtered)
 {
-    register_eo_t *eo = (register_eo_t *) value;
+    uint8_t *combined = NULL;
+    size_t len = 2 + (cfile.count / 8);
+    char **operands;
+    bool is_and = false;
+    bool all_cached = true;
+    int ret;
 
-    const int proto_id = get_eo_proto_id(eo);
-    const char *filter = proto_get_protocol_filter_name(proto_id);
-    const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
+    operands = sharkd_filter_split(filter, &is_and);
+    if (operands)
+    {
+        for (char **op = operands; *op; op++)
+        {
+            const struct sharkd_filter_item *l;
+            uint8_t *bits;
 
-    json_dumper_begin_object(&dumper);
-    sharkd_json_value_stringf("name", "Export Object/%s", label);
-    sharkd_json_value_stringf("tap", "eo:%s", filter);
-    json_dumper_end_object(&dumper);
+            l = (const struct sharkd_filter_item *) g_hash_table_lookup(filter_table, *op);
+            if (!l)
+            {
+                all_cached = false;
+                continue;
+            }
+
+            bits = sharkd_filter_item_expand(l, cfile.count);
+            if (!combined)
+            {
+                combined = bits;
+                continue;
+            }
+            for (size_t i = 0; i < len; i++)
+                combined[i] = is_and ? (combined[i] & bits[i]) : (combined[i] | bits[i]);
+            g_free(bits);
+        }
+        g_strfreev(operands);
+    }
+
+    if (!combined)
+        return sharkd_filter(filter, filtered);
+
+    if (all_cached)
+    {
+        /* Nothing to dissect at all, once we know the filter is valid. */
+        dfilter_t *dfcode = NULL;
+
+        if (!dfilter_compile_cached(filter, &dfcode, NULL))
+        {
+            g_free(combined);
+            return -1;
+        }
+        dfilter_free(dfcode);
+        *filtered = combined;
+        return 0;
+    }
+
+    if (is_and)
+    {
+        ret = sharkd_filter_candidates(filter, combined, filtered);
+        g_free(combined);
+        return ret;
+    }
+
+    /* The frames in the union match for sure; check the others. */
+    for (size_t i = 0; i < len; i++)
+        combined[i] = ~combined[i];
+    ret = sharkd_filter_candidates(filter, combined, filtered);
+    if (ret != -1 && *filtered)
+    {
+        for (size_t i = 0; i < len; i++)
+            (*filtered)[i] |= (uint8_t) ~combined[i];
+    }
+    g_free(combined);
+    return ret;
+}
+
+static const struct sharkd_filter_item *
+sharkd_session_filter_data(const char *filter)
+{
+    struct sharkd_filter_item *l;
+    char *key;
+
+    l = (struct sharkd_filter_item *) g_hash_table_lookup(filter_table, filter);
+    if (l)
+    {
+        g_queue_unlink(&filter_lru, l->lru_link);
+        g_queue_push_head_link(&filter_lru, l->lru_link);
+    }
+    else
+    {
+        uint8_t *filtered = NULL;
+
+        int ret = sharkd_session_filter_run(filter, &filtered);
+
+        if (ret == -1)
+            return NULL;
+
+        l = sharkd_filter_item_new(filtered, cfile.count);
+        g_free(filtered);
+
+        key = g_strdup(filter);
+        l->filter = key;
+        g_queue_push_head(&filter_lru, l);
+        l->lru_link = filter_lru.head;
+        filter_cache_size += l->size;
+        g_hash_table_insert(filter_table, key, l);
+
+        /* Make room, but always keep the one just added. */
+        while (filter_cache_size > FILTER_CACHE_MAX_SIZE && filter_lru.tail != l->lru_link)
+        {
+            struct sharkd_filter_item *old = (struct sharkd_filter_item *) g_queue_pop_tail(&filter_lru);
+
+            filter_cache_size -= old->size;
+            g_hash_table_remove(filter_table, old->filter);
+        }
+    }
+
+    return l;
+}
+
+static bool
+sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
+{
+    bool ret = false;
+    char **arr;
+    uint32_t tmp_addr_src, tmp_addr_dst;
+    address tmp_src_addr, tmp_dst_addr;
+
+    memset(id, 0, sizeof(*id));
+
+    arr = g_strsplit(init_str, "_", 7); /* pass larger value, so we'll catch incorrect input :) */
+    if (g_strv_length(arr) != 5)
+        goto fail;
+
+    /* TODO, for now only IPv4 */
+    if (!get_host_ipaddr(arr[0], &tmp_addr_src))
+        goto fail;
+
+    if (!ws_strtou16(arr[1], NULL, &id->src_port))
+        goto fail;
+
+    if (!get_host_ipaddr(arr[2], &tmp_addr_dst))
+        goto fail;
+
+    if (!ws_strtou16(arr[3], NULL, &id->dst_port))
+        goto fail;
+
+    if (!ws_hexstrtou32(arr[4], NULL, &id->ssrc))
+        goto fail;
+
+    set_address(&tmp_src_addr, AT_IPv4, 4, &tmp_addr_src);
+    copy_address(&id->src_addr, &tmp_src_addr);
+    set_address(&tmp_dst_addr, AT_IPv4, 4, &tmp_addr_dst);
+    copy_address(&id->dst_addr, &tmp_dst_addr);
+
+    ret = true;
+
+fail:
+    g_strfreev(arr);
+    return ret;
+}
+
+static bool
+sharkd_session_process_info_nstat_cb(const void *key, void *value, void *userdata _U_)
+{
+    stat_tap_table_ui *stat_tap = (stat_tap_table_ui *) value;
+
+    sharkd_json_object_open(NULL);
+    sharkd_json_value_string("name", stat_tap->title);
+    sharkd_json_value_stringf("tap", "nstat:%s", (const char *) key);
+    sharkd_json_object_close();
+
+    return false;
+}
+
+static bool
+sharkd_session_process_info_conv_cb(const void* key, void* value, void* userdata _U_)
+{
+    struct register_ct *table = (struct register_ct *) value;
+
+    const char *label = (const char *) key;
+
+    if (get_conversation_packet_func(table))
+    {
+        sharkd_json_object_open(NULL);
+        sharkd_json_value_stringf("name", "Conversation List/%s", label);
+        sharkd_json_value_stringf("tap", "conv:%s", label);
+        sharkd_json_object_close();
+    }
+
+    if (get_endpoint_packet_func(table))
+    {
+        sharkd_json_object_open(NULL);
+        sharkd_json_value_stringf("name", "Endpoint/%s", label);
+        sharkd_json_value_stringf("tap", "endpt:%s", label);
+        sharkd_json_object_close();
+    }
+    return false;
+}
+
+static bool
+sharkd_session_seq_analysis_cb(const void *key, void *value, void *userdata _U_)
+{
+    register_analysis_t *analysis = (register_analysis_t *) value;
+
+    sharkd_json_object_open(NULL);
+    sharkd_json_value_string("name", sequence_analysis_get_ui_name(analysis));
+    sharkd_json_value_stringf("tap", "seqa:%s", (const char *) key);
+    sharkd_json_object_close();
+
+    return false;
+}
+
+static bool
+sharkd_export_object_visit_cb(const void *key _U_, void *value, void *user_data _U_)
+{
+    register_eo_t *eo = (register_eo_t *) value;
+
+    const int proto_id = get_eo_proto_id(eo);
+    const char *filter = proto_get_protocol_filter_name(proto_id);
+    const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
+
+    sharkd_json_object_open(NULL);
+    sharkd_json_value_stringf("name", "Export Object/%s", label);
+    sharkd_json_value_stringf("tap", "eo:%s", filter);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -886,10 +1496,10 @@ sharkd_srt_visit_cb(const void *key _U_, void *value, void *user_data _U_)
     const char *filter = proto_get_protocol_filter_name(proto_id);
     const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("name", "Service Response Time/%s", label);
     sharkd_json_value_stringf("tap", "srt:%s", filter);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -903,10 +1513,10 @@ sharkd_rtd_visit_cb(const void *key _U_, void *value, void *user_data _U_)
     const char *filter = proto_get_protocol_filter_name(proto_id);
     const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("name", "Response Time Delay/%s", label);
     sharkd_json_value_stringf("tap", "rtd:%s", filter);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -920,10 +1530,10 @@ sharkd_follower_visit_cb(const void *key _U_, void *value, void *user_data _U_)
     const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
     const char *filter = label; /* correct: get_follow_by_name() is registered by short name */
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("name", "Follow/%s", label);
     sharkd_json_value_stringf("tap", "follow:%s", filter);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -1056,10 +1666,10 @@ sharkd_session_process_info(void)
         const char *col_format = col_format_to_string(i);
         const char *col_descr  = col_format_desc(i);
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", col_descr);
         sharkd_json_value_string("format", col_format);
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
@@ -1072,10 +1682,10 @@ sharkd_session_process_info(void)
         {
             stats_tree_cfg *cfg = (stats_tree_cfg *) l->data;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
             sharkd_json_value_string("name", cfg->title);
             sharkd_json_value_stringf("tap", "stat:%s", cfg->abbr);
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
 
         g_list_free(cfg_list);
@@ -1114,35 +1724,35 @@ sharkd_session_process_info(void)
 
     sharkd_json_array_open("taps");
     {
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "UDP Multicast Streams");
         sharkd_json_value_string("tap", "multicast");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "RTP streams");
         sharkd_json_value_string("tap", "rtp-streams");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "Protocol Hierarchy Statistics");
         sharkd_json_value_string("tap", "phs");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "VoIP Calls");
         sharkd_json_value_string("tap", "voip-calls");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "VoIP Conversations");
         sharkd_json_value_string("tap", "voip-convs");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "Expert Information");
         sharkd_json_value_string("tap", "expert");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
@@ -1286,6 +1896,12 @@ sharkd_session_process_field(const char* buf, const jsmntok_t* tokens, int count
  *
  * Input:
  *   (m) file - file to be loaded
+ *   (o) max_packets - stop after this many packets
+ *   (o) max_bytes   - stop after this many bytes
+ *   (o) memory      - if true, count the memory requested by each protocol
+ *                     while loading, for "status" to report
+ *   (o) tail        - if true, the file is still being written; read what's
+ *                     there, and the rest with "tail" requests
  *
  * Output object with attributes:
  *   (m) err - error code
@@ -1296,6 +1912,10 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
     const char *tok_file = json_find_attr(buf, tokens, count, "file");
     const char *tok_max_packets = json_find_attr(buf, tokens, count, "max_packets");
     const char *tok_max_bytes = json_find_attr(buf, tokens, count, "max_bytes");
+    const char *tok_memory = json_find_attr(buf, tokens, count, "memory");
+    const char *tok_tail = json_find_attr(buf, tokens, count, "tail");
+    bool memory = (tok_memory && !strcmp(tok_memory, "true"));
+    bool tail = (tok_tail && !strcmp(tok_tail, "true"));
     int err = 0;
 
     uint32_t max_packets = 0;  /* 0 means unlimited */
@@ -1330,9 +1950,33 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
         }
     }
 
+    if (tail && (max_packets > 0 || max_bytes > 0))
+    {
+        sharkd_json_error(
+                rpcid, -32602, NULL,
+                "tail can't be used with max_packets or max_bytes"
+                );
+        return;
+    }
+
     fprintf(stderr, "load: filename=%s, max_packets=%u, max_bytes=%" PRIu64 "\n",
             tok_file, max_packets, max_bytes);
 
+    /* Cached filter results and open cursors are for the file loaded before. */
+    sharkd_session_filter_clear();
+    g_hash_table_remove_all(frames_cursors);
+
+    /* The counts are for this file only. */
+    dissector_perf_reset();
+    dissector_perf_enable(memory);
+
+    if (max_packets == 0 && max_bytes == 0 && !memory && !tail && sharkd_cf_is_preloaded(tok_file))
+    {
+        /* Already loaded by the daemon before it forked us. */
+        sharkd_json_simple_ok(rpcid);
+        return;
+    }
+
     if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, false, &err) != CF_OK)
     {
         sharkd_json_error(
@@ -1348,6 +1992,10 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
         {
             err = sharkd_load_cap_file_with_limits((int)max_packets, (int64_t)max_bytes);
         }
+        else if (tail)
+        {
+            err = sharkd_load_cap_file_tail();
+        }
         else
         {
             err = sharkd_load_cap_file();
@@ -1363,6 +2011,7 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
         err = ENOMEM;
     }
     ENDTRY;
+    dissector_perf_enable(false);
 
     if (err == 0)
     {
@@ -1378,6 +2027,140 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 }
 
+/*
+ * Brings the cached filter results up to date with the frames after
+ * old_count, which are the only ones dissected; a result that can't be
+ * brought up to date is dropped.
+ */
+static void
+sharkd_session_filter_extend(uint32_t old_count)
+{
+    size_t len = 2 + (cfile.count / 8);
+    uint8_t *candidates = (uint8_t *) g_malloc0(len);
+    GPtrArray *failed = g_ptr_array_new();
+    GHashTableIter iter;
+    void *value;
+
+    for (uint32_t framenum = old_count + 1; framenum <= cfile.count; framenum++)
+        candidates[framenum / 8] |= 1 << (framenum % 8);
+
+    g_hash_table_iter_init(&iter, filter_table);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+        struct sharkd_filter_item *l = (struct sharkd_filter_item *) value;
+        struct sharkd_filter_item *n;
+        uint8_t *added = NULL;
+        uint8_t *bits;
+
+        if (sharkd_filter_candidates(l->filter, candidates, &added) == -1 || !added)
+        {
+            g_ptr_array_add(failed, l);
+            continue;
+        }
+
+        bits = (uint8_t *) g_malloc0(len);
+        for (uint32_t framenum = 1; framenum <= old_count; framenum++)
+        {
+            if (sharkd_filter_item_passed(l, framenum))
+                bits[framenum / 8] |= 1 << (framenum % 8);
+        }
+        for (size_t i = 0; i < len; i++)
+            bits[i] |= added[i] & candidates[i];
+        g_free(added);
+
+        n = sharkd_filter_item_new(bits, cfile.count);
+        g_free(bits);
+
+        /* Swap the results in, keeping the key and the place in the LRU. */
+        for (unsigned i = 0; i < l->num_chunks; i++)
+        {
+            g_free(l->chunks[i].array);
+            g_free(l->chunks[i].bits);
+        }
+        g_free(l->chunks);
+        filter_cache_size -= l->size;
+        l->all = n->all;
+        l->chunks = n->chunks;
+        l->num_chunks = n->num_chunks;
+        l->size = n->size;
+        filter_cache_size += l->size;
+        g_free(n);
+    }
+
+    for (unsigned i = 0; i < failed->len; i++)
+    {
+        struct sharkd_filter_item *l = (struct sharkd_filter_item *) g_ptr_array_index(failed, i);
+
+        g_queue_delete_link(&filter_lru, l->lru_link);
+        filter_cache_size -= l->size;
+        g_hash_table_remove(filter_table, l->filter);
+    }
+
+    g_ptr_array_free(failed, true);
+    g_free(candidates);
+}
+
+/**
+ * sharkd_session_process_tail()
+ *
+ * Process tail request, for a file loaded with tail set
+ *
+ * Input:
+ *   (o) stop - if true, stop following the file after reading what's been added
+ *
+ * Cached filter results are updated for the new frames, and "frames_next"
+ * carries on into them.
+ *
+ * Output object with attributes:
+ *   (m) frames  - count of currently loaded frames
+ *   (m) added   - count of frames read by this request
+ *   (m) tailing - true, while the file is still being followed
+ *   (o) err     - error code, if reading the file failed; tailing is then false
+ */
+static void
+sharkd_session_process_tail(const char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_stop = json_find_attr(buf, tokens, count, "stop");
+    uint32_t old_count = cfile.count;
+    uint32_t added = 0;
+    int err = 0;
+
+    if (!sharkd_is_tailing())
+    {
+        sharkd_json_error(
+                rpcid, -2002, NULL,
+                "No file is being followed"
+                );
+        return;
+    }
+
+    TRY
+    {
+        err = sharkd_continue_tail(&added);
+    }
+    CATCH(OutOfMemoryError)
+    {
+        fprintf(stderr, "tail: OutOfMemoryError\n");
+        err = ENOMEM;
+        sharkd_finish_tail();
+    }
+    ENDTRY;
+
+    if (added > 0)
+        sharkd_session_filter_extend(old_count);
+
+    if (tok_stop && !strcmp(tok_stop, "true"))
+        sharkd_finish_tail();
+
+    sharkd_json_result_prologue(rpcid);
+    sharkd_json_value_anyf("frames", "%u", cfile.count);
+    sharkd_json_value_anyf("added", "%u", added);
+    sharkd_json_value_anyf("tailing", sharkd_is_tailing() ? "true" : "false");
+    if (err != 0)
+        sharkd_json_value_anyf("err", "%d", err);
+    sharkd_json_result_epilogue();
+}
+
 /**
  * sharkd_session_process_status()
  *
@@ -1394,6 +2177,13 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *                      'format'   - column format (%x or %Cus:<expr>:<occurrence> if COL_CUSTOM)
  *                      'visible'  - true if column is visible
  *                      'display'  - column display format; 'U', 'R' or 'D'
+ *   (m) memory      - array of memory components, objects with attributes:
+ *                      'name'     - what the memory is used for
+ *                      'bytes'    - bytes in use
+ *   (o) protocol_memory - if the file was loaded with memory set, array of objects with attributes:
+ *                      'protocol'     - protocol filter name
+ *                      'file_bytes'   - file scope bytes requested by the protocol's dissectors
+ *                      'packet_bytes' - packet scope bytes requested by the protocol's dissectors
  */
 static void
 sharkd_session_process_status(void)
@@ -1447,6 +2237,40 @@ sharkd_session_process_status(void)
         sharkd_json_array_close();
     }
 
+    const char *mem_name;
+    size_t mem_value;
+
+    sharkd_json_array_open("memory");
+    for (unsigned i = 0; (mem_name = memory_usage_get(i, &mem_value)) != NULL; i++)
+    {
+        sharkd_json_object_open(NULL);
+        sharkd_json_value_string("name", mem_name);
+        sharkd_json_value_anyf("bytes", "%zu", mem_value);
+        sharkd_json_object_close();
+    }
+    sharkd_json_array_close();
+
+    GPtrArray *perf_stats = dissector_perf_get_stats();
+
+    if (perf_stats->len > 0)
+    {
+        sharkd_json_array_open("protocol_memory");
+        for (unsigned i = 0; i < perf_stats->len; i++)
+        {
+            dissector_perf_t *perf = (dissector_perf_t *)g_ptr_array_index(perf_stats, i);
+
+            if (perf->self_file_bytes == 0 && perf->self_bytes == 0)
+                continue;
+            sharkd_json_object_open(NULL);
+            sharkd_json_value_string("protocol", proto_get_protocol_filter_name(perf->proto_id));
+            sharkd_json_value_anyf("file_bytes", "%" PRIu64, perf->self_file_bytes);
+            sharkd_json_value_anyf("packet_bytes", "%" PRIu64, perf->self_bytes);
+            sharkd_json_object_close();
+        }
+        sharkd_json_array_close();
+    }
+    g_ptr_array_unref(perf_stats);
+
     sharkd_json_result_epilogue();
 }
 
@@ -1645,7 +2469,7 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
     unsigned int i;
     char *comment = NULL;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_array_open("c");
     for (unsigned col = 0; col < cinfo->num_cols; ++col)
@@ -1689,7 +2513,41 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
     }
 
     wtap_block_unref(pkt_block);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
+}
+
+/*
+ * Moves along the sorted list of time reference frames, given as "refs",
+ * up to the frame about to be dissected.
+ */
+static void
+sharkd_session_frames_refs_advance(uint32_t framenum, const char **refs,
+        uint32_t *current_ref_frame, uint32_t *next_ref_frame)
+{
+    if (framenum < *next_ref_frame)
+        return;
+
+    *current_ref_frame = *next_ref_frame;
+
+    if (**refs != ',')
+        *next_ref_frame = UINT32_MAX;
+
+    while (**refs == ',' && framenum >= *next_ref_frame)
+    {
+        *current_ref_frame = *next_ref_frame;
+
+        if (!ws_strtou32(*refs + 1, refs, next_ref_frame))
+        {
+            fprintf(stderr, "sharkd_session_process_frames() wrong format for refs: %s\n", *refs);
+            break;
+        }
+    }
+
+    if (**refs == '\0' && framenum >= *next_ref_frame)
+    {
+        *current_ref_frame = *next_ref_frame;
+        *next_ref_frame = UINT32_MAX;
+    }
 }
 
 /**
@@ -1724,7 +2582,7 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
     const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
     const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
 
-    const uint8_t *filter_data = NULL;
+    const struct sharkd_filter_item *filter_data = NULL;
 
     uint32_t prev_dis_num = 0;
     uint32_t current_ref_frame = 0, next_ref_frame = UINT32_MAX;
@@ -1749,99 +2607,367 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
         }
     }
 
-    if (tok_filter)
-    {
-        const struct sharkd_filter_item *filter_item;
+    if (tok_filter)
+    {
+        const struct sharkd_filter_item *filter_item;
+
+        filter_item = sharkd_session_filter_data(tok_filter);
+        if (!filter_item)
+        {
+            sharkd_json_error(
+                    rpcid, -13002, NULL,
+                    "Filter expression invalid"
+                    );
+            return;
+        }
+
+        filter_data = filter_item;
+    }
+
+    skip = 0;
+    if (tok_skip)
+    {
+        if (!ws_strtou32(tok_skip, NULL, &skip))
+            return;
+    }
+
+    limit = 0;
+    if (tok_limit)
+    {
+        if (!ws_strtou32(tok_limit, NULL, &limit))
+            return;
+    }
+
+    if (tok_refs)
+    {
+        if (!ws_strtou32(tok_refs, &tok_refs, &next_ref_frame))
+            return;
+    }
+
+    sharkd_json_result_array_prologue(rpcid);
+
+    wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
+
+    for (uint32_t framenum = 1; framenum <= cfile.count; framenum++)
+    {
+        frame_data *fdata;
+        uint32_t ref_frame = (framenum != 1) ? 1 : 0;
+        enum dissect_request_status status;
+        int err;
+        char *err_info;
+
+        if (filter_data && !sharkd_filter_item_passed(filter_data, framenum))
+            continue;
+
+        if (skip)
+        {
+            skip--;
+            prev_dis_num = framenum;
+            continue;
+        }
+
+        if (tok_refs)
+        {
+            sharkd_session_frames_refs_advance(framenum, &tok_refs, &current_ref_frame, &next_ref_frame);
+
+            if (current_ref_frame)
+                ref_frame = current_ref_frame;
+        }
+
+        fdata = sharkd_get_frame(framenum);
+        status = sharkd_dissect_request(framenum,
+                ref_frame, prev_dis_num,
+                &rec, cinfo,
+                (fdata->color_filter == NULL) ? SHARKD_DISSECT_FLAG_COLOR : SHARKD_DISSECT_FLAG_NULL,
+                &sharkd_session_process_frames_cb, NULL,
+                &err, &err_info);
+        switch (status) {
+
+            case DISSECT_REQUEST_SUCCESS:
+                break;
+
+            case DISSECT_REQUEST_NO_SUCH_FRAME:
+                /* XXX - report the error. */
+                break;
+
+            case DISSECT_REQUEST_READ_ERROR:
+                /*
+                 * Free up the error string.
+                 * XXX - report the error.
+                 */
+                g_free(err_info);
+                break;
+        }
+
+        prev_dis_num = framenum;
+
+        if (limit && --limit == 0)
+            break;
+    }
+    sharkd_json_result_array_epilogue();
+
+    if (cinfo != &cfile.cinfo)
+        col_cleanup(cinfo);
+
+    wtap_rec_cleanup(&rec);
+}
+
+/*
+ * A cursor over the frames matching a filter, kept between "frames_next"
+ * requests, so that a client can page through them without each page
+ * walking the file from the start or setting up its columns again.
+ */
+struct sharkd_frames_cursor
+{
+    uint32_t id;
+    char *filter;           /* NULL for all frames */
+    char *refs;             /* NULL if no "refs" were given */
+    const char *refs_pos;
+    uint32_t current_ref_frame;
+    uint32_t next_ref_frame;
+    column_info user_cinfo;
+    bool has_user_cinfo;
+    uint32_t framenum;      /* next frame to look at */
+    uint32_t prev_dis_num;
+};
+
+#define SHARKD_FRAMES_NEXT_LIMIT  1000  /* rows per "frames_next", unless given */
+#define SHARKD_FRAMES_NEXT_BATCH  100   /* rows per "frames_rows" notification, unless given */
+
+static void
+sharkd_session_frames_cursor_free(void *data)
+{
+    struct sharkd_frames_cursor *cursor = (struct sharkd_frames_cursor *) data;
+
+    if (cursor->has_user_cinfo)
+        col_cleanup(&cursor->user_cinfo);
+    g_free(cursor->filter);
+    g_free(cursor->refs);
+    g_free(cursor);
+}
+
+static struct sharkd_frames_cursor *
+sharkd_session_frames_cursor_find(const char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_cursor = json_find_attr(buf, tokens, count, "cursor");
+    struct sharkd_frames_cursor *cursor = NULL;
+    uint32_t id;
+
+    if (tok_cursor && ws_strtou32(tok_cursor, NULL, &id))
+        cursor = (struct sharkd_frames_cursor *) g_hash_table_lookup(frames_cursors, GUINT_TO_POINTER(id));
+
+    if (!cursor)
+    {
+        sharkd_json_error(
+                rpcid, -13003, NULL,
+                "No such cursor"
+                );
+    }
+    return cursor;
+}
+
+/* Is there another request waiting, which should stop the current one? */
+static bool
+sharkd_session_input_pending(void)
+{
+#ifndef _WIN32
+    struct pollfd pfd;
+
+    pfd.fd = fileno(stdin);
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, 0) > 0;
+#else
+    /* XXX - no way to tell for a pipe without reading it. */
+    return false;
+#endif
+}
+
+/**
+ * sharkd_session_process_frames_open()
+ *
+ * Process frames_open request
+ *
+ * Input:
+ *   (o) column0...columnXX - requested columns, as for frames
+ *   (o) filter - filter to be used
+ *   (o) refs  - list (comma separated) with sorted time reference frame numbers.
+ *
+ * Output object with attributes:
+ *   (m) cursor - cursor to pass to frames_next and frames_close
+ */
+static void
+sharkd_session_process_frames_open(const char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
+    const char *tok_column = json_find_attr(buf, tokens, count, "column0");
+    const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
+
+    struct sharkd_frames_cursor *cursor;
+    uint32_t next_ref_frame = UINT32_MAX;
+
+    if (tok_refs)
+    {
+        if (!ws_strtou32(tok_refs, &tok_refs, &next_ref_frame))
+            return;
+    }
+
+    if (tok_filter && !sharkd_session_filter_data(tok_filter))
+    {
+        sharkd_json_error(
+                rpcid, -13002, NULL,
+                "Filter expression invalid"
+                );
+        return;
+    }
+
+    cursor = g_new0(struct sharkd_frames_cursor, 1);
+
+    if (tok_column)
+    {
+        if (!sharkd_session_create_columns(&cursor->user_cinfo, buf, tokens, count))
+        {
+            g_free(cursor);
+            sharkd_json_error(
+                    rpcid, -13001, NULL,
+                    "Column definition invalid - note column 6 requires a custom definition"
+                    );
+            return;
+        }
+        cursor->has_user_cinfo = true;
+    }
+
+    cursor->id = ++frames_cursor_last_id;
+    cursor->filter = g_strdup(tok_filter);
+    if (tok_refs)
+    {
+        cursor->refs = g_strdup(tok_refs);
+        cursor->refs_pos = cursor->refs;
+    }
+    cursor->next_ref_frame = next_ref_frame;
+    cursor->framenum = 1;
+
+    g_hash_table_insert(frames_cursors, GUINT_TO_POINTER(cursor->id), cursor);
+
+    sharkd_json_result_prologue(rpcid);
+    sharkd_json_value_anyf("cursor", "%u", cursor->id);
+    sharkd_json_result_epilogue();
+}
+
+/**
+ * sharkd_session_process_frames_next()
+ *
+ * Process frames_next request
+ *
+ * Input:
+ *   (m) cursor - as returned by frames_open
+ *   (o) limit=N  - show at most N frames, 1000 by default
+ *   (o) batch=N  - send the frames in notifications of N frames, 100 by default
+ *   (o) interruptible - stop early, if another request comes in meanwhile
+ *
+ * The frames are sent as they're dissected, in "frames_rows" notifications
+ * with attributes:
+ *   (m) cursor - the cursor
+ *   (m) rows   - array of frames, with the attributes used by frames
+ *
+ * Output object with attributes:
+ *   (m) rows        - number of frames sent
+ *   (m) done        - true, if there are no more frames
+ *   (o) interrupted - true, if stopped early; frames_next carries on from there
+ */
+static void
+sharkd_session_process_frames_next(const char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_limit = json_find_attr(buf, tokens, count, "limit");
+    const char *tok_batch = json_find_attr(buf, tokens, count, "batch");
+    const char *tok_interruptible = json_find_attr(buf, tokens, count, "interruptible");
+
+    struct sharkd_frames_cursor *cursor;
+    const struct sharkd_filter_item *filter_data = NULL;
+    uint32_t limit = SHARKD_FRAMES_NEXT_LIMIT;
+    uint32_t batch = SHARKD_FRAMES_NEXT_BATCH;
+    bool interruptible = false;
+    bool interrupted = false;
+    uint32_t rows = 0, batch_rows = 0;
 
-        filter_item = sharkd_session_filter_data(tok_filter);
-        if (!filter_item)
-        {
-            sharkd_json_error(
-                    rpcid, -13002, NULL,
-                    "Filter expression invalid"
-                    );
-            return;
-        }
+    wtap_rec rec; /* Record information */
+    column_info *cinfo;
 
-        filter_data = filter_item->filtered;
-    }
+    cursor = sharkd_session_frames_cursor_find(buf, tokens, count);
+    if (!cursor)
+        return;
 
-    skip = 0;
-    if (tok_skip)
+    if (tok_limit)
     {
-        if (!ws_strtou32(tok_skip, NULL, &skip))
+        if (!ws_strtou32(tok_limit, NULL, &limit))
             return;
     }
 
-    limit = 0;
-    if (tok_limit)
+    if (tok_batch)
     {
-        if (!ws_strtou32(tok_limit, NULL, &limit))
+        if (!ws_strtou32(tok_batch, NULL, &batch))
             return;
     }
 
-    if (tok_refs)
+    if (tok_interruptible && !strcmp(tok_interruptible, "true"))
+        interruptible = true;
+
+    if (cursor->filter)
     {
-        if (!ws_strtou32(tok_refs, &tok_refs, &next_ref_frame))
+        /* Usually still cached, but it might have been evicted since. */
+        filter_data = sharkd_session_filter_data(cursor->filter);
+        if (!filter_data)
+        {
+            sharkd_json_error(
+                    rpcid, -13002, NULL,
+                    "Filter expression invalid"
+                    );
             return;
+        }
     }
 
-    sharkd_json_result_array_prologue(rpcid);
+    cinfo = cursor->has_user_cinfo ? &cursor->user_cinfo : &cfile.cinfo;
 
     wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
 
-    for (uint32_t framenum = 1; framenum <= cfile.count; framenum++)
+    for (; cursor->framenum <= cfile.count && rows < limit; cursor->framenum++)
     {
+        uint32_t framenum = cursor->framenum;
         frame_data *fdata;
         uint32_t ref_frame = (framenum != 1) ? 1 : 0;
         enum dissect_request_status status;
         int err;
         char *err_info;
 
-        if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
+        if (filter_data && !sharkd_filter_item_passed(filter_data, framenum))
             continue;
 
-        if (skip)
+        if (interruptible && sharkd_session_input_pending())
         {
-            skip--;
-            prev_dis_num = framenum;
-            continue;
+            interrupted = true;
+            break;
         }
 
-        if (tok_refs)
+        if (cursor->refs)
         {
-            if (framenum >= next_ref_frame)
-            {
-                current_ref_frame = next_ref_frame;
-
-                if (*tok_refs != ',')
-                    next_ref_frame = UINT32_MAX;
-
-                while (*tok_refs == ',' && framenum >= next_ref_frame)
-                {
-                    current_ref_frame = next_ref_frame;
-
-                    if (!ws_strtou32(tok_refs + 1, &tok_refs, &next_ref_frame))
-                    {
-                        fprintf(stderr, "sharkd_session_process_frames() wrong format for refs: %s\n", tok_refs);
-                        break;
-                    }
-                }
+            sharkd_session_frames_refs_advance(framenum, &cursor->refs_pos,
+                    &cursor->current_ref_frame, &cursor->next_ref_frame);
 
-                if (*tok_refs == '\0' && framenum >= next_ref_frame)
-                {
-                    current_ref_frame = next_ref_frame;
-                    next_ref_frame = UINT32_MAX;
-                }
-            }
+            if (cursor->current_ref_frame)
+                ref_frame = cursor->current_ref_frame;
+        }
 
-            if (current_ref_frame)
-                ref_frame = current_ref_frame;
+        if (batch_rows == 0)
+        {
+            sharkd_json_notification_open("frames_rows");
+            sharkd_json_object_open("params");
+            sharkd_json_value_anyf("cursor", "%u", cursor->id);
+            sharkd_json_array_open("rows");
         }
 
         fdata = sharkd_get_frame(framenum);
         status = sharkd_dissect_request(framenum,
-                ref_frame, prev_dis_num,
+                ref_frame, cursor->prev_dis_num,
                 &rec, cinfo,
                 (fdata->color_filter == NULL) ? SHARKD_DISSECT_FLAG_COLOR : SHARKD_DISSECT_FLAG_NULL,
                 &sharkd_session_process_frames_cb, NULL,
@@ -1864,17 +2990,59 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
                 break;
         }
 
-        prev_dis_num = framenum;
+        cursor->prev_dis_num = framenum;
+        rows++;
 
-        if (limit && --limit == 0)
-            break;
+        if (++batch_rows == batch)
+        {
+            sharkd_json_array_close();
+            sharkd_json_object_close();
+            sharkd_json_response_close();
+            batch_rows = 0;
+        }
     }
-    sharkd_json_result_array_epilogue();
 
-    if (cinfo != &cfile.cinfo)
-        col_cleanup(cinfo);
+    if (batch_rows)
+    {
+        sharkd_json_array_close();
+        sharkd_json_object_close();
+        sharkd_json_response_close();
+    }
 
     wtap_rec_cleanup(&rec);
+
+    /* Skip the frames not matching, so that done is right. */
+    while (!interrupted && filter_data && cursor->framenum <= cfile.count &&
+            !sharkd_filter_item_passed(filter_data, cursor->framenum))
+        cursor->framenum++;
+
+    sharkd_json_result_prologue(rpcid);
+    sharkd_json_value_anyf("rows", "%u", rows);
+    sharkd_json_value_anyf("done", cursor->framenum > cfile.count ? "true" : "false");
+    if (interrupted)
+        sharkd_json_value_anyf("interrupted", "true");
+    sharkd_json_result_epilogue();
+}
+
+/**
+ * sharkd_session_process_frames_close()
+ *
+ * Process frames_close request
+ *
+ * Input:
+ *   (m) cursor - as returned by frames_open
+ */
+static void
+sharkd_session_process_frames_close(const char *buf, const jsmntok_t *tokens, int count)
+{
+    struct sharkd_frames_cursor *cursor;
+
+    cursor = sharkd_session_frames_cursor_find(buf, tokens, count);
+    if (!cursor)
+        return;
+
+    g_hash_table_remove(frames_cursors, GUINT_TO_POINTER(cursor->id));
+    sharkd_json_simple_ok(rpcid);
 }
 
 static void
@@ -1886,7 +3054,7 @@ sharkd_session_process_tap_stats_node_cb(const char *key, const stat_node *n)
     sharkd_json_array_open(key);
     for (node = n->children; node; node = node->next)
     {
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         /* code based on stats_tree_get_values_from_node() */
         sharkd_json_value_string("name", node->name);
@@ -1931,7 +3099,7 @@ sharkd_session_process_tap_stats_node_cb(const char *key, const stat_node *n)
             // We recurse here but our depth is limited
             sharkd_session_process_tap_stats_node_cb("sub", node);
         }
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 }
@@ -1962,7 +3130,7 @@ sharkd_session_process_tap_stats_cb(void *psp)
 {
     stats_tree *st = (stats_tree *) psp;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_value_stringf("tap", "stats:%s", st->cfg->abbr);
     sharkd_json_value_string("type", "stats");
@@ -1970,7 +3138,7 @@ sharkd_session_process_tap_stats_cb(void *psp)
 
     sharkd_session_process_tap_stats_node_cb("stats", &st->root);
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2007,7 +3175,7 @@ sharkd_session_process_tap_expert_cb(void *tapdata)
     struct sharkd_expert_tap *etd = (struct sharkd_expert_tap *) tapdata;
     GSList *list;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_value_string("tap", "expert");
     sharkd_json_value_string("type", "expert");
@@ -2018,7 +3186,7 @@ sharkd_session_process_tap_expert_cb(void *tapdata)
         expert_info_t *ei = (expert_info_t *) list->data;
         const char *tmp;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_anyf("f", "%u", ei->packet_num);
 
@@ -2035,11 +3203,11 @@ sharkd_session_process_tap_expert_cb(void *tapdata)
         if (ei->protocol)
             sharkd_json_value_string("p", ei->protocol);
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static tap_packet_status
@@ -2097,7 +3265,7 @@ sharkd_session_process_tap_flow_cb(void *tapdata)
 
     sequence_analysis_get_nodes(graph_analysis);
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("tap", "seqa:%s", graph_analysis->name);
     sharkd_json_value_string("type", "flow");
 
@@ -2123,7 +3291,7 @@ sharkd_session_process_tap_flow_cb(void *tapdata)
         if (!sai->display)
             continue;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_string("t", sai->time_str);
         sharkd_json_value_anyf("n", "[%u,%u]", sai->src_node, sai->dst_node);
@@ -2132,11 +3300,11 @@ sharkd_session_process_tap_flow_cb(void *tapdata)
         if (sai->comment)
             sharkd_json_value_string("c", sai->comment);
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2344,7 +3512,7 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
 
     GSList *l;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_value_string("tap", rtp_req->tap_name);
     sharkd_json_value_string("type", "rtp-analyse");
@@ -2364,7 +3532,7 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
     {
         struct sharkd_analyse_rtp_items *item = (struct sharkd_analyse_rtp_items *) l->data;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_anyf("f", "%u", item->frame_num);
         sharkd_json_value_anyf("o", "%.9f", item->arrive_offset);
@@ -2428,11 +3596,11 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
         if (item->marker)
             sharkd_json_value_anyf("mark", "1");
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 /**
@@ -2477,7 +3645,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
 
     int with_geoip = 0;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("tap", iu->type);
 
     if (!strncmp(iu->type, "conv:", 5))
@@ -2509,7 +3677,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
             char *src_port, *dst_port;
             char *filter_str;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_json_value_string("saddr", (src_addr = get_conversation_address(NULL, &iui->src_address, iu->resolve_name)));
             sharkd_json_value_string("daddr", (dst_addr = get_conversation_address(NULL, &iui->dst_address, iu->resolve_name)));
@@ -2547,7 +3715,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
             if (sharkd_session_geoip_addr(&(iui->dst_address), "2"))
                 with_geoip = 1;
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
     }
     else if (iu->hash.conv_array != NULL && !strncmp(iu->type, "endpt:", 6))
@@ -2558,7 +3726,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
             char *host_str, *port_str;
             char *filter_str;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_json_value_string("host", (host_str = get_conversation_address(NULL, &endpoint->myaddress, iu->resolve_name)));
 
@@ -2586,7 +3754,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
 
             if (sharkd_session_geoip_addr(&(endpoint->myaddress), ""))
                 with_geoip = 1;
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
     }
     sharkd_json_array_close();
@@ -2594,7 +3762,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
     sharkd_json_value_string("proto", proto);
     sharkd_json_value_anyf("geoip", with_geoip ? "true" : "false");
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2634,7 +3802,7 @@ sharkd_session_process_tap_nstat_cb(void *arg)
     stat_data_t *stat_data = (stat_data_t *) arg;
     unsigned i, j, k;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("tap", "nstat:%s", stat_data->stat_tap_data->cli_string);
     sharkd_json_value_string("type", "nstat");
 
@@ -2643,9 +3811,9 @@ sharkd_session_process_tap_nstat_cb(void *arg)
     {
         stat_tap_table_item *field = &(stat_data->stat_tap_data->fields[i]);
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("c", field->column_name);
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
@@ -2654,7 +3822,7 @@ sharkd_session_process_tap_nstat_cb(void *arg)
     {
         stat_tap_table *table = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table *, i);
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_string("t", table->title);
 
@@ -2703,11 +3871,11 @@ sharkd_session_process_tap_nstat_cb(void *arg)
             sharkd_json_array_close();
         }
         sharkd_json_array_close();
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2759,7 +3927,7 @@ sharkd_session_process_tap_rtd_cb(void *arg)
      */
     const value_string *vs = get_rtd_value_string(rtd);
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("tap", "rtd:%s", filter);
     sharkd_json_value_string("type", "rtd");
 
@@ -2785,7 +3953,7 @@ sharkd_session_process_tap_rtd_cb(void *arg)
             if (ms->rtd[j].num == 0)
                 continue;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             if (rtd_data->stat_table.num_rtds == 1)
                 type_str = val_to_str_const(j, vs, "Other"); /* 1 table - description per row */
@@ -2809,12 +3977,12 @@ sharkd_session_process_tap_rtd_cb(void *arg)
                 sharkd_json_value_anyf("rsp_dup", "%u", ms->rsp_dup_num);
             }
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2855,7 +4023,7 @@ sharkd_session_process_tap_srt_cb(void *arg)
 
     unsigned i;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("tap", "srt:%s", filter);
     sharkd_json_value_string("type", "srt");
 
@@ -2867,7 +4035,7 @@ sharkd_session_process_tap_srt_cb(void *arg)
 
         int j;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         if (rst->name)
             sharkd_json_value_string("n", rst->name);
@@ -2891,7 +4059,7 @@ sharkd_session_process_tap_srt_cb(void *arg)
             if (proc->stats.num == 0)
                 continue;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_json_value_string("n", proc->procedure);
 
@@ -2904,15 +4072,15 @@ sharkd_session_process_tap_srt_cb(void *arg)
             sharkd_json_value_anyf("max", "%.9f", nstime_to_sec(&proc->stats.max));
             sharkd_json_value_anyf("tot", "%.9f", nstime_to_sec(&proc->stats.tot));
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
         sharkd_json_array_close();
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -3020,7 +4188,7 @@ sharkd_session_process_tap_eo_cb(void *tapdata)
     char *sha1sum_str;
     uint8_t sha1sum_bytes[HASH_SHA1_LENGTH];
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("tap", object_list->type);
     sharkd_json_value_string("type", "eo");
 
@@ -3031,7 +4199,7 @@ sharkd_session_process_tap_eo_cb(void *tapdata)
     {
         const export_object_entry_t *eo_entry = (export_object_entry_t *) slist->data;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_anyf("pkt", "%u", eo_entry->pkt_num);
 
@@ -3053,13 +4221,13 @@ sharkd_session_process_tap_eo_cb(void *tapdata)
         sharkd_json_value_string("sha1", sha1sum_str);
         g_free(sha1sum_str);
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
         i++;
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -3120,7 +4288,7 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 
     GList *listx;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("tap", "rtp-streams");
     sharkd_json_value_string("type", "rtp-streams");
 
@@ -3132,7 +4300,7 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 
         rtpstream_info_calculate(streaminfo, &calc);
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_stringf("ssrc", "0x%x", calc.ssrc);
         sharkd_json_value_string("payload", calc.all_payload_type_names);
@@ -3166,11 +4334,11 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 
         rtpstream_info_calc_free(&calc);
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 /**
@@ -3207,7 +4375,7 @@ sharkd_session_process_tap_multicast_cb(void *arg)
     GList *list_item;
     char *addr_str;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_value_string("tap", "multicast");
     sharkd_json_value_string("type", "multicast");
@@ -3258,7 +4426,7 @@ sharkd_session_process_tap_multicast_cb(void *arg)
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -3568,6 +4736,33 @@ sharkd_session_eo_register_tap_listener(register_eo_t *eo, const char *tap_type,
     return register_tap_listener(get_eo_tap_listener_name(eo), eo_object, tap_filter, 0, NULL, get_eo_packet_func(eo), tap_draw, NULL);
 }
 
+struct sharkd_tap_progress
+{
+    uint32_t every;
+    bool interruptible;
+};
+
+static bool
+sharkd_session_tap_progress_cb(uint32_t framenum, void *data)
+{
+    struct sharkd_tap_progress *progress = (struct sharkd_tap_progress *) data;
+
+    if (progress->interruptible && sharkd_session_input_pending())
+        return false;
+
+    if (progress->every && framenum % progress->every == 0)
+    {
+        sharkd_json_notification_open("tap_progress");
+        sharkd_json_object_open("params");
+        sharkd_json_value_anyf("frames", "%u", framenum);
+        sharkd_json_value_anyf("total", "%u", cfile.count);
+        sharkd_json_object_close();
+        sharkd_json_response_close();
+    }
+
+    return true;
+}
+
 /**
  * sharkd_session_process_tap()
  *
@@ -3576,8 +4771,16 @@ sharkd_session_eo_register_tap_listener(register_eo_t *eo, const char *tap_type,
  * Input:
  *   (m) tap0         - First tap request
  *   (o) tap1...tap15 - Other tap requests
+ *   (o) progress=N   - send a "tap_progress" notification after every N frames
+ *   (o) interruptible - stop early, if another request comes in meanwhile;
+ *                       "cancel" can be sent just for that
+ *
+ * The "tap_progress" notifications have attributes:
+ *   (m) frames - number of frames tapped so far
+ *   (m) total  - number of frames in the capture
  *
  * Output object with attributes:
+ *   (o) interrupted - true, if stopped early; taps is then empty
  *   (m) taps  - array of object with attributes:
  *                  (m) tap  - tap name
  *                  (m) type - tap output type
@@ -3604,6 +4807,15 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
     int taps_count = 0;
     int i;
     const char *tap_filter = json_find_attr(buf, tokens, count, "filter");
+    const char *tok_progress = json_find_attr(buf, tokens, count, "progress");
+    const char *tok_interruptible = json_find_attr(buf, tokens, count, "interruptible");
+    struct sharkd_tap_progress progress = { 0, false };
+
+    if (tok_progress && !ws_strtou32(tok_progress, NULL, &progress.every))
+        return;
+
+    if (tok_interruptible && !strcmp(tok_interruptible, "true"))
+        progress.interruptible = true;
 
     rtpstream_tapinfo_t rtp_tapinfo =
     { NULL, NULL, NULL, NULL, 0, NULL, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, false, false};
@@ -3743,6 +4955,10 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
             ct_data->resolve_port = true;
 
             tap_error = register_tap_listener(ct_tapname, &ct_data->hash, tap_filter, 0, NULL, tap_func, sharkd_session_process_tap_conv_cb, NULL);
+            if (!strncmp(tok_tap, "conv:", 5))
+                set_tap_mergeable(&ct_data->hash, conversation_table_shard_new, conversation_table_shard_merge, conversation_table_shard_free);
+            else
+                set_tap_mergeable(&ct_data->hash, endpoint_table_shard_new, endpoint_table_shard_merge, endpoint_table_shard_free);
 
             tap_data = &ct_data->hash;
             tap_free = sharkd_session_free_tap_conv_cb;
@@ -3803,6 +5019,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
             rtd_table_dissector_init(rtd, &rtd_data->stat_table, NULL, NULL);
 
             tap_error = register_tap_listener(get_rtd_tap_listener_name(rtd), rtd_data, tap_filter, 0, NULL, get_rtd_packet_func(rtd), sharkd_session_process_tap_rtd_cb, NULL);
+            set_tap_mergeable(rtd_data, rtd_table_shard_new, rtd_table_shard_merge, rtd_table_shard_free);
 
             tap_data = rtd_data;
             tap_free = sharkd_session_free_tap_rtd_cb;
@@ -3839,6 +5056,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
             srt_table_dissector_init(srt, srt_data->srt_array);
 
             tap_error = register_tap_listener(get_srt_tap_listener_name(srt), srt_data, tap_filter, 0, NULL, get_srt_packet_func(srt), sharkd_session_process_tap_srt_cb, NULL);
+            set_tap_mergeable(srt_data, srt_table_shard_new, srt_table_shard_merge, srt_table_shard_free);
 
             tap_data = srt_data;
             tap_free = sharkd_session_free_tap_srt_cb;
@@ -4067,11 +5285,23 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
         return;
     }
 
-    sharkd_json_result_prologue(rpcid);
-    sharkd_json_array_open("taps");
-    sharkd_retap();
-    sharkd_json_array_close();
-    sharkd_json_result_epilogue();
+    /* Tapped first, so that notifications can go out meanwhile. */
+    if (sharkd_retap_frames(sharkd_session_tap_progress_cb, &progress))
+    {
+        sharkd_json_result_prologue(rpcid);
+        sharkd_json_array_open("taps");
+        draw_tap_listeners(true);
+        sharkd_json_array_close();
+        sharkd_json_result_epilogue();
+    }
+    else
+    {
+        sharkd_json_result_prologue(rpcid);
+        sharkd_json_value_anyf("interrupted", "true");
+        sharkd_json_array_open("taps");
+        sharkd_json_array_close();
+        sharkd_json_result_epilogue();
+    }
 
     for (i = 0; i < taps_count; i++)
     {
@@ -4189,7 +5419,7 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
         {
             follow_record = (follow_record_t *) cur->data;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_json_value_anyf("n", "%u", follow_record->packet_num);
             sharkd_json_value_base64("d", follow_record->data->data, follow_record->data->len);
@@ -4197,7 +5427,7 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
             if (follow_record->is_server)
                 sharkd_json_value_anyf("s", "%d", 1);
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
         sharkd_json_array_close();
     }
@@ -4225,7 +5455,7 @@ sharkd_session_process_frame_cb_tree(const char *key, epan_dissect_t *edt, proto
         if (!display_hidden && FI_GET_FLAG(finfo, FI_HIDDEN))
             continue;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         if (!finfo->rep)
         {
@@ -4318,7 +5548,7 @@ sharkd_session_process_frame_cb_tree(const char *key, epan_dissect_t *edt, proto
             sharkd_session_process_frame_cb_tree("n", edt, (proto_tree *) node, tvbs, display_hidden);
         }
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 }
@@ -4342,10 +5572,10 @@ sharkd_follower_visit_layers_cb(const void *key _U_, void *value, void *user_dat
 
         follow_filter = get_follow_conv_func(follower)(edt, pi, &ignore_stream, &ignore_sub_stream);
 
-        json_dumper_begin_array(&dumper);
-        json_dumper_value_string(&dumper, layer_proto);
-        json_dumper_value_string(&dumper, follow_filter);
-        json_dumper_end_array(&dumper);
+        sharkd_json_array_open(NULL);
+        sharkd_json_value_string(NULL, layer_proto);
+        sharkd_json_value_string(NULL, follow_filter);
+        sharkd_json_array_close();
 
         g_free(follow_filter);
     }
@@ -4515,7 +5745,7 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
         {
             src = (struct data_source *) data_src->data;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             {
                 char *src_description = get_data_source_description(src);
@@ -4539,7 +5769,7 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
                 sharkd_json_value_base64("bytes", (const uint8_t*)"", 0);
             }
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
 
             data_src = data_src->next;
         }
@@ -4780,7 +6010,7 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
     {
         struct sharkd_iograph *graph = &graphs[i];
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         if (graph->error)
         {
@@ -4813,7 +6043,7 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
             }
             sharkd_json_array_close();
         }
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
         remove_tap_listener(graph);
         g_free(graph->items);
@@ -4850,7 +6080,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
     const char *tok_interval = json_find_attr(buf, tokens, count, "interval");
     const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
 
-    const uint8_t *filter_data = NULL;
+    const struct sharkd_filter_item *filter_data = NULL;
 
     struct
     {
@@ -4881,7 +6111,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
                     );
             return;
         }
-        filter_data = filter_item->filtered;
+        filter_data = filter_item;
     }
 
     st_total.frames = 0;
@@ -4903,7 +6133,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
         int64_t msec_rel;
         int64_t new_idx;
 
-        if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
+        if (filter_data && !sharkd_filter_item_passed(filter_data, framenum))
             continue;
 
         fdata = sharkd_get_frame(framenum);
@@ -5112,7 +6342,7 @@ sharkd_session_process_check(char *buf, const jsmntok_t *tokens, int count)
         dfilter_t *dfp;
         df_error_t *df_err = NULL;
 
-        if (dfilter_compile(tok_filter, &dfp, &df_err))
+        if (dfilter_compile_cached(tok_filter, &dfp, &df_err))
         {
             if (dfp && dfilter_deprecated_tokens(dfp))
                 sharkd_json_warning(rpcid, "Filter contains deprecated tokens");
@@ -5171,10 +6401,10 @@ sharkd_session_process_complete_pref_cb(module_t *module, void *d)
     if (strncmp(data->pref, module->name, strlen(data->pref)) != 0)
         return 0;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("f", module->name);
     sharkd_json_value_string("d", module->title);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return 0;
 }
@@ -5189,10 +6419,10 @@ sharkd_session_process_complete_pref_option_cb(pref_t *pref, void *d)
     if (strncmp(data->pref, pref_name, strlen(data->pref)) != 0)
         return 0;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("f", "%s.%s", data->module, pref_name);
     sharkd_json_value_string("d", pref_title);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return 0; /* continue */
 }
@@ -5226,63 +6456,37 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
 
     if (tok_field != NULL && tok_field[0])
     {
-        const size_t filter_length = strlen(tok_field);
         const int filter_with_dot = !!strchr(tok_field, '.');
 
-        void *proto_cookie;
-        void *field_cookie;
-        int proto_id;
+        header_field_info *hfinfo;
+        void *cookie;
 
         sharkd_json_array_open("field");
 
-        for (proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie))
+        for (hfinfo = proto_registrar_get_first_byprefix(tok_field, &cookie); hfinfo != NULL; hfinfo = proto_registrar_get_next_byprefix(tok_field, &cookie))
         {
-            protocol_t *protocol = find_protocol_by_id(proto_id);
-            const char *protocol_filter;
-            const char *protocol_name;
-            header_field_info *hfinfo;
+            const bool is_protocol = (hfinfo->parent == -1);
+            protocol_t *protocol = find_protocol_by_id(is_protocol ? hfinfo->id : hfinfo->parent);
 
             if (!proto_is_protocol_enabled(protocol))
                 continue;
 
-            protocol_name   = proto_get_protocol_long_name(protocol);
-            protocol_filter = proto_get_protocol_filter_name(proto_id);
-
-            if (strlen(protocol_filter) >= filter_length && !g_ascii_strncasecmp(tok_field, protocol_filter, filter_length))
-            {
-                json_dumper_begin_object(&dumper);
-                {
-                    sharkd_json_value_string("f", protocol_filter);
-                    sharkd_json_value_anyf("t", "%d", FT_PROTOCOL);
-                    sharkd_json_value_string("n", protocol_name);
-                }
-                json_dumper_end_object(&dumper);
-            }
-
-            if (!filter_with_dot)
+            /* Only complete fields once past the protocol name */
+            if (!is_protocol && !filter_with_dot)
                 continue;
 
-            for (hfinfo = proto_get_first_protocol_field(proto_id, &field_cookie); hfinfo != NULL; hfinfo = proto_get_next_protocol_field(proto_id, &field_cookie))
+            sharkd_json_object_open(NULL);
             {
-                if (hfinfo->same_name_prev_id != -1) /* ignore duplicate names */
-                    continue;
+                sharkd_json_value_string("f", hfinfo->abbrev);
 
-                if (strlen(hfinfo->abbrev) >= filter_length && !g_ascii_strncasecmp(tok_field, hfinfo->abbrev, filter_length))
+                /* XXX, skip displaying name, if there are multiple (to not confuse user) */
+                if (hfinfo->same_name_next == NULL)
                 {
-                    json_dumper_begin_object(&dumper);
-                    {
-                        sharkd_json_value_string("f", hfinfo->abbrev);
-
-                        /* XXX, skip displaying name, if there are multiple (to not confuse user) */
-                        if (hfinfo->same_name_next == NULL)
-                        {
-                            sharkd_json_value_anyf("t", "%d", hfinfo->type);
-                            sharkd_json_value_string("n", hfinfo->name);
-                        }
-                    }
-                    json_dumper_end_object(&dumper);
+                    sharkd_json_value_anyf("t", "%d", is_protocol ? FT_PROTOCOL : hfinfo->type);
+                    sharkd_json_value_string("n", hfinfo->name);
                 }
             }
+            sharkd_json_object_close();
         }
 
         sharkd_json_array_close();
@@ -5513,7 +6717,7 @@ sharkd_session_process_dumpconf_cb(pref_t *pref, void *d)
                     sharkd_json_array_open("e");
                     for (enums = prefs_get_enumvals(pref); enums->name; enums++)
                     {
-                        json_dumper_begin_object(&dumper);
+                        sharkd_json_object_open(NULL);
 
                         sharkd_json_value_anyf("v", "%d", enums->value);
 
@@ -5522,7 +6726,7 @@ sharkd_session_process_dumpconf_cb(pref_t *pref, void *d)
 
                         sharkd_json_value_string("d", enums->description);
 
-                        json_dumper_end_object(&dumper);
+                        sharkd_json_object_close();
                     }
                     sharkd_json_array_close();
                     break;
@@ -5787,7 +6991,7 @@ sharkd_rtp_download_decode(struct sharkd_download_rtp *req)
             memcpy(&wav_hdr[36], "data", 4);
             memcpy(&wav_hdr[40], "\xFF\xFF\xFF\xFF", 4); /* XXX, unknown */
 
-            json_dumper_write_base64(&dumper, wav_hdr, sizeof(wav_hdr));
+            sharkd_json_bytes_write(wav_hdr, sizeof(wav_hdr));
         }
 
         // Write samples to our file.
@@ -5831,7 +7035,7 @@ sharkd_rtp_download_decode(struct sharkd_download_rtp *req)
         }
 
         /* Write the decoded, possibly-resampled audio */
-        json_dumper_write_base64(&dumper, (const uint8_t*)write_buff, write_bytes);
+        sharkd_json_bytes_write((const uint8_t*)write_buff, write_bytes);
 
         g_free(decode_buff);
     }
@@ -6058,10 +7262,9 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
             sharkd_json_value_string("file", filename);
             sharkd_json_value_string("mime", mime);
 
-            json_dumper_set_member_name(&dumper, "data");
-            json_dumper_begin_base64(&dumper);
+            sharkd_json_bytes_begin("data");
             sharkd_rtp_download_decode(&rtp_req);
-            json_dumper_end_base64(&dumper);
+            sharkd_json_bytes_end();
 
             sharkd_json_result_epilogue();
 
@@ -6084,6 +7287,45 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
     }
 }
 
+/**
+ * sharkd_session_process_encoding()
+ *
+ * Process encoding request
+ *
+ * Input:
+ *   (m) format - "json" (the default) or "cbor", for the responses after this one
+ *
+ * Requests are always JSON text, one per line.
+ */
+static void
+sharkd_session_process_encoding(const char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_format = json_find_attr(buf, tokens, count, "format");
+
+    if (!strcmp(tok_format, "json"))
+    {
+        sharkd_json_simple_ok(rpcid);
+        if (cbor_buf)
+        {
+            g_byte_array_free(cbor_buf, true);
+            cbor_buf = NULL;
+        }
+    }
+    else if (!strcmp(tok_format, "cbor"))
+    {
+        sharkd_json_simple_ok(rpcid);
+        if (!cbor_buf)
+            cbor_buf = g_byte_array_new();
+    }
+    else
+    {
+        sharkd_json_error(
+                rpcid, -14001, NULL,
+                "Unsupported encoding: %s", tok_format
+                );
+    }
+}
+
 static void
 sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 {
@@ -6105,6 +7347,8 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
             sharkd_session_process_load(buf, tokens, count);
         else if (!strcmp(tok_method, "status"))
             sharkd_session_process_status();
+        else if (!strcmp(tok_method, "tail"))
+            sharkd_session_process_tail(buf, tokens, count);
         else if (!strcmp(tok_method, "analyse"))
             sharkd_session_process_analyse();
         else if (!strcmp(tok_method, "info"))
@@ -6119,6 +7363,12 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
             sharkd_session_process_complete(buf, tokens, count);
         else if (!strcmp(tok_method, "frames"))
             sharkd_session_process_frames(buf, tokens, count);
+        else if (!strcmp(tok_method, "frames_open"))
+            sharkd_session_process_frames_open(buf, tokens, count);
+        else if (!strcmp(tok_method, "frames_next"))
+            sharkd_session_process_frames_next(buf, tokens, count);
+        else if (!strcmp(tok_method, "frames_close"))
+            sharkd_session_process_frames_close(buf, tokens, count);
         else if (!strcmp(tok_method, "tap"))
             sharkd_session_process_tap(buf, tokens, count);
         else if (!strcmp(tok_method, "follow"))
@@ -6137,6 +7387,13 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
             sharkd_session_process_dumpconf(buf, tokens, count);
         else if (!strcmp(tok_method, "download"))
             sharkd_session_process_download(buf, tokens, count);
+        else if (!strcmp(tok_method, "encoding"))
+            sharkd_session_process_encoding(buf, tokens, count);
+        else if (!strcmp(tok_method, "cancel"))
+        {
+            /* Whatever it was meant to stop has stopped on seeing it. */
+            sharkd_json_simple_ok(rpcid);
+        }
         else if (!strcmp(tok_method, "bye"))
         {
             sharkd_json_simple_ok(rpcid);
@@ -6166,6 +7423,7 @@ sharkd_session_main(int mode_setting)
     dumper.output_file = stdout;
 
     filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+    frames_cursors = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, sharkd_session_frames_cursor_free);
 
 #ifdef HAVE_MAXMINDDB
     /* mmdbresolve was stopped before fork(), force starting it */
@@ -6213,6 +7471,10 @@ sharkd_session_main(int mode_setting)
         sharkd_session_process(buf, tokens, ret);
     }
 
+    g_hash_table_destroy(frames_cursors);
+    if (cbor_buf)
+        g_byte_array_free(cbor_buf, true);
+    g_queue_clear(&filter_lru);
     g_hash_table_destroy(filter_table);
     g_free(tokens);
 
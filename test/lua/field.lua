@@ -9,8 +9,8 @@ local OTHER = "other"
 local n_frames = 1
 testlib.init({
     [FRAME] = n_frames,
-    [PER_FRAME] = n_frames*43,
-    [OTHER] = 16,
+    [PER_FRAME] = n_frames*49,
+    [OTHER] = 22,
 })
 
 ------------- helper funcs ------------
@@ -30,6 +30,11 @@ local function makeFieldInfo(field)
     return true
 end
 
+local function makeFieldSet(names)
+    local foo = FieldSet.new(names)
+    return true
+end
+
 local function setFieldInfo(finfo,name,value)
     finfo[name] = value
     return true
@@ -80,6 +85,19 @@ testlib.test(OTHER,"Field.type-5", f_dhcp_opt.type == ftypes.UINT8)
 -- make sure can't create a FieldInfo outside tap
 testlib.test(OTHER,"Field__call-1",not pcall(makeFieldInfo,f_eth_src))
 
+testlib.testing(OTHER, "FieldSet")
+
+testlib.test(OTHER,"FieldSet.new-0",pcall(makeFieldSet,{"ip.src","udp.srcport"}))
+testlib.test(OTHER,"FieldSet.new-1",not pcall(makeFieldSet,{"ip.src","FooBARhowdy"}))
+testlib.test(OTHER,"FieldSet.new-2",not pcall(makeFieldSet,{}))
+testlib.test(OTHER,"FieldSet.new-3",not pcall(makeFieldSet))
+
+local fs_udp = FieldSet.new({"udp.srcport", "udp.dstport", "ip.src", "tcp.srcport", "eth.addr"})
+
+testlib.test(OTHER,"FieldSet__len-1", #fs_udp == 5)
+-- make sure can't get values outside tap
+testlib.test(OTHER,"FieldSet__call-1",not pcall(fs_udp))
+
 local tap = Listener.new()
 
 --------------------------
@@ -157,6 +175,18 @@ function tap.packet(pinfo,tvb)
     testlib.test(PER_FRAME,"FieldInfo.len-1", fi_eth_src.len == 6)
     testlib.test(PER_FRAME,"FieldInfo.len-2",not pcall(setFieldInfo,fi_eth_src,"len",6))
 
+    testlib.testing(FRAME,"FieldSet")
+
+    local sport, dport, ip_src, tcp_sport, eth_addr = fs_udp()
+    testlib.test(PER_FRAME,"FieldSet__call-2", sport == f_udp_srcport()())
+    testlib.test(PER_FRAME,"FieldSet__call-3", dport == f_udp_dstport()())
+    testlib.test(PER_FRAME,"FieldSet__call-4", ip_src == tostring(f_ip_src()()))
+    testlib.test(PER_FRAME,"FieldSet__call-5", tcp_sport == nil)
+
+    local all_sport, all_dport, all_ip_src, all_tcp_sport, all_eth_addr = fs_udp:all()
+    testlib.test(PER_FRAME,"FieldSet.all-1", #all_eth_addr == #eth_macs and all_eth_addr[1] == eth_addr)
+    testlib.test(PER_FRAME,"FieldSet.all-2", #all_tcp_sport == 0 and all_sport[1] == sport)
+
     testlib.pass(FRAME)
 end
 
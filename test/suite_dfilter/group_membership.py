@@ -133,3 +133,44 @@ class TestDfilterMembership:
     def test_membership_rhs_field(self, checkDFilterCount):
         dfilter = 'eth.src in { eth.addr }'
         checkDFilterCount(dfilter, 1)
+
+    def test_membership_or_chain_1(self, checkDFilterCount):
+        # Compiled as a single membership test
+        dfilter = 'tcp.port == 81 || tcp.port == 3267 || tcp.port == 90'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_or_chain_2(self, checkDFilterCount):
+        dfilter = 'tcp.port == 81 || tcp.port == 82 || tcp.port == 90'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_or_chain_3(self, checkDFilterCount):
+        dfilter = 'tcp.port == 81 || ip.proto == 6 || tcp.port == 90'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_or_chain_all(self, checkDFilterCount):
+        dfilter = 'all tcp.port == 80 || all tcp.port == 3267'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_or_chain_repeated(self, checkDFilterCount):
+        dfilter = 'tcp.port == 80 || tcp.port == 80'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_cidr_1(self, checkDFilterCount):
+        dfilter = 'ip.addr in {192.168.0.0/16, 10.0.0.0/24}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_cidr_2(self, checkDFilterCount):
+        dfilter = 'ip.addr in {192.168.0.0/16, 172.16.0.0/12}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_overlapping_ranges(self, checkDFilterCount):
+        dfilter = 'tcp.port in {70 .. 90, 85 .. 100, 60 .. 75}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_not_in(self, checkDFilterCount):
+        dfilter = 'tcp.port not in {80, 3267}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_all_not_in(self, checkDFilterCount):
+        dfilter = 'all tcp.port not in {80, 81}'
+        checkDFilterCount(dfilter, 1)
@@ -3,6 +3,7 @@
 # SPDX-License-Identifier: GPL-2.0-or-later
 
 # from suite_dfilter.dfiltertest import *
+import subprocesstest
 
 
 class TestDfilterSyntax:
@@ -582,3 +583,17 @@ class TestDfilterValueString:
     def test_value_string_func_layer(self, checkDFilterCount):
         dfilter = 'vals(tls.handshake.type#1) contains "Client"'
         checkDFilterCount(dfilter, 2)
+
+class TestDfilterProfile:
+    trace_file = "dhcp.pcap"
+
+    def test_profile_capture(self, cmd_dftest, capture_file, dfilter_env):
+        '''dftest --capture runs the filter over every packet.'''
+        proc = subprocesstest.check_run((cmd_dftest,
+                                         '--capture', capture_file(self.trace_file),
+                                         '--', 'dhcp.option.dhcp == 1'),
+                                        capture_output=True,
+                                        universal_newlines=True,
+                                        env=dfilter_env)
+        assert 'Packets: 4' in proc.stdout
+        assert 'Profile: 4 runs, 1 matched' in proc.stdout
@@ -242,6 +242,26 @@ class TestDissectGprpc:
         assert grep_output(stdout, 'tutorial.PersonSearchService/Search') # grpc request
         assert grep_output(stdout, 'tutorial.Person') # grpc response
 
+    def test_grpc_with_protobuf_on_demand(self, cmd_tshark, features, dirs, capture_file, test_env):
+        '''gRPC with Protobuf payload, parsing .proto files on demand'''
+        if not features.have_nghttp2:
+            pytest.skip('Requires nghttp2.')
+        well_know_types_dir = os.path.join(dirs.protobuf_lang_files_dir, 'well_know_types').replace('\\', '/')
+        user_defined_types_dir = os.path.join(dirs.protobuf_lang_files_dir, 'user_defined_types').replace('\\', '/')
+        stdout = subprocess.check_output((cmd_tshark,
+                '-r', capture_file('grpc_person_search_protobuf_with_image.pcapng.gz'),
+                '-o', 'uat:protobuf_search_paths: "{}","{}"'.format(well_know_types_dir, 'FALSE'),
+                '-o', 'uat:protobuf_search_paths: "{}","{}"'.format(user_defined_types_dir, 'TRUE'),
+                '-o', 'protobuf.load_on_demand: TRUE',
+                '-d', 'tcp.port==50051,http2',
+                '-2',
+                '-Y', 'protobuf.message.name == "tutorial.PersonSearchRequest"'
+                      ' || (grpc.message_length == 66 && protobuf.field.value.string == "Jason"'
+                      '     && protobuf.field.value.int64 == 1602601886)',
+            ), encoding='utf-8', env=test_env)
+        assert grep_output(stdout, 'tutorial.PersonSearchService/Search') # grpc request
+        assert grep_output(stdout, 'tutorial.Person') # grpc response
+
     def test_grpc_streaming_mode_reassembly(self, cmd_tshark, features, dirs, capture_file, test_env):
         '''gRPC/HTTP2 streaming mode reassembly'''
         if not features.have_nghttp2:
@@ -106,6 +106,32 @@ class TestFileFormatsPcapng:
             encoding='utf-8', env=test_env)
         assert capture_stdout == fileformats_baseline_str
 
+    def test_pcapng_split_packet_count(self, cmd_editcap, cmd_tshark, capture_file, result_file, test_env):
+        '''Splitting a pcapng file by packet count keeps every packet and time stamp'''
+        outfile = result_file('dhcp-split.pcapng')
+        subprocess.run((cmd_editcap,
+            '-c', '2',
+            capture_file('dhcp-nanosecond.pcapng'), outfile
+        ), check=True, env=test_env)
+        p = PurePath(outfile)
+        split_files = sorted(f for f in os.listdir(p.parent) if f.startswith(p.stem + '_'))
+        assert len(split_files) == 2
+        time_epochs = ''
+        for split_file in split_files:
+            time_epochs += subprocess.check_output((cmd_tshark,
+                    '-r', os.path.join(p.parent, split_file),
+                    '-Tfields',
+                    '-e', 'frame.time_epoch',
+                    ),
+                encoding='utf-8', env=test_env)
+        orig_time_epochs = subprocess.check_output((cmd_tshark,
+                '-r', capture_file('dhcp-nanosecond.pcapng'),
+                '-Tfields',
+                '-e', 'frame.time_epoch',
+                ),
+            encoding='utf-8', env=test_env)
+        assert time_epochs == orig_time_epochs
+
 @pytest.fixture
 def check_pcapng_dsb_fields(request, cmd_tshark):
     '''Factory that checks whether the DSB within the capture file matches.'''
@@ -66,6 +66,22 @@ class TestTsharkIO:
         '''Read direct and write direct using TShark'''
         check_io_4_packets(capture_file, result_file, cmd_tshark, cmd_capinfos, env=test_env)
 
+    def test_tshark_io_read_ahead(self, cmd_tshark, capture_file, test_env):
+        '''Read using a separate reader thread using TShark'''
+        # Decryption secrets blocks are handed over from the reader thread,
+        # so use a file that has them.
+        tshark_args = ('-r', capture_file('tls12-dsb.pcapng'), '-V')
+        expected = subprocess.check_output((cmd_tshark,) + tshark_args, encoding='utf-8', env=test_env)
+        actual = subprocess.check_output((cmd_tshark, '--read-ahead') + tshark_args, encoding='utf-8', env=test_env)
+        assert actual == expected
+
+    def test_tshark_io_read_ahead_two_pass(self, cmd_tshark, capture_file, test_env):
+        '''Read the first pass using a separate reader thread using TShark'''
+        tshark_args = ('-r', capture_file('tls12-dsb.pcapng'), '-2', '-Y', 'tls', '-V')
+        expected = subprocess.check_output((cmd_tshark,) + tshark_args, encoding='utf-8', env=test_env)
+        actual = subprocess.check_output((cmd_tshark, '--read-ahead') + tshark_args, encoding='utf-8', env=test_env)
+        assert actual == expected
+
 
 @pytest.mark.skipif(sys.byteorder != 'little', reason='Requires a little endian system')
 class TestRawsharkIO:
@@ -0,0 +1,143 @@
+#
+# Wireshark tests
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''perfshark tests
+
+These check that perfshark runs and that its results make sense; they
+don't check how fast anything is. To track dissection speed, point
+WS_PERFSHARK_BASELINE at a JSON file mapping capture file names to the
+packets per second measured for them earlier, for instance
+
+    {"dhcp.pcap": 40000, "http.pcap": 25000}
+
+and the captures in it are also checked against WS_PERFSHARK_TOLERANCE
+(default 0.25), the fraction by which they may be slower. Setting
+WS_PERFSHARK_RESULTS to a path writes the rates measured by this run to
+it in the same format, to be used as the next baseline.
+'''
+
+import json
+import os
+import subprocess
+import pytest
+
+
+# Captures with a bit of everything that take a moment to dissect.
+benchmark_captures = (
+    'dhcp.pcap',
+    'dns-mdns.pcap',
+    'http.pcap',
+    'http2-data-reassembly.pcap',
+    'sample_control4_2012-03-24.pcap',
+    'snakeoil-dtls.pcap',
+)
+
+measured_rates = {}
+
+
+@pytest.fixture(scope='session')
+def cmd_perfshark(program):
+    return program('perfshark')
+
+
+@pytest.fixture
+def run_perfshark(cmd_perfshark, capture_file, test_env):
+    def run_perfshark_real(filename, *args):
+        proc = subprocess.run(
+            (cmd_perfshark, '-r', capture_file(filename)) + args,
+            capture_output=True, encoding='utf-8', env=test_env)
+        assert proc.returncode == 0, proc.stderr
+        try:
+            return json.loads(proc.stdout)
+        except json.JSONDecodeError:
+            pytest.fail('Invalid JSON: %r' % proc.stdout)
+    return run_perfshark_real
+
+
+@pytest.fixture(scope='session')
+def perfshark_baseline():
+    path = os.environ.get('WS_PERFSHARK_BASELINE')
+    if not path:
+        return {}
+    with open(path, 'r', encoding='utf-8') as f:
+        return json.load(f)
+
+
+@pytest.fixture(scope='session', autouse=True)
+def perfshark_results():
+    yield
+    path = os.environ.get('WS_PERFSHARK_RESULTS')
+    if path and measured_rates:
+        with open(path, 'w', encoding='utf-8') as f:
+            json.dump(measured_rates, f, indent=2, sort_keys=True)
+
+
+class TestPerfshark:
+    def test_perfshark_passes(self, run_perfshark):
+        '''Every pass dissects every packet.'''
+        result = run_perfshark('dhcp.pcap', '-n', '3')
+        assert result['packets'] == 4
+        assert result['bytes'] > 0
+        assert len(result['passes']) == 3
+        for p in result['passes']:
+            assert p['passed'] == 4
+            assert p['elapsed'] >= 0
+        assert result['best'] == min(p['elapsed'] for p in result['passes'])
+        assert 'protocols' not in result
+
+    def test_perfshark_filter(self, run_perfshark):
+        '''The display filter is counted in each pass.'''
+        result = run_perfshark('dhcp.pcap', '-n', '2', '-Y', 'dhcp.option.dhcp == 1')
+        assert result['filter'] == 'dhcp.option.dhcp == 1'
+        assert [p['passed'] for p in result['passes']] == [1, 1]
+
+    def test_perfshark_bad_filter(self, cmd_perfshark, capture_file, test_env):
+        proc = subprocess.run(
+            (cmd_perfshark, '-r', capture_file('dhcp.pcap'), '-Y', 'dhcp.option.dhcp =='),
+            capture_output=True, encoding='utf-8', env=test_env)
+        assert proc.returncode != 0
+        assert proc.stdout == ''
+
+    def test_perfshark_missing_file(self, cmd_perfshark, capture_file, test_env):
+        proc = subprocess.run(
+            (cmd_perfshark, '-r', capture_file('non-existant.pcap')),
+            capture_output=True, encoding='utf-8', env=test_env)
+        assert proc.returncode != 0
+        assert proc.stdout == ''
+
+    def test_perfshark_per_protocol(self, run_perfshark):
+        '''Per-protocol counters add up over the passes.'''
+        result = run_perfshark('dhcp.pcap', '-n', '2', '-p', '-V', '-c')
+        assert result['visible'] and result['tree'] and result['columns']
+        protocols = {p['name']: p for p in result['protocols']}
+        assert 'dhcp' in protocols
+        assert protocols['dhcp']['accepted'] == 2 * 4
+        for p in protocols.values():
+            assert p['self'] <= p['total']
+            assert p['self_bytes'] <= p['total_bytes']
+
+    def test_perfshark_revisit(self, run_perfshark):
+        result = run_perfshark('dhcp.pcap', '-n', '2', '--revisit', '-t')
+        assert result['revisit']
+        assert len(result['passes']) == 2
+
+    def test_perfshark_tap(self, run_perfshark):
+        '''A tap doesn't print anything into the results.'''
+        result = run_perfshark('dhcp.pcap', '-n', '1', '-z', 'io,phs')
+        assert result['taps'] == ['io,phs']
+
+    @pytest.mark.parametrize('filename', benchmark_captures)
+    def test_perfshark_baseline(self, filename, run_perfshark, perfshark_baseline):
+        '''Dissection is no slower than the baseline, if there is one.'''
+        result = run_perfshark(filename, '-n', '5', '-t')
+        assert result['packets'] > 0
+        rate = result['packets_per_sec']
+        measured_rates[filename] = rate
+        if filename not in perfshark_baseline:
+            return
+        tolerance = float(os.environ.get('WS_PERFSHARK_TOLERANCE', '0.25'))
+        baseline = perfshark_baseline[filename]
+        assert rate >= baseline * (1 - tolerance), \
+            '%s: %.0f packets/s, baseline %.0f packets/s' % (filename, rate, baseline)
@@ -195,7 +195,8 @@ class TestSharkd:
                     "title": "Length", "format": "%L", "visible":True, "display": "R"
                 },{
                     "title": "Info", "format": "%i", "visible":True, "display": "R"
-                }]
+                }],
+                "memory": MatchList({"name": MatchAny(str), "bytes": MatchAny(int)}),
             }},
         ))
 
@@ -224,10 +225,30 @@ class TestSharkd:
                     "title": "Length", "format": "%L", "visible":True, "display": "R"
                 },{
                     "title": "Info", "format": "%i", "visible":True, "display": "R"
-                }]
+                }],
+                "memory": MatchList({"name": MatchAny(str), "bytes": MatchAny(int)}),
             }},
         ))
 
+    def test_sharkd_req_status_memory(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap'), "memory": True}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"status"},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":MatchObject({
+                "frames": 4,
+                "memory": MatchList({"name": MatchAny(str), "bytes": MatchAny(int)}),
+                "protocol_memory": MatchList({
+                    "protocol": MatchAny(str),
+                    "file_bytes": MatchAny(int),
+                    "packet_bytes": MatchAny(int),
+                }),
+            })},
+        ))
+
     def test_sharkd_req_analyse(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -288,12 +309,20 @@ class TestSharkd:
             {"jsonrpc":"2.0", "id":1, "method":"complete"},
             {"jsonrpc":"2.0", "id":2, "method":"complete", "params":{"field": "frame.le"}},
             {"jsonrpc":"2.0", "id":3, "method":"complete", "params":{"field": "garbage.nothing.matches"}},
+            {"jsonrpc":"2.0", "id":4, "method":"complete", "params":{"field": "FRAME.LE"}},
+            {"jsonrpc":"2.0", "id":5, "method":"complete", "params":{"field": "fram"}},
         ), (
             {"jsonrpc":"2.0","id":1,"result":{}},
             {"jsonrpc":"2.0","id":2,"result":{"field": MatchList(
                 {"f": "frame.len", "t": 7, "n": "Frame Length"}, match_element=any)}
             },
             {"jsonrpc":"2.0","id":3,"result":{"field": []}},
+            {"jsonrpc":"2.0","id":4,"result":{"field": MatchList(
+                {"f": "frame.len", "t": 7, "n": "Frame Length"}, match_element=any)}
+            },
+            {"jsonrpc":"2.0","id":5,"result":{"field": MatchList(
+                {"f": "frame", "t": 1, "n": "Frame"}, match_element=any)}
+            },
         ))
 
     def test_sharkd_req_complete_pref(self, check_sharkd_session):
@@ -359,6 +388,66 @@ class TestSharkd:
              },
         ))
 
+    def test_sharkd_req_frames_cursor(self, check_sharkd_session, capture_file):
+        row = {
+            "c": MatchList(MatchAny(str)),
+            "num": MatchAny(int),
+            "bg": MatchAny(str),
+            "fg": MatchAny(str),
+        }
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"frames_open", "params":{"filter":"frame.number!=2"}},
+            {"jsonrpc":"2.0", "id":3, "method":"frames_next", "params":{"cursor":1, "limit":2, "batch":1}},
+            {"jsonrpc":"2.0", "id":4, "method":"frames_next", "params":{"cursor":1}},
+            {"jsonrpc":"2.0", "id":5, "method":"frames_close", "params":{"cursor":1}},
+            {"jsonrpc":"2.0", "id":6, "method":"frames_next", "params":{"cursor":1}},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"cursor":1}},
+            {"jsonrpc":"2.0","method":"frames_rows","params":{"cursor":1,"rows":[dict(row, num=1)]}},
+            {"jsonrpc":"2.0","method":"frames_rows","params":{"cursor":1,"rows":[dict(row, num=3)]}},
+            {"jsonrpc":"2.0","id":3,"result":{"rows":2,"done":False}},
+            {"jsonrpc":"2.0","method":"frames_rows","params":{"cursor":1,"rows":[dict(row, num=4)]}},
+            {"jsonrpc":"2.0","id":4,"result":{"rows":1,"done":True}},
+            {"jsonrpc":"2.0","id":5,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":6,"error":{"code":-13003,"message":"No such cursor"}},
+        ))
+
+    def test_sharkd_req_tail(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"tail"},
+            {"jsonrpc":"2.0", "id":2, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap'), "tail": True, "max_packets": 2}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap'), "tail": True}
+            },
+            {"jsonrpc":"2.0", "id":4, "method":"frames_open", "params":{"filter":"frame.number!=2"}},
+            {"jsonrpc":"2.0", "id":5, "method":"tail"},
+            {"jsonrpc":"2.0", "id":6, "method":"tail", "params":{"stop": True}},
+            {"jsonrpc":"2.0", "id":7, "method":"tail"},
+        ), (
+            {"jsonrpc":"2.0","id":1,"error":{"code":-2002,"message":"No file is being followed"}},
+            {"jsonrpc":"2.0","id":2,"error":{"code":-32602,"message":"tail can't be used with max_packets or max_bytes"}},
+            {"jsonrpc":"2.0","id":3,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":4,"result":{"cursor":1}},
+            {"jsonrpc":"2.0","id":5,"result":{"frames":4,"added":0,"tailing":True}},
+            {"jsonrpc":"2.0","id":6,"result":{"frames":4,"added":0,"tailing":False}},
+            {"jsonrpc":"2.0","id":7,"error":{"code":-2002,"message":"No file is being followed"}},
+        ))
+
+    def test_sharkd_req_encoding(self, check_sharkd_session):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"encoding", "params":{"format":"json"}},
+            {"jsonrpc":"2.0", "id":2, "method":"encoding", "params":{"format":"xml"}},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"error":{"code":-14001,"message":"Unsupported encoding: xml"}},
+        ))
+
     def test_sharkd_req_tap_invalid(self, check_sharkd_session, capture_file):
         # XXX Unrecognized taps result in an empty line, modify
         #     run_sharkd_session such that checking for it is possible.
@@ -429,6 +518,31 @@ class TestSharkd:
             }},
         ))
 
+    def test_sharkd_req_tap_progress(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"tap", "params":{"tap0": "endpt:TCP", "progress": 2}},
+            {"jsonrpc":"2.0", "id":3, "method":"cancel"},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","method":"tap_progress","params":{"frames":2,"total":4}},
+            {"jsonrpc":"2.0","method":"tap_progress","params":{"frames":4,"total":4}},
+            {"jsonrpc":"2.0","id":2,"result":{
+                "taps": [
+                    {
+                        "tap": "endpt:TCP",
+                        "type": "host",
+                        "proto": "TCP",
+                        "geoip": MatchAny(bool),
+                        "hosts": [],
+                    },
+                ]
+            }},
+            {"jsonrpc":"2.0","id":3,"result":{"status":"OK"}},
+        ))
+
     def test_sharkd_req_tap_rtp_streams(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
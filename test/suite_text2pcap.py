@@ -334,6 +334,14 @@ class TestText2pcapParsing:
                 "7f 00 00 01 ff 98 00 13 00 0d b5 48 66 69 72 73\n"
         check_rawip(pdata, 0, 0)
 
+    def test_text2pcap_large_input(self, check_rawip):
+        '''Verify that packets come out whole from inputs read in many parts.'''
+        pdata = ("Packet\r\n"
+                 "0000  45 00 00 21 00 01 00 00  40 11 7c c9 7f 00 00 01  E..!....@.|.....\r\n"
+                 "0010  7f 00 00 01 ff 98 00 13  00 0d b5 48 66 69 72 73  ...........Hfirs\r\n"
+                 "0020  74                                                t\r\n") * 40000
+        check_rawip(pdata, 40000, 1320000)
+
     def test_text2pcap_eol_missing(self, check_rawip):
         '''Verify that the last LF can be missing.'''
         pdata = "0000  45 00 00 21 00 01 00 00 40 11 7c c9 7f 00 00 01\n" \
@@ -36,6 +36,12 @@ class TestUnitTests:
             '--verbose'
         ), env=base_env)
 
+    def test_unit_wmem_bench(self, program, base_env):
+        '''wmem_bench, briefly, to check that every benchmark runs'''
+        subprocess.check_call((program('wmem_bench'),
+            '-n', '1000'
+        ), env=base_env)
+
     def test_unit_wscbor_test(self, program, base_env):
         '''wscbor_test'''
         subprocess.check_call(program('wscbor_test'), env=base_env)
@@ -234,6 +234,77 @@ def prefix_to_oui(prefix, prefix_map):
 
     return '{}/{:d}'.format(oui, int(pfx_len)), kind
 
+# Each string pool is kept below the 64 KiB limit some compilers (MSVC)
+# place on string literals, and a string is referenced by its pool number
+# and offset so that the tables hold no pointers. Tables without pointers
+# need no relocations and can be shared read-only between processes.
+MANUF_POOL_SIZE = 65000
+
+class StringPools:
+    def __init__(self):
+        self.pools = [[]]
+        self.pool_len = 0
+        self.refs = {}
+
+    def ref(self, name):
+        if name in self.refs:
+            return self.refs[name]
+        size = len(name.encode('UTF-8')) + 1
+        if self.pool_len + size > MANUF_POOL_SIZE:
+            self.pools.append([])
+            self.pool_len = 0
+        ref = 'MANUF_STR({}, {})'.format(len(self.pools) - 1, self.pool_len)
+        self.pools[-1].append(name)
+        self.pool_len += size
+        self.refs[name] = ref
+        return ref
+
+    def write(self, manuf_fd):
+        for idx, pool in enumerate(self.pools):
+            manuf_fd.write("static const char manuf_strings_{}[] =\n".format(idx))
+            for name in pool:
+                manuf_fd.write("    \"{}\\0\"\n".format(name.replace('"', '\\"')))
+            manuf_fd.write("    ;\n\n")
+        manuf_fd.write("static const char * const manuf_string_pools[] = {\n")
+        for idx in range(len(self.pools)):
+            manuf_fd.write("    manuf_strings_{},\n".format(idx))
+        manuf_fd.write("};\n\n")
+
+def write_manuf_tables(manuf_fd, prefix_map, oui_d):
+    # Write the prefix map
+    manuf_fd.write("static const manuf_registry_t ieee_registry_table[] = {\n")
+    keys = list(prefix_map.keys())
+    keys.sort()
+    for oui in keys:
+        manuf_fd.write("    {{ {{ 0x{}, 0x{}, 0x{} }}, {} }},\n".format(oui[0:2], oui[3:5], oui[6:8], prefix_map[oui]))
+    manuf_fd.write("};\n\n")
+
+    pools = StringPools()
+    tables = []
+    for kind, name, octets in ((MA_L, 'oui24', 3), (MA_M, 'oui28', 4), (MA_S, 'oui36', 5)):
+        lines = []
+        keys = list(oui_d[kind].keys())
+        keys.sort()
+        for oui in keys:
+            short = oui_d[kind][oui][0]
+            if oui_d[kind][oui][1]:
+                long = oui_d[kind][oui][1]
+            else:
+                long = short
+            block = ', '.join('0x' + oui[i * 3:i * 3 + 2] for i in range(octets))
+            lines.append("    {{ {{ {} }}, {}, {} }}, /* {} */\n".format(block, pools.ref(short), pools.ref(long), short))
+        tables.append((name, lines))
+
+    pools.write(manuf_fd)
+
+    for name, lines in tables:
+        manuf_fd.write("static const manuf_{0}_t global_manuf_{0}_table[] = {{\n".format(name))
+        for line in lines:
+            manuf_fd.write(line)
+        manuf_fd.write("};\n")
+        if name != 'oui36':
+            manuf_fd.write("\n")
+
 def main():
     manuf_path = os.path.join(os.path.dirname(__file__), '..', 'epan', 'manuf-data.c')
 
@@ -323,70 +394,7 @@ def main():
 
 ''')
 
-    # Write the prefix map
-    manuf_fd.write("static const manuf_registry_t ieee_registry_table[] = {\n")
-    keys = list(prefix_map.keys())
-    keys.sort()
-    for oui in keys:
-        manuf_fd.write("    {{ {{ 0x{}, 0x{}, 0x{} }}, {} }},\n".format(oui[0:2], oui[3:5], oui[6:8], prefix_map[oui]))
-    manuf_fd.write("};\n\n")
-
-    # write the MA-L table
-    manuf_fd.write("static const manuf_oui24_t global_manuf_oui24_table[] = {\n")
-    keys = list(oui_d[MA_L].keys())
-    keys.sort()
-    for oui in keys:
-        short = oui_d[MA_L][oui][0]
-        if oui_d[MA_L][oui][1]:
-            long = oui_d[MA_L][oui][1]
-        else:
-            long = short
-        line = "    {{ {{ 0x{}, 0x{}, 0x{} }}, \"{}\", ".format(oui[0:2], oui[3:5], oui[6:8], short)
-        sep = 44 - len(line)
-        if sep <= 0:
-            sep = 0
-        line += sep * ' '
-        line += "\"{}\" }},\n".format(long.replace('"', '\\"'))
-        manuf_fd.write(line)
-    manuf_fd.write("};\n\n")
-
-    # write the MA-M table
-    manuf_fd.write("static const manuf_oui28_t global_manuf_oui28_table[] = {\n")
-    keys = list(oui_d[MA_M].keys())
-    keys.sort()
-    for oui in keys:
-        short = oui_d[MA_M][oui][0]
-        if oui_d[MA_M][oui][1]:
-            long = oui_d[MA_M][oui][1]
-        else:
-            long = short
-        line = "    {{ {{ 0x{}, 0x{}, 0x{}, 0x{} }}, \"{}\", ".format(oui[0:2], oui[3:5], oui[6:8], oui[9:11], short)
-        sep = 50 - len(line)
-        if sep <= 0:
-            sep = 0
-        line += sep * ' '
-        line += "\"{}\" }},\n".format(long.replace('"', '\\"'))
-        manuf_fd.write(line)
-    manuf_fd.write("};\n\n")
-
-    #write the MA-S table
-    manuf_fd.write("static const manuf_oui36_t global_manuf_oui36_table[] = {\n")
-    keys = list(oui_d[MA_S].keys())
-    keys.sort()
-    for oui in keys:
-        short = oui_d[MA_S][oui][0]
-        if oui_d[MA_S][oui][1]:
-            long = oui_d[MA_S][oui][1]
-        else:
-            long = short
-        line = "    {{ {{ 0x{}, 0x{}, 0x{}, 0x{}, 0x{} }}, \"{}\", ".format(oui[0:2], oui[3:5], oui[6:8], oui[9:11], oui[12:14], short)
-        sep = 56 - len(line)
-        if sep <= 0:
-            sep = 0
-        line += sep * ' '
-        line += "\"{}\" }},\n".format(long.replace('"', '\\"'))
-        manuf_fd.write(line)
-    manuf_fd.write("};\n")
+    write_manuf_tables(manuf_fd, prefix_map, oui_d)
 
     manuf_fd.close()
 
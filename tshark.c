@@ -48,6 +48,7 @@
 #include <wsutil/please_report_bug.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/ws_trace.h>
 #include <wsutil/strtoi.h>
 #include <wsutil/report_message.h>
 #include <app/application_flavor.h>
@@ -143,6 +144,9 @@
 #define LONGOPT_PRINT_TIMERS            LONGOPT_BASE_APPLICATION+9
 #define LONGOPT_GLOBAL_PROFILE          LONGOPT_BASE_APPLICATION+10
 #define LONGOPT_COMPRESS                LONGOPT_BASE_APPLICATION+11
+#define LONGOPT_READ_AHEAD              LONGOPT_BASE_APPLICATION+12
+#define LONGOPT_ROLLING                 LONGOPT_BASE_APPLICATION+13
+#define LONGOPT_WRITE_BEHIND            LONGOPT_BASE_APPLICATION+14
 
 capture_file cfile;
 
@@ -246,6 +250,7 @@ static void report_counts_siginfo(int);
 #endif /* HAVE_LIBPCAP */
 
 static void reset_epan_mem(capture_file *cf, epan_dissect_t *edt, bool tree, bool visual);
+static void rolling_retire(capture_file *cf, const wtap_rec *rec);
 
 typedef enum {
     PROCESS_FILE_SUCCEEDED,
@@ -273,6 +278,21 @@ static bool write_finale(void);
 static GHashTable *output_only_tables;
 
 static bool opt_print_timers;
+static bool opt_read_ahead;
+static bool opt_write_behind;
+
+/*
+ * With --rolling, state that only concerns frames older than this many
+ * seconds is dropped as we go, so that we can run indefinitely.
+ */
+static uint32_t rolling_secs;
+
+typedef struct {
+    time_t   secs;          /* capture time, in whole seconds */
+    uint32_t framenum;      /* first frame with that time */
+} rolling_mark_t;
+
+static GQueue rolling_marks = G_QUEUE_INIT;
 struct elapsed_pass_s {
     int64_t dissect;
     int64_t dfilter_read;
@@ -492,6 +512,8 @@ print_usage(FILE *output)
     fprintf(output, "Processing:\n");
     fprintf(output, "  -2                       perform a two-pass analysis\n");
     fprintf(output, "  -M <packet count>        perform session auto reset\n");
+    fprintf(output, "  --rolling <seconds>      retire conversations and other state idle for longer\n");
+    fprintf(output, "                           than this, to run indefinitely on a live capture\n");
     fprintf(output, "  -R <read filter>, --read-filter <read filter>\n");
     fprintf(output, "                           packet Read filter in Wireshark display filter syntax\n");
     fprintf(output, "                           (requires -2)\n");
@@ -595,6 +617,8 @@ print_usage(FILE *output)
     fprintf(output, "  --temp-dir <directory>   write temporary files to this directory\n");
     fprintf(output, "                           (default: %s)\n", g_get_tmp_dir());
     fprintf(output, "  --compress <type>        compress the output file using the type compression format\n");
+    fprintf(output, "  --read-ahead             read the capture file in a separate thread while dissecting\n");
+    fprintf(output, "  --write-behind           write the output file in a separate thread while dissecting\n");
     fprintf(output, "\n");
 
     ws_log_print_usage(output);
@@ -1072,6 +1096,9 @@ main(int argc, char *argv[])
         {"print-timers", ws_no_argument, NULL, LONGOPT_PRINT_TIMERS},
         {"global-profile", ws_no_argument, NULL, LONGOPT_GLOBAL_PROFILE},
         {"compress", ws_required_argument, NULL, LONGOPT_COMPRESS},
+        {"read-ahead", ws_no_argument, NULL, LONGOPT_READ_AHEAD},
+        {"rolling", ws_required_argument, NULL, LONGOPT_ROLLING},
+        {"write-behind", ws_no_argument, NULL, LONGOPT_WRITE_BEHIND},
         {0, 0, 0, 0}
     };
     bool                 arg_error = false;
@@ -1158,6 +1185,7 @@ main(int argc, char *argv[])
 
     /* Initialize log handler early so we can have proper logging during startup. */
     ws_log_init(vcmdarg_err, "TShark Debug Console");
+    ws_trace_register();
 
     /* Early logging command-line initialization. */
     ws_log_parse_args(&argc, argv, optstring, long_options, vcmdarg_err, WS_EXIT_INVALID_OPTION);
@@ -1960,6 +1988,18 @@ main(int argc, char *argv[])
                     goto clean_exit;
                 }
                 break;
+            case LONGOPT_READ_AHEAD:
+                opt_read_ahead = true;
+                break;
+            case LONGOPT_WRITE_BEHIND:
+                opt_write_behind = true;
+                break;
+            case LONGOPT_ROLLING:
+                if (!get_nonzero_uint32(ws_optarg, "rolling window", &rolling_secs)) {
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
             case '?':        /* Bad flag - print usage message */
             default:
                 /* wslog arguments are okay */
@@ -2185,6 +2225,12 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (rolling_secs != 0 && perform_two_pass_analysis) {
+        cmdarg_err("--rolling does not support two-pass analysis.");
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+
 #ifdef HAVE_LIBPCAP
     if (caps_queries) {
         /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -2978,6 +3024,605 @@ clean_exit:
     return exit_status;
 }
 
+/*
+ * Read-ahead pipeline for single-pass processing of a capture file.
+ *
+ * With --read-ahead, a separate thread reads records from libwiretap
+ * (including any decompression and record parsing) into a bounded queue,
+ * while the main thread dissects and prints them in order.
+ *
+ * Dissection itself stays on the main thread: the dissection engine has
+ * global state (conversations, reassembly tables, name resolution, ...)
+ * and isn't safe to run with more than one thread.  Anything libwiretap
+ * hands to libwireshark while reading (name resolution and decryption
+ * secrets blocks) is therefore queued along with the records and handed
+ * over when the main thread reaches it, and the main thread's accesses
+ * to the wtap (IDBs and other blocks, via the packet provider) are
+ * serialized with the reader by read_ahead_lock()/read_ahead_unlock().
+ */
+#define READ_AHEAD_QUEUE_DEPTH 256
+
+typedef enum {
+    READ_AHEAD_RECORD,
+    READ_AHEAD_IPV4_NAME,
+    READ_AHEAD_IPV6_NAME,
+    READ_AHEAD_SECRETS,
+    READ_AHEAD_EOF
+} read_ahead_item_type_t;
+
+typedef struct {
+    read_ahead_item_type_t type;
+    /* READ_AHEAD_RECORD */
+    wtap_rec     rec;
+    int64_t      data_offset;
+    /* READ_AHEAD_IPV4_NAME, READ_AHEAD_IPV6_NAME */
+    unsigned     ipv4_addr;
+    ws_in6_addr  ipv6_addr;
+    char        *name;
+    bool         static_entry;
+    /* READ_AHEAD_SECRETS */
+    uint32_t     secrets_type;
+    void        *secrets;
+    unsigned     secrets_size;
+    /* READ_AHEAD_EOF */
+    int          err;
+    char        *err_info;
+} read_ahead_item_t;
+
+typedef struct {
+    wtap         *wth;
+    GThread      *thread;
+    GAsyncQueue  *filled_q;    /* read_ahead_item_t *, in file order */
+    GAsyncQueue  *free_q;      /* READ_AHEAD_RECORD items to read into */
+    GMutex        wth_mutex;   /* held while accessing the wtap */
+    int           stop;        /* accessed with g_atomic_int_* */
+    bool          at_eof;
+    read_ahead_item_t *items;  /* READ_AHEAD_QUEUE_DEPTH record items */
+} read_ahead_t;
+
+/* Non-NULL while the reader thread is running. */
+static read_ahead_t *read_ahead;
+
+static void
+read_ahead_lock(void)
+{
+    if (read_ahead)
+        g_mutex_lock(&read_ahead->wth_mutex);
+}
+
+static void
+read_ahead_unlock(void)
+{
+    if (read_ahead)
+        g_mutex_unlock(&read_ahead->wth_mutex);
+}
+
+/*
+ * Callbacks from libwiretap.  While the reader thread is running, these
+ * are only called from it, so queue the information for the main thread.
+ */
+static void
+tshark_add_ipv4_name(const unsigned addr, const char *name, const bool static_entry)
+{
+    read_ahead_item_t *item;
+
+    if (!read_ahead) {
+        add_ipv4_name(addr, name, static_entry);
+        return;
+    }
+    item = g_new0(read_ahead_item_t, 1);
+    item->type = READ_AHEAD_IPV4_NAME;
+    item->ipv4_addr = addr;
+    item->name = g_strdup(name);
+    item->static_entry = static_entry;
+    g_async_queue_push(read_ahead->filled_q, item);
+}
+
+static void
+tshark_add_ipv6_name(const ws_in6_addr *addrp, const char *name, const bool static_entry)
+{
+    read_ahead_item_t *item;
+
+    if (!read_ahead) {
+        add_ipv6_name(addrp, name, static_entry);
+        return;
+    }
+    item = g_new0(read_ahead_item_t, 1);
+    item->type = READ_AHEAD_IPV6_NAME;
+    item->ipv6_addr = *addrp;
+    item->name = g_strdup(name);
+    item->static_entry = static_entry;
+    g_async_queue_push(read_ahead->filled_q, item);
+}
+
+static void
+tshark_add_secrets(uint32_t secrets_type, const void *secrets, unsigned size)
+{
+    read_ahead_item_t *item;
+
+    if (!read_ahead) {
+        secrets_wtap_callback(secrets_type, secrets, size);
+        return;
+    }
+    item = g_new0(read_ahead_item_t, 1);
+    item->type = READ_AHEAD_SECRETS;
+    item->secrets_type = secrets_type;
+    item->secrets = g_memdup2(secrets, size);
+    item->secrets_size = size;
+    g_async_queue_push(read_ahead->filled_q, item);
+}
+
+static void *
+read_ahead_worker(void *data)
+{
+    read_ahead_t *ra = (read_ahead_t *)data;
+    read_ahead_item_t *item;
+    bool ok;
+
+    for (;;) {
+        item = (read_ahead_item_t *)g_async_queue_pop(ra->free_q);
+        item->err = 0;
+        item->err_info = NULL;
+        if (g_atomic_int_get(&ra->stop)) {
+            item->type = READ_AHEAD_EOF;
+            g_async_queue_push(ra->filled_q, item);
+            break;
+        }
+
+        wtap_rec_reset(&item->rec);
+        g_mutex_lock(&ra->wth_mutex);
+        ok = wtap_read(ra->wth, &item->rec, &item->err, &item->err_info,
+                       &item->data_offset);
+        g_mutex_unlock(&ra->wth_mutex);
+
+        item->type = ok ? READ_AHEAD_RECORD : READ_AHEAD_EOF;
+        g_async_queue_push(ra->filled_q, item);
+        if (!ok)
+            break;
+    }
+    return NULL;
+}
+
+static void
+read_ahead_start(wtap *wth)
+{
+    read_ahead_t *ra = g_new0(read_ahead_t, 1);
+
+    ra->wth = wth;
+    ra->filled_q = g_async_queue_new();
+    ra->free_q = g_async_queue_new();
+    g_mutex_init(&ra->wth_mutex);
+    ra->items = g_new0(read_ahead_item_t, READ_AHEAD_QUEUE_DEPTH);
+    for (unsigned i = 0; i < READ_AHEAD_QUEUE_DEPTH; i++) {
+        wtap_rec_init(&ra->items[i].rec, DEFAULT_INIT_BUFFER_SIZE_2048);
+        g_async_queue_push(ra->free_q, &ra->items[i]);
+    }
+
+    /* Set this before the thread starts, so the callbacks queue. */
+    read_ahead = ra;
+    ra->thread = g_thread_new("read_ahead_worker", read_ahead_worker, ra);
+}
+
+/* Hand over anything other than a record that was queued. */
+static void
+read_ahead_deliver(read_ahead_item_t *item, bool deliver)
+{
+    switch (item->type) {
+
+    case READ_AHEAD_IPV4_NAME:
+        if (deliver)
+            add_ipv4_name(item->ipv4_addr, item->name, item->static_entry);
+        break;
+
+    case READ_AHEAD_IPV6_NAME:
+        if (deliver)
+            add_ipv6_name(&item->ipv6_addr, item->name, item->static_entry);
+        break;
+
+    case READ_AHEAD_SECRETS:
+        if (deliver)
+            secrets_wtap_callback(item->secrets_type, item->secrets, item->secrets_size);
+        break;
+
+    default:
+        ws_assert_not_reached();
+    }
+    g_free(item->name);
+    g_free(item->secrets);
+    g_free(item);
+}
+
+/*
+ * Get the next record from the reader thread, in the same way as
+ * wtap_read().  The record must be handed back with
+ * read_ahead_release() before the next call.
+ */
+static bool
+read_ahead_read(read_ahead_item_t **itemp, int *err, char **err_info)
+{
+    read_ahead_item_t *item;
+
+    *itemp = NULL;
+    if (read_ahead->at_eof) {
+        *err = 0;
+        return false;
+    }
+    for (;;) {
+        item = (read_ahead_item_t *)g_async_queue_pop(read_ahead->filled_q);
+        if (item->type == READ_AHEAD_RECORD) {
+            *itemp = item;
+            return true;
+        }
+        if (item->type == READ_AHEAD_EOF) {
+            read_ahead->at_eof = true;
+            *err = item->err;
+            *err_info = item->err_info;
+            g_async_queue_push(read_ahead->free_q, item);
+            return false;
+        }
+        read_ahead_deliver(item, true);
+    }
+}
+
+static void
+read_ahead_release(read_ahead_item_t *item)
+{
+    if (item)
+        g_async_queue_push(read_ahead->free_q, item);
+}
+
+/*
+ * Stop the reader thread, whether or not it has reached the end of the
+ * file, and discard anything it read that wasn't used.
+ */
+static void
+read_ahead_finish(void)
+{
+    read_ahead_t *ra = read_ahead;
+    read_ahead_item_t *item;
+
+    g_atomic_int_set(&ra->stop, 1);
+    while (!ra->at_eof) {
+        item = (read_ahead_item_t *)g_async_queue_pop(ra->filled_q);
+        if (item->type == READ_AHEAD_RECORD) {
+            g_async_queue_push(ra->free_q, item);
+        } else if (item->type == READ_AHEAD_EOF) {
+            ra->at_eof = true;
+            g_free(item->err_info);
+            g_async_queue_push(ra->free_q, item);
+        } else {
+            read_ahead_deliver(item, false);
+        }
+    }
+    g_thread_join(ra->thread);
+    read_ahead = NULL;
+
+    /* Anything queued after the EOF item (there shouldn't be anything). */
+    while ((item = (read_ahead_item_t *)g_async_queue_try_pop(ra->filled_q)) != NULL) {
+        if (item->type != READ_AHEAD_RECORD && item->type != READ_AHEAD_EOF)
+            read_ahead_deliver(item, false);
+    }
+    for (unsigned i = 0; i < READ_AHEAD_QUEUE_DEPTH; i++) {
+        wtap_rec_cleanup(&ra->items[i].rec);
+    }
+    g_free(ra->items);
+    g_async_queue_unref(ra->filled_q);
+    g_async_queue_unref(ra->free_q);
+    g_mutex_clear(&ra->wth_mutex);
+    g_free(ra);
+}
+
+/*
+ * Write-behind pipeline for writing the output file.
+ *
+ * With --write-behind, the records that pass the filters are copied
+ * into a bounded queue and written out by a separate thread, so that
+ * the main thread doesn't wait for wtap_dump() (including any
+ * compression of the output) or for the file system.  Interface blocks
+ * for the output go through the same queue, so everything is written in
+ * the same order as without this option.
+ *
+ * A write error is noticed by the main thread on its next call or at
+ * the end of the pass, and is reported against the frame that couldn't
+ * be written, not the one being dissected at the time.
+ */
+#define WRITE_BEHIND_QUEUE_DEPTH 256
+
+typedef enum {
+    WRITE_BEHIND_RECORD,
+    WRITE_BEHIND_IDB,
+    WRITE_BEHIND_STOP
+} write_behind_item_type_t;
+
+typedef struct {
+    write_behind_item_type_t type;
+    uint32_t     framenum;     /* input frame, for error reports */
+    /* WRITE_BEHIND_RECORD */
+    wtap_rec     rec;
+    /* WRITE_BEHIND_IDB */
+    wtap_block_t idb;
+} write_behind_item_t;
+
+typedef struct {
+    wtap_dumper  *pdh;
+    GThread      *thread;
+    GAsyncQueue  *filled_q;    /* write_behind_item_t *, in output order */
+    GAsyncQueue  *free_q;      /* WRITE_BEHIND_RECORD items to copy into */
+    int           failed;      /* accessed with g_atomic_int_*; when set, */
+    int           err;         /* these are set and the writer discards */
+    char         *err_info;    /* what's left in the queue */
+    uint32_t      err_framenum;
+    write_behind_item_t *items; /* WRITE_BEHIND_QUEUE_DEPTH record items */
+} write_behind_t;
+
+/* Non-NULL while the writer thread is running. */
+static write_behind_t *write_behind;
+
+static void *
+write_behind_worker(void *data)
+{
+    write_behind_t *wb = (write_behind_t *)data;
+    write_behind_item_t *item;
+    bool ok;
+
+    for (;;) {
+        item = (write_behind_item_t *)g_async_queue_pop(wb->filled_q);
+        switch (item->type) {
+
+        case WRITE_BEHIND_RECORD:
+            if (!g_atomic_int_get(&wb->failed)) {
+                ok = wtap_dump(wb->pdh, &item->rec, &wb->err, &wb->err_info);
+                if (!ok) {
+                    ws_debug("tshark: error writing to a capture file (%d)", wb->err);
+                    wb->err_framenum = item->framenum;
+                    g_atomic_int_set(&wb->failed, 1);
+                }
+            }
+            wtap_rec_reset(&item->rec);
+            g_async_queue_push(wb->free_q, item);
+            break;
+
+        case WRITE_BEHIND_IDB:
+            if (!g_atomic_int_get(&wb->failed)) {
+                ok = wtap_dump_add_idb(wb->pdh, item->idb, &wb->err, &wb->err_info);
+                if (!ok) {
+                    wb->err_framenum = item->framenum;
+                    g_atomic_int_set(&wb->failed, 1);
+                }
+            }
+            wtap_block_unref(item->idb);
+            g_free(item);
+            break;
+
+        case WRITE_BEHIND_STOP:
+            g_free(item);
+            return NULL;
+        }
+    }
+}
+
+static void
+write_behind_start(wtap_dumper *pdh)
+{
+    write_behind_t *wb = g_new0(write_behind_t, 1);
+
+    wb->pdh = pdh;
+    wb->filled_q = g_async_queue_new();
+    wb->free_q = g_async_queue_new();
+    wb->items = g_new0(write_behind_item_t, WRITE_BEHIND_QUEUE_DEPTH);
+    for (unsigned i = 0; i < WRITE_BEHIND_QUEUE_DEPTH; i++) {
+        wb->items[i].type = WRITE_BEHIND_RECORD;
+        wtap_rec_init(&wb->items[i].rec, DEFAULT_INIT_BUFFER_SIZE_2048);
+        g_async_queue_push(wb->free_q, &wb->items[i]);
+    }
+
+    write_behind = wb;
+    wb->thread = g_thread_new("write_behind_worker", write_behind_worker, wb);
+}
+
+/*
+ * If the writer thread has failed, hand its error to the caller, once.
+ */
+static bool
+write_behind_check(int *err, char **err_info, volatile uint32_t *err_framenum)
+{
+    if (!g_atomic_int_get(&write_behind->failed))
+        return true;
+    *err = write_behind->err;
+    *err_info = write_behind->err_info;
+    *err_framenum = write_behind->err_framenum;
+    write_behind->err_info = NULL;
+    return false;
+}
+
+/*
+ * Copy a record into an item that the writer thread owns.  The packet
+ * block is shared rather than copied; block reference counts are
+ * atomic, and nobody modifies a record's block after it's been written.
+ */
+static void
+write_behind_copy_rec(wtap_rec *dst, const wtap_rec *src)
+{
+    Buffer options_buf = dst->options_buf;
+    Buffer data = dst->data;
+    wtap_block_t spare_block = dst->spare_block;
+
+    *dst = *src;
+    dst->options_buf = options_buf;
+    dst->data = data;
+    dst->spare_block = spare_block;
+    if (dst->block != NULL)
+        wtap_block_ref(dst->block);
+    ws_buffer_clean(&dst->options_buf);
+    ws_buffer_append_buffer(&dst->options_buf, &src->options_buf);
+    ws_buffer_clean(&dst->data);
+    ws_buffer_append_buffer(&dst->data, &src->data);
+}
+
+/*
+ * Write a record to the output file, in the same way as wtap_dump(),
+ * on the writer thread if there is one.
+ */
+static bool
+tshark_dump(wtap_dumper *pdh, const wtap_rec *rec, uint32_t framenum,
+        int *err, char **err_info, volatile uint32_t *err_framenum)
+{
+    write_behind_item_t *item;
+
+    if (!write_behind) {
+        if (!wtap_dump(pdh, rec, err, err_info)) {
+            ws_debug("tshark: error writing to a capture file (%d)", *err);
+            *err_framenum = framenum;
+            return false;
+        }
+        return true;
+    }
+    if (!write_behind_check(err, err_info, err_framenum))
+        return false;
+    item = (write_behind_item_t *)g_async_queue_pop(write_behind->free_q);
+    item->framenum = framenum;
+    write_behind_copy_rec(&item->rec, rec);
+    g_async_queue_push(write_behind->filled_q, item);
+    return true;
+}
+
+/*
+ * Add an interface block to the output file, in the same way as
+ * wtap_dump_add_idb(), on the writer thread if there is one.
+ */
+static bool
+tshark_dump_add_idb(wtap_dumper *pdh, wtap_block_t idb, uint32_t framenum,
+        int *err, char **err_info, volatile uint32_t *err_framenum)
+{
+    write_behind_item_t *item;
+
+    if (!write_behind) {
+        if (!wtap_dump_add_idb(pdh, idb, err, err_info)) {
+            *err_framenum = framenum;
+            return false;
+        }
+        return true;
+    }
+    if (!write_behind_check(err, err_info, err_framenum))
+        return false;
+    item = g_new0(write_behind_item_t, 1);
+    item->type = WRITE_BEHIND_IDB;
+    item->framenum = framenum;
+    item->idb = wtap_block_ref(idb);
+    g_async_queue_push(write_behind->filled_q, item);
+    return true;
+}
+
+/*
+ * Wait for the writer thread to write everything queued and stop it.
+ * Returns false, with the error, if anything couldn't be written.
+ */
+static bool
+write_behind_finish(int *err, char **err_info, volatile uint32_t *err_framenum)
+{
+    write_behind_t *wb = write_behind;
+    write_behind_item_t *item;
+    bool ok;
+
+    item = g_new0(write_behind_item_t, 1);
+    item->type = WRITE_BEHIND_STOP;
+    g_async_queue_push(wb->filled_q, item);
+    g_thread_join(wb->thread);
+
+    ok = write_behind_check(err, err_info, err_framenum);
+    write_behind = NULL;
+
+    for (unsigned i = 0; i < WRITE_BEHIND_QUEUE_DEPTH; i++) {
+        wtap_rec_cleanup(&wb->items[i].rec);
+    }
+    g_free(wb->items);
+    g_async_queue_unref(wb->filled_q);
+    g_async_queue_unref(wb->free_q);
+    g_free(wb);
+    return ok;
+}
+
+/*
+ * Packet provider routines that lock out the reader thread while they
+ * look at the wtap.
+ */
+static const nstime_t *
+tshark_provider_get_start_ts(struct packet_provider_data *prov)
+{
+    const nstime_t *ts;
+
+    read_ahead_lock();
+    ts = cap_file_provider_get_start_ts(prov);
+    read_ahead_unlock();
+    return ts;
+}
+
+static const nstime_t *
+tshark_provider_get_end_ts(struct packet_provider_data *prov)
+{
+    const nstime_t *ts;
+
+    read_ahead_lock();
+    ts = cap_file_provider_get_end_ts(prov);
+    read_ahead_unlock();
+    return ts;
+}
+
+static const char *
+tshark_provider_get_interface_name(struct packet_provider_data *prov, uint32_t interface_id, unsigned section_number)
+{
+    const char *name;
+
+    read_ahead_lock();
+    name = cap_file_provider_get_interface_name(prov, interface_id, section_number);
+    read_ahead_unlock();
+    return name;
+}
+
+static const char *
+tshark_provider_get_interface_description(struct packet_provider_data *prov, uint32_t interface_id, unsigned section_number)
+{
+    const char *descr;
+
+    read_ahead_lock();
+    descr = cap_file_provider_get_interface_description(prov, interface_id, section_number);
+    read_ahead_unlock();
+    return descr;
+}
+
+static int32_t
+tshark_provider_get_process_id(struct packet_provider_data *prov, uint32_t process_info_id, unsigned section_number)
+{
+    int32_t process_id;
+
+    read_ahead_lock();
+    process_id = cap_file_provider_get_process_id(prov, process_info_id, section_number);
+    read_ahead_unlock();
+    return process_id;
+}
+
+static const char *
+tshark_provider_get_process_name(struct packet_provider_data *prov, uint32_t process_info_id, unsigned section_number)
+{
+    const char *name;
+
+    read_ahead_lock();
+    name = cap_file_provider_get_process_name(prov, process_info_id, section_number);
+    read_ahead_unlock();
+    return name;
+}
+
+static const uint8_t *
+tshark_provider_get_process_uuid(struct packet_provider_data *prov, uint32_t process_info_id, unsigned section_number, size_t *uuid_size)
+{
+    const uint8_t *uuid;
+
+    read_ahead_lock();
+    uuid = cap_file_provider_get_process_uuid(prov, process_info_id, section_number, uuid_size);
+    read_ahead_unlock();
+    return uuid;
+}
+
 bool loop_running;
 uint32_t packet_count;
 
@@ -2986,14 +3631,14 @@ tshark_epan_new(capture_file *cf)
 {
     static const struct packet_provider_funcs funcs = {
         cap_file_provider_get_frame_ts,
-        cap_file_provider_get_start_ts,
-        cap_file_provider_get_end_ts,
-        cap_file_provider_get_interface_name,
-        cap_file_provider_get_interface_description,
+        tshark_provider_get_start_ts,
+        tshark_provider_get_end_ts,
+        tshark_provider_get_interface_name,
+        tshark_provider_get_interface_description,
         NULL,
-        cap_file_provider_get_process_id,
-        cap_file_provider_get_process_name,
-        cap_file_provider_get_process_uuid,
+        tshark_provider_get_process_id,
+        tshark_provider_get_process_name,
+        tshark_provider_get_process_uuid,
     };
 
     return epan_new(&cf->provider, &funcs);
@@ -3276,6 +3921,9 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
            "-e", we'll prime those directly later. */
         bool visible = print_packet_info && print_details && output_fields_num_fields(output_fields) == 0;
         edt = epan_dissect_new(cf->epan, create_proto_tree, visible);
+        /* Unless a tap walks the whole tree, nothing looks at the faked
+           items, so don't build subtrees holding no demanded field. */
+        epan_dissect_demand_only(edt, !(tap_flags & TL_REQUIRES_PROTO_TREE));
 
         wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
 
@@ -3293,6 +3941,7 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
                 /*
                  * The packet was successfully read; process it.
                  */
+                rolling_retire(cf, &rec);
                 switch (process_packet_single_pass(cf, edt, data_offset, &rec,
                                                    tap_flags)) {
 
@@ -3647,6 +4296,9 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
         int64_t max_byte_count, int *err, char **err_info)
 {
     wtap_rec        rec;
+    wtap_rec       *recp = &rec;
+    read_ahead_item_t *ra_item = NULL;
+    bool            got_record;
     epan_dissect_t *edt = NULL;
     int64_t         data_offset;
     pass_status_t   status = PASS_SUCCEEDED;
@@ -3679,18 +4331,33 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
         /* We're not going to display the protocol tree on this pass,
            so it's not going to be "visible". */
         edt = epan_dissect_new(cf->epan, create_proto_tree, false);
+        epan_dissect_demand_only(edt, true);
     }
 
     ws_debug("tshark: reading records for first pass");
+    if (opt_read_ahead)
+        read_ahead_start(cf->provider.wth);
+
     *err = 0;
-    while (wtap_read(cf->provider.wth, &rec, err, err_info, &data_offset)) {
+    for (;;) {
+        if (opt_read_ahead) {
+            got_record = read_ahead_read(&ra_item, err, err_info);
+            if (got_record) {
+                recp = &ra_item->rec;
+                data_offset = ra_item->data_offset;
+            }
+        } else {
+            got_record = wtap_read(cf->provider.wth, &rec, err, err_info, &data_offset);
+        }
+        if (!got_record)
+            break;
         if (read_interrupted) {
             status = PASS_INTERRUPTED;
             break;
         }
         framenum++;
 
-        if (process_packet_first_pass(cf, edt, data_offset, &rec)) {
+        if (process_packet_first_pass(cf, edt, data_offset, recp)) {
             /* Stop reading if we hit a stop condition */
             if (max_packet_count > 0 && framenum >= max_packet_count) {
                 ws_debug("tshark: max_packet_count (%d) reached", max_packet_count);
@@ -3704,7 +4371,16 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
                 break;
             }
         }
-        wtap_rec_reset(&rec);
+        if (opt_read_ahead) {
+            read_ahead_release(ra_item);
+            ra_item = NULL;
+        } else {
+            wtap_rec_reset(&rec);
+        }
+    }
+    if (opt_read_ahead) {
+        read_ahead_release(ra_item);
+        read_ahead_finish();
     }
     if (*err != 0)
         status = PASS_READ_ERROR;
@@ -3837,7 +4513,8 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
 }
 
 static bool
-process_new_idbs(wtap *wth, wtap_dumper *pdh, int *err, char **err_info)
+process_new_idbs(wtap *wth, wtap_dumper *pdh, uint32_t framenum,
+        int *err, char **err_info, volatile uint32_t *err_framenum)
 {
     wtap_block_t if_data;
 
@@ -3851,7 +4528,7 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, int *err, char **err_info)
          */
         if (pdh != NULL) {
             if (wtap_file_type_subtype_supports_block(wtap_dump_file_type_subtype(pdh), WTAP_BLOCK_IF_ID_AND_INFO) != BLOCK_NOT_SUPPORTED) {
-                if (!wtap_dump_add_idb(pdh, if_data, err, err_info))
+                if (!tshark_dump_add_idb(pdh, if_data, framenum, err, err_info, err_framenum))
                     return false;
             }
         }
@@ -3859,6 +4536,32 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, int *err, char **err_info)
     return true;
 }
 
+/*
+ * Stop the writer thread, if there is one, at the end of a pass.  A
+ * write error it hit is reported unless the pass already failed in some
+ * other way.
+ */
+static pass_status_t
+finish_write_behind(pass_status_t status, int *err, char **err_info,
+        volatile uint32_t *err_framenum)
+{
+    int   wb_err;
+    char *wb_err_info = NULL;
+
+    if (!write_behind)
+        return status;
+    if (!write_behind_finish(&wb_err, &wb_err_info, err_framenum) &&
+            status != PASS_WRITE_ERROR) {
+        if (status == PASS_SUCCEEDED || status == PASS_INTERRUPTED) {
+            *err = wb_err;
+            *err_info = wb_err_info;
+            return PASS_WRITE_ERROR;
+        }
+        g_free(wb_err_info);
+    }
+    return status;
+}
+
 static pass_status_t
 process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
         int *err, char **err_info,
@@ -3880,9 +4583,10 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
      * the IDBs in the file, as we've finished reading it; they'll
      * all be at the beginning of the output file.
      */
-    if (!process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
-        *err_framenum = 0;
-        return PASS_WRITE_ERROR;
+    if (opt_write_behind && pdh != NULL)
+        write_behind_start(pdh);
+    if (!process_new_idbs(cf->provider.wth, pdh, 0, err, err_info, err_framenum)) {
+        return finish_write_behind(PASS_WRITE_ERROR, err, err_info, err_framenum);
     }
 
     wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
@@ -3922,6 +4626,9 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
            "-e", we'll prime those directly later. */
         bool visible = print_packet_info && print_details && output_fields_num_fields(output_fields) == 0;
         edt = epan_dissect_new(cf->epan, create_proto_tree, visible);
+        /* Unless a tap walks the whole tree, nothing looks at the faked
+           items, so don't build subtrees holding no demanded field. */
+        epan_dissect_demand_only(edt, !(tap_flags & TL_REQUIRES_PROTO_TREE));
     }
 
     /*
@@ -3957,10 +4664,8 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
             write_framenum++;
             if (pdh != NULL) {
                 ws_debug("tshark: writing packet #%d to outfile packet #%d", framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, err, err_info)) {
+                if (!tshark_dump(pdh, &rec, framenum, err, err_info, err_framenum)) {
                     /* Error writing to the output file. */
-                    ws_debug("tshark: error writing to a capture file (%d)", *err);
-                    *err_framenum = framenum;
                     status = PASS_WRITE_ERROR;
                     break;
                 }
@@ -3989,6 +4694,7 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
         }
         wtap_rec_reset(&rec);
     }
+    status = finish_write_behind(status, err, err_info, err_framenum);
 
     if (edt)
         epan_dissect_free(edt);
@@ -4006,6 +4712,10 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         volatile uint32_t *err_framenum)
 {
     wtap_rec        rec;
+    wtap_rec       *recp = &rec;
+    read_ahead_item_t *ra_item = NULL;
+    bool            got_record;
+    bool            idbs_ok;
     bool create_proto_tree = false;
     bool            filtering_tap_listeners;
     unsigned        tap_flags;
@@ -4060,6 +4770,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
            "-e", we'll prime those directly later. */
         visible = print_packet_info && print_details && output_fields_num_fields(output_fields) == 0;
         edt = epan_dissect_new(cf->epan, create_proto_tree, visible);
+        epan_dissect_demand_only(edt, !(tap_flags & TL_REQUIRES_PROTO_TREE));
     }
 
     /*
@@ -4069,10 +4780,25 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
      */
     set_resolution_synchrony(true);
 
+    if (opt_read_ahead)
+        read_ahead_start(cf->provider.wth);
+    if (opt_write_behind && pdh != NULL)
+        write_behind_start(pdh);
+
     *err = 0;
     got_printing_error = false;
-    while (wtap_read(cf->provider.wth, &rec, err, err_info, &data_offset) &&
-           !got_printing_error) {
+    for (;;) {
+        if (opt_read_ahead) {
+            got_record = read_ahead_read(&ra_item, err, err_info);
+            if (got_record) {
+                recp = &ra_item->rec;
+                data_offset = ra_item->data_offset;
+            }
+        } else {
+            got_record = wtap_read(cf->provider.wth, &rec, err, err_info, &data_offset);
+        }
+        if (!got_record || got_printing_error)
+            break;
         if (read_interrupted) {
             status = PASS_INTERRUPTED;
             break;
@@ -4082,8 +4808,11 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         /*
          * Process whatever IDBs we haven't seen yet.
          */
-        if (!process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
-            *err_framenum = framenum;
+        read_ahead_lock();
+        idbs_ok = process_new_idbs(cf->provider.wth, pdh, framenum,
+                                   err, err_info, err_framenum);
+        read_ahead_unlock();
+        if (!idbs_ok) {
             status = PASS_WRITE_ERROR;
             break;
         }
@@ -4091,8 +4820,9 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         ws_debug("tshark: processing packet #%d", framenum);
 
         reset_epan_mem(cf, edt, create_proto_tree, visible);
+        rolling_retire(cf, recp);
 
-        switch (process_packet_single_pass(cf, edt, data_offset, &rec,
+        switch (process_packet_single_pass(cf, edt, data_offset, recp,
                                            tap_flags)) {
         case PROCESS_PACKET_PASSED:
             /* Either there's no read filtering or this packet passed the
@@ -4102,10 +4832,8 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             if (pdh != NULL) {
                 ws_debug("tshark: writing packet #%d to outfile as #%d",
                         framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, err, err_info)) {
+                if (!tshark_dump(pdh, recp, framenum, err, err_info, err_framenum)) {
                     /* Error writing to the output file. */
-                    ws_debug("tshark: error writing to a capture file (%d)", *err);
-                    *err_framenum = framenum;
                     status = PASS_WRITE_ERROR;
                     break;
                 }
@@ -4147,7 +4875,16 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             *err = 0; /* This is not a read error */
             break;
         }
-        wtap_rec_reset(&rec);
+        if (opt_read_ahead) {
+            read_ahead_release(ra_item);
+            ra_item = NULL;
+        } else {
+            wtap_rec_reset(&rec);
+        }
+    }
+    if (opt_read_ahead) {
+        read_ahead_release(ra_item);
+        read_ahead_finish();
     }
     if (status == PASS_SUCCEEDED) {
         if (*err != 0) {
@@ -4157,8 +4894,8 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             /*
              * Process whatever IDBs we haven't seen yet.
              */
-            if (!process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
-                *err_framenum = framenum;
+            if (!process_new_idbs(cf->provider.wth, pdh, framenum,
+                                  err, err_info, err_framenum)) {
                 status = PASS_WRITE_ERROR;
             }
 
@@ -4170,6 +4907,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             }
         }
     }
+    status = finish_write_behind(status, err, err_info, err_framenum);
 
     if (edt)
         epan_dissect_free(edt);
@@ -4922,7 +5660,7 @@ print_columns(capture_file *cf, const epan_dissect_t *edt)
 }
 
 static bool
-print_packet(capture_file *cf, epan_dissect_t *edt)
+write_packet(capture_file *cf, epan_dissect_t *edt)
 {
     if (print_summary || output_fields_has_cols(output_fields))
         /* Just fill in the columns. */
@@ -5011,6 +5749,17 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
     return true;
 }
 
+static bool
+print_packet(capture_file *cf, epan_dissect_t *edt)
+{
+    bool ok;
+
+    WS_TRACE1(print__start, edt->pi.num);
+    ok = write_packet(cf, edt);
+    WS_TRACE2(print__done, edt->pi.num, ok);
+    return ok;
+}
+
 static bool
 write_finale(void)
 {
@@ -5110,9 +5859,9 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile
     epan_free(cf->epan);
     cf->epan = tshark_epan_new(cf);
 
-    wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
-    wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
-    wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+    wtap_set_cb_new_ipv4(cf->provider.wth, tshark_add_ipv4_name);
+    wtap_set_cb_new_ipv6(cf->provider.wth, tshark_add_ipv6_name);
+    wtap_set_cb_new_secrets(cf->provider.wth, tshark_add_secrets);
 
     return CF_OK;
 
@@ -5209,4 +5958,46 @@ reset_epan_mem(capture_file *cf,epan_dissect_t *edt, bool tree, bool visual)
     cf->epan = tshark_epan_new(cf);
     epan_dissect_init(edt, cf->epan, tree, visual);
     cf->count = 0;
+
+    /* Frame numbers start over, and there's nothing left to retire. */
+    g_queue_clear_full(&rolling_marks, g_free);
+}
+
+/*
+ * Called before processing each record with --rolling. Once a second of
+ * capture time, drops the state of the frames, conversations and
+ * reassemblies that haven't been seen in the last rolling_secs seconds.
+ * This is a single pass, so none of those frames will be dissected again.
+ */
+static void
+rolling_retire(capture_file *cf, const wtap_rec *rec)
+{
+    rolling_mark_t *mark;
+    bool            expired = false;
+    unsigned        retired;
+
+    if (rolling_secs == 0 || !(rec->presence_flags & WTAP_HAS_TS))
+        return;
+
+    mark = (rolling_mark_t *)g_queue_peek_tail(&rolling_marks);
+    if (mark != NULL && rec->ts.secs <= mark->secs)
+        return;
+
+    /* This is the first record with this time; it's about to become
+       frame cf->count + 1. */
+    mark = g_new(rolling_mark_t, 1);
+    mark->secs = rec->ts.secs;
+    mark->framenum = cf->count + 1;
+    g_queue_push_tail(&rolling_marks, mark);
+
+    while ((mark = (rolling_mark_t *)g_queue_peek_head(&rolling_marks))->secs + (time_t)rolling_secs <= rec->ts.secs) {
+        g_free(g_queue_pop_head(&rolling_marks));
+        expired = true;
+    }
+    if (!expired)
+        return;
+
+    retired = epan_retire_before(mark->framenum);
+    ws_debug("tshark: retired %u conversations idle since before frame %u",
+             retired, mark->framenum);
 }
@@ -58,7 +58,7 @@ typedef struct if_stat_cache_item_s {
 struct if_stat_cache_s {
     int stat_fd;
     ws_process_id fork_child;
-    GList *cache_list;  /* List of if_stat_chache_entry_t */
+    GHashTable *cache_table;  /* Interface name -> if_stat_cache_item_t */
 };
 
 /* this callback mechanism should possibly be replaced by the g_signal_...() stuff (if I only would know how :-) */
@@ -443,6 +443,8 @@ capture_input_new_file(capture_session *cap_session, char *new_file)
                            &cap_session->rec, &err,
                            &cap_session->frame_dup_cache, cap_session->frame_cksum);
             cf_close((capture_file *)cap_session->cf);
+            /* That read everything that was left. */
+            cap_session->count_pending = 0;
         }
         g_free(capture_opts->save_file);
         is_tempfile = false;
@@ -571,10 +573,11 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
             }
             capture_callback_invoke(capture_cb_capture_update_started, cap_session);
         }
-        /* Read from the capture file the number of records the child told us it added. */
-        to_read += cap_session->count_pending;
+        /* Read from the capture file the number of records the child told
+           us it added, along with any we didn't get to last time. */
+        int to_tail = to_read + cap_session->count_pending;
         cap_session->count_pending = 0;
-        switch (cf_continue_tail((capture_file *)cap_session->cf, to_read,
+        switch (cf_continue_tail((capture_file *)cap_session->cf, &to_tail,
                                  &cap_session->rec, &err,
                                  &cap_session->frame_dup_cache, cap_session->frame_cksum)) {
 
@@ -585,6 +588,7 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
                    file.
 
                    XXX - abort on a read error? */
+                cap_session->count_pending = to_tail;
                 capture_callback_invoke(capture_cb_capture_update_continue, cap_session);
                 break;
 
@@ -605,6 +609,17 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
         capture_info_new_packets(to_read, cap_session->wtap, cap_session->cap_data_info);
 }
 
+/* read the packets we left for later in capture_input_new_packets */
+void
+capture_read_pending(capture_session *cap_session)
+{
+    if (cap_session->state != CAPTURE_RUNNING || !cap_session->capture_opts->real_time_mode ||
+        cap_session->count_pending == 0)
+        return;
+
+    capture_input_new_packets(cap_session, 0);
+}
+
 
 /* Capture child told us how many dropped packets it counted.
  */
@@ -886,6 +901,15 @@ capture_input_closed(capture_session *cap_session, char *msg)
     }
 }
 
+static void
+capture_stat_cache_item_free(void *data)
+{
+    if_stat_cache_item_t *sc_item = (if_stat_cache_item_t *)data;
+
+    g_free(sc_item->name);
+    g_free(sc_item);
+}
+
 if_stat_cache_t *
 capture_stat_start(capture_options *capture_opts)
 {
@@ -899,6 +923,7 @@ capture_stat_start(capture_options *capture_opts)
 
     sc->stat_fd = -1;
     sc->fork_child = WS_INVALID_PID;
+    sc->cache_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, capture_stat_cache_item_free);
 
     /* Fire up dumpcap. */
     /*
@@ -930,7 +955,7 @@ capture_stat_start(capture_options *capture_opts)
                 sc_item = g_new0(if_stat_cache_item_t, 1);
                 ws_assert(device->if_info.name);
                 sc_item->name = g_strdup(device->if_info.name);
-                sc->cache_list = g_list_prepend(sc->cache_list, sc_item);
+                g_hash_table_replace(sc->cache_table, sc_item->name, sc_item);
             }
         }
     } else {
@@ -952,6 +977,7 @@ capture_interface_stat_start(capture_options *capture_opts, GList **if_list)
 
     sc->stat_fd = -1;
     sc->fork_child = WS_INVALID_PID;
+    sc->cache_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, capture_stat_cache_item_free);
 
     /* Fire up dumpcap. */
     /*
@@ -1008,7 +1034,7 @@ capture_interface_stat_start(capture_options *capture_opts, GList **if_list)
             sc_item = g_new0(if_stat_cache_item_t, 1);
             ws_assert(if_info->name);
             sc_item->name = g_strdup(if_info->name);
-            sc->cache_list = g_list_prepend(sc->cache_list, sc_item);
+            g_hash_table_replace(sc->cache_table, sc_item->name, sc_item);
         }
     } else if (status == WS_EXIT_NO_INTERFACES) {
         /*
@@ -1033,16 +1059,16 @@ capture_interface_stat_start(capture_options *capture_opts, GList **if_list)
 
 #define MAX_STAT_LINE_LEN 500
 
-static void
-capture_stat_cache_update(if_stat_cache_t *sc)
+bool
+capture_stats_update(if_stat_cache_t *sc)
 {
     char stat_line[MAX_STAT_LINE_LEN] = "";
     char **stat_parts;
-    GList *sc_entry;
     if_stat_cache_item_t *sc_item;
+    bool updated = false;
 
     if (!sc || sc->fork_child == WS_INVALID_PID) {
-        return;
+        return false;
     }
 
     while (sync_pipe_gets_nonblock(sc->stat_fd, stat_line, MAX_STAT_LINE_LEN) > 0) {
@@ -1053,34 +1079,31 @@ capture_stat_cache_update(if_stat_cache_t *sc)
             g_strfreev(stat_parts);
             continue;
         }
-        for (sc_entry = sc->cache_list; sc_entry != NULL; sc_entry = g_list_next(sc_entry)) {
-            sc_item = (if_stat_cache_item_t *)sc_entry->data;
-            if (strcmp(sc_item->name, stat_parts[0]) == 0) {
-                sc_item->ps.ps_recv = (u_int) strtoul(stat_parts[1], NULL, 10);
-                sc_item->ps.ps_drop = (u_int) strtoul(stat_parts[2], NULL, 10);
-            }
+        sc_item = (if_stat_cache_item_t *)g_hash_table_lookup(sc->cache_table, stat_parts[0]);
+        if (sc_item) {
+            sc_item->ps.ps_recv = (u_int) strtoul(stat_parts[1], NULL, 10);
+            sc_item->ps.ps_drop = (u_int) strtoul(stat_parts[2], NULL, 10);
+            updated = true;
         }
         g_strfreev(stat_parts);
     }
+    return updated;
 }
 
 bool
 capture_stats(if_stat_cache_t *sc, char *ifname, struct pcap_stat *ps)
 {
-    GList *sc_entry;
     if_stat_cache_item_t *sc_item;
 
     if (!sc || sc->fork_child == WS_INVALID_PID || !ifname || !ps) {
         return false;
     }
 
-    capture_stat_cache_update(sc);
-    for (sc_entry = sc->cache_list; sc_entry != NULL; sc_entry = g_list_next(sc_entry)) {
-        sc_item = (if_stat_cache_item_t *)sc_entry->data;
-        if (strcmp(sc_item->name, ifname) == 0) {
-            memcpy(ps, &sc_item->ps, sizeof(struct pcap_stat));
-            return true;
-        }
+    capture_stats_update(sc);
+    sc_item = (if_stat_cache_item_t *)g_hash_table_lookup(sc->cache_table, ifname);
+    if (sc_item) {
+        memcpy(ps, &sc_item->ps, sizeof(struct pcap_stat));
+        return true;
     }
     return false;
 }
@@ -1088,8 +1111,6 @@ capture_stats(if_stat_cache_t *sc, char *ifname, struct pcap_stat *ps)
 void
 capture_stat_stop(if_stat_cache_t *sc)
 {
-    GList *sc_entry;
-    if_stat_cache_item_t *sc_item;
     int ret;
     char *msg;
 
@@ -1105,12 +1126,7 @@ capture_stat_stop(if_stat_cache_t *sc)
         }
     }
 
-    for (sc_entry = sc->cache_list; sc_entry != NULL; sc_entry = g_list_next(sc_entry)) {
-        sc_item = (if_stat_cache_item_t *)sc_entry->data;
-        g_free(sc_item->name);
-        g_free(sc_item);
-    }
-    g_list_free(sc->cache_list);
+    g_hash_table_destroy(sc->cache_table);
     g_free(sc);
 }
 
@@ -81,6 +81,15 @@ capture_stop(capture_session *cap_session);
 extern void
 capture_kill_child(capture_session *cap_session);
 
+/**
+ * Read packets the capture child has told us about but that we didn't
+ * get to yet, because it captured them faster than we could read them.
+ * Call this once the UI has caught up after a capture_cb_capture_update_continue
+ * callback; it does nothing if there are no such packets.
+ */
+extern void
+capture_read_pending(capture_session *cap_session);
+
 struct if_stat_cache_s;
 typedef struct if_stat_cache_s if_stat_cache_t;
 
@@ -100,6 +109,14 @@ extern WS_RETNONNULL if_stat_cache_t * capture_stat_start(capture_options *captu
  */
 extern WS_RETNONNULL if_stat_cache_t * capture_interface_stat_start(capture_options *capture_opts, GList **if_list);
 
+/**
+ * Read the statistics that have arrived since the last call.
+ * dumpcap reports on every interface about once a second. capture_stats()
+ * does this as well; calling it first tells whether a new report arrived.
+ * @return true if any interface's statistics were updated.
+ */
+extern bool capture_stats_update(if_stat_cache_t *sc);
+
 /**
  * Fetch capture statistics, similar to pcap_stats().
  */
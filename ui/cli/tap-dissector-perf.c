@@ -0,0 +1,124 @@
+/* tap-dissector-perf.c
+ * Per-protocol dissector time and allocation statistics for tshark.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/* This module reports how long each protocol's dissectors took and how
+ * much packet scope memory they allocated, using the profiling counters
+ * kept by epan/packet.c.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/proto.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_dissector_perf(void);
+
+/* The counters live in libwireshark; the listener has no state of its own. */
+static int dissperf_tapdata;
+
+static void
+dissperf_reset(void *tapdata _U_)
+{
+	dissector_perf_reset();
+}
+
+static void
+dissperf_draw(void *tapdata _U_)
+{
+	GPtrArray *stats = dissector_perf_get_stats();
+	uint64_t total_ns = 0;
+
+	for (unsigned i = 0; i < stats->len; i++) {
+		total_ns += ((dissector_perf_t *)g_ptr_array_index(stats, i))->self_ns;
+	}
+
+	printf("\n");
+	printf("=======================================================================================================\n");
+	printf("Dissector Performance Statistics:\n");
+	printf("Protocol                   Calls  Accepted    Self ms   Total ms  Self %%   us/call  Self bytes  Total bytes\n");
+	for (unsigned i = 0; i < stats->len; i++) {
+		dissector_perf_t *perf = (dissector_perf_t *)g_ptr_array_index(stats, i);
+
+		printf("%-20s %11" PRIu64 " %9" PRIu64 " %10.3f %10.3f %6.2f %9.3f %11" PRIu64 " %12" PRIu64 "\n",
+		       proto_get_protocol_filter_name(perf->proto_id),
+		       perf->calls,
+		       perf->accepted,
+		       perf->self_ns / 1000000.0,
+		       perf->total_ns / 1000000.0,
+		       total_ns ? 100.0 * perf->self_ns / total_ns : 0.0,
+		       perf->calls ? perf->self_ns / 1000.0 / perf->calls : 0.0,
+		       perf->self_bytes,
+		       perf->total_bytes);
+	}
+	printf("=======================================================================================================\n");
+
+	g_ptr_array_unref(stats);
+}
+
+static void
+dissperf_finish(void *tapdata _U_)
+{
+	dissector_perf_enable(false);
+}
+
+static bool
+dissperf_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString *error_string;
+
+	error_string = register_tap_listener("frame", &dissperf_tapdata, NULL, TL_REQUIRES_NOTHING,
+					dissperf_reset, NULL, dissperf_draw, dissperf_finish);
+	if (error_string) {
+		cmdarg_err("Couldn't register dissector,perf tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		return false;
+	}
+
+	dissector_perf_enable(true);
+
+	return true;
+}
+
+static stat_tap_ui dissperf_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"dissector,perf",
+	dissperf_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_dissector_perf(void)
+{
+	register_stat_tap_ui(&dissperf_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -130,6 +130,8 @@ void init_endpoints(struct register_ct *ct, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_mergeable(&iu->hash, endpoint_table_shard_new,
+			  endpoint_table_shard_merge, endpoint_table_shard_free);
 
 }
 
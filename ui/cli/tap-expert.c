@@ -42,11 +42,19 @@ typedef struct expert_entry
     char        *summary;
 } expert_entry;
 
+/* Key for finding an entry; the strings are interned in the tap's GStringChunk */
+typedef struct expert_key
+{
+    const char *protocol;
+    const char *summary;
+} expert_key;
+
 
 /* Overall struct for storing all data seen */
 typedef struct expert_tapdata_t {
     severity_level_t lowest_report_level; /* the lowest level that will be displayed */
     GArray       *ei_array[max_level]; /* expert info items */
+    GHashTable   *ei_index[max_level]; /* expert_key -> index into ei_array */
     GStringChunk *text;         /* for efficient storage of summary strings */
 } expert_tapdata_t;
 
@@ -65,9 +73,61 @@ expert_stat_reset(void *tapdata)
     /* Empty each of the arrays */
     for (n=0; n < max_level; n++) {
         g_array_set_size(etd->ei_array[n], 0);
+        g_hash_table_remove_all(etd->ei_index[n]);
     }
 }
 
+static unsigned
+expert_key_hash(const void *k)
+{
+    const expert_key *key = (const expert_key *)k;
+
+    return g_direct_hash(key->protocol) ^ g_direct_hash(key->summary);
+}
+
+static gboolean
+expert_key_equal(const void *a, const void *b)
+{
+    const expert_key *key_a = (const expert_key *)a;
+    const expert_key *key_b = (const expert_key *)b;
+
+    return key_a->protocol == key_b->protocol && key_a->summary == key_b->summary;
+}
+
+/* Find the entry for a protocol and summary, adding an empty one at
+   the end of the list for the severity level if there isn't one yet */
+static expert_entry *
+expert_entry_get(expert_tapdata_t *data, severity_level_t severity_level,
+                 const char *protocol, const char *summary, uint32_t group)
+{
+    expert_key    key;
+    expert_key   *new_key;
+    expert_entry  tmp_entry;
+    void         *idx;
+
+    /* Copy/Store protocol and summary strings efficiently using GStringChunk.
+       Interning them means the key can compare pointers. */
+    key.protocol = g_string_chunk_insert_const(data->text, protocol);
+    key.summary = g_string_chunk_insert_const(data->text, summary);
+
+    if (g_hash_table_lookup_extended(data->ei_index[severity_level], &key, NULL, &idx)) {
+        return &g_array_index(data->ei_array[severity_level], expert_entry, GPOINTER_TO_UINT(idx));
+    }
+
+    tmp_entry.protocol = key.protocol;
+    tmp_entry.summary = (char *)key.summary;
+    tmp_entry.group = group;
+    tmp_entry.frequency = 0;
+    g_array_append_val(data->ei_array[severity_level], tmp_entry);
+
+    new_key = g_new(expert_key, 1);
+    *new_key = key;
+    g_hash_table_insert(data->ei_index[severity_level], new_key,
+                        GUINT_TO_POINTER(data->ei_array[severity_level]->len - 1));
+
+    return &g_array_index(data->ei_array[severity_level], expert_entry, data->ei_array[severity_level]->len - 1);
+}
+
 /* Process stat struct for an expert frame */
 static tap_packet_status
 expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U_,
@@ -76,9 +136,7 @@ expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U
     const expert_info_t *ei   = (const expert_info_t *)pointer;
     expert_tapdata_t    *data = (expert_tapdata_t *)tapdata;
     severity_level_t     severity_level;
-    expert_entry         tmp_entry;
     expert_entry        *entry;
-    unsigned             n;
 
     switch (ei->severity) {
         case PI_COMMENT:
@@ -106,26 +164,10 @@ expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U
         return TAP_PACKET_REDRAW; /* XXX - TAP_PACKET_DONT_REDRAW? */
     }
 
-    /* If a duplicate just bump up frequency.
-       TODO: could make more efficient by avoiding linear search...*/
-    for (n=0; n < data->ei_array[severity_level]->len; n++) {
-        entry = &g_array_index(data->ei_array[severity_level], expert_entry, n);
-        if ((strcmp(ei->protocol, entry->protocol) == 0) &&
-            (strcmp(ei->summary, entry->summary) == 0)) {
-            entry->frequency++;
-            return TAP_PACKET_REDRAW;
-        }
-    }
-
-    /* Else Add new item to end of list for severity level */
-    entry = &tmp_entry;
-    /* Copy/Store protocol and summary strings efficiently using GStringChunk */
-    entry->protocol = g_string_chunk_insert_const(data->text, ei->protocol);
-    entry->summary = g_string_chunk_insert_const(data->text, ei->summary);
-    entry->group = ei->group;
-    entry->frequency = 1;
-    /* Store a copy of the expert entry */
-    g_array_append_val(data->ei_array[severity_level], tmp_entry);
+    /* If a duplicate just bump up frequency, else add new item to end of
+       list for severity level */
+    entry = expert_entry_get(data, severity_level, ei->protocol, ei->summary, ei->group);
+    entry->frequency++;
 
     return TAP_PACKET_REDRAW;
 }
@@ -187,11 +229,60 @@ expert_tapdata_free(expert_tapdata_t* hs)
 {
     for (int n = 0; n < max_level; n++) {
         g_array_free(hs->ei_array[n], true);
+        g_hash_table_destroy(hs->ei_index[n]);
     }
     g_string_chunk_free(hs->text);
     g_free(hs);
 }
 
+static expert_tapdata_t *
+expert_tapdata_new(severity_level_t lowest_report_level)
+{
+    expert_tapdata_t *hs;
+    int               n;
+
+    /* Create top-level struct */
+    hs = g_new0(expert_tapdata_t, 1);
+    hs->lowest_report_level = lowest_report_level;
+
+    /* Allocate chunk of strings */
+    hs->text = g_string_chunk_new(100);
+
+    /* Allocate GArray for each severity level */
+    for (n=0; n < max_level; n++) {
+        hs->ei_array[n] = g_array_sized_new(false, false, sizeof(expert_entry), 1000);
+        hs->ei_index[n] = g_hash_table_new_full(expert_key_hash, expert_key_equal, g_free, NULL);
+    }
+
+    return hs;
+}
+
+static void *
+expert_shard_new(void *tapdata)
+{
+    return expert_tapdata_new(((expert_tapdata_t *)tapdata)->lowest_report_level);
+}
+
+/* Add a shard's items to the parent, keeping the order they were first seen in */
+static void
+expert_shard_merge(void *tapdata, void *shard)
+{
+    expert_tapdata_t *data  = (expert_tapdata_t *)tapdata;
+    expert_tapdata_t *sdata = (expert_tapdata_t *)shard;
+    expert_entry     *entry;
+    expert_entry     *sentry;
+    unsigned          i;
+    int               level;
+
+    for (level=0; level < max_level; level++) {
+        for (i=0; i < sdata->ei_array[level]->len; i++) {
+            sentry = &g_array_index(sdata->ei_array[level], expert_entry, i);
+            entry = expert_entry_get(data, (severity_level_t)level, sentry->protocol, sentry->summary, sentry->group);
+            entry->frequency += sentry->frequency;
+        }
+    }
+}
+
 /* Create a new expert stats struct */
 static bool expert_stat_init(const char *opt_arg, void *userdata _U_)
 {
@@ -199,7 +290,6 @@ static bool expert_stat_init(const char *opt_arg, void *userdata _U_)
     const char       *filter = NULL;
     GString          *error_string;
     expert_tapdata_t *hs;
-    int               n;
     severity_level_t lowest_report_level = comment_level;
 
 
@@ -241,17 +331,7 @@ static bool expert_stat_init(const char *opt_arg, void *userdata _U_)
         }
     }
 
-    /* Create top-level struct */
-    hs = g_new0(expert_tapdata_t, 1);
-    hs->lowest_report_level = lowest_report_level;
-
-    /* Allocate chunk of strings */
-    hs->text = g_string_chunk_new(100);
-
-    /* Allocate GArray for each severity level */
-    for (n=0; n < max_level; n++) {
-        hs->ei_array[n] = g_array_sized_new(false, false, sizeof(expert_entry), 1000);
-    }
+    hs = expert_tapdata_new(lowest_report_level);
 
     /**********************************************/
     /* Register the tap listener                  */
@@ -269,6 +349,8 @@ static bool expert_stat_init(const char *opt_arg, void *userdata _U_)
         expert_tapdata_free(hs);
         return false;
     }
+    set_tap_mergeable(hs, expert_shard_new, expert_shard_merge,
+                      (tap_shard_free_cb)expert_tapdata_free);
 
     return true;
 }
@@ -29,6 +29,8 @@
 typedef struct _export_object_list_gui_t {
     GSList *entries;
     register_eo_t* eo;
+    const char *save_in_path;
+    bool save_in_path_failed;
 } export_object_list_gui_t;
 
 static GHashTable* eo_opts;
@@ -82,11 +84,67 @@ bool eo_tap_opt_add(const char *option_string)
     return false;
 }
 
+/* Create the destination directory (or its parents) if it doesn't exist */
+static bool
+eo_check_save_in_path(export_object_list_gui_t *object_list)
+{
+    if (object_list->save_in_path_failed)
+        return false;
+
+    if (!g_file_test(object_list->save_in_path, G_FILE_TEST_IS_DIR)) {
+        if (g_mkdir_with_parents(object_list->save_in_path, 0755) == -1) {
+            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
+                    object_list->save_in_path, g_strerror(errno));
+            object_list->save_in_path_failed = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void
+eo_save_entry(export_object_list_gui_t *object_list, export_object_entry_t *entry)
+{
+    GString *safe_filename = NULL;
+    char *save_as_fullpath = NULL;
+    unsigned count = 0;
+
+    do {
+        g_free(save_as_fullpath);
+        if (entry->filename) {
+            safe_filename = eo_massage_str(entry->filename,
+                EXPORT_OBJECT_MAXFILELEN, count);
+        } else {
+            char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
+            const char *ext;
+            ext = eo_ct2ext(entry->content_type);
+            snprintf(generic_name, sizeof(generic_name),
+                "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
+            safe_filename = eo_massage_str(generic_name,
+                EXPORT_OBJECT_MAXFILELEN, count);
+        }
+        save_as_fullpath = g_build_filename(object_list->save_in_path, safe_filename->str, NULL);
+        g_string_free(safe_filename, TRUE);
+    } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < prefs.gui_max_export_objects);
+    write_file_binary_mode(save_as_fullpath, entry->payload_data, entry->payload_len);
+    g_free(save_as_fullpath);
+}
+
 static void
 object_list_add_entry(void *gui_data, export_object_entry_t *entry)
 {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
+    /* Entries are complete when added unless the tap extends them later;
+     * write those out right away so that their payload isn't kept in
+     * memory until the end of the capture. */
+    if (!get_eo_updates_entries(object_list->eo)) {
+        if (eo_check_save_in_path(object_list))
+            eo_save_entry(object_list, entry);
+        eo_free_entry(entry);
+        return;
+    }
+
     object_list->entries = g_slist_append(object_list->entries, entry);
 }
 
@@ -103,46 +161,13 @@ eo_draw(void *tapdata)
 {
     export_object_list_t *tap_object = (export_object_list_t *)tapdata;
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)tap_object->gui_data;
-    GSList *slist = object_list->entries;
-    export_object_entry_t *entry;
-    char* save_in_path = (char*)g_hash_table_lookup(eo_opts, proto_get_protocol_filter_name(get_eo_proto_id(object_list->eo)));
-    GString *safe_filename = NULL;
-    char *save_as_fullpath = NULL;
-    unsigned count = 0;
+    GSList *slist;
 
-    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
-        /* If the destination directory (or its parents) do not exist, create them. */
-        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
-            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
-                    save_in_path, g_strerror(errno));
-            return;
-        }
-    }
+    if (!eo_check_save_in_path(object_list))
+        return;
 
-    while (slist) {
-        entry = (export_object_entry_t *)slist->data;
-        do {
-            g_free(save_as_fullpath);
-            if (entry->filename) {
-                safe_filename = eo_massage_str(entry->filename,
-                    EXPORT_OBJECT_MAXFILELEN, count);
-            } else {
-                char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
-                const char *ext;
-                ext = eo_ct2ext(entry->content_type);
-                snprintf(generic_name, sizeof(generic_name),
-                    "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
-                safe_filename = eo_massage_str(generic_name,
-                    EXPORT_OBJECT_MAXFILELEN, count);
-            }
-            save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
-            g_string_free(safe_filename, TRUE);
-        } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < prefs.gui_max_export_objects);
-        count = 0;
-        write_file_binary_mode(save_as_fullpath, entry->payload_data, entry->payload_len);
-        g_free(save_as_fullpath);
-        save_as_fullpath = NULL;
-        slist = slist->next;
+    for (slist = object_list->entries; slist; slist = slist->next) {
+        eo_save_entry(object_list, (export_object_entry_t *)slist->data);
     }
 }
 
@@ -175,7 +200,7 @@ eo_finish(void *tapdata)
 }
 
 static void
-exportobject_handler(void *key, void *value _U_, void *user_data _U_)
+exportobject_handler(void *key, void *value, void *user_data _U_)
 {
     GString *error_msg;
     export_object_list_t *tap_data;
@@ -197,6 +222,7 @@ exportobject_handler(void *key, void *value _U_, void *user_data _U_)
     tap_data->gui_data = (void*)object_list;
 
     object_list->eo = eo;
+    object_list->save_in_path = (const char*)value;
 
     /* Data will be gathered via a tap callback */
     error_msg = register_tap_listener(get_eo_tap_listener_name(eo), tap_data, NULL, TL_REQUIRES_NOTHING,
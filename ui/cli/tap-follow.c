@@ -15,11 +15,13 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <glib.h>
 #include <epan/addr_resolv.h>
+#include <wsutil/file_util.h>
 #include <wsutil/str_util.h>
 #include <wsutil/unicode-utils.h>
 #include <epan/follow.h>
@@ -58,8 +60,33 @@ typedef struct _cli_follow_info {
     uint32_t          addrBuf_v4;
     ws_in6_addr addrBuf_v6;
   }             addrBuf[2];
+
+  /* all streams */
+  bool          all_streams;
+  follow_multi_t *multi;
+  char          *output_dir;
+  GQueue        open_files;     /* cli_follow_file_t, least recently used first */
 } cli_follow_info_t;
 
+/* Output file of one direction of a stream, when writing all streams
+ * to a directory */
+typedef struct {
+  char          *path;
+  FILE          *fh;
+  GList         *lru_link;      /* in cli_follow_info_t->open_files while fh is open */
+  bool          opened;         /* created; reopen for appending */
+  bool          failed;
+} cli_follow_file_t;
+
+typedef struct {
+  cli_follow_file_t file[2];    /* Index with FROM_CLIENT or FROM_SERVER */
+  unsigned      chunk;
+} cli_follow_stream_t;
+
+/* Keep well below the usual per-process descriptor limits; files that
+ * drop out are reopened for appending when their stream has more data. */
+#define MAX_OPEN_FOLLOW_FILES 64
+
 
 #define STR_FOLLOW      "follow,"
 
@@ -70,6 +97,9 @@ typedef struct _cli_follow_info {
 #define STR_CODEC       ",utf-8"
 #define STR_YAML        ",yaml"
 
+#define STR_ALL         ",all"
+#define STR_DIR         ",dir="
+
 static const char * follow_str_type(cli_follow_info_t* cli_follow_info)
 {
   switch (cli_follow_info->show_type)
@@ -431,7 +461,13 @@ follow_arg_filter(const char **opt_argp, follow_info_t *follow_info)
   cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)follow_info->gui_data;
   bool is_ipv6;
 
-  if (sscanf(*opt_argp, ",%d%n", &cli_follow_info->stream_index, &len) == 1 &&
+  if (strncmp(*opt_argp, STR_ALL, strlen(STR_ALL)) == 0 &&
+      ((*opt_argp)[strlen(STR_ALL)] == 0 || (*opt_argp)[strlen(STR_ALL)] == ','))
+  {
+    *opt_argp += strlen(STR_ALL);
+    cli_follow_info->all_streams = true;
+  }
+  else if (sscanf(*opt_argp, ",%d%n", &cli_follow_info->stream_index, &len) == 1 &&
       ((*opt_argp)[len] == 0 || (*opt_argp)[len] == ','))
   {
     *opt_argp += len;
@@ -505,7 +541,7 @@ static bool follow_arg_range(const char **opt_argp, cli_follow_info_t* cli_follo
 {
   int           len;
 
-  if (**opt_argp == 0)
+  if (**opt_argp == 0 || strncmp(*opt_argp, STR_DIR, strlen(STR_DIR)) == 0)
   {
     cli_follow_info->chunkMin = 1;
     cli_follow_info->chunkMax = UINT32_MAX;
@@ -537,6 +573,23 @@ static bool follow_arg_range(const char **opt_argp, cli_follow_info_t* cli_follo
   return true;
 }
 
+static bool follow_arg_dir(const char **opt_argp, cli_follow_info_t* cli_follow_info)
+{
+  if (!follow_arg_strncmp(opt_argp, STR_DIR))
+    return true;
+
+  /* The directory is the rest of the argument and may contain commas */
+  if (!cli_follow_info->all_streams || cli_follow_info->show_type != SHOW_RAW || **opt_argp == 0)
+  {
+    cmdarg_err("An output directory requires the raw mode and all streams.");
+    return false;
+  }
+  cli_follow_info->output_dir = g_strdup(*opt_argp);
+  *opt_argp += strlen(*opt_argp);
+
+  return true;
+}
+
 static bool
 follow_arg_done(const char *opt_argp)
 {
@@ -549,6 +602,204 @@ follow_arg_done(const char *opt_argp)
   return true;
 }
 
+static void
+follow_file_close(cli_follow_info_t* cli_follow_info, cli_follow_file_t *file)
+{
+  if (file->fh == NULL)
+    return;
+
+  if (fclose(file->fh) == EOF && !file->failed)
+  {
+    fprintf(stderr, "tshark: Error writing \"%s\": %s\n", file->path, g_strerror(errno));
+    file->failed = true;
+  }
+  file->fh = NULL;
+  g_queue_delete_link(&cli_follow_info->open_files, file->lru_link);
+  file->lru_link = NULL;
+}
+
+static FILE *
+follow_file_get(cli_follow_info_t* cli_follow_info, cli_follow_file_t *file)
+{
+  if (file->fh != NULL)
+  {
+    /* Most recently used goes last */
+    g_queue_unlink(&cli_follow_info->open_files, file->lru_link);
+    g_queue_push_tail_link(&cli_follow_info->open_files, file->lru_link);
+    return file->fh;
+  }
+
+  if (file->failed)
+    return NULL;
+
+  if (cli_follow_info->open_files.length >= MAX_OPEN_FOLLOW_FILES)
+    follow_file_close(cli_follow_info, (cli_follow_file_t *)g_queue_peek_head(&cli_follow_info->open_files));
+
+  /* Truncate on first use, append when reopening after an eviction */
+  file->fh = ws_fopen(file->path, file->opened ? "ab" : "wb");
+  if (file->fh == NULL)
+  {
+    fprintf(stderr, "tshark: Can't open \"%s\" for writing: %s\n", file->path, g_strerror(errno));
+    file->failed = true;
+    return NULL;
+  }
+  file->opened = true;
+  g_queue_push_tail(&cli_follow_info->open_files, file);
+  file->lru_link = g_queue_peek_tail_link(&cli_follow_info->open_files);
+
+  return file->fh;
+}
+
+static void
+follow_all_record(follow_info_t *follow_info, unsigned stream, follow_record_t *follow_record, void *user_data)
+{
+  cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)user_data;
+  cli_follow_stream_t *cli_stream = (cli_follow_stream_t*)follow_info->gui_data;
+  const char *proto_filter_name;
+  FILE *fh;
+
+  if (cli_stream == NULL)
+  {
+    proto_filter_name = proto_get_protocol_filter_name(get_follow_proto_id(cli_follow_info->follower));
+    cli_stream = g_new0(cli_follow_stream_t, 1);
+    for (unsigned ii = 0; ii < array_length(cli_stream->file); ii++)
+    {
+      char *name = ws_strdup_printf("%s-stream-%u-node%u.bin", proto_filter_name, stream, ii);
+      cli_stream->file[ii].path = g_build_filename(cli_follow_info->output_dir, name, NULL);
+      g_free(name);
+    }
+    follow_info->gui_data = cli_stream;
+  }
+
+  /* ignore chunks not in range */
+  cli_stream->chunk++;
+  if ((cli_stream->chunk < cli_follow_info->chunkMin) || (cli_stream->chunk > cli_follow_info->chunkMax))
+    return;
+
+  fh = follow_file_get(cli_follow_info, &cli_stream->file[follow_record->is_server]);
+  if (fh != NULL && follow_record->data->len > 0)
+    fwrite(follow_record->data->data, 1, follow_record->data->len, fh);
+}
+
+static tap_packet_status
+follow_all_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data, tap_flags_t flags)
+{
+  cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)tapdata;
+
+  return follow_multi_tap_listener(cli_follow_info->multi, pinfo, edt, data, flags);
+}
+
+static void
+follow_all_reset(void *tapdata)
+{
+  cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)tapdata;
+
+  follow_multi_reset(cli_follow_info->multi);
+}
+
+static bool
+follow_all_draw_stream(follow_info_t *follow_info, unsigned stream _U_, void *user_data)
+{
+  follow_info->gui_data = user_data;
+  follow_draw(follow_info);
+  return false;
+}
+
+static bool
+follow_all_close_stream(follow_info_t *follow_info, unsigned stream _U_, void *user_data)
+{
+  cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)user_data;
+  cli_follow_stream_t *cli_stream = (cli_follow_stream_t*)follow_info->gui_data;
+
+  if (cli_stream != NULL)
+  {
+    follow_file_close(cli_follow_info, &cli_stream->file[FROM_CLIENT]);
+    follow_file_close(cli_follow_info, &cli_stream->file[FROM_SERVER]);
+  }
+  return false;
+}
+
+static void
+follow_all_draw(void *tapdata)
+{
+  cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)tapdata;
+
+  if (cli_follow_info->output_dir)
+    follow_multi_foreach_stream(cli_follow_info->multi, follow_all_close_stream, cli_follow_info);
+  else
+    follow_multi_foreach_stream(cli_follow_info->multi, follow_all_draw_stream, cli_follow_info);
+}
+
+static bool
+follow_all_free_stream(follow_info_t *follow_info, unsigned stream _U_, void *user_data)
+{
+  cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)user_data;
+  cli_follow_stream_t *cli_stream = (cli_follow_stream_t*)follow_info->gui_data;
+
+  if (cli_follow_info->output_dir && cli_stream != NULL)
+  {
+    follow_all_close_stream(follow_info, stream, user_data);
+    g_free(cli_stream->file[FROM_CLIENT].path);
+    g_free(cli_stream->file[FROM_SERVER].path);
+    g_free(cli_stream);
+  }
+  follow_info->gui_data = NULL;
+  return false;
+}
+
+static void
+follow_all_free(void *tapdata)
+{
+  cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)tapdata;
+
+  if (cli_follow_info->multi)
+  {
+    follow_multi_foreach_stream(cli_follow_info->multi, follow_all_free_stream, cli_follow_info);
+    follow_multi_free(cli_follow_info->multi);
+  }
+  g_free(cli_follow_info->output_dir);
+  g_free(cli_follow_info);
+}
+
+/* Follow every stream in a single pass, either printing them one after
+ * the other at the end or writing their payload to files as it arrives */
+static bool follow_all_streams(cli_follow_info_t* cli_follow_info)
+{
+  register_follow_t* follower = cli_follow_info->follower;
+  GString  *errp;
+
+  if (cli_follow_info->output_dir && !g_file_test(cli_follow_info->output_dir, G_FILE_TEST_IS_DIR) &&
+      g_mkdir_with_parents(cli_follow_info->output_dir, 0755) == -1)
+  {
+    cmdarg_err("Can't create output directory \"%s\": %s", cli_follow_info->output_dir, g_strerror(errno));
+    follow_all_free(cli_follow_info);
+    return false;
+  }
+
+  cli_follow_info->multi = follow_multi_new(follower,
+                                            cli_follow_info->output_dir ? follow_all_record : NULL,
+                                            cli_follow_info);
+  if (cli_follow_info->multi == NULL)
+  {
+    cmdarg_err("Following all streams is not supported for %s.",
+               proto_get_protocol_filter_name(get_follow_proto_id(follower)));
+    follow_all_free(cli_follow_info);
+    return false;
+  }
+
+  errp = register_tap_listener(get_follow_tap_string(follower), cli_follow_info, NULL, 0,
+                               follow_all_reset, follow_all_packet, follow_all_draw, follow_all_free);
+
+  if (errp != NULL)
+  {
+    follow_all_free(cli_follow_info);
+    g_string_free(errp, TRUE);
+    cmdarg_err("Error registering tap listener.");
+    return false;
+  }
+  return true;
+}
+
 static bool follow_stream(const char *opt_argp, void *userdata)
 {
   follow_info_t *follow_info;
@@ -581,10 +832,18 @@ static bool follow_stream(const char *opt_argp, void *userdata)
   arg_success &= follow_arg_mode(&opt_argp, follow_info);
   arg_success &= follow_arg_filter(&opt_argp, follow_info);
   arg_success &= follow_arg_range(&opt_argp, cli_follow_info);
+  arg_success &= follow_arg_dir(&opt_argp, cli_follow_info);
   arg_success &= follow_arg_done(opt_argp);
   if (!arg_success)
     return false;
 
+  if (cli_follow_info->all_streams)
+  {
+    follow_info->gui_data = NULL;
+    follow_info_free(follow_info);
+    return follow_all_streams(cli_follow_info);
+  }
+
   if (cli_follow_info->stream_index >= 0)
   {
     index_filter = get_follow_index_func(follower);
@@ -271,6 +271,8 @@ void init_iousers(struct register_ct *ct, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_mergeable(&iu->hash, conversation_table_shard_new,
+			  conversation_table_shard_merge, conversation_table_shard_free);
 
 }
 
@@ -0,0 +1,141 @@
+/* tap-mem.c
+ * Memory usage by component and by protocol for tshark.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/* This module reports the memory registered with wsutil/app_mem_usage.c,
+ * which includes the process as a whole and the wmem scopes, followed by
+ * the file and packet scope memory requested by each protocol's
+ * dissectors, using the profiling counters kept by epan/packet.c.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/proto.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/app_mem_usage.h>
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_mem(void);
+
+/* The counters live in libwireshark; the listener has no state of its own. */
+static int mem_tapdata;
+
+static int
+mem_compare(const void *a, const void *b)
+{
+	const dissector_perf_t *perf_a = *(const dissector_perf_t **)a;
+	const dissector_perf_t *perf_b = *(const dissector_perf_t **)b;
+
+	if (perf_a->self_file_bytes != perf_b->self_file_bytes)
+		return perf_a->self_file_bytes < perf_b->self_file_bytes ? 1 : -1;
+	if (perf_a->self_bytes != perf_b->self_bytes)
+		return perf_a->self_bytes < perf_b->self_bytes ? 1 : -1;
+	return perf_a->proto_id - perf_b->proto_id;
+}
+
+static void
+mem_reset(void *tapdata _U_)
+{
+	dissector_perf_reset();
+}
+
+static void
+mem_draw(void *tapdata _U_)
+{
+	GPtrArray *stats = dissector_perf_get_stats();
+	const char *name;
+	size_t value;
+
+	g_ptr_array_sort(stats, mem_compare);
+
+	printf("\n");
+	printf("=================================================================================\n");
+	printf("Memory Usage Statistics:\n");
+	printf("Component                                  Bytes\n");
+	for (unsigned i = 0; (name = memory_usage_get(i, &value)) != NULL; i++) {
+		printf("%-30s %17zu\n", name, value);
+	}
+	printf("\n");
+	printf("Protocol                  Calls   File bytes  Total file bytes  Packet bytes\n");
+	for (unsigned i = 0; i < stats->len; i++) {
+		dissector_perf_t *perf = (dissector_perf_t *)g_ptr_array_index(stats, i);
+
+		if (perf->total_file_bytes == 0 && perf->total_bytes == 0)
+			continue;
+		printf("%-20s %10" PRIu64 " %12" PRIu64 " %17" PRIu64 " %13" PRIu64 "\n",
+		       proto_get_protocol_filter_name(perf->proto_id),
+		       perf->calls,
+		       perf->self_file_bytes,
+		       perf->total_file_bytes,
+		       perf->self_bytes);
+	}
+	printf("=================================================================================\n");
+
+	g_ptr_array_unref(stats);
+}
+
+static void
+mem_finish(void *tapdata _U_)
+{
+	dissector_perf_enable(false);
+}
+
+static bool
+mem_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString *error_string;
+
+	error_string = register_tap_listener("frame", &mem_tapdata, NULL, TL_REQUIRES_NOTHING,
+					mem_reset, NULL, mem_draw, mem_finish);
+	if (error_string) {
+		cmdarg_err("Couldn't register mem tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		return false;
+	}
+
+	dissector_perf_enable(true);
+
+	return true;
+}
+
+static stat_tap_ui mem_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"mem",
+	mem_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_mem(void)
+{
+	register_stat_tap_ui(&mem_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -109,6 +109,7 @@ init_rtd_tables(register_rtd_t* rtd, const char *filter)
 		g_string_free(error_string, TRUE);
 		return false;
 	}
+	set_tap_mergeable(&ui->rtd, rtd_table_shard_new, rtd_table_shard_merge, rtd_table_shard_free);
 
 	return true;
 }
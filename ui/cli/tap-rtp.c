@@ -32,6 +32,7 @@
 #include <epan/tap.h>
 #include <epan/stat_tap_ui.h>
 #include <epan/addr_resolv.h>
+#include <wsutil/cmdarg_err.h>
 
 #include "ui/rtp_stream.h"
 #include "ui/tap-rtp-common.h"
@@ -104,10 +105,231 @@ rtpstreams_stat_draw_cb(rtpstream_tapinfo_t *tapinfo _U_)
     g_free(savelocale);
 }
 
+/*
+ * "-z rtp,streams,summary[,idle=<seconds>]"
+ *
+ * Constant-memory variant meant for long captures and live monitoring.
+ * Only the running per-stream counters are kept; no per-packet data is
+ * stored. With an idle timeout, streams that have not seen a packet for
+ * that many seconds are reported and forgotten, so memory is bounded by
+ * the number of concurrently active streams rather than by the capture.
+ */
+#define RTP_SUMMARY_OPT "rtp,streams,summary"
+
+typedef struct _rtp_summary_t {
+    GHashTable *streams;        /* rtpstream_id_t * -> rtpstream_info_t * */
+    double idle_timeout;        /* seconds, 0 = keep all streams until the end */
+    double next_sweep;          /* relative capture time of the next idle check */
+    double now;                 /* relative time of the current packet */
+    bool header_printed;
+} rtp_summary_t;
+
+static unsigned
+rtp_summary_hash(const void *key)
+{
+    return rtpstream_id_to_hash((const rtpstream_id_t *)key);
+}
+
+static gboolean
+rtp_summary_equal(const void *a, const void *b)
+{
+    return rtpstream_id_equal((const rtpstream_id_t *)a, (const rtpstream_id_t *)b, RTPSTREAM_ID_EQUAL_SSRC);
+}
+
+static void
+rtp_summary_free_stream(void *data)
+{
+    rtpstream_info_free_all((rtpstream_info_t *)data);
+}
+
+static void
+rtp_summary_print_stream(rtp_summary_t *summary, const rtpstream_info_t *strinfo)
+{
+    rtpstream_info_calc_t calc;
+    char *savelocale;
+
+    savelocale = g_strdup(setlocale(LC_NUMERIC, NULL));
+    setlocale(LC_NUMERIC, "C");
+
+    if (!summary->header_printed) {
+        printf("===================== RTP Streams Summary ====================\n");
+        printf("%13s %13s %15s %5s %15s %5s %10s %16s %8s %8s %8s %8s %15s %15s %8s %5s\n",
+                "Start time", "End time", "Src IP addr", "Port", "Dest IP addr", "Port", "SSRC", "Payload",
+                "Pkts", "Lost", "Lost(%)", "Seq errs", "Mean Jitter(ms)", "Max Jitter(ms)", "R-factor", "MOS");
+        summary->header_printed = true;
+    }
+
+    rtpstream_info_calculate(strinfo, &calc);
+    printf("%13.6f %13.6f %15s %5u %15s %5u 0x%08X %16s %8u %8d %8.1f %8u %15.3f %15.3f %8.1f %5.2f\n",
+            nstime_to_sec(&(strinfo->start_rel_time)),
+            nstime_to_sec(&(strinfo->stop_rel_time)),
+            calc.src_addr_str,
+            calc.src_port,
+            calc.dst_addr_str,
+            calc.dst_port,
+            calc.ssrc,
+            calc.all_payload_type_names,
+            calc.packet_count,
+            calc.lost_num,
+            calc.lost_perc,
+            calc.sequence_err,
+            calc.mean_jitter,
+            calc.max_jitter,
+            calc.r_factor,
+            calc.mos);
+    rtpstream_info_calc_free(&calc);
+
+    setlocale(LC_NUMERIC, savelocale);
+    g_free(savelocale);
+}
+
+static gboolean
+rtp_summary_evict_idle(void *key _U_, void *value, void *user_data)
+{
+    rtp_summary_t *summary = (rtp_summary_t *)user_data;
+    rtpstream_info_t *strinfo = (rtpstream_info_t *)value;
+
+    if (summary->now - nstime_to_sec(&strinfo->stop_rel_time) < summary->idle_timeout) {
+        return FALSE;
+    }
+    rtp_summary_print_stream(summary, strinfo);
+    /* Flush so that a monitoring pipeline sees finished calls promptly */
+    fflush(stdout);
+    return TRUE;
+}
+
+static void
+rtp_summary_reset(void *tapdata)
+{
+    rtp_summary_t *summary = (rtp_summary_t *)tapdata;
+
+    g_hash_table_remove_all(summary->streams);
+    summary->next_sweep = 0;
+    summary->header_printed = false;
+}
+
+static tap_packet_status
+rtp_summary_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data, tap_flags_t flags _U_)
+{
+    rtp_summary_t *summary = (rtp_summary_t *)tapdata;
+    const struct _rtp_info *rtpinfo = (const struct _rtp_info *)data;
+    rtpstream_id_t stream_id;
+    rtpstream_info_t *strinfo;
+
+    /* Shallow copy addresses as this is just for the lookup */
+    rtpstream_id_copy_pinfo_shallow(pinfo, &stream_id, false);
+    stream_id.ssrc = rtpinfo->info_sync_src;
+
+    strinfo = (rtpstream_info_t *)g_hash_table_lookup(summary->streams, &stream_id);
+    if (!strinfo) {
+        strinfo = rtpstream_info_malloc_and_init();
+        rtpstream_id_copy_pinfo(pinfo, &(strinfo->id), false);
+        strinfo->id.ssrc = rtpinfo->info_sync_src;
+        rtpstream_info_analyse_init(strinfo, pinfo, rtpinfo);
+        g_hash_table_insert(summary->streams, &(strinfo->id), strinfo);
+    }
+    rtpstream_info_analyse_process(strinfo, pinfo, rtpinfo);
+
+    /* Check for idle streams at most once per second of capture time */
+    if (summary->idle_timeout > 0) {
+        summary->now = nstime_to_sec(&pinfo->rel_ts);
+        if (summary->now >= summary->next_sweep) {
+            g_hash_table_foreach_remove(summary->streams, rtp_summary_evict_idle, summary);
+            summary->next_sweep = summary->now + 1.0;
+        }
+    }
+
+    return TAP_PACKET_DONT_REDRAW;
+}
+
+static int
+rtp_summary_cmp_start(const void *a, const void *b)
+{
+    const rtpstream_info_t *stream_a = *(const rtpstream_info_t * const *)a;
+    const rtpstream_info_t *stream_b = *(const rtpstream_info_t * const *)b;
+
+    return nstime_cmp(&stream_a->start_rel_time, &stream_b->start_rel_time);
+}
+
+static void
+rtp_summary_draw(void *tapdata)
+{
+    rtp_summary_t *summary = (rtp_summary_t *)tapdata;
+    GPtrArray *remaining;
+    GHashTableIter iter;
+    void *value;
+
+    /* Streams still active at the end of the capture, oldest first */
+    remaining = g_ptr_array_sized_new(g_hash_table_size(summary->streams));
+    g_hash_table_iter_init(&iter, summary->streams);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        g_ptr_array_add(remaining, value);
+    }
+    g_ptr_array_sort(remaining, rtp_summary_cmp_start);
+
+    for (unsigned i = 0; i < remaining->len; i++) {
+        rtp_summary_print_stream(summary, (const rtpstream_info_t *)g_ptr_array_index(remaining, i));
+    }
+    g_ptr_array_free(remaining, TRUE);
+
+    if (summary->header_printed) {
+        printf("==============================================================\n");
+    }
+}
+
+static void
+rtp_summary_finish(void *tapdata)
+{
+    rtp_summary_t *summary = (rtp_summary_t *)tapdata;
+
+    g_hash_table_destroy(summary->streams);
+    g_free(summary);
+}
 
 static bool
-rtpstreams_stat_init(const char *opt_arg _U_, void *userdata _U_)
+rtp_summary_init(const char *opt_arg)
 {
+    rtp_summary_t *summary;
+    GString *error_string;
+    const char *opt = opt_arg + strlen(RTP_SUMMARY_OPT);
+    double idle_timeout = 0;
+
+    if (*opt != '\0') {
+        char *end;
+
+        if (strncmp(opt, ",idle=", 6) != 0) {
+            cmdarg_err("invalid \"-z " RTP_SUMMARY_OPT "[,idle=<seconds>]\" argument");
+            return false;
+        }
+        idle_timeout = g_ascii_strtod(opt + 6, &end);
+        if (end == opt + 6 || *end != '\0' || idle_timeout <= 0) {
+            cmdarg_err("invalid idle timeout \"%s\" for -z " RTP_SUMMARY_OPT, opt + 6);
+            return false;
+        }
+    }
+
+    summary = g_new0(rtp_summary_t, 1);
+    summary->streams = g_hash_table_new_full(rtp_summary_hash, rtp_summary_equal, NULL, rtp_summary_free_stream);
+    summary->idle_timeout = idle_timeout;
+
+    error_string = register_tap_listener("rtp", summary, NULL, 0,
+            rtp_summary_reset, rtp_summary_packet, rtp_summary_draw, rtp_summary_finish);
+    if (error_string) {
+        cmdarg_err("Couldn't register RTP summary tap: %s", error_string->str);
+        g_string_free(error_string, TRUE);
+        g_hash_table_destroy(summary->streams);
+        g_free(summary);
+        return false;
+    }
+    return true;
+}
+
+static bool
+rtpstreams_stat_init(const char *opt_arg, void *userdata _U_)
+{
+    if (opt_arg && strncmp(opt_arg, RTP_SUMMARY_OPT, strlen(RTP_SUMMARY_OPT)) == 0) {
+        return rtp_summary_init(opt_arg);
+    }
     register_tap_listener_rtpstream(&the_tapinfo_struct, NULL, NULL);
     return true;
 }
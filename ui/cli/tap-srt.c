@@ -130,6 +130,7 @@ init_srt_tables(register_srt_t* srt, const char *filter)
 		g_string_free(error_string, TRUE);
 		return false;
 	}
+	set_tap_mergeable(&ui->data, srt_table_shard_new, srt_table_shard_merge, srt_table_shard_free);
 
 	return true;
 }
@@ -0,0 +1,262 @@
+/* frame_index.c
+ * On-disk index of the frames in a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/pint.h>
+
+#include "frame_index.h"
+
+/*
+ * File format, all values little-endian:
+ *
+ *   header:
+ *     magic           8 bytes, FRAME_INDEX_MAGIC
+ *     version         uint32, FRAME_INDEX_VERSION
+ *     entry size      uint32, FRAME_INDEX_ENTRY_SIZE
+ *     capture size    uint64, size of the capture file in bytes
+ *     capture mtime   int64, modification time of the capture file
+ *     frame count     uint32
+ *     reserved        uint32, zero
+ *
+ *   followed by one entry per frame:
+ *     file offset     uint64
+ *     packet length   uint32
+ *     captured length uint32
+ *     seconds         int64
+ *     nanoseconds     int32
+ *     flags           uint32, FRAME_INDEX_FLAG_*
+ */
+#define FRAME_INDEX_MAGIC       "WSFIDX\r\n"
+#define FRAME_INDEX_MAGIC_LEN   8
+#define FRAME_INDEX_VERSION     1
+#define FRAME_INDEX_HEADER_SIZE 40
+#define FRAME_INDEX_ENTRY_SIZE  32
+
+#define FRAME_INDEX_FLAG_HAS_TS 0x00000001
+
+struct _frame_index {
+    GMappedFile   *mapped;
+    const uint8_t *entries;
+    uint32_t       count;
+};
+
+static char *
+frame_index_path(const char *capture_path)
+{
+    return ws_strdup_printf("%s%s", capture_path, FRAME_INDEX_SUFFIX);
+}
+
+static bool
+capture_file_stat(const char *capture_path, uint64_t *size, int64_t *mtime)
+{
+    ws_statb64 statb;
+
+    if (ws_stat64(capture_path, &statb) != 0) {
+        return false;
+    }
+    *size = (uint64_t)statb.st_size;
+    *mtime = (int64_t)statb.st_mtime;
+    return true;
+}
+
+frame_index_t *
+frame_index_open(const char *capture_path)
+{
+    char          *path;
+    GMappedFile   *mapped;
+    const uint8_t *data;
+    size_t         length;
+    uint64_t       size;
+    int64_t        mtime;
+    uint32_t       count;
+    frame_index_t *index;
+
+    if (!capture_file_stat(capture_path, &size, &mtime)) {
+        return NULL;
+    }
+
+    path = frame_index_path(capture_path);
+    /* Mapping the index means opening it costs next to nothing, however
+     * many frames there are; pages are only read in when used. */
+    mapped = g_mapped_file_new(path, false, NULL);
+    g_free(path);
+    if (mapped == NULL) {
+        return NULL;
+    }
+
+    data = (const uint8_t *)g_mapped_file_get_contents(mapped);
+    length = g_mapped_file_get_length(mapped);
+    if (length < FRAME_INDEX_HEADER_SIZE ||
+            memcmp(data, FRAME_INDEX_MAGIC, FRAME_INDEX_MAGIC_LEN) != 0 ||
+            pletohu32(data + 8) != FRAME_INDEX_VERSION ||
+            pletohu32(data + 12) != FRAME_INDEX_ENTRY_SIZE ||
+            pletohu64(data + 16) != size ||
+            (int64_t)pletohu64(data + 24) != mtime) {
+        /* Not an index, an index from an incompatible version, or an
+         * index for the capture file as it used to be. */
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    count = pletohu32(data + 32);
+    if ((length - FRAME_INDEX_HEADER_SIZE) / FRAME_INDEX_ENTRY_SIZE < count) {
+        /* Truncated. */
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    index = g_new(frame_index_t, 1);
+    index->mapped = mapped;
+    index->entries = data + FRAME_INDEX_HEADER_SIZE;
+    index->count = count;
+    return index;
+}
+
+uint32_t
+frame_index_count(const frame_index_t *index)
+{
+    return index->count;
+}
+
+bool
+frame_index_get(const frame_index_t *index, uint32_t framenum,
+                frame_index_entry_t *entry)
+{
+    const uint8_t *p;
+
+    if (framenum == 0 || framenum > index->count) {
+        return false;
+    }
+
+    p = index->entries + (size_t)(framenum - 1) * FRAME_INDEX_ENTRY_SIZE;
+    entry->file_off = (int64_t)pletohu64(p);
+    entry->pkt_len = pletohu32(p + 8);
+    entry->cap_len = pletohu32(p + 12);
+    entry->abs_ts.secs = (time_t)(int64_t)pletohu64(p + 16);
+    entry->abs_ts.nsecs = (int)pletohu32(p + 24);
+    entry->has_ts = (pletohu32(p + 28) & FRAME_INDEX_FLAG_HAS_TS) != 0;
+    return true;
+}
+
+bool
+frame_index_matches(const frame_index_t *index, const frame_data *fdata)
+{
+    frame_index_entry_t entry;
+
+    if (!frame_index_get(index, fdata->num, &entry)) {
+        return false;
+    }
+    return entry.file_off == fdata->file_off &&
+        entry.pkt_len == fdata->pkt_len &&
+        entry.cap_len == fdata->cap_len &&
+        entry.has_ts == (bool)fdata->has_ts &&
+        (!entry.has_ts || nstime_cmp(&entry.abs_ts, &fdata->abs_ts) == 0);
+}
+
+void
+frame_index_free(frame_index_t *index)
+{
+    if (index == NULL) {
+        return;
+    }
+    g_mapped_file_unref(index->mapped);
+    g_free(index);
+}
+
+bool
+frame_index_write(const char *capture_path, frame_data_sequence *frames,
+                  uint32_t count)
+{
+    char       *path, *tmp_path;
+    FILE       *fh;
+    uint8_t     header[FRAME_INDEX_HEADER_SIZE];
+    uint8_t     entry[FRAME_INDEX_ENTRY_SIZE];
+    uint64_t    size;
+    int64_t     mtime;
+    frame_data *fdata;
+    bool        ok = true;
+
+    if (!capture_file_stat(capture_path, &size, &mtime)) {
+        return false;
+    }
+
+    path = frame_index_path(capture_path);
+    tmp_path = ws_strdup_printf("%s.tmp", path);
+    fh = ws_fopen(tmp_path, "wb");
+    if (fh == NULL) {
+        /* Probably a read-only directory; the index is optional. */
+        g_free(tmp_path);
+        g_free(path);
+        return false;
+    }
+
+    memcpy(header, FRAME_INDEX_MAGIC, FRAME_INDEX_MAGIC_LEN);
+    phtoleu32(header + 8, FRAME_INDEX_VERSION);
+    phtoleu32(header + 12, FRAME_INDEX_ENTRY_SIZE);
+    phtoleu64(header + 16, size);
+    phtoleu64(header + 24, (uint64_t)mtime);
+    phtoleu32(header + 32, count);
+    phtoleu32(header + 36, 0);
+    if (fwrite(header, sizeof header, 1, fh) != 1) {
+        ok = false;
+    }
+
+    for (uint32_t framenum = 1; ok && framenum <= count; framenum++) {
+        fdata = frame_data_sequence_find(frames, framenum);
+        if (fdata == NULL) {
+            ok = false;
+            break;
+        }
+        phtoleu64(entry, (uint64_t)fdata->file_off);
+        phtoleu32(entry + 8, fdata->pkt_len);
+        phtoleu32(entry + 12, fdata->cap_len);
+        phtoleu64(entry + 16, (uint64_t)(int64_t)fdata->abs_ts.secs);
+        phtoleu32(entry + 24, (uint32_t)fdata->abs_ts.nsecs);
+        phtoleu32(entry + 28, fdata->has_ts ? FRAME_INDEX_FLAG_HAS_TS : 0);
+        if (fwrite(entry, sizeof entry, 1, fh) != 1) {
+            ok = false;
+        }
+    }
+
+    if (fclose(fh) != 0) {
+        ok = false;
+    }
+    if (ok) {
+        ws_unlink(path);
+        ok = ws_rename(tmp_path, path) == 0;
+    }
+    if (!ok) {
+        ws_unlink(tmp_path);
+    }
+
+    g_free(tmp_path);
+    g_free(path);
+    return ok;
+}
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
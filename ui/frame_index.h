@@ -0,0 +1,101 @@
+/** @file
+ *
+ * On-disk index of the frames in a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_INDEX_H__
+#define __FRAME_INDEX_H__
+
+#include <epan/frame_data.h>
+#include <epan/frame_data_sequence.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A frame index is a sidecar file, named after the capture file with
+ * FRAME_INDEX_SUFFIX appended, holding the essentials of each frame's
+ * frame_data: where the record is in the file, its lengths and its
+ * time stamp. It is tied to the size and modification time of the
+ * capture file it was written for and is ignored once either changes.
+ */
+#define FRAME_INDEX_SUFFIX ".wsidx"
+
+typedef struct _frame_index frame_index_t;
+
+typedef struct {
+    int64_t  file_off;
+    uint32_t pkt_len;
+    uint32_t cap_len;
+    nstime_t abs_ts;
+    bool     has_ts;
+} frame_index_entry_t;
+
+/**
+ * Open and validate the index for a capture file.
+ *
+ * @param capture_path Path of the capture file.
+ * @return The index, or NULL if there isn't one or it doesn't match
+ * the capture file as it is now.
+ */
+frame_index_t *frame_index_open(const char *capture_path);
+
+/** Number of frames in an index. */
+uint32_t frame_index_count(const frame_index_t *index);
+
+/**
+ * Get the entry for a frame.
+ *
+ * @param index The index.
+ * @param framenum Frame number, starting at 1.
+ * @param entry Filled in with the frame's entry.
+ * @return true on success, false if framenum is out of range.
+ */
+bool frame_index_get(const frame_index_t *index, uint32_t framenum,
+                     frame_index_entry_t *entry);
+
+/**
+ * Check whether a frame matches its entry in the index.
+ */
+bool frame_index_matches(const frame_index_t *index, const frame_data *fdata);
+
+void frame_index_free(frame_index_t *index);
+
+/**
+ * Write the index for a capture file that has been read in full.
+ * The index is written to a temporary file that is then renamed, so
+ * a reader never sees a partial index.
+ *
+ * @param capture_path Path of the capture file.
+ * @param frames The file's frames.
+ * @param count Number of frames.
+ * @return true on success, false if the index couldn't be written.
+ */
+bool frame_index_write(const char *capture_path, frame_data_sequence *frames,
+                       uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_INDEX_H__ */
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,367 @@
+/* frame_ngram_index.c
+ * Per-frame trigram filters over the bytes of a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/pint.h>
+
+#include "frame_ngram_index.h"
+
+/*
+ * File format, all values little-endian:
+ *
+ *   header:
+ *     magic           8 bytes, NGRAM_INDEX_MAGIC
+ *     version         uint32, NGRAM_INDEX_VERSION
+ *     reserved        uint32, zero
+ *     capture size    uint64, size of the capture file in bytes
+ *     capture mtime   int64, modification time of the capture file
+ *     frame count     uint32
+ *     reserved        uint32, zero
+ *
+ *   followed by frame count + 1 filter offsets, uint64 each, relative
+ *   to the first filter; frame N's filter runs from offset N-1 up to
+ *   offset N,
+ *
+ *   followed by the filters. Each is a power of two bytes long; trigram
+ *   hash h sets bit (h % 8) of byte (h / 8).
+ */
+#define NGRAM_INDEX_MAGIC       "WSNGRM\r\n"
+#define NGRAM_INDEX_MAGIC_LEN   8
+#define NGRAM_INDEX_VERSION     1
+#define NGRAM_INDEX_HEADER_SIZE 40
+
+/*
+ * At least one filter bit per byte of frame data, rounded up to a power
+ * of two, keeps the false positive rate per trigram below two in three,
+ * so a search string of several bytes rules out most frames while the
+ * index stays between an eighth and a quarter of the size of the data.
+ * Jumbo frames get less than a bit per byte so that they don't dominate
+ * the index.
+ */
+#define NGRAM_FILTER_MIN_BITS_LOG2  6
+#define NGRAM_FILTER_MAX_BITS_LOG2  13
+
+struct _frame_ngram_index {
+    /* Read-only index saved by an earlier read. */
+    GMappedFile   *mapped;
+    const uint8_t *offsets;
+    const uint8_t *filters;
+    size_t         filters_len;
+    /* Index being built. */
+    GArray        *offsets_arr;     /* uint64_t, count + 1 entries */
+    GByteArray    *filters_arr;
+    uint32_t       count;
+};
+
+static char *
+frame_ngram_index_path(const char *capture_path)
+{
+    return ws_strdup_printf("%s%s", capture_path, FRAME_NGRAM_INDEX_SUFFIX);
+}
+
+static bool
+capture_file_stat(const char *capture_path, uint64_t *size, int64_t *mtime)
+{
+    ws_statb64 statb;
+
+    if (ws_stat64(capture_path, &statb) != 0) {
+        return false;
+    }
+    *size = (uint64_t)statb.st_size;
+    *mtime = (int64_t)statb.st_mtime;
+    return true;
+}
+
+static inline unsigned
+ngram_filter_bits_log2(size_t len)
+{
+    unsigned bits_log2 = NGRAM_FILTER_MIN_BITS_LOG2;
+
+    while (bits_log2 < NGRAM_FILTER_MAX_BITS_LOG2 && ((size_t)1 << bits_log2) < len) {
+        bits_log2++;
+    }
+    return bits_log2;
+}
+
+static inline uint32_t
+ngram_hash(const uint8_t *p, unsigned bits_log2)
+{
+    uint32_t trigram = ((uint32_t)g_ascii_tolower(p[0]) << 16) |
+                       ((uint32_t)g_ascii_tolower(p[1]) << 8) |
+                       (uint32_t)g_ascii_tolower(p[2]);
+
+    return (trigram * UINT32_C(0x9E3779B1)) >> (32 - bits_log2);
+}
+
+frame_ngram_index_t *
+frame_ngram_index_new(void)
+{
+    frame_ngram_index_t *index = g_new0(frame_ngram_index_t, 1);
+    uint64_t             zero = 0;
+
+    index->offsets_arr = g_array_new(false, false, sizeof(uint64_t));
+    g_array_append_val(index->offsets_arr, zero);
+    index->filters_arr = g_byte_array_new();
+    return index;
+}
+
+frame_ngram_index_t *
+frame_ngram_index_open(const char *capture_path)
+{
+    char                *path;
+    GMappedFile         *mapped;
+    const uint8_t       *data;
+    size_t               length;
+    uint64_t             size;
+    int64_t              mtime;
+    uint32_t             count;
+    frame_ngram_index_t *index;
+
+    if (!capture_file_stat(capture_path, &size, &mtime)) {
+        return NULL;
+    }
+
+    path = frame_ngram_index_path(capture_path);
+    mapped = g_mapped_file_new(path, false, NULL);
+    g_free(path);
+    if (mapped == NULL) {
+        return NULL;
+    }
+
+    data = (const uint8_t *)g_mapped_file_get_contents(mapped);
+    length = g_mapped_file_get_length(mapped);
+    if (length < NGRAM_INDEX_HEADER_SIZE ||
+            memcmp(data, NGRAM_INDEX_MAGIC, NGRAM_INDEX_MAGIC_LEN) != 0 ||
+            pletohu32(data + 8) != NGRAM_INDEX_VERSION ||
+            pletohu64(data + 16) != size ||
+            (int64_t)pletohu64(data + 24) != mtime) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    count = pletohu32(data + 32);
+    /* The offsets, and the filters they point to, have to be there. */
+    if ((length - NGRAM_INDEX_HEADER_SIZE) / 8 < (uint64_t)count + 1 ||
+            pletohu64(data + NGRAM_INDEX_HEADER_SIZE + (size_t)count * 8) >
+                length - NGRAM_INDEX_HEADER_SIZE - ((size_t)count + 1) * 8) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    index = g_new0(frame_ngram_index_t, 1);
+    index->mapped = mapped;
+    index->offsets = data + NGRAM_INDEX_HEADER_SIZE;
+    index->filters = index->offsets + ((size_t)count + 1) * 8;
+    index->filters_len = length - NGRAM_INDEX_HEADER_SIZE - ((size_t)count + 1) * 8;
+    index->count = count;
+    return index;
+}
+
+uint32_t
+frame_ngram_index_count(const frame_ngram_index_t *index)
+{
+    return index->count;
+}
+
+bool
+frame_ngram_index_is_new(const frame_ngram_index_t *index)
+{
+    return index->mapped == NULL;
+}
+
+void
+frame_ngram_index_add(frame_ngram_index_t *index, uint32_t framenum,
+                      const uint8_t *data, size_t len)
+{
+    unsigned  bits_log2;
+    size_t    filter_len;
+    uint8_t  *filter;
+    uint64_t  end;
+
+    if (index->mapped != NULL || framenum != index->count + 1) {
+        return;
+    }
+
+    bits_log2 = ngram_filter_bits_log2(len);
+    filter_len = ((size_t)1 << bits_log2) / 8;
+    if (filter_len > G_MAXUINT - index->filters_arr->len) {
+        /* Full; the remaining frames just aren't indexed. */
+        return;
+    }
+    g_byte_array_set_size(index->filters_arr, index->filters_arr->len + (unsigned)filter_len);
+    filter = index->filters_arr->data + index->filters_arr->len - filter_len;
+    memset(filter, 0, filter_len);
+
+    for (size_t i = 0; i + 2 < len; i++) {
+        uint32_t h = ngram_hash(data + i, bits_log2);
+        filter[h >> 3] |= (uint8_t)(1 << (h & 7));
+    }
+
+    end = index->filters_arr->len;
+    g_array_append_val(index->offsets_arr, end);
+    index->count++;
+}
+
+static bool
+frame_ngram_index_get(const frame_ngram_index_t *index, uint32_t framenum,
+                      const uint8_t **filter, size_t *filter_len)
+{
+    uint64_t start, end;
+
+    if (framenum == 0 || framenum > index->count) {
+        return false;
+    }
+
+    if (index->mapped != NULL) {
+        start = pletohu64(index->offsets + (size_t)(framenum - 1) * 8);
+        end = pletohu64(index->offsets + (size_t)framenum * 8);
+        if (end > index->filters_len) {
+            return false;
+        }
+        *filter = index->filters + start;
+    } else {
+        start = g_array_index(index->offsets_arr, uint64_t, framenum - 1);
+        end = g_array_index(index->offsets_arr, uint64_t, framenum);
+        *filter = index->filters_arr->data + start;
+    }
+    *filter_len = (size_t)(end - start);
+    /* Anything else is a damaged index. */
+    return end > start && (*filter_len & (*filter_len - 1)) == 0;
+}
+
+bool
+frame_ngram_index_may_contain(const frame_ngram_index_t *index,
+                              uint32_t framenum,
+                              const uint8_t *needle, size_t needle_len)
+{
+    const uint8_t *filter;
+    size_t         filter_len;
+    unsigned       bits_log2 = 3;
+
+    if (needle_len < 3 || !frame_ngram_index_get(index, framenum, &filter, &filter_len)) {
+        return true;
+    }
+
+    while (((size_t)1 << bits_log2) < filter_len * 8) {
+        bits_log2++;
+    }
+
+    for (size_t i = 0; i + 2 < needle_len; i++) {
+        uint32_t h = ngram_hash(needle + i, bits_log2);
+        if (!(filter[h >> 3] & (1 << (h & 7)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+frame_ngram_index_free(frame_ngram_index_t *index)
+{
+    if (index == NULL) {
+        return;
+    }
+    if (index->mapped != NULL) {
+        g_mapped_file_unref(index->mapped);
+    } else {
+        g_array_free(index->offsets_arr, true);
+        g_byte_array_free(index->filters_arr, true);
+    }
+    g_free(index);
+}
+
+bool
+frame_ngram_index_write(const frame_ngram_index_t *index,
+                        const char *capture_path)
+{
+    char     *path, *tmp_path;
+    FILE     *fh;
+    uint8_t   header[NGRAM_INDEX_HEADER_SIZE];
+    uint8_t   offset[8];
+    uint64_t  size;
+    int64_t   mtime;
+    bool      ok = true;
+
+    /* A read-only index is already on disk. */
+    if (index->mapped != NULL) {
+        return false;
+    }
+
+    if (!capture_file_stat(capture_path, &size, &mtime)) {
+        return false;
+    }
+
+    path = frame_ngram_index_path(capture_path);
+    tmp_path = ws_strdup_printf("%s.tmp", path);
+    fh = ws_fopen(tmp_path, "wb");
+    if (fh == NULL) {
+        g_free(tmp_path);
+        g_free(path);
+        return false;
+    }
+
+    memcpy(header, NGRAM_INDEX_MAGIC, NGRAM_INDEX_MAGIC_LEN);
+    phtoleu32(header + 8, NGRAM_INDEX_VERSION);
+    phtoleu32(header + 12, 0);
+    phtoleu64(header + 16, size);
+    phtoleu64(header + 24, (uint64_t)mtime);
+    phtoleu32(header + 32, index->count);
+    phtoleu32(header + 36, 0);
+    if (fwrite(header, sizeof header, 1, fh) != 1) {
+        ok = false;
+    }
+
+    for (unsigned i = 0; ok && i < index->offsets_arr->len; i++) {
+        phtoleu64(offset, g_array_index(index->offsets_arr, uint64_t, i));
+        if (fwrite(offset, sizeof offset, 1, fh) != 1) {
+            ok = false;
+        }
+    }
+
+    if (ok && index->filters_arr->len > 0 &&
+            fwrite(index->filters_arr->data, index->filters_arr->len, 1, fh) != 1) {
+        ok = false;
+    }
+
+    if (fclose(fh) != 0) {
+        ok = false;
+    }
+    if (ok) {
+        ws_unlink(path);
+        ok = ws_rename(tmp_path, path) == 0;
+    }
+    if (!ok) {
+        ws_unlink(tmp_path);
+    }
+
+    g_free(tmp_path);
+    g_free(path);
+    return ok;
+}
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
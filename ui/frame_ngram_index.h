@@ -0,0 +1,112 @@
+/** @file
+ *
+ * Per-frame trigram filters over the bytes of a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_NGRAM_INDEX_H__
+#define __FRAME_NGRAM_INDEX_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * An n-gram index holds, for each frame, a small Bloom filter of the
+ * (ASCII case-folded) byte trigrams in the frame's data. It can tell
+ * that a frame definitely doesn't contain a byte string, so searches
+ * can skip reading those frames. It never rules out a frame that does.
+ *
+ * The index can be saved as a sidecar file, named after the capture
+ * file with FRAME_NGRAM_INDEX_SUFFIX appended, next to the frame index.
+ * Like the frame index, it is tied to the size and modification time
+ * of the capture file and is ignored once either changes.
+ */
+#define FRAME_NGRAM_INDEX_SUFFIX ".wsngram"
+
+typedef struct _frame_ngram_index frame_ngram_index_t;
+
+/** Create an empty index, to be filled in with frame_ngram_index_add(). */
+frame_ngram_index_t *frame_ngram_index_new(void);
+
+/**
+ * Open and validate the saved index for a capture file.
+ *
+ * @param capture_path Path of the capture file.
+ * @return The index, or NULL if there isn't one or it doesn't match
+ * the capture file as it is now. An index opened this way is read-only.
+ */
+frame_ngram_index_t *frame_ngram_index_open(const char *capture_path);
+
+/** Number of frames in an index. */
+uint32_t frame_ngram_index_count(const frame_ngram_index_t *index);
+
+/** Whether an index was created with frame_ngram_index_new(). */
+bool frame_ngram_index_is_new(const frame_ngram_index_t *index);
+
+/**
+ * Add a frame's data. Frames have to be added in order; frames that
+ * are out of order or already in the index are ignored, as are all
+ * frames added to a read-only index.
+ *
+ * @param index The index.
+ * @param framenum Frame number, starting at 1.
+ * @param data The frame's data.
+ * @param len Length of the data.
+ */
+void frame_ngram_index_add(frame_ngram_index_t *index, uint32_t framenum,
+                           const uint8_t *data, size_t len);
+
+/**
+ * Check whether a frame might contain a byte string, ignoring ASCII
+ * case.
+ *
+ * @return false if the frame is known not to contain the string, true
+ * if it might, if the string is too short to check or if the frame
+ * isn't in the index.
+ */
+bool frame_ngram_index_may_contain(const frame_ngram_index_t *index,
+                                   uint32_t framenum,
+                                   const uint8_t *needle, size_t needle_len);
+
+void frame_ngram_index_free(frame_ngram_index_t *index);
+
+/**
+ * Save the index for a capture file that has been read in full. The
+ * index is written to a temporary file that is then renamed, so a
+ * reader never sees a partial index.
+ *
+ * @param index The index.
+ * @param capture_path Path of the capture file.
+ * @return true on success, false if the index couldn't be written.
+ */
+bool frame_ngram_index_write(const frame_ngram_index_t *index,
+                             const char *capture_path);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_NGRAM_INDEX_H__ */
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -426,6 +426,114 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
     return true;
 }
 
+/** Merge the values of one io_graph_item_t array into another.
+ *
+ * Used to fold per-shard items into the parent items when a tap listener
+ * collects a range of frames separately (see set_tap_mergeable()). The
+ * other items must cover frames that come after the ones already in items.
+ *
+ * @param items [in,out] Array containing the items to update.
+ * @param other [in] Array containing the items to add.
+ * @param count [in] The number of items in both arrays.
+ * @param hf_index [in] Header field index for advanced statistics.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ */
+static inline void
+merge_io_graph_items(io_graph_item_t *items, const io_graph_item_t *other, size_t count, int hf_index, int item_unit) {
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        io_graph_item_t *item = &items[i];
+        const io_graph_item_t *oitem = &other[i];
+        bool first;
+
+        if (oitem->frames == 0 && oitem->fields == 0) {
+            continue;
+        }
+
+        if (item->first_frame_in_invl == 0) {
+            item->first_frame_in_invl = oitem->first_frame_in_invl;
+        }
+        if (oitem->last_frame_in_invl != 0) {
+            item->last_frame_in_invl = oitem->last_frame_in_invl;
+        }
+        item->frames += oitem->frames;
+        item->bytes += oitem->bytes;
+
+        if (oitem->fields == 0) {
+            continue;
+        }
+        first = (item->fields == 0);
+
+        switch (hf_index >= 0 ? proto_registrar_get_ftype(hf_index) : FT_NONE) {
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+            if (first || oitem->uint_max > item->uint_max) {
+                item->uint_max = oitem->uint_max;
+                item->max_frame_in_invl = oitem->max_frame_in_invl;
+            }
+            if (first || oitem->uint_min < item->uint_min) {
+                item->uint_min = oitem->uint_min;
+                item->min_frame_in_invl = oitem->min_frame_in_invl;
+            }
+            item->double_tot += oitem->double_tot;
+            break;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+            if (first || oitem->int_max > item->int_max) {
+                item->int_max = oitem->int_max;
+                item->max_frame_in_invl = oitem->max_frame_in_invl;
+            }
+            if (first || oitem->int_min < item->int_min) {
+                item->int_min = oitem->int_min;
+                item->min_frame_in_invl = oitem->min_frame_in_invl;
+            }
+            item->double_tot += oitem->double_tot;
+            break;
+        case FT_FLOAT:
+        case FT_DOUBLE:
+            if (first || oitem->double_max > item->double_max) {
+                item->double_max = oitem->double_max;
+                item->max_frame_in_invl = oitem->max_frame_in_invl;
+            }
+            if (first || oitem->double_min < item->double_min) {
+                item->double_min = oitem->double_min;
+                item->min_frame_in_invl = oitem->min_frame_in_invl;
+            }
+            item->double_tot += oitem->double_tot;
+            break;
+        case FT_RELATIVE_TIME:
+            if (item_unit != IOG_ITEM_UNIT_CALC_LOAD) {
+                if (first || nstime_cmp(&oitem->time_max, &item->time_max) > 0) {
+                    item->time_max = oitem->time_max;
+                    item->max_frame_in_invl = oitem->max_frame_in_invl;
+                }
+                if (first || nstime_cmp(&oitem->time_min, &item->time_min) < 0) {
+                    item->time_min = oitem->time_min;
+                    item->min_frame_in_invl = oitem->min_frame_in_invl;
+                }
+            }
+            nstime_add(&item->time_tot, &oitem->time_tot);
+            break;
+        default:
+            break;
+        }
+        item->fields += oitem->fields;
+    }
+}
+
 
 #ifdef __cplusplus
 }
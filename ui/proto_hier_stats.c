@@ -27,6 +27,76 @@
 
 static int pc_proto_id = -1;
 
+/*
+ * What each frame contributes depends only on the protocols at the top
+ * level of its tree and their lengths, so that's kept for every frame
+ * dissected here, and the frames don't have to be dissected again when
+ * the statistics are computed again, e.g. for another display filter.
+ * The sequences of protocols are interned, and the lengths are stored
+ * as LEB128 varints.
+ */
+typedef struct {
+	const int	*stack;		/* [n, hf id...], or NULL if not seen yet */
+	size_t		lengths;	/* offset of the n lengths in lengths */
+} ph_frame_stack_t;
+
+struct _ph_frame_stacks {
+	GHashTable	*stack_table;	/* interned stacks */
+	GArray		*frames;	/* ph_frame_stack_t, indexed by frame number - 1 */
+	GByteArray	*lengths;
+};
+
+/* At most this many protocols are kept for a frame, each in a PDU. */
+#define PH_STACK_MAX	256
+
+	static unsigned
+ph_stack_hash(const void *key)
+{
+	const int *stack = (const int *)key;
+	unsigned hash = 5381;
+
+	for (int i = 0; i <= stack[0]; i++) {
+		hash = hash * 33 + (unsigned)stack[i];
+	}
+	return hash;
+}
+
+	static gboolean
+ph_stack_equal(const void *a, const void *b)
+{
+	const int *stack_a = (const int *)a;
+	const int *stack_b = (const int *)b;
+
+	return stack_a[0] == stack_b[0] &&
+		memcmp(stack_a + 1, stack_b + 1, stack_a[0] * sizeof(int)) == 0;
+}
+
+	void
+ph_frame_stacks_free(struct _ph_frame_stacks *stacks)
+{
+	if (!stacks)
+		return;
+
+	g_hash_table_destroy(stacks->stack_table);
+	g_array_free(stacks->frames, true);
+	g_byte_array_free(stacks->lengths, true);
+	g_free(stacks);
+}
+
+	static struct _ph_frame_stacks *
+ph_frame_stacks_get(capture_file *cf)
+{
+	if (!cf->ph_stacks) {
+		cf->ph_stacks = g_new(struct _ph_frame_stacks, 1);
+		cf->ph_stacks->stack_table = g_hash_table_new_full(ph_stack_hash, ph_stack_equal, g_free, NULL);
+		cf->ph_stacks->frames = g_array_new(false, true, sizeof(ph_frame_stack_t));
+		cf->ph_stacks->lengths = g_byte_array_new();
+	}
+	if (cf->ph_stacks->frames->len < cf->count)
+		g_array_set_size(cf->ph_stacks->frames, cf->count);
+	return cf->ph_stacks;
+}
+
     static GNode*
 find_stat_node(GNode *parent_stat_node, const header_field_info *needle_hfinfo)
 {
@@ -88,21 +158,18 @@ ph_node_is_proto(proto_node *ptree_node)
     return proto_registrar_is_protocol(hfinfo->id) && hfinfo->id != pc_proto_id;
 }
 
-static void
-// NOLINTNEXTLINE(misc-no-recursion)
-process_node(proto_node *ptree_node, GNode *parent_stat_node, ph_stats_t *ps)
+/*
+ * Counts one PDU of a protocol in the frame, found under parent_stat_node.
+ * last is true if no other protocol follows it.
+ */
+    static GNode *
+process_pdu(const header_field_info *hfinfo, unsigned length, bool last,
+            GNode *parent_stat_node, ph_stats_t *ps)
 {
-    field_info		*finfo;
     ph_stats_node_t	*stats;
-    proto_node		*proto_sibling_node;
     GNode		*stat_node;
 
-    finfo = PNODE_FINFO(ptree_node);
-    /* We don't fake protocol nodes we expect them to have a field_info.
-     */
-    ws_assert(finfo);
-
-    stat_node = find_stat_node(parent_stat_node, finfo->hfinfo);
+    stat_node = find_stat_node(parent_stat_node, hfinfo);
 
     stats = STAT_NODE_STATS(stat_node);
     /* Only increment the total packet count once per packet for a given
@@ -116,80 +183,130 @@ process_node(proto_node *ptree_node, GNode *parent_stat_node, ph_stats_t *ps)
         stats->last_pkt = ps->tot_packets;
     }
     stats->num_pdus_total++;
-    stats->num_bytes_total += finfo->length + finfo->appendix_length;
-
-    proto_sibling_node = ptree_node->next;
-
-    /* Skip entries that are not protocols, e.g.
-     * toplevel tree item of desegmentation "[Reassembled TCP Segments]")
-     * XXX: We should probably skip PINOs with field_type FT_BYTES too.
-     *
-     * XXX: We look at siblings not children, and thus don't descend into
-     * the tree to pick up embedded protocols not added to the toplevel of
-     * the tree.
-     */
-    while (proto_sibling_node) {
-        if (ph_node_is_proto(proto_sibling_node)) {
-            break;
-        }
-        proto_sibling_node = proto_sibling_node->next;
-    }
+    stats->num_bytes_total += length;
 
-    if (proto_sibling_node) {
-        // We recurse here but we're limited by proto tree checks
-        process_node(proto_sibling_node, stat_node, ps);
-    } else {
+    if (last) {
         stats->num_pkts_last++;
-        stats->num_bytes_last += finfo->length + finfo->appendix_length;
+        stats->num_bytes_last += length;
     }
+    return stat_node;
 }
 
+/* Counts a frame from its kept stack. */
+    static void
+process_stack(const struct _ph_frame_stacks *stacks, const ph_frame_stack_t *frame_stack,
+              ph_stats_t *ps)
+{
+    const int	*stack = frame_stack->stack;
+    const uint8_t	*p = stacks->lengths->data + frame_stack->lengths;
+    GNode	*stat_node = ps->stats_tree;
+
+    for (int i = 1; i <= stack[0]; i++) {
+        unsigned length = 0;
+        unsigned shift = 0;
+
+        do {
+            length |= (unsigned)(*p & 0x7f) << shift;
+            shift += 7;
+        } while (*p++ & 0x80);
 
+        stat_node = process_pdu(proto_registrar_get_nth(stack[i]), length,
+                                i == stack[0], stat_node, ps);
+    }
+}
 
+/*
+ * Keeps the protocols at the top level of the tree, and their lengths,
+ * for the frame.
+ */
     static void
-process_tree(proto_tree *protocol_tree, ph_stats_t* ps)
+process_tree(proto_tree *protocol_tree, struct _ph_frame_stacks *stacks,
+             ph_frame_stack_t *frame_stack)
 {
     proto_node	*ptree_node;
+    int		stack[PH_STACK_MAX + 1];
+    const int	*interned;
+    int		n = 0;
+
+    frame_stack->lengths = stacks->lengths->len;
 
     /*
      * Skip over non-protocols and comments. (Packet comments are a PINO
      * with FT_PROTOCOL field type). This keeps us from having a top-level
      * "Packet comments" item that steals items from "Frame".
+     *
+     * After the first protocol, skip entries that are not protocols, e.g.
+     * toplevel tree item of desegmentation "[Reassembled TCP Segments]")
+     * XXX: We should probably skip PINOs with field_type FT_BYTES too.
+     *
+     * XXX: We look at siblings not children, and thus don't descend into
+     * the tree to pick up embedded protocols not added to the toplevel of
+     * the tree.
      */
-    ptree_node = ((proto_node *)protocol_tree)->first_child;
-    while (ptree_node) {
-        if (ph_node_is_proto(ptree_node)) {
-            break;
-        }
-        ptree_node = ptree_node->next;
+    for (ptree_node = ((proto_node *)protocol_tree)->first_child;
+         ptree_node && n < PH_STACK_MAX; ptree_node = ptree_node->next) {
+        field_info *finfo;
+        unsigned length;
+
+        if (!ph_node_is_proto(ptree_node))
+            continue;
+
+        finfo = PNODE_FINFO(ptree_node);
+        stack[++n] = finfo->hfinfo->id;
+        length = finfo->length + finfo->appendix_length;
+        do {
+            uint8_t byte = length & 0x7f;
+
+            length >>= 7;
+            if (length)
+                byte |= 0x80;
+            g_byte_array_append(stacks->lengths, &byte, 1);
+        } while (length);
     }
+    stack[0] = n;
 
-    if (!ptree_node) {
-        return;
-    }
+    interned = (const int *)g_hash_table_lookup(stacks->stack_table, stack);
+    if (!interned) {
+        int *copy = (int *)g_memdup2(stack, (n + 1) * sizeof(int));
 
-    process_node(ptree_node, ps->stats_tree, ps);
+        g_hash_table_add(stacks->stack_table, copy);
+        interned = copy;
+    }
+    frame_stack->stack = interned;
 }
 
     static bool
 process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
                wtap_rec *rec, ph_stats_t* ps)
 {
-    epan_dissect_t	edt;
+    struct _ph_frame_stacks *stacks = cf->ph_stacks;
+    ph_frame_stack_t	*frame_stack;
     double		cur_time;
 
-    /* Load the record from the capture file */
-    if (!cf_read_record(cf, frame, rec))
-        return false;	/* failure */
+    frame_stack = &g_array_index(stacks->frames, ph_frame_stack_t, frame->num - 1);
+    if (!frame_stack->stack) {
+        epan_dissect_t	edt;
+
+        /* Load the record from the capture file */
+        if (!cf_read_record(cf, frame, rec))
+            return false;	/* failure */
 
-    /* Dissect the record   tree  not visible */
-    epan_dissect_init(&edt, cf->epan, true, false);
-    /* Don't fake protocols. We need them for the protocol hierarchy */
-    epan_dissect_fake_protocols(&edt, false);
-    epan_dissect_run(&edt, cf->cd_t, rec, frame, cinfo);
+        /* Dissect the record   tree  not visible */
+        epan_dissect_init(&edt, cf->epan, true, false);
+        /* Don't fake protocols. We need them for the protocol hierarchy */
+        epan_dissect_fake_protocols(&edt, false);
+        epan_dissect_run(&edt, cf->cd_t, rec, frame, cinfo);
 
-    /* Get stats from this protocol tree */
-    process_tree(edt.tree, ps);
+        /* Keep what this protocol tree adds to the stats */
+        process_tree(edt.tree, stacks, frame_stack);
+
+        /* Free our memory. */
+        epan_dissect_cleanup(&edt);
+        wtap_rec_reset(rec);
+    }
+
+    /* Get stats from this frame's protocols */
+    process_stack(stacks, frame_stack, ps);
 
     if (frame->has_ts) {
         /* Update times */
@@ -200,10 +317,6 @@ process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
             ps->last_time = cur_time;
     }
 
-    /* Free our memory. */
-    epan_dissect_cleanup(&edt);
-    wtap_rec_cleanup(rec);
-
     return true;	/* success */
 }
 
@@ -233,6 +346,9 @@ ph_stats_new(capture_file *cf)
 
     pc_proto_id = proto_registrar_get_id_byname("pkt_comment");
 
+    /* Frames seen by an earlier run aren't dissected again. */
+    ph_frame_stacks_get(cf);
+
     /* Initialize the data */
     ps = g_new(ph_stats_t, 1);
     ps->tot_packets = 0;
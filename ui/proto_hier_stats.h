@@ -44,6 +44,13 @@ ph_stats_t *ph_stats_new(capture_file *cf);
 
 void ph_stats_free(ph_stats_t *ps);
 
+/** Frees the per-frame protocol stacks ph_stats_new() keeps in the
+ * capture_file, when the frames are dissected again or the file is closed.
+ *
+ * @param stacks cf->ph_stacks, which may be NULL
+ */
+void ph_frame_stacks_free(struct _ph_frame_stacks *stacks);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
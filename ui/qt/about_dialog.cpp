@@ -30,9 +30,11 @@
 
 #include "ui/util.h"
 
+#include "wsutil/app_mem_usage.h"
 #include "wsutil/filesystem.h"
 #include "app/application_flavor.h"
 #include "wsutil/plugins.h"
+#include "wsutil/str_util.h"
 #include "wsutil/version_info.h"
 #include "wsutil/path_config.h"
 
@@ -251,6 +253,24 @@ QStringList FolderListModel::headerColumns() const
     return QStringList() << tr("Name") << tr("Location") << tr("Typical Files");
 }
 
+MemoryListModel::MemoryListModel(QObject * parent):
+        AStringListListModel(parent)
+{
+    const char *name;
+    size_t value;
+
+    for (unsigned i = 0; (name = memory_usage_get(i, &value)) != NULL; i++) {
+        appendRow(QStringList() << name
+                << gchar_free_to_qstring(format_size(value, FORMAT_SIZE_UNIT_BYTES, FORMAT_SIZE_PREFIX_IEC))
+                << QString::number(value));
+    }
+}
+
+QStringList MemoryListModel::headerColumns() const
+{
+    return QStringList() << tr("Component") << tr("Size") << tr("Bytes");
+}
+
 // To do:
 // - Tweak and enhance ui...
 
@@ -302,6 +322,13 @@ AboutDialog::AboutDialog(QWidget *parent) :
     connect(ui->searchFolders, &QLineEdit::textChanged, folderProxyModel, &AStringListListSortFilterProxyModel::setFilter);
     connect(ui->tblFolders, &QTreeView::doubleClicked, this, &AboutDialog::urlDoubleClicked);
 
+    /* Memory */
+    MemoryListModel * memoryModel = new MemoryListModel(this);
+    ui->tblMemory->setModel(memoryModel);
+    ui->tblMemory->setRootIsDecorated(false);
+    ui->tblMemory->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui->tblMemory, &QTreeView::customContextMenuRequested, this, &AboutDialog::handleCopyMenu);
+
     /* Plugins */
     ui->label_no_plugins->hide();
     PluginListModel * pluginModel = new PluginListModel(this);
@@ -426,6 +453,9 @@ void AboutDialog::showEvent(QShowEvent * event)
     ui->tblFolders->setColumnWidth(1, ui->tblFolders->parentWidget()->width() -
                                    (ui->tblFolders->columnWidth(0) + ui->tblFolders->columnWidth(2)));
 
+    // Memory: Names to contents.
+    ui->tblMemory->resizeColumnToContents(0);
+
     // Plugins: All but the last to contents.
     model = ui->tblPlugins->model();
     for (int col = 0; model && col < model->columnCount() - 1; col++) {
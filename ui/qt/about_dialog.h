@@ -65,6 +65,16 @@ protected:
     virtual QStringList headerColumns() const;
 };
 
+class MemoryListModel : public AStringListListModel
+{
+    Q_OBJECT
+public:
+    explicit MemoryListModel(QObject * parent = Q_NULLPTR);
+
+protected:
+    virtual QStringList headerColumns() const;
+};
+
 class AboutDialog : public QDialog
 {
     Q_OBJECT
@@ -82,7 +82,10 @@ QString CaptureFile::no_capture_file_ = QObject::tr("[no capture file]");
 CaptureFile::CaptureFile(QObject *parent, capture_file *cap_file) :
     QObject(parent),
     cap_file_(cap_file),
-    file_state_(QString())
+    file_state_(QString()),
+    retapping_(false),
+    retap_again_(false),
+    delayed_retap_pending_(false)
 {
 #ifdef HAVE_LIBPCAP
     capture_callback_add(captureCallback, (void *) this);
@@ -205,14 +208,43 @@ int CaptureFile::timestampPrecision()
 
 void CaptureFile::retapPackets()
 {
-    if (cap_file_) {
-        cf_retap_packets(cap_file_);
+    if (!cap_file_) {
+        return;
     }
+
+    if (retapping_) {
+        // We're being called from the event loop run by the retap in
+        // progress. Tap listeners registered since it started have missed
+        // packets, so run one more pass for all of them afterwards instead
+        // of failing on the nested call.
+        retap_again_ = true;
+        return;
+    }
+
+    retapping_ = true;
+    do {
+        retap_again_ = false;
+        if (cf_retap_packets(cap_file_) == CF_READ_ABORTED) {
+            break;
+        }
+    } while (retap_again_ && cap_file_);
+    retap_again_ = false;
+    retapping_ = false;
 }
 
 void CaptureFile::delayedRetapPackets()
 {
-    QTimer::singleShot(0, this, SLOT(retapPackets()));
+    if (delayed_retap_pending_) {
+        return;
+    }
+    delayed_retap_pending_ = true;
+    QTimer::singleShot(0, this, SLOT(runDelayedRetap()));
+}
+
+void CaptureFile::runDelayedRetap()
+{
+    delayed_retap_pending_ = false;
+    retapPackets();
 }
 
 void CaptureFile::reload()
@@ -123,13 +123,15 @@ signals:
 public slots:
     /** Retap the capture file. Convenience wrapper for cf_retap_packets.
      * Application events are processed periodically via update_progress_dlg.
+     * Requests made while a retap is in progress, e.g. by dialogs opened
+     * meanwhile, are served together by one more retap once it finishes.
      */
     void retapPackets();
 
     /** Retap the capture file after the current batch of application events
      * is processed. If you call this instead of retapPackets or
      * cf_retap_packets in a dialog's constructor it will be displayed before
-     * tapping starts.
+     * tapping starts. Requests made before the retap starts share it.
      */
     void delayedRetapPackets();
 
@@ -143,6 +145,9 @@ public slots:
      */
     void setCaptureStopFlag(bool stop_flag = true);
 
+private slots:
+    void runDelayedRetap();
+
 private:
     static void captureFileCallback(int event, void *data, void *user_data);
 #ifdef HAVE_LIBPCAP
@@ -157,6 +162,9 @@ private:
 
     capture_file *cap_file_;
     QString file_state_;
+    bool retapping_;
+    bool retap_again_;
+    bool delayed_retap_pending_;
 };
 
 #endif // CAPTURE_FILE_H
@@ -21,6 +21,7 @@
 #include "capture_filter_syntax_worker.h"
 #include <ui/qt/widgets/syntax_line_edit.h>
 
+#include <QHash>
 #include <QMutexLocker>
 #include <QSet>
 
@@ -30,6 +31,41 @@
 // gethostbyname(3) claims that it's thread safe.
 static QMutex pcap_compile_mtx_;
 
+#ifdef HAVE_LIBPCAP
+// Results of earlier checks, keyed by link-layer type (or extcap
+// interface) and filter and shared by every capture filter edit. With
+// dozens of interfaces selected, or when going back to something typed
+// a moment ago, most checks are lookups rather than pcap_compile or
+// extcap runs.
+struct FilterCheckResult {
+    enum SyntaxLineEdit::SyntaxState state;
+    QString err_str;
+};
+static QMutex filter_check_cache_mtx_;
+static QHash<QString, FilterCheckResult> filter_check_cache_;
+static const int max_filter_check_cache_ = 1000;
+
+static bool lookupFilterCheck(const QString &key, FilterCheckResult &result)
+{
+    QMutexLocker locker(&filter_check_cache_mtx_);
+    auto it = filter_check_cache_.constFind(key);
+    if (it == filter_check_cache_.constEnd()) {
+        return false;
+    }
+    result = it.value();
+    return true;
+}
+
+static void storeFilterCheck(const QString &key, const FilterCheckResult &result)
+{
+    QMutexLocker locker(&filter_check_cache_mtx_);
+    if (filter_check_cache_.size() >= max_filter_check_cache_) {
+        filter_check_cache_.clear();
+    }
+    filter_check_cache_.insert(key, result);
+}
+#endif // HAVE_LIBPCAP
+
 #if 0
 #include <QDebug>
 #include <QThread>
@@ -86,54 +122,66 @@ void CaptureFilterSyntaxWorker::checkFilter(const QString filter)
     }
 
     foreach(int dlt, active_dlts.values()) {
-        QMutexLocker locker(&pcap_compile_mtx_);
-        pd = pcap_open_dead(dlt, DUMMY_SNAPLENGTH);
-        if (pd == NULL)
-        {
-            //don't have ability to verify capture filter
-            break;
-        }
-        /*
-         * XXX - There are filters that pcap_compile rejects on a dead handle
-         * but accepts on a live handle for certain devices; e.g. "ifindex",
-         * "inbound", and "outbound" require Linux BPF extensions. (That's
-         * different than the special treatment of "vlan" on Linux and some
-         * versions of Npcap, where the filter will still be accepted, just
-         * compile differently. We only care if it's valid here, unlike in
-         * CompiledFilterDialog.) We don't want to spawn dumpcap to open a
-         * live device every time a few characters are typed, especially on
-         * Windows where that might spawn UAC prompts.
-         */
+        const QString cache_key = QStringLiteral("dlt %1\n%2").arg(dlt).arg(filter);
+        FilterCheckResult result;
+
+        if (!lookupFilterCheck(cache_key, result)) {
+            QMutexLocker locker(&pcap_compile_mtx_);
+            pd = pcap_open_dead(dlt, DUMMY_SNAPLENGTH);
+            if (pd == NULL)
+            {
+                //don't have ability to verify capture filter
+                break;
+            }
+            /*
+             * XXX - There are filters that pcap_compile rejects on a dead handle
+             * but accepts on a live handle for certain devices; e.g. "ifindex",
+             * "inbound", and "outbound" require Linux BPF extensions. (That's
+             * different than the special treatment of "vlan" on Linux and some
+             * versions of Npcap, where the filter will still be accepted, just
+             * compile differently. We only care if it's valid here, unlike in
+             * CompiledFilterDialog.) We don't want to spawn dumpcap to open a
+             * live device every time a few characters are typed, especially on
+             * Windows where that might spawn UAC prompts.
+             */
 #ifdef PCAP_NETMASK_UNKNOWN
-        pc_err = pcap_compile(pd, &fcode, filter.toUtf8().data(), 1 /* Do optimize */, PCAP_NETMASK_UNKNOWN);
+            pc_err = pcap_compile(pd, &fcode, filter.toUtf8().data(), 1 /* Do optimize */, PCAP_NETMASK_UNKNOWN);
 #else
-        pc_err = pcap_compile(pd, &fcode, filter.toUtf8().data(), 1 /* Do optimize */, 0);
+            pc_err = pcap_compile(pd, &fcode, filter.toUtf8().data(), 1 /* Do optimize */, 0);
 #endif
 
 #if DEBUG_SLEEP_TIME > 0
-        QThread::msleep(DEBUG_SLEEP_TIME);
+            QThread::msleep(DEBUG_SLEEP_TIME);
 #endif
 
-        if (pc_err) {
-            /* Check the error message to see if it implies that this filter
-             * is rejected on a dead interface but may work on a live capture.
-             */
-            const char* err_s = pcap_geterr(pd);
-            if (strstr(err_s, "when reading savefiles") /* libpcap >= 1.3.0 */ ||
-                strstr(err_s, "not a live capture") /* libpcap >= 1.11.0 */ ) {
-
-                state = SyntaxLineEdit::Deprecated;
-                err_str = tr("Unable to check capture filter (BPF extensions require a live handle)");
+            result.state = SyntaxLineEdit::Valid;
+            if (pc_err) {
+                /* Check the error message to see if it implies that this filter
+                 * is rejected on a dead interface but may work on a live capture.
+                 */
+                const char* err_s = pcap_geterr(pd);
+                if (strstr(err_s, "when reading savefiles") /* libpcap >= 1.3.0 */ ||
+                    strstr(err_s, "not a live capture") /* libpcap >= 1.11.0 */ ) {
+
+                    result.state = SyntaxLineEdit::Deprecated;
+                    result.err_str = tr("Unable to check capture filter (BPF extensions require a live handle)");
+                } else {
+                    DEBUG_SYNTAX_CHECK("unknown", "known bad");
+                    result.state = SyntaxLineEdit::Invalid;
+                    result.err_str = err_s;
+                }
             } else {
-                DEBUG_SYNTAX_CHECK("unknown", "known bad");
-                state = SyntaxLineEdit::Invalid;
-                err_str = err_s;
+                DEBUG_SYNTAX_CHECK("unknown", "known good");
+                pcap_freecode(&fcode);
             }
-        } else {
-            DEBUG_SYNTAX_CHECK("unknown", "known good");
-            pcap_freecode(&fcode);
+            pcap_close(pd);
+            storeFilterCheck(cache_key, result);
+        }
+
+        if (result.state != SyntaxLineEdit::Valid) {
+            state = result.state;
+            err_str = result.err_str;
         }
-        pcap_close(pd);
 
         if (state == SyntaxLineEdit::Invalid) break;
     }
@@ -141,22 +189,33 @@ void CaptureFilterSyntaxWorker::checkFilter(const QString filter)
     if (state != SyntaxLineEdit::Invalid) {
         foreach(unsigned extcapif, active_extcap.values()) {
             interface_t *device;
-            char *error = NULL;
+            FilterCheckResult result;
 
             device = &g_array_index(global_capture_opts.all_ifaces, interface_t, extcapif);
-            extcap_filter_status status = extcap_verify_capture_filter(device->name, filter.toUtf8().constData(), &error);
-            if (status == EXTCAP_FILTER_VALID) {
-                DEBUG_SYNTAX_CHECK("unknown", "known good");
-            } else if (status == EXTCAP_FILTER_INVALID) {
-                DEBUG_SYNTAX_CHECK("unknown", "known bad");
-                state = SyntaxLineEdit::Invalid;
-                err_str = error;
-                break;
-            } else {
-                state = SyntaxLineEdit::Deprecated;
-                err_str = tr("Unable to check capture filter");
+            const QString cache_key = QStringLiteral("extcap %1\n%2").arg(device->name).arg(filter);
+            if (!lookupFilterCheck(cache_key, result)) {
+                char *error = NULL;
+                extcap_filter_status status = extcap_verify_capture_filter(device->name, filter.toUtf8().constData(), &error);
+                if (status == EXTCAP_FILTER_VALID) {
+                    DEBUG_SYNTAX_CHECK("unknown", "known good");
+                    result.state = SyntaxLineEdit::Valid;
+                } else if (status == EXTCAP_FILTER_INVALID) {
+                    DEBUG_SYNTAX_CHECK("unknown", "known bad");
+                    result.state = SyntaxLineEdit::Invalid;
+                    result.err_str = error;
+                } else {
+                    result.state = SyntaxLineEdit::Deprecated;
+                    result.err_str = tr("Unable to check capture filter");
+                }
+                g_free(error);
+                storeFilterCheck(cache_key, result);
+            }
+
+            if (result.state != SyntaxLineEdit::Valid) {
+                state = result.state;
+                err_str = result.err_str;
             }
-            g_free(error);
+            if (state == SyntaxLineEdit::Invalid) break;
         }
     }
     emit syntaxResult(filter, state, err_str);
@@ -24,7 +24,9 @@
 #ifdef HAVE_LIBPCAP
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QMessageBox>
+#include <QSignalBlocker>
 #include <QTimer>
 
 #include "ringbuffer.h"
@@ -973,29 +975,38 @@ void CaptureOptionsDialog::updateLocalInterfaces()
     updateInterfaces(&global_capture_opts);
 }
 
+// The counts come from the welcome page's InterfaceTreeModel, which runs
+// the one dumpcap statistics session.
 void CaptureOptionsDialog::updateStatistics(void)
 {
     interface_t *device;
+    QHash<QString, interface_t *> devices;
 
-    disconnect(ui->interfaceTree, &QTreeWidget::itemChanged, this, &CaptureOptionsDialog::interfaceItemChanged);
-    for (int row = 0; row < ui->interfaceTree->topLevelItemCount(); row++) {
+    for (unsigned if_idx = 0; if_idx < global_capture_opts.all_ifaces->len; if_idx++) {
+        device = &g_array_index(global_capture_opts.all_ifaces, interface_t, if_idx);
+        if (device->hidden || device->if_info.type == IF_PIPE) {
+            continue;
+        }
+        devices.insert(device->display_name, device);
+    }
 
-        for (unsigned if_idx = 0; if_idx < global_capture_opts.all_ifaces->len; if_idx++) {
-            QTreeWidgetItem *ti = ui->interfaceTree->topLevelItem(row);
-            if (!ti) {
-                continue;
-            }
-            device = &g_array_index(global_capture_opts.all_ifaces, interface_t, if_idx);
-            QString device_name = ti->text(col_interface_);
-            if (device_name.compare(device->display_name) || device->hidden || device->if_info.type == IF_PIPE) {
-                continue;
-            }
-            QList<int> points = ti->data(col_traffic_, Qt::UserRole).value<QList<int> >();
-            points.append(device->packet_diff);
-            ti->setData(col_traffic_, Qt::UserRole, QVariant::fromValue(points));
+    // Setting each item's data would have the view work out what to
+    // repaint once per interface. Block that, and repaint what's shown
+    // once at the end.
+    QSignalBlocker blocker(ui->interfaceTree->model());
+    for (int row = 0; row < ui->interfaceTree->topLevelItemCount(); row++) {
+        QTreeWidgetItem *ti = ui->interfaceTree->topLevelItem(row);
+        if (!ti) {
+            continue;
         }
+        device = devices.value(ti->text(col_interface_));
+        if (!device) {
+            continue;
+        }
+        QList<int> points = ti->data(col_traffic_, Qt::UserRole).value<QList<int> >();
+        points.append(device->packet_diff);
+        ti->setData(col_traffic_, Qt::UserRole, QVariant::fromValue(points));
     }
-    connect(ui->interfaceTree, &QTreeWidget::itemChanged, this, &CaptureOptionsDialog::interfaceItemChanged);
     ui->interfaceTree->viewport()->update();
 }
 
@@ -0,0 +1,41 @@
+/* display_filter_syntax_worker.cpp
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "display_filter_syntax_worker.h"
+#include <ui/qt/widgets/syntax_line_edit.h>
+
+#if 0
+#include <QDebug>
+#include <QThread>
+#define DEBUG_SYNTAX_CHECK(state1, state2) qDebug() << "DF state" << QThread::currentThreadId() << state1 << "->" << state2 << ":" << filter
+#else
+#define DEBUG_SYNTAX_CHECK(state1, state2)
+#endif
+
+// Compiling a filter with big sets or deeply nested macros can take long
+// enough to make typing lag, so DisplayFilterEdit does it here. The
+// compiler serializes itself against other compiles and against changes
+// to the field registry (see dfilter_lock()), and the result is shared
+// through dfilter_compile_cached(), so applying the filter afterwards
+// on the main thread doesn't compile it again.
+void DisplayFilterSyntaxWorker::checkFilter(const QString filter)
+{
+    QString err_msg;
+    QString err_msg_full;
+
+    DEBUG_SYNTAX_CHECK("received", "?");
+
+    SyntaxLineEdit::SyntaxState state = SyntaxLineEdit::displayFilterSyntaxState(filter, err_msg, err_msg_full);
+
+    DEBUG_SYNTAX_CHECK("unknown", state);
+
+    emit syntaxResult(filter, state, err_msg, err_msg_full);
+}
@@ -0,0 +1,29 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef DISPLAY_FILTER_SYNTAX_WORKER_H
+#define DISPLAY_FILTER_SYNTAX_WORKER_H
+
+#include <QObject>
+
+class DisplayFilterSyntaxWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    DisplayFilterSyntaxWorker(QObject *parent = 0) : QObject(parent) {}
+
+public slots:
+    void checkFilter(const QString filter);
+
+signals:
+    void syntaxResult(QString filter, int state, QString err_msg, QString err_msg_full);
+};
+
+#endif // DISPLAY_FILTER_SYNTAX_WORKER_H
@@ -0,0 +1,173 @@
+/* dissector_perf_dialog.cpp
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "dissector_perf_dialog.h"
+
+#include <epan/packet.h>
+#include <epan/proto.h>
+
+#include <wsutil/utf8_entities.h>
+
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+enum {
+    col_protocol_,
+    col_calls_,
+    col_accepted_,
+    col_self_ms_,
+    col_total_ms_,
+    col_us_per_call_,
+    col_self_bytes_,
+    col_total_bytes_
+};
+
+// Sort numeric columns on their values rather than their text.
+class DissectorPerfTreeWidgetItem : public QTreeWidgetItem
+{
+public:
+    DissectorPerfTreeWidgetItem(QTreeWidget *tree) : QTreeWidgetItem(tree) {}
+
+    bool operator< (const QTreeWidgetItem &other) const
+    {
+        int column = treeWidget()->sortColumn();
+        if (column == col_protocol_) {
+            return QTreeWidgetItem::operator<(other);
+        }
+        return data(column, Qt::UserRole).toDouble() < other.data(column, Qt::UserRole).toDouble();
+    }
+};
+
+DissectorPerfDialog::DissectorPerfDialog(QWidget &parent, CaptureFile &cf) :
+    WiresharkDialog(parent, cf)
+{
+    setWindowSubtitle(tr("Dissector Performance"));
+    loadGeometry(parent.width() * 2 / 3, parent.height() * 2 / 3);
+
+    QVBoxLayout *main_layout = new QVBoxLayout(this);
+
+    stats_tree_ = new QTreeWidget(this);
+    stats_tree_->setRootIsDecorated(false);
+    stats_tree_->setUniformRowHeights(true);
+    stats_tree_->setHeaderLabels(QStringList()
+                                 << tr("Protocol") << tr("Calls") << tr("Accepted")
+                                 << tr("Self ms") << tr("Total ms") << tr("Self " UTF8_MICRO_SIGN "s/Call")
+                                 << tr("Self Bytes") << tr("Total Bytes"));
+    stats_tree_->headerItem()->setToolTip(col_self_ms_, tr("Time spent in the protocol's dissectors, excluding the dissectors they called."));
+    stats_tree_->headerItem()->setToolTip(col_total_ms_, tr("Time spent in the protocol's dissectors, including the dissectors they called."));
+    stats_tree_->setSortingEnabled(true);
+    stats_tree_->sortByColumn(col_self_ms_, Qt::DescendingOrder);
+    main_layout->addWidget(stats_tree_);
+
+    QDialogButtonBox *button_box = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    retap_button_ = button_box->addButton(tr("Redissect"), QDialogButtonBox::ActionRole);
+    retap_button_->setToolTip(tr("Reset the counters and dissect all packets again."));
+    refresh_button_ = button_box->addButton(tr("Refresh"), QDialogButtonBox::ActionRole);
+    refresh_button_->setToolTip(tr("Show the counters gathered so far."));
+    reset_button_ = button_box->addButton(tr("Reset"), QDialogButtonBox::ResetRole);
+    reset_button_->setToolTip(tr("Discard the counters gathered so far."));
+    main_layout->addWidget(button_box);
+
+    connect(button_box, &QDialogButtonBox::rejected, this, &DissectorPerfDialog::reject);
+    connect(retap_button_, &QPushButton::clicked, this, &DissectorPerfDialog::retapPackets);
+    connect(refresh_button_, &QPushButton::clicked, this, &DissectorPerfDialog::updateStats);
+    connect(reset_button_, &QPushButton::clicked, this, &DissectorPerfDialog::resetStats);
+
+    dissector_perf_enable(true);
+    registerTapListener("frame", this, NULL, TL_REQUIRES_NOTHING, tapReset, NULL, tapDraw);
+
+    QTimer::singleShot(0, this, SLOT(retapPackets()));
+}
+
+DissectorPerfDialog::~DissectorPerfDialog()
+{
+    dissector_perf_enable(false);
+}
+
+void DissectorPerfDialog::updateWidgets()
+{
+    bool idle = !file_closed_ && retapDepth() < 1;
+
+    retap_button_->setEnabled(idle);
+    reset_button_->setEnabled(retapDepth() < 1);
+
+    WiresharkDialog::updateWidgets();
+}
+
+void DissectorPerfDialog::retapPackets()
+{
+    if (file_closed_) {
+        return;
+    }
+    cap_file_.retapPackets();
+}
+
+void DissectorPerfDialog::resetStats()
+{
+    dissector_perf_reset();
+    updateStats();
+}
+
+void DissectorPerfDialog::updateStats()
+{
+    GPtrArray *stats = dissector_perf_get_stats();
+
+    stats_tree_->setSortingEnabled(false);
+    stats_tree_->clear();
+    for (unsigned i = 0; i < stats->len; i++) {
+        const dissector_perf_t *perf = (const dissector_perf_t *)g_ptr_array_index(stats, i);
+        double self_ms = perf->self_ns / 1000000.0;
+        double total_ms = perf->total_ns / 1000000.0;
+        double us_per_call = perf->calls ? perf->self_ns / 1000.0 / perf->calls : 0.0;
+
+        QTreeWidgetItem *ti = new DissectorPerfTreeWidgetItem(stats_tree_);
+        ti->setText(col_protocol_, proto_get_protocol_short_name(find_protocol_by_id(perf->proto_id)));
+        ti->setToolTip(col_protocol_, proto_get_protocol_long_name(find_protocol_by_id(perf->proto_id)));
+        ti->setText(col_calls_, QString::number(perf->calls));
+        ti->setData(col_calls_, Qt::UserRole, (double)perf->calls);
+        ti->setText(col_accepted_, QString::number(perf->accepted));
+        ti->setData(col_accepted_, Qt::UserRole, (double)perf->accepted);
+        ti->setText(col_self_ms_, QString::number(self_ms, 'f', 3));
+        ti->setData(col_self_ms_, Qt::UserRole, self_ms);
+        ti->setText(col_total_ms_, QString::number(total_ms, 'f', 3));
+        ti->setData(col_total_ms_, Qt::UserRole, total_ms);
+        ti->setText(col_us_per_call_, QString::number(us_per_call, 'f', 3));
+        ti->setData(col_us_per_call_, Qt::UserRole, us_per_call);
+        ti->setText(col_self_bytes_, QString::number(perf->self_bytes));
+        ti->setData(col_self_bytes_, Qt::UserRole, (double)perf->self_bytes);
+        ti->setText(col_total_bytes_, QString::number(perf->total_bytes));
+        ti->setData(col_total_bytes_, Qt::UserRole, (double)perf->total_bytes);
+        for (int col = col_calls_; col <= col_total_bytes_; col++) {
+            ti->setTextAlignment(col, Qt::AlignRight);
+        }
+    }
+    g_ptr_array_unref(stats);
+    stats_tree_->setSortingEnabled(true);
+
+    for (int col = 0; col < stats_tree_->columnCount(); col++) {
+        stats_tree_->resizeColumnToContents(col);
+    }
+}
+
+void DissectorPerfDialog::tapReset(void *tapdata)
+{
+    Q_UNUSED(tapdata)
+    dissector_perf_reset();
+}
+
+void DissectorPerfDialog::tapDraw(void *tapdata)
+{
+    DissectorPerfDialog *dialog = static_cast<DissectorPerfDialog *>(tapdata);
+    if (dialog) {
+        dialog->updateStats();
+    }
+}
@@ -0,0 +1,49 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef DISSECTOR_PERF_DIALOG_H
+#define DISSECTOR_PERF_DIALOG_H
+
+#include "wireshark_dialog.h"
+
+class QPushButton;
+class QTreeWidget;
+
+/**
+ * @brief Shows the time and packet scope memory each protocol's
+ * dissectors used while the packets were dissected.
+ *
+ * Dissector profiling is turned on for as long as the dialog is open.
+ */
+class DissectorPerfDialog : public WiresharkDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DissectorPerfDialog(QWidget &parent, CaptureFile &cf);
+    ~DissectorPerfDialog();
+
+private slots:
+    void retapPackets();
+    void updateStats();
+    void resetStats();
+
+private:
+    QTreeWidget *stats_tree_;
+    QPushButton *retap_button_;
+    QPushButton *refresh_button_;
+    QPushButton *reset_button_;
+
+    void updateWidgets() override;
+
+    static void tapReset(void *tapdata);
+    static void tapDraw(void *tapdata);
+};
+
+#endif // DISSECTOR_PERF_DIALOG_H
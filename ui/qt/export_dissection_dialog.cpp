@@ -35,6 +35,43 @@ static const QStringList export_extensions = QStringList()
     << "c"
     << "json";
 
+ExportDissectionJob::ExportDissectionJob(QObject *parent, cf_export_job_t *job, const QString &file_name) :
+    QObject(parent),
+    job_(job),
+    file_name_(file_name)
+{
+    connect(&poll_timer_, &QTimer::timeout, this, &ExportDissectionJob::poll);
+    poll_timer_.start(200);
+}
+
+ExportDissectionJob::~ExportDissectionJob()
+{
+    if (job_) {
+        cf_export_job_cancel(job_);
+        cf_export_job_finish(job_);
+    }
+}
+
+void ExportDissectionJob::poll()
+{
+    unsigned done, total;
+
+    if (cf_export_job_poll(job_, &done, &total)) {
+        mainApp->pushStatus(MainApplication::TemporaryStatus,
+                            tr("Exporting to %1: %2 of %3 packets").arg(file_name_).arg(done).arg(total));
+        return;
+    }
+
+    poll_timer_.stop();
+    // Any error has been reported by the time this returns.
+    if (cf_export_job_finish(job_) == CF_PRINT_OK) {
+        mainApp->pushStatus(MainApplication::TemporaryStatus,
+                            tr("Exported %1 packets to %2").arg(done).arg(file_name_));
+    }
+    job_ = nullptr;
+    deleteLater();
+}
+
 ExportDissectionDialog::ExportDissectionDialog(QWidget *parent, capture_file *cap_file, export_type_e export_type, QString selRange):
     WiresharkFileDialog(parent),
     export_type_(export_type),
@@ -153,6 +190,10 @@ void ExportDissectionDialog::dialogAccepted(const QStringList &selected)
 
         packet_format_stack_->updatePrintArgs(print_args_);
 
+        if (startBackgroundExport()) {
+            return;
+        }
+
         switch (export_type_) {
         case export_type_text:      /* Text */
             print_args_.stream = print_stream_text_new(true, print_args_.file);
@@ -199,6 +240,62 @@ void ExportDissectionDialog::dialogAccepted(const QStringList &selected)
     }
 }
 
+// Start exporting on other threads, so that the GUI can be used, and other
+// exports started, in the meantime. Returns false if the export hasn't
+// been started and hasn't failed, so the caller should do it here.
+bool ExportDissectionDialog::startBackgroundExport()
+{
+    cf_export_format_e format;
+
+    switch (export_type_) {
+    case export_type_csv:
+        format = CF_EXPORT_CSV;
+        break;
+    case export_type_carrays:
+        format = CF_EXPORT_CARRAYS;
+        break;
+    case export_type_psml:
+        format = CF_EXPORT_PSML;
+        break;
+    case export_type_pdml:
+        format = CF_EXPORT_PDML;
+        break;
+    case export_type_json:
+        format = CF_EXPORT_JSON;
+        break;
+    default:
+        // Text goes through a print stream, which is still written here.
+        return false;
+    }
+
+    if (!cf_can_export_in_background(cap_file_)) {
+        return false;
+    }
+
+    cf_print_status_t status;
+    cf_export_job_t *job = cf_export_job_start(cap_file_, format, &print_args_, &status);
+    if (!job) {
+        switch (status) {
+        case CF_PRINT_OK:
+            return false;
+        case CF_PRINT_OPEN_ERROR:
+            report_open_failure(print_args_.file, errno, true);
+            break;
+        case CF_PRINT_WRITE_ERROR:
+            report_write_failure(print_args_.file, errno);
+            break;
+        }
+    } else {
+        new ExportDissectionJob(mainApp, job, gchar_free_to_qstring(g_path_get_basename(print_args_.file)));
+    }
+
+    char *dirname;
+    /* Save the directory name for future file dialogs. */
+    dirname = get_dirname(print_args_.file);  /* Overwrites file_name data */
+    set_last_open_dir(dirname);
+    return true;
+}
+
 void ExportDissectionDialog::exportTypeChanged(QString name_filter)
 {
     export_type_ = export_type_map_.value(name_filter);
@@ -22,6 +22,26 @@
 #include "packet_format_stack.h"
 
 #include <QMap>
+#include <QTimer>
+
+// Keeps a background export going, and shows its progress, after the
+// dialog that started it is gone.
+class ExportDissectionJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ExportDissectionJob(QObject *parent, cf_export_job_t *job, const QString &file_name);
+    ~ExportDissectionJob();
+
+private slots:
+    void poll();
+
+private:
+    cf_export_job_t *job_;
+    QString file_name_;
+    QTimer poll_timer_;
+};
 
 class ExportDissectionDialog : public WiresharkFileDialog
 {
@@ -56,6 +76,7 @@ private:
     QPushButton *save_bt_;
 
     bool isValid();
+    bool startBackgroundExport();
 };
 
 #endif // EXPORT_DISSECTION_DIALOG_H
@@ -170,6 +170,7 @@ void ExportObjectDialog::show()
 
     QDialog::show();
     cap_file_.retapPackets();
+    model_.spillObjectEntries();
     eo_ui_->progressFrame->hide();
     for (int i = 0; i < eo_ui_->objectTree->model()->columnCount(); i++)
         eo_ui_->objectTree->resizeColumnToContents(i);
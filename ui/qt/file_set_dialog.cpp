@@ -57,7 +57,8 @@ FileSetDialog::FileSetDialog(QWidget *parent) :
     GeometryStateDialog(parent),
     fs_ui_(new Ui::FileSetDialog),
     fileset_entry_model_(new FilesetEntryModel(this)),
-    close_button_(NULL)
+    close_button_(NULL),
+    open_all_button_(NULL)
 {
     fs_ui_->setupUi(this);
     loadGeometry ();
@@ -67,6 +68,10 @@ FileSetDialog::FileSetDialog(QWidget *parent) :
     fs_ui_->fileSetTree->setFocus();
 
     close_button_ = fs_ui_->buttonBox->button(QDialogButtonBox::Close);
+    open_all_button_ = fs_ui_->buttonBox->addButton(tr("Open All"), QDialogButtonBox::ActionRole);
+    open_all_button_->setToolTip(tr("Open every file in the set as one capture, in order."));
+    open_all_button_->setEnabled(false);
+    connect(open_all_button_, &QPushButton::clicked, this, &FileSetDialog::openAllFiles);
 
     connect(fs_ui_->fileSetTree->selectionModel(), &QItemSelectionModel::selectionChanged,
             this, &FileSetDialog::selectionChanged);
@@ -133,6 +138,8 @@ void FileSetDialog::endAddFile()
 
     if (close_button_)
         close_button_->setEnabled(true);
+    if (open_all_button_)
+        open_all_button_->setEnabled(fileset_entry_model_->entryCount() > 1);
 }
 
 void FileSetDialog::selectionChanged(const QItemSelection &selected, const QItemSelection &)
@@ -149,6 +156,20 @@ void FileSetDialog::selectionChanged(const QItemSelection &selected, const QItem
     }
 }
 
+// The set is sorted by name, which for ring buffers and other file sets
+// is the order in which the files were written.
+void FileSetDialog::openAllFiles()
+{
+    QStringList cf_paths;
+
+    for (int row = 0; row < fileset_entry_model_->entryCount(); row++) {
+        cf_paths << fileset_entry_model_->getRowEntry(row)->fullname;
+    }
+    if (cf_paths.size() > 1) {
+        emit fileSetOpenCaptureFiles(cf_paths);
+    }
+}
+
 void FileSetDialog::on_buttonBox_helpRequested()
 {
     mainApp->helpTopicAction(HELP_FILESET_DIALOG);
@@ -41,15 +41,18 @@ public:
 
 signals:
     void fileSetOpenCaptureFile(QString);
+    void fileSetOpenCaptureFiles(QStringList);
 
 private slots:
     void selectionChanged(const QItemSelection &selected, const QItemSelection &);
     void on_buttonBox_helpRequested();
+    void openAllFiles();
 
 private:
     Ui::FileSetDialog *fs_ui_;
     FilesetEntryModel *fileset_entry_model_;
     QPushButton *close_button_;
+    QPushButton *open_all_button_;
     int cur_idx_;
 };
 
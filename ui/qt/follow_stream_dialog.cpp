@@ -1191,6 +1191,7 @@ void FollowStreamDialog::readFollowStream()
     isReadRunning = true;
     loop_break_mutex.unlock();
 
+    ui->teStreamContent->beginBulkInsert();
     for (cur = g_list_last(follow_info_.payload); cur; cur = g_list_previous(cur)) {
         if (dialogClosed() || !isReadRunning) break;
 
@@ -1221,12 +1222,16 @@ void FollowStreamDialog::readFollowStream()
                     follow_record->abs_ts,
                     global_pos);
             if (elapsed_timer.elapsed() > info_update_freq_) {
+                // Lay out what we have so far so that it can be shown.
+                ui->teStreamContent->endBulkInsert();
                 fillHintLabel(ui->teStreamContent->currentPacket());
                 mainApp->processEvents();
+                ui->teStreamContent->beginBulkInsert();
                 elapsed_timer.start();
             }
         }
     }
+    ui->teStreamContent->endBulkInsert();
 
     loop_break_mutex.lock();
     isReadRunning = false;
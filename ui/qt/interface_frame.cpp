@@ -56,6 +56,8 @@
 
 #ifdef HAVE_LIBPCAP
 const int stat_update_interval_ = 1000; // ms
+// How soon to look again if dumpcap's report is late.
+const int stat_retry_interval_ = 200; // ms
 #endif
 const char *no_capture_link = "#no_capture";
 
@@ -526,6 +528,7 @@ void InterfaceFrame::updateStatistics(void)
         return;
 
 #ifdef HAVE_LIBPCAP
+    QList<int> rows;
 
     for (int idx = 0; idx < source_model_.rowCount(); idx++)
     {
@@ -533,8 +536,14 @@ void InterfaceFrame::updateStatistics(void)
 
         /* Proxy model has not masked out the interface */
         if (selectIndex.isValid())
-            source_model_.updateStatistic(idx);
+            rows << idx;
     }
+
+    // Follow dumpcap's reports instead of adding a point of no traffic
+    // whenever our timer gets ahead of them.
+    bool updated = source_model_.updateStatistics(rows);
+    if (stat_timer_)
+        stat_timer_->setInterval(updated ? stat_update_interval_ : stat_retry_interval_);
 #endif
 }
 
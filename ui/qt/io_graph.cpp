@@ -41,7 +41,10 @@ IOGraph::IOGraph(QCustomPlot* parent, const char* type_unit_name) :
     interval_(0),
     asAOT_(false),
     type_unit_name_(type_unit_name),
-    cur_idx_(-1)
+    cur_idx_(-1),
+    tap_interval_(0),
+    view_interval_(0),
+    view_dirty_(false)
 {
     GString* error_string;
     error_string = register_tap_listener("frame",
@@ -304,14 +307,15 @@ nstime_t IOGraph::startTime() const
 int IOGraph::packetFromTime(double ts) const
 {
     int idx = ts * SCALE_F / interval_;
-    if (idx >= 0 && idx <= cur_idx_) {
+    if (idx >= 0 && idx <= viewIdx()) {
+        const io_graph_item_t* items = viewItems();
         switch (val_units_) {
         case IOG_ITEM_UNIT_CALC_MAX:
-            return items_[idx].max_frame_in_invl;
+            return items[idx].max_frame_in_invl;
         case IOG_ITEM_UNIT_CALC_MIN:
-            return items_[idx].min_frame_in_invl;
+            return items[idx].min_frame_in_invl;
         default:
-            return items_[idx].last_frame_in_invl;
+            return items[idx].last_frame_in_invl;
         }
     }
     return -1;
@@ -323,10 +327,68 @@ void IOGraph::clearAllData()
     if (items_.size()) {
         reset_io_graph_items(&items_[0], items_.size(), hf_index_);
     }
+    // Whatever gets tapped next is tapped at the current interval.
+    tap_interval_ = interval_;
+    view_items_.clear();
+    view_interval_ = 0;
+    view_dirty_ = false;
     nstime_set_zero(&start_time_);
+    decimator_.clear();
     Graph::clearAllData();
 }
 
+// The items for the current interval: the tapped ones, or the tapped ones
+// rolled up.
+const io_graph_item_t* IOGraph::viewItems() const
+{
+    if (interval_ == tap_interval_ || view_items_.empty()) {
+        return items_.empty() ? NULL : &items_[0];
+    }
+    return &view_items_[0];
+}
+
+int IOGraph::viewIdx() const
+{
+    if (cur_idx_ < 0 || interval_ == tap_interval_ || view_items_.empty()) {
+        return cur_idx_;
+    }
+    return cur_idx_ / (interval_ / tap_interval_);
+}
+
+// The start of every interval_ is the start of some tap_interval_ (both
+// count from relative time 0), so rolling up is just merging each run of
+// interval_ / tap_interval_ items.
+void IOGraph::updateView()
+{
+    if (interval_ == tap_interval_ || tap_interval_ <= 0 || interval_ % tap_interval_) {
+        view_items_.clear();
+        view_interval_ = 0;
+        view_dirty_ = false;
+        return;
+    }
+    if (view_interval_ == interval_ && !view_dirty_) {
+        return;
+    }
+
+    size_t factor = interval_ / tap_interval_;
+    size_t count = (cur_idx_ >= 0) ? (size_t)cur_idx_ / factor + 1 : 1;
+    try {
+        view_items_.assign(count, io_graph_item_t());
+    }
+    catch (std::bad_alloc&) {
+        ws_warning("Failed memory allocation!");
+        view_items_.clear();
+        view_interval_ = 0;
+        return;
+    }
+    reset_io_graph_items(&view_items_[0], count, hf_index_);
+    for (int i = 0; i <= cur_idx_; i++) {
+        merge_io_graph_items(&view_items_[i / factor], &items_[i], 1, hf_index_, val_units_);
+    }
+    view_interval_ = interval_;
+    view_dirty_ = false;
+}
+
 void IOGraph::recalcGraphData(capture_file* cap_file)
 {
     /* Moving average variables */
@@ -341,7 +403,10 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
         bars_->data()->clear();
     }
 
-    if (moving_avg_period_ > 0 && cur_idx_ >= 0) {
+    updateView();
+    int cur_idx = viewIdx();
+
+    if (moving_avg_period_ > 0 && cur_idx >= 0) {
         /* "Warm-up phase" - calculate average on some data not displayed;
          * just to make sure average on leftmost and rightmost displayed
          * values is as reliable as possible
@@ -352,7 +417,7 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
         mavg_in_average_count++;
         for (warmup_interval = 1;
             (warmup_interval < moving_avg_period_ / 2) &&
-            (warmup_interval <= (unsigned)cur_idx_);
+            (warmup_interval <= (unsigned)cur_idx);
             warmup_interval += 1) {
 
             mavg_cumulated += getItemValue((int)warmup_interval, cap_file);
@@ -361,8 +426,9 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
         mavg_to_add = warmup_interval;
     }
 
+    QVector<double> keys, values;
     double ts_offset = startOffset();
-    for (int i = 0; i <= cur_idx_; i++) {
+    for (int i = 0; i <= cur_idx; i++) {
         double ts = (double)i * interval_ / SCALE_F + ts_offset;
         double val = getItemValue(i, cap_file);
 
@@ -375,7 +441,7 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
                     mavg_cumulated -= getItemValue(mavg_to_remove, cap_file);
                     mavg_to_remove += 1;
                 }
-                if (mavg_to_add <= (unsigned int)cur_idx_) {
+                if (mavg_to_add <= (unsigned int)cur_idx) {
                     mavg_in_average_count++;
                     mavg_cumulated += getItemValue(mavg_to_add, cap_file);
                     mavg_to_add += 1;
@@ -391,7 +457,8 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
         if (hasItemToShow(i, val))
         {
             if (graph_) {
-                graph_->addData(ts, val);
+                keys.append(ts);
+                values.append(val);
             }
             if (bars_) {
                 bars_->addData(ts, val);
@@ -399,6 +466,13 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
         }
     }
 
+    decimator_.setGraph(graph_);
+    if (graph_) {
+        decimator_.setData(keys, values, true);
+    } else {
+        decimator_.clear();
+    }
+
     emit requestReplot();
 }
 
@@ -519,7 +593,7 @@ bool IOGraph::hasItemToShow(int idx, double value) const
 
     bool result = false;
 
-    const io_graph_item_t* item = &items_[idx];
+    const io_graph_item_t* item = &viewItems()[idx];
 
     switch (val_units_) {
     case IOG_ITEM_UNIT_PACKETS:
@@ -554,12 +628,19 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+// Returns true if the graph has to be retapped to show the new interval,
+// i.e. if it isn't a multiple of the interval the data was tapped at.
+bool IOGraph::setInterval(int interval)
 {
     interval_ = interval;
     if (bars_) {
         bars_->setWidth(interval_ / SCALE_F);
     }
+    if (tap_interval_ <= 0 || interval_ % tap_interval_) {
+        return true;
+    }
+    updateView();
+    return false;
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -567,7 +648,7 @@ double IOGraph::getItemValue(int idx, const capture_file* cap_file) const
 {
     ws_assert(idx < max_io_items_);
 
-    return get_io_graph_item(&items_[0], val_units_, idx, hf_index_, cap_file, interval_, cur_idx_, asAOT_);
+    return get_io_graph_item(viewItems(), val_units_, idx, hf_index_, cap_file, interval_, viewIdx(), asAOT_);
 }
 
 // "tap_reset" callback for register_tap_listener
@@ -588,7 +669,10 @@ tap_packet_status IOGraph::tapPacket(void* iog_ptr, packet_info* pinfo, epan_dis
         return TAP_PACKET_DONT_REDRAW;
     }
 
-    int64_t tmp_idx = get_io_graph_index(pinfo, iog->interval_);
+    if (iog->tap_interval_ <= 0) {
+        iog->tap_interval_ = iog->interval_;
+    }
+    int64_t tmp_idx = get_io_graph_index(pinfo, iog->tap_interval_);
     bool recalc = false;
 
     /* some sanity checks */
@@ -652,9 +736,10 @@ tap_packet_status IOGraph::tapPacket(void* iog_ptr, packet_info* pinfo, epan_dis
         adv_edt = edt;
     }
 
-    if (!update_io_graph_item(&iog->items_[0], idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
+    if (!update_io_graph_item(&iog->items_[0], idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->tap_interval_)) {
         return TAP_PACKET_DONT_REDRAW;
     }
+    iog->view_dirty_ = true;
 
     //    qDebug() << "=tapPacket" << iog->name_ << idx << iog->hf_index_ << iog->val_units_ << iog->num_items_;
 
@@ -19,6 +19,8 @@
 
 #include "wireshark_dialog.h"
 
+#include <ui/qt/widgets/qcp_graph_decimator.h>
+
 #include <vector>
 
 class QCPBars;
@@ -82,11 +84,11 @@ public:
     void setValueUnitField(const QString& vu_field);
     nstime_t startTime() const;
     unsigned int movingAveragePeriod() const { return moving_avg_period_; }
-    void setInterval(int interval);
+    bool setInterval(int interval);
     int packetFromTime(double ts) const;
     bool hasItemToShow(int idx, double value) const;
     double getItemValue(int idx, const capture_file* cap_file) const;
-    int maxInterval() const { return cur_idx_; }
+    int maxInterval() const { return viewIdx(); }
 
     void clearAllData();
 
@@ -110,6 +112,10 @@ private:
 
     void removeTapListener();
 
+    const io_graph_item_t* viewItems() const;
+    int viewIdx() const;
+    void updateView();
+
     bool showsZero() const;
     double startOffset() const;
 
@@ -131,8 +137,18 @@ private:
 
     // Cached data. We should be able to change the Y axis without retapping as
     // much as is feasible.
+    // items_ holds what was tapped, at tap_interval_. When interval_ is
+    // a multiple of that, view_items_ holds items_ rolled up to interval_,
+    // so the interval can be made coarser (and fine again, down to
+    // tap_interval_) without retapping.
     std::vector<io_graph_item_t> items_;
     int cur_idx_;
+    int tap_interval_;
+    std::vector<io_graph_item_t> view_items_;
+    int view_interval_;
+    bool view_dirty_;
+    // Small intervals over long captures give more points than pixels.
+    QCPGraphDecimator decimator_;
 };
 
 #endif // IO_GRAPH_H
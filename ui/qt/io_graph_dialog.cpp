@@ -28,6 +28,7 @@
 #include <ui/qt/utils/variant_pointer.h>
 #include <ui/qt/utils/color_utils.h>
 #include <ui/qt/utils/tango_colors.h> //provides some default colors
+#include <ui/qt/widgets/customplot.h>
 #include <ui/qt/widgets/qcustomplot.h>
 #include <ui/qt/widgets/qcp_string_legend_item.h>
 #include <ui/qt/widgets/qcp_axis_ticker_si.h>
@@ -362,7 +363,9 @@ IOGraphDialog::IOGraphDialog(QWidget &parent, CaptureFile &cf, const char* type_
     iop->setMouseTracking(true);
     iop->setEnabled(true);
 
+    CustomPlot::setupRendering(iop);
     tracer_ = new QCPItemTracer(iop);
+    CustomPlot::addToOverlay(tracer_);
 }
 
 void IOGraphDialog::initialize(QWidget& parent, uat_field_t* io_graph_fields, QString displayFilter, io_graph_item_unit_t value_units, QString yfield, bool is_sibling_dialog, const QVector<QString> convFilters)
@@ -1016,7 +1019,7 @@ QString IOGraphDialog::getHintText(unsigned num_items) const
         .arg(num_items);
 }
 
-void IOGraphDialog::updateHint()
+void IOGraphDialog::updateHint(bool tracer_moved)
 {
     QCustomPlot *iop = ui->ioPlot;
     QString hint;
@@ -1055,7 +1058,11 @@ void IOGraphDialog::updateHint()
                     .arg(QString::number(ts, 'f', precision_))
                     .arg(val);
         }
-        iop->replot(QCustomPlot::rpQueuedReplot);
+        if (tracer_moved) {
+            CustomPlot::replotOverlay(iop);
+        } else {
+            iop->replot(QCustomPlot::rpQueuedReplot);
+        }
     } else {
         if (rubber_band_ && rubber_band_->isVisible()) {
             QRectF zoom_ranges = getZoomRanges(rubber_band_->geometry());
@@ -1303,7 +1310,7 @@ void IOGraphDialog::mouseMoved(QMouseEvent *event)
         }
     }
 
-    updateHint();
+    updateHint(true);
 }
 
 void IOGraphDialog::mouseReleased(QMouseEvent *event)
@@ -1393,8 +1400,8 @@ void IOGraphDialog::selectedFrameChanged(QList<int> frames)
 #endif
             double key = nstime_to_sec(&pinfo->rel_ts) - (interval / (2 * SCALE_F)) + nstime_to_sec(&start_time_);
             tracer_->setGraphKey(key);
-            ui->ioPlot->replot();
-            updateHint();
+            CustomPlot::replotOverlay(ui->ioPlot);
+            updateHint(true);
         }
     }
 }
@@ -1511,6 +1518,7 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 {
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
     bool need_retap = false;
+    bool need_recalc = false;
 
     precision_ = ceil(log10(SCALE_F / interval));
     if (precision_ < 0) {
@@ -1532,8 +1540,11 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
-                iog->setInterval(interval);
-                if (iog->visible()) {
+                // Coarser multiples of the tapped interval are rolled up
+                // from the tapped data.
+                if (!iog->setInterval(interval)) {
+                    need_recalc = true;
+                } else if (iog->visible()) {
                     need_retap = true;
                 } else {
                     iog->setNeedRetap(true);
@@ -1544,6 +1555,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else if (need_recalc) {
+        scheduleRecalc(true);
     }
 }
 
@@ -181,7 +181,8 @@ private:
     void panAxes(int x_pixels, int y_pixels);
     void toggleTracerStyle(bool force_default = false);
     void getGraphInfo();
-    void updateHint();
+    // If only the tracer has moved, just the overlay layer is redrawn.
+    void updateHint(bool tracer_moved = false);
     void updateLegend();
     QRectF getZoomRanges(QRect zoom_rect);
     void createIOGraph(int currentRow);
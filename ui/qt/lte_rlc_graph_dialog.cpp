@@ -157,12 +157,14 @@ void LteRlcGraphDialog::completeGraph(bool may_be_empty)
     QCustomPlot *sp = ui->rlcPlot;
     base_graph_ = sp->addGraph(); // All: Selectable segments
     base_graph_->setPen(QPen(QBrush(Qt::black), 0.25));
+    base_decimator_.setGraph(base_graph_);
 
     reseg_graph_ = sp->addGraph();
     reseg_graph_->setPen(QPen(QBrush(Qt::lightGray), 0.25));
 
     acks_graph_ = sp->addGraph();
     acks_graph_->setPen(QPen(QBrush(graph_color_ack), 1.0));
+    acks_decimator_.setGraph(acks_graph_);
 
     nacks_graph_ = sp->addGraph();
     nacks_graph_->setPen(QPen(QBrush(graph_color_nack), 0.25));
@@ -321,9 +323,9 @@ void LteRlcGraphDialog::fillGraph()
 
     // Add the data from the graphs.
     // N.B. passing true to assume the timestamps are already sorted..
-    base_graph_->setData(seq_time, seq, true);
+    base_decimator_.setData(seq_time, seq, true);
     reseg_graph_->setData(reseg_seq_time, reseg_seq, true);
-    acks_graph_->setData(acks_time, acks, true);
+    acks_decimator_.setData(acks_time, acks, true);
     nacks_graph_->setData(nacks_time, nacks, true);
 
     sp->setEnabled(true);
@@ -14,6 +14,7 @@
 #include <ui/tap-rlc-graph.h>
 
 #include <ui/qt/widgets/qcustomplot.h>
+#include <ui/qt/widgets/qcp_graph_decimator.h>
 
 class QMenu;
 class QRubberBand;
@@ -62,6 +63,8 @@ private:
     QCPGraph *reseg_graph_;
     QCPGraph *acks_graph_;
     QCPGraph *nacks_graph_;
+    QCPGraphDecimator base_decimator_;
+    QCPGraphDecimator acks_decimator_;
     QCPItemTracer *tracer_;
     uint32_t packet_num_;
 
@@ -23,6 +23,8 @@
 #include <ui/qt/models/atap_data_model.h>
 #include <ui/qt/models/timeline_delegate.h>
 
+#include <cmath>
+
 #include <QSize>
 #include <QVariant>
 #include <QWidget>
@@ -43,6 +45,8 @@ ATapDataModel::ATapDataModel(dataModelType type, int protoId, QString filter, QO
     hash_.user_data = this;
 
     storage_ = nullptr;
+    _rowCount = 0;
+    _sortKeysColumn = -1;
     _resolveNames = false;
     _absoluteTime = false;
     _nanoseconds = false;
@@ -181,7 +185,7 @@ void ATapDataModel::limitToDisplayFilter(bool limit)
 
 int ATapDataModel::rowCount(const QModelIndex &parent) const
 {
-    return (storage_ && !parent.isValid()) ? (int) storage_->len : 0;
+    return !parent.isValid() ? _rowCount : 0;
 }
 
 void ATapDataModel::tapReset(void *tapdata) {
@@ -238,6 +242,8 @@ void ATapDataModel::resetData()
 
     beginResetModel();
     storage_ = nullptr;
+    _rowCount = 0;
+    invalidateSortKeys();
     if (_type == ATapDataModel::DATAMODEL_ENDPOINT)
         reset_endpoint_table_data(&hash_);
     else if (_type == ATapDataModel::DATAMODEL_CONVERSATION)
@@ -254,12 +260,35 @@ void ATapDataModel::updateData(GArray * newData)
     if (_disableTap)
         return;
 
-    emit layoutAboutToBeChanged();
-    storage_ = newData;
-    emit layoutChanged();
+    invalidateSortKeys();
+    int newCount = newData ? (int) newData->len : 0;
+    int firstNewRow = _rowCount;
+    if (newData != storage_ || newCount < _rowCount) {
+        firstNewRow = 0;
+        beginResetModel();
+        storage_ = newData;
+        _rowCount = newCount;
+        endResetModel();
+    } else {
+        // The tap only ever appends rows and updates counters, so tell
+        // views just that rather than having them relayout everything.
+        int oldCount = _rowCount;
+        if (newCount > oldCount) {
+            beginInsertRows(QModelIndex(), oldCount, newCount - 1);
+            _rowCount = newCount;
+            endInsertRows();
+        }
+        if (oldCount > 0) {
+            emit dataChanged(index(0, 0), index(oldCount - 1, columnCount() - 1));
+        }
+    }
 
     if (_type == ATapDataModel::DATAMODEL_CONVERSATION)
         ((ConversationDataModel *)(this))->doDataUpdate();
+#ifdef HAVE_MAXMINDDB
+    else if (_type == ATapDataModel::DATAMODEL_ENDPOINT)
+        ((EndpointDataModel *)(this))->requestGeoIPData(firstNewRow);
+#endif
 }
 
 bool ATapDataModel::resolveNames() const
@@ -315,6 +344,32 @@ QString ATapDataModel::filter() const
     return _filter;
 }
 
+void ATapDataModel::invalidateSortKeys()
+{
+    _sortKeysColumn = -1;
+    _sortKeys.clear();
+}
+
+bool ATapDataModel::lessThanByKey(int rowA, int rowB, int column, bool *less) const
+{
+    if (rowA < 0 || rowB < 0 || rowA >= _rowCount || rowB >= _rowCount)
+        return false;
+
+    if (column != _sortKeysColumn || _sortKeys.size() != (size_t) _rowCount) {
+        double key;
+        if (!sortKey(0, column, &key))
+            return false;
+
+        _sortKeys.resize(_rowCount);
+        for (int row = 0; row < _rowCount; row++)
+            sortKey(row, column, &_sortKeys[row]);
+        _sortKeysColumn = column;
+    }
+
+    *less = _sortKeys[rowA] < _sortKeys[rowB];
+    return true;
+}
+
 ATapDataModel::dataModelType ATapDataModel::modelType() const
 {
     return _type;
@@ -347,6 +402,25 @@ int EndpointDataModel::columnCount(const QModelIndex &) const
     return ENDP_NUM_COLUMNS;
 }
 
+#ifdef HAVE_MAXMINDDB
+void EndpointDataModel::requestGeoIPData(int firstRow)
+{
+    if (!storage_ || columnCount() <= ENDP_NUM_COLUMNS)
+        return;
+
+    // Results arrive asynchronously and refresh the views via
+    // addressResolutionChanged, same as lookups made from data().
+    for (int row = firstRow; row < _rowCount; row++) {
+        endpoint_item_t *item = &g_array_index(storage_, endpoint_item_t, row);
+        if (item->myaddress.type == AT_IPv4) {
+            maxmind_db_lookup_ipv4((const ws_in4_addr *) item->myaddress.data);
+        } else if (item->myaddress.type == AT_IPv6) {
+            maxmind_db_lookup_ipv6((const ws_in6_addr *) item->myaddress.data);
+        }
+    }
+}
+#endif
+
 QVariant EndpointDataModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (orientation == Qt::Vertical)
@@ -566,12 +640,60 @@ QVariant EndpointDataModel::data(const QModelIndex &idx, int role) const
     return QVariant();
 }
 
+bool EndpointDataModel::sortKey(int row, int column, double *key) const
+{
+    const endpoint_item_t *item = &g_array_index(storage_, endpoint_item_t, row);
+
+    switch (column) {
+    case ENDP_COLUMN_PORT:
+        if (_resolveNames)
+            return false;
+        *key = item->port;
+        return true;
+    case ENDP_COLUMN_PACKETS:
+        *key = (double)(item->tx_frames + item->rx_frames);
+        return true;
+    case ENDP_COLUMN_BYTES:
+        *key = (double)(item->tx_bytes + item->rx_bytes);
+        return true;
+    case ENDP_COLUMN_PACKETS_TOTAL:
+        *key = showTotalColumn() ? (double)(item->tx_frames_total + item->rx_frames_total) : 0;
+        return true;
+    case ENDP_COLUMN_BYTES_TOTAL:
+    {
+        double percent = 0;
+        if (showTotalColumn()) {
+            double totalPackets = (double)(item->tx_frames_total + item->rx_frames_total);
+            percent = totalPackets == 0 ? 0 : (double)(item->tx_frames + item->rx_frames) * 100 / totalPackets;
+        }
+        /* Match the rounding of the value shown and filtered on. */
+        *key = std::round(percent * 100) / 100;
+        return true;
+    }
+    case ENDP_COLUMN_PKT_AB:
+        *key = (double)item->tx_frames;
+        return true;
+    case ENDP_COLUMN_BYTES_AB:
+        *key = (double)item->tx_bytes;
+        return true;
+    case ENDP_COLUMN_PKT_BA:
+        *key = (double)item->rx_frames;
+        return true;
+    case ENDP_COLUMN_BYTES_BA:
+        *key = (double)item->rx_bytes;
+        return true;
+    default:
+        return false;
+    }
+}
+
 void EndpointDataModel::setResolveNames(bool resolve)
 {
     if (_resolveNames == resolve)
         return;
 
     _resolveNames = resolve;
+    invalidateSortKeys();
     if (rowCount() > 0) {
         dataChanged(index(0, ENDP_COLUMN_ADDR), index(rowCount() - 1, ENDP_COLUMN_PORT));
     }
@@ -907,6 +1029,80 @@ QVariant ConversationDataModel::data(const QModelIndex &idx, int role) const
     return QVariant();
 }
 
+bool ConversationDataModel::sortKey(int row, int column, double *key) const
+{
+    const conv_item_t *conv_item = &g_array_index(storage_, conv_item_t, row);
+    double duration = nstime_to_sec(&conv_item->stop_time) - nstime_to_sec(&conv_item->start_time);
+
+    switch (column) {
+    case CONV_COLUMN_SRC_PORT:
+        if (_resolveNames)
+            return false;
+        *key = conv_item->src_port;
+        return true;
+    case CONV_COLUMN_DST_PORT:
+        if (_resolveNames)
+            return false;
+        *key = conv_item->dst_port;
+        return true;
+    case CONV_COLUMN_PACKETS:
+        *key = (double)(conv_item->tx_frames + conv_item->rx_frames);
+        return true;
+    case CONV_COLUMN_BYTES:
+        *key = (double)(conv_item->tx_bytes + conv_item->rx_bytes);
+        return true;
+    case CONV_COLUMN_CONV_ID:
+        /* Rows without an ID have no value and sort first. */
+        *key = conv_item->conv_id != CONV_ID_UNSET ? (double)conv_item->conv_id : -1;
+        return true;
+    case CONV_COLUMN_PACKETS_TOTAL:
+        *key = showTotalColumn() ? (double)(conv_item->tx_frames_total + conv_item->rx_frames_total) : 0;
+        return true;
+    case CONV_COLUMN_BYTES_TOTAL:
+    {
+        double percent = 0;
+        if (showTotalColumn()) {
+            double totalPackets = (double)(conv_item->tx_frames_total + conv_item->rx_frames_total);
+            percent = totalPackets == 0 ? 0 : (double)(conv_item->tx_frames + conv_item->rx_frames) * 100 / totalPackets;
+        }
+        /* Match the rounding of the value shown and filtered on. */
+        *key = std::round(percent * 100) / 100;
+        return true;
+    }
+    case CONV_COLUMN_PKT_AB:
+        *key = (double)conv_item->tx_frames;
+        return true;
+    case CONV_COLUMN_BYTES_AB:
+        *key = (double)conv_item->tx_bytes;
+        return true;
+    case CONV_COLUMN_PKT_BA:
+        *key = (double)conv_item->rx_frames;
+        return true;
+    case CONV_COLUMN_BYTES_BA:
+        *key = (double)conv_item->rx_bytes;
+        return true;
+    case CONV_COLUMN_START:
+        *key = _absoluteTime ? nstime_to_sec(&conv_item->start_abs_time) : nstime_to_sec(&conv_item->start_time);
+        return true;
+    case CONV_COLUMN_DURATION:
+        *key = duration;
+        return true;
+    case CONV_COLUMN_BPS_AB:
+        *key = duration > min_bw_calc_duration_ ? (double)(qlonglong)(conv_item->tx_bytes * 8 / duration) : -1;
+        return true;
+    case CONV_COLUMN_BPS_BA:
+        *key = duration > min_bw_calc_duration_ ? (double)(qlonglong)(conv_item->rx_bytes * 8 / duration) : -1;
+        return true;
+    case CONV_TCP_EXT_COLUMN_A:
+        if (tap() != "tcp")
+            return false;
+        *key = (double)conv_item->ext_tcp.flows;
+        return true;
+    default:
+        return false;
+    }
+}
+
 conv_item_t * ConversationDataModel::itemForRow(int row)
 {
     if (row < 0 || row >= rowCount())
@@ -916,7 +1112,7 @@ conv_item_t * ConversationDataModel::itemForRow(int row)
 
 bool ConversationDataModel::showConversationId(int row) const
 {
-    if (!storage_ || row < 0 || row >= (int) storage_->len)
+    if (!storage_ || row < 0 || row >= _rowCount)
         return false;
 
     conv_item_t *conv_item = (conv_item_t *)&g_array_index(storage_, conv_item_t, row);
@@ -935,6 +1131,7 @@ void ConversationDataModel::setResolveNames(bool resolve)
         return;
 
     _resolveNames = resolve;
+    invalidateSortKeys();
     if (rowCount() > 0) {
         dataChanged(index(0, CONV_COLUMN_SRC_ADDR), index(rowCount() - 1, CONV_COLUMN_DST_PORT));
     }
@@ -946,6 +1143,7 @@ void ConversationDataModel::useAbsoluteTime(bool absolute)
         return;
 
     _absoluteTime = absolute;
+    invalidateSortKeys();
     headerDataChanged(Qt::Horizontal, CONV_COLUMN_START, CONV_COLUMN_START);
     if (rowCount() > 0) {
         dataChanged(index(0, CONV_COLUMN_START), index(rowCount() - 1, CONV_COLUMN_START));
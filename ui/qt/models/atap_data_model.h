@@ -18,6 +18,8 @@
 
 #include <QAbstractListModel>
 
+#include <vector>
+
 /**
  * @brief DataModel for tap user data
  *
@@ -212,6 +214,22 @@ public:
      */
     void updateFlags(unsigned flag);
 
+    /**
+     * @brief Compare two rows by the raw value of a numeric column
+     *
+     * The values of the column are gathered into one array the first time
+     * it is compared on, so sorting a large table doesn't format or box
+     * every value for every comparison.
+     *
+     * @param rowA the first row
+     * @param rowB the second row
+     * @param column the column to compare on
+     * @param less set to whether rowA sorts before rowB
+     * @return true if the column is numeric and less was set, false if the
+     * rows have to be compared on their data
+     */
+    bool lessThanByKey(int rowA, int rowB, int column, bool *less) const;
+
 #ifdef HAVE_MAXMINDDB
     /**
      * @brief Does this model have geoip data available
@@ -235,8 +253,18 @@ protected:
     void resetData();
     void updateData(GArray * data);
 
+    /**
+     * @brief The raw value a numeric column sorts on
+     *
+     * @return false if the column doesn't sort numerically in the
+     * model's current state
+     */
+    virtual bool sortKey(int row, int column, double *key) const = 0;
+    void invalidateSortKeys();
+
     dataModelType _type;
     GArray * storage_;
+    int _rowCount;
     QString _filter;
 
     bool _absoluteTime;
@@ -258,6 +286,9 @@ protected:
 private:
     int _protoId;
 
+    mutable std::vector<double> _sortKeys;
+    mutable int _sortKeysColumn;
+
 };
 
 class EndpointDataModel : public ATapDataModel
@@ -296,6 +327,21 @@ public:
     void setResolveNames(bool resolve) override;
     void useAbsoluteTime(bool absolute) override;
     void useNanosecondTimestamps(bool nanoseconds) override;
+
+#ifdef HAVE_MAXMINDDB
+    /**
+     * @brief Queue GeoIP lookups for all addresses from firstRow on
+     *
+     * The lookups are sent to mmdbresolve in one go instead of one by
+     * one as the rows get painted.
+     *
+     * @param firstRow the first row without a pending lookup
+     */
+    void requestGeoIPData(int firstRow);
+#endif
+
+protected:
+    bool sortKey(int row, int column, double *key) const override;
 };
 
 class ConversationDataModel : public ATapDataModel
@@ -352,6 +398,9 @@ public:
     void setResolveNames(bool resolve) override;
     void useAbsoluteTime(bool absolute) override;
     void useNanosecondTimestamps(bool nanoseconds) override;
+
+protected:
+    bool sortKey(int row, int column, double *key) const override;
 };
 
 #endif // ATAP_DATA_MODEL_H
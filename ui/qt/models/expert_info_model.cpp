@@ -13,7 +13,42 @@
 #include "file.h"
 #include <epan/proto.h>
 
-ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, column_info *cinfo, ExpertPacketItem* parent) :
+ExpertInfoRecords::ExpertInfoRecords() :
+    text_(g_string_chunk_new(64 * 1024))
+{
+}
+
+ExpertInfoRecords::~ExpertInfoRecords()
+{
+    g_string_chunk_free(text_);
+}
+
+unsigned ExpertInfoRecords::append(const expert_info_t& expert_info, column_info *cinfo)
+{
+    Record record;
+
+    record.packet_num = expert_info.packet_num;
+    record.hf_id = expert_info.hf_index;
+    // Many items share a summary ("Previous segment not captured", ...)
+    record.summary = g_string_chunk_insert_const(text_, expert_info.summary);
+    // A packet with several expert infos only needs its Info column once.
+    if (!records_.isEmpty() && records_.last().packet_num == record.packet_num) {
+        record.info = records_.last().info;
+    } else {
+        record.info = g_string_chunk_insert(text_, cinfo ? col_get_text(cinfo, COL_INFO) : "");
+    }
+
+    records_.append(record);
+    return static_cast<unsigned>(records_.size() - 1);
+}
+
+void ExpertInfoRecords::clear()
+{
+    records_.clear();
+    g_string_chunk_clear(text_);
+}
+
+ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, column_info *cinfo, const ExpertInfoRecords *records, ExpertPacketItem* parent) :
     packet_num_(expert_info.packet_num),
     group_(expert_info.group),
     severity_(expert_info.severity),
@@ -21,21 +56,37 @@ ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, column_info
     row_(0),
     protocol_(expert_info.protocol),
     summary_(expert_info.summary),
-    parentItem_(parent)
+    records_(records),
+    parentItem_(parent),
+    summaryRoot_(NULL)
 {
     if (cinfo) {
         info_ = col_get_text(cinfo, COL_INFO);
     }
 }
 
-ExpertPacketItem::~ExpertPacketItem()
+// The record strings live until the next ExpertInfoModel::clear, which
+// also deletes this item, so there's no need to copy them.
+ExpertPacketItem::ExpertPacketItem(const ExpertInfoRecords& records, unsigned record, ExpertPacketItem* parent, int row) :
+    packet_num_(records.packetNum(record)),
+    group_(parent->group_),
+    severity_(parent->severity_),
+    hf_id_(records.hfId(record)),
+    row_(row),
+    protocol_(parent->protocol_),
+    summary_(QByteArray::fromRawData(records.summary(record), static_cast<int>(strlen(records.summary(record))))),
+    info_(QByteArray::fromRawData(records.colInfo(record), static_cast<int>(strlen(records.colInfo(record))))),
+    records_(NULL),
+    parentItem_(parent),
+    summaryRoot_(NULL)
 {
-    for (int row = 0; row < childItems_.count(); row++)
-    {
-        delete childItems_.value(row);
-    }
+}
 
+ExpertPacketItem::~ExpertPacketItem()
+{
+    qDeleteAll(childItems_);
     childItems_.clear();
+    delete summaryRoot_;
 }
 
 QString ExpertPacketItem::groupKey(bool group_by_summary, int severity, int group, QString protocol, int expert_hf)
@@ -62,18 +113,39 @@ void ExpertPacketItem::appendChild(ExpertPacketItem* child, QString hash)
     hashChild_[hash] = child;
 }
 
+void ExpertPacketItem::appendRecord(unsigned record)
+{
+    recordIds_.append(record);
+}
+
 ExpertPacketItem* ExpertPacketItem::child(int row)
 {
-    return childItems_.value(row);
+    if (recordIds_.isEmpty()) {
+        return childItems_.value(row);
+    }
+
+    if (row < 0 || row >= recordIds_.size()) {
+        return NULL;
+    }
+    if (childItems_.size() <= row) {
+        childItems_.resize(recordIds_.size());
+    }
+    if (!childItems_[row]) {
+        childItems_[row] = new ExpertPacketItem(*records_, recordIds_[row], this, row);
+    }
+    return childItems_[row];
 }
 
 ExpertPacketItem* ExpertPacketItem::child(QString hash)
 {
-    return hashChild_[hash];
+    return hashChild_.value(hash);
 }
 
 int ExpertPacketItem::childCount() const
 {
+    if (!recordIds_.isEmpty()) {
+        return static_cast<int>(recordIds_.size());
+    }
     return static_cast<int>(childItems_.count());
 }
 
@@ -87,6 +159,17 @@ ExpertPacketItem* ExpertPacketItem::parentItem()
     return parentItem_;
 }
 
+ExpertPacketItem* ExpertPacketItem::summaryRoot()
+{
+    return summaryRoot_;
+}
+
+void ExpertPacketItem::setSummaryRoot(ExpertPacketItem* summary_root)
+{
+    delete summaryRoot_;
+    summaryRoot_ = summary_root;
+}
+
 
 
 
@@ -109,6 +192,7 @@ void ExpertInfoModel::clear()
 
     eventCounts_.clear();
     delete root_;
+    records_.clear();
     root_ = createRootItem();
 
     endResetModel();
@@ -121,7 +205,7 @@ DIAG_OFF_CAST_AWAY_CONST
     static expert_info_t root_expert = { 0, -1, -1, -1, rootName, (char*)rootName, NULL };
 DIAG_ON_CAST_AWAY_CONST
 
-    return new ExpertPacketItem(root_expert, NULL, NULL);
+    return new ExpertPacketItem(root_expert, NULL, NULL, NULL);
 }
 
 
@@ -152,8 +236,7 @@ QModelIndex ExpertInfoModel::index(int row, int column, const QModelIndex& paren
 
             for (int subrow = 0; subrow < parent_item->childCount(); subrow++) {
                 child_item = parent_item->child(subrow);
-                //summary children are always stored in first child of group
-                grandchild_item = child_item->child(0);
+                grandchild_item = child_item->summaryRoot();
 
                 if (row_count+grandchild_item->childCount() > row) {
                     return createIndex(row, column, grandchild_item->child(row-row_count));
@@ -330,7 +413,7 @@ int ExpertInfoModel::rowCount(const QModelIndex &parent) const
 
             for (int row = 0; row < parent_item->childCount(); row++) {
                 child_item = parent_item->child(row);
-                grandchild_item = child_item->child(0);
+                grandchild_item = child_item->summaryRoot();
                 row_count += grandchild_item->childCount();
             }
 
@@ -357,33 +440,27 @@ void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
 {
     QString groupKey = ExpertPacketItem::groupKey(false, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
     QString summaryKey = ExpertPacketItem::groupKey(true, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
+    column_info *cinfo = &(capture_file_.capFile()->cinfo);
 
     ExpertPacketItem* expert_root = root_->child(groupKey);
     if (expert_root == NULL) {
-        ExpertPacketItem *new_item = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), root_);
-
-        root_->appendChild(new_item, groupKey);
-
-        expert_root = new_item;
+        expert_root = new ExpertPacketItem(expert_info, cinfo, &records_, root_);
+        expert_root->setSummaryRoot(new ExpertPacketItem(expert_info, NULL, &records_, expert_root));
+        root_->appendChild(expert_root, groupKey);
     }
 
-    ExpertPacketItem *expert = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_root);
-    expert_root->appendChild(expert, groupKey);
-
-    //add the summary children off of the first child of the root children
-    ExpertPacketItem* summary_root = expert_root->child(0);
+    unsigned record = records_.append(expert_info, cinfo);
+    expert_root->appendRecord(record);
 
     //make a summary child
+    ExpertPacketItem* summary_root = expert_root->summaryRoot();
     ExpertPacketItem* expert_summary_root = summary_root->child(summaryKey);
     if (expert_summary_root == NULL) {
-        ExpertPacketItem *new_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), summary_root);
-
-        summary_root->appendChild(new_summary, summaryKey);
-        expert_summary_root = new_summary;
+        expert_summary_root = new ExpertPacketItem(expert_info, cinfo, &records_, summary_root);
+        summary_root->appendChild(expert_summary_root, summaryKey);
     }
 
-    ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_summary_root);
-    expert_summary_root->appendChild(expert_summary, summaryKey);
+    expert_summary_root->appendRecord(record);
 }
 
 void ExpertInfoModel::tapReset(void *eid_ptr)
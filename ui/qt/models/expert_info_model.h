@@ -17,6 +17,7 @@
 #include <QAbstractItemModel>
 #include <QList>
 #include <QMap>
+#include <QVector>
 
 #include <ui/qt/capture_file.h>
 
@@ -24,10 +25,41 @@
 #include <epan/tap.h>
 #include <epan/column-utils.h>
 
+/*
+ * Storage for the individual expert infos seen by the tap. There can be
+ * millions of them, so each one is a small fixed-size record. Summaries
+ * are interned and Info column strings are stored once per packet.
+ */
+class ExpertInfoRecords
+{
+public:
+    ExpertInfoRecords();
+    ~ExpertInfoRecords();
+
+    unsigned append(const expert_info_t& expert_info, column_info *cinfo);
+    void clear();
+
+    unsigned packetNum(unsigned record) const { return records_[record].packet_num; }
+    int hfId(unsigned record) const { return records_[record].hf_id; }
+    const char *summary(unsigned record) const { return records_[record].summary; }
+    const char *colInfo(unsigned record) const { return records_[record].info; }
+
+private:
+    struct Record {
+        uint32_t packet_num;
+        int hf_id;
+        const char *summary;
+        const char *info;
+    };
+
+    QVector<Record> records_;
+    GStringChunk *text_;
+};
+
 class ExpertPacketItem
 {
 public:
-    ExpertPacketItem(const expert_info_t& expert_info, column_info *cinfo, ExpertPacketItem* parent);
+    ExpertPacketItem(const expert_info_t& expert_info, column_info *cinfo, const ExpertInfoRecords *records, ExpertPacketItem* parent);
     virtual ~ExpertPacketItem();
 
     unsigned int packetNum() const { return packet_num_; }
@@ -42,26 +74,36 @@ public:
     QString groupKey(bool group_by_summary);
 
     void appendChild(ExpertPacketItem* child, QString hash);
+    // Individual expert infos are only turned into items when a view
+    // asks for them, i.e. when their group gets opened.
+    void appendRecord(unsigned record);
     ExpertPacketItem* child(int row);
     ExpertPacketItem* child(QString hash);
     int childCount() const;
     int row() const;
     ExpertPacketItem* parentItem();
+    // Parent of the per-summary items of a group.
+    ExpertPacketItem* summaryRoot();
+    void setSummaryRoot(ExpertPacketItem* summary_root);
 
 private:
+    ExpertPacketItem(const ExpertInfoRecords& records, unsigned record, ExpertPacketItem* parent, int row);
+
     unsigned int packet_num_;
     int group_;
     int severity_;
     int hf_id_;
     int row_;
-    // Half-hearted attempt at conserving memory. If this isn't sufficient,
-    // PacketListRecord interns column strings in a GStringChunk.
+    // Items made from a record point into ExpertInfoRecords' string chunk.
     QByteArray protocol_;
     QByteArray summary_;
     QByteArray info_;
 
-    QList<ExpertPacketItem*> childItems_;
+    const ExpertInfoRecords *records_;
+    QVector<unsigned> recordIds_;
+    QVector<ExpertPacketItem*> childItems_;
     ExpertPacketItem* parentItem_;
+    ExpertPacketItem* summaryRoot_;
     QHash<QString, ExpertPacketItem*> hashChild_;    //optimization for insertion
 };
 
@@ -122,6 +164,7 @@ private:
     ExpertPacketItem* createRootItem();
 
     bool group_by_summary_;
+    ExpertInfoRecords records_;
     ExpertPacketItem* root_;
 
     QHash<enum ExpertSeverity, int> eventCounts_;
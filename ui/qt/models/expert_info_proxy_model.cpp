@@ -182,6 +182,14 @@ QVariant ExpertInfoProxyModel::data(const QModelIndex &proxy_index, int role) co
                 unsigned int count = 0;
                 ExpertPacketItem *child_item,
                                  *item = static_cast<ExpertPacketItem*>(source_index.internalPointer());
+                // Children have their group's severity, so without a
+                // text filter there's no need to look at (and create)
+                // each of them.
+                if (textFilter_.isEmpty()) {
+                    if (!hidden_severities_.contains(item->severity()))
+                        count = item->childCount();
+                    return count;
+                }
                 for (int row = 0; row < item->childCount(); row++) {
                     child_item = item->child(row);
                     if (child_item == NULL)
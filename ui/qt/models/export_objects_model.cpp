@@ -13,9 +13,18 @@
 #include <ui/qt/utils/qt_ui_utils.h>
 #include <ui/qt/utils/variant_pointer.h>
 #include <wsutil/filesystem.h>
+#include <wsutil/report_message.h>
 #include <epan/prefs.h>
 
 #include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+
+// Payloads at least this large are moved out of memory into a temporary
+// directory; smaller ones aren't worth a file each.
+static const size_t spill_min_len_ = 64 * 1024;
 
 extern "C" {
 
@@ -44,6 +53,7 @@ object_list_get_entry(void *gui_data, int row) {
 
 ExportObjectModel::ExportObjectModel(register_eo_t* eo, QObject *parent) :
     QAbstractTableModel(parent),
+    spill_dir_(nullptr),
     eo_(eo)
 {
     eo_gui_data_.model = this;
@@ -58,6 +68,7 @@ ExportObjectModel::~ExportObjectModel()
     foreach (QVariant v, objects_) {
         eo_free_entry(VariantPointer<export_object_entry_t>::asPtr(v));
     }
+    delete spill_dir_;
 }
 
 QVariant ExportObjectModel::data(const QModelIndex &index, int role) const
@@ -139,6 +150,31 @@ void ExportObjectModel::addObjectEntry(export_object_entry_t *entry)
     beginInsertRows(QModelIndex(), count, count);
     objects_.append(VariantPointer<export_object_entry_t>::asQVariant(entry));
     endInsertRows();
+
+    // Entries that the tap extends later are spilled once tapping is done.
+    if (!get_eo_updates_entries(eo_))
+        spillObjectEntry(entry);
+}
+
+void ExportObjectModel::spillObjectEntry(export_object_entry_t *entry)
+{
+    if (entry->payload_len < spill_min_len_ || entry->payload_path)
+        return;
+
+    if (!spill_dir_)
+        spill_dir_ = new QTemporaryDir(QDir::tempPath() + "/wireshark_eo_XXXXXX");
+
+    if (spill_dir_->isValid()) {
+        // On failure the payload simply stays in memory.
+        eo_spill_entry(entry, qUtf8Printable(spill_dir_->path()));
+    }
+}
+
+void ExportObjectModel::spillObjectEntries()
+{
+    foreach (QVariant v, objects_) {
+        spillObjectEntry(VariantPointer<export_object_entry_t>::asPtr(v));
+    }
 }
 
 export_object_entry_t* ExportObjectModel::objectEntry(int row)
@@ -156,12 +192,50 @@ bool ExportObjectModel::saveEntry(QModelIndex &index, QString filename)
         return false;
 
     if (filename.length() > 0) {
-        write_file_binary_mode(qUtf8Printable(filename), entry->payload_data, entry->payload_len);
+        if (entry->payload_path)
+            copy_file_binary_mode(entry->payload_path, qUtf8Printable(filename));
+        else
+            write_file_binary_mode(qUtf8Printable(filename), entry->payload_data, entry->payload_len);
     }
 
     return true;
 }
 
+namespace {
+
+struct ExportObjectSaveJob {
+    export_object_entry_t *entry;
+    QString path;
+    QString error;
+};
+
+// Runs on a worker thread, so errors are collected instead of reported.
+void saveObjectJob(ExportObjectSaveJob &job)
+{
+    if (job.entry->payload_path) {
+        QFile::remove(job.path);
+        QFile src(QString::fromUtf8(job.entry->payload_path));
+        if (!src.copy(job.path))
+            job.error = src.errorString();
+        return;
+    }
+
+    QFile file(job.path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        job.error = file.errorString();
+        return;
+    }
+    if (job.entry->payload_len > 0 &&
+        file.write(reinterpret_cast<const char *>(job.entry->payload_data),
+                   static_cast<qint64>(job.entry->payload_len)) != static_cast<qint64>(job.entry->payload_len)) {
+        job.error = file.errorString();
+    }
+    if (!file.flush() && job.error.isEmpty())
+        job.error = file.errorString();
+}
+
+} // namespace
+
 void ExportObjectModel::saveAllEntries(QString path)
 {
     if (path.isEmpty())
@@ -169,6 +243,8 @@ void ExportObjectModel::saveAllEntries(QString path)
 
     QDir save_dir(path);
     export_object_entry_t *entry;
+    QList<ExportObjectSaveJob> jobs;
+    QSet<QString> taken;
 
     for (QList<QVariant>::iterator it = objects_.begin(); it != objects_.end(); ++it)
     {
@@ -197,9 +273,17 @@ void ExportObjectModel::saveAllEntries(QString path)
             }
             filename = QString::fromUtf8(safe_filename->str);
             g_string_free(safe_filename, TRUE);
-        } while (save_dir.exists(filename) && ++count < prefs.gui_max_export_objects);
-        write_file_binary_mode(qUtf8Printable(save_dir.filePath(filename)),
-                               entry->payload_data, entry->payload_len);
+        } while ((save_dir.exists(filename) || taken.contains(filename)) && ++count < prefs.gui_max_export_objects);
+        taken.insert(filename);
+        jobs.append({ entry, save_dir.filePath(filename), QString() });
+    }
+
+    // The names are settled above, so the files can be written in parallel.
+    QtConcurrent::blockingMap(jobs, saveObjectJob);
+
+    foreach (const ExportObjectSaveJob &job, jobs) {
+        if (!job.error.isEmpty())
+            report_failure("Could not save %s: %s", qUtf8Printable(job.path), qUtf8Printable(job.error));
     }
 }
 
@@ -21,6 +21,8 @@
 #include <QSortFilterProxyModel>
 #include <QList>
 
+class QTemporaryDir;
+
 typedef struct export_object_list_gui_t {
     class ExportObjectModel *model;
 } export_object_list_gui_t;
@@ -45,6 +47,7 @@ public:
     void addObjectEntry(export_object_entry_t *entry);
     export_object_entry_t *objectEntry(int row);
     void resetObjects();
+    void spillObjectEntries();
 
     bool saveEntry(QModelIndex &index, QString filename);
     void saveAllEntries(QString path);
@@ -63,6 +66,9 @@ public:
 
 private:
     QList<QVariant> objects_;
+    QTemporaryDir *spill_dir_;
+
+    void spillObjectEntry(export_object_entry_t *entry);
 
     export_object_list_t export_object_list_;
     export_object_list_gui_t eo_gui_data_;
@@ -423,16 +423,15 @@ void InterfaceTreeModel::stopStatistic()
 }
 #endif
 
-void InterfaceTreeModel::updateStatistic(unsigned int idx)
+// Adds a sparkline point for each of the given rows from the latest
+// dumpcap report, returning false if there hasn't been one since the last
+// call. The rows are updated together so that the views are only told
+// once, however many interfaces there are.
+bool InterfaceTreeModel::updateStatistics(const QList<int> &rows)
 {
 #ifdef HAVE_LIBPCAP
-    if (! global_capture_opts.all_ifaces || global_capture_opts.all_ifaces->len <= (unsigned) idx)
-        return;
-
-    interface_t *device = &g_array_index(global_capture_opts.all_ifaces, interface_t, idx);
-
-    if (device->if_info.type == IF_PIPE || device->if_info.type == IF_EXTCAP)
-        return;
+    if (!global_capture_opts.all_ifaces)
+        return false;
 
     if (!stat_cache_)
     {
@@ -445,36 +444,68 @@ void InterfaceTreeModel::updateStatistic(unsigned int idx)
         stat_cache_ = capture_stat_start(&global_capture_opts);
     }
 
-    struct pcap_stat stats;
-    unsigned diff = 0;
-    bool isActive = false;
+    if (!capture_stats_update(stat_cache_))
+        return false;
 
-    if (capture_stats(stat_cache_, device->name, &stats))
+    bool layout_changing = false;
+    int first = -1;
+    int last = -1;
+
+    foreach (int idx, rows)
     {
-        if ( (int) stats.ps_recv > 0 )
-            isActive = true;
+        if (idx < 0 || global_capture_opts.all_ifaces->len <= (unsigned) idx)
+            continue;
+
+        interface_t *device = &g_array_index(global_capture_opts.all_ifaces, interface_t, idx);
 
-        if ((int)(stats.ps_recv - device->last_packets) >= 0)
+        if (device->if_info.type == IF_PIPE || device->if_info.type == IF_EXTCAP)
+            continue;
+
+        struct pcap_stat stats;
+        unsigned diff = 0;
+        bool isActive = false;
+
+        if (capture_stats(stat_cache_, device->name, &stats))
         {
-            diff = stats.ps_recv - device->last_packets;
-            device->packet_diff = diff;
+            if ( (int) stats.ps_recv > 0 )
+                isActive = true;
+
+            if ((int)(stats.ps_recv - device->last_packets) >= 0)
+            {
+                diff = stats.ps_recv - device->last_packets;
+                device->packet_diff = diff;
+            }
+            device->last_packets = stats.ps_recv;
         }
-        device->last_packets = stats.ps_recv;
-    }
 
-    points[device->name].append(diff);
+        points[device->name].append(diff);
 
-    if (active[device->name] != isActive)
-    {
-        emit layoutAboutToBeChanged();
-        active[device->name] = isActive;
-        emit layoutChanged();
+        if (active[device->name] != isActive)
+        {
+            if (!layout_changing)
+            {
+                emit layoutAboutToBeChanged();
+                layout_changing = true;
+            }
+            active[device->name] = isActive;
+        }
+
+        first = first < 0 ? idx : qMin(first, idx);
+        last = qMax(last, idx);
     }
 
-    emit dataChanged(index(idx, IFTREE_COL_STATS), index(idx, IFTREE_COL_STATS));
+    if (layout_changing)
+        emit layoutChanged();
+
+    // Views only repaint the part of this that they show.
+    if (first >= 0)
+        emit dataChanged(index(first, IFTREE_COL_STATS), index(last, IFTREE_COL_STATS));
 
+    return true;
 #else
-    Q_UNUSED(idx)
+    Q_UNUSED(rows)
+
+    return false;
 #endif
 }
 
@@ -71,7 +71,7 @@ public:
     QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
 
-    void updateStatistic(unsigned int row);
+    bool updateStatistics(const QList<int> &rows);
 #ifdef HAVE_LIBPCAP
     void setCache(if_stat_cache_t *stat_cache);
     void stopStatistic();
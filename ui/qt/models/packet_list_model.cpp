@@ -8,8 +8,10 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <stdexcept>
+#include <vector>
 
 #include "packet_list_model.h"
 
@@ -36,7 +38,8 @@
 #include <QElapsedTimer>
 #include <QFontMetrics>
 #include <QModelIndex>
-#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
 
 // Print timing information
 //#define DEBUG_PACKET_LIST_MODEL 1
@@ -50,6 +53,25 @@ class SortAbort : public std::runtime_error
     using std::runtime_error::runtime_error;
 };
 
+// The sort key for a record in a column that requires dissection. This
+// is extracted once per record so that comparisons don't need to look
+// at (or re-dissect) the record.
+struct ColumnSortKey
+{
+    PacketListRecord *record;
+    QByteArray text;
+    double num;
+    bool num_ok;
+};
+
+// The sort key for a record in a column that comes from frame data.
+struct FrameDataSortKey
+{
+    PacketListRecord *record;
+    frame_data_sort_key_t key;
+    uint32_t num;
+};
+
 static PacketListModel * glbl_plist_model = Q_NULLPTR;
 static const int reserved_packets_ = 100000;
 constexpr int buffer_size_ = reserved_packets_ / 10;
@@ -84,7 +106,17 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     QAbstractItemModel(parent),
     number_to_row_(QVector<int>()),
     need_recreate_visible_rows_(false),
-    idle_dissection_row_(0)
+    idle_dissection_row_(0),
+    prefetch_pos_(0),
+    prefetch_pending_(false),
+    prefetch_view_first_(0),
+    prefetch_direction_(1),
+    color_map_buckets_(0),
+    color_map_rows_(0),
+    color_map_pending_(false),
+    width_sample_rows_(0),
+    width_sample_pos_(0),
+    width_sample_pending_(false)
 {
     Q_ASSERT(glbl_plist_model == Q_NULLPTR);
     glbl_plist_model = this;
@@ -136,6 +168,7 @@ unsigned PacketListModel::recreateVisibleRows()
 {
     beginResetModel();
     visible_rows_.resize(0);
+    aggregation_rows_.clear();
     number_to_row_.fill(0);
     endResetModel();
 
@@ -148,6 +181,10 @@ unsigned PacketListModel::recreateVisibleRows()
         endInsertRows();
     }
     idle_dissection_row_ = 0;
+    prefetch_rows_.clear();
+    prefetch_pos_ = 0;
+    resetColorMap();
+    sampleColumnWidths();
     return static_cast<unsigned>(visible_rows_.count());
 }
 
@@ -157,12 +194,18 @@ void PacketListModel::clear() {
     PacketListRecord::invalidateAllRecords();
     physical_rows_.resize(0);
     visible_rows_.resize(0);
+    aggregation_rows_.clear();
     new_visible_rows_.resize(0);
     number_to_row_.resize(0);
     endResetModel();
     idle_dissection_timer_->invalidate();
     idle_dissection_row_ = 0;
+    prefetch_rows_.clear();
+    prefetch_pos_ = 0;
     need_recreate_visible_rows_ = false;
+    resetColorMap();
+    width_sample_rows_ = 0;
+    width_sample_pos_ = 0;
 }
 
 void PacketListModel::invalidateAllColumnStrings()
@@ -204,6 +247,7 @@ void PacketListModel::invalidateAllColumnStrings()
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
             QVector<int>() << Qt::DisplayRole);
 #endif
+    sampleColumnWidths();
 }
 
 void PacketListModel::resetColumns()
@@ -214,6 +258,7 @@ void PacketListModel::resetColumns()
     if (cap_file_) {
         PacketListRecord::resetColumns(&cap_file_->cinfo);
     }
+    sampleColumnWidths();
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     emit layoutChanged();
@@ -229,6 +274,7 @@ void PacketListModel::resetColorized()
     emit layoutAboutToBeChanged();
 #endif
     PacketListRecord::resetColorization();
+    resetColorMap();
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     emit layoutChanged();
 #else
@@ -531,7 +577,6 @@ Qt::SortOrder PacketListModel::sort_order_;
 capture_file *PacketListModel::sort_cap_file_;
 bool PacketListModel::stop_flag_;
 ProgressFrame *PacketListModel::progress_frame_;
-double PacketListModel::comps_;
 double PacketListModel::exp_comps_;
 
 QElapsedTimer busy_timer_;
@@ -546,32 +591,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     QString col_title = get_column_title(column);
 
-    /* Make sure we're actually going to sort. Note that the header
-     * has no way of knowing that sorting failed, so in these cases
-     * the sort indicator have the value that the user requested
-     * regardless.
-     */
-    if (PacketListRecord::textColumn(column) >= 0 && (unsigned)visible_rows_.count() > prefs.gui_packet_list_cached_rows_max) {
-        /* Column not based on frame data but by column text that requires
-         * dissection, so to sort in a reasonable amount of time the column
-         * text needs to be cached.
-         */
-        /* If the sort is being triggered because the columns were already
-         * sorted and the filter is being cleared (or changed to something
-         * else with more rows than fit in the cache), then the temporary
-         * message will be immediately overwritten with the standard capture
-         * statistics by the packets_bar_update() call after thawing the rows.
-         * It will still blink yellow, and the user will get the message if
-         * they then click on the header file (wondering why it didn't sort.)
-         */
-        if (col_title.isEmpty()) {
-            col_title = tr("Column");
-        }
-        QString temp_msg = tr("%1 can only be sorted with %2 or fewer visible rows; increase cache size in Layout preferences").arg(col_title).arg(prefs.gui_packet_list_cached_rows_max);
-        mainApp->pushStatus(MainApplication::TemporaryStatus, temp_msg);
-        return;
-    }
-
     /* If we are currently in the middle of reading the capture file, don't
      * sort. PacketList::captureFileReadFinished invalidates all the cached
      * column strings and then tries to sort again.
@@ -580,7 +599,7 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
      * we ignored user input, but now in order to cancel sorting we don't.)
      *
      * This also means we can't sort while still sorting. That would crash
-     * too, because recordLessThan depends on the value of class private
+     * too, because the sort functions depend on the value of class private
      * variables, and so we can't change them while a previous sort is using
      * them. Maybe if we made the comparison function a closure using the
      * current values.
@@ -608,7 +627,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
         busy_msg = tr("Sorting …");
     }
     stop_flag_ = false;
-    comps_ = 0;
     /* XXX: The expected number of comparisons is O(N log N), but this could
      * be a pretty significant overestimate of the amount of time it takes,
      * if there are lots of identical entries. (Especially with string
@@ -630,15 +648,21 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
     QVector<PacketListRecord *> sorted_visible_rows_ = visible_rows_;
     try {
-        std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+        if (text_sort_column_ < 0) {
+            sortByFrameDataKeys(sorted_visible_rows_);
+        } else {
+            sortByColumnKeys(sorted_visible_rows_);
+        }
 
         beginResetModel();
         visible_rows_.resize(0);
+        aggregation_rows_.clear();
         number_to_row_.fill(0);
         foreach (PacketListRecord *record, sorted_visible_rows_) {
             updateVisibleRows(record);
         }
         endResetModel();
+        resetColorMap();
     } catch (const SortAbort& e) {
         mainApp->pushStatus(MainApplication::TemporaryStatus, e.what());
     }
@@ -745,15 +769,15 @@ void PacketListModel::updateVisibleRows(PacketListRecord* record)
     }
     bool add_record = true;
     if (recent.aggregation_view) {
-        for (qsizetype i = 0; i < visible_rows_.size(); i++) {
-            frame_data* prev_fdata = visible_rows_[i]->frameData();
-            if (frame_data_aggregation_compare(prev_fdata, fdata) == 0) {
-                record->setRow(visible_rows_[i]->row());
-                frame_data_aggregation_free(prev_fdata);
-                visible_rows_[i] = record;
-                add_record = false;
-                break;
-            }
+        // The last frame of each group stands for the group.
+        unsigned group = frame_data_get_aggregation_group(record->frameData());
+        QHash<unsigned, qsizetype>::const_iterator it = aggregation_rows_.constFind(group);
+        if (it != aggregation_rows_.constEnd()) {
+            record->setRow(visible_rows_[*it]->row());
+            visible_rows_[*it] = record;
+            add_record = false;
+        } else {
+            aggregation_rows_.insert(group, visible_rows_.size());
         }
     }
     if (add_record) {
@@ -766,85 +790,195 @@ void PacketListModel::updateVisibleRows(PacketListRecord* record)
     number_to_row_[fdata->num] = record->row();
 }
 
-bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
+// Compare column text, numerically for numeric columns, and then frame
+// numbers.
+static int compareColumnSortKeys(const ColumnSortKey &k1, const ColumnSortKey &k2, bool numeric)
 {
-    int cmp_val = 0;
-    comps_++;
+    // UTF-8 byte order is the same as code point order.
+    int cmp_val = qstrcmp(k1.text, k2.text);
+    if (cmp_val != 0 && numeric) {
+        if (!k1.num_ok && !k2.num_ok) {
+            cmp_val = 0;
+        } else if (!k1.num_ok || (k2.num_ok && k1.num < k2.num)) {
+            cmp_val = -1;
+        } else if (!k2.num_ok || (k1.num > k2.num)) {
+            cmp_val = 1;
+        }
+    }
+
+    if (cmp_val == 0) {
+        // All else being equal, compare frame numbers.
+        uint32_t num1 = k1.record->frameData()->num;
+        uint32_t num2 = k2.record->frameData()->num;
+        cmp_val = (num1 > num2) - (num1 < num2);
+    }
 
-    // Wherein we try to cram the logic of packet_list_compare_records,
-    // _packet_list_compare_records, and packet_list_compare_custom from
-    // gtk/packet_list_store.c into one function
+    return cmp_val;
+}
 
-    if (busy_timer_.elapsed() > busy_timeout_) {
-        if (progress_frame_) {
-            progress_frame_->setValue(static_cast<int>(comps_/exp_comps_ * 100));
+// Sort keys in chunks on the global thread pool and merge the chunks
+// pairwise, also in parallel, keeping the UI responsive and the progress
+// bar (the second half of it) up to date.
+template <typename Key, typename LessThan>
+void PacketListModel::sortKeys(std::vector<Key> &keys, LessThan lessThan)
+{
+    const qsizetype count = static_cast<qsizetype>(keys.size());
+    std::atomic<bool> abort_sort(false);
+    std::atomic<qint64> comparisons(0);
+
+    // Workers publish their comparison counts and check for cancellation
+    // every this many comparisons.
+    const qint64 comps_quantum = 4096;
+    auto keyLessThan = [&](qint64 &local_comps) {
+        return [&](const Key &k1, const Key &k2) {
+            if (++local_comps % comps_quantum == 0) {
+                comparisons += comps_quantum;
+                if (abort_sort) {
+                    throw SortAbort("Sorting aborted");
+                }
+            }
+            return lessThan(k1, k2);
+        };
+    };
+
+    // Run the future returned by QtConcurrent, keeping the UI responsive
+    // and passing a cancellation through to the workers.
+    auto waitForWorkers = [&](QFuture<void> future) {
+        while (!future.isFinished()) {
+            if (progress_frame_) {
+                progress_frame_->setValue(50 + static_cast<int>(std::min(comparisons / exp_comps_, 1.0) * 50));
+            }
+            mainApp->processEvents(QEventLoop::ExcludeSocketNotifiers, busy_timeout_);
+            if (stop_flag_) {
+                abort_sort = true;
+            }
+            QThread::msleep(busy_timeout_ / 4);
         }
-        // What's the least amount of processing that we can do which will draw
-        // the busy indicator?
-        mainApp->processEvents(QEventLoop::ExcludeSocketNotifiers, 1);
-        if (stop_flag_) {
+        if (abort_sort) {
             throw SortAbort("Sorting aborted");
         }
-        busy_timer_.restart();
+    };
+
+    // Don't bother splitting small chunks across threads.
+    const qsizetype min_chunk = 16384;
+    qsizetype num_chunks = std::max(qsizetype(1), std::min(qsizetype(QThread::idealThreadCount()), count / min_chunk));
+    QVector<qsizetype> bounds;
+    for (qsizetype chunk = 0; chunk <= num_chunks; chunk++) {
+        bounds << count * chunk / num_chunks;
+    }
+
+    QVector<qsizetype> ranges;
+    for (qsizetype chunk = 0; chunk < num_chunks; chunk++) {
+        ranges << chunk;
     }
-    if (sort_column_ < 0) {
-        // No column.
-        cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-    } else if (text_sort_column_ < 0) {
-        // Column comes directly from frame data
-        cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
-    } else  {
-        QString r1String = r1->columnString(sort_cap_file_, sort_column_);
-        QString r2String = r2->columnString(sort_cap_file_, sort_column_);
-        // XXX: The naive string comparison compares Unicode code points.
-        // Proper collation is more expensive
-        cmp_val = r1String.compare(r2String);
-        if (cmp_val != 0 && sort_column_is_numeric_) {
-            // Custom column with numeric data (or something like a port number).
-            // Attempt to convert to numbers.
-            // XXX This is slow. Can we avoid doing this? Perhaps the actual
-            // values used for sorting should be cached too as QVariant[List].
-            // If so, we could consider using QCollatorSortKeys or similar
-            // for strings as well.
-            bool ok_r1, ok_r2;
-            double num_r1 = parseNumericColumn(r1String, &ok_r1);
-            double num_r2 = parseNumericColumn(r2String, &ok_r2);
-
-            if (!ok_r1 && !ok_r2) {
-                cmp_val = 0;
-            } else if (!ok_r1 || (ok_r2 && num_r1 < num_r2)) {
-                // either r1 is invalid (and sort it before others) or both
-                // r1 and r2 are valid (sort normally)
-                cmp_val = -1;
-            } else if (!ok_r2 || (num_r1 > num_r2)) {
-                cmp_val = 1;
+    waitForWorkers(QtConcurrent::map(ranges, [&](qsizetype chunk) {
+        qint64 local_comps = 0;
+        try {
+            std::sort(keys.begin() + bounds[chunk], keys.begin() + bounds[chunk + 1], keyLessThan(local_comps));
+        } catch (const SortAbort&) {
+            // Picked up by waitForWorkers.
+        }
+    }));
+
+    // Merge adjacent sorted runs until only one remains.
+    for (qsizetype width = 1; width < num_chunks; width *= 2) {
+        ranges.clear();
+        for (qsizetype chunk = 0; chunk + width < num_chunks; chunk += width * 2) {
+            ranges << chunk;
+        }
+        waitForWorkers(QtConcurrent::map(ranges, [&, width](qsizetype chunk) {
+            qint64 local_comps = 0;
+            qsizetype last = bounds[std::min(chunk + width * 2, num_chunks)];
+            try {
+                std::inplace_merge(keys.begin() + bounds[chunk], keys.begin() + bounds[chunk + width],
+                                   keys.begin() + last, keyLessThan(local_comps));
+            } catch (const SortAbort&) {
+                // Picked up by waitForWorkers.
             }
+        }));
+    }
+}
+
+// Sort by a column that requires dissection. Each record is dissected
+// exactly once to extract its sort key (dissection isn't thread safe, so
+// that happens here), then the keys are sorted in chunks on the global
+// thread pool and the chunks merged pairwise, also in parallel. Only the
+// sort keys are kept, so this doesn't depend on the column text cache
+// being large enough to hold every visible row.
+void PacketListModel::sortByColumnKeys(QVector<PacketListRecord *> &rows)
+{
+    const qsizetype count = rows.count();
+    std::vector<ColumnSortKey> keys(count);
+
+    for (qsizetype i = 0; i < count; i++) {
+        ColumnSortKey &key = keys[i];
+
+        key.record = rows[i];
+        key.text = key.record->columnSortString(sort_cap_file_, sort_column_).toUtf8();
+        key.num = 0;
+        key.num_ok = false;
+        if (sort_column_is_numeric_) {
+            char *end = NULL;
+            key.num = g_ascii_strtod(key.text.constData(), &end);
+            key.num_ok = key.text.constData() != end;
         }
 
-        if (cmp_val == 0) {
-            // All else being equal, compare column numbers.
-            cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
+        if (busy_timer_.elapsed() > busy_timeout_) {
+            if (progress_frame_) {
+                // Key extraction is the first half of the progress bar.
+                progress_frame_->setValue(static_cast<int>(i * 50 / count));
+            }
+            mainApp->processEvents(QEventLoop::ExcludeSocketNotifiers, 1);
+            if (stop_flag_) {
+                throw SortAbort("Sorting aborted");
+            }
+            busy_timer_.restart();
         }
     }
 
-    if (sort_order_ == Qt::AscendingOrder) {
-        return cmp_val < 0;
-    } else {
-        return cmp_val > 0;
+    const bool numeric = sort_column_is_numeric_;
+    const bool ascending = sort_order_ == Qt::AscendingOrder;
+    sortKeys(keys, [numeric, ascending](const ColumnSortKey &k1, const ColumnSortKey &k2) {
+        int cmp_val = compareColumnSortKeys(k1, k2, numeric);
+        return ascending ? cmp_val < 0 : cmp_val > 0;
+    });
+
+    for (qsizetype i = 0; i < count; i++) {
+        rows[i] = keys[i].record;
     }
 }
 
-// Parses a field as a double. Handle values with suffixes ("12ms"), negative
-// values ("-1.23") and fields with multiple occurrences ("1,2"). Marks values
-// that do not contain any numeric value ("Unknown") as invalid.
-double PacketListModel::parseNumericColumn(const QString &val, bool *ok)
+// Sort by a column that comes straight from frame data, such as the time
+// and cumulative bytes columns. Working out each record's key in one pass
+// takes at most one lookup of the previous or reference frame per record,
+// instead of one per record in every comparison, and the comparisons are
+// then just integer compares.
+void PacketListModel::sortByFrameDataKeys(QVector<PacketListRecord *> &rows)
 {
-    QByteArray ba = val.toUtf8();
-    const char *strval = ba.constData();
-    char *end = NULL;
-    double num = g_ascii_strtod(strval, &end);
-    *ok = strval != end;
-    return num;
+    const qsizetype count = rows.count();
+    const int col_fmt = sort_cap_file_->cinfo.columns[sort_column_].col_fmt;
+    std::vector<FrameDataSortKey> keys(count);
+
+    for (qsizetype i = 0; i < count; i++) {
+        FrameDataSortKey &key = keys[i];
+
+        key.record = rows[i];
+        key.num = key.record->frameData()->num;
+        frame_data_get_sort_key(sort_cap_file_->epan, key.record->frameData(), col_fmt, &key.key);
+    }
+
+    const bool ascending = sort_order_ == Qt::AscendingOrder;
+    sortKeys(keys, [ascending](const FrameDataSortKey &k1, const FrameDataSortKey &k2) {
+        int cmp_val = frame_data_compare_sort_keys(&k1.key, &k2.key);
+        if (cmp_val == 0) {
+            cmp_val = (k1.num > k2.num) - (k1.num < k2.num);
+        }
+        return ascending ? cmp_val < 0 : cmp_val > 0;
+    });
+
+    for (qsizetype i = 0; i < count; i++) {
+        rows[i] = keys[i].record;
+    }
 }
 
 int PacketListModel::rowCount(const QModelIndex &) const
@@ -996,6 +1130,226 @@ void PacketListModel::dissectIdle(bool reset)
     emit bgColorizationProgress(first+1, idle_dissection_row_+1);
 }
 
+// How many pages past the viewport to prepare in the scroll direction.
+static const int prefetch_pages_ = 2;
+void PacketListModel::prefetchRows(int first, int last)
+{
+    if (first < 0 || last < first || first >= visible_rows_.count())
+        return;
+
+    if (first != prefetch_view_first_) {
+        prefetch_direction_ = first > prefetch_view_first_ ? 1 : -1;
+        prefetch_view_first_ = first;
+    }
+
+    // The rows on screen were used last, so they're the first thing the
+    // cache would evict. Only prepare as many rows as fit beside them.
+    int page = last - first + 1;
+    int room = PacketListRecord::maxCache() - page;
+    int ahead = qMin(page * prefetch_pages_, room);
+    int behind = qMin(page, room - ahead);
+    int row_count = static_cast<int>(visible_rows_.count());
+
+    prefetch_rows_.clear();
+    prefetch_pos_ = 0;
+    if (ahead <= 0)
+        return;
+
+    int ahead_start = prefetch_direction_ > 0 ? last + 1 : first - 1;
+    int behind_start = prefetch_direction_ > 0 ? first - 1 : last + 1;
+    for (int i = 0; i < ahead; i++) {
+        int row = ahead_start + i * prefetch_direction_;
+        if (row >= 0 && row < row_count)
+            prefetch_rows_ << row;
+    }
+    for (int i = 0; i < behind; i++) {
+        int row = behind_start - i * prefetch_direction_;
+        if (row >= 0 && row < row_count)
+            prefetch_rows_ << row;
+    }
+
+    if (!prefetch_rows_.isEmpty() && !prefetch_pending_) {
+        prefetch_pending_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::prefetchIdle);
+    }
+}
+
+// Dissection isn't thread safe, so this runs on the GUI thread in slices
+// like dissectIdle(), with the slices re-aimed each time the view moves.
+void PacketListModel::prefetchIdle()
+{
+    prefetch_pending_ = false;
+    if (prefetch_pos_ >= prefetch_rows_.count())
+        return;
+
+    if (!cap_file_ || cap_file_->read_lock) {
+        // File is in use (at worst, being rescanned). Try again later.
+        prefetch_pending_ = true;
+        QTimer::singleShot(idle_dissection_interval_, this, &PacketListModel::prefetchIdle);
+        return;
+    }
+
+    QElapsedTimer prefetch_timer;
+    prefetch_timer.start();
+    while (prefetch_timer.elapsed() < idle_dissection_interval_
+           && prefetch_pos_ < prefetch_rows_.count()) {
+        int row = prefetch_rows_[prefetch_pos_++];
+        if (row < visible_rows_.count() && visible_rows_[row]) {
+            visible_rows_[row]->prefetch(cap_file_);
+        }
+    }
+
+    if (prefetch_pos_ < prefetch_rows_.count()) {
+        prefetch_pending_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::prefetchIdle);
+    }
+}
+
+// The number of rows colorized for each color map bucket. More find
+// smaller runs of color, at the cost of more dissection.
+static const int color_map_samples_ = 5;
+
+void PacketListModel::buildColorMap(int buckets)
+{
+    int rows = static_cast<int>(visible_rows_.count());
+
+    if (buckets == color_map_buckets_ && rows == color_map_rows_)
+        return;
+
+    color_map_.clear();
+    color_map_.reserve(buckets);
+    color_map_buckets_ = buckets;
+    color_map_rows_ = rows;
+
+    if (buckets > 0 && rows > 0 && !color_map_pending_) {
+        color_map_pending_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::colorMapIdle);
+    }
+}
+
+void PacketListModel::resetColorMap()
+{
+    color_map_.clear();
+    color_map_buckets_ = 0;
+    color_map_rows_ = 0;
+    emit colorMapUpdated();
+}
+
+// Like dissectIdle(), but samples each bucket instead of colorizing
+// every row.
+void PacketListModel::colorMapIdle()
+{
+    color_map_pending_ = false;
+    if (color_map_.count() >= color_map_buckets_ || color_map_rows_ != visible_rows_.count())
+        return;
+
+    if (!cap_file_ || cap_file_->read_lock) {
+        // File is in use (at worst, being rescanned). Try again later.
+        color_map_pending_ = true;
+        QTimer::singleShot(idle_dissection_interval_, this, &PacketListModel::colorMapIdle);
+        return;
+    }
+
+    QElapsedTimer color_map_timer;
+    color_map_timer.start();
+    while (color_map_timer.elapsed() < idle_dissection_interval_
+           && color_map_.count() < color_map_buckets_) {
+        int bucket = static_cast<int>(color_map_.count());
+        int first = static_cast<int>((int64_t) bucket * color_map_rows_ / color_map_buckets_);
+        int last = static_cast<int>((int64_t) (bucket + 1) * color_map_rows_ / color_map_buckets_);
+        // With more buckets than rows, some buckets are empty. Give them
+        // the color of the row they fall on.
+        int span = qMax(last - first, 1);
+        int num_samples = qMin(span, color_map_samples_);
+        const color_filter_t *colors[color_map_samples_];
+        int counts[color_map_samples_];
+        int num_colors = 0;
+
+        for (int sample = 0; sample < num_samples; sample++) {
+            // Sample the middle of each of num_samples equal slices.
+            int row = first + ((2 * sample + 1) * span) / (2 * num_samples);
+            ensureRowColorized(row);
+            frame_data *fdata = getRowFdata(row);
+            const color_filter_t *color_filter = fdata ? (const color_filter_t *) fdata->color_filter : NULL;
+
+            int color;
+            for (color = 0; color < num_colors && colors[color] != color_filter; color++);
+            if (color == num_colors) {
+                colors[num_colors] = color_filter;
+                counts[num_colors] = 0;
+                num_colors++;
+            }
+            counts[color]++;
+        }
+
+        int best = 0;
+        for (int color = 1; color < num_colors; color++) {
+            if (counts[color] > counts[best]) {
+                best = color;
+            }
+        }
+        if (num_colors > 0 && colors[best]) {
+            color_map_ << ColorUtils::fromColorT(&colors[best]->bg_color).rgb();
+        } else {
+            color_map_ << qRgba(0, 0, 0, 0);
+        }
+    }
+
+    emit colorMapUpdated();
+
+    if (color_map_.count() < color_map_buckets_) {
+        color_map_pending_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::colorMapIdle);
+    }
+}
+
+// The number of rows, spread across the list, whose columns are measured
+// in addition to the ones dissected for display.
+static const int column_width_samples_ = 200;
+
+void PacketListModel::sampleColumnWidths()
+{
+    width_sample_rows_ = static_cast<int>(visible_rows_.count());
+    width_sample_pos_ = 0;
+
+    if (width_sample_rows_ > 0 && !width_sample_pending_) {
+        width_sample_pending_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::widthSampleIdle);
+    }
+}
+
+// Like colorMapIdle(), with one sample in the middle of each slice.
+void PacketListModel::widthSampleIdle()
+{
+    width_sample_pending_ = false;
+    int num_samples = qMin(width_sample_rows_, column_width_samples_);
+    if (width_sample_pos_ >= num_samples || width_sample_rows_ > visible_rows_.count())
+        return;
+
+    if (!cap_file_ || cap_file_->read_lock) {
+        // File is in use (at worst, being rescanned). Try again later.
+        width_sample_pending_ = true;
+        QTimer::singleShot(idle_dissection_interval_, this, &PacketListModel::widthSampleIdle);
+        return;
+    }
+
+    QElapsedTimer width_sample_timer;
+    width_sample_timer.start();
+    while (width_sample_timer.elapsed() < idle_dissection_interval_
+           && width_sample_pos_ < num_samples) {
+        int row = static_cast<int>(((int64_t) 2 * width_sample_pos_ + 1) * width_sample_rows_ / (2 * num_samples));
+        width_sample_pos_++;
+        if (visible_rows_[row]) {
+            visible_rows_[row]->measureColumns(cap_file_);
+        }
+    }
+
+    if (width_sample_pos_ < num_samples) {
+        width_sample_pending_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::widthSampleIdle);
+    }
+}
+
 // XXX Pass in cinfo from packet_list_append so that we can fill in
 // line counts?
 int PacketListModel::appendPacket(frame_data *fdata)
@@ -1005,7 +1359,8 @@ int PacketListModel::appendPacket(frame_data *fdata)
 
 #ifdef DEBUG_PACKET_LIST_MODEL
     if (fdata->num % 10000 == 1) {
-        log_resource_usage(fdata->num == 1, "%u packets", fdata->num);
+        log_resource_usage(fdata->num == 1, "%u packets, %lld bytes per cached row",
+                           fdata->num, (long long)PacketListRecord::cacheBytesPerRow());
     }
 #endif
 
@@ -14,10 +14,14 @@
 
 #include <stdio.h>
 
+#include <vector>
+
 #include <epan/packet.h>
 
 #include <QAbstractItemModel>
+#include <QColor>
 #include <QFont>
+#include <QHash>
 #include <QVector>
 
 #include <ui/qt/progress_frame.h>
@@ -58,6 +62,39 @@ public:
     frame_data *getRowFdata(QModelIndex idx) const;
     frame_data *getRowFdata(int row) const;
     void ensureRowColorized(int row);
+    /**
+     * @brief Prepare the rows around the viewport before they are shown.
+     *
+     * Queues the rows past the viewport in the direction it last moved,
+     * and one page behind it, to be colorized and have their columns
+     * cached in idle time. Scrolling then shows cached rows instead of
+     * dissecting them while painting.
+     *
+     * @param first the first visible row
+     * @param last the last visible row
+     */
+    void prefetchRows(int first, int last);
+    /**
+     * @brief Start building a color map of the whole packet list.
+     *
+     * The rows are divided into evenly sized buckets, e.g. one per pixel
+     * of the scroll bar's groove. A few rows spread across each bucket are
+     * colorized in idle time, and the bucket gets the most common color
+     * among them. This means the map is ready long before every row has
+     * been colorized. colorMapUpdated is emitted as buckets are filled in.
+     * Calling this again with the same bucket count does nothing unless
+     * the rows have changed.
+     *
+     * @param buckets the number of buckets
+     */
+    void buildColorMap(int buckets);
+    /**
+     * @brief The color map, as far as it has been built.
+     *
+     * @return One color per bucket, starting with the first. Buckets whose
+     * packets aren't colored are transparent.
+     */
+    const QVector<QRgb> &colorMap() const { return color_map_; }
     int visibleIndexOf(const frame_data *fdata) const;
     /**
      * @brief Invalidate any cached column strings.
@@ -84,6 +121,7 @@ signals:
     void goToPacket(int);
 
     void bgColorizationProgress(int first, int last);
+    void colorMapUpdated();
 
 public slots:
     void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
@@ -97,6 +135,8 @@ private:
     QVector<PacketListRecord *> physical_rows_;
     QVector<PacketListRecord *> visible_rows_;
     QVector<PacketListRecord *> new_visible_rows_;
+    // Aggregation group -> index in visible_rows_.
+    QHash<unsigned, qsizetype> aggregation_rows_;
     QVector<int> number_to_row_;
     bool need_recreate_visible_rows_;
 
@@ -105,18 +145,39 @@ private:
     static int text_sort_column_;
     static Qt::SortOrder sort_order_;
     static capture_file *sort_cap_file_;
-    static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
-    static double parseNumericColumn(const QString &val, bool *ok);
 
     static bool stop_flag_;
     static ProgressFrame *progress_frame_;
     static double exp_comps_;
-    static double comps_;
 
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
 
+    QVector<int> prefetch_rows_;
+    int prefetch_pos_;
+    bool prefetch_pending_;
+    int prefetch_view_first_;
+    int prefetch_direction_;
+    void prefetchIdle();
+
+    QVector<QRgb> color_map_;
+    int color_map_buckets_;
+    int color_map_rows_;
+    bool color_map_pending_;
+    void colorMapIdle();
+    void resetColorMap();
+
+    int width_sample_rows_;
+    int width_sample_pos_;
+    bool width_sample_pending_;
+    void sampleColumnWidths();
+    void widthSampleIdle();
+
     bool isNumericColumn(int column);
+    template <typename Key, typename LessThan>
+    void sortKeys(std::vector<Key> &keys, LessThan lessThan);
+    void sortByColumnKeys(QVector<PacketListRecord *> &rows);
+    void sortByFrameDataKeys(QVector<PacketListRecord *> &rows);
     void updateVisibleRows(PacketListRecord*);
 };
 
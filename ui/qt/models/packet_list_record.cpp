@@ -18,9 +18,37 @@
 
 #include <ui/qt/utils/qt_ui_utils.h>
 
-#include <QStringList>
+#include <algorithm>
 
-QCache<uint32_t, QStringList> PacketListRecord::col_text_cache_(500);
+#include <QStringList>
+#include <QVarLengthArray>
+#include <QtEndian>
+
+QCache<uint32_t, QByteArray> PacketListRecord::col_text_cache_(500);
+QVector<QByteArray> PacketListRecord::interned_text_;
+QHash<QByteArray, quint32> PacketListRecord::interned_index_;
+QVector<int> PacketListRecord::intern_tries_;
+QVector<int> PacketListRecord::intern_hits_;
+qsizetype PacketListRecord::cached_bytes_ = 0;
+qsizetype PacketListRecord::cached_rows_ = 0;
+QVector<QByteArray> PacketListRecord::widest_text_;
+
+/*
+ * Each cached row is a single block of UTF-8:
+ *
+ *   quint32 column count
+ *   quint32 per column: the offset of its text in the block, or
+ *           interned_flag_ | its index in interned_text_
+ *   the NUL-terminated text of the columns that weren't interned
+ *
+ * Protocol names, addresses, ports and the like repeat from row to row,
+ * so they're stored once and shared. Columns that turn out to be mostly
+ * unique (number, time, info) stop being looked up after a sample.
+ */
+static const quint32 interned_flag_ = 0x80000000;
+static const qsizetype max_interned_len_ = 64;
+static const qsizetype max_interned_strings_ = 65536;
+static const int intern_sample_ = 256;
 QMap<int, int> PacketListRecord::cinfo_column_;
 unsigned PacketListRecord::rows_color_ver_ = 1;
 
@@ -61,8 +89,39 @@ void PacketListRecord::ensureColorized(capture_file *cap_file)
     }
 }
 
+void PacketListRecord::prefetch(capture_file *cap_file)
+{
+    Q_ASSERT(fdata_);
+
+    if (!cap_file) {
+        return;
+    }
+
+    bool dissect_color = !colorized_ || ( color_ver_ != rows_color_ver_ );
+    if (dissect_color || !col_text_cache_.contains(fdata_->num)) {
+        dissect(cap_file, true, dissect_color);
+    }
+}
+
+void PacketListRecord::measureColumns(capture_file *cap_file)
+{
+    Q_ASSERT(fdata_);
+
+    // Cached rows were measured when they were cached.
+    if (!cap_file || col_text_cache_.contains(fdata_->num)) {
+        return;
+    }
+
+    if (col_text_cache_.totalCost() < col_text_cache_.maxCost()) {
+        dissect(cap_file, true);
+    } else {
+        QString unused;
+        dissect(cap_file, true, false, -1, &unused);
+    }
+}
+
 // We might want to return a const char * instead. This would keep us from
-// creating excessive QByteArrays, e.g. in PacketListModel::recordLessThan.
+// creating excessive QByteArrays, e.g. when sorting.
 const QString PacketListRecord::columnString(capture_file *cap_file, int column, bool colorized)
 {
     // packet_list_store.c:packet_list_get_value
@@ -78,16 +137,61 @@ const QString PacketListRecord::columnString(capture_file *cap_file, int column,
     // properly colorized?
     //
     bool dissect_color = ( colorized && !colorized_ ) || ( color_ver_ != rows_color_ver_ );
-    QStringList *col_text = nullptr;
+    QByteArray *col_text = nullptr;
     if (!dissect_color) {
         col_text = col_text_cache_.object(fdata_->num);
     }
-    if (col_text == nullptr || column >= col_text->count() || col_text->at(column).isNull()) {
+    if (col_text == nullptr) {
         dissect(cap_file, true, dissect_color);
         col_text = col_text_cache_.object(fdata_->num);
     }
 
-    return col_text ? col_text->at(column) : QString();
+    return col_text ? cachedColumnText(col_text, column) : QString();
+}
+
+const QString PacketListRecord::columnSortString(capture_file *cap_file, int column)
+{
+    Q_ASSERT(fdata_);
+
+    if (!cap_file || column < 0 || (unsigned)column >= cap_file->cinfo.num_cols) {
+        return QString();
+    }
+
+    QByteArray *col_text = col_text_cache_.object(fdata_->num);
+    if (col_text != nullptr) {
+        return cachedColumnText(col_text, column);
+    }
+
+    // Sorting a large capture would otherwise evict every other entry
+    // from the cache, so hand back just the one column.
+    QString column_text;
+    dissect(cap_file, true, false, column, &column_text);
+    return column_text;
+}
+
+void PacketListRecord::invalidateAllRecords()
+{
+    col_text_cache_.clear();
+    interned_text_.clear();
+    interned_index_.clear();
+    intern_tries_.clear();
+    intern_hits_.clear();
+    cached_bytes_ = 0;
+    cached_rows_ = 0;
+    widest_text_.clear();
+}
+
+qsizetype PacketListRecord::cacheBytesPerRow()
+{
+    if (cached_rows_ < 1 || col_text_cache_.isEmpty()) {
+        return 0;
+    }
+
+    qsizetype interned_bytes = 0;
+    foreach (const QByteArray &text, interned_text_) {
+        interned_bytes += text.capacity();
+    }
+    return cached_bytes_ / cached_rows_ + interned_bytes / col_text_cache_.size();
 }
 
 void PacketListRecord::resetColumns(column_info *cinfo)
@@ -108,7 +212,8 @@ void PacketListRecord::resetColumns(column_info *cinfo)
     }
 }
 
-void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, bool dissect_color)
+void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, bool dissect_color,
+                               int text_column, QString *column_text)
 {
     // packet_list_store.c:packet_list_dissect_and_cache_record
     epan_dissect_t edt;
@@ -145,7 +250,13 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, boo
         if (dissect_columns) {
             col_fill_in_error(cinfo, fdata_, false, false /* fill_fd_columns */);
 
-            cacheColumnStrings(cinfo);
+            if (column_text && text_column < 0) {
+                noteColumnWidths(cinfo);
+            } else if (column_text) {
+                *column_text = QString(get_column_text(cinfo, text_column));
+            } else {
+                cacheColumnStrings(cinfo);
+            }
         }
         if (dissect_color) {
             fdata_->color_filter = NULL;
@@ -192,7 +303,13 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, boo
     if (dissect_columns) {
         /* "Stringify" non frame_data vals */
         epan_dissect_fill_in_columns(&edt, false, false /* fill_fd_columns */);
-        cacheColumnStrings(cinfo);
+        if (column_text && text_column < 0) {
+            noteColumnWidths(cinfo);
+        } else if (column_text) {
+            *column_text = QString(get_column_text(cinfo, text_column));
+        } else {
+            cacheColumnStrings(cinfo);
+        }
     }
 
     if (dissect_color) {
@@ -229,7 +346,12 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         return;
     }
 
-    QStringList *col_text = new QStringList();
+    QByteArray *col_text = new QByteArray();
+    QVarLengthArray<quint32, 32> header;
+    qsizetype header_len = (1 + cinfo->num_cols) * sizeof(quint32);
+
+    col_text->resize(header_len);
+    header << cinfo->num_cols;
 
     lines_ = 1;
     line_count_changed_ = false;
@@ -237,20 +359,109 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
     for (unsigned column = 0; column < cinfo->num_cols; ++column) {
         int col_lines = 1;
 
-        QString col_str;
         int text_col = cinfo_column_.value(column, -1);
         if (text_col < 0) {
             col_fill_in_frame_data(fdata_, cinfo, column, false);
         }
 
-        col_str = QString(get_column_text(cinfo, column));
-        *col_text << col_str;
-        col_lines = static_cast<int>(col_str.count('\n'));
+        const char *col_str = get_column_text(cinfo, column);
+        qsizetype col_len = static_cast<qsizetype>(strlen(col_str));
+        quint32 id;
+        if (internColumnText(column, col_str, col_len, &id)) {
+            header << (interned_flag_ | id);
+        } else {
+            header << static_cast<quint32>(col_text->size());
+            col_text->append(col_str, col_len);
+            col_text->append('\0');
+        }
+        noteColumnWidth(column, col_str, col_len);
+        col_lines = static_cast<int>(std::count(col_str, col_str + col_len, '\n'));
         if (col_lines > lines_) {
             lines_ = col_lines;
             line_count_changed_ = true;
         }
     }
 
+    memcpy(col_text->data(), header.constData(), header_len);
+    col_text->squeeze();
+
+    cached_bytes_ += col_text->capacity();
+    cached_rows_++;
     col_text_cache_.insert(fdata_->num, col_text);
 }
+
+void PacketListRecord::noteColumnWidths(column_info *cinfo)
+{
+    for (unsigned column = 0; column < cinfo->num_cols; ++column) {
+        if (cinfo_column_.value(column, -1) < 0) {
+            col_fill_in_frame_data(fdata_, cinfo, column, false);
+        }
+        const char *col_str = get_column_text(cinfo, column);
+        noteColumnWidth(column, col_str, static_cast<qsizetype>(strlen(col_str)));
+    }
+}
+
+// Lets PacketList size columns to their contents without dissecting rows
+// to find out what the contents are. The packet list uses a monospace
+// font, so the longest line is taken to be the widest.
+void PacketListRecord::noteColumnWidth(unsigned column, const char *str, qsizetype len)
+{
+    if (column >= (unsigned)widest_text_.size()) {
+        widest_text_.resize(column + 1);
+    }
+
+    const char *end = str + len;
+    while (str < end) {
+        const char *nl = static_cast<const char *>(memchr(str, '\n', end - str));
+        const char *line_end = nl ? nl : end;
+        if (line_end - str > widest_text_[column].size()) {
+            widest_text_[column] = QByteArray(str, line_end - str);
+        }
+        str = nl ? nl + 1 : end;
+    }
+}
+
+bool PacketListRecord::internColumnText(unsigned column, const char *str, qsizetype len, quint32 *id)
+{
+    if (len > max_interned_len_ || interned_text_.size() >= max_interned_strings_) {
+        return false;
+    }
+
+    if (column >= (unsigned)intern_tries_.size()) {
+        intern_tries_.resize(column + 1);
+        intern_hits_.resize(column + 1);
+    }
+    if (intern_tries_[column] >= intern_sample_ && intern_hits_[column] * 4 < intern_tries_[column]) {
+        // Mostly unique values; interning them would only cost memory.
+        return false;
+    }
+    intern_tries_[column]++;
+
+    auto it = interned_index_.constFind(QByteArray::fromRawData(str, len));
+    if (it != interned_index_.constEnd()) {
+        intern_hits_[column]++;
+        *id = it.value();
+        return true;
+    }
+
+    QByteArray text(str, len);
+    *id = static_cast<quint32>(interned_text_.size());
+    interned_text_ << text;
+    interned_index_.insert(text, *id);
+    return true;
+}
+
+QString PacketListRecord::cachedColumnText(const QByteArray *col_text, int column)
+{
+    const char *data = col_text->constData();
+
+    if (column < 0 || static_cast<quint32>(column) >= qFromUnaligned<quint32>(data)) {
+        return QString();
+    }
+
+    quint32 ref = qFromUnaligned<quint32>(data + (1 + column) * sizeof(quint32));
+    if (ref & interned_flag_) {
+        return QString::fromUtf8(interned_text_.at(ref & ~interned_flag_));
+    }
+    return QString::fromUtf8(data + ref);
+}
@@ -19,8 +19,10 @@
 
 #include <QByteArray>
 #include <QCache>
+#include <QHash>
 #include <QList>
 #include <QVariant>
+#include <QVector>
 
 struct conversation;
 struct _GStringChunk;
@@ -33,8 +35,16 @@ public:
 
     // Ensure that the record is colorized.
     void ensureColorized(capture_file *cap_file);
+    // Ensure that the record is colorized and its columns are cached.
+    void prefetch(capture_file *cap_file);
+    // Note the width of the record's columns, caching them only if that
+    // won't evict anything.
+    void measureColumns(capture_file *cap_file);
     // Return the string value for a column. Data is cached if possible.
     const QString columnString(capture_file *cap_file, int column, bool colorized = false);
+    // Return the string value for a single column without adding the
+    // record's columns to the cache. Used to build sort keys.
+    const QString columnSortString(capture_file *cap_file, int column);
     frame_data *frameData() const { return fdata_; }
     // packet_list->col_to_text in gtk/packet_list_store.c
     static int textColumn(int column) { return cinfo_column_.value(column, -1); }
@@ -52,13 +62,19 @@ public:
 
     void invalidateColorized() { colorized_ = false; }
     void invalidateRecord() { col_text_cache_.remove(fdata_->num); }
-    static void invalidateAllRecords() { col_text_cache_.clear(); }
+    static void invalidateAllRecords();
     /* In Qt 6, QCache maxCost is a qsizetype, but the QAbstractItemModel
      * number of rows is still an int, so we're limited to INT_MAX anyway.
      */
     static void setMaxCache(int cost) { col_text_cache_.setMaxCost(cost); }
+    static int maxCache() { return static_cast<int>(col_text_cache_.maxCost()); }
+    // Approximate memory used per row in the column text cache.
+    static qsizetype cacheBytesPerRow();
     static void resetColumns(column_info *cinfo);
     static void resetColorization() { rows_color_ver_++; }
+    // The longest line of text seen in a column since the records
+    // were last invalidated.
+    static QString widestColumnText(int column) { return QString::fromUtf8(widest_text_.value(column)); }
 
     inline int lineCount() { return lines_; }
     inline int lineCountChanged() { return line_count_changed_; }
@@ -66,8 +82,17 @@ public:
     inline int row() const { return row_; }
 
 private:
-    /** The column text for some columns */
-    static QCache<uint32_t, QStringList> col_text_cache_;
+    /** The column text for some columns, see cacheColumnStrings() */
+    static QCache<uint32_t, QByteArray> col_text_cache_;
+    /** Column values shared between rows */
+    static QVector<QByteArray> interned_text_;
+    static QHash<QByteArray, quint32> interned_index_;
+    static QVector<int> intern_tries_;
+    static QVector<int> intern_hits_;
+    static qsizetype cached_bytes_;
+    static qsizetype cached_rows_;
+    /** The longest line of each column, see noteColumnWidth() */
+    static QVector<QByteArray> widest_text_;
 
     frame_data *fdata_;
     int lines_;
@@ -89,8 +114,13 @@ private:
     GSList *color_filters_;
     int color_filter_count_;
 
-    void dissect(capture_file *cap_file, bool dissect_columns, bool dissect_color = false);
+    void dissect(capture_file *cap_file, bool dissect_columns, bool dissect_color = false,
+                 int text_column = -1, QString *column_text = nullptr);
     void cacheColumnStrings(column_info *cinfo);
+    void noteColumnWidths(column_info *cinfo);
+    static void noteColumnWidth(unsigned column, const char *str, qsizetype len);
+    static bool internColumnText(unsigned column, const char *str, qsizetype len, quint32 *id);
+    static QString cachedColumnText(const QByteArray *col_text, int column);
 };
 
 #endif // PACKET_LIST_RECORD_H
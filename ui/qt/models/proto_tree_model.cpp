@@ -36,7 +36,7 @@ ProtoTreeModel::~ProtoTreeModel()
 Qt::ItemFlags ProtoTreeModel::flags(const QModelIndex &index) const
 {
     Qt::ItemFlags item_flags = QAbstractItemModel::flags(index);
-    if (rowCount(index) < 1) {
+    if (!hasChildren(index)) {
         item_flags |= Qt::ItemNeverHasChildren;
     }
 
@@ -80,6 +80,16 @@ int ProtoTreeModel::rowCount(const QModelIndex &parent) const
     return root_node_->childrenCount();
 }
 
+// Views ask this for every visible row to draw the expander. Answer it
+// without building the child nodes, which only happens on expansion.
+bool ProtoTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return protoNodeFromIndex(parent)->hasChildren();
+    }
+    return root_node_->hasChildren();
+}
+
 // The QItemDelegate documentation says
 // "When displaying items from a custom model in a standard view, it is
 //  often sufficient to simply ensure that the model returns appropriate
@@ -241,6 +241,7 @@ PacketList::PacketList(QWidget *parent) :
     gbl_cur_packet_list = this;
 
     connect(packet_list_model_, &PacketListModel::goToPacket, this, [=](int packet) { goToPacket(packet); });
+    connect(packet_list_model_, &PacketListModel::colorMapUpdated, this, [=]() { create_far_overlay_ = true; });
     connect(mainApp, &MainApplication::addressResolutionChanged, this, &PacketList::redrawVisiblePacketsDontSelectCurrent);
     connect(mainApp, &MainApplication::columnDataChanged, this, &PacketList::redrawVisiblePacketsDontSelectCurrent);
     connect(mainApp, &MainApplication::preferencesChanged, this, [=]() {
@@ -259,6 +260,7 @@ PacketList::PacketList(QWidget *parent) :
     connect(header(), &QHeaderView::sectionMoved, this, &PacketList::sectionMoved);
 
     connect(verticalScrollBar(), &QScrollBar::actionTriggered, this, &PacketList::vScrollBarActionTriggered);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &PacketList::prefetchAroundViewport);
 }
 
 PacketList::~PacketList()
@@ -1068,23 +1070,53 @@ void PacketList::setRecentColumnWidth(int col)
         }
         // Custom delegate padding
         if (itemDelegateForColumn(col)) {
-            QStyleOptionViewItem option;
+            col_width += columnPadding(col);
+        }
+    }
+
+    setColumnWidth(col, col_width);
+}
+
+int PacketList::columnPadding(int col) const
+{
+    QAbstractItemDelegate *delegate = itemDelegateForColumn(col);
+    if (!delegate) {
+        delegate = itemDelegate();
+    }
+
+    QStyleOptionViewItem option;
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-            initViewItemOption(&option);
+    initViewItemOption(&option);
 #else
-            option = viewOptions();
+    option = viewOptions();
 #endif
-            // This is adding "how much width hinted for an empty index, plus
-            // the decoration, plus any padding between the decoration and
-            // normal display?" Many styles however have a non zero hint for
-            // an empty index, so this isn't quite right. What we really want
-            // is a size hint for an index whose data is the string above, and
-            // to just use that for the width.
-            col_width += itemDelegateForColumn(col)->sizeHint(option, QModelIndex()).width();
-        }
+    // This is adding "how much width hinted for an empty index, plus
+    // the decoration, plus any padding between the decoration and
+    // normal display?" Many styles however have a non zero hint for
+    // an empty index, so this isn't quite right. What we really want
+    // is a size hint for an index whose data is the string above, and
+    // to just use that for the width.
+    return delegate->sizeHint(option, QModelIndex()).width();
+}
+
+// QTreeView measures a column by asking for the data of its rows, each
+// of which we would have to dissect. resizeColumnToContents() and
+// double-clicking a header divider use this, so instead go by the widest
+// text seen in rows dissected so far and in the rows the model samples
+// in the background.
+int PacketList::sizeHintForColumn(int column) const
+{
+    if (!cap_file_ || column < 0 || (unsigned)column >= cap_file_->cinfo.num_cols) {
+        return QTreeView::sizeHintForColumn(column);
     }
 
-    setColumnWidth(col, col_width);
+    QString text = PacketListRecord::widestColumnText(column);
+    if (text.isEmpty()) {
+        const char *long_str = get_column_width_string(get_column_format(column), column);
+        text = long_str ? long_str : MIN_COL_WIDTH_STR;
+    }
+
+    return fontMetrics().horizontalAdvance(text) + columnPadding(column);
 }
 
 void PacketList::drawCurrentPacket()
@@ -2203,6 +2235,18 @@ void PacketList::vScrollBarActionTriggered(int)
     scrollViewChanged(tail_at_end_);
 }
 
+// Have the model prepare the rows the user is about to scroll to.
+void PacketList::prefetchAroundViewport()
+{
+    if (!cap_file_ || cap_file_->state != FILE_READ_DONE) return;
+
+    QModelIndex first = indexAt(viewport()->rect().topLeft());
+    if (!first.isValid()) return;
+
+    QModelIndex last = indexAt(viewport()->rect().bottomLeft());
+    packet_list_model_->prefetchRows(first.row(), last.isValid() ? last.row() : packet_list_model_->rowCount() - 1);
+}
+
 void PacketList::scrollViewChanged(bool at_end)
 {
     if (capture_in_progress_) {
@@ -2407,6 +2451,23 @@ void PacketList::drawFarOverlay()
         // Hopefully no themes use the text color for the groove color.
         overlay.fill(Qt::transparent);
 
+        // Packet colors down the middle, leaving the sides for the ticks.
+        // The map is built by sampling in the background, one color per
+        // raster line, so that we don't have to colorize every packet.
+        packet_list_model_->buildColorMap(o_height);
+        const QVector<QRgb> &color_map = packet_list_model_->colorMap();
+        int tick_width = o_width / 3;
+        for (int line = 0; line < color_map.count(); line++) {
+            if (qAlpha(color_map[line]) == 0) {
+                continue;
+            }
+            // Translucent, so that the slider still shows through.
+            QColor color = QColor::fromRgba(color_map[line]);
+            color.setAlphaF(0.5f);
+            painter.fillRect(tick_width, line, o_width - (2 * tick_width), 1, color);
+            have_marked_image = true;
+        }
+
         QColor tick_color = palette().text().color();
         tick_color.setAlphaF(0.3f);
         painter.setPen(tick_color);
@@ -2416,7 +2477,6 @@ void PacketList::drawFarOverlay()
             frame_data *fdata = packet_list_model_->getRowFdata(row);
             if (fdata->marked || fdata->ref_time || fdata->ignored) {
                 int new_line = row * o_height / pl_rows;
-                int tick_width = o_width / 3;
                 // Marked or ignored: left side, time refs: right side.
                 // XXX Draw ignored ticks in the middle?
                 int x1 = fdata->ref_time ? o_width - tick_width : 1;
@@ -127,6 +127,7 @@ protected:
     virtual void mouseMoveEvent (QMouseEvent *event) override;
     virtual void resizeEvent(QResizeEvent *event) override;
     virtual void keyPressEvent(QKeyEvent *event) override;
+    virtual int sizeHintForColumn(int column) const override;
 
 protected slots:
     void rowsInserted(const QModelIndex &parent, int start, int end) override;
@@ -171,6 +172,7 @@ private:
     void setFrameReftime(bool set, frame_data *fdata);
     void setColumnVisibility();
     void setRecentColumnWidth(int column);
+    int columnPadding(int column) const;
     void drawCurrentPacket();
     void applyRecentColumnWidths();
     void scrollViewChanged(bool at_end);
@@ -220,6 +222,7 @@ private slots:
     void sectionMoved(int, int, int);
     void copySummary();
     void vScrollBarActionTriggered(int);
+    void prefetchAroundViewport();
     void drawFarOverlay();
     void drawNearOverlay();
     void updatePackets(bool redraw);
@@ -15,6 +15,7 @@
 #include <epan/prefs.h>
 #include <epan/prefs-int.h>
 #include <epan/decode_as.h>
+#include <epan/packet.h>
 #include <ui/language.h>
 #include <ui/preference_utils.h>
 #include <cfile.h>
@@ -42,29 +43,74 @@
 extern "C" {
 // Callbacks prefs routines
 
+typedef struct {
+    unsigned int changed_flags;     /* the effects of all the changed preferences */
+    bool must_redissect;            /* a change could alter how the packets read so far are dissected */
+} prefs_unstash_result_t;
+
+/*
+ * A preference of a protocol that isn't among the layers of any packet
+ * read so far can't have changed how those packets were dissected, unless
+ * it is one of those that decide which traffic is handed to the protocol
+ * in the first place: ports, ranges and dissector choices.
+ */
+static bool
+pref_change_affects_packets(module_t *module, pref_t *pref)
+{
+    int proto_id;
+
+    switch (prefs_get_type(pref)) {
+    case PREF_BOOL:
+    case PREF_ENUM:
+    case PREF_INT:
+    case PREF_STRING:
+    case PREF_SAVE_FILENAME:
+    case PREF_OPEN_FILENAME:
+    case PREF_DIRNAME:
+    case PREF_PASSWORD:
+        break;
+    default:
+        return true;
+    }
+
+    proto_id = proto_get_id_by_filter_name(module->name);
+    if (proto_id < 0)
+        return true;
+
+    return protocol_was_dissected(proto_id);
+}
+
 static unsigned
 module_prefs_unstash(module_t *module, void *data)
 {
-    unsigned int *must_redissect_p = static_cast<unsigned int *>(data);
+    prefs_unstash_result_t *result = static_cast<prefs_unstash_result_t *>(data);
     pref_unstash_data_t unstashed_data;
+    unsigned int changed_flags = 0;
 
     unstashed_data.handle_decode_as = true;
 
-    module->prefs_changed_flags = 0;        /* assume none of them changed */
     for (GList *pref_l = module->prefs; pref_l && pref_l->data; pref_l = gxx_list_next(pref_l)) {
         pref_t *pref = gxx_list_data(pref_t *, pref_l);
 
         if (prefs_is_preference_obsolete(pref) || prefs_get_type(pref) == PREF_STATIC_TEXT) continue;
 
         unstashed_data.module = module;
+        module->prefs_changed_flags = 0;
         pref_unstash(pref, &unstashed_data);
         commandline_options_drop(module->name, prefs_get_name(pref));
+
+        /* If it changed in a way that could cause packets to be dissected
+           differently, indicate that we must redissect and refilter the
+           current capture (if we have one). */
+        if ((module->prefs_changed_flags & PREF_EFFECT_DISSECTION) &&
+            pref_change_affects_packets(module, pref)) {
+            result->must_redissect = true;
+        }
+        changed_flags |= module->prefs_changed_flags;
     }
 
-    /* If any of them changed, indicate that we must redissect and refilter
-       the current capture (if we have one), as the preference change
-       could cause packets to be dissected differently. */
-    *must_redissect_p |= module->prefs_changed_flags;
+    module->prefs_changed_flags = changed_flags;
+    result->changed_flags |= changed_flags;
 
     if (prefs_module_has_submodules(module))
         return prefs_modules_foreach_submodules(module->submodules, module_prefs_unstash, data);
@@ -378,7 +424,8 @@ void PreferencesDialog::on_showChangedValuesCheckBox_toggled(bool checked)
 void PreferencesDialog::apply()
 {
     char* err = NULL;
-    unsigned int redissect_flags = 0;
+    unsigned int redissect_flags;
+    prefs_unstash_result_t unstash_result = { 0, false };
 
     // XXX - We should validate preferences as the user changes them, not here.
     //       Some, but not all, of the preference controls validate the input,
@@ -386,7 +433,8 @@ void PreferencesDialog::apply()
     //       "stashed" value is sometimes the last valid input, not, e.g., the
     //       input when the dialog was opened.
     // XXX - We're also too enthusiastic about setting must_redissect.
-    prefs_modules_for_all_modules(module_prefs_unstash, (void *)&redissect_flags);
+    prefs_modules_for_all_modules(module_prefs_unstash, (void *)&unstash_result);
+    redissect_flags = unstash_result.changed_flags;
 
     extcap_register_preferences();
 
@@ -405,7 +453,11 @@ void PreferencesDialog::apply()
     pd_ui_->filterExpressonsFrame->acceptChanges();
     pd_ui_->expertFrame->acceptChanges();
 #ifdef HAVE_LIBGNUTLS
-    redissect_flags |= pd_ui_->rsaKeysFrame->acceptChanges();
+    unsigned int rsa_keys_flags = pd_ui_->rsaKeysFrame->acceptChanges();
+    redissect_flags |= rsa_keys_flags;
+    if (rsa_keys_flags & PREF_EFFECT_DISSECTION) {
+        unstash_result.must_redissect = true;
+    }
 #endif
 
     //Filter expressions don't affect dissection, so there is no need to
@@ -448,7 +500,7 @@ void PreferencesDialog::apply()
         mainApp->emitAppSignal(MainApplication::FieldsChanged);
     }
 
-    if (redissect_flags & PREF_EFFECT_DISSECTION) {
+    if (unstash_result.must_redissect) {
         // Freeze the packet list early to avoid updating column data before doing a
         // full redissection. The packet list will be thawed when redissection is done.
         mainApp->emitAppSignal(MainApplication::FreezePacketList);
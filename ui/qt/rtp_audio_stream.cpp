@@ -36,6 +36,8 @@
 #include <QVariant>
 #include <QTimer>
 
+#include <algorithm>
+
 // To do:
 // - Only allow one rtpstream_info_t per RtpAudioStream?
 
@@ -57,6 +59,7 @@ RtpAudioStream::RtpAudioStream(QObject *parent, rtpstream_id_t *id, bool stereo_
     , audio_out_rate_(0)
     , audio_requested_out_rate_(0)
     , visual_sample_rate_(default_visual_sample_rate_)
+    , visual_sample_rate_used_(default_visual_sample_rate_)
     , max_sample_val_(1)
     , max_sample_val_used_(1)
     , color_(0)
@@ -161,14 +164,22 @@ void RtpAudioStream::clearPackets()
     first_packet_ = true;
 }
 
+double RtpAudioStream::tappedDuration() const
+{
+    if (rtp_packets_.isEmpty()) return 0.0;
+    return rtp_packets_.last()->arrive_offset;
+}
+
 void RtpAudioStream::reset(double global_start_time)
 {
     global_start_rel_time_ = global_start_time;
     stop_rel_time_ = start_rel_time_;
     audio_out_rate_ = 0;
     max_sample_val_ = 1;
-    packet_timestamps_.clear();
     visual_samples_.clear();
+    visual_sample_nos_.clear();
+    frame_start_nos_.clear();
+    frame_nums_.clear();
     out_of_seq_timestamps_.clear();
     jitter_drop_timestamps_.clear();
 }
@@ -259,6 +270,9 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
 
     int32_t resample_buff_bytes = 0x1000;
     SAMPLE *resample_buff = (SAMPLE *) g_malloc(resample_buff_bytes);
+    // Reused for every packet of the stream.
+    SAMPLE *decode_buff = NULL;
+    size_t decode_buff_bytes = 0;
     char *write_buff = NULL;
     qint64 write_bytes = 0;
     unsigned int channels = 0;
@@ -278,7 +292,6 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
     struct SpeexResamplerState_ *audio_resampler = NULL;
 
     for (int cur_packet = 0; cur_packet < rtp_packets_.size(); cur_packet++) {
-        SAMPLE *decode_buff = NULL;
         // TODO: Update a progress bar here.
         rtp_packet_t *rtp_packet = rtp_packets_[cur_packet];
 
@@ -301,7 +314,7 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
             last_sequence = rtp_packet->info->info_extended_seq_num - 1;
         }
 
-        size_t decoded_bytes = decode_rtp_packet(rtp_packet, &decode_buff, decoders_hash_, &channels, &sample_rate);
+        size_t decoded_bytes = decode_rtp_packet_buffer(rtp_packet, &decode_buff, &decode_buff_bytes, decoders_hash_, &channels, &sample_rate);
         // XXX: We don't actually *do* anything with channels, and just treat
         // everything as if it were mono
 
@@ -330,7 +343,6 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
             // We didn't decode anything. Clean up and prep for
             // the next packet.
             last_sequence = rtp_packet->info->info_extended_seq_num;
-            g_free(decode_buff);
             continue;
         }
 
@@ -465,9 +477,8 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
             audio_file_->frameWriteSamples(rtp_packet->frame_num, write_buff, write_bytes);
             last_sequence_w = last_sequence;
         }
-
-        g_free(decode_buff);
     }
+    g_free(decode_buff);
     g_free(resample_buff);
 
     if (audio_resampler) speex_resampler_destroy(audio_resampler);
@@ -491,8 +502,11 @@ void RtpAudioStream::decodeVisual()
     speex_resampler_reset_mem(visual_resampler_);
     speex_resampler_set_rate(visual_resampler_, audio_out_rate_, visual_sample_rate_);
 
-    packet_timestamps_.clear();
+    visual_sample_rate_used_ = visual_sample_rate_;
     visual_samples_.clear();
+    visual_sample_nos_.clear();
+    frame_start_nos_.clear();
+    frame_nums_.clear();
     max_sample_val_ = 1;
 
     // Skip silence at begin of the stream
@@ -510,19 +524,20 @@ void RtpAudioStream::decodeVisual()
             // Resample
             speex_resampler_process_int(visual_resampler_, 0, read_buff, &read_len, resample_buff, &out_len);
 
-            // Create timestamp and visual sample
+            // Create visual samples. Timestamps are derived from their
+            // positions, and frame numbers are kept once per frame.
+            if (out_len > 0) addVisualFrame(sample_no, frame_num);
             for (unsigned i = 0; i < out_len; i++) {
-                double time = start_rel_time_ + (double) sample_no / visual_sample_rate_;
-                packet_timestamps_[time] = frame_num;
                 if (qAbs(resample_buff[i]) > max_sample_val_) max_sample_val_ = qAbs(resample_buff[i]);
                 visual_samples_.append(resample_buff[i]);
+                visual_sample_nos_.append(sample_no);
                 sample_no++;
             }
         } else {
             // Insert end of line mark
-            double time = start_rel_time_ + (double) sample_no / visual_sample_rate_;
-            packet_timestamps_[time] = frame_num;
+            addVisualFrame(sample_no, frame_num);
             visual_samples_.append(SAMPLE_NaN);
+            visual_sample_nos_.append(sample_no);
             sample_no += out_len;
         }
     }
@@ -535,6 +550,17 @@ void RtpAudioStream::decodeVisual()
     audio_file_->setDataReadStage();
 }
 
+void RtpAudioStream::addVisualFrame(quint32 sample_no, quint32 frame_num)
+{
+    if (!frame_start_nos_.isEmpty() && frame_start_nos_.last() == sample_no) {
+        // Nothing visible of the previous frame; the later one wins
+        frame_nums_.last() = frame_num;
+    } else if (frame_nums_.isEmpty() || frame_nums_.last() != frame_num) {
+        frame_start_nos_.append(sample_no);
+        frame_nums_.append(frame_num);
+    }
+}
+
 const QStringList RtpAudioStream::payloadNames() const
 {
     QStringList payload_names = payload_names_.values();
@@ -544,14 +570,14 @@ const QStringList RtpAudioStream::payloadNames() const
 
 const QVector<double> RtpAudioStream::visualTimestamps(bool relative)
 {
-    QVector<double> ts_keys = packet_timestamps_.keys().toVector();
-    if (relative) return ts_keys;
+    QVector<double> timestamps;
+    double offset = relative ? start_rel_time_ : start_abs_offset_;
 
-    QVector<double> adj_timestamps;
-    for (int i = 0; i < ts_keys.size(); i++) {
-        adj_timestamps.append(ts_keys[i] + start_abs_offset_ - start_rel_time_);
+    timestamps.reserve(visual_sample_nos_.size());
+    for (int i = 0; i < visual_sample_nos_.size(); i++) {
+        timestamps.append(offset + (double) visual_sample_nos_[i] / visual_sample_rate_used_);
     }
-    return adj_timestamps;
+    return timestamps;
 }
 
 // Scale the height of the waveform to global scale (max_sample_val_used_)
@@ -561,6 +587,7 @@ const QVector<double> RtpAudioStream::visualSamples(int y_offset)
 {
     QVector<double> adj_samples;
     double scaled_offset = y_offset * stack_offset_;
+    adj_samples.reserve(visual_samples_.size());
     for (int i = 0; i < visual_samples_.size(); i++) {
         if (SAMPLE_NaN != visual_samples_[i]) {
             adj_samples.append(((double)visual_samples_[i] * INT16_MAX / max_sample_val_used_) + scaled_offset);
@@ -658,12 +685,20 @@ const QVector<double> RtpAudioStream::insertedSilenceSamples(int y_offset)
 
 quint32 RtpAudioStream::nearestPacket(double timestamp, bool is_relative)
 {
-    if (packet_timestamps_.size() < 1) return 0;
+    if (visual_sample_nos_.size() < 1) return 0;
 
     if (!is_relative) timestamp -= start_abs_offset_;
-    QMap<double, quint32>::iterator it = packet_timestamps_.lowerBound(timestamp);
-    if (it == packet_timestamps_.end()) return 0;
-    return it.value();
+    double position = (timestamp - start_rel_time_) * visual_sample_rate_used_;
+
+    // First visual sample at or after the timestamp...
+    auto sample_it = std::lower_bound(visual_sample_nos_.cbegin(), visual_sample_nos_.cend(), position,
+                                      [](quint32 sample_no, double pos) { return sample_no < pos; });
+    if (sample_it == visual_sample_nos_.cend()) return 0;
+
+    // ...and the frame it belongs to
+    auto frame_it = std::upper_bound(frame_start_nos_.cbegin(), frame_start_nos_.cend(), *sample_it);
+    if (frame_it == frame_start_nos_.cbegin()) return 0;
+    return frame_nums_.at(static_cast<int>(frame_it - frame_start_nos_.cbegin()) - 1);
 }
 
 QAudio::State RtpAudioStream::outputState() const
@@ -22,7 +22,6 @@
 
 #include <QAudio>
 #include <QColor>
-#include <QMap>
 #include <QObject>
 #include <QSet>
 #include <QVector>
@@ -64,6 +63,7 @@ public:
     double stopRelTime() const { return stop_rel_time_; }
     unsigned sampleRate() const { return first_sample_rate_; }
     unsigned playRate() const { return audio_out_rate_; }
+    double tappedDuration() const;
     void setRequestedPlayRate(unsigned new_rate) { audio_requested_out_rate_ = new_rate; }
     void setVisualSampleRate(unsigned new_rate) { visual_sample_rate_ = new_rate; }
     const QStringList payloadNames() const;
@@ -197,8 +197,11 @@ private:
     uint32_t visual_sample_rate_;
     QSet<QString> payload_names_;
     struct SpeexResamplerState_ *visual_resampler_;
-    QMap<double, quint32> packet_timestamps_;
+    uint32_t visual_sample_rate_used_;  // Rate of visual_samples_
     QVector<qint16> visual_samples_;
+    QVector<quint32> visual_sample_nos_;    // Position of each visual sample since the stream start
+    QVector<quint32> frame_start_nos_;      // Visual sample position where each frame starts...
+    QVector<quint32> frame_nums_;           // ...and its frame number
     QVector<double> out_of_seq_timestamps_;
     QVector<double> jitter_drop_timestamps_;
     QVector<double> wrong_timestamp_timestamps_;
@@ -224,6 +227,7 @@ private:
     quint32 calculateAudioOutRate(QAudioDeviceInfo out_device, unsigned int sample_rate, unsigned int requested_out_rate);
 #endif
     SAMPLE *resizeBufferIfNeeded(SAMPLE *buff, int32_t *buff_bytes, qint64 requested_size);
+    void addVisualFrame(quint32 sample_no, quint32 frame_num);
 
 private slots:
     void outputStateChanged(QAudio::State new_state);
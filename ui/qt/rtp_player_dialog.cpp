@@ -29,6 +29,7 @@
 #include <wsutil/pint.h>
 
 #include <ui/qt/utils/color_utils.h>
+#include <ui/qt/widgets/customplot.h>
 #include <ui/qt/widgets/qcustomplot.h>
 #include <ui/qt/utils/qt_ui_utils.h>
 #include "rtp_audio_stream.h"
@@ -49,7 +50,11 @@
 #include <QFrame>
 #include <QMenu>
 #include <QVBoxLayout>
+#include <QThread>
 #include <QTimer>
+#include <QtConcurrent>
+
+#include <atomic>
 
 #include <QAudioFormat>
 #include <QAudioOutput>
@@ -63,9 +68,6 @@
 #include <ui/qt/utils/stock_icon.h>
 #include "main_application.h"
 
-// To do:
-// - Threaded decoding?
-
 // Current and former RTP player bugs. Many have attachments that can be usef for testing.
 // Bug 3368 - The timestamp line in a RTP or RTCP packet display's "Not Representable"
 // Bug 3952 - VoIP Call RTP Player: audio played is corrupted when RFC2833 packets are present
@@ -174,6 +176,7 @@ RtpPlayerDialog::RtpPlayerDialog(QWidget &parent, CaptureFile &cf, bool capture_
     , marker_stream_requested_out_rate_(0)
     , last_ti_(0)
     , listener_removed_(true)
+    , retap_pending_(false)
     , block_redraw_(false)
     , lock_ui_(0)
     , read_capture_enabled_(capture_running)
@@ -224,7 +227,9 @@ RtpPlayerDialog::RtpPlayerDialog(QWidget &parent, CaptureFile &cf, bool capture_
     connect(ui->audioPlot, &QCustomPlot::mouseDoubleClick, this, &RtpPlayerDialog::graphDoubleClicked);
     connect(ui->audioPlot, &QCustomPlot::plottableClick, this, &RtpPlayerDialog::plotClicked);
 
+    CustomPlot::setupRendering(ui->audioPlot);
     cur_play_pos_ = new QCPItemStraightLine(ui->audioPlot);
+    CustomPlot::addToOverlay(cur_play_pos_);
     cur_play_pos_->setVisible(false);
 
     start_marker_pos_ = new QCPItemStraightLine(ui->audioPlot);
@@ -438,6 +443,25 @@ void RtpPlayerDialog::reject()
     RtpPlayerDialog::accept();
 }
 
+// Streams are often added in many small batches, e.g. when several calls
+// are played from the VoIP Calls dialog. Every retap reads the packets of
+// all streams, so collect the requests into a single pass.
+void RtpPlayerDialog::scheduleRetap()
+{
+    if (retap_pending_) return;
+    retap_pending_ = true;
+    QTimer::singleShot(0, this, SLOT(scheduledRetap()));
+}
+
+void RtpPlayerDialog::scheduledRetap()
+{
+    // Already done, or picked up when the running retap finishes
+    if (!retap_pending_ || !listener_removed_) return;
+
+    retap_pending_ = false;
+    retapPackets();
+}
+
 void RtpPlayerDialog::retapPackets()
 {
     if (!listener_removed_) {
@@ -480,10 +504,36 @@ void RtpPlayerDialog::retapPackets()
         }
         fillTappedColumns();
         rescanPackets(true);
+        if (retap_pending_) {
+            // Streams were added while we were busy
+            QTimer::singleShot(0, this, SLOT(scheduledRetap()));
+        }
     }
     unlockUI();
 }
 
+// Keep the waveforms of all streams below this many points in total. With
+// thousands of streams they are drawn at a lower resolution instead.
+static const double max_visual_samples_ = 20 * 1000 * 1000;
+static const unsigned min_visual_sample_rate_ = 50;
+
+unsigned RtpPlayerDialog::visualSampleRate()
+{
+    unsigned visual_sample_rate = static_cast<unsigned>(ui->visualSRSpinBox->value());
+    double total_duration = 0.0;
+
+    for (int row = 0; row < ui->streamTreeWidget->topLevelItemCount(); row++) {
+        QTreeWidgetItem *ti = ui->streamTreeWidget->topLevelItem(row);
+        RtpAudioStream *audio_stream = ti->data(stream_data_col_, Qt::UserRole).value<RtpAudioStream*>();
+        total_duration += audio_stream->tappedDuration();
+    }
+
+    if (total_duration * visual_sample_rate > max_visual_samples_) {
+        visual_sample_rate = qMax(min_visual_sample_rate_, static_cast<unsigned>(max_visual_samples_ / total_duration));
+    }
+    return visual_sample_rate;
+}
+
 void RtpPlayerDialog::rescanPackets(bool rescale_axes)
 {
     lockUI();
@@ -498,11 +548,14 @@ void RtpPlayerDialog::rescanPackets(bool rescale_axes)
     QAudioDeviceInfo cur_out_device = getCurrentDeviceInfo();
 #endif
     int row_count = ui->streamTreeWidget->topLevelItemCount();
+    unsigned visual_sample_rate = visualSampleRate();
+    QVector<RtpAudioStream *> audio_streams;
 
     // Reset stream values
     for (int row = 0; row < row_count; row++) {
         QTreeWidgetItem *ti = ui->streamTreeWidget->topLevelItem(row);
         RtpAudioStream *audio_stream = ti->data(stream_data_col_, Qt::UserRole).value<RtpAudioStream*>();
+
         audio_stream->setStereoRequired(stereo_available_);
         audio_stream->reset(first_stream_rel_start_time_);
 
@@ -520,10 +573,25 @@ void RtpPlayerDialog::rescanPackets(bool rescale_axes)
             break;
         }
         audio_stream->setTimingMode(timing_mode);
-
-	       //if (!cur_out_device.isNull()) {
-            audio_stream->decode(cur_out_device);
-        //}
+        audio_stream->setVisualSampleRate(visual_sample_rate);
+        audio_streams << audio_stream;
+    }
+
+    // Each stream has its own decoders, resamplers and audio file, so they
+    // are decoded on the thread pool. The payload type names are looked up
+    // once here first, as the lookup sets up its table on first use.
+    try_val_to_str_ext(0, get_external_value_string_ext("rtp_payload_type_short_vals_ext"));
+    std::atomic<int> decoded_streams(0);
+    QFuture<void> future = QtConcurrent::map(audio_streams, [&](RtpAudioStream *audio_stream) {
+        audio_stream->decode(cur_out_device);
+        decoded_streams++;
+    });
+    while (!future.isFinished()) {
+        if (row_count > 1) {
+            ui->hintLabel->setText("<i><small>" + tr("Decoding streams… %1 of %2").arg(decoded_streams.load()).arg(row_count) + "</i></small>");
+        }
+        mainApp->processEvents(QEventLoop::ExcludeUserInputEvents, 100);
+        QThread::msleep(25);
     }
 
     for (int col = 0; col < ui->streamTreeWidget->columnCount() - 1; col++) {
@@ -830,7 +898,7 @@ void RtpPlayerDialog::replaceRtpStreams(QVector<rtpstream_id_t *> stream_ids)
 
         unlockUI();
 #ifdef QT_MULTIMEDIA_LIB
-        QTimer::singleShot(0, this, SLOT(retapPackets()));
+        scheduleRetap();
 #endif
     } else {
         ws_warning("replaceRtpStreams was called while other thread locked it. Current call is ignored, try it later.");
@@ -856,7 +924,7 @@ void RtpPlayerDialog::addRtpStreams(QVector<rtpstream_id_t *> stream_ids)
 
         unlockUI();
 #ifdef QT_MULTIMEDIA_LIB
-        QTimer::singleShot(0, this, SLOT(retapPackets()));
+        scheduleRetap();
 #endif
     } else {
         ws_warning("addRtpStreams was called while other thread locked it. Current call is ignored, try it later.");
@@ -1342,7 +1410,7 @@ void RtpPlayerDialog::setPlayPosition(double secs)
     if (secs > cur_secs) {
         cur_play_pos_->point1->setCoords(secs, 0.0);
         cur_play_pos_->point2->setCoords(secs, 1.0);
-        ui->audioPlot->replot();
+        CustomPlot::replotOverlay(ui->audioPlot);
     }
 }
 
@@ -2133,13 +2201,14 @@ void RtpPlayerDialog::on_visualSRSpinBox_editingFinished()
     mainApp->processEvents();
 
     int row_count = ui->streamTreeWidget->topLevelItemCount();
+    unsigned visual_sample_rate = visualSampleRate();
 
     // Reset stream values
     for (int row = 0; row < row_count; row++) {
         QTreeWidgetItem *ti = ui->streamTreeWidget->topLevelItem(row);
         RtpAudioStream *audio_stream = ti->data(stream_data_col_, Qt::UserRole).value<RtpAudioStream*>();
 
-        audio_stream->setVisualSampleRate(static_cast<unsigned>(ui->visualSRSpinBox->value()));
+        audio_stream->setVisualSampleRate(visual_sample_rate);
         audio_stream->decodeVisual();
     }
 
@@ -2816,7 +2885,7 @@ void RtpPlayerDialog::rtpAnalysisRemove()
 void RtpPlayerDialog::on_actionReadCapture_triggered()
 {
 #ifdef QT_MULTIMEDIA_LIB
-    QTimer::singleShot(0, this, SLOT(retapPackets()));
+    scheduleRetap();
 #endif
 }
 
@@ -2848,7 +2917,7 @@ void RtpPlayerDialog::captureEvent(CaptureEvent e _U_)
         read_capture_enabled_ = new_read_capture_enabled;
         updateWidgets();
         if (retap) {
-            QTimer::singleShot(0, this, SLOT(retapPackets()));
+            scheduleRetap();
         }
     }
 #endif
@@ -151,6 +151,7 @@ private slots:
      * streams added using ::addRtpStream.
      */
     void retapPackets();
+    void scheduledRetap();
     void captureEvent(CaptureEvent e);
     /** Clear, decode, and redraw each stream.
      */
@@ -256,6 +257,7 @@ private:
     quint32 marker_stream_requested_out_rate_;
     QTreeWidgetItem *last_ti_;
     bool listener_removed_;
+    bool retap_pending_;
     QPushButton *read_btn_;
     QToolButton *inaudible_btn_;
     QToolButton *analyze_btn_;
@@ -322,6 +324,8 @@ private:
     void selectInaudible(bool select);
     QVector<rtpstream_id_t *>getSelectedRtpStreamIDs();
     void fillTappedColumns();
+    void scheduleRetap();
+    unsigned visualSampleRate();
 
 #else // QT_MULTIMEDIA_LIB
 private:
@@ -49,7 +49,7 @@ SCTPAssocAnalyseDialog::~SCTPAssocAnalyseDialog()
 const sctp_assoc_info_t* SCTPAssocAnalyseDialog::findAssocForPacket(capture_file* cf)
 {
     frame_data     *fdata;
-    GList          *list, *framelist;
+    GList          *list;
     const sctp_assoc_info_t *assoc;
     bool           frame_found = false;
 
@@ -64,17 +64,8 @@ const sctp_assoc_info_t* SCTPAssocAnalyseDialog::findAssocForPacket(capture_file
     while (list) {
         assoc = gxx_list_data(const sctp_assoc_info_t*, list);
 
-        framelist = g_list_first(assoc->frame_numbers);
-        uint32_t fn;
-        while (framelist) {
-            fn = GPOINTER_TO_UINT(framelist->data);
-            if (fn == fdata->num) {
-                frame_found = true;
-                break;
-            }
-            framelist = gxx_list_next(framelist);
-        }
-        if (frame_found) {
+        if (sctp_assoc_has_frame(assoc, fdata->num)) {
+            frame_found = true;
             return assoc;
         } else {
             list = gxx_list_next(list);
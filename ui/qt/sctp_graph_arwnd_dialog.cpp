@@ -42,6 +42,14 @@ SCTPGraphArwndDialog::SCTPGraphArwndDialog(QWidget *parent, const sctp_assoc_inf
     this->setWindowFlags(flags);
     this->setWindowTitle(tr("SCTP Data and Adv. Rec. Window over Time: %1 Port1 %2 Port2 %3")
             .arg(gchar_free_to_qstring(cf_get_display_name(cap_file_))).arg(assoc->port1).arg(assoc->port2));
+
+    redraw_timer_.setSingleShot(true);
+    redraw_timer_.setInterval(100);
+    connect(&redraw_timer_, &QTimer::timeout, this, [this]() { drawPoints(); });
+    connect(ui->sctpPlot->xAxis, QOverload<const QCPRange &>::of(&QCPAxis::rangeChanged),
+            &redraw_timer_, QOverload<>::of(&QTimer::start));
+    connect(ui->sctpPlot->yAxis, QOverload<const QCPRange &>::of(&QCPAxis::rangeChanged),
+            &redraw_timer_, QOverload<>::of(&QTimer::start));
     if ((direction == 1 && assoc->n_array_tsn1 == 0) || (direction == 2 && assoc->n_array_tsn2 == 0)) {
         QMessageBox msgBox;
         msgBox.setText(tr("No Data Chunks sent"));
@@ -57,45 +65,33 @@ SCTPGraphArwndDialog::~SCTPGraphArwndDialog()
     delete ui;
 }
 
-void SCTPGraphArwndDialog::drawArwndGraph(const sctp_assoc_info_t *selected_assoc)
+static uint32_t sack_arwnd(const sctp_assoc_info_t *assoc, int direction, const sctp_sack_chunk_t *sack)
 {
-    GList *listSACK = Q_NULLPTR, *tlist;
-    struct sack_chunk_header *sack_header;
-    struct nr_sack_chunk_header *nr_sack_header;
-    tsn_t *tsn;
-    uint8_t type;
-    uint32_t arwnd=0;
+    const void *chunk = sctp_assoc_sack_data(assoc, direction, sack);
 
-    if (direction == 1) {
-        listSACK = g_list_last(selected_assoc->sack1);
-        startArwnd = selected_assoc->arwnd2;
-    } else {
-        listSACK = g_list_last(selected_assoc->sack2);
-        startArwnd = selected_assoc->arwnd1;
+    if (sack->type == SCTP_NR_SACK_CHUNK_ID) {
+        return g_ntohl(static_cast<const struct nr_sack_chunk_header *>(chunk)->a_rwnd);
     }
-    bool detect_max_arwnd = (startArwnd == 0) ? true : false;
-
-    while (listSACK) {
-        tsn = gxx_list_data(tsn_t*, listSACK);
-        tlist = g_list_first(tsn->tsns);
-        while (tlist) {
-            type = gxx_list_data(struct chunk_header *, tlist)->type;
-            if (type == SCTP_SACK_CHUNK_ID) {
-                sack_header = gxx_list_data(struct sack_chunk_header *, tlist);
-                arwnd = g_ntohl(sack_header->a_rwnd);
-            } else if (type == SCTP_NR_SACK_CHUNK_ID) {
-                nr_sack_header = gxx_list_data(struct nr_sack_chunk_header *, tlist);
-                arwnd = g_ntohl(nr_sack_header->a_rwnd);
-            }
-            if (detect_max_arwnd && startArwnd < arwnd) {
-                startArwnd = arwnd;
-            }
+    return g_ntohl(static_cast<const struct sack_chunk_header *>(chunk)->a_rwnd);
+}
+
+void SCTPGraphArwndDialog::drawArwndGraph(const sctp_assoc_info_t *selected_assoc)
+{
+    GArray *sacks = (direction == 1) ? selected_assoc->sack1 : selected_assoc->sack2;
+    const QCPRange x_range = ui->sctpPlot->xAxis->range();
+    const QCPRange y_range = ui->sctpPlot->yAxis->range();
+    SCTPGraphDecimator decimator(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
+
+    for (unsigned i = 0; i < sacks->len; i++) {
+        const sctp_sack_chunk_t *sack = &g_array_index(sacks, sctp_sack_chunk_t, i);
+        uint32_t arwnd = sack_arwnd(selected_assoc, direction, sack);
+        double time = sack->secs + sack->usecs/1000000.0;
+
+        if (decimator.keep(time, arwnd)) {
             ya.append(arwnd);
-            xa.append(tsn->secs + tsn->usecs/1000000.0);
-            fa.append(tsn->frame_number);
-            tlist = gxx_list_next(tlist);
+            xa.append(time);
+            fa.append(sack->frame_number);
         }
-        listSACK = gxx_list_previous(listSACK);
     }
 
     QCPScatterStyle myScatter;
@@ -114,6 +110,25 @@ void SCTPGraphArwndDialog::drawArwndGraph(const sctp_assoc_info_t *selected_asso
         ui->sctpPlot->graph(0)->setLineStyle(QCPGraph::lsNone);
         ui->sctpPlot->graph(0)->setData(xa, ya);
     }
+}
+
+
+void SCTPGraphArwndDialog::drawGraph(const sctp_assoc_info_t *selected_assoc)
+{
+    GArray *sacks;
+
+    if (direction == 1) {
+        sacks = selected_assoc->sack1;
+        startArwnd = selected_assoc->arwnd2;
+    } else {
+        sacks = selected_assoc->sack2;
+        startArwnd = selected_assoc->arwnd1;
+    }
+    if (startArwnd == 0) {
+        for (unsigned i = 0; i < sacks->len; i++) {
+            startArwnd = qMax(startArwnd, sack_arwnd(selected_assoc, direction, &g_array_index(sacks, sctp_sack_chunk_t, i)));
+        }
+    }
 
     ui->sctpPlot->xAxis->setLabel(tr("time [secs]"));
     ui->sctpPlot->yAxis->setLabel(tr("Advertised Receiver Window [Bytes]"));
@@ -124,17 +139,27 @@ void SCTPGraphArwndDialog::drawArwndGraph(const sctp_assoc_info_t *selected_asso
     QCPRange myYArwndRange(0, startArwnd);
     ui->sctpPlot->xAxis->setRange(myXArwndRange);
     ui->sctpPlot->yAxis->setRange(myYArwndRange);
-}
 
-
-void SCTPGraphArwndDialog::drawGraph(const sctp_assoc_info_t *selected_assoc)
-{
-    ui->sctpPlot->clearGraphs();
-    drawArwndGraph(selected_assoc);
     ui->sctpPlot->setInteractions(QCP::iRangeZoom | QCP::iRangeDrag | QCP::iSelectPlottables);
     ui->sctpPlot->axisRect(0)->setRangeZoomAxes(ui->sctpPlot->xAxis, ui->sctpPlot->yAxis);
     ui->sctpPlot->axisRect(0)->setRangeZoom(Qt::Horizontal);
     connect(ui->sctpPlot, &QCustomPlot::plottableClick, this, &SCTPGraphArwndDialog::graphClicked);
+    drawPoints(selected_assoc);
+}
+
+void SCTPGraphArwndDialog::drawPoints(const sctp_assoc_info_t *selected_assoc)
+{
+    if (!selected_assoc) {
+        selected_assoc = SCTPAssocAnalyseDialog::findAssoc(this, selected_assoc_id);
+        if (!selected_assoc) return;
+    }
+
+    redraw_timer_.stop();
+    ui->sctpPlot->clearGraphs();
+    xa.clear();
+    ya.clear();
+    fa.clear();
+    drawArwndGraph(selected_assoc);
     ui->sctpPlot->replot();
 }
 
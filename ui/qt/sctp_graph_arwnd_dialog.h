@@ -15,6 +15,7 @@
 #include "cfile.h"
 
 #include <QDialog>
+#include <QTimer>
 
 namespace Ui {
 class SCTPGraphArwndDialog;
@@ -53,8 +54,10 @@ private:
     QVector<double> xa, ya;
     QVector<uint32_t> fa;
  //   QVector<QString> typeStrings;
+    QTimer redraw_timer_;
 
     void drawGraph(const _sctp_assoc_info *selected_assoc);
+    void drawPoints(const _sctp_assoc_info *selected_assoc = NULL);
     void drawArwndGraph(const _sctp_assoc_info *selected_assoc);
 };
 
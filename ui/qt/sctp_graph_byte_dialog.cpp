@@ -41,6 +41,14 @@ SCTPGraphByteDialog::SCTPGraphByteDialog(QWidget *parent, const sctp_assoc_info_
     this->setWindowFlags(flags);
     this->setWindowTitle(tr("SCTP Data and Adv. Rec. Window over Time: %1 Port1 %2 Port2 %3")
             .arg(gchar_free_to_qstring(cf_get_display_name(cap_file_))).arg(assoc->port1).arg(assoc->port2));
+
+    redraw_timer_.setSingleShot(true);
+    redraw_timer_.setInterval(100);
+    connect(&redraw_timer_, &QTimer::timeout, this, [this]() { drawPoints(); });
+    connect(ui->sctpPlot->xAxis, QOverload<const QCPRange &>::of(&QCPAxis::rangeChanged),
+            &redraw_timer_, QOverload<>::of(&QTimer::start));
+    connect(ui->sctpPlot->yAxis, QOverload<const QCPRange &>::of(&QCPAxis::rangeChanged),
+            &redraw_timer_, QOverload<>::of(&QTimer::start));
     if ((direction == 1 && assoc->n_array_tsn1 == 0) || (direction == 2 && assoc->n_array_tsn2 == 0)) {
         QMessageBox msgBox;
         msgBox.setText(tr("No Data Chunks sent"));
@@ -59,42 +67,24 @@ SCTPGraphByteDialog::~SCTPGraphByteDialog()
 
 void SCTPGraphByteDialog::drawBytesGraph(const sctp_assoc_info_t *selected_assoc)
 {
-    GList *listTSN = Q_NULLPTR, *tlist = Q_NULLPTR;
-    tsn_t *tsn = Q_NULLPTR;
-    uint8_t type;
-    uint32_t maxBytes;
+    GArray *tsns = (direction == 1) ? selected_assoc->tsn1 : selected_assoc->tsn2;
     uint64_t sumBytes = 0;
+    const QCPRange x_range = ui->sctpPlot->xAxis->range();
+    const QCPRange y_range = ui->sctpPlot->yAxis->range();
+    SCTPGraphDecimator decimator(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
 
-    if (direction == 1) {
-        maxBytes = selected_assoc->n_data_bytes_ep1;
-        listTSN = g_list_last(selected_assoc->tsn1);
-    } else {
-        maxBytes = selected_assoc->n_data_bytes_ep2;
-        listTSN = g_list_last(selected_assoc->tsn2);
-    }
-
+    for (unsigned i = 0; i < tsns->len; i++) {
+        const sctp_tsn_chunk_t *tsn = &g_array_index(tsns, sctp_tsn_chunk_t, i);
+        double time = tsn->secs + tsn->usecs/1000000.0;
 
-    while (listTSN) {
-        tsn = gxx_list_data(tsn_t*, listTSN);
-        tlist = g_list_first(tsn->tsns);
-        uint16_t length;
-        while (tlist)
-        {
-            type = gxx_list_data(struct chunk_header *, tlist)->type;
-            if (type == SCTP_DATA_CHUNK_ID || type == SCTP_I_DATA_CHUNK_ID) {
-                length = g_ntohs(gxx_list_data(struct data_chunk_header *, tlist)->length);
-                if (type == SCTP_DATA_CHUNK_ID)
-                    length -= DATA_CHUNK_HEADER_LENGTH;
-                else
-                    length -= I_DATA_CHUNK_HEADER_LENGTH;
-                sumBytes += length;
+        if (tsn->type == SCTP_DATA_CHUNK_ID || tsn->type == SCTP_I_DATA_CHUNK_ID) {
+            sumBytes += tsn->length;
+            if (decimator.keep(time, sumBytes)) {
                 yb.append(sumBytes);
-                xb.append(tsn->secs + tsn->usecs/1000000.0);
+                xb.append(time);
                 fb.append(tsn->frame_number);
             }
-            tlist = gxx_list_next(tlist);
         }
-        listTSN = gxx_list_previous(listTSN);
     }
 
 
@@ -114,6 +104,16 @@ void SCTPGraphByteDialog::drawBytesGraph(const sctp_assoc_info_t *selected_assoc
         ui->sctpPlot->graph(0)->setLineStyle(QCPGraph::lsNone);
         ui->sctpPlot->graph(0)->setData(xb, yb);
     }
+}
+
+
+void SCTPGraphByteDialog::drawGraph()
+{
+    const sctp_assoc_info_t* selected_assoc = SCTPAssocAnalyseDialog::findAssoc(this, selected_assoc_id);
+    if (!selected_assoc) return;
+
+    uint32_t maxBytes = (direction == 1) ? selected_assoc->n_data_bytes_ep1 : selected_assoc->n_data_bytes_ep2;
+
     ui->sctpPlot->xAxis->setLabel(tr("time [secs]"));
     ui->sctpPlot->yAxis->setLabel(tr("Received Bytes"));
 
@@ -122,18 +122,25 @@ void SCTPGraphByteDialog::drawBytesGraph(const sctp_assoc_info_t *selected_assoc
     QCPRange myYByteRange(0, maxBytes);
     ui->sctpPlot->xAxis->setRange(myXByteRange);
     ui->sctpPlot->yAxis->setRange(myYByteRange);
-}
 
+    ui->sctpPlot->setInteractions(QCP::iRangeZoom | QCP::iRangeDrag | QCP::iSelectPlottables);
+    connect(ui->sctpPlot, &QCustomPlot::plottableClick, this, &SCTPGraphByteDialog::graphClicked);
+    drawPoints(selected_assoc);
+}
 
-void SCTPGraphByteDialog::drawGraph()
+void SCTPGraphByteDialog::drawPoints(const sctp_assoc_info_t *selected_assoc)
 {
-    const sctp_assoc_info_t* selected_assoc = SCTPAssocAnalyseDialog::findAssoc(this, selected_assoc_id);
-    if (!selected_assoc) return;
+    if (!selected_assoc) {
+        selected_assoc = SCTPAssocAnalyseDialog::findAssoc(this, selected_assoc_id);
+        if (!selected_assoc) return;
+    }
 
+    redraw_timer_.stop();
     ui->sctpPlot->clearGraphs();
+    xb.clear();
+    yb.clear();
+    fb.clear();
     drawBytesGraph(selected_assoc);
-    ui->sctpPlot->setInteractions(QCP::iRangeZoom | QCP::iRangeDrag | QCP::iSelectPlottables);
-    connect(ui->sctpPlot, &QCustomPlot::plottableClick, this, &SCTPGraphByteDialog::graphClicked);
     ui->sctpPlot->replot();
 }
 
@@ -15,6 +15,7 @@
 #include "cfile.h"
 
 #include <QDialog>
+#include <QTimer>
 
 namespace Ui {
 class SCTPGraphByteDialog;
@@ -51,8 +52,10 @@ private:
     int direction;
     QVector<double> xb, yb;
     QVector<uint32_t> fb;
+    QTimer redraw_timer_;
 
     void drawGraph();
+    void drawPoints(const _sctp_assoc_info *selected_assoc = NULL);
     void drawBytesGraph(const _sctp_assoc_info *selected_assoc);
 };
 
@@ -27,6 +27,32 @@
 #include "ui/qt/widgets/wireshark_file_dialog.h"
 #include "main_application.h"
 
+SCTPGraphDecimator::SCTPGraphDecimator(double x_lower, double x_upper, double y_lower, double y_upper) :
+    x_lower_(x_lower),
+    x_scale_(x_upper > x_lower ? resolution_ / (x_upper - x_lower) : 0),
+    y_lower_(y_lower),
+    y_scale_(y_upper > y_lower ? resolution_ / (y_upper - y_lower) : 0),
+    cells_(resolution_ * resolution_)
+{
+}
+
+bool SCTPGraphDecimator::keep(double x, double y)
+{
+    double col = (x - x_lower_) * x_scale_;
+    double row = (y - y_lower_) * y_scale_;
+
+    if (x < x_lower_ || col > resolution_ || y < y_lower_ || row > resolution_) {
+        return false;
+    }
+
+    int cell = qMin(int(row), resolution_ - 1) * resolution_ + qMin(int(col), resolution_ - 1);
+    if (cells_.testBit(cell)) {
+        return false;
+    }
+    cells_.setBit(cell);
+    return true;
+}
+
 SCTPGraphDialog::SCTPGraphDialog(QWidget *parent, const sctp_assoc_info_t *assoc,
         capture_file *cf, int dir) :
     QDialog(parent),
@@ -48,6 +74,14 @@ SCTPGraphDialog::SCTPGraphDialog(QWidget *parent, const sctp_assoc_info_t *assoc
     this->setWindowFlags(flags);
     this->setWindowTitle(tr("SCTP TSNs and SACKs over Time: %1 Port1 %2 Port2 %3")
             .arg(gchar_free_to_qstring(cf_get_display_name(cap_file_))).arg(assoc->port1).arg(assoc->port2));
+
+    redraw_timer_.setSingleShot(true);
+    redraw_timer_.setInterval(100);
+    connect(&redraw_timer_, &QTimer::timeout, this, [this]() { drawPoints(); });
+    connect(ui->sctpPlot->xAxis, QOverload<const QCPRange &>::of(&QCPAxis::rangeChanged),
+            &redraw_timer_, QOverload<>::of(&QTimer::start));
+    connect(ui->sctpPlot->yAxis, QOverload<const QCPRange &>::of(&QCPAxis::rangeChanged),
+            &redraw_timer_, QOverload<>::of(&QTimer::start));
     if ((direction == 1 && assoc->n_array_tsn1 == 0) || (direction == 2 && assoc->n_array_tsn2 == 0)) {
         QMessageBox msgBox;
         msgBox.setText(tr("No Data Chunks sent"));
@@ -65,150 +99,154 @@ SCTPGraphDialog::~SCTPGraphDialog()
 
 void SCTPGraphDialog::drawNRSACKGraph(const sctp_assoc_info_t* selected_assoc)
 {
-    tsn_t *sack = Q_NULLPTR;
-    GList *list = Q_NULLPTR, *tlist = Q_NULLPTR;
+    GArray *sacks;
     uint16_t gap_start=0, gap_end=0, i, numberOf_gaps, numberOf_nr_gaps;
-    uint8_t type;
     uint32_t tsnumber, j = 0, min_tsn, rel = 0;
-    struct nr_sack_chunk_header *nr_sack_header = Q_NULLPTR;
-    struct gaps *nr_gap = Q_NULLPTR;
+    const struct nr_sack_chunk_header *nr_sack_header = Q_NULLPTR;
+    const struct gaps *nr_gap = Q_NULLPTR;
     /* This holds the sum of gap acks and nr gap acks */
     uint16_t total_gaps = 0;
+    const QCPRange x_range = ui->sctpPlot->xAxis->range();
+    const QCPRange y_range = ui->sctpPlot->yAxis->range();
+    SCTPGraphDecimator gaps(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
+    SCTPGraphDecimator nr_gaps(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
+    SCTPGraphDecimator cum_acks(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
 
     if (direction == 1) {
-        list = g_list_last(selected_assoc->sack1);
+        sacks = selected_assoc->sack1;
         min_tsn = selected_assoc->min_tsn1;
     } else {
-        list = g_list_last(selected_assoc->sack2);
+        sacks = selected_assoc->sack2;
         min_tsn = selected_assoc->min_tsn2;
     }
     if (relative) {
         rel = min_tsn;
     }
-    while (list) {
-        sack = gxx_list_data(tsn_t*, list);
-        tlist = g_list_first(sack->tsns);
-        while (tlist) {
-            type = gxx_list_data(struct chunk_header *, tlist)->type;
-            if (type == SCTP_NR_SACK_CHUNK_ID) {
-                nr_sack_header = gxx_list_data(struct nr_sack_chunk_header *, tlist);
-                numberOf_nr_gaps=g_ntohs(nr_sack_header->nr_of_nr_gaps);
-                numberOf_gaps=g_ntohs(nr_sack_header->nr_of_gaps);
-                tsnumber = g_ntohl(nr_sack_header->cum_tsn_ack);
-                total_gaps = numberOf_gaps + numberOf_nr_gaps;
-                /* If the number of nr_gaps is greater than 0 */
-                if (total_gaps > 0) {
-                    nr_gap = &nr_sack_header->gaps[0];
-                    for (i = 0; i < total_gaps; i++) {
-                        gap_start = g_ntohs(nr_gap->start);
-                        gap_end = g_ntohs(nr_gap->end);
-                        for (j = gap_start; j <= gap_end; j++) {
-                            if (i >= numberOf_gaps) {
+    for (unsigned k = 0; k < sacks->len; k++) {
+        const sctp_sack_chunk_t *sack = &g_array_index(sacks, sctp_sack_chunk_t, k);
+        double time = sack->secs + sack->usecs/1000000.0;
+
+        if (sack->type == SCTP_NR_SACK_CHUNK_ID) {
+            nr_sack_header = static_cast<const struct nr_sack_chunk_header *>(sctp_assoc_sack_data(selected_assoc, direction, sack));
+            numberOf_nr_gaps=g_ntohs(nr_sack_header->nr_of_nr_gaps);
+            numberOf_gaps=g_ntohs(nr_sack_header->nr_of_gaps);
+            tsnumber = g_ntohl(nr_sack_header->cum_tsn_ack);
+            total_gaps = numberOf_gaps + numberOf_nr_gaps;
+            /* If the number of nr_gaps is greater than 0 */
+            if (total_gaps > 0) {
+                nr_gap = &nr_sack_header->gaps[0];
+                for (i = 0; i < total_gaps; i++) {
+                    gap_start = g_ntohs(nr_gap->start);
+                    gap_end = g_ntohs(nr_gap->end);
+                    for (j = gap_start; j <= gap_end; j++) {
+                        if (i >= numberOf_gaps) {
+                            if (nr_gaps.keep(time, j + tsnumber - rel)) {
                                 yn.append(j + tsnumber - rel);
-                                xn.append(sack->secs + sack->usecs/1000000.0);
+                                xn.append(time);
                                 fn.append(sack->frame_number);
-                            } else {
+                            }
+                        } else {
+                            if (gaps.keep(time, j + tsnumber - rel)) {
                                 yg.append(j + tsnumber - rel);
-                                xg.append(sack->secs + sack->usecs/1000000.0);
+                                xg.append(time);
                                 fg.append(sack->frame_number);
                             }
                         }
-                        if (i < total_gaps-1)
-                            nr_gap++;
                     }
+                    if (i < total_gaps-1)
+                        nr_gap++;
+                }
 
-                    if (tsnumber>=min_tsn) {
-                        ys.append(j + tsnumber - rel);
-                        xs.append(sack->secs + sack->usecs/1000000.0);
-                        fs.append(sack->frame_number);
-                    }
+                if (tsnumber>=min_tsn && cum_acks.keep(time, j + tsnumber - rel)) {
+                    ys.append(j + tsnumber - rel);
+                    xs.append(time);
+                    fs.append(sack->frame_number);
                 }
             }
-            tlist = gxx_list_next(tlist);
         }
-        list = gxx_list_previous(list);
     }
 }
 
 void SCTPGraphDialog::drawSACKGraph(const sctp_assoc_info_t* selected_assoc)
 {
-    GList *listSACK = Q_NULLPTR, *tlist = Q_NULLPTR;
+    GArray *sacks;
     uint16_t gap_start=0, gap_end=0, nr, dup_nr;
-    struct sack_chunk_header *sack_header = Q_NULLPTR;
-    struct gaps *gap = Q_NULLPTR;
-    tsn_t *tsn = Q_NULLPTR;
-    uint8_t type;
+    const struct sack_chunk_header *sack_header = Q_NULLPTR;
+    const struct gaps *gap = Q_NULLPTR;
     uint32_t tsnumber=0, rel = 0;
     uint32_t minTSN;
-    uint32_t *dup_list = Q_NULLPTR;
+    const uint32_t *dup_list = Q_NULLPTR;
     int i, j;
+    const QCPRange x_range = ui->sctpPlot->xAxis->range();
+    const QCPRange y_range = ui->sctpPlot->yAxis->range();
+    SCTPGraphDecimator gaps(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
+    SCTPGraphDecimator cum_acks(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
+    SCTPGraphDecimator dups(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
 
     if (direction == 1) {
         minTSN = selected_assoc->min_tsn1;
-        listSACK = g_list_last(selected_assoc->sack1);
+        sacks = selected_assoc->sack1;
     } else {
         minTSN = selected_assoc->min_tsn2;
-        listSACK = g_list_last(selected_assoc->sack2);
+        sacks = selected_assoc->sack2;
     }
     if (relative) {
         rel = minTSN;
     }
-    while (listSACK) {
-        tsn = gxx_list_data(tsn_t*, listSACK);
-        tlist = g_list_first(tsn->tsns);
-        while (tlist) {
-            type = gxx_list_data(struct chunk_header *, tlist)->type;
-            if (type == SCTP_SACK_CHUNK_ID) {
-                sack_header = gxx_list_data(struct sack_chunk_header *, tlist);
-                nr=g_ntohs(sack_header->nr_of_gaps);
-                tsnumber = g_ntohl(sack_header->cum_tsn_ack);
-                dup_nr=g_ntohs(sack_header->nr_of_dups);
-                if (nr>0) {  // Gap Reports green
-                    // Flexible Array Member #1.  XXX - UB in C++ technically;
-                    // also are we checking at any point that all the data is
-                    // there, since this was just copied straight from the TVB
-                    // and the overall chunk length might be inconsistent with
-                    // the number of gaps and duplicated TSNs indicated and/or
-                    // present.
-                    gap = &sack_header->gaps[0];
-                    for (i=0;i<nr; i++) {
-                        // Really we're just doing this, but as FAMs are UB
-                        // in C++ some compilers or run-times might complain.
-                        //gap = &sack_header->gaps[i];
-                        gap_start=g_ntohs(gap->start);
-                        gap_end = g_ntohs(gap->end);
-                        for (j=gap_start; j<=gap_end; j++) {
+    for (unsigned k = 0; k < sacks->len; k++) {
+        const sctp_sack_chunk_t *sack = &g_array_index(sacks, sctp_sack_chunk_t, k);
+        double time = sack->secs + sack->usecs/1000000.0;
+
+        if (sack->type == SCTP_SACK_CHUNK_ID) {
+            sack_header = static_cast<const struct sack_chunk_header *>(sctp_assoc_sack_data(selected_assoc, direction, sack));
+            nr=g_ntohs(sack_header->nr_of_gaps);
+            tsnumber = g_ntohl(sack_header->cum_tsn_ack);
+            dup_nr=g_ntohs(sack_header->nr_of_dups);
+            if (nr>0) {  // Gap Reports green
+                // Flexible Array Member #1.  XXX - UB in C++ technically;
+                // also are we checking at any point that all the data is
+                // there, since this was just copied straight from the TVB
+                // and the overall chunk length might be inconsistent with
+                // the number of gaps and duplicated TSNs indicated and/or
+                // present.
+                gap = &sack_header->gaps[0];
+                for (i=0;i<nr; i++) {
+                    // Really we're just doing this, but as FAMs are UB
+                    // in C++ some compilers or run-times might complain.
+                    //gap = &sack_header->gaps[i];
+                    gap_start=g_ntohs(gap->start);
+                    gap_end = g_ntohs(gap->end);
+                    for (j=gap_start; j<=gap_end; j++) {
+                        if (gaps.keep(time, j + tsnumber - rel)) {
                             yg.append(j + tsnumber - rel);
-                            xg.append(tsn->secs + tsn->usecs/1000000.0);
-                            fg.append(tsn->frame_number);
+                            xg.append(time);
+                            fg.append(sack->frame_number);
                         }
-                        if (i < nr-1)
-                            gap++;
                     }
+                    if (i < nr-1)
+                        gap++;
                 }
-                if (tsnumber>=minTSN) { // CumTSNAck red
-                    ys.append(tsnumber - rel);
-                    xs.append(tsn->secs + tsn->usecs/1000000.0);
-                    fs.append(tsn->frame_number);
-                }
-                if (dup_nr > 0) { // Duplicates cyan
-                    // XXX - Flexible Array Member #2, basically. This is sort
-                    // of horrifying. Jump over the gaps array to where the
-                    // duplicated TSN array should be.
-                    dup_list = (uint32_t*)(&sack_header->gaps[0] + nr);
-                    for (i = 0; i < dup_nr; i++) {
-                        tsnumber = g_ntohl(dup_list[i]);
-                        if (tsnumber >= minTSN) {
-                            yd.append(tsnumber - rel);
-                            xd.append(tsn->secs + tsn->usecs/1000000.0);
-                            fd.append(tsn->frame_number);
-                        }
+            }
+            if (tsnumber>=minTSN && cum_acks.keep(time, tsnumber - rel)) { // CumTSNAck red
+                ys.append(tsnumber - rel);
+                xs.append(time);
+                fs.append(sack->frame_number);
+            }
+            if (dup_nr > 0) { // Duplicates cyan
+                // XXX - Flexible Array Member #2, basically. This is sort
+                // of horrifying. Jump over the gaps array to where the
+                // duplicated TSN array should be.
+                dup_list = (const uint32_t*)(&sack_header->gaps[0] + nr);
+                for (i = 0; i < dup_nr; i++) {
+                    tsnumber = g_ntohl(dup_list[i]);
+                    if (tsnumber >= minTSN && dups.keep(time, tsnumber - rel)) {
+                        yd.append(tsnumber - rel);
+                        xd.append(time);
+                        fd.append(sack->frame_number);
                     }
                 }
             }
-            tlist = gxx_list_next(tlist);
         }
-        listSACK = gxx_list_previous(listSACK);
     }
 
     QCPScatterStyle myScatter;
@@ -272,16 +310,17 @@ void SCTPGraphDialog::drawSACKGraph(const sctp_assoc_info_t* selected_assoc)
 
 void SCTPGraphDialog::drawTSNGraph(const sctp_assoc_info_t* selected_assoc)
 {
-    GList *listTSN = Q_NULLPTR,*tlist = Q_NULLPTR;
-    tsn_t *tsn = Q_NULLPTR;
-    uint8_t type;
-    uint32_t tsnumber=0, rel = 0, minTSN;
+    GArray *tsns;
+    uint32_t rel = 0, minTSN;
+    const QCPRange x_range = ui->sctpPlot->xAxis->range();
+    const QCPRange y_range = ui->sctpPlot->yAxis->range();
+    SCTPGraphDecimator decimator(x_range.lower, x_range.upper, y_range.lower, y_range.upper);
 
     if (direction == 1) {
-        listTSN = g_list_last(selected_assoc->tsn1);
+        tsns = selected_assoc->tsn1;
          minTSN = selected_assoc->min_tsn1;
     } else {
-        listTSN = g_list_last(selected_assoc->tsn2);
+        tsns = selected_assoc->tsn2;
          minTSN = selected_assoc->min_tsn2;
     }
 
@@ -289,21 +328,17 @@ void SCTPGraphDialog::drawTSNGraph(const sctp_assoc_info_t* selected_assoc)
         rel = minTSN;
      }
 
-    while (listTSN) {
-        tsn = gxx_list_data(tsn_t*, listTSN);
-        tlist = g_list_first(tsn->tsns);
-        while (tlist)
-        {
-            type = gxx_list_data(struct chunk_header *, tlist)->type;
-            if (type == SCTP_DATA_CHUNK_ID || type == SCTP_I_DATA_CHUNK_ID || type == SCTP_FORWARD_TSN_CHUNK_ID) {
-                tsnumber = g_ntohl(gxx_list_data(struct data_chunk_header *, tlist)->tsn);
-                yt.append(tsnumber - rel);
-                xt.append(tsn->secs + tsn->usecs/1000000.0);
+    for (unsigned k = 0; k < tsns->len; k++) {
+        const sctp_tsn_chunk_t *tsn = &g_array_index(tsns, sctp_tsn_chunk_t, k);
+        double time = tsn->secs + tsn->usecs/1000000.0;
+
+        if (tsn->type == SCTP_DATA_CHUNK_ID || tsn->type == SCTP_I_DATA_CHUNK_ID || tsn->type == SCTP_FORWARD_TSN_CHUNK_ID) {
+            if (decimator.keep(time, tsn->tsn - rel)) {
+                yt.append(tsn->tsn - rel);
+                xt.append(time);
                 ft.append(tsn->frame_number);
             }
-            tlist = gxx_list_next(tlist);
         }
-        listTSN = gxx_list_previous(listTSN);
     }
 
     QCPScatterStyle myScatter;
@@ -342,6 +377,32 @@ void SCTPGraphDialog::drawGraph(const sctp_assoc_info_t* selected_assoc)
         maxTSN = selected_assoc->max_tsn2;
         minTSN = selected_assoc->min_tsn2;
     }
+    // give the axes some labels:
+    ui->sctpPlot->xAxis->setLabel(tr("time [secs]"));
+    ui->sctpPlot->yAxis->setLabel(tr("TSNs"));
+    ui->sctpPlot->setInteractions(QCP::iRangeZoom | QCP::iRangeDrag | QCP::iSelectPlottables);
+    connect(ui->sctpPlot, &QCustomPlot::plottableClick, this, &SCTPGraphDialog::graphClicked);
+    // set axes ranges, so we see all data:
+    QCPRange myXRange(selected_assoc->min_secs, (selected_assoc->max_secs+1));
+    if (relative) {
+        QCPRange myYRange(0, maxTSN - minTSN + 1);
+        ui->sctpPlot->yAxis->setRange(myYRange);
+    } else {
+        QCPRange myYRange(minTSN, maxTSN + 1);
+        ui->sctpPlot->yAxis->setRange(myYRange);
+    }
+    ui->sctpPlot->xAxis->setRange(myXRange);
+    drawPoints(selected_assoc);
+}
+
+void SCTPGraphDialog::drawPoints(const sctp_assoc_info_t* selected_assoc)
+{
+    if (!selected_assoc) {
+        selected_assoc = SCTPAssocAnalyseDialog::findAssoc(this, selected_assoc_id);
+        if (!selected_assoc) return;
+    }
+
+    redraw_timer_.stop();
     ui->sctpPlot->clearGraphs();
     xt.clear();
     yt.clear();
@@ -378,22 +439,6 @@ void SCTPGraphDialog::drawGraph(const sctp_assoc_info_t* selected_assoc)
         drawNRSACKGraph(selected_assoc);
         break;
     }
-
-    // give the axes some labels:
-    ui->sctpPlot->xAxis->setLabel(tr("time [secs]"));
-    ui->sctpPlot->yAxis->setLabel(tr("TSNs"));
-    ui->sctpPlot->setInteractions(QCP::iRangeZoom | QCP::iRangeDrag | QCP::iSelectPlottables);
-    connect(ui->sctpPlot, &QCustomPlot::plottableClick, this, &SCTPGraphDialog::graphClicked);
-    // set axes ranges, so we see all data:
-    QCPRange myXRange(selected_assoc->min_secs, (selected_assoc->max_secs+1));
-    if (relative) {
-        QCPRange myYRange(0, maxTSN - minTSN + 1);
-        ui->sctpPlot->yAxis->setRange(myYRange);
-    } else {
-        QCPRange myYRange(minTSN, maxTSN + 1);
-        ui->sctpPlot->yAxis->setRange(myYRange);
-    }
-    ui->sctpPlot->xAxis->setRange(myXRange);
     ui->sctpPlot->replot();
 }
 
@@ -14,7 +14,9 @@
 
 #include "cfile.h"
 
+#include <QBitArray>
 #include <QDialog>
+#include <QTimer>
 
 namespace Ui {
 class SCTPGraphDialog;
@@ -72,6 +74,23 @@ struct nr_sack_chunk_header {
 };
 
 
+// Keeps at most one point in each cell of a grid over the visible part of
+// a graph. Associations can have millions of chunks, and points closer
+// together than the cells can't be told apart on the plot; the dialogs
+// draw their points again when the graph is zoomed or dragged.
+class SCTPGraphDecimator
+{
+public:
+    SCTPGraphDecimator(double x_lower, double x_upper, double y_lower, double y_upper);
+    bool keep(double x, double y);
+
+private:
+    static const int resolution_ = 1024;
+    double x_lower_, x_scale_;
+    double y_lower_, y_scale_;
+    QBitArray cells_;
+};
+
 class SCTPGraphDialog : public QDialog
 {
     Q_OBJECT
@@ -111,8 +130,10 @@ private:
     QVector<QString> typeStrings;
     bool relative;
     int type;
+    QTimer redraw_timer_;
 
     void drawGraph(const _sctp_assoc_info* selected_assoc = NULL);
+    void drawPoints(const _sctp_assoc_info* selected_assoc = NULL);
     void drawTSNGraph(const _sctp_assoc_info* selected_assoc);
     void drawSACKGraph(const _sctp_assoc_info* selected_assoc);
     void drawNRSACKGraph(const _sctp_assoc_info* selected_assoc);
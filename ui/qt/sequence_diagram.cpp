@@ -24,34 +24,22 @@
 #include <QPen>
 #include <QPointF>
 
+#include <cmath>
+
 const int max_comment_em_width_ = 20;
 
 // UML-like network node sequence diagrams.
 // https://developer.ibm.com/articles/the-sequence-diagram/
 
-WSCPSeqData::WSCPSeqData() :
-  key(0),
-  value(NULL)
-{
-}
-
-WSCPSeqData::WSCPSeqData(double key, struct _seq_analysis_item *value) :
-  key(key),
-  value(value)
-{
-}
-
 SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *commentAxis) :
     QCPAbstractPlottable(keyAxis, valueAxis),
     key_axis_(keyAxis),
     value_axis_(valueAxis),
     comment_axis_(commentAxis),
-    data_(NULL),
     sainfo_(NULL),
     selected_packet_(0),
     selected_key_(-1.0)
 {
-    data_ = new WSCPSeqDataMap();
     // xaxis (value): Address
     // yaxis (key): Time
     // yaxis2 (comment): Extra info ("Comment" in GTK+)
@@ -104,58 +92,31 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
 
 SequenceDiagram::~SequenceDiagram()
 {
-    delete data_;
 }
 
 int SequenceDiagram::adjacentPacket(bool next)
 {
-    int adjacent_packet = -1;
-    WSCPSeqDataMap::const_iterator it;
+    int adjacent_key;
 
-    if (data_->size() < 1) return adjacent_packet;
+    if (items_.size() < 1) return -1;
 
     if (selected_packet_ < 1) {
-        if (next) {
-            it = data_->constBegin();
-        } else {
-            it = data_->constEnd();
-            --it;
-        }
-        selected_key_ = it.value().key;
-        return it.value().value->frame_number;
-    }
-
-    if (next) {
-        for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-            if (it.value().value->frame_number == selected_packet_) {
-                ++it;
-                if (it != data_->constEnd()) {
-                    adjacent_packet = it.value().value->frame_number;
-                    selected_key_ = it.value().key;
-                }
-                break;
-            }
-        }
+        adjacent_key = next ? 0 : static_cast<int>(items_.size()) - 1;
     } else {
-        it = data_->constEnd();
-        --it;
-        while (it != data_->constBegin()) {
-            uint32_t prev_frame = it.value().value->frame_number;
-            --it;
-            if (prev_frame == selected_packet_) {
-                adjacent_packet = it.value().value->frame_number;
-                selected_key_ = it.value().key;
-                break;
-            }
-        }
+        int selected_key = frame_keys_.value(selected_packet_, -1);
+        if (selected_key < 0) return -1;
+
+        adjacent_key = next ? selected_key + 1 : selected_key - 1;
+        if (adjacent_key < 0 || adjacent_key >= items_.size()) return -1;
     }
 
-    return adjacent_packet;
+    selected_key_ = adjacent_key;
+    return items_.at(adjacent_key)->frame_number;
 }
 
 void SequenceDiagram::setData(_seq_analysis_info *sainfo)
 {
-    data_->clear();
+    clearData();
     sainfo_ = sainfo;
     if (!sainfo) return;
 
@@ -167,11 +128,10 @@ void SequenceDiagram::setData(_seq_analysis_info *sainfo)
     for (GList *cur = g_queue_peek_nth_link(sainfo->items, 0); cur; cur = gxx_list_next(cur)) {
         seq_analysis_item_t *sai = gxx_list_data(seq_analysis_item_t *, cur);
         if (sai->display) {
-            WSCPSeqData new_data;
-
-            new_data.key = cur_key;
-            new_data.value = sai;
-            data_->insert(new_data.key, new_data);
+            if (!frame_keys_.contains(sai->frame_number)) {
+                frame_keys_.insert(sai->frame_number, static_cast<int>(items_.size()));
+            }
+            items_.append(sai);
 
             key_ticks.append(cur_key);
             key_labels.append(sai->time_str);
@@ -206,6 +166,7 @@ void SequenceDiagram::setSelectedPacket(int selected_packet)
     selected_key_ = -1;
     if (selected_packet > 0) {
         selected_packet_ = selected_packet;
+        selected_key_ = frame_keys_.value(selected_packet_, -1);
     } else {
         selected_packet_ = 0;
     }
@@ -216,8 +177,8 @@ _seq_analysis_item *SequenceDiagram::itemForPosY(int ypos)
 {
     double key_pos = qRound(key_axis_->pixelToCoord(ypos));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
-        return data_->value(key_pos).value;
+    if (key_pos >= 0 && key_pos < items_.size()) {
+        return items_.at(static_cast<int>(key_pos));
     }
     return NULL;
 }
@@ -240,7 +201,7 @@ double SequenceDiagram::selectTest(const QPointF &pos, bool, QVariant *) const
 {
     double key_pos = qRound(key_axis_->pixelToCoord(pos.y()));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
+    if (key_pos >= 0 && key_pos < items_.size()) {
         return 1.0;
     }
 
@@ -268,10 +229,15 @@ void SequenceDiagram::draw(QCPPainter *painter)
     painter->restore();
     fg_pen = pen();
 
-    WSCPSeqDataMap::const_iterator it;
-    for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-        double cur_key = it.key();
-        seq_analysis_item_t *sai = it.value().value;
+    // Only rows that overlap the visible key range. Each row extends half
+    // a key above and below its center.
+    if (items_.isEmpty()) return;
+    int first_key = qMax(0, static_cast<int>(std::floor(key_axis_->range().lower - 0.5)));
+    int last_key = qMin(static_cast<int>(items_.size()) - 1, static_cast<int>(std::ceil(key_axis_->range().upper + 0.5)));
+
+    for (int key = first_key; key <= last_key; key++) {
+        double cur_key = key;
+        seq_analysis_item_t *sai = items_.at(key);
         QColor bg_color;
 
         if (sai->frame_number == selected_packet_) {
@@ -384,22 +350,13 @@ void SequenceDiagram::drawLegendIcon(QCPPainter *, const QRectF &) const
 QCPRange SequenceDiagram::getKeyRange(bool &validRange, QCP::SignDomain) const
 {
     QCPRange range;
-    bool valid = false;
 
-    WSCPSeqDataMap::const_iterator it = data_->constBegin();
-    while (it != data_->constEnd()) {
-        double cur_key = it.key();
-        if (!valid) {
-            range.lower = range.upper = cur_key;
-            valid = true;
-        } else if (cur_key < range.lower) {
-            range.lower = cur_key;
-        } else if (cur_key > range.upper) {
-            range.upper = cur_key;
-        }
-        ++it;
+    // Keys are the row numbers 0 .. n-1.
+    validRange = !items_.isEmpty();
+    if (validRange) {
+        range.lower = 0;
+        range.upper = items_.size() - 1;
     }
-    validRange = valid;
     return range;
 }
 
@@ -410,7 +367,7 @@ QCPRange SequenceDiagram::getValueRange(bool &validRange, QCP::SignDomain, const
 
     if (sainfo_) {
         range.lower = 0;
-        range.upper = data_->size();
+        range.upper = items_.size();
         valid = true;
     }
     validRange = valid;
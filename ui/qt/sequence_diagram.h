@@ -15,24 +15,13 @@
 #include <epan/address.h>
 
 #include <QObject>
-#include <QMultiMap>
+#include <QHash>
+#include <QVector>
 #include <ui/qt/widgets/qcustomplot.h>
 
 struct _seq_analysis_info;
 struct _seq_analysis_item;
 
-// Some of this is probably unnecessary
-class WSCPSeqData
-{
-public:
-  WSCPSeqData();
-  WSCPSeqData(double key, _seq_analysis_item *value);
-  double key;
-  struct _seq_analysis_item *value;
-};
-
-typedef QMultiMap<double, WSCPSeqData> WSCPSeqDataMap;
-
 class SequenceDiagram : public QCPAbstractPlottable
 {
     Q_OBJECT
@@ -55,7 +44,7 @@ public:
     QString elidedComment(const QString &text) const;
 
     // reimplemented virtual methods:
-    virtual void clearData() { data_->clear(); }
+    virtual void clearData() { items_.clear(); frame_keys_.clear(); }
     virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=0) const Q_DECL_OVERRIDE;
 
 public slots:
@@ -71,7 +60,10 @@ private:
     QCPAxis *key_axis_;
     QCPAxis *value_axis_;
     QCPAxis *comment_axis_;
-    WSCPSeqDataMap *data_;
+    // Displayed items, indexed by key (row). Only the rows in the visible
+    // key range are looked at when drawing.
+    QVector<struct _seq_analysis_item *> items_;
+    QHash<uint32_t, int> frame_keys_; // Frame number -> key of its first row
     struct _seq_analysis_info *sainfo_;
     uint32_t selected_packet_;
     double selected_key_;
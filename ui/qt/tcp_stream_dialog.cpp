@@ -26,6 +26,7 @@
 #include "progress_frame.h"
 #include "main_application.h"
 #include "ui/qt/widgets/wireshark_file_dialog.h"
+#include "ui/qt/widgets/customplot.h"
 #include "ui/qt/widgets/qcp_axis_ticker_si.h"
 #include "ui/recent.h"
 
@@ -312,6 +313,7 @@ TCPStreamDialog::TCPStreamDialog(QWidget *parent, const CaptureFile& cf, tcp_gra
     // Base Graph - enables selecting segments (both data and SACKs)
     base_graph_ = sp->addGraph();
     base_graph_->setPen(QPen(QBrush(graph_color_1), pen_width));
+    base_decimator_.setGraph(base_graph_);
 
     // Throughput Graph - rate of sent bytes
     tput_graph_ = sp->addGraph(sp->xAxis, sp->yAxis2);
@@ -343,6 +345,7 @@ TCPStreamDialog::TCPStreamDialog(QWidget *parent, const CaptureFile& cf, tcp_gra
     ack_graph_->setPen(QPen(QBrush(graph_color_2), pen_width));
     ack_graph_->setLineStyle(QCPGraph::lsStepLeft);
     ack_graph_->setName(tr("ACK"));
+    ack_decimator_.setGraph(ack_graph_);
 
     // Duplicate ACK Graph - displays duplicate ack ticks
     // QCustomPlot doesn't have QCPScatterStyle::ssTick so we have to make our own.
@@ -390,6 +393,7 @@ TCPStreamDialog::TCPStreamDialog(QWidget *parent, const CaptureFile& cf, tcp_gra
     rwin_graph_->setPen(QPen(QBrush(graph_color_3), pen_width));
     rwin_graph_->setLineStyle(QCPGraph::lsStepLeft);
     rwin_graph_->setName(tr("Receive Window"));
+    rwin_decimator_.setGraph(rwin_graph_);
 
     // Zero Window Graph - displays zero window crosses (x)
     zero_win_graph_ = sp->addGraph();
@@ -412,7 +416,9 @@ TCPStreamDialog::TCPStreamDialog(QWidget *parent, const CaptureFile& cf, tcp_gra
     sp->yAxis->setNumberPrecision(9);
     sp->yAxis2->setNumberPrecision(9);
 
+    CustomPlot::setupRendering(sp);
     tracer_ = new QCPItemTracer(sp);
+    CustomPlot::addToOverlay(tracer_);
 
     // Default the legend to the top left
     sp->axisRect()->insetLayout()->setInsetAlignment(0, Qt::AlignTop|Qt::AlignLeft);
@@ -675,6 +681,10 @@ void TCPStreamDialog::fillGraph(bool reset_axes, bool set_focus)
     base_graph_->setLineStyle(QCPGraph::lsNone);
     tracer_->setGraph(NULL);
 
+    base_decimator_.clear();
+    ack_decimator_.clear();
+    rwin_decimator_.clear();
+
     // base_graph_ is always visible.
     for (int i = 0; i < sp->graphCount(); i++) {
         sp->graph(i)->data()->clear();
@@ -1046,7 +1056,7 @@ void TCPStreamDialog::fillStevens()
         rel_time.append(ts - ts_offset_);
         seq.append(seg->th_seq - seq_offset_);
     }
-    base_graph_->setData(rel_time, seq);
+    base_decimator_.setData(rel_time, seq);
 }
 
 void TCPStreamDialog::fillTcptrace()
@@ -1146,8 +1156,8 @@ void TCPStreamDialog::fillTcptrace()
             rwin.append(ackno + seg->th_win);
         }
     }
-    base_graph_->setData(pkt_time, pkt_seqnums, true);
-    ack_graph_->setData(ackrwin_time, ack, true);
+    base_decimator_.setData(pkt_time, pkt_seqnums, true);
+    ack_decimator_.setData(ackrwin_time, ack, true);
     seg_graph_->setData(sb_time, sb_center, true);
     seg_eb_->setData(sb_span);
     sack_graph_->setData(sack_time, sack_center, true);
@@ -1155,7 +1165,7 @@ void TCPStreamDialog::fillTcptrace()
     sack2_graph_->setData(sack2_time, sack2_center, true);
     sack2_eb_->setData(sack2_span);
     rwin_graph_->setValueAxis(sp->yAxis);
-    rwin_graph_->setData(ackrwin_time, rwin, true);
+    rwin_decimator_.setData(ackrwin_time, rwin, true);
     dup_ack_graph_->setData(dup_ack_time, dup_ack, true);
     zero_win_graph_->setData(zero_win_time, zero_win, true);
 }
@@ -2150,7 +2160,7 @@ void TCPStreamDialog::mouseMoved(QMouseEvent *event)
             tracer_->setVisible(false);
             hint += "Hover over the graph for details. " + stream_desc_ + "</i></small>";
             ui->hintLabel->setText(hint);
-            ui->streamPlot->replot(QCustomPlot::rpQueuedReplot);
+            CustomPlot::replotOverlay(sp);
             return;
         }
 
@@ -2169,7 +2179,7 @@ void TCPStreamDialog::mouseMoved(QMouseEvent *event)
                 .arg(packet_seg->th_ack)
                 .arg(packet_seg->th_win);
         tracer_->setGraphKey(ui->streamPlot->xAxis->pixelToCoord(event->pos().x()));
-        sp->replot(QCustomPlot::rpQueuedReplot);
+        CustomPlot::replotOverlay(sp);
     } else {
         if (rubber_band_ && rubber_band_->isVisible() && event) {
             rubber_band_->setGeometry(QRect(rb_origin_, event->pos()).normalized());
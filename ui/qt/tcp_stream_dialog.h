@@ -24,6 +24,7 @@
 #include "geometry_state_dialog.h"
 
 #include <ui/qt/widgets/qcustomplot.h>
+#include <ui/qt/widgets/qcp_graph_decimator.h>
 #include <QMenu>
 #include <QRubberBand>
 #include <QTimer>
@@ -107,6 +108,10 @@ private:
     QCPGraph *rwin_graph_;
     QCPGraph *dup_ack_graph_;
     QCPGraph *zero_win_graph_;
+    // Sequence number graphs can have millions of points.
+    QCPGraphDecimator base_decimator_;
+    QCPGraphDecimator ack_decimator_;
+    QCPGraphDecimator rwin_decimator_;
     QCPItemTracer *tracer_;
     QRectF axis_bounds_;
     uint32_t packet_num_;
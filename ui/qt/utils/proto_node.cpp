@@ -12,28 +12,10 @@
 
 #include <epan/prefs.h>
 
-// NOLINTNEXTLINE(misc-no-recursion)
-ProtoNode::ProtoNode(proto_node *node, ProtoNode *parent) :
-    node_(node), parent_(parent)
+ProtoNode::ProtoNode(proto_node *node, ProtoNode *parent, int row) :
+    node_(node), children_loaded_(false), label_loaded_(false),
+    parent_(parent), row_(row)
 {
-    if (node_) {
-
-        int num_children = 0;
-        for (proto_node *child = node_->first_child; child; child = child->next) {
-            if (!isHidden(child)) {
-                num_children++;
-            }
-        }
-
-        m_children.reserve(num_children);
-
-        for (proto_node *child = node_->first_child; child; child = child->next) {
-            if (!isHidden(child)) {
-                // We recurse here, but we're limited by tree depth checks in epan
-                m_children.append(new ProtoNode(child, this));
-            }
-        }
-    }
 }
 
 ProtoNode::~ProtoNode()
@@ -56,8 +38,37 @@ ProtoNode* ProtoNode::parentNode()
     return parent_;
 }
 
+void ProtoNode::loadChildren() const
+{
+    if (children_loaded_) {
+        return;
+    }
+    children_loaded_ = true;
+    if (!node_) {
+        return;
+    }
+
+    int num_children = 0;
+    for (proto_node *child = node_->first_child; child; child = child->next) {
+        if (!isHidden(child)) {
+            num_children++;
+        }
+    }
+
+    m_children.reserve(num_children);
+
+    for (proto_node *child = node_->first_child; child; child = child->next) {
+        if (!isHidden(child)) {
+            m_children.append(new ProtoNode(child, const_cast<ProtoNode *>(this), (int)m_children.size()));
+        }
+    }
+}
+
 QString ProtoNode::labelText() const
 {
+    if (label_loaded_) {
+        return label_;
+    }
     if (!node_) {
         return QString();
     }
@@ -86,6 +97,8 @@ QString ProtoNode::labelText() const
         label.prepend("<");
         label.append(">");
     }
+    label_ = label;
+    label_loaded_ = true;
     return label;
 }
 
@@ -93,16 +106,32 @@ int ProtoNode::childrenCount() const
 {
     if (!node_) return 0;
 
+    loadChildren();
     return (int)m_children.count();
 }
 
+bool ProtoNode::hasChildren() const
+{
+    if (!node_) return false;
+
+    if (children_loaded_) {
+        return !m_children.isEmpty();
+    }
+    for (proto_node *child = node_->first_child; child; child = child->next) {
+        if (!isHidden(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int ProtoNode::row()
 {
-    if (!isChild()) {
+    if (!isChild() || !parent_) {
         return -1;
     }
 
-    return (int)parent_->m_children.indexOf(const_cast<ProtoNode*>(this));
+    return row_;
 }
 
 bool ProtoNode::isExpanded() const
@@ -120,6 +149,7 @@ proto_node * ProtoNode::protoNode() const
 
 ProtoNode* ProtoNode::child(int row)
 {
+    loadChildren();
     if (row < 0 || row >= m_children.size())
         return nullptr;
     return m_children.at(row);
@@ -35,7 +35,7 @@ public:
         NodePtr node;
     };
 
-    explicit ProtoNode(proto_node * node = NULL, ProtoNode *parent = nullptr);
+    explicit ProtoNode(proto_node * node = NULL, ProtoNode *parent = nullptr, int row = -1);
     ~ProtoNode();
 
     bool isValid() const;
@@ -45,6 +45,7 @@ public:
     proto_node *protoNode() const;
     ProtoNode *child(int row);
     int childrenCount() const;
+    bool hasChildren() const;
     int row();
     ProtoNode *parentNode();
 
@@ -54,8 +55,15 @@ public:
 
 private:
     proto_node * node_;
-    QVector<ProtoNode*>m_children;
+    // Children and the label are only built when a view asks for them,
+    // so selecting a packet with a huge tree costs what is shown.
+    mutable QVector<ProtoNode*>m_children;
+    mutable bool children_loaded_;
+    mutable QString label_;
+    mutable bool label_loaded_;
     ProtoNode *parent_;
+    int row_;
+    void loadChildren() const;
     static bool isHidden(proto_node * node);
 };
 
@@ -359,16 +359,15 @@ void VoipCallsDialog::tapDraw(void *tapinfo_ptr)
         return;
     }
 
-    GList *graph_item = g_queue_peek_nth_link(tapinfo->graph_analysis->items, 0);
-    for (; graph_item; graph_item = gxx_list_next(graph_item)) {
-        for (GList *rsi_entry = g_list_first(tapinfo->rtpstream_list); rsi_entry; rsi_entry = gxx_list_next(rsi_entry)) {
-            seq_analysis_item_t * sai = gxx_list_data(seq_analysis_item_t *, graph_item);
-            rtpstream_info_t *rsi = gxx_list_data(rtpstream_info_t *, rsi_entry);
-
-            if (rsi->start_fd->num == sai->frame_number) {
-                rsi->call_num = sai->conv_num;
-                // VOIP_CALLS_DEBUG("setting conv num %u for frame %u", sai->conv_num, sai->frame_number);
-            }
+    // Look up the graph item of each stream's first frame instead of
+    // comparing every graph item with every stream.
+    for (GList *rsi_entry = g_list_first(tapinfo->rtpstream_list); rsi_entry; rsi_entry = gxx_list_next(rsi_entry)) {
+        rtpstream_info_t *rsi = gxx_list_data(rtpstream_info_t *, rsi_entry);
+        seq_analysis_item_t *sai = static_cast<seq_analysis_item_t *>(g_hash_table_lookup(tapinfo->graph_analysis->ht, GUINT_TO_POINTER(rsi->start_fd->num)));
+
+        if (sai) {
+            rsi->call_num = sai->conv_num;
+            // VOIP_CALLS_DEBUG("setting conv num %u for frame %u", sai->conv_num, sai->frame_number);
         }
     }
 
@@ -618,24 +617,25 @@ void VoipCallsDialog::showSequence()
 QVector<rtpstream_id_t *>VoipCallsDialog::getSelectedRtpIds()
 {
     QVector<rtpstream_id_t *> stream_ids;
+    QSet<unsigned> selected_calls;
     foreach (QModelIndex index, ui->callTreeView->selectionModel()->selectedIndexes()) {
         voip_calls_info_t *vci = VoipCallsInfoModel::indexToCallInfo(index);
         if (!vci) continue;
+        selected_calls << vci->call_num;
+    }
+    if (selected_calls.isEmpty()) {
+        return stream_ids;
+    }
 
-        for (GList *rsi_entry = g_list_first(tapinfo_.rtpstream_list); rsi_entry; rsi_entry = gxx_list_next(rsi_entry)) {
-            rtpstream_info_t *rsi = gxx_list_data(rtpstream_info_t *, rsi_entry);
-            if (!rsi) continue;
-
-            //VOIP_CALLS_DEBUG("checking call %u, start frame %u == stream call %u, start frame %u, setup frame %u",
-            //                vci->call_num, vci->start_fd->num,
-            //                rsi->call_num, rsi->start_fd->num, rsi->setup_frame_number);
-            if (vci->call_num == static_cast<unsigned>(rsi->call_num)) {
-                //VOIP_CALLS_DEBUG("adding call number %u", vci->call_num);
-                if (-1 == stream_ids.indexOf(&(rsi->id))) {
-                    // Add only new stream
-                    stream_ids << &(rsi->id);
-                }
-            }
+    // Each stream belongs to at most one call, so a single pass over the
+    // streams yields every stream of the selected calls exactly once.
+    for (GList *rsi_entry = g_list_first(tapinfo_.rtpstream_list); rsi_entry; rsi_entry = gxx_list_next(rsi_entry)) {
+        rtpstream_info_t *rsi = gxx_list_data(rtpstream_info_t *, rsi_entry);
+        if (!rsi || rsi->call_num < 0) continue;
+
+        if (selected_calls.contains(static_cast<unsigned>(rsi->call_num))) {
+            //VOIP_CALLS_DEBUG("adding call number %u", rsi->call_num);
+            stream_ids << &(rsi->id);
         }
     }
 
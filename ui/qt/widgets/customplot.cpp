@@ -10,6 +10,7 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#include <epan/prefs.h>
 #include <wsutil/utf8_entities.h>
 
 #include <ui/qt/widgets/customplot.h>
@@ -19,13 +20,38 @@ static const QString marker_label_object_name_ = "marker_label_%1";
 static const QString marker_line_object_name_ = "marker_line_%1";
 static const QString marker_diff_line_object_name_ = "marker_diff_line_";
 static const QString marker_diff_label_object_name_ = "marker_diff_label_";
+// Created by QCustomPlot, above everything else, in QCPLayer::lmBuffered mode.
+static const QString overlay_layer_name_ = "overlay";
 CustomPlot::CustomPlot(QWidget* widget):
     QCustomPlot(widget),
     selected_marker_idx_(-1),
     data_point_visible_(true),
     marker_diff_visible_(false),
     dragging_(false)
-{}
+{
+    setupRendering(this);
+}
+
+void CustomPlot::setupRendering(QCustomPlot* plot)
+{
+    // setOpenGl() falls back to the raster buffers by itself if it can't
+    // get a context, or if QCUSTOMPLOT_USE_OPENGL wasn't defined.
+    if (prefs.gui_plot_opengl) {
+        plot->setOpenGl(true);
+    }
+}
+
+void CustomPlot::addToOverlay(QCPLayerable* layerable)
+{
+    layerable->setLayer(overlay_layer_name_);
+}
+
+void CustomPlot::replotOverlay(QCustomPlot* plot)
+{
+    // Only the overlay's paint buffer is redrawn, unless the buffers have
+    // been invalidated (e.g. by a resize), in which case this replots.
+    plot->layer(overlay_layer_name_)->replot();
+}
 
 CustomPlot::~CustomPlot()
 {
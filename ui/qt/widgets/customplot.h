@@ -46,6 +46,15 @@ public:
     Marker* posMarker();
     void markerMoved(const Marker*);
 
+    // Draw with OpenGL if the "gui.plot_opengl" preference is set and a
+    // context can be created, otherwise with the raster paint buffers.
+    static void setupRendering(QCustomPlot* plot);
+    // Move an item that changes while the user interacts with the plot,
+    // such as a tracer, onto the buffered overlay layer...
+    static void addToOverlay(QCPLayerable* layerable);
+    // ...so that it can be redrawn without redrawing the graphs.
+    static void replotOverlay(QCustomPlot* plot);
+
 protected:
     void mouseMoveEvent(QMouseEvent* event) override;
     void axisRemoved(QCPAxis*) override;
@@ -27,6 +27,7 @@
 #include <ui/qt/models/pref_models.h>
 #include <ui/qt/filter_action.h>
 #include <ui/qt/display_filter_expression_dialog.h>
+#include <ui/qt/display_filter_syntax_worker.h>
 #include <ui/qt/main_window.h>
 
 #include <QAction>
@@ -37,6 +38,8 @@
 #include <QMessageBox>
 #include <QPainter>
 #include <QStringListModel>
+#include <QThread>
+#include <QTimer>
 #include <QWidget>
 #include <QObject>
 #include <QDrag>
@@ -71,7 +74,10 @@ DisplayFilterEdit::DisplayFilterEdit(QWidget *parent, DisplayFilterEditType type
     leftAlignActions_(false),
     last_applied_(QString()),
     filter_word_preamble_(QString()),
-    autocomplete_accepts_field_(true)
+    autocomplete_accepts_field_(true),
+    line_edit_timer_(nullptr),
+    syntax_thread_(nullptr),
+    syntax_worker_(nullptr)
 {
     setAccessibleName(tr("Display filter entry"));
 
@@ -84,6 +90,20 @@ DisplayFilterEdit::DisplayFilterEdit(QWidget *parent, DisplayFilterEditType type
     setDefaultPlaceholderText();
     setType(type);
 
+    // Filters are checked as they're typed on a worker thread, once
+    // typing pauses, so that big ones don't make the keyboard lag.
+    line_edit_timer_ = new QTimer(this);
+    line_edit_timer_->setSingleShot(true);
+    connect(line_edit_timer_, &QTimer::timeout, this, &DisplayFilterEdit::updateFilter);
+
+    syntax_thread_ = new QThread;
+    syntax_worker_ = new DisplayFilterSyntaxWorker;
+    syntax_worker_->moveToThread(syntax_thread_);
+    connect(syntax_worker_, &DisplayFilterSyntaxWorker::syntaxResult,
+            this, &DisplayFilterEdit::setFilterSyntaxState);
+    connect(this, &DisplayFilterEdit::displayFilterChanged, syntax_worker_, &DisplayFilterSyntaxWorker::checkFilter);
+    syntax_thread_->start();
+
     connect(this, &DisplayFilterEdit::textChanged, this,
             static_cast<void (DisplayFilterEdit::*)(const QString &)>(&DisplayFilterEdit::checkFilter));
 
@@ -94,6 +114,14 @@ DisplayFilterEdit::DisplayFilterEdit(QWidget *parent, DisplayFilterEditType type
     connect(mainApp, &MainApplication::appInitialized, this, &DisplayFilterEdit::connectToMainWindow);
 }
 
+DisplayFilterEdit::~DisplayFilterEdit()
+{
+    syntax_thread_->quit();
+    syntax_thread_->wait();
+    delete syntax_thread_;
+    delete syntax_worker_;
+}
+
 void DisplayFilterEdit::setType(DisplayFilterEditType type)
 {
     if (type_ == type) {
@@ -356,10 +384,20 @@ void DisplayFilterEdit::focusOutEvent(QFocusEvent *event)
     SyntaxLineEdit::focusOutEvent(event);
 }
 
+// Checks the current text right away, for callers that need the answer
+// now; the shared compiled filter makes this cheap if the worker has
+// already seen the same text.
 bool DisplayFilterEdit::checkFilter()
 {
     checkFilter(text());
 
+    if (syntaxState() == Busy) {
+        line_edit_timer_->stop();
+        if (checkDisplayFilter(text())) {
+            updateFilterSyntaxStatus(text());
+        }
+    }
+
     return syntaxState() != Invalid;
 }
 
@@ -386,9 +424,45 @@ void DisplayFilterEdit::checkFilter(const QString& filter_text)
         mainApp->popStatus(MainApplication::FilterSyntax);
 
     emit popFilterSyntaxStatus();
-    if (!checkDisplayFilter(filter_text))
+    if (!completionAllowed())
         return;
 
+    if (filter_text.isEmpty()) {
+        line_edit_timer_->stop();
+        checkDisplayFilter(filter_text);
+        updateFilterSyntaxStatus(filter_text);
+    } else {
+        setSyntaxState(Busy);
+        setToolTip(QString());
+        if (apply_button_) {
+            apply_button_->setEnabled(false);
+        }
+        line_edit_timer_->start(prefs.gui_debounce_timer);
+    }
+}
+
+void DisplayFilterEdit::updateFilter()
+{
+    emit displayFilterChanged(text());
+}
+
+void DisplayFilterEdit::setFilterSyntaxState(QString filter, int state, QString err_msg, QString err_msg_full)
+{
+    // Ignore the answers to questions the user has since typed past.
+    if (filter.compare(text()) != 0 || line_edit_timer_->isActive())
+        return;
+
+    setSyntaxState((SyntaxState)state);
+    if (state != Empty && state != Valid) {
+        setSyntaxErrorMessages(err_msg, err_msg_full);
+    }
+    updateFilterSyntaxStatus(filter);
+}
+
+void DisplayFilterEdit::updateFilterSyntaxStatus(const QString &filter_text)
+{
+    MainWindow *mw = mainApp->mainWindow();
+
     switch (syntaxState()) {
     case Deprecated:
     {
@@ -606,24 +680,24 @@ void DisplayFilterEdit::buildCompletionList(const QString &field_word, const QSt
             protocol_t *protocol = find_protocol_by_id(proto_id);
             if (!proto_is_protocol_enabled(protocol)) continue;
 
-            const QString pfname = proto_get_protocol_filter_name(proto_id);
-            field_list << pfname;
-
-            // Add fields only if we're past the protocol name and only for the
-            // current protocol.
-            if (field_dots > pfname.count('.')) {
-                void *field_cookie;
-                const QByteArray fw_ba = field_word.toUtf8(); // or toLatin1 or toStdString?
-                const char *fw_utf8 = fw_ba.constData();
-                size_t fw_len = (size_t) strlen(fw_utf8);
-                for (header_field_info *hfinfo = proto_get_first_protocol_field(proto_id, &field_cookie); hfinfo; hfinfo = proto_get_next_protocol_field(proto_id, &field_cookie)) {
-                    if (hfinfo->same_name_prev_id != -1) continue; // Ignore duplicate names.
-
-                    if (!g_ascii_strncasecmp(fw_utf8, hfinfo->abbrev, fw_len)) {
-                        if ((size_t) strlen(hfinfo->abbrev) != fw_len) field_list << hfinfo->abbrev;
-                    }
-                }
-            }
+            field_list << proto_get_protocol_filter_name(proto_id);
+        }
+
+        const QByteArray fw_ba = field_word.toUtf8(); // or toLatin1 or toStdString?
+        const char *fw_utf8 = fw_ba.constData();
+        size_t fw_len = (size_t) strlen(fw_utf8);
+        void *field_cookie;
+        for (header_field_info *hfinfo = proto_registrar_get_first_byprefix(fw_utf8, &field_cookie); hfinfo; hfinfo = proto_registrar_get_next_byprefix(fw_utf8, &field_cookie)) {
+            if (hfinfo->parent == -1) continue; // Protocols were added above.
+
+            protocol_t *protocol = find_protocol_by_id(hfinfo->parent);
+            if (!proto_is_protocol_enabled(protocol)) continue;
+
+            // Add fields only if we're past the protocol name.
+            const QString pfname = proto_get_protocol_filter_name(hfinfo->parent);
+            if (field_dots <= pfname.count('.')) continue;
+
+            if ((size_t) strlen(hfinfo->abbrev) != fw_len) field_list << hfinfo->abbrev;
         }
 
         // Add display filter functions to the completion list
@@ -691,6 +765,9 @@ void DisplayFilterEdit::applyDisplayFilter()
         }
     }
 
+    if (syntaxState() == Busy)
+        checkFilter();
+
     if (syntaxState() == Invalid)
         return;
 
@@ -17,6 +17,9 @@
 #include <ui/qt/widgets/syntax_line_edit.h>
 
 class QEvent;
+class QThread;
+class QTimer;
+class DisplayFilterSyntaxWorker;
 class StockIconToolButton;
 
 typedef enum {
@@ -31,6 +34,7 @@ class DisplayFilterEdit : public SyntaxLineEdit
     Q_OBJECT
 public:
     explicit DisplayFilterEdit(QWidget *parent = 0, DisplayFilterEditType type = DisplayFilterToEnter);
+    ~DisplayFilterEdit();
     void setType(DisplayFilterEditType type);
 
 protected:
@@ -54,6 +58,8 @@ public slots:
 
 private slots:
     void checkFilter(const QString &filter_text);
+    void updateFilter();
+    void setFilterSyntaxState(QString filter, int state, QString err_msg, QString err_msg_full);
     void clearFilter();
     void changeEvent(QEvent* event);
 
@@ -83,6 +89,9 @@ private:
     QString filter_word_preamble_;
     bool autocomplete_accepts_field_;
     QString style_sheet_;
+    QTimer *line_edit_timer_;
+    QThread *syntax_thread_;
+    DisplayFilterSyntaxWorker *syntax_worker_;
 
     void setDefaultPlaceholderText();
     void buildCompletionList(const QString &field_word, const QString &preamble);
@@ -91,8 +100,10 @@ private:
 
     void alignActionButtons();
     void updateClearButton();
+    void updateFilterSyntaxStatus(const QString &filter_text);
 
 signals:
+    void displayFilterChanged(const QString filter);
     void pushFilterSyntaxStatus(const QString&);
     void popFilterSyntaxStatus();
     void filterPackets(QString new_filter, bool force);
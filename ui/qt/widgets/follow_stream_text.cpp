@@ -18,7 +18,6 @@
 #include <QMap>
 #include <QMouseEvent>
 #include <QTextCursor>
-#include <QScrollBar>
 
 // To do:
 // - Draw text by hand similar to HexDataSourceView. This would let us add
@@ -26,28 +25,81 @@
 //   max_document_length_ in FollowStreamDialog.
 
 FollowStreamText::FollowStreamText(QWidget *parent) :
-    QPlainTextEdit(parent), truncated_(false)
+    QPlainTextEdit(parent), truncated_(false), bulk_insert_(false)
 {
     setMouseTracking(true);
 //    setMaximumBlockCount(1);
     QTextDocument *text_doc = document();
     text_doc->setDefaultFont(mainApp->monospaceFont());
+    // This is a read-only view. The undo stack would otherwise keep a
+    // second copy of everything we add, which adds up for large streams.
+    text_doc->setUndoRedoEnabled(false);
 
     metainfo_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.35);
 }
 
 const int FollowStreamText::max_document_length_ = 500 * 1000 * 1000; // Just a guess
 
-void FollowStreamText::addTruncated(int cur_pos)
+void FollowStreamText::beginBulkInsert()
+{
+    if (bulk_insert_) {
+        return;
+    }
+
+    bulk_cursor_ = QTextCursor(document());
+    bulk_cursor_.movePosition(QTextCursor::End);
+    bulk_cursor_.beginEditBlock();
+    bulk_insert_ = true;
+}
+
+void FollowStreamText::endBulkInsert()
+{
+    if (!bulk_insert_) {
+        return;
+    }
+
+    bulk_insert_ = false;
+    bulk_cursor_.endEditBlock();
+    bulk_cursor_ = QTextCursor();
+}
+
+// Text is appended through a cursor of our own rather than the widget's
+// cursor, so the view doesn't scroll to the end (and have to be scrolled
+// back) for every piece of text. Outside of a bulk insert each append is
+// its own edit block, which lays out the document right away as before.
+QTextCursor FollowStreamText::appendCursor()
+{
+    if (bulk_insert_) {
+        bulk_cursor_.movePosition(QTextCursor::End);
+        return bulk_cursor_;
+    }
+
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.beginEditBlock();
+    return cursor;
+}
+
+void FollowStreamText::finishAppend(QTextCursor &cursor)
+{
+    addTruncated(cursor);
+    if (bulk_insert_) {
+        bulk_cursor_ = cursor;
+    } else {
+        cursor.endEditBlock();
+    }
+}
+
+void FollowStreamText::addTruncated(QTextCursor &cursor)
 {
     if (truncated_) {
-        QTextCharFormat tcf = currentCharFormat();
+        QTextCharFormat tcf;
         tcf.setBackground(palette().base().color());
         tcf.setForeground(metainfo_fg_);
-        insertPlainText("\n" + tr("[Stream output truncated]"));
-        moveCursor(QTextCursor::End);
-    } else {
-        verticalScrollBar()->setValue(cur_pos);
+        cursor.insertText("\n" + tr("[Stream output truncated]"), tcf);
+        if (!bulk_insert_) {
+            moveCursor(QTextCursor::End);
+        }
     }
 }
 
@@ -63,11 +115,9 @@ void FollowStreamText::addText(QString text, bool is_from_server, uint32_t packe
         truncated_ = true;
     }
 
-    setUpdatesEnabled(false);
-    int cur_pos = verticalScrollBar()->value();
-    moveCursor(QTextCursor::End);
+    QTextCursor cursor = appendCursor();
 
-    QTextCharFormat tcf = currentCharFormat();
+    QTextCharFormat tcf;
     if (!colorize) {
         tcf.setBackground(palette().base().color());
         tcf.setForeground(palette().text().color());
@@ -90,13 +140,11 @@ void FollowStreamText::addText(QString text, bool is_from_server, uint32_t packe
         tcf.setForeground(ColorUtils::fromColorT(prefs.st_client_fg));
         tcf.setBackground(ColorUtils::fromColorT(prefs.st_client_bg));
     }
-    setCurrentCharFormat(tcf);
 
-    insertPlainText(text);
-    text_pos_to_packet_[textCursor().anchor()] = packet_num;
+    cursor.insertText(text, tcf);
+    text_pos_to_packet_[cursor.position()] = packet_num;
 
-    addTruncated(cur_pos);
-    setUpdatesEnabled(true);
+    finishAppend(cursor);
 }
 
 void FollowStreamText::addDeltaTime(double delta)
@@ -110,19 +158,14 @@ void FollowStreamText::addDeltaTime(double delta)
         truncated_ = true;
     }
 
-    setUpdatesEnabled(false);
-    int cur_pos = verticalScrollBar()->value();
-    moveCursor(QTextCursor::End);
+    QTextCursor cursor = appendCursor();
 
-    QTextCharFormat tcf = currentCharFormat();
+    QTextCharFormat tcf;
     tcf.setBackground(palette().base().color());
     tcf.setForeground(metainfo_fg_);
-    setCurrentCharFormat(tcf);
-
-    insertPlainText(delta_str);
+    cursor.insertText(delta_str, tcf);
 
-    addTruncated(cur_pos);
-    setUpdatesEnabled(true);
+    finishAppend(cursor);
 }
 
 void FollowStreamText::mouseMoveEvent(QMouseEvent *event)
@@ -150,6 +193,7 @@ void FollowStreamText::leaveEvent(QEvent *event)
 
 void FollowStreamText::clear()
 {
+    endBulkInsert();
     truncated_ = false;
     text_pos_to_packet_.clear();
     QPlainTextEdit::clear();
@@ -11,6 +11,7 @@
 #define FOLLOW_STREAM_TEXT_H
 
 #include <QPlainTextEdit>
+#include <QTextCursor>
 
 class FollowStreamText : public QPlainTextEdit
 {
@@ -21,6 +22,10 @@ public:
     void addText(QString text, bool is_from_server, uint32_t packet_num, bool colorize, bool marked);
     void addDeltaTime(double delta);
     int currentPacket() const;
+    // Text added between these calls is laid out once, at the end,
+    // instead of after every addText() / addDeltaTime() call.
+    void beginBulkInsert();
+    void endBulkInsert();
 
 protected:
     void mouseMoveEvent(QMouseEvent *event);
@@ -36,10 +41,14 @@ public slots:
 
 private:
     int textPosToPacket(int text_pos) const;
-    void addTruncated(int cur_pos);
+    QTextCursor appendCursor();
+    void finishAppend(QTextCursor &cursor);
+    void addTruncated(QTextCursor &cursor);
 
     static const int        max_document_length_;
     bool                    truncated_;
+    bool                    bulk_insert_;
+    QTextCursor             bulk_cursor_;
     QMap<int, uint32_t>     text_pos_to_packet_;
     QColor                  metainfo_fg_;
 };
@@ -48,7 +48,7 @@ Q_DECLARE_METATYPE(DataPrinter::DumpType)
 
 HexDataSourceView::HexDataSourceView(const QByteArray &data, packet_char_enc encoding, QWidget *parent) :
     BaseDataSourceView(data, parent),
-    layout_(new QTextLayout()),
+    line_cache_(1024),
     layout_dirty_(false),
     encoding_(encoding),
     hovered_byte_offset_(-1),
@@ -68,14 +68,15 @@ HexDataSourceView::HexDataSourceView(const QByteArray &data, packet_char_enc enc
     line_height_(0),
     allow_hover_selection_(!recent.gui_allow_hover_selection)
 {
-    layout_->setCacheEnabled(true);
-
     offset_normal_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.35);
     offset_field_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.65);
     ctx_menu_.setToolTipsVisible(true);
 
     window()->winId(); // Required for screenChanged? https://phabricator.kde.org/D20171
-    connect(window()->windowHandle(), &QWindow::screenChanged, viewport(), [=](const QScreen *) { viewport()->update(); });
+    connect(window()->windowHandle(), &QWindow::screenChanged, viewport(), [=](const QScreen *) {
+        invalidateAllLines();
+        viewport()->update();
+    });
 
     setMouseTracking(true);
 
@@ -87,7 +88,6 @@ HexDataSourceView::HexDataSourceView(const QByteArray &data, packet_char_enc enc
 HexDataSourceView::~HexDataSourceView()
 {
     ctx_menu_.clear();
-    delete(layout_);
 }
 
 void HexDataSourceView::createContextMenu()
@@ -195,42 +195,48 @@ void HexDataSourceView::updateContextMenu()
 
 void HexDataSourceView::markProtocol(int start, int length)
 {
+    invalidateBytes(proto_start_, proto_len_);
     proto_start_ = start;
     proto_len_ = length;
-    viewport()->update();
+    invalidateBytes(proto_start_, proto_len_);
 }
 
 void HexDataSourceView::markField(int start, int length, bool scroll_to, bool hover)
 {
     if (hover) {
+        invalidateBytes(field_hover_start_, field_hover_len_);
         field_hover_start_ = start;
         field_hover_len_ = length;
     } else {
+        invalidateBytes(field_start_, field_len_);
         field_start_ = start;
         field_len_ = length;
     }
+    invalidateBytes(start, length);
     if (scroll_to) {
         scrollToByte(start);
     }
-    viewport()->update();
 }
 
 void HexDataSourceView::markAppendix(int start, int length)
 {
+    invalidateBytes(field_a_start_, field_a_len_);
     field_a_start_ = start;
     field_a_len_ = length;
-    viewport()->update();
+    invalidateBytes(field_a_start_, field_a_len_);
 }
 
 void HexDataSourceView::unmarkField()
 {
+    invalidateBytes(proto_start_, proto_len_);
+    invalidateBytes(field_start_, field_len_);
+    invalidateBytes(field_a_start_, field_a_len_);
     proto_start_ = 0;
     proto_len_ = 0;
     field_start_ = 0;
     field_len_ = 0;
     field_a_start_ = 0;
     field_a_len_ = 0;
-    viewport()->update();
 }
 
 void HexDataSourceView::setMonospaceFont(const QFont &mono_font)
@@ -239,7 +245,7 @@ void HexDataSourceView::setMonospaceFont(const QFont &mono_font)
 
     setFont(int_font);
     viewport()->setFont(int_font);
-    layout_->setFont(int_font);
+    invalidateAllLines();
 
     if (isVisible()) {
         updateLayoutMetrics();
@@ -253,24 +259,34 @@ void HexDataSourceView::setMonospaceFont(const QFont &mono_font)
 void HexDataSourceView::updateByteViewSettings()
 {
     row_width_ = recent.gui_bytes_view == BYTES_BITS ? 8 : 16;
+    invalidateAllLines();
 
     updateContextMenu();
     updateScrollbars();
     viewport()->update();
 }
 
-void HexDataSourceView::paintEvent(QPaintEvent *)
+bool HexDataSourceView::event(QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::ApplicationPaletteChange:
+        invalidateAllLines();
+        break;
+    default:
+        break;
+    }
+    return BaseDataSourceView::event(event);
+}
+
+void HexDataSourceView::paintEvent(QPaintEvent *event)
 {
     updateLayoutMetrics();
 
     QPainter painter(viewport());
     painter.translate(-horizontalScrollBar()->value() * em_width_, 0);
 
-    // Pixel offset of this row
-    int row_y = 0;
-
-    // Starting byte offset
-    int offset = verticalScrollBar()->value() * row_width_;
+    // Starting row
+    int top_row = verticalScrollBar()->value();
 
     // Clear the area
     painter.fillRect(viewport()->rect(), palette().base());
@@ -290,23 +306,43 @@ void HexDataSourceView::paintEvent(QPaintEvent *)
         return;
     }
 
-    // Data rows
+    // Data rows. Only the rows that need repainting are laid out, and
+    // rows that haven't changed come from line_cache_.
     int widget_height = height();
+    int num_rows = static_cast<int>((data_.size() + row_width_ - 1) / row_width_);
+    int hovered_row = hovered_byte_offset_ >= 0 ? hovered_byte_offset_ / row_width_ : -1;
+    QList<QRect> hover_outlines;
     painter.save();
 
-    x_pos_to_column_.clear();
-    while ((int) (row_y + line_height_) < widget_height && offset < (int) data_.size()) {
-        drawLine(&painter, offset, row_y);
-        offset += row_width_;
-        row_y += line_height_;
+    for (int vis_row = event->rect().top() / line_height_; vis_row <= event->rect().bottom() / line_height_; vis_row++) {
+        int row = top_row + vis_row;
+        // Pixel offset of this row
+        int row_y = vis_row * line_height_;
+        if (row_y + line_height_ >= widget_height || row >= num_rows) {
+            break;
+        }
+
+        HexLine *hex_line = layoutLine(row);
+        hex_line->layout.draw(&painter, QPointF(0.0, row_y));
+
+        if (row == hovered_row) {
+            int column = hovered_byte_offset_ - (row * row_width_);
+            if (column < hex_line->hex_outlines.size()) {
+                hover_outlines.append(hex_line->hex_outlines[column].translated(0, row_y));
+            }
+            if (column < hex_line->ascii_outlines.size()) {
+                hover_outlines.append(hex_line->ascii_outlines[column].translated(0, row_y));
+            }
+        }
     }
 
     painter.restore();
 
-    // We can't do this in drawLine since the next line might draw over our rect.
+    // We can't do this as we draw each row since the next row might draw over
+    // our rect.
     // This looks best when our highlight and background have similar lightnesses.
     // We might want to set a composition mode when that's not the case.
-    if (!hover_outlines_.isEmpty()) {
+    if (!hover_outlines.isEmpty()) {
         qreal pen_width = 1.0;
         qreal hover_alpha = 0.6;
         QPen ho_pen;
@@ -322,7 +358,7 @@ void HexDataSourceView::paintEvent(QPaintEvent *)
         painter.save();
         painter.setPen(ho_pen);
         painter.setBrush(Qt::NoBrush);
-        foreach (QRect ho_rect, hover_outlines_) {
+        foreach (QRect ho_rect, hover_outlines) {
             // These look good on retina and non-retina displays on macOS.
             // We might want to use fontMetrics numbers instead.
             ho_rect.adjust(-1, 0, -1, -1);
@@ -330,7 +366,6 @@ void HexDataSourceView::paintEvent(QPaintEvent *)
         }
         painter.restore();
     }
-    hover_outlines_.clear();
 
     QStyleOptionFocusRect option;
     option.initFrom(this);
@@ -375,23 +410,32 @@ void HexDataSourceView::mouseMoveEvent(QMouseEvent *event)
         return;
     }
 
-    hovered_byte_offset_ = byteOffsetAtPixel(event->pos());
+    int byte_offset = byteOffsetAtPixel(event->pos());
+    if (byte_offset == hovered_byte_offset_) {
+        return;
+    }
+
+    // Only the rows holding the previous and new outlines need repainting.
+    repaintBytes(hovered_byte_offset_, 1);
+    hovered_byte_offset_ = byte_offset;
+    repaintBytes(hovered_byte_offset_, 1);
     if (hovered_byte_offset_ < 0) {
+        invalidateBytes(field_hover_start_, field_hover_len_);
         field_hover_start_ = 0;
         field_hover_len_ = 0;
     }
     emit byteHovered(hovered_byte_offset_);
-    viewport()->update();
 }
 
 void HexDataSourceView::leaveEvent(QEvent *event)
 {
+    invalidateBytes(field_hover_start_, field_hover_len_);
     field_hover_start_ = 0;
     field_hover_len_ = 0;
+    repaintBytes(hovered_byte_offset_, 1);
     hovered_byte_offset_ = -1;
     emit byteHovered(hovered_byte_offset_);
 
-    viewport()->update();
     QAbstractScrollArea::leaveEvent(event);
 }
 
@@ -419,16 +463,21 @@ int HexDataSourceView::stringWidth(const QString &line)
     return viewport()->fontMetrics().horizontalAdvance(line);
 }
 
-// Draw a line of byte view text for a given offset.
+// Lay out a row of byte view text, or fetch it from line_cache_.
 // Text highlighting is handled using QTextLayout::FormatRange.
-void HexDataSourceView::drawLine(QPainter *painter, const int offset, const int row_y)
+// The returned line is owned by the cache and is only good until the next
+// call.
+HexDataSourceView::HexLine *HexDataSourceView::layoutLine(int row)
 {
-    if (data_.isEmpty()) {
-        return;
+    HexLine *hex_line = line_cache_.object(row);
+    if (hex_line) {
+        return hex_line;
     }
+    hex_line = new HexLine;
 
     // Build our pixel to byte offset vector the first time through.
     bool build_x_pos = x_pos_to_column_.empty() ? true : false;
+    int offset = row * row_width_;
     int tvb_len = static_cast<int>(data_.size());
     int max_tvb_pos = qMin(offset + row_width_, tvb_len) - 1;
     QList<QTextLayout::FormatRange> fmt_list;
@@ -454,6 +503,22 @@ void HexDataSourceView::drawLine(QPainter *painter, const int offset, const int
         // Extra hover space before and after each byte.
         int slop = em_width_ / 2;
         unsigned char c;
+        int ho_len;
+
+        switch (recent.gui_bytes_view) {
+        case BYTES_HEX:
+            ho_len = 2;
+            break;
+        case BYTES_BITS:
+            ho_len = 8;
+            break;
+        case BYTES_DEC:
+        case BYTES_OCT:
+            ho_len = 3;
+            break;
+        default:
+            ws_assert_not_reached();
+        }
 
         if (build_x_pos) {
             x_pos_to_column_ += QVector<int>().fill(-1, slop);
@@ -464,7 +529,9 @@ void HexDataSourceView::drawLine(QPainter *painter, const int offset, const int
             /* insert a space every separator_interval_ bytes */
             if ((tvb_pos != offset) && ((tvb_pos % separator_interval_) == 0)) {
                 line += ' ';
-                x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset - 1, em_width_);
+                if (build_x_pos) {
+                    x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset - 1, em_width_);
+                }
             }
 
             switch (recent.gui_bytes_view) {
@@ -493,27 +560,10 @@ void HexDataSourceView::drawLine(QPainter *painter, const int offset, const int
             if (build_x_pos) {
                 x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset, stringWidth(line) - x_pos_to_column_.size() + slop);
             }
-            if (tvb_pos == hovered_byte_offset_) {
-                int ho_len;
-                switch (recent.gui_bytes_view) {
-                case BYTES_HEX:
-                    ho_len = 2;
-                    break;
-                case BYTES_BITS:
-                    ho_len = 8;
-                    break;
-                case BYTES_DEC:
-                case BYTES_OCT:
-                    ho_len = 3;
-                    break;
-                default:
-                    ws_assert_not_reached();
-                }
-                QRect ho_rect = painter->boundingRect(QRect(), Qt::AlignHCenter|Qt::AlignVCenter, line.right(ho_len));
-                ho_rect.moveRight(stringWidth(line));
-                ho_rect.moveTop(row_y);
-                hover_outlines_.append(ho_rect);
-            }
+            QRect ho_rect = viewport()->fontMetrics().boundingRect(QRect(), Qt::AlignHCenter|Qt::AlignVCenter, line.right(ho_len));
+            ho_rect.moveRight(stringWidth(line));
+            ho_rect.moveTop(0);
+            hex_line->hex_outlines.append(ho_rect);
         }
         line += QString(ascii_start - line.length(), ' ');
         if (build_x_pos) {
@@ -589,12 +639,10 @@ void HexDataSourceView::drawLine(QPainter *painter, const int offset, const int
             if (build_x_pos) {
                 x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset, stringWidth(line) - x_pos_to_column_.size());
             }
-            if (tvb_pos == hovered_byte_offset_) {
-                QRect ho_rect = painter->boundingRect(QRect(), 0, line.right(1));
-                ho_rect.moveRight(stringWidth(line));
-                ho_rect.moveTop(row_y);
-                hover_outlines_.append(ho_rect);
-            }
+            QRect ho_rect = viewport()->fontMetrics().boundingRect(QRect(), 0, line.right(1));
+            ho_rect.moveRight(stringWidth(line));
+            ho_rect.moveTop(0);
+            hex_line->ascii_outlines.append(ho_rect);
         }
         if (in_non_printable) {
             addAsciiFormatRange(fmt_list, np_start, np_len, offset, max_tvb_pos, ModeNonPrintable);
@@ -610,16 +658,67 @@ void HexDataSourceView::drawLine(QPainter *painter, const int offset, const int
     // XXX Fields won't be highlighted if neither hex nor ascii are enabled.
     addFormatRange(fmt_list, 0, offsetChars(), offset_mode);
 
-    layout_->clearLayout();
-    layout_->clearFormats();
-    layout_->setText(line);
-    layout_->setFormats(fmt_list.toVector());
-    layout_->beginLayout();
-    QTextLine tl = layout_->createLine();
+    QTextLayout *layout = &hex_line->layout;
+    layout->setCacheEnabled(true);
+    layout->setFont(viewport()->font());
+    layout->setText(line);
+    layout->setFormats(fmt_list.toVector());
+    layout->beginLayout();
+    QTextLine tl = layout->createLine();
     tl.setLineWidth(totalPixels());
     tl.setLeadingIncluded(true);
-    layout_->endLayout();
-    layout_->draw(painter, QPointF(0.0, row_y));
+    layout->endLayout();
+
+    line_cache_.insert(row, hex_line);
+    return hex_line;
+}
+
+void HexDataSourceView::invalidateAllLines()
+{
+    line_cache_.clear();
+    x_pos_to_column_.clear();
+}
+
+// Drop the cached rows holding the given bytes and repaint them.
+void HexDataSourceView::invalidateBytes(int start, int length)
+{
+    if (start < 0 || length < 1) {
+        return;
+    }
+
+    int first_row = start / row_width_;
+    int last_row = (start + length - 1) / row_width_;
+    if (last_row - first_row < line_cache_.size()) {
+        for (int row = first_row; row <= last_row; row++) {
+            line_cache_.remove(row);
+        }
+    } else {
+        // A large field, e.g. a reassembled PDU. Look at the cached rows
+        // instead of every row in the field.
+        const QList<int> rows = line_cache_.keys();
+        for (int row : rows) {
+            if (row >= first_row && row <= last_row) {
+                line_cache_.remove(row);
+            }
+        }
+    }
+    repaintBytes(start, length);
+}
+
+// Repaint the visible rows holding the given bytes.
+void HexDataSourceView::repaintBytes(int start, int length)
+{
+    if (start < 0 || length < 1 || line_height_ < 1) {
+        return;
+    }
+
+    int top_row = verticalScrollBar()->value();
+    int first_row = qMax(start / row_width_, top_row) - top_row;
+    int last_row = qMin((start + length - 1) / row_width_, top_row + (viewport()->height() / line_height_)) - top_row;
+    if (first_row > last_row) {
+        return;
+    }
+    viewport()->update(0, first_row * line_height_, viewport()->width(), (last_row - first_row + 1) * line_height_);
 }
 
 bool HexDataSourceView::addFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int start, int length, HighlightMode mode)
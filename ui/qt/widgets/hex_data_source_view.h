@@ -14,6 +14,7 @@
 #include "ui/recent.h"
 
 #include <QAbstractScrollArea>
+#include <QCache>
 #include <QFont>
 #include <QVector>
 #include <QMenu>
@@ -53,7 +54,8 @@ public slots:
     void unmarkField();
 
 protected:
-    virtual void paintEvent(QPaintEvent *);
+    virtual bool event(QEvent *event);
+    virtual void paintEvent(QPaintEvent *event);
     virtual void resizeEvent(QResizeEvent *);
     virtual void showEvent(QShowEvent *);
     virtual void mousePressEvent (QMouseEvent * event);
@@ -73,11 +75,24 @@ private:
         ModeHover
     } HighlightMode;
 
-    QTextLayout *layout_;
+    // A row of text laid out for painting, along with the outline of
+    // each of its bytes when hovered.
+    struct HexLine {
+        QTextLayout layout;
+        QVector<QRect> hex_outlines;
+        QVector<QRect> ascii_outlines;
+    };
+
+    // Laid out rows, keyed by row number. A row is kept until its bytes or
+    // their highlighting change.
+    QCache<int, HexLine> line_cache_;
 
     void updateLayoutMetrics();
     int stringWidth(const QString &line);
-    void drawLine(QPainter *painter, const int offset, const int row_y);
+    HexLine *layoutLine(int row);
+    void invalidateAllLines();
+    void invalidateBytes(int start, int length);
+    void repaintBytes(int start, int length);
     bool addFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int start, int length, HighlightMode mode);
     bool addHexFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
     bool addAsciiFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
@@ -124,7 +139,6 @@ private:
     int row_width_;             // Number of bytes per line
     int em_width_;              // Single character width and text margin. NOTE: Use fontMetrics::width for multiple characters.
     int line_height_;           // Font line spacing
-    QList<QRect> hover_outlines_; // Hovered byte outlines.
 
     bool allow_hover_selection_;
 
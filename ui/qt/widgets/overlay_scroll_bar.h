@@ -41,9 +41,9 @@ public:
     void setNearOverlayImage(QImage &overlay_image, int packet_count = -1, int start_pos = -1, int end_pos = -1, QList<int> positions = QList<int>(), int rowHeight = 1);
 
     /** Set the "far" overlay image.
-     * @param mp_image An image showing the position of marked, ignored,
-     *        and reference time packets over the entire packet list. It
-     *        should be sized in device pixels.
+     * @param mp_image An image showing the colors of the packets and the
+     *        position of marked, ignored, and reference time packets over
+     *        the entire packet list. It should be sized in device pixels.
      */
     void setMarkedPacketImage(QImage &mp_image);
 
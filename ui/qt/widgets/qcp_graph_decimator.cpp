@@ -0,0 +1,184 @@
+/** @file
+ *
+ * Keeps the full-resolution data of a QCPGraph and hands the graph only
+ * what can be seen at the current axis range and size.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <ui/qt/widgets/qcp_graph_decimator.h>
+
+#include <algorithm>
+#include <numeric>
+
+// Below this many points per pixel column, decimating isn't worth it.
+static const size_t min_points_per_pixel_ = 4;
+
+QCPGraphDecimator::QCPGraphDecimator(QObject *parent) :
+    QObject(parent),
+    mMinIndex(0),
+    mMaxIndex(0),
+    mShownPixels(0),
+    mDirty(false)
+{
+}
+
+void QCPGraphDecimator::setGraph(QCPGraph *graph)
+{
+    if (graph == mGraph) {
+        return;
+    }
+    if (mPlot) {
+        disconnect(mPlot, &QCustomPlot::beforeReplot, this, &QCPGraphDecimator::update);
+    }
+    mGraph = graph;
+    mPlot = graph ? graph->parentPlot() : nullptr;
+    if (mPlot) {
+        connect(mPlot, &QCustomPlot::beforeReplot, this, &QCPGraphDecimator::update);
+    }
+    mDirty = true;
+}
+
+void QCPGraphDecimator::setData(const QVector<double> &keys, const QVector<double> &values, bool sorted)
+{
+    size_t count = std::min((size_t)keys.size(), (size_t)values.size());
+
+    mKeys.assign(keys.constBegin(), keys.constBegin() + count);
+    mValues.assign(values.constBegin(), values.constBegin() + count);
+
+    if (!sorted && !std::is_sorted(mKeys.begin(), mKeys.end())) {
+        std::vector<size_t> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return mKeys[a] < mKeys[b]; });
+
+        std::vector<double> sorted_keys(count), sorted_values(count);
+        for (size_t i = 0; i < count; i++) {
+            sorted_keys[i] = mKeys[order[i]];
+            sorted_values[i] = mValues[order[i]];
+        }
+        mKeys.swap(sorted_keys);
+        mValues.swap(sorted_values);
+    }
+
+    mMinIndex = 0;
+    mMaxIndex = 0;
+    for (size_t i = 1; i < count; i++) {
+        if (mValues[i] < mValues[mMinIndex]) {
+            mMinIndex = i;
+        }
+        if (mValues[i] > mValues[mMaxIndex]) {
+            mMaxIndex = i;
+        }
+    }
+
+    mDirty = true;
+    update();
+}
+
+void QCPGraphDecimator::clear()
+{
+    mKeys.clear();
+    mValues.clear();
+    mMinIndex = 0;
+    mMaxIndex = 0;
+    mDirty = true;
+    if (mGraph) {
+        mGraph->data()->clear();
+    }
+}
+
+void QCPGraphDecimator::update()
+{
+    if (!mGraph || !mGraph->keyAxis()) {
+        return;
+    }
+
+    QCPAxis *key_axis = mGraph->keyAxis();
+    QCPRange range = key_axis->range();
+    int pixels = qMax(1, qRound(qAbs(key_axis->coordToPixel(range.upper) - key_axis->coordToPixel(range.lower))));
+
+    if (!mDirty && range == mShownRange && pixels == mShownPixels) {
+        return;
+    }
+    mShownRange = range;
+    mShownPixels = pixels;
+    mDirty = false;
+
+    // Nothing of ours to show; leave whatever the graph has alone, so that
+    // callers not using setData() aren't affected.
+    if (mKeys.empty()) {
+        return;
+    }
+
+    size_t first = std::lower_bound(mKeys.begin(), mKeys.end(), range.lower) - mKeys.begin();
+    size_t last = std::upper_bound(mKeys.begin(), mKeys.end(), range.upper) - mKeys.begin();
+
+    QVector<QCPGraphData> shown;
+
+    if (first == 0 && last == mKeys.size() && last <= (size_t)pixels * min_points_per_pixel_) {
+        // Few enough points, all of them visible.
+        shown.reserve((int)last);
+        for (size_t i = 0; i < last; i++) {
+            shown.append(QCPGraphData(mKeys[i], mValues[i]));
+        }
+        mGraph->data()->set(shown, true);
+        return;
+    }
+
+    std::vector<size_t> indexes;
+    indexes.reserve((size_t)pixels * 2 + 8);
+
+    // Off-screen points: what rescaleAxes() needs, and the neighbours of
+    // the visible ones so that lines are drawn to the edges correctly.
+    indexes.push_back(0);
+    indexes.push_back(mKeys.size() - 1);
+    indexes.push_back(mMinIndex);
+    indexes.push_back(mMaxIndex);
+    if (first > 0) {
+        indexes.push_back(first - 1);
+    }
+    if (last < mKeys.size()) {
+        indexes.push_back(last);
+    }
+
+    if (last - first <= (size_t)pixels * min_points_per_pixel_) {
+        for (size_t i = first; i < last; i++) {
+            indexes.push_back(i);
+        }
+    } else {
+        // One minimum and one maximum per pixel column.
+        double column_width = range.size() / pixels;
+        size_t i = first;
+        while (i < last) {
+            int column = (int)((mKeys[i] - range.lower) / column_width);
+            double column_end = range.lower + (column + 1) * column_width;
+            size_t min_i = i, max_i = i;
+
+            for (i++; i < last && mKeys[i] < column_end; i++) {
+                if (mValues[i] < mValues[min_i]) {
+                    min_i = i;
+                }
+                if (mValues[i] > mValues[max_i]) {
+                    max_i = i;
+                }
+            }
+            indexes.push_back(min_i);
+            if (max_i != min_i) {
+                indexes.push_back(max_i);
+            }
+        }
+    }
+
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
+    shown.reserve((int)indexes.size());
+    for (size_t idx : indexes) {
+        shown.append(QCPGraphData(mKeys[idx], mValues[idx]));
+    }
+    mGraph->data()->set(shown, true);
+}
@@ -0,0 +1,63 @@
+/** @file
+ *
+ * Keeps the full-resolution data of a QCPGraph and hands the graph only
+ * what can be seen at the current axis range and size.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef QCP_GRAPH_DECIMATOR_H
+#define QCP_GRAPH_DECIMATOR_H
+
+#include <ui/qt/widgets/qcustomplot.h>
+
+#include <QPointer>
+
+#include <vector>
+
+/**
+ * Min/max decimation for QCPGraph.
+ *
+ * Drawing a graph costs time proportional to its number of points, even
+ * when most of them land on the same pixel column. Graphs given their data
+ * through setData() are instead left with at most one minimum and one
+ * maximum per pixel column across the visible key range, plus the points
+ * just outside it so that lines leave the plot at the right angle and the
+ * global extremes so that rescaleAxes() still sees the whole data set.
+ * The selection is redone before each replot in which the key range or
+ * the axis length changed.
+ */
+class QCPGraphDecimator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QCPGraphDecimator(QObject *parent = nullptr);
+
+    QCPGraph *graph() const { return mGraph.data(); }
+    void setGraph(QCPGraph *graph);
+
+    // Replaces the data of the graph. Keys must be sorted if sorted is true.
+    void setData(const QVector<double> &keys, const QVector<double> &values, bool sorted = false);
+    void clear();
+    size_t dataCount() const { return mKeys.size(); }
+
+public slots:
+    void update();
+
+private:
+    QPointer<QCPGraph> mGraph;
+    QPointer<QCustomPlot> mPlot;
+    std::vector<double> mKeys;
+    std::vector<double> mValues;
+    size_t mMinIndex;
+    size_t mMaxIndex;
+    QCPRange mShownRange;
+    int mShownPixels;
+    bool mDirty;
+};
+
+#endif
@@ -187,59 +187,80 @@ void SyntaxLineEdit::insertFilter(const QString &filter)
     insert(padded_filter);
 }
 
-bool SyntaxLineEdit::checkDisplayFilter(QString filter)
+SyntaxLineEdit::SyntaxState SyntaxLineEdit::displayFilterSyntaxState(const QString &filter,
+                                                                     QString &err_msg,
+                                                                     QString &err_msg_full)
 {
-    if (!completion_enabled_) {
-        return false;
-    }
+    SyntaxState state;
 
     if (filter.isEmpty()) {
-        setSyntaxState(SyntaxLineEdit::Empty);
-        return true;
+        return SyntaxLineEdit::Empty;
     }
 
+    // The compiled filter is shared, so applying the same text afterwards
+    // doesn't compile it again.
     dfilter_t *dfp = NULL;
     df_error_t *df_err = NULL;
-    if (dfilter_compile(filter.toUtf8().constData(), &dfp, &df_err)) {
+    if (dfilter_compile_cached(filter.toUtf8().constData(), &dfp, &df_err)) {
         GSList *warn;
         GPtrArray *depr = NULL;
         if (dfp != NULL && (warn = dfilter_get_warnings(dfp)) != NULL) {
             // FIXME Need to use a different state or rename ::Deprecated
-            setSyntaxState(SyntaxLineEdit::Deprecated);
+            state = SyntaxLineEdit::Deprecated;
             /*
             * We're being lazy and only printing the first warning.
             * Would it be better to print all of them?
             */
-            syntax_error_message_  = QString(static_cast<char *>(warn->data));
+            err_msg = QString(static_cast<char *>(warn->data));
         } else if (dfp != NULL && (depr = dfilter_deprecated_tokens(dfp)) != NULL) {
             // You keep using that word. I do not think it means what you think it means.
             // Possible alternatives: ::Troubled, or ::Problematic maybe?
-            setSyntaxState(SyntaxLineEdit::Deprecated);
+            state = SyntaxLineEdit::Deprecated;
             /*
              * We're being lazy and only printing the first "problem" token.
              * Would it be better to print all of them?
              */
             QString token((const char *)g_ptr_array_index(depr, 0));
             char *token_str = qstring_strdup(token.section('.', 0, 0));
+            dfilter_lock();
             header_field_info *hfi = proto_registrar_get_byalias(token_str);
             if (hfi)
-                syntax_error_message_ = tr("\"%1\" is deprecated in favour of \"%2\". "
-                                           "See Help section 6.4.8 for details.").arg(token_str).arg(hfi->abbrev);
+                err_msg = tr("\"%1\" is deprecated in favour of \"%2\". "
+                             "See Help section 6.4.8 for details.").arg(token_str).arg(hfi->abbrev);
             else
                 // The token_str is the message.
-                syntax_error_message_ = tr("%1").arg(token_str);
+                err_msg = tr("%1").arg(token_str);
+            dfilter_unlock();
             g_free(token_str);
         } else {
-            setSyntaxState(SyntaxLineEdit::Valid);
+            state = SyntaxLineEdit::Valid;
         }
     } else {
-        setSyntaxState(SyntaxLineEdit::Invalid);
-        syntax_error_message_ = QString::fromUtf8(df_err->msg);
-        syntax_error_message_full_ = createSyntaxErrorMessageFull(filter, syntax_error_message_, df_err->loc.col_start, df_err->loc.col_len);
+        state = SyntaxLineEdit::Invalid;
+        err_msg = QString::fromUtf8(df_err->msg);
+        err_msg_full = createSyntaxErrorMessageFull(filter, err_msg, df_err->loc.col_start, df_err->loc.col_len);
         df_error_free(&df_err);
     }
     dfilter_free(dfp);
 
+    return state;
+}
+
+bool SyntaxLineEdit::checkDisplayFilter(QString filter)
+{
+    if (!completion_enabled_) {
+        return false;
+    }
+
+    QString err_msg;
+    QString err_msg_full;
+    SyntaxState state = displayFilterSyntaxState(filter, err_msg, err_msg_full);
+
+    setSyntaxState(state);
+    if (state != SyntaxLineEdit::Empty && state != SyntaxLineEdit::Valid) {
+        setSyntaxErrorMessages(err_msg, err_msg_full);
+    }
+
     return true;
 }
 
@@ -39,11 +39,19 @@ public:
     void setCompleter(QCompleter *c);
     QCompleter *completer() const { return completer_; }
     void allowCompletion(bool enabled);
+    bool completionAllowed() const { return completion_enabled_; }
 
     static QString createSyntaxErrorMessageFull(const QString &filter,
                                                 const QString &err_msg,
                                                 qsizetype loc_start, size_t loc_length);
 
+    // Checks a display filter without touching any widget, so that it can
+    // be used from a worker thread, and returns the state along with the
+    // messages that checkDisplayFilter() would set.
+    static SyntaxState displayFilterSyntaxState(const QString &filter,
+                                                QString &err_msg,
+                                                QString &err_msg_full);
+
 public slots:
     void setStyleSheet(const QString &style_sheet);
     // Insert filter text at the current position, adding spaces where needed.
@@ -58,6 +66,10 @@ public slots:
 protected:
     QCompleter *completer_;
     QStringListModel *completion_model_;
+    void setSyntaxErrorMessages(const QString &err_msg, const QString &err_msg_full) {
+        syntax_error_message_ = err_msg;
+        syntax_error_message_full_ = err_msg_full;
+    }
     void setCompletionTokenChars(const QString &token_chars) { token_chars_ = token_chars; }
     bool isComplexFilter(const QString &filter);
     virtual void buildCompletionList(const QString &field_word, const QString &preamble) { Q_UNUSED(field_word); Q_UNUSED(preamble); }
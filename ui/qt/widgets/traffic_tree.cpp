@@ -462,6 +462,13 @@ bool TrafficDataFilterProxy::lessThan(const QModelIndex &source_left, const QMod
     if (! model || source_left.model() != model || source_right.model() != model)
         return false;
 
+    /* Numeric columns are compared straight from the tap data, without
+     * boxing every value into a QVariant once per comparison. */
+    bool less;
+    if (source_left.column() == source_right.column() &&
+        model->lessThanByKey(source_left.row(), source_right.row(), source_left.column(), &less))
+        return less;
+
     QVariant datA = source_left.data(ATapDataModel::UNFORMATTED_DISPLAYDATA);
     QVariant datB = source_right.data(ATapDataModel::UNFORMATTED_DISPLAYDATA);
 
@@ -460,6 +460,7 @@ WiresharkMainWindow::WiresharkMainWindow(QWidget *parent) :
 
     file_set_dialog_ = new FileSetDialog(this);
     connect(file_set_dialog_, &FileSetDialog::fileSetOpenCaptureFile, this, [=](QString cf_path) { openCaptureFile(cf_path); });
+    connect(file_set_dialog_, &FileSetDialog::fileSetOpenCaptureFiles, this, &WiresharkMainWindow::openCaptureFileSet);
 
     initMainToolbarIcons();
 
@@ -2417,6 +2418,7 @@ void WiresharkMainWindow::setMenusForCaptureFile(bool force_disable)
      * still in progress.
      */
     main_ui_->actionStatisticsProtocolHierarchy->setEnabled(enable);
+    main_ui_->actionStatisticsDissectorPerformance->setEnabled(enable);
     /*
      * "Export Specified Packets..." should be available only if
      * we can write the file out in at least one format.
@@ -2538,6 +2540,7 @@ void WiresharkMainWindow::setForCapturedPackets(bool have_captured_packets)
 
     main_ui_->actionStatisticsCaptureFileProperties->setEnabled(have_captured_packets);
     main_ui_->actionStatisticsProtocolHierarchy->setEnabled(have_captured_packets);
+    main_ui_->actionStatisticsDissectorPerformance->setEnabled(have_captured_packets);
     main_ui_->actionStatisticsIOGraph->setEnabled(have_captured_packets);
     main_ui_->actionStatisticsPlot->setEnabled(have_captured_packets);
 }
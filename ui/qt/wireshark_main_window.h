@@ -269,6 +269,7 @@ public slots:
     // XXX We might want to return a cf_read_status_t or a CaptureFile.
     bool openCaptureFile(QString cf_path, QString display_filter, unsigned int type, bool is_tempfile = false);
     bool openCaptureFile(QString cf_path = QString(), QString display_filter = QString()) { return openCaptureFile(cf_path, display_filter, WTAP_TYPE_AUTO); }
+    bool openCaptureFileSet(QStringList cf_paths);
     void filterPackets(QString new_filter = QString(), bool force = false) override;
     void layoutToolbars();
     void updatePreferenceActions();
@@ -281,6 +282,7 @@ public slots:
 #ifdef HAVE_LIBPCAP
     void captureCapturePrepared(capture_session *);
     void captureCaptureUpdateStarted(capture_session *);
+    void captureCaptureUpdateContinued(capture_session *);
     void captureCaptureUpdateFinished(capture_session *);
     void captureCaptureFixedFinished(capture_session *cap_session);
     void captureCaptureFailed(capture_session *);
@@ -104,6 +104,7 @@ DIAG_ON(frame-larger-than=)
 #include "conversation_hash_tables_dialog.h"
 #include "enabled_protocols_dialog.h"
 #include "decode_as_dialog.h"
+#include "dissector_perf_dialog.h"
 #include <ui/qt/widgets/display_filter_edit.h>
 #include "display_filter_expression_dialog.h"
 #include "dissector_tables_dialog.h"
@@ -181,6 +182,7 @@ DIAG_ON(frame-larger-than=)
 #include <QDesktopServices>
 #include <QUrl>
 #include <QMutex>
+#include <QTimer>
 #include <ui/tap-aggregation.h>
 
 // XXX You must uncomment QT_WINEXTRAS_LIB lines in CMakeList.txt and
@@ -303,6 +305,57 @@ finish:
     return ret;
 }
 
+// Open consecutive files, such as a ring buffer set, as one capture.
+bool WiresharkMainWindow::openCaptureFileSet(QStringList cf_paths)
+{
+    QList<QByteArray> paths_utf8;
+    QVector<const char *> fnames;
+    int err;
+    bool ret = true;
+
+    if (cf_paths.isEmpty()) {
+        return false;
+    }
+
+    QString before_what(tr(" before opening another file"));
+    if (!testCaptureFileClose(before_what)) {
+        return false;
+    }
+
+    for (const QString &cf_path : cf_paths) {
+        paths_utf8 << cf_path.toUtf8();
+    }
+    for (const QByteArray &path_utf8 : paths_utf8) {
+        fnames << path_utf8.constData();
+    }
+
+    setMwFileName(cf_paths.first());
+
+    CaptureFile::globalCapFile()->window = this;
+    if (cf_open_set(CaptureFile::globalCapFile(), fnames.constData(), static_cast<unsigned>(fnames.size()),
+                    WTAP_TYPE_AUTO, &err) != CF_OK) {
+        CaptureFile::globalCapFile()->window = NULL;
+        return false;
+    }
+
+    switch (cf_read(CaptureFile::globalCapFile(), /*reloading=*/false)) {
+    case CF_READ_OK:
+    case CF_READ_ERROR:
+        break;
+
+    case CF_READ_ABORTED:
+        capture_file_.setCapFile(NULL);
+        ret = false;
+        break;
+    }
+
+    if (ret) {
+        mainApp->setLastOpenDirFromFilename(cf_paths.first());
+        main_ui_->statusBar->showExpert();
+    }
+    return ret;
+}
+
 void WiresharkMainWindow::filterPackets(QString new_filter, bool force)
 {
     cf_status_t cf_status;
@@ -556,6 +609,17 @@ void WiresharkMainWindow::captureCaptureUpdateStarted(capture_session *session)
     setForCapturedPackets(true);
 }
 
+void WiresharkMainWindow::captureCaptureUpdateContinued(capture_session *session) {
+
+    /* If packets are arriving faster than we can read them, we've left
+       some for later. Read them once we've handled any pending input and
+       repainted, rather than waiting for the capture child to tell us
+       about more. */
+    if (session->count_pending > 0) {
+        QTimer::singleShot(0, this, [session]() { capture_read_pending(session); });
+    }
+}
+
 void WiresharkMainWindow::captureCaptureUpdateFinished(capture_session *session) {
 
     /* The capture isn't stopping any more - it's stopped. */
@@ -748,6 +812,9 @@ void WiresharkMainWindow::captureEventHandler(CaptureEvent ev)
         case CaptureEvent::Started:
             captureCaptureUpdateStarted(ev.capSession());
             break;
+        case CaptureEvent::Continued:
+            captureCaptureUpdateContinued(ev.capSession());
+            break;
         case CaptureEvent::Finished:
             captureCaptureUpdateFinished(ev.capSession());
             break;
@@ -3441,6 +3508,11 @@ void WiresharkMainWindow::connectStatisticsMenuActions()
         phd->show();
     });
 
+    connect(main_ui_->actionStatisticsDissectorPerformance, &QAction::triggered, this, [=]() {
+        DissectorPerfDialog *dpd = new DissectorPerfDialog(*this, capture_file_);
+        dpd->show();
+    });
+
     connect(main_ui_->actionStatisticsConversations, &QAction::triggered, this, &WiresharkMainWindow::showConversationsDialog);
     connect(main_ui_->actionStatisticsEndpoints, &QAction::triggered, this, &WiresharkMainWindow::showEndpointsDialog);
 
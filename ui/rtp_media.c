@@ -30,6 +30,7 @@
 typedef struct _rtp_decoder_t {
     codec_handle_t handle;
     codec_context_t *context;
+    wmem_map_t *own_fmtp_map;   /* freed with the decoder */
 } rtp_decoder_t;
 
 /****************************************************************************/
@@ -52,6 +53,7 @@ decode_rtp_create_decoder(uint8_t payload_type, const char *payload_type_str, in
     /* Put either valid or empty decoder into the hash table */
     decoder = g_new(rtp_decoder_t, 1);
     decoder->handle = NULL;
+    decoder->own_fmtp_map = NULL;
     decoder->context = g_new(codec_context_t, 1);
     decoder->context->sample_rate = payload_rate;
     decoder->context->channels = payload_channels;
@@ -98,7 +100,8 @@ decode_rtp_find_or_create_decoder(uint8_t payload_type, const char *payload_type
  * @param decoder RTP decoder used to decode the audio in the RTP payload.
  * @param payload_data Payload
  * @param payload_len Length of payload
- * @param out_buff Output audio samples.
+ * @param buff Output audio samples, a buffer reused between packets.
+ * @param buff_bytes Size of the buffer.
  * @param channels_ptr If non-NULL, receives the number of channels in the sample.
  * @param sample_rate_ptr If non-NULL, receives the sample rate.
  * @return The number of decoded bytes on success, 0 on failure.
@@ -106,23 +109,17 @@ decode_rtp_find_or_create_decoder(uint8_t payload_type, const char *payload_type
 
 static size_t
 decode_rtp_packet_payload(rtp_decoder_t *decoder, uint8_t *payload_data, size_t payload_len,
-                          SAMPLE **out_buff, unsigned *channels_ptr, unsigned *sample_rate_ptr)
+                          SAMPLE **buff, size_t *buff_bytes, unsigned *channels_ptr, unsigned *sample_rate_ptr)
 {
-    SAMPLE *tmp_buff = NULL;
-    size_t tmp_buff_len;
     size_t decoded_bytes = 0;
 
     if (!decoder->handle) {
-        *out_buff = NULL;
         return 0;
     }
 
     /* Decode with registered codec */
-    /* if output == NULL and outputSizeBytes == NULL => ask for expected size of the buffer */
-    tmp_buff_len = codec_decode(decoder->handle, decoder->context, payload_data, payload_len, NULL, NULL);
-    tmp_buff = (SAMPLE *)g_malloc(tmp_buff_len);
-    decoded_bytes = codec_decode(decoder->handle, decoder->context, payload_data, payload_len, tmp_buff, &tmp_buff_len);
-    *out_buff = tmp_buff;
+    decoded_bytes = codec_decode_buffer(decoder->handle, decoder->context, payload_data, payload_len,
+                                        (void **)buff, buff_bytes);
 
     if (channels_ptr) {
         *channels_ptr = codec_get_channels(decoder->handle, decoder->context);
@@ -193,9 +190,9 @@ prepend_amr_oa_hdr(uint8_t amr_ft, uint8_t amr_q, const uint8_t *amr_payload, ui
  * @return Number of decoded bytes
  */
 
-size_t
-decode_iuup_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_hash, unsigned *channels_ptr,
-                  unsigned *sample_rate_ptr)
+static size_t
+decode_iuup_packet(rtp_packet_t *rp, SAMPLE **buff, size_t *buff_bytes, GHashTable *decoders_hash,
+                   unsigned *channels_ptr, unsigned *sample_rate_ptr)
 {
     uint8_t iuup_pdu_type;
     uint8_t iuup_frame_nr;
@@ -248,7 +245,8 @@ decode_iuup_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_has
     /* Look for registered codecs */
     decoder = decode_rtp_find_decoder(rp->info->info_payload_type, decoders_hash);
     if (!decoder) {
-            wmem_map_t *iuup_decode_amr_fmtp = wmem_map_new(wmem_epan_scope(), wmem_str_hash, g_str_equal);
+            /* Not in the epan scope, as streams can be decoded on other threads. */
+            wmem_map_t *iuup_decode_amr_fmtp = wmem_map_new(NULL, wmem_str_hash, g_str_equal);
             wmem_map_insert(iuup_decode_amr_fmtp, "octet-align", "1");
             decoder = decode_rtp_create_decoder(rp->info->info_payload_type,
                                                 "amr",
@@ -257,14 +255,14 @@ decode_iuup_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_has
                                                 iuup_decode_amr_fmtp,
                                                 decoders_hash);
             ws_assert(decoder);
+            decoder->own_fmtp_map = iuup_decode_amr_fmtp;
     }
     decoded_bytes = decode_rtp_packet_payload(decoder, amr_hdr, AMR_NB_OA_HDR_LEN + iuup_payload_len,
-                                              out_buff, channels_ptr, sample_rate_ptr);
+                                              buff, buff_bytes, channels_ptr, sample_rate_ptr);
     g_free(amr_hdr);
     return decoded_bytes;
 
 ret_err:
-    *out_buff = NULL;
     return 0;
 }
 
@@ -274,8 +272,8 @@ ret_err:
  */
 
 size_t
-decode_rtp_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_hash, unsigned *channels_ptr,
-                  unsigned *sample_rate_ptr)
+decode_rtp_packet_buffer(rtp_packet_t *rp, SAMPLE **buff, size_t *buff_bytes, GHashTable *decoders_hash,
+                         unsigned *channels_ptr, unsigned *sample_rate_ptr)
 {
     rtp_decoder_t *decoder;
 
@@ -284,7 +282,7 @@ decode_rtp_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_hash
     }
 
     if (rp->info->info_is_iuup)
-        return decode_iuup_packet(rp, out_buff, decoders_hash, channels_ptr, sample_rate_ptr);
+        return decode_iuup_packet(rp, buff, buff_bytes, decoders_hash, channels_ptr, sample_rate_ptr);
 
     /* Look for registered codecs */
     decoder = decode_rtp_find_or_create_decoder(rp->info->info_payload_type,
@@ -295,7 +293,17 @@ decode_rtp_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_hash
                                                 decoders_hash);
     return decode_rtp_packet_payload(decoder,
                                      rp->payload_data, rp->info->info_payload_len,
-                                     out_buff, channels_ptr, sample_rate_ptr);
+                                     buff, buff_bytes, channels_ptr, sample_rate_ptr);
+}
+
+size_t
+decode_rtp_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_hash, unsigned *channels_ptr,
+                  unsigned *sample_rate_ptr)
+{
+    size_t buff_bytes = 0;
+
+    *out_buff = NULL;
+    return decode_rtp_packet_buffer(rp, out_buff, &buff_bytes, decoders_hash, channels_ptr, sample_rate_ptr);
 }
 
 /****************************************************************************/
@@ -308,6 +316,9 @@ rtp_decoder_value_destroy(void *dec_arg)
         codec_release(dec->handle, dec->context);
         g_free(dec->context);
     }
+    if (dec->own_fmtp_map) {
+        wmem_map_destroy(dec->own_fmtp_map, false, false);
+    }
     g_free(dec_arg);
 }
 
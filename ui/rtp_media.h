@@ -62,6 +62,20 @@ GHashTable *rtp_decoder_hash_table_new(void);
  */
 size_t decode_rtp_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_hash, unsigned *channels_ptr, unsigned *sample_rate_ptr);
 
+/** Decode an RTP packet into a buffer that is reused for every packet of
+ * a stream, rather than one allocated for each packet.
+ *
+ * @param rp Wrapper for per-packet RTP tap data.
+ * @param buff Output audio samples. Grown as needed; the caller frees it
+ * with g_free() when the stream is decoded.
+ * @param buff_bytes Size of the buffer in bytes, 0 if buff is NULL.
+ * @param decoders_hash Hash table created with rtp_decoder_hash_table_new.
+ * @param channels_ptr If non-NULL, receives the number of channels in the sample.
+ * @param sample_rate_ptr If non-NULL, receives the sample rate.
+ * @return The number of decoded bytes on success, 0 on failure.
+ */
+size_t decode_rtp_packet_buffer(rtp_packet_t *rp, SAMPLE **buff, size_t *buff_bytes, GHashTable *decoders_hash, unsigned *channels_ptr, unsigned *sample_rate_ptr);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -93,6 +93,61 @@ tally_frame_data(frame_data *cur_frame, summary_tally *sum_tally)
     }
 }
 
+/* Fills in the tallies from the totals file.c keeps as frames come and go. */
+static void
+tally_from_capture_file(const capture_file *cf, summary_tally *sum_tally)
+{
+    sum_tally->bytes = cf->tally_all.bytes;
+    sum_tally->packet_count_ts = cf->tally_all.count_ts;
+    if (cf->tally_all.count_ts > 0) {
+        sum_tally->start_time = cf->tally_all.start;
+        sum_tally->stop_time = cf->tally_all.stop;
+    }
+
+    sum_tally->filtered_count = cf->tally_displayed.count;
+    sum_tally->filtered_count_ts = cf->tally_displayed.count_ts;
+    sum_tally->filtered_bytes = cf->tally_displayed.bytes;
+    if (cf->tally_displayed.count_ts > 0) {
+        sum_tally->filtered_start = cf->tally_displayed.start;
+        sum_tally->filtered_stop = cf->tally_displayed.stop;
+    }
+
+    sum_tally->marked_count = cf->tally_marked.count;
+    sum_tally->marked_count_ts = cf->tally_marked.count_ts;
+    sum_tally->marked_bytes = cf->tally_marked.bytes;
+    if (cf->tally_marked.count_ts > 0) {
+        sum_tally->marked_start = cf->tally_marked.start;
+        sum_tally->marked_stop = cf->tally_marked.stop;
+    }
+
+    sum_tally->ignored_count = cf->ignored_count;
+}
+
+/* Stores a tally of every frame, for next time. */
+static void
+tally_to_capture_file(const summary_tally *sum_tally, capture_file *cf)
+{
+    cf->tally_all.count = cf->count;
+    cf->tally_all.count_ts = sum_tally->packet_count_ts;
+    cf->tally_all.bytes = sum_tally->bytes;
+    cf->tally_all.start = sum_tally->start_time;
+    cf->tally_all.stop = sum_tally->stop_time;
+
+    cf->tally_displayed.count = sum_tally->filtered_count;
+    cf->tally_displayed.count_ts = sum_tally->filtered_count_ts;
+    cf->tally_displayed.bytes = sum_tally->filtered_bytes;
+    cf->tally_displayed.start = sum_tally->filtered_start;
+    cf->tally_displayed.stop = sum_tally->filtered_stop;
+
+    cf->tally_marked.count = sum_tally->marked_count;
+    cf->tally_marked.count_ts = sum_tally->marked_count_ts;
+    cf->tally_marked.bytes = sum_tally->marked_bytes;
+    cf->tally_marked.start = sum_tally->marked_start;
+    cf->tally_marked.stop = sum_tally->marked_stop;
+
+    cf->tally_valid = true;
+}
+
 static void
 hash_to_str(const unsigned char *hash, size_t length, char *str) {
   int i;
@@ -144,7 +199,9 @@ summary_fill_in(capture_file *cf, summary_tally *st)
     st->cap_end_time = (cap_end == NULL || nstime_is_unset(cap_end)) ? DBL_MIN : nstime_to_sec(cap_end);
 
     /* initialize the tally */
-    if (cf->count != 0) {
+    if (cf->tally_valid) {
+        tally_from_capture_file(cf, st);
+    } else if (cf->count != 0) {
         first_frame = frame_data_sequence_find(cf->provider.frames, 1);
         if (first_frame->has_ts) {
             st->start_time = nstime_to_sec(&first_frame->abs_ts);
@@ -155,6 +212,10 @@ summary_fill_in(capture_file *cf, summary_tally *st)
             cur_frame = frame_data_sequence_find(cf->provider.frames, framenum);
             tally_frame_data(cur_frame, st);
         }
+
+        /* Unless frames are still being filtered, this holds from now on. */
+        if (!cf->redissecting && !cf->read_lock && cf->provider.frames != NULL)
+            tally_to_capture_file(st, cf);
     }
 
     st->filename = cf->filename;
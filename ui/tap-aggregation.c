@@ -80,7 +80,7 @@ tapPacket(void* ptr, packet_info* pinfo, epan_dissect_t* edt, const void* data _
         }
     }
     if (pinfo && key->values_num > 0) {
-        pinfo->fd->aggregation_keys = g_slist_append(pinfo->fd->aggregation_keys, key);
+        frame_data_append_aggregation_key(pinfo->fd, key);
     }
     else {
         free_aggregation_key(key);
@@ -430,6 +430,41 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
     return TAP_PACKET_DONT_REDRAW;
 }
 
+/****************************************************************************/
+/* Estimate the R-factor and MOS of a stream using the simplified E-model
+ * (ITU-T G.107) commonly used by passive VoIP monitors: the jitter buffer
+ * is assumed to add twice the mean jitter to a fixed 10 ms of delay, and
+ * every percent of packet loss costs 2.5 points. Only the per-stream
+ * summary values are needed, so this works on streaming state as well.
+ */
+static void rtpstream_info_calc_mos(rtpstream_info_calc_t *calc)
+{
+        double effective_latency;
+        double lost_perc;
+        double r;
+
+        effective_latency = calc->mean_jitter * 2 + 10;
+        if (effective_latency < 160) {
+                r = 93.2 - (effective_latency / 40);
+        } else {
+                r = 93.2 - (effective_latency - 120) / 10;
+        }
+        /* Duplicates can make the loss negative; they don't improve quality */
+        lost_perc = calc->lost_perc > 0 ? calc->lost_perc : 0;
+        r -= lost_perc * 2.5;
+
+        if (r <= 0) {
+                calc->r_factor = 0;
+                calc->mos = 1.0;
+        } else if (r >= 100) {
+                calc->r_factor = 100;
+                calc->mos = 4.5;
+        } else {
+                calc->r_factor = r;
+                calc->mos = 1 + 0.035 * r + 0.000007 * r * (r - 60) * (100 - r);
+        }
+}
+
 /****************************************************************************/
 /* evaluate rtpstream_info_t calculations */
 /* - code is gathered from existing GTK/Qt/tui sources related to RTP statistics calculation
@@ -494,6 +529,7 @@ void rtpstream_info_calculate(const rtpstream_info_t *strinfo, rtpstream_info_ca
         calc->start_time_ms = strinfo->rtp_stats.start_time / 1000.0;
         calc->first_packet_num = strinfo->rtp_stats.first_packet_num;
         calc->last_packet_num = strinfo->rtp_stats.max_nr;
+        rtpstream_info_calc_mos(calc);
 }
 
 /****************************************************************************/
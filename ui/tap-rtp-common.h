@@ -72,6 +72,8 @@ typedef struct _rtpstream_info_calc {
     double start_time_ms; /**< Unit is ms */
     uint32_t first_packet_num;
     uint32_t last_packet_num;
+    double r_factor; /* ITU-T G.107 E-model R-factor estimated from jitter and loss */
+    double mos; /* Mean Opinion Score derived from r_factor (1.0 - 4.5) */
 } rtpstream_info_calc_t;
 
 /**
@@ -37,27 +37,6 @@
 
 static sctp_allassocs_info_t sctp_tapinfo_struct;
 
-static void
-free_first(void *data, void *user_data _U_)
-{
-    g_free(data);
-}
-
-static void
-tsn_free(void *data)
-{
-    tsn_t *tsn;
-
-    tsn = (tsn_t *) data;
-    if (tsn->tsns != NULL)
-    {
-        g_list_free_full(tsn->tsns, g_free);
-    }
-    free_address(&tsn->src);
-    free_address(&tsn->dst);
-    g_free(tsn);
-}
-
 static void
 chunk_free(void *data)
 {
@@ -106,53 +85,13 @@ reset(void *arg)
             info->error_info_list = NULL;
         }
 
-        if (info->frame_numbers != NULL)
-        {
-            g_list_free(info->frame_numbers);
-            info->frame_numbers = NULL;
-        }
-
-        if (info->tsn1 != NULL)
-        {
-            g_list_free_full(info->tsn1, tsn_free);
-            info->tsn1 = NULL;
-        }
-
-        if (info->tsn2 != NULL)
-        {
-            g_list_free_full(info->tsn2, tsn_free);
-            info->tsn2 = NULL;
-        }
-
-        if (info->sack1 != NULL)
-        {
-            g_list_free_full(info->sack1, tsn_free);
-            info->sack1 = NULL;
-        }
-
-        if (info->sack2 != NULL)
-        {
-            g_list_free_full(info->sack2, tsn_free);
-            info->sack2 = NULL;
-        }
-
-        if (info->sort_tsn1 != NULL)
-            g_ptr_array_free(info->sort_tsn1, true);
-
-        if (info->sort_tsn2 != NULL)
-            g_ptr_array_free(info->sort_tsn2, true);
-
-        if (info->sort_sack1 != NULL)
-            g_ptr_array_free(info->sort_sack1, true);
-
-        if (info->sort_sack2 != NULL)
-            g_ptr_array_free(info->sort_sack2, true);
-
-        if (info->min_max != NULL)
-        {
-            g_slist_foreach(info->min_max, free_first, NULL);
-            info->min_max = NULL;
-        }
+        g_array_free(info->frame_numbers, true);
+        g_array_free(info->tsn1, true);
+        g_array_free(info->tsn2, true);
+        g_array_free(info->sack1, true);
+        g_array_free(info->sack2, true);
+        g_byte_array_free(info->sack_data1, true);
+        g_byte_array_free(info->sack_data2, true);
 
         if (info->addr_chunk_count) {
             g_list_free_full(info->addr_chunk_count, chunk_free);
@@ -320,29 +259,82 @@ add_address(address *vadd, sctp_assoc_info_t *info, uint16_t direction)
     return info;
 }
 
+static void
+update_time_range(sctp_assoc_info_t *info, uint32_t secs, uint32_t usecs)
+{
+    if (secs < info->min_secs)
+    {
+        info->min_secs  = secs;
+        info->min_usecs = usecs;
+    }
+    else if (secs == info->min_secs && usecs < info->min_usecs)
+        info->min_usecs = usecs;
+
+    if (secs > info->max_secs)
+    {
+        info->max_secs  = secs;
+        info->max_usecs = usecs;
+    }
+    else if (secs == info->max_secs && usecs > info->max_usecs)
+        info->max_usecs = usecs;
+}
+
+/*
+ * The graphs only need the TSN and length of each DATA chunk, so those are
+ * all that is kept, in one array per direction rather than a list entry and
+ * a copy of the chunk header each.
+ */
+static void
+add_tsn_chunk(GArray *chunks, packet_info *pinfo, tvbuff_t *tvb, uint32_t tsnumber, uint32_t length)
+{
+    sctp_tsn_chunk_t chunk;
+
+    chunk.frame_number = pinfo->num;
+    chunk.secs         = (uint32_t)pinfo->rel_ts.secs;
+    chunk.usecs        = (uint32_t)pinfo->rel_ts.nsecs/1000;
+    chunk.tsn          = tsnumber;
+    chunk.length       = length;
+    chunk.type         = tvb_get_uint8(tvb, 0);
+    g_array_append_val(chunks, chunk);
+}
+
+/* SACKs are variable length, so they are copied one after another. */
+static void
+add_sack_chunk(GArray *chunks, GByteArray *sack_data, packet_info *pinfo, tvbuff_t *tvb, uint16_t length)
+{
+    static const uint8_t padding[3];
+    sctp_sack_chunk_t chunk;
+
+    if (sack_data->len % 4 != 0)
+        g_byte_array_append(sack_data, padding, 4 - sack_data->len % 4);
+
+    chunk.frame_number = pinfo->num;
+    chunk.secs         = (uint32_t)pinfo->rel_ts.secs;
+    chunk.usecs        = (uint32_t)pinfo->rel_ts.nsecs/1000;
+    chunk.offset       = sack_data->len;
+    chunk.length       = length;
+    chunk.type         = tvb_get_uint8(tvb, 0);
+    g_byte_array_set_size(sack_data, sack_data->len + length);
+    tvb_memcpy(tvb, sack_data->data + chunk.offset, 0, length);
+    g_array_append_val(chunks, chunk);
+}
+
 static tap_packet_status
 packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data, tap_flags_t flags _U_)
 {
     const struct _sctp_info *sctp_info = (const struct _sctp_info *)data;
-    uint32_t chunk_number = 0, tsnumber, framenumber;
+    uint32_t chunk_number = 0, tsnumber, arwnd, chunk_length;
     sctp_tmp_info_t tmp_info;
     sctp_assoc_info_t *info = NULL;
     sctp_error_info_t *error = NULL;
     uint16_t type, length = 0;
     address *store = NULL;
-    tsn_t *tsn = NULL;
-    tsn_t *sack = NULL;
-    uint8_t *t_s_n = NULL;
-    bool sackchunk = false;
     bool datachunk = false;
     bool forwardchunk = false;
-    struct tsn_sort *tsn_s;
     int i;
     uint8_t idx = 0;
-    bool tsn_used = false;
-    bool sack_used = false;
-
-    framenumber = pinfo->num;
+    uint32_t secs = (uint32_t)pinfo->rel_ts.secs;
+    uint32_t usecs = (uint32_t)pinfo->rel_ts.nsecs/1000;
 
     type = sctp_info->ip_src.type;
 
@@ -436,11 +428,13 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
             info->n_forward_chunks  = 0;
             info->max_window1       = 0;
             info->max_window2       = 0;
-            info->min_max           = NULL;
-            info->sort_tsn1         = g_ptr_array_new_with_free_func(g_free);
-            info->sort_tsn2         = g_ptr_array_new_with_free_func(g_free);
-            info->sort_sack1        = g_ptr_array_new_with_free_func(g_free);
-            info->sort_sack2        = g_ptr_array_new_with_free_func(g_free);
+            info->frame_numbers     = g_array_new(false, false, sizeof(uint32_t));
+            info->tsn1              = g_array_new(false, false, sizeof(sctp_tsn_chunk_t));
+            info->tsn2              = g_array_new(false, false, sizeof(sctp_tsn_chunk_t));
+            info->sack1             = g_array_new(false, false, sizeof(sctp_sack_chunk_t));
+            info->sack2             = g_array_new(false, false, sizeof(sctp_sack_chunk_t));
+            info->sack_data1        = g_byte_array_new();
+            info->sack_data2        = g_byte_array_new();
             info->dir1              = g_new0(sctp_init_collision_t, 1);
             info->dir1->init_min_tsn = 0xffffffff;
             info->dir1->initack_min_tsn = 0xffffffff;
@@ -456,48 +450,13 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
             }
             info->addr_chunk_count = NULL;
 
-            if (((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_INIT_CHUNK_ID) ||
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_INIT_ACK_CHUNK_ID) ||
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_DATA_CHUNK_ID) ||
+            if (((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_DATA_CHUNK_ID) ||
                     ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_I_DATA_CHUNK_ID) ||
                     ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_SACK_CHUNK_ID) ||
                     ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_NR_SACK_CHUNK_ID) ||
                     ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_FORWARD_TSN_CHUNK_ID))
             {
-                tsn = g_new0(tsn_t, 1);
-                copy_address(&tsn->src, &tmp_info.src);
-                copy_address(&tsn->dst, &tmp_info.dst);
-
-                sack = g_new0(tsn_t, 1);
-                copy_address(&sack->src, &tmp_info.src);
-                copy_address(&sack->dst, &tmp_info.dst);
-                sack->secs=tsn->secs   = (uint32_t)pinfo->rel_ts.secs;
-                sack->usecs=tsn->usecs = (uint32_t)pinfo->rel_ts.nsecs/1000;
-
-                if (((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_DATA_CHUNK_ID) ||
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_I_DATA_CHUNK_ID) ||
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_SACK_CHUNK_ID) ||
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_NR_SACK_CHUNK_ID) ||
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_FORWARD_TSN_CHUNK_ID))
-                {
-                    if (tsn->secs < info->min_secs)
-                    {
-                        info->min_secs  = tsn->secs;
-                        info->min_usecs = tsn->usecs;
-                    }
-                    else if (tsn->secs == info->min_secs && tsn->usecs < info->min_usecs)
-                        info->min_usecs = tsn->usecs;
-
-                    if (tsn->secs > info->max_secs)
-                    {
-                        info->max_secs  = tsn->secs;
-                        info->max_usecs = tsn->usecs;
-                    }
-                    else if (tsn->secs == info->max_secs && tsn->usecs > info->max_usecs)
-                        info->max_usecs = tsn->usecs;
-                }
-
-                sack->frame_number = tsn->frame_number = pinfo->num;
+                update_time_range(info, secs, usecs);
             }
             if ((tvb_get_uint8(sctp_info->tvb[0],0) == SCTP_INIT_CHUNK_ID) || (tvb_get_uint8(sctp_info->tvb[0],0) == SCTP_INIT_ACK_CHUNK_ID))
             {
@@ -564,17 +523,6 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
             }
             else
             {
-                if (((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_INIT_CHUNK_ID) &&
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_INIT_ACK_CHUNK_ID) &&
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_DATA_CHUNK_ID) &&
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_I_DATA_CHUNK_ID) &&
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_SACK_CHUNK_ID) &&
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_NR_SACK_CHUNK_ID) &&
-                        ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_FORWARD_TSN_CHUNK_ID))
-                {
-                    tsn = g_new0(tsn_t, 1);
-                    sack = g_new0(tsn_t, 1);
-                }
                 for (chunk_number = 0; chunk_number < sctp_info->number_of_tvbs; chunk_number++)
                 {
                     idx = tvb_get_uint8(sctp_info->tvb[0],0);
@@ -621,49 +569,9 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                                 info->n_forward_chunks_ep1++;
                             info->max_tsn1 = tsnumber;
                         }
-                        if (tsn->first_tsn == 0)
-                            tsn->first_tsn = tsnumber;
-                        if (datachunk)
-                        {
-                            t_s_n = (uint8_t *)g_malloc(16);
-                            tvb_memcpy(sctp_info->tvb[chunk_number], (uint8_t *)(t_s_n),0, 16);
-                        }
-                        else
-                        {
-                            t_s_n = (uint8_t *)g_malloc(length);
-                            tvb_memcpy(sctp_info->tvb[chunk_number], (uint8_t *)(t_s_n),0, length);
-                        }
-                        tsn->tsns = g_list_append(tsn->tsns, t_s_n);
-                        tsn_s = g_new(struct tsn_sort, 1);
-                        tsn_s->tsnumber = tsnumber;
-                        tsn_s->secs     = tsn->secs = (uint32_t)pinfo->rel_ts.secs;
-                        tsn_s->usecs    = tsn->usecs = (uint32_t)pinfo->rel_ts.nsecs/1000;
-                        tsn_s->offset   = 0;
-                        tsn_s->framenumber = framenumber;
-                        if (datachunk)
-                            if (tvb_get_uint8(sctp_info->tvb[chunk_number],0) == SCTP_DATA_CHUNK_ID) {
-                                tsn_s->length   = length - DATA_CHUNK_HEADER_LENGTH;
-                            } else {
-                                tsn_s->length   = length - I_DATA_CHUNK_HEADER_LENGTH;
-                            }
-                            else
-                                tsn_s->length   = length;
-                        if (tsn->secs < info->min_secs)
-                        {
-                            info->min_secs  = tsn->secs;
-                            info->min_usecs = tsn->usecs;
-                        }
-                        else if (tsn->secs == info->min_secs && tsn->usecs < info->min_usecs)
-                            info->min_usecs = tsn->usecs;
-
-                        if (tsn->secs > info->max_secs)
-                        {
-                            info->max_secs  = tsn->secs;
-                            info->max_usecs = tsn->usecs;
-                        }
-                        else if (tsn->secs == info->max_secs && tsn->usecs > info->max_usecs)
-                            info->max_usecs = tsn->usecs;
-                        g_ptr_array_add(info->sort_tsn1, tsn_s);
+                        add_tsn_chunk(info->tsn1, pinfo, sctp_info->tvb[chunk_number], tsnumber,
+                                      datachunk ? length : 0);
+                        update_time_range(info, secs, usecs);
                         info->n_array_tsn1++;
                     }
                     if ((tvb_get_uint8(sctp_info->tvb[chunk_number],0) == SCTP_SACK_CHUNK_ID) ||
@@ -675,37 +583,11 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                         if (tsnumber > info->max_tsn2)
                             info->max_tsn2 = tsnumber;
                         length = tvb_get_ntohs(sctp_info->tvb[chunk_number], CHUNK_LENGTH_OFFSET);
-                        if (sack->first_tsn == 0)
-                            sack->first_tsn = tsnumber;
-                        t_s_n = (uint8_t *)g_malloc(length);
-                        tvb_memcpy(sctp_info->tvb[chunk_number], (uint8_t *)(t_s_n),0, length);
-                        sack->tsns = g_list_append(sack->tsns, t_s_n);
-                        sackchunk = true;
-                        tsn_s = g_new(struct tsn_sort, 1);
-                        tsn_s->tsnumber = tsnumber;
-                        tsn_s->secs     = tsn->secs = (uint32_t)pinfo->rel_ts.secs;
-                        tsn_s->usecs    = tsn->usecs = (uint32_t)pinfo->rel_ts.nsecs/1000;
-                        tsn_s->offset   = 0;
-                        tsn_s->framenumber = framenumber;
-                        tsn_s->length   =  tvb_get_ntohl(sctp_info->tvb[chunk_number], SACK_CHUNK_ADV_REC_WINDOW_CREDIT_OFFSET);
-                        if (tsn_s->length > info->max_window1)
-                            info->max_window1 = tsn_s->length;
-                        if (tsn->secs < info->min_secs)
-                        {
-                            info->min_secs  = tsn->secs;
-                            info->min_usecs = tsn->usecs;
-                        }
-                        else if (tsn->secs == info->min_secs && tsn->usecs < info->min_usecs)
-                            info->min_usecs = tsn->usecs;
-
-                        if (tsn->secs > info->max_secs)
-                        {
-                            info->max_secs  = tsn->secs;
-                            info->max_usecs = tsn->usecs;
-                        }
-                        else if (tsn->secs == info->max_secs && tsn->usecs > info->max_usecs)
-                            info->max_usecs = tsn->usecs;
-                        g_ptr_array_add(info->sort_sack2, tsn_s);
+                        add_sack_chunk(info->sack2, info->sack_data2, pinfo, sctp_info->tvb[chunk_number], length);
+                        arwnd = tvb_get_ntohl(sctp_info->tvb[chunk_number], SACK_CHUNK_ADV_REC_WINDOW_CREDIT_OFFSET);
+                        if (arwnd > info->max_window1)
+                            info->max_window1 = arwnd;
+                        update_time_range(info, secs, usecs);
                         info->n_sack_chunks_ep2++;
                     }
                 }
@@ -723,15 +605,7 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                 else
                     info = add_address(store, info, 1);
                 number = pinfo->num;
-                info->frame_numbers=g_list_prepend(info->frame_numbers, GUINT_TO_POINTER(number));
-                if (datachunk || forwardchunk) {
-                    info->tsn1 = g_list_prepend(info->tsn1, tsn);
-                    tsn_used = true;
-                }
-                if (sackchunk == true) {
-                    info->sack2 = g_list_prepend(info->sack2, sack);
-                    sack_used = true;
-                }
+                g_array_append_val(info->frame_numbers, number);
                 sctp_tapinfo_struct.assoc_info_list = g_list_append(sctp_tapinfo_struct.assoc_info_list, info);
             }
             else
@@ -771,51 +645,16 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
         } else if (info->verification_tag2 == 0 && info->verification_tag1 != sctp_info->verification_tag) {
             info->verification_tag2 = sctp_info->verification_tag;
         }
-        if (((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_INIT_CHUNK_ID) ||
-                ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_INIT_ACK_CHUNK_ID) ||
-                ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_DATA_CHUNK_ID) ||
+        if (((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_DATA_CHUNK_ID) ||
                 ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_I_DATA_CHUNK_ID) ||
                 ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_SACK_CHUNK_ID) ||
                 ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_NR_SACK_CHUNK_ID) ||
                 ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_FORWARD_TSN_CHUNK_ID))
         {
-
-            tsn = g_new0(tsn_t, 1);
-            copy_address(&tsn->src, &tmp_info.src);
-            copy_address(&tsn->dst, &tmp_info.dst);
-
-            sack = g_new0(tsn_t, 1);
-            copy_address(&sack->src, &tmp_info.src);
-            copy_address(&sack->dst, &tmp_info.dst);
-            sack->secs=tsn->secs = (uint32_t)pinfo->rel_ts.secs;
-            sack->usecs=tsn->usecs = (uint32_t)pinfo->rel_ts.nsecs/1000;
-
-            if (((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_DATA_CHUNK_ID) ||
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_I_DATA_CHUNK_ID) ||
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_SACK_CHUNK_ID) ||
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_NR_SACK_CHUNK_ID) ||
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) == SCTP_FORWARD_TSN_CHUNK_ID))
-            {
-                if (tsn->secs < info->min_secs)
-                {
-                    info->min_secs  = tsn->secs;
-                    info->min_usecs = tsn->usecs;
-                }
-                else if (tsn->secs == info->min_secs && tsn->usecs < info->min_usecs)
-                    info->min_usecs = tsn->usecs;
-
-                if (tsn->secs > info->max_secs)
-                {
-                    info->max_secs  = tsn->secs;
-                    info->max_usecs = tsn->usecs;
-                }
-                else if (tsn->secs == info->max_secs && tsn->usecs > info->max_usecs)
-                    info->max_usecs = tsn->usecs;
-            }
-            sack->frame_number = tsn->frame_number = pinfo->num;
+            update_time_range(info, secs, usecs);
         }
         number = pinfo->num;
-        info->frame_numbers=g_list_prepend(info->frame_numbers, GUINT_TO_POINTER(number));
+        g_array_append_val(info->frame_numbers, number);
 
         store = g_new(address, 1);
         copy_address(store, &tmp_info.src);
@@ -860,8 +699,6 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                 info->instream2 = tvb_get_ntohs(sctp_info->tvb[0],INIT_CHUNK_NUMBER_OF_INBOUND_STREAMS_OFFSET);
                 info->outstream2 = tvb_get_ntohs(sctp_info->tvb[0],INIT_CHUNK_NUMBER_OF_OUTBOUND_STREAMS_OFFSET);
                 info->arwnd2 = tvb_get_ntohl(sctp_info->tvb[0],INIT_CHUNK_ADV_REC_WINDOW_CREDIT_OFFSET);
-                info->tsn2 = g_list_prepend(info->tsn2, tsn);
-                tsn_used = true;
             }
             else if (info->direction == 1)
             {
@@ -872,8 +709,6 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                 info->instream1 = tvb_get_ntohs(sctp_info->tvb[0],INIT_CHUNK_NUMBER_OF_INBOUND_STREAMS_OFFSET);
                 info->outstream1 = tvb_get_ntohs(sctp_info->tvb[0],INIT_CHUNK_NUMBER_OF_OUTBOUND_STREAMS_OFFSET);
                 info->arwnd1 = tvb_get_ntohl(sctp_info->tvb[0],INIT_CHUNK_ADV_REC_WINDOW_CREDIT_OFFSET);
-                info->tsn1 = g_list_prepend(info->tsn1, tsn);
-                tsn_used = true;
             }
 
             idx = tvb_get_uint8(sctp_info->tvb[0],0);
@@ -944,22 +779,6 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
         }
         else
         {
-            if (((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_INIT_ACK_CHUNK_ID) &&
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_DATA_CHUNK_ID) &&
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_I_DATA_CHUNK_ID) &&
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_SACK_CHUNK_ID) &&
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_NR_SACK_CHUNK_ID) &&
-                    ((tvb_get_uint8(sctp_info->tvb[0],0)) != SCTP_FORWARD_TSN_CHUNK_ID))
-            {
-                if (!sack)
-                    sack = g_new0(tsn_t, 1);
-                sack->tsns = NULL;
-                sack->first_tsn = 0;
-                if (!tsn)
-                    tsn = g_new0(tsn_t, 1);
-                tsn->tsns = NULL;
-                tsn->first_tsn = 0;
-            }
             for (chunk_number = 0; chunk_number < sctp_info->number_of_tvbs; chunk_number++)
             {
                 idx = tvb_get_uint8(sctp_info->tvb[chunk_number],0);
@@ -978,15 +797,11 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                     datachunk = true;
                 if (tvb_get_uint8(sctp_info->tvb[chunk_number],0) == SCTP_FORWARD_TSN_CHUNK_ID)
                     forwardchunk = true;
-                if ((datachunk || forwardchunk) && tsn != NULL)
+                if (datachunk || forwardchunk)
                 {
                     tsnumber = tvb_get_ntohl((sctp_info->tvb)[chunk_number], DATA_CHUNK_TSN_OFFSET);
-                    if (tsn->first_tsn == 0)
-                        tsn->first_tsn = tsnumber;
                     if (datachunk)
                     {
-                        t_s_n = (uint8_t *)g_malloc(16);
-                        tvb_memcpy(sctp_info->tvb[chunk_number], (uint8_t *)(t_s_n),0, 16);
                         if (tvb_get_uint8(sctp_info->tvb[chunk_number],0) == SCTP_DATA_CHUNK_ID) {
                             length=tvb_get_ntohs(sctp_info->tvb[chunk_number], CHUNK_LENGTH_OFFSET)-DATA_CHUNK_HEADER_LENGTH;
                         } else {
@@ -998,35 +813,11 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                     else
                     {
                         length=tvb_get_ntohs(sctp_info->tvb[chunk_number], CHUNK_LENGTH_OFFSET);
-                        t_s_n = (uint8_t *)g_malloc(length);
-                        tvb_memcpy(sctp_info->tvb[chunk_number], (uint8_t *)(t_s_n),0, length);
                         info->n_forward_chunks++;
                     }
-                    tsn->tsns = g_list_append(tsn->tsns, t_s_n);
-
-                    tsn_s = g_new0(struct tsn_sort, 1);
-                    tsn_s->tsnumber = tsnumber;
-                    tsn_s->secs  = tsn->secs = (uint32_t)pinfo->rel_ts.secs;
-                    tsn_s->usecs = tsn->usecs = (uint32_t)pinfo->rel_ts.nsecs/1000;
-                    tsn_s->offset = 0;
-                    tsn_s->framenumber = framenumber;
-                    tsn_s->length = length;
-
-                    if (tsn->secs < info->min_secs)
-                    {
-                        info->min_secs  = tsn->secs;
-                        info->min_usecs = tsn->usecs;
-                    }
-                    else if (tsn->secs == info->min_secs && tsn->usecs < info->min_usecs)
-                        info->min_usecs = tsn->usecs;
+                    chunk_length = datachunk ? length : 0;
 
-                    if (tsn->secs > info->max_secs)
-                    {
-                        info->max_secs  = tsn->secs;
-                        info->max_usecs = tsn->usecs;
-                    }
-                    else if (tsn->secs == info->max_secs && tsn->usecs > info->max_usecs)
-                        info->max_usecs = tsn->usecs;
+                    update_time_range(info, secs, usecs);
 
                     if (info->direction == 1)
                     {
@@ -1080,7 +871,7 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                             }
                         }
 
-                        g_ptr_array_add(info->sort_tsn1, tsn_s);
+                        add_tsn_chunk(info->tsn1, pinfo, sctp_info->tvb[chunk_number], tsnumber, chunk_length);
                         info->n_array_tsn1++;
                     }
                     else if (info->direction == 2)
@@ -1146,48 +937,18 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                             }
                         }
 
-                        g_ptr_array_add(info->sort_tsn2, tsn_s);
+                        add_tsn_chunk(info->tsn2, pinfo, sctp_info->tvb[chunk_number], tsnumber, chunk_length);
                         info->n_array_tsn2++;
                     }
                 }
-                else if (((tvb_get_uint8(sctp_info->tvb[chunk_number],0) == SCTP_SACK_CHUNK_ID) ||
-                            (tvb_get_uint8(sctp_info->tvb[chunk_number],0) == SCTP_NR_SACK_CHUNK_ID)) &&
-                        sack != NULL)
+                else if ((tvb_get_uint8(sctp_info->tvb[chunk_number],0) == SCTP_SACK_CHUNK_ID) ||
+                            (tvb_get_uint8(sctp_info->tvb[chunk_number],0) == SCTP_NR_SACK_CHUNK_ID))
                 {
                     tsnumber = tvb_get_ntohl((sctp_info->tvb)[chunk_number], SACK_CHUNK_CUMULATIVE_TSN_ACK_OFFSET);
                     length = tvb_get_ntohs(sctp_info->tvb[chunk_number], CHUNK_LENGTH_OFFSET);
+                    arwnd = tvb_get_ntohl(sctp_info->tvb[chunk_number], SACK_CHUNK_ADV_REC_WINDOW_CREDIT_OFFSET);
 
-                    if (sack->first_tsn == 0)
-                        sack->first_tsn = tsnumber;
-
-                    t_s_n = (uint8_t *)g_malloc(length);
-                    tvb_memcpy(sctp_info->tvb[chunk_number], (uint8_t *)(t_s_n),0, length);
-                    sack->tsns = g_list_append(sack->tsns, t_s_n);
-                    sackchunk = true;
-                    tsn_s = g_new0(struct tsn_sort, 1);
-                    tsn_s->tsnumber = tsnumber;
-                    tsn_s->secs   = tsn->secs = (uint32_t)pinfo->rel_ts.secs;
-                    tsn_s->usecs  = tsn->usecs = (uint32_t)pinfo->rel_ts.nsecs/1000;
-                    tsn_s->offset = 0;
-                    tsn_s->framenumber = framenumber;
-                    tsn_s->length = tvb_get_ntohl(sctp_info->tvb[chunk_number], SACK_CHUNK_ADV_REC_WINDOW_CREDIT_OFFSET);
-
-                    if (tsn->secs < info->min_secs)
-                    {
-                        info->min_secs  = tsn->secs;
-                        info->min_usecs = tsn->usecs;
-                    }
-                    else if (tsn->secs == info->min_secs && tsn->usecs < info->min_usecs)
-                        info->min_usecs = tsn->usecs;
-
-                    if (tsn->secs > info->max_secs)
-                    {
-                        info->max_secs  = tsn->secs;
-                        info->max_usecs = tsn->usecs;
-                    }
-                    else if (tsn->secs == info->max_secs && tsn->usecs > info->max_usecs)
-                        info->max_usecs = tsn->usecs;
-
+                    update_time_range(info, secs, usecs);
 
                     if (info->direction == 2)
                     {
@@ -1195,9 +956,9 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                             info->min_tsn1 = tsnumber;
                         if(tsnumber > info->max_tsn1)
                             info->max_tsn1 = tsnumber;
-                        if (tsn_s->length > info->max_window1)
-                            info->max_window1 = tsn_s->length;
-                        g_ptr_array_add(info->sort_sack1, tsn_s);
+                        if (arwnd > info->max_window1)
+                            info->max_window1 = arwnd;
+                        add_sack_chunk(info->sack1, info->sack_data1, pinfo, sctp_info->tvb[chunk_number], length);
                         info->n_sack_chunks_ep1++;
                     }
                     else if (info->direction == 1)
@@ -1206,40 +967,20 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                             info->min_tsn2 = tsnumber;
                         if(tsnumber > info->max_tsn2)
                             info->max_tsn2 = tsnumber;
-                        if (tsn_s->length > info->max_window2)
-                            info->max_window2 = tsn_s->length;
-                        g_ptr_array_add(info->sort_sack2, tsn_s);
+                        if (arwnd > info->max_window2)
+                            info->max_window2 = arwnd;
+                        add_sack_chunk(info->sack2, info->sack_data2, pinfo, sctp_info->tvb[chunk_number], length);
                         info->n_sack_chunks_ep2++;
                     }
                 }
             }
         }
 
-        if (datachunk || forwardchunk)
-        {
-            if (info->direction == 1)
-                info->tsn1 = g_list_prepend(info->tsn1, tsn);
-            else if (info->direction == 2)
-                info->tsn2 = g_list_prepend(info->tsn2, tsn);
-            tsn_used = true;
-        }
-        if (sackchunk == true)
-        {
-            if (info->direction == 1)
-                info->sack2 = g_list_prepend(info->sack2, sack);
-            else if(info->direction == 2)
-                info->sack1 = g_list_prepend(info->sack1, sack);
-            sack_used = true;
-        }
         info->n_tvbs += sctp_info->number_of_tvbs;
         sctp_tapinfo_struct.sum_tvbs += sctp_info->number_of_tvbs;
         info = calc_checksum(sctp_info, info);
         info->n_packets++;
     }
-    if (tsn && !tsn_used)
-        tsn_free(tsn);
-    if (sack && !sack_used)
-        tsn_free(sack);
     free_address(&tmp_info.src);
     free_address(&tmp_info.dst);
     return TAP_PACKET_REDRAW;
@@ -1278,6 +1019,33 @@ get_sctp_assoc_info(uint16_t assoc_id)
     return find_assoc(&needle);
 }
 
+bool
+sctp_assoc_has_frame(const sctp_assoc_info_t *assoc, uint32_t frame_number)
+{
+    const uint32_t *frames = (const uint32_t *)(void *)assoc->frame_numbers->data;
+    unsigned low = 0, high = assoc->frame_numbers->len;
+
+    /* Frames are added as they are tapped, so they are in order. */
+    while (low < high)
+    {
+        unsigned mid = low + (high - low) / 2;
+
+        if (frames[mid] < frame_number)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low < assoc->frame_numbers->len && frames[low] == frame_number;
+}
+
+const void *
+sctp_assoc_sack_data(const sctp_assoc_info_t *assoc, int direction, const sctp_sack_chunk_t *chunk)
+{
+    const GByteArray *sack_data = (direction == 1) ? assoc->sack_data1 : assoc->sack_data2;
+
+    return sack_data->data + chunk->offset;
+}
+
 void
 register_tap_listener_sctp_stat(void)
 {
@@ -138,15 +138,26 @@ extern "C" {
  */
 #define MAX_SCTP_CHUNK_TYPE 256
 
-typedef struct _tsn {
+/* A DATA, I-DATA or FORWARD-TSN chunk, or another chunk bundled after one. */
+typedef struct _sctp_tsn_chunk {
 	uint32_t	 frame_number;
-	uint32_t	 secs;		/* Absolute seconds */
+	uint32_t	 secs;		/* Relative seconds */
 	uint32_t	 usecs;
-	address	 src;
-	address	 dst;
-	uint32_t	 first_tsn;
-	GList	*tsns;
-} tsn_t;
+	uint32_t	 tsn;
+	uint32_t	 length;	/* of the user data */
+	uint8_t		 type;
+} sctp_tsn_chunk_t;
+
+/* A SACK or NR-SACK chunk; the chunk itself is kept in the association's
+ * sack_data, 4-byte aligned. */
+typedef struct _sctp_sack_chunk {
+	uint32_t	 frame_number;
+	uint32_t	 secs;		/* Relative seconds */
+	uint32_t	 usecs;
+	uint32_t	 offset;
+	uint16_t	 length;
+	uint8_t		 type;
+} sctp_sack_chunk_t;
 
 typedef struct _sctp_tmp_info {
 	uint16_t assoc_id;
@@ -170,15 +181,6 @@ typedef struct _sctp_init_collision {
 	bool    initack:1;
 } sctp_init_collision_t;
 
-struct tsn_sort{
-	uint32_t tsnumber;
-	uint32_t secs;
-	uint32_t usecs;
-	uint32_t offset;
-	uint32_t length;
-	uint32_t framenumber;
-};
-
 typedef struct _sctp_addr_chunk {
 	uint32_t	 direction;
 	address addr;
@@ -251,16 +253,13 @@ typedef struct _sctp_assoc_info {
 	uint32_t   max_bytes2;
 	sctp_init_collision_t *dir1;
 	sctp_init_collision_t *dir2;
-	GSList	  *min_max;
-	GList	  *frame_numbers;
-	GList	  *tsn1;
-	GPtrArray *sort_tsn1;
-	GPtrArray *sort_sack1;
-	GList	  *sack1;
-	GList	  *tsn2;
-	GPtrArray *sort_tsn2;
-	GPtrArray *sort_sack2;
-	GList	  *sack2;
+	GArray	  *frame_numbers;	/* uint32_t, in the order seen */
+	GArray	  *tsn1;		/* sctp_tsn_chunk_t */
+	GArray	  *sack1;		/* sctp_sack_chunk_t */
+	GByteArray *sack_data1;
+	GArray	  *tsn2;
+	GArray	  *sack2;
+	GByteArray *sack_data2;
 	bool       check_address;
 	GList*	   error_info_list;
 	/* The array is initialized to MAX_SCTP_CHUNK_TYPE
@@ -300,6 +299,13 @@ void remove_tap_listener_sctp_stat(void);
 const sctp_assoc_info_t* get_sctp_assoc_info(uint16_t assoc_id);
 const sctp_assoc_info_t* get_selected_assoc(void);
 
+/** Return true if the frame was one of the association's. */
+bool sctp_assoc_has_frame(const sctp_assoc_info_t *assoc, uint32_t frame_number);
+
+/** Return a SACK or NR-SACK chunk of the association. */
+const void *sctp_assoc_sack_data(const sctp_assoc_info_t *assoc, int direction,
+    const sctp_sack_chunk_t *chunk);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
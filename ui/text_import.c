@@ -1729,6 +1729,393 @@ parse_token(token_t token, char *str)
     return IMPORT_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+ * Hex dump lines
+ *
+ * Most lines of a hex dump are an offset, bytes, and maybe an ASCII dump,
+ * which the scanner turns into a token and a call to parse_num() for each
+ * byte. Those lines are tokenized and their bytes decoded here instead,
+ * for large inputs on several threads at once; that doesn't depend on the
+ * state machine, which then gets the lines in order, with only the offset
+ * going through parse_token(). Any other line, or a line whose offset
+ * doesn't continue the packet, is given to the scanner as before.
+ */
+
+/* Input is read and tokenized this much at a time. */
+#define HEXDUMP_CHUNK_SIZE      (4 * 1024 * 1024)
+/* Smaller parts of a chunk aren't worth a thread of their own. */
+#define HEXDUMP_SLICE_MIN_SIZE  (256 * 1024)
+#define HEXDUMP_MAX_SLICES      8
+
+#define HEXDUMP_IS_BLANK(c)     ((c) == ' ' || (c) == '\t')
+#define HEXDUMP_NIBBLE(c)       (hex_decode_info.table[(unsigned char)(c)])
+
+typedef struct {
+    uint32_t start;         /* in the chunk */
+    uint32_t len;           /* without the end of line */
+    uint32_t next;          /* start of the next line */
+    bool has_eol;
+    /* Set if the line was tokenized; the scanner gets the line otherwise. */
+    uint32_t lead_len;      /* the offset, or the first byte with no offsets */
+    uint32_t lead_start;
+    token_t lead_token;
+    uint32_t num_bytes;     /* the bytes after the lead */
+    uint32_t bytes_start;   /* in the slice's decoded bytes */
+    uint32_t text_len;      /* 0 if there's nothing after the bytes */
+    uint32_t text_start;
+} hexdump_line_t;
+
+typedef struct {
+    char *chunk;
+    uint32_t start;
+    uint32_t end;
+    GArray *lines;          /* of hexdump_line_t */
+    GByteArray *bytes;
+} hexdump_slice_t;
+
+/*
+ * The token the scanner makes of a run of characters between blanks.
+ * The text rule matches the whole run, so it's the longest match unless
+ * another rule matches all of it too, and wins as the earlier rule.
+ */
+static token_t
+hexdump_run_token(const char *run, size_t len)
+{
+    size_t i = 0, digits;
+
+    for (digits = 0; digits < len && HEXDUMP_NIBBLE(run[digits]) >= 0; digits++)
+        ;
+    if (digits == len) {
+        switch (len) {
+        case 2:
+            return T_BYTE;
+        case 4: case 6: case 8:
+            return T_BYTES;
+        case 3: case 5: case 7:
+            return T_OFFSET;
+        default:
+            return T_TEXT;
+        }
+    }
+
+    if (len > 2 && run[0] == '0' && (run[1] == 'x' || run[1] == 'X'))
+        i = 2;
+    for (digits = 0; i < len && HEXDUMP_NIBBLE(run[i]) >= 0; i++, digits++)
+        ;
+    if (i < len && run[i] == ':')
+        i++;
+    return (i == len && digits >= 3 && digits <= 8) ? T_OFFSET : T_TEXT;
+}
+
+/*
+ * Where the line after an end of line at nl starts. The end of line can
+ * take a carriage return after the newline, as in the scanner (which
+ * wouldn't treat what follows as the start of a line, but nothing writes
+ * those.)
+ */
+static uint32_t
+hexdump_after_eol(const char *chunk, uint32_t nl, uint32_t len)
+{
+    if (nl + 1 < len && chunk[nl + 1] == '\r')
+        return nl + 2;
+    return nl + 1;
+}
+
+/*
+ * Tokenize a line that is an offset (or, with no offsets, a byte) followed
+ * by at least one byte, and optionally text, decoding the bytes. Anything
+ * else is left for the scanner.
+ */
+static void
+hexdump_tokenize_line(hexdump_slice_t *slice, hexdump_line_t *line)
+{
+    const char *p = slice->chunk + line->start;
+    const char *end = p + line->len;
+    const char *run, *run_end;
+    token_t token;
+    unsigned base = slice->bytes->len;
+    uint8_t *out, *out_start;
+
+    /* A carriage return that doesn't end the line isn't a token at all. */
+    if (memchr(p, '\r', line->len) != NULL)
+        return;
+
+    while (p < end && HEXDUMP_IS_BLANK(*p))
+        p++;
+    run = p;
+    while (p < end && !HEXDUMP_IS_BLANK(*p))
+        p++;
+    run_end = p;
+    token = hexdump_run_token(run, run_end - run);
+    if (offset_base != 0 ? (token != T_OFFSET && token != T_BYTES) : token != T_BYTE)
+        return;
+
+    /* Each byte is a blank and two digits. */
+    g_byte_array_set_size(slice->bytes, base + (unsigned)((end - p) / 3) + 1);
+    out_start = out = slice->bytes->data + base;
+    for (;;) {
+        while (p < end && HEXDUMP_IS_BLANK(*p))
+            p++;
+        if (p == end) {
+            break;
+        }
+        if (end - p >= 2 && HEXDUMP_NIBBLE(p[0]) >= 0 && HEXDUMP_NIBBLE(p[1]) >= 0 &&
+            (end - p == 2 || HEXDUMP_IS_BLANK(p[2]))) {
+            *out++ = (uint8_t)(HEXDUMP_NIBBLE(p[0]) << 4 | HEXDUMP_NIBBLE(p[1]));
+            p += 2;
+            continue;
+        }
+
+        /* Anything but a byte group ends the bytes, and the rest is ignored. */
+        const char *text = p;
+        while (p < end && !HEXDUMP_IS_BLANK(*p))
+            p++;
+        if (hexdump_run_token(text, p - text) == T_BYTES) {
+            out = out_start;
+            break;
+        }
+        line->text_start = (uint32_t)(text - slice->chunk);
+        line->text_len = (uint32_t)(p - text);
+        break;
+    }
+
+    g_byte_array_set_size(slice->bytes, base + (unsigned)(out - out_start));
+    if (out == out_start)
+        return;
+
+    line->lead_start = (uint32_t)(run - slice->chunk);
+    line->lead_len = (uint32_t)(run_end - run);
+    line->lead_token = token;
+    line->num_bytes = (uint32_t)(out - out_start);
+    line->bytes_start = base;
+}
+
+static void *
+hexdump_slice_worker(void *data)
+{
+    hexdump_slice_t *slice = (hexdump_slice_t *)data;
+    uint32_t pos = slice->start;
+
+    while (pos < slice->end) {
+        hexdump_line_t line = { 0 };
+        const char *nl = (const char *)memchr(slice->chunk + pos, '\n', slice->end - pos);
+        uint32_t line_end;
+
+        line.start = pos;
+        if (nl != NULL) {
+            line_end = (uint32_t)(nl - slice->chunk);
+            line.next = hexdump_after_eol(slice->chunk, line_end, slice->end);
+            line.has_eol = true;
+            if (line_end > pos && slice->chunk[line_end - 1] == '\r')
+                line_end--;
+        } else {
+            /* The last line of the input. */
+            line_end = line.next = slice->end;
+        }
+        line.len = line_end - pos;
+        hexdump_tokenize_line(slice, &line);
+        g_array_append_val(slice->lines, line);
+        pos = line.next;
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------
+ * Write bytes already decoded into the current packet
+ */
+static import_status_t
+write_decoded_bytes(const uint8_t *bytes, uint32_t nbytes)
+{
+    while (nbytes > 0) {
+        uint32_t count = MIN(nbytes, info_p->max_frame_length - curr_offset);
+
+        memcpy(&packet_buf[curr_offset], bytes, count);
+        curr_offset += count;
+        bytes += count;
+        nbytes -= count;
+        if (curr_offset >= info_p->max_frame_length) /* packet full */
+            if (start_new_packet(true) != IMPORT_SUCCESS)
+                return IMPORT_FAILURE;
+    }
+
+    return IMPORT_SUCCESS;
+}
+
+/* Pass a token of a line to parse_token(), which wants it NUL-terminated. */
+static import_status_t
+hexdump_parse_token(token_t token, char *chunk, uint32_t start, uint32_t len)
+{
+    char saved = chunk[start + len];
+    import_status_t status;
+
+    chunk[start + len] = '\0';
+    status = parse_token(token, chunk + start);
+    chunk[start + len] = saved;
+    return status;
+}
+
+/*----------------------------------------------------------------------
+ * Process a tokenized line, doing what the tokens from the scanner would
+ */
+static import_status_t
+process_hexdump_line(void *scanner, char *chunk, const hexdump_line_t *line, const uint8_t *bytes)
+{
+    parser_state_t expected = (line->lead_token == T_BYTE) ? READ_BYTE : READ_OFFSET;
+    uint32_t rest = line->lead_start + line->lead_len;
+
+    if (hexdump_parse_token(line->lead_token, chunk, line->lead_start, line->lead_len) != IMPORT_SUCCESS)
+        return IMPORT_FAILURE;
+    if (state != expected) {
+        /* Not part of a packet; the scanner gets the rest of the line. */
+        return text_import_scan_line(scanner, chunk + rest, line->next - rest);
+    }
+
+    state = READ_BYTE;
+    if (write_decoded_bytes(bytes, line->num_bytes) != IMPORT_SUCCESS)
+        return IMPORT_FAILURE;
+    if (line->text_len > 0 &&
+        hexdump_parse_token(T_TEXT, chunk, line->text_start, line->text_len) != IMPORT_SUCCESS)
+        return IMPORT_FAILURE;
+    if (line->has_eol && parse_token(T_EOL, NULL) != IMPORT_SUCCESS)
+        return IMPORT_FAILURE;
+
+    return IMPORT_SUCCESS;
+}
+
+/*
+ * The end of the last whole line in the chunk, whose end of line is
+ * followed by something (so that it's known whether that's a carriage
+ * return belonging to it), or 0 if there's none.
+ */
+static uint32_t
+hexdump_last_line_end(const char *chunk, uint32_t len)
+{
+    if (len < 2)
+        return 0;
+    for (uint32_t i = len - 1; i-- > 0; ) {
+        if (chunk[i] == '\n')
+            return hexdump_after_eol(chunk, i, len);
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------
+ * Import a hex dump
+ */
+static import_status_t
+text_import_hexdump(FILE *input)
+{
+    hexdump_slice_t slices[HEXDUMP_MAX_SLICES];
+    GThread *threads[HEXDUMP_MAX_SLICES];
+    unsigned max_slices = MIN(g_get_num_processors(), HEXDUMP_MAX_SLICES);
+    size_t capacity = HEXDUMP_CHUNK_SIZE;
+    uint32_t len = 0;
+    /* One more byte, to NUL-terminate a token at the end. */
+    char *chunk = (char *)g_malloc(capacity + 1);
+    bool eof = false;
+    import_status_t status = IMPORT_SUCCESS;
+    void *scanner;
+
+    scanner = text_import_line_scanner_new();
+    if (scanner == NULL) {
+        g_free(chunk);
+        return IMPORT_INIT_FAILED;
+    }
+
+    for (unsigned i = 0; i < HEXDUMP_MAX_SLICES; i++) {
+        slices[i].lines = g_array_new(false, false, sizeof(hexdump_line_t));
+        slices[i].bytes = g_byte_array_new();
+    }
+
+    while (status == IMPORT_SUCCESS && !(eof && len == 0)) {
+        uint32_t used;
+        unsigned num_slices;
+
+        if (!eof) {
+            size_t want = capacity - len;
+            size_t got = fread(chunk + len, 1, want, input);
+
+            len += (uint32_t)got;
+            if (got < want) {
+                if (ferror(input)) {
+                    report_failure("Error reading the input: %s", g_strerror(errno));
+                    status = IMPORT_FAILURE;
+                    break;
+                }
+                eof = true;
+            }
+        }
+
+        used = eof ? len : hexdump_last_line_end(chunk, len);
+        if (used == 0) {
+            /* A line longer than the buffer. */
+            if (capacity > UINT32_MAX / 2) {
+                report_failure("Line too long in the input");
+                status = IMPORT_FAILURE;
+                break;
+            }
+            capacity *= 2;
+            chunk = (char *)g_realloc(chunk, capacity + 1);
+            continue;
+        }
+
+        /* Split the chunk at line ends. */
+        num_slices = MAX(1, MIN(max_slices, used / HEXDUMP_SLICE_MIN_SIZE));
+        for (unsigned i = 0; i < num_slices; i++) {
+            uint32_t end = used;
+
+            if (i + 1 < num_slices) {
+                uint32_t target = (uint32_t)((uint64_t)used * (i + 1) / num_slices);
+                const char *nl = (const char *)memchr(chunk + target, '\n', used - target);
+
+                if (nl != NULL)
+                    end = hexdump_after_eol(chunk, (uint32_t)(nl - chunk), used);
+            }
+            slices[i].chunk = chunk;
+            slices[i].start = (i == 0) ? 0 : slices[i - 1].end;
+            slices[i].end = MAX(end, slices[i].start);
+            g_array_set_size(slices[i].lines, 0);
+            g_byte_array_set_size(slices[i].bytes, 0);
+        }
+
+        for (unsigned i = 1; i < num_slices; i++) {
+            threads[i] = g_thread_new("Text import", hexdump_slice_worker, &slices[i]);
+        }
+        hexdump_slice_worker(&slices[0]);
+        for (unsigned i = 1; i < num_slices; i++) {
+            g_thread_join(threads[i]);
+        }
+
+        /* Feed the lines to the state machine in order. */
+        for (unsigned i = 0; i < num_slices && status == IMPORT_SUCCESS; i++) {
+            for (unsigned j = 0; j < slices[i].lines->len && status == IMPORT_SUCCESS; j++) {
+                const hexdump_line_t *line = &g_array_index(slices[i].lines, hexdump_line_t, j);
+
+                if (line->lead_len > 0) {
+                    status = process_hexdump_line(scanner, chunk, line, slices[i].bytes->data + line->bytes_start);
+                } else {
+                    status = text_import_scan_line(scanner, chunk + line->start, line->next - line->start);
+                }
+            }
+        }
+
+        memmove(chunk, chunk + used, len - used);
+        len -= used;
+    }
+
+    if (status == IMPORT_SUCCESS)
+        status = parse_token(T_EOF, NULL);
+
+    for (unsigned i = 0; i < HEXDUMP_MAX_SLICES; i++) {
+        g_array_free(slices[i].lines, true);
+        g_byte_array_free(slices[i].bytes, true);
+    }
+    text_import_line_scanner_free(scanner);
+    g_free(chunk);
+    return status;
+}
+
 /*----------------------------------------------------------------------
  * Import a text file.
  */
@@ -1912,7 +2299,7 @@ text_import(text_import_info_t * const info)
     }
 
     if (info->mode == TEXT_IMPORT_HEXDUMP) {
-        status = text_import_scan(info->hexdump.import_text_FILE);
+        status = text_import_hexdump(info->hexdump.import_text_FILE);
         switch(status) {
         case (IMPORT_SUCCESS):
             ret = 0;
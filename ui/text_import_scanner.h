@@ -41,7 +41,16 @@ import_status_t parse_token(token_t token, char *str);
 
 extern FILE *text_importin;
 
-import_status_t text_import_scan(FILE *input_file);
+/*
+ * The scanner is run a line at a time, for the lines of a hex dump that
+ * text_import() doesn't tokenize itself. The end of a line isn't taken as
+ * the end of the input, so T_EOF is left to the caller.
+ */
+void *text_import_line_scanner_new(void);
+
+import_status_t text_import_scan_line(void *scanner, const char *line, size_t len);
+
+void text_import_line_scanner_free(void *scanner);
 
 #ifdef __cplusplus
 }
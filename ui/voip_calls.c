@@ -293,6 +293,10 @@ voip_calls_reset_all_taps(voip_calls_tapinfo_t *tapinfo)
     }
     g_list_free(tapinfo->rtpstream_list);
     tapinfo->rtpstream_list = NULL;
+    if (tapinfo->rtpstream_open_hash) {
+        g_hash_table_destroy(tapinfo->rtpstream_open_hash);
+        tapinfo->rtpstream_open_hash = NULL;
+    }
 
     g_free(tapinfo->sdp_summary);
     tapinfo->sdp_summary = NULL;
@@ -601,6 +605,9 @@ rtp_reset(void *tap_offset_ptr)
     g_list_free(tapinfo->rtpstream_list);
     tapinfo->rtpstream_list = NULL;
     tapinfo->nrtpstreams = 0;
+    if (tapinfo->rtpstream_open_hash) {
+        g_hash_table_remove_all(tapinfo->rtpstream_open_hash);
+    }
 
     // Do not touch graph_analysis, it is handled by caller
 
@@ -611,15 +618,35 @@ rtp_reset(void *tap_offset_ptr)
     return;
 }
 
+/****************************************************************************/
+/* Streams that are not ended yet are indexed by setup frame and SSRC, so
+ * that RTP packets do not have to walk the list of all streams seen so far. */
+static uint64_t
+rtp_open_stream_key(uint32_t setup_frame_number, uint32_t ssrc)
+{
+    return ((uint64_t)setup_frame_number << 32) | ssrc;
+}
+
+static void
+rtp_end_stream(voip_calls_tapinfo_t *tapinfo, rtpstream_info_t *strinfo)
+{
+    uint64_t key = rtp_open_stream_key(strinfo->setup_frame_number, strinfo->id.ssrc);
+
+    strinfo->end_stream = true;
+    if (tapinfo->rtpstream_open_hash) {
+        g_hash_table_remove(tapinfo->rtpstream_open_hash, &key);
+    }
+}
+
 /****************************************************************************/
 /* whenever a RTP packet is seen by the tap listener */
 static tap_packet_status
 rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void const *rtp_info_ptr, tap_flags_t flags)
 {
     voip_calls_tapinfo_t *tapinfo = tap_id_to_base(tap_offset_ptr, tap_id_offset_rtp_);
-    rtpstream_info_t    *tmp_listinfo;
+    rtpstream_info_t    *tmp_listinfo = NULL;
     rtpstream_info_t    *strinfo = NULL;
-    GList                *list;
+    uint64_t             key;
     struct _rtp_packet_info *p_packet_data = NULL;
 
     const struct _rtp_info *rtp_info = (const struct _rtp_info *)rtp_info_ptr;
@@ -634,30 +661,26 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
     }
 
     /* check whether we already have a RTP stream with this setup frame and ssrc in the list */
-    list = g_list_first(tapinfo->rtpstream_list);
-    while (list)
-    {
-        tmp_listinfo=(rtpstream_info_t *)list->data;
-        if ( (tmp_listinfo->setup_frame_number == rtp_info->info_setup_frame_num)
-                && (tmp_listinfo->id.ssrc == rtp_info->info_sync_src) && (tmp_listinfo->end_stream == false)) {
-            /* if the payload type has changed, we mark the stream as finished to create a new one
-               this is to show multiple payload changes in the Graph for example for DTMF RFC2833 */
-            if ( tmp_listinfo->first_payload_type != rtp_info->info_payload_type ) {
-                tmp_listinfo->end_stream = true;
-            } else if ( ( ( tmp_listinfo->ed137_info == NULL ) && (rtp_info->info_ed137_info != NULL) ) ||
-                        ( ( tmp_listinfo->ed137_info != NULL ) && (rtp_info->info_ed137_info == NULL) ) ||
-                        ( ( tmp_listinfo->ed137_info != NULL ) && (rtp_info->info_ed137_info != NULL) &&
-                          ( 0!=strcmp(tmp_listinfo->ed137_info, rtp_info->info_ed137_info) )
-                        )
-                      ) {
-            /* if ed137_info has changed, create new stream */
-                tmp_listinfo->end_stream = true;
-            } else {
-                strinfo = (rtpstream_info_t*)(list->data);
-                break;
-            }
+    key = rtp_open_stream_key(rtp_info->info_setup_frame_num, rtp_info->info_sync_src);
+    if (tapinfo->rtpstream_open_hash) {
+        tmp_listinfo = (rtpstream_info_t *)g_hash_table_lookup(tapinfo->rtpstream_open_hash, &key);
+    }
+    if (tmp_listinfo) {
+        /* if the payload type has changed, we mark the stream as finished to create a new one
+           this is to show multiple payload changes in the Graph for example for DTMF RFC2833 */
+        if ( tmp_listinfo->first_payload_type != rtp_info->info_payload_type ) {
+            rtp_end_stream(tapinfo, tmp_listinfo);
+        } else if ( ( ( tmp_listinfo->ed137_info == NULL ) && (rtp_info->info_ed137_info != NULL) ) ||
+                    ( ( tmp_listinfo->ed137_info != NULL ) && (rtp_info->info_ed137_info == NULL) ) ||
+                    ( ( tmp_listinfo->ed137_info != NULL ) && (rtp_info->info_ed137_info != NULL) &&
+                      ( 0!=strcmp(tmp_listinfo->ed137_info, rtp_info->info_ed137_info) )
+                    )
+                  ) {
+        /* if ed137_info has changed, create new stream */
+            rtp_end_stream(tapinfo, tmp_listinfo);
+        } else {
+            strinfo = tmp_listinfo;
         }
-        list = g_list_next(list);
     }
 
     /* if this is a duplicated RTP Event End, just return */
@@ -695,6 +718,10 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
             strinfo->ed137_info = NULL;
         }
         tapinfo->rtpstream_list = g_list_prepend(tapinfo->rtpstream_list, strinfo);
+        if (!tapinfo->rtpstream_open_hash) {
+            tapinfo->rtpstream_open_hash = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+        }
+        g_hash_table_insert(tapinfo->rtpstream_open_hash, g_memdup2(&key, sizeof(key)), strinfo);
     }
 
     /* Add the info to the existing RTP stream */
@@ -706,7 +733,7 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
     if (tapinfo->rtp_evt_frame_num == pinfo->num) {
         strinfo->rtp_event = tapinfo->rtp_evt;
         if (tapinfo->rtp_evt_end == true) {
-            strinfo->end_stream = true;
+            rtp_end_stream(tapinfo, strinfo);
         }
     }
 
@@ -187,6 +187,7 @@ typedef struct _voip_calls_tapinfo {
     epan_t               *session; /**< epan session */
     int                   nrtpstreams; /**< number of rtp streams */
     GList*                rtpstream_list; /**< list of rtpstream_info_t */
+    GHashTable*           rtpstream_open_hash; /**< setup frame and SSRC -> rtpstream_info_t that is not ended yet */
     uint32_t              rtp_evt_frame_num;
     uint8_t               rtp_evt;
     bool                  rtp_evt_end;
@@ -93,8 +93,43 @@ typedef struct blf_log_container {
     uint16_t compression_method;      /* 0: uncompressed, 2: zlib */
 
     unsigned char  *real_data;        /* cache for decompressed data */
+    uint64_t last_used;               /* blf_t.cache_clock when real_data was last used */
+
+    uint32_t objects;                 /* objects starting in the container, seen by the first pass */
+    nstime_t first_ts;                /* time stamps of the first and the last of them */
+    nstime_t last_ts;
 } blf_log_container_t;
 
+/*
+ * Decompressed log containers are kept up to this many bytes in all,
+ * the least recently used ones being freed first; they're read from
+ * the file again if they're needed. Containers read from a pipe can't
+ * be read again, so those are all kept.
+ */
+#define BLF_CACHE_SIZE              (64 * 1024 * 1024)
+
+/*
+ * On the first pass, the log container after the one being read is read
+ * ahead, and inflated on a worker thread in the meantime.
+ */
+typedef enum {
+    BLF_AHEAD_NONE,                   /* nothing was read ahead */
+    BLF_AHEAD_FOUND,                  /* the last container was found, but its data wasn't read */
+    BLF_AHEAD_INFLATING,              /* the last container is being inflated by ahead_job */
+    BLF_AHEAD_PULL_FAILED,            /* reading the last container failed with ahead_err */
+    BLF_AHEAD_FIND_FAILED             /* looking for another container failed with ahead_err, 0 at EOF */
+} blf_ahead_t;
+
+typedef struct blf_inflate_job {
+    unsigned char *compressed_data;
+    unsigned int   compressed_length;
+    unsigned char *buf;
+    unsigned int   length;
+    int            err;
+    char          *err_info;
+    bool           done;
+} blf_inflate_job_t;
+
 typedef struct blf_data {
     int64_t     start_of_last_obj;
     int64_t     current_real_seek_pos;
@@ -103,6 +138,19 @@ typedef struct blf_data {
 
     GArray     *log_containers;
 
+    GArray     *cached_containers;    /* indices of the containers with real_data */
+    size_t      cached_bytes;
+    uint64_t    cache_clock;
+
+    blf_ahead_t ahead;
+    int         ahead_err;
+    char       *ahead_err_info;
+    blf_inflate_job_t *ahead_job;
+    GThreadPool *inflate_pool;        /* NULL if there's no point, or until the first pass needs it */
+    bool        inflate_pool_tried;
+    GMutex      inflate_mutex;
+    GCond       inflate_cond;
+
     GHashTable *channel_to_iface_ht;
     GHashTable *channel_to_name_ht;
     uint32_t    next_interface_id;
@@ -748,6 +796,60 @@ blf_init_logcontainer(blf_log_container_t *tmp) {
     tmp->real_length = 0;
     tmp->real_data = NULL;
     tmp->compression_method = 0;
+    tmp->last_used = 0;
+    tmp->objects = 0;
+    nstime_set_zero(&tmp->first_ts);
+    nstime_set_zero(&tmp->last_ts);
+}
+
+/* The number of containers at the start of the array that the first pass has pulled. */
+static unsigned
+blf_pulled_logcontainers(const blf_t *blf) {
+    switch (blf->ahead) {
+    case BLF_AHEAD_FOUND:
+    case BLF_AHEAD_INFLATING:
+    case BLF_AHEAD_PULL_FAILED:
+        return blf->log_containers->len - 1;
+    default:
+        return blf->log_containers->len;
+    }
+}
+
+/* Note that a container's data is in memory, freeing others' if that's too much. */
+static void
+blf_cache_logcontainer(blf_params_t *params, unsigned container_index) {
+    blf_t *blf = params->blf_data;
+    blf_log_container_t *container = &g_array_index(blf->log_containers, blf_log_container_t, container_index);
+
+    if (container->real_data == NULL) {
+        return;
+    }
+
+    container->last_used = ++blf->cache_clock;
+    g_array_append_val(blf->cached_containers, container_index);
+    blf->cached_bytes += (size_t)container->real_length;
+
+    while (!params->pipe && blf->cached_bytes > BLF_CACHE_SIZE && blf->cached_containers->len > 1) {
+        unsigned lru = 0;
+        uint64_t lru_used = UINT64_MAX;
+
+        for (unsigned i = 0; i < blf->cached_containers->len; i++) {
+            blf_log_container_t *cached = &g_array_index(blf->log_containers, blf_log_container_t,
+                g_array_index(blf->cached_containers, unsigned, i));
+
+            if (cached->last_used < lru_used) {
+                lru = i;
+                lru_used = cached->last_used;
+            }
+        }
+
+        blf_log_container_t *evicted = &g_array_index(blf->log_containers, blf_log_container_t,
+            g_array_index(blf->cached_containers, unsigned, lru));
+        blf->cached_bytes -= (size_t)evicted->real_length;
+        g_free(evicted->real_data);
+        evicted->real_data = NULL;
+        g_array_remove_index_fast(blf->cached_containers, lru);
+    }
 }
 
 int
@@ -778,6 +880,201 @@ blf_logcontainers_search(const void *a, const void *b) {
     }
 }
 
+#ifdef USE_ZLIB_OR_ZLIBNG
+static void
+blf_inflate_logcontainer(blf_inflate_job_t *job) {
+    zlib_stream infstream = {0};
+
+    infstream.avail_in  = job->compressed_length;
+    infstream.next_in   = job->compressed_data;
+    infstream.avail_out = job->length;
+    infstream.next_out  = job->buf;
+
+    /* the actual DE-compression work. */
+    if (Z_OK != ZLIB_PREFIX(inflateInit)(&infstream)) {
+        /*
+         * XXX - check the error code and handle this appropriately.
+         */
+        job->err = WTAP_ERR_INTERNAL;
+        if (infstream.msg != NULL) {
+            job->err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: inflateInit failed for LogContainer, message\"%s\"",
+                                          infstream.msg);
+        } else {
+            job->err_info = ws_strdup("blf_pull_logcontainer_into_memory: inflateInit failed for LogContainer");
+        }
+        ws_debug("inflateInit failed for LogContainer");
+        if (infstream.msg != NULL) {
+            ws_debug("inflateInit returned: \"%s\"", infstream.msg);
+        }
+        return;
+    }
+
+    int ret = ZLIB_PREFIX(inflate)(&infstream, Z_NO_FLUSH);
+    /* Z_OK should not happen here since we know how big the buffer should be */
+    if (Z_STREAM_END != ret) {
+        switch (ret) {
+
+        case Z_NEED_DICT:
+            job->err = WTAP_ERR_DECOMPRESS;
+            job->err_info = ws_strdup("preset dictionary needed");
+            break;
+
+        case Z_STREAM_ERROR:
+            job->err = WTAP_ERR_INTERNAL;
+            job->err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: Z_STREAM_ERROR from inflate(), message \"%s\"",
+                                         (infstream.msg != NULL) ? infstream.msg : "(none)");
+            break;
+
+        case Z_MEM_ERROR:
+            /* This means "not enough memory". */
+            job->err = ENOMEM;
+            job->err_info = NULL;
+            break;
+
+        case Z_DATA_ERROR:
+            /* This means "deflate stream invalid" */
+            job->err = WTAP_ERR_DECOMPRESS;
+            job->err_info = (infstream.msg != NULL) ? ws_strdup(infstream.msg) : NULL;
+            break;
+
+        case Z_BUF_ERROR:
+            /* XXX - this is recoverable; what should we do here? */
+            job->err = WTAP_ERR_INTERNAL;
+            job->err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: Z_BUF_ERROR from inflate(), message \"%s\"",
+                                         (infstream.msg != NULL) ? infstream.msg : "(none)");
+            break;
+
+        case Z_VERSION_ERROR:
+            job->err = WTAP_ERR_INTERNAL;
+            job->err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: Z_VERSION_ERROR from inflate(), message \"%s\"",
+                                         (infstream.msg != NULL) ? infstream.msg : "(none)");
+            break;
+
+        default:
+            job->err = WTAP_ERR_INTERNAL;
+            job->err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: unexpected error %d from inflate(), message \"%s\"",
+                                         ret,
+                                         (infstream.msg != NULL) ? infstream.msg : "(none)");
+            break;
+        }
+        ws_debug("inflate failed (return code %d) for LogContainer", ret);
+        if (infstream.msg != NULL) {
+            ws_debug("inflate returned: \"%s\"", infstream.msg);
+        }
+        /* Free up any dynamically-allocated memory in infstream */
+        ZLIB_PREFIX(inflateEnd)(&infstream);
+        return;
+    }
+
+    if (Z_OK != ZLIB_PREFIX(inflateEnd)(&infstream)) {
+        /*
+         * The zlib manual says this only returns Z_OK on success
+         * and Z_STREAM_ERROR if the stream state was inconsistent.
+         *
+         * It's not clear what useful information can be reported
+         * for Z_STREAM_ERROR; a look at the 1.2.11 source indicates
+         * that no string is returned to indicate what the problem
+         * was.
+         *
+         * It's also not clear what to do about infstream if this
+         * fails.
+         */
+        job->err = WTAP_ERR_INTERNAL;
+        job->err_info = ws_strdup("blf_pull_logcontainer_into_memory: inflateEnd failed for LogContainer");
+        ws_debug("inflateEnd failed for LogContainer");
+        if (infstream.msg != NULL) {
+            ws_debug("inflateEnd returned: \"%s\"", infstream.msg);
+        }
+        return;
+    }
+
+
+    g_free(job->compressed_data);
+    job->compressed_data = NULL;
+}
+
+static void
+blf_inflate_work(void *data, void *user_data) {
+    blf_inflate_job_t *job = (blf_inflate_job_t *)data;
+    blf_t *blf = (blf_t *)user_data;
+
+    blf_inflate_logcontainer(job);
+
+    g_mutex_lock(&blf->inflate_mutex);
+    job->done = true;
+    g_cond_broadcast(&blf->inflate_cond);
+    g_mutex_unlock(&blf->inflate_mutex);
+}
+
+static blf_inflate_job_t *
+blf_wait_inflate(blf_t *blf) {
+    blf_inflate_job_t *job = blf->ahead_job;
+
+    g_mutex_lock(&blf->inflate_mutex);
+    while (!job->done) {
+        g_cond_wait(&blf->inflate_cond, &blf->inflate_mutex);
+    }
+    g_mutex_unlock(&blf->inflate_mutex);
+
+    blf->ahead_job = NULL;
+    return job;
+}
+
+/* Frees the job, handing its data to the container if it was inflated. */
+static bool
+blf_finish_inflate(blf_log_container_t *container, blf_inflate_job_t *job, int *err, char **err_info) {
+    bool ok = job->err == 0;
+
+    if (ok) {
+        container->real_data = job->buf;
+    } else {
+        *err = job->err;
+        *err_info = job->err_info;
+        g_free(job->buf);
+    }
+    g_free(job->compressed_data);
+    g_free(job);
+    return ok;
+}
+#endif /* USE_ZLIB_OR_ZLIBNG */
+
+static void
+blf_free_inflate(blf_t *blf) {
+#ifdef USE_ZLIB_OR_ZLIBNG
+    if (blf->inflate_pool != NULL) {
+        /* Wait for the worker to finish with the job. */
+        g_thread_pool_free(blf->inflate_pool, false, true);
+        blf->inflate_pool = NULL;
+    }
+    if (blf->ahead_job != NULL) {
+        g_free(blf->ahead_job->compressed_data);
+        g_free(blf->ahead_job->buf);
+        g_free(blf->ahead_job->err_info);
+        g_free(blf->ahead_job);
+        blf->ahead_job = NULL;
+    }
+#endif /* USE_ZLIB_OR_ZLIBNG */
+    g_free(blf->ahead_err_info);
+    blf->ahead_err_info = NULL;
+}
+
+/* Start the inflate worker if it's worth having. */
+static bool
+blf_start_inflate_pool(blf_t *blf) {
+#ifdef USE_ZLIB_OR_ZLIBNG
+    if (!blf->inflate_pool_tried) {
+        blf->inflate_pool_tried = true;
+        if (g_get_num_processors() > 1) {
+            blf->inflate_pool = g_thread_pool_new(blf_inflate_work, blf, 1, false, NULL);
+        }
+    }
+    return blf->inflate_pool != NULL;
+#else
+    (void) blf;
+    return false;
+#endif /* USE_ZLIB_OR_ZLIBNG */
+}
+
 /** Ensures the given log container is in memory
  *
  * If the log container already is not already in memory,
@@ -785,9 +1082,12 @@ blf_logcontainers_search(const void *a, const void *b) {
  * properly sized buffer.
  * The file offset must be set to the start of the container
  * data (container->infile_data_start) before calling this function.
+ *
+ * If ahead is true, a zlib-compressed container is read and handed to
+ * the inflate worker as blf_t.ahead_job instead, without real_data.
  */
 static bool
-blf_pull_logcontainer_into_memory(blf_params_t *params, blf_log_container_t *container, int *err, char **err_info) {
+blf_pull_logcontainer_into_memory(blf_params_t *params, blf_log_container_t *container, bool ahead, int *err, char **err_info) {
 
     if (container == NULL) {
         *err = WTAP_ERR_INTERNAL;
@@ -910,122 +1210,26 @@ blf_pull_logcontainer_into_memory(blf_params_t *params, blf_log_container_t *con
             *err_info = ws_strdup("blf_pull_logcontainer_into_memory: cannot allocate memory");
             return false;
         }
-        zlib_stream infstream = {0};
 
-        infstream.avail_in  = (unsigned int)data_length;
-        infstream.next_in   = compressed_data;
-        infstream.avail_out = (unsigned int)container->real_length;
-        infstream.next_out  = buf;
+        blf_inflate_job_t *job = g_new0(blf_inflate_job_t, 1);
 
-        /* the actual DE-compression work. */
-        if (Z_OK != ZLIB_PREFIX(inflateInit)(&infstream)) {
-            /*
-             * XXX - check the error code and handle this appropriately.
-             */
-            g_free(buf);
-            g_free(compressed_data);
-            *err = WTAP_ERR_INTERNAL;
-            if (infstream.msg != NULL) {
-                *err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: inflateInit failed for LogContainer, message\"%s\"",
-                                              infstream.msg);
-            } else {
-                *err_info = ws_strdup("blf_pull_logcontainer_into_memory: inflateInit failed for LogContainer");
-            }
-            ws_debug("inflateInit failed for LogContainer");
-            if (infstream.msg != NULL) {
-                ws_debug("inflateInit returned: \"%s\"", infstream.msg);
-            }
-            return false;
-        }
-
-        int ret = ZLIB_PREFIX(inflate)(&infstream, Z_NO_FLUSH);
-        /* Z_OK should not happen here since we know how big the buffer should be */
-        if (Z_STREAM_END != ret) {
-            switch (ret) {
+        job->compressed_data = compressed_data;
+        job->compressed_length = (unsigned int)data_length;
+        job->buf = buf;
+        job->length = (unsigned int)container->real_length;
 
-            case Z_NEED_DICT:
-                *err = WTAP_ERR_DECOMPRESS;
-                *err_info = ws_strdup("preset dictionary needed");
-                break;
-
-            case Z_STREAM_ERROR:
-                *err = WTAP_ERR_INTERNAL;
-                *err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: Z_STREAM_ERROR from inflate(), message \"%s\"",
-                                             (infstream.msg != NULL) ? infstream.msg : "(none)");
-                break;
-
-            case Z_MEM_ERROR:
-                /* This means "not enough memory". */
-                *err = ENOMEM;
-                *err_info = NULL;
-                break;
-
-            case Z_DATA_ERROR:
-                /* This means "deflate stream invalid" */
-                *err = WTAP_ERR_DECOMPRESS;
-                *err_info = (infstream.msg != NULL) ? ws_strdup(infstream.msg) : NULL;
-                break;
-
-            case Z_BUF_ERROR:
-                /* XXX - this is recoverable; what should we do here? */
-                *err = WTAP_ERR_INTERNAL;
-                *err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: Z_BUF_ERROR from inflate(), message \"%s\"",
-                                             (infstream.msg != NULL) ? infstream.msg : "(none)");
-                break;
-
-            case Z_VERSION_ERROR:
-                *err = WTAP_ERR_INTERNAL;
-                *err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: Z_VERSION_ERROR from inflate(), message \"%s\"",
-                                             (infstream.msg != NULL) ? infstream.msg : "(none)");
-                break;
-
-            default:
-                *err = WTAP_ERR_INTERNAL;
-                *err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory: unexpected error %d from inflate(), message \"%s\"",
-                                             ret,
-                                             (infstream.msg != NULL) ? infstream.msg : "(none)");
-                break;
-            }
-            g_free(buf);
-            g_free(compressed_data);
-            ws_debug("inflate failed (return code %d) for LogContainer", ret);
-            if (infstream.msg != NULL) {
-                ws_debug("inflate returned: \"%s\"", infstream.msg);
-            }
-            /* Free up any dynamically-allocated memory in infstream */
-            ZLIB_PREFIX(inflateEnd)(&infstream);
-            return false;
-        }
-
-        if (Z_OK != ZLIB_PREFIX(inflateEnd)(&infstream)) {
-            /*
-             * The zlib manual says this only returns Z_OK on success
-             * and Z_STREAM_ERROR if the stream state was inconsistent.
-             *
-             * It's not clear what useful information can be reported
-             * for Z_STREAM_ERROR; a look at the 1.2.11 source indicates
-             * that no string is returned to indicate what the problem
-             * was.
-             *
-             * It's also not clear what to do about infstream if this
-             * fails.
-             */
-            *err = WTAP_ERR_INTERNAL;
-            *err_info = ws_strdup("blf_pull_logcontainer_into_memory: inflateEnd failed for LogContainer");
-            g_free(buf);
-            g_free(compressed_data);
-            ws_debug("inflateEnd failed for LogContainer");
-            if (infstream.msg != NULL) {
-                ws_debug("inflateEnd returned: \"%s\"", infstream.msg);
-            }
-            return false;
+        if (ahead) {
+            /* blf_pull_next_logcontainer() picks it up. */
+            params->blf_data->ahead_job = job;
+            g_thread_pool_push(params->blf_data->inflate_pool, job, NULL);
+            return true;
         }
 
-        g_free(compressed_data);
-        container->real_data = buf;
-        return true;
+        blf_inflate_logcontainer(job);
+        return blf_finish_inflate(container, job, err, err_info);
 #else /* USE_ZLIB_OR_ZLIBNG */
         (void) params;
+        (void) ahead;
         *err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
         *err_info = ws_strdup("blf_pull_logcontainer_into_memory: reading gzip-compressed containers isn't supported");
         return false;
@@ -1195,23 +1399,97 @@ blf_find_next_logcontainer(blf_params_t* params, int* err, char** err_info) {
     return true;
 }
 
+/* Find the container after the last one pulled, and start reading and inflating it. */
+static void
+blf_read_ahead(blf_params_t *params) {
+    blf_t *blf = params->blf_data;
+    blf_log_container_t *container;
+    int ahead_err = 0;
+    char *ahead_err_info = NULL;
+
+    if (params->random || !blf_start_inflate_pool(blf)) {
+        return;
+    }
+
+    if (!blf_find_next_logcontainer(params, &ahead_err, &ahead_err_info)) {
+        blf->ahead = BLF_AHEAD_FIND_FAILED;
+        blf->ahead_err = ahead_err;
+        blf->ahead_err_info = ahead_err_info;
+        return;
+    }
+
+    blf->ahead = BLF_AHEAD_FOUND;
+    container = &g_array_index(blf->log_containers, blf_log_container_t, blf->log_containers->len - 1);
+    if (container->real_data != NULL || container->real_length == 0 ||
+        container->compression_method != BLF_COMPRESSION_ZLIB) {
+        /* Nothing worth doing on the worker; it's pulled when it's needed. */
+        return;
+    }
+
+    if (!blf_pull_logcontainer_into_memory(params, container, true, &ahead_err, &ahead_err_info)) {
+        blf->ahead = BLF_AHEAD_PULL_FAILED;
+        blf->ahead_err = ahead_err;
+        blf->ahead_err_info = ahead_err_info;
+        return;
+    }
+    blf->ahead = BLF_AHEAD_INFLATING;
+}
+
 static bool
 // NOLINTNEXTLINE(misc-no-recursion)
 blf_pull_next_logcontainer(blf_params_t* params, int* err, char** err_info) {
+    blf_t *blf = params->blf_data;
     blf_log_container_t* container;
+    bool pulled;
 
-    if (!blf_find_next_logcontainer(params, err, err_info)) {
-        return false;
-    }
+    switch (blf->ahead) {
 
-    /* Is there a next log container to pull? */
-    if (params->blf_data->log_containers->len == 0) {
-        /* No. */
+    case BLF_AHEAD_NONE:
+        if (!blf_find_next_logcontainer(params, err, err_info)) {
+            return false;
+        }
+
+        /* Is there a next log container to pull? */
+        if (blf->log_containers->len == 0) {
+            /* No. */
+            return false;
+        }
+
+        container = &g_array_index(blf->log_containers, blf_log_container_t, blf->log_containers->len - 1);
+        pulled = blf_pull_logcontainer_into_memory(params, container, false, err, err_info);
+        break;
+
+    case BLF_AHEAD_FOUND:
+        container = &g_array_index(blf->log_containers, blf_log_container_t, blf->log_containers->len - 1);
+        pulled = blf_pull_logcontainer_into_memory(params, container, false, err, err_info);
+        break;
+
+#ifdef USE_ZLIB_OR_ZLIBNG
+    case BLF_AHEAD_INFLATING:
+        container = &g_array_index(blf->log_containers, blf_log_container_t, blf->log_containers->len - 1);
+        pulled = blf_finish_inflate(container, blf_wait_inflate(blf), err, err_info);
+        break;
+#endif /* USE_ZLIB_OR_ZLIBNG */
+
+    case BLF_AHEAD_PULL_FAILED:
+        container = &g_array_index(blf->log_containers, blf_log_container_t, blf->log_containers->len - 1);
+        *err = blf->ahead_err;
+        *err_info = blf->ahead_err_info;
+        blf->ahead_err_info = NULL;
+        pulled = false;
+        break;
+
+    default:
+        /* BLF_AHEAD_FIND_FAILED */
+        blf->ahead = BLF_AHEAD_NONE;
+        *err = blf->ahead_err;
+        *err_info = blf->ahead_err_info;
+        blf->ahead_err_info = NULL;
         return false;
     }
+    blf->ahead = BLF_AHEAD_NONE;
 
-    container = &g_array_index(params->blf_data->log_containers, blf_log_container_t, params->blf_data->log_containers->len - 1);
-    if (!blf_pull_logcontainer_into_memory(params, container, err, err_info)) {
+    if (!pulled) {
         if (*err == WTAP_ERR_DECOMPRESS || *err == WTAP_ERR_SHORT_READ) {
             report_warning("Error while decompressing BLF log container number %u (file pos. 0x%" PRIx64 "): %s",
                 params->blf_data->log_containers->len - 1, container->infile_start_pos, *err_info ? *err_info : "(none)");
@@ -1242,9 +1520,74 @@ blf_pull_next_logcontainer(blf_params_t* params, int* err, char** err_info) {
         return false;
     }
 
+    blf_cache_logcontainer(params, blf->log_containers->len - 1);
+    blf_read_ahead(params);
     return true;
 }
 
+/** Ensures the log container at container_index in the array is in memory
+ *
+ * Containers are read again if they were freed to stay within BLF_CACHE_SIZE.
+ */
+static bool
+blf_load_logcontainer(blf_params_t *params, unsigned container_index, int *err, char **err_info) {
+    blf_t *blf = params->blf_data;
+    blf_log_container_t *container = &g_array_index(blf->log_containers, blf_log_container_t, container_index);
+    int64_t pos = 0;
+
+    if (container->real_data != NULL || container->real_length == 0) {
+        container->last_used = ++blf->cache_clock;
+        return true;
+    }
+
+    if (!params->random) {
+        /* The first pass went past it: read it, then carry on from where we were. */
+        if (params->pipe) {
+            *err = WTAP_ERR_INTERNAL;
+            *err_info = ws_strdup("blf_load_logcontainer: log container of a pipe was freed");
+            return false;
+        }
+        pos = file_tell(params->fh);
+    }
+
+    if (file_seek(params->fh, container->infile_data_start, SEEK_SET, err) == -1) {
+        return false;
+    }
+    if (!blf_pull_logcontainer_into_memory(params, container, false, err, err_info)) {
+        return false;
+    }
+    if (!params->random && file_seek(params->fh, pos, SEEK_SET, err) == -1) {
+        return false;
+    }
+
+    blf_cache_logcontainer(params, container_index);
+    return true;
+}
+
+/* Index an object read by the first pass under the container it starts in. */
+static void
+blf_index_object(blf_t *blf, int64_t real_pos, const wtap_rec *rec) {
+    unsigned container_index = blf_pulled_logcontainers(blf);
+
+    if (real_pos < 0 || !(rec->presence_flags & WTAP_HAS_TS)) {
+        return;
+    }
+
+    while (container_index > 0) {
+        blf_log_container_t *container = &g_array_index(blf->log_containers, blf_log_container_t, --container_index);
+
+        if ((uint64_t)real_pos >= container->real_start_pos) {
+            if ((uint64_t)real_pos < container->real_start_pos + container->real_length) {
+                if (container->objects++ == 0) {
+                    container->first_ts = rec->ts;
+                }
+                container->last_ts = rec->ts;
+            }
+            return;
+        }
+    }
+}
+
 static bool
 blf_read_bytes_or_eof(blf_params_t *params, uint64_t real_pos, void *target_buffer, uint64_t count, int *err, char **err_info) {
     blf_log_container_t*    container;
@@ -1273,7 +1616,8 @@ blf_read_bytes_or_eof(blf_params_t *params, uint64_t real_pos, void *target_buff
          * Do a binary search for the container in which real_pos
          * is included.
          */
-        if (!g_array_binary_search(params->blf_data->log_containers, &real_pos, blf_logcontainers_search, &container_index)) {
+        if (!g_array_binary_search(params->blf_data->log_containers, &real_pos, blf_logcontainers_search, &container_index) ||
+            container_index >= blf_pulled_logcontainers(params->blf_data)) {
             /*
              * XXX - why is this treated as an EOF rather than an error?
              * *err appears to be 0, which means our caller treats it as an
@@ -1284,7 +1628,7 @@ blf_read_bytes_or_eof(blf_params_t *params, uint64_t real_pos, void *target_buff
         }
         container = &g_array_index(params->blf_data->log_containers, blf_log_container_t, container_index);
     } else {
-        if (params->blf_data->log_containers->len == 0) {
+        if (blf_pulled_logcontainers(params->blf_data) == 0) {
             /*
              * This is the first (linear) pass, and we haven't yet
              * added any containers.  Pull the next log container
@@ -1296,11 +1640,15 @@ blf_read_bytes_or_eof(blf_params_t *params, uint64_t real_pos, void *target_buff
         }
 
         /*
-         * Search backwards in the array, from the last entry to the
-         * first, to find the log container in which real_pos is
-         * included.
+         * Search backwards in the array, from the last entry pulled
+         * to the first, to find the log container in which real_pos
+         * is included.
          */
-        container_index = params->blf_data->log_containers->len;
+        container_index = blf_pulled_logcontainers(params->blf_data);
+        if (container_index == 0) {
+            ws_debug("cannot find real_pos in container");
+            return false;
+        }
         do {
             container = &g_array_index(params->blf_data->log_containers, blf_log_container_t, --container_index);
         } while (real_pos < container->real_start_pos && container_index > 0);  /* For some reason we skipped past the correct container */
@@ -1310,7 +1658,7 @@ blf_read_bytes_or_eof(blf_params_t *params, uint64_t real_pos, void *target_buff
 
         while (real_pos >= container->real_start_pos + container->real_length) {
             container_index++;
-            if (!params->random) {  /* First (linear) pass */
+            if (!params->random && container_index >= blf_pulled_logcontainers(params->blf_data)) {  /* First (linear) pass */
                 if (!blf_pull_next_logcontainer(params, err, err_info)) {
                     return false;
                 }
@@ -1333,13 +1681,8 @@ blf_read_bytes_or_eof(blf_params_t *params, uint64_t real_pos, void *target_buff
 
         start_in_buf = real_pos - container->real_start_pos;
 
-        if (params->random) {
-            if (file_seek(params->fh, container->infile_data_start, SEEK_SET, err) == -1) {
-                return false;
-            }
-            if (!blf_pull_logcontainer_into_memory(params, container, err, err_info)) {
-                return false;
-            }
+        if (!blf_load_logcontainer(params, container_index, err, err_info)) {
+            return false;
         }
 
         data_left = container->real_length - start_in_buf;
@@ -3811,6 +4154,7 @@ static bool blf_read(wtap *wth, wtap_rec *rec, int *err, char **err_info, int64_
         return false;
     }
     *data_offset = blf_tmp.blf_data->start_of_last_obj;
+    blf_index_object(blf_tmp.blf_data, *data_offset, rec);
 
     return true;
 }
@@ -3835,6 +4179,13 @@ static bool blf_seek_read(wtap *wth, int64_t seek_off, wtap_rec *rec, int *err,
 
 static void blf_free(blf_t *blf) {
     if (blf != NULL) {
+        blf_free_inflate(blf);
+        g_mutex_clear(&blf->inflate_mutex);
+        g_cond_clear(&blf->inflate_cond);
+        if (blf->cached_containers != NULL) {
+            g_array_free(blf->cached_containers, true);
+            blf->cached_containers = NULL;
+        }
         if (blf->log_containers != NULL) {
             for (unsigned i = 0; i < blf->log_containers->len; i++) {
                 blf_log_container_t* log_container = &g_array_index(blf->log_containers, blf_log_container_t, i);
@@ -3907,8 +4258,12 @@ blf_open(wtap *wth, int *err, char **err_info) {
     }
 
     /* Prepare our private context. */
-    blf = g_new(blf_t, 1);
+    blf = g_new0(blf_t, 1);
     blf->log_containers = g_array_new(false, false, sizeof(blf_log_container_t));
+    blf->cached_containers = g_array_new(false, false, sizeof(unsigned));
+    blf->ahead = BLF_AHEAD_NONE;
+    g_mutex_init(&blf->inflate_mutex);
+    g_cond_init(&blf->inflate_cond);
     blf->current_real_seek_pos = 0;
     blf->start_offset_ns = blf_data_to_ns(&header.start_date);
     blf->end_offset_ns = blf_data_to_ns(&header.end_date);
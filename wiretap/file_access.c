@@ -31,6 +31,7 @@
 #include "required_file_handlers.h"
 #include <wsutil/array.h>
 #include <wsutil/buffer.h>
+#include <wsutil/pint.h>
 #include <wsutil/str_util.h>
 
 #include "lanalyzer.h"
@@ -395,6 +396,67 @@ struct open_info *open_routines;
 /* this points to the first OPEN_INFO_HEURISTIC type in the array */
 static unsigned heuristic_open_routine_idx;
 
+/* the number of magic readers registered with first_routine at the top */
+static unsigned first_open_routines;
+
+/*
+ * Magic numbers that identify a magic-number file type from the first
+ * bytes of the file, so that its open routine can be tried before the
+ * others rather than after all the ones ahead of it in the array. Types
+ * whose magic number is written in the host byte order list it both ways
+ * round. The open routine still checks the header, so a file that just
+ * happens to start with one of these goes on to the usual search.
+ */
+typedef struct {
+	const uint8_t *magic;
+	unsigned magic_len;
+	wtap_open_routine_t open_routine;
+} open_magic_t;
+
+#define OPEN_MAGIC(s)	(const uint8_t *)(s), sizeof (s) - 1
+
+static const open_magic_t open_magic_base[] = {
+	{ OPEN_MAGIC("\xa1\xb2\xc3\xd4"),		libpcap_open },
+	{ OPEN_MAGIC("\xd4\xc3\xb2\xa1"),		libpcap_open },
+	{ OPEN_MAGIC("\xa1\xb2\x3c\x4d"),		libpcap_open },
+	{ OPEN_MAGIC("\x4d\x3c\xb2\xa1"),		libpcap_open },
+	{ OPEN_MAGIC("\xa1\xb2\xcd\x34"),		libpcap_open },
+	{ OPEN_MAGIC("\x34\xcd\xb2\xa1"),		libpcap_open },
+	{ OPEN_MAGIC("\x1c\x00\x01\xac"),		libpcap_open },
+	{ OPEN_MAGIC("\xac\x01\x00\x1c"),		libpcap_open },
+	{ OPEN_MAGIC("\x1c\x00\x01\xab"),		libpcap_open },
+	{ OPEN_MAGIC("\xab\x01\x00\x1c"),		libpcap_open },
+	{ OPEN_MAGIC("\x0a\x0d\x0d\x0a"),		pcapng_open },
+	{ OPEN_MAGIC("TRSNIFF data    \x1a"),	ngsniffer_open },
+	{ OPEN_MAGIC("snoop\0\0\0"),		snoop_open },
+	{ OPEN_MAGIC("iptrace 1.0"),		iptrace_open },
+	{ OPEN_MAGIC("iptrace 2.0"),		iptrace_open },
+	{ OPEN_MAGIC("RTSS"),			netmon_open },
+	{ OPEN_MAGIC("GMBU"),			netmon_open },
+	{ OPEN_MAGIC("VL\0\0"),			netxray_open },
+	{ OPEN_MAGIC("XCP\0"),			netxray_open },
+	{ OPEN_MAGIC("btsnoop\0"),		btsnoop_open },
+	{ OPEN_MAGIC("LOGG"),			blf_open },
+	{ OPEN_MAGIC("#!rtpplay1.0 "),		rtpdump_open },
+	{ OPEN_MAGIC("PML_"),			procmon_open },
+};
+
+/* Every magic number is at least this long, and the first 4 bytes key the table. */
+#define OPEN_MAGIC_MIN_LEN	4
+#define OPEN_MAGIC_MAX_LEN	17
+
+/* More than one magic number never matches the same file in practice. */
+#define OPEN_MAGIC_MAX_CANDIDATES	4
+
+/* the first 4 bytes -> GSList of open_magic_t, in table order */
+static GHashTable *open_magic_table;
+
+/* The cost of finding a file's type, for the debug log. */
+typedef struct {
+	unsigned probes;
+	int64_t usecs;
+} open_stats_t;
+
 static void
 set_heuristic_routine(void)
 {
@@ -435,6 +497,18 @@ init_open_routines(void)
 	}
 
 	set_heuristic_routine();
+
+	open_magic_table = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+	    NULL, (GDestroyNotify)g_slist_free);
+	for (i = 0; i < array_length(open_magic_base); i++) {
+		const open_magic_t *om = &open_magic_base[i];
+		void *key;
+
+		ws_assert(om->magic_len >= OPEN_MAGIC_MIN_LEN && om->magic_len <= OPEN_MAGIC_MAX_LEN);
+		key = GUINT_TO_POINTER(pntohu32(om->magic));
+		g_hash_table_insert(open_magic_table, key,
+		    g_slist_append((GSList *)g_hash_table_lookup(open_magic_table, key), (void *)om));
+	}
 }
 
 /*
@@ -479,6 +553,7 @@ wtap_register_open_info(struct open_info *oi, const bool first_routine)
 	   append it; if it's anything else, stick it in the middle */
 	if (first_routine && oi->type == OPEN_INFO_MAGIC) {
 		g_array_prepend_val(open_info_arr, *oi);
+		first_open_routines++;
 	} else if (!first_routine && oi->type == OPEN_INFO_HEURISTIC) {
 		g_array_append_val(open_info_arr, *oi);
 	} else {
@@ -508,6 +583,8 @@ wtap_deregister_open_info(const char *name)
 		if (open_routines[i].name && strcmp(open_routines[i].name, name) == 0) {
 			g_strfreev(open_routines[i].extensions_set);
 			open_info_arr = g_array_remove_index(open_info_arr, i);
+			if (i < first_open_routines)
+				first_open_routines--;
 			set_heuristic_routine();
 			return;
 		}
@@ -728,8 +805,12 @@ heuristic_uses_extension(unsigned int i, const char *extension)
  * occurred while reading the input.
  */
 static int
-try_one_open(wtap *wth, const struct open_info *candidate, int *err, char **err_info)
+try_one_open(wtap *wth, const struct open_info *candidate, open_stats_t *stats,
+    int *err, char **err_info)
 {
+	int64_t start, elapsed;
+	int result;
+
 	/* Seek back to the beginning of the file; the open routine for the
 	 * previous file type may have left the file position somewhere other
 	 * than the beginning, and the open routine for this file type will
@@ -748,35 +829,115 @@ try_one_open(wtap *wth, const struct open_info *candidate, int *err, char **err_
 	 */
 	wth->wslua_data = candidate->wslua_data;
 
-	return candidate->open_routine(wth, err, err_info);
+	if (!ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_DEBUG))
+		return candidate->open_routine(wth, err, err_info);
+
+	start = g_get_monotonic_time();
+	result = candidate->open_routine(wth, err, err_info);
+	elapsed = g_get_monotonic_time() - start;
+	stats->probes++;
+	stats->usecs += elapsed;
+	ws_debug("%s: %s in %" PRId64 " us", candidate->name,
+	    result == WTAP_OPEN_MINE ? "mine" :
+	    result == WTAP_OPEN_NOT_MINE ? "not mine" : "error", elapsed);
+	return result;
 }
 
 /*
- * Attempt to open the file corresponding to "wth".  If "type" is supplied
- * (i.e. other than WTAP_TYPE_AUTO), that will be the only type attempted.
- * Otherwise, heuristic detection of the file format will be performed,
- * possibly guided by the extension part of "filename".
+ * Look the first bytes of the file up in open_magic_table, and put the
+ * indices in open_routines of the magic-number types they identify in
+ * "candidates".
  *
- * Returns WTAP_OPEN_MINE upon success, WTAP_OPEN_NOT_MINE if it was not
- * possible to determine a suitable format for the file, or WTAP_OPEN_ERROR if
- * a failure occurred while reading the input.
+ * Returns the number of candidates; 0 if there are none, or if the bytes
+ * couldn't be read, in which case the open routines will find that out.
+ */
+static unsigned
+magic_open_candidates(wtap *wth, unsigned *candidates)
+{
+	uint8_t probe[OPEN_MAGIC_MAX_LEN];
+	int bytes_read, err;
+	unsigned ncandidates = 0;
+	GSList *entry;
+
+	if (open_magic_table == NULL || file_seek(wth->fh, 0, SEEK_SET, &err) == -1)
+		return 0;
+
+	bytes_read = file_read(probe, sizeof probe, wth->fh);
+	if (bytes_read < OPEN_MAGIC_MIN_LEN)
+		return 0;
+
+	entry = (GSList *)g_hash_table_lookup(open_magic_table,
+	    GUINT_TO_POINTER(pntohu32(probe)));
+	for (; entry != NULL && ncandidates < OPEN_MAGIC_MAX_CANDIDATES; entry = entry->next) {
+		const open_magic_t *om = (const open_magic_t *)entry->data;
+		unsigned i, c;
+
+		if ((unsigned)bytes_read < om->magic_len ||
+		    memcmp(probe, om->magic, om->magic_len) != 0)
+			continue;
+
+		/* The index can change as readers are registered. */
+		for (i = 0; i < heuristic_open_routine_idx; i++) {
+			if (open_routines[i].open_routine == om->open_routine)
+				break;
+		}
+		if (i == heuristic_open_routine_idx)
+			continue;
+		for (c = 0; c < ncandidates && candidates[c] != i; c++)
+			;
+		if (c == ncandidates)
+			candidates[ncandidates++] = i;
+	}
+
+	return ncandidates;
+}
+
+static bool
+is_magic_open_candidate(const unsigned *candidates, unsigned ncandidates, unsigned i)
+{
+	for (unsigned c = 0; c < ncandidates; c++) {
+		if (candidates[c] == i)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Detect the type of the file corresponding to "wth", guided by the magic
+ * number at its start and then by the extension part of its name.
  */
 static int
-try_open(wtap *wth, unsigned int type, int *err, char **err_info)
+try_open_auto(wtap *wth, open_stats_t *stats, int *err, char **err_info)
 {
 	int result = WTAP_OPEN_NOT_MINE;
-	unsigned i;
+	unsigned candidates[OPEN_MAGIC_MAX_CANDIDATES];
+	unsigned ncandidates, i;
 	char *extension;
 
-	/* 'type' is 1-based. */
-	if (type != WTAP_TYPE_AUTO && type <= open_info_arr->len) {
-		/* Try only the specified type. */
-		return try_one_open(wth, &open_routines[type - 1], err, err_info);
+	/*
+	 * First, the file types that the magic number at the start of the
+	 * file points to, after any readers registered to be tried first,
+	 * which still are.
+	 */
+	ncandidates = magic_open_candidates(wth, candidates);
+	if (ncandidates > 0) {
+		for (i = 0; i < first_open_routines && result == WTAP_OPEN_NOT_MINE; i++) {
+			if (!is_magic_open_candidate(candidates, ncandidates, i))
+				result = try_one_open(wth, &open_routines[i], stats, err, err_info);
+		}
+		for (i = 0; i < ncandidates && result == WTAP_OPEN_NOT_MINE; i++) {
+			result = try_one_open(wth, &open_routines[candidates[i]], stats, err, err_info);
+		}
+		if (result != WTAP_OPEN_NOT_MINE) {
+			return result;
+		}
 	}
 
-	/* First, all file types that support magic numbers. */
-	for (i = 0; i < heuristic_open_routine_idx && result == WTAP_OPEN_NOT_MINE; i++) {
-		result = try_one_open(wth, &open_routines[i], err, err_info);
+	/* Then the rest of the file types that support magic numbers. */
+	for (i = ncandidates > 0 ? first_open_routines : 0;
+	    i < heuristic_open_routine_idx && result == WTAP_OPEN_NOT_MINE; i++) {
+		if (!is_magic_open_candidate(candidates, ncandidates, i))
+			result = try_one_open(wth, &open_routines[i], stats, err, err_info);
 	}
 
 	if (result != WTAP_OPEN_NOT_MINE) {
@@ -818,7 +979,7 @@ try_open(wtap *wth, unsigned int type, int *err, char **err_info)
 				    || (pass == 1 && open_routines[i].extensions == NULL)
 				    || (pass == 2 && open_routines[i].extensions != NULL
 				                  && !heuristic_uses_extension(i, extension))) {
-					result = try_one_open(wth, &open_routines[i], err, err_info);
+					result = try_one_open(wth, &open_routines[i], stats, err, err_info);
 				}
 			}
 		}
@@ -827,13 +988,41 @@ try_open(wtap *wth, unsigned int type, int *err, char **err_info)
 	} else {
 		/* No extension.  Try all the heuristic types in order. */
 		for (i = heuristic_open_routine_idx; i < open_info_arr->len && result == WTAP_OPEN_NOT_MINE; i++) {
-			result = try_one_open(wth, &open_routines[i], err, err_info);
+			result = try_one_open(wth, &open_routines[i], stats, err, err_info);
 		}
 	}
 
 	return result;
 }
 
+/*
+ * Attempt to open the file corresponding to "wth".  If "type" is supplied
+ * (i.e. other than WTAP_TYPE_AUTO), that will be the only type attempted.
+ * Otherwise, heuristic detection of the file format will be performed,
+ * possibly guided by the extension part of "filename".
+ *
+ * Returns WTAP_OPEN_MINE upon success, WTAP_OPEN_NOT_MINE if it was not
+ * possible to determine a suitable format for the file, or WTAP_OPEN_ERROR if
+ * a failure occurred while reading the input.
+ */
+static int
+try_open(wtap *wth, unsigned int type, int *err, char **err_info)
+{
+	open_stats_t stats = { 0, 0 };
+	int result;
+
+	/* 'type' is 1-based. */
+	if (type != WTAP_TYPE_AUTO && type <= open_info_arr->len) {
+		/* Try only the specified type. */
+		return try_one_open(wth, &open_routines[type - 1], &stats, err, err_info);
+	}
+
+	result = try_open_auto(wth, &stats, err, err_info);
+	ws_debug("%s: %u open routines tried in %" PRId64 " us", wth->pathname,
+	    stats.probes, stats.usecs);
+	return result;
+}
+
 /* Opens a file and prepares a wtap struct.
  * If "do_random" is true, it opens the file twice; the second open
  * allows the application to do random-access I/O without moving
@@ -2559,6 +2748,51 @@ wtap_dump(wtap_dumper *wdh, const wtap_rec *rec, int *err, char **err_info)
 	return (wdh->subtype_write)(wdh, rec, err, err_info);
 }
 
+bool
+wtap_dump_can_copy_raw(const wtap_dumper *wdh, const wtap *wth)
+{
+	return wth->subtype_raw_record_len != NULL &&
+	    wth->random_fh != NULL &&
+	    wdh->file_type_subtype == wth->file_type_subtype &&
+	    wdh->file_encap == wth->file_encap;
+}
+
+/* Large enough that copies go at the speed of sequential I/O. */
+#define RAW_COPY_CHUNK_SIZE	(1024 * 1024)
+
+bool
+wtap_dump_copy_raw(wtap_dumper *wdh, wtap *wth, int64_t seek_off,
+    int64_t len, bool *write_failed, int *err, char **err_info)
+{
+	uint8_t *buf;
+	unsigned chunk;
+	bool ok = true;
+
+	*write_failed = false;
+	*err = 0;
+	*err_info = NULL;
+
+	if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
+		return false;
+
+	buf = (uint8_t *)g_malloc(len < RAW_COPY_CHUNK_SIZE ? (size_t)len : RAW_COPY_CHUNK_SIZE);
+	while (len > 0) {
+		chunk = len < RAW_COPY_CHUNK_SIZE ? (unsigned)len : RAW_COPY_CHUNK_SIZE;
+		if (!wtap_read_bytes(wth->random_fh, buf, chunk, err, err_info)) {
+			ok = false;
+			break;
+		}
+		if (!wtap_dump_file_write(wdh, buf, chunk, err)) {
+			*write_failed = true;
+			ok = false;
+			break;
+		}
+		len -= chunk;
+	}
+	g_free(buf);
+	return ok;
+}
+
 bool
 wtap_dump_flush(wtap_dumper *wdh, int *err)
 {
@@ -2571,6 +2805,14 @@ wtap_dump_flush(wtap_dumper *wdh, int *err)
 		}
 		break;
 #endif
+#ifdef HAVE_ZSTD
+	case WS_FILE_ZSTD_COMPRESSED:
+		if (zstdwfile_flush((ZSTDWFILE_T)wdh->fh) == -1) {
+			*err = zstdwfile_geterr((ZSTDWFILE_T)wdh->fh);
+			return false;
+		}
+		break;
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
 	case WS_FILE_LZ4_COMPRESSED:
 		if (lz4wfile_flush((LZ4WFILE_T)wdh->fh) == -1) {
@@ -2712,6 +2954,10 @@ wtap_dump_file_open(const wtap_dumper *wdh, const char *filename)
 	case WS_FILE_GZIP_COMPRESSED:
 		return gzwfile_open(filename);
 #endif /* defined (HAVE_ZLIB) || defined (HAVE_ZLIBNG) */
+#ifdef HAVE_ZSTD
+	case WS_FILE_ZSTD_COMPRESSED:
+		return zstdwfile_open(filename);
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
 	case WS_FILE_LZ4_COMPRESSED:
 		return lz4wfile_open(filename);
@@ -2730,6 +2976,10 @@ wtap_dump_file_fdopen(const wtap_dumper *wdh, int fd)
 	case WS_FILE_GZIP_COMPRESSED:
 		return gzwfile_fdopen(fd);
 #endif /* defined (HAVE_ZLIB) || defined (HAVE_ZLIBNG) */
+#ifdef HAVE_ZSTD
+	case WS_FILE_ZSTD_COMPRESSED:
+		return zstdwfile_fdopen(fd);
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
 	case WS_FILE_LZ4_COMPRESSED:
 		return lz4wfile_fdopen(fd);
@@ -2758,6 +3008,18 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 		}
 		break;
 #endif
+#ifdef HAVE_ZSTD
+	case WS_FILE_ZSTD_COMPRESSED:
+		nwritten = zstdwfile_write((ZSTDWFILE_T)wdh->fh, buf, bufsize);
+		/*
+		 * zstdwfile_write() returns 0 on error.
+		 */
+		if (nwritten == 0) {
+			*err = zstdwfile_geterr((ZSTDWFILE_T)wdh->fh);
+			return false;
+		}
+		break;
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
 	case WS_FILE_LZ4_COMPRESSED:
 		nwritten = lz4wfile_write((LZ4WFILE_T)wdh->fh, buf, bufsize);
@@ -2798,6 +3060,10 @@ wtap_dump_file_close(wtap_dumper *wdh)
 	case WS_FILE_GZIP_COMPRESSED:
 		return gzwfile_close((GZWFILE_T)wdh->fh);
 #endif
+#ifdef HAVE_ZSTD
+	case WS_FILE_ZSTD_COMPRESSED:
+		return zstdwfile_close((ZSTDWFILE_T)wdh->fh);
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
 	case WS_FILE_LZ4_COMPRESSED:
 		return lz4wfile_close((LZ4WFILE_T)wdh->fh);
@@ -2869,6 +3135,12 @@ cleanup_open_routines(void)
 		g_array_free(open_info_arr, true);
 		open_info_arr = NULL;
 	}
+
+	if (open_magic_table != NULL) {
+		g_hash_table_destroy(open_magic_table);
+		open_magic_table = NULL;
+	}
+	first_open_routines = 0;
 }
 
 /*
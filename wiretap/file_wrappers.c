@@ -27,6 +27,7 @@
 #include <wsutil/file_util.h>
 #include <wsutil/zlib_compat.h>
 #include <wsutil/file_compressed.h>
+#include <wsutil/pint.h>
 
 #ifdef HAVE_ZSTD
 #include <zstd.h>
@@ -129,6 +130,7 @@ struct wtap_reader {
 #endif /* USE_ZLIB_OR_ZLIBNG */
 #ifdef HAVE_ZSTD
     ZSTD_DCtx *zstd_dctx;
+    struct zstd_pool *zstd_pool; /* decompression ahead of the reader, or NULL */
 #endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
     LZ4F_dctx *lz4_dctx;
@@ -139,6 +141,17 @@ struct wtap_reader {
     /* fast seeking */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
+    bool random;                /* true if this is the random-access stream */
+
+    /*
+     * Memory mapping of an uncompressed regular file. While it's
+     * in use, out.buf points into the mapping rather than at
+     * out_alloc, the buffer we allocated.
+     */
+    GMappedFile *mapped;        /* the mapping, or NULL */
+    const uint8_t *map;         /* start of the mapped file */
+    int64_t map_len;            /* length of the mapping */
+    uint8_t *out_alloc;         /* our own output buffer */
 };
 
 /* Current read offset within a buffer. */
@@ -268,6 +281,12 @@ struct lz4_cur_seek_point {
     unsigned have;
 };
 
+#ifdef HAVE_ZSTD
+static void zstd_pool_start(FILE_T state);
+static void zstd_pool_stop(FILE_T state);
+static bool zstd_pool_fill_out_buffer(FILE_T state);
+#endif /* HAVE_ZSTD */
+
 #define SPAN INT64_C(1048576)
 static struct fast_seek_point *
 fast_seek_find(FILE_T file, int64_t pos)
@@ -385,9 +404,102 @@ fast_seek_reset(FILE_T state)
     }
 }
 
+#ifndef S_ISREG
+#define S_ISREG(mode)   (((mode) & S_IFMT) == S_IFREG)
+#endif
+
+/*
+ * Map an uncompressed regular file, so that reads are copies out of the
+ * page cache instead of a read() into our output buffer followed by a
+ * copy out of it.
+ *
+ * This is done only for files that are uncompressed from the start;
+ * for anything else, or if the mapping fails (e.g., a file too large
+ * for the address space), we just keep using reads.
+ */
+static void
+uncompressed_map_file(FILE_T state)
+{
+    ws_statb64 st;
+    GMappedFile *mapped;
+
+    if (state->mapped != NULL || state->pos != 0 || state->is_compressed)
+        return;
+    if (ws_fstat64(state->fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+        st.st_size <= state->raw_pos)
+        return;
+
+    mapped = g_mapped_file_new_from_fd(state->fd, false, NULL);
+    if (mapped == NULL)
+        return;
+    if ((int64_t)g_mapped_file_get_length(mapped) <= state->raw_pos) {
+        g_mapped_file_unref(mapped);
+        return;
+    }
+    state->mapped = mapped;
+    state->map = (const uint8_t *)g_mapped_file_get_contents(mapped);
+    state->map_len = (int64_t)g_mapped_file_get_length(mapped);
+}
+
+/* Point the output buffer back at our own buffer, if it's in the mapping. */
+static void
+out_buf_unmap(FILE_T state)
+{
+    if (state->out.buf != state->out_alloc) {
+        state->out.buf = state->out_alloc;
+        buf_reset(&state->out);
+    }
+}
+
+static void
+uncompressed_unmap_file(FILE_T state)
+{
+    if (state->mapped == NULL)
+        return;
+    if (state->out.buf != state->out_alloc) {
+        /* Discard what's left of the mapped window; it'll be read
+           again from the file. */
+        state->raw_pos -= state->out.avail;
+        out_buf_unmap(state);
+    }
+    g_mapped_file_unref(state->mapped);
+    state->mapped = NULL;
+    state->map = NULL;
+    state->map_len = 0;
+}
+
 static bool
 uncompressed_fill_out_buffer(FILE_T state)
 {
+    if (state->mapped != NULL) {
+        if (state->raw_pos < state->map_len) {
+            /*
+             * Hand out the rest of the mapping, or as much of it as
+             * fits in an unsigned, as the output buffer.
+             */
+            int64_t left = state->map_len - state->raw_pos;
+            unsigned n = left > MAX_READ_BUF_SIZE ? MAX_READ_BUF_SIZE : (unsigned)left;
+
+            state->out.buf = (uint8_t *)state->map + state->raw_pos;
+            state->out.next = state->out.buf;
+            state->out.avail = n;
+            state->raw_pos += n;
+            return true;
+        }
+
+        /*
+         * We're past the end of the mapping; the file might have grown
+         * since we mapped it (e.g., it's being written by a capture),
+         * so go back to reading it. We haven't been reading from the
+         * descriptor, so make sure it's where we think we are.
+         */
+        out_buf_unmap(state);
+        if (ws_lseek64(state->fd, state->raw_pos, SEEK_SET) == -1) {
+            state->err = errno;
+            state->err_info = NULL;
+            return false;
+        }
+    }
     if (buf_read(state, &state->out) < 0)
         return false;
     return true;
@@ -943,6 +1055,7 @@ check_for_zstd_compression(FILE_T state)
         fast_seek_header(state, state->raw_pos - state->in.avail, state->pos, ZSTD);
         state->compression = ZSTD;
         state->is_compressed = true;
+        zstd_pool_start(state);
         return 1;
 #else /* HAVE_ZSTD */
         state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
@@ -1266,7 +1379,60 @@ check_for_lz4_compression(FILE_T state)
 
 typedef int (*compression_type_test)(FILE_T);
 
+/*
+ * Skippable frames, as defined by both the Zstandard and LZ4 frame
+ * formats: a magic number from 0x184D2A50 to 0x184D2A5F, a 4-byte
+ * little-endian length, and that many bytes of user data. The zstd
+ * seekable format, for one, appends its seek table in one.
+ */
+#define SKIPPABLE_FRAME_HEADER_SIZE 8
+
+static bool
+is_skippable_frame_magic(const uint8_t *p)
+{
+    return (p[0] & 0xF0) == 0x50 && p[1] == 0x2A && p[2] == 0x4D && p[3] == 0x18;
+}
+
+static int
+check_for_skippable_frame(FILE_T state)
+{
+    uint64_t left;
+    unsigned n;
+
+    if (state->in.avail < SKIPPABLE_FRAME_HEADER_SIZE && !state->eof) {
+        if (fill_in_buffer(state) == -1)
+            return -1;
+    }
+    if (state->in.avail < SKIPPABLE_FRAME_HEADER_SIZE ||
+        !is_skippable_frame_magic(state->in.next))
+        return 0;
+
+    /* Skip the frame; it has no data for us. */
+    left = SKIPPABLE_FRAME_HEADER_SIZE + (uint64_t)pletohu32(state->in.next + 4);
+    while (left) {
+        if (state->in.avail == 0) {
+            if (fill_in_buffer(state) == -1)
+                return -1;
+            if (state->in.avail == 0) {
+                state->err = WTAP_ERR_SHORT_READ;
+                state->err_info = NULL;
+                return -1;
+            }
+        }
+        n = (uint64_t)state->in.avail > left ? (unsigned)left : state->in.avail;
+        state->in.next += n;
+        state->in.avail -= n;
+        left -= n;
+    }
+
+    /* Whatever follows is a new stream; look at it the next time
+       through. */
+    state->compression = UNKNOWN;
+    return 1;
+}
+
 static compression_type_test const compression_type_tests[] = {
+    check_for_skippable_frame,
     check_for_zlib_compression,
     check_for_zstd_compression,
     check_for_lz4_compression,
@@ -1353,6 +1519,16 @@ check_for_compression(FILE_T state)
        input to output -- this assumes that the output buffer is larger than
        the input buffer, which also assures space for gzungetc() */
     state->raw = state->pos;
+    uncompressed_map_file(state);
+    if (state->mapped != NULL) {
+        /* Everything in the input buffer is also in the mapping, so
+           discard it and start handing out the mapping from there. */
+        state->raw_pos -= state->in.avail;
+        buf_reset(&state->in);
+        buf_reset(&state->out);
+        state->compression = UNCOMPRESSED;
+        return 0;
+    }
     state->out.next = state->out.buf;
     /* not a compressed file -- copy everything we've read into the
        input buffer to the output buffer and fall to raw i/o */
@@ -1406,8 +1582,11 @@ fill_out_buffer(FILE_T state)
 
 #ifdef HAVE_ZSTD
     case ZSTD:
-        /* zstd decompress */
-        if (!zstd_fill_out_buffer(state))
+        /* zstd decompress, possibly on other threads */
+        if (state->zstd_pool != NULL) {
+            if (!zstd_pool_fill_out_buffer(state))
+                return -1;
+        } else if (!zstd_fill_out_buffer(state))
             return -1;
         break;
 #endif /* HAVE_ZSTD */
@@ -1465,6 +1644,10 @@ gz_skip(FILE_T state, int64_t len)
 static void
 gz_reset(FILE_T state)
 {
+#ifdef HAVE_ZSTD
+    zstd_pool_stop(state);        /* we're going somewhere else */
+#endif /* HAVE_ZSTD */
+    out_buf_unmap(state);         /* don't write into a mapping */
     buf_reset(&state->out);       /* no output data available */
     state->eof = false;           /* not at end of file */
     state->compression = UNKNOWN; /* look for compression header */
@@ -1606,6 +1789,7 @@ file_fdopen(int fd)
     state->in.next = state->in.buf;
     state->in.avail = 0;
     state->out.buf = (unsigned char *)g_try_malloc(want << 1);
+    state->out_alloc = state->out.buf;
     state->out.next = state->out.buf;
     state->out.avail = 0;
     state->size = want;
@@ -1714,10 +1898,414 @@ file_open(const char *path)
     return ft;
 }
 
+#ifdef HAVE_ZSTD
+/*
+ * The zstd seekable format:
+ *
+ * https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md
+ *
+ * The file is a sequence of independent zstd frames followed by a
+ * skippable frame holding a seek table: an entry of compressed and
+ * decompressed size (and, optionally, a checksum) per frame, and a
+ * footer with the number of frames, a descriptor and a magic number.
+ */
+#define ZSTD_SEEKABLE_MAGIC             0x8F92EAB1U
+#define ZSTD_SEEKABLE_SKIPPABLE_MAGIC   0x184D2A5EU
+#define ZSTD_SEEKABLE_FOOTER_SIZE       9
+#define ZSTD_SEEKABLE_CHECKSUM_FLAG     0x80
+#define ZSTD_SEEKABLE_RESERVED_BITS     0x7C
+#define ZSTD_SEEKABLE_MAX_FRAMES        0x8000000U
+
+static bool
+pread_fully(int fd, int64_t offset, void *buf, size_t len)
+{
+    size_t got = 0;
+    ssize_t ret;
+
+    if (ws_lseek64(fd, offset, SEEK_SET) == -1)
+        return false;
+    while (got < len) {
+        ret = ws_read(fd, (uint8_t *)buf + got, (unsigned)(len - got));
+        if (ret <= 0) {
+            if (ret == 0)
+                errno = 0;  /* short read, not an error */
+            return false;
+        }
+        got += (size_t)ret;
+    }
+    return true;
+}
+
+typedef struct {
+    int64_t in;                 /* offset of the frame in the file */
+    int64_t out;                /* offset of its data in the uncompressed data */
+    uint32_t compressed_size;
+    uint32_t decompressed_size;
+} zstd_frame_entry;
+
+/*
+ * If the file is in the zstd seekable format, read its seek table and
+ * return an array of zstd_frame_entry, one per frame; otherwise return
+ * NULL. The descriptor is left where it was.
+ */
+static GArray *
+zstd_seek_table_read(FILE_T state)
+{
+    ws_statb64 st;
+    int64_t saved_pos, file_size, table_start, in, out;
+    uint8_t footer[ZSTD_SEEKABLE_FOOTER_SIZE];
+    uint8_t header[SKIPPABLE_FRAME_HEADER_SIZE];
+    uint8_t *table = NULL;
+    uint32_t num_frames, entry_size;
+    uint64_t table_size;
+    GArray *frames = NULL;
+
+    if (ws_fstat64(state->fd, &st) < 0 || !S_ISREG(st.st_mode))
+        return NULL;
+    file_size = st.st_size;
+    if (file_size - state->start < ZSTD_SEEKABLE_FOOTER_SIZE + SKIPPABLE_FRAME_HEADER_SIZE)
+        return NULL;
+
+    saved_pos = ws_lseek64(state->fd, 0, SEEK_CUR);
+    if (saved_pos == -1)
+        return NULL;
+
+    if (!pread_fully(state->fd, file_size - ZSTD_SEEKABLE_FOOTER_SIZE, footer, sizeof footer))
+        goto done;
+    if (pletohu32(footer + 5) != ZSTD_SEEKABLE_MAGIC ||
+        (footer[4] & ZSTD_SEEKABLE_RESERVED_BITS) != 0)
+        goto done;
+    num_frames = pletohu32(footer);
+    if (num_frames == 0 || num_frames > ZSTD_SEEKABLE_MAX_FRAMES)
+        goto done;
+    entry_size = (footer[4] & ZSTD_SEEKABLE_CHECKSUM_FLAG) ? 12 : 8;
+    table_size = (uint64_t)num_frames * entry_size;
+
+    table_start = file_size - ZSTD_SEEKABLE_FOOTER_SIZE - (int64_t)table_size;
+    if (table_start - SKIPPABLE_FRAME_HEADER_SIZE < state->start)
+        goto done;
+    if (!pread_fully(state->fd, table_start - SKIPPABLE_FRAME_HEADER_SIZE, header, sizeof header))
+        goto done;
+    if (pletohu32(header) != ZSTD_SEEKABLE_SKIPPABLE_MAGIC ||
+        pletohu32(header + 4) != table_size + ZSTD_SEEKABLE_FOOTER_SIZE)
+        goto done;
+
+    table = (uint8_t *)g_try_malloc(table_size);
+    if (table == NULL || !pread_fully(state->fd, table_start, table, (size_t)table_size))
+        goto done;
+
+    frames = g_array_sized_new(false, false, sizeof(zstd_frame_entry), num_frames);
+    in = state->start;
+    out = 0;
+    for (uint32_t i = 0; i < num_frames; i++) {
+        const uint8_t *p = table + (size_t)i * entry_size;
+        zstd_frame_entry entry;
+
+        entry.in = in;
+        entry.out = out;
+        entry.compressed_size = pletohu32(p);
+        entry.decompressed_size = pletohu32(p + 4);
+        g_array_append_val(frames, entry);
+        in += entry.compressed_size;
+        out += entry.decompressed_size;
+    }
+
+    /* The frames must cover the file up to the seek table exactly. */
+    if (in != table_start - SKIPPABLE_FRAME_HEADER_SIZE) {
+        g_array_free(frames, true);
+        frames = NULL;
+    }
+
+done:
+    g_free(table);
+    (void)ws_lseek64(state->fd, saved_pos, SEEK_SET);
+    return frames;
+}
+
+/*
+ * If the file is in the zstd seekable format, turn its seek table into
+ * fast seek points, one at the start of each frame, so that random
+ * access never has to decompress more than one frame, even for parts
+ * of the file we haven't read sequentially yet.
+ */
+static void
+zstd_seek_table_load(FILE_T state)
+{
+    GArray *frames;
+
+    if (state->fast_seek == NULL || state->fast_seek->len != 0)
+        return;
+    frames = zstd_seek_table_read(state);
+    if (frames == NULL)
+        return;
+
+    for (unsigned i = 0; i < frames->len; i++) {
+        zstd_frame_entry *entry = &g_array_index(frames, zstd_frame_entry, i);
+
+        /* fast_seek_header() only adds points past the last one, so
+           of several frames starting at the same offset in the
+           decompressed data only the first gets a point. */
+        fast_seek_header(state, entry->in, entry->out, ZSTD);
+    }
+    ws_debug("Loaded %u fast seek points from a zstd seek table", state->fast_seek->len);
+    g_array_free(frames, true);
+}
+
+/*
+ * Parallel decompression of seekable-format zstd files.
+ *
+ * The frames of a seekable file are independent, and the seek table
+ * tells us where they all are, so when reading such a file sequentially
+ * we can decompress the frames ahead of the reader on worker threads.
+ * The reading thread still does all I/O on the descriptor; the workers
+ * only decompress. Decompressed frames are handed out in order, each
+ * frame's buffer being used as the output buffer while it's consumed.
+ */
+#define ZSTD_POOL_MAX_THREADS       8
+#define ZSTD_POOL_MAX_FRAME_SIZE    (64U << 20)
+
+typedef struct zstd_pool zstd_pool;
+
+typedef struct {
+    zstd_pool *pool;
+    uint8_t *src;
+    size_t src_len;
+    uint8_t *dst;
+    size_t dst_len;
+    int64_t end_in;             /* offset in the file just past the frame */
+    size_t result;              /* ZSTD_decompress() result */
+    bool done;
+} zstd_pool_job;
+
+struct zstd_pool {
+    GArray *frames;             /* zstd_frame_entry for each frame */
+    unsigned next_frame;        /* next frame to hand to a worker */
+    unsigned max_in_flight;
+    GQueue jobs;                /* jobs in frame order */
+    GThreadPool *threads;
+    GMutex mutex;
+    GCond cond;
+    uint8_t *cur;               /* frame buffer being used as out.buf */
+};
+
+static void
+zstd_pool_work(void *data, void *user_data _U_)
+{
+    zstd_pool_job *job = (zstd_pool_job *)data;
+    size_t ret;
+
+    ret = ZSTD_decompress(job->dst, job->dst_len, job->src, job->src_len);
+
+    g_mutex_lock(&job->pool->mutex);
+    job->result = ret;
+    job->done = true;
+    g_cond_broadcast(&job->pool->cond);
+    g_mutex_unlock(&job->pool->mutex);
+}
+
+static void
+zstd_pool_wait(zstd_pool *pool, zstd_pool_job *job)
+{
+    g_mutex_lock(&pool->mutex);
+    while (!job->done)
+        g_cond_wait(&pool->cond, &pool->mutex);
+    g_mutex_unlock(&pool->mutex);
+}
+
+static void
+zstd_pool_job_free(zstd_pool_job *job)
+{
+    g_free(job->src);
+    g_free(job->dst);
+    g_free(job);
+}
+
+/* Read frames and hand them to workers until enough are in flight. */
+static bool
+zstd_pool_submit(FILE_T state)
+{
+    zstd_pool *pool = state->zstd_pool;
+
+    while (g_queue_get_length(&pool->jobs) < pool->max_in_flight &&
+           pool->next_frame < pool->frames->len) {
+        zstd_frame_entry *entry = &g_array_index(pool->frames, zstd_frame_entry, pool->next_frame);
+        zstd_pool_job *job = g_new0(zstd_pool_job, 1);
+
+        job->pool = pool;
+        job->src_len = entry->compressed_size;
+        job->dst_len = entry->decompressed_size;
+        job->end_in = entry->in + entry->compressed_size;
+        job->src = (uint8_t *)g_try_malloc(job->src_len ? job->src_len : 1);
+        job->dst = (uint8_t *)g_try_malloc(job->dst_len ? job->dst_len : 1);
+        if (job->src == NULL || job->dst == NULL) {
+            zstd_pool_job_free(job);
+            state->err = ENOMEM;
+            state->err_info = NULL;
+            return false;
+        }
+        if (!pread_fully(state->fd, entry->in, job->src, job->src_len)) {
+            zstd_pool_job_free(job);
+            state->err = errno ? errno : WTAP_ERR_SHORT_READ;
+            state->err_info = NULL;
+            return false;
+        }
+        g_queue_push_tail(&pool->jobs, job);
+        g_thread_pool_push(pool->threads, job, NULL);
+        pool->next_frame++;
+    }
+    return true;
+}
+
+static void
+zstd_pool_stop(FILE_T state)
+{
+    zstd_pool *pool = state->zstd_pool;
+    zstd_pool_job *job;
+
+    if (pool == NULL)
+        return;
+
+    /* Wait for the workers to finish what they're doing. */
+    g_thread_pool_free(pool->threads, false, true);
+    while ((job = (zstd_pool_job *)g_queue_pop_head(&pool->jobs)) != NULL)
+        zstd_pool_job_free(job);
+
+    if (state->out.buf == pool->cur) {
+        state->out.buf = state->out_alloc;
+        buf_reset(&state->out);
+    }
+    g_free(pool->cur);
+    g_array_free(pool->frames, true);
+    g_mutex_clear(&pool->mutex);
+    g_cond_clear(&pool->cond);
+    g_free(pool);
+    state->zstd_pool = NULL;
+}
+
+/*
+ * Start decompressing ahead of the reader if this is a seekable zstd
+ * file being read sequentially from its first frame and there's more
+ * than one frame and more than one processor.
+ */
+static void
+zstd_pool_start(FILE_T state)
+{
+    GArray *frames;
+    zstd_pool *pool;
+    unsigned nthreads;
+
+    if (state->random || state->zstd_pool != NULL || state->pos != 0 ||
+        state->raw_pos - state->in.avail != state->start)
+        return;
+    nthreads = MIN((unsigned)g_get_num_processors(), ZSTD_POOL_MAX_THREADS);
+    if (nthreads < 2)
+        return;
+
+    frames = zstd_seek_table_read(state);
+    if (frames == NULL)
+        return;
+    for (unsigned i = 0; i < frames->len; i++) {
+        if (g_array_index(frames, zstd_frame_entry, i).decompressed_size > ZSTD_POOL_MAX_FRAME_SIZE) {
+            /* Too much memory to have several of these in flight. */
+            g_array_set_size(frames, 0);
+            break;
+        }
+    }
+    if (frames->len < 2) {
+        g_array_free(frames, true);
+        return;
+    }
+
+    pool = g_new0(zstd_pool, 1);
+    pool->frames = frames;
+    pool->max_in_flight = nthreads * 2;
+    g_queue_init(&pool->jobs);
+    g_mutex_init(&pool->mutex);
+    g_cond_init(&pool->cond);
+    pool->threads = g_thread_pool_new(zstd_pool_work, NULL, (int)nthreads, false, NULL);
+    if (pool->threads == NULL) {
+        g_array_free(frames, true);
+        g_mutex_clear(&pool->mutex);
+        g_cond_clear(&pool->cond);
+        g_free(pool);
+        return;
+    }
+    state->zstd_pool = pool;
+
+    /* We read the frames ourselves from here on. */
+    buf_reset(&state->in);
+    state->raw_pos = state->start;
+}
+
+static bool
+zstd_pool_fill_out_buffer(FILE_T state)
+{
+    zstd_pool *pool = state->zstd_pool;
+    zstd_pool_job *job;
+
+    ws_assert(state->out.avail == 0);
+
+    /* We're done with the previous frame. */
+    if (state->out.buf == pool->cur) {
+        state->out.buf = state->out_alloc;
+        buf_reset(&state->out);
+    }
+    g_free(pool->cur);
+    pool->cur = NULL;
+
+    if (!zstd_pool_submit(state))
+        return false;
+
+    job = (zstd_pool_job *)g_queue_pop_head(&pool->jobs);
+    if (job == NULL) {
+        /* That was the last frame. Continue with whatever follows
+           (the seek table, in a skippable frame) the usual way. */
+        zstd_frame_entry *last = &g_array_index(pool->frames, zstd_frame_entry, pool->frames->len - 1);
+        int64_t end_in = last->in + last->compressed_size;
+
+        zstd_pool_stop(state);
+        if (ws_lseek64(state->fd, end_in, SEEK_SET) == -1) {
+            state->err = errno;
+            state->err_info = NULL;
+            return false;
+        }
+        state->raw_pos = end_in;
+        buf_reset(&state->in);
+        state->last_compression = state->compression;
+        state->compression = UNKNOWN;
+        return true;
+    }
+
+    zstd_pool_wait(pool, job);
+    if (ZSTD_isError(job->result) || job->result != job->dst_len) {
+        state->err = WTAP_ERR_DECOMPRESS;
+        state->err_info = ZSTD_isError(job->result) ? ZSTD_getErrorName(job->result) :
+            "zstd frame size doesn't match the seek table";
+        zstd_pool_job_free(job);
+        return false;
+    }
+
+    pool->cur = job->dst;
+    state->out.buf = job->dst;
+    state->out.next = job->dst;
+    state->out.avail = (unsigned)job->dst_len;
+    state->raw_pos = job->end_in;
+    job->dst = NULL;
+    zstd_pool_job_free(job);
+
+    /* Keep the workers busy while this frame is consumed. */
+    return zstd_pool_submit(state);
+}
+#endif /* HAVE_ZSTD */
+
 void
-file_set_random_access(FILE_T stream, bool random_flag _U_, GPtrArray *seek)
+file_set_random_access(FILE_T stream, bool random_flag, GPtrArray *seek)
 {
     stream->fast_seek = seek;
+    stream->random = random_flag;
+#ifdef HAVE_ZSTD
+    zstd_seek_table_load(stream);
+#endif /* HAVE_ZSTD */
 }
 
 int64_t
@@ -1888,6 +2476,9 @@ file_seek(FILE_T file, int64_t offset, int whence, int *err)
             break;
         }
 
+#ifdef HAVE_ZSTD
+        zstd_pool_stop(file);
+#endif /* HAVE_ZSTD */
         if (ws_lseek64(file->fd, off, SEEK_SET) == -1) {
             *err = errno;
             return -1;
@@ -2015,9 +2606,12 @@ file_seek(FILE_T file, int64_t offset, int whence, int *err)
         && (file->fast_seek != NULL))
     {
         /*
-         * Yes.  Just seek there within the file.
+         * Yes.  Just seek there within the file.  (If the file is
+         * mapped, we're not reading from the descriptor, so it isn't
+         * where we are and there's nothing to seek.)
          */
-        if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
+        if (file->mapped == NULL &&
+            ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
             *err = errno;
             return -1;
         }
@@ -2093,6 +2687,10 @@ file_tell(FILE_T stream)
 int64_t
 file_tell_raw(FILE_T stream)
 {
+    /* If we're handing out the mapping, raw_pos is past all of it,
+       not just what's been consumed. */
+    if (stream->mapped != NULL && stream->out.buf != stream->out_alloc)
+        return stream->raw_pos - stream->out.avail;
     return stream->raw_pos;
 }
 
@@ -2396,6 +2994,9 @@ file_clearerr(FILE_T stream)
 void
 file_fdclose(FILE_T file)
 {
+    /* The mapping would keep the file open (and, on Windows, keep it
+       from being renamed or removed). */
+    uncompressed_unmap_file(file);
     if (file->fd != -1)
         ws_close(file->fd);
     file->fd = -1;
@@ -2418,6 +3019,10 @@ file_close(FILE_T file)
     int fd = file->fd;
 
     /* free memory and close file */
+#ifdef HAVE_ZSTD
+    zstd_pool_stop(file);
+#endif /* HAVE_ZSTD */
+    uncompressed_unmap_file(file);
     if (file->size) {
 #ifdef USE_ZLIB_OR_ZLIBNG
         ZLIB_PREFIX(inflateEnd)(&(file->strm));
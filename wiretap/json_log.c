@@ -29,7 +29,7 @@
 #include "file_wrappers.h"
 
 #include <wsutil/array.h>
-#include <wsutil/wsjson.h>
+#include <wsutil/ws_mempbrk.h>
 
 enum log_format_e {
     LOG_FORMAT_JSON_LINES,
@@ -49,10 +49,101 @@ static bool json_log_seek_read(wtap* wth, int64_t seek_off, wtap_rec* rec, int*
 
 // Maximum size of a log entry
 #define MAX_JSON_LOG_ENTRY_SIZE (100 * 1024)
-#define START_TOKENS 25
+// Entries are read this much at a time until their end is found.
+#define JSON_LOG_READ_CHUNK 4096
 
-jsmntok_t *tokens = NULL;
-unsigned num_tokens = 0;
+// Characters that matter outside and inside strings, so that the rest can
+// be skipped by ws_mempbrk_exec, which uses SIMD instructions if it can.
+static ws_mempbrk_pattern json_structural_pattern;
+static ws_mempbrk_pattern json_string_pattern;
+
+// State of a scan for the end of an object, which can be spread over
+// several buffers.
+typedef struct {
+    int depth;
+    bool in_string;
+    bool in_escape;
+} json_scan_t;
+
+// Returns the number of bytes up to and including the brace that closes
+// the object the scan started on, or 0 if it isn't in this buffer.
+static size_t json_object_scan(json_scan_t *scan, const char *buf, size_t len) {
+    const uint8_t *start = (const uint8_t *) buf;
+    const uint8_t *cur = start;
+    const uint8_t *end = start + len;
+    unsigned char found;
+
+    if (scan->in_escape && cur < end) {
+        scan->in_escape = false;
+        cur++;
+    }
+
+    while (cur < end) {
+        if (scan->in_string) {
+            cur = ws_mempbrk_exec(cur, end - cur, &json_string_pattern, &found);
+            if (!cur) {
+                break;
+            }
+            if (found == '\\') {
+                if (cur + 1 >= end) {
+                    scan->in_escape = true;
+                    break;
+                }
+                cur += 2;
+                continue;
+            }
+            scan->in_string = false;
+        } else {
+            cur = ws_mempbrk_exec(cur, end - cur, &json_structural_pattern, &found);
+            if (!cur) {
+                break;
+            }
+            if (found == '"') {
+                scan->in_string = true;
+            } else if (found == '{') {
+                scan->depth++;
+            } else {
+                scan->depth--;
+                if (scan->depth == 0) {
+                    return cur - start + 1;
+                }
+            }
+        }
+        cur++;
+    }
+
+    return 0;
+}
+
+ptrdiff_t skip_ws(const char *log_data, const char *log_end) {
+    const char *cur = log_data;
+    for (; cur < log_end; cur++) {
+        if (!g_ascii_isspace(*cur)) {
+            break;
+        }
+    }
+    return cur - log_data;
+}
+
+// Returns the end of the string whose opening quote is at str, or NULL.
+static const char *json_string_end(const char *str, const char *end) {
+    const uint8_t *cur = (const uint8_t *) str + 1;
+    const uint8_t *str_end = (const uint8_t *) end;
+    unsigned char found;
+
+    while (cur < str_end) {
+        cur = ws_mempbrk_exec(cur, str_end - cur, &json_string_pattern, &found);
+        if (!cur) {
+            break;
+        }
+        if (found == '"') {
+            return (const char *) cur;
+        }
+        cur += 2;
+    }
+
+    return NULL;
+}
 
 // XXX We should return the precision as well.
 static nstime_t get_entry_timestamp(const char *log_data, size_t entry_size) {
@@ -68,29 +159,36 @@ static nstime_t get_entry_timestamp(const char *log_data, size_t entry_size) {
         "timestamp",                // GCP audit, ns
     };
 
-    int parsed_cnt = json_parse_len(log_data, entry_size, tokens, num_tokens);
-    if (parsed_cnt == JSMN_ERROR_NOMEM) {
-        int needed = json_parse_len(log_data, entry_size, NULL, 0);
-        while ((int)num_tokens < needed) num_tokens *= 2;
-        tokens = g_realloc(tokens, sizeof(jsmntok_t) * num_tokens);
-        parsed_cnt = json_parse_len(log_data, entry_size, tokens, num_tokens);
-    }
+    // Walk the strings in order, looking for the first key with a string
+    // value, rather than tokenizing the whole entry.
+    const char *log_end = log_data + entry_size;
+    const char *cur = log_data;
+    while ((cur = memchr(cur, '"', log_end - cur)) != NULL) {
+        const char *key_start = cur + 1;
+        const char *key_end = json_string_end(cur, log_end);
+        if (!key_end) {
+            break;
+        }
+        cur = key_end + 1;
 
-    if (parsed_cnt < 3) {
-        return (nstime_t) NSTIME_INIT_ZERO;
-    }
+        const char *value = cur + skip_ws(cur, log_end);
+        if (value >= log_end || *value != ':') {
+            continue;
+        }
+        value++;
+        value += skip_ws(value, log_end);
+        if (value >= log_end || *value != '"') {
+            continue;
+        }
 
-    for (int idx = 0; idx < parsed_cnt - 1; idx++) {
-        if (tokens[idx].type == JSMN_STRING && tokens[idx+1].type == JSMN_STRING) {
-            for (size_t key = 0; key < array_length(timestamp_keys); key++) {
-                int key_len = (int) strlen(timestamp_keys[key]);
-                if (key_len == tokens[idx].end - tokens[idx].start && strncmp(log_data + tokens[idx].start, timestamp_keys[key], key_len) == 0) {
-                    nstime_t ts;
-                    if (iso8601_to_nstime(&ts, log_data + tokens[idx+1].start, ISO8601_DATETIME_AUTO)) {
-                        return ts;
-                    }
-                    return (nstime_t) NSTIME_INIT_ZERO;
+        for (size_t key = 0; key < array_length(timestamp_keys); key++) {
+            size_t key_len = strlen(timestamp_keys[key]);
+            if (key_len == (size_t) (key_end - key_start) && strncmp(key_start, timestamp_keys[key], key_len) == 0) {
+                nstime_t ts;
+                if (iso8601_to_nstime(&ts, value + 1, ISO8601_DATETIME_AUTO)) {
+                    return ts;
                 }
+                return (nstime_t) NSTIME_INIT_ZERO;
             }
         }
     }
@@ -98,16 +196,6 @@ static nstime_t get_entry_timestamp(const char *log_data, size_t entry_size) {
     return (nstime_t) NSTIME_INIT_ZERO;
 }
 
-ptrdiff_t skip_ws(const char *log_data, const char *log_end) {
-    const char *cur = log_data;
-    for (; cur < log_end; cur++) {
-        if (!g_ascii_isspace(*cur)) {
-            break;
-        }
-    }
-    return cur - log_data;
-}
-
 // {"Records":[
 ptrdiff_t skip_cloudtrail_header(const char *log_data, const char *log_end) {
     const char *cur = log_data;
@@ -142,35 +230,46 @@ ptrdiff_t skip_cloudtrail_header(const char *log_data, const char *log_end) {
     return 0;
 }
 
-// XXX Should this be in wsjson?
-size_t json_object_size(const char *log_data, const char *log_end) {
-    int depth = 0;
-    bool in_string = false;
-    bool in_escape = false;
-
-    for (const char *cur = log_data; cur < log_end; cur++) {
-        if (in_string) {
-            if (in_escape) {
-                in_escape = false;
-            } else if (*cur == '\\') {
-                in_escape = true;
-            } else if (*cur == '"') {
-                in_string = false;
+// Read the object at the current position into buf a chunk at a time,
+// stopping at the chunk that holds its end, and leave the file just past
+// it. Returns the size of the object, or 0 if there isn't one.
+static size_t json_log_read_object(FILE_T fh, Buffer *buf, int *err, char **err_info) {
+    json_scan_t scan = { 0, false, false };
+    size_t entry_size = 0;
+
+    while (entry_size < MAX_JSON_LOG_ENTRY_SIZE) {
+        unsigned chunk_size = (unsigned) MIN(JSON_LOG_READ_CHUNK, MAX_JSON_LOG_ENTRY_SIZE - entry_size);
+        ws_buffer_assure_space(buf, chunk_size);
+        char *chunk = (char *) ws_buffer_end_ptr(buf);
+
+        int bytes_read = file_read(chunk, chunk_size, fh);
+        if (bytes_read < 0) {
+            *err = file_error(fh, err_info);
+            return 0;
+        }
+        if (bytes_read == 0) {
+            if (entry_size > 0) {
+                *err = WTAP_ERR_SHORT_READ;
             }
-        } else {
-            if (*cur == '"') {
-                in_string = true;
-            } else if (*cur == '{') {
-                depth++;
-            } else if (*cur == '}') {
-                depth--;
-                if (depth == 0) {
-                    return cur - log_data + 1;
-                }
+            return 0;
+        }
+
+        size_t object_size = json_object_scan(&scan, chunk, bytes_read);
+        if (object_size > 0) {
+            ws_buffer_increase_length(buf, object_size);
+            // Hand back what we read past the end. It's still in the
+            // file's buffer, so this doesn't touch the disk.
+            if (file_seek(fh, (int64_t) object_size - bytes_read, SEEK_CUR, err) == -1) {
+                return 0;
             }
+            return entry_size + object_size;
         }
+        ws_buffer_increase_length(buf, bytes_read);
+        entry_size += bytes_read;
     }
 
+    *err = WTAP_ERR_BAD_FILE;
+    *err_info = ws_strdup_printf("JSON Log: entry is larger than %u bytes", MAX_JSON_LOG_ENTRY_SIZE);
     return 0;
 }
 
@@ -179,11 +278,6 @@ wtap_open_return_val json_log_open(wtap *wth, int *err, char **err_info _U_)
     char *log_buf = g_new(char, MAX_JSON_LOG_ENTRY_SIZE);
     char *log_data = log_buf;
 
-    if (!tokens) {
-        num_tokens = START_TOKENS;
-        tokens = g_malloc(sizeof(jsmntok_t) * num_tokens);
-    }
-
     int bytes_read = file_read(log_data, MAX_JSON_LOG_ENTRY_SIZE, wth->fh);
     if (bytes_read < 1) {
         g_free(log_buf);
@@ -196,7 +290,8 @@ wtap_open_return_val json_log_open(wtap *wth, int *err, char **err_info _U_)
 
     log_data += cloudtrail_header_len;
 
-    size_t entry_size = json_object_size(log_data, log_end);
+    json_scan_t scan = { 0, false, false };
+    size_t entry_size = json_object_scan(&scan, log_data, log_buf + bytes_read - log_data);
 
     nstime_t ts = get_entry_timestamp(log_data, entry_size);
 
@@ -247,21 +342,11 @@ static bool json_log_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec, int *err,
         }
     }
 
-    ws_buffer_assure_space(&rec->data, MAX_JSON_LOG_ENTRY_SIZE);
-    char *log_data = (char *) ws_buffer_start_ptr(&rec->data);
-
-    int64_t start_pos = file_tell(fh);
-    int bytes_read = file_read(log_data, MAX_JSON_LOG_ENTRY_SIZE, fh);
-    if (bytes_read < 1) {
-        if (!file_eof(fh)) {
-            *err = WTAP_ERR_SHORT_READ;
-        }
+    size_t entry_size = json_log_read_object(fh, &rec->data, err, err_info);
+    if (entry_size == 0) {
         return false;
     }
-    const char *log_end = log_data + bytes_read - 1;
-
-    size_t entry_size = json_object_size(log_data, log_end);
-    ws_buffer_increase_length(&rec->data, entry_size);
+    const char *log_data = (const char *) ws_buffer_start_ptr(&rec->data);
 
     nstime_t ts = get_entry_timestamp(log_data, entry_size);
     if (nstime_is_zero(&ts)) {
@@ -270,10 +355,6 @@ static bool json_log_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec, int *err,
         return false;
     }
 
-    if (file_seek(fh, start_pos + entry_size, SEEK_SET, err) == -1) {
-        return false;
-    }
-
     rec->presence_flags = WTAP_HAS_TS;
     rec->ts = ts;
     rec->tsprec = WTAP_TSPREC_NSEC;
@@ -337,6 +418,9 @@ void register_json_log(void)
 {
     json_log_file_type_subtype = wtap_register_file_type_subtype(&json_log_info);
 
+    ws_mempbrk_compile(&json_structural_pattern, "\"{}");
+    ws_mempbrk_compile(&json_string_pattern, "\"\\");
+
     /*
      * Register name for backwards compatibility with the
      * wtap_filetypes table in Lua.
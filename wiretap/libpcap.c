@@ -84,6 +84,8 @@ static bool libpcap_read_packet(wtap *wth, FILE_T fh,
     wtap_rec *rec, int *err, char **err_info);
 static bool libpcap_read_header(wtap *wth, FILE_T fh, int *err, char **err_info,
     struct pcaprec_ss990915_hdr *hdr);
+static bool libpcap_raw_record_len(wtap *wth, int64_t seek_off, unsigned *len,
+    int *err, char **err_info);
 static void libpcap_close(wtap *wth);
 
 static bool libpcap_dump_pcap(wtap_dumper *wdh, const wtap_rec *rec,
@@ -718,6 +720,15 @@ wtap_open_return_val libpcap_open(wtap *wth, int *err, char **err_info)
 		wtap_add_generated_idb(wth);
 	}
 
+	/*
+	 * Records of plain pcap files in our byte order, with the lengths
+	 * in the usual order, are written back exactly as they are read,
+	 * so they can be copied without reading them.
+	 */
+	if ((libpcap->variant == PCAP || libpcap->variant == PCAP_NSEC) &&
+	    !libpcap->byte_swapped && libpcap->lengths_swapped == NOT_SWAPPED)
+		wth->subtype_raw_record_len = libpcap_raw_record_len;
+
 	return WTAP_OPEN_MINE;
 }
 
@@ -1306,6 +1317,24 @@ libpcap_seek_read(wtap *wth, int64_t seek_off, wtap_rec *rec,
 	return true;
 }
 
+static bool
+libpcap_raw_record_len(wtap *wth, int64_t seek_off, unsigned *len,
+    int *err, char **err_info)
+{
+	struct pcaprec_ss990915_hdr hdr;
+
+	if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
+		return false;
+
+	if (!libpcap_read_header(wth, wth->random_fh, err, err_info, &hdr)) {
+		if (*err == 0)
+			*err = WTAP_ERR_SHORT_READ;
+		return false;
+	}
+	*len = (unsigned)sizeof (struct pcaprec_hdr) + hdr.hdr.incl_len;
+	return true;
+}
+
 static bool
 libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
     int *err, char **err_info)
@@ -1378,7 +1407,7 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	packet_size -= phdr_len;
 
 	wtap_setup_packet_rec(rec, wth->file_encap);
-	rec->block = wtap_block_create(WTAP_BLOCK_PACKET);
+	rec->block = wtap_rec_new_packet_block(rec);
 	rec->presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
 
 	/* Update the timestamp, if not already done */
@@ -1402,10 +1431,18 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	rec->rec_header.packet_header.len = orig_size;
 
 	/*
-	 * Read the packet data.
+	 * Read the packet data, or skip over it if the caller only wants
+	 * the record headers and post-processing doesn't need the data.
 	 */
-	if (!wtap_read_bytes_buffer(fh, &rec->data, packet_size, err, err_info))
-		return false;	/* failed */
+	if (fh == wth->fh && wth->skip_packet_data &&
+	    !pcap_read_post_process_uses_data(is_nokia, wth->file_encap,
+	      libpcap->byte_swapped)) {
+		if (!wtap_read_bytes(fh, NULL, packet_size, err, err_info))
+			return false;	/* failed */
+	} else {
+		if (!wtap_read_bytes_buffer(fh, &rec->data, packet_size, err, err_info))
+			return false;	/* failed */
+	}
 
 	pcap_read_post_process(is_nokia, wth->file_encap, rec,
 	    libpcap->byte_swapped, libpcap->fcs_len);
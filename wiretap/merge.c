@@ -303,21 +303,105 @@ merge_select_frame_type(const int file_type, int in_file_count, merge_in_file_t
 }
 
 /*
- * returns true if first argument is earlier than second
+ * The input files that have a record present, as a binary min-heap
+ * ordered by merge_rec_is_before(), so finding the earliest record is
+ * O(log n) in the number of input files rather than a scan of them all.
+ */
+typedef struct {
+    merge_in_file_t **files;
+    unsigned          count;
+    unsigned          next_unread;  /**< first in_files[] entry not yet read from */
+    merge_in_file_t  *last;         /**< file whose record was returned last */
+} merge_heap_t;
+
+/*
+ * Returns true if the record from l goes before the record from r.
+ * Records with no time stamp go before all others (yes, this means
+ * you won't get a chronological merge of those records, but you
+ * obviously *can't* get that), in file order. Records with the same
+ * time stamp go in reverse file order, which is what the linear
+ * search that this replaces did.
  */
 static bool
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_rec_is_before(const merge_in_file_t *l, const merge_in_file_t *r)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return false;
-    } else if (l->secs < r->secs) { /* left is earlier */
+    bool l_has_ts = (l->rec.presence_flags & WTAP_HAS_TS) != 0;
+    bool r_has_ts = (r->rec.presence_flags & WTAP_HAS_TS) != 0;
+
+    if (!l_has_ts || !r_has_ts) {
+        if (l_has_ts != r_has_ts)
+            return !l_has_ts;
+        return l < r;
+    }
+    if (l->rec.ts.secs != r->rec.ts.secs)
+        return l->rec.ts.secs < r->rec.ts.secs;
+    if (l->rec.ts.nsecs != r->rec.ts.nsecs)
+        return l->rec.ts.nsecs < r->rec.ts.nsecs;
+    return l > r;
+}
+
+static void
+merge_heap_push(merge_heap_t *heap, merge_in_file_t *in_file)
+{
+    unsigned i = heap->count++;
+
+    while (i > 0) {
+        unsigned parent = (i - 1) / 2;
+
+        if (!merge_rec_is_before(in_file, heap->files[parent]))
+            break;
+        heap->files[i] = heap->files[parent];
+        i = parent;
+    }
+    heap->files[i] = in_file;
+}
+
+static merge_in_file_t *
+merge_heap_pop(merge_heap_t *heap)
+{
+    merge_in_file_t *top = heap->files[0];
+    merge_in_file_t *moved = heap->files[--heap->count];
+    unsigned i = 0;
+
+    for (;;) {
+        unsigned child = 2 * i + 1;
+
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count &&
+            merge_rec_is_before(heap->files[child + 1], heap->files[child]))
+            child++;
+        if (!merge_rec_is_before(heap->files[child], moved))
+            break;
+        heap->files[i] = heap->files[child];
+        i = child;
+    }
+    if (heap->count > 0)
+        heap->files[i] = moved;
+
+    return top;
+}
+
+/*
+ * Read the next record from a file, and put the file in the heap if
+ * there is one. Returns false on a read error.
+ */
+static bool
+merge_heap_read(merge_heap_t *heap, merge_in_file_t *in_file,
+                int *err, char **err_info)
+{
+    int64_t data_offset;
+
+    if (!wtap_read(in_file->wth, &in_file->rec, err, err_info, &data_offset)) {
+        if (*err != 0) {
+            in_file->state = GOT_ERROR;
+            return false;
+        }
+        in_file->state = AT_EOF;
         return true;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
-        return false;
     }
-    /* either one < two or one == two
-     * either way, return one
-     */
+    in_file->state = RECORD_PRESENT;
+    merge_heap_push(heap, in_file);
     return true;
 }
 
@@ -333,6 +417,7 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * On an EOF (meaning all the files are at EOF), set *err to 0 and return
  * NULL.
  *
+ * @param heap the files with a record present
  * @param in_file_count number of entries in in_files
  * @param in_files input file array
  * @param err wiretap error, if failed
@@ -342,79 +427,50 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * all files
  */
 static merge_in_file_t *
-merge_read_packet(int in_file_count, merge_in_file_t in_files[],
+merge_read_packet(merge_heap_t *heap, unsigned in_file_count, merge_in_file_t in_files[],
                   int *err, char **err_info)
 {
-    int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
+    merge_in_file_t *in_file;
 
     /*
      * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
+     * EOF: that means reading the next record from the file whose
+     * record we returned last time, and, the first time through, one
+     * from every file.
      */
-    for (i = 0; i < in_file_count; i++) {
-        int64_t data_offset;
-
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec, err, err_info,
-                           &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
-            }
-        }
+    if (heap->last != NULL) {
+        in_file = heap->last;
+        heap->last = NULL;
+        if (!merge_heap_read(heap, in_file, err, err_info))
+            return in_file;
+    }
+    while (heap->next_unread < in_file_count) {
+        in_file = &in_files[heap->next_unread++];
+        if (!merge_heap_read(heap, in_file, err, err_info))
+            return in_file;
     }
 
-    if (ei == -1) {
+    if (heap->count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    in_file = merge_heap_pop(heap);
+
     /* We'll need to read another packet from this file. */
-    in_files[ei].state = RECORD_NOT_PRESENT;
+    in_file->state = RECORD_NOT_PRESENT;
+    heap->last = in_file;
 
     /* Count this packet. */
-    in_files[ei].packet_num++;
+    in_file->packet_num++;
 
     /*
      * Return a pointer to the merge_in_file_t of the file from which the
      * packet was read.
      */
     *err = 0;
-    return &in_files[ei];
+    return in_file;
 }
 
 /** Read the next packet, in file sequence order, from the set of files
@@ -1043,9 +1099,13 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
 {
     merge_result        status = MERGE_OK;
     merge_in_file_t    *in_file;
+    merge_heap_t        heap = { 0 };
     int                 count = 0;
     bool                stop_flag = false;
 
+    if (!do_append)
+        heap.files = g_new(merge_in_file_t *, in_file_count);
+
     for (;;) {
         *err = 0;
 
@@ -1054,7 +1114,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
+            in_file = merge_read_packet(&heap, in_file_count, in_files, err,
                                         err_info);
         }
 
@@ -1161,6 +1221,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         wtap_rec_reset(&in_file->rec);
     }
 
+    g_free(heap.files);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -1240,6 +1302,17 @@ tempfile_free(void *data) {
 }
 
 #define MAX_MERGE_FILES 10000 // Arbitrary
+
+/* The most input files to merge in one pass; 0 means as many as we can open. */
+static unsigned merge_max_open_files;
+
+void
+merge_set_max_open_files(unsigned max_open_files)
+{
+    ws_assert(max_open_files == 0 || max_open_files >= 2);
+    merge_max_open_files = max_open_files;
+}
+
 static bool
 // NOLINTNEXTLINE(misc-no-recursion)
 merge_files_common(const char* out_filename, /* filename in normal output mode,
@@ -1289,8 +1362,12 @@ merge_files_common(const char* out_filename, /* filename in normal output mode,
             return false;
         }
 
-        /* open the input files */
-        open_file_count = merge_open_in_files(in_file_count - total_file_count, &in_filenames[total_file_count], &in_files, cb, app_env_var_prefix, &err, &err_info, &err_fileno);
+        /* open the input files, up to the limit for one pass */
+        unsigned batch_file_count = in_file_count - total_file_count;
+        if (merge_max_open_files != 0 && batch_file_count > merge_max_open_files) {
+            batch_file_count = merge_max_open_files;
+        }
+        open_file_count = merge_open_in_files(batch_file_count, &in_filenames[total_file_count], &in_files, cb, app_env_var_prefix, &err, &err_info, &err_fileno);
         if (open_file_count == 0) {
             ws_debug("merge_open_in_files() failed with err=%d", err);
             report_cfile_open_failure(in_filenames[err_fileno], err, err_info);
@@ -117,6 +117,20 @@ typedef struct {
 } merge_progress_callback_t;
 
 
+/**
+ * @brief Limit the number of input files merged at once.
+ *
+ * If there are more input files than this, they are merged in batches
+ * of at most this many, in order, into temporary files that are then
+ * merged in turn, as is done when the open file limit is reached. This
+ * bounds the open files and the memory used for wiretap handles and
+ * interface maps when merging thousands of files.
+ *
+ * @param max_open_files The maximum, at least 2, or 0 for no limit
+ */
+WS_DLL_PUBLIC void
+merge_set_max_open_files(unsigned max_open_files);
+
 /**
  * @brief Merge the given input files to a file with the given filename
  *
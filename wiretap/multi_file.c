@@ -0,0 +1,439 @@
+/* multi_file.c
+ * Read a set of consecutive capture files as one capture
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * A ring buffer or other file set is a series of files written one after
+ * the other, so reading them in order gives the records in order; there's
+ * no need to merge them by time stamp as merge.c does, or to write them
+ * out to a temporary file first.
+ *
+ * The files are opened as members of a wrapper wtap whose read routines
+ * read from the member holding the current record. Each member's sections
+ * become sections of the wrapper, just as if the files had been
+ * concatenated, so the interface IDs in each member's records stay valid
+ * once their section number has been shifted by the number of sections
+ * in the earlier members. The member's IDBs, NRBs, DSBs and meta events
+ * are added to the wrapper's as they turn up.
+ *
+ * Record offsets carry the member number in their upper bits. Random
+ * access keeps at most MULTI_FILE_MAX_OPEN members open, reopening the
+ * others when a record in them is wanted; a day of one-minute files would
+ * otherwise need thousands of open descriptors.
+ */
+
+#include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_WIRETAP
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
+
+#include "wtap_module.h"
+#include "file_wrappers.h"
+
+#include <wsutil/file_util.h>
+#include <wsutil/ws_assert.h>
+
+/* Member number in the upper bits of a record offset, offset in the lower. */
+#define MULTI_FILE_OFFSET_BITS  40
+#define MULTI_FILE_OFFSET_MASK  ((INT64_C(1) << MULTI_FILE_OFFSET_BITS) - 1)
+#define MULTI_FILE_MAX_MEMBERS  (1U << (63 - MULTI_FILE_OFFSET_BITS))
+
+/* Members kept open for random access. */
+#define MULTI_FILE_MAX_OPEN     32
+
+typedef struct {
+    char     *filename;
+    wtap     *wth;              /* NULL if not open */
+    int64_t   size;             /* File size when first opened */
+    unsigned  section_base;     /* Wrapper section of the member's first section */
+    unsigned  iface_base;       /* Wrapper interface ID of the member's first interface */
+    unsigned  num_shbs;         /* Sections, IDBs etc. added to the wrapper so far */
+    unsigned  num_idbs;
+    unsigned  num_nrbs;
+    unsigned  num_dsbs;
+    unsigned  num_meta_events;
+    unsigned  last_used;        /* For choosing a member to close */
+} multi_file_member_t;
+
+typedef struct {
+    multi_file_member_t *members;
+    unsigned             num_members;
+    unsigned             current;       /* Member being read sequentially */
+    unsigned             num_open;
+    unsigned             use_count;
+    bool                 do_random;
+    unsigned int         type;
+    const char          *app_env_var_prefix;
+    int64_t              done_size;     /* Sizes of the members before current */
+} multi_file_t;
+
+/*
+ * Add anything the member has read since we last looked to the wrapper.
+ * Only the member being read sequentially can have anything new.
+ */
+static void
+multi_file_add_blocks(wtap *wth, GArray *blocks, GArray *member_blocks, unsigned *num_added,
+                      void (*process)(wtap *, wtap_block_t))
+{
+    if (member_blocks == NULL) {
+        return;
+    }
+    for (; *num_added < member_blocks->len; (*num_added)++) {
+        wtap_block_t block = wtap_block_ref(g_array_index(member_blocks, wtap_block_t, *num_added));
+
+        g_array_append_val(blocks, block);
+        if (process != NULL) {
+            process(wth, block);
+        }
+    }
+}
+
+static void
+multi_file_sync_member(wtap *wth, multi_file_member_t *member)
+{
+    wtap *mwth = member->wth;
+
+    /* Sections first, as their interface mapping refers to the IDBs. */
+    for (; member->num_shbs < mwth->shb_hdrs->len; member->num_shbs++) {
+        wtap_block_t shb = wtap_block_ref(g_array_index(mwth->shb_hdrs, wtap_block_t, member->num_shbs));
+        unsigned first_iface = member->iface_base +
+            g_array_index(mwth->shb_iface_to_global, unsigned, member->num_shbs);
+
+        g_array_append_val(wth->shb_hdrs, shb);
+        g_array_append_val(wth->shb_iface_to_global, first_iface);
+    }
+    multi_file_add_blocks(wth, wth->interface_data, mwth->interface_data, &member->num_idbs, NULL);
+    multi_file_add_blocks(wth, wth->nrbs, mwth->nrbs, &member->num_nrbs, wtapng_process_nrb);
+    multi_file_add_blocks(wth, wth->dsbs, mwth->dsbs, &member->num_dsbs, wtapng_process_dsb);
+    multi_file_add_blocks(wth, wth->meta_events, mwth->meta_events, &member->num_meta_events, NULL);
+}
+
+/*
+ * Ask the OS to start reading a file we'll soon want, so that switching
+ * to it doesn't wait for the disk.
+ */
+static void
+multi_file_prefetch(const multi_file_member_t *member _U_)
+{
+#ifdef HAVE_POSIX_FADVISE
+    int fd = ws_open(member->filename, O_RDONLY, 0);
+
+    if (fd >= 0) {
+        (void)posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        ws_close(fd);
+    }
+#endif
+}
+
+static void
+multi_file_close_member(multi_file_t *mf, multi_file_member_t *member)
+{
+    if (member->wth != NULL) {
+        wtap_close(member->wth);
+        member->wth = NULL;
+        mf->num_open--;
+    }
+}
+
+/* Start reading a member sequentially, adding its sections and so on. */
+static void
+multi_file_start_member(wtap *wth, multi_file_member_t *member)
+{
+    wtap *mwth = member->wth;
+    int64_t size = wtap_file_size(mwth, NULL);
+
+    member->size = size > 0 ? size : 0;
+    member->section_base = wth->shb_hdrs->len;
+    member->iface_base = wth->interface_data->len;
+    if (mwth->file_encap != wth->file_encap) {
+        wth->file_encap = WTAP_ENCAP_PER_PACKET;
+    }
+    if (mwth->file_tsprec != wth->file_tsprec) {
+        wth->file_tsprec = WTAP_TSPREC_PER_PACKET;
+    }
+    if (mwth->snapshot_length > wth->snapshot_length) {
+        wth->snapshot_length = mwth->snapshot_length;
+    }
+    multi_file_sync_member(wth, member);
+}
+
+/*
+ * Open a member. If we're reading it sequentially it's started; otherwise
+ * we've read it before, and only need its random access stream.
+ */
+static bool
+multi_file_open_member(wtap *wth, unsigned idx, bool sequential, int *err, char **err_info)
+{
+    multi_file_t *mf = (multi_file_t *)wth->priv;
+    multi_file_member_t *member = &mf->members[idx];
+    wtap *mwth;
+
+    if (member->wth != NULL) {
+        return true;
+    }
+
+    /* Make room, closing the member used longest ago. */
+    if (mf->num_open >= MULTI_FILE_MAX_OPEN) {
+        multi_file_member_t *lru = NULL;
+
+        for (unsigned i = 0; i < mf->num_members; i++) {
+            multi_file_member_t *m = &mf->members[i];
+
+            if (m->wth != NULL && i != mf->current &&
+                    (lru == NULL || m->last_used < lru->last_used)) {
+                lru = m;
+            }
+        }
+        if (lru != NULL) {
+            multi_file_close_member(mf, lru);
+        }
+    }
+
+    mwth = wtap_open_offline(member->filename, mf->type, err, err_info,
+                             mf->do_random, mf->app_env_var_prefix);
+    if (mwth == NULL) {
+        return false;
+    }
+    if (mwth->file_type_subtype != wth->file_type_subtype) {
+        wtap_close(mwth);
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("multi_file: %s isn't the same type of file as %s",
+                                     member->filename, mf->members[0].filename);
+        return false;
+    }
+    member->wth = mwth;
+    member->last_used = ++mf->use_count;
+    mf->num_open++;
+
+    if (sequential) {
+        multi_file_start_member(wth, member);
+    } else {
+        /* Only the random access side is needed. */
+        wtap_sequential_close(mwth);
+    }
+    return true;
+}
+
+/* Turn a member's record into one of ours. */
+static void
+multi_file_fix_rec(const multi_file_member_t *member, wtap_rec *rec)
+{
+    rec->section_number += member->section_base;
+    rec->presence_flags |= WTAP_HAS_SECTION_NUMBER;
+}
+
+static bool
+multi_file_read(wtap *wth, wtap_rec *rec, int *err, char **err_info, int64_t *data_offset)
+{
+    multi_file_t *mf = (multi_file_t *)wth->priv;
+    multi_file_member_t *member;
+    int64_t offset;
+
+    for (;;) {
+        member = &mf->members[mf->current];
+        member->wth->skip_packet_data = wth->skip_packet_data;
+        if (wtap_read(member->wth, rec, err, err_info, &offset)) {
+            break;
+        }
+        if (*err != 0 || mf->current + 1 >= mf->num_members) {
+            /* An error, or the end of the last member. */
+            return false;
+        }
+
+        /* On to the next member; we're done reading this one sequentially. */
+        wtap_sequential_close(member->wth);
+        wth->fh = NULL;
+        mf->done_size += member->size;
+        mf->current++;
+        if (!multi_file_open_member(wth, mf->current, true, err, err_info)) {
+            return false;
+        }
+        wth->fh = mf->members[mf->current].wth->fh;
+        if (mf->current + 1 < mf->num_members) {
+            multi_file_prefetch(&mf->members[mf->current + 1]);
+        }
+    }
+
+    multi_file_sync_member(wth, member);
+    multi_file_fix_rec(member, rec);
+    *data_offset = ((int64_t)mf->current << MULTI_FILE_OFFSET_BITS) | offset;
+    return true;
+}
+
+static bool
+multi_file_seek_read(wtap *wth, int64_t seek_off, wtap_rec *rec, int *err, char **err_info)
+{
+    multi_file_t *mf = (multi_file_t *)wth->priv;
+    unsigned idx = (unsigned)(seek_off >> MULTI_FILE_OFFSET_BITS);
+    multi_file_member_t *member;
+
+    if (idx >= mf->num_members) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("multi_file: offset %" PRId64 " is past the last file", seek_off);
+        return false;
+    }
+    member = &mf->members[idx];
+    if (!multi_file_open_member(wth, idx, false, err, err_info)) {
+        return false;
+    }
+    member->last_used = ++mf->use_count;
+
+    if (!wtap_seek_read(member->wth, seek_off & MULTI_FILE_OFFSET_MASK, rec, err, err_info)) {
+        return false;
+    }
+    multi_file_fix_rec(member, rec);
+    return true;
+}
+
+static int64_t
+multi_file_read_so_far(wtap *wth)
+{
+    multi_file_t *mf = (multi_file_t *)wth->priv;
+    wtap *mwth = mf->members[mf->current].wth;
+
+    if (mwth == NULL || mwth->fh == NULL) {
+        return mf->done_size;
+    }
+    return mf->done_size + file_tell_raw(mwth->fh);
+}
+
+static int64_t
+multi_file_size(wtap *wth, int *err)
+{
+    multi_file_t *mf = (multi_file_t *)wth->priv;
+    int64_t size = 0;
+
+    /* Members we haven't opened yet are sized from the file system. */
+    for (unsigned i = 0; i < mf->num_members; i++) {
+        ws_statb64 statb;
+
+        if (i <= mf->current) {
+            size += mf->members[i].size;
+        } else if (ws_stat64(mf->members[i].filename, &statb) == 0) {
+            size += statb.st_size;
+        } else {
+            if (err != NULL) {
+                *err = errno;
+            }
+            return -1;
+        }
+    }
+    return size;
+}
+
+static void
+multi_file_sequential_close(wtap *wth)
+{
+    multi_file_t *mf = (multi_file_t *)wth->priv;
+
+    /* wth->fh belongs to the current member. */
+    wth->fh = NULL;
+    for (unsigned i = 0; i < mf->num_members; i++) {
+        if (mf->members[i].wth != NULL) {
+            wtap_sequential_close(mf->members[i].wth);
+        }
+    }
+}
+
+static void
+multi_file_close(wtap *wth)
+{
+    multi_file_t *mf = (multi_file_t *)wth->priv;
+
+    for (unsigned i = 0; i < mf->num_members; i++) {
+        multi_file_close_member(mf, &mf->members[i]);
+        g_free(mf->members[i].filename);
+    }
+    g_free(mf->members);
+}
+
+wtap *
+wtap_open_offline_multi(const char *const *filenames, unsigned num_files, unsigned int type,
+                        int *err, char **err_info, bool do_random, const char *app_env_var_prefix)
+{
+    wtap *wth, *first;
+    multi_file_t *mf;
+
+    *err = 0;
+    *err_info = NULL;
+
+    if (num_files == 1) {
+        return wtap_open_offline(filenames[0], type, err, err_info, do_random, app_env_var_prefix);
+    }
+    if (num_files == 0 || num_files > MULTI_FILE_MAX_MEMBERS) {
+        *err = WTAP_ERR_CANT_OPEN;
+        return NULL;
+    }
+
+    wth = g_new0(wtap, 1);
+    mf = g_new0(multi_file_t, 1);
+    mf->members = g_new0(multi_file_member_t, num_files);
+    mf->num_members = num_files;
+    mf->do_random = do_random;
+    mf->type = type;
+    mf->app_env_var_prefix = app_env_var_prefix;
+    for (unsigned i = 0; i < num_files; i++) {
+        mf->members[i].filename = g_strdup(filenames[i]);
+    }
+
+    wth->priv = mf;
+    wth->pathname = g_strdup(filenames[0]);
+    wth->app_env_var_prefix = app_env_var_prefix;
+    wth->shb_hdrs = g_array_new(false, false, sizeof(wtap_block_t));
+    wth->shb_iface_to_global = g_array_new(false, false, sizeof(unsigned));
+    wth->interface_data = g_array_new(false, false, sizeof(wtap_block_t));
+    wth->nrbs = g_array_new(false, false, sizeof(wtap_block_t));
+    wth->dsbs = g_array_new(false, false, sizeof(wtap_block_t));
+    wth->meta_events = g_array_new(false, false, sizeof(wtap_block_t));
+    wth->subtype_read = multi_file_read;
+    wth->subtype_seek_read = do_random ? multi_file_seek_read : NULL;
+    wth->subtype_read_so_far = multi_file_read_so_far;
+    wth->subtype_file_size = multi_file_size;
+    wth->subtype_sequential_close = multi_file_sequential_close;
+    wth->subtype_close = multi_file_close;
+    nstime_set_unset(&wth->file_start_ts);
+    nstime_set_unset(&wth->file_end_ts);
+
+    /* The first member decides the file type, and the encapsulation and
+     * time stamp precision unless others differ. */
+    first = wtap_open_offline(filenames[0], type, err, err_info, do_random, app_env_var_prefix);
+    if (first == NULL) {
+        wtap_close(wth);
+        return NULL;
+    }
+    wth->file_type_subtype = first->file_type_subtype;
+    wth->file_encap = first->file_encap;
+    wth->file_tsprec = first->file_tsprec;
+    mf->members[0].wth = first;
+    mf->members[0].last_used = ++mf->use_count;
+    mf->num_open = 1;
+    multi_file_start_member(wth, &mf->members[0]);
+    wth->fh = first->fh;
+    multi_file_prefetch(&mf->members[1]);
+
+    return wth;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
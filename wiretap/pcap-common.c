@@ -2704,6 +2704,33 @@ pcap_read_post_process(bool is_nokia, int wtap_encap,
 	}
 }
 
+/*
+ * Returns true if pcap_read_post_process() looks at, or modifies, the
+ * packet data for this encapsulation, so that a reader can't skip
+ * over the data without changing the record it returns.
+ */
+bool
+pcap_read_post_process_uses_data(bool is_nokia _U_, int wtap_encap,
+    bool bytes_swapped)
+{
+	switch (wtap_encap) {
+
+	case WTAP_ENCAP_ATM_PDUS:
+	case WTAP_ENCAP_USB_LINUX_MMAPPED:
+		return true;
+
+	case WTAP_ENCAP_SLL:
+	case WTAP_ENCAP_SLL2:
+	case WTAP_ENCAP_USB_LINUX:
+	case WTAP_ENCAP_NFLOG:
+	case WTAP_ENCAP_PFLOG:
+		return bytes_swapped;
+
+	default:
+		return false;
+	}
+}
+
 bool
 wtap_encap_requires_phdr(int wtap_encap)
 {
@@ -941,7 +941,8 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                        pcapng_opt_byte_order_e byte_order,
                        int *err, char **err_info)
 {
-    uint8_t *option_content; /* Allocate as large as the options block */
+    uint8_t *option_content; /* As large as the options block */
+    uint8_t *option_alloc = NULL;
     unsigned opt_bytes_remaining;
     const uint8_t *option_ptr;
     const pcapng_option_header_t *oh;
@@ -954,24 +955,38 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
         return true;
     }
 
-    /* Allocate enough memory to hold all options */
-    option_content = (uint8_t *)g_try_malloc(opt_cont_buf_len);
-    if (option_content == NULL) {
-        *err = ENOMEM;  /* we assume we're out of memory */
-        return false;
+    /*
+     * Get enough memory to hold all options.  When reading a record,
+     * use the record's options buffer, so that we don't allocate and
+     * free a buffer for every block; none of the option handlers keep
+     * pointers into it.
+     */
+    if (wblock->rec != NULL) {
+        ws_buffer_clean(&wblock->rec->options_buf);
+        ws_buffer_assure_space(&wblock->rec->options_buf, opt_cont_buf_len);
+        option_content = ws_buffer_start_ptr(&wblock->rec->options_buf);
+    } else {
+        option_alloc = (uint8_t *)g_try_malloc(opt_cont_buf_len);
+        if (option_alloc == NULL) {
+            *err = ENOMEM;  /* we assume we're out of memory */
+            return false;
+        }
+        option_content = option_alloc;
     }
 
     /* Read all the options into the buffer */
     if (!wtap_read_bytes(fh, option_content, opt_cont_buf_len, err, err_info)) {
         ws_debug("failed to read options");
-        g_free(option_content);
+        g_free(option_alloc);
         return false;
     }
 
     /*
      * Now process them.
      * option_ptr starts out aligned on at least a 4-byte boundary, as
-     * that's what g_try_malloc() gives us, and each option is padded
+     * that's what g_try_malloc() gives us (and a Buffer, which gets its
+     * memory the same way, has nothing consumed from the start after
+     * ws_buffer_clean()), and each option is padded
      * to a length that's a multiple of 4 bytes, so it remains aligned.
      */
     option_ptr = &option_content[0];
@@ -983,7 +998,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
         if (sizeof (*oh) > opt_bytes_remaining) {
             *err = WTAP_ERR_BAD_FILE;
             *err_info = ws_strdup_printf("pcapng: Not enough data for option header");
-            g_free(option_content);
+            g_free(option_alloc);
             return false;
         }
         option_code = oh->option_code;
@@ -1012,7 +1027,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
             *err = WTAP_ERR_INTERNAL;
             *err_info = ws_strdup_printf("pcapng: invalid byte order %d passed to pcapng_process_options()",
                                         byte_order);
-            g_free(option_content);
+            g_free(option_alloc);
             return false;
         }
         option_ptr += sizeof (*oh); /* 4 bytes, so it remains aligned */
@@ -1026,7 +1041,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
             *err = WTAP_ERR_BAD_FILE;
             *err_info = ws_strdup_printf("pcapng: Not enough data to handle option of length %u",
                                         option_length);
-            g_free(option_content);
+            g_free(option_alloc);
             return false;
         }
 
@@ -1050,7 +1065,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                                                          option_ptr,
                                                          byte_order,
                                                          err, err_info)) {
-                    g_free(option_content);
+                    g_free(option_alloc);
                     return false;
                 }
                 break;
@@ -1062,7 +1077,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                                                   option_ptr,
                                                   byte_order,
                                                   err, err_info)) {
-                    g_free(option_content);
+                    g_free(option_alloc);
                     return false;
                 }
                 break;
@@ -1071,7 +1086,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                     !(*process_option)(wblock, section_info, option_code,
                                        option_length, option_ptr,
                                        err, err_info)) {
-                    g_free(option_content);
+                    g_free(option_alloc);
                     return false;
                 }
                 break;
@@ -1079,7 +1094,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
         option_ptr += rounded_option_length; /* multiple of 4 bytes, so it remains aligned */
         opt_bytes_remaining -= rounded_option_length;
     }
-    g_free(option_content);
+    g_free(option_alloc);
     return true;
 }
 
@@ -2023,7 +2038,7 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
 }
 
 static bool
-pcapng_read_packet_block(wtap *wth _U_, FILE_T fh, uint32_t block_type,
+pcapng_read_packet_block(wtap *wth, FILE_T fh, uint32_t block_type,
                          uint32_t block_content_length,
                          section_info_t *section_info,
                          wtapng_block_t *wblock,
@@ -2043,7 +2058,7 @@ pcapng_read_packet_block(wtap *wth _U_, FILE_T fh, uint32_t block_type,
     int fcslen;
     bool enhanced = (block_type == BLOCK_TYPE_EPB);
 
-    wblock->block = wtap_block_create(WTAP_BLOCK_PACKET);
+    wblock->block = wtap_rec_new_packet_block(wblock->rec);
 
     if (enhanced) {
         /*
@@ -2249,9 +2264,17 @@ pcapng_read_packet_block(wtap *wth _U_, FILE_T fh, uint32_t block_type,
     wblock->rec->ts.secs = (time_t)(wblock->rec->ts.secs + iface_info.tsoffset);
 
     /* "(Enhanced) Packet Block" read capture data */
-    if (!wtap_read_bytes_buffer(fh, &wblock->rec->data,
-                                packet.cap_len - pseudo_header_len, err, err_info))
-        return false;
+    if (fh == wth->fh && wth->skip_packet_data &&
+        !pcap_read_post_process_uses_data(false, iface_info.wtap_encap,
+                                          section_info->byte_swapped)) {
+        if (!wtap_read_bytes(fh, NULL, packet.cap_len - pseudo_header_len,
+                             err, err_info))
+            return false;
+    } else {
+        if (!wtap_read_bytes_buffer(fh, &wblock->rec->data,
+                                    packet.cap_len - pseudo_header_len, err, err_info))
+            return false;
+    }
     block_read += packet.cap_len - pseudo_header_len;
 
     /* jump over potential padding bytes at end of the packet data */
@@ -2312,7 +2335,7 @@ pcapng_read_packet_block(wtap *wth _U_, FILE_T fh, uint32_t block_type,
 
 
 static bool
-pcapng_read_simple_packet_block(wtap *wth _U_, FILE_T fh,
+pcapng_read_simple_packet_block(wtap *wth, FILE_T fh,
                                 uint32_t block_type _U_,
                                 uint32_t block_content_length,
                                 section_info_t *section_info,
@@ -2425,9 +2448,17 @@ pcapng_read_simple_packet_block(wtap *wth _U_, FILE_T fh,
     wblock->rec->rec_header.packet_header.len = simple_packet.packet_len - pseudo_header_len;
 
     /* "Simple Packet Block" read capture data */
-    if (!wtap_read_bytes_buffer(fh, &wblock->rec->data,
-                                simple_packet.cap_len - pseudo_header_len, err, err_info))
-        return false;
+    if (fh == wth->fh && wth->skip_packet_data &&
+        !pcap_read_post_process_uses_data(false, iface_info.wtap_encap,
+                                          section_info->byte_swapped)) {
+        if (!wtap_read_bytes(fh, NULL, simple_packet.cap_len - pseudo_header_len,
+                             err, err_info))
+            return false;
+    } else {
+        if (!wtap_read_bytes_buffer(fh, &wblock->rec->data,
+                                    simple_packet.cap_len - pseudo_header_len, err, err_info))
+            return false;
+    }
 
     /* jump over potential padding bytes at end of the packet data */
     if (padding != 0) {
@@ -24,6 +24,7 @@
 #include <wsutil/file_util.h>
 #include <wsutil/buffer.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/ws_trace.h>
 #include <wsutil/exported_pdu_tlvs.h>
 #include <wsutil/pint.h>
 #ifdef HAVE_PLUGINS
@@ -81,6 +82,9 @@ wtap_file_size(wtap *wth, int *err)
 {
 	ws_statb64 statb;
 
+	if (wth->subtype_file_size != NULL)
+		return wth->subtype_file_size(wth, err);
+
 	if (file_fstat((wth->fh == NULL) ? wth->random_fh : wth->fh,
 	    &statb, err) == -1)
 		return -1;
@@ -1743,6 +1747,12 @@ wtapng_process_dsb(wtap *wth, wtap_block_t dsb)
 		wth->add_new_secrets(dsb_mand->secrets_type, dsb_mand->secrets_data, dsb_mand->secrets_len);
 }
 
+void
+wtap_set_skip_packet_data(wtap *wth, bool skip)
+{
+	wth->skip_packet_data = skip;
+}
+
 /*
  * Reset a wtap_rec to an initialized state, making it ready for a
  * new record.
@@ -1851,6 +1861,8 @@ wtap_setup_custom_block_rec(wtap_rec *rec, uint32_t pen,
 bool
 wtap_read(wtap *wth, wtap_rec *rec, int *err, char **err_info, int64_t *offset)
 {
+	WS_TRACE0(read__start);
+
 	/*
 	 * Reset the record to default values.
 	 */
@@ -1877,6 +1889,7 @@ wtap_read(wtap *wth, wtap_rec *rec, int *err, char **err_info, int64_t *offset)
 			wtap_block_unref(rec->block);
 			rec->block = NULL;
 		}
+		WS_TRACE3(read__done, false, 0, 0);
 		return false;	/* failure */
 	}
 
@@ -1894,9 +1907,25 @@ wtap_read(wtap *wth, wtap_rec *rec, int *err, char **err_info, int64_t *offset)
 		ws_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_NONE);
 	}
 
+	WS_TRACE3(read__done, true, *offset, ws_buffer_length(&rec->data));
 	return true;	/* success */
 }
 
+unsigned
+wtap_read_batch(wtap *wth, wtap_rec *recs, int64_t *offsets,
+    unsigned max_recs, int *err, char **err_info)
+{
+	unsigned n;
+
+	*err = 0;
+	*err_info = NULL;
+	for (n = 0; n < max_recs; n++) {
+		if (!wtap_read(wth, &recs[n], err, err_info, &offsets[n]))
+			break;
+	}
+	return n;
+}
+
 /*
  * Read a given number of bytes from a file into a buffer or, if
  * buf is NULL, just discard them.
@@ -2028,6 +2057,8 @@ wtap_read_bytes_buffer(FILE_T fh, Buffer *buf, unsigned length, int *err,
 int64_t
 wtap_read_so_far(wtap *wth)
 {
+	if (wth->subtype_read_so_far != NULL)
+		return wth->subtype_read_so_far(wth);
 	return file_tell_raw(wth->fh);
 }
 
@@ -2038,10 +2069,6 @@ wtap_rec_init(wtap_rec *rec, size_t space)
 	memset(rec, 0, sizeof *rec);
 	ws_buffer_init(&rec->options_buf, 0);
 	ws_buffer_init(&rec->data, space);
-	/* In the future, see if we can create rec->block here once
-	 * and have it be reused like the rest of rec.
-	 * Currently it's recreated for each packet.
-	 */
 }
 
 /* Apply a snapshot value */
@@ -2074,7 +2101,16 @@ wtap_rec_apply_snapshot(wtap_rec *rec, uint32_t snaplen)
 void
 wtap_rec_reset(wtap_rec *rec)
 {
-	wtap_block_unref(rec->block);
+	/*
+	 * If nobody else kept a reference to the packet block, hang on
+	 * to it so that the next packet record can reuse it.
+	 */
+	if (rec->block != NULL && rec->spare_block == NULL &&
+	    wtap_block_get_type(rec->block) == WTAP_BLOCK_PACKET &&
+	    wtap_block_reuse(rec->block))
+		rec->spare_block = rec->block;
+	else
+		wtap_block_unref(rec->block);
 	rec->block = NULL;
 	rec->block_was_modified = false;
 }
@@ -2084,10 +2120,25 @@ void
 wtap_rec_cleanup(wtap_rec *rec)
 {
 	wtap_rec_reset(rec);
+	wtap_block_unref(rec->spare_block);
+	rec->spare_block = NULL;
 	ws_buffer_free(&rec->options_buf);
 	ws_buffer_free(&rec->data);
 }
 
+wtap_block_t
+wtap_rec_new_packet_block(wtap_rec *rec)
+{
+	wtap_block_t block;
+
+	if (rec->spare_block != NULL) {
+		block = rec->spare_block;
+		rec->spare_block = NULL;
+		return block;
+	}
+	return wtap_block_create(WTAP_BLOCK_PACKET);
+}
+
 wtap_block_t
 wtap_rec_generate_idb(const wtap_rec *rec)
 {
@@ -2106,6 +2157,8 @@ bool
 wtap_seek_read(wtap *wth, int64_t seek_off, wtap_rec *rec,
     int *err, char **err_info)
 {
+	WS_TRACE1(seek__read__start, seek_off);
+
 	/*
 	 * Reset the record to default values.
 	 */
@@ -2121,6 +2174,7 @@ wtap_seek_read(wtap *wth, int64_t seek_off, wtap_rec *rec,
 			wtap_block_unref(rec->block);
 			rec->block = NULL;
 		}
+		WS_TRACE3(seek__read__done, false, seek_off, 0);
 		return false;
 	}
 
@@ -2138,9 +2192,24 @@ wtap_seek_read(wtap *wth, int64_t seek_off, wtap_rec *rec,
 		ws_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_NONE);
 	}
 
+	WS_TRACE3(seek__read__done, true, seek_off, ws_buffer_length(&rec->data));
 	return true;
 }
 
+bool
+wtap_raw_record_len(wtap *wth, int64_t seek_off, unsigned *len,
+    int *err, char **err_info)
+{
+	*err = 0;
+	*err_info = NULL;
+	if (wth->subtype_raw_record_len == NULL) {
+		*err = WTAP_ERR_UNSUPPORTED;
+		*err_info = g_strdup("records in this file can't be copied as they are");
+		return false;
+	}
+	return wth->subtype_raw_record_len(wth, seek_off, len, err, err_info);
+}
+
 static bool
 wtap_full_file_read_file(wtap *wth, FILE_T fh, wtap_rec *rec,
     int *err, char **err_info)
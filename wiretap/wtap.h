@@ -1537,6 +1537,13 @@ typedef struct wtap_rec {
     wtap_block_t block;          /* block information */
     bool block_was_modified;     /* true if ANY aspect of the block has been modified */
 
+    /*
+     * A packet block from a previous record that nobody else holds
+     * a reference to, kept so that wtap_rec_new_packet_block() can
+     * reuse it rather than allocating a new one.
+     */
+    wtap_block_t spare_block;
+
     /*
      * We use a Buffer so that we don't have to allocate and free
      * a buffer for the options for each record.
@@ -2022,6 +2029,30 @@ WS_DLL_PUBLIC
 struct wtap* wtap_open_offline(const char *filename, unsigned int type, int *err,
     char **err_info, bool do_random, const char* app_env_var_prefix);
 
+/**
+ * @brief Open a set of consecutive capture files as one capture.
+ *
+ * The files, such as those of a ring buffer, are read one after the other
+ * without merging them, so they must be given in time order. They must
+ * all be of the same file type. Each file's sections become sections of
+ * the capture, and record offsets identify the file as well as the record.
+ * A single file is simply opened with wtap_open_offline().
+ *
+ * @param filenames Names of the files to open, in order
+ * @param num_files Number of files
+ * @param type WTAP_TYPE_AUTO for automatic recognize file format or explicit choose format type
+ * @param[out] err As for wtap_open_offline(); a later file that can't be
+ * opened or is of a different type is reported when reading reaches it.
+ * @param[out] err_info As for wtap_open_offline()
+ * @param do_random true if random access to the files will be done,
+ * false if not
+ * @param app_env_var_prefix The prefix for the application environment variable used to get the personal config directory.
+ */
+WS_DLL_PUBLIC
+struct wtap* wtap_open_offline_multi(const char *const *filenames, unsigned num_files,
+    unsigned int type, int *err, char **err_info, bool do_random,
+    const char* app_env_var_prefix);
+
 /**
  * @brief Clear EOF status for a wiretap file.
  *
@@ -2105,6 +2136,24 @@ typedef void (*wtap_new_secrets_callback_t)(uint32_t secrets_type, const void *s
 WS_DLL_PUBLIC
 void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secrets);
 
+/**
+ * @brief Allow sequential reads to skip over packet data.
+ *
+ * For callers that only look at record headers (time stamps, lengths,
+ * interface IDs, and the like). When set, file types that support it
+ * skip over the packet data of packet records returned by wtap_read()
+ * rather than copying it into the record's data buffer, which is left
+ * empty; the captured length is still reported. Other file types, and
+ * records whose header can't be filled in without the data, are read
+ * as usual. Random access reads with wtap_seek_read() always return
+ * the packet data.
+ *
+ * @param wth Wiretap file handle.
+ * @param skip true to skip packet data, false to read it.
+ */
+WS_DLL_PUBLIC
+void wtap_set_skip_packet_data(wtap *wth, bool skip);
+
 /**
  * @brief Read the next record in the file, filling in *phdr and *buf.
  *
@@ -2124,6 +2173,33 @@ WS_DLL_PUBLIC
 bool wtap_read(wtap *wth, wtap_rec *rec, int *err, char **err_info,
     int64_t *offset);
 
+/**
+ * @brief Read up to a given number of records from the file.
+ *
+ * Equivalent to calling wtap_read() for each element of recs in turn, but
+ * lets callers that process records in groups do so without a call per
+ * record. Each record must have been initialized with wtap_rec_init();
+ * as with wtap_read(), a record's previous contents (including its block)
+ * are released by wtap_rec_reset(), which the caller must do before reusing
+ * it, and its data buffer is reused, so an array of records that is kept
+ * across calls only grows its buffers once.
+ *
+ * @param wth a wtap * returned by a call that opened a file for reading.
+ * @param recs an array of at least max_recs records to fill in.
+ * @param offsets an array of at least max_recs offsets, set to the offset
+ * to pass to wtap_seek_read() to reread the corresponding record.
+ * @param max_recs the maximum number of records to read.
+ * @param err set to 0 if the batch was filled or the end of the file was
+ * reached, or to the error that stopped the read.
+ * @param err_info for some errors, a string giving more details of
+ * the error.
+ * @return the number of records read; if it's less than max_recs, the
+ * end of the file was reached or an error occurred, as indicated by *err.
+ */
+WS_DLL_PUBLIC
+unsigned wtap_read_batch(wtap *wth, wtap_rec *recs, int64_t *offsets,
+    unsigned max_recs, int *err, char **err_info);
+
 /**
  * @brief Read the record at a specified offset in a capture file, filling in
  * *phdr and *buf.
@@ -2186,6 +2262,19 @@ void wtap_rec_reset(wtap_rec *rec);
 WS_DLL_PUBLIC
 void wtap_rec_cleanup(wtap_rec *rec);
 
+/**
+ * @brief Get an empty packet block for a record.
+ *
+ * Returns the packet block kept by wtap_rec_reset(), if any, and
+ * otherwise creates a new one. Either way the caller owns the
+ * returned reference, typically by storing it in rec->block.
+ *
+ * @param rec Pointer to the wtap_rec structure.
+ * @return A packet block with no options.
+ */
+WS_DLL_PUBLIC
+wtap_block_t wtap_rec_new_packet_block(wtap_rec *rec);
+
 /**
  * @brief Return an error string for WTAP_ERR_UNWRITABLE_REC_TYPE.
  *
@@ -2784,6 +2873,57 @@ bool wtap_dump_add_idb(wtap_dumper *wdh, wtap_block_t idb, int *err,
      char **err_info);
 WS_DLL_PUBLIC
 bool wtap_dump(wtap_dumper *, const wtap_rec *, int *err, char **err_info);
+
+/**
+ * @brief Check whether records can be copied to a dump file as they are.
+ *
+ * True if copying the bytes of a record in the file being read with
+ * wtap_dump_copy_raw() writes the same thing as reading the record and
+ * writing it with wtap_dump() would, as long as it hasn't been changed.
+ * Records can then be copied without being read and parsed.
+ *
+ * @param wdh handle for the file we're writing.
+ * @param wth handle for the file we're reading.
+ * @return true if records can be copied.
+ */
+WS_DLL_PUBLIC
+bool wtap_dump_can_copy_raw(const wtap_dumper *wdh, const wtap *wth);
+
+/**
+ * @brief Get the number of bytes a record takes up in the file being read.
+ *
+ * Only available if wtap_dump_can_copy_raw() is true for the file.
+ *
+ * @param wth handle for the file we're reading.
+ * @param seek_off the offset of the record, as returned by wtap_read().
+ * @param[out] len set to the length of the record, including its header.
+ * @param[out] err set to an error code on failure.
+ * @param[out] err_info for some errors, a string giving more details.
+ * @return true on success, false on failure.
+ */
+WS_DLL_PUBLIC
+bool wtap_raw_record_len(wtap *wth, int64_t seek_off, unsigned *len,
+     int *err, char **err_info);
+
+/**
+ * @brief Copy bytes from the file being read to a dump file as they are.
+ *
+ * Used to write out a run of records for which wtap_dump_can_copy_raw()
+ * is true, from the offset of the first to the end of the last.
+ *
+ * @param wdh handle for the file we're writing.
+ * @param wth handle for the file we're reading.
+ * @param seek_off where to start copying.
+ * @param len how many bytes to copy.
+ * @param[out] write_failed set to true if writing failed, and to false
+ * if reading did.
+ * @param[out] err set to an error code on failure.
+ * @param[out] err_info for some errors, a string giving more details.
+ * @return true on success, false on failure.
+ */
+WS_DLL_PUBLIC
+bool wtap_dump_copy_raw(wtap_dumper *wdh, wtap *wth, int64_t seek_off,
+     int64_t len, bool *write_failed, int *err, char **err_info);
 WS_DLL_PUBLIC
 bool wtap_dump_flush(wtap_dumper *, int *);
 WS_DLL_PUBLIC
@@ -80,6 +80,9 @@ struct wtap {
     subtype_seek_read_func      subtype_seek_read;      /**< Function called for random access reads */
     void                        (*subtype_sequential_close)(struct wtap*); /**< Cleanup for sequential read state. */
     void                        (*subtype_close)(struct wtap*);            /**< Cleanup for general file state. */
+    int64_t                     (*subtype_read_so_far)(struct wtap*);      /**< Amount read sequentially, if not the position in fh. */
+    int64_t                     (*subtype_file_size)(struct wtap*, int*);  /**< Size of the capture, if not the size of fh's file. */
+    bool                        (*subtype_raw_record_len)(struct wtap*, int64_t, unsigned*, int*, char**); /**< Size in the file of the record at an offset, if records can be copied as they are to a file of the same type. */
     int                         file_encap;    /**< Per-file encapsulation type, for those
                                                 * file formats that have
                                                 * per-file encapsulation
@@ -112,6 +115,7 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;    /**< Callback for new IPv6 addresses. */
     wtap_new_secrets_callback_t add_new_secrets; /**< Callback for new secrets. */
     GPtrArray                   *fast_seek;      /**< Fast seek index. */
+    bool                        skip_packet_data; /**< true if sequential reads may skip packet data */
 };
 
 /**
@@ -434,6 +434,17 @@ void wtap_block_unref(wtap_block_t block)
     }
 }
 
+bool wtap_block_reuse(wtap_block_t block)
+{
+    if (block == NULL || block->mandatory_data != NULL ||
+        g_atomic_int_get(&block->ref_count) != 1) {
+        return false;
+    }
+
+    wtap_block_free_options(block);
+    return true;
+}
+
 void wtap_block_array_free(GArray* block_array)
 {
     unsigned block;
@@ -607,6 +607,21 @@ wtap_block_ref(wtap_block_t block);
 WS_DLL_PUBLIC void
 wtap_block_unref(wtap_block_t block);
 
+/**
+ * @brief Prepare a block to be reused for another record
+ *
+ * If the caller holds the only reference to the block, and the block
+ * has no mandatory data, remove all of its options, keeping the storage
+ * for them, so that the block can be filled in again rather than
+ * freed and recreated.
+ *
+ * @param[in] block Block to reuse
+ * @return true if the block can be reused, false if it is shared
+ * and must be unref'd instead
+ */
+WS_DLL_PUBLIC bool
+wtap_block_reuse(wtap_block_t block);
+
 /**
  * @brief Free an array of blocks
  *
@@ -0,0 +1,46 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CKSUM_INT_H__
+#define __CKSUM_INT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef HAVE_SSE4_2
+/**
+ * @brief Update a CRC-32C with the SSE4.2 crc32 instruction.
+ *
+ * Equivalent to crc32c_calculate_no_swap(). The caller must have checked
+ * ws_cpuid_sse42() first.
+ *
+ * @param buf  The data to add to the CRC.
+ * @param len  The length of the data in bytes.
+ * @param crc  The CRC so far, or CRC32C_PRELOAD.
+ * @return     The updated CRC.
+ */
+uint32_t crc32c_sse42_no_swap(const uint8_t *buf, size_t len, uint32_t crc);
+#endif
+
+#ifdef HAVE_AVX2
+/**
+ * @brief Add up 32-byte blocks of a buffer as 32-bit words using AVX2.
+ *
+ * Only the first (len & ~31) bytes are summed. The caller must have
+ * checked ws_cpuid_avx2() first.
+ *
+ * @param buf  The data to add up, with no alignment requirement.
+ * @param len  The length of the data in bytes.
+ * @return     The sum of the host byte order 32-bit words, without any
+ *             carries folded back in.
+ */
+uint64_t ws_cksum_avx2_sum(const uint8_t *buf, size_t len);
+#endif
+
+#endif /* __CKSUM_INT_H__ */
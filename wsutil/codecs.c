@@ -20,6 +20,8 @@
 #ifdef HAVE_PLUGINS
 static plugins_t *libwscodecs_plugins;
 #endif
+static int codecs_registered;
+static GMutex codecs_register_mutex;
 
 static GSList *codecs_plugins;
 
@@ -49,15 +51,29 @@ call_plugin_register_codec_module(void * data, void * user_data _U_)
 
 
 /*
- * For all codec plugins, call their register routines.
+ * Codecs are only needed to play or save RTP audio, so the codec plugins
+ * aren't opened until a codec is first looked up.
  */
 void
 codecs_init(const char* app_env_var_prefix _U_)
 {
 #ifdef HAVE_PLUGINS
-    libwscodecs_plugins = plugins_init(WS_PLUGIN_CODEC, app_env_var_prefix);
+    libwscodecs_plugins = plugins_init_on_demand(WS_PLUGIN_CODEC, app_env_var_prefix);
+#endif
+    g_atomic_int_set(&codecs_registered, false);
+}
+
+/*
+ * For all codec plugins, call their register routines.
+ */
+static void
+codecs_register(void)
+{
+#ifdef HAVE_PLUGINS
+    plugins_load(libwscodecs_plugins);
 #endif
     g_slist_foreach(codecs_plugins, call_plugin_register_codec_module, NULL);
+    g_atomic_int_set(&codecs_registered, true);
 }
 
 void
@@ -65,6 +81,7 @@ codecs_cleanup(void)
 {
     g_slist_free(codecs_plugins);
     codecs_plugins = NULL;
+    g_atomic_int_set(&codecs_registered, false);
 #ifdef HAVE_PLUGINS
     plugins_cleanup(libwscodecs_plugins);
     libwscodecs_plugins = NULL;
@@ -92,7 +109,17 @@ codec_handle_t
 find_codec(const char *name)
 {
     codec_handle_t ret;
-    char *key = g_ascii_strup(name, -1);
+    char *key;
+
+    /* Streams can be decoded on several threads at once. */
+    if (G_UNLIKELY(!g_atomic_int_get(&codecs_registered))) {
+        g_mutex_lock(&codecs_register_mutex);
+        if (!g_atomic_int_get(&codecs_registered))
+            codecs_register();
+        g_mutex_unlock(&codecs_register_mutex);
+    }
+
+    key = g_ascii_strup(name, -1);
 
     ret = (registered_codecs) ? (codec_handle_t)g_hash_table_lookup(registered_codecs, key) : NULL;
     g_free(key);
@@ -180,6 +207,23 @@ size_t codec_decode(codec_handle_t codec, codec_context_t *context, const void *
     return (codec->decode_fn)(context, input, inputSizeBytes, output, outputSizeBytes);
 }
 
+size_t codec_decode_buffer(codec_handle_t codec, codec_context_t *context, const void *input, size_t inputSizeBytes, void **output, size_t *outputSizeBytes)
+{
+    size_t needed;
+
+    if (!codec) return 0;
+
+    needed = (codec->decode_fn)(context, input, inputSizeBytes, NULL, NULL);
+    if (needed == 0) return 0;
+    if (*output == NULL || *outputSizeBytes < needed) {
+        *output = g_realloc(*output, needed);
+        *outputSizeBytes = needed;
+    }
+
+    /* Codecs set the size to what they decoded; the buffer keeps its own. */
+    return (codec->decode_fn)(context, input, inputSizeBytes, *output, &needed);
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
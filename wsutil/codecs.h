@@ -41,10 +41,11 @@ WS_DLL_PUBLIC void codecs_register_plugin(const codecs_plugin *plug);
 /**
  * @brief Initialize all built-in and plugin-based codecs.
  *
- * Invokes the registration routines for all supported codecs, including
+ * Prepares the registration of all supported codecs, including
  * statically linked and dynamically loaded plugins. This function should
  * be called during application startup or dissector initialization to
- * ensure codec availability for decoding and playback.
+ * ensure codec availability for decoding and playback. The plugins are
+ * opened and registered the first time find_codec() is called.
  *
  * @param app_env_var_prefix The prefix for the application environment variable used to get plugin directory.
  */
@@ -252,6 +253,26 @@ WS_DLL_PUBLIC size_t codec_decode(codec_handle_t codec, codec_context_t *context
         const void *inputBytes, size_t inputBytesSize,
         void *outputSamples, size_t *outputSamplesSize);
 
+/**
+ * @brief Decode a whole payload into a buffer that is reused between calls.
+ *
+ * Does what the two calls to codec_decode() (one for the size, one to
+ * decode) do, without allocating a buffer for each payload. The buffer is
+ * grown with g_realloc() when a payload needs more room, and is freed by
+ * the caller with g_free() when it is done decoding.
+ *
+ * @param codec              Handle to the codec.
+ * @param context            Pointer to the associated context.
+ * @param inputBytes         Pointer to encoded input data.
+ * @param inputBytesSize     Size of the input data in bytes.
+ * @param outputSamples      Pointer to the buffer, which may be NULL.
+ * @param outputSamplesSize  Pointer to the size of the buffer in bytes.
+ * @return                   Number of decoded bytes (!not samples).
+ */
+WS_DLL_PUBLIC size_t codec_decode_buffer(codec_handle_t codec, codec_context_t *context,
+        const void *inputBytes, size_t inputBytesSize,
+        void **outputSamples, size_t *outputSamplesSize);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -18,6 +18,17 @@
 #include <wsutil/crc32.h>
 #include <wsutil/zlib_compat.h>
 
+#include "cksum_int.h"
+
+#ifdef HAVE_SSE4_2
+#include "ws_cpuid.h"
+#elif defined(__ARM_FEATURE_CRC32)
+/* ARMv8.1-A and later always have the CRC32 instructions; builds for
+ * plain ARMv8-A don't define this, and use the table. */
+#include <string.h>
+#include <arm_acle.h>
+#endif
+
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
 /*****************************************************************/
@@ -429,14 +440,44 @@ crc32_ccitt_table_lookup (unsigned char pos)
 	return crc32_ccitt_table[pos];
 }
 
+#ifdef HAVE_SSE4_2
+/* Checking costs a CPUID instruction, so only do it once. */
+static bool
+crc32c_use_sse42(void)
+{
+	static int use_sse42 = -1;
+
+	if (use_sse42 < 0)
+		use_sse42 = ws_cpuid_sse42() ? 1 : 0;
+	return use_sse42 != 0;
+}
+#endif
+
+#if !defined(HAVE_SSE4_2) && defined(__ARM_FEATURE_CRC32)
+static uint32_t
+crc32c_armv8_no_swap(const uint8_t *p, int len, uint32_t crc)
+{
+	while (len >= 8) {
+		uint64_t v;
+
+		memcpy(&v, p, sizeof v);
+		crc = __crc32cd(crc, v);
+		p += 8;
+		len -= 8;
+	}
+	while (len-- > 0) {
+		crc = __crc32cb(crc, *p++);
+	}
+
+	return crc;
+}
+#endif
+
 uint32_t
 crc32c_calculate(const void *buf, int len, uint32_t crc)
 {
-	const uint8_t *p = (const uint8_t *)buf;
 	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	crc = crc32c_calculate_no_swap(buf, len, crc);
 	return CRC32C_SWAP(crc);
 }
 
@@ -444,11 +485,20 @@ uint32_t
 crc32c_calculate_no_swap(const void *buf, int len, uint32_t crc)
 {
 	const uint8_t *p = (const uint8_t *)buf;
+
+#if !defined(HAVE_SSE4_2) && defined(__ARM_FEATURE_CRC32)
+	return crc32c_armv8_no_swap(p, len, crc);
+#else
+#ifdef HAVE_SSE4_2
+	if (len > 0 && crc32c_use_sse42())
+		return crc32c_sse42_no_swap(p, (size_t)len, crc);
+#endif
 	while (len-- > 0) {
 		CRC32C(crc, *p++);
 	}
 
 	return crc;
+#endif /* !HAVE_SSE4_2 && __ARM_FEATURE_CRC32 */
 }
 
 uint32_t
@@ -0,0 +1,74 @@
+/* crc32_sse42.c
+ * CRC-32C with the SSE4.2 crc32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <string.h>
+
+#include <nmmintrin.h>
+
+#include "cksum_int.h"
+
+/*
+ * The crc32 instruction implements exactly the reflected Castagnoli
+ * polynomial of crc32c_table, so it can stand in for the table without
+ * any pre- or post-conditioning. Loads are done with memcpy() so that
+ * the buffer needn't be aligned; the compiler turns them into plain
+ * unaligned moves.
+ */
+uint32_t
+crc32c_sse42_no_swap(const uint8_t *buf, size_t len, uint32_t crc)
+{
+	const uint8_t *p = buf;
+
+#if defined(__x86_64__) || defined(_M_X64)
+	uint64_t crc64 = crc;
+
+	while (len >= 8) {
+		uint64_t v;
+
+		memcpy(&v, p, sizeof v);
+		crc64 = _mm_crc32_u64(crc64, v);
+		p += 8;
+		len -= 8;
+	}
+	crc = (uint32_t)crc64;
+#endif
+	while (len >= 4) {
+		uint32_t v;
+
+		memcpy(&v, p, sizeof v);
+		crc = _mm_crc32_u32(crc, v);
+		p += 4;
+		len -= 4;
+	}
+	while (len-- > 0) {
+		crc = _mm_crc32_u8(crc, *p++);
+	}
+
+	return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
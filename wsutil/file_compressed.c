@@ -18,8 +18,13 @@
 #include <errno.h>
 
 #include <wsutil/file_util.h>
+#include <wsutil/pint.h>
 #include <wsutil/zlib_compat.h>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif /* HAVE_ZSTD */
+
 #ifdef HAVE_LZ4FRAME_H
 #include <lz4frame.h>
 #endif /* HAVE_LZ4FRAME_H */
@@ -41,7 +46,7 @@ static const struct compression_type {
     { WS_FILE_GZIP_COMPRESSED, "gz", "gzip compressed", "gzip", true },
 #endif /* USE_ZLIB_OR_ZLIBNG */
 #ifdef HAVE_ZSTD
-    { WS_FILE_ZSTD_COMPRESSED, "zst", "zstd compressed", "zstd", false },
+    { WS_FILE_ZSTD_COMPRESSED, "zst", "zstd compressed", "zstd", true },
 #endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
     { WS_FILE_LZ4_COMPRESSED, "lz4", "lz4 compressed", "lz4", true },
@@ -164,6 +169,10 @@ writecap_file_open(ws_cwstream* pfile, const char *filename)
         case WS_FILE_GZIP_COMPRESSED:
             return gzwfile_open(filename);
 #endif /* defined (HAVE_ZLIB) || defined (HAVE_ZLIBNG) */
+#ifdef HAVE_ZSTD
+        case WS_FILE_ZSTD_COMPRESSED:
+            return zstdwfile_open(filename);
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
         case WS_FILE_LZ4_COMPRESSED:
             return lz4wfile_open(filename);
@@ -201,6 +210,10 @@ writecap_file_fdopen(ws_cwstream* pfile, int fd)
         case WS_FILE_GZIP_COMPRESSED:
             return gzwfile_fdopen(fd);
 #endif /* defined (HAVE_ZLIB) || defined (HAVE_ZLIBNG) */
+#ifdef HAVE_ZSTD
+        case WS_FILE_ZSTD_COMPRESSED:
+            return zstdwfile_fdopen(fd);
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
         case WS_FILE_LZ4_COMPRESSED:
             return lz4wfile_fdopen(fd);
@@ -334,6 +347,18 @@ ws_cwstream_write(ws_cwstream* pfile, const uint8_t* data, size_t data_length,
             }
             break;
 #endif
+#ifdef HAVE_ZSTD
+        case WS_FILE_ZSTD_COMPRESSED:
+            nwritten = zstdwfile_write(pfile->fh, data, data_length);
+            /*
+             * zstdwfile_write() returns 0 on error.
+             */
+            if (nwritten == 0) {
+                *err = zstdwfile_geterr(pfile->fh);
+                return false;
+            }
+            break;
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
         case WS_FILE_LZ4_COMPRESSED:
             nwritten = lz4wfile_write(pfile->fh, data, data_length);
@@ -377,6 +402,16 @@ ws_cwstream_flush(ws_cwstream* pfile, int *err)
             }
             break;
 #endif
+#ifdef HAVE_ZSTD
+        case WS_FILE_ZSTD_COMPRESSED:
+            if (zstdwfile_flush((ZSTDWFILE_T)pfile->fh) == -1) {
+                if (err) {
+                    *err = zstdwfile_geterr((ZSTDWFILE_T)pfile->fh);
+                }
+                return false;
+            }
+            break;
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
         case WS_FILE_LZ4_COMPRESSED:
             if (lz4wfile_flush((LZ4WFILE_T)pfile->fh) == -1) {
@@ -410,6 +445,11 @@ ws_cwstream_close(ws_cwstream* pfile, int *errp)
             err = gzwfile_close(pfile->fh);
             break;
 #endif
+#ifdef HAVE_ZSTD
+        case WS_FILE_ZSTD_COMPRESSED:
+            err = zstdwfile_close(pfile->fh);
+            break;
+#endif /* HAVE_ZSTD */
 #ifdef HAVE_LZ4FRAME_H
         case WS_FILE_LZ4_COMPRESSED:
             err = lz4wfile_close(pfile->fh);
@@ -429,6 +469,299 @@ ws_cwstream_close(ws_cwstream* pfile, int *errp)
     return err == 0;
 }
 
+#if defined (USE_ZLIB_OR_ZLIBNG) || defined (HAVE_ZSTD) || defined (HAVE_LZ4FRAME_H)
+
+/*
+ * Block compression on worker threads.
+ *
+ * The data written to a compressed file is gathered into blocks, each of
+ * which is compressed by itself, as a complete gzip member, LZ4 frame or
+ * zstd frame; a file made of those can be decompressed by anything that
+ * reads concatenated members or frames, and readers can start at any
+ * block without decompressing what's before it.  (The gzip and LZ4
+ * readers add a fast seek point at the start of every member or frame,
+ * and zstd files also get a seek table at the end.)
+ *
+ * As the blocks don't depend on each other, they're compressed on a pool
+ * of worker threads, so that compressed output isn't limited to what one
+ * processor can compress; compressed blocks are written out in order, by
+ * whoever is writing the file, while it goes on producing data.  Flushing
+ * ends the current block and waits for everything to be written, so it
+ * means the same as when compressing in-line.
+ */
+#define CW_BLOCK_SIZE       (1024 * 1024)
+#define CW_MAX_THREADS      8
+
+typedef struct cw_pipeline cw_pipeline;
+
+typedef struct {
+    cw_pipeline *pipeline;
+    uint8_t *data;          /* uncompressed data */
+    size_t len;
+    uint8_t *out;           /* compressed data */
+    size_t out_size;        /* allocated size of out */
+    size_t out_len;
+    void *ctx;              /* compressor context, kept with the block */
+    int err;                /* error compressing the block, or 0 */
+    const char *err_info;
+    bool done;
+} cw_block;
+
+/* Compress block->data into block->out; runs on a worker thread, so it
+   can only touch the block.  Sets block->err on failure. */
+typedef void (*cw_compress_func)(cw_block *block, const void *writer);
+
+/* Write a compressed block out, or report block->err; runs on the thread
+   writing the file.  Returns false, having set the writer's error, on
+   failure. */
+typedef bool (*cw_write_func)(void *writer, const cw_block *block);
+
+struct cw_pipeline {
+    GThreadPool *threads;           /* NULL to compress in-line */
+    unsigned max_blocks;
+    GQueue jobs;                    /* blocks being compressed, in order */
+    GPtrArray *free_blocks;
+    unsigned block_count;           /* blocks allocated so far */
+    cw_block *cur;                  /* block being filled */
+    uint64_t blocks_written;
+    bool failed;
+    GMutex mutex;
+    GCond cond;
+    cw_compress_func compress;
+    GDestroyNotify free_ctx;
+    cw_write_func write;
+    void *writer;
+};
+
+static void
+cw_pipeline_work(void *data, void *user_data)
+{
+    cw_block *block = (cw_block *)data;
+    cw_pipeline *pipeline = (cw_pipeline *)user_data;
+
+    pipeline->compress(block, pipeline->writer);
+
+    g_mutex_lock(&pipeline->mutex);
+    block->done = true;
+    g_cond_broadcast(&pipeline->cond);
+    g_mutex_unlock(&pipeline->mutex);
+}
+
+/*
+ * Returns NULL if compressing on worker threads isn't worthwhile, unless
+ * always is true, in which case blocks are compressed in-line when there's
+ * only one processor.
+ */
+static cw_pipeline *
+cw_pipeline_new(cw_compress_func compress, GDestroyNotify free_ctx,
+                cw_write_func write, void *writer, bool always)
+{
+    cw_pipeline *pipeline;
+    unsigned nthreads;
+
+    nthreads = MIN((unsigned)g_get_num_processors(), CW_MAX_THREADS);
+    if (nthreads < 2 && !always)
+        return NULL;
+
+    pipeline = g_new0(cw_pipeline, 1);
+    g_queue_init(&pipeline->jobs);
+    g_mutex_init(&pipeline->mutex);
+    g_cond_init(&pipeline->cond);
+    pipeline->compress = compress;
+    pipeline->free_ctx = free_ctx;
+    pipeline->write = write;
+    pipeline->writer = writer;
+    pipeline->free_blocks = g_ptr_array_new();
+    if (nthreads >= 2)
+        pipeline->threads = g_thread_pool_new(cw_pipeline_work, pipeline, (int)nthreads, false, NULL);
+    if (pipeline->threads == NULL && !always) {
+        g_ptr_array_free(pipeline->free_blocks, true);
+        g_mutex_clear(&pipeline->mutex);
+        g_cond_clear(&pipeline->cond);
+        g_free(pipeline);
+        return NULL;
+    }
+    /* Enough to keep the workers busy while finished blocks are written. */
+    pipeline->max_blocks = pipeline->threads != NULL ? nthreads * 2 : 1;
+    return pipeline;
+}
+
+/* Wait for the oldest block being compressed, and write it out. */
+static void
+cw_pipeline_write_oldest(cw_pipeline *pipeline)
+{
+    cw_block *block = (cw_block *)g_queue_pop_head(&pipeline->jobs);
+
+    g_mutex_lock(&pipeline->mutex);
+    while (!block->done)
+        g_cond_wait(&pipeline->cond, &pipeline->mutex);
+    g_mutex_unlock(&pipeline->mutex);
+
+    if (!pipeline->failed) {
+        if (pipeline->write(pipeline->writer, block))
+            pipeline->blocks_written++;
+        else
+            pipeline->failed = true;
+    }
+    g_ptr_array_add(pipeline->free_blocks, block);
+}
+
+/* Hand the current block to a worker. */
+static void
+cw_pipeline_submit(cw_pipeline *pipeline)
+{
+    cw_block *block = pipeline->cur;
+
+    pipeline->cur = NULL;
+    block->done = false;
+    block->err = 0;
+    block->err_info = NULL;
+    g_queue_push_tail(&pipeline->jobs, block);
+    if (pipeline->threads != NULL) {
+        g_thread_pool_push(pipeline->threads, block, NULL);
+    } else {
+        pipeline->compress(block, pipeline->writer);
+        block->done = true;
+    }
+}
+
+/* Start filling a block, writing out finished ones if they're all in use. */
+static void
+cw_pipeline_start_block(cw_pipeline *pipeline)
+{
+    cw_block *block;
+
+    if (pipeline->free_blocks->len == 0) {
+        if (pipeline->block_count < pipeline->max_blocks) {
+            block = g_new0(cw_block, 1);
+            block->pipeline = pipeline;
+            block->data = (uint8_t *)g_malloc(CW_BLOCK_SIZE);
+            g_ptr_array_add(pipeline->free_blocks, block);
+            pipeline->block_count++;
+        } else {
+            cw_pipeline_write_oldest(pipeline);
+        }
+    }
+    block = (cw_block *)g_ptr_array_remove_index_fast(pipeline->free_blocks,
+                                                      pipeline->free_blocks->len - 1);
+    block->len = 0;
+    pipeline->cur = block;
+}
+
+/* Returns false if writing has failed. */
+static bool
+cw_pipeline_write(cw_pipeline *pipeline, const void *buf, size_t len)
+{
+    while (len > 0) {
+        size_t n;
+
+        if (pipeline->failed)
+            return false;
+        if (pipeline->cur == NULL)
+            cw_pipeline_start_block(pipeline);
+        n = MIN(len, CW_BLOCK_SIZE - pipeline->cur->len);
+        memcpy(pipeline->cur->data + pipeline->cur->len, buf, n);
+        pipeline->cur->len += n;
+        buf = (const uint8_t *)buf + n;
+        len -= n;
+        if (pipeline->cur->len == CW_BLOCK_SIZE)
+            cw_pipeline_submit(pipeline);
+    }
+    return !pipeline->failed;
+}
+
+/* End the current block, and wait for everything to be written out.
+   Returns false if writing has failed. */
+static bool
+cw_pipeline_flush(cw_pipeline *pipeline)
+{
+    if (pipeline->cur != NULL && pipeline->cur->len != 0)
+        cw_pipeline_submit(pipeline);
+    while (!g_queue_is_empty(&pipeline->jobs))
+        cw_pipeline_write_oldest(pipeline);
+    return !pipeline->failed;
+}
+
+static void
+cw_block_free(void *data)
+{
+    cw_block *block = (cw_block *)data;
+
+    if (block->ctx != NULL)
+        block->pipeline->free_ctx(block->ctx);
+    g_free(block->out);
+    g_free(block->data);
+    g_free(block);
+}
+
+/* Write out everything, and free the pipeline.  If nothing at all has
+   been written, an empty block is, so that the file is a valid empty
+   compressed file.  Returns false if writing has failed. */
+static bool
+cw_pipeline_free(cw_pipeline *pipeline)
+{
+    bool ok;
+
+    ok = cw_pipeline_flush(pipeline);
+    if (ok && pipeline->blocks_written == 0) {
+        if (pipeline->cur == NULL)
+            cw_pipeline_start_block(pipeline);
+        cw_pipeline_submit(pipeline);
+        ok = cw_pipeline_flush(pipeline);
+    }
+    if (pipeline->cur != NULL)
+        g_ptr_array_add(pipeline->free_blocks, pipeline->cur);
+
+    if (pipeline->threads != NULL)
+        g_thread_pool_free(pipeline->threads, false, true);
+    g_ptr_array_set_free_func(pipeline->free_blocks, cw_block_free);
+    g_ptr_array_free(pipeline->free_blocks, true);
+    g_mutex_clear(&pipeline->mutex);
+    g_cond_clear(&pipeline->cond);
+    g_free(pipeline);
+    return ok;
+}
+
+/* Make sure a block's output buffer has room for size bytes. */
+static bool
+cw_block_reserve_out(cw_block *block, size_t size)
+{
+    if (block->out_size < size) {
+        g_free(block->out);
+        block->out = (uint8_t *)g_try_malloc(size);
+        if (block->out == NULL) {
+            block->out_size = 0;
+            block->err = ENOMEM;
+            return false;
+        }
+        block->out_size = size;
+    }
+    return true;
+}
+
+/* Write all of a buffer to a file descriptor. */
+static bool
+cw_write_fully(int fd, const uint8_t *buf, size_t len, int *err)
+{
+    while (len > 0) {
+        unsigned n = (unsigned)MIN(len, G_MAXINT);
+        ssize_t got = ws_write(fd, buf, n);
+
+        if (got < 0) {
+            *err = errno;
+            return false;
+        }
+        if (got == 0) {
+            *err = FILE_ERR_SHORT_WRITE;
+            return false;
+        }
+        buf += got;
+        len -= (size_t)got;
+    }
+    return true;
+}
+#endif /* defined (USE_ZLIB_OR_ZLIBNG) || defined (HAVE_ZSTD) || defined (HAVE_LZ4FRAME_H) */
+
 #ifdef USE_ZLIB_OR_ZLIBNG
 
 #define GZBUFSIZE 4096
@@ -448,8 +781,13 @@ struct gzip_writer {
     const char *err_info;   /* additional error information string for some errors */
     /* zlib deflate stream */
     zlib_stream strm;          /* stream structure in-place (not a pointer) */
+    cw_pipeline *pipeline;     /* block compression on worker threads, if any */
 };
 
+static void gz_block_compress(cw_block *block, const void *writer);
+static void gz_block_free_ctx(void *ctx);
+static bool gz_block_write(void *writer, const cw_block *block);
+
 GZWFILE_T
 gzwfile_open(const char *path)
 {
@@ -491,6 +829,10 @@ gzwfile_fdopen(int fd)
     state->pos = 0;                 /* no uncompressed data yet */
     state->strm.avail_in = 0;       /* no input data yet */
 
+    /* with more than one processor, compress blocks as separate members */
+    state->pipeline = cw_pipeline_new(gz_block_compress, gz_block_free_ctx,
+                                      gz_block_write, state, false);
+
     /* return stream */
     return state;
 }
@@ -606,6 +948,75 @@ gz_comp(GZWFILE_T state, int flush)
     return 0;
 }
 
+/* Compress a block as a complete gzip member. */
+static void
+gz_block_compress(cw_block *block, const void *writer)
+{
+    const struct gzip_writer *state = (const struct gzip_writer *)writer;
+    zlib_streamp strm = (zlib_streamp)block->ctx;
+    int ret;
+
+    if (strm == NULL) {
+        strm = g_new0(zlib_stream, 1);
+        ret = ZLIB_PREFIX(deflateInit2)(strm, state->level, Z_DEFLATED,
+                           15 + 16, 8, state->strategy);
+        if (ret != Z_OK) {
+            g_free(strm);
+            if (ret == Z_MEM_ERROR) {
+                block->err = ENOMEM;
+            } else {
+                block->err = FILE_ERR_INTERNAL;
+                block->err_info = "Unknown error from deflateInit2()";
+            }
+            return;
+        }
+        block->ctx = strm;
+    } else {
+        ZLIB_PREFIX(deflateReset)(strm);
+    }
+
+    if (!cw_block_reserve_out(block, ZLIB_PREFIX(deflateBound)(strm, (unsigned long)block->len)))
+        return;
+#ifdef z_const
+    strm->next_in = (z_const Bytef *)block->data;
+#else /* z_const */
+DIAG_OFF(cast-qual)
+    strm->next_in = (Bytef *)block->data;
+DIAG_ON(cast-qual)
+#endif /* z_const */
+    strm->avail_in = (unsigned)block->len;
+    strm->next_out = block->out;
+    strm->avail_out = (unsigned)block->out_size;
+    ret = ZLIB_PREFIX(deflate)(strm, Z_FINISH);
+    if (ret != Z_STREAM_END) {
+        /* This "shouldn't happen", as out is big enough. */
+        block->err = FILE_ERR_INTERNAL;
+        block->err_info = "Unexpected result from deflate()";
+        return;
+    }
+    block->out_len = block->out_size - strm->avail_out;
+}
+
+static void
+gz_block_free_ctx(void *ctx)
+{
+    (void)ZLIB_PREFIX(deflateEnd)((zlib_streamp)ctx);
+    g_free(ctx);
+}
+
+static bool
+gz_block_write(void *writer, const cw_block *block)
+{
+    GZWFILE_T state = (GZWFILE_T)writer;
+
+    if (block->err != 0) {
+        state->err = block->err;
+        state->err_info = block->err_info;
+        return false;
+    }
+    return cw_write_fully(state->fd, block->out, block->out_len, &state->err);
+}
+
 /* Write out len bytes from buf.  Return 0, and set state->err, on
    failure or on an attempt to write 0 bytes (in which case state->err
    is Z_OK); return the number of bytes written on success. */
@@ -618,6 +1029,14 @@ gzwfile_write(GZWFILE_T state, const void *buf, unsigned len)
 
     strm = &(state->strm);
 
+    /* with worker threads, just hand the data over */
+    if (state->pipeline != NULL) {
+        if (len == 0 || !cw_pipeline_write(state->pipeline, buf, len))
+            return 0;
+        state->pos += len;
+        return put;
+    }
+
     /* check that there's no error */
     if (state->err != Z_OK)
         return 0;
@@ -682,6 +1101,9 @@ DIAG_ON(cast-qual)
 int
 gzwfile_flush(GZWFILE_T state)
 {
+    if (state->pipeline != NULL)
+        return cw_pipeline_flush(state->pipeline) ? 0 : -1;
+
     /* check that there's no error */
     if (state->err != Z_OK)
         return -1;
@@ -701,11 +1123,17 @@ gzwfile_close(GZWFILE_T state)
     int ret = 0;
 
     /* flush, free memory, and close file */
-    if (gz_comp(state, Z_FINISH) == -1)
+    if (state->pipeline != NULL) {
+        if (!cw_pipeline_free(state->pipeline))
+            ret = state->err;
+    } else if (gz_comp(state, Z_FINISH) == -1) {
         ret = state->err;
-    (void)ZLIB_PREFIX(deflateEnd)(&(state->strm));
-    g_free(state->out);
-    g_free(state->in);
+    }
+    if (state->size != 0) {
+        (void)ZLIB_PREFIX(deflateEnd)(&(state->strm));
+        g_free(state->out);
+        g_free(state->in);
+    }
     state->err = Z_OK;
     if (ws_close(state->fd) == -1 && ret == 0)
         ret = errno;
@@ -720,6 +1148,207 @@ gzwfile_geterr(GZWFILE_T state)
 }
 #endif /* USE_ZLIB_OR_ZLIBNG */
 
+#ifdef HAVE_ZSTD
+
+/*
+ * zstd files are always written as a sequence of independent frames, one
+ * per block, followed by a seek table in the zstd seekable format, so
+ * that they can be read from anywhere, and decompressed on several
+ * threads, when read back.
+ */
+#define ZSTD_SEEKABLE_MAGIC             0x8F92EAB1U
+#define ZSTD_SEEKABLE_SKIPPABLE_MAGIC   0x184D2A5EU
+#define ZSTD_SEEKABLE_FOOTER_SIZE       9
+#define ZSTD_SEEKABLE_ENTRY_SIZE        8   /* no checksums */
+#define ZSTD_SEEKABLE_MAX_FRAMES        0x8000000U
+#define ZSTD_WRITER_LEVEL               3   /* zstd's default level */
+
+/* internal zstd file state data structure for writing */
+struct zstd_writer {
+    int fd;                 /* file descriptor */
+    int64_t pos;            /* current position in uncompressed data */
+    int level;              /* compression level */
+    int err;                /* error code */
+    const char *err_info;   /* additional error information string for some errors */
+    GByteArray *seek_table; /* seek table entries for the frames written */
+    uint32_t frame_count;
+    cw_pipeline *pipeline;  /* block compression, on worker threads if possible */
+};
+
+static void zstd_block_compress(cw_block *block, const void *writer);
+static void zstd_block_free_ctx(void *ctx);
+static bool zstd_block_write(void *writer, const cw_block *block);
+
+ZSTDWFILE_T
+zstdwfile_open(const char *path)
+{
+    int fd;
+    ZSTDWFILE_T state;
+    int save_errno;
+
+    fd = ws_open(path, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd == -1)
+        return NULL;
+    state = zstdwfile_fdopen(fd);
+    if (state == NULL) {
+        save_errno = errno;
+        ws_close(fd);
+        errno = save_errno;
+    }
+    return state;
+}
+
+ZSTDWFILE_T
+zstdwfile_fdopen(int fd)
+{
+    ZSTDWFILE_T state;
+
+    /* allocate zstd_writer structure to return */
+    state = (ZSTDWFILE_T)g_try_malloc(sizeof *state);
+    if (state == NULL)
+        return NULL;
+    state->fd = fd;
+    state->pos = 0;                 /* no uncompressed data yet */
+    state->level = ZSTD_WRITER_LEVEL;
+    state->err = 0;                 /* clear error */
+    state->err_info = NULL;         /* clear additional error information */
+    state->seek_table = g_byte_array_new();
+    state->frame_count = 0;
+    state->pipeline = cw_pipeline_new(zstd_block_compress, zstd_block_free_ctx,
+                                      zstd_block_write, state, true);
+
+    /* return stream */
+    return state;
+}
+
+/* Compress a block as a complete zstd frame. */
+static void
+zstd_block_compress(cw_block *block, const void *writer)
+{
+    const struct zstd_writer *state = (const struct zstd_writer *)writer;
+    ZSTD_CCtx *cctx = (ZSTD_CCtx *)block->ctx;
+    size_t ret;
+
+    if (cctx == NULL) {
+        cctx = ZSTD_createCCtx();
+        if (cctx == NULL) {
+            block->err = ENOMEM;
+            return;
+        }
+        block->ctx = cctx;
+    }
+    if (!cw_block_reserve_out(block, ZSTD_compressBound(block->len)))
+        return;
+    ret = ZSTD_compressCCtx(cctx, block->out, block->out_size, block->data, block->len,
+                            state->level);
+    if (ZSTD_isError(ret)) {
+        block->err = FILE_ERR_CANT_WRITE; // XXX - FILE_ERR_COMPRESS?
+        block->err_info = ZSTD_getErrorName(ret);
+        return;
+    }
+    block->out_len = ret;
+}
+
+static void
+zstd_block_free_ctx(void *ctx)
+{
+    ZSTD_freeCCtx((ZSTD_CCtx *)ctx);
+}
+
+static bool
+zstd_block_write(void *writer, const cw_block *block)
+{
+    ZSTDWFILE_T state = (ZSTDWFILE_T)writer;
+    uint8_t entry[ZSTD_SEEKABLE_ENTRY_SIZE];
+
+    if (block->err != 0) {
+        state->err = block->err;
+        state->err_info = block->err_info;
+        return false;
+    }
+    if (!cw_write_fully(state->fd, block->out, block->out_len, &state->err))
+        return false;
+
+    /* A file with too many frames for a seek table just doesn't get one. */
+    if (state->seek_table != NULL) {
+        if (state->frame_count < ZSTD_SEEKABLE_MAX_FRAMES) {
+            phtoleu32(entry, (uint32_t)block->out_len);
+            phtoleu32(entry + 4, (uint32_t)block->len);
+            g_byte_array_append(state->seek_table, entry, sizeof entry);
+            state->frame_count++;
+        } else {
+            g_byte_array_free(state->seek_table, true);
+            state->seek_table = NULL;
+        }
+    }
+    return true;
+}
+
+/* Write out the seek table, as a skippable frame.  Returns false, and
+   sets state->err, on failure. */
+static bool
+zstd_write_seek_table(ZSTDWFILE_T state)
+{
+    uint8_t header[8];
+    uint8_t footer[ZSTD_SEEKABLE_FOOTER_SIZE];
+
+    phtoleu32(header, ZSTD_SEEKABLE_SKIPPABLE_MAGIC);
+    phtoleu32(header + 4, state->seek_table->len + ZSTD_SEEKABLE_FOOTER_SIZE);
+    phtoleu32(footer, state->frame_count);
+    footer[4] = 0;                  /* descriptor: no checksums */
+    phtoleu32(footer + 5, ZSTD_SEEKABLE_MAGIC);
+
+    return cw_write_fully(state->fd, header, sizeof header, &state->err) &&
+        cw_write_fully(state->fd, state->seek_table->data, state->seek_table->len, &state->err) &&
+        cw_write_fully(state->fd, footer, sizeof footer, &state->err);
+}
+
+/* Write out len bytes from buf.  Return 0, and set state->err, on
+   failure or on an attempt to write 0 bytes (in which case state->err
+   is 0); return the number of bytes written on success. */
+size_t
+zstdwfile_write(ZSTDWFILE_T state, const void *buf, size_t len)
+{
+    if (len == 0 || !cw_pipeline_write(state->pipeline, buf, len))
+        return 0;
+    state->pos += len;
+    return len;
+}
+
+/* Flush out what we've written so far, ending the current frame.
+   Returns -1, and sets state->err, on failure; returns 0 on success. */
+int
+zstdwfile_flush(ZSTDWFILE_T state)
+{
+    return cw_pipeline_flush(state->pipeline) ? 0 : -1;
+}
+
+/* Flush out all data written, add the seek table, and close the file.
+   Returns a Wiretap error on failure; returns 0 on success. */
+int
+zstdwfile_close(ZSTDWFILE_T state)
+{
+    int ret = 0;
+
+    if (!cw_pipeline_free(state->pipeline))
+        ret = state->err;
+    else if (state->seek_table != NULL && !zstd_write_seek_table(state))
+        ret = state->err;
+    if (state->seek_table != NULL)
+        g_byte_array_free(state->seek_table, true);
+    if (ws_close(state->fd) == -1 && ret == 0)
+        ret = errno;
+    g_free(state);
+    return ret;
+}
+
+int
+zstdwfile_geterr(ZSTDWFILE_T state)
+{
+    return state->err;
+}
+#endif /* HAVE_ZSTD */
+
 #ifdef HAVE_LZ4FRAME_H
 
 #define LZ4BUFSIZE 4194304 // 4MiB, maximum block size
@@ -737,8 +1366,12 @@ struct lz4_writer {
     const char *err_info;   /* additional error information string for some errors */
     LZ4F_preferences_t lz4_prefs;
     LZ4F_cctx *lz4_cctx;
+    cw_pipeline *pipeline;  /* block compression on worker threads, if any */
 };
 
+static void lz4_block_compress(cw_block *block, const void *writer);
+static bool lz4_block_write(void *writer, const cw_block *block);
+
 LZ4WFILE_T
 lz4wfile_open(const char *path)
 {
@@ -804,6 +1437,10 @@ lz4wfile_fdopen(int fd)
     state->pos = 0;                 /* no uncompressed data yet */
     state->pos_out = 0;
 
+    /* with more than one processor, compress blocks as separate frames */
+    state->pipeline = cw_pipeline_new(lz4_block_compress, g_free,
+                                      lz4_block_write, state, false);
+
     /* return stream */
     return state;
 }
@@ -870,26 +1507,16 @@ lz4_init(LZ4WFILE_T state)
     return 0;
 }
 
-/* Write out len bytes from buf.  Return 0, and set state->err, on
-   failure or on an attempt to write 0 bytes (in which case state->err
-   is 0); return the number of bytes written on success. */
-size_t
-lz4wfile_write(LZ4WFILE_T state, const void *buf, size_t len)
+/* Compress and write out len bytes from buf, which must be non-zero.
+   Return false, and set state->err, on failure. */
+static bool
+lz4_comp(LZ4WFILE_T state, const void *buf, size_t len)
 {
     size_t to_write;
-    size_t put = len;
-
-    /* check that there's no error */
-    if (state->err != 0)
-        return 0;
-
-    /* if len is zero, avoid unnecessary operations */
-    if (len == 0)
-        return 0;
 
     /* allocate memory if this is the first time through */
     if (state->size_out == 0 && lz4_init(state) == -1)
-        return 0;
+        return false;
 
     do {
         to_write = MIN(len, state->want);
@@ -898,17 +1525,97 @@ lz4wfile_write(LZ4WFILE_T state, const void *buf, size_t len)
         if (LZ4F_isError(bytesWritten)) {
             state->err = FILE_ERR_CANT_WRITE; // XXX - FILE_ERR_COMPRESS?
             state->err_info = LZ4F_getErrorName(bytesWritten);
-            return 0;
+            return false;
         }
         if (!lz4_write_out(state, bytesWritten)) {
-            return 0;
+            return false;
         }
-        state->pos += to_write;
+        buf = (const uint8_t *)buf + to_write;
         len -= to_write;
     } while (len);
 
+    return true;
+}
+
+/* Flush out what has been compressed so far.  Return false, and set
+   state->err, on failure. */
+static bool
+lz4_flush(LZ4WFILE_T state)
+{
+    size_t bytesWritten;
+
+    bytesWritten = LZ4F_flush(state->lz4_cctx, state->out, state->size_out, NULL);
+    if (LZ4F_isError(bytesWritten)) {
+        // Should never happen if size_out >= LZ4F_compressBound(0, prefsPtr)
+        state->err = FILE_ERR_INTERNAL;
+        return false;
+    }
+    return lz4_write_out(state, bytesWritten);
+}
+
+/* Compress a block as a complete LZ4 frame. */
+static void
+lz4_block_compress(cw_block *block, const void *writer)
+{
+    const struct lz4_writer *state = (const struct lz4_writer *)writer;
+    size_t ret;
+
+    if (!cw_block_reserve_out(block, LZ4F_compressFrameBound(block->len, &state->lz4_prefs)))
+        return;
+    ret = LZ4F_compressFrame(block->out, block->out_size, block->data, block->len,
+                             &state->lz4_prefs);
+    if (LZ4F_isError(ret)) {
+        block->err = FILE_ERR_CANT_WRITE; // XXX - FILE_ERR_COMPRESS?
+        block->err_info = LZ4F_getErrorName(ret);
+        return;
+    }
+    block->out_len = ret;
+}
+
+static bool
+lz4_block_write(void *writer, const cw_block *block)
+{
+    LZ4WFILE_T state = (LZ4WFILE_T)writer;
+
+    if (block->err != 0) {
+        state->err = block->err;
+        state->err_info = block->err_info;
+        return false;
+    }
+    if (!cw_write_fully(state->fd, block->out, block->out_len, &state->err))
+        return false;
+    state->pos_out += block->out_len;
+    return true;
+}
+
+/* Write out len bytes from buf.  Return 0, and set state->err, on
+   failure or on an attempt to write 0 bytes (in which case state->err
+   is 0); return the number of bytes written on success. */
+size_t
+lz4wfile_write(LZ4WFILE_T state, const void *buf, size_t len)
+{
+    /* with worker threads, just hand the data over */
+    if (state->pipeline != NULL) {
+        if (len == 0 || !cw_pipeline_write(state->pipeline, buf, len))
+            return 0;
+        state->pos += len;
+        return len;
+    }
+
+    /* check that there's no error */
+    if (state->err != 0)
+        return 0;
+
+    /* if len is zero, avoid unnecessary operations */
+    if (len == 0)
+        return 0;
+
+    if (!lz4_comp(state, buf, len))
+        return 0;
+    state->pos += len;
+
     /* input was all buffered or compressed */
-    return put;
+    return len;
 }
 
 /* Flush out what we've written so far.  Returns -1, and sets state->err,
@@ -916,21 +1623,14 @@ lz4wfile_write(LZ4WFILE_T state, const void *buf, size_t len)
 int
 lz4wfile_flush(LZ4WFILE_T state)
 {
-    size_t bytesWritten;
+    if (state->pipeline != NULL)
+        return cw_pipeline_flush(state->pipeline) ? 0 : -1;
+
     /* check that there's no error */
     if (state->err != 0)
         return -1;
 
-    bytesWritten = LZ4F_flush(state->lz4_cctx, state->out, state->size_out, NULL);
-    if (LZ4F_isError(bytesWritten)) {
-        // Should never happen if size_out >= LZ4F_compressBound(0, prefsPtr)
-        state->err = FILE_ERR_INTERNAL;
-        return -1;
-    }
-    if (!lz4_write_out(state, bytesWritten)) {
-        return -1;
-    }
-    return 0;
+    return lz4_flush(state) ? 0 : -1;
 }
 
 /* Flush out all data written, and close the file.  Returns a Wiretap
@@ -940,17 +1640,25 @@ lz4wfile_close(LZ4WFILE_T state)
 {
     int ret = 0;
 
-    /* flush, free memory, and close file */
-    size_t bytesWritten = LZ4F_compressEnd(state->lz4_cctx, state->out, state->size_out, NULL);
-    if (LZ4F_isError(bytesWritten)) {
-        // Should never happen if size_out >= LZ4F_compressBound(0, prefsPtr)
-        ret = FILE_ERR_INTERNAL;
-    }
-    if (!lz4_write_out(state, bytesWritten)) {
+    if (state->pipeline != NULL) {
+        /* every block was written as a complete frame */
+        if (!cw_pipeline_free(state->pipeline))
+            ret = state->err;
+    } else if (state->size_out != 0 || lz4_init(state) == 0) {
+        /* flush, free memory, and close file */
+        size_t bytesWritten = LZ4F_compressEnd(state->lz4_cctx, state->out, state->size_out, NULL);
+        if (LZ4F_isError(bytesWritten)) {
+            // Should never happen if size_out >= LZ4F_compressBound(0, prefsPtr)
+            ret = FILE_ERR_INTERNAL;
+        }
+        if (!lz4_write_out(state, bytesWritten)) {
+            ret = state->err;
+        }
+        g_free(state->out);
+        LZ4F_freeCompressionContext(state->lz4_cctx);
+    } else {
         ret = state->err;
     }
-    g_free(state->out);
-    LZ4F_freeCompressionContext(state->lz4_cctx);
     if (ws_close(state->fd) == -1 && ret == 0)
         ret = errno;
     g_free(state);
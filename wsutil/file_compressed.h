@@ -100,6 +100,17 @@ WS_DLL_PUBLIC int gzwfile_close(GZWFILE_T state);
 WS_DLL_PUBLIC int gzwfile_geterr(GZWFILE_T state);
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE_ZSTD
+typedef struct zstd_writer *ZSTDWFILE_T;
+
+WS_DLL_PUBLIC ZSTDWFILE_T zstdwfile_open(const char *path);
+WS_DLL_PUBLIC ZSTDWFILE_T zstdwfile_fdopen(int fd);
+WS_DLL_PUBLIC size_t zstdwfile_write(ZSTDWFILE_T state, const void *buf, size_t len);
+WS_DLL_PUBLIC int zstdwfile_flush(ZSTDWFILE_T state);
+WS_DLL_PUBLIC int zstdwfile_close(ZSTDWFILE_T state);
+WS_DLL_PUBLIC int zstdwfile_geterr(ZSTDWFILE_T state);
+#endif /* HAVE_ZSTD */
+
 #ifdef HAVE_LZ4
 typedef struct lz4_writer *LZ4WFILE_T;
 
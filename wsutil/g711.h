@@ -14,6 +14,9 @@
 
 #include "ws_symbol_export.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -60,6 +63,30 @@ WS_DLL_PUBLIC unsigned char linear2ulaw(int pcm_val);
  */
 WS_DLL_PUBLIC int ulaw2linear(unsigned char u_val);
 
+/**
+ * @brief Decodes a buffer of u-law values to 16-bit linear PCM.
+ *
+ * Equivalent to calling ulaw2linear() on each value, but done with a
+ * single table lookup per sample.
+ *
+ * @param in The u-law encoded values.
+ * @param len The number of values.
+ * @param out Receives len samples.
+ */
+WS_DLL_PUBLIC void ulaw_decode_buffer(const uint8_t *in, size_t len, int16_t *out);
+
+/**
+ * @brief Decodes a buffer of A-law values to 16-bit linear PCM.
+ *
+ * Equivalent to calling alaw2linear() on each value, but done with a
+ * single table lookup per sample.
+ *
+ * @param in The A-law encoded values.
+ * @param len The number of values.
+ * @param out Receives len samples.
+ */
+WS_DLL_PUBLIC void alaw_decode_buffer(const uint8_t *in, size_t len, int16_t *out);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
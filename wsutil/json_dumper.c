@@ -18,8 +18,11 @@
 
 #include "json_dumper.h"
 #include <math.h>
+#include <string.h>
 
 #include <wsutil/array.h>
+#include <wsutil/to_str.h>
+#include <wsutil/ws_mempbrk.h>
 #include <wsutil/wslog.h>
 
 /*
@@ -127,24 +130,58 @@ json_puts_string(const json_dumper *dumper, const char *str, bool dot_to_undersc
         "u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
     };
 
+    /*
+     * Find the characters that need escaping with ws_mempbrk, and copy
+     * the runs between them with one write each; most strings have
+     * none at all. '/' is only escaped after '<', and '.' only in keys.
+     */
+#define JSON_SPECIAL_CHARS \
+    "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f" \
+    "\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f" \
+    "\"\\/"
+    static ws_mempbrk_pattern pbrk_json_string;
+    static ws_mempbrk_pattern pbrk_json_key;
+    static bool compiled = false;
+
+    if (!compiled) {
+        ws_mempbrk_compile(&pbrk_json_string, JSON_SPECIAL_CHARS);
+        ws_mempbrk_compile(&pbrk_json_key, JSON_SPECIAL_CHARS ".");
+        compiled = true;
+    }
+
+    const ws_mempbrk_pattern *pattern = dot_to_underscore ? &pbrk_json_key : &pbrk_json_string;
+    const uint8_t *start = (const uint8_t *)str;
+    const uint8_t *end = start + strlen(str);
+    const uint8_t *run = start;
+    const uint8_t *from = start;
+    const uint8_t *p;
+    unsigned char c;
+
     jd_putc(dumper, '"');
-    for (int i = 0; str[i]; i++) {
-        if ((unsigned)str[i] < 0x20) {
+    while (from < end && (p = ws_mempbrk_exec(from, end - from, pattern, &c)) != NULL) {
+        from = p + 1;
+        if (c == '/' && (p == start || p[-1] != '<'))
+            continue;
+
+        if (p > run)
+            jd_puts_len(dumper, (const char *)run, p - run);
+        run = p + 1;
+
+        if (c < 0x20) {
             jd_putc(dumper, '\\');
-            jd_puts(dumper, json_cntrl[(unsigned)str[i]]);
-        } else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
+            jd_puts(dumper, json_cntrl[c]);
+        } else if (c == '/') {
             // Convert </script> to <\/script> to avoid breaking web pages.
             jd_puts(dumper, "\\/");
+        } else if (c == '.') {
+            jd_putc(dumper, '_');
         } else {
-            if (str[i] == '\\' || str[i] == '"') {
-                jd_putc(dumper, '\\');
-            }
-            if (dot_to_underscore && str[i] == '.')
-                jd_putc(dumper, '_');
-            else
-                jd_putc(dumper, str[i]);
+            jd_putc(dumper, '\\');
+            jd_putc(dumper, c);
         }
     }
+    if (end > run)
+        jd_puts_len(dumper, (const char *)run, end - run);
     jd_putc(dumper, '"');
 }
 
@@ -606,6 +643,46 @@ json_dumper_value_double(json_dumper *dumper, double value)
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
 
+void
+json_dumper_value_int64(json_dumper *dumper, int64_t value)
+{
+    if (!json_dumper_check_previous_error(dumper)) {
+        return;
+    }
+
+    if (!json_dumper_setting_value_ok(dumper)) {
+        return;
+    }
+
+    prepare_token(dumper);
+    char buffer[sizeof("-9223372036854775808")];
+    char *end = buffer + sizeof(buffer);
+    char *start = int64_to_str_back(end, value);
+    jd_puts_len(dumper, start, end - start);
+
+    dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
+}
+
+void
+json_dumper_value_uint64(json_dumper *dumper, uint64_t value)
+{
+    if (!json_dumper_check_previous_error(dumper)) {
+        return;
+    }
+
+    if (!json_dumper_setting_value_ok(dumper)) {
+        return;
+    }
+
+    prepare_token(dumper);
+    char buffer[sizeof("18446744073709551615")];
+    char *end = buffer + sizeof(buffer);
+    char *start = uint64_to_str_back(end, value);
+    jd_puts_len(dumper, start, end - start);
+
+    dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
+}
+
 void
 json_dumper_value_va_list(json_dumper *dumper, const char *format, va_list ap)
 {
@@ -141,6 +141,30 @@ json_dumper_value_string(json_dumper *dumper, const char *value);
 WS_DLL_PUBLIC void
 json_dumper_value_double(json_dumper *dumper, double value);
 
+/**
+ * @brief Writes a signed integer value to the JSON output.
+ *
+ * Adds an integer to the current object or array, without going
+ * through printf-style formatting.
+ *
+ * @param dumper The JSON dumper context.
+ * @param value The integer value to write.
+ */
+WS_DLL_PUBLIC void
+json_dumper_value_int64(json_dumper *dumper, int64_t value);
+
+/**
+ * @brief Writes an unsigned integer value to the JSON output.
+ *
+ * Adds an integer to the current object or array, without going
+ * through printf-style formatting.
+ *
+ * @param dumper The JSON dumper context.
+ * @param value The integer value to write.
+ */
+WS_DLL_PUBLIC void
+json_dumper_value_uint64(json_dumper *dumper, uint64_t value);
+
 /**
  * @brief Writes a formatted literal value to the JSON output.
  *
@@ -37,6 +37,14 @@ typedef struct _plugin {
     uint32_t        flags;        /* plugin flags */
 } plugin;
 
+/* What plugins_init() and plugins_init_on_demand() hand out. */
+typedef struct _plugin_set {
+    plugin_type_e   type;
+    bool            pending;            /* not scanned yet */
+    char           *app_env_var_prefix; /* for the deferred scan */
+    GHashTable     *plugins_module;     /* plugin name -> plugin */
+} plugin_set;
+
 #define TYPE_DIR_EPAN       "epan"
 #define TYPE_DIR_WIRETAP    "wiretap"
 #define TYPE_DIR_CODECS     "codecs"
@@ -249,17 +257,9 @@ DIAG_ON_PEDANTIC
     g_free(plugin_folder);
 }
 
-/*
- * Scan for plugins.
- */
-plugins_t *
-plugins_init(plugin_type_e type, const char* app_env_var_prefix)
+static void
+scan_plugins(GHashTable *plugins_module, plugin_type_e type, const char* app_env_var_prefix)
 {
-    if (!g_module_supported())
-        return NULL; /* nothing to do */
-
-    GHashTable *plugins_module = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_plugin);
-
     /*
      * Scan the global plugin directory.
      */
@@ -276,10 +276,66 @@ plugins_init(plugin_type_e type, const char* app_env_var_prefix)
     if (!started_with_special_privs() && !files_identical(get_plugins_dir_with_version(app_env_var_prefix), get_plugins_pers_dir_with_version(app_env_var_prefix))) {
         scan_plugins_dir(plugins_module, get_plugins_pers_dir_with_version(app_env_var_prefix), type, true);
     }
+}
 
-    plugins_module_list = g_slist_prepend(plugins_module_list, plugins_module);
+static plugin_set *
+new_plugin_set(plugin_type_e type)
+{
+    plugin_set *set = g_new(plugin_set, 1);
+
+    set->type = type;
+    set->pending = false;
+    set->app_env_var_prefix = NULL;
+    set->plugins_module = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_plugin);
+    plugins_module_list = g_slist_prepend(plugins_module_list, set);
+    return set;
+}
+
+/*
+ * Scan for plugins.
+ */
+plugins_t *
+plugins_init(plugin_type_e type, const char* app_env_var_prefix)
+{
+    if (!g_module_supported())
+        return NULL; /* nothing to do */
 
-    return plugins_module;
+    plugin_set *set = new_plugin_set(type);
+
+    scan_plugins(set->plugins_module, type, app_env_var_prefix);
+
+    return set;
+}
+
+plugins_t *
+plugins_init_on_demand(plugin_type_e type, const char* app_env_var_prefix)
+{
+    if (!g_module_supported())
+        return NULL; /* nothing to do */
+
+    plugin_set *set = new_plugin_set(type);
+
+    set->pending = true;
+    set->app_env_var_prefix = g_strdup(app_env_var_prefix);
+
+    return set;
+}
+
+bool
+plugins_load(plugins_t *plugins)
+{
+    plugin_set *set = (plugin_set *)plugins;
+
+    if (!set || !set->pending)
+        return false;
+
+    /* Cleared first, so that a plugin looking itself up doesn't rescan. */
+    set->pending = false;
+    scan_plugins(set->plugins_module, set->type, set->app_env_var_prefix);
+    g_free(set->app_env_var_prefix);
+    set->app_env_var_prefix = NULL;
+
+    return true;
 }
 
 WS_DLL_PUBLIC void
@@ -290,7 +346,11 @@ plugins_get_descriptions(plugin_description_callback callback, void *callback_da
     void * value;
 
     for (GSList *l = plugins_module_list; l != NULL; l = l->next) {
-        g_hash_table_iter_init (&iter, (GHashTable *)l->data);
+        plugin_set *set = (plugin_set *)l->data;
+
+        /* Everything that could be loaded is listed, so load it. */
+        plugins_load(set);
+        g_hash_table_iter_init (&iter, set->plugins_module);
         while (g_hash_table_iter_next (&iter, NULL, &value)) {
             g_ptr_array_add(plugins_array, value);
         }
@@ -326,7 +386,7 @@ plugins_get_count(void)
     unsigned count = 0;
 
     for (GSList *l = plugins_module_list; l != NULL; l = l->next) {
-        count += g_hash_table_size((GHashTable *)l->data);
+        count += g_hash_table_size(((plugin_set *)l->data)->plugins_module);
     }
     return count;
 }
@@ -334,11 +394,15 @@ plugins_get_count(void)
 void
 plugins_cleanup(plugins_t *plugins)
 {
-    if (!plugins)
+    plugin_set *set = (plugin_set *)plugins;
+
+    if (!set)
         return;
 
-    plugins_module_list = g_slist_remove(plugins_module_list, plugins);
-    g_hash_table_destroy((GHashTable *)plugins);
+    plugins_module_list = g_slist_remove(plugins_module_list, set);
+    g_hash_table_destroy(set->plugins_module);
+    g_free(set->app_env_var_prefix);
+    g_free(set);
 }
 
 bool
@@ -39,6 +39,28 @@ typedef enum {
 
 WS_DLL_PUBLIC plugins_t *plugins_init(plugin_type_e type, const char* app_env_var_prefix);
 
+/**
+ * @brief Like plugins_init(), but without opening anything yet.
+ *
+ * For plugin types that are needed only by some features, the scan and
+ * each plugin's registration are put off until plugins_load() is called,
+ * or until plugins_get_descriptions() lists the plugins.
+ *
+ * @param type The type of plugins to look for.
+ * @param app_env_var_prefix The prefix for the application environment variable used to get plugin directory.
+ * @return A handle for plugins_load() and plugins_cleanup().
+ */
+WS_DLL_PUBLIC plugins_t *plugins_init_on_demand(plugin_type_e type, const char* app_env_var_prefix);
+
+/**
+ * @brief Scans for and registers the plugins deferred by plugins_init_on_demand().
+ *
+ * @param plugins The handle returned by plugins_init_on_demand().
+ * @return true if the plugins were loaded by this call, false if there
+ * was nothing left to load.
+ */
+WS_DLL_PUBLIC bool plugins_load(plugins_t *plugins);
+
 typedef void (*plugin_description_callback)(const char *name, const char *version,
                                             uint32_t flags, const char *filename,
                                             void *user_data);
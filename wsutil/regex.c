@@ -21,6 +21,22 @@ struct _ws_regex {
 
 #define ERROR_MAXLEN_IN_CODE_UNITS   128
 
+/*
+ * Match data for ws_regex_matches_length() and ws_regex_matches_pos(),
+ * which only need the offsets of the whole match. It doesn't depend on
+ * the pattern, so each thread allocates it once instead of on every
+ * match; it is not freed when the thread exits.
+ */
+static WS_THREAD_LOCAL pcre2_match_data *thread_match_data;
+
+static pcre2_match_data *
+get_match_data(void)
+{
+    if (thread_match_data == NULL)
+        thread_match_data = pcre2_match_data_create(1, NULL);
+    return thread_match_data;
+}
+
 static char *
 get_error_msg(int errorcode)
 {
@@ -76,6 +92,13 @@ compile_pcre2(const char *patt, ssize_t size, char **errmsg, unsigned flags)
         return NULL;
     }
 
+    /* Compile the pattern to machine code if PCRE2 was built with JIT
+     * support for this platform. If it wasn't, or this fails, matching
+     * uses the interpreter as before. PCRE2 searches for a literal the
+     * pattern starts with or requires before trying to match it, with
+     * either. */
+    pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+
     return code;
 }
 
@@ -123,6 +146,18 @@ match_pcre2(pcre2_code *code, const char *subject, ssize_t subj_length,
                     match_data,
                     NULL);
 
+    if (rc == PCRE2_ERROR_JIT_STACKLIMIT) {
+        /* The JIT uses a fixed size stack; some patterns on huge
+         * subjects need more. The interpreter doesn't have that limit. */
+        rc = pcre2_match(code,
+                        (const uint8_t*)subject,
+                        length,
+                        (PCRE2_SIZE)subj_offset,
+                        PCRE2_NO_JIT,
+                        match_data,
+                        NULL);
+    }
+
     if (rc < 0) {
         /* No match */
         if (rc != PCRE2_ERROR_NOMATCH) {
@@ -151,18 +186,12 @@ bool
 ws_regex_matches_length(const ws_regex_t *re,
                         const char *subj, ssize_t subj_length)
 {
-    bool matched;
-    pcre2_match_data *match_data;
-
     ws_return_val_if(!re, false);
     ws_return_val_if(!subj, false);
 
     /* We don't use the matched substring but pcre2_match requires
      * at least one pair of offsets. */
-    match_data = pcre2_match_data_create(1, NULL);
-    matched = match_pcre2(re->code, subj, subj_length, 0, match_data);
-    pcre2_match_data_free(match_data);
-    return matched;
+    return match_pcre2(re->code, subj, subj_length, 0, get_match_data());
 }
 
 
@@ -177,14 +206,13 @@ ws_regex_matches_pos(const ws_regex_t *re,
     ws_return_val_if(!re, false);
     ws_return_val_if(!subj, false);
 
-    match_data = pcre2_match_data_create(1, NULL);
+    match_data = get_match_data();
     matched = match_pcre2(re->code, subj, subj_length, subj_offset, match_data);
     if (matched && pos_vect) {
         PCRE2_SIZE *ovect = pcre2_get_ovector_pointer(match_data);
         pos_vect[0] = ovect[0];
         pos_vect[1] = ovect[1];
     }
-    pcre2_match_data_free(match_data);
     return matched;
 }
 
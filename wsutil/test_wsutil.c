@@ -324,6 +324,65 @@ static void test_format_text_perf(void)
         "format_text_string(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
 }
 
+#include "json_dumper.h"
+
+static void test_json_dumper_string(void)
+{
+    GString *out = g_string_new(NULL);
+    json_dumper dumper = {
+        .output_string = out,
+    };
+
+    json_dumper_begin_array(&dumper);
+    json_dumper_value_string(&dumper, "plain text");
+    json_dumper_value_string(&dumper, "\"quoted\" back\\slash");
+    json_dumper_value_string(&dumper, "\001tab\tnl\n");
+    json_dumper_value_string(&dumper, "a/b</script>/");
+    json_dumper_value_string(&dumper, "");
+    json_dumper_value_string(&dumper, NULL);
+    json_dumper_value_int64(&dumper, INT64_MIN);
+    json_dumper_value_int64(&dumper, 0);
+    json_dumper_value_uint64(&dumper, UINT64_MAX);
+    json_dumper_end_array(&dumper);
+    g_assert_true(json_dumper_finish(&dumper));
+
+    g_assert_cmpstr(out->str, ==,
+        "[\"plain text\",\"\\\"quoted\\\" back\\\\slash\","
+        "\"\\u0001tab\\tnl\\n\",\"a/b<\\/script>/\",\"\",null,"
+        "-9223372036854775808,0,18446744073709551615]\n");
+    g_string_free(out, true);
+}
+
+static void test_json_dumper_perf(void)
+{
+#define JSON_LOOP_COUNT (1 * 1000 * 1000)
+    GString            *out = g_string_new(NULL);
+    int                 i;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    const char *text = "The quick brown fox jumps over the \"lazy\" dog";
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < JSON_LOOP_COUNT; i++) {
+        json_dumper dumper = {
+            .output_string = out,
+        };
+
+        g_string_truncate(out, 0);
+        json_dumper_begin_object(&dumper);
+        json_dumper_set_member_name(&dumper, "text");
+        json_dumper_value_string(&dumper, text);
+        json_dumper_set_member_name(&dumper, "num");
+        json_dumper_value_uint64(&dumper, (uint64_t)i * 1000003);
+        json_dumper_end_object(&dumper);
+        json_dumper_finish(&dumper);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "json_dumper: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+    g_string_free(out, true);
+}
+
 #include "to_str.h"
 
 static void test_word_to_hex(void)
@@ -640,6 +699,93 @@ static void test_int64_to_str_back(void)
     g_assert_cmpstr(str, ==, "9223372036854775807");
 }
 
+static void test_ip6_to_str(void)
+{
+    static const char *tests[] = {
+        "::",
+        "::1",
+        "1::",
+        "2001:db8::1",
+        "2001:db8:0:1:1:1:1:1",
+        "2001:0:0:1::1",
+        "fe80::1:2:3:4",
+        "::ffff:192.0.2.128",
+        "::192.0.2.128",
+        "::ffff:0:c000:280",
+        "2001:db8:ffaa:ddbb:1199:2288:3377:1",
+    };
+    char result[WS_INET6_ADDRSTRLEN];
+    ws_in6_addr addr;
+
+    for (size_t i = 0; i < G_N_ELEMENTS(tests); i++) {
+        g_assert_true(ws_inet_pton6(tests[i], &addr));
+        ip6_to_str_buf(&addr, result, sizeof(result));
+        g_assert_cmpstr(result, ==, tests[i]);
+    }
+
+    /* Too small */
+    g_assert_true(ws_inet_pton6("2001:db8::1", &addr));
+    ip6_to_str_buf(&addr, result, 8);
+    g_assert_cmpstr(result, ==, "[Buffer");
+}
+
+static void test_bytes_to_hexstr_perf(void)
+{
+#define HEXSTR_LOOP_COUNT (1 * 1000 * 1000)
+    uint8_t             bytes[64];
+    char                out[sizeof(bytes) * 2];
+    int                 i;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    for (i = 0; i < (int)sizeof(bytes); i++)
+        bytes[i] = (uint8_t)(i * 37);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < HEXSTR_LOOP_COUNT; i++) {
+        bytes_to_hexstr(out, bytes, sizeof(bytes));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "bytes_to_hexstr(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+}
+
+static void test_address_to_str_perf(void)
+{
+#define ADDRESS_LOOP_COUNT (1 * 1000 * 1000)
+    char                result[WS_INET6_ADDRSTRLEN];
+    ws_in6_addr         addr6;
+    ws_in4_addr         addr4;
+    int                 i;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    ws_inet_pton6("2001:db8:0:1:1:1:1:1", &addr6);
+    RESOURCE_USAGE_START;
+    for (i = 0; i < ADDRESS_LOOP_COUNT; i++) {
+        addr6.bytes[15] = (uint8_t)i;
+        ip6_to_str_buf(&addr6, result, sizeof(result));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "ip6_to_str_buf(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < ADDRESS_LOOP_COUNT; i++) {
+        addr4 = g_htonl(0xC0000200 + (i & 0xFF));
+        ip_addr_to_str_buf(&addr4, result, sizeof(result));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "ip_addr_to_str_buf(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < ADDRESS_LOOP_COUNT; i++) {
+        uint32_to_str_buf((uint32_t)i * 4099, result, sizeof(result));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "uint32_to_str_buf(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+}
+
 #include "nstime.h"
 #include "time_util.h"
 
@@ -897,6 +1043,103 @@ static void test_getopt_opterr1(void)
 #endif
 }
 
+#include "crc32.h"
+#include "ws_cksum.h"
+
+/* Lengths and offsets that exercise every tail and alignment of the
+ * vector paths, and both sides of their length thresholds. */
+#define CKSUM_BUF_LEN 600
+
+static void fill_cksum_buf(uint8_t *buf, size_t len)
+{
+    uint32_t x = 0x12345678;
+
+    for (size_t i = 0; i < len; i++) {
+        x = x * 1103515245 + 12345;
+        buf[i] = (uint8_t)(x >> 16);
+    }
+}
+
+static uint32_t crc32c_bitwise(const uint8_t *buf, size_t len, uint32_t crc)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0x82F63B78 & -(crc & 1));
+    }
+    return crc;
+}
+
+static void test_crc32c(void)
+{
+    static const char check[] = "123456789";
+    uint8_t buf[CKSUM_BUF_LEN + 8];
+
+    /* The standard CRC-32C check value. */
+    g_assert_cmphex(~crc32c_calculate_no_swap(check, 9, CRC32C_PRELOAD), ==, 0xE3069283);
+    g_assert_cmphex(crc32c_calculate(check, 9, CRC32C_SWAP(CRC32C_PRELOAD)), ==,
+                    CRC32C_SWAP(crc32c_bitwise((const uint8_t *)check, 9, CRC32C_PRELOAD)));
+    g_assert_cmphex(crc32c_calculate_no_swap(check, 0, CRC32C_PRELOAD), ==, CRC32C_PRELOAD);
+
+    fill_cksum_buf(buf, sizeof buf);
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= CKSUM_BUF_LEN; len += (len < 80 ? 1 : 37)) {
+            g_assert_cmphex(crc32c_calculate_no_swap(buf + offset, (int)len, CRC32C_PRELOAD), ==,
+                            crc32c_bitwise(buf + offset, len, CRC32C_PRELOAD));
+        }
+    }
+}
+
+static uint16_t cksum_sum16_simple(const uint8_t *buf, size_t len)
+{
+    uint32_t sum = 0;
+
+    for (size_t i = 0; i + 1 < len; i += 2)
+        sum += (uint32_t)buf[i] << 8 | buf[i + 1];
+    if (len & 1)
+        sum += (uint32_t)buf[len - 1] << 8;
+    while (sum > 0xffff)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+static void test_cksum_sum16(void)
+{
+    uint8_t buf[CKSUM_BUF_LEN + 8];
+
+    g_assert_cmpuint(ws_cksum_sum16(buf, 0), ==, 0);
+    memset(buf, 0xff, sizeof buf);
+    g_assert_cmphex(ws_cksum_sum16(buf, CKSUM_BUF_LEN), ==, 0xffff);
+
+    fill_cksum_buf(buf, sizeof buf);
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= CKSUM_BUF_LEN; len += (len < 160 ? 1 : 41)) {
+            /* Compare in network byte order, where the result is defined. */
+            g_assert_cmphex(g_ntohs(ws_cksum_sum16(buf + offset, len)), ==,
+                            cksum_sum16_simple(buf + offset, len));
+        }
+    }
+}
+
+#include "g711.h"
+
+static void test_g711_decode_buffer(void)
+{
+    uint8_t codes[256];
+    int16_t samples[256];
+
+    for (unsigned i = 0; i < 256; i++)
+        codes[i] = (uint8_t)i;
+
+    ulaw_decode_buffer(codes, 256, samples);
+    for (unsigned i = 0; i < 256; i++)
+        g_assert_cmpint(samples[i], ==, ulaw2linear(codes[i]));
+
+    alaw_decode_buffer(codes, 256, samples);
+    for (unsigned i = 0; i < 256; i++)
+        g_assert_cmpint(samples[i], ==, alaw2linear(codes[i]));
+}
+
 int main(int argc, char **argv)
 {
     int ret;
@@ -925,6 +1168,12 @@ int main(int argc, char **argv)
         g_test_add_func("/str_util/format_text_perf", test_format_text_perf);
     }
 
+    g_test_add_func("/json_dumper/string", test_json_dumper_string);
+
+    if (g_test_perf()) {
+        g_test_add_func("/json_dumper/perf", test_json_dumper_perf);
+    }
+
     g_test_add_func("/to_str/word_to_hex", test_word_to_hex);
     g_test_add_func("/to_str/bytes_to_str", test_bytes_to_str);
     g_test_add_func("/to_str/bytes_to_str_punct", test_bytes_to_str_punct);
@@ -943,6 +1192,12 @@ int main(int argc, char **argv)
     g_test_add_func("/to_str/int_to_str_back", test_int_to_str_back);
     g_test_add_func("/to_str/int64_to_str_back", test_int64_to_str_back);
     g_test_add_func("/to_str/ip_addr_to_str_test1", test_ip_addr_to_str_test1);
+    g_test_add_func("/to_str/ip6_to_str", test_ip6_to_str);
+
+    if (g_test_perf()) {
+        g_test_add_func("/to_str/bytes_to_hexstr_perf", test_bytes_to_hexstr_perf);
+        g_test_add_func("/to_str/address_to_str_perf", test_address_to_str_perf);
+    }
 
     g_test_add_func("/nstime/from_iso8601", test_nstime_from_iso8601);
 
@@ -951,6 +1206,11 @@ int main(int argc, char **argv)
     g_test_add_func("/ws_getopt/optional1", test_getopt_optional_argument1);
     g_test_add_func("/ws_getopt/opterr1", test_getopt_opterr1);
 
+    g_test_add_func("/crc32/crc32c", test_crc32c);
+    g_test_add_func("/ws_cksum/sum16", test_cksum_sum16);
+
+    g_test_add_func("/g711/decode_buffer", test_g711_decode_buffer);
+
     ret = g_test_run();
 
     return ret;
@@ -78,6 +78,18 @@ void log_resource_usage(bool reset_delta, const char *format, ...);
 WS_DLL_PUBLIC
 uint64_t create_timestamp(void);
 
+/**
+ * @brief Fetches a monotonic timestamp in nanoseconds.
+ *
+ * The value has no defined epoch and is only meaningful when compared to
+ * another value returned by this function; it is intended for timing short
+ * stretches of code.
+ *
+ * @return The current monotonic time in nanoseconds.
+ */
+WS_DLL_PUBLIC
+uint64_t ws_monotonic_ns(void);
+
 /**
  * @brief Initializes or updates timezone settings.
  *
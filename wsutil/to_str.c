@@ -86,12 +86,23 @@ low_nibble_of_octet_to_hex(uint8_t oct)
 	return hex_digits[oct & 0xF];
 }
 
+/* The two hex digits for each octet value, so that an octet can be
+   converted with one lookup and one two-byte copy. */
+#define HEX_PAIRS(hi) \
+	hi "0" hi "1" hi "2" hi "3" hi "4" hi "5" hi "6" hi "7" \
+	hi "8" hi "9" hi "a" hi "b" hi "c" hi "d" hi "e" hi "f"
+
+static const char hex_pairs[256 * 2 + 1] =
+	HEX_PAIRS("0") HEX_PAIRS("1") HEX_PAIRS("2") HEX_PAIRS("3")
+	HEX_PAIRS("4") HEX_PAIRS("5") HEX_PAIRS("6") HEX_PAIRS("7")
+	HEX_PAIRS("8") HEX_PAIRS("9") HEX_PAIRS("a") HEX_PAIRS("b")
+	HEX_PAIRS("c") HEX_PAIRS("d") HEX_PAIRS("e") HEX_PAIRS("f");
+
 static inline char *
 byte_to_hex(char *out, uint32_t dword)
 {
-	*out++ = low_nibble_of_octet_to_hex(dword >> 4);
-	*out++ = low_nibble_of_octet_to_hex(dword);
-	return out;
+	memcpy(out, &hex_pairs[(dword & 0xFF) * 2], 2);
+	return out + 2;
 }
 
 char *
@@ -633,22 +644,88 @@ ip_to_str(wmem_allocator_t *scope, const uint8_t *ad)
 	return ip_addr_to_str(scope, (const ws_in4_addr *)ad);
 }
 
+/*
+ * Format an IPv6 address the way the BIND-derived inet_ntop() in GNU libc
+ * and the BSDs does (RFC 5952 compression of the longest run of two or
+ * more zero groups, the first one if there's a tie; lowercase hex without
+ * leading zeroes; embedded IPv4 for IPv4-mapped and IPv4-compatible
+ * addresses), without going through the system call and its error
+ * checking. The buffer has to be at least WS_INET6_ADDRSTRLEN bytes.
+ */
+static void
+ip6_addr_to_str_buf(const ws_in6_addr *addr, char *buf)
+{
+	const uint8_t *ad = addr->bytes;
+	uint16_t words[8];
+	int best_base = -1, best_len = 0;
+	int cur_base = -1, cur_len = 0;
+	char *b = buf;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		words[i] = pntohu16(ad + i * 2);
+		if (words[i] == 0) {
+			if (cur_base == -1) {
+				cur_base = i;
+				cur_len = 1;
+			} else {
+				cur_len++;
+			}
+		} else if (cur_base != -1) {
+			if (cur_len > best_len) {
+				best_base = cur_base;
+				best_len = cur_len;
+			}
+			cur_base = -1;
+		}
+	}
+	if (cur_base != -1 && cur_len > best_len) {
+		best_base = cur_base;
+		best_len = cur_len;
+	}
+	if (best_len < 2)
+		best_base = -1;
+
+	for (i = 0; i < 8; i++) {
+		if (best_base != -1 && i >= best_base && i < best_base + best_len) {
+			if (i == best_base)
+				*b++ = ':';
+			continue;
+		}
+		if (i != 0)
+			*b++ = ':';
+		if (i == 6 && best_base == 0 &&
+		    (best_len == 6 || (best_len == 5 && words[5] == 0xffff))) {
+			ip_addr_to_str_buf((const ws_in4_addr *)(ad + 12), b,
+			    WS_INET_ADDRSTRLEN);
+			return;
+		}
+		b = word_to_hex_npad(b, words[i]);
+	}
+	if (best_base != -1 && best_base + best_len == 8)
+		*b++ = ':';
+	*b = '\0';
+}
+
 void
 ip6_to_str_buf(const ws_in6_addr *addr, char *buf, size_t buf_size)
 {
-	/*
-	 * If there is not enough space then ws_inet_ntop6() will leave
-	 * an error message in the buffer, we don't need
-	 * to use _return_if_nospace().
-	 */
-	ws_inet_ntop6(addr, buf, (unsigned)buf_size);
+	char str[WS_INET6_ADDRSTRLEN];
+
+	if (buf_size >= WS_INET6_ADDRSTRLEN) {
+		ip6_addr_to_str_buf(addr, buf);
+		return;
+	}
+	ip6_addr_to_str_buf(addr, str);
+	_return_if_nospace(strlen(str) + 1, buf, buf_size);
+	memcpy(buf, str, strlen(str) + 1);
 }
 
 char *ip6_to_str(wmem_allocator_t *scope, const ws_in6_addr *ad)
 {
 	char *buf = wmem_alloc(scope, WS_INET6_ADDRSTRLEN * sizeof(char));
 
-	ws_inet_ntop6(ad, buf, WS_INET6_ADDRSTRLEN);
+	ip6_addr_to_str_buf(ad, buf);
 
 	return buf;
 }
@@ -10,6 +10,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "unicode-utils.h"
 
 const int ws_utf8_seqlen[256] = {
@@ -31,6 +33,37 @@ const int ws_utf8_seqlen[256] = {
     4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,  /* 0xf0...0xff */
 };
 
+#define ASCII_WORD_HIGH_BITS UINT64_C(0x8080808080808080)
+
+size_t
+ws_ascii_prefix_len(const uint8_t *ptr, size_t length)
+{
+    size_t i = 0;
+    uint64_t word;
+
+    /* memcpy() keeps the loads safe for unaligned pointers, and compilers
+     * turn it into a single load. */
+    while (i + 2 * sizeof word <= length) {
+        uint64_t word2;
+
+        memcpy(&word, ptr + i, sizeof word);
+        memcpy(&word2, ptr + i + sizeof word, sizeof word2);
+        if ((word | word2) & ASCII_WORD_HIGH_BITS)
+            break;
+        i += 2 * sizeof word;
+    }
+    while (i + sizeof word <= length) {
+        memcpy(&word, ptr + i, sizeof word);
+        if (word & ASCII_WORD_HIGH_BITS)
+            break;
+        i += sizeof word;
+    }
+    while (i < length && ptr[i] < 0x80)
+        i++;
+
+    return i;
+}
+
 /* Given a pointer and a length, validates a string of bytes as UTF-8.
  * Returns the number of valid bytes, and a pointer immediately past
  * the checked region.
@@ -54,9 +87,11 @@ utf_8_validate(const uint8_t *start, ssize_t length, const uint8_t **end)
         ch = *ptr;
 
         if (ch < 0x80) {
-            valid_bytes++;
-            ptr++;
-            length--;
+            size_t ascii_len = ws_ascii_prefix_len(ptr, length);
+
+            valid_bytes += ascii_len;
+            ptr += ascii_len;
+            length -= (ssize_t)ascii_len;
             continue;
         }
 
@@ -63,6 +63,19 @@ const int ws_utf8_seqlen[256];
  */
 #define ws_utf8_char_len(ch)  (ws_utf8_seqlen[(ch)])
 
+/**
+ * @brief Returns the length of the run of 7-bit ASCII bytes at the start of a buffer.
+ *
+ * Checks a machine word at a time, so it's cheaper than a byte-by-byte
+ * loop for the long runs of ASCII that most text in packets consists of.
+ *
+ * @param ptr Pointer to the input byte sequence.
+ * @param length Length of the input sequence.
+ * @return Number of leading bytes that have the high-order bit clear.
+ */
+WS_DLL_PUBLIC size_t
+ws_ascii_prefix_len(const uint8_t *ptr, size_t length);
+
 /**
  * @brief Validates and sanitizes a UTF-8 byte sequence.
  *
@@ -374,21 +374,32 @@ _try_val_to_str_index(const uint32_t val, value_string_ext *vse)
     return NULL;
 }
 
-/* Value comparator for sorted extended value strings */
-static int
-val_to_str_compar(const void *v_needle, const void *v_item)
-{
-    uint32_t needle = *(const uint32_t *)v_needle;
-    uint32_t value = ((const value_string *)v_item)->value;
-    return needle > value ? 1 : (needle < value ? -1 : 0);
-}
-
-/* log(n)-time matching for sorted extended value strings */
+/* log(n)-time matching for sorted extended value strings. This is
+ * open-coded rather than using bsearch() so that each step is a plain
+ * comparison instead of a call through a comparator. */
 static const value_string *
 _try_val_to_str_bsearch(const uint32_t val, value_string_ext *vse)
 {
-    return bsearch(&val, vse->_vs_p, vse->_vs_num_entries,
-                   sizeof vse->_vs_p[0], val_to_str_compar);
+    const value_string *vs_p = vse->_vs_p;
+    unsigned lo = 0;
+    unsigned hi = vse->_vs_num_entries;
+
+    /* Values that are out of range are common (they're what gets
+     * shown as "Unknown"), so rule them out up front. */
+    if (hi == 0 || val < vs_p[0].value || val > vs_p[hi - 1].value)
+        return NULL;
+
+    while (lo < hi) {
+        unsigned mid = lo + (hi - lo) / 2;
+
+        if (vs_p[mid].value < val)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < vse->_vs_num_entries && vs_p[lo].value == val)
+        return &vs_p[lo];
+    return NULL;
 }
 
 /* Initializes an extended value string. Behaves like a match function to
@@ -645,21 +656,32 @@ _try_val64_to_str_index(const uint64_t val, val64_string_ext *vse)
     return NULL;
 }
 
-/* Value comparator for sorted extended value strings */
-static int
-val64_to_str_compar(const void *v_needle, const void *v_item)
-{
-    uint64_t needle = *(const uint64_t *)v_needle;
-    uint64_t value = ((const val64_string *)v_item)->value;
-    return needle > value ? 1 : (needle < value ? -1 : 0);
-}
-
-/* log(n)-time matching for sorted extended value strings */
+/* log(n)-time matching for sorted extended value strings. This is
+ * open-coded rather than using bsearch() so that each step is a plain
+ * comparison instead of a call through a comparator. */
 static const val64_string *
 _try_val64_to_str_bsearch(const uint64_t val, val64_string_ext *vse)
 {
-    return bsearch(&val, vse->_vs_p, vse->_vs_num_entries,
-                   sizeof vse->_vs_p[0], val64_to_str_compar);
+    const val64_string *vs_p = vse->_vs_p;
+    unsigned lo = 0;
+    unsigned hi = vse->_vs_num_entries;
+
+    /* Values that are out of range are common (they're what gets
+     * shown as "Unknown"), so rule them out up front. */
+    if (hi == 0 || val < vs_p[0].value || val > vs_p[hi - 1].value)
+        return NULL;
+
+    while (lo < hi) {
+        unsigned mid = lo + (hi - lo) / 2;
+
+        if (vs_p[mid].value < val)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < vse->_vs_num_entries && vs_p[lo].value == val)
+        return &vs_p[lo];
+    return NULL;
 }
 
 /* Initializes an extended value string. Behaves like a match function to
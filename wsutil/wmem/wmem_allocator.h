@@ -49,6 +49,8 @@ struct _wmem_allocator_t {
     void *private_data; /**< Allocator-specific internal state. */
     enum _wmem_allocator_type_t type; /**< Allocator type (e.g., scope, file-backed, slab). */
     bool in_scope; /**< Indicates whether the allocator is currently active in a scope. */
+    uint64_t allocated; /**< Total bytes requested through wmem_alloc() and wmem_realloc(). */
+    uint64_t in_use; /**< Bytes requested since the allocator was last emptied by wmem_free_all(). */
 };
 
 #ifdef __cplusplus
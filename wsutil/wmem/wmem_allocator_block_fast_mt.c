@@ -0,0 +1,372 @@
+/* wmem_allocator_block_fast_mt.c
+ * Wireshark Memory Manager Fast Large-Block Allocator for Several Threads
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_allocator.h"
+#include "wmem_allocator_block_fast_mt.h"
+
+/*
+ * Like the fast block allocator, this grabs large blocks and bump-allocates
+ * out of them, with free a no-op. To let several threads allocate at once
+ * without taking a lock, each thread claims a chunk of a shared block with a
+ * single atomic add and then bump-allocates out of its chunk on its own.
+ * Only allocating a new block, which happens once per WMEM_BLOCK_SIZE bytes,
+ * and jumbo allocations take the mutex.
+ *
+ * The chunk each thread is working on is remembered in thread-local storage
+ * together with the generation of the allocator it was claimed in. free_all
+ * bumps the generation instead of visiting the threads, so it costs the same
+ * however many threads used the pool; each thread notices on its next
+ * allocation and claims a fresh chunk. As with every other allocator,
+ * free_all must not run concurrently with allocations from the same pool.
+ */
+
+#define WMEM_ALIGN_AMOUNT (2 * sizeof (size_t))
+#define WMEM_ALIGN_SIZE(SIZE) ((~(WMEM_ALIGN_AMOUNT-1)) & \
+        ((SIZE) + (WMEM_ALIGN_AMOUNT-1)))
+
+#define WMEM_CHUNK_TO_DATA(CHUNK) ((void*)((uint8_t*)(CHUNK) + WMEM_CHUNK_HEADER_SIZE))
+#define WMEM_DATA_TO_CHUNK(DATA) ((wmem_block_fast_mt_chunk_t*)((uint8_t*)(DATA) - WMEM_CHUNK_HEADER_SIZE))
+
+/* Same block size as the single-threaded fast block allocator. */
+#define WMEM_BLOCK_SIZE (2 * 1024 * 1024)
+
+/* What each thread claims from the current block at a time. Small enough
+ * that a thread that allocates little doesn't strand much of a block, large
+ * enough that the atomic add is rare compared to allocations. */
+#define WMEM_THREAD_CHUNK_SIZE (64 * 1024)
+
+/* Allocations bigger than this get a region of their own straight from the
+ * shared block rather than going through the thread's chunk. */
+#define WMEM_THREAD_MAX_CHUNK_ALLOC (WMEM_THREAD_CHUNK_SIZE / 4)
+
+#define WMEM_BLOCK_MAX_ALLOC_SIZE (WMEM_BLOCK_SIZE - (WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE))
+
+/* How many pools of this type a thread can be allocating from before it has
+ * to give up one of its chunks (which only wastes the rest of that chunk). */
+#define WMEM_THREAD_CURSORS 4
+
+typedef struct _wmem_block_fast_mt_hdr {
+    struct _wmem_block_fast_mt_hdr *next;
+
+    /* Claimed with atomic adds, so it can run past WMEM_BLOCK_SIZE. */
+    int pos;
+} wmem_block_fast_mt_hdr_t;
+#define WMEM_BLOCK_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_fast_mt_hdr_t))
+
+typedef struct {
+    uint32_t len;
+} wmem_block_fast_mt_chunk_t;
+#define WMEM_CHUNK_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_fast_mt_chunk_t))
+
+#define JUMBO_MAGIC 0xFFFFFFFF
+typedef struct _wmem_block_fast_mt_jumbo {
+    struct _wmem_block_fast_mt_jumbo *prev, *next;
+} wmem_block_fast_mt_jumbo_t;
+#define WMEM_JUMBO_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_fast_mt_jumbo_t))
+
+typedef struct {
+    /* The block chunks are being claimed from; the head of block_list. */
+    wmem_block_fast_mt_hdr_t *current;
+    wmem_block_fast_mt_hdr_t *block_list;
+    wmem_block_fast_mt_jumbo_t *jumbo_list;
+
+    /* Unique for the life of the process, so that a thread's cursor can't
+     * match a new pool that happens to get the address of an old one. */
+    uint64_t id;
+    int      generation;
+
+    /* Protects block_list, current (for writing) and jumbo_list. */
+    GMutex   mutex;
+} wmem_block_fast_mt_allocator_t;
+
+/* A thread's chunk of one pool. */
+typedef struct {
+    uint64_t id;
+    int      generation;
+    uint8_t *pos;
+    uint8_t *end;
+} wmem_block_fast_mt_cursor_t;
+
+static WS_THREAD_LOCAL wmem_block_fast_mt_cursor_t thread_cursors[WMEM_THREAD_CURSORS];
+static WS_THREAD_LOCAL unsigned thread_cursor_next;
+
+static uint64_t next_allocator_id = 1;
+static GMutex   next_allocator_id_mutex;
+
+/* Claims len bytes (a multiple of WMEM_ALIGN_AMOUNT, at most
+ * WMEM_BLOCK_MAX_ALLOC_SIZE) from the current block, adding a new one if
+ * it's full. */
+static uint8_t *
+wmem_block_fast_mt_claim(wmem_block_fast_mt_allocator_t *allocator, int len)
+{
+    wmem_block_fast_mt_hdr_t *block, *new_block;
+    int pos;
+
+    for (;;) {
+        block = (wmem_block_fast_mt_hdr_t *)g_atomic_pointer_get(&allocator->current);
+        if (block) {
+            pos = g_atomic_int_add(&block->pos, len);
+            if (pos <= WMEM_BLOCK_SIZE - len) {
+                return (uint8_t *)block + pos;
+            }
+        }
+
+        /* Full (or no block yet); whoever gets the lock first adds one. */
+        g_mutex_lock(&allocator->mutex);
+        if (allocator->current == block) {
+            new_block = (wmem_block_fast_mt_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+            new_block->pos  = WMEM_BLOCK_HEADER_SIZE;
+            new_block->next = allocator->block_list;
+            allocator->block_list = new_block;
+            g_atomic_pointer_set(&allocator->current, new_block);
+        }
+        g_mutex_unlock(&allocator->mutex);
+    }
+}
+
+static wmem_block_fast_mt_cursor_t *
+wmem_block_fast_mt_cursor(wmem_block_fast_mt_allocator_t *allocator)
+{
+    wmem_block_fast_mt_cursor_t *cursor;
+    int generation = g_atomic_int_get(&allocator->generation);
+    unsigned i;
+
+    for (i = 0; i < WMEM_THREAD_CURSORS; i++) {
+        cursor = &thread_cursors[i];
+        if (cursor->id == allocator->id) {
+            if (cursor->generation != generation) {
+                /* The pool was emptied since this chunk was claimed. */
+                cursor->generation = generation;
+                cursor->pos = cursor->end = NULL;
+            }
+            return cursor;
+        }
+    }
+
+    cursor = &thread_cursors[thread_cursor_next];
+    thread_cursor_next = (thread_cursor_next + 1) % WMEM_THREAD_CURSORS;
+    cursor->id = allocator->id;
+    cursor->generation = generation;
+    cursor->pos = cursor->end = NULL;
+    return cursor;
+}
+
+/* API */
+
+static void *
+wmem_block_fast_mt_alloc(void *private_data, const size_t size)
+{
+    wmem_block_fast_mt_allocator_t *allocator = (wmem_block_fast_mt_allocator_t*) private_data;
+    wmem_block_fast_mt_cursor_t    *cursor;
+    wmem_block_fast_mt_chunk_t     *chunk;
+    int real_size;
+
+    if (size > WMEM_BLOCK_MAX_ALLOC_SIZE) {
+        wmem_block_fast_mt_jumbo_t *block;
+
+        /* allocate/initialize a new block of the necessary size */
+        block = (wmem_block_fast_mt_jumbo_t *)wmem_alloc(NULL,
+                size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+
+        g_mutex_lock(&allocator->mutex);
+        block->next = allocator->jumbo_list;
+        if (block->next) {
+            block->next->prev = block;
+        }
+        block->prev = NULL;
+        allocator->jumbo_list = block;
+        g_mutex_unlock(&allocator->mutex);
+
+        chunk = ((wmem_block_fast_mt_chunk_t*)((uint8_t*)(block) + WMEM_JUMBO_HEADER_SIZE));
+        chunk->len = JUMBO_MAGIC;
+
+        return WMEM_CHUNK_TO_DATA(chunk);
+    }
+
+    real_size = (int)(WMEM_ALIGN_SIZE(size) + WMEM_CHUNK_HEADER_SIZE);
+
+    if (real_size > WMEM_THREAD_MAX_CHUNK_ALLOC) {
+        chunk = (wmem_block_fast_mt_chunk_t *)wmem_block_fast_mt_claim(allocator, real_size);
+    }
+    else {
+        cursor = wmem_block_fast_mt_cursor(allocator);
+        if (cursor->pos == NULL || cursor->end - cursor->pos < real_size) {
+            cursor->pos = wmem_block_fast_mt_claim(allocator, WMEM_THREAD_CHUNK_SIZE);
+            cursor->end = cursor->pos + WMEM_THREAD_CHUNK_SIZE;
+        }
+        chunk = (wmem_block_fast_mt_chunk_t *)cursor->pos;
+        cursor->pos += real_size;
+    }
+
+    /* safe to cast, size smaller than WMEM_BLOCK_MAX_ALLOC_SIZE */
+    chunk->len = (uint32_t) size;
+
+    /* and return the user's pointer */
+    return WMEM_CHUNK_TO_DATA(chunk);
+}
+
+static void
+wmem_block_fast_mt_free(void *private_data _U_, void *ptr _U_)
+{
+   /* free is NOP */
+}
+
+static void *
+wmem_block_fast_mt_realloc(void *private_data, void *ptr, const size_t size)
+{
+    wmem_block_fast_mt_chunk_t *chunk;
+
+    chunk = WMEM_DATA_TO_CHUNK(ptr);
+
+    if (chunk->len == JUMBO_MAGIC) {
+        wmem_block_fast_mt_allocator_t *allocator = (wmem_block_fast_mt_allocator_t*) private_data;
+        wmem_block_fast_mt_jumbo_t *block;
+
+        block = ((wmem_block_fast_mt_jumbo_t*)((uint8_t*)(chunk) - WMEM_JUMBO_HEADER_SIZE));
+        /* The neighbours' links are shared with other threads. */
+        g_mutex_lock(&allocator->mutex);
+        block =  (wmem_block_fast_mt_jumbo_t*)wmem_realloc(NULL, block,
+                size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+        if (block->prev) {
+            block->prev->next = block;
+        }
+        else {
+            allocator->jumbo_list = block;
+        }
+        if (block->next) {
+            block->next->prev = block;
+        }
+        g_mutex_unlock(&allocator->mutex);
+        return ((void*)((uint8_t*)(block) + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE));
+    }
+    else if (chunk->len < size) {
+        /* grow */
+        void *newptr;
+
+        /* need to alloc and copy; free is no-op, so don't call it */
+        newptr = wmem_block_fast_mt_alloc(private_data, size);
+        memcpy(newptr, ptr, chunk->len);
+
+        return newptr;
+    }
+
+    /* shrink or same space - great we can do nothing */
+    return ptr;
+}
+
+static void
+wmem_block_fast_mt_free_all(void *private_data)
+{
+    wmem_block_fast_mt_allocator_t *allocator = (wmem_block_fast_mt_allocator_t*) private_data;
+    wmem_block_fast_mt_hdr_t       *cur, *nxt;
+    wmem_block_fast_mt_jumbo_t     *cur_jum, *nxt_jum;
+
+    g_mutex_lock(&allocator->mutex);
+
+    /* Invalidate every thread's chunk. */
+    g_atomic_int_inc(&allocator->generation);
+
+    /* iterate through the blocks, freeing all but the first and reinitializing
+     * that one */
+    cur = allocator->block_list;
+
+    if (cur) {
+         cur->pos = WMEM_BLOCK_HEADER_SIZE;
+         nxt = cur->next;
+         cur->next = NULL;
+         cur = nxt;
+    }
+
+    while (cur) {
+        nxt  = cur->next;
+        wmem_free(NULL, cur);
+        cur = nxt;
+    }
+
+    /* now do the jumbo blocks, freeing all of them */
+    cur_jum = allocator->jumbo_list;
+    while (cur_jum) {
+        nxt_jum  = cur_jum->next;
+        wmem_free(NULL, cur_jum);
+        cur_jum = nxt_jum;
+    }
+    allocator->jumbo_list = NULL;
+
+    g_mutex_unlock(&allocator->mutex);
+}
+
+static void
+wmem_block_fast_mt_gc(void *private_data _U_)
+{
+    /* No-op */
+}
+
+static void
+wmem_block_fast_mt_allocator_cleanup(void *private_data)
+{
+    wmem_block_fast_mt_allocator_t *allocator = (wmem_block_fast_mt_allocator_t*) private_data;
+
+    /* wmem guarantees that free_all() is called directly before this, so
+     * simply free the first block */
+    wmem_free(NULL, allocator->block_list);
+
+    g_mutex_clear(&allocator->mutex);
+
+    /* then just free the allocator structs */
+    wmem_free(NULL, private_data);
+}
+
+void
+wmem_block_fast_mt_allocator_init(wmem_allocator_t *allocator)
+{
+    wmem_block_fast_mt_allocator_t *block_allocator;
+
+    block_allocator = wmem_new(NULL, wmem_block_fast_mt_allocator_t);
+
+    allocator->walloc   = &wmem_block_fast_mt_alloc;
+    allocator->wrealloc = &wmem_block_fast_mt_realloc;
+    allocator->wfree    = &wmem_block_fast_mt_free;
+
+    allocator->free_all = &wmem_block_fast_mt_free_all;
+    allocator->gc       = &wmem_block_fast_mt_gc;
+    allocator->cleanup  = &wmem_block_fast_mt_allocator_cleanup;
+
+    allocator->private_data = (void*) block_allocator;
+
+    block_allocator->current    = NULL;
+    block_allocator->block_list = NULL;
+    block_allocator->jumbo_list = NULL;
+    block_allocator->generation = 0;
+    g_mutex_init(&block_allocator->mutex);
+
+    g_mutex_lock(&next_allocator_id_mutex);
+    block_allocator->id = next_allocator_id++;
+    g_mutex_unlock(&next_allocator_id_mutex);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,55 @@
+/** @file
+ *
+ * Definitions for the Wireshark Memory Manager Fast Large-Block Allocator
+ * for Several Threads
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WMEM_ALLOCATOR_BLOCK_FAST_MT_H__
+#define __WMEM_ALLOCATOR_BLOCK_FAST_MT_H__
+
+#include "wmem_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Initialize a fast block-based memory allocator usable from several threads.
+ *
+ * Sets up a `wmem_allocator_t` to behave like the fast block allocator, except
+ * that any number of threads may allocate from it at the same time. Each
+ * thread bump-allocates from its own chunk of the shared blocks without
+ * locking.
+ *
+ * @param allocator Pointer to the allocator structure to initialize.
+ *
+ * @note free_all must not be called while other threads are allocating from
+ *       the same allocator. The allocator must not be NULL.
+ */
+void
+wmem_block_fast_mt_allocator_init(wmem_allocator_t *allocator);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WMEM_ALLOCATOR_BLOCK_FAST_MT_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,459 @@
+/* wmem_bench.c
+ * Wireshark Memory Manager Benchmarks
+ *
+ * Times the wmem allocators and containers under the allocation patterns
+ * dissection produces, one iteration at a time, and reports percentiles
+ * of the iteration times along with the resident set size.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "wmem.h"
+#include "wmem_allocator.h"
+#include "wmem_allocator_block.h"
+#include "wmem_allocator_block_fast.h"
+#include "wmem_allocator_simple.h"
+#include "wmem_allocator_strict.h"
+
+#include <wsutil/app_mem_usage.h>
+#include <wsutil/time_util.h>
+#include <wsutil/ws_getopt.h>
+
+#define DEFAULT_ITERATIONS  100000
+
+/* How many iterations pass between resident set size samples. */
+#define RSS_SAMPLE_INTERVAL 1024
+
+/* Long-lived tables grow to this many entries and then churn. */
+#define MAP_CHURN_SIZE      4096
+
+typedef struct {
+    const char            *name;
+    wmem_allocator_type_t  type;
+} bench_allocator_t;
+
+static const bench_allocator_t bench_allocators[] = {
+    { "simple",     WMEM_ALLOCATOR_SIMPLE },
+    { "block",      WMEM_ALLOCATOR_BLOCK },
+    { "block_fast", WMEM_ALLOCATOR_BLOCK_FAST },
+    { "strict",     WMEM_ALLOCATOR_STRICT },
+};
+
+/* State shared by the iterations of one benchmark run. */
+typedef struct {
+    wmem_allocator_t *allocator;
+    uint32_t          rand_state;
+    wmem_map_t       *map;
+    wmem_tree_t      *tree;
+    uint32_t          next_key;
+    uint32_t          oldest_key;
+} bench_state_t;
+
+typedef struct {
+    const char  *name;
+    const char  *description;
+    /* Whether each iteration ends with wmem_free_all(), as packet scope does. */
+    bool         free_all;
+    void       (*setup)(bench_state_t *state);
+    void       (*iterate)(bench_state_t *state);
+} bench_t;
+
+/* A local copy of wmem_allocator_new that ignores the
+ * WIRESHARK_DEBUG_WMEM_OVERRIDE variable so that every run gets the
+ * allocator type it asked for */
+static wmem_allocator_t *
+wmem_allocator_force_new(const wmem_allocator_type_t type)
+{
+    wmem_allocator_t *allocator;
+
+    allocator = wmem_new(NULL, wmem_allocator_t);
+    allocator->type = type;
+    allocator->callbacks = NULL;
+    allocator->in_scope = true;
+
+    switch (type) {
+        case WMEM_ALLOCATOR_SIMPLE:
+            wmem_simple_allocator_init(allocator);
+            break;
+        case WMEM_ALLOCATOR_BLOCK:
+            wmem_block_allocator_init(allocator);
+            break;
+        case WMEM_ALLOCATOR_BLOCK_FAST:
+            wmem_block_fast_allocator_init(allocator);
+            break;
+        case WMEM_ALLOCATOR_STRICT:
+            wmem_strict_allocator_init(allocator);
+            break;
+        default:
+            g_assert_not_reached();
+            return NULL;
+    };
+
+    return allocator;
+}
+
+/* A small, fixed pseudo-random sequence, so that runs are repeatable. */
+static inline uint32_t
+bench_rand(bench_state_t *state)
+{
+    uint32_t x = state->rand_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state->rand_state = x;
+    return x;
+}
+
+static size_t
+current_rss(void)
+{
+    const char *name;
+    size_t      value;
+
+    for (unsigned i = 0; (name = memory_usage_get(i, &value)) != NULL; i++) {
+        if (strcmp(name, "RSS") == 0) {
+            return value;
+        }
+    }
+    return 0;
+}
+
+/* BENCHMARKS */
+
+/* The many small allocations of a packet's tree items, strings and
+ * per-layer structures. */
+static void
+bench_small_iterate(bench_state_t *state)
+{
+    for (unsigned i = 0; i < 64; i++) {
+        size_t  len = 8 + (bench_rand(state) & 0x78);
+        char   *ptr = (char *)wmem_alloc(state->allocator, len);
+
+        ptr[0] = (char)i;
+    }
+}
+
+/* Small allocations with the occasional large buffer and reallocation,
+ * as when a dissector copies or decompresses data. */
+static void
+bench_mixed_iterate(bench_state_t *state)
+{
+    char   *buf;
+    size_t  len = 256;
+
+    for (unsigned i = 0; i < 48; i++) {
+        char *ptr = (char *)wmem_alloc(state->allocator, 8 + (bench_rand(state) & 0x78));
+
+        ptr[0] = (char)i;
+    }
+
+    buf = (char *)wmem_alloc(state->allocator, len);
+    while (len < 8192) {
+        buf[len - 1] = 0;
+        len *= 2;
+        buf = (char *)wmem_realloc(state->allocator, buf, len);
+    }
+    buf[len - 1] = 0;
+
+    for (unsigned i = 0; i < 16; i++) {
+        wmem_free(state->allocator, wmem_alloc(state->allocator, 16 + (bench_rand(state) & 0xf0)));
+    }
+}
+
+/* Building up item labels and column strings. */
+static void
+bench_strbuf_iterate(bench_state_t *state)
+{
+    for (unsigned i = 0; i < 8; i++) {
+        wmem_strbuf_t *strbuf = wmem_strbuf_new(state->allocator, "");
+
+        for (unsigned j = 0; j < 16; j++) {
+            wmem_strbuf_append_printf(strbuf, "%s: %u, ", "Sequence Number", bench_rand(state));
+        }
+        wmem_strbuf_append(strbuf, "Flags: 0x018 (PSH, ACK)");
+        wmem_strbuf_finalize(strbuf);
+    }
+}
+
+/* Growing arrays one element at a time, as for lists of options. */
+static void
+bench_array_iterate(bench_state_t *state)
+{
+    wmem_array_t *array = wmem_array_new(state->allocator, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < 256; i++) {
+        wmem_array_append_one(array, i);
+    }
+}
+
+static void
+bench_map_setup(bench_state_t *state)
+{
+    state->map = wmem_map_new(state->allocator, g_direct_hash, g_direct_equal);
+}
+
+static void
+bench_map_flat_setup(bench_state_t *state)
+{
+    state->map = wmem_map_new_flat(state->allocator, g_direct_hash, g_direct_equal);
+}
+
+/* A file scope table of conversations or transactions: each packet adds
+ * a few entries, looks up several and, once the table is full, the
+ * oldest entries go away. */
+static void
+bench_map_iterate(bench_state_t *state)
+{
+    for (unsigned i = 0; i < 4; i++) {
+        uint32_t *value = wmem_new(state->allocator, uint32_t);
+
+        *value = state->next_key;
+        wmem_map_insert(state->map, GUINT_TO_POINTER(state->next_key + 1), value);
+        state->next_key++;
+    }
+
+    for (unsigned i = 0; i < 16; i++) {
+        uint32_t key = state->oldest_key + bench_rand(state) % (state->next_key - state->oldest_key);
+
+        if (wmem_map_lookup(state->map, GUINT_TO_POINTER(key + 1)) == NULL) {
+            g_assert_not_reached();
+        }
+    }
+
+    while (state->next_key - state->oldest_key > MAP_CHURN_SIZE) {
+        wmem_free(state->allocator, wmem_map_remove(state->map, GUINT_TO_POINTER(state->oldest_key + 1)));
+        state->oldest_key++;
+    }
+}
+
+static void
+bench_tree_setup(bench_state_t *state)
+{
+    state->tree = wmem_tree_new(state->allocator);
+}
+
+/* Reassembly and sequence analysis: segments keyed by (increasing, gappy)
+ * sequence number, looked up by the offset they contain. */
+static void
+bench_tree_iterate(bench_state_t *state)
+{
+    for (unsigned i = 0; i < 4; i++) {
+        state->next_key += 512 + (bench_rand(state) & 0x3ff);
+        if (state->oldest_key == 0) {
+            state->oldest_key = state->next_key;
+        }
+        wmem_tree_insert32(state->tree, state->next_key, GUINT_TO_POINTER(state->next_key + 1));
+    }
+
+    for (unsigned i = 0; i < 16; i++) {
+        uint32_t key = bench_rand(state) % (state->next_key + 1);
+
+        if (key >= state->oldest_key && wmem_tree_lookup32_le(state->tree, key) == NULL) {
+            g_assert_not_reached();
+        }
+    }
+}
+
+static const bench_t benchmarks[] = {
+    { "small",    "64 small allocations, then free all", true, NULL, bench_small_iterate },
+    { "mixed",    "small allocations, frees and a growing buffer, then free all", true, NULL, bench_mixed_iterate },
+    { "strbuf",   "8 strings of 16 formatted appends, then free all", true, NULL, bench_strbuf_iterate },
+    { "array",    "256 appends to an array, then free all", true, NULL, bench_array_iterate },
+    { "map",      "4 inserts, 16 lookups and churn in a chained map", false, bench_map_setup, bench_map_iterate },
+    { "map_flat", "4 inserts, 16 lookups and churn in a flat map", false, bench_map_flat_setup, bench_map_iterate },
+    { "tree",     "4 inserts and 16 less-or-equal lookups in a tree", false, bench_tree_setup, bench_tree_iterate },
+};
+
+/* HARNESS */
+
+static int
+compare_uint64(const void *a, const void *b)
+{
+    uint64_t l = *(const uint64_t *)a;
+    uint64_t r = *(const uint64_t *)b;
+
+    return l < r ? -1 : l > r;
+}
+
+static uint64_t
+percentile(const uint64_t *sorted, unsigned count, unsigned pct)
+{
+    return sorted[(uint64_t)(count - 1) * pct / 100];
+}
+
+static void
+run_bench(const bench_t *bench, const bench_allocator_t *alloc, unsigned iterations,
+          uint64_t *samples)
+{
+    bench_state_t state;
+    uint64_t      start, end, total = 0;
+    size_t        rss_start, rss_peak, rss;
+
+    memset(&state, 0, sizeof(state));
+    state.allocator = wmem_allocator_force_new(alloc->type);
+    state.rand_state = 2463534242U;
+
+    rss_start = rss_peak = current_rss();
+    if (bench->setup) {
+        bench->setup(&state);
+    }
+
+    for (unsigned i = 0; i < iterations; i++) {
+        start = ws_monotonic_ns();
+        bench->iterate(&state);
+        if (bench->free_all) {
+            wmem_free_all(state.allocator);
+        }
+        end = ws_monotonic_ns();
+        samples[i] = end - start;
+        total += samples[i];
+
+        if (i % RSS_SAMPLE_INTERVAL == RSS_SAMPLE_INTERVAL - 1) {
+            rss = current_rss();
+            if (rss > rss_peak) {
+                rss_peak = rss;
+            }
+        }
+    }
+    rss = current_rss();
+    if (rss > rss_peak) {
+        rss_peak = rss;
+    }
+
+    wmem_destroy_allocator(state.allocator);
+
+    qsort(samples, iterations, sizeof(*samples), compare_uint64);
+    printf("%-9s %-11s %9u %9.0f %9" PRIu64 " %9" PRIu64 " %9" PRIu64 " %9" PRIu64 " %10zu %10zu\n",
+           bench->name, alloc->name, iterations,
+           (double)total / iterations,
+           percentile(samples, iterations, 50),
+           percentile(samples, iterations, 90),
+           percentile(samples, iterations, 99),
+           samples[iterations - 1],
+           rss_peak / 1024,
+           (rss_peak - rss_start) / 1024);
+    fflush(stdout);
+}
+
+static void
+print_usage(FILE *fp)
+{
+    fprintf(fp, "Usage: wmem_bench [-n <iterations>] [-b <benchmark>] [-a <allocator>]\n");
+    fprintf(fp, "\n");
+    fprintf(fp, "  -n <iterations>  iterations per run (default: %d)\n", DEFAULT_ITERATIONS);
+    fprintf(fp, "  -b <benchmark>   only run this benchmark; may be repeated\n");
+    fprintf(fp, "  -a <allocator>   only use this allocator; may be repeated\n");
+    fprintf(fp, "  -h               display this help and exit\n");
+    fprintf(fp, "\n");
+    fprintf(fp, "Benchmarks:\n");
+    for (unsigned i = 0; i < G_N_ELEMENTS(benchmarks); i++) {
+        fprintf(fp, "  %-9s %s\n", benchmarks[i].name, benchmarks[i].description);
+    }
+    fprintf(fp, "\n");
+    fprintf(fp, "Allocators:");
+    for (unsigned i = 0; i < G_N_ELEMENTS(bench_allocators); i++) {
+        fprintf(fp, " %s", bench_allocators[i].name);
+    }
+    fprintf(fp, "\n\n");
+    fprintf(fp, "Times are per iteration, in nanoseconds. The resident set size\n");
+    fprintf(fp, "(RSS) is the peak seen during the run and its growth over the run,\n");
+    fprintf(fp, "in KiB, where the platform reports it.\n");
+}
+
+static bool
+selected(GPtrArray *names, const char *name)
+{
+    if (names->len == 0) {
+        return true;
+    }
+    for (unsigned i = 0; i < names->len; i++) {
+        if (strcmp((const char *)g_ptr_array_index(names, i), name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int
+main(int argc, char **argv)
+{
+    GPtrArray *bench_names = g_ptr_array_new();
+    GPtrArray *alloc_names = g_ptr_array_new();
+    unsigned   iterations = DEFAULT_ITERATIONS;
+    uint64_t  *samples;
+    int        opt;
+
+    while ((opt = ws_getopt(argc, argv, "a:b:hn:")) != -1) {
+        switch (opt) {
+            case 'a':
+                g_ptr_array_add(alloc_names, ws_optarg);
+                break;
+            case 'b':
+                g_ptr_array_add(bench_names, ws_optarg);
+                break;
+            case 'n':
+                iterations = (unsigned)strtoul(ws_optarg, NULL, 10);
+                if (iterations == 0) {
+                    fprintf(stderr, "wmem_bench: The number of iterations must be positive.\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                print_usage(stdout);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(stderr);
+                return EXIT_FAILURE;
+        }
+    }
+
+    wmem_init();
+
+    samples = g_new(uint64_t, iterations);
+    printf("%-9s %-11s %9s %9s %9s %9s %9s %9s %10s %10s\n",
+           "benchmark", "allocator", "iters", "mean", "p50", "p90", "p99", "max",
+           "rss_kb", "rss_growth");
+    for (unsigned i = 0; i < G_N_ELEMENTS(benchmarks); i++) {
+        if (!selected(bench_names, benchmarks[i].name)) {
+            continue;
+        }
+        for (unsigned j = 0; j < G_N_ELEMENTS(bench_allocators); j++) {
+            if (!selected(alloc_names, bench_allocators[j].name)) {
+                continue;
+            }
+            run_bench(&benchmarks[i], &bench_allocators[j], iterations, samples);
+        }
+    }
+    g_free(samples);
+
+    wmem_cleanup();
+
+    g_ptr_array_free(bench_names, true);
+    g_ptr_array_free(alloc_names, true);
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -21,6 +21,7 @@
 #include "wmem_allocator_simple.h"
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_block_fast.h"
+#include "wmem_allocator_block_fast_mt.h"
 #include "wmem_allocator_strict.h"
 
 /* Set according to the WIRESHARK_DEBUG_WMEM_OVERRIDE environment variable in
@@ -41,6 +42,9 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
+    allocator->allocated += size;
+    allocator->in_use += size;
+
     return allocator->walloc(allocator->private_data, size);
 }
 
@@ -93,6 +97,9 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
 
     ws_assert(allocator->in_scope);
 
+    allocator->allocated += size;
+    allocator->in_use += size;
+
     return allocator->wrealloc(allocator->private_data, ptr, size);
 }
 
@@ -102,6 +109,7 @@ wmem_free_all_real(wmem_allocator_t *allocator, bool final)
     wmem_call_callbacks(allocator,
             final ? WMEM_CB_DESTROY_EVENT : WMEM_CB_FREE_EVENT);
     allocator->free_all(allocator->private_data);
+    allocator->in_use = 0;
 }
 
 void
@@ -116,6 +124,18 @@ wmem_gc(wmem_allocator_t *allocator)
     allocator->gc(allocator->private_data);
 }
 
+uint64_t
+wmem_allocated_bytes(wmem_allocator_t *allocator)
+{
+    return allocator->allocated;
+}
+
+uint64_t
+wmem_in_use_bytes(wmem_allocator_t *allocator)
+{
+    return allocator->in_use;
+}
+
 void
 wmem_destroy_allocator(wmem_allocator_t *allocator)
 {
@@ -142,6 +162,8 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator->type      = real_type;
     allocator->callbacks = NULL;
     allocator->in_scope  = true;
+    allocator->allocated = 0;
+    allocator->in_use    = 0;
 
     switch (real_type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -153,6 +175,9 @@ wmem_allocator_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_BLOCK_FAST:
             wmem_block_fast_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_BLOCK_FAST_MT:
+            wmem_block_fast_mt_allocator_init(allocator);
+            break;
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
@@ -180,7 +205,10 @@ wmem_init(void)
     }
     else {
         do_override = true;
-        if (strncmp(override_env, "simple", strlen("simple")) == 0) {
+        if (strncmp(override_env, "block_fast_mt", strlen("block_fast_mt")) == 0) {
+            override_type = WMEM_ALLOCATOR_BLOCK_FAST_MT;
+        }
+        else if (strncmp(override_env, "simple", strlen("simple")) == 0) {
             override_type = WMEM_ALLOCATOR_SIMPLE;
         }
         else if (strncmp(override_env, "block", strlen("block")) == 0) {
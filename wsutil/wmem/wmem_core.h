@@ -57,11 +57,16 @@ typedef enum _wmem_allocator_type_t {
                 memory usage via things like canaries and scrubbing freed
                 memory. Valgrind is the better choice on platforms that support
                 it. */
-    WMEM_ALLOCATOR_BLOCK_FAST /**< A block allocator like WMEM_ALLOCATOR_BLOCK
+    WMEM_ALLOCATOR_BLOCK_FAST, /**< A block allocator like WMEM_ALLOCATOR_BLOCK
                 but even faster by tracking absolutely minimal metadata and
                 making 'free' a no-op. Useful only for very short-lived scopes
                 where there's no reason to free individual allocations because
                 the next free_all is always just around the corner. */
+    WMEM_ALLOCATOR_BLOCK_FAST_MT /**< Like WMEM_ALLOCATOR_BLOCK_FAST, but
+                safe to allocate from in several threads at once. Each thread
+                allocates without locking from its own chunk of the shared
+                blocks, and free_all is as cheap as for a single thread. The
+                free_all itself must not race with allocations. */
 } wmem_allocator_type_t;
 
 /**
@@ -208,6 +213,38 @@ WS_DLL_PUBLIC
 void
 wmem_gc(wmem_allocator_t *allocator);
 
+/**
+ * @brief Returns the number of bytes requested from an allocator.
+ *
+ * The count covers every wmem_alloc() and wmem_realloc() call made on the
+ * allocator since it was created; it is not reduced by frees. Callers can
+ * take the difference of two readings to measure what a piece of code
+ * allocated.
+ *
+ * @param allocator The allocator to query.
+ * @return The running total of requested bytes.
+ */
+WS_DLL_PUBLIC
+uint64_t
+wmem_allocated_bytes(wmem_allocator_t *allocator);
+
+/**
+ * @brief Returns the number of bytes requested from an allocator since it
+ * was last emptied.
+ *
+ * This is what wmem_allocated_bytes() has counted since the last
+ * wmem_free_all() (or wmem_leave_scope()). Individual wmem_free() calls
+ * don't reduce it, and wmem_realloc() counts the new size in full, so it
+ * is an upper bound on the live bytes rather than an exact figure; for
+ * scopes, which are mostly emptied all at once, the two are close.
+ *
+ * @param allocator The allocator to query.
+ * @return The bytes requested since the allocator was last emptied.
+ */
+WS_DLL_PUBLIC
+uint64_t
+wmem_in_use_bytes(wmem_allocator_t *allocator);
+
 /**
  * @brief Destroy the given allocator, freeing all memory allocated in it.
  *
@@ -10,8 +10,18 @@
  */
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WMEM_MAP_FLAT_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define WMEM_MAP_FLAT_NEON
+#endif
+
 #ifdef HAVE_XXHASH
 #include <xxhash.h>
 #endif /* HAVE_XXHASH */
@@ -57,6 +67,13 @@ typedef struct _wmem_map_item_t {
     uint32_t hash;
 } wmem_map_item_t;
 
+/* A slot in the table of a flat (open addressing) map. */
+typedef struct _wmem_map_slot_t {
+    const void *key;
+    void *value;
+    uint32_t hash;
+} wmem_map_slot_t;
+
 struct _wmem_map_t {
     /* Number of items stored. */
     size_t count;
@@ -85,6 +102,16 @@ struct _wmem_map_t {
      */
     wmem_stack_t *deleted_items;
 
+    /* Flat maps (see wmem_map_new_flat) use open addressing instead of the
+     * table, items and deleted_items above: each slot has a control byte,
+     * which is FLAT_EMPTY, FLAT_DELETED or 7 bits of the slot's hash, and
+     * lookups compare a whole group of control bytes at once. */
+    bool flat;
+    uint8_t *ctrl;
+    wmem_map_slot_t *slots;
+    /* Number of FLAT_DELETED slots. */
+    size_t tombstones;
+
     GHashFunc  hash_func;
     GEqualFunc eql_func;
 
@@ -153,6 +180,10 @@ wmem_map_new(wmem_allocator_t *allocator,
     map->items = NULL;
     map->next_item = NULL;
     map->deleted_items = wmem_stack_new(allocator);
+    map->flat = false;
+    map->ctrl = NULL;
+    map->slots = NULL;
+    map->tombstones = 0;
 
     // The first callback ID wmem_register_callback assigns is 1, so
     // 0 means unused.
@@ -172,6 +203,9 @@ wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     map->table = NULL;
     map->items = NULL;
     map->next_item = NULL;
+    map->ctrl = NULL;
+    map->slots = NULL;
+    map->tombstones = 0;
     while (wmem_stack_count(map->deleted_items))
         wmem_stack_pop(map->deleted_items);
 
@@ -202,6 +236,10 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     map->items = NULL;
     map->next_item = NULL;
     map->deleted_items = wmem_stack_new(metadata_scope);
+    map->flat = false;
+    map->ctrl = NULL;
+    map->slots = NULL;
+    map->tombstones = 0;
 
     map->metadata_scope_cb_id = wmem_register_callback(metadata_scope, wmem_map_destroy_cb, map);
     map->data_scope_cb_id  = wmem_register_callback(data_scope, wmem_map_reset_cb, map);
@@ -263,6 +301,308 @@ wmem_map_grow(wmem_map_t *map, unsigned new_capacity)
     wmem_free(map->data_allocator, old_table);
 }
 
+wmem_map_t *
+wmem_map_new_flat(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new(allocator, hash_func, eql_func);
+    map->flat = true;
+
+    return map;
+}
+
+wmem_map_t *
+wmem_map_new_flat_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new_autoreset(metadata_scope, data_scope, hash_func, eql_func);
+    map->flat = true;
+
+    return map;
+}
+
+/* Flat maps: open addressing in the style of the "Swiss table". The slots
+ * are split into groups of FLAT_GROUP_SIZE, and the control bytes of a group
+ * are compared against 7 bits of the wanted hash in one go, so a lookup
+ * usually touches one group of control bytes and one slot, with no pointer
+ * chasing. Groups are probed triangularly, which visits every group because
+ * the number of groups is a power of two. */
+#define FLAT_GROUP_BITS 4
+#define FLAT_GROUP_SIZE (1 << FLAT_GROUP_BITS)
+
+/* Control bytes. Full slots have the top bit clear. */
+#define FLAT_EMPTY   0x80
+#define FLAT_DELETED 0xFE
+
+/* The group is chosen by the top bits of the hash; the bits stored in the
+ * control byte come from a second multiplication so that they are not just
+ * the next few bits down, which would be nearly constant within a group. */
+#define FLAT_H2(HASH) ((uint8_t)(((uint32_t)(HASH) * 0x9E3779B1U) >> 25))
+
+/* Maximum number of full and deleted slots: 7/8 of the capacity, so that
+ * every probe sequence ends at an empty slot. */
+#define FLAT_MAX_LOAD(MAP) (CAPACITY(MAP) - (CAPACITY(MAP) >> 3))
+
+#define FLAT_NOT_FOUND SIZE_MAX
+
+#ifdef WMEM_MAP_FLAT_NEON
+static inline uint32_t
+flat_neon_movemask(uint8x16_t cmp)
+{
+    static const uint8_t bits[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+    };
+    uint8x16_t masked = vandq_u8(cmp, vld1q_u8(bits));
+
+    return vaddv_u8(vget_low_u8(masked)) |
+        ((uint32_t)vaddv_u8(vget_high_u8(masked)) << 8);
+}
+#endif
+
+/* Returns a bitmask of the control bytes in the group equal to val. */
+static inline uint32_t
+flat_match(const uint8_t *group, uint8_t val)
+{
+#if defined(WMEM_MAP_FLAT_SSE2)
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)val)));
+#elif defined(WMEM_MAP_FLAT_NEON)
+    return flat_neon_movemask(vceqq_u8(vld1q_u8(group), vdupq_n_u8(val)));
+#else
+    uint32_t mask = 0;
+    for (unsigned i = 0; i < FLAT_GROUP_SIZE; i++) {
+        if (group[i] == val)
+            mask |= 1U << i;
+    }
+    return mask;
+#endif
+}
+
+/* Returns a bitmask of the empty or deleted control bytes in the group. */
+static inline uint32_t
+flat_match_free(const uint8_t *group)
+{
+#if defined(WMEM_MAP_FLAT_SSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#elif defined(WMEM_MAP_FLAT_NEON)
+    return flat_neon_movemask(vtstq_u8(vld1q_u8(group), vdupq_n_u8(0x80)));
+#else
+    uint32_t mask = 0;
+    for (unsigned i = 0; i < FLAT_GROUP_SIZE; i++) {
+        if (group[i] & 0x80)
+            mask |= 1U << i;
+    }
+    return mask;
+#endif
+}
+
+static inline size_t
+flat_first_group(const wmem_map_t *map, uint32_t hash)
+{
+    unsigned group_bits = map->capacity - FLAT_GROUP_BITS;
+
+    return group_bits ? (size_t)(hash >> (32 - group_bits)) : 0;
+}
+
+static void
+flat_init_table(wmem_map_t *map)
+{
+    map->count      = 0;
+    map->tombstones = 0;
+    map->capacity   = map->min_capacity;
+    map->ctrl       = wmem_alloc_array(map->data_allocator, uint8_t, CAPACITY(map));
+    memset(map->ctrl, FLAT_EMPTY, CAPACITY(map));
+    /* We do *not* need to 0 these, the control bytes say which are used. */
+    map->slots      = wmem_alloc_array(map->data_allocator, wmem_map_slot_t, CAPACITY(map));
+}
+
+static size_t
+flat_find(const wmem_map_t *map, const void *key, uint32_t hash)
+{
+    size_t   group_mask = (CAPACITY(map) >> FLAT_GROUP_BITS) - 1;
+    size_t   group = flat_first_group(map, hash);
+    uint8_t  h2 = FLAT_H2(hash);
+    const uint8_t *ctrl;
+    uint32_t match;
+    size_t   i, step;
+
+    for (step = 1; step <= group_mask + 1; step++) {
+        ctrl = map->ctrl + (group << FLAT_GROUP_BITS);
+        for (match = flat_match(ctrl, h2); match; match &= match - 1) {
+            i = (group << FLAT_GROUP_BITS) + ws_ctz(match);
+            if ((hash == map->slots[i].hash) && map->eql_func(key, map->slots[i].key)) {
+                return i;
+            }
+        }
+        if (flat_match(ctrl, FLAT_EMPTY)) {
+            /* The key would have been inserted here or earlier. */
+            return FLAT_NOT_FOUND;
+        }
+        group = (group + step) & group_mask;
+    }
+
+    return FLAT_NOT_FOUND;
+}
+
+/* Finds the first empty or deleted slot on the probe sequence of the hash.
+ * There always is one, since the load is limited to FLAT_MAX_LOAD. */
+static size_t
+flat_find_free(const wmem_map_t *map, uint32_t hash)
+{
+    size_t   group_mask = (CAPACITY(map) >> FLAT_GROUP_BITS) - 1;
+    size_t   group = flat_first_group(map, hash);
+    uint32_t match;
+    size_t   step;
+
+    for (step = 1; ; step++) {
+        match = flat_match_free(map->ctrl + (group << FLAT_GROUP_BITS));
+        if (match) {
+            return (group << FLAT_GROUP_BITS) + ws_ctz(match);
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+static void
+flat_resize(wmem_map_t *map, unsigned new_capacity)
+{
+    uint8_t         *old_ctrl;
+    wmem_map_slot_t *old_slots;
+    size_t           old_cap, i, j;
+
+    if (new_capacity > 32) {
+        // Run time error
+        ws_error("wmem_map does not support more than 2^32 items");
+        return;
+    }
+
+    old_ctrl  = map->ctrl;
+    old_slots = map->slots;
+    old_cap   = CAPACITY(map);
+
+    /* This is also used at the same capacity, to clear out tombstones. */
+    map->capacity   = new_capacity;
+    map->tombstones = 0;
+    map->ctrl       = wmem_alloc_array(map->data_allocator, uint8_t, CAPACITY(map));
+    memset(map->ctrl, FLAT_EMPTY, CAPACITY(map));
+    map->slots      = wmem_alloc_array(map->data_allocator, wmem_map_slot_t, CAPACITY(map));
+
+    for (i = 0; i < old_cap; i++) {
+        if (old_ctrl[i] & 0x80)
+            continue;
+        j = flat_find_free(map, old_slots[i].hash);
+        map->ctrl[j]  = old_ctrl[i];
+        map->slots[j] = old_slots[i];
+    }
+
+    wmem_free(map->data_allocator, old_ctrl);
+    wmem_free(map->data_allocator, old_slots);
+}
+
+static void
+flat_erase(wmem_map_t *map, size_t i)
+{
+    /* If the group still has an empty slot then no probe sequence has ever
+     * gone past it, so the slot can be made empty again. Otherwise leave a
+     * tombstone so that lookups keep probing. */
+    if (flat_match(map->ctrl + (i & ~((size_t)FLAT_GROUP_SIZE - 1)), FLAT_EMPTY)) {
+        map->ctrl[i] = FLAT_EMPTY;
+    } else {
+        map->ctrl[i] = FLAT_DELETED;
+        map->tombstones++;
+    }
+    map->count--;
+}
+
+static void *
+flat_insert(wmem_map_t *map, const void *key, void *value)
+{
+    void   *old_val;
+    size_t  i;
+
+    /* Make sure we have a table */
+    if (map->ctrl == NULL) {
+        flat_init_table(map);
+    }
+
+    uint32_t hash = HASH(map, key);
+    i = flat_find(map, key, hash);
+    if (i != FLAT_NOT_FOUND) {
+        /* replace and return old value for this key */
+        old_val = map->slots[i].value;
+        map->slots[i].value = value;
+        return old_val;
+    }
+
+    if (map->count + map->tombstones >= FLAT_MAX_LOAD(map)) {
+        /* Grow if mostly full of live items, otherwise just rehash to get
+         * rid of the tombstones. */
+        flat_resize(map, map->count >= (CAPACITY(map) >> 1) ? map->capacity + 1 : map->capacity);
+    }
+
+    i = flat_find_free(map, hash);
+    if (map->ctrl[i] == FLAT_DELETED) {
+        map->tombstones--;
+    }
+    map->ctrl[i]        = FLAT_H2(hash);
+    map->slots[i].key   = key;
+    map->slots[i].value = value;
+    map->slots[i].hash  = hash;
+
+    map->count++;
+
+    /* no previous entry, return NULL */
+    return NULL;
+}
+
+static inline const wmem_map_slot_t *
+flat_lookup_hash(const wmem_map_t *map, const void *key, uint32_t hash)
+{
+    size_t i;
+
+    if (map->ctrl == NULL) {
+        return NULL;
+    }
+
+    i = flat_find(map, key, hash);
+    return i == FLAT_NOT_FOUND ? NULL : &map->slots[i];
+}
+
+static inline const wmem_map_slot_t *
+flat_lookup(const wmem_map_t *map, const void *key)
+{
+    if (map->ctrl == NULL) {
+        return NULL;
+    }
+
+    return flat_lookup_hash(map, key, HASH(map, key));
+}
+
+static bool
+flat_remove(wmem_map_t *map, const void *key, void **value)
+{
+    size_t i;
+
+    if (map->ctrl == NULL) {
+        return false;
+    }
+
+    i = flat_find(map, key, HASH(map, key));
+    if (i == FLAT_NOT_FOUND) {
+        return false;
+    }
+
+    if (value) {
+        *value = map->slots[i].value;
+    }
+    flat_erase(map, i);
+    return true;
+}
+
 void
 wmem_map_destroy(wmem_map_t *map, bool free_keys _U_, bool free_values _U_)
 {
@@ -283,6 +623,8 @@ wmem_map_destroy(wmem_map_t *map, bool free_keys _U_, bool free_values _U_)
         wmem_unregister_callback(map->data_allocator, map->data_scope_cb_id);
     }
     wmem_free(map->data_allocator, map->table);
+    wmem_free(map->data_allocator, map->ctrl);
+    wmem_free(map->data_allocator, map->slots);
     // The arrays of items created before the last time the map grew the map
     // are orphaned and get freed when the data_allocator does.
     wmem_free(map->data_allocator, map->items);
@@ -295,6 +637,10 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
     wmem_map_item_t **item;
     void *old_val;
 
+    if (map->flat) {
+        return flat_insert(map, key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         wmem_map_init_table(map);
@@ -344,6 +690,10 @@ wmem_map_contains(const wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map && map->flat) {
+        return flat_lookup(map, key) != NULL;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return false;
@@ -369,6 +719,11 @@ wmem_map_lookup(const wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map && map->flat) {
+        const wmem_map_slot_t *slot = flat_lookup(map, key);
+        return slot ? slot->value : NULL;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return NULL;
@@ -389,11 +744,54 @@ wmem_map_lookup(const wmem_map_t *map, const void *key)
     return NULL;
 }
 
+void *
+wmem_map_lookup_hash(const wmem_map_t *map, const void *key, unsigned key_hash)
+{
+    wmem_map_item_t *item;
+    uint32_t hash = (uint32_t)(key_hash * x);
+
+    if (map && map->flat) {
+        const wmem_map_slot_t *slot = flat_lookup_hash(map, key, hash);
+        return slot ? slot->value : NULL;
+    }
+
+    /* Make sure we have map and a table */
+    if (map == NULL || map->table == NULL) {
+        return NULL;
+    }
+
+    item = map->table[MASK_HASH(map, hash)];
+
+    /* scan list of items in this slot for the correct value */
+    while (item) {
+        if ((hash == item->hash) && map->eql_func(key, item->key)) {
+            return item->value;
+        }
+        item = item->next;
+    }
+
+    return NULL;
+}
+
 bool
 wmem_map_lookup_extended(const wmem_map_t *map, const void *key, const void **orig_key, void **value)
 {
     wmem_map_item_t *item;
 
+    if (map && map->flat) {
+        const wmem_map_slot_t *slot = flat_lookup(map, key);
+        if (slot == NULL) {
+            return false;
+        }
+        if (orig_key) {
+            *orig_key = slot->key;
+        }
+        if (value) {
+            *value = slot->value;
+        }
+        return true;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return false;
@@ -426,6 +824,12 @@ wmem_map_remove(wmem_map_t *map, const void *key)
     wmem_map_item_t **item, *tmp;
     void *value;
 
+    if (map && map->flat) {
+        value = NULL;
+        flat_remove(map, key, &value);
+        return value;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return NULL;
@@ -458,6 +862,10 @@ wmem_map_steal(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t **item, *tmp;
 
+    if (map && map->flat) {
+        return flat_remove(map, key, NULL);
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return false;
@@ -491,7 +899,14 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, const wmem_map_t *map)
     wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
-    if (map->table != NULL) {
+    if (map->flat) {
+        if (map->ctrl != NULL) {
+            for (i = 0; i < CAPACITY(map); i++) {
+                if (!(map->ctrl[i] & 0x80))
+                    wmem_list_prepend(list, (void*)map->slots[i].key);
+            }
+        }
+    } else if (map->table != NULL) {
         capacity = CAPACITY(map);
 
         /* copy all the elements into the list over from table */
@@ -513,6 +928,17 @@ wmem_map_foreach(const wmem_map_t *map, GHFunc foreach_func, void * user_data)
     wmem_map_item_t *cur;
     unsigned i;
 
+    if (map && map->flat) {
+        if (map->ctrl == NULL) {
+            return;
+        }
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (!(map->ctrl[i] & 0x80))
+                foreach_func((void *)map->slots[i].key, map->slots[i].value, user_data);
+        }
+        return;
+    }
+
     /* Make sure we have a table */
     if (map == NULL || map->table == NULL) {
         return;
@@ -533,6 +959,19 @@ wmem_map_find(const wmem_map_t *map, GHRFunc foreach_func, void * user_data)
     wmem_map_item_t **item;
     unsigned i;
 
+    if (map && map->flat) {
+        if (map->ctrl == NULL) {
+            return NULL;
+        }
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (!(map->ctrl[i] & 0x80) &&
+                    foreach_func((void *)map->slots[i].key, map->slots[i].value, user_data)) {
+                return map->slots[i].value;
+            }
+        }
+        return NULL;
+    }
+
     /* Make sure we have a table */
     if (map == NULL || map->table == NULL) {
         return 0;
@@ -557,6 +996,20 @@ wmem_map_foreach_remove(wmem_map_t *map, GHRFunc foreach_func, void * user_data)
     wmem_map_item_t **item, *tmp;
     unsigned i, deleted = 0;
 
+    if (map && map->flat) {
+        if (map->ctrl == NULL) {
+            return 0;
+        }
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (!(map->ctrl[i] & 0x80) &&
+                    foreach_func((void *)map->slots[i].key, map->slots[i].value, user_data)) {
+                flat_erase(map, i);
+                deleted++;
+            }
+        }
+        return deleted;
+    }
+
     /* Make sure we have a table */
     if (map == NULL || map->table == NULL) {
         return 0;
@@ -595,7 +1048,12 @@ wmem_map_reserve(wmem_map_t *map, uint64_t capacity)
 
     map->min_capacity = MAX(map->min_capacity, WMEM_MAP_DEFAULT_CAPACITY);
 
-    if (map->table) {
+    if (map->flat) {
+        /* Growing a flat map rehashes it, so there's no cost beyond that. */
+        if (map->ctrl && map->min_capacity > map->capacity) {
+            flat_resize(map, map->min_capacity);
+        }
+    } else if (map->table) {
         /* XXX - Should reserving after an item has been inserted be allowed?
          * Either we orphan some items in the old array or have to do a more
          * expensive copy operation.
@@ -95,6 +95,38 @@ wmem_map_t *
 wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
         GHashFunc hash_func, GEqualFunc eql_func);
 
+/**
+ * @brief Creates a flat map with the given allocator scope.
+ *
+ * Behaves exactly like a map from wmem_map_new(), and is used through the
+ * same functions, but stores the items directly in an open addressing table
+ * instead of in per-bucket chains. Lookups compare several slots at once
+ * (with SSE2 or NEON where available) and don't chase pointers, which makes
+ * them faster for large maps that are looked up far more often than they
+ * are changed. Iteration order differs from that of a chained map.
+ *
+ * @param allocator The allocator scope with which to create the map.
+ * @param hash_func The hash function used to place inserted keys.
+ * @param eql_func  The equality function used to compare inserted keys.
+ * @return The newly-allocated map.
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_flat(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func);
+
+/**
+ * @brief Creates a flat map with two allocator scopes.
+ *
+ * The flat equivalent of wmem_map_new_autoreset(); see wmem_map_new_flat().
+ *
+ * @warning This cannot be used with either allocator scope being NULL.
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_flat_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
+        GHashFunc hash_func, GEqualFunc eql_func);
+
 /**
  * @brief Inserts a value into the map.
  *
@@ -129,6 +161,22 @@ WS_DLL_PUBLIC
 void *
 wmem_map_lookup(const wmem_map_t *map, const void *key);
 
+/**
+ * @brief Lookup a value in the map using an already computed hash of the key.
+ *
+ * Useful when the caller can compute the hash of a key more cheaply than the
+ * map's hash function can, e.g. because it has hashed parts of the key
+ * before.
+ *
+ * @param map The map to search in. May be NULL.
+ * @param key The key to lookup.
+ * @param key_hash The value the map's hash function returns for key.
+ * @return The value stored at the key if any, or NULL.
+ */
+WS_DLL_PUBLIC
+void *
+wmem_map_lookup_hash(const wmem_map_t *map, const void *key, unsigned key_hash);
+
 /**
  * @brief Lookup a value in the map, returning the key, value, and a boolean which
  * is true if the key is found.
@@ -16,12 +16,18 @@
 #include <errno.h>
 
 #include "wmem-int.h"
+#include "wmem_miscutl.h"
 #include "wmem_strutl.h"
 
 #include <wsutil/unicode-utils.h>
 
 #define DEFAULT_MINIMUM_SIZE 16
 
+/* Buffers smaller than this double when they grow; larger ones grow by half,
+ * which wastes less of a large allocation for a string that has nearly
+ * stopped growing. */
+#define GEOMETRIC_DOUBLING_LIMIT (64 * 1024)
+
 /* _ROOM accounts for the null-terminator, _RAW_ROOM does not.
  * Some functions need one, some functions need the other. */
 #define WMEM_STRBUF_ROOM(S) ((S)->alloc_size - (S)->len - 1)
@@ -38,6 +44,7 @@ wmem_strbuf_new_sized(wmem_allocator_t *allocator,
     strbuf->allocator = allocator;
     strbuf->len       = 0;
     strbuf->alloc_size = alloc_size ? alloc_size : DEFAULT_MINIMUM_SIZE;
+    strbuf->buffer    = NULL;
 
     strbuf->str    = (char *)wmem_alloc(strbuf->allocator, strbuf->alloc_size);
     strbuf->str[0] = '\0';
@@ -45,6 +52,21 @@ wmem_strbuf_new_sized(wmem_allocator_t *allocator,
     return strbuf;
 }
 
+void
+wmem_strbuf_init_buffer(wmem_strbuf_t *strbuf, wmem_allocator_t *allocator,
+                        char *buffer, size_t size)
+{
+    ws_assert(buffer && size > 0);
+
+    strbuf->allocator  = allocator;
+    strbuf->str        = buffer;
+    strbuf->len        = 0;
+    strbuf->alloc_size = size;
+    strbuf->buffer     = buffer;
+
+    strbuf->str[0] = '\0';
+}
+
 wmem_strbuf_t *
 wmem_strbuf_new_len(wmem_allocator_t *allocator, const char *str, size_t len)
 {
@@ -88,6 +110,23 @@ wmem_strbuf_dup(wmem_allocator_t *allocator, const wmem_strbuf_t *src)
     return new;
 }
 
+/* changes the allocated size of the wmem_strbuf_t, moving the string out of
+ * the caller's buffer if it is still there */
+static void
+wmem_strbuf_resize(wmem_strbuf_t *strbuf, const size_t new_alloc_len)
+{
+    if (strbuf->str == strbuf->buffer) {
+        char *str = (char *)wmem_alloc(strbuf->allocator, new_alloc_len);
+
+        memcpy(str, strbuf->str, strbuf->len + 1);
+        strbuf->str = str;
+    } else {
+        strbuf->str = (char *)wmem_realloc(strbuf->allocator, strbuf->str, new_alloc_len);
+    }
+
+    strbuf->alloc_size = new_alloc_len;
+}
+
 /* grows the allocated size of the wmem_strbuf_t */
 static inline void
 wmem_strbuf_grow(wmem_strbuf_t *strbuf, const size_t to_add)
@@ -107,16 +146,25 @@ wmem_strbuf_grow(wmem_strbuf_t *strbuf, const size_t to_add)
 
     /* +1 for the null-terminator */
     while (new_alloc_len < (new_len + 1)) {
-        new_alloc_len *= 2;
+        if (new_alloc_len < GEOMETRIC_DOUBLING_LIMIT) {
+            new_alloc_len *= 2;
+        } else {
+            new_alloc_len += new_alloc_len / 2;
+        }
     }
 
-    if (new_alloc_len == strbuf->alloc_size) {
+    wmem_strbuf_resize(strbuf, new_alloc_len);
+}
+
+void
+wmem_strbuf_reserve(wmem_strbuf_t *strbuf, const size_t len)
+{
+    if (WMEM_STRBUF_ROOM(strbuf) >= len) {
         return;
     }
 
-    strbuf->str = (char *)wmem_realloc(strbuf->allocator, strbuf->str, new_alloc_len);
-
-    strbuf->alloc_size = new_alloc_len;
+    /* +1 for the null-terminator */
+    wmem_strbuf_resize(strbuf, strbuf->len + len + 1);
 }
 
 void
@@ -208,6 +256,34 @@ wmem_strbuf_append_printf(wmem_strbuf_t *strbuf, const char *format, ...)
     va_end(ap);
 }
 
+void
+wmem_strbuf_append_uint(wmem_strbuf_t *strbuf, uint64_t value)
+{
+    char   digits[20];  /* UINT64_MAX has 20 digits */
+    size_t n = 0;
+
+    /* The number of digits is known before anything is appended, so this
+     * needs neither a format string nor a second try. */
+    do {
+        digits[sizeof(digits) - ++n] = '0' + (char)(value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    wmem_strbuf_append_len(strbuf, &digits[sizeof(digits) - n], n);
+}
+
+void
+wmem_strbuf_append_int(wmem_strbuf_t *strbuf, int64_t value)
+{
+    if (value < 0) {
+        wmem_strbuf_append_c(strbuf, '-');
+        /* Negate as unsigned, which is defined for INT64_MIN as well. */
+        wmem_strbuf_append_uint(strbuf, 0 - (uint64_t)value);
+    } else {
+        wmem_strbuf_append_uint(strbuf, (uint64_t)value);
+    }
+}
+
 void
 wmem_strbuf_append_c(wmem_strbuf_t *strbuf, const char c)
 {
@@ -384,6 +460,14 @@ wmem_strbuf_finalize(wmem_strbuf_t *strbuf)
     if (strbuf == NULL)
         return NULL;
 
+    if (strbuf->buffer) {
+        /* The structure belongs to the caller. */
+        if (strbuf->str == strbuf->buffer) {
+            return (char *)wmem_memdup(strbuf->allocator, strbuf->str, strbuf->len+1);
+        }
+        return (char *)wmem_realloc(strbuf->allocator, strbuf->str, strbuf->len+1);
+    }
+
     char *ret = (char *)wmem_realloc(strbuf->allocator, strbuf->str, strbuf->len+1);
 
     wmem_free(strbuf->allocator, strbuf);
@@ -391,14 +475,38 @@ wmem_strbuf_finalize(wmem_strbuf_t *strbuf)
     return ret;
 }
 
+char *
+wmem_strbuf_steal(wmem_strbuf_t *strbuf)
+{
+    char *ret;
+
+    if (strbuf == NULL)
+        return NULL;
+
+    if (strbuf->buffer) {
+        /* The structure belongs to the caller. */
+        if (strbuf->str == strbuf->buffer) {
+            return (char *)wmem_memdup(strbuf->allocator, strbuf->str, strbuf->len+1);
+        }
+        return strbuf->str;
+    }
+
+    ret = strbuf->str;
+    wmem_free(strbuf->allocator, strbuf);
+
+    return ret;
+}
+
 void
 wmem_strbuf_destroy(wmem_strbuf_t *strbuf)
 {
     if (strbuf == NULL)
         return;
 
-    wmem_free(strbuf->allocator, strbuf->str);
-    wmem_free(strbuf->allocator, strbuf);
+    if (strbuf->str != strbuf->buffer)
+        wmem_free(strbuf->allocator, strbuf->str);
+    if (strbuf->buffer == NULL)
+        wmem_free(strbuf->allocator, strbuf);
 }
 
 static bool
@@ -447,7 +555,8 @@ wmem_strbuf_utf8_make_valid(wmem_strbuf_t *strbuf)
 {
     wmem_strbuf_t *tmp = ws_utf8_make_valid_strbuf(strbuf->allocator, (const uint8_t*)strbuf->str, strbuf->len);
 
-    wmem_free(strbuf->allocator, strbuf->str);
+    if (strbuf->str != strbuf->buffer)
+        wmem_free(strbuf->allocator, strbuf->str);
     strbuf->str = tmp->str;
     strbuf->len = tmp->len;
     strbuf->alloc_size = tmp->alloc_size;
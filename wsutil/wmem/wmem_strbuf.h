@@ -58,6 +58,13 @@ struct _wmem_strbuf_t {
      * regardless of actual string content.
      */
     size_t alloc_size;
+
+    /**
+     * Storage provided by the caller with wmem_strbuf_init_buffer(), or NULL.
+     * `str` points here until the string outgrows it. If set, the structure
+     * itself belongs to the caller as well.
+     */
+    char *buffer;
 };
 
 typedef struct _wmem_strbuf_t wmem_strbuf_t;
@@ -133,6 +140,53 @@ WS_DLL_PUBLIC
 wmem_strbuf_t *
 wmem_strbuf_dup(wmem_allocator_t *allocator, const wmem_strbuf_t *strbuf);
 
+/**
+ * @brief Initialize a string buffer that starts out in storage of the caller's.
+ *
+ * Both the structure and the initial storage are provided by the caller, usually
+ * on the stack, so that building a short string allocates nothing. If the string
+ * outgrows `buffer`, it is moved to memory from `allocator` and carries on as
+ * usual.
+ *
+ * wmem_strbuf_destroy() frees only what was allocated, and wmem_strbuf_finalize()
+ * and wmem_strbuf_steal() return the string in memory from `allocator`, copying
+ * it out of `buffer` if it is still there. The structure can't be used after any
+ * of these unless it is initialized again.
+ *
+ * @code
+ * char buf[128];
+ * wmem_strbuf_t strbuf;
+ *
+ * wmem_strbuf_init_buffer(&strbuf, NULL, buf, sizeof(buf));
+ * wmem_strbuf_append(&strbuf, "...");
+ * ...
+ * wmem_strbuf_destroy(&strbuf);
+ * @endcode
+ *
+ * @param strbuf Pointer to the structure to initialize.
+ * @param allocator Pointer to the memory allocator to use if the string outgrows `buffer`.
+ * @param buffer Initial storage for the string.
+ * @param size Size of `buffer` in bytes, including room for the null-terminator.
+ */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_init_buffer(wmem_strbuf_t *strbuf, wmem_allocator_t *allocator,
+                        char *buffer, size_t size);
+
+/**
+ * @brief Make room in a string buffer for a number of bytes to be appended.
+ *
+ * If the buffer doesn't have room for `len` more bytes, it is grown to exactly
+ * the size needed for them rather than by the usual geometric steps. This suits
+ * callers that know the length of what they are about to append.
+ *
+ * @param strbuf Pointer to the string buffer.
+ * @param len Number of bytes to make room for, not counting the null-terminator.
+ */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_reserve(wmem_strbuf_t *strbuf, size_t len);
+
 /**
  * @brief Append a null-terminated string to the end of a string buffer.
  *
@@ -191,6 +245,31 @@ WS_DLL_PUBLIC
 void
 wmem_strbuf_append_vprintf(wmem_strbuf_t *strbuf, const char *fmt, va_list ap);
 
+/**
+ * @brief Append an unsigned integer in decimal to a string buffer.
+ *
+ * Equivalent to appending with the format "%" PRIu64, without the cost of
+ * parsing a format string or of formatting twice when the buffer needs to grow.
+ *
+ * @param strbuf Pointer to the string buffer to append to.
+ * @param value Value to append.
+ */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_append_uint(wmem_strbuf_t *strbuf, uint64_t value);
+
+/**
+ * @brief Append a signed integer in decimal to a string buffer.
+ *
+ * Equivalent to appending with the format "%" PRId64; see wmem_strbuf_append_uint().
+ *
+ * @param strbuf Pointer to the string buffer to append to.
+ * @param value Value to append.
+ */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_append_int(wmem_strbuf_t *strbuf, int64_t value);
+
 /**
  * @brief Append a single character to a string buffer.
  *
@@ -379,6 +458,21 @@ WS_DLL_PUBLIC
 char *
 wmem_strbuf_finalize(wmem_strbuf_t *strbuf);
 
+/**
+ * @brief Finalize a wmem string buffer without truncating its memory.
+ *
+ * Like wmem_strbuf_finalize(), but hands over the allocated memory as it is,
+ * including any room left at its end, instead of reallocating it to size, which
+ * usually means a copy. Prefer this for strings that don't live long, such as
+ * those in the packet scope.
+ *
+ * @param strbuf Pointer to the string buffer to finalize.
+ * @return Pointer to the raw, null-terminated C string. The caller assumes ownership.
+ */
+WS_DLL_PUBLIC
+char *
+wmem_strbuf_steal(wmem_strbuf_t *strbuf);
+
 /**
  * @brief Destroy a wmem string buffer and release its associated memory.
  *
@@ -19,6 +19,7 @@
 #include "wmem_allocator.h"
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_block_fast.h"
+#include "wmem_allocator_block_fast_mt.h"
 #include "wmem_allocator_simple.h"
 #include "wmem_allocator_strict.h"
 
@@ -54,6 +55,9 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_BLOCK_FAST:
             wmem_block_fast_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_BLOCK_FAST_MT:
+            wmem_block_fast_mt_allocator_init(allocator);
+            break;
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
@@ -135,8 +139,51 @@ wmem_test_foreach_cb(const void *key _U_, void *value, void *user_data)
     return (cb_continue_count == 0);
 }
 
+static bool
+wmem_test_btree_order_cb(const void *key, void *value, void *user_data)
+{
+    uint32_t *last_key = (uint32_t *)user_data;
+
+    g_assert_true(GPOINTER_TO_UINT(key) == *last_key + 1);
+    g_assert_true(value == key);
+    *last_key = GPOINTER_TO_UINT(key);
+
+    return false;
+}
+
 /* ALLOCATOR TESTING FUNCTIONS (/wmem/allocator/) */
 
+static void
+wmem_test_allocator_accounting(void)
+{
+    wmem_allocator_t *allocator;
+    void             *ptr;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_SIMPLE);
+    g_assert_true(wmem_allocated_bytes(allocator) == 0);
+    g_assert_true(wmem_in_use_bytes(allocator) == 0);
+
+    ptr = wmem_alloc(allocator, 10);
+    wmem_alloc(allocator, 20);
+    g_assert_true(wmem_allocated_bytes(allocator) == 30);
+    g_assert_true(wmem_in_use_bytes(allocator) == 30);
+
+    ptr = wmem_realloc(allocator, ptr, 40);
+    wmem_free(allocator, ptr);
+    g_assert_true(wmem_allocated_bytes(allocator) == 70);
+    g_assert_true(wmem_in_use_bytes(allocator) == 70);
+
+    wmem_free_all(allocator);
+    g_assert_true(wmem_allocated_bytes(allocator) == 70);
+    g_assert_true(wmem_in_use_bytes(allocator) == 0);
+
+    wmem_alloc(allocator, 5);
+    g_assert_true(wmem_allocated_bytes(allocator) == 75);
+    g_assert_true(wmem_in_use_bytes(allocator) == 5);
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_callbacks(void)
 {
@@ -353,6 +400,61 @@ wmem_test_allocator_block_fast(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_BLOCK, NULL);
 }
 
+#define MT_THREADS 4
+#define MT_ALLOCS  20000
+
+static void *
+wmem_test_allocator_block_fast_mt_thread(void *data)
+{
+    wmem_allocator_t *allocator = (wmem_allocator_t *)data;
+    unsigned *ptrs[64];
+    unsigned i, j, tag;
+
+    /* Tag every allocation with the thread so that overlapping allocations
+     * from different threads show up as clobbered tags. */
+    tag = GPOINTER_TO_UINT(g_thread_self());
+    for (i = 0; i < MT_ALLOCS; i++) {
+        j = i % G_N_ELEMENTS(ptrs);
+        if (i >= G_N_ELEMENTS(ptrs)) {
+            g_assert_true(ptrs[j][0] == tag + j);
+            g_assert_true(ptrs[j][1] == tag + j);
+        }
+        ptrs[j] = (unsigned *)wmem_alloc(allocator, (i % 7 == 0 ? 20000 : 8) * sizeof(unsigned));
+        ptrs[j][0] = ptrs[j][1] = tag + j;
+    }
+    for (j = 0; j < G_N_ELEMENTS(ptrs); j++) {
+        g_assert_true(ptrs[j][0] == tag + j);
+        g_assert_true(ptrs[j][1] == tag + j);
+    }
+
+    return NULL;
+}
+
+static void
+wmem_test_allocator_block_fast_mt(void)
+{
+    wmem_allocator_t *allocator;
+    GThread *threads[MT_THREADS];
+    int i, round;
+
+    wmem_test_allocator(WMEM_ALLOCATOR_BLOCK_FAST_MT, NULL,
+            MAX_SIMULTANEOUS_ALLOCS*4);
+    wmem_test_allocator_jumbo(WMEM_ALLOCATOR_BLOCK_FAST_MT, NULL);
+
+    /* Several threads allocating at once, with free_all in between. */
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_BLOCK_FAST_MT);
+    for (round = 0; round < 3; round++) {
+        for (i = 0; i < MT_THREADS; i++) {
+            threads[i] = g_thread_new("wmem_test", wmem_test_allocator_block_fast_mt_thread, allocator);
+        }
+        for (i = 0; i < MT_THREADS; i++) {
+            g_thread_join(threads[i]);
+        }
+        wmem_free_all(allocator);
+    }
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_simple(void)
 {
@@ -934,6 +1036,8 @@ wmem_test_map(void)
         ret = wmem_map_lookup(map, GINT_TO_POINTER(i));
         g_assert_true(ret == GINT_TO_POINTER(i));
         g_assert_true(wmem_map_contains(map, GINT_TO_POINTER(i)) == true);
+        ret = wmem_map_lookup_hash(map, GINT_TO_POINTER(i), g_direct_hash(GINT_TO_POINTER(i)));
+        g_assert_true(ret == GINT_TO_POINTER(i));
         g_assert_true(wmem_map_lookup_extended(map, GINT_TO_POINTER(i), NULL, NULL));
         key_ret = NULL;
         g_assert_true(wmem_map_lookup_extended(map, GINT_TO_POINTER(i), GINT_TO_POINTER(&key_ret), NULL));
@@ -1019,6 +1123,165 @@ wmem_test_map(void)
     wmem_destroy_allocator(allocator);
 }
 
+static void
+wmem_test_map_flat(void)
+{
+    wmem_allocator_t   *allocator, *extra_allocator;
+    wmem_map_t       *map;
+    char             *str_key;
+    const void       *str_key_ret;
+    unsigned int      i;
+    unsigned int     *value_ret;
+    void             *ret;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* insertion, lookup and removal of simple integer keys */
+    map = wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+    g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(1)) == NULL);
+
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(777777));
+        g_assert_true(ret == NULL);
+        ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(777777));
+    }
+    g_assert_true(wmem_map_size(map) == CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_lookup(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(i));
+        g_assert_true(wmem_map_contains(map, GINT_TO_POINTER(i)) == true);
+        ret = wmem_map_lookup_hash(map, GINT_TO_POINTER(i), g_direct_hash(GINT_TO_POINTER(i)));
+        g_assert_true(ret == GINT_TO_POINTER(i));
+    }
+    /* remove every other key, leaving deleted slots among the full ones */
+    for (i=0; i<CONTAINER_ITERS; i+=2) {
+        ret = wmem_map_remove(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(i));
+        ret = wmem_map_remove(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == NULL);
+    }
+    g_assert_true(wmem_map_size(map) == CONTAINER_ITERS/2);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_contains(map, GINT_TO_POINTER(i)) == (i % 2 == 1));
+    }
+    /* churn through many more keys than the map ever holds at once */
+    for (i=CONTAINER_ITERS; i<8*CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(wmem_map_steal(map, GINT_TO_POINTER(i)));
+    }
+    g_assert_true(wmem_map_size(map) == CONTAINER_ITERS/2);
+    for (i=1; i<CONTAINER_ITERS; i+=2) {
+        g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(i)) == GINT_TO_POINTER(i));
+    }
+    wmem_free_all(allocator);
+
+    /* test auto-reset functionality */
+    map = wmem_map_new_flat_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == NULL);
+    }
+    wmem_free_all(extra_allocator);
+    g_assert_true(wmem_map_size(map) == 0);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(i)) == NULL);
+    }
+    wmem_free_all(allocator);
+
+    /* string keys */
+    map = wmem_map_new_flat(allocator, wmem_str_hash, g_str_equal);
+    g_assert_true(map);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        str_key = wmem_test_rand_string(allocator, 1, 64);
+        wmem_map_insert(map, str_key, GINT_TO_POINTER(i));
+        str_key_ret = NULL;
+        value_ret = NULL;
+        g_assert_true(wmem_map_lookup_extended(map, str_key, &str_key_ret, GINT_TO_POINTER(&value_ret)) == true);
+        g_assert_true(g_str_equal(str_key_ret, str_key));
+        g_assert_true(value_ret == GINT_TO_POINTER(i));
+    }
+
+    /* test foreach, find and reserve */
+    map = wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+    wmem_map_reserve(map, CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(2));
+    }
+    wmem_map_foreach(map, check_val_map, GINT_TO_POINTER(2));
+    g_assert_true(wmem_map_find(map, equal_val_map, GINT_TO_POINTER(2)) == GINT_TO_POINTER(2));
+    g_assert_true(wmem_list_count(wmem_map_get_keys(allocator, map)) == CONTAINER_ITERS);
+    g_assert_true(wmem_map_foreach_remove(map, equal_val_map, GINT_TO_POINTER(2)) == CONTAINER_ITERS);
+    g_assert_true(wmem_map_size(map) == 0);
+    g_assert_true(wmem_map_find(map, equal_val_map, GINT_TO_POINTER(2)) == NULL);
+
+    wmem_destroy_allocator(extra_allocator);
+    wmem_destroy_allocator(allocator);
+}
+
+/* NOTE: You have to run "wmem_test -m perf" to run the performance tests. */
+static void
+wmem_test_mapperf(void)
+{
+#define MAP_PERF_ITERS (1 * 1000 * 1000)
+    wmem_allocator_t   *allocator;
+    wmem_map_t         *map;
+    unsigned            i, pass;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+    static const char  *kind[] = { "chained", "flat" };
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    for (pass = 0; pass < G_N_ELEMENTS(kind); pass++) {
+        if (pass == 0) {
+            map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+        } else {
+            map = wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal);
+        }
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < MAP_PERF_ITERS; i++) {
+            wmem_map_insert(map, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s map insert: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < MAP_PERF_ITERS; i++) {
+            g_assert_true(wmem_map_lookup(map, GUINT_TO_POINTER(i)) == GUINT_TO_POINTER(i));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s map lookup hit: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = MAP_PERF_ITERS; i < 2 * MAP_PERF_ITERS; i++) {
+            g_assert_true(wmem_map_lookup(map, GUINT_TO_POINTER(i)) == NULL);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s map lookup miss: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < MAP_PERF_ITERS; i++) {
+            wmem_map_remove(map, GUINT_TO_POINTER(i));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s map remove: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+        g_assert_true(wmem_map_size(map) == 0);
+
+        wmem_free_all(allocator);
+    }
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1180,6 +1443,90 @@ wmem_test_strbuf_validate(void)
     wmem_strbuf_destroy(strbuf);
 }
 
+static void
+wmem_test_strbuf_buffer(void)
+{
+    wmem_allocator_t   *allocator;
+    wmem_strbuf_t       strbuf, *heap_strbuf;
+    char                buffer[8];
+    char               *str;
+    size_t              alloc_size;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* Stays in the caller's buffer while it fits. */
+    wmem_strbuf_init_buffer(&strbuf, allocator, buffer, sizeof(buffer));
+    g_assert_cmpstr(wmem_strbuf_get_str(&strbuf), ==, "");
+    wmem_strbuf_append(&strbuf, "TEST");
+    wmem_strbuf_append_uint(&strbuf, 123);
+    g_assert_true(wmem_strbuf_get_str(&strbuf) == buffer);
+    g_assert_cmpstr(wmem_strbuf_get_str(&strbuf), ==, "TEST123");
+    str = wmem_strbuf_finalize(&strbuf);
+    g_assert_true(str != buffer);
+    g_assert_cmpstr(str, ==, "TEST123");
+    wmem_free(allocator, str);
+
+    /* Moves to the allocator once it doesn't. */
+    wmem_strbuf_init_buffer(&strbuf, allocator, buffer, sizeof(buffer));
+    wmem_strbuf_append(&strbuf, "TEST");
+    wmem_strbuf_append(&strbuf, "FUZZ");
+    g_assert_true(wmem_strbuf_get_str(&strbuf) != buffer);
+    g_assert_cmpstr(wmem_strbuf_get_str(&strbuf), ==, "TESTFUZZ");
+    wmem_strbuf_append_printf(&strbuf, "%d%s", 3, "a");
+    g_assert_cmpstr(wmem_strbuf_get_str(&strbuf), ==, "TESTFUZZ3a");
+    g_assert_cmpuint(wmem_strbuf_get_len(&strbuf), ==, 10);
+    wmem_strict_check_canaries(allocator);
+    str = wmem_strbuf_steal(&strbuf);
+    g_assert_cmpstr(str, ==, "TESTFUZZ3a");
+    wmem_free(allocator, str);
+
+    wmem_strbuf_init_buffer(&strbuf, allocator, buffer, sizeof(buffer));
+    wmem_strbuf_append(&strbuf, "TEST");
+    str = wmem_strbuf_steal(&strbuf);
+    g_assert_true(str != buffer);
+    g_assert_cmpstr(str, ==, "TEST");
+    wmem_free(allocator, str);
+
+    /* Destroying it frees only what was allocated. */
+    wmem_strbuf_init_buffer(&strbuf, allocator, buffer, sizeof(buffer));
+    wmem_strbuf_append(&strbuf, "TEST");
+    wmem_strbuf_destroy(&strbuf);
+    wmem_strbuf_init_buffer(&strbuf, allocator, buffer, sizeof(buffer));
+    wmem_strbuf_append_c_count(&strbuf, '+', 64);
+    g_assert_cmpuint(wmem_strbuf_get_len(&strbuf), ==, 64);
+    wmem_strbuf_destroy(&strbuf);
+    wmem_strict_check_canaries(allocator);
+
+    /* Reserving grows to exactly the size asked for, or not at all. */
+    heap_strbuf = wmem_strbuf_new(allocator, "TEST");
+    wmem_strbuf_reserve(heap_strbuf, 100);
+    alloc_size = heap_strbuf->alloc_size;
+    g_assert_cmpuint(alloc_size, ==, 4 + 100 + 1);
+    wmem_strbuf_append_c_count(heap_strbuf, '+', 100);
+    g_assert_cmpuint(heap_strbuf->alloc_size, ==, alloc_size);
+    wmem_strbuf_reserve(heap_strbuf, 0);
+    g_assert_cmpuint(heap_strbuf->alloc_size, ==, alloc_size);
+    str = wmem_strbuf_steal(heap_strbuf);
+    g_assert_cmpuint(strlen(str), ==, 104);
+    wmem_free(allocator, str);
+
+    heap_strbuf = wmem_strbuf_new(allocator, NULL);
+    wmem_strbuf_append_uint(heap_strbuf, 0);
+    wmem_strbuf_append_c(heap_strbuf, ' ');
+    wmem_strbuf_append_uint(heap_strbuf, UINT64_MAX);
+    wmem_strbuf_append_c(heap_strbuf, ' ');
+    wmem_strbuf_append_int(heap_strbuf, -42);
+    wmem_strbuf_append_c(heap_strbuf, ' ');
+    wmem_strbuf_append_int(heap_strbuf, INT64_MIN);
+    wmem_strbuf_append_c(heap_strbuf, ' ');
+    wmem_strbuf_append_int(heap_strbuf, INT64_MAX);
+    g_assert_cmpstr(wmem_strbuf_get_str(heap_strbuf), ==,
+            "0 18446744073709551615 -42 -9223372036854775808 9223372036854775807");
+    wmem_strbuf_destroy(heap_strbuf);
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_tree(void)
 {
@@ -1353,6 +1700,251 @@ wmem_test_tree(void)
     wmem_destroy_allocator(allocator);
 }
 
+static void
+wmem_test_btree(void)
+{
+    wmem_allocator_t   *allocator, *extra_allocator;
+    wmem_tree_t        *tree, *rb_tree;
+    uint32_t            i;
+    uint32_t            rand_int;
+    uint32_t            int_key, rb_key;
+    int                 j;
+    wmem_tree_key_t     keys[3];
+
+    allocator       = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    tree = wmem_tree_new_btree(allocator);
+    g_assert_true(tree);
+    g_assert_true(wmem_tree_is_empty(tree));
+
+    /* test basic 32-bit key operations */
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, i) == NULL);
+        g_assert_true(!wmem_tree_contains32(tree, i));
+        if (i > 0) {
+            g_assert_true(wmem_tree_lookup32_le_full(tree, i, &int_key) == GINT_TO_POINTER(i-1));
+            g_assert_true(int_key == i - 1);
+        }
+        g_assert_true(wmem_tree_lookup32_ge(tree, i) == NULL);
+        wmem_tree_insert32(tree, i, GINT_TO_POINTER(i));
+        g_assert_true(wmem_tree_lookup32(tree, i) == GINT_TO_POINTER(i));
+        g_assert_true(wmem_tree_contains32(tree, i));
+        g_assert_true(!wmem_tree_is_empty(tree));
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+
+    /* replace every other value */
+    for (i=0; i<CONTAINER_ITERS; i+=2) {
+        wmem_tree_insert32(tree, i, GINT_TO_POINTER(i+1));
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, i) == GINT_TO_POINTER(i | 1));
+    }
+
+    /* remove all but every tenth key */
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        if (i % 10 != 0) {
+            g_assert_true(wmem_tree_remove32(tree, i) == GINT_TO_POINTER(i | 1));
+            g_assert_true(wmem_tree_remove32(tree, i) == NULL);
+        }
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS / 10);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32_le_full(tree, i, &int_key) == GINT_TO_POINTER((i / 10 * 10) | 1));
+        g_assert_true(int_key == i / 10 * 10);
+        if (i + 10 <= CONTAINER_ITERS) {
+            g_assert_true(wmem_tree_lookup32_ge_full(tree, i, &int_key) == GINT_TO_POINTER(((i + 9) / 10 * 10) | 1));
+            g_assert_true(int_key == (i + 9) / 10 * 10);
+        } else if (i % 10 != 0) {
+            g_assert_true(wmem_tree_lookup32_ge(tree, i) == NULL);
+        }
+    }
+
+    /* remove the rest, which must leave the tree empty */
+    for (i=0; i<CONTAINER_ITERS; i+=10) {
+        g_assert_true(wmem_tree_remove32(tree, i) == GINT_TO_POINTER(i | 1));
+    }
+    g_assert_true(wmem_tree_is_empty(tree));
+    g_assert_true(wmem_tree_count(tree) == 0);
+    g_assert_true(wmem_tree_lookup32_le(tree, CONTAINER_ITERS) == NULL);
+    wmem_free_all(allocator);
+
+    /* compare random operations with a red-black tree */
+    tree    = wmem_tree_new_btree(allocator);
+    rb_tree = wmem_tree_new(allocator);
+    for (i=0; i<8*CONTAINER_ITERS; i++) {
+        rand_int = ((uint32_t)g_test_rand_int()) % (2*CONTAINER_ITERS);
+        switch (g_test_rand_int_range(0, 5)) {
+            case 0:
+            case 1:
+                wmem_tree_insert32(tree, rand_int, GINT_TO_POINTER(i));
+                wmem_tree_insert32(rb_tree, rand_int, GINT_TO_POINTER(i));
+                break;
+            case 2:
+                g_assert_true(wmem_tree_remove32(tree, rand_int) == wmem_tree_remove32(rb_tree, rand_int));
+                break;
+            case 3:
+                int_key = rb_key = 0;
+                g_assert_true(wmem_tree_lookup32_le_full(tree, rand_int, &int_key) ==
+                        wmem_tree_lookup32_le_full(rb_tree, rand_int, &rb_key));
+                g_assert_true(int_key == rb_key);
+                break;
+            default:
+                int_key = rb_key = 0;
+                g_assert_true(wmem_tree_lookup32_ge_full(tree, rand_int, &int_key) ==
+                        wmem_tree_lookup32_ge_full(rb_tree, rand_int, &rb_key));
+                g_assert_true(int_key == rb_key);
+                break;
+        }
+    }
+    g_assert_true(wmem_tree_count(tree) == wmem_tree_count(rb_tree));
+    wmem_free_all(allocator);
+
+    /* test auto-reset functionality */
+    tree = wmem_tree_new_btree_autoreset(allocator, extra_allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_tree_insert32(tree, i, GINT_TO_POINTER(i));
+        g_assert_true(wmem_tree_lookup32(tree, i) == GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+    wmem_free_all(extra_allocator);
+    g_assert_true(wmem_tree_is_empty(tree));
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, i) == NULL);
+        g_assert_true(wmem_tree_lookup32_le(tree, i) == NULL);
+    }
+    wmem_free_all(allocator);
+
+    /* test array key functionality */
+    tree = wmem_tree_new_btree(allocator);
+    keys[0].length = 1;
+    keys[0].key    = wmem_new(allocator, uint32_t);
+    keys[1].length = 1;
+    keys[1].key    = wmem_new(allocator, uint32_t);
+    keys[2].length = 0;
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        *(keys[0].key) = i % 7;
+        *(keys[1].key) = i * 4;
+        wmem_tree_insert32_array(tree, keys, GINT_TO_POINTER(i));
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        *(keys[0].key) = i % 7;
+        *(keys[1].key) = i * 4;
+        g_assert_true(wmem_tree_lookup32_array(tree, keys) == GINT_TO_POINTER(i));
+        for (j=0; j<3; j++) {
+            (*(keys[1].key)) += 1;
+            g_assert_true(wmem_tree_lookup32_array_le(tree, keys) == GINT_TO_POINTER(i));
+        }
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+
+    /* test for-each functionality, then that values come in key order */
+    expected_user_data = NULL;
+    memset(value_seen, 0, sizeof(value_seen));
+    cb_called_count = 0;
+    cb_continue_count = 10;
+    wmem_tree_foreach(tree, wmem_test_foreach_cb, NULL);
+    g_assert_true(cb_called_count   == 10);
+    g_assert_true(cb_continue_count == 0);
+    wmem_free_all(allocator);
+
+    tree = wmem_tree_new_btree(NULL);
+    for (i=CONTAINER_ITERS; i>0; i--) {
+        wmem_tree_insert32(tree, i, GINT_TO_POINTER(i));
+    }
+    int_key = 0;
+    wmem_tree_foreach(tree, wmem_test_btree_order_cb, &int_key);
+    g_assert_true(int_key == CONTAINER_ITERS);
+    wmem_tree_destroy(tree, false, false);
+
+    wmem_destroy_allocator(extra_allocator);
+    wmem_destroy_allocator(allocator);
+}
+
+/* NOTE: You have to run "wmem_test -m perf" to run the performance tests. */
+static void
+wmem_test_treeperf(void)
+{
+#define TREE_PERF_ITERS (1 * 1000 * 1000)
+    wmem_allocator_t   *allocator;
+    wmem_tree_t        *tree;
+    uint32_t           *rand_keys;
+    unsigned            i, pass;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+    static const char  *kind[] = { "red-black", "B+" };
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+    rand_keys = g_new(uint32_t, TREE_PERF_ITERS);
+    for (i = 0; i < TREE_PERF_ITERS; i++) {
+        rand_keys[i] = g_test_rand_int();
+    }
+
+    for (pass = 0; pass < G_N_ELEMENTS(kind); pass++) {
+        if (pass == 0) {
+            tree = wmem_tree_new(allocator);
+        } else {
+            tree = wmem_tree_new_btree(allocator);
+        }
+
+        /* Keys in order, as frame numbers are. */
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_ITERS; i++) {
+            wmem_tree_insert32(tree, 2 * i, GUINT_TO_POINTER(i + 1));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree insert in order: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_ITERS; i++) {
+            g_assert_true(wmem_tree_lookup32(tree, 2 * (rand_keys[i] % TREE_PERF_ITERS)) != NULL);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree lookup: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_ITERS; i++) {
+            g_assert_true(wmem_tree_lookup32_le(tree, 2 * (rand_keys[i] % TREE_PERF_ITERS) + 1) != NULL);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree lookup_le: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_ITERS; i++) {
+            wmem_tree_remove32(tree, 2 * i);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree remove: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+        g_assert_true(wmem_tree_is_empty(tree));
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_ITERS; i++) {
+            wmem_tree_insert32(tree, rand_keys[i], GUINT_TO_POINTER(i + 1));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree insert random: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_ITERS; i++) {
+            g_assert_true(wmem_tree_lookup32_le(tree, rand_keys[i]) != NULL);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree lookup_le random: u %.3f ms s %.3f ms", kind[pass], utime_ms, stime_ms);
+
+        wmem_free_all(allocator);
+    }
+
+    g_free(rand_keys);
+    wmem_destroy_allocator(allocator);
+}
+
 
 /* to be used as userdata in the callback wmem_test_itree_check_overlap_cb*/
 typedef struct wmem_test_itree_user_data {
@@ -1467,9 +2059,11 @@ main(int argc, char **argv)
 
     g_test_add_func("/wmem/allocator/block",     wmem_test_allocator_block);
     g_test_add_func("/wmem/allocator/blk_fast",  wmem_test_allocator_block_fast);
+    g_test_add_func("/wmem/allocator/blk_fast_mt", wmem_test_allocator_block_fast_mt);
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
+    g_test_add_func("/wmem/allocator/accounting", wmem_test_allocator_accounting);
 
     g_test_add_func("/wmem/utils/misc",    wmem_test_miscutls);
     g_test_add_func("/wmem/utils/strings", wmem_test_strutls);
@@ -1481,11 +2075,20 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
     g_test_add_func("/wmem/datastruct/list",   wmem_test_list);
     g_test_add_func("/wmem/datastruct/map",    wmem_test_map);
+    g_test_add_func("/wmem/datastruct/map/flat", wmem_test_map_flat);
+    if (g_test_perf()) {
+        g_test_add_func("/wmem/datastruct/mapperf", wmem_test_mapperf);
+    }
     g_test_add_func("/wmem/datastruct/queue",  wmem_test_queue);
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
     g_test_add_func("/wmem/datastruct/strbuf/validate", wmem_test_strbuf_validate);
+    g_test_add_func("/wmem/datastruct/strbuf/buffer", wmem_test_strbuf_buffer);
     g_test_add_func("/wmem/datastruct/tree",   wmem_test_tree);
+    g_test_add_func("/wmem/datastruct/tree/btree", wmem_test_btree);
+    if (g_test_perf()) {
+        g_test_add_func("/wmem/datastruct/treeperf", wmem_test_treeperf);
+    }
     g_test_add_func("/wmem/datastruct/itree",  wmem_test_itree);
 
     ret = g_test_run();
@@ -69,6 +69,15 @@ typedef struct _wmem_tree_node_t wmem_tree_node_t;
  */
 typedef struct _wmem_itree_node_t wmem_itree_node_t;
 
+/**
+ * @typedef wmem_btree_node_t
+ * @brief Opaque type representing a node in a B+tree.
+ *
+ * `wmem_btree_node_t` holds the nodes of trees created with
+ * `wmem_tree_new_btree()`; it is private to wmem_tree.c.
+ */
+typedef struct _wmem_btree_node_t wmem_btree_node_t;
+
 
 /**
  * @brief Internal representation of a wmem balanced tree.
@@ -87,6 +96,9 @@ struct _wmem_tree_t {
     unsigned data_scope_cb_id;            /**< Callback ID for data scope lifecycle management. */
 
     void (*post_rotation_cb)(wmem_tree_node_t *); /**< Optional callback invoked after tree rotations. */
+
+    bool btree;                           /**< True if the tree is a B+tree rather than a red-black tree. */
+    wmem_btree_node_t *btree_root;        /**< Root node of a B+tree. */
 };
 
 /**
@@ -356,6 +356,459 @@ rb_remove_node(wmem_tree_t *tree, wmem_tree_node_t *node, bool free_key)
     wmem_free(tree->data_allocator, node);
 }
 
+#define CREATE_DATA(TRANSFORM, DATA) ((TRANSFORM) ? (TRANSFORM)(DATA) : (DATA))
+
+/*
+ * B+trees (see wmem_tree_new_btree) keep up to WMEM_BTREE_ORDER sorted keys
+ * in each node, and only their leaves hold values. A lookup reads a few
+ * wide nodes instead of following a pointer per level of a binary tree, and
+ * the leaves are linked in key order, so the _le and _ge lookups step to the
+ * neighbouring leaf at most.
+ *
+ * Removing a key never merges or rebalances nodes: a node is only freed once
+ * it is empty. Trees that shrink keep the height they had when they were
+ * largest, which with nodes this wide is still only a few levels.
+ */
+#define WMEM_BTREE_ORDER 32
+
+struct _wmem_btree_node_t {
+    unsigned count;     /* keys in a leaf, children in an inner node */
+    bool is_leaf;
+
+    /* In an inner node keys[i] is the smallest key that may be found under
+     * children[i], and keys[0] is unused. */
+    uint32_t keys[WMEM_BTREE_ORDER];
+
+    union {
+        struct {
+            void *values[WMEM_BTREE_ORDER];
+            bool is_subtree[WMEM_BTREE_ORDER];
+            struct _wmem_btree_node_t *prev;
+            struct _wmem_btree_node_t *next;
+        } leaf;
+        struct _wmem_btree_node_t *children[WMEM_BTREE_ORDER];
+    } u;
+};
+
+static wmem_btree_node_t *
+btree_new_node(wmem_tree_t *tree, bool is_leaf)
+{
+    wmem_btree_node_t *node;
+
+    node = wmem_new(tree->data_allocator, wmem_btree_node_t);
+    node->count   = 0;
+    node->is_leaf = is_leaf;
+    if (is_leaf) {
+        node->u.leaf.prev = NULL;
+        node->u.leaf.next = NULL;
+    }
+
+    return node;
+}
+
+/* The child of an inner node under which key belongs. The comparisons are
+ * counted rather than branched on, which compilers can vectorize. */
+static inline unsigned
+btree_child_index(const wmem_btree_node_t *node, uint32_t key)
+{
+    unsigned i, index = 0;
+
+    for (i = 1; i < node->count; i++) {
+        index += node->keys[i] <= key;
+    }
+
+    return index;
+}
+
+/* The position in a leaf of the first key that is not smaller than key. */
+static inline unsigned
+btree_leaf_pos(const wmem_btree_node_t *leaf, uint32_t key)
+{
+    unsigned i, pos = 0;
+
+    for (i = 0; i < leaf->count; i++) {
+        pos += leaf->keys[i] < key;
+    }
+
+    return pos;
+}
+
+static wmem_btree_node_t *
+btree_find_leaf(const wmem_tree_t *tree, uint32_t key)
+{
+    wmem_btree_node_t *node = tree->btree_root;
+
+    while (node && !node->is_leaf) {
+        node = node->u.children[btree_child_index(node, key)];
+    }
+
+    return node;
+}
+
+/* Find the leaf and position of key, or return NULL. */
+static wmem_btree_node_t *
+btree_lookup(const wmem_tree_t *tree, uint32_t key, unsigned *pos)
+{
+    wmem_btree_node_t *leaf = btree_find_leaf(tree, key);
+    unsigned           p;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    p = btree_leaf_pos(leaf, key);
+    if (p == leaf->count || leaf->keys[p] != key) {
+        return NULL;
+    }
+
+    *pos = p;
+    return leaf;
+}
+
+/* Find the leaf and position of the largest key <= key, or return NULL. */
+static wmem_btree_node_t *
+btree_lookup_le(const wmem_tree_t *tree, uint32_t key, unsigned *pos)
+{
+    wmem_btree_node_t *leaf = btree_find_leaf(tree, key);
+    unsigned           p;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    p = btree_leaf_pos(leaf, key);
+    if (p < leaf->count && leaf->keys[p] == key) {
+        *pos = p;
+        return leaf;
+    }
+
+    if (p == 0) {
+        /* Every key here is larger; the previous leaf's are all smaller. */
+        leaf = leaf->u.leaf.prev;
+        if (!leaf) {
+            return NULL;
+        }
+        p = leaf->count;
+    }
+
+    *pos = p - 1;
+    return leaf;
+}
+
+/* Find the leaf and position of the smallest key >= key, or return NULL. */
+static wmem_btree_node_t *
+btree_lookup_ge(const wmem_tree_t *tree, uint32_t key, unsigned *pos)
+{
+    wmem_btree_node_t *leaf = btree_find_leaf(tree, key);
+    unsigned           p;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    p = btree_leaf_pos(leaf, key);
+    if (p == leaf->count) {
+        /* Every key here is smaller; the next leaf's are all larger. */
+        leaf = leaf->u.leaf.next;
+        if (!leaf) {
+            return NULL;
+        }
+        p = 0;
+    }
+
+    *pos = p;
+    return leaf;
+}
+
+static void
+btree_leaf_insert_at(wmem_btree_node_t *leaf, unsigned pos, uint32_t key,
+        void *value, bool is_subtree)
+{
+    unsigned n = leaf->count - pos;
+
+    memmove(&leaf->keys[pos + 1], &leaf->keys[pos], n * sizeof(leaf->keys[0]));
+    memmove(&leaf->u.leaf.values[pos + 1], &leaf->u.leaf.values[pos], n * sizeof(leaf->u.leaf.values[0]));
+    memmove(&leaf->u.leaf.is_subtree[pos + 1], &leaf->u.leaf.is_subtree[pos], n * sizeof(leaf->u.leaf.is_subtree[0]));
+    leaf->keys[pos]              = key;
+    leaf->u.leaf.values[pos]     = value;
+    leaf->u.leaf.is_subtree[pos] = is_subtree;
+    leaf->count++;
+}
+
+static void
+btree_inner_insert_at(wmem_btree_node_t *node, unsigned index, uint32_t key,
+        wmem_btree_node_t *child)
+{
+    unsigned n = node->count - index;
+
+    memmove(&node->keys[index + 1], &node->keys[index], n * sizeof(node->keys[0]));
+    memmove(&node->u.children[index + 1], &node->u.children[index], n * sizeof(node->u.children[0]));
+    node->keys[index]       = key;
+    node->u.children[index] = child;
+    node->count++;
+}
+
+/* Move the entries of a full node from split onwards to a new node after it. */
+static wmem_btree_node_t *
+btree_split(wmem_tree_t *tree, wmem_btree_node_t *node, unsigned split)
+{
+    wmem_btree_node_t *right = btree_new_node(tree, node->is_leaf);
+    unsigned           n     = node->count - split;
+
+    memcpy(right->keys, &node->keys[split], n * sizeof(node->keys[0]));
+    if (node->is_leaf) {
+        memcpy(right->u.leaf.values, &node->u.leaf.values[split], n * sizeof(node->u.leaf.values[0]));
+        memcpy(right->u.leaf.is_subtree, &node->u.leaf.is_subtree[split], n * sizeof(node->u.leaf.is_subtree[0]));
+        right->u.leaf.prev = node;
+        right->u.leaf.next = node->u.leaf.next;
+        if (right->u.leaf.next) {
+            right->u.leaf.next->u.leaf.prev = right;
+        }
+        node->u.leaf.next = right;
+    } else {
+        memcpy(right->u.children, &node->u.children[split], n * sizeof(node->u.children[0]));
+    }
+    right->count = n;
+    node->count  = split;
+
+    return right;
+}
+
+/*
+ * Find or insert key under node, and set *value to its value. If node had to
+ * be split, return the new node that follows it, and set *split_key to the
+ * smallest key under that node.
+ */
+static wmem_btree_node_t *
+btree_insert_node(wmem_tree_t *tree, wmem_btree_node_t *node, uint32_t key,
+        void*(*func)(void*), void* data, bool is_subtree, bool replace,
+        void **value, uint32_t *split_key)
+{
+    wmem_btree_node_t *right = NULL, *child_right;
+    uint32_t           child_split_key;
+    unsigned           pos;
+
+    if (node->is_leaf) {
+        pos = btree_leaf_pos(node, key);
+        if (pos < node->count && node->keys[pos] == key) {
+            if (replace) {
+                node->u.leaf.values[pos] = CREATE_DATA(func, data);
+            }
+            *value = node->u.leaf.values[pos];
+            return NULL;
+        }
+
+        *value = CREATE_DATA(func, data);
+        if (node->count < WMEM_BTREE_ORDER) {
+            btree_leaf_insert_at(node, pos, key, *value, is_subtree);
+            return NULL;
+        }
+
+        if (pos == WMEM_BTREE_ORDER) {
+            /* Keys usually arrive in order (frame numbers, sequence numbers),
+             * so leave the full node full instead of halving it. */
+            right = btree_split(tree, node, WMEM_BTREE_ORDER);
+            btree_leaf_insert_at(right, 0, key, *value, is_subtree);
+        } else {
+            right = btree_split(tree, node, WMEM_BTREE_ORDER / 2);
+            if (pos <= WMEM_BTREE_ORDER / 2) {
+                btree_leaf_insert_at(node, pos, key, *value, is_subtree);
+            } else {
+                btree_leaf_insert_at(right, pos - WMEM_BTREE_ORDER / 2, key, *value, is_subtree);
+            }
+        }
+        *split_key = right->keys[0];
+        return right;
+    }
+
+    pos = btree_child_index(node, key);
+    child_right = btree_insert_node(tree, node->u.children[pos], key, func, data,
+            is_subtree, replace, value, &child_split_key);
+    if (!child_right) {
+        return NULL;
+    }
+
+    pos++;
+    if (node->count < WMEM_BTREE_ORDER) {
+        btree_inner_insert_at(node, pos, child_split_key, child_right);
+        return NULL;
+    }
+
+    if (pos == WMEM_BTREE_ORDER) {
+        right = btree_split(tree, node, WMEM_BTREE_ORDER);
+        btree_inner_insert_at(right, 0, child_split_key, child_right);
+    } else {
+        right = btree_split(tree, node, WMEM_BTREE_ORDER / 2);
+        if (pos <= WMEM_BTREE_ORDER / 2) {
+            btree_inner_insert_at(node, pos, child_split_key, child_right);
+        } else {
+            btree_inner_insert_at(right, pos - WMEM_BTREE_ORDER / 2, child_split_key, child_right);
+        }
+    }
+    *split_key = right->keys[0];
+    return right;
+}
+
+static void *
+btree_lookup_or_insert32(wmem_tree_t *tree, uint32_t key,
+        void*(*func)(void*), void* data, bool is_subtree, bool replace)
+{
+    wmem_btree_node_t *right, *root;
+    uint32_t           split_key;
+    void              *value;
+
+    if (!tree->btree_root) {
+        tree->btree_root = btree_new_node(tree, true);
+    }
+
+    right = btree_insert_node(tree, tree->btree_root, key, func, data,
+            is_subtree, replace, &value, &split_key);
+    if (right) {
+        root = btree_new_node(tree, false);
+        root->count         = 2;
+        root->keys[0]       = tree->btree_root->keys[0];
+        root->keys[1]       = split_key;
+        root->u.children[0] = tree->btree_root;
+        root->u.children[1] = right;
+        tree->btree_root    = root;
+    }
+
+    return value;
+}
+
+/* Remove key from under node, setting *value to its value if it was found.
+ * Return true if node is left empty. */
+static bool
+btree_remove_node(wmem_tree_t *tree, wmem_btree_node_t *node, uint32_t key,
+        void **value)
+{
+    wmem_btree_node_t *child;
+    unsigned           pos, n;
+
+    if (node->is_leaf) {
+        pos = btree_leaf_pos(node, key);
+        if (pos == node->count || node->keys[pos] != key) {
+            return false;
+        }
+
+        *value = node->u.leaf.values[pos];
+        n = node->count - pos - 1;
+        memmove(&node->keys[pos], &node->keys[pos + 1], n * sizeof(node->keys[0]));
+        memmove(&node->u.leaf.values[pos], &node->u.leaf.values[pos + 1], n * sizeof(node->u.leaf.values[0]));
+        memmove(&node->u.leaf.is_subtree[pos], &node->u.leaf.is_subtree[pos + 1], n * sizeof(node->u.leaf.is_subtree[0]));
+        node->count--;
+
+        if (node->count == 0) {
+            if (node->u.leaf.prev) {
+                node->u.leaf.prev->u.leaf.next = node->u.leaf.next;
+            }
+            if (node->u.leaf.next) {
+                node->u.leaf.next->u.leaf.prev = node->u.leaf.prev;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    pos = btree_child_index(node, key);
+    child = node->u.children[pos];
+    if (!btree_remove_node(tree, child, key, value)) {
+        return false;
+    }
+
+    wmem_free(tree->data_allocator, child);
+    n = node->count - pos - 1;
+    memmove(&node->keys[pos], &node->keys[pos + 1], n * sizeof(node->keys[0]));
+    memmove(&node->u.children[pos], &node->u.children[pos + 1], n * sizeof(node->u.children[0]));
+    node->count--;
+
+    return node->count == 0;
+}
+
+static void *
+btree_remove32(wmem_tree_t *tree, uint32_t key)
+{
+    wmem_btree_node_t *root;
+    void              *value = NULL;
+
+    if (!tree->btree_root) {
+        return NULL;
+    }
+
+    if (btree_remove_node(tree, tree->btree_root, key, &value)) {
+        wmem_free(tree->data_allocator, tree->btree_root);
+        tree->btree_root = NULL;
+        return value;
+    }
+
+    /* Drop roots that are left with a single child. */
+    while (!tree->btree_root->is_leaf && tree->btree_root->count == 1) {
+        root = tree->btree_root;
+        tree->btree_root = root->u.children[0];
+        wmem_free(tree->data_allocator, root);
+    }
+
+    return value;
+}
+
+static void
+btree_free_node(wmem_allocator_t *allocator, wmem_btree_node_t *node,
+        bool free_keys, bool free_values)
+{
+    unsigned i;
+
+    if (node->is_leaf) {
+        for (i = 0; i < node->count; i++) {
+            if (node->u.leaf.is_subtree[i]) {
+                wmem_tree_destroy((wmem_tree_t *)node->u.leaf.values[i], free_keys, free_values);
+            } else if (free_values) {
+                wmem_free(allocator, node->u.leaf.values[i]);
+            }
+        }
+    } else {
+        for (i = 0; i < node->count; i++) {
+            btree_free_node(allocator, node->u.children[i], free_keys, free_values);
+        }
+    }
+    wmem_free(allocator, node);
+}
+
+static wmem_btree_node_t *
+btree_first_leaf(const wmem_tree_t *tree)
+{
+    wmem_btree_node_t *node = tree->btree_root;
+
+    while (node && !node->is_leaf) {
+        node = node->u.children[0];
+    }
+
+    return node;
+}
+
+static bool
+btree_foreach(const wmem_tree_t *tree, wmem_foreach_func callback,
+        void *user_data)
+{
+    wmem_btree_node_t *leaf;
+    unsigned           i;
+
+    for (leaf = btree_first_leaf(tree); leaf; leaf = leaf->u.leaf.next) {
+        for (i = 0; i < leaf->count; i++) {
+            if (leaf->u.leaf.is_subtree[i]) {
+                if (wmem_tree_foreach((wmem_tree_t *)leaf->u.leaf.values[i],
+                            callback, user_data)) {
+                    return true;
+                }
+            } else if (callback(GUINT_TO_POINTER(leaf->keys[i]),
+                        leaf->u.leaf.values[i], user_data)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 wmem_tree_t *
 wmem_tree_new(wmem_allocator_t *allocator)
 {
@@ -368,6 +821,16 @@ wmem_tree_new(wmem_allocator_t *allocator)
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_btree(wmem_allocator_t *allocator)
+{
+    wmem_tree_t *tree = wmem_tree_new(allocator);
+
+    tree->btree = true;
+
+    return tree;
+}
+
 static bool
 wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
         void *user_data)
@@ -375,6 +838,7 @@ wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     wmem_tree_t *tree = (wmem_tree_t *)user_data;
 
     tree->root = NULL;
+    tree->btree_root = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
@@ -412,6 +876,16 @@ wmem_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_btree_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope)
+{
+    wmem_tree_t *tree = wmem_tree_new_autoreset(metadata_scope, data_scope);
+
+    tree->btree = true;
+
+    return tree;
+}
+
 static void
 free_tree_node(wmem_allocator_t *allocator, wmem_tree_node_t* node, bool free_keys, bool free_values)
 {
@@ -446,6 +920,9 @@ void
 wmem_tree_destroy(wmem_tree_t *tree, bool free_keys, bool free_values)
 {
     free_tree_node(tree->data_allocator, tree->root, free_keys, free_values);
+    if (tree->btree_root) {
+        btree_free_node(tree->data_allocator, tree->btree_root, free_keys, free_values);
+    }
     if (tree->metadata_allocator) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
     }
@@ -458,7 +935,7 @@ wmem_tree_destroy(wmem_tree_t *tree, bool free_keys, bool free_values)
 bool
 wmem_tree_is_empty(const wmem_tree_t *tree)
 {
-    return tree->root == NULL;
+    return tree->root == NULL && tree->btree_root == NULL;
 }
 
 static bool
@@ -504,8 +981,6 @@ create_node(wmem_allocator_t *allocator, wmem_tree_node_t *parent, const void *k
     return node;
 }
 
-#define CREATE_DATA(TRANSFORM, DATA) ((TRANSFORM) ? (TRANSFORM)(DATA) : (DATA))
-
 
 /**
  * return inserted node
@@ -573,7 +1048,13 @@ static void *
 lookup_or_insert32(wmem_tree_t *tree, uint32_t key,
         void*(*func)(void*), void* data, bool is_subtree, bool replace)
 {
-    wmem_tree_node_t *node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
+    wmem_tree_node_t *node;
+
+    if (tree->btree) {
+        return btree_lookup_or_insert32(tree, key, func, data, is_subtree, replace);
+    }
+
+    node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
     return node->data;
 }
 
@@ -586,6 +1067,9 @@ wmem_tree_lookup(const wmem_tree_t *tree, const void *key, compare_func cmp)
         return NULL;
     }
 
+    /* B+trees only have 32-bit keys. */
+    ws_assert(!tree->btree);
+
     node = tree->root;
 
     while (node) {
@@ -610,6 +1094,9 @@ wmem_tree_insert_node(wmem_tree_t *tree, const void *key, void *data, compare_fu
     wmem_tree_node_t *node = tree->root;
     wmem_tree_node_t *new_node = NULL;
 
+    /* B+trees only have 32-bit keys. */
+    ws_assert(!tree->btree);
+
     /* is this the first node ?*/
     if (!node) {
         tree->root = create_node(tree->data_allocator, node, key,
@@ -668,6 +1155,12 @@ bool wmem_tree_contains32(const wmem_tree_t *tree, uint32_t key)
         return false;
     }
 
+    if (tree->btree) {
+        unsigned pos;
+
+        return btree_lookup(tree, key, &pos) != NULL;
+    }
+
     wmem_tree_node_t *node = tree->root;
 
     while (node) {
@@ -712,6 +1205,14 @@ wmem_tree_lookup32_node(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32(const wmem_tree_t *tree, uint32_t key)
 {
+    if (tree && tree->btree) {
+        wmem_btree_node_t *leaf;
+        unsigned           pos;
+
+        leaf = btree_lookup(tree, key, &pos);
+        return leaf ? leaf->u.leaf.values[pos] : NULL;
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -788,6 +1289,14 @@ wmem_tree_lookup32_le_node(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32_le(const wmem_tree_t *tree, uint32_t key)
 {
+    if (tree && tree->btree) {
+        wmem_btree_node_t *leaf;
+        unsigned           pos;
+
+        leaf = btree_lookup_le(tree, key, &pos);
+        return leaf ? leaf->u.leaf.values[pos] : NULL;
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_le_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -799,6 +1308,18 @@ wmem_tree_lookup32_le(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32_le_full(const wmem_tree_t *tree, uint32_t key, uint32_t *orig_key)
 {
+    if (tree && tree->btree) {
+        wmem_btree_node_t *leaf;
+        unsigned           pos;
+
+        leaf = btree_lookup_le(tree, key, &pos);
+        if (leaf == NULL) {
+            return NULL;
+        }
+        *orig_key = leaf->keys[pos];
+        return leaf->u.leaf.values[pos];
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_le_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -877,6 +1398,14 @@ wmem_tree_lookup32_ge_node(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32_ge(const wmem_tree_t *tree, uint32_t key)
 {
+    if (tree && tree->btree) {
+        wmem_btree_node_t *leaf;
+        unsigned           pos;
+
+        leaf = btree_lookup_ge(tree, key, &pos);
+        return leaf ? leaf->u.leaf.values[pos] : NULL;
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_ge_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -888,6 +1417,18 @@ wmem_tree_lookup32_ge(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32_ge_full(const wmem_tree_t *tree, uint32_t key, uint32_t *orig_key)
 {
+    if (tree && tree->btree) {
+        wmem_btree_node_t *leaf;
+        unsigned           pos;
+
+        leaf = btree_lookup_ge(tree, key, &pos);
+        if (leaf == NULL) {
+            return NULL;
+        }
+        *orig_key = leaf->keys[pos];
+        return leaf->u.leaf.values[pos];
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_ge_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -900,6 +1441,10 @@ wmem_tree_lookup32_ge_full(const wmem_tree_t *tree, uint32_t key, uint32_t *orig
 void *
 wmem_tree_remove32(wmem_tree_t *tree, uint32_t key)
 {
+    if (tree && tree->btree) {
+        return btree_remove32(tree, key);
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -960,7 +1505,13 @@ wmem_tree_remove_string(wmem_tree_t* tree, const char* k, uint32_t flags)
 static void *
 create_sub_tree(void* d)
 {
-    return wmem_tree_new(((wmem_tree_t *)d)->data_allocator);
+    wmem_tree_t *tree = (wmem_tree_t *)d;
+
+    /* Subtrees are the same kind of tree as the tree they are in. */
+    if (tree->btree) {
+        return wmem_tree_new_btree(tree->data_allocator);
+    }
+    return wmem_tree_new(tree->data_allocator);
 }
 
 void
@@ -1076,6 +1627,9 @@ bool
 wmem_tree_foreach(const wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data)
 {
+    if (tree->btree)
+        return btree_foreach(tree, callback, user_data);
+
     if(!tree->root)
         return false;
 
@@ -1133,6 +1687,38 @@ wmem_tree_print_nodes(const char *prefix, wmem_tree_node_t *node, uint32_t level
         wmem_print_subtree((wmem_tree_t *)node->data, level+1, key_printer, data_printer);
 }
 
+static void
+wmem_btree_print_node(wmem_btree_node_t *node, uint32_t level,
+    wmem_printer_func key_printer, wmem_printer_func data_printer)
+{
+    unsigned i;
+
+    wmem_print_indent(level);
+    printf("%sNODE:%p count:%u\n", node->is_leaf ? "LEAF " : "", (void *)node, node->count);
+
+    for (i = 0; i < node->count; i++) {
+        if (!node->is_leaf) {
+            wmem_btree_print_node(node->u.children[i], level+1, key_printer, data_printer);
+            continue;
+        }
+
+        wmem_print_indent(level+1);
+        printf("key:%u %s:%p\n", node->keys[i],
+                node->u.leaf.is_subtree[i]?"tree":"data", node->u.leaf.values[i]);
+        if (key_printer) {
+            wmem_print_indent(level+1);
+            key_printer(GUINT_TO_POINTER(node->keys[i]));
+            printf("\n");
+        }
+        if (node->u.leaf.is_subtree[i]) {
+            wmem_print_subtree((wmem_tree_t *)node->u.leaf.values[i], level+2, key_printer, data_printer);
+        } else if (data_printer) {
+            wmem_print_indent(level+1);
+            data_printer(node->u.leaf.values[i]);
+            printf("\n");
+        }
+    }
+}
 
 static void
 wmem_print_subtree(const wmem_tree_t *tree, uint32_t level, wmem_printer_func key_printer, wmem_printer_func data_printer)
@@ -1142,6 +1728,14 @@ wmem_print_subtree(const wmem_tree_t *tree, uint32_t level, wmem_printer_func ke
 
     wmem_print_indent(level);
 
+    if (tree->btree) {
+        printf("WMEM B+tree:%p root:%p\n", (void *)tree, (void *)tree->btree_root);
+        if (tree->btree_root) {
+            wmem_btree_print_node(tree->btree_root, level, key_printer, data_printer);
+        }
+        return;
+    }
+
     printf("WMEM tree:%p root:%p\n", (void *)tree, (void *)tree->root);
     if (tree->root) {
         wmem_tree_print_nodes("Root-", tree->root, level, key_printer, data_printer);
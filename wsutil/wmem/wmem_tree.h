@@ -30,6 +30,9 @@ extern "C" {
  *    time for lookups, compared to linked lists that are O(n). This means
  *    red/black trees scale very well when many objects are being stored.
  *
+ *    Trees with 32-bit keys can instead be created as B+trees, which are used
+ *    through the same functions; see wmem_tree_new_btree().
+ *
  *    @{
  */
 
@@ -82,6 +85,38 @@ WS_DLL_PUBLIC
 wmem_tree_t *
 wmem_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope);
 
+/**
+ * @brief Creates a B+tree with the given allocator scope.
+ *
+ * Behaves like a tree from wmem_tree_new(), and is used through the same
+ * functions, but keeps many keys in each node and its values in leaves that
+ * are linked in key order. Lookups, including the _le and _ge ones, touch
+ * far fewer cache lines than in a red-black tree, which matters for trees
+ * with many keys such as those indexed by frame or sequence number.
+ *
+ * Only 32-bit and array keys are supported: string keys and
+ * wmem_tree_insert_node() need a tree from wmem_tree_new().
+ *
+ * @param allocator Allocator used for the tree.
+ * @return A pointer to the newly created tree.
+ */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_btree(wmem_allocator_t *allocator);
+
+/**
+ * @brief Creates a B+tree with two allocator scopes.
+ *
+ * The B+tree equivalent of wmem_tree_new_autoreset(); see wmem_tree_new_btree().
+ *
+ * @param metadata_scope Allocator for the base structure and metadata.
+ * @param data_scope Allocator for the tree data that resets on free_all.
+ * @return A pointer to the newly created tree.
+ */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_btree_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope);
+
 /**
  * @brief Cleanup memory used by tree.
  *
@@ -0,0 +1,141 @@
+/* ws_cksum.c
+ * Ones'-complement summing for the Internet checksum
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "ws_cksum.h"
+
+#include <string.h>
+
+#include "cksum_int.h"
+
+#ifdef HAVE_AVX2
+#include "ws_cpuid.h"
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+/* Advanced SIMD is part of the base ARMv8-A architecture, so there's
+ * nothing to check at run time. */
+#define WS_CKSUM_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * Since 2^16 = 1 mod 2^16 - 1, adding 32-bit words and folding the
+ * carries down at the end gives the same ones'-complement sum as adding
+ * 16-bit words, in either byte order, and a 64-bit accumulator can take
+ * 2^32 words before it could overflow. Folding never turns a nonzero
+ * sum into 0, so the result matches in_cksum()'s 16-bit loop exactly.
+ */
+static inline uint16_t
+ws_cksum_fold(uint64_t sum)
+{
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+#ifdef HAVE_AVX2
+/* Checking costs a CPUID instruction or two, so only do it once. */
+static bool
+ws_cksum_use_avx2(void)
+{
+    static int use_avx2 = -1;
+
+    if (use_avx2 < 0)
+        use_avx2 = ws_cpuid_avx2() ? 1 : 0;
+    return use_avx2 != 0;
+}
+#endif
+
+uint16_t
+ws_cksum_sum16(const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    uint64_t sum = 0;
+
+#if defined(HAVE_AVX2)
+    if (len >= 64 && ws_cksum_use_avx2()) {
+        size_t bulk = len & ~(size_t)31;
+
+        sum = ws_cksum_avx2_sum(p, bulk);
+        p += bulk;
+        len -= bulk;
+    }
+#elif defined(WS_CKSUM_NEON)
+    if (len >= 32) {
+        uint64x2_t acc0 = vdupq_n_u64(0);
+        uint64x2_t acc1 = vdupq_n_u64(0);
+
+        /* UADALP adds pairs of 32-bit words into the 64-bit lanes. */
+        while (len >= 32) {
+            acc0 = vpadalq_u32(acc0, vreinterpretq_u32_u8(vld1q_u8(p)));
+            acc1 = vpadalq_u32(acc1, vreinterpretq_u32_u8(vld1q_u8(p + 16)));
+            p += 32;
+            len -= 32;
+        }
+        acc0 = vaddq_u64(acc0, acc1);
+        sum = vgetq_lane_u64(acc0, 0) + vgetq_lane_u64(acc0, 1);
+    }
+#endif
+
+    while (len >= 8) {
+        uint32_t v[2];
+
+        memcpy(v, p, sizeof v);
+        sum += v[0];
+        sum += v[1];
+        p += 8;
+        len -= 8;
+    }
+    if (len >= 4) {
+        uint32_t v;
+
+        memcpy(&v, p, sizeof v);
+        sum += v;
+        p += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        uint16_t v;
+
+        memcpy(&v, p, sizeof v);
+        sum += v;
+        p += 2;
+        len -= 2;
+    }
+    if (len) {
+        union {
+            uint8_t c[2];
+            uint16_t s;
+        } last;
+
+        last.c[0] = *p;
+        last.c[1] = 0;
+        sum += last.s;
+    }
+
+    return ws_cksum_fold(sum);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
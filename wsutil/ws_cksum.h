@@ -0,0 +1,53 @@
+/** @file
+ * Ones'-complement summing for the Internet checksum
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_CKSUM_H__
+#define __WS_CKSUM_H__
+
+#include <wireshark.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Add up a buffer as 16-bit words with end-around carry.
+ *
+ * This is the inner loop of the Internet checksum (RFC 1071). The words
+ * are read in host byte order, which RFC 1071 shows gives the same
+ * result, byte for byte, as summing in network byte order. An odd final
+ * byte is padded with a zero byte after it in memory. Uses AVX2 or NEON
+ * where available.
+ *
+ * @param buf  The data to add up, with no alignment requirement.
+ * @param len  The length of the data in bytes.
+ * @return     The sum folded to 16 bits, not inverted; 0 only if every
+ *             word is 0.
+ */
+WS_DLL_PUBLIC uint16_t ws_cksum_sum16(const void *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WS_CKSUM_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
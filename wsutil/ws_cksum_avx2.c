@@ -0,0 +1,72 @@
+/* ws_cksum_avx2.c
+ * Internet checksum summing with AVX2 intrinsics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <immintrin.h>
+
+#include "cksum_int.h"
+
+/*
+ * Each 32-byte block is split into eight 32-bit words, which are widened
+ * into 64-bit lanes so that the accumulators can't overflow for any
+ * buffer that fits in memory; the carries are folded back in by the
+ * caller. Two accumulators keep consecutive adds independent.
+ */
+uint64_t
+ws_cksum_avx2_sum(const uint8_t *buf, size_t len)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = zero;
+    __m256i acc1 = zero;
+    __m128i acc;
+    uint64_t lanes[2];
+
+    while (len >= 64) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)buf);
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(buf + 32));
+
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v1, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v1, zero));
+        buf += 64;
+        len -= 64;
+    }
+    if (len >= 32) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)buf);
+
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+    }
+
+    acc0 = _mm256_add_epi64(acc0, acc1);
+    acc = _mm_add_epi64(_mm256_castsi256_si128(acc0), _mm256_extracti128_si256(acc0, 1));
+    _mm_storeu_si128((__m128i *)lanes, acc);
+
+    return lanes[0] + lanes[1];
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
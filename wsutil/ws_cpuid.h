@@ -62,6 +62,8 @@
  * on Windows anyway, so the answer is probably "no".
  */
 #if defined(_M_IX86) || defined(_M_X64)
+#include <immintrin.h>	/* for _xgetbv() */
+
 static bool
 ws_cpuid(uint32_t *CPUInfo, uint32_t selector)
 {
@@ -143,7 +145,7 @@ ws_cpuid(uint32_t *CPUInfo _U_, int selector _U_)
 }
 #endif
 
-static int
+static inline int
 ws_cpuid_sse42(void)
 {
 	uint32_t CPUInfo[4];
@@ -154,3 +156,53 @@ ws_cpuid_sse42(void)
 	/* in ECX bit 20 toggled on */
 	return (CPUInfo[2] & (1 << 20));
 }
+
+/*
+ * AVX2 needs support from both the processor and the OS, which has to
+ * save the YMM registers on context switches; XGETBV tells us whether
+ * it does.
+ */
+static inline bool
+ws_cpuid_avx2(void)
+{
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || \
+    (defined(__GNUC__) && defined(__x86_64__))
+	uint32_t CPUInfo[4];
+	uint64_t xcr0;
+
+	if (!ws_cpuid(CPUInfo, 0) || CPUInfo[0] < 7)
+		return false;
+
+	if (!ws_cpuid(CPUInfo, 1))
+		return false;
+
+	/* in ECX bit 27 (OSXSAVE) and bit 28 (AVX) toggled on */
+	if ((CPUInfo[2] & ((1 << 27) | (1 << 28))) != ((1 << 27) | (1 << 28)))
+		return false;
+
+#if defined(_MSC_VER)
+	xcr0 = _xgetbv(0);
+#else
+	{
+		uint32_t xcr0_lo, xcr0_hi;
+
+		__asm__ __volatile__("xgetbv"
+						: "=a" (xcr0_lo),
+							"=d" (xcr0_hi)
+						: "c" (0));
+		xcr0 = ((uint64_t)xcr0_hi << 32) | xcr0_lo;
+	}
+#endif
+	/* XMM and YMM state both enabled */
+	if ((xcr0 & 0x6) != 0x6)
+		return false;
+
+	if (!ws_cpuid(CPUInfo, 7))
+		return false;
+
+	/* in EBX bit 5 toggled on */
+	return (CPUInfo[1] & (1 << 5)) != 0;
+#else
+	return false;
+#endif
+}
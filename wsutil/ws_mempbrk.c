@@ -27,6 +27,102 @@
 
 #include <string.h>
 
+#if defined(__aarch64__) || defined(_M_ARM64)
+/* Advanced SIMD is part of the base ARMv8-A architecture, so there's
+ * nothing to check at run time. */
+#define WS_MEMPBRK_NEON
+#include <arm_neon.h>
+#include "bits_ctz.h"
+#endif
+
+/*
+ * Build the pattern's nibble tables. Each distinct set of low nibbles
+ * seen with some high nibble gets one bit, so this works for any set of
+ * needles whose high nibbles come with at most 8 distinct sets of low
+ * nibbles; that covers all the sets the dissectors use. Returns false
+ * if the needles can't be represented.
+ */
+static bool
+ws_mempbrk_nibbles_compile(ws_mempbrk_pattern* pattern)
+{
+    uint16_t lo_sets[16] = { 0 };
+    uint16_t buckets[8];
+    unsigned num_buckets = 0;
+    unsigned b;
+
+    memset(pattern->nibble_lo, 0, sizeof pattern->nibble_lo);
+    memset(pattern->nibble_hi, 0, sizeof pattern->nibble_hi);
+
+    for (unsigned c = 1; c < 256; c++) {
+        if (pattern->patt[c])
+            lo_sets[c >> 4] |= 1 << (c & 0xf);
+    }
+
+    for (unsigned hi = 0; hi < 16; hi++) {
+        if (lo_sets[hi] == 0)
+            continue;
+        for (b = 0; b < num_buckets; b++) {
+            if (buckets[b] == lo_sets[hi])
+                break;
+        }
+        if (b == num_buckets) {
+            if (num_buckets == 8)
+                return false;
+            buckets[num_buckets++] = lo_sets[hi];
+        }
+        pattern->nibble_hi[hi] |= 1 << b;
+        for (unsigned lo = 0; lo < 16; lo++) {
+            if (lo_sets[hi] & (1 << lo))
+                pattern->nibble_lo[lo] |= 1 << b;
+        }
+    }
+    return true;
+}
+
+#ifdef WS_MEMPBRK_NEON
+/* Same lookup as the AVX2 version, 16 bytes at a time. */
+static inline uint64_t
+ws_mempbrk_neon_match(const uint8_t *p, uint8x16_t lo_tbl, uint8x16_t hi_tbl)
+{
+    uint8x16_t v, lo, hi, hit;
+
+    v = vld1q_u8(p);
+    lo = vqtbl1q_u8(lo_tbl, vandq_u8(v, vdupq_n_u8(0x0f)));
+    hi = vqtbl1q_u8(hi_tbl, vshrq_n_u8(v, 4));
+    hit = vtstq_u8(lo, hi);
+    /* There's no movemask; narrowing leaves 4 bits per byte. */
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+}
+
+static const uint8_t *
+ws_mempbrk_neon_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
+{
+    const uint8x16_t lo_tbl = vld1q_u8(pattern->nibble_lo);
+    const uint8x16_t hi_tbl = vld1q_u8(pattern->nibble_hi);
+    const uint8_t *p = haystack;
+    const uint8_t *last = haystack + haystacklen - 16;
+    uint64_t mask;
+
+    for (;;) {
+        mask = ws_mempbrk_neon_match(p, lo_tbl, hi_tbl);
+        if (mask != 0)
+            break;
+        if (p == last)
+            return NULL;
+        p += 16;
+        /* The final block overlaps the one before it, so we never read
+         * past the end; the overlapping bytes are known not to match. */
+        if (p > last)
+            p = last;
+    }
+
+    p += ws_ctz(mask) >> 2;
+    if (found_needle)
+        *found_needle = *p;
+    return p;
+}
+#endif
+
 void
 ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const char *needles)
 {
@@ -39,6 +135,12 @@ ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const char *needles)
 
 #ifdef HAVE_SSE4_2
     ws_mempbrk_sse42_compile(pattern, needles);
+#endif
+    pattern->use_nibbles = ws_mempbrk_nibbles_compile(pattern);
+#if defined(HAVE_AVX2)
+    ws_mempbrk_avx2_compile(pattern);
+#elif !defined(WS_MEMPBRK_NEON)
+    pattern->use_nibbles = false;
 #endif
 }
 
@@ -64,6 +166,13 @@ ws_mempbrk_portable_exec(const uint8_t* haystack, size_t haystacklen, const ws_m
 WS_DLL_PUBLIC const uint8_t *
 ws_mempbrk_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
 {
+#if defined(HAVE_AVX2)
+    if (haystacklen >= 32 && pattern->use_nibbles)
+        return ws_mempbrk_avx2_exec(haystack, haystacklen, pattern, found_needle);
+#elif defined(WS_MEMPBRK_NEON)
+    if (haystacklen >= 16 && pattern->use_nibbles)
+        return ws_mempbrk_neon_exec(haystack, haystacklen, pattern, found_needle);
+#endif
 #ifdef HAVE_SSE4_2
     if (haystacklen >= 16 && pattern->use_sse42)
         return (const uint8_t*)ws_mempbrk_sse42_exec((const char*)haystack, haystacklen, pattern, found_needle);
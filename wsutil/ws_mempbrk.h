@@ -24,6 +24,11 @@ typedef struct {
     bool use_sse42;
     __m128i mask;
 #endif
+    /* The needles as a pair of nibble lookup tables: byte b is a needle
+     * iff nibble_lo[b & 0xf] & nibble_hi[b >> 4] is non-zero. */
+    bool use_nibbles;
+    uint8_t nibble_lo[16];
+    uint8_t nibble_hi[16];
 } ws_mempbrk_pattern;
 
 /**
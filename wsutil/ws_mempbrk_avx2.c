@@ -0,0 +1,92 @@
+/* ws_mempbrk_avx2.c
+ * Scan for a set of bytes with AVX2 intrinsics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <glib.h>
+#include "ws_cpuid.h"
+
+#include <immintrin.h>
+#include "ws_mempbrk.h"
+#include "ws_mempbrk_int.h"
+#include "bits_ctz.h"
+
+void
+ws_mempbrk_avx2_compile(ws_mempbrk_pattern* pattern)
+{
+    if (pattern->use_nibbles && !ws_cpuid_avx2())
+        pattern->use_nibbles = false;
+}
+
+/*
+ * Returns a mask with bit i set iff p[i] is one of the needles.
+ *
+ * VPSHUFB looks up each low nibble in nibble_lo and each high nibble in
+ * nibble_hi; the needles are exactly the bytes whose two lookups share a
+ * bit. VPSHUFB shuffles within 128-bit lanes, so both tables are
+ * broadcast to each lane.
+ */
+static inline uint32_t
+ws_mempbrk_avx2_match(const uint8_t *p, __m256i lo_tbl, __m256i hi_tbl)
+{
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+    __m256i v, lo, hi, miss;
+
+    v = _mm256_loadu_si256((const __m256i *)(const void *)p);
+    lo = _mm256_shuffle_epi8(lo_tbl, _mm256_and_si256(v, nibble_mask));
+    hi = _mm256_shuffle_epi8(hi_tbl, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble_mask));
+    miss = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256());
+    return ~(uint32_t)_mm256_movemask_epi8(miss);
+}
+
+const uint8_t *
+ws_mempbrk_avx2_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
+{
+    const __m256i lo_tbl = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(const void *)pattern->nibble_lo));
+    const __m256i hi_tbl = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(const void *)pattern->nibble_hi));
+    const uint8_t *p = haystack;
+    const uint8_t *last = haystack + haystacklen - 32;
+    uint32_t mask;
+
+    for (;;) {
+        mask = ws_mempbrk_avx2_match(p, lo_tbl, hi_tbl);
+        if (mask != 0)
+            break;
+        if (p == last)
+            return NULL;
+        p += 32;
+        /* The final block overlaps the one before it, so we never read
+         * past the end; the overlapping bytes are known not to match. */
+        if (p > last)
+            p = last;
+    }
+
+    p += ws_ctz(mask);
+    if (found_needle)
+        *found_needle = *p;
+    return p;
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -57,4 +57,31 @@ void ws_mempbrk_sse42_compile(ws_mempbrk_pattern* pattern, const char *needles);
 const char *ws_mempbrk_sse42_exec(const char* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle);
 #endif
 
+#ifdef HAVE_AVX2
+/**
+ * @brief Finish compiling a pattern for AVX2-accelerated mempbrk search.
+ *
+ * Keeps the pattern's nibble tables enabled only if the processor and OS
+ * support AVX2.
+ *
+ * @param pattern  Pointer to the pattern structure whose nibble tables
+ *                 have already been built.
+ */
+void ws_mempbrk_avx2_compile(ws_mempbrk_pattern* pattern);
+
+/**
+ * @brief Search for the first matching byte in a buffer using AVX2.
+ *
+ * Looks up each byte's nibbles in the pattern's nibble tables, 32 bytes
+ * at a time. The haystack must be at least 32 bytes long.
+ *
+ * @param haystack       Pointer to the input buffer to search.
+ * @param haystacklen    Length of the input buffer in bytes, at least 32.
+ * @param pattern        Precompiled pattern with usable nibble tables.
+ * @param found_needle   Optional output pointer to receive the matched byte.
+ * @return               Pointer to the first matching byte in `haystack`, or NULL if none found.
+ */
+const uint8_t *ws_mempbrk_avx2_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle);
+#endif
+
 #endif /* __WS_MEMPBRK_INT_H__ */
@@ -0,0 +1,64 @@
+/* ws_trace.c
+ * Static tracepoints in the packet processing hot paths
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "ws_trace.h"
+
+#ifdef HAVE_TRACELOGGINGPROVIDER_H
+
+#include <stdlib.h>
+
+TRACELOGGING_DEFINE_PROVIDER(
+    ws_trace_provider,
+    "Wireshark",
+    (0x88306d79, 0x284b, 0x46f4, 0x84, 0xf2, 0x78, 0x2c, 0x29, 0x1c, 0x53, 0xa0));
+
+static void
+ws_trace_unregister(void)
+{
+    TraceLoggingUnregister(ws_trace_provider);
+}
+
+void
+ws_trace_register(void)
+{
+    static bool registered;
+
+    if (registered) {
+        return;
+    }
+    if (TraceLoggingRegister(ws_trace_provider) == ERROR_SUCCESS) {
+        registered = true;
+        atexit(ws_trace_unregister);
+    }
+}
+
+#else /* HAVE_TRACELOGGINGPROVIDER_H */
+
+void
+ws_trace_register(void)
+{
+}
+
+#endif /* HAVE_TRACELOGGINGPROVIDER_H */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
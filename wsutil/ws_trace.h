@@ -0,0 +1,123 @@
+/** @file
+ * Static tracepoints in the packet processing hot paths
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_TRACE_H__
+#define __WS_TRACE_H__
+
+#include <wireshark.h>
+
+/*
+ * WS_TRACEn(name, ...) marks a point that an external tracer can attach
+ * to without rebuilding: a USDT probe in the "wireshark" provider where
+ * <sys/sdt.h> is available (SystemTap, bpftrace, perf, DTrace), and a
+ * TraceLogging event from the "Wireshark" ETW provider on Windows. For
+ * example, on Linux
+ *
+ *     bpftrace -e 'usdt:./run/tshark:wireshark:filter__done { @passed[arg1] = count(); }'
+ *
+ * Probes come in pairs named <what>__start and <what>__done where the
+ * time between them is of interest. Names use "__", which DTrace shows
+ * as "-".
+ *
+ * A USDT probe is a single no-op instruction until a tracer attaches,
+ * and a TraceLogging event is a test of whether anyone is listening,
+ * so these can sit in per-packet code. The arguments are still worked
+ * out each time, so they should be integers that are already at hand;
+ * they are passed on as 64-bit values.
+ *
+ * Builds without either mechanism, or with ENABLE_TRACEPOINTS turned
+ * off, compile the probes away.
+ */
+
+#if defined(HAVE_SYS_SDT_H)
+
+#include <sys/sdt.h>
+
+#define WS_TRACE0(name) \
+    DTRACE_PROBE(wireshark, name)
+#define WS_TRACE1(name, a1) \
+    DTRACE_PROBE1(wireshark, name, (uint64_t)(a1))
+#define WS_TRACE2(name, a1, a2) \
+    DTRACE_PROBE2(wireshark, name, (uint64_t)(a1), (uint64_t)(a2))
+#define WS_TRACE3(name, a1, a2, a3) \
+    DTRACE_PROBE3(wireshark, name, (uint64_t)(a1), (uint64_t)(a2), (uint64_t)(a3))
+
+#elif defined(HAVE_TRACELOGGINGPROVIDER_H)
+
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* {88306d79-284b-46f4-84f2-782c291c53a0}, defined in ws_trace.c. */
+WS_DLL_PUBLIC const TraceLoggingHProvider ws_trace_provider;
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#define WS_TRACE0(name) \
+    TraceLoggingWrite(ws_trace_provider, #name)
+#define WS_TRACE1(name, a1) \
+    TraceLoggingWrite(ws_trace_provider, #name, \
+        TraceLoggingUInt64((uint64_t)(a1), "arg0"))
+#define WS_TRACE2(name, a1, a2) \
+    TraceLoggingWrite(ws_trace_provider, #name, \
+        TraceLoggingUInt64((uint64_t)(a1), "arg0"), \
+        TraceLoggingUInt64((uint64_t)(a2), "arg1"))
+#define WS_TRACE3(name, a1, a2, a3) \
+    TraceLoggingWrite(ws_trace_provider, #name, \
+        TraceLoggingUInt64((uint64_t)(a1), "arg0"), \
+        TraceLoggingUInt64((uint64_t)(a2), "arg1"), \
+        TraceLoggingUInt64((uint64_t)(a3), "arg2"))
+
+#else
+
+#define WS_TRACE0(name)                 ((void)0)
+#define WS_TRACE1(name, a1)             ((void)0)
+#define WS_TRACE2(name, a1, a2)         ((void)0)
+#define WS_TRACE3(name, a1, a2, a3)     ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Makes the tracepoints visible to tracers.
+ *
+ * ETW events are only delivered once their provider has been registered
+ * with the system, which this does, unregistering it again at exit.
+ * USDT probes need nothing, so elsewhere this does nothing. Programs that
+ * want to be traced should call it early in main().
+ */
+WS_DLL_PUBLIC void ws_trace_register(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WS_TRACE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */